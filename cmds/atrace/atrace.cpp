@@ -14,16 +14,21 @@
  * limitations under the License.
  */
 
+#include <ctype.h>
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <zlib.h>
 
@@ -33,8 +38,13 @@
 
 #include <cutils/properties.h>
 
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 #include <utils/Trace.h>
+#include <utils/Vector.h>
 
 using namespace android;
 
@@ -44,6 +54,7 @@ enum { MAX_SYS_FILES = 10 };
 
 const char* k_traceTagsProperty = "debug.atrace.tags.enableflags";
 const char* k_traceAppCmdlineProperty = "debug.atrace.app_cmdlines";
+const char* k_traceSnapshotProperty = "debug.atrace.snapshot";
 
 typedef enum { OPT, REQ } requiredness  ;
 
@@ -142,6 +153,12 @@ static int g_traceDurationSeconds = 5;
 static bool g_traceOverwrite = false;
 static int g_traceBufferSizeKB = 2048;
 static bool g_compress = false;
+static int g_compressLevel = Z_DEFAULT_COMPRESSION;
+static const char* g_streamDir = NULL;
+static int g_streamSizeMB = 0;
+static const char* g_daemonDir = NULL;
+static int g_snapshotIntervalSecs = 60;
+static int g_snapshotCount = 10;
 static bool g_nohup = false;
 static int g_initialSleepSecs = 0;
 static const char* g_kernelTraceFuncs = NULL;
@@ -191,6 +208,41 @@ static const char* k_tracingOnPath =
 static const char* k_tracePath =
     "/sys/kernel/debug/tracing/trace";
 
+static const char* k_tracingPath =
+    "/sys/kernel/debug/tracing";
+
+static const char* k_traceEventsPath =
+    "/sys/kernel/debug/tracing/events";
+
+// The files describing the binary format of the streamed trace, in
+// k_tracingPath.
+static const char* k_streamFormatFiles[] = {
+    "events/header_page",
+    "events/header_event",
+    "saved_cmdlines",
+    "printk_formats",
+};
+
+// Size of the files the per-CPU streams are split into.
+static const int64_t k_streamChunkSize = 64*1024*1024;
+
+// How often the streamed per-CPU buffers are drained while tracing.
+static const long k_streamIntervalNs = 100*1000*1000;
+
+// How often the daemon checks k_traceSnapshotProperty.
+static const long k_daemonIntervalNs = 200*1000*1000;
+
+// The number of threads poking the binder services, and how long to wait
+// for the services to refresh their properties.
+static const int k_pokeThreads = 8;
+static const nsecs_t k_pokeTimeout = 1000*1000*1000;
+
+// The categories the daemon traces when none are given, cheap enough to
+// leave on all the time.
+static const char* k_daemonCategories[] = {
+    "gfx", "input", "view", "wm", "am", "freq",
+};
+
 // Check whether a file exists.
 static bool fileExists(const char* filename) {
     return access(filename, F_OK) != -1;
@@ -401,30 +453,109 @@ static bool setPrintTgidEnableIfPresent(bool enable)
     return true;
 }
 
-// Poke all the binder-enabled processes in the system to get them to re-read
-// their system properties.
-static bool pokeBinderServices()
+// The state shared by pokeBinderServices and its threads. The threads
+// keep a reference, as the ones stuck in a busy process outlive the call.
+struct PokeState : public LightRefBase<PokeState> {
+    enum { PENDING = 1 };   // not a status_t
+
+    Mutex lock;
+    Condition doneCond;
+    Vector<String16> services;
+    Vector<status_t> results;   // PENDING until the service answered
+    size_t next;
+    size_t numDone;
+};
+
+static void* pokeThread(void* arg)
 {
+    sp<PokeState> state = static_cast<PokeState*>(arg);
+    state->decStrong(arg);
     sp<IServiceManager> sm = defaultServiceManager();
-    Vector<String16> services = sm->listServices();
-    for (size_t i = 0; i < services.size(); i++) {
-        sp<IBinder> obj = sm->checkService(services[i]);
+
+    Mutex::Autolock _l(state->lock);
+    while (state->next < state->services.size()) {
+        size_t i = state->next++;
+        String16 name = state->services[i];
+        state->lock.unlock();
+
+        status_t result = NAME_NOT_FOUND;
+        sp<IBinder> obj = sm->checkService(name);
         if (obj != NULL) {
             Parcel data;
-            if (obj->transact(IBinder::SYSPROPS_TRANSACTION, data,
-                    NULL, 0) != OK) {
-                if (false) {
-                    // XXX: For some reason this fails on tablets trying to
-                    // poke the "phone" service.  It's not clear whether some
-                    // are expected to fail.
-                    String8 svc(services[i]);
-                    fprintf(stderr, "error poking binder service %s\n",
-                        svc.string());
-                    return false;
-                }
+            result = obj->transact(IBinder::SYSPROPS_TRANSACTION, data, NULL, 0);
+        }
+
+        state->lock.lock();
+        state->results.editItemAt(i) = result;
+        if (++state->numDone == state->services.size()) {
+            state->doneCond.signal();
+        }
+    }
+    return NULL;
+}
+
+// Poke all the binder-enabled processes in the system to get them to re-read
+// their system properties. The services are poked by k_pokeThreads threads,
+// so that a few busy processes don't hold up the others, and the wait is
+// bounded by k_pokeTimeout. The services that failed to refresh or didn't
+// answer in time are reported, but don't make tracing fail: some are
+// expected to fail, the "phone" service on tablets for instance.
+static bool pokeBinderServices()
+{
+    sp<IServiceManager> sm = defaultServiceManager();
+    sp<PokeState> state = new PokeState;
+    state->services = sm->listServices();
+    state->results.insertAt(status_t(PokeState::PENDING), 0,
+            state->services.size());
+    state->next = 0;
+    state->numDone = 0;
+
+    Mutex::Autolock _l(state->lock);
+    for (int i = 0; i < k_pokeThreads && size_t(i) < state->services.size(); i++) {
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        state->incStrong(state.get());
+        if (pthread_create(&thread, &attr, pokeThread, state.get()) != 0) {
+            state->decStrong(state.get());
+            pthread_attr_destroy(&attr);
+            if (i == 0) {
+                fprintf(stderr, "error starting thread to poke binder services\n");
+                return false;
             }
+            break;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    nsecs_t deadline = systemTime(SYSTEM_TIME_MONOTONIC) + k_pokeTimeout;
+    while (state->numDone < state->services.size()) {
+        nsecs_t left = deadline - systemTime(SYSTEM_TIME_MONOTONIC);
+        if (left <= 0) {
+            break;
+        }
+        state->doneCond.waitRelative(state->lock, left);
+    }
+
+    String8 failed, busy;
+    for (size_t i = 0; i < state->services.size(); i++) {
+        status_t result = state->results[i];
+        if (result == PokeState::PENDING) {
+            busy.appendFormat(" %s", String8(state->services[i]).string());
+        } else if (result != OK && result != NAME_NOT_FOUND) {
+            failed.appendFormat(" %s", String8(state->services[i]).string());
         }
     }
+    if (!failed.isEmpty()) {
+        fprintf(stderr, "warning: binder services failed to refresh their "
+                "properties:%s\n", failed.string());
+    }
+    if (!busy.isEmpty()) {
+        fprintf(stderr, "warning: binder services didn't refresh their "
+                "properties within %" PRId64 "ms:%s\n",
+                ns2ms(k_pokeTimeout), busy.string());
+    }
     return true;
 }
 
@@ -452,6 +583,16 @@ static bool setAppCmdlineProperty(const char* cmdline)
     return true;
 }
 
+// Set the system property that asks the daemon for a snapshot.
+static bool setTraceSnapshotProperty(const char* reason)
+{
+    if (property_set(k_traceSnapshotProperty, reason) < 0) {
+        fprintf(stderr, "error setting trace snapshot system property\n");
+        return false;
+    }
+    return true;
+}
+
 // Disable all /sys/ enable files.
 static bool disableKernelTraceEvents() {
     bool ok = true;
@@ -633,8 +774,8 @@ static void stopTrace()
     setTracingEnabled(false);
 }
 
-// Read the current kernel trace and write it to stdout.
-static void dumpTrace()
+// Read the current kernel trace and write it to outFd.
+static void dumpTrace(int outFd)
 {
     int traceFD = open(k_tracePath, O_RDWR);
     if (traceFD == -1) {
@@ -649,7 +790,7 @@ static void dumpTrace()
         int result, flush;
 
         bzero(&zs, sizeof(zs));
-        result = deflateInit(&zs, Z_DEFAULT_COMPRESSION);
+        result = deflateInit(&zs, g_compressLevel);
         if (result != Z_OK) {
             fprintf(stderr, "error initializing zlib: %d\n", result);
             close(traceFD);
@@ -684,7 +825,7 @@ static void dumpTrace()
 
             if (zs.avail_out == 0) {
                 // Need to write the output.
-                result = write(STDOUT_FILENO, out, bufSize);
+                result = write(outFd, out, bufSize);
                 if ((size_t)result < bufSize) {
                     fprintf(stderr, "error writing deflated trace: %s (%d)\n",
                             strerror(errno), errno);
@@ -704,7 +845,7 @@ static void dumpTrace()
 
         if (zs.avail_out < bufSize) {
             size_t bytes = bufSize - zs.avail_out;
-            result = write(STDOUT_FILENO, out, bytes);
+            result = write(outFd, out, bytes);
             if ((size_t)result < bytes) {
                 fprintf(stderr, "error writing deflated trace: %s (%d)\n",
                         strerror(errno), errno);
@@ -720,7 +861,7 @@ static void dumpTrace()
         free(out);
     } else {
         ssize_t sent = 0;
-        while ((sent = sendfile(STDOUT_FILENO, traceFD, NULL, 64*1024*1024)) > 0);
+        while ((sent = sendfile(outFd, traceFD, NULL, 64*1024*1024)) > 0);
         if (sent == -1) {
             fprintf(stderr, "error dumping trace: %s (%d)\n", strerror(errno),
                     errno);
@@ -730,6 +871,390 @@ static void dumpTrace()
     close(traceFD);
 }
 
+// State of the stream of one CPU's ring buffer to disk.
+struct CpuStream {
+    int cpu;
+    int rawFD;          // per_cpu/cpuN/trace_pipe_raw
+    int pipeFDs[2];     // splice() needs a pipe between the two files
+    int outFD;          // the current chunk
+    int chunk;          // number of the current chunk
+    int64_t chunkBytes; // bytes written to the current chunk
+};
+
+static Vector<CpuStream> g_streams;
+static int g_streamMaxChunks = 0;
+
+// Open the next chunk of stream and delete the oldest one if the stream
+// has grown past the size limit.
+static bool openStreamChunk(CpuStream* stream)
+{
+    char path[PATH_MAX];
+
+    if (stream->outFD != -1) {
+        close(stream->outFD);
+        stream->chunk++;
+    }
+    if (g_streamMaxChunks > 0 && stream->chunk >= g_streamMaxChunks) {
+        snprintf(path, sizeof(path), "%s/cpu%d.%04d", g_streamDir,
+                stream->cpu, stream->chunk - g_streamMaxChunks);
+        unlink(path);
+    }
+    snprintf(path, sizeof(path), "%s/cpu%d.%04d", g_streamDir, stream->cpu,
+            stream->chunk);
+    stream->outFD = open(path, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if (stream->outFD == -1) {
+        fprintf(stderr, "error creating %s: %s (%d)\n", path,
+                strerror(errno), errno);
+        return false;
+    }
+    stream->chunkBytes = 0;
+    return true;
+}
+
+// Write data read from the ring buffer to the stream's current chunk.
+static bool writeStream(CpuStream* stream, const void* data, size_t len)
+{
+    if (stream->chunkBytes >= k_streamChunkSize && !openStreamChunk(stream)) {
+        return false;
+    }
+    if (write(stream->outFD, data, len) != (ssize_t)len) {
+        fprintf(stderr, "error writing trace stream: %s (%d)\n",
+                strerror(errno), errno);
+        return false;
+    }
+    stream->chunkBytes += len;
+    return true;
+}
+
+// Move the full pages of the CPU's ring buffer to disk, without copying
+// them to user space.
+static bool spliceStream(CpuStream* stream)
+{
+    const size_t pageSize = getpagesize();
+
+    for (;;) {
+        if (stream->chunkBytes >= k_streamChunkSize && !openStreamChunk(stream)) {
+            return false;
+        }
+        ssize_t len = splice(stream->rawFD, NULL, stream->pipeFDs[1], NULL,
+                pageSize, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+        if (len == -1 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            if (len == -1 && errno != EAGAIN) {
+                fprintf(stderr, "error reading trace_pipe_raw of cpu %d: "
+                        "%s (%d)\n", stream->cpu, strerror(errno), errno);
+                return false;
+            }
+            return true;
+        }
+        while (len > 0) {
+            ssize_t written = splice(stream->pipeFDs[0], NULL, stream->outFD,
+                    NULL, len, SPLICE_F_MOVE);
+            if (written == -1 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                fprintf(stderr, "error writing trace stream: %s (%d)\n",
+                        strerror(errno), errno);
+                return false;
+            }
+            len -= written;
+            stream->chunkBytes += written;
+        }
+    }
+}
+
+// Copy a file of the tracing directory to the stream directory.
+static bool copyFormatFile(const char* name)
+{
+    char src[PATH_MAX], dst[PATH_MAX];
+    char buf[4096];
+    bool ok = true;
+
+    snprintf(src, sizeof(src), "%s/%s", k_tracingPath, name);
+    snprintf(dst, sizeof(dst), "%s/%s", g_streamDir, name);
+    int srcFD = open(src, O_RDONLY|O_CLOEXEC);
+    if (srcFD == -1) {
+        // Not all the kernels have all the files.
+        return errno == ENOENT;
+    }
+    int dstFD = open(dst, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if (dstFD == -1) {
+        fprintf(stderr, "error creating %s: %s (%d)\n", dst, strerror(errno),
+                errno);
+        close(srcFD);
+        return false;
+    }
+    ssize_t len;
+    while ((len = read(srcFD, buf, sizeof(buf))) > 0) {
+        if (write(dstFD, buf, len) != len) {
+            ok = false;
+            break;
+        }
+    }
+    if (len < 0 || !ok) {
+        fprintf(stderr, "error copying %s: %s (%d)\n", src, strerror(errno),
+                errno);
+        ok = false;
+    }
+    close(dstFD);
+    close(srcFD);
+    return ok;
+}
+
+// Save the formats of the events along with the stream, the raw pages
+// can't be decoded without them.
+static bool writeStreamFormats()
+{
+    char path[PATH_MAX];
+    bool ok = true;
+
+    snprintf(path, sizeof(path), "%s/events", g_streamDir);
+    mkdir(path, 0755);
+    for (size_t i = 0; i < sizeof(k_streamFormatFiles) / sizeof(k_streamFormatFiles[0]); i++) {
+        ok &= copyFormatFile(k_streamFormatFiles[i]);
+    }
+
+    DIR* events = opendir(k_traceEventsPath);
+    if (events == NULL) {
+        fprintf(stderr, "error opening %s: %s (%d)\n", k_traceEventsPath,
+                strerror(errno), errno);
+        return false;
+    }
+    struct dirent* system;
+    while ((system = readdir(events)) != NULL) {
+        if (system->d_type != DT_DIR || system->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", k_traceEventsPath, system->d_name);
+        DIR* d = opendir(path);
+        if (d == NULL) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/events/%s", g_streamDir, system->d_name);
+        mkdir(path, 0755);
+        struct dirent* event;
+        while ((event = readdir(d)) != NULL) {
+            if (event->d_type != DT_DIR || event->d_name[0] == '.') {
+                continue;
+            }
+            snprintf(path, sizeof(path), "%s/events/%s/%s", g_streamDir,
+                    system->d_name, event->d_name);
+            mkdir(path, 0755);
+            String8 name = String8::format("events/%s/%s/format",
+                    system->d_name, event->d_name);
+            ok &= copyFormatFile(name.string());
+        }
+        closedir(d);
+    }
+    closedir(events);
+    return ok;
+}
+
+// Start streaming the per-CPU ring buffers to g_streamDir. Each CPU's
+// buffer goes to the files cpuN.0000, cpuN.0001... of k_streamChunkSize
+// bytes, which concatenated in order are the raw pages read from the
+// kernel. With a size limit, only the most recent chunks are kept, so the
+// directory works as a circular buffer much larger than the kernel's.
+static bool startStreaming()
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    char path[PATH_MAX];
+
+    if (mkdir(g_streamDir, 0755) == -1 && errno != EEXIST) {
+        fprintf(stderr, "error creating %s: %s (%d)\n", g_streamDir,
+                strerror(errno), errno);
+        return false;
+    }
+    if (g_streamSizeMB > 0) {
+        int64_t perCpu = (int64_t)g_streamSizeMB * 1024 * 1024 / cpus;
+        g_streamMaxChunks = perCpu / k_streamChunkSize;
+        if (g_streamMaxChunks < 2) {
+            g_streamMaxChunks = 2;
+        }
+    }
+
+    for (long cpu = 0; cpu < cpus; cpu++) {
+        CpuStream stream;
+        stream.cpu = cpu;
+        stream.outFD = -1;
+        stream.chunk = 0;
+        stream.chunkBytes = 0;
+        snprintf(path, sizeof(path), "%s/per_cpu/cpu%ld/trace_pipe_raw",
+                k_tracingPath, cpu);
+        stream.rawFD = open(path, O_RDONLY|O_NONBLOCK|O_CLOEXEC);
+        if (stream.rawFD == -1) {
+            // Offline CPUs don't have a buffer.
+            if (errno == ENOENT) {
+                continue;
+            }
+            fprintf(stderr, "error opening %s: %s (%d)\n", path,
+                    strerror(errno), errno);
+            return false;
+        }
+        if (pipe2(stream.pipeFDs, O_CLOEXEC) == -1) {
+            fprintf(stderr, "error creating pipe: %s (%d)\n", strerror(errno),
+                    errno);
+            close(stream.rawFD);
+            return false;
+        }
+        if (!openStreamChunk(&stream)) {
+            close(stream.rawFD);
+            close(stream.pipeFDs[0]);
+            close(stream.pipeFDs[1]);
+            return false;
+        }
+        g_streams.add(stream);
+    }
+    return true;
+}
+
+// Move what the kernel buffered since the last call to disk.
+static bool drainStreams()
+{
+    bool ok = true;
+    for (size_t i = 0; i < g_streams.size(); i++) {
+        ok &= spliceStream(&g_streams.editItemAt(i));
+    }
+    return ok;
+}
+
+// Write the rest of the trace, including the partially filled pages that
+// splice() leaves in the ring buffers, and the event formats.
+static bool stopStreaming()
+{
+    const size_t pageSize = getpagesize();
+    uint8_t* page = (uint8_t*)malloc(pageSize);
+    bool ok = drainStreams();
+
+    for (size_t i = 0; i < g_streams.size(); i++) {
+        CpuStream& stream(g_streams.editItemAt(i));
+        ssize_t len;
+        while (ok && (len = read(stream.rawFD, page, pageSize)) > 0) {
+            ok = writeStream(&stream, page, len);
+        }
+        close(stream.outFD);
+        close(stream.pipeFDs[0]);
+        close(stream.pipeFDs[1]);
+        close(stream.rawFD);
+    }
+    g_streams.clear();
+    free(page);
+
+    ok &= writeStreamFormats();
+    return ok;
+}
+
+// Trace for g_traceDurationSeconds while moving the trace to disk.
+static bool streamTrace()
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    end.tv_sec += g_traceDurationSeconds;
+
+    bool ok = true;
+    while (ok && !g_traceAborted) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > end.tv_sec ||
+                (now.tv_sec == end.tv_sec && now.tv_nsec >= end.tv_nsec)) {
+            break;
+        }
+        struct timespec interval = { 0, k_streamIntervalNs };
+        nanosleep(&interval, NULL);
+        ok = drainStreams();
+    }
+    return ok;
+}
+
+// Write a snapshot of the kernel ring buffer to g_daemonDir, named after
+// the time and the reason of the snapshot, and delete the oldest ones past
+// g_snapshotCount.
+static bool writeSnapshot(const char* reason, Vector<String8>* snapshots)
+{
+    char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y%m%d-%H%M%S", localtime(&now));
+
+    // The reason comes from a property anyone can set, only keep the
+    // characters that are safe in a file name.
+    String8 name;
+    for (const char* c = reason; *c && name.length() < 32; c++) {
+        bool safe = isalnum(*c) || *c == '-' || *c == '_' || *c == '.';
+        name.append(safe ? String8(c, 1) : String8("_"));
+    }
+    String8 path = String8::format("%s/trace-%s-%s%s", g_daemonDir, date,
+            name.string(), g_compress ? ".z" : ".txt");
+
+    int fd = open(path.string(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "error creating %s: %s (%d)\n", path.string(),
+                strerror(errno), errno);
+        return false;
+    }
+
+    // Stop tracing while the buffer is read, so that the snapshot is
+    // consistent, and start again from an empty buffer.
+    stopTrace();
+    dumpTrace(fd);
+    close(fd);
+    clearTrace();
+    startTrace();
+
+    printf("snapshot for \"%s\" written to %s\n", reason, path.string());
+    fflush(stdout);
+
+    snapshots->add(path);
+    while (snapshots->size() > (size_t)g_snapshotCount) {
+        unlink((*snapshots)[0].string());
+        snapshots->removeAt(0);
+    }
+    return true;
+}
+
+// Keep tracing into the circular kernel buffer until a signal, and save
+// its contents whenever k_traceSnapshotProperty is set, at most once every
+// g_snapshotIntervalSecs. The property holds the reason of the snapshot,
+// for instance "jank" when set by SurfaceFlinger, and is cleared once
+// handled.
+static bool runDaemon()
+{
+    Vector<String8> snapshots;
+    time_t lastSnapshot = 0;
+    bool ok = true;
+
+    if (mkdir(g_daemonDir, 0755) == -1 && errno != EEXIST) {
+        fprintf(stderr, "error creating %s: %s (%d)\n", g_daemonDir,
+                strerror(errno), errno);
+        return false;
+    }
+    setTraceSnapshotProperty("");
+
+    while (ok && !g_traceAborted) {
+        struct timespec interval = { 0, k_daemonIntervalNs };
+        nanosleep(&interval, NULL);
+
+        char reason[PROPERTY_VALUE_MAX];
+        if (property_get(k_traceSnapshotProperty, reason, "") <= 0) {
+            continue;
+        }
+        setTraceSnapshotProperty("");
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (lastSnapshot != 0 && now.tv_sec - lastSnapshot < g_snapshotIntervalSecs) {
+            fprintf(stderr, "skipping snapshot for \"%s\", last one was %lds ago\n",
+                    reason, (long)(now.tv_sec - lastSnapshot));
+            continue;
+        }
+        lastSnapshot = now.tv_sec;
+        ok = writeSnapshot(reason, &snapshots);
+    }
+    return ok;
+}
+
 static void handleSignal(int /*signo*/)
 {
     if (!g_nohup) {
@@ -797,6 +1322,18 @@ static void showHelp(const char *cmd)
                     "  -s N            sleep for N seconds before tracing [default 0]\n"
                     "  -t N            trace for N seconds [defualt 5]\n"
                     "  -z              compress the trace dump\n"
+                    "  --fast_compress compress the trace dump faster, but less\n"
+                    "  --stream dir    write the raw trace to dir while tracing, one\n"
+                    "                    series of cpuN.NNNN files per CPU, along\n"
+                    "                    with the event formats\n"
+                    "  --stream_size N only keep the last N MB of the streamed trace\n"
+                    "  --daemon dir    trace into a circular buffer until killed, and\n"
+                    "                    save it to dir whenever the property\n"
+                    "                    debug.atrace.snapshot is set\n"
+                    "  --snapshot_interval N\n"
+                    "                  take at most one snapshot every N seconds [default 60]\n"
+                    "  --snapshot_count N\n"
+                    "                  only keep the last N snapshots [default 10]\n"
                     "  --async_start   start circular trace and return immediatly\n"
                     "  --async_dump    dump the current contents of circular trace buffer\n"
                     "  --async_stop    stop tracing and dump the current contents of circular\n"
@@ -826,6 +1363,12 @@ int main(int argc, char **argv)
             {"async_stop",      no_argument, 0,  0 },
             {"async_dump",      no_argument, 0,  0 },
             {"list_categories", no_argument, 0,  0 },
+            {"fast_compress",   no_argument, 0,  0 },
+            {"stream",          required_argument, 0,  0 },
+            {"stream_size",     required_argument, 0,  0 },
+            {"daemon",          required_argument, 0,  0 },
+            {"snapshot_interval", required_argument, 0,  0 },
+            {"snapshot_count",  required_argument, 0,  0 },
             {           0,                0, 0,  0 }
         };
 
@@ -891,6 +1434,20 @@ int main(int argc, char **argv)
                 } else if (!strcmp(long_options[option_index].name, "list_categories")) {
                     listSupportedCategories();
                     exit(0);
+                } else if (!strcmp(long_options[option_index].name, "fast_compress")) {
+                    g_compress = true;
+                    g_compressLevel = Z_BEST_SPEED;
+                } else if (!strcmp(long_options[option_index].name, "stream")) {
+                    g_streamDir = optarg;
+                } else if (!strcmp(long_options[option_index].name, "stream_size")) {
+                    g_streamSizeMB = atoi(optarg);
+                } else if (!strcmp(long_options[option_index].name, "daemon")) {
+                    g_daemonDir = optarg;
+                    g_traceOverwrite = true;
+                } else if (!strcmp(long_options[option_index].name, "snapshot_interval")) {
+                    g_snapshotIntervalSecs = atoi(optarg);
+                } else if (!strcmp(long_options[option_index].name, "snapshot_count")) {
+                    g_snapshotCount = atoi(optarg);
                 }
             break;
 
@@ -902,6 +1459,26 @@ int main(int argc, char **argv)
         }
     }
 
+    if (g_streamDir != NULL && async) {
+        fprintf(stderr, "error: --stream can't be used with the async options\n");
+        exit(1);
+    }
+    if (g_daemonDir != NULL && (async || g_streamDir != NULL)) {
+        fprintf(stderr, "error: --daemon can't be used with --stream or the "
+                "async options\n");
+        exit(1);
+    }
+    if (g_daemonDir != NULL && optind == argc) {
+        for (int i = 0; i < NELEM(k_daemonCategories); i++) {
+            for (int j = 0; j < NELEM(k_categories); j++) {
+                if (!strcmp(k_daemonCategories[i], k_categories[j].name) &&
+                        isCategorySupported(k_categories[j])) {
+                    g_categoryEnables[j] = true;
+                }
+            }
+        }
+    }
+
     registerSigHandler();
 
     if (g_initialSleepSecs > 0) {
@@ -923,7 +1500,11 @@ int main(int argc, char **argv)
         // another.
         ok = clearTrace();
 
-        if (ok && !async) {
+        if (ok && g_daemonDir != NULL) {
+            ok = runDaemon();
+        } else if (ok && g_streamDir != NULL) {
+            ok = startStreaming() && streamTrace();
+        } else if (ok && !async) {
             // Sleep to allow the trace to be captured.
             struct timespec timeLeft;
             timeLeft.tv_sec = g_traceDurationSeconds;
@@ -940,11 +1521,20 @@ int main(int argc, char **argv)
     if (traceStop)
         stopTrace();
 
-    if (ok && traceDump) {
+    if (g_streamDir != NULL && !g_streams.isEmpty()) {
+        ok &= stopStreaming();
+        if (ok) {
+            printf(" done\nTRACE: written to %s\n", g_streamDir);
+            fflush(stdout);
+        }
+        clearTrace();
+    }
+
+    if (ok && traceDump && g_streamDir == NULL && g_daemonDir == NULL) {
         if (!g_traceAborted) {
             printf(" done\nTRACE:\n");
             fflush(stdout);
-            dumpTrace();
+            dumpTrace(STDOUT_FILENO);
         } else {
             printf("\ntrace aborted.\n");
             fflush(stdout);
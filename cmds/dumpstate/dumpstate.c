@@ -75,42 +75,25 @@ static void get_tombstone_fds(tombstone_data_t data[NUM_TOMBSTONES]) {
     }
 }
 
-/* dumps the current system state to stdout */
-static void dumpstate() {
-    time_t now = time(NULL);
-    char build[PROPERTY_VALUE_MAX], fingerprint[PROPERTY_VALUE_MAX];
-    char radio[PROPERTY_VALUE_MAX], bootloader[PROPERTY_VALUE_MAX];
-    char network[PROPERTY_VALUE_MAX], date[80];
-    char build_type[PROPERTY_VALUE_MAX];
-
-    property_get("ro.build.display.id", build, "(unknown)");
-    property_get("ro.build.fingerprint", fingerprint, "(unknown)");
-    property_get("ro.build.type", build_type, "(unknown)");
-    property_get("ro.baseband", radio, "(unknown)");
-    property_get("ro.bootloader", bootloader, "(unknown)");
-    property_get("gsm.operator.alpha", network, "(unknown)");
-    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&now));
-
-    printf("========================================================\n");
-    printf("== dumpstate: %s\n", date);
-    printf("========================================================\n");
-
-    printf("\n");
-    printf("Build: %s\n", build);
-    printf("Build fingerprint: '%s'\n", fingerprint); /* format is important for other tools */
-    printf("Bootloader: %s\n", bootloader);
-    printf("Radio: %s\n", radio);
-    printf("Network: %s\n", network);
-
-    printf("Kernel: ");
-    dump_file(NULL, "/proc/version");
-    printf("Command line: %s\n", strtok(cmdline_buf, "\n"));
-    printf("\n");
+/* The sections of the report, each one runs in its own process and in
+ * parallel with the others, see run_section(). They are listed in the
+ * order of the report.
+ */
 
+static void dump_uptime_and_memory() {
     run_command("UPTIME", 10, "uptime", NULL);
     dump_file("MEMORY INFO", "/proc/meminfo");
+}
+
+static void dump_cpu_info() {
     run_command("CPU INFO", 10, "top", "-n", "1", "-d", "1", "-m", "30", "-t", NULL);
+}
+
+static void dump_procrank() {
     run_command("PROCRANK", 20, "procrank", NULL);
+}
+
+static void dump_kernel_info() {
     dump_file("VIRTUAL MEMORY STATS", "/proc/vmstat");
     dump_file("VMALLOC INFO", "/proc/vmallocinfo");
     dump_file("SLAB INFO", "/proc/slabinfo");
@@ -124,29 +107,50 @@ static void dumpstate() {
     dump_file("KERNEL CPUFREQ", "/sys/devices/system/cpu/cpu0/cpufreq/stats/time_in_state");
     dump_file("KERNEL SYNC", "/d/sync");
     dump_file("KERNEL BLUEDROID", "/d/bluedroid");
+}
 
+static void dump_processes() {
     run_command("PROCESSES", 10, "ps", "-P", NULL);
     run_command("PROCESSES AND THREADS", 10, "ps", "-t", "-p", "-P", NULL);
     run_command("PROCESSES (SELINUX LABELS)", 10, "ps", "-Z", NULL);
-    run_command("LIBRANK", 10, "librank", NULL);
+}
 
-    do_dmesg();
+static void dump_librank() {
+    run_command("LIBRANK", 10, "librank", NULL);
+}
 
+static void dump_open_files() {
     run_command("LIST OF OPEN FILES", 10, SU_PATH, "root", "lsof", NULL);
+}
+
+static void dump_smaps() {
     for_each_pid(do_showmap, "SMAPS OF ALL PROCESSES");
-    for_each_tid(show_wchan, "BLOCKED PROCESS WAIT-CHANNELS");
+}
 
-    if (screenshot_path[0]) {
-        ALOGI("taking screenshot\n");
-        run_command(NULL, 10, "/system/bin/screencap", "-p", screenshot_path, NULL);
-        ALOGI("wrote screenshot: %s\n", screenshot_path);
-    }
+static void dump_wchans() {
+    show_all_wchans("BLOCKED PROCESS WAIT-CHANNELS");
+}
+
+static void take_screenshot() {
+    ALOGI("taking screenshot\n");
+    run_command(NULL, 10, "/system/bin/screencap", "-p", screenshot_path, NULL);
+    ALOGI("wrote screenshot: %s\n", screenshot_path);
+}
 
+static void dump_system_log() {
     // dump_file("EVENT LOG TAGS", "/etc/event-log-tags");
     run_command("SYSTEM LOG", 20, "logcat", "-v", "threadtime", "-d", "*:v", NULL);
+}
+
+static void dump_event_log() {
     run_command("EVENT LOG", 20, "logcat", "-b", "events", "-v", "threadtime", "-d", "*:v", NULL);
+}
+
+static void dump_radio_log() {
     run_command("RADIO LOG", 20, "logcat", "-b", "radio", "-v", "threadtime", "-d", "*:v", NULL);
+}
 
+static void dump_traces_and_tombstones() {
     /* show the traces we collected in main(), if that was done */
     if (dump_traces_path != NULL) {
         dump_file("VM TRACES JUST NOW", dump_traces_path);
@@ -213,8 +217,14 @@ static void dumpstate() {
 
     dump_file("LAST PANIC CONSOLE", "/data/dontpanic/apanic_console");
     dump_file("LAST PANIC THREADS", "/data/dontpanic/apanic_threads");
+}
 
+static void dump_settings() {
     for_each_userid(do_dump_settings, NULL);
+}
+
+static void dump_network() {
+    char network[PROPERTY_VALUE_MAX];
 
     /* The following have a tendency to get wedged when wifi drivers/fw goes belly-up. */
     run_command("NETWORK INTERFACES", 10, SU_PATH, "root", "netcfg", NULL);
@@ -262,7 +272,9 @@ static void dumpstate() {
             SU_PATH, "root", "wlutil", "counters", NULL);
 #endif
     dump_file("INTERRUPTS (2)", "/proc/interrupts");
+}
 
+static void dump_storage() {
     print_properties();
 
     run_command("VOLD DUMP", 10, "vdc", "dump", NULL);
@@ -274,7 +286,9 @@ static void dumpstate() {
     dump_file("PACKAGE UID ERRORS", "/data/system/uiderrors.txt");
 
     run_command("LAST RADIO LOG", 10, "parse_radio_log", "/proc/last_radio_log", NULL);
+}
 
+static void dump_backlights_and_binder() {
     printf("------ BACKLIGHTS ------\n");
     printf("LCD brightness=");
     dump_file(NULL, "/sys/class/leds/lcd-backlight/brightness");
@@ -294,7 +308,9 @@ static void dumpstate() {
     dump_file("BINDER TRANSACTIONS", "/sys/kernel/debug/binder/transactions");
     dump_file("BINDER STATS", "/sys/kernel/debug/binder/stats");
     dump_file("BINDER STATE", "/sys/kernel/debug/binder/state");
+}
 
+static void dump_board() {
     printf("========================================================\n");
     printf("== Board\n");
     printf("========================================================\n");
@@ -303,7 +319,9 @@ static void dumpstate() {
     printf("\n");
 
     /* Migrate the ril_dumpstate to a dumpstate_board()? */
+    char build_type[PROPERTY_VALUE_MAX];
     char ril_dumpstate_timeout[PROPERTY_VALUE_MAX] = {0};
+    property_get("ro.build.type", build_type, "(unknown)");
     property_get("ril.dumpstate.timeout", ril_dumpstate_timeout, "30");
     if (strnlen(ril_dumpstate_timeout, PROPERTY_VALUE_MAX - 1) > 0) {
         if (0 == strncmp(build_type, "user", PROPERTY_VALUE_MAX - 1)) {
@@ -317,16 +335,19 @@ static void dumpstate() {
                     SU_PATH, "root", "vril-dump", NULL);
         }
     }
+}
 
+static void dump_framework_services() {
     printf("========================================================\n");
     printf("== Android Framework Services\n");
     printf("========================================================\n");
 
-    /* the full dumpsys is starting to take a long time, so we need
-       to increase its timeout.  we really need to do the timeouts in
-       dumpsys itself... */
-    run_command("DUMPSYS", 60, "dumpsys", NULL);
+    /* dumpsys dumps 4 services at once and gives up on any of them
+       after 10s, the overall timeout is only there as a last resort */
+    run_command("DUMPSYS", 60, "dumpsys", "-j", "4", "-t", "10", NULL);
+}
 
+static void dump_checkins() {
     printf("========================================================\n");
     printf("== Checkins\n");
     printf("========================================================\n");
@@ -336,36 +357,109 @@ static void dumpstate() {
     run_command("CHECKIN NETSTATS", 30, "dumpsys", "netstats", "--checkin", NULL);
     run_command("CHECKIN PROCSTATS", 30, "dumpsys", "procstats", "-c", NULL);
     run_command("CHECKIN USAGESTATS", 30, "dumpsys", "usagestats", "-c", NULL);
+}
 
+static void dump_app_activities() {
     printf("========================================================\n");
     printf("== Running Application Activities\n");
     printf("========================================================\n");
 
     run_command("APP ACTIVITIES", 30, "dumpsys", "activity", "all", NULL);
+}
 
+static void dump_app_services() {
     printf("========================================================\n");
     printf("== Running Application Services\n");
     printf("========================================================\n");
 
     run_command("APP SERVICES", 30, "dumpsys", "activity", "service", "all", NULL);
+}
 
+static void dump_app_providers() {
     printf("========================================================\n");
     printf("== Running Application Providers\n");
     printf("========================================================\n");
 
     run_command("APP SERVICES", 30, "dumpsys", "activity", "provider", "all", NULL);
+}
+
+static void dump_header() {
+    time_t now = time(NULL);
+    char build[PROPERTY_VALUE_MAX], fingerprint[PROPERTY_VALUE_MAX];
+    char radio[PROPERTY_VALUE_MAX], bootloader[PROPERTY_VALUE_MAX];
+    char network[PROPERTY_VALUE_MAX], date[80];
+
+    property_get("ro.build.display.id", build, "(unknown)");
+    property_get("ro.build.fingerprint", fingerprint, "(unknown)");
+    property_get("ro.baseband", radio, "(unknown)");
+    property_get("ro.bootloader", bootloader, "(unknown)");
+    property_get("gsm.operator.alpha", network, "(unknown)");
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    printf("========================================================\n");
+    printf("== dumpstate: %s\n", date);
+    printf("========================================================\n");
+
+    printf("\n");
+    printf("Build: %s\n", build);
+    printf("Build fingerprint: '%s'\n", fingerprint); /* format is important for other tools */
+    printf("Bootloader: %s\n", bootloader);
+    printf("Radio: %s\n", radio);
+    printf("Network: %s\n", network);
 
+    printf("Kernel: ");
+    dump_file(NULL, "/proc/version");
+    printf("Command line: %s\n", strtok(cmdline_buf, "\n"));
+    printf("\n");
+}
 
+static void dump_footer() {
     printf("========================================================\n");
     printf("== dumpstate: done\n");
     printf("========================================================\n");
 }
 
+/* dumps the current system state to stdout */
+static void dumpstate() {
+    /* The timeouts only stop the sections that got stuck, the commands
+       they run have their own. */
+    run_section("dumpstate", 10, dump_header);
+    run_section("UPTIME", 20, dump_uptime_and_memory);
+    run_section("CPU INFO", 20, dump_cpu_info);
+    run_section("PROCRANK", 30, dump_procrank);
+    run_section("KERNEL INFO", 30, dump_kernel_info);
+    run_section("PROCESSES", 40, dump_processes);
+    run_section("LIBRANK", 20, dump_librank);
+    run_section("KERNEL LOG", 20, do_dmesg);
+    run_section("LIST OF OPEN FILES", 20, dump_open_files);
+    run_section("SMAPS OF ALL PROCESSES", 300, dump_smaps);
+    run_section("BLOCKED PROCESS WAIT-CHANNELS", 60, dump_wchans);
+    if (screenshot_path[0]) {
+        run_section("SCREENSHOT", 20, take_screenshot);
+    }
+    run_section("SYSTEM LOG", 30, dump_system_log);
+    run_section("EVENT LOG", 30, dump_event_log);
+    run_section("RADIO LOG", 30, dump_radio_log);
+    run_section("VM TRACES", 60, dump_traces_and_tombstones);
+    run_section("SYSTEM SETTINGS", 120, dump_settings);
+    run_section("NETWORK", 300, dump_network);
+    run_section("SYSTEM PROPERTIES", 90, dump_storage);
+    run_section("BACKLIGHTS", 30, dump_backlights_and_binder);
+    run_section("BOARD", 300, dump_board);
+    run_section("DUMPSYS", 70, dump_framework_services);
+    run_section("CHECKINS", 160, dump_checkins);
+    run_section("APP ACTIVITIES", 40, dump_app_activities);
+    run_section("APP SERVICES", 40, dump_app_services);
+    run_section("APP PROVIDERS", 40, dump_app_providers);
+    run_section("dumpstate: done", 10, dump_footer);
+    finish_sections();
+}
+
 static void usage() {
     fprintf(stderr, "usage: dumpstate [-b soundfile] [-e soundfile] [-o file [-d] [-p] [-z]] [-s] [-q]\n"
             "  -o: write to file (instead of stdout)\n"
             "  -d: append date to filename (requires -o)\n"
-            "  -z: gzip output (requires -o)\n"
+            "  -z: gzip output, one gzip member per section (requires -o or -s)\n"
             "  -p: capture screenshot to filename.png (requires -o)\n"
             "  -s: write output to control socket (for init)\n"
             "  -b: play sound file instead of vibrate, at beginning of job\n"
@@ -508,7 +602,6 @@ int main(int argc, char *argv[]) {
 
     /* redirect output if needed */
     char path[PATH_MAX], tmp_path[PATH_MAX];
-    pid_t gzip_pid = -1;
 
     if (!use_socket && use_outfile) {
         strlcpy(path, use_outfile, sizeof(path));
@@ -526,10 +619,14 @@ int main(int argc, char *argv[]) {
         if (do_compress) strlcat(path, ".gz", sizeof(path));
         strlcpy(tmp_path, path, sizeof(tmp_path));
         strlcat(tmp_path, ".tmp", sizeof(tmp_path));
-        gzip_pid = redirect_to_file(stdout, tmp_path, do_compress);
+        redirect_to_file(stdout, tmp_path, 0);
+    }
+    if (do_compress && (use_socket || use_outfile)) {
+        report_compress(stdout, do_compress);
     }
 
     dumpstate();
+    report_finish();
 
     /* done */
     if (vibrator) {
@@ -540,10 +637,8 @@ int main(int argc, char *argv[]) {
         fclose(vibrator);
     }
 
-    /* wait for gzip to finish, otherwise it might get killed when we exit */
-    if (gzip_pid > 0) {
+    if (report_is_compressed()) {
         fclose(stdout);
-        waitpid(gzip_pid, NULL, 0);
     }
 
     /* rename the (now complete) .tmp file to its final location */
@@ -27,6 +27,7 @@
 typedef void (for_each_pid_func)(int, const char *);
 typedef void (for_each_tid_func)(int, int, const char *);
 typedef void (for_each_userid_func)(int);
+typedef void (section_func)(void);
 
 /* prints the contents of a file */
 int dump_file(const char *title, const char *path);
@@ -37,6 +38,26 @@ int dump_file_from_fd(const char *title, const char *path, int fd);
 /* forks a command and waits for it to finish -- terminate args with NULL */
 int run_command(const char *title, int timeout_seconds, const char *command, ...);
 
+/* runs func in a child process, its output is buffered and written to
+   stdout after the output of the sections started before it */
+void run_section(const char *title, int timeout_seconds, section_func func);
+
+/* waits for the running sections and writes their output */
+void finish_sections();
+
+/* compresses the report written to out, one gzip member per section */
+void report_compress(FILE *out, int level);
+
+bool report_is_compressed();
+
+/* the output of the sections, written by the main process only */
+void report_section_begin(const char *title);
+void report_write(const void *data, size_t len);
+void report_section_end();
+
+/* ends the last section and flushes the report */
+void report_finish();
+
 /* prints all the system properties */
 void print_properties();
 
@@ -61,6 +82,10 @@ void for_each_userid(for_each_userid_func func, const char *header);
 /* Displays a blocked processes in-kernel wait channel */
 void show_wchan(int pid, int tid, const char *name);
 
+/* Displays the wait channels of all threads, like for_each_tid(show_wchan),
+   reading each task directory once and walking processes in parallel */
+void show_all_wchans(const char *header);
+
 /* Runs "showmap" for a process */
 void do_showmap(int pid, const char *name);
 
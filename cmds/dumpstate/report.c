@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#include "dumpstate.h"
+
+/*
+ * Writes the report, compressed as one gzip member per section when
+ * report_compress() was called. The concatenated members are a regular gzip
+ * file, so "gunzip" or "zcat" still give the whole text report. Like the
+ * BGZF files of the bioinformatics tools, every member header also carries:
+ *  - an extra field with subfield ID "DS" and a 4 byte little endian length,
+ *    the size of the whole member in bytes,
+ *  - the title of the section as the member's comment (FCOMMENT).
+ * A reader can walk the headers from one member to the next and decompress
+ * only the sections it needs.
+ */
+
+#define GZIP_FLAG_EXTRA     0x04
+#define GZIP_FLAG_COMMENT   0x10
+#define GZIP_OS_UNIX        3
+#define GZIP_HEADER_SIZE    10
+#define GZIP_EXTRA_SIZE     10  /* XLEN, subfield id, length and value */
+#define GZIP_TRAILER_SIZE   8
+
+static FILE *out;
+static int level;               /* 0 if the report isn't compressed */
+static const char *title;       /* of the current section, NULL if none */
+static z_stream stream;
+static unsigned char *member;   /* compressed data of the current section */
+static size_t member_len;
+static size_t member_size;
+static uLong crc;
+
+void report_compress(FILE *f, int compression_level) {
+    out = f;
+    level = compression_level;
+}
+
+bool report_is_compressed() {
+    return level != 0;
+}
+
+static void put_le32(unsigned char *p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+/* Compresses the input of the stream, flush is passed to deflate(). */
+static void deflate_input(int flush) {
+    do {
+        if (member_size - member_len < 65536) {
+            size_t size = member_size ? member_size * 2 : 65536 * 2;
+            unsigned char *buf = realloc(member, size);
+            if (buf == NULL) {
+                fprintf(stderr, "out of memory compressing %s\n", title);
+                exit(1);
+            }
+            member = buf;
+            member_size = size;
+        }
+        stream.next_out = member + member_len;
+        stream.avail_out = member_size - member_len;
+        deflate(&stream, flush);
+        member_len = member_size - stream.avail_out;
+    } while (stream.avail_in > 0 || stream.avail_out == 0);
+}
+
+void report_section_begin(const char *section_title) {
+    if (!level) {
+        return;
+    }
+    title = section_title;
+    memset(&stream, 0, sizeof(stream));
+    /* raw deflate, the gzip header and trailer are written below */
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "deflateInit2 failed\n");
+        exit(1);
+    }
+    member_len = 0;
+    crc = crc32(0L, Z_NULL, 0);
+}
+
+void report_write(const void *data, size_t len) {
+    if (!level) {
+        fwrite(data, len, 1, stdout);
+        return;
+    }
+    if (title == NULL) {
+        report_section_begin("dumpstate");
+    }
+    crc = crc32(crc, data, len);
+    stream.next_in = (Bytef *) data;
+    stream.avail_in = len;
+    deflate_input(Z_NO_FLUSH);
+}
+
+void report_section_end() {
+    unsigned char header[GZIP_HEADER_SIZE + GZIP_EXTRA_SIZE];
+    unsigned char trailer[GZIP_TRAILER_SIZE];
+
+    if (!level || title == NULL) {
+        return;
+    }
+    stream.avail_in = 0;
+    deflate_input(Z_FINISH);
+
+    size_t comment_len = strlen(title) + 1;
+    size_t size = sizeof(header) + comment_len + member_len + sizeof(trailer);
+
+    memset(header, 0, sizeof(header));
+    header[0] = 0x1f;
+    header[1] = 0x8b;
+    header[2] = Z_DEFLATED;
+    header[3] = GZIP_FLAG_EXTRA | GZIP_FLAG_COMMENT;
+    /* MTIME and XFL are left at 0 */
+    header[9] = GZIP_OS_UNIX;
+    header[10] = 8;     /* XLEN, little endian */
+    header[12] = 'D';
+    header[13] = 'S';
+    header[14] = 4;     /* subfield length, little endian */
+    put_le32(header + 16, size);
+
+    put_le32(trailer, crc);
+    put_le32(trailer + 4, stream.total_in);
+
+    fwrite(header, sizeof(header), 1, out);
+    fwrite(title, comment_len, 1, out);
+    fwrite(member, member_len, 1, out);
+    fwrite(trailer, sizeof(trailer), 1, out);
+    fflush(out);
+
+    deflateEnd(&stream);
+    title = NULL;
+}
+
+void report_finish() {
+    report_section_end();
+    free(member);
+    member = NULL;
+    member_size = 0;
+    fflush(level ? out : stdout);
+}
@@ -19,6 +19,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <poll.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -44,6 +45,9 @@
 
 static const int64_t NANOS_PER_SEC = 1000000000;
 
+/* the most threads show_all_wchans() walks /proc with */
+#define MAX_WALK_THREADS 4
+
 /* list of native processes to include in the native dumps */
 static const char* native_processes_to_dump[] = {
         "/system/bin/drmserver",
@@ -76,7 +80,25 @@ void for_each_userid(void (*func)(int), const char *header) {
     closedir(d);
 }
 
-static void __for_each_pid(void (*helper)(int, const char *, void *), const char *header, void *arg) {
+/* reads a file of a /proc directory into buf, NUL terminated; returns the
+   length read, or -1 with errno set */
+static ssize_t read_proc_file(int dirfd, const char *name, char *buf, size_t size) {
+    int fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t len = TEMP_FAILURE_RETRY(read(fd, buf, size - 1));
+    int err = errno;
+    close(fd);
+    if (len < 0) {
+        errno = err;
+        return -1;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+static void __for_each_pid(void (*helper)(int, int, const char *, void *), const char *header, void *arg) {
     DIR *d;
     struct dirent *de;
 
@@ -88,29 +110,29 @@ static void __for_each_pid(void (*helper)(int, const char *, void *), const char
     printf("\n------ %s ------\n", header);
     while ((de = readdir(d))) {
         int pid;
-        int fd;
-        char cmdpath[255];
+        int pidfd;
         char cmdline[255];
 
         if (!(pid = atoi(de->d_name))) {
             continue;
         }
 
-        sprintf(cmdpath,"/proc/%d/cmdline", pid);
-        memset(cmdline, 0, sizeof(cmdline));
-        if ((fd = open(cmdpath, O_RDONLY)) < 0) {
+        /* the files of each process are opened relative to its directory,
+           which saves the kernel a path walk each */
+        pidfd = openat(dirfd(d), de->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (pidfd < 0 || read_proc_file(pidfd, "cmdline", cmdline, sizeof(cmdline)) < 0) {
             strcpy(cmdline, "N/A");
-        } else {
-            read(fd, cmdline, sizeof(cmdline) - 1);
-            close(fd);
         }
-        helper(pid, cmdline, arg);
+        helper(pid, pidfd, cmdline, arg);
+        if (pidfd >= 0) {
+            close(pidfd);
+        }
     }
 
     closedir(d);
 }
 
-static void for_each_pid_helper(int pid, const char *cmdline, void *arg) {
+static void for_each_pid_helper(int pid, int pidfd, const char *cmdline, void *arg) {
     for_each_pid_func *func = arg;
     func(pid, cmdline);
 }
@@ -119,16 +141,23 @@ void for_each_pid(for_each_pid_func func, const char *header) {
     __for_each_pid(for_each_pid_helper, header, func);
 }
 
-static void for_each_tid_helper(int pid, const char *cmdline, void *arg) {
+/* opens the task directory of a process, for fdopendir() */
+static int open_task_dir(int pid, int pidfd) {
+    int taskfd = pidfd < 0 ? -1 : openat(pidfd, "task", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskfd < 0) {
+        printf("Failed to open /proc/%d/task (%s)\n", pid, strerror(errno));
+    }
+    return taskfd;
+}
+
+static void for_each_tid_helper(int pid, int pidfd, const char *cmdline, void *arg) {
     DIR *d;
     struct dirent *de;
-    char taskpath[255];
+    int taskfd;
     for_each_tid_func *func = arg;
 
-    sprintf(taskpath, "/proc/%d/task", pid);
-
-    if (!(d = opendir(taskpath))) {
-        printf("Failed to open %s (%s)\n", taskpath, strerror(errno));
+    if ((taskfd = open_task_dir(pid, pidfd)) < 0 || !(d = fdopendir(taskfd))) {
+        if (taskfd >= 0) close(taskfd);
         return;
     }
 
@@ -136,8 +165,6 @@ static void for_each_tid_helper(int pid, const char *cmdline, void *arg) {
 
     while ((de = readdir(d))) {
         int tid;
-        int fd;
-        char commpath[255];
         char comm[255];
 
         if (!(tid = atoi(de->d_name))) {
@@ -147,16 +174,12 @@ static void for_each_tid_helper(int pid, const char *cmdline, void *arg) {
         if (tid == pid)
             continue;
 
-        sprintf(commpath,"/proc/%d/comm", tid);
-        memset(comm, 0, sizeof(comm));
-        if ((fd = open(commpath, O_RDONLY)) < 0) {
+        char commpath[sizeof(de->d_name) + 8];
+        snprintf(commpath, sizeof(commpath), "%s/comm", de->d_name);
+        if (read_proc_file(taskfd, commpath, comm, sizeof(comm)) < 0) {
             strcpy(comm, "N/A");
         } else {
-            char *c;
-            read(fd, comm, sizeof(comm) - 1);
-            close(fd);
-
-            c = strrchr(comm, '\n');
+            char *c = strrchr(comm, '\n');
             if (c) {
                 *c = '\0';
             }
@@ -200,6 +223,179 @@ out_close:
     return;
 }
 
+/* the output of one process in show_all_wchans() */
+struct wchan_output {
+    int pid;
+    char *data;
+    size_t len;
+};
+
+struct wchan_walk {
+    struct wchan_output *outputs;
+    size_t count;
+    volatile int32_t next;
+};
+
+static void __attribute__((format(printf, 2, 3)))
+wchan_printf(struct wchan_output *out, const char *fmt, ...) {
+    char line[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (len < 0) {
+        return;
+    }
+    if ((size_t) len >= sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+    char *data = realloc(out->data, out->len + len);
+    if (!data) {
+        return;
+    }
+    memcpy(data + out->len, line, len);
+    out->data = data;
+    out->len += len;
+}
+
+/* the same lines as show_wchan() for one thread; dirfd is its directory */
+static void wchan_print_task(struct wchan_output *out, int pid, int tid, int dirfd,
+        const char *name) {
+    char buffer[255];
+    char name_buffer[255];
+
+    if (read_proc_file(dirfd, "wchan", buffer, sizeof(buffer)) < 0) {
+        wchan_printf(out, "Failed to open '/proc/%d/wchan' (%s)\n", tid, strerror(errno));
+        return;
+    }
+    snprintf(name_buffer, sizeof(name_buffer), "%*s%s",
+             pid == tid ? 0 : 3, "", name);
+    wchan_printf(out, "%-7d %-32s %s\n", tid, name_buffer, buffer);
+}
+
+static void wchan_walk_process(struct wchan_output *out) {
+    char path[32];
+    char cmdline[255];
+    int pid = out->pid;
+    int pidfd, taskfd;
+    DIR *d;
+    struct dirent *de;
+
+    snprintf(path, sizeof(path), "/proc/%d", pid);
+    pidfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (pidfd < 0) {
+        /* it exited since we listed it */
+        return;
+    }
+    if (read_proc_file(pidfd, "cmdline", cmdline, sizeof(cmdline)) < 0) {
+        strcpy(cmdline, "N/A");
+    }
+    taskfd = openat(pidfd, "task", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskfd < 0 || !(d = fdopendir(taskfd))) {
+        wchan_printf(out, "Failed to open /proc/%d/task (%s)\n", pid, strerror(errno));
+        if (taskfd >= 0) close(taskfd);
+        close(pidfd);
+        return;
+    }
+
+    wchan_print_task(out, pid, pid, pidfd, cmdline);
+    while ((de = readdir(d))) {
+        int tid = atoi(de->d_name);
+        int tidfd;
+        char comm[255];
+
+        if (!tid || tid == pid) {
+            continue;
+        }
+        tidfd = openat(taskfd, de->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (tidfd < 0) {
+            continue;
+        }
+        if (read_proc_file(tidfd, "comm", comm, sizeof(comm)) < 0) {
+            strcpy(comm, "N/A");
+        } else {
+            char *c = strrchr(comm, '\n');
+            if (c) {
+                *c = '\0';
+            }
+        }
+        wchan_print_task(out, pid, tid, tidfd, comm);
+        close(tidfd);
+    }
+
+    closedir(d);
+    close(pidfd);
+}
+
+static void *wchan_worker(void *arg) {
+    struct wchan_walk *walk = arg;
+    for (;;) {
+        size_t i = (size_t) __sync_fetch_and_add(&walk->next, 1);
+        if (i >= walk->count) {
+            return NULL;
+        }
+        wchan_walk_process(&walk->outputs[i]);
+    }
+}
+
+void show_all_wchans(const char *header) {
+    DIR *d;
+    struct dirent *de;
+    struct wchan_walk walk;
+    size_t capacity = 0;
+
+    if (!(d = opendir("/proc"))) {
+        printf("Failed to open /proc (%s)\n", strerror(errno));
+        return;
+    }
+
+    memset(&walk, 0, sizeof(walk));
+    while ((de = readdir(d))) {
+        int pid = atoi(de->d_name);
+        if (!pid) {
+            continue;
+        }
+        if (walk.count == capacity) {
+            capacity = capacity ? capacity * 2 : 512;
+            struct wchan_output *outputs =
+                    realloc(walk.outputs, capacity * sizeof(*outputs));
+            if (!outputs) {
+                break;
+            }
+            walk.outputs = outputs;
+        }
+        walk.outputs[walk.count].pid = pid;
+        walk.outputs[walk.count].data = NULL;
+        walk.outputs[walk.count].len = 0;
+        walk.count++;
+    }
+    closedir(d);
+
+    /* the processes are walked in parallel, and printed in order */
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int nthreads = cpus < 1 ? 1 : cpus > MAX_WALK_THREADS ? MAX_WALK_THREADS : cpus;
+    pthread_t threads[MAX_WALK_THREADS];
+    int started = 0;
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[started], NULL, wchan_worker, &walk) == 0) {
+            started++;
+        }
+    }
+    wchan_worker(&walk);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    printf("\n------ %s ------\n", header);
+    for (size_t i = 0; i < walk.count; i++) {
+        if (walk.outputs[i].len) {
+            fwrite(walk.outputs[i].data, 1, walk.outputs[i].len, stdout);
+        }
+        free(walk.outputs[i].data);
+    }
+    free(walk.outputs);
+}
+
 void do_dump_settings(int userid) {
     char title[255];
     char dbpath[255];
@@ -369,6 +565,229 @@ int run_command(const char *title, int timeout_seconds, const char *command, ...
     }
 }
 
+/*
+ * Sections of the report run in child processes, so that the helpers above
+ * can keep printing to stdout. The output of each child is read from a pipe
+ * and written to the real stdout in the order the sections were started:
+ * the oldest section still running streams its output directly, the ones
+ * started after it are buffered until it completes.
+ */
+
+#define MAX_RUNNING_SECTIONS 4
+
+typedef struct section {
+    struct section *next;
+    const char *title;
+    pid_t pid;
+    int fd;             /* read end of the child's stdout, -1 once closed */
+    int64_t start;
+    int64_t deadline;
+    char *buf;          /* output received while an older section ran */
+    size_t len;
+    size_t size;
+} section_t;
+
+static section_t *sections;     /* in the order they were started */
+static int num_running_sections;
+
+static void append_section_output(section_t *section, const char *data, size_t len) {
+    if (section == sections) {
+        report_write(data, len);
+        return;
+    }
+    if (section->len + len > section->size) {
+        size_t size = section->size ? section->size * 2 : 65536;
+        while (size < section->len + len) {
+            size *= 2;
+        }
+        char *buf = realloc(section->buf, size);
+        if (buf == NULL) {
+            return;  /* drop the output rather than the whole report */
+        }
+        section->buf = buf;
+        section->size = size;
+    }
+    memcpy(section->buf + section->len, data, len);
+    section->len += len;
+}
+
+static void end_section(section_t *section, bool timed_out) {
+    int status;
+
+    if (timed_out) {
+        char msg[255];
+        /* the commands run by the section die with it, see run_command() */
+        kill(section->pid, SIGKILL);
+        snprintf(msg, sizeof(msg), "*** %s: Timed out after %ds (killed pid %d)\n\n",
+                section->title, (int) ((nanotime() - section->start) / NANOS_PER_SEC),
+                section->pid);
+        append_section_output(section, msg, strlen(msg));
+    }
+    close(section->fd);
+    section->fd = -1;
+    waitpid(section->pid, &status, 0);
+    num_running_sections--;
+}
+
+/* Writes the output of the oldest sections that completed. */
+static void write_completed_sections() {
+    while (sections != NULL && sections->fd < 0) {
+        section_t *section = sections;
+        sections = section->next;
+        report_section_end();
+        free(section->buf);
+        free(section);
+        if (sections != NULL) {
+            report_section_begin(sections->title);
+            report_write(sections->buf, sections->len);
+            sections->len = 0;
+        }
+    }
+    fflush(stdout);
+}
+
+/* Reads the output of the running sections until one of them completes. */
+static void wait_for_section() {
+    struct pollfd pfds[MAX_RUNNING_SECTIONS];
+    section_t *running[MAX_RUNNING_SECTIONS];
+    char buffer[32768];
+    int completed = 0;
+
+    while (!completed && num_running_sections > 0) {
+        int64_t now = nanotime();
+        int64_t timeout = NANOS_PER_SEC;
+        int n = 0;
+        section_t *section;
+
+        for (section = sections; section != NULL; section = section->next) {
+            if (section->fd < 0) {
+                continue;
+            }
+            if (section->deadline <= now) {
+                end_section(section, true);
+                completed = 1;
+                continue;
+            }
+            if (section->deadline - now < timeout) {
+                timeout = section->deadline - now;
+            }
+            pfds[n].fd = section->fd;
+            pfds[n].events = POLLIN;
+            pfds[n].revents = 0;
+            running[n++] = section;
+        }
+        if (completed || n == 0) {
+            break;
+        }
+
+        if (poll(pfds, n, (int) (timeout / 1000000) + 1) < 0 && errno != EINTR) {
+            fprintf(stderr, "poll: %s\n", strerror(errno));
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!pfds[i].revents) {
+                continue;
+            }
+            ssize_t ret = TEMP_FAILURE_RETRY(read(pfds[i].fd, buffer, sizeof(buffer)));
+            if (ret > 0) {
+                append_section_output(running[i], buffer, ret);
+            } else {
+                end_section(running[i], false);
+                completed = 1;
+            }
+        }
+    }
+    write_completed_sections();
+}
+
+/* Runs func in this process when a child can't be started. */
+static void run_section_inline(const char *title, section_func func) {
+    char msg[255];
+    int err = errno;
+
+    finish_sections();
+    snprintf(msg, sizeof(msg), "*** %s: %s\n", title, strerror(err));
+    report_section_begin(title);
+    report_write(msg, strlen(msg));
+    if (report_is_compressed()) {
+        /* func prints to stdout, which is the compressed report */
+        report_section_end();
+        return;
+    }
+    func();
+    fflush(stdout);
+    report_section_end();
+}
+
+/* runs func in a child process, its output follows the earlier sections' */
+void run_section(const char *title, int timeout_seconds, section_func func) {
+    int fds[2];
+
+    while (num_running_sections >= MAX_RUNNING_SECTIONS) {
+        wait_for_section();
+    }
+
+    fflush(stdout);
+    pid_t pid = -1;
+    if (pipe(fds) == 0) {
+        pid = fork();
+        if (pid < 0) {
+            int err = errno;
+            close(fds[0]);
+            close(fds[1]);
+            errno = err;    /* reported by run_section_inline */
+        }
+    }
+    if (pid < 0) {
+        run_section_inline(title, func);
+        return;
+    }
+
+    if (pid == 0) {
+        /* make sure the section dies when dumpstate dies */
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+        func();
+        fflush(stdout);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    section_t *section = calloc(1, sizeof(section_t));
+    if (section == NULL) {
+        /* can't happen in practice; wait for it rather than lose track */
+        kill(pid, SIGKILL);
+        close(fds[0]);
+        waitpid(pid, NULL, 0);
+        return;
+    }
+    section->title = title;
+    section->pid = pid;
+    section->fd = fds[0];
+    section->start = nanotime();
+    section->deadline = section->start + (int64_t) timeout_seconds * NANOS_PER_SEC;
+
+    section_t **link = &sections;
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+    *link = section;
+    num_running_sections++;
+    if (section == sections) {
+        report_section_begin(title);
+    }
+}
+
+/* waits for the running sections and writes their output */
+void finish_sections() {
+    while (num_running_sections > 0) {
+        wait_for_section();
+    }
+    write_completed_sections();
+}
+
 size_t num_props = 0;
 static char* props[2000];
 
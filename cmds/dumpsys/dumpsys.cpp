@@ -10,9 +10,14 @@
 #include <binder/ProcessState.h>
 #include <binder/IServiceManager.h>
 #include <binder/TextOutput.h>
+#include <utils/Timers.h>
 #include <utils/Vector.h>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -26,6 +31,229 @@ static int sort_func(const String16* lhs, const String16* rhs)
     return lhs->compare(*rhs);
 }
 
+static void usage()
+{
+    fprintf(stderr,
+        "usage: dumpsys [-j JOBS] [-t TIMEOUT] [SERVICE [ARGS]]\n"
+        "       dumpsys -l\n"
+        "  -l: only list the services\n"
+        "  -j: dump up to JOBS services at once\n"
+        "  -t: give up on a service after TIMEOUT seconds\n");
+}
+
+static void printSeparator(const String16& name)
+{
+    aout << "------------------------------------------------------------"
+            "-------------------" << endl;
+    aout << "DUMP OF SERVICE " << name << ":" << endl;
+}
+
+static void writeAll(int fd, const char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+// A service dumped into a pipe by its own thread, so that several services
+// are dumped at once and a hung one can be given up on.
+struct DumpJob {
+    String16 name;
+    sp<IBinder> service;
+    pthread_t thread;
+    int fd;                 // read end of the pipe, -1 once done
+    nsecs_t start;
+    nsecs_t end;
+    bool headerShown;
+    bool timedOut;
+    Vector<char> pending;   // output received while an earlier one was shown
+};
+
+struct DumpThreadArgs {
+    sp<IBinder> service;
+    String16 name;
+    Vector<String16> args;
+    int fd;
+};
+
+static void* dumpThread(void* arg)
+{
+    DumpThreadArgs* a = static_cast<DumpThreadArgs*>(arg);
+    int err = a->service->dump(a->fd, a->args);
+    if (err != 0) {
+        aerr << "Error dumping service info: (" << strerror(err)
+                << ") " << a->name << endl;
+    }
+    close(a->fd);
+    delete a;
+    return NULL;
+}
+
+static bool startDump(DumpJob* job, const Vector<String16>& args)
+{
+    int fds[2];
+    job->start = systemTime(SYSTEM_TIME_MONOTONIC);
+    job->end = job->start;
+    if (pipe(fds) != 0) {
+        aerr << "Failed to create pipe to dump service info for " << job->name
+                << ": " << strerror(errno) << endl;
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+    DumpThreadArgs* a = new DumpThreadArgs;
+    a->service = job->service;
+    a->name = job->name;
+    a->args = args;
+    a->fd = fds[1];
+
+    int err = pthread_create(&job->thread, NULL, dumpThread, a);
+    if (err != 0) {
+        aerr << "Failed to start thread to dump service info for " << job->name
+                << ": " << strerror(err) << endl;
+        delete a;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    job->fd = fds[0];
+    return true;
+}
+
+static void finishDump(DumpJob* job, bool timedOut)
+{
+    close(job->fd);
+    job->fd = -1;
+    job->end = systemTime(SYSTEM_TIME_MONOTONIC);
+    job->timedOut = timedOut;
+    if (!timedOut) {
+        // the thread closed the pipe, it only has its reference to drop
+        pthread_join(job->thread, NULL);
+    }
+}
+
+// Dumps the services with up to maxJobs threads. The output is still shown
+// in the order of the list: the first service not done yet is written as
+// it comes, the output of the following ones is kept until it completes.
+// A service still dumping after timeout seconds is reported and skipped;
+// its thread is left blocked in the binder call. Returns false if such
+// threads are left, the others are joined.
+static bool dumpServices(Vector<DumpJob>& jobs, const Vector<String16>& args,
+        size_t maxJobs, int timeout, bool showHeaders)
+{
+    bool joined = true;
+    const size_t N = jobs.size();
+    const nsecs_t timeoutNs = seconds_to_nanoseconds(timeout);
+    size_t head = 0;
+    size_t next = 0;
+    char buffer[32768];
+
+    while (head < N) {
+        while (next < N && next - head < maxJobs) {
+            DumpJob& job(jobs.editItemAt(next++));
+            if (job.service != NULL) {
+                startDump(&job, args);
+            }
+        }
+
+        // show the first service and write what it dumped so far
+        DumpJob& first(jobs.editItemAt(head));
+        if (first.service == NULL) {
+            aerr << "Can't find service: " << first.name << endl;
+            head++;
+            continue;
+        }
+        if (!first.headerShown) {
+            if (showHeaders) {
+                printSeparator(first.name);
+            }
+            first.headerShown = true;
+        }
+        if (first.pending.size() > 0) {
+            writeAll(STDOUT_FILENO, first.pending.array(), first.pending.size());
+            first.pending.clear();
+        }
+
+        if (first.fd < 0) {
+            nsecs_t elapsed = first.end - first.start;
+            if (first.timedOut) {
+                joined = false;
+                aout << "*** SERVICE '" << first.name << "' DUMP TIMEOUT ("
+                        << timeout << "s) EXPIRED ***" << endl;
+            }
+            if (showHeaders) {
+                char line[64];
+                snprintf(line, sizeof(line), "--------- %.3fs", elapsed / 1e9);
+                aout << line << " was the duration of dumpsys " << first.name << endl;
+            }
+            head++;
+            continue;
+        }
+
+        // wait for output from any running service, or for a timeout
+        struct pollfd pfds[next - head];
+        size_t indices[next - head];
+        size_t n = 0;
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        int pollTimeout = -1;
+        for (size_t i = head; i < next; i++) {
+            DumpJob& job(jobs.editItemAt(i));
+            if (job.fd < 0) {
+                continue;
+            }
+            if (timeoutNs > 0) {
+                nsecs_t left = job.start + timeoutNs - now;
+                if (left <= 0) {
+                    finishDump(&job, true);
+                    pollTimeout = 0;
+                    continue;
+                }
+                int ms = int(nanoseconds_to_milliseconds(left)) + 1;
+                if (pollTimeout < 0 || ms < pollTimeout) {
+                    pollTimeout = ms;
+                }
+            }
+            pfds[n].fd = job.fd;
+            pfds[n].events = POLLIN;
+            pfds[n].revents = 0;
+            indices[n++] = i;
+        }
+        if (n == 0 || pollTimeout == 0) {
+            continue;
+        }
+        if (poll(pfds, n, pollTimeout) < 0) {
+            if (errno == EINTR) continue;
+            aerr << "dumpsys: poll failed: " << strerror(errno) << endl;
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (!pfds[i].revents) {
+                continue;
+            }
+            DumpJob& job(jobs.editItemAt(indices[i]));
+            ssize_t len = read(job.fd, buffer, sizeof(buffer));
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            if (len <= 0) {
+                finishDump(&job, false);
+            } else if (indices[i] == head) {
+                writeAll(STDOUT_FILENO, buffer, len);
+            } else {
+                job.pending.appendArray(buffer, len);
+            }
+        }
+    }
+    return joined;
+}
+
 int main(int argc, char* const argv[])
 {
     signal(SIGPIPE, SIG_IGN);
@@ -40,16 +268,31 @@ int main(int argc, char* const argv[])
     Vector<String16> services;
     Vector<String16> args;
     bool showListOnly = false;
-    if ((argc == 2) && (strcmp(argv[1], "-l") == 0)) {
-        showListOnly = true;
+    size_t maxJobs = 0;
+    int timeout = 0;
+
+    // The options come before the service name, anything after it is
+    // passed to the service.
+    int argi = 1;
+    for ( ; argi < argc && argv[argi][0] == '-'; argi++) {
+        if (!strcmp(argv[argi], "-l")) {
+            showListOnly = true;
+        } else if (!strcmp(argv[argi], "-j") && argi + 1 < argc) {
+            maxJobs = atoi(argv[++argi]);
+        } else if (!strcmp(argv[argi], "-t") && argi + 1 < argc) {
+            timeout = atoi(argv[++argi]);
+        } else {
+            usage();
+            return 1;
+        }
     }
-    if ((argc == 1) || showListOnly) {
+    if ((argi == argc) || showListOnly) {
         services = sm->listServices();
         services.sort(sort_func);
         args.add(String16("-a"));
     } else {
-        services.add(String16(argv[1]));
-        for (int i=2; i<argc; i++) {
+        services.add(String16(argv[argi]));
+        for (int i=argi+1; i<argc; i++) {
             args.add(String16(argv[i]));
         }
     }
@@ -72,13 +315,32 @@ int main(int argc, char* const argv[])
         return 0;
     }
 
+    if (maxJobs > 0 || timeout > 0) {
+        Vector<DumpJob> jobs;
+        for (size_t i=0; i<N; i++) {
+            DumpJob job;
+            job.name = services[i];
+            job.service = sm->checkService(services[i]);
+            job.fd = -1;
+            job.start = 0;
+            job.end = 0;
+            job.headerShown = false;
+            job.timedOut = false;
+            jobs.add(job);
+        }
+        if (!dumpServices(jobs, args, maxJobs > 0 ? maxJobs : 1, timeout, N > 1)) {
+            // Some threads are still in binder calls, don't tear down the
+            // process state from under them.
+            _exit(0);
+        }
+        return 0;
+    }
+
     for (size_t i=0; i<N; i++) {
         sp<IBinder> service = sm->checkService(services[i]);
         if (service != NULL) {
             if (N > 1) {
-                aout << "------------------------------------------------------------"
-                        "-------------------" << endl;
-                aout << "DUMP OF SERVICE " << services[i] << ":" << endl;
+                printSeparator(services[i]);
             }
             int err = service->dump(STDOUT_FILENO, args);
             if (err != 0) {
@@ -6,6 +6,7 @@ LOCAL_SRC_FILES:=   \
     Composers.cpp   \
     GLHelper.cpp    \
     Renderers.cpp   \
+    Scenarios.cpp   \
     Main.cpp        \
 
 LOCAL_MODULE:= flatland
@@ -24,4 +25,8 @@ LOCAL_SHARED_LIBRARIES := \
     libui       \
     libutils    \
 
+LOCAL_STATIC_LIBRARIES := libglTest
+
+LOCAL_C_INCLUDES += $(call include-path-for, opengl-tests-includes)
+
 include $(BUILD_EXECUTABLE)
@@ -17,6 +17,8 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
+#include <system/graphics.h>
+
 #include "Flatland.h"
 #include "GLHelper.h"
 
@@ -51,6 +53,19 @@ public:
 
     bool modBlit(GLuint texName, const float* texMatrix, float* modColor,
             int32_t x, int32_t y, uint32_t w, uint32_t h) {
+        const float uv[] = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            0.0f, 1.0f,
+            1.0f, 1.0f,
+        };
+        return modBlitUV(texName, texMatrix, modColor, uv, x, y, w, h);
+    }
+
+    // Blits with the texture coordinates of the top-left, top-right,
+    // bottom-left and bottom-right corners given in uv.
+    bool modBlitUV(GLuint texName, const float* texMatrix, float* modColor,
+            const float* uv, int32_t x, int32_t y, uint32_t w, uint32_t h) {
         glUseProgram(mBlitPgm);
 
         GLint vp[4];
@@ -67,12 +82,6 @@ public:
             float(x),   float(y+h),
             float(x+w), float(y+h),
         };
-        const float uv[] = {
-            0.0f, 0.0f,
-            1.0f, 0.0f,
-            0.0f, 1.0f,
-            1.0f, 1.0f,
-        };
 
         glVertexAttribPointer(mPosAttribLoc, 2, GL_FLOAT, GL_FALSE, 0, pos);
         glVertexAttribPointer(mUVAttribLoc, 2, GL_FLOAT, GL_FALSE, 0, uv);
@@ -282,4 +291,66 @@ Composer* blendShrink() {
     return new BlendShrinkComp();
 }
 
+Composer* configured() {
+    class ConfiguredComp : public ComposerBase {
+        virtual bool setUp(GLHelper* helper) {
+            // Apply the HAL transform to the corners of the layer, the
+            // flips come before the rotation.
+            for (int i = 0; i < 4; i++) {
+                float s = float(i & 1);
+                float t = float(i >> 1);
+                if (mLayerDesc.transform & HAL_TRANSFORM_ROT_90) {
+                    float tmp = s;
+                    s = t;
+                    t = 1.0f - tmp;
+                }
+                if (mLayerDesc.transform & HAL_TRANSFORM_FLIP_H) {
+                    s = 1.0f - s;
+                }
+                if (mLayerDesc.transform & HAL_TRANSFORM_FLIP_V) {
+                    t = 1.0f - t;
+                }
+                mUV[i*2] = s;
+                mUV[i*2 + 1] = t;
+            }
+            mBlend = (mLayerDesc.flags & LAYER_BLEND) ||
+                    mLayerDesc.alpha < 1.0f;
+            return mBlitter.setUp(helper);
+        }
+
+        virtual bool compose(GLuint texName, const sp<GLConsumer>& glc) {
+            bool result;
+
+            float texMatrix[16];
+            glc->getTransformMatrix(texMatrix);
+
+            float a = mLayerDesc.alpha;
+            float modColor[4] = { a, a, a, a };
+
+            if (mBlend) {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            }
+
+            result = mBlitter.modBlitUV(texName, texMatrix, modColor, mUV,
+                    mLayerDesc.x, mLayerDesc.y,
+                    mLayerDesc.width, mLayerDesc.height);
+            if (!result) {
+                return false;
+            }
+
+            if (mBlend) {
+                glDisable(GL_BLEND);
+            }
+
+            return true;
+        }
+
+        Blitter mBlitter;
+        float mUV[8];
+        bool mBlend;
+    };
+    return new ConfiguredComp();
+}
+
 } // namespace android
@@ -15,23 +15,30 @@
  */
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 
 #include <gui/GLConsumer.h>
+#include <utils/Vector.h>
 
 namespace android {
 
 #define NELEMS(x) ((int) (sizeof(x) / sizeof((x)[0])))
 
-enum { MAX_NUM_LAYERS = 16 };
+enum { MAX_NUM_LAYERS = 32 };
 enum { MAX_TEST_RUNS = 16 };
 
 class Composer;
 class Renderer;
 class GLHelper;
 
+enum {
+    // The layer is blended over the layers below it, used by configured().
+    LAYER_BLEND = 0x1,
+};
+
 struct LayerDesc {
     uint32_t flags;
     Renderer* (*rendererFactory)();
@@ -40,8 +47,37 @@ struct LayerDesc {
     int32_t y;
     uint32_t width;
     uint32_t height;
+
+    // The plane alpha and HAL_TRANSFORM_* bits of the layer, only used by
+    // configured().
+    float alpha;
+    uint32_t transform;
+};
+
+struct BenchmarkDesc {
+    // The name of the test.
+    const char* name;
+
+    // The dimensions of the space in which window layers are specified.
+    uint32_t width;
+    uint32_t height;
+
+    // The screen heights at which to run the test.
+    uint32_t runHeights[MAX_TEST_RUNS];
+
+    // The list of window layers.
+    LayerDesc layers[MAX_NUM_LAYERS];
 };
 
+// Appends the scenarios described in the file at path, the format is
+// documented in README.txt.
+bool loadScenarioFile(const char* path, Vector<BenchmarkDesc>* benchmarks);
+
+// Builds a scenario replaying the geometry of the layers of the primary
+// display, as listed by 'dumpsys SurfaceFlinger' in f.
+bool loadSurfaceFlingerDump(FILE* f, const char* name,
+        BenchmarkDesc* benchmark);
+
 void resetColorGenerator();
 
 class Composer {
@@ -57,6 +93,7 @@ Composer* opaque();
 Composer* opaqueShrink();
 Composer* blend();
 Composer* blendShrink();
+Composer* configured();
 
 class Renderer {
 public:
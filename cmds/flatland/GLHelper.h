@@ -66,6 +66,8 @@ public:
 
     bool getDitherTexture(GLuint* outTexName);
 
+    EGLDisplay getDisplay() const { return mDisplay; }
+
 private:
 
     bool createNamedSurfaceTexture(GLuint name, uint32_t w, uint32_t h,
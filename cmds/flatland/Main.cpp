@@ -24,12 +24,16 @@
 #include <ui/Fence.h>
 #include <utils/Trace.h>
 
+#include <system/graphics.h>
+
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 
 #include <math.h>
 #include <getopt.h>
 
+#include <BenchmarkReport.h>
+
 #include "Flatland.h"
 #include "GLHelper.h"
 
@@ -39,22 +43,19 @@ static uint32_t g_SleepBetweenSamplesMs = 0;
 static bool     g_PresentToWindow       = false;
 static size_t   g_BenchmarkNameLen      = 0;
 
-struct BenchmarkDesc {
-    // The name of the test.
-    const char* name;
+// The results table goes to stderr when a machine readable report is
+// written to stdout.
+static FILE*    g_TextOut               = stdout;
+static BenchmarkReport* g_Report        = NULL;
 
-    // The dimensions of the space in which window layers are specified.
-    uint32_t width;
-    uint32_t height;
+// The scenarios to run, either the builtin ones or the ones loaded with -f,
+// -l or -r.
+static Vector<BenchmarkDesc> g_Benchmarks;
 
-    // The screen heights at which to run the test.
-    uint32_t runHeights[MAX_TEST_RUNS];
-
-    // The list of window layers.
-    LayerDesc layers[MAX_NUM_LAYERS];
-};
+// The number of frames whose GPU times are collected for the percentiles.
+static const uint32_t g_FrameTimeSamples = 128;
 
-static const BenchmarkDesc benchmarks[] = {
+static const BenchmarkDesc builtinBenchmarks[] = {
     { "16:10 Single Static Window",
         2560, 1600, { 800, 1200, 1600, 2400 },
         {
@@ -296,7 +297,15 @@ public:
         mDesc = desc;
         mGLHelper = helper;
 
-        result = mGLHelper->createSurfaceTexture(mDesc.width, mDesc.height,
+        // A rotated layer's buffer has the orientation of its content.
+        uint32_t bufW = mDesc.width;
+        uint32_t bufH = mDesc.height;
+        if (mDesc.transform & HAL_TRANSFORM_ROT_90) {
+            bufW = mDesc.height;
+            bufH = mDesc.width;
+        }
+
+        result = mGLHelper->createSurfaceTexture(bufW, bufH,
                 &mGLConsumer, &mSurface, &mTexName);
         if (!result) {
             return false;
@@ -441,6 +450,13 @@ public:
         return true;
     }
 
+    // Records the device and GL implementation the benchmark runs on.
+    void collectDeviceInfo(BenchmarkReport* report) {
+        if (mGLHelper->makeCurrent(mSurface)) {
+            report->collectDeviceInfo(mGLHelper->getDisplay());
+        }
+    }
+
     void tearDown() {
         ATRACE_CALL();
 
@@ -507,6 +523,45 @@ public:
         return endTime - startTime;
     }
 
+    // Runs frameCount frames and appends the GPU time of each of them, in
+    // ms, to frameTimes. The GPU time of a frame is the delay between the
+    // signal times of its composition fence and of the previous frame's,
+    // which matches the time it takes as long as the GPU never idles.
+    bool runFrameTimes(uint32_t frameCount, Vector<double>* frameTimes) {
+        ATRACE_CALL();
+
+        Vector<sp<Fence> > fences;
+
+        resetColorGenerator();
+        for (uint32_t i = 0; i <= frameCount; i++) {
+            if (!doFrame(mSurface)) {
+                return false;
+            }
+            fences.add(mGLConsumer->getCurrentFence());
+        }
+
+        // Keep the GPU busy until the last frame has completed.
+        while (fences.top()->wait(0) == -ETIME) {
+            if (!doFrame(mSurface)) {
+                return false;
+            }
+        }
+
+        nsecs_t prevTime = fences[0]->getSignalTime();
+        if (prevTime < 0 || prevTime == INT64_MAX) {
+            return false;
+        }
+        for (uint32_t i = 1; i <= frameCount; i++) {
+            nsecs_t time = fences[i]->getSignalTime();
+            if (time < 0 || time == INT64_MAX) {
+                return false;
+            }
+            frameTimes->add(double(time - prevTime) / 1e6);
+            prevTime = time;
+        }
+        return true;
+    }
+
 private:
 
     bool doFrame(EGLSurface surface) {
@@ -592,17 +647,25 @@ static int cmpDouble(const double* lhs, const double* rhs) {
     return 0;
 }
 
+// Returns the p-th percentile of the sorted samples, using the nearest rank.
+static double percentile(const Vector<double>& samples, uint32_t p) {
+    size_t rank = (samples.size() * p + 99) / 100;
+    return samples[rank > 0 ? rank - 1 : 0];
+}
+
 // Run a single benchmark and print the result.
 static bool runTest(const BenchmarkDesc b, size_t run) {
     bool success = true;
     double prevResult = 0.0, result = 0.0;
     Vector<double> samples;
+    Vector<double> frameTimes;
+    static const uint32_t percentiles[] = { 50, 90, 99 };
 
     uint32_t runHeight = b.runHeights[run];
     uint32_t runWidth = b.width * runHeight / b.height;
-    printf(" %-*s | %4d x %4d | ", static_cast<int>(g_BenchmarkNameLen), b.name,
-            runWidth, runHeight);
-    fflush(stdout);
+    fprintf(g_TextOut, " %-*s | %4d x %4d | ",
+            static_cast<int>(g_BenchmarkNameLen), b.name, runWidth, runHeight);
+    fflush(g_TextOut);
 
     BenchmarkRunner r(b, run);
     if (!r.setUp()) {
@@ -610,6 +673,10 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
         return false;
     }
 
+    if (g_Report != NULL && !g_Report->hasDeviceInfo()) {
+        r.collectDeviceInfo(g_Report);
+    }
+
     // The slowest 1/outlierFraction sample results are ignored as potential
     // outliers.
     const uint32_t outlierFraction = 16;
@@ -633,11 +700,11 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
 
     if (totalFrames - warmUpFrames > 16) {
         // The test runs too fast to get a stable result.  Skip it.
-        printf("  fast");
+        fprintf(g_TextOut, "  fast");
         goto done;
     } else if (totalFrames == 5 && runTime > 200e6) {
         // The test runs too slow to be very useful.  Skip it.
-        printf("  slow");
+        fprintf(g_TextOut, "  slow");
         goto done;
     }
 
@@ -648,7 +715,7 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
         }
 
         if (newSamples > 512) {
-            printf("varies");
+            fprintf(g_TextOut, "varies");
             goto done;
         }
 
@@ -674,12 +741,38 @@ static bool runTest(const BenchmarkDesc b, size_t run) {
         result = (samples[elem-1] + samples[elem]) * 0.5;
     } while (fabs(result - prevResult) > threshold * result);
 
-    printf("%6.3f", result / double(totalFrames - warmUpFrames) / 1e6);
+    fprintf(g_TextOut, "%6.3f", result / double(totalFrames - warmUpFrames) / 1e6);
+
+    // The distribution of the GPU time of individual frames shows how much
+    // headroom is left in the worst frames, which the average hides.
+    if (!r.runFrameTimes(g_FrameTimeSamples, &frameTimes)) {
+        success = false;
+        goto done;
+    }
+    frameTimes.sort(cmpDouble);
+    fprintf(g_TextOut, "   ");
+    for (size_t i = 0; i < NELEMS(percentiles); i++) {
+        fprintf(g_TextOut, " | %6.3f", percentile(frameTimes, percentiles[i]));
+    }
+
+    if (g_Report != NULL) {
+        char params[32];
+        snprintf(params, sizeof(params), "%dx%d", runWidth, runHeight);
+        g_Report->addResult(b.name, params, "frame_time",
+                result / double(totalFrames - warmUpFrames) / 1e6, "ms");
+        for (size_t i = 0; i < NELEMS(percentiles); i++) {
+            char metric[32];
+            snprintf(metric, sizeof(metric), "gpu_frame_time_p%u",
+                    percentiles[i]);
+            g_Report->addResult(b.name, params, metric,
+                    percentile(frameTimes, percentiles[i]), "ms");
+        }
+    }
 
 done:
 
-    printf("\n");
-    fflush(stdout);
+    fprintf(g_TextOut, "\n");
+    fflush(g_TextOut);
     r.tearDown();
 
     return success;
@@ -690,7 +783,8 @@ static void printResultsTableHeader() {
     size_t len = strlen(scenario);
     size_t leftPad = (g_BenchmarkNameLen - len) / 2;
     size_t rightPad = g_BenchmarkNameLen - len - leftPad;
-    printf(" %*s%s%*s | Resolution  | Time (ms)\n",
+    fprintf(g_TextOut,
+            " %*s%s%*s | Resolution  | Time (ms) |    p50 |    p90 |    p99\n",
             static_cast<int>(leftPad), "",
             "Scenario", static_cast<int>(rightPad), "");
 }
@@ -699,8 +793,8 @@ static void printResultsTableHeader() {
 static bool runTests() {
     printResultsTableHeader();
 
-    for (size_t i = 0; i < NELEMS(benchmarks); i++) {
-        const BenchmarkDesc& b = benchmarks[i];
+    for (size_t i = 0; i < g_Benchmarks.size(); i++) {
+        const BenchmarkDesc& b = g_Benchmarks[i];
         for (size_t j = 0; j < MAX_TEST_RUNS && b.runHeights[j]; j++) {
             if (!runTest(b, j)) {
                 return false;
@@ -713,8 +807,8 @@ static bool runTests() {
 // Return the length longest benchmark name.
 static size_t maxBenchmarkNameLen() {
     size_t maxLen = 0;
-    for (size_t i = 0; i < NELEMS(benchmarks); i++) {
-        const BenchmarkDesc& b = benchmarks[i];
+    for (size_t i = 0; i < g_Benchmarks.size(); i++) {
+        const BenchmarkDesc& b = g_Benchmarks[i];
         size_t len = strlen(b.name);
         if (len > maxLen) {
             maxLen = len;
@@ -729,6 +823,12 @@ static void showHelp(const char *cmd) {
     fprintf(stderr, "options include:\n"
                     "  -s N            sleep for N ms between samples\n"
                     "  -d              display the test frame to a window\n"
+                    "  -o FORMAT       also write the results to stdout as\n"
+                    "                  'json' or 'csv', the table goes to stderr\n"
+                    "  -f FILE         run the scenarios described in FILE\n"
+                    "  -l FILE         replay the layers of a 'dumpsys SurfaceFlinger'\n"
+                    "                  output saved in FILE\n"
+                    "  -r              replay the layers currently on screen\n"
                     "  --help          print this helpful message and exit\n"
             );
 }
@@ -739,6 +839,8 @@ int main(int argc, char** argv) {
         exit(0);
     }
 
+    BenchmarkReport::Format format = BenchmarkReport::FORMAT_TEXT;
+
     for (;;) {
         int ret;
         int option_index = 0;
@@ -747,7 +849,7 @@ int main(int argc, char** argv) {
             {     0,               0, 0,  0 }
         };
 
-        ret = getopt_long(argc, argv, "ds:",
+        ret = getopt_long(argc, argv, "do:s:f:l:r",
                           long_options, &option_index);
 
         if (ret < 0) {
@@ -763,6 +865,42 @@ int main(int argc, char** argv) {
                 g_SleepBetweenSamplesMs = atoi(optarg);
             break;
 
+            case 'o':
+                if (!BenchmarkReport::parseFormat(optarg, &format)) {
+                    showHelp(argv[0]);
+                    exit(2);
+                }
+            break;
+
+            case 'f':
+                if (!loadScenarioFile(optarg, &g_Benchmarks)) {
+                    exit(1);
+                }
+            break;
+
+            case 'l':
+            case 'r': {
+                FILE* f = ret == 'l' ? fopen(optarg, "r") :
+                        popen("dumpsys SurfaceFlinger", "r");
+                if (f == NULL) {
+                    fprintf(stderr, "unable to read the SurfaceFlinger dump\n");
+                    exit(1);
+                }
+                BenchmarkDesc b;
+                bool loaded = loadSurfaceFlingerDump(f,
+                        ret == 'l' ? optarg : "Current Screen", &b);
+                if (ret == 'l') {
+                    fclose(f);
+                } else {
+                    pclose(f);
+                }
+                if (!loaded) {
+                    exit(1);
+                }
+                g_Benchmarks.add(b);
+            }
+            break;
+
             case 0:
                 if (strcmp(long_options[option_index].name, "help")) {
                     showHelp(argv[0]);
@@ -776,16 +914,28 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (g_Benchmarks.isEmpty()) {
+        g_Benchmarks.appendArray(builtinBenchmarks, NELEMS(builtinBenchmarks));
+    }
+
     g_BenchmarkNameLen = maxBenchmarkNameLen();
 
-    printf(" cmdline:");
+    BenchmarkReport report("flatland", format);
+    if (report.isMachineReadable()) {
+        g_TextOut = stderr;
+        g_Report = &report;
+    }
+
+    fprintf(g_TextOut, " cmdline:");
     for (int i = 0; i < argc; i++) {
-        printf(" %s", argv[i]);
+        fprintf(g_TextOut, " %s", argv[i]);
     }
-    printf("\n");
+    fprintf(g_TextOut, "\n");
 
     if (!runTests()) {
         fprintf(stderr, "exiting due to error.\n");
         return 1;
     }
+
+    report.write(stdout);
 }
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <system/graphics.h>
+
+#include "Flatland.h"
+
+namespace android {
+
+static char* skipSpaces(char* s) {
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    return s;
+}
+
+// Returns the next whitespace separated token of *s, or NULL at the end of
+// the line.
+static char* nextToken(char** s) {
+    char* start = skipSpaces(*s);
+    if (*start == '\0' || *start == '\n' || *start == '#') {
+        return NULL;
+    }
+    char* end = start;
+    while (*end && *end != ' ' && *end != '\t' && *end != '\n') {
+        end++;
+    }
+    if (*end) {
+        *end++ = '\0';
+    }
+    *s = end;
+    return start;
+}
+
+static bool parseRunHeights(const char* s, uint32_t* runHeights) {
+    memset(runHeights, 0, sizeof(uint32_t) * MAX_TEST_RUNS);
+    for (size_t i = 0; i < MAX_TEST_RUNS; i++) {
+        char* end;
+        unsigned long h = strtoul(s, &end, 10);
+        if (end == s || h == 0) {
+            return false;
+        }
+        runHeights[i] = uint32_t(h);
+        if (*end == '\0') {
+            return true;
+        }
+        if (*end != ',') {
+            return false;
+        }
+        s = end + 1;
+    }
+    return false;
+}
+
+static bool parseLayer(char* s, LayerDesc* layer) {
+    char* tok[4];
+    for (int i = 0; i < 4; i++) {
+        tok[i] = nextToken(&s);
+        if (tok[i] == NULL) {
+            return false;
+        }
+    }
+
+    memset(layer, 0, sizeof(*layer));
+    layer->rendererFactory = staticGradient;
+    layer->composerFactory = configured;
+    layer->x = atoi(tok[0]);
+    layer->y = atoi(tok[1]);
+    layer->width = atoi(tok[2]);
+    layer->height = atoi(tok[3]);
+    layer->alpha = 1.0f;
+    if (layer->width == 0 || layer->height == 0) {
+        return false;
+    }
+
+    char* opt;
+    while ((opt = nextToken(&s)) != NULL) {
+        if (!strcmp(opt, "opaque")) {
+            layer->flags &= ~LAYER_BLEND;
+        } else if (!strcmp(opt, "blend")) {
+            layer->flags |= LAYER_BLEND;
+        } else if (!strncmp(opt, "alpha=", 6)) {
+            layer->alpha = atof(opt + 6);
+            if (layer->alpha < 0.0f || layer->alpha > 1.0f) {
+                return false;
+            }
+        } else if (!strncmp(opt, "rot=", 4)) {
+            switch (atoi(opt + 4)) {
+                case 0:   break;
+                case 90:  layer->transform ^= HAL_TRANSFORM_ROT_90;  break;
+                case 180: layer->transform ^= HAL_TRANSFORM_ROT_180; break;
+                case 270: layer->transform ^= HAL_TRANSFORM_ROT_270; break;
+                default:  return false;
+            }
+        } else if (!strcmp(opt, "flip=h")) {
+            layer->transform ^= HAL_TRANSFORM_FLIP_H;
+        } else if (!strcmp(opt, "flip=v")) {
+            layer->transform ^= HAL_TRANSFORM_FLIP_V;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadScenarioFile(const char* path, Vector<BenchmarkDesc>* benchmarks) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "unable to open %s\n", path);
+        return false;
+    }
+
+    bool result = true;
+    BenchmarkDesc* b = NULL;
+    size_t numLayers = 0;
+    int lineNum = 0;
+    char line[1024];
+    while (result && fgets(line, sizeof(line), f) != NULL) {
+        lineNum++;
+        char* s = line;
+        char* keyword = nextToken(&s);
+        if (keyword == NULL) {
+            continue;
+        }
+
+        if (!strcmp(keyword, "scenario")) {
+            char* w = nextToken(&s);
+            char* h = nextToken(&s);
+            char* runHeights = nextToken(&s);
+            char* name = skipSpaces(s);
+            char* end = name + strlen(name);
+            while (end > name && (end[-1] == '\n' || end[-1] == '\r' ||
+                    end[-1] == ' ')) {
+                *--end = '\0';
+            }
+
+            BenchmarkDesc desc;
+            memset(&desc, 0, sizeof(desc));
+            if (w == NULL || h == NULL || runHeights == NULL || !*name ||
+                    !parseRunHeights(runHeights, desc.runHeights)) {
+                result = false;
+                break;
+            }
+            desc.name = strdup(name);
+            desc.width = atoi(w);
+            desc.height = atoi(h);
+            benchmarks->add(desc);
+            b = &benchmarks->editTop();
+            numLayers = 0;
+        } else if (!strcmp(keyword, "layer")) {
+            if (b == NULL || numLayers == MAX_NUM_LAYERS) {
+                result = false;
+                break;
+            }
+            result = parseLayer(s, &b->layers[numLayers++]);
+        } else {
+            result = false;
+        }
+    }
+
+    if (!result) {
+        fprintf(stderr, "%s:%d: invalid scenario description\n", path,
+                lineNum);
+    }
+    fclose(f);
+    return result;
+}
+
+// The values parsed from the description of a layer in the SurfaceFlinger
+// dump, see Layer::dump().
+struct DumpedLayer {
+    uint32_t layerStack;
+    float x, y;
+    int w, h;
+    int crop[4];
+    int isOpaque;
+    unsigned int alpha;
+    unsigned int flags;
+    float tr[4];
+};
+
+static bool parseDumpedLayer(const char* line, DumpedLayer* l) {
+    const char* s = strstr(line, "layerStack=");
+    if (s == NULL || sscanf(s, "layerStack=%u", &l->layerStack) != 1) {
+        return false;
+    }
+    s = strstr(line, "pos=(");
+    if (s == NULL || sscanf(s, "pos=(%f,%f), size=(%d,%d), crop=(%d,%d,%d,%d)",
+            &l->x, &l->y, &l->w, &l->h,
+            &l->crop[0], &l->crop[1], &l->crop[2], &l->crop[3]) != 8) {
+        return false;
+    }
+    s = strstr(line, "isOpaque=");
+    if (s == NULL || sscanf(s, "isOpaque=%d", &l->isOpaque) != 1) {
+        return false;
+    }
+    s = strstr(line, "alpha=");
+    if (s == NULL || sscanf(s, "alpha=%x, flags=%x, tr=[%f, %f][%f, %f]",
+            &l->alpha, &l->flags, &l->tr[0], &l->tr[1], &l->tr[2],
+            &l->tr[3]) != 6) {
+        return false;
+    }
+    return true;
+}
+
+// Converts the layer to screen space, returns false if it isn't visible.
+static bool convertDumpedLayer(const DumpedLayer& l, uint32_t dispW,
+        uint32_t dispH, LayerDesc* layer) {
+    enum { eLayerHidden = 0x01 };
+    if (l.layerStack != 0 || (l.flags & eLayerHidden) || l.alpha == 0) {
+        return false;
+    }
+
+    int w = l.w;
+    int h = l.h;
+    if (l.crop[2] > l.crop[0] && l.crop[3] > l.crop[1]) {
+        w = l.crop[2] - l.crop[0];
+        h = l.crop[3] - l.crop[1];
+    }
+
+    // Only the rotations by multiples of 90 degrees are replayed, other
+    // transforms are approximated by their bounds.
+    uint32_t transform = 0;
+    float a = l.tr[0], b = l.tr[1], c = l.tr[2], d = l.tr[3];
+    if (a < 0.0f && d < 0.0f) {
+        transform = HAL_TRANSFORM_ROT_180;
+    } else if (b > 0.0f && c < 0.0f) {
+        transform = HAL_TRANSFORM_ROT_90;
+    } else if (b < 0.0f && c > 0.0f) {
+        transform = HAL_TRANSFORM_ROT_270;
+    }
+
+    float x0 = l.x, y0 = l.y, x1 = l.x, y1 = l.y;
+    for (int i = 1; i < 4; i++) {
+        float px = float((i & 1) ? w : 0);
+        float py = float((i & 2) ? h : 0);
+        float sx = l.x + a * px + c * py;
+        float sy = l.y + b * px + d * py;
+        x0 = sx < x0 ? sx : x0;
+        y0 = sy < y0 ? sy : y0;
+        x1 = sx > x1 ? sx : x1;
+        y1 = sy > y1 ? sy : y1;
+    }
+
+    // Clip to the display.
+    x0 = x0 < 0.0f ? 0.0f : x0;
+    y0 = y0 < 0.0f ? 0.0f : y0;
+    x1 = x1 > float(dispW) ? float(dispW) : x1;
+    y1 = y1 > float(dispH) ? float(dispH) : y1;
+    if (x1 - x0 < 1.0f || y1 - y0 < 1.0f) {
+        return false;
+    }
+
+    memset(layer, 0, sizeof(*layer));
+    layer->rendererFactory = staticGradient;
+    layer->composerFactory = configured;
+    layer->x = int32_t(x0);
+    layer->y = int32_t(y0);
+    layer->width = uint32_t(x1 - x0);
+    layer->height = uint32_t(y1 - y0);
+    layer->alpha = float(l.alpha) / 255.0f;
+    layer->transform = transform;
+    layer->flags = l.isOpaque ? 0 : LAYER_BLEND;
+    return true;
+}
+
+bool loadSurfaceFlingerDump(FILE* f, const char* name,
+        BenchmarkDesc* benchmark) {
+    uint32_t dispW = 0, dispH = 0;
+    Vector<DumpedLayer> layers;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (dispW == 0 && strstr(line, "type=") != NULL) {
+            // The first DisplayDevice is the primary display.
+            const char* s = strstr(line, "layerStack=");
+            if (s != NULL) {
+                int w, h;
+                uint32_t stack;
+                if (sscanf(s, "layerStack=%u, (%dx%d)", &stack, &w, &h) == 3) {
+                    dispW = w;
+                    dispH = h;
+                }
+            }
+            continue;
+        }
+        DumpedLayer l;
+        if (parseDumpedLayer(line, &l)) {
+            layers.add(l);
+        }
+    }
+
+    if (dispW == 0 || dispH == 0) {
+        fprintf(stderr, "no display found in the SurfaceFlinger dump\n");
+        return false;
+    }
+
+    memset(benchmark, 0, sizeof(*benchmark));
+    benchmark->name = strdup(name);
+    benchmark->width = dispW;
+    benchmark->height = dispH;
+    benchmark->runHeights[0] = dispH;
+
+    // The layers are dumped from the bottom to the top.
+    size_t numLayers = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (numLayers == MAX_NUM_LAYERS) {
+            fprintf(stderr, "only replaying the first %d visible layers\n",
+                    MAX_NUM_LAYERS);
+            break;
+        }
+        if (convertDumpedLayer(layers[i], dispW, dispH,
+                &benchmark->layers[numLayers])) {
+            numLayers++;
+        }
+    }
+
+    if (numLayers == 0) {
+        fprintf(stderr, "no visible layers found in the SurfaceFlinger dump\n");
+        return false;
+    }
+    return true;
+}
+
+} // namespace android
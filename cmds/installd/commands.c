@@ -16,6 +16,7 @@
 
 #include <inttypes.h>
 #include <sys/capability.h>
+#include <sys/xattr.h>
 #include "installd.h"
 #include <cutils/sched_policy.h>
 #include <diskusage/dirsize.h>
@@ -37,6 +38,8 @@ int install(const char *pkgname, uid_t uid, gid_t gid, const char *seinfo)
     char applibdir[PKG_PATH_MAX];
     struct stat libStat;
 
+    size_index_invalidate(pkgname, (userid_t)-1);
+
     if ((uid < AID_SYSTEM) || (gid < AID_SYSTEM)) {
         ALOGE("invalid uid/gid: %d %d\n", uid, gid);
         return -1;
@@ -114,6 +117,8 @@ int uninstall(const char *pkgname, userid_t userid)
 {
     char pkgdir[PKG_PATH_MAX];
 
+    size_index_invalidate(pkgname, userid);
+
     if (create_pkg_path(pkgdir, pkgname, PKG_DIR_POSTFIX, userid))
         return -1;
 
@@ -128,6 +133,9 @@ int renamepkg(const char *oldpkgname, const char *newpkgname)
     char oldpkgdir[PKG_PATH_MAX];
     char newpkgdir[PKG_PATH_MAX];
 
+    size_index_invalidate(oldpkgname, (userid_t)-1);
+    size_index_invalidate(newpkgname, (userid_t)-1);
+
     if (create_pkg_path(oldpkgdir, oldpkgname, PKG_DIR_POSTFIX, 0))
         return -1;
     if (create_pkg_path(newpkgdir, newpkgname, PKG_DIR_POSTFIX, 0))
@@ -181,6 +189,8 @@ int delete_user_data(const char *pkgname, userid_t userid)
 {
     char pkgdir[PKG_PATH_MAX];
 
+    size_index_invalidate(pkgname, userid);
+
     if (create_pkg_path(pkgdir, pkgname, PKG_DIR_POSTFIX, userid))
         return -1;
 
@@ -194,6 +204,8 @@ int make_user_data(const char *pkgname, uid_t uid, userid_t userid, const char*
     char libsymlink[PKG_PATH_MAX];
     struct stat libStat;
 
+    size_index_invalidate(pkgname, userid);
+
     // Create the data dir for the package
     if (create_pkg_path(pkgdir, pkgname, PKG_DIR_POSTFIX, userid)) {
         return -1;
@@ -278,6 +290,8 @@ int delete_user(userid_t userid)
 {
     int status = 0;
 
+    size_index_invalidate_all();
+
     char data_path[PKG_PATH_MAX];
     if ((create_user_path(data_path, userid) != 0)
             || (delete_dir_contents(data_path, 1, NULL) != 0)) {
@@ -303,6 +317,8 @@ int delete_cache(const char *pkgname, userid_t userid)
 {
     char cachedir[PKG_PATH_MAX];
 
+    size_index_invalidate(pkgname, userid);
+
     if (create_pkg_path(cachedir, pkgname, CACHE_DIR_POSTFIX, userid))
         return -1;
 
@@ -315,6 +331,8 @@ int delete_code_cache(const char *pkgname, userid_t userid)
     char codecachedir[PKG_PATH_MAX];
     struct stat s;
 
+    size_index_invalidate(pkgname, userid);
+
     if (create_pkg_path(codecachedir, pkgname, CODE_CACHE_DIR_POSTFIX, userid))
         return -1;
 
@@ -334,27 +352,29 @@ int delete_code_cache(const char *pkgname, userid_t userid)
  * also require that apps constantly modify file metadata even
  * when just reading from the cache, which is pretty awful.
  */
-int free_cache(int64_t free_size)
+static void add_cache_files_cb(void* ctx, const char *basepath, const char *cachedir)
+{
+    add_cache_files((cache_t*)ctx, basepath, cachedir);
+}
+
+static void add_cache_roots_cb(void* ctx, const char *basepath, const char *cachedir)
+{
+    add_cache_roots((cache_stream_t*)ctx, basepath, cachedir);
+}
+
+/* Calls add() with the directories holding the cache directories of the
+   packages of every user. */
+static void collect_cache_dirs(void (*add)(void*, const char*, const char*), void* ctx)
 {
-    cache_t* cache;
-    int64_t avail;
     DIR *d;
     struct dirent *de;
     char tmpdir[PATH_MAX];
     char *dirpos;
 
-    avail = data_disk_free();
-    if (avail < 0) return -1;
-
-    ALOGI("free_cache(%" PRId64 ") avail %" PRId64 "\n", free_size, avail);
-    if (avail >= free_size) return 0;
-
-    cache = start_cache_collection();
-
     // Collect cache files for primary user.
     if (create_user_path(tmpdir, 0) == 0) {
         //ALOGI("adding cache files from %s\n", tmpdir);
-        add_cache_files(cache, tmpdir, "cache");
+        add(ctx, tmpdir, "cache");
     }
 
     // Search for other users and add any cache files from them.
@@ -374,7 +394,7 @@ int free_cache(int64_t free_size)
                 if ((strlen(name)+(dirpos-tmpdir)) < (sizeof(tmpdir)-1)) {
                     strcpy(dirpos, name);
                     //ALOGI("adding cache files from %s\n", tmpdir);
-                    add_cache_files(cache, tmpdir, "cache");
+                    add(ctx, tmpdir, "cache");
                 } else {
                     ALOGW("Path exceeds limit: %s%s", tmpdir, name);
                 }
@@ -401,7 +421,7 @@ int free_cache(int64_t free_size)
                     if (lookup_media_dir(tmpdir, "Android") == 0
                             && lookup_media_dir(tmpdir, "data") == 0) {
                         //ALOGI("adding cache files from %s\n", tmpdir);
-                        add_cache_files(cache, tmpdir, "cache");
+                        add(ctx, tmpdir, "cache");
                     }
                 } else {
                     ALOGW("Path exceeds limit: %s%s", tmpdir, name);
@@ -410,9 +430,39 @@ int free_cache(int64_t free_size)
         }
         closedir(d);
     }
+}
+
+int free_cache(int64_t free_size)
+{
+    int64_t avail;
+    char value[PROPERTY_VALUE_MAX];
+
+    size_index_invalidate_all();
+
+    avail = data_disk_free();
+    if (avail < 0) return -1;
+
+    ALOGI("free_cache(%" PRId64 ") avail %" PRId64 "\n", free_size, avail);
+    if (avail >= free_size) return 0;
 
-    clear_cache_files(cache, free_size);
-    finish_cache_collection(cache);
+    // The streaming collection only keeps the oldest files in memory and
+    // walks the cache directories in parallel; the legacy one collects and
+    // sorts every cache file before deleting any.
+    property_get("installd.free_cache.legacy", value, "0");
+    if (value[0] == '1') {
+        cache_t* cache = start_cache_collection();
+        collect_cache_dirs(add_cache_files_cb, cache);
+        clear_cache_files(cache, free_size);
+        finish_cache_collection(cache);
+    } else {
+        cache_stream_t* stream = start_cache_stream();
+        if (stream == NULL) {
+            return -1;
+        }
+        collect_cache_dirs(add_cache_roots_cb, stream);
+        clear_cache_files_streaming(stream, free_size);
+        finish_cache_stream(stream);
+    }
 
     return data_disk_free() >= free_size ? 0 : -1;
 }
@@ -422,6 +472,8 @@ int move_dex(const char *src, const char *dst, const char *instruction_set)
     char src_dex[PKG_PATH_MAX];
     char dst_dex[PKG_PATH_MAX];
 
+    size_index_invalidate_all();
+
     if (validate_apk_path(src)) {
         ALOGE("invalid apk path '%s' (bad prefix)\n", src);
         return -1;
@@ -447,6 +499,8 @@ int rm_dex(const char *path, const char *instruction_set)
 {
     char dex_path[PKG_PATH_MAX];
 
+    size_index_invalidate_all();
+
     if (validate_apk_path(path) && validate_system_app_path(path)) {
         ALOGE("invalid apk path '%s' (bad prefix)\n", path);
         return -1;
@@ -465,7 +519,7 @@ int rm_dex(const char *path, const char *instruction_set)
     }
 }
 
-int get_size(const char *pkgname, userid_t userid, const char *apkpath,
+static int calculate_size(const char *pkgname, userid_t userid, const char *apkpath,
              const char *libdirpath, const char *fwdlock_apkpath, const char *asecpath,
              const char *instruction_set, int64_t *_codesize, int64_t *_datasize,
              int64_t *_cachesize, int64_t* _asecsize)
@@ -553,7 +607,7 @@ int get_size(const char *pkgname, userid_t userid, const char *apkpath,
             }
             subfd = openat(dfd, name, O_RDONLY | O_DIRECTORY);
             if (subfd >= 0) {
-                dirsize = calculate_dir_size(subfd);
+                dirsize = calculate_dir_size_parallel(subfd, 0);
             }
             if(!strcmp(name,"lib")) {
                 codesize += dirsize + statsize;
@@ -584,6 +638,30 @@ done:
     return 0;
 }
 
+int get_size(const char *pkgname, userid_t userid, const char *apkpath,
+             const char *libdirpath, const char *fwdlock_apkpath, const char *asecpath,
+             const char *instruction_set, int64_t *_codesize, int64_t *_datasize,
+             int64_t *_cachesize, int64_t* _asecsize)
+{
+    size_info_t sizes;
+
+    if (size_index_lookup(pkgname, userid, apkpath, libdirpath, fwdlock_apkpath,
+            asecpath, instruction_set, &sizes) != 0) {
+        unsigned token = size_index_watch(pkgname, userid, apkpath, libdirpath,
+                fwdlock_apkpath, asecpath, instruction_set);
+        calculate_size(pkgname, userid, apkpath, libdirpath, fwdlock_apkpath, asecpath,
+                instruction_set, &sizes.codesize, &sizes.datasize, &sizes.cachesize,
+                &sizes.asecsize);
+        size_index_store(token, &sizes);
+    }
+
+    *_codesize = sizes.codesize;
+    *_datasize = sizes.datasize;
+    *_cachesize = sizes.cachesize;
+    *_asecsize = sizes.asecsize;
+    return 0;
+}
+
 int create_cache_path(char path[PKG_PATH_MAX], const char *src, const char *instruction_set)
 {
     char *tmp;
@@ -688,7 +766,7 @@ static void run_patchoat(int input_fd, int oat_fd, const char* input_file_name,
 
 static void run_dex2oat(int zip_fd, int oat_fd, const char* input_file_name,
     const char* output_file_name, const char *pkgname, const char *instruction_set,
-    bool vm_safe_mode)
+    bool vm_safe_mode, int threads)
 {
     static const unsigned int MAX_INSTRUCTION_SET_LEN = 7;
 
@@ -745,6 +823,7 @@ static void run_dex2oat(int zip_fd, int oat_fd, const char* input_file_name,
     char dex2oat_Xms_arg[strlen("-Xms") + PROPERTY_VALUE_MAX];
     char dex2oat_Xmx_arg[strlen("-Xmx") + PROPERTY_VALUE_MAX];
     char dex2oat_compiler_filter_arg[strlen("--compiler-filter=") + PROPERTY_VALUE_MAX];
+    char threads_arg[strlen("-j") + MAX_INT_LEN];
 
     sprintf(zip_fd_arg, "--zip-fd=%d", zip_fd);
     sprintf(zip_location_arg, "--zip-location=%s", input_file_name);
@@ -752,6 +831,7 @@ static void run_dex2oat(int zip_fd, int oat_fd, const char* input_file_name,
     sprintf(oat_location_arg, "--oat-location=%s", output_file_name);
     sprintf(instruction_set_arg, "--instruction-set=%s", instruction_set);
     sprintf(instruction_set_features_arg, "--instruction-set-features=%s", dex2oat_isa_features);
+    sprintf(threads_arg, "-j%d", threads);
 
     bool have_profile_file = false;
     bool have_top_k_profile_threshold = false;
@@ -796,6 +876,7 @@ static void run_dex2oat(int zip_fd, int oat_fd, const char* input_file_name,
                + (have_dex2oat_Xms_flag ? 2 : 0)
                + (have_dex2oat_Xmx_flag ? 2 : 0)
                + (have_dex2oat_compiler_filter_flag ? 1 : 0)
+               + (threads > 0 ? 1 : 0)
                + (have_dex2oat_flags ? 1 : 0)];
     int i = 0;
     argv[i++] = (char*)DEX2OAT_BIN;
@@ -824,6 +905,9 @@ static void run_dex2oat(int zip_fd, int oat_fd, const char* input_file_name,
     if (have_dex2oat_compiler_filter_flag) {
         argv[i++] = dex2oat_compiler_filter_arg;
     }
+    if (threads > 0) {
+        argv[i++] = threads_arg;
+    }
     if (have_dex2oat_flags) {
         argv[i++] = dex2oat_flags;
     }
@@ -873,6 +957,8 @@ int dexopt(const char *apk_path, uid_t uid, bool is_public,
     char in_odex_path[PKG_PATH_MAX];
     int res, input_fd=-1, out_fd=-1;
 
+    size_index_invalidate_all();
+
     if (strlen(apk_path) >= (PKG_PATH_MAX - 8)) {
         return -1;
     }
@@ -928,14 +1014,14 @@ int dexopt(const char *apk_path, uid_t uid, bool is_public,
     memset(&input_stat, 0, sizeof(input_stat));
     stat(input_file, &input_stat);
 
-    input_fd = open(input_file, O_RDONLY, 0);
+    input_fd = open(input_file, O_RDONLY | O_CLOEXEC, 0);
     if (input_fd < 0) {
         ALOGE("installd cannot open '%s' for input during dexopt\n", input_file);
         return -1;
     }
 
     unlink(out_path);
-    out_fd = open(out_path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    out_fd = open(out_path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
     if (out_fd < 0) {
         ALOGE("installd cannot open '%s' for output during dexopt\n", out_path);
         goto fail;
@@ -957,6 +1043,11 @@ int dexopt(const char *apk_path, uid_t uid, bool is_public,
     }
 
 
+    /* dex2oat is the only expensive child, it waits for a free slot when
+       several packages are compiled at once */
+    bool is_dex2oat = !is_patchoat && strncmp(persist_sys_dalvik_vm_lib, "libart", 6) == 0;
+    int threads = is_dex2oat ? dexopt_sched_acquire() : 0;
+
     ALOGV("DexInv: --- BEGIN '%s' ---\n", input_file);
 
     pid_t pid;
@@ -985,6 +1076,12 @@ int dexopt(const char *apk_path, uid_t uid, bool is_public,
             ALOGE("set_sched_policy failed: %s\n", strerror(errno));
             exit(70);
         }
+        /* the descriptors are close-on-exec so that the children of other
+           commands running at the same time don't inherit them */
+        if (fcntl(input_fd, F_SETFD, 0) < 0 || fcntl(out_fd, F_SETFD, 0) < 0) {
+            ALOGE("fcntl failed: %s\n", strerror(errno));
+            exit(71);
+        }
         if (flock(out_fd, LOCK_EX | LOCK_NB) != 0) {
             ALOGE("flock(%s) failed: %s\n", out_path, strerror(errno));
             exit(67);
@@ -997,7 +1094,7 @@ int dexopt(const char *apk_path, uid_t uid, bool is_public,
                 run_patchoat(input_fd, out_fd, input_file, out_path, pkgname, instruction_set);
             } else {
                 run_dex2oat(input_fd, out_fd, input_file, out_path, pkgname, instruction_set,
-                            vm_safe_mode);
+                            vm_safe_mode, threads);
             }
         } else {
             exit(69);   /* Unexpected persist.sys.dalvik.vm.lib value */
@@ -1005,6 +1102,9 @@ int dexopt(const char *apk_path, uid_t uid, bool is_public,
         exit(68);   /* only get here on exec failure */
     } else {
         res = wait_child(pid);
+        if (is_dex2oat) {
+            dexopt_sched_release();
+        }
         if (res == 0) {
             ALOGV("DexInv: --- END '%s' (success) ---\n", input_file);
         } else {
@@ -1078,6 +1178,13 @@ int movefileordir(char* srcpath, char* dstpath, int dstbasepos,
                 unlink(dstpath);
                 return 1;
             }
+        } else if (errno == EXDEV) {
+            /* the destination is on another volume */
+            ALOGV("Copying %s to %s (uid %d)\n", srcpath, dstpath, dstuid);
+            if (copy_file(srcpath, dstpath, dstuid, dstgid) != 0) {
+                return 1;
+            }
+            unlink(srcpath);
         } else {
             ALOGW("Unable to rename %s to %s: %s\n",
                 srcpath, dstpath, strerror(errno));
@@ -1140,6 +1247,8 @@ int movefiles()
     char buf[PKG_PATH_MAX+1];
     int bufp, bufe, bufi, readlen;
 
+    size_index_invalidate_all();
+
     char srcpkg[PKG_NAME_MAX];
     char dstpkg[PKG_NAME_MAX];
     char srcpath[PKG_PATH_MAX];
@@ -1299,6 +1408,8 @@ int linklib(const char* pkgname, const char* asecLibDir, int userId)
     struct stat s, libStat;
     int rc = 0;
 
+    size_index_invalidate(pkgname, userId);
+
     if (create_pkg_path(pkgdir, pkgname, PKG_DIR_POSTFIX, userId)) {
         ALOGE("cannot create package path\n");
         return -1;
@@ -1410,37 +1521,99 @@ static int flatten_path(const char *prefix, const char *suffix,
     return 0;
 }
 
-int idmap(const char *target_apk, const char *overlay_apk, uid_t uid)
-{
-    ALOGV("idmap target_apk=%s overlay_apk=%s uid=%d\n", target_apk, overlay_apk, uid);
+/* The stats of the apks an idmap was generated from are kept in this xattr
+   of the idmap. It is only regenerated when they change. */
+#define IDMAP_STAMP_XATTR "user.installd.idmap"
+#define IDMAP_STAMP_MAX 256
+
+/* the most idmaps idmap_batch() generates at once */
+#define IDMAP_MAX_JOBS 4
 
-    int idmap_fd = -1;
+struct idmap_job {
+    const char *target_apk;
+    const char *overlay_apk;
     char idmap_path[PATH_MAX];
+    char stamp[IDMAP_STAMP_MAX];
+    int fd;
+    pid_t pid;
+};
 
-    if (flatten_path(IDMAP_PREFIX, IDMAP_SUFFIX, overlay_apk,
-                idmap_path, sizeof(idmap_path)) == -1) {
-        ALOGE("idmap cannot generate idmap path for overlay %s\n", overlay_apk);
-        goto fail;
+static int append_stamp(const char *apk, char *stamp, size_t size)
+{
+    struct stat s;
+    size_t len = strlen(stamp);
+    if (stat(apk, &s) < 0) {
+        return -1;
     }
+    snprintf(stamp + len, size - len, "%" PRIx64 ":%" PRIu64 ":%" PRId64 ":%ld.%09ld;",
+            (uint64_t) s.st_dev, (uint64_t) s.st_ino, (int64_t) s.st_size,
+            (long) s.st_mtime, (long) s.st_mtim.tv_nsec);
+    return 0;
+}
 
-    unlink(idmap_path);
-    idmap_fd = open(idmap_path, O_RDWR | O_CREAT | O_EXCL, 0644);
-    if (idmap_fd < 0) {
-        ALOGE("idmap cannot open '%s' for output: %s\n", idmap_path, strerror(errno));
-        goto fail;
+/* tells whether the idmap of job is there and was generated from the
+   current target and overlay for uid */
+static int idmap_is_current(const struct idmap_job *job, uid_t uid)
+{
+    char current[IDMAP_STAMP_MAX];
+    struct stat s;
+    ssize_t len;
+
+    if (job->stamp[0] == '\0' || lstat(job->idmap_path, &s) < 0 ||
+            !S_ISREG(s.st_mode) || s.st_size == 0 ||
+            s.st_uid != AID_SYSTEM || s.st_gid != uid) {
+        return 0;
     }
-    if (fchown(idmap_fd, AID_SYSTEM, uid) < 0) {
-        ALOGE("idmap cannot chown '%s'\n", idmap_path);
-        goto fail;
+    len = getxattr(job->idmap_path, IDMAP_STAMP_XATTR, current, sizeof(current) - 1);
+    if (len < 0) {
+        return 0;
     }
-    if (fchmod(idmap_fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) < 0) {
-        ALOGE("idmap cannot chmod '%s'\n", idmap_path);
-        goto fail;
+    current[len] = '\0';
+    return !strcmp(current, job->stamp);
+}
+
+/* forks the idmap of job; returns 1 if it's current already, and -1 if it
+   couldn't be started */
+static int idmap_start(struct idmap_job *job, uid_t uid)
+{
+    ALOGV("idmap target_apk=%s overlay_apk=%s uid=%d\n", job->target_apk, job->overlay_apk, uid);
+
+    job->fd = -1;
+    job->pid = -1;
+    job->stamp[0] = '\0';
+
+    if (flatten_path(IDMAP_PREFIX, IDMAP_SUFFIX, job->overlay_apk,
+                job->idmap_path, sizeof(job->idmap_path)) == -1) {
+        ALOGE("idmap cannot generate idmap path for overlay %s\n", job->overlay_apk);
+        job->idmap_path[0] = '\0';
+        return -1;
     }
 
-    pid_t pid;
-    pid = fork();
-    if (pid == 0) {
+    if (append_stamp(job->target_apk, job->stamp, sizeof(job->stamp)) < 0 ||
+            append_stamp(job->overlay_apk, job->stamp, sizeof(job->stamp)) < 0) {
+        job->stamp[0] = '\0';
+    } else if (idmap_is_current(job, uid)) {
+        ALOGV("idmap %s is up to date\n", job->idmap_path);
+        return 1;
+    }
+
+    unlink(job->idmap_path);
+    job->fd = open(job->idmap_path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (job->fd < 0) {
+        ALOGE("idmap cannot open '%s' for output: %s\n", job->idmap_path, strerror(errno));
+        return -1;
+    }
+    if (fchown(job->fd, AID_SYSTEM, uid) < 0) {
+        ALOGE("idmap cannot chown '%s'\n", job->idmap_path);
+        return -1;
+    }
+    if (fchmod(job->fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) < 0) {
+        ALOGE("idmap cannot chmod '%s'\n", job->idmap_path);
+        return -1;
+    }
+
+    job->pid = fork();
+    if (job->pid == 0) {
         /* child -- drop privileges before continuing */
         if (setgid(uid) != 0) {
             ALOGE("setgid(%d) failed during idmap\n", uid);
@@ -1450,29 +1623,156 @@ int idmap(const char *target_apk, const char *overlay_apk, uid_t uid)
             ALOGE("setuid(%d) failed during idmap\n", uid);
             exit(1);
         }
-        if (flock(idmap_fd, LOCK_EX | LOCK_NB) != 0) {
-            ALOGE("flock(%s) failed during idmap: %s\n", idmap_path, strerror(errno));
+        if (fcntl(job->fd, F_SETFD, 0) < 0) {
+            ALOGE("fcntl failed during idmap: %s\n", strerror(errno));
+            exit(1);
+        }
+        if (flock(job->fd, LOCK_EX | LOCK_NB) != 0) {
+            ALOGE("flock(%s) failed during idmap: %s\n", job->idmap_path, strerror(errno));
             exit(1);
         }
 
-        run_idmap(target_apk, overlay_apk, idmap_fd);
+        run_idmap(job->target_apk, job->overlay_apk, job->fd);
         exit(1); /* only if exec call to idmap failed */
-    } else {
-        int status = wait_child(pid);
+    }
+    if (job->pid < 0) {
+        ALOGE("idmap cannot fork: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/* waits for the idmap started by idmap_start(), or cleans up after its
+   failure if result is -1 */
+static int idmap_finish(struct idmap_job *job, int result)
+{
+    if (result == 0) {
+        int status = wait_child(job->pid);
         if (status != 0) {
             ALOGE("idmap failed, status=0x%04x\n", status);
-            goto fail;
+            result = -1;
+        } else if (job->stamp[0] != '\0' && fsetxattr(job->fd, IDMAP_STAMP_XATTR,
+                    job->stamp, strlen(job->stamp), 0) < 0) {
+            ALOGW("idmap cannot stamp '%s': %s\n", job->idmap_path, strerror(errno));
         }
     }
-
-    close(idmap_fd);
+    if (result < 0) {
+        if (job->fd >= 0) {
+            close(job->fd);
+            unlink(job->idmap_path);
+        }
+        return -1;
+    }
+    if (job->fd >= 0) {
+        close(job->fd);
+    }
     return 0;
-fail:
-    if (idmap_fd >= 0) {
-        close(idmap_fd);
-        unlink(idmap_path);
+}
+
+int idmap(const char *target_apk, const char *overlay_apk, uid_t uid)
+{
+    struct idmap_job job;
+    job.target_apk = target_apk;
+    job.overlay_apk = overlay_apk;
+    int result = idmap_start(&job, uid);
+    if (result > 0) {
+        return 0;
     }
-    return -1;
+    return idmap_finish(&job, result);
+}
+
+int idmap_batch(char *pairs, uid_t uid)
+{
+    struct idmap_job jobs[IDMAP_MAX_JOBS];
+    int results[IDMAP_MAX_JOBS];
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_jobs = cpus < 1 ? 1 : (cpus > IDMAP_MAX_JOBS ? IDMAP_MAX_JOBS : (size_t) cpus);
+    size_t running = 0;
+    size_t count = 0;
+    size_t next = 0;
+    size_t i, j;
+    int ret = 0;
+    char **targets;
+    char **overlays;
+    char *saveptr;
+    char *pair;
+
+    /* split the pairs first, so that an overlay given more than once can
+       be dropped: the idmap path comes from the overlay alone, and two jobs
+       writing the same idmap at once would clobber each other */
+    for (pair = pairs; *pair != '\0'; pair++) {
+        if (*pair == ',') {
+            count++;
+        }
+    }
+    count++;
+    targets = malloc(count * sizeof(*targets));
+    overlays = malloc(count * sizeof(*overlays));
+    if (targets == NULL || overlays == NULL) {
+        free(targets);
+        free(overlays);
+        return -1;
+    }
+
+    count = 0;
+    for (pair = strtok_r(pairs, ",", &saveptr); pair != NULL; pair = strtok_r(NULL, ",", &saveptr)) {
+        char *overlay = strchr(pair, ':');
+        if (overlay == NULL) {
+            ALOGE("idmap batch: bad pair '%s'\n", pair);
+            ret = -1;
+            continue;
+        }
+        *overlay++ = '\0';
+        targets[count] = pair;
+        overlays[count] = overlay;
+        count++;
+    }
+
+    /* like a series of idmap commands, the last pair of an overlay wins */
+    for (i = 0; i < count; i++) {
+        for (j = i + 1; j < count; j++) {
+            if (overlays[j] != NULL && !strcmp(overlays[i], overlays[j])) {
+                ALOGV("idmap batch: overlay %s is given again, skipping target %s\n",
+                        overlays[i], targets[i]);
+                overlays[i] = NULL;
+                break;
+            }
+        }
+    }
+
+    for (;;) {
+        while (next < count && overlays[next] == NULL) {
+            next++;
+        }
+        /* wait for the oldest one when all the slots are busy, and for all
+           of them at the end */
+        if (running == max_jobs || (next == count && running > 0)) {
+            ret |= idmap_finish(&jobs[0], results[0]);
+            running--;
+            for (i = 0; i < running; i++) {
+                jobs[i] = jobs[i + 1];
+                results[i] = results[i + 1];
+            }
+            continue;
+        }
+        if (next == count) {
+            break;
+        }
+
+        struct idmap_job *job = &jobs[running];
+        job->target_apk = targets[next];
+        job->overlay_apk = overlays[next];
+        next++;
+        results[running] = idmap_start(job, uid);
+        if (results[running] > 0) {
+            continue;
+        }
+        running++;
+    }
+
+    free(targets);
+    free(overlays);
+    return ret;
 }
 
 int restorecon_data(const char* pkgName, const char* seinfo, uid_t uid)
@@ -1481,42 +1781,47 @@ int restorecon_data(const char* pkgName, const char* seinfo, uid_t uid)
     DIR *d;
     struct stat s;
     char *userdir;
-    char *primarydir;
-    char *pkgdir;
-    int ret = 0;
-
-    // SELINUX_ANDROID_RESTORECON_DATADATA flag is set by libselinux. Not needed here.
-    unsigned int flags = SELINUX_ANDROID_RESTORECON_RECURSE;
+    char **pkgdirs = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t i;
+    int ret;
 
     if (!pkgName || !seinfo) {
         ALOGE("Package name or seinfo tag is null when trying to restorecon.");
         return -1;
     }
 
-    if (asprintf(&primarydir, "%s%s%s", android_data_dir.path, PRIMARY_USER_PREFIX, pkgName) < 0) {
+    // Relabel for primary user, and for all secondary users. The
+    // directories are collected first, and relabeled in parallel.
+    pkgdirs = malloc(sizeof(*pkgdirs));
+    if (pkgdirs == NULL) {
         return -1;
     }
-
-    // Relabel for primary user.
-    if (selinux_android_restorecon_pkgdir(primarydir, seinfo, uid, flags) < 0) {
-        ALOGE("restorecon failed for %s: %s\n", primarydir, strerror(errno));
-        ret |= -1;
+    capacity = 1;
+    if (asprintf(&pkgdirs[0], "%s%s%s", android_data_dir.path, PRIMARY_USER_PREFIX, pkgName) < 0) {
+        free(pkgdirs);
+        return -1;
     }
+    count = 1;
 
     if (asprintf(&userdir, "%s%s", android_data_dir.path, SECONDARY_USER_PREFIX) < 0) {
-        free(primarydir);
-        return -1;
+        ret = -1;
+        goto out;
     }
 
-    // Relabel package directory for all secondary users.
     d = opendir(userdir);
     if (d == NULL) {
-        free(primarydir);
+        // relabel the primary user anyway, but still report the failure
+        restorecon_pkgdirs(pkgdirs, count, seinfo, uid);
         free(userdir);
-        return -1;
+        ret = -1;
+        goto out;
     }
 
     while ((entry = readdir(d))) {
+        char *pkgdir;
+
         if (entry->d_type != DT_DIR) {
             continue;
         }
@@ -1542,16 +1847,27 @@ int restorecon_data(const char* pkgName, const char* seinfo, uid_t uid)
             continue;
         }
 
-        if (selinux_android_restorecon_pkgdir(pkgdir, seinfo, uid, flags) < 0) {
-            ALOGE("restorecon failed for %s: %s\n", pkgdir, strerror(errno));
-            ret |= -1;
+        if (count == capacity) {
+            char **grown = realloc(pkgdirs, 2 * capacity * sizeof(*pkgdirs));
+            if (grown == NULL) {
+                free(pkgdir);
+                continue;
+            }
+            pkgdirs = grown;
+            capacity *= 2;
         }
-        free(pkgdir);
+        pkgdirs[count++] = pkgdir;
     }
 
     closedir(d);
-    free(primarydir);
     free(userdir);
+    ret = restorecon_pkgdirs(pkgdirs, count, seinfo, uid);
+
+out:
+    for (i = 0; i < count; i++) {
+        free(pkgdirs[i]);
+    }
+    free(pkgdirs);
     return ret;
 }
 
@@ -0,0 +1,224 @@
+/*
+** Copyright 2008, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <pthread.h>
+#include <time.h>
+
+#include "installd.h"
+
+/*
+ * Limits the number of dex2oat children running at once. When the package
+ * manager sends many dexopt commands without waiting for the replies (after
+ * an OTA for instance), they run on several workers, and each of them asks
+ * for a slot here before forking dex2oat.
+ *
+ * The number of slots is recomputed every time from the number of CPUs, the
+ * memory available and the temperature of the device, and the CPUs are
+ * split between the running compilers with dex2oat's -j option.
+ */
+
+/* At most this many dex2oat at once, so that a worker is always left for
+   the other commands. */
+#define DEXOPT_MAX_JOBS         3
+/* Memory used by a dex2oat, unless dalvik.vm.dex2oat-Xmx is larger. */
+#define DEXOPT_JOB_MEMORY       (256LL * 1024 * 1024)
+/* Only one dex2oat runs while a thermal zone is this close to throttling,
+   in thousandths of its trip temperature. */
+#define DEXOPT_THERMAL_MARGIN   50
+#define MAX_THERMAL_ZONES       32
+#define MAX_TRIP_POINTS         8
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_released = PTHREAD_COND_INITIALIZER;
+static int g_running;
+
+static int read_file(const char *path, char *buf, size_t size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    ssize_t len;
+
+    if (fd < 0) {
+        return -1;
+    }
+    len = read(fd, buf, size - 1);
+    close(fd);
+    if (len < 0) {
+        return -1;
+    }
+    buf[len] = 0;
+    return 0;
+}
+
+static int read_long(const char *path, long *value)
+{
+    char buf[32];
+    char *end;
+
+    if (read_file(path, buf, sizeof(buf)) < 0) {
+        return -1;
+    }
+    *value = strtol(buf, &end, 10);
+    return end == buf ? -1 : 0;
+}
+
+/* Returns the memory that can be used without swapping, or -1. */
+static int64_t available_memory()
+{
+    char buf[1024];
+    const char *s;
+    long long free_kb = 0, cached_kb = 0, avail_kb;
+
+    if (read_file("/proc/meminfo", buf, sizeof(buf)) < 0) {
+        return -1;
+    }
+    if ((s = strstr(buf, "MemAvailable:")) != NULL
+            && sscanf(s, "MemAvailable: %lld", &avail_kb) == 1) {
+        return avail_kb * 1024;
+    }
+    /* kernels before 3.14 */
+    if ((s = strstr(buf, "MemFree:")) != NULL) {
+        sscanf(s, "MemFree: %lld", &free_kb);
+    }
+    if ((s = strstr(buf, "\nCached:")) != NULL) {
+        sscanf(s, "\nCached: %lld", &cached_kb);
+    }
+    return (free_kb + cached_kb) * 1024;
+}
+
+/* Parses a heap size such as "512m", returns -1 if it can't. */
+static int64_t parse_heap_size(const char *s)
+{
+    char *end;
+    long long size = strtoll(s, &end, 10);
+
+    if (end == s || size <= 0) {
+        return -1;
+    }
+    switch (*end) {
+    case 'g': case 'G': size *= 1024;   /* fall through */
+    case 'm': case 'M': size *= 1024;   /* fall through */
+    case 'k': case 'K': size *= 1024;   break;
+    case 0: break;
+    default: return -1;
+    }
+    return size;
+}
+
+static int64_t job_memory()
+{
+    char value[PROPERTY_VALUE_MAX];
+    int64_t size = -1;
+
+    if (property_get("dalvik.vm.dex2oat-Xmx", value, NULL) > 0) {
+        size = parse_heap_size(value);
+    }
+    return size > DEXOPT_JOB_MEMORY ? size : DEXOPT_JOB_MEMORY;
+}
+
+/* Returns 1 if a thermal zone is close to its first passive trip point,
+   where the kernel starts throttling the CPUs. */
+static int is_near_throttling()
+{
+    char path[PATH_MAX];
+    char type[32];
+    int zone, trip;
+
+    for (zone = 0; zone < MAX_THERMAL_ZONES; zone++) {
+        long temp;
+        snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/temp", zone);
+        if (read_long(path, &temp) < 0) {
+            break;
+        }
+        for (trip = 0; trip < MAX_TRIP_POINTS; trip++) {
+            long trip_temp;
+            snprintf(path, sizeof(path),
+                    "/sys/class/thermal/thermal_zone%d/trip_point_%d_type", zone, trip);
+            if (read_file(path, type, sizeof(type)) < 0) {
+                break;
+            }
+            if (strncmp(type, "passive", 7) != 0) {
+                continue;
+            }
+            snprintf(path, sizeof(path),
+                    "/sys/class/thermal/thermal_zone%d/trip_point_%d_temp", zone, trip);
+            if (read_long(path, &trip_temp) == 0 && trip_temp > 0
+                    && temp >= trip_temp - trip_temp * DEXOPT_THERMAL_MARGIN / 1000) {
+                return 1;
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+int dexopt_sched_limit(long cpus, int64_t avail_mem, int64_t job_mem, int hot, int *threads)
+{
+    long limit;
+
+    if (cpus < 1) {
+        cpus = 1;
+    }
+    /* two threads per compiler compile faster than twice as many compilers
+       competing for the memory bandwidth */
+    limit = cpus / 2;
+    if (avail_mem >= 0 && job_mem > 0 && avail_mem / job_mem < limit) {
+        limit = (long)(avail_mem / job_mem);
+    }
+    if (hot || limit < 1) {
+        limit = 1;
+    }
+    if (limit > DEXOPT_MAX_JOBS) {
+        limit = DEXOPT_MAX_JOBS;
+    }
+    if (threads != NULL) {
+        *threads = (int)(cpus / limit);
+    }
+    return (int)limit;
+}
+
+int dexopt_sched_acquire()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int64_t job_mem = job_memory();
+    int limit, threads;
+
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        // The memory and the temperature change while the compilers run,
+        // look again now and then even if none of them completed.
+        limit = dexopt_sched_limit(cpus, available_memory(), job_mem,
+                is_near_throttling(), &threads);
+        if (g_running < limit) {
+            break;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        pthread_cond_timedwait(&g_released, &g_lock, &deadline);
+    }
+    g_running++;
+    ALOGV("dexopt: %d of %d compilers, %d threads each\n", g_running, limit, threads);
+    pthread_mutex_unlock(&g_lock);
+    return threads;
+}
+
+void dexopt_sched_release()
+{
+    pthread_mutex_lock(&g_lock);
+    g_running--;
+    pthread_cond_broadcast(&g_released);
+    pthread_mutex_unlock(&g_lock);
+}
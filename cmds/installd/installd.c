@@ -14,6 +14,7 @@
 ** limitations under the License.
 */
 
+#include <pthread.h>
 #include <sys/capability.h>
 #include <sys/prctl.h>
 #include <selinux/android.h>
@@ -25,6 +26,9 @@
 #define BUFFER_MAX    1024  /* input buffer for commands */
 #define TOKEN_MAX     8     /* max number of arguments in buffer */
 #define REPLY_MAX     256   /* largest reply allowed */
+#define JOB_ID_MAX    16    /* largest job id allowed */
+#define MAX_WORKERS   4     /* max number of commands run at once */
+#define MAX_JOBS      256   /* max number of commands queued or running */
 
 static int do_ping(char **arg, char reply[REPLY_MAX])
 {
@@ -139,6 +143,12 @@ static int do_idmap(char **arg, char reply[REPLY_MAX])
     return idmap(arg[0], arg[1], atoi(arg[2]));
 }
 
+static int do_idmap_batch(char **arg, char reply[REPLY_MAX] __attribute__((unused)))
+{
+    /* pairs, uid: the pairs are <target apk>:<overlay apk>, separated by commas */
+    return idmap_batch(arg[0], atoi(arg[1]));
+}
+
 static int do_restorecon_data(char **arg, char reply[REPLY_MAX] __attribute__((unused)))
 {
     return restorecon_data(arg[0], arg[1], atoi(arg[2]));
@@ -150,34 +160,42 @@ static int do_patchoat(char **arg, char reply[REPLY_MAX]) {
     return dexopt(arg[0], atoi(arg[1]), atoi(arg[2]), arg[3], arg[4], 0, 1);
 }
 
+/* Commands with a package name argument only wait for the earlier commands
+ * on the same package, the others wait for all the earlier commands.
+ */
+#define LOCK_NONE     -1    /* doesn't touch any file */
+#define LOCK_ALL      -2    /* touches several packages or users */
+
 struct cmdinfo {
     const char *name;
     unsigned numargs;
     int (*func)(char **arg, char reply[REPLY_MAX]);
+    int lockarg;        /* index of the package name, or LOCK_* */
 };
 
 struct cmdinfo cmds[] = {
-    { "ping",                 0, do_ping },
-    { "install",              4, do_install },
-    { "dexopt",               6, do_dexopt },
-    { "movedex",              3, do_move_dex },
-    { "rmdex",                2, do_rm_dex },
-    { "remove",               2, do_remove },
-    { "rename",               2, do_rename },
-    { "fixuid",               3, do_fixuid },
-    { "freecache",            1, do_free_cache },
-    { "rmcache",              2, do_rm_cache },
-    { "rmcodecache",          2, do_rm_code_cache },
-    { "getsize",              7, do_get_size },
-    { "rmuserdata",           2, do_rm_user_data },
-    { "movefiles",            0, do_movefiles },
-    { "linklib",              3, do_linklib },
-    { "mkuserdata",           4, do_mk_user_data },
-    { "mkuserconfig",         1, do_mk_user_config },
-    { "rmuser",               1, do_rm_user },
-    { "idmap",                3, do_idmap },
-    { "restorecondata",       3, do_restorecon_data },
-    { "patchoat",             5, do_patchoat },
+    { "ping",                 0, do_ping,             LOCK_NONE },
+    { "install",              4, do_install,          0 },
+    { "dexopt",               6, do_dexopt,           3 },
+    { "movedex",              3, do_move_dex,         LOCK_ALL },
+    { "rmdex",                2, do_rm_dex,           LOCK_ALL },
+    { "remove",               2, do_remove,           0 },
+    { "rename",               2, do_rename,           LOCK_ALL },
+    { "fixuid",               3, do_fixuid,           0 },
+    { "freecache",            1, do_free_cache,       LOCK_ALL },
+    { "rmcache",              2, do_rm_cache,         0 },
+    { "rmcodecache",          2, do_rm_code_cache,    0 },
+    { "getsize",              7, do_get_size,         0 },
+    { "rmuserdata",           2, do_rm_user_data,     0 },
+    { "movefiles",            0, do_movefiles,        LOCK_ALL },
+    { "linklib",              3, do_linklib,          0 },
+    { "mkuserdata",           4, do_mk_user_data,     0 },
+    { "mkuserconfig",         1, do_mk_user_config,   LOCK_ALL },
+    { "rmuser",               1, do_rm_user,          LOCK_ALL },
+    { "idmap",                3, do_idmap,            LOCK_ALL },
+    { "idmapbatch",           2, do_idmap_batch,      LOCK_ALL },
+    { "restorecondata",       3, do_restorecon_data,  0 },
+    { "patchoat",             5, do_patchoat,         3 },
 };
 
 static int readx(int s, void *_buf, int count)
@@ -219,67 +237,265 @@ static int writex(int s, const void *_buf, int count)
 }
 
 
+/* A command read from the socket. Commands prefixed with "@<id> " are
+ * replied to with "@<id> <ret> [reply]" as soon as they complete, so the
+ * client can send the next ones without waiting. The others are replied
+ * to with "<ret> [reply]" and the client waits for the reply, as before.
+ */
+struct job {
+    struct job *next;
+    int s;
+    char *id;               /* in buf, NULL if the client waits for the reply */
+    const struct cmdinfo *cmd;  /* NULL if the command is invalid */
+    char *arg[TOKEN_MAX+1];
+    int running;
+    int done;
+    char buf[BUFFER_MAX];
+};
+
+static pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobs_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobs_finished = PTHREAD_COND_INITIALIZER;
+static struct job *jobs;        /* queued and running, in the order received */
+static unsigned num_jobs;
+
+static pthread_mutex_t reply_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Tokenize the command buffer, locate a matching command,
- * ensure that the required number of arguments are provided,
- * call the function(), return the result.
+ * ensure that the required number of arguments are provided.
  */
-static int execute(int s, char cmd[BUFFER_MAX])
+static void parse(struct job *job)
 {
-    char reply[REPLY_MAX];
-    char *arg[TOKEN_MAX+1];
+    char *cmd = job->buf;
     unsigned i;
     unsigned n = 0;
-    unsigned short count;
-    int ret = -1;
-
-    // ALOGI("execute('%s')\n", cmd);
 
-        /* default reply is "" */
-    reply[0] = 0;
+    job->cmd = NULL;
+    job->id = NULL;
+    job->arg[0] = cmd;
+
+    if (*cmd == '@') {
+        char *end = strchr(cmd, ' ');
+        job->id = cmd + 1;
+        if (end != NULL) {
+            *end = 0;
+            cmd = end + 1;
+        } else {
+            cmd += strlen(cmd);
+        }
+            /* still replied to with the id, so the client isn't left waiting */
+        if (strlen(job->id) < 1 || strlen(job->id) >= JOB_ID_MAX) {
+            ALOGE("invalid job id\n");
+            return;
+        }
+    }
 
         /* n is number of args (not counting arg[0]) */
-    arg[0] = cmd;
+    job->arg[0] = cmd;
     while (*cmd) {
         if (isspace(*cmd)) {
             *cmd++ = 0;
             n++;
-            arg[n] = cmd;
+            job->arg[n] = cmd;
             if (n == TOKEN_MAX) {
                 ALOGE("too many arguments\n");
-                goto done;
+                return;
             }
         }
         cmd++;
     }
 
     for (i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
-        if (!strcmp(cmds[i].name,arg[0])) {
+        if (!strcmp(cmds[i].name, job->arg[0])) {
             if (n != cmds[i].numargs) {
                 ALOGE("%s requires %d arguments (%d given)\n",
                      cmds[i].name, cmds[i].numargs, n);
             } else {
-                ret = cmds[i].func(arg + 1, reply);
+                job->cmd = &cmds[i];
             }
-            goto done;
+            return;
         }
     }
-    ALOGE("unsupported command '%s'\n", arg[0]);
+    ALOGE("unsupported command '%s'\n", job->arg[0]);
+}
 
-done:
-    if (reply[0]) {
-        n = snprintf(cmd, BUFFER_MAX, "%d %s", ret, reply);
+/* call the function(), send the result. */
+static int execute(struct job *job)
+{
+    char reply[REPLY_MAX];
+    char out[BUFFER_MAX];
+    unsigned short count;
+    int ret = -1;
+    int n;
+    int res = 0;
+
+    // ALOGI("execute('%s')\n", job->arg[0]);
+
+        /* default reply is "" */
+    reply[0] = 0;
+
+    if (job->cmd != NULL) {
+        ret = job->cmd->func(job->arg + 1, reply);
+    }
+
+    if (job->id != NULL) {
+        n = snprintf(out, BUFFER_MAX, "@%s %d", job->id, ret);
     } else {
-        n = snprintf(cmd, BUFFER_MAX, "%d", ret);
+        n = snprintf(out, BUFFER_MAX, "%d", ret);
+    }
+    if (reply[0]) {
+        n += snprintf(out + n, BUFFER_MAX - n, " %s", reply);
     }
     if (n > BUFFER_MAX) n = BUFFER_MAX;
     count = n;
 
-    // ALOGI("reply: '%s'\n", cmd);
-    if (writex(s, &count, sizeof(count))) return -1;
-    if (writex(s, cmd, count)) return -1;
+    // ALOGI("reply: '%s'\n", out);
+    pthread_mutex_lock(&reply_lock);
+    if (writex(job->s, &count, sizeof(count)) || writex(job->s, out, count)) {
+        res = -1;
+    }
+    pthread_mutex_unlock(&reply_lock);
+    return res;
+}
+
+static int lock_arg(const struct job *job)
+{
+    return job->cmd != NULL ? job->cmd->lockarg : LOCK_NONE;
+}
+
+static int jobs_conflict(const struct job *a, const struct job *b)
+{
+    int la = lock_arg(a);
+    int lb = lock_arg(b);
+    if (la == LOCK_NONE || lb == LOCK_NONE) {
+        return 0;
+    }
+    if (la == LOCK_ALL || lb == LOCK_ALL) {
+        return 1;
+    }
+    return !strcmp(a->arg[la + 1], b->arg[lb + 1]);
+}
+
+/* Returns the first queued job that doesn't conflict with any job received
+ * before it, so that the commands on a package run in order.
+ */
+static struct job *next_runnable_job()
+{
+    struct job *job, *prev;
+    for (job = jobs; job != NULL; job = job->next) {
+        if (job->running) {
+            continue;
+        }
+        for (prev = jobs; prev != job; prev = prev->next) {
+            if (jobs_conflict(prev, job)) {
+                break;
+            }
+        }
+        if (prev == job) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static void *worker_main(void *arg __attribute__((unused)))
+{
+    struct job **link;
+    struct job *job;
+
+    for (;;) {
+        pthread_mutex_lock(&jobs_lock);
+        while ((job = next_runnable_job()) == NULL) {
+            pthread_cond_wait(&jobs_queued, &jobs_lock);
+        }
+        job->running = 1;
+        pthread_mutex_unlock(&jobs_lock);
+
+        if (execute(job)) {
+            ALOGE("failed to reply to '%s'\n", job->arg[0]);
+        }
+
+        pthread_mutex_lock(&jobs_lock);
+        for (link = &jobs; *link != job; link = &(*link)->next) {
+        }
+        *link = job->next;
+        num_jobs--;
+        if (job->id != NULL) {
+            free(job);
+        } else {
+            job->done = 1;    /* freed by the thread waiting for it */
+        }
+        pthread_cond_broadcast(&jobs_finished);
+        pthread_cond_broadcast(&jobs_queued);
+        pthread_mutex_unlock(&jobs_lock);
+    }
+    return NULL;
+}
+
+/* The workers must be started after drop_privileges(), the credentials of
+ * a thread are only inherited by the threads it creates.
+ */
+static int start_workers()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_workers = cpus < 2 ? 2 : (cpus > MAX_WORKERS ? MAX_WORKERS : (int) cpus);
+    int i;
+
+    for (i = 0; i < num_workers; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, NULL)) {
+            ALOGE("failed to start worker %d\n", i);
+            return i == 0 ? -1 : 0;
+        }
+        pthread_detach(thread);
+    }
+    ALOGI("running commands on %d workers\n", num_workers);
+    return 0;
+}
+
+/* Queues the command, and waits for it to complete if the client does. */
+static int submit(int s, const char *cmd, int count)
+{
+    struct job *job = calloc(1, sizeof(struct job));
+    struct job **link;
+
+    if (job == NULL) {
+        ALOGE("out of memory\n");
+        return -1;
+    }
+    job->s = s;
+    memcpy(job->buf, cmd, count);
+    job->buf[count] = 0;
+    parse(job);
+
+    pthread_mutex_lock(&jobs_lock);
+    while (num_jobs >= MAX_JOBS) {
+        pthread_cond_wait(&jobs_finished, &jobs_lock);
+    }
+    for (link = &jobs; *link != NULL; link = &(*link)->next) {
+    }
+    *link = job;
+    num_jobs++;
+    pthread_cond_broadcast(&jobs_queued);
+    if (job->id == NULL) {
+        while (!job->done) {
+            pthread_cond_wait(&jobs_finished, &jobs_lock);
+        }
+        free(job);
+    }
+    pthread_mutex_unlock(&jobs_lock);
     return 0;
 }
 
+static void wait_for_jobs()
+{
+    pthread_mutex_lock(&jobs_lock);
+    while (jobs != NULL) {
+        pthread_cond_wait(&jobs_finished, &jobs_lock);
+    }
+    pthread_mutex_unlock(&jobs_lock);
+}
+
 /**
  * Initialize all the global variables that are used elsewhere. Returns 0 upon
  * success and -1 on error.
@@ -681,6 +897,11 @@ int main(const int argc, const char *argv[]) {
 
     drop_privileges();
 
+    if (start_workers() < 0) {
+        ALOGE("Could not start workers; exiting.\n");
+        exit(1);
+    }
+
     lsocket = android_get_control_socket(SOCKET_PATH);
     if (lsocket < 0) {
         ALOGE("Failed to get socket from environment: %s\n", strerror(errno));
@@ -716,12 +937,15 @@ int main(const int argc, const char *argv[]) {
                 ALOGE("failed to read command\n");
                 break;
             }
-            buf[count] = 0;
             if (selinux_enabled && selinux_status_updated() > 0) {
+                /* the running commands may be using the contexts */
+                wait_for_jobs();
                 selinux_android_seapp_context_reload();
             }
-            if (execute(s, buf)) break;
+            if (submit(s, buf, count)) break;
         }
+        /* the replies of the queued commands are still written to s */
+        wait_for_jobs();
         ALOGI("closing connection\n");
         close(s);
     }
@@ -130,6 +130,37 @@ typedef struct {
     int8_t* curMemBlockEnd;
 } cache_t;
 
+/* A cache file found by the streaming collection, see cache_heap_t. */
+typedef struct {
+    time_t modTime;
+    size_t root;        /* index of the cache directory holding the file */
+    char* path;
+} cache_entry_t;
+
+/*
+ * Keeps the `capacity` oldest cache files offered to it, as a max-heap on
+ * the modification time so that the newest of them is dropped first.
+ */
+typedef struct {
+    size_t count;
+    size_t capacity;
+    cache_entry_t* entries;
+} cache_heap_t;
+
+typedef struct {
+    int64_t codesize;
+    int64_t datasize;
+    int64_t cachesize;
+    int64_t asecsize;
+} size_info_t;
+
+/* The cache directories walked by the streaming collection. */
+typedef struct {
+    size_t numRoots;
+    size_t availRoots;
+    char** roots;
+} cache_stream_t;
+
 /* util.c */
 
 int create_pkg_path_in_dir(char path[PKG_PATH_MAX],
@@ -165,6 +196,12 @@ int delete_dir_contents(const char *pathname,
 
 int delete_dir_contents_fd(int dfd, const char *name);
 
+int copy_file_contents(int srcfd, int dstfd);
+
+int copy_file_xattrs(int srcfd, int dstfd);
+
+int copy_file(const char *src, const char *dst, uid_t owner, gid_t group);
+
 int copy_dir_files(const char *srcname, const char *dstname, uid_t owner, gid_t group);
 
 int lookup_media_dir(char basepath[PATH_MAX], const char *dir);
@@ -179,6 +216,22 @@ void clear_cache_files(cache_t* cache, int64_t free_size);
 
 void finish_cache_collection(cache_t* cache);
 
+int cache_heap_init(cache_heap_t* heap, size_t capacity);
+
+int cache_heap_offer(cache_heap_t* heap, time_t modTime, size_t root, const char* path);
+
+void cache_heap_sort(cache_heap_t* heap);
+
+void cache_heap_destroy(cache_heap_t* heap);
+
+cache_stream_t* start_cache_stream();
+
+void add_cache_roots(cache_stream_t* stream, const char *basepath, const char *cachedir);
+
+void clear_cache_files_streaming(cache_stream_t* stream, int64_t free_size);
+
+void finish_cache_stream(cache_stream_t* stream);
+
 int validate_system_app_path(const char* path);
 
 int get_path_from_env(dir_rec_t* rec, const char* var);
@@ -200,6 +253,38 @@ int ensure_config_user_dirs(userid_t userid);
 int create_profile_file(const char *pkgname, gid_t gid);
 void remove_profile_file(const char *pkgname);
 
+/* size_index.c */
+
+int size_index_lookup(const char *pkgname, userid_t userid, const char *apkpath,
+        const char *libdirpath, const char *fwdlock_apkpath, const char *asecpath,
+        const char *instruction_set, size_info_t *sizes);
+
+/* Watches the files of a package before they are scanned, returns the token to
+ * store the sizes with or 0 if the package isn't indexed. */
+unsigned size_index_watch(const char *pkgname, userid_t userid, const char *apkpath,
+        const char *libdirpath, const char *fwdlock_apkpath, const char *asecpath,
+        const char *instruction_set);
+
+/* Stores the sizes scanned after size_index_watch(), unless the package
+ * changed in the meantime. */
+void size_index_store(unsigned token, const size_info_t *sizes);
+
+void size_index_invalidate(const char *pkgname, userid_t userid);
+
+void size_index_invalidate_all();
+
+/* dexopt_sched.c */
+
+int dexopt_sched_limit(long cpus, int64_t avail_mem, int64_t job_mem, int hot, int *threads);
+
+int dexopt_sched_acquire();
+
+void dexopt_sched_release();
+
+/* restorecon.c */
+
+int restorecon_pkgdirs(char **pkgdirs, size_t count, const char *seinfo, uid_t uid);
+
 /* commands.c */
 
 int install(const char *pkgname, uid_t uid, gid_t gid, const char *seinfo);
@@ -224,4 +309,5 @@ int dexopt(const char *apk_path, uid_t uid, bool is_public, const char *pkgName,
 int movefiles();
 int linklib(const char* target, const char* source, int userId);
 int idmap(const char *target_path, const char *overlay_path, uid_t uid);
+int idmap_batch(char *pairs, uid_t uid);
 int restorecon_data();
@@ -0,0 +1,280 @@
+/*
+** Copyright 2014, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/xattr.h>
+
+#include <openssl/sha.h>
+#include <selinux/android.h>
+
+#include "installd.h"
+
+/*
+ * Relabels package directories, skipping the ones that were relabeled
+ * under the same policy already.
+ *
+ * After a full relabel, the directory gets a digest of everything that
+ * decides the labels below it: the file and seapp contexts, the seinfo, the
+ * uid and the path. The next restorecon of the directory is skipped while
+ * the digest is the same. Apps own their data directory and could set the
+ * xattr themselves, so the digest is keyed with a secret only installd can
+ * read; without it, nothing is skipped.
+ *
+ * The directories of a package, one per user, are relabeled in parallel.
+ */
+
+#define RESTORECON_XATTR        "user.installd.restorecon"
+#define RESTORECON_KEY_SIZE     32
+#define RESTORECON_MAX_THREADS  4
+
+/* the files whose contents decide the labels of app data */
+static const char* policy_files[] = {
+    "/data/security/current/file_contexts",
+    "/data/security/current/seapp_contexts",
+    "/file_contexts",
+    "/seapp_contexts",
+    NULL,
+};
+#define NUM_POLICY_FILES (sizeof(policy_files) / sizeof(policy_files[0]) - 1)
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_have_key;
+static unsigned char g_key[RESTORECON_KEY_SIZE];
+/* the digest of the policy files, valid while they are the same as when
+   it was computed */
+static int g_have_policy_digest;
+static unsigned char g_policy_digest[SHA256_DIGEST_LENGTH];
+static struct stat g_policy_stats[NUM_POLICY_FILES];
+
+static int read_fully(int fd, void *buf, size_t size)
+{
+    char *p = buf;
+    while (size > 0) {
+        ssize_t n = TEMP_FAILURE_RETRY(read(fd, p, size));
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/* loads the key, creating it the first time */
+static int load_key_locked()
+{
+    char path[PKG_PATH_MAX];
+    int fd;
+
+    if (g_have_key) {
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%smisc/installd", android_data_dir.path);
+    if (fs_prepare_dir(path, 0700, AID_INSTALL, AID_INSTALL) == -1) {
+        return -1;
+    }
+    strlcat(path, "/restorecon_key", sizeof(path));
+
+    fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT) {
+        int rfd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+        if (rfd < 0 || read_fully(rfd, g_key, sizeof(g_key)) < 0) {
+            ALOGE("Couldn't make the restorecon key: %s\n", strerror(errno));
+            if (rfd >= 0) close(rfd);
+            return -1;
+        }
+        close(rfd);
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+        if (fd < 0 || TEMP_FAILURE_RETRY(write(fd, g_key, sizeof(g_key))) !=
+                (ssize_t) sizeof(g_key)) {
+            ALOGE("Couldn't write %s: %s\n", path, strerror(errno));
+            if (fd >= 0) {
+                close(fd);
+                unlink(path);
+            }
+            return -1;
+        }
+        close(fd);
+        g_have_key = 1;
+        return 0;
+    }
+    if (fd < 0 || read_fully(fd, g_key, sizeof(g_key)) < 0) {
+        ALOGE("Couldn't read %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    close(fd);
+    g_have_key = 1;
+    return 0;
+}
+
+static int same_stat(const struct stat *a, const struct stat *b)
+{
+    return a->st_dev == b->st_dev && a->st_ino == b->st_ino &&
+            a->st_size == b->st_size && a->st_mtime == b->st_mtime &&
+            a->st_ctime == b->st_ctime;
+}
+
+/* (re)computes the digest of the policy files if any of them changed */
+static int update_policy_digest_locked()
+{
+    struct stat stats[NUM_POLICY_FILES];
+    SHA256_CTX ctx;
+    size_t i;
+
+    memset(stats, 0, sizeof(stats));
+    for (i = 0; i < NUM_POLICY_FILES; i++) {
+        if (stat(policy_files[i], &stats[i]) < 0) {
+            memset(&stats[i], 0, sizeof(stats[i]));
+        }
+    }
+    if (g_have_policy_digest) {
+        for (i = 0; i < NUM_POLICY_FILES; i++) {
+            if (!same_stat(&stats[i], &g_policy_stats[i])) {
+                break;
+            }
+        }
+        if (i == NUM_POLICY_FILES) {
+            return 0;
+        }
+    }
+
+    g_have_policy_digest = 0;
+    SHA256_Init(&ctx);
+    for (i = 0; i < NUM_POLICY_FILES; i++) {
+        char buf[8192];
+        ssize_t n;
+        int fd = open(policy_files[i], O_RDONLY | O_CLOEXEC);
+        /* tell a missing file from an empty one */
+        SHA256_Update(&ctx, policy_files[i], strlen(policy_files[i]) + 1);
+        SHA256_Update(&ctx, fd < 0 ? "-" : "+", 1);
+        if (fd < 0) {
+            continue;
+        }
+        while ((n = TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)))) > 0) {
+            SHA256_Update(&ctx, buf, n);
+        }
+        close(fd);
+        if (n < 0) {
+            return -1;
+        }
+    }
+    SHA256_Final(g_policy_digest, &ctx);
+    memcpy(g_policy_stats, stats, sizeof(stats));
+    g_have_policy_digest = 1;
+    return 0;
+}
+
+/* the digest a package directory gets once relabeled; returns -1 if
+   directories can't be skipped */
+static int pkgdir_digest(const char *pkgdir, const char *seinfo, uid_t uid,
+        unsigned char digest[SHA256_DIGEST_LENGTH])
+{
+    SHA256_CTX ctx;
+    uint32_t uid32 = uid;
+
+    pthread_mutex_lock(&g_lock);
+    if (load_key_locked() < 0 || update_policy_digest_locked() < 0) {
+        pthread_mutex_unlock(&g_lock);
+        return -1;
+    }
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, g_key, sizeof(g_key));
+    SHA256_Update(&ctx, g_policy_digest, sizeof(g_policy_digest));
+    pthread_mutex_unlock(&g_lock);
+
+    SHA256_Update(&ctx, seinfo, strlen(seinfo) + 1);
+    SHA256_Update(&ctx, &uid32, sizeof(uid32));
+    SHA256_Update(&ctx, pkgdir, strlen(pkgdir) + 1);
+    SHA256_Final(digest, &ctx);
+    return 0;
+}
+
+static int restorecon_pkgdir(const char *pkgdir, const char *seinfo, uid_t uid)
+{
+    // SELINUX_ANDROID_RESTORECON_DATADATA flag is set by libselinux. Not needed here.
+    unsigned int flags = SELINUX_ANDROID_RESTORECON_RECURSE;
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    unsigned char current[SHA256_DIGEST_LENGTH];
+    int have_digest = pkgdir_digest(pkgdir, seinfo, uid, digest) == 0;
+
+    if (have_digest &&
+            getxattr(pkgdir, RESTORECON_XATTR, current, sizeof(current)) == sizeof(current) &&
+            !memcmp(digest, current, sizeof(digest))) {
+        ALOGV("%s is labeled for the current policy already\n", pkgdir);
+        return 0;
+    }
+
+    if (selinux_android_restorecon_pkgdir(pkgdir, seinfo, uid, flags) < 0) {
+        ALOGE("restorecon failed for %s: %s\n", pkgdir, strerror(errno));
+        return -1;
+    }
+    if (have_digest && setxattr(pkgdir, RESTORECON_XATTR, digest, sizeof(digest), 0) < 0) {
+        ALOGW("Couldn't set %s on %s: %s\n", RESTORECON_XATTR, pkgdir, strerror(errno));
+    }
+    return 0;
+}
+
+struct restorecon_walk {
+    char **pkgdirs;
+    size_t count;
+    const char *seinfo;
+    uid_t uid;
+    volatile int32_t next;
+    volatile int32_t ret;
+};
+
+static void *restorecon_thread(void *arg)
+{
+    struct restorecon_walk *walk = arg;
+    for (;;) {
+        size_t i = (size_t) __sync_fetch_and_add(&walk->next, 1);
+        if (i >= walk->count) {
+            return NULL;
+        }
+        if (restorecon_pkgdir(walk->pkgdirs[i], walk->seinfo, walk->uid) < 0) {
+            __sync_fetch_and_or(&walk->ret, -1);
+        }
+    }
+}
+
+int restorecon_pkgdirs(char **pkgdirs, size_t count, const char *seinfo, uid_t uid)
+{
+    struct restorecon_walk walk;
+    pthread_t threads[RESTORECON_MAX_THREADS];
+    size_t nthreads = count < RESTORECON_MAX_THREADS ? count : RESTORECON_MAX_THREADS;
+    size_t started = 0;
+    size_t i;
+
+    walk.pkgdirs = pkgdirs;
+    walk.count = count;
+    walk.seinfo = seinfo;
+    walk.uid = uid;
+    walk.next = 0;
+    walk.ret = 0;
+
+    for (i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[started], NULL, restorecon_thread, &walk) == 0) {
+            started++;
+        }
+    }
+    restorecon_thread(&walk);
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return walk.ret;
+}
@@ -0,0 +1,384 @@
+/*
+** Copyright 2008, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <pthread.h>
+#include <sys/inotify.h>
+
+#include "installd.h"
+
+/*
+ * Index of the sizes computed by get_size(), so that the storage settings
+ * don't walk the trees of packages that didn't change since the last
+ * request.
+ *
+ * An entry is only kept while inotify watches every directory of the
+ * package's data and library directories, and its code files. The watches
+ * are added before get_size() scans the package, and the first event on any
+ * of them drops the entry and its watches, so a change made during the scan
+ * isn't lost; the next get_size() does a full scan again. Commands that
+ * change the files of a package also drop its entries. Packages with too
+ * many directories to watch are not indexed and are always scanned.
+ *
+ * Commands run on several threads, g_lock protects the whole index.
+ */
+
+#define SIZE_INDEX_MAX_ENTRIES 1024
+#define SIZE_INDEX_MAX_WATCHES 4096
+
+#define SIZE_WATCH_MASK (IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | \
+        IN_DELETE_SELF | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO)
+
+typedef struct size_entry {
+    struct size_entry* next;
+    userid_t userid;
+    char* pkgname;
+    char* key;          /* the other arguments of get_size() */
+    unsigned token;     /* returned by size_index_watch() */
+    int pending;        /* watched, but the sizes aren't stored yet */
+    size_info_t sizes;
+    size_t numWatches;
+    size_t availWatches;
+    int* watches;
+} size_entry_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_inotify_fd = -1;
+static size_entry_t* g_entries;
+static size_t g_num_entries;
+static size_t g_num_watches;
+static unsigned g_last_token;
+
+static int size_index_init()
+{
+    if (g_inotify_fd < 0) {
+        g_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (g_inotify_fd < 0) {
+            ALOGE("Couldn't init inotify for the size index: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int entry_has_watch(const size_entry_t* entry, int wd)
+{
+    size_t i;
+    for (i=0; i<entry->numWatches; i++) {
+        if (entry->watches[i] == wd) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* The same path watched twice gets the same descriptor, so a watch is only
+   removed once no other entry uses it. */
+static void remove_entry(size_entry_t** link)
+{
+    size_entry_t* entry = *link;
+    size_t i;
+
+    *link = entry->next;
+    for (i=0; i<entry->numWatches; i++) {
+        int wd = entry->watches[i];
+        size_entry_t* other;
+        int shared = 0;
+        for (other = g_entries; other != NULL && !shared; other = other->next) {
+            shared = entry_has_watch(other, wd);
+        }
+        if (!shared) {
+            inotify_rm_watch(g_inotify_fd, wd);
+        }
+    }
+    g_num_watches -= entry->numWatches;
+    g_num_entries--;
+    free(entry->watches);
+    free(entry->pkgname);
+    free(entry->key);
+    free(entry);
+}
+
+static void invalidate_package(const char *pkgname, userid_t userid)
+{
+    size_entry_t** link = &g_entries;
+    while (*link != NULL) {
+        size_entry_t* entry = *link;
+        if ((userid == (userid_t)-1 || entry->userid == userid)
+                && !strcmp(entry->pkgname, pkgname)) {
+            remove_entry(link);
+        } else {
+            link = &entry->next;
+        }
+    }
+}
+
+static void invalidate_all()
+{
+    while (g_entries != NULL) {
+        remove_entry(&g_entries);
+    }
+}
+
+static void invalidate_watch(int wd)
+{
+    size_entry_t** link = &g_entries;
+    while (*link != NULL) {
+        if (entry_has_watch(*link, wd)) {
+            remove_entry(link);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+}
+
+/* Drops the entries whose files changed since the last call. */
+static void process_events()
+{
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    if (g_inotify_fd < 0) {
+        return;
+    }
+
+    while ((len = read(g_inotify_fd, buf, sizeof(buf))) > 0) {
+        char* pos = buf;
+        while (pos < buf + len) {
+            const struct inotify_event* event = (const struct inotify_event*)pos;
+            if (event->mask & IN_Q_OVERFLOW) {
+                invalidate_all();
+            } else if (!(event->mask & IN_IGNORED)) {
+                invalidate_watch(event->wd);
+            }
+            pos += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+static int add_watch(size_entry_t* entry, const char* path)
+{
+    if (g_num_watches >= SIZE_INDEX_MAX_WATCHES) {
+        return -1;
+    }
+    int wd = inotify_add_watch(g_inotify_fd, path, SIZE_WATCH_MASK | IN_DONT_FOLLOW);
+    if (wd < 0) {
+        // Files that don't exist can only be created by commands that
+        // invalidate the index.
+        return errno == ENOENT ? 0 : -1;
+    }
+    if (entry_has_watch(entry, wd)) {
+        return 0;
+    }
+    if (entry->numWatches >= entry->availWatches) {
+        size_t newAvail = entry->availWatches < 16 ? 16 : entry->availWatches*2;
+        int* newWatches = (int*)realloc(entry->watches, newAvail*sizeof(int));
+        if (newWatches == NULL) {
+            return -1;
+        }
+        entry->availWatches = newAvail;
+        entry->watches = newWatches;
+    }
+    entry->watches[entry->numWatches++] = wd;
+    g_num_watches++;
+    return 0;
+}
+
+/* Watches path and all the directories below it. */
+static int add_tree_watches(size_entry_t* entry, char path[PATH_MAX])
+{
+    DIR *d;
+    struct dirent *de;
+    size_t len = strlen(path);
+    int res = 0;
+
+    if (add_watch(entry, path) < 0) {
+        return -1;
+    }
+
+    d = opendir(path);
+    if (d == NULL) {
+        return 0;
+    }
+    while (res == 0 && (de = readdir(d))) {
+        const char *name = de->d_name;
+        if (de->d_type != DT_DIR) {
+            continue;
+        }
+            /* always skip "." and ".." */
+        if (name[0] == '.') {
+            if (name[1] == 0) continue;
+            if ((name[1] == '.') && (name[2] == 0)) continue;
+        }
+        if ((size_t)snprintf(path + len, PATH_MAX - len, "/%s", name) >= PATH_MAX - len) {
+            res = -1;
+            break;
+        }
+        res = add_tree_watches(entry, path);
+    }
+    path[len] = 0;
+    closedir(d);
+    return res;
+}
+
+static char* make_key(const char *apkpath, const char *libdirpath,
+        const char *fwdlock_apkpath, const char *asecpath, const char *instruction_set)
+{
+    char* key = NULL;
+    if (asprintf(&key, "%s\n%s\n%s\n%s\n%s", apkpath, libdirpath ? libdirpath : "",
+            fwdlock_apkpath ? fwdlock_apkpath : "", asecpath ? asecpath : "",
+            instruction_set) < 0) {
+        return NULL;
+    }
+    return key;
+}
+
+int size_index_lookup(const char *pkgname, userid_t userid, const char *apkpath,
+        const char *libdirpath, const char *fwdlock_apkpath, const char *asecpath,
+        const char *instruction_set, size_info_t *sizes)
+{
+    size_entry_t* entry;
+    char* key;
+    int res = -1;
+
+    key = make_key(apkpath, libdirpath, fwdlock_apkpath, asecpath, instruction_set);
+    if (key == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&g_lock);
+    process_events();
+    for (entry = g_entries; entry != NULL; entry = entry->next) {
+        if (!entry->pending && entry->userid == userid
+                && !strcmp(entry->pkgname, pkgname) && !strcmp(entry->key, key)) {
+            *sizes = entry->sizes;
+            res = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    free(key);
+    return res;
+}
+
+static unsigned watch_locked(const char *pkgname, userid_t userid, const char *apkpath,
+        const char *libdirpath, const char *fwdlock_apkpath, const char *asecpath,
+        const char *instruction_set)
+{
+    size_entry_t* entry;
+    char path[PATH_MAX];
+    int res = 0;
+
+    if (size_index_init() < 0) {
+        return 0;
+    }
+    invalidate_package(pkgname, userid);
+    if (g_num_entries >= SIZE_INDEX_MAX_ENTRIES) {
+        return 0;
+    }
+
+    entry = (size_entry_t*)calloc(1, sizeof(size_entry_t));
+    if (entry == NULL) {
+        return 0;
+    }
+    entry->userid = userid;
+    entry->pkgname = strdup(pkgname);
+    entry->key = make_key(apkpath, libdirpath, fwdlock_apkpath, asecpath, instruction_set);
+    if (++g_last_token == 0) {
+        g_last_token = 1;
+    }
+    entry->token = g_last_token;
+    entry->pending = 1;
+    entry->next = g_entries;
+    g_entries = entry;
+    g_num_entries++;
+    if (entry->pkgname == NULL || entry->key == NULL) {
+        remove_entry(&g_entries);
+        return 0;
+    }
+
+    // Watch everything get_size() is about to look at.
+    res |= add_watch(entry, apkpath);
+    if (fwdlock_apkpath != NULL && fwdlock_apkpath[0] != '!') {
+        res |= add_watch(entry, fwdlock_apkpath);
+    }
+    if (asecpath != NULL && asecpath[0] != '!') {
+        res |= add_watch(entry, asecpath);
+    }
+    if (!create_cache_path(path, apkpath, instruction_set)) {
+        res |= add_watch(entry, path);
+    }
+    if (res == 0 && libdirpath != NULL && libdirpath[0] != '!'
+            && strlen(libdirpath) < sizeof(path)) {
+        strcpy(path, libdirpath);
+        res = add_tree_watches(entry, path);
+    }
+    if (res == 0 && !create_pkg_path(path, pkgname, PKG_DIR_POSTFIX, userid)) {
+        res = add_tree_watches(entry, path);
+    }
+
+    if (res != 0) {
+        // Too large to watch, it will be scanned every time.
+        remove_entry(&g_entries);
+        return 0;
+    }
+    return entry->token;
+}
+
+unsigned size_index_watch(const char *pkgname, userid_t userid, const char *apkpath,
+        const char *libdirpath, const char *fwdlock_apkpath, const char *asecpath,
+        const char *instruction_set)
+{
+    unsigned token;
+
+    pthread_mutex_lock(&g_lock);
+    token = watch_locked(pkgname, userid, apkpath, libdirpath, fwdlock_apkpath, asecpath,
+            instruction_set);
+    pthread_mutex_unlock(&g_lock);
+    return token;
+}
+
+void size_index_store(unsigned token, const size_info_t *sizes)
+{
+    size_entry_t* entry;
+
+    if (token == 0) {
+        return;
+    }
+    pthread_mutex_lock(&g_lock);
+    // An event since size_index_watch() has dropped the entry.
+    process_events();
+    for (entry = g_entries; entry != NULL; entry = entry->next) {
+        if (entry->pending && entry->token == token) {
+            entry->sizes = *sizes;
+            entry->pending = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+void size_index_invalidate(const char *pkgname, userid_t userid)
+{
+    pthread_mutex_lock(&g_lock);
+    invalidate_package(pkgname, userid);
+    pthread_mutex_unlock(&g_lock);
+}
+
+void size_index_invalidate_all()
+{
+    pthread_mutex_lock(&g_lock);
+    invalidate_all();
+    pthread_mutex_unlock(&g_lock);
+}
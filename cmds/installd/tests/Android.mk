@@ -4,6 +4,7 @@ include $(CLEAR_VARS)
 
 # Build the unit tests.
 test_src_files := \
+    installd_size_index_test.cpp \
     installd_utils_test.cpp
 
 shared_libraries := \
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "size_index_test"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "installd.h"
+}
+
+#define TEST_DATA_DIR "/data/local/tmp/size_index_test/"
+#define TEST_PKG "com.example.sizes"
+#define TEST_PKG_DIR TEST_DATA_DIR "data/" TEST_PKG
+#define TEST_APK TEST_DATA_DIR "base.apk"
+
+namespace android {
+
+class SizeIndexTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        android_data_dir.path = TEST_DATA_DIR;
+        android_data_dir.len = strlen(TEST_DATA_DIR);
+
+        mkdir(TEST_DATA_DIR, 0700);
+        mkdir(TEST_DATA_DIR "data", 0700);
+        mkdir(TEST_PKG_DIR, 0700);
+        mkdir(TEST_PKG_DIR "/files", 0700);
+        touch(TEST_APK);
+
+        memset(&mSizes, 0, sizeof(mSizes));
+        mSizes.codesize = 1234;
+        mSizes.datasize = 5678;
+    }
+
+    virtual void TearDown() {
+        size_index_invalidate_all();
+        unlink(TEST_PKG_DIR "/files/new");
+        rmdir(TEST_PKG_DIR "/files");
+        rmdir(TEST_PKG_DIR);
+        rmdir(TEST_DATA_DIR "data");
+        unlink(TEST_APK);
+        rmdir(TEST_DATA_DIR);
+    }
+
+    static void touch(const char* path) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        ASSERT_GE(fd, 0) << "couldn't create " << path;
+        close(fd);
+    }
+
+    static unsigned watch() {
+        return size_index_watch(TEST_PKG, 0, TEST_APK, NULL, NULL, NULL, "arm");
+    }
+
+    static int lookup(size_info_t* sizes) {
+        return size_index_lookup(TEST_PKG, 0, TEST_APK, NULL, NULL, NULL, "arm", sizes);
+    }
+
+    size_info_t mSizes;
+};
+
+TEST_F(SizeIndexTest, StoredSizesAreFound) {
+    size_info_t sizes;
+    EXPECT_NE(0, lookup(&sizes));
+
+    unsigned token = watch();
+    ASSERT_NE(0U, token);
+    EXPECT_NE(0, lookup(&sizes))
+            << "Sizes shouldn't be found before they are stored";
+
+    size_index_store(token, &mSizes);
+    ASSERT_EQ(0, lookup(&sizes));
+    EXPECT_EQ(mSizes.codesize, sizes.codesize);
+    EXPECT_EQ(mSizes.datasize, sizes.datasize);
+}
+
+TEST_F(SizeIndexTest, ChangeDuringScanIsNotLost) {
+    size_info_t sizes;
+    unsigned token = watch();
+    ASSERT_NE(0U, token);
+
+    // A file created while get_size() is scanning the package.
+    touch(TEST_PKG_DIR "/files/new");
+
+    size_index_store(token, &mSizes);
+    EXPECT_NE(0, lookup(&sizes))
+            << "Sizes scanned while the package changed shouldn't be stored";
+}
+
+TEST_F(SizeIndexTest, ChangeAfterStoreDropsSizes) {
+    size_info_t sizes;
+    size_index_store(watch(), &mSizes);
+    ASSERT_EQ(0, lookup(&sizes));
+
+    touch(TEST_PKG_DIR "/files/new");
+    EXPECT_NE(0, lookup(&sizes));
+}
+
+TEST_F(SizeIndexTest, InvalidatedPackageIsNotStored) {
+    size_info_t sizes;
+    unsigned token = watch();
+    ASSERT_NE(0U, token);
+
+    size_index_invalidate(TEST_PKG, 0);
+    size_index_store(token, &mSizes);
+    EXPECT_NE(0, lookup(&sizes));
+}
+
+}
@@ -480,4 +480,62 @@ TEST_F(UtilsTest, AppendAndIncrement_TooBig) {
             << "String should fail because it's too large to fit";
 }
 
+TEST_F(UtilsTest, CacheHeap_KeepsOldest) {
+    cache_heap_t heap;
+    const time_t modTimes[] = { 50, 10, 40, 20, 60, 5, 30 };
+    char path[16];
+
+    ASSERT_EQ(0, cache_heap_init(&heap, 3))
+            << "Heap should be allocated";
+
+    for (size_t i = 0; i < sizeof(modTimes)/sizeof(modTimes[0]); i++) {
+        snprintf(path, sizeof(path), "/cache/%d", (int) modTimes[i]);
+        cache_heap_offer(&heap, modTimes[i], i, path);
+    }
+
+    EXPECT_EQ(3U, heap.count)
+            << "Heap should be bounded by its capacity";
+
+    EXPECT_EQ(0, cache_heap_offer(&heap, 100, 0, "/cache/100"))
+            << "Newer files should be dropped when the heap is full";
+
+    cache_heap_sort(&heap);
+
+    EXPECT_EQ(5, heap.entries[0].modTime);
+    EXPECT_STREQ("/cache/5", heap.entries[0].path);
+    EXPECT_EQ(5U, heap.entries[0].root);
+    EXPECT_EQ(10, heap.entries[1].modTime);
+    EXPECT_EQ(20, heap.entries[2].modTime)
+            << "Files should be sorted from the oldest";
+
+    cache_heap_destroy(&heap);
+}
+
+TEST_F(UtilsTest, DexoptSchedLimit) {
+    const int64_t MB = 1024 * 1024;
+    int threads;
+
+    EXPECT_EQ(3, dexopt_sched_limit(8, 2048 * MB, 256 * MB, 0, &threads))
+            << "Eight cores should run at most three compilers";
+    EXPECT_EQ(2, threads);
+
+    EXPECT_EQ(2, dexopt_sched_limit(4, -1, 256 * MB, 0, &threads))
+            << "Memory should be ignored when it is unknown";
+    EXPECT_EQ(2, threads);
+
+    EXPECT_EQ(1, dexopt_sched_limit(8, 300 * MB, 256 * MB, 0, &threads))
+            << "Compilers should be limited by the available memory";
+    EXPECT_EQ(8, threads);
+
+    EXPECT_EQ(1, dexopt_sched_limit(8, 100 * MB, 256 * MB, 0, &threads))
+            << "One compiler should always be allowed";
+
+    EXPECT_EQ(1, dexopt_sched_limit(8, 2048 * MB, 256 * MB, 1, &threads))
+            << "A hot device should run a single compiler";
+    EXPECT_EQ(8, threads);
+
+    EXPECT_EQ(1, dexopt_sched_limit(1, 2048 * MB, 256 * MB, 0, &threads));
+    EXPECT_EQ(1, threads);
+}
+
 }
@@ -14,6 +14,11 @@
 ** limitations under the License.
 */
 
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/xattr.h>
+
 #include "installd.h"
 
 #define CACHE_NOISY(x) //x
@@ -336,6 +341,146 @@ static int _copy_owner_permissions(int srcfd, int dstfd)
     return 0;
 }
 
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+#define COPY_CHUNK (1024 * 1024)   /* sendfile() is interrupted in between */
+
+/*
+ * Copies the contents of srcfd to dstfd without going through user space
+ * when the kernel can: first as a reflink sharing the blocks if both files
+ * are on the same copy-on-write filesystem, then with sendfile(). Falls back
+ * to read() and write() for the filesystems supporting neither.
+ */
+int copy_file_contents(int srcfd, int dstfd)
+{
+    struct stat st;
+    off_t offset = 0;
+    ssize_t size;
+    char buf[65536];
+
+    if (fstat(srcfd, &st) != 0) {
+        return -1;
+    }
+    if (ioctl(dstfd, FICLONE, srcfd) == 0) {
+        return 0;
+    }
+
+    while (offset < st.st_size) {
+        off_t left = st.st_size - offset;
+        size = sendfile(dstfd, srcfd, &offset, left > COPY_CHUNK ? COPY_CHUNK : left);
+        if (size < 0) {
+            if (errno == EINTR) continue;
+            if (offset == 0 && (errno == EINVAL || errno == ENOSYS)) break;
+            return -1;
+        }
+        if (size == 0) {
+            /* the file was truncated while we copied it */
+            return 0;
+        }
+    }
+    if (offset > 0 || st.st_size == 0) {
+        return 0;
+    }
+
+    while ((size = read(srcfd, buf, sizeof(buf))) != 0) {
+        ssize_t written = 0;
+        if (size < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (written < size) {
+            ssize_t n = write(dstfd, buf + written, size - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            written += n;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Copies the extended attributes of srcfd to dstfd, except the security
+ * labels which are set for the destination by the policy.
+ */
+int copy_file_xattrs(int srcfd, int dstfd)
+{
+    char names[1024];
+    char value[1024];
+    ssize_t len = flistxattr(srcfd, names, sizeof(names));
+    const char *name;
+    int res = 0;
+
+    if (len < 0) {
+        return (errno == ENOTSUP) ? 0 : -1;
+    }
+    for (name = names; name < names + len; name += strlen(name) + 1) {
+        ssize_t size;
+        if (!strncmp(name, "security.", 9)) {
+            continue;
+        }
+        size = fgetxattr(srcfd, name, value, sizeof(value));
+        if (size < 0 || fsetxattr(dstfd, name, value, size, 0) != 0) {
+            ALOGW("Couldn't copy xattr %s: %s\n", name, strerror(errno));
+            res = -1;
+        }
+    }
+    return res;
+}
+
+/*
+ * Copies the regular file src to the new file dst, with its mode, extended
+ * attributes and times, owned by owner and group. Used when a file can't be
+ * renamed because it moves to another filesystem.
+ */
+int copy_file(const char *src, const char *dst, uid_t owner, gid_t group)
+{
+    struct stat st;
+    struct timespec times[2];
+    int srcfd, dstfd;
+    int res = -1;
+
+    srcfd = open(src, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (srcfd < 0) {
+        ALOGW("Couldn't open %s: %s\n", src, strerror(errno));
+        return -1;
+    }
+    if (fstat(srcfd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ALOGW("Not copying %s, not a regular file\n", src);
+        close(srcfd);
+        return -1;
+    }
+    dstfd = open(dst, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (dstfd < 0) {
+        ALOGW("Couldn't create %s: %s\n", dst, strerror(errno));
+        close(srcfd);
+        return -1;
+    }
+
+    if (copy_file_contents(srcfd, dstfd) != 0) {
+        ALOGE("Couldn't copy %s to %s: %s\n", src, dst, strerror(errno));
+    } else if (fchown(dstfd, owner, group) != 0
+            || fchmod(dstfd, st.st_mode & 07777) != 0) {
+        ALOGE("Couldn't set the owner of %s: %s\n", dst, strerror(errno));
+    } else {
+        copy_file_xattrs(srcfd, dstfd);
+        times[0] = st.st_atim;
+        times[1] = st.st_mtim;
+        futimens(dstfd, times);
+        res = 0;
+    }
+
+    close(dstfd);
+    close(srcfd);
+    if (res != 0) {
+        unlink(dst);
+    }
+    return res;
+}
+
 static int _copy_dir_files(int sdfd, int ddfd, uid_t owner, gid_t group)
 {
     int result = 0;
@@ -370,14 +515,11 @@ static int _copy_dir_files(int sdfd, int ddfd, uid_t owner, gid_t group)
                 ALOGE("Failed to change file owner\n");
             }
 
-            char buf[8192];
-            ssize_t size;
-            while ((size = read(fsfd, buf, sizeof(buf))) > 0) {
-                write(fdfd, buf, size);
-            }
-            if (size < 0) {
+            if (copy_file_contents(fsfd, fdfd) != 0) {
                 ALOGW("Couldn't copy %s: %s\n", name, strerror(errno));
                 result = -1;
+            } else {
+                copy_file_xattrs(fsfd, fdfd);
             }
         }
         close(fdfd);
@@ -905,6 +1047,502 @@ void finish_cache_collection(cache_t* cache)
     free(cache);
 }
 
+/*
+ * Streaming cache collection: instead of recording every cache file, each
+ * pass walks the cache directories in parallel and only keeps the
+ * CACHE_STREAM_BATCH oldest files, which are then deleted oldest first.
+ * Passes are repeated until enough space is free or no file is left.
+ */
+
+#define CACHE_STREAM_BATCH 16384
+#define CACHE_STREAM_MAX_THREADS 4
+
+int cache_heap_init(cache_heap_t* heap, size_t capacity)
+{
+    heap->count = 0;
+    heap->capacity = capacity;
+    heap->entries = (cache_entry_t*)malloc(capacity*sizeof(cache_entry_t));
+    return heap->entries != NULL ? 0 : -1;
+}
+
+static void _cache_heap_sift_down(cache_entry_t* entries, size_t count, size_t i)
+{
+    for (;;) {
+        size_t largest = i;
+        size_t l = 2*i + 1;
+        size_t r = l + 1;
+        if (l < count && entries[l].modTime > entries[largest].modTime) {
+            largest = l;
+        }
+        if (r < count && entries[r].modTime > entries[largest].modTime) {
+            largest = r;
+        }
+        if (largest == i) {
+            return;
+        }
+        cache_entry_t tmp = entries[i];
+        entries[i] = entries[largest];
+        entries[largest] = tmp;
+        i = largest;
+    }
+}
+
+/* Returns 1 if the file is one of the oldest offered so far, 0 if it was
+   dropped, -1 on allocation failure. */
+int cache_heap_offer(cache_heap_t* heap, time_t modTime, size_t root, const char* path)
+{
+    cache_entry_t* entries = heap->entries;
+    if (heap->count == heap->capacity) {
+        if (heap->capacity == 0 || modTime >= entries[0].modTime) {
+            return 0;
+        }
+        char* copy = strdup(path);
+        if (copy == NULL) {
+            return -1;
+        }
+        // Replace the newest file.
+        free(entries[0].path);
+        entries[0].modTime = modTime;
+        entries[0].root = root;
+        entries[0].path = copy;
+        _cache_heap_sift_down(entries, heap->count, 0);
+        return 1;
+    }
+
+    char* copy = strdup(path);
+    if (copy == NULL) {
+        return -1;
+    }
+    size_t i = heap->count++;
+    while (i > 0 && entries[(i-1)/2].modTime < modTime) {
+        entries[i] = entries[(i-1)/2];
+        i = (i-1)/2;
+    }
+    entries[i].modTime = modTime;
+    entries[i].root = root;
+    entries[i].path = copy;
+    return 1;
+}
+
+/* Sorts the files from the oldest to the newest, the heap can't be offered
+   files anymore. */
+void cache_heap_sort(cache_heap_t* heap)
+{
+    size_t n = heap->count;
+    while (n > 1) {
+        cache_entry_t tmp = heap->entries[0];
+        heap->entries[0] = heap->entries[n-1];
+        heap->entries[n-1] = tmp;
+        n--;
+        _cache_heap_sift_down(heap->entries, n, 0);
+    }
+}
+
+void cache_heap_destroy(cache_heap_t* heap)
+{
+    size_t i;
+    for (i=0; i<heap->count; i++) {
+        free(heap->entries[i].path);
+    }
+    free(heap->entries);
+    heap->entries = NULL;
+    heap->count = 0;
+    heap->capacity = 0;
+}
+
+cache_stream_t* start_cache_stream()
+{
+    cache_stream_t* stream = (cache_stream_t*)calloc(1, sizeof(cache_stream_t));
+    return stream;
+}
+
+static void _add_cache_root(cache_stream_t* stream, const char* path)
+{
+    if (stream->numRoots >= stream->availRoots) {
+        size_t newAvail = stream->availRoots < 64 ? 64 : stream->availRoots*2;
+        char** newRoots = (char**)realloc(stream->roots, newAvail*sizeof(char*));
+        if (newRoots == NULL) {
+            ALOGE("Failure growing cache roots array for %s\n", path);
+            return;
+        }
+        stream->availRoots = newAvail;
+        stream->roots = newRoots;
+    }
+    char* root = strdup(path);
+    if (root == NULL) {
+        ALOGE("Failure allocating cache root %s\n", path);
+        return;
+    }
+    stream->roots[stream->numRoots++] = root;
+}
+
+/* Same directories as add_cache_files(), without walking them. */
+void add_cache_roots(cache_stream_t* stream, const char *basepath, const char *cachedir)
+{
+    DIR *d;
+    struct dirent *de;
+    char dirname[PATH_MAX];
+    size_t baseLen = strlen(basepath);
+    const char* sep = (baseLen > 0 && basepath[baseLen-1] == '/') ? "" : "/";
+
+    d = opendir(basepath);
+    if (d == NULL) {
+        return;
+    }
+
+    while ((de = readdir(d))) {
+        if (de->d_type == DT_DIR) {
+            const char *name = de->d_name;
+            size_t len;
+
+                /* always skip "." and ".." */
+            if (name[0] == '.') {
+                if (name[1] == 0) continue;
+                if ((name[1] == '.') && (name[2] == 0)) continue;
+            }
+
+            if (cachedir != NULL) {
+                len = snprintf(dirname, sizeof(dirname), "%s%s%s/%s", basepath, sep,
+                        name, cachedir);
+            } else {
+                len = snprintf(dirname, sizeof(dirname), "%s%s%s", basepath, sep, name);
+            }
+            if (len < sizeof(dirname)) {
+                _add_cache_root(stream, dirname);
+            }
+        }
+    }
+
+    closedir(d);
+}
+
+typedef struct {
+    cache_stream_t* stream;
+    volatile int32_t* nextRoot;
+    cache_heap_t heap;
+    size_t numFiles;
+    int failed;
+} cache_walker_t;
+
+/*
+ * Offers the files below the directory open as dfd, whose path is in
+ * path[0..pathLen), to the walker's heap. Directories left without any
+ * non hidden entries are deleted along with their hidden files, as
+ * delete_cache_dir() does. Returns the number of non hidden entries left,
+ * and takes ownership of dfd.
+ */
+static size_t _stream_cache_dir(cache_walker_t* w, size_t root, int dfd,
+        char path[PATH_MAX], size_t pathLen)
+{
+    DIR* d;
+    struct dirent *de;
+    size_t children = 0;
+
+    d = fdopendir(dfd);
+    if (d == NULL) {
+        ALOGE("Couldn't fdopendir %s: %s\n", path, strerror(errno));
+        close(dfd);
+        return 1;
+    }
+
+    while ((de = readdir(d))) {
+        const char *name = de->d_name;
+        unsigned char type = de->d_type;
+        struct stat s;
+        int haveStat = 0;
+
+            /* always skip "." and ".." */
+        if (name[0] == '.') {
+            if (name[1] == 0) continue;
+            if ((name[1] == '.') && (name[2] == 0)) continue;
+        }
+
+        if (type == DT_UNKNOWN) {
+            if (fstatat(dfd, name, &s, AT_SYMLINK_NOFOLLOW) < 0) {
+                continue;
+            }
+            haveStat = 1;
+            type = S_ISDIR(s.st_mode) ? DT_DIR : (S_ISREG(s.st_mode) ? DT_REG : DT_UNKNOWN);
+        }
+
+        size_t finallen = snprintf(path + pathLen, PATH_MAX - pathLen, "/%s", name);
+        if (finallen >= PATH_MAX - pathLen) {
+            // Whoops, the final path is too long!  We'll just delete it.
+            path[pathLen] = 0;
+            ALOGW("Cache entry %s truncated in path %s; deleting\n", name, path);
+            if (type == DT_DIR) {
+                delete_dir_contents_fd(dfd, name);
+            }
+            if (unlinkat(dfd, name, type == DT_DIR ? AT_REMOVEDIR : 0) < 0) {
+                ALOGE("Couldn't unlinkat %s: %s\n", name, strerror(errno));
+            }
+            continue;
+        }
+
+        if (type == DT_DIR) {
+            int subfd = openat(dfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (subfd < 0) {
+                ALOGE("Couldn't openat %s: %s\n", path, strerror(errno));
+                children++;
+                continue;
+            }
+            if (_stream_cache_dir(w, root, subfd, path, pathLen + finallen) > 0) {
+                children++;
+            } else {
+                ALOGI("DEL DIR %s\n", path);
+                if (delete_dir_contents_fd(dfd, name) == 0 &&
+                        unlinkat(dfd, name, AT_REMOVEDIR) < 0) {
+                    ALOGE("Couldn't unlinkat %s: %s\n", path, strerror(errno));
+                    children++;
+                }
+            }
+        } else if (type == DT_REG) {
+            // Skip files that start with '.'; they will be deleted if
+            // their entire directory is deleted.
+            if (name[0] == '.') {
+                continue;
+            }
+            children++;
+            if (!haveStat && fstatat(dfd, name, &s, AT_SYMLINK_NOFOLLOW) < 0) {
+                ALOGW("Unable to stat cache file %s; deleting\n", path);
+                if (unlinkat(dfd, name, 0) < 0) {
+                    ALOGE("Couldn't unlink %s: %s\n", path, strerror(errno));
+                }
+                continue;
+            }
+            w->numFiles++;
+            if (cache_heap_offer(&w->heap, s.st_mtime, root, path) < 0) {
+                w->failed = 1;
+            }
+        }
+    }
+    path[pathLen] = 0;
+
+    closedir(d);
+    return children;
+}
+
+static void* _cache_walker_thread(void* arg)
+{
+    cache_walker_t* w = (cache_walker_t*)arg;
+    cache_stream_t* stream = w->stream;
+    char path[PATH_MAX];
+
+    for (;;) {
+        size_t root = (size_t)__sync_fetch_and_add(w->nextRoot, 1);
+        if (root >= stream->numRoots) {
+            break;
+        }
+        int dfd = open(stream->roots[root], O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (dfd < 0) {
+            continue;
+        }
+        strcpy(path, stream->roots[root]);
+        if (_stream_cache_dir(w, root, dfd, path, strlen(path)) == 0) {
+            // This is a root directory, get rid of any hidden files but
+            // not of the directory itself.
+            delete_dir_contents(stream->roots[root], 0, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* Walks all the cache directories and keeps the oldest files in heap,
+   returns the total number of files found or -1 on error. */
+static ssize_t _collect_oldest_cache_files(cache_stream_t* stream, cache_heap_t* heap)
+{
+    cache_walker_t walkers[CACHE_STREAM_MAX_THREADS];
+    pthread_t threads[CACHE_STREAM_MAX_THREADS];
+    volatile int32_t nextRoot = 0;
+    size_t numThreads, started, i, j;
+    ssize_t numFiles = 0;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    numThreads = cpus > CACHE_STREAM_MAX_THREADS ? CACHE_STREAM_MAX_THREADS :
+            (cpus > 0 ? (size_t)cpus : 1);
+    if (numThreads > stream->numRoots) {
+        numThreads = stream->numRoots > 0 ? stream->numRoots : 1;
+    }
+
+    for (i=0; i<numThreads; i++) {
+        walkers[i].stream = stream;
+        walkers[i].nextRoot = &nextRoot;
+        walkers[i].numFiles = 0;
+        walkers[i].failed = 0;
+        if (cache_heap_init(&walkers[i].heap, CACHE_STREAM_BATCH) < 0) {
+            break;
+        }
+    }
+    numThreads = i;
+    if (numThreads == 0) {
+        return -1;
+    }
+
+    // The calling thread is the first walker.
+    for (started=1; started<numThreads; started++) {
+        if (pthread_create(&threads[started], NULL, _cache_walker_thread,
+                &walkers[started]) != 0) {
+            break;
+        }
+    }
+    _cache_walker_thread(&walkers[0]);
+    for (i=1; i<started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (i=0; i<numThreads; i++) {
+        cache_walker_t* w = &walkers[i];
+        for (j=0; j<w->heap.count; j++) {
+            cache_entry_t* e = &w->heap.entries[j];
+            if (cache_heap_offer(heap, e->modTime, e->root, e->path) < 0) {
+                w->failed = 1;
+            }
+        }
+        if (w->failed) {
+            numFiles = -1;
+        } else if (numFiles >= 0) {
+            numFiles += w->numFiles;
+        }
+        cache_heap_destroy(&w->heap);
+    }
+    return numFiles;
+}
+
+typedef struct {
+    char* path;
+    size_t root;
+} cache_pruned_dir_t;
+
+static int _cmp_cache_dirs(const void *lhsP, const void *rhsP)
+{
+    return strcmp(((const cache_pruned_dir_t*)lhsP)->path,
+            ((const cache_pruned_dir_t*)rhsP)->path);
+}
+
+/* Deletes the directory that was left without non hidden files, and its
+   parents up to its cache directory. */
+static void _prune_cache_dir(cache_stream_t* stream, const cache_pruned_dir_t* dir)
+{
+    size_t rootLen = strlen(stream->roots[dir->root]);
+    char path[PATH_MAX];
+
+    strcpy(path, dir->path);
+    while (strlen(path) > rootLen) {
+        DIR* d = opendir(path);
+        struct dirent *de;
+        int empty = 1;
+        if (d == NULL) {
+            return;
+        }
+        while (empty && (de = readdir(d))) {
+            const char *name = de->d_name;
+            if (de->d_type == DT_DIR) {
+                if (name[0] == '.' && (name[1] == 0 ||
+                        (name[1] == '.' && name[2] == 0))) {
+                    continue;
+                }
+                empty = 0;
+            } else if (de->d_type == DT_REG && name[0] != '.') {
+                empty = 0;
+            }
+        }
+        closedir(d);
+        if (!empty) {
+            return;
+        }
+        ALOGI("DEL DIR %s\n", path);
+        if (delete_dir_contents(path, 1, NULL)) {
+            return;
+        }
+        *strrchr(path, '/') = 0;
+    }
+}
+
+void clear_cache_files_streaming(cache_stream_t* stream, int64_t free_size)
+{
+    cache_heap_t heap;
+    ssize_t numFiles;
+    size_t i;
+    int skip = 0;
+
+    ALOGI("Streaming cache files from %zd directories", stream->numRoots);
+
+    for (;;) {
+        size_t numDeleted = 0;
+        size_t numDirs = 0;
+        cache_pruned_dir_t* dirs;
+
+        if (cache_heap_init(&heap, CACHE_STREAM_BATCH) < 0) {
+            ALOGE("Failure allocating cache heap\n");
+            return;
+        }
+        numFiles = _collect_oldest_cache_files(stream, &heap);
+        if (numFiles < 0) {
+            ALOGE("Failure collecting cache files\n");
+            cache_heap_destroy(&heap);
+            return;
+        }
+        ALOGI("Collected cache files: %zd files, trimming the oldest %zd",
+                numFiles, heap.count);
+        cache_heap_sort(&heap);
+
+        dirs = (cache_pruned_dir_t*)malloc(heap.count*sizeof(cache_pruned_dir_t));
+        for (i=0; i<heap.count; i++) {
+            skip++;
+            if (skip > 10) {
+                if (data_disk_free() > free_size) {
+                    break;
+                }
+                skip = 0;
+            }
+            cache_entry_t* file = &heap.entries[i];
+            ALOGI("DEL (mod %d) %s\n", (int)file->modTime, file->path);
+            if (unlink(file->path) < 0) {
+                ALOGE("Couldn't unlink %s: %s\n", file->path, strerror(errno));
+                continue;
+            }
+            numDeleted++;
+            if (dirs != NULL) {
+                // The entry is done with, keep its directory for pruning.
+                *strrchr(file->path, '/') = 0;
+                dirs[numDirs].path = file->path;
+                dirs[numDirs].root = file->root;
+                numDirs++;
+            }
+        }
+
+        if (dirs != NULL) {
+            // Children sort after their parents, so going backwards prunes
+            // the deepest directories first.
+            qsort(dirs, numDirs, sizeof(cache_pruned_dir_t), _cmp_cache_dirs);
+            for (i=numDirs; i>0; i--) {
+                if (i == 1 || strcmp(dirs[i-1].path, dirs[i-2].path)) {
+                    _prune_cache_dir(stream, &dirs[i-1]);
+                }
+            }
+            free(dirs);
+        }
+        cache_heap_destroy(&heap);
+
+        // Stop once every cache file was a candidate or nothing could be
+        // deleted, there is no point in walking the directories again.
+        if (data_disk_free() > free_size || numDeleted == 0 ||
+                (size_t)numFiles <= CACHE_STREAM_BATCH) {
+            return;
+        }
+    }
+}
+
+void finish_cache_stream(cache_stream_t* stream)
+{
+    size_t i;
+    for (i=0; i<stream->numRoots; i++) {
+        free(stream->roots[i]);
+    }
+    free(stream->roots);
+    free(stream);
+}
+
 /**
  * Validate that the path is valid in the context of the provided directory.
  * The path is allowed to have at most one subdirectory and no indirections
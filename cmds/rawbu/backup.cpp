@@ -12,6 +12,8 @@
 #include <assert.h>
 #include <ctype.h>
 #include <utime.h>
+#include <pthread.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <stdint.h>
@@ -30,19 +32,25 @@
 // Introduces backup all option to header.
 #define FILE_VERSION_2 0xffff0002
 
-#define FILE_VERSION FILE_VERSION_2
+// Adds the base of incremental backups to the header, the inode of files
+// and the nanoseconds of their mtime.
+#define FILE_VERSION_3 0xffff0003
+
+#define FILE_VERSION FILE_VERSION_3
 
 namespace android {
 
 static char nameBuffer[PATH_MAX];
 static struct stat statBuffer;
 
-static char copyBuffer[8192];
+static char copyBuffer[256*1024];
 static char *backupFilePath = NULL;
 
 static uint32_t inputFileVersion;
 
 static int opt_backupAll;
+static const char* opt_basePath;
+static int opt_jobs;
 
 #define SPECIAL_NO_TOUCH 0
 #define SPECIAL_NO_BACKUP 1
@@ -61,6 +69,86 @@ static const struct special_dir SKIP_PATHS[] = {
     { NULL, 0 },
 };
 
+/*
+ * Index of the files of a backup file and of the backups it is based on,
+ * by path. Incremental backups only write the files that changed since
+ * their base, and restores take the unchanged ones from the base.
+ */
+struct index_entry {
+    struct index_entry* next;
+    char* path;
+    FILE* fh;           // the backup file holding the contents
+    off_t offset;       // of the contents in fh
+    int64_t size;
+    int64_t mtime;      // in nanoseconds
+    int64_t ino;
+};
+
+#define INDEX_BUCKETS 65536
+#define MAX_BASE_DEPTH 16
+
+static struct index_entry* indexBuckets[INDEX_BUCKETS];
+
+// The backup files the index refers to, not to be wiped on restore.
+static char* indexFiles[MAX_BASE_DEPTH];
+static int numIndexFiles;
+
+static uint32_t hash_path(const char* path)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash = (hash ^ (unsigned char)*path++) * 16777619u;
+    }
+    return hash;
+}
+
+static struct index_entry* find_index_entry(const char* path)
+{
+    struct index_entry* e;
+    for (e = indexBuckets[hash_path(path) % INDEX_BUCKETS]; e; e = e->next) {
+        if (strcmp(e->path, path) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static struct index_entry* add_index_entry(const char* path)
+{
+    struct index_entry* e = find_index_entry(path);
+    if (e != NULL) {
+        return e;
+    }
+    e = (struct index_entry*)calloc(1, sizeof(*e));
+    if (e == NULL || (e->path = strdup(path)) == NULL) {
+        free(e);
+        return NULL;
+    }
+    uint32_t bucket = hash_path(path) % INDEX_BUCKETS;
+    e->next = indexBuckets[bucket];
+    indexBuckets[bucket] = e;
+    return e;
+}
+
+static int is_backup_file(const char* path)
+{
+    if (backupFilePath && strcmp(backupFilePath, path) == 0) {
+        return 1;
+    }
+    for (int i = 0; i < numIndexFiles; i++) {
+        if (strcmp(indexFiles[i], path) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int64_t mtime_ns(const struct stat* st)
+{
+    return ((int64_t)st->st_mtime)*1000*1000*1000 + st->st_mtim.tv_nsec;
+}
+
 /* This is just copied from the shell's built-in wipe command. */
 static int wipe (const char *path) 
 {
@@ -153,8 +241,8 @@ static int wipe (const char *path)
             strcat(nameBuffer, "/");
 
         } else {
-            // Don't delete the backup file
-            if (backupFilePath && strcmp(backupFilePath, nameBuffer) == 0) {
+            // Don't delete the backup file or the ones it is based on
+            if (is_backup_file(nameBuffer)) {
                 continue;
             }
             ret = unlink(nameBuffer);
@@ -229,9 +317,60 @@ static int copy_file(FILE* dest, FILE* src, off_t size, const char* destName,
     return 1;
 }
 
+// Copies size bytes of srcFd, from offset or from its current position if
+// offset is NULL, to the end of dest. The kernel copies the data when it
+// can, without going through copyBuffer.
+static int copy_fd(FILE* dest, int srcFd, off_t* offset, off_t size,
+        const char* destName, const char* srcName)
+{
+    if (fflush(dest) != 0) {
+        fprintf(stderr, "unable to write file '%s': %s\n",
+            destName ? destName : "backup", strerror(errno));
+        return 0;
+    }
+    int destFd = fileno(dest);
+    off_t origSize = size;
+    bool useSendfile = true;
+
+    while (size > 0) {
+        ssize_t len;
+        if (useSendfile) {
+            size_t amt = size > 0x40000000 ? 0x40000000 : (size_t)size;
+            len = sendfile(destFd, srcFd, offset, amt);
+            if (len < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                useSendfile = false;
+                continue;
+            }
+        } else {
+            size_t amt = size > (off_t)sizeof(copyBuffer) ? sizeof(copyBuffer) : (size_t)size;
+            len = offset ? pread(srcFd, copyBuffer, amt, *offset) : read(srcFd, copyBuffer, amt);
+            if (len > 0) {
+                if (write(destFd, copyBuffer, len) != len) {
+                    fprintf(stderr, "unable to write file '%s': %s\n",
+                        destName ? destName : "backup", strerror(errno));
+                    return 0;
+                }
+                if (offset) {
+                    *offset += len;
+                }
+            }
+        }
+        if (len <= 0) {
+            fprintf(stderr, "unable to copy (%ld of %ld bytes left) file '%s': %s\n",
+                (long)size, (long)origSize, srcName ? srcName : destName,
+                len < 0 ? strerror(errno) : "unexpected EOF");
+            return 0;
+        }
+        size -= len;
+    }
+    return 1;
+}
+
 #define TYPE_END 0
 #define TYPE_DIR 1
 #define TYPE_FILE 2
+// A file whose contents are in the base of an incremental backup.
+#define TYPE_UNCHANGED 3
 
 static int write_header(FILE* fh, int type, const char* path, const struct stat* st)
 {
@@ -247,7 +386,7 @@ static int write_header(FILE* fh, int type, const char* path, const struct stat*
     if (!write_int32(fh, st->st_gid)) return 0;
     if (!write_int32(fh, st->st_mode)) return 0;
     if (!write_int64(fh, ((int64_t)st->st_atime)*1000*1000*1000)) return 0;
-    if (!write_int64(fh, ((int64_t)st->st_mtime)*1000*1000*1000)) return 0;
+    if (!write_int64(fh, mtime_ns(st))) return 0;
     if (!write_int64(fh, ((int64_t)st->st_ctime)*1000*1000*1000)) return 0;
     
     return 1;
@@ -325,34 +464,50 @@ static int backup_dir(FILE* fh, const char* srcPath)
                 goto done;
             }
         } else if (S_ISREG(statBuffer.st_mode)) {
-            // Skip the backup file
-            if (backupFilePath && strcmp(fullPath, backupFilePath) == 0) {
-                printf("Skipping backup file %s...\n", backupFilePath);
+            // Skip the backup file and the ones it is based on
+            if (is_backup_file(fullPath)) {
+                printf("Skipping backup file %s...\n", fullPath);
+                continue;
+            }
+
+            // Files with the same size, mtime and inode as in the base are
+            // taken from there on restore.
+            off_t size = statBuffer.st_size;
+            struct index_entry* base = find_index_entry(fullPath);
+            if (base != NULL && base->size == size &&
+                    base->mtime == mtime_ns(&statBuffer) &&
+                    base->ino == (int64_t)statBuffer.st_ino) {
+                printf("Unchanged file %s...\n", fullPath);
+                if (write_header(fh, TYPE_UNCHANGED, fullPath, &statBuffer) == 0 ||
+                        !write_int64(fh, size) ||
+                        !write_int64(fh, statBuffer.st_ino)) {
+                    result = 0;
+                    goto done;
+                }
                 continue;
-            } else {
-                printf("Saving file %s...\n", fullPath);
             }
+
+            printf("Saving file %s...\n", fullPath);
             if (write_header(fh, TYPE_FILE, fullPath, &statBuffer) == 0) {
                 result = 0;
                 goto done;
             }
             
-            off_t size = statBuffer.st_size;
-            if (!write_int64(fh, size)) {
+            if (!write_int64(fh, size) || !write_int64(fh, statBuffer.st_ino)) {
                 result = 0;
                 goto done;
             }
             
-            FILE* src = fopen(fullPath, "r");
-            if (src == NULL) {
+            int src = open(fullPath, O_RDONLY);
+            if (src < 0) {
                 fprintf(stderr, "unable to open source file '%s': %s\n",
                     fullPath, strerror(errno));
                 result = 0;
                 goto done;
             }
             
-            int copyres = copy_file(fh, src, size, NULL, fullPath);
-            fclose(src);
+            int copyres = copy_fd(fh, src, NULL, size, NULL, fullPath);
+            close(src);
             if (!copyres) {
                 result = 0;
                 goto done;
@@ -370,9 +525,138 @@ done:
     return result;
 }
 
+/*
+ * With -j, threads walk /data ahead of the backup and stat everything, so
+ * that the backup itself mostly finds the directories and inodes cached.
+ * This matters most for incremental backups, which spend their time
+ * checking files rather than copying them.
+ */
+static pthread_mutex_t prefetchLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prefetchCond = PTHREAD_COND_INITIALIZER;
+static char** prefetchDirs;
+static int prefetchNumDirs;
+static int prefetchMaxDirs;
+static int prefetchBusy;
+static bool prefetchStop;
+
+static void prefetch_push_locked(char* path)
+{
+    if (prefetchNumDirs == prefetchMaxDirs) {
+        int newMax = prefetchMaxDirs ? prefetchMaxDirs * 2 : 256;
+        char** dirs = (char**)realloc(prefetchDirs, newMax * sizeof(char*));
+        if (dirs == NULL) {
+            free(path);
+            return;
+        }
+        prefetchDirs = dirs;
+        prefetchMaxDirs = newMax;
+    }
+    prefetchDirs[prefetchNumDirs++] = path;
+    pthread_cond_signal(&prefetchCond);
+}
+
+static void* prefetch_thread(void*)
+{
+    pthread_mutex_lock(&prefetchLock);
+    for (;;) {
+        while (prefetchNumDirs == 0 && prefetchBusy > 0 && !prefetchStop) {
+            pthread_cond_wait(&prefetchCond, &prefetchLock);
+        }
+        if (prefetchNumDirs == 0 || prefetchStop) {
+            // Done, wake up the others so that they see it too.
+            pthread_cond_broadcast(&prefetchCond);
+            break;
+        }
+        char* path = prefetchDirs[--prefetchNumDirs];
+        prefetchBusy++;
+        pthread_mutex_unlock(&prefetchLock);
+
+        DIR* dir = opendir(path);
+        struct dirent* de;
+        while (dir != NULL && (de = readdir(dir)) != NULL) {
+            if (0 == strcmp(de->d_name, ".")
+                    || 0 == strcmp(de->d_name, "..")
+                    || 0 == strcmp(de->d_name, "lost+found")) {
+                continue;
+            }
+            char* fullPath;
+            if (asprintf(&fullPath, "%s/%s", path, de->d_name) < 0) {
+                continue;
+            }
+            struct stat st;
+            if (lstat(fullPath, &st) == 0 && S_ISDIR(st.st_mode)) {
+                pthread_mutex_lock(&prefetchLock);
+                prefetch_push_locked(fullPath);
+                pthread_mutex_unlock(&prefetchLock);
+            } else {
+                free(fullPath);
+            }
+        }
+        if (dir != NULL) {
+            closedir(dir);
+        }
+        free(path);
+
+        pthread_mutex_lock(&prefetchLock);
+        prefetchBusy--;
+        if (prefetchBusy == 0 && prefetchNumDirs == 0) {
+            pthread_cond_broadcast(&prefetchCond);
+        }
+    }
+    pthread_mutex_unlock(&prefetchLock);
+    return NULL;
+}
+
+static int start_prefetch(const char* path, pthread_t* threads, int numThreads)
+{
+    int started = 0;
+    char* root = strdup(path);
+    if (root == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&prefetchLock);
+    prefetch_push_locked(root);
+    pthread_mutex_unlock(&prefetchLock);
+    while (started < numThreads &&
+            pthread_create(&threads[started], NULL, prefetch_thread, NULL) == 0) {
+        started++;
+    }
+    return started;
+}
+
+static void stop_prefetch(pthread_t* threads, int numThreads)
+{
+    pthread_mutex_lock(&prefetchLock);
+    prefetchStop = true;
+    pthread_cond_broadcast(&prefetchCond);
+    pthread_mutex_unlock(&prefetchLock);
+    for (int i = 0; i < numThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    while (prefetchNumDirs > 0) {
+        free(prefetchDirs[--prefetchNumDirs]);
+    }
+}
+
+static int build_index(const char* path, int depth);
+
 static int backup_data(const char* destPath)
 {
     int res = -1;
+    int basePathLen = opt_basePath ? strlen(opt_basePath) : 0;
+    pthread_t* prefetchThreads = NULL;
+    int numPrefetchThreads = 0;
+
+    if (opt_basePath) {
+        if (strcmp(opt_basePath, destPath) == 0) {
+            fprintf(stderr, "the base can't be the destination '%s'\n", destPath);
+            return -1;
+        }
+        printf("Reading base %s...\n", opt_basePath);
+        if (build_index(opt_basePath, 0) != 0) {
+            return -1;
+        }
+    }
     
     FILE* fh = fopen(destPath, "w");
     if (fh == NULL) {
@@ -386,14 +670,28 @@ static int backup_data(const char* destPath)
     // The path that shouldn't be backed up
     backupFilePath = strdup(destPath);
 
+    if (opt_jobs > 1) {
+        prefetchThreads = (pthread_t*)malloc(opt_jobs * sizeof(pthread_t));
+        if (prefetchThreads != NULL) {
+            numPrefetchThreads = start_prefetch("/data", prefetchThreads, opt_jobs);
+        }
+    }
+
     if (!write_int32(fh, FILE_VERSION)) goto done;
     if (!write_int32(fh, opt_backupAll)) goto done;
+    if (!write_int32(fh, basePathLen)) goto done;
+    if (basePathLen > 0 &&
+            fwrite(opt_basePath, 1, basePathLen, fh) != (size_t)basePathLen) goto done;
     if (!backup_dir(fh, "/data")) goto done;
     if (!write_int32(fh, 0)) goto done;
     
     res = 0;
     
 done:
+    if (prefetchThreads != NULL) {
+        stop_prefetch(prefetchThreads, numPrefetchThreads);
+        free(prefetchThreads);
+    }
     if (fflush(fh) != 0) {
         fprintf(stderr, "error flushing destination '%s': %s\n",
             destPath, strerror(errno));
@@ -435,7 +733,8 @@ static int64_t read_int64(FILE* fh, int64_t defVal)
     return val;
 }
 
-static int read_header(FILE* fh, int* type, char** path, struct stat* st)
+// mtime, if not NULL, is set to the mtime in nanoseconds.
+static int read_header(FILE* fh, int* type, char** path, struct stat* st, int64_t* mtime)
 {
     *type = read_int32(fh, -1);
     if (*type == TYPE_END) {
@@ -488,6 +787,9 @@ static int read_header(FILE* fh, int* type, char** path, struct stat* st)
         return 0;
     }
     st->st_mtime = (time_t)(ltime/1000/1000/1000);
+    if (mtime != NULL) {
+        *mtime = ltime;
+    }
     ltime = read_int64(fh, -1);
     if (ltime < 0) {
         fprintf(stderr, "bad ctime in restore file at '%s'\n", readPath);
@@ -500,6 +802,125 @@ static int read_header(FILE* fh, int* type, char** path, struct stat* st)
     return 1;
 }
 
+// Reads the version and the header fields that follow it, and returns the
+// base of the backup in basePath, NULL if it isn't incremental.
+static int read_file_header(FILE* fh, const char* path, uint32_t* version,
+        int* backupAll, char** basePath)
+{
+    *version = read_int32(fh, 0);
+    if (*version < FILE_VERSION_1 || *version > FILE_VERSION) {
+        fprintf(stderr, "Backup file '%s' has bad version: 0x%x\n", path, *version);
+        return 0;
+    }
+    *backupAll = *version >= FILE_VERSION_2 ? read_int32(fh, 0) : 0;
+    *basePath = NULL;
+    if (*version >= FILE_VERSION_3) {
+        int32_t len = read_int32(fh, -1);
+        if (len < 0 || len >= PATH_MAX) {
+            fprintf(stderr, "bad base path length %d in '%s'\n", len, path);
+            return 0;
+        }
+        if (len > 0) {
+            *basePath = (char*)malloc(len + 1);
+            if (*basePath == NULL || fread(*basePath, 1, len, fh) != (size_t)len) {
+                fprintf(stderr, "truncated base path in '%s'\n", path);
+                free(*basePath);
+                *basePath = NULL;
+                return 0;
+            }
+            (*basePath)[len] = 0;
+        }
+    }
+    return 1;
+}
+
+// Adds the files of the backup at path, and of the backups it is based on,
+// to the index. The backup files are kept open for restore_data().
+static int build_index(const char* path, int depth)
+{
+    uint32_t version;
+    int backupAll;
+    char* basePath;
+    struct stat st;
+
+    if (depth >= MAX_BASE_DEPTH) {
+        fprintf(stderr, "too many incremental backups based on each other\n");
+        return -1;
+    }
+    FILE* fh = fopen(path, "r");
+    if (fh == NULL) {
+        fprintf(stderr, "unable to open base '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (!read_file_header(fh, path, &version, &backupAll, &basePath)) {
+        fclose(fh);
+        return -1;
+    }
+    if (basePath != NULL) {
+        int res = build_index(basePath, depth + 1);
+        free(basePath);
+        if (res != 0) {
+            fclose(fh);
+            return -1;
+        }
+    }
+    indexFiles[numIndexFiles++] = strdup(path);
+
+    for (;;) {
+        int type;
+        char* filePath = NULL;
+        int64_t mtime = 0;
+        if (read_header(fh, &type, &filePath, &st, &mtime) == 0) {
+            return -1;
+        }
+        if (type == TYPE_END) {
+            break;
+        }
+        if (type == TYPE_FILE || type == TYPE_UNCHANGED) {
+            int64_t size = read_int64(fh, -1);
+            int64_t ino = version >= FILE_VERSION_3 ? read_int64(fh, -1) : 0;
+            if (size < 0) {
+                fprintf(stderr, "bad file size in '%s'\n", path);
+                free(filePath);
+                return -1;
+            }
+            struct index_entry* e;
+            if (type == TYPE_FILE) {
+                e = add_index_entry(filePath);
+                if (e == NULL) {
+                    fprintf(stderr, "out of memory indexing '%s'\n", path);
+                    free(filePath);
+                    return -1;
+                }
+                e->fh = fh;
+                e->offset = ftello(fh);
+                e->size = size;
+                if (fseeko(fh, size, SEEK_CUR) != 0) {
+                    fprintf(stderr, "truncated backup file '%s'\n", path);
+                    free(filePath);
+                    return -1;
+                }
+            } else {
+                e = find_index_entry(filePath);
+                if (e == NULL || e->fh == NULL || e->size != size) {
+                    fprintf(stderr, "'%s' from '%s' is missing from its base\n",
+                        filePath, path);
+                    free(filePath);
+                    return -1;
+                }
+            }
+            e->mtime = mtime;
+            e->ino = ino;
+        } else if (type != TYPE_DIR) {
+            fprintf(stderr, "unknown node type %d in '%s'\n", type, path);
+            free(filePath);
+            return -1;
+        }
+        free(filePath);
+    }
+    return 0;
+}
+
 static int restore_data(const char* srcPath)
 {
     int res = -1;
@@ -511,16 +932,19 @@ static int restore_data(const char* srcPath)
         return -1;
     }
     
-    inputFileVersion = read_int32(fh, 0);
-    if (inputFileVersion < FILE_VERSION_1 || inputFileVersion > FILE_VERSION) {
-        fprintf(stderr, "Restore file has bad version: 0x%x\n", inputFileVersion);
+    char* basePath;
+    if (!read_file_header(fh, srcPath, &inputFileVersion, &opt_backupAll, &basePath)) {
         goto done;
     }
-    
-    if (inputFileVersion >= FILE_VERSION_2) {
-        opt_backupAll = read_int32(fh, 0);
-    } else {
-        opt_backupAll = 0;
+
+    // Index the base before wiping, it may be in /data.
+    if (basePath != NULL) {
+        printf("Reading base %s...\n", basePath);
+        int indexRes = build_index(basePath, 0);
+        free(basePath);
+        if (indexRes != 0) {
+            goto done;
+        }
     }
 
     // The path that shouldn't be deleted
@@ -536,7 +960,7 @@ static int restore_data(const char* srcPath)
     while (1) {
         int type;
         char* path = NULL;
-        if (read_header(fh, &type, &path, &statBuffer) == 0) {
+        if (read_header(fh, &type, &path, &statBuffer, NULL) == 0) {
             goto done;
         }
         if (type == 0) {
@@ -567,6 +991,9 @@ static int restore_data(const char* srcPath)
                 free(path);
                 goto done;
             }
+            if (inputFileVersion >= FILE_VERSION_3) {
+                read_int64(fh, 0);  // the inode, only used by incremental backups
+            }
             
             printf("Restoring file %s...\n", path);
             
@@ -584,6 +1011,37 @@ static int restore_data(const char* srcPath)
                 free(path);
                 goto done;
             }
+
+        } else if (type == TYPE_UNCHANGED) {
+            typeName = "file";
+            off_t size = read_int64(fh, -1);
+            read_int64(fh, 0);
+            struct index_entry* e = find_index_entry(path);
+            if (e == NULL || e->fh == NULL || e->size != size) {
+                fprintf(stderr, "'%s' is missing from the base\n", path);
+                free(path);
+                goto done;
+            }
+
+            printf("Restoring file %s from base...\n", path);
+
+            FILE* dest = fopen(path, "w");
+            if (dest == NULL) {
+                fprintf(stderr, "unable to open destination file '%s': %s\n",
+                    path, strerror(errno));
+                free(path);
+                goto done;
+            }
+
+            off_t offset = e->offset;
+            int copyres = copy_fd(dest, fileno(e->fh), &offset, size, path, NULL);
+            if (fclose(dest) != 0) {
+                copyres = 0;
+            }
+            if (!copyres) {
+                free(path);
+                goto done;
+            }
         
         } else {
             fprintf(stderr, "unknown node type %d\n", type);
@@ -638,7 +1096,11 @@ static void show_help(const char *cmd)
                     "  restore         Perform a restore of /data.\n");
     fprintf(stderr, "options include:\n"
                     "  -h              Show this help text.\n"
-                    "  -a              Backup all files.\n");
+                    "  -a              Backup all files.\n"
+                    "  -i base-file    Only store the files changed since the backup\n"
+                    "                  base-file, which must be kept to restore.\n"
+                    "  -j jobs         Scan /data with this many threads ahead of\n"
+                    "                  the backup.\n");
     fprintf(stderr, "\n backup-file-path Defaults to /sdcard/backup.dat .\n"
                     "                  On devices that emulate the sdcard, you will need to\n"
                     "                  explicitly specify the directory it is mapped to,\n"
@@ -689,7 +1151,7 @@ int main (int argc, char **argv)
     for (;;) {
         int ret;
 
-        ret = getopt(argc, argv, "ah");
+        ret = getopt(argc, argv, "ahi:j:");
 
         if (ret < 0) {
             break;
@@ -700,6 +1162,13 @@ int main (int argc, char **argv)
                 android::opt_backupAll = 1;
                 if (restore) fprintf(stderr, "Warning: -a option ignored on restore\n");
                 break;
+            case 'i':
+                android::opt_basePath = optarg;
+                if (restore) fprintf(stderr, "Warning: -i option ignored on restore\n");
+                break;
+            case 'j':
+                android::opt_jobs = atoi(optarg);
+                break;
             case 'h':
                 android::show_help(argv[0]);
                 exit(0);
@@ -72,6 +72,7 @@ const char *cmd_name(uint32_t cmd)
         NAME(BR_FAILED_REPLY);
         NAME(BR_DEAD_REPLY);
         NAME(BR_DEAD_BINDER);
+        NAME(BR_CLEAR_DEATH_NOTIFICATION_DONE);
     default: return "???";
     }
 }
@@ -262,16 +263,22 @@ int binder_parse(struct binder_state *bs, struct binder_io *bio,
             r = 0;
             break;
         }
-        case BR_DEAD_BINDER: {
+        case BR_DEAD_BINDER:
+        case BR_CLEAR_DEATH_NOTIFICATION_DONE: {
             struct binder_death *death = (struct binder_death *)(uintptr_t) *(binder_uintptr_t *)ptr;
             ptr += sizeof(binder_uintptr_t);
             death->func(bs, death->ptr);
             break;
         }
         case BR_FAILED_REPLY:
-            r = -1;
-            break;
         case BR_DEAD_REPLY:
+            if (func) {
+                /* a one-way call sent from the loop failed, most likely
+                 * because its target died, which isn't fatal to the loop */
+                ALOGE("parse: one-way call failed (%s)\n",
+                      cmd == BR_DEAD_REPLY ? "dead" : "failed");
+                break;
+            }
             r = -1;
             break;
         default:
@@ -312,6 +319,46 @@ void binder_link_to_death(struct binder_state *bs, uint32_t target, struct binde
     binder_write(bs, &data, sizeof(data));
 }
 
+void binder_clear_death(struct binder_state *bs, uint32_t target, struct binder_death *death)
+{
+    struct {
+        uint32_t cmd;
+        struct binder_handle_cookie payload;
+    } __attribute__((packed)) data;
+
+    data.cmd = BC_CLEAR_DEATH_NOTIFICATION;
+    data.payload.handle = target;
+    data.payload.cookie = (uintptr_t) death;
+    binder_write(bs, &data, sizeof(data));
+}
+
+int binder_call_oneway(struct binder_state *bs,
+                       struct binder_io *msg, uint32_t target, uint32_t code)
+{
+    struct {
+        uint32_t cmd;
+        struct binder_transaction_data txn;
+    } __attribute__((packed)) writebuf;
+
+    if (msg->flags & BIO_F_OVERFLOW) {
+        fprintf(stderr,"binder: txn buffer overflow\n");
+        return -1;
+    }
+
+    writebuf.cmd = BC_TRANSACTION;
+    writebuf.txn.target.handle = target;
+    writebuf.txn.cookie = 0;
+    writebuf.txn.code = code;
+    writebuf.txn.flags = TF_ONE_WAY;
+    writebuf.txn.data_size = msg->data - msg->data0;
+    writebuf.txn.offsets_size = ((char*) msg->offs) - ((char*) msg->offs0);
+    writebuf.txn.data.ptr.buffer = (uintptr_t)msg->data0;
+    writebuf.txn.data.ptr.offsets = (uintptr_t)msg->offs0;
+
+    hexdump(msg->data0, msg->data - msg->data0);
+    return binder_write(bs, &writebuf, sizeof(writebuf)) < 0 ? -1 : 0;
+}
+
 int binder_call(struct binder_state *bs,
                 struct binder_io *msg, struct binder_io *reply,
                 uint32_t target, uint32_t code)
@@ -366,11 +413,16 @@ fail:
     return -1;
 }
 
+/* Room for the commands the driver queues between two reads (death
+ * notifications, ref count changes, a transaction), so that they are
+ * handled with a single ioctl. */
+#define BINDER_LOOP_READ_SIZE 2048
+
 void binder_loop(struct binder_state *bs, binder_handler func)
 {
     int res;
     struct binder_write_read bwr;
-    uint32_t readbuf[32];
+    uint32_t readbuf[BINDER_LOOP_READ_SIZE / sizeof(uint32_t)];
 
     bwr.write_size = 0;
     bwr.write_consumed = 0;
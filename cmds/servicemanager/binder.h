@@ -39,8 +39,13 @@ enum {
     SVC_MGR_CHECK_SERVICE,
     SVC_MGR_ADD_SERVICE,
     SVC_MGR_LIST_SERVICES,
+    SVC_MGR_NOTIFY_SERVICE,
 };
 
+/* Code of the transaction sent to the callbacks of SVC_MGR_NOTIFY_SERVICE
+ * when their service is registered, see IServiceManager.cpp */
+#define SVC_MGR_SERVICE_REGISTERED 1
+
 typedef int (*binder_handler)(struct binder_state *bs,
                               struct binder_transaction_data *txn,
                               struct binder_io *msg,
@@ -56,6 +61,12 @@ int binder_call(struct binder_state *bs,
                 struct binder_io *msg, struct binder_io *reply,
                 uint32_t target, uint32_t code);
 
+/* send a one-way transaction, the reply or error is not waited for
+ * - returns zero if the driver accepted it
+ */
+int binder_call_oneway(struct binder_state *bs,
+                       struct binder_io *msg, uint32_t target, uint32_t code);
+
 /* release any state associate with the binder_io
  * - call once any necessary data has been extracted from the
  *   binder_io after binder_call() returns
@@ -69,6 +80,8 @@ void binder_acquire(struct binder_state *bs, uint32_t target);
 void binder_release(struct binder_state *bs, uint32_t target);
 
 void binder_link_to_death(struct binder_state *bs, uint32_t target, struct binder_death *death);
+/* death->func is also called once the driver acknowledges the clear */
+void binder_clear_death(struct binder_state *bs, uint32_t target, struct binder_death *death);
 
 void binder_loop(struct binder_state *bs, binder_handler func);
 
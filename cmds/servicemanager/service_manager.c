@@ -1,10 +1,13 @@
 /* Copyright 2008 The Android Open Source Project
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <string.h>
+#include <time.h>
 
 #include <private/android_filesystem_config.h>
 
@@ -56,9 +59,137 @@ static int selinux_enabled;
 static char *service_manager_context;
 static struct selabel_handle* sehandle;
 
+/* Cache of the access decisions that were allowed, keyed by the context of
+ * the caller, the permission and the service name, so that the processes
+ * looking up the same services over and over at boot don't each go through
+ * the service_contexts lookup and the policy check. Denials are not cached,
+ * so that each of them is still audited. The whole cache is dropped when
+ * the policy or the service contexts are reloaded, or when it is full. */
+#define ACCESS_CACHE_SIZE 256
+#define ACCESS_CACHE_MAX_ENTRIES 2048
+
+struct access_entry
+{
+    struct access_entry *next;
+    uint32_t hash;
+    const char *perm;   /* one of the static permission strings */
+    char *name;         /* NULL for permissions not about a service */
+    char sctx[0];
+};
+
+static struct access_entry *access_cache[ACCESS_CACHE_SIZE];
+static unsigned access_cache_entries;
+
+static uint32_t access_hash(const char *sctx, const char *perm, const char *name)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    const char *s;
+    for (s = sctx; *s; s++) {
+        hash = (hash ^ (unsigned char) *s) * 16777619u;
+    }
+    for (s = name ? name : ""; *s; s++) {
+        hash = (hash ^ (unsigned char) *s) * 16777619u;
+    }
+    return hash ^ (uint32_t)(uintptr_t) perm;
+}
+
+static bool access_cache_find(const char *sctx, const char *perm, const char *name)
+{
+    uint32_t hash = access_hash(sctx, perm, name);
+    struct access_entry *e;
+
+    for (e = access_cache[hash % ACCESS_CACHE_SIZE]; e; e = e->next) {
+        if (e->hash == hash && e->perm == perm && !strcmp(e->sctx, sctx) &&
+            (name ? e->name && !strcmp(e->name, name) : !e->name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void access_cache_flush(void)
+{
+    struct access_entry *e, *next;
+    unsigned i;
+
+    for (i = 0; i < ACCESS_CACHE_SIZE; i++) {
+        for (e = access_cache[i]; e; e = next) {
+            next = e->next;
+            free(e->name);
+            free(e);
+        }
+        access_cache[i] = NULL;
+    }
+    access_cache_entries = 0;
+}
+
+static void access_cache_add(const char *sctx, const char *perm, const char *name)
+{
+    size_t len = strlen(sctx) + 1;
+    struct access_entry *e;
+
+    if (access_cache_entries >= ACCESS_CACHE_MAX_ENTRIES) {
+        access_cache_flush();
+    }
+    e = malloc(sizeof(*e) + len);
+    if (!e) {
+        return;
+    }
+    e->name = name ? strdup(name) : NULL;
+    if (name && !e->name) {
+        free(e);
+        return;
+    }
+    e->hash = access_hash(sctx, perm, name);
+    e->perm = perm;
+    memcpy(e->sctx, sctx, len);
+    e->next = access_cache[e->hash % ACCESS_CACHE_SIZE];
+    access_cache[e->hash % ACCESS_CACHE_SIZE] = e;
+    access_cache_entries++;
+}
+
+/* Counters of the service lookups, logged every SVC_STATS_INTERVAL
+ * lookups. */
+#define SVC_STATS_INTERVAL 1024
+
+static struct {
+    unsigned lookups;
+    unsigned cache_hits;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} svc_stats;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void svc_stats_add(uint64_t start_ns)
+{
+    uint64_t ns = now_ns() - start_ns;
+
+    svc_stats.lookups++;
+    svc_stats.total_ns += ns;
+    if (ns > svc_stats.max_ns) {
+        svc_stats.max_ns = ns;
+    }
+    if (svc_stats.lookups == SVC_STATS_INTERVAL) {
+        ALOGI("%u lookups, %u access cache hits, avg %" PRIu64 "us, max %" PRIu64 "us\n",
+              svc_stats.lookups, svc_stats.cache_hits,
+              svc_stats.total_ns / svc_stats.lookups / 1000, svc_stats.max_ns / 1000);
+        memset(&svc_stats, 0, sizeof(svc_stats));
+    }
+}
+
+/* tctx is the context of the target, or NULL to look up the one of the
+ * service name in service_contexts. */
 static bool check_mac_perms(pid_t spid, const char *tctx, const char *perm, const char *name)
 {
     char *sctx = NULL;
+    char *lookup_tctx = NULL;
     const char *class = "service_manager";
     bool allowed;
 
@@ -67,9 +198,28 @@ static bool check_mac_perms(pid_t spid, const char *tctx, const char *perm, cons
         return false;
     }
 
+    if (access_cache_find(sctx, perm, name)) {
+        svc_stats.cache_hits++;
+        freecon(sctx);
+        return true;
+    }
+
+    if (!tctx) {
+        if (selabel_lookup(sehandle, &lookup_tctx, name, 0) != 0) {
+            ALOGE("SELinux: No match for %s in service_contexts.\n", name);
+            freecon(sctx);
+            return false;
+        }
+        tctx = lookup_tctx;
+    }
+
     int result = selinux_check_access(sctx, tctx, class, perm, (void *) name);
     allowed = (result == 0);
+    if (allowed) {
+        access_cache_add(sctx, perm, name);
+    }
 
+    freecon(lookup_tctx);
     freecon(sctx);
     return allowed;
 }
@@ -85,9 +235,6 @@ static bool check_mac_perms_from_getcon(pid_t spid, const char *perm)
 
 static bool check_mac_perms_from_lookup(pid_t spid, const char *perm, const char *name)
 {
-    bool allowed;
-    char *tctx = NULL;
-
     if (selinux_enabled <= 0) {
         return true;
     }
@@ -97,14 +244,7 @@ static bool check_mac_perms_from_lookup(pid_t spid, const char *perm, const char
         abort();
     }
 
-    if (selabel_lookup(sehandle, &tctx, name, 0) != 0) {
-        ALOGE("SELinux: No match for %s in service_contexts.\n", name);
-        return false;
-    }
-
-    allowed = check_mac_perms(spid, tctx, perm, name);
-    freecon(tctx);
-    return allowed;
+    return check_mac_perms(spid, NULL, perm, name);
 }
 
 static int svc_can_register(const uint16_t *name, size_t name_len, pid_t spid)
@@ -128,6 +268,8 @@ static int svc_can_find(const uint16_t *name, size_t name_len, pid_t spid)
 struct svcinfo
 {
     struct svcinfo *next;
+    struct svcinfo *hash_next;
+    uint32_t hash;
     uint32_t handle;
     struct binder_death death;
     int allow_isolated;
@@ -135,14 +277,32 @@ struct svcinfo
     uint16_t name[0];
 };
 
+/* svclist keeps registration order for SVC_MGR_LIST_SERVICES, lookups go
+ * through the hash table. Services are never removed, only their handle
+ * cleared when they die. */
 struct svcinfo *svclist = NULL;
 
+#define SVC_HASH_SIZE 256
+struct svcinfo *svchash[SVC_HASH_SIZE];
+
+static uint32_t svc_hash(const uint16_t *s16, size_t len)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ s16[i]) * 16777619u;
+    }
+    return hash;
+}
+
 struct svcinfo *find_svc(const uint16_t *s16, size_t len)
 {
     struct svcinfo *si;
+    uint32_t hash = svc_hash(s16, len);
 
-    for (si = svclist; si; si = si->next) {
-        if ((len == si->len) &&
+    for (si = svchash[hash % SVC_HASH_SIZE]; si; si = si->hash_next) {
+        if ((hash == si->hash) && (len == si->len) &&
             !memcmp(s16, si->name, len * sizeof(uint16_t))) {
             return si;
         }
@@ -161,6 +321,132 @@ void svcinfo_death(struct binder_state *bs, void *ptr)
     }
 }
 
+/* Clients waiting for a service to be registered, see
+ * SVC_MGR_NOTIFY_SERVICE. Each holds a reference on its callback and a
+ * death link to it, until either the service shows up or the client dies.
+ * A callback waits for a single service; asking again with the same one is
+ * a no-op. */
+#define MAX_SVC_WAITERS 1024
+#define MAX_SVC_WAITERS_PER_UID 64
+
+struct svcwaiter
+{
+    struct svcwaiter *next;
+    uint32_t handle;
+    uid_t uid;
+    struct binder_death death;
+    int notified;
+    size_t len;
+    uint16_t name[0];
+};
+
+static struct svcwaiter *waitlist = NULL;
+static unsigned num_waiters;
+
+static void unlink_waiter(struct svcwaiter *w)
+{
+    struct svcwaiter **link;
+
+    for (link = &waitlist; *link; link = &(*link)->next) {
+        if (*link == w) {
+            *link = w->next;
+            num_waiters--;
+            return;
+        }
+    }
+}
+
+/* Called when the client dies, or once the death link of a notified waiter
+ * has been cleared; either way the driver is done with w->death. */
+static void waiter_death(struct binder_state *bs, void *ptr)
+{
+    struct svcwaiter *w = (struct svcwaiter *) ptr;
+
+    if (!w->notified) {
+        unlink_waiter(w);
+    }
+    binder_release(bs, w->handle);
+    free(w);
+}
+
+static int add_waiter(struct binder_state *bs, const uint16_t *s, size_t len,
+                      uint32_t handle, uid_t uid)
+{
+    struct svcwaiter *w;
+    unsigned uid_waiters = 0;
+
+    for (w = waitlist; w; w = w->next) {
+        if (w->handle == handle) {
+            if ((w->len == len) && !memcmp(w->name, s, len * sizeof(uint16_t))) {
+                return 0;
+            }
+            ALOGE("notify_service('%s') uid=%d - CALLBACK ALREADY WAITING\n",
+                 str8(s, len), uid);
+            return -1;
+        }
+        if (w->uid == uid) {
+            uid_waiters++;
+        }
+    }
+    if (num_waiters >= MAX_SVC_WAITERS || uid_waiters >= MAX_SVC_WAITERS_PER_UID) {
+        ALOGE("notify_service('%s') uid=%d - TOO MANY WAITERS\n",
+             str8(s, len), uid);
+        return -1;
+    }
+    w = malloc(sizeof(*w) + len * sizeof(uint16_t));
+    if (!w) {
+        return -1;
+    }
+    w->handle = handle;
+    w->uid = uid;
+    w->death.func = waiter_death;
+    w->death.ptr = w;
+    w->notified = 0;
+    w->len = len;
+    memcpy(w->name, s, len * sizeof(uint16_t));
+    w->next = waitlist;
+    waitlist = w;
+    num_waiters++;
+    binder_acquire(bs, handle);
+    binder_link_to_death(bs, handle, &w->death);
+    return 0;
+}
+
+static int is_isolated(uid_t uid)
+{
+    uid_t appid = uid % AID_USER;
+    return appid >= AID_ISOLATED_START && appid <= AID_ISOLATED_END;
+}
+
+/* Sends the new service to the clients waiting for it. */
+static void notify_waiters(struct binder_state *bs, struct svcinfo *si)
+{
+    struct svcwaiter **link = &waitlist;
+
+    while (*link) {
+        struct svcwaiter *w = *link;
+        if ((w->len != si->len) ||
+            memcmp(w->name, si->name, si->len * sizeof(uint16_t))) {
+            link = &w->next;
+            continue;
+        }
+        if (si->allow_isolated || !is_isolated(w->uid)) {
+            unsigned iodata[512/4];
+            struct binder_io msg;
+
+            bio_init(&msg, iodata, sizeof(iodata), 4);
+            bio_put_ref(&msg, si->handle);
+            binder_call_oneway(bs, &msg, w->handle, SVC_MGR_SERVICE_REGISTERED);
+        }
+        /* w is freed by waiter_death() once the driver acknowledges
+         * that the death link is gone */
+        *link = w->next;
+        num_waiters--;
+        w->notified = 1;
+        binder_clear_death(bs, w->handle, &w->death);
+    }
+}
+
 uint16_t svcmgr_id[] = {
     'a','n','d','r','o','i','d','.','o','s','.',
     'I','S','e','r','v','i','c','e','M','a','n','a','g','e','r'
@@ -182,8 +468,7 @@ uint32_t do_find_service(struct binder_state *bs, const uint16_t *s, size_t len,
         if (!si->allow_isolated) {
             // If this service doesn't allow access from isolated processes,
             // then check the uid to see if it is isolated.
-            uid_t appid = uid % AID_USER;
-            if (appid >= AID_ISOLATED_START && appid <= AID_ISOLATED_END) {
+            if (is_isolated(uid)) {
                 return 0;
             }
         }
@@ -236,13 +521,44 @@ int do_add_service(struct binder_state *bs,
         si->allow_isolated = allow_isolated;
         si->next = svclist;
         svclist = si;
+        si->hash = svc_hash(s, len);
+        si->hash_next = svchash[si->hash % SVC_HASH_SIZE];
+        svchash[si->hash % SVC_HASH_SIZE] = si;
     }
 
     binder_acquire(bs, handle);
     binder_link_to_death(bs, handle, &si->death);
+    notify_waiters(bs, si);
     return 0;
 }
 
+/* Returns the handle of the service if it is already registered, otherwise
+ * sends it to the callback once it is. */
+int do_notify_service(struct binder_state *bs,
+                      const uint16_t *s, size_t len,
+                      uint32_t callback, uid_t uid, pid_t spid,
+                      uint32_t *handle)
+{
+    struct svcinfo *si;
+
+    *handle = 0;
+    if (!callback || (len == 0) || (len > 127))
+        return -1;
+
+    if (!svc_can_find(s, len, spid)) {
+        ALOGE("notify_service('%s') uid=%d - PERMISSION DENIED\n",
+             str8(s, len), uid);
+        return -1;
+    }
+
+    si = find_svc(s, len);
+    if (si && si->handle) {
+        *handle = do_find_service(bs, s, len, uid, spid);
+        return 0;
+    }
+    return add_waiter(bs, s, len, callback, uid);
+}
+
 int svcmgr_handler(struct binder_state *bs,
                    struct binder_transaction_data *txn,
                    struct binder_io *msg,
@@ -254,6 +570,7 @@ int svcmgr_handler(struct binder_state *bs,
     uint32_t handle;
     uint32_t strict_policy;
     int allow_isolated;
+    uint64_t start_ns;
 
     //ALOGI("target=%x code=%d pid=%d uid=%d\n",
     //  txn->target.handle, txn->code, txn->sender_pid, txn->sender_euid);
@@ -286,6 +603,7 @@ int svcmgr_handler(struct binder_state *bs,
             selabel_close(sehandle);
             sehandle = tmp_sehandle;
         }
+        access_cache_flush();
     }
 
     switch(txn->code) {
@@ -295,7 +613,9 @@ int svcmgr_handler(struct binder_state *bs,
         if (s == NULL) {
             return -1;
         }
+        start_ns = now_ns();
         handle = do_find_service(bs, s, len, txn->sender_euid, txn->sender_pid);
+        svc_stats_add(start_ns);
         if (!handle)
             break;
         bio_put_ref(reply, handle);
@@ -313,6 +633,19 @@ int svcmgr_handler(struct binder_state *bs,
             return -1;
         break;
 
+    case SVC_MGR_NOTIFY_SERVICE:
+        s = bio_get_string16(msg, &len);
+        if (s == NULL) {
+            return -1;
+        }
+        if (do_notify_service(bs, s, len, bio_get_ref(msg), txn->sender_euid,
+                              txn->sender_pid, &handle))
+            return -1;
+        if (!handle)
+            break;
+        bio_put_ref(reply, handle);
+        return 0;
+
     case SVC_MGR_LIST_SERVICES: {
         uint32_t n = bio_get_uint32(msg);
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_BATTERYPROPERTIESSNAPSHOT_H
+#define ANDROID_BATTERYPROPERTIESSNAPSHOT_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <batteryservice/BatteryService.h>
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+#include <utils/StrongPointer.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/*
+ * The latest BatteryProperties published by the registrar, in ashmem that
+ * native clients map read-only, so that they can sample the battery state
+ * without a binder call.
+ *
+ * sequence is a seqlock: it is odd while the registrar writes, and
+ * incremented again once it's done. Readers retry until they copied the
+ * values between two reads of the same even sequence.
+ */
+struct battery_properties_shared_t {
+    enum { VERSION = 1 };
+    enum { TECHNOLOGY_SIZE = 32 };
+
+    uint32_t            version;
+    volatile int32_t    sequence;
+    int64_t             timestamp;      // of the last update, CLOCK_MONOTONIC ns
+    int32_t             chargerAcOnline;
+    int32_t             chargerUsbOnline;
+    int32_t             chargerWirelessOnline;
+    int32_t             batteryStatus;
+    int32_t             batteryHealth;
+    int32_t             batteryPresent;
+    int32_t             batteryLevel;
+    int32_t             batteryVoltage;
+    int32_t             batteryTemperature;
+    char                batteryTechnology[TECHNOLOGY_SIZE];
+    uint32_t            reserved[3];
+};
+
+class BatteryPropertiesSnapshot : public RefBase {
+public:
+    // create makes a new snapshot for the registrar to publish to, map maps
+    // the one of the registrar read-only and takes ownership of fd. Both
+    // return NULL on failure.
+    static sp<BatteryPropertiesSnapshot> create();
+    static sp<BatteryPropertiesSnapshot> map(int fd);
+
+    // connect maps the snapshot of the battery properties registrar, or
+    // returns NULL if it doesn't publish one.
+    static sp<BatteryPropertiesSnapshot> connect();
+
+    virtual ~BatteryPropertiesSnapshot();
+
+    // getFd returns the ashmem fd backing the snapshot. It stays owned by
+    // the snapshot.
+    int getFd() const { return mFd; }
+
+    // Registrar side. publish stores props and returns true if they differ
+    // from the last ones published, in which case listeners should be told;
+    // updates that change nothing are coalesced away. Only one thread may
+    // publish at a time.
+    bool publish(const BatteryProperties& props);
+
+    // Client side. read copies the latest properties, and their sequence if
+    // outSequence isn't NULL. It returns NO_INIT if nothing was published
+    // yet, and WOULD_BLOCK if an update stays in progress for too long.
+    status_t read(BatteryProperties* props, uint32_t* outSequence = NULL,
+            nsecs_t* outTimestamp = NULL) const;
+    // getSequence returns the sequence of the latest properties, which only
+    // changes when they do; it's cheaper than read() to poll for changes.
+    uint32_t getSequence() const;
+
+private:
+    BatteryPropertiesSnapshot(int fd, battery_properties_shared_t* shared,
+            bool writable);
+
+    int mFd;
+    battery_properties_shared_t* mShared;
+    const bool mWritable;
+    // the registrar's copy of the last properties published, valid once
+    // the sequence isn't 0
+    BatteryProperties mLast;
+};
+
+}; // namespace android
+
+#endif // ANDROID_BATTERYPROPERTIESSNAPSHOT_H
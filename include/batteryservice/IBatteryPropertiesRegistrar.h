@@ -18,7 +18,9 @@
 #define ANDROID_IBATTERYPROPERTIESREGISTRAR_H
 
 #include <binder/IInterface.h>
+#include <batteryservice/BatteryPropertiesSnapshot.h>
 #include <batteryservice/IBatteryPropertiesListener.h>
+#include <utils/Mutex.h>
 
 namespace android {
 
@@ -27,6 +29,8 @@ enum {
     REGISTER_LISTENER = IBinder::FIRST_CALL_TRANSACTION,
     UNREGISTER_LISTENER,
     GET_PROPERTY,
+    // native only, not in the aidl
+    GET_PROPERTIES_SNAPSHOT,
 };
 
 class IBatteryPropertiesRegistrar : public IInterface {
@@ -36,12 +40,24 @@ public:
     virtual void registerListener(const sp<IBatteryPropertiesListener>& listener) = 0;
     virtual void unregisterListener(const sp<IBatteryPropertiesListener>& listener) = 0;
     virtual status_t getProperty(int id, struct BatteryProperty *val) = 0;
+    // returns the snapshot of the latest properties the registrar
+    // publishes, mapped read-only, or NULL if it doesn't publish one
+    virtual sp<BatteryPropertiesSnapshot> getPropertiesSnapshot() = 0;
 };
 
 class BnBatteryPropertiesRegistrar : public BnInterface<IBatteryPropertiesRegistrar> {
 public:
+    // The first call creates the snapshot and registers a listener with
+    // registerListener() that publishes every update to it, so that any
+    // registrar that notifies its listeners publishes one.
+    virtual sp<BatteryPropertiesSnapshot> getPropertiesSnapshot();
+
     virtual status_t onTransact(uint32_t code, const Parcel& data,
                                 Parcel* reply, uint32_t flags = 0);
+
+private:
+    Mutex mSnapshotLock;
+    sp<BatteryPropertiesSnapshot> mSnapshot;
 };
 
 }; // namespace android
@@ -68,6 +68,13 @@ public:
 
     AppOpsManager();
 
+    // Returns the op whose mode the given op follows, and with which the
+    // service reports changes to its mode.
+    static int32_t opToSwitch(int32_t op);
+
+    // checkOp() asks the service once per op, uid and package, and then
+    // until the mode of the op changes for the package. noteOp() and
+    // startOp() always go to the service, which records them.
     int32_t checkOp(int32_t op, int32_t uid, const String16& callingPackage);
     int32_t noteOp(int32_t op, int32_t uid, const String16& callingPackage);
     int32_t startOp(int32_t op, int32_t uid, const String16& callingPackage);
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_CHUNKEDTEXTOUTPUT_H
+#define ANDROID_CHUNKEDTEXTOUTPUT_H
+
+#include <binder/TextOutput.h>
+#include <utils/Vector.h>
+
+// ---------------------------------------------------------------------------
+namespace android {
+
+/*
+ * ChunkedTextOutput collects text for a file descriptor, typically the one
+ * given to dump(), in pages that are allocated as needed and never
+ * reallocated: unlike appending to a String8, nothing is copied again once
+ * written, however long the output grows. flush() writes the pages to the
+ * fd and keeps them for what comes next, the destructor flushes.
+ *
+ * Text is buffered until flush() so that it can be collected while holding
+ * a lock and written, possibly blocking on a slow reader, after releasing
+ * it. Not thread safe.
+ */
+class ChunkedTextOutput : public TextOutput
+{
+public:
+    // reserveBytes are allocated upfront, a good guess of the size of the
+    // output saves allocating pages while it's collected.
+                        ChunkedTextOutput(int fd, size_t reserveBytes = 0);
+    virtual             ~ChunkedTextOutput();
+
+    virtual status_t    print(const char* txt, size_t len);
+    virtual void        moveIndent(int delta);
+
+    virtual void        pushBundle();
+    virtual void        popBundle();
+
+            // format formats straight into the current page.
+            status_t    format(const char* fmt, ...)
+                                __attribute__((format (printf, 2, 3)));
+            status_t    append(const String8& str);
+
+            status_t    flush();
+            size_t      size() const;
+
+private:
+    enum { CHUNK_SIZE = 4096 };
+
+    // Disallow copying
+                        ChunkedTextOutput(const ChunkedTextOutput& rhs);
+    ChunkedTextOutput&  operator = (const ChunkedTextOutput& rhs);
+
+            status_t    write(const char* txt, size_t len);
+            status_t    nextPage();
+
+    const int           mFd;
+    Vector<char*>       mPages;
+    size_t              mPage;      // index of the current page in mPages
+    size_t              mUsed;      // bytes used in the current page
+    int32_t             mIndent;
+    bool                mAtLineStart;
+};
+
+// ---------------------------------------------------------------------------
+}; // namespace android
+
+#endif // ANDROID_CHUNKEDTEXTOUTPUT_H
@@ -54,7 +54,16 @@ public:
         SYSPROPS_TRANSACTION    = B_PACK_CHARS('_', 'S', 'P', 'R'),
 
         // Corresponds to TF_ONE_WAY -- an asynchronous call.
-        FLAG_ONEWAY             = 0x00000001
+        FLAG_ONEWAY             = 0x00000001,
+
+        // The call is on a latency-critical path: the thread handling it
+        // runs with the caller's scheduling policy and priority until it
+        // returns, rather than at whatever the remote pool thread had.
+        FLAG_LATENCY_CRITICAL   = 0x00000100,
+
+        // linkToDeath() flag: report the death through bindersDied(),
+        // together with the others read from the driver at the same time.
+        DEATH_BATCHED           = 0x00000001
     };
 
                           IBinder();
@@ -85,6 +94,12 @@ public:
     {
     public:
         virtual void binderDied(const wp<IBinder>& who) = 0;
+
+        // Called instead of binderDied() for the links made with
+        // DEATH_BATCHED, once for all the binders found dead at the same
+        // time (typically many of those of a process that died). Calls
+        // binderDied() for each of them by default.
+        virtual void bindersDied(const Vector<wp<IBinder> >& who);
     };
 
     /**
@@ -104,6 +119,10 @@ public:
      *
      * @note This link always holds a weak reference to its recipient.
      *
+     * @note With the DEATH_BATCHED flag, DeathRecipient::bindersDied() is
+     * called instead, once the other commands read from the driver along
+     * with the death have been handled.
+     *
      * @note You will only receive a weak reference to the dead
      * binder.  You should not try to promote this to a strong reference.
      * (Nor should you need to, as there is nothing useful you can
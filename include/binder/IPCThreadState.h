@@ -18,8 +18,10 @@
 #define ANDROID_IPC_THREAD_STATE_H
 
 #include <utils/Errors.h>
+#include <utils/Timers.h>
 #include <binder/Parcel.h>
 #include <binder/ProcessState.h>
+#include <utils/KeyedVector.h>
 #include <utils/Vector.h>
 
 #ifdef HAVE_WIN32_PROC
@@ -29,6 +31,8 @@ typedef  int  uid_t;
 // ---------------------------------------------------------------------------
 namespace android {
 
+class TransactionStats;
+
 class IPCThreadState
 {
 public:
@@ -55,6 +59,21 @@ public:
             status_t            handlePolledCommands();
             void                flushCommands();
 
+            // Opt-in coalescing of oneway transactions made from this
+            // thread.  While enabled, oneway calls accumulate in the
+            // outgoing command buffer and are handed to the driver together
+            // once more than maxBytes are pending or the oldest one has
+            // waited longer than maxDelay.  No timer runs in the background:
+            // callers must flushCommands() at the end of a burst.  Passing
+            // maxBytes == 0 flushes anything pending and turns batching off.
+            void                setOnewayBatching(size_t maxBytes, nsecs_t maxDelay);
+
+            // Makes every transaction from this thread as if it was made
+            // with IBinder::FLAG_LATENCY_CRITICAL.  For real-time threads,
+            // such as SurfaceFlinger's main thread, whose calls shouldn't
+            // wait for a remote thread running at the default priority.
+            void                setLatencyCritical(bool critical);
+
             void                joinThreadPool(bool isMain = true);
             
             // Stop the local process.
@@ -74,6 +93,11 @@ public:
                                                             BpBinder* proxy); 
             status_t            clearDeathNotification( int32_t handle,
                                                         BpBinder* proxy); 
+            // Used by BpBinder for the links made with DEATH_BATCHED: holds
+            // the death of proxy until the commands read along with it have
+            // been handled, then reports it with the others to recipient.
+            void                queueDeath(const wp<IBinder::DeathRecipient>& recipient,
+                                           const wp<IBinder>& proxy);
 
     static  void                shutdown();
     
@@ -92,6 +116,7 @@ private:
             status_t            waitForResponse(Parcel *reply,
                                                 status_t *acquireResult=NULL);
             status_t            talkWithDriver(bool doReceive=true);
+            status_t            flushOnewayBatch();
             status_t            writeTransactionData(int32_t cmd,
                                                      uint32_t binderFlags,
                                                      int32_t handle,
@@ -101,8 +126,18 @@ private:
             status_t            getAndExecuteCommand();
             status_t            executeCommand(int32_t command);
             void                processPendingDerefs();
+            void                deliverPendingDeaths();
             
             void                clearCaller();
+
+            // Per-thread pool of scratch Parcels (transaction replies) that
+            // keep their capacity across calls.
+            Parcel*             obtainParcel();
+            void                recycleParcel(Parcel* parcel);
+            void                trimParcelPool();
+
+            void                recordTransaction(int direction, const Parcel& data,
+                                                  uint32_t code, nsecs_t start);
             
     static  void                threadDestructor(void *st);
     static  void                freeBuffer(Parcel* parcel,
@@ -114,9 +149,25 @@ private:
     const   pid_t               mMyThreadId;
             Vector<BBinder*>    mPendingStrongDerefs;
             Vector<RefBase::weakref_type*> mPendingWeakDerefs;
+            KeyedVector<wp<IBinder::DeathRecipient>, Vector<wp<IBinder> > >
+                                mPendingDeaths;
             
             Parcel              mIn;
             Parcel              mOut;
+            Vector<Parcel*>     mParcelPool;
+            size_t              mParcelsInUse;
+            size_t              mParcelsInUsePeak;
+            size_t              mOnewayBatchBytes;
+            nsecs_t             mOnewayBatchDelay;
+            nsecs_t             mOnewayBatchStart;
+            // Batched oneway transactions whose completion has not been
+            // read back from the driver yet.
+            size_t              mOnewayBatchCount;
+            TransactionStats*   mTransactionStats;
+            bool                mInThreadPool;
+            // How long the last getAndExecuteCommand() blocked in the driver.
+            nsecs_t             mLastWorkWait;
+            bool                mLatencyCritical;
             status_t            mLastError;
             pid_t               mCallingPid;
             uid_t               mCallingUid;
@@ -20,6 +20,7 @@
 
 #include <binder/IInterface.h>
 #include <binder/IPermissionController.h>
+#include <utils/Timers.h>
 #include <utils/Vector.h>
 #include <utils/String16.h>
 
@@ -43,6 +44,16 @@ public:
      */
     virtual sp<IBinder>         checkService( const String16& name) const = 0;
 
+    /**
+     * Retrieve a service, blocking until it is registered or for at most
+     * timeout nanoseconds, forever if timeout is negative. Returns as soon
+     * as the service manager reports the registration when the calling
+     * process has binder threads to receive it, otherwise checks again
+     * every second.
+     */
+    virtual sp<IBinder>         waitForService( const String16& name,
+                                                nsecs_t timeout) const = 0;
+
     /**
      * Register a service.
      */
@@ -60,6 +71,7 @@ public:
         CHECK_SERVICE_TRANSACTION,
         ADD_SERVICE_TRANSACTION,
         LIST_SERVICES_TRANSACTION,
+        NOTIFY_SERVICE_TRANSACTION,
     };
 };
 
@@ -28,12 +28,21 @@ namespace android {
 // ----------------------------------------------------------------------------
 
 class SimpleBestFitAllocator;
+class SizeClassAllocator;
 
 // ----------------------------------------------------------------------------
 
 class MemoryDealer : public RefBase
 {
 public:
+    enum {
+        // Serve allocations of up to 2KB from slabs of fixed size blocks
+        // (32 bytes to 2KB, powers of two): allocating and freeing them
+        // takes constant time, and they don't fragment the rest of the heap.
+        // A flag of the dealer, it isn't passed on to the heap.
+        SIZE_CLASSES = 0x00010000
+    };
+
     MemoryDealer(size_t size, const char* name = 0);
     MemoryDealer(size_t size, const char* name , uint32_t flags  /* or bits such as MemoryHeapBase::READ_ONLY */ );
 
@@ -52,6 +61,8 @@ private:
 
     sp<IMemoryHeap>             mHeap;
     SimpleBestFitAllocator*     mAllocator;
+    // NULL unless created with SIZE_CLASSES
+    SizeClassAllocator*         mSizeClasses;
 };
 
 
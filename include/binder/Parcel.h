@@ -17,7 +17,10 @@
 #ifndef ANDROID_PARCEL_H
 #define ANDROID_PARCEL_H
 
+#include <string.h>
+
 #include <cutils/native_handle.h>
+#include <utils/Debug.h>
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 #include <utils/String16.h>
@@ -119,6 +122,12 @@ public:
     template<typename T>
     status_t            write(const LightFlattenable<T>& val);
 
+    // Writes a trivially copyable struct with a single capacity check,
+    // instead of one per field.  A struct made only of 32-bit fields
+    // (int32_t, uint32_t, float, Rect, ...) ends up exactly as if each
+    // field had been written with writeInt32()/writeFloat() in order.
+    template<typename T>
+    status_t            writeTrivial(const T& val);
 
     // Place a native_handle into the parcel (the native_handle's file-
     // descriptors are dup'ed, so it is safe to delete the native_handle
@@ -146,6 +155,24 @@ public:
     // The caller should call release() on the blob after writing its contents.
     status_t            writeBlob(size_t len, WritableBlob* outBlob);
 
+    // Like writeBlob(), but the blob is for the given receiver only, which
+    // lets it come from a pooled ashmem region last sent to that same
+    // receiver (see setBlobPoolLimit()).
+    status_t            writeBlob(size_t len, const sp<IBinder>& receiver,
+                                  WritableBlob* outBlob);
+
+    // Lets writeBlob() recycle its ashmem regions (and their mappings)
+    // across Parcels in this process, keeping at most maxIdleBytes of
+    // them around while unused.  Only blobs written for a receiver are
+    // pooled, and a region is only reused for the receiver it was sent
+    // to, since that receiver may still have it mapped.  A region is only
+    // recycled once both the WritableBlob and the Parcel that carried it
+    // have been released, so this is only safe when the receiver is done
+    // with a blob by the time the transaction returns (i.e. not for oneway
+    // calls, nor for readers holding on to their ReadableBlob).  0, the
+    // default, disables it.
+    static void         setBlobPoolLimit(size_t maxIdleBytes);
+
     status_t            writeObject(const flat_binder_object& val, bool nullMetaData);
 
     // Like Parcel.java's writeNoException().  Just writes a zero int32.
@@ -184,6 +211,10 @@ public:
     template<typename T>
     status_t            read(LightFlattenable<T>& val) const;
 
+    // Reads back a struct written by writeTrivial().
+    template<typename T>
+    status_t            readTrivial(T* val) const;
+
     // Like Parcel.java's readExceptionCode().  Reads the first int32
     // off of a Parcel's header, returning 0 or the negative error
     // code on exceptions, but also deals with skipping over rich
@@ -249,6 +280,13 @@ private:
     void                freeDataNoInit();
     void                initState();
     void                scanForFds() const;
+    size_t              lowerBoundObject(size_t offset) const;
+    uint8_t*            allocData(size_t desired, size_t* outCapacity);
+    status_t            reallocData(size_t desired);
+    void                freeDataStorage(uint8_t* data);
+    binder_size_t*      allocObjects(size_t count, size_t* outCapacity);
+    status_t            reallocObjects(size_t count);
+    void                freeObjectsStorage(binder_size_t* objects);
                         
     template<class T>
     status_t            readAligned(T *pArg) const;
@@ -269,12 +307,29 @@ private:
     mutable size_t      mNextObjectHint;
 
     mutable bool        mFdsKnown;
-    mutable bool        mHasFds;
+    // Number of BINDER_TYPE_FD objects in mObjects, valid if mFdsKnown.
+    mutable size_t      mFdCount;
+    // Whether mObjects is in increasing offset order, which is the case
+    // unless objects were written after moving the data position back.
+    bool                mObjectsSorted;
     bool                mAllowFds;
     
     release_func        mOwner;
     void*               mOwnerCookie;
 
+    // Pooled blob regions whose fds this Parcel carries without owning.
+    Vector<sp<RefBase> > mBlobRegions;
+
+    // Small transactions are written into these inline buffers and only
+    // spill to the heap once they outgrow them, so the common few-dozen
+    // byte Parcel never touches the allocator.
+    enum {
+        INLINE_DATA_SIZE = 256,
+        INLINE_OBJECTS_COUNT = 8
+    };
+    uint8_t             mInlineData[INLINE_DATA_SIZE] __attribute__((aligned(8)));
+    binder_size_t       mInlineObjects[INLINE_OBJECTS_COUNT];
+
     class Blob {
     public:
         Blob();
@@ -284,12 +339,16 @@ private:
         inline size_t size() const { return mSize; }
 
     protected:
-        void init(bool mapped, void* data, size_t size);
+        void init(bool mapped, void* data, size_t size,
+                const sp<RefBase>& region = NULL);
         void clear();
 
         bool mMapped;
         void* mData;
         size_t mSize;
+        // Set when mData belongs to a pooled region that must not be
+        // unmapped here.
+        sp<RefBase> mRegion;
     };
 
     class FlattenableHelperInterface {
@@ -406,6 +465,30 @@ status_t Parcel::read(LightFlattenable<T>& val) const {
     return NO_ERROR;
 }
 
+template<typename T>
+status_t Parcel::writeTrivial(const T& val) {
+    COMPILE_TIME_ASSERT_FUNCTION_SCOPE(__has_trivial_copy(T));
+    COMPILE_TIME_ASSERT_FUNCTION_SCOPE(__alignof__(T) <= sizeof(int32_t));
+    COMPILE_TIME_ASSERT_FUNCTION_SCOPE((sizeof(T) % sizeof(int32_t)) == 0);
+    void* buffer = writeInplace(sizeof(T));
+    if (buffer == NULL)
+        return NO_MEMORY;
+    memcpy(buffer, &val, sizeof(T));
+    return NO_ERROR;
+}
+
+template<typename T>
+status_t Parcel::readTrivial(T* val) const {
+    COMPILE_TIME_ASSERT_FUNCTION_SCOPE(__has_trivial_copy(T));
+    COMPILE_TIME_ASSERT_FUNCTION_SCOPE(__alignof__(T) <= sizeof(int32_t));
+    COMPILE_TIME_ASSERT_FUNCTION_SCOPE((sizeof(T) % sizeof(int32_t)) == 0);
+    void const* buffer = readInplace(sizeof(T));
+    if (buffer == NULL)
+        return NOT_ENOUGH_DATA;
+    memcpy(val, buffer, sizeof(T));
+    return NO_ERROR;
+}
+
 // ---------------------------------------------------------------------------
 
 inline TextOutput& operator<<(TextOutput& to, const Parcel& parcel)
@@ -20,9 +20,11 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include <utils/RWLock.h>
 #include <utils/String16.h>
 #include <utils/Singleton.h>
 #include <utils/SortedVector.h>
+#include <utils/Timers.h>
 
 namespace android {
 // ---------------------------------------------------------------------------
@@ -30,12 +32,16 @@ namespace android {
 /*
  * PermissionCache caches permission checks for a given uid.
  *
- * Currently the cache is not updated when there is a permission change,
- * for instance when an application is uninstalled.
+ * Grants are cached until the cache is purged, denials for
+ * kDeniedTimeout at most. The cache doesn't learn about permission changes
+ * by itself: whoever does, for instance when an application is installed or
+ * uninstalled, must call purge() or purgeUid().
  *
- * IMPORTANT: for the reason stated above, only system permissions are safe
- * to cache. This restriction may be lifted at a later time.
+ * IMPORTANT: unless that is done, only system permissions are safe to
+ * cache.
  *
+ * Checks only take a read lock, so that threads checking at the same time
+ * don't wait on each other.
  */
 
 class PermissionCache : Singleton<PermissionCache> {
@@ -43,24 +49,30 @@ class PermissionCache : Singleton<PermissionCache> {
         String16    name;
         uid_t       uid;
         bool        granted;
+        nsecs_t     expires;    // denials only
         inline bool operator < (const Entry& e) const {
             return (uid == e.uid) ? (name < e.name) : (uid < e.uid);
         }
     };
-    mutable Mutex mLock;
+    // how long a denial is cached: long enough to spare the binder call to
+    // callers retrying in a loop, short enough for a grant to be noticed
+    static const nsecs_t kDeniedTimeout;
+
+    mutable RWLock mLock;
+    // bumped by every purge, so that a check that raced with one isn't
+    // cached
+    uint32_t mGeneration;
     // we pool all the permission names we see, as many permissions checks
     // will have identical names
     SortedVector< String16 > mPermissionNamesPool;
     // this is our cache per say. it stores pooled names.
     SortedVector< Entry > mCache;
 
-    // free the whole cache, but keep the permission name pool
-    void purge();
-
     status_t check(bool* granted,
-            const String16& permission, uid_t uid) const;
+            const String16& permission, uid_t uid, uint32_t* generation) const;
 
-    void cache(const String16& permission, uid_t uid, bool granted);
+    void cache(const String16& permission, uid_t uid, bool granted,
+            uint32_t generation);
 
 public:
     PermissionCache();
@@ -72,6 +84,12 @@ public:
 
     static bool checkPermission(const String16& permission,
             pid_t pid, uid_t uid);
+
+    // free the whole cache, but keep the permission name pool
+    static void purge();
+
+    // forget what is cached for one uid
+    static void purgeUid(uid_t uid);
 };
 
 // ---------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/String8.h>
 #include <utils/String16.h>
+#include <utils/Timers.h>
 
 #include <utils/threads.h>
 
@@ -28,6 +29,7 @@
 namespace android {
 
 class IPCThreadState;
+class TransactionStats;
 
 class ProcessState : public virtual RefBase
 {
@@ -62,6 +64,25 @@ public:
             status_t            setThreadPoolMaxThreadCount(size_t maxThreads);
             void                giveThreadPoolName();
 
+            // Lets a spawned (non-main) pool thread exit after it handles a
+            // command that it waited longer than idleTimeout for; the driver
+            // spawns threads again on demand.  At most as many threads as the
+            // configured maximum are ever retired.  0, the default, keeps
+            // them around forever.
+            void                setThreadPoolIdleTimeout(nsecs_t idleTimeout);
+            nsecs_t             getThreadPoolIdleTimeout() const;
+
+            // Thread pool size, retirements and the most recent episodes
+            // during which every pool thread was busy.
+            void                dumpThreadPoolStats(String8& result) const;
+
+            // Per-interface transaction latency histograms, collected by
+            // every thread of this process while enabled.  They start out
+            // enabled if the debug.binder.stats property is set to 1.
+            void                setTransactionStatsEnabled(bool enabled);
+            bool                isTransactionStatsEnabled() const;
+            void                dumpTransactionStats(String8& result) const;
+
 private:
     friend class IPCThreadState;
     
@@ -77,14 +98,39 @@ private:
                 RefBase::weakref_type* refs;
             };
             
-            handle_entry*       lookupHandleLocked(int32_t handle);
+            // Proxies are spread over independently locked stripes by
+            // handle, so that lookups of different handles from different
+            // threads don't contend on a single lock.
+            enum { HANDLE_STRIPE_COUNT = 16 };
+
+            struct handle_stripe {
+                Mutex lock;
+                Vector<handle_entry> entries;
+            };
+
+            handle_stripe&      stripeForHandle(int32_t handle);
+            handle_entry*       lookupHandleLocked(handle_stripe& stripe, int32_t handle);
+
+            void                threadPoolThreadJoined();
+            bool                threadPoolThreadMayRetire();
+            void                threadPoolThreadLeft(bool retired);
+            void                threadPoolThreadBusy();
+            void                threadPoolThreadIdle();
+
+            TransactionStats*   acquireTransactionStats();
+            void                releaseTransactionStats(TransactionStats* stats);
+
+            struct stats_entry {
+                TransactionStats* stats;
+                bool inUse;
+            };
 
             int                 mDriverFD;
             void*               mVMStart;
             
+            handle_stripe       mHandleToObject[HANDLE_STRIPE_COUNT];
+
     mutable Mutex               mLock;  // protects everything below.
-            
-            Vector<handle_entry>mHandleToObject;
 
             bool                mManagesContexts;
             context_check_func  mBinderContextCheckFunc;
@@ -97,6 +143,30 @@ private:
             String8             mRootDir;
             bool                mThreadPoolStarted;
     volatile int32_t            mThreadPoolSeq;
+
+    // Thread pool accounting, see threadPoolThreadJoined() and friends.
+    mutable Mutex               mThreadPoolLock;
+            size_t              mMaxThreads;
+            size_t              mRetiredThreads;
+            nsecs_t             mIdleThreadTimeout;
+    volatile int32_t            mPooledThreads;
+    volatile int32_t            mBusyThreads;
+
+            enum { SATURATION_HISTORY = 16 };
+            struct saturation_event {
+                nsecs_t start;
+                nsecs_t duration;
+                int32_t threads;
+            };
+            saturation_event    mSaturations[SATURATION_HISTORY];
+            size_t              mSaturationCount;
+            nsecs_t             mSaturationStart;
+
+    // Stats objects outlive the threads that filled them, and are handed
+    // on to new threads so that history isn't lost when a thread exits.
+    mutable Mutex               mStatsLock;
+            Vector<stats_entry> mTransactionStats;
+    volatile int32_t            mTransactionStatsEnabled;
 };
     
 }; // namespace android
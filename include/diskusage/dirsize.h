@@ -25,6 +25,10 @@ __BEGIN_DECLS
 int64_t stat_size(struct stat *s);
 int64_t calculate_dir_size(int dfd);
 
+/* the same as calculate_dir_size(), with subdirectories sized by up to
+   'threads' threads; 0 picks one per CPU. Takes ownership of dfd. */
+int64_t calculate_dir_size_parallel(int dfd, int threads);
+
 __END_DECLS
 
 #endif /* __LIBDISKUSAGE_DIRSIZE_H */
@@ -51,6 +51,10 @@ public:
     // get the send file-descriptor.
     int getSendFd() const;
 
+    // change the size of the send buffer. Messages already in the socket are kept, if they
+    // take more than the new size sending fails with -EAGAIN until enough of them are read.
+    status_t setSendBufferSize(size_t size);
+
     // send objects (sized blobs). All objects are guaranteed to be written or the call fails.
     template <typename T>
     static ssize_t sendObjects(const sp<BitTube>& tube,
@@ -66,6 +70,18 @@ public:
         return recvObjects(tube, events, count, sizeof(T));
     }
 
+    // receive the objects of up to maxMessages messages with a single system
+    // call. Message i is received in slots[i * slotCount] and may hold up to
+    // slotCount objects, excess objects are discarded; outCounts[i] is set to
+    // the number of objects it held. Returns the number of messages received,
+    // 0 if there were none.
+    template <typename T>
+    static ssize_t recvObjectMessages(const sp<BitTube>& tube,
+            T* slots, size_t slotCount, size_t maxMessages, size_t* outCounts) {
+        return recvObjectMessages(tube, slots, slotCount, maxMessages,
+                outCounts, sizeof(T));
+    }
+
     // parcels this BitTube
     status_t writeToParcel(Parcel* reply) const;
 
@@ -87,6 +103,10 @@ private:
 
     static ssize_t recvObjects(const sp<BitTube>& tube,
             void* events, size_t count, size_t objSize);
+
+    static ssize_t recvObjectMessages(const sp<BitTube>& tube,
+            void* slots, size_t slotCount, size_t maxMessages,
+            size_t* outCounts, size_t objSize);
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_BUFFERCONVERTER_H
+#define ANDROID_GUI_BUFFERCONVERTER_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+#include <ui/Rect.h>
+
+#include <utils/KeyedVector.h>
+#include <utils/RefBase.h>
+#include <utils/threads.h>
+
+namespace android {
+
+/*
+ * BufferConverter copies a buffer into another one with the GPU, converting
+ * the pixel format on the way (YUV to RGB for instance), scaling the crop of
+ * the source to the whole destination and applying a
+ * NATIVE_WINDOW_TRANSFORM_* transform. The copy is only queued: the fence it
+ * returns signals once the destination is written and the source can be
+ * reused.
+ *
+ * It renders with its own EGL context, and puts back the context that was
+ * current on the calling thread, so any thread may use it. Conversions are
+ * serialized.
+ */
+class BufferConverter : public LightRefBase<BufferConverter> {
+public:
+    BufferConverter();
+
+    // convert queues the copy of the crop of src into dst, to start once
+    // srcFence has signaled, and returns the fence of the copy in outFence.
+    // An empty crop copies the whole source. dst must be renderable by the
+    // GPU (GRALLOC_USAGE_HW_RENDER), BAD_VALUE is returned otherwise.
+    status_t convert(const sp<GraphicBuffer>& src, const sp<Fence>& srcFence,
+            const Rect& crop, uint32_t transform,
+            const sp<GraphicBuffer>& dst, sp<Fence>* outFence);
+
+private:
+    friend class LightRefBase<BufferConverter>;
+    ~BufferConverter();
+
+    // Disallow copying
+    BufferConverter(const BufferConverter& rhs);
+    BufferConverter& operator = (const BufferConverter& rhs);
+
+    status_t initLocked();
+    status_t convertLocked(const sp<GraphicBuffer>& src,
+            const sp<Fence>& srcFence, const Rect& crop, uint32_t transform,
+            const sp<GraphicBuffer>& dst, sp<Fence>* outFence);
+
+    // getImageLocked returns the EGLImage of a buffer, creating it the first
+    // time the buffer is seen.
+    EGLImageKHR getImageLocked(const sp<GraphicBuffer>& buffer);
+    void clearImagesLocked();
+
+    Mutex mMutex;
+
+    // mInitError is NO_INIT until the first conversion sets up EGL, and the
+    // result of that setup afterwards.
+    status_t mInitError;
+
+    EGLDisplay mEglDisplay;
+    EGLContext mEglContext;
+    EGLSurface mEglSurface;
+
+    GLuint mProgram;
+    GLint mPositionLoc;
+    GLint mTexCoordLoc;
+    GLuint mSrcTexture;
+    GLuint mDstTexture;
+    GLuint mFramebuffer;
+
+    // The EGLImages of the last buffers converted, by buffer id. Producers
+    // cycle through a few buffers, so they are usually all here.
+    struct CachedImage {
+        sp<GraphicBuffer> mGraphicBuffer;
+        EGLImageKHR mEglImage;
+    };
+    KeyedVector<uint64_t, CachedImage> mImages;
+};
+
+}; // namespace android
+
+#endif // ANDROID_GUI_BUFFERCONVERTER_H
@@ -96,6 +96,15 @@ class BufferItem : public Flattenable {
     // Indicates this buffer must be transformed by the inverse transform of the screen
     // it is displayed onto. This is applied after mTransform.
     bool mTransformToDisplayInverse;
+
+    // mSurfaceDamage is the part of the buffer, in buffer coordinates, that
+    // changed since the previous frame of the producer. It is invalid when
+    // unknown, meaning the whole buffer.
+    Rect mSurfaceDamage;
+
+    // addOlderSurfaceDamage accounts for a frame that was dropped in favor
+    // of this one: its damage must be reported along with ours.
+    void addOlderSurfaceDamage(const Rect& damage);
 };
 
 } // namespace android
@@ -88,6 +88,21 @@ class BufferItemConsumer: public ConsumerBase
     status_t releaseBuffer(const BufferItem &item,
             const sp<Fence>& releaseFence = Fence::NO_FENCE);
 
+    // Gets up to maxCount of the pending buffers at once, oldest first,
+    // appending them to items, in a single call to the BufferQueue. Returns
+    // as acquireBuffer would when not even one buffer could be acquired.
+    //
+    // If waitForFence is true, acquireBuffers waits on the fence of each of
+    // the buffers before returning.
+    status_t acquireBuffers(size_t maxCount, Vector<BufferItem>* items,
+            nsecs_t presentWhen, bool waitForFence = true);
+
+    // Returns several acquired buffers to the queue at once, with the same
+    // fence, as releaseBuffer would return each of them. This suits
+    // consumers that process the buffers of a burst in a single job.
+    status_t releaseBuffers(const Vector<BufferItem>& items,
+            const sp<Fence>& releaseFence = Fence::NO_FENCE);
+
     // setDefaultBufferSize is used to set the size of buffers returned by
     // requestBuffers when a with and height of zero is requested.
     status_t setDefaultBufferSize(uint32_t w, uint32_t h);
@@ -71,6 +71,14 @@ public:
             const sp<Fence>& releaseFence, EGLDisplay display,
             EGLSyncKHR fence);
 
+    // See IGraphicBufferConsumer::acquireBuffers
+    virtual status_t acquireBuffers(size_t maxCount,
+            Vector<BufferItem>* outBuffers, nsecs_t expectedPresent);
+
+    // See IGraphicBufferConsumer::releaseBuffers
+    virtual status_t releaseBuffers(const Vector<ReleasedBuffer>& buffers,
+            uint64_t* outStaleSlots);
+
     // connect connects a consumer to the BufferQueue.  Only one
     // consumer may be connected, and when that consumer disconnects the
     // BufferQueue is placed into the "abandoned" state, causing most
@@ -139,12 +147,18 @@ public:
     // NATIVE_WINDOW_TRANSFORM_ROT_90.  The default is 0 (no transform).
     virtual status_t setTransformHint(uint32_t hint);
 
+    // See IGraphicBufferConsumer::setDropLateFrames
+    virtual status_t setDropLateFrames(bool enabled);
+
     // Retrieve the sideband buffer stream, if any.
     virtual sp<NativeHandle> getSidebandStream() const;
 
     // dump our state in a String
     virtual void dump(String8& result, const char* prefix) const;
 
+    // See IGraphicBufferConsumer::dumpLatencyStats
+    virtual void dumpLatencyStats(String8& result, bool clear);
+
     // Functions required for backwards compatibility.
     // These will be modified/renamed in IGraphicBufferConsumer and will be
     // removed from this class at that time. See b/13306289.
@@ -165,6 +179,15 @@ public:
     // End functions required for backwards compatibility
 
 private:
+    // acquireBufferLocked and releaseBufferLocked do the work of
+    // acquireBuffer and releaseBuffer, with mCore->mMutex held, but leave
+    // waking up the producer to the caller.
+    status_t acquireBufferLocked(BufferItem* outBuffer,
+            nsecs_t expectedPresent);
+    status_t releaseBufferLocked(int slot, uint64_t frameNumber,
+            const sp<Fence>& releaseFence, EGLDisplay eglDisplay,
+            EGLSyncKHR eglFence);
+
     sp<BufferQueueCore> mCore;
 
     // This references mCore->mSlots. Lock mCore->mMutex while accessing.
@@ -26,6 +26,8 @@
 #include <utils/RefBase.h>
 #include <utils/String8.h>
 #include <utils/StrongPointer.h>
+#include <utils/Thread.h>
+#include <utils/Timers.h>
 #include <utils/Trace.h>
 #include <utils/Vector.h>
 
@@ -46,6 +48,7 @@
 namespace android {
 
 class BufferItem;
+class BufferQueueControlServer;
 class IConsumerListener;
 class IGraphicBufferAlloc;
 class IProducerListener;
@@ -120,9 +123,94 @@ private:
     // in one of the slots.
     bool stillTracking(const BufferItem* item) const;
 
-    // waitWhileAllocatingLocked blocks until mIsAllocating is false.
+    // freeBuffersBeyondMaxCountLocked frees the buffers of the FREE slots
+    // beyond the max buffer count, which dequeueBuffer would otherwise only
+    // free the next time it is called. It does nothing while buffers are
+    // being allocated.
+    void freeBuffersBeyondMaxCountLocked();
+
+    // waitWhileAllocatingLocked blocks until mIsAllocating and
+    // mIsReallocating are false.
     void waitWhileAllocatingLocked() const;
 
+    // setBufferStateLocked changes the state of a slot. It must be used
+    // instead of assigning BufferSlot::mBufferState so that the per-state
+    // slot masks below stay in sync.
+    void setBufferStateLocked(int slot, BufferSlot::BufferState state);
+
+    // countSlotsLocked returns the number of slots below maxBufferCount that
+    // are in the given state (FREE, DEQUEUED or ACQUIRED).
+    int countSlotsLocked(BufferSlot::BufferState state,
+            int maxBufferCount) const;
+
+    // findOldestFreeSlotLocked returns the FREE slot below maxBufferCount
+    // with the lowest frame number, or INVALID_BUFFER_SLOT if there is none.
+    // Only the FREE slots are visited.
+    int findOldestFreeSlotLocked(int maxBufferCount) const;
+
+    // scheduleReallocationLocked is called when the default buffer size or
+    // format changes. If the connected producer relies on the defaults, the
+    // FREE slots still holding buffers of the old geometry are reallocated
+    // on a background thread, so that the allocation doesn't happen in
+    // dequeueBuffer on the producer's thread. A dequeueBuffer arriving while
+    // the thread runs waits for it instead of allocating the same buffer.
+    void scheduleReallocationLocked();
+
+    // reallocateBuffers runs on the reallocation thread. It allocates
+    // replacement buffers one at a time without holding mMutex, and only
+    // swaps each one in if its slot is still FREE and still holds the
+    // buffer being replaced.
+    void reallocateBuffers();
+
+    class ReallocationThread;
+
+    // The record*Locked methods below timestamp each frame as it moves
+    // through the queue. The stages are accumulated into the latency
+    // histograms when the frame is released, see dumpLatencyStatsLocked.
+    void recordDequeueLocked(int slot, nsecs_t dequeueStart);
+    void recordQueueLocked(int slot, const sp<Fence>& fence);
+    void recordAcquireLocked(int slot);
+    void recordDropLocked(int slot);
+    void recordReleaseLocked(int slot);
+
+    // recordGpuTimes adds the frames released since the last call to the
+    // gpu histogram. Reading a fence's signal time is an ioctl, so it must
+    // be called without holding mMutex.
+    void recordGpuTimes();
+
+    // dumpLatencyStatsLocked prints the latency histograms of the frames
+    // released so far, optionally clearing them afterwards.
+    void dumpLatencyStatsLocked(String8& result, bool clear);
+
+    // LatencyHistogram counts durations in power of two microsecond buckets;
+    // the last bucket also collects everything longer.
+    struct LatencyHistogram {
+        enum { BUCKET_COUNT = 20 };
+
+        LatencyHistogram() { clear(); }
+        void clear();
+        void add(nsecs_t duration);
+        nsecs_t percentile(uint32_t percent) const;
+        void dump(String8& result, const char* name) const;
+
+        uint32_t count;
+        nsecs_t total;
+        nsecs_t max;
+        uint32_t buckets[BUCKET_COUNT];
+    };
+
+    // FrameTimes holds the timestamps of the frame currently in a slot.
+    // A timestamp of 0 means that stage wasn't seen for this frame (e.g.
+    // the buffer was attached rather than dequeued).
+    struct FrameTimes {
+        FrameTimes() : dequeueTime(0), queueTime(0), acquireTime(0) {}
+
+        nsecs_t dequeueTime;
+        nsecs_t queueTime;
+        nsecs_t acquireTime;
+        sp<Fence> fence;
+    };
+
     // mAllocator is the connection to SurfaceFlinger that is used to allocate
     // new GraphicBuffer objects.
     sp<IGraphicBufferAlloc> mAllocator;
@@ -234,9 +322,18 @@ private:
     // mTransformHint is used to optimize for screen rotations.
     uint32_t mTransformHint;
 
+    // mDropLateFrames is whether acquireBuffer also drops superseded
+    // buffers with automatic timestamps, see setDropLateFrames.
+    bool mDropLateFrames;
+
     // mSidebandStream is a handle to the sideband buffer stream, if any
     sp<NativeHandle> mSidebandStream;
 
+    // mControlServer serves the control channel handed out by
+    // BufferQueueProducer::getControlChannel. It is stopped when the
+    // producer disconnects or goes away, or the BufferQueue is abandoned.
+    sp<BufferQueueControlServer> mControlServer;
+
     // mIsAllocating indicates whether a producer is currently trying to allocate buffers (which
     // releases mMutex while doing the allocation proper). Producers should not modify any of the
     // FREE slots while this is true. mIsAllocatingCondition is signaled when this value changes to
@@ -246,6 +343,60 @@ private:
     // mIsAllocatingCondition is a condition variable used by producers to wait until mIsAllocating
     // becomes false.
     mutable Condition mIsAllocatingCondition;
+
+    // mFreeSlots, mDequeuedSlots and mAcquiredSlots have bit N set when slot
+    // N is in the corresponding state (QUEUED slots are in none of them).
+    // They are maintained by setBufferStateLocked.
+    uint64_t mFreeSlots;
+    uint64_t mDequeuedSlots;
+    uint64_t mAcquiredSlots;
+
+    // mProducerUsesDefaultSize, mProducerFormat, mProducerUsage and
+    // mProducerAsync record the arguments of the last dequeueBuffer call,
+    // telling which buffers the producer will ask for after the defaults
+    // change. They are reset when the producer disconnects.
+    bool mProducerUsesDefaultSize;
+    uint32_t mProducerFormat;
+    uint32_t mProducerUsage;
+    bool mProducerAsync;
+
+    // mFreedBeyondMaxCount is set when freeBuffersBeyondMaxCountLocked freed
+    // a buffer the producer may still hold; the next dequeueBuffer returns
+    // RELEASE_ALL_BUFFERS so that it drops them.
+    bool mFreedBeyondMaxCount;
+
+    // mIsReallocating indicates whether a ReallocationThread is running;
+    // producers wait on mIsAllocatingCondition while it is true, like they do
+    // for mIsAllocating. mReallocationPending is set when the defaults change
+    // again while it runs, in which case it makes another pass over the slots.
+    bool mIsReallocating;
+    bool mReallocationPending;
+
+    // mFrameTimes holds the timestamps of the frame in each slot.
+    FrameTimes mFrameTimes[BufferQueueDefs::NUM_BUFFER_SLOTS];
+
+    // The latency histograms, per pipeline stage:
+    //   mDequeueWaitTime  time spent waiting in dequeueBuffer
+    //   mProducerTime     dequeueBuffer to queueBuffer
+    //   mGpuTime          queueBuffer to the acquire fence signaling
+    //   mQueuedTime       queueBuffer to acquireBuffer
+    //   mConsumerTime     acquireBuffer to releaseBuffer
+    LatencyHistogram mDequeueWaitTime;
+    LatencyHistogram mProducerTime;
+    LatencyHistogram mGpuTime; // guarded by mGpuTimeLock
+    LatencyHistogram mQueuedTime;
+    LatencyHistogram mConsumerTime;
+
+    // mDroppedFrames counts the frames replaced in the queue before the
+    // consumer acquired them.
+    uint32_t mDroppedFrames;
+
+    // mReleasedFrames holds the frames released but not yet added to
+    // mGpuTime by recordGpuTimes. It and mGpuTime are guarded by
+    // mGpuTimeLock rather than mMutex; mGpuTimeLock may be taken while
+    // holding mMutex, but not the other way around.
+    Vector<FrameTimes> mReleasedFrames;
+    mutable Mutex mGpuTimeLock;
 }; // class BufferQueueCore
 
 } // namespace android
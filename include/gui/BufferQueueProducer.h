@@ -173,6 +173,14 @@ public:
     virtual void allocateBuffers(bool async, uint32_t width, uint32_t height,
             uint32_t format, uint32_t usage);
 
+    // See IGraphicBufferProducer::getControlChannel
+    virtual status_t getControlChannel(int* outFd);
+
+    // See IGraphicBufferProducer::attachAndQueueBuffer
+    virtual status_t attachAndQueueBuffer(int* outSlot,
+            const sp<GraphicBuffer>& buffer, const QueueBufferInput& input,
+            QueueBufferOutput* output);
+
 private:
     // This is required by the IBinder::DeathRecipient interface
     virtual void binderDied(const wp<IBinder>& who);
@@ -45,7 +45,8 @@ public:
         // trigger the callback.
         //
         // This is called without any lock held and can be called concurrently
-        // by multiple threads.
+        // by multiple threads, unless setAsyncFrameAvailable was used, in
+        // which case it is only called from the consumer's dispatch thread.
         virtual void onFrameAvailable() = 0;
     };
 
@@ -72,14 +73,35 @@ public:
     void dump(String8& result) const;
     void dump(String8& result, const char* prefix) const;
 
+    // dumpLatencyStats writes the BufferQueue latency histograms to a
+    // string, see IGraphicBufferConsumer::dumpLatencyStats.
+    void dumpLatencyStats(String8& result, bool clear);
+
     // setFrameAvailableListener sets the listener object that will be notified
     // when a new frame becomes available.
     void setFrameAvailableListener(const wp<FrameAvailableListener>& listener);
 
+    // setAsyncFrameAvailable makes the FrameAvailableListener be called from
+    // a thread owned by this ConsumerBase instead of the producer's thread,
+    // so that queueBuffer never waits for the locks the listener takes. If
+    // coalesce is true, the frames queued while the listener was busy only
+    // trigger one more call; listeners that count frames must not use it.
+    // Frames still waiting for the listener when this is called are lost,
+    // so it is meant to be set up before the producer connects.
+    void setAsyncFrameAvailable(bool enabled, bool coalesce = false);
+
 private:
     ConsumerBase(const ConsumerBase&);
     void operator=(const ConsumerBase&);
 
+    // FrameDispatcher is the thread calling the FrameAvailableListener when
+    // setAsyncFrameAvailable is enabled.
+    class FrameDispatcher;
+
+    // dispatchFrameAvailable calls the FrameAvailableListener count times,
+    // from the FrameDispatcher.
+    void dispatchFrameAvailable(uint32_t count);
+
 protected:
     // ConsumerBase constructs a new ConsumerBase object to consume image
     // buffers from the given IGraphicBufferConsumer.
@@ -167,6 +189,20 @@ protected:
             const sp<GraphicBuffer> graphicBuffer,
             EGLDisplay display, EGLSyncKHR eglFence);
 
+    // acquireBuffersLocked fetches up to maxCount buffers from the
+    // BufferQueue at once, see IGraphicBufferConsumer::acquireBuffers, and
+    // updates the buffer slots as acquireBufferLocked does. Derived classes
+    // that need to override acquireBufferLocked shouldn't use it.
+    status_t acquireBuffersLocked(size_t maxCount,
+            Vector<IGraphicBufferConsumer::BufferItem>* items,
+            nsecs_t presentWhen);
+
+    // releaseBuffersLocked gives several buffers back to the BufferQueue at
+    // once, as releaseBufferLocked does for each. It returns the first error
+    // from one of them, if any.
+    status_t releaseBuffersLocked(
+            const Vector<IGraphicBufferConsumer::BufferItem>& items);
+
     // returns true if the slot still has the graphicBuffer in it.
 #ifdef STE_HARDWARE
     virtual
@@ -196,6 +232,12 @@ protected:
         // the producer is responsible for delaying writes until it signals.
         sp<Fence> mFence;
 
+        // mReleaseFences holds mFence together with the release fences added
+        // since the buffer was acquired. They are only merged into mFence
+        // when the buffer is released, so fences that have signaled by then
+        // never cost a merge.
+        FenceSet mReleaseFences;
+
         // the frame number of the last acquired frame for this slot
         uint64_t mFrameNumber;
     };
@@ -225,6 +267,10 @@ protected:
     // queueBuffer.
     wp<FrameAvailableListener> mFrameAvailableListener;
 
+    // mFrameDispatcher is the thread calling mFrameAvailableListener, or
+    // NULL if it is called from the producer's thread.
+    sp<FrameDispatcher> mFrameDispatcher;
+
     // The ConsumerBase has-a BufferQueue and is responsible for creating this object
     // if none is supplied
     sp<IGraphicBufferConsumer> mConsumer;
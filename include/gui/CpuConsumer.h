@@ -17,6 +17,7 @@
 #ifndef ANDROID_GUI_CPUCONSUMER_H
 #define ANDROID_GUI_CPUCONSUMER_H
 
+#include <gui/BufferConverter.h>
 #include <gui/ConsumerBase.h>
 
 #include <ui/GraphicBuffer.h>
@@ -54,14 +55,20 @@ class CpuConsumer : public ConsumerBase
         uint32_t    scalingMode;
         int64_t     timestamp;
         uint64_t    frameNumber;
-        // Values below are only valid when using
-        // HAL_PIXEL_FORMAT_YCbCr_420_888, in which case LockedBuffer::data
-        // contains the Y channel, and stride is the Y channel stride. For other
-        // formats, these will all be 0.
+        // Values below are only valid for YUV formats with a known layout:
+        // HAL_PIXEL_FORMAT_YCbCr_420_888, YV12, YCrCb_420_SP (NV21) and
+        // YCbCr_422_SP (NV16), in which case LockedBuffer::data contains the
+        // Y channel, and stride is the Y channel stride. chromaStep is the
+        // distance in bytes between two samples of a chroma row (2 when Cb and
+        // Cr are interleaved), and chromaWidth and chromaHeight the size of
+        // the chroma planes in samples. For other formats, these will all be
+        // 0. See gui/YuvPlanes.h for helpers to copy them.
         uint8_t    *dataCb;
         uint8_t    *dataCr;
         uint32_t    chromaStride;
         uint32_t    chromaStep;
+        uint32_t    chromaWidth;
+        uint32_t    chromaHeight;
     };
 
     // Create a new CPU consumer. The maxLockedBuffers parameter specifies
@@ -104,6 +111,29 @@ class CpuConsumer : public ConsumerBase
     // lockNextBuffer.
     status_t unlockBuffer(const LockedBuffer &nativeBuffer);
 
+    // setPersistentMapping controls whether each slot's buffer stays locked
+    // for CPU access between frames. When enabled, a slot is mapped the
+    // first time it is locked and the mapping is handed out again for later
+    // frames in the same slot until the slot is reallocated or freed;
+    // lockNextBuffer then only waits for the acquire fence, and unlockBuffer
+    // doesn't unmap anything. Since gralloc isn't asked to lock the buffer
+    // again, it can't do any cache maintenance for the new frame either, so
+    // this is only safe for buffers that are CPU coherent.
+    // Disabled by default; disabling it unmaps every slot not locked by the
+    // user.
+    void setPersistentMapping(bool enabled);
+
+    // setConvertedFormat has lockNextBuffer hand out a copy of each buffer
+    // converted to format by the GPU, instead of the buffer itself, when the
+    // buffer has another format. The crop and transform of the buffer are
+    // applied by the copy: the LockedBuffer has the size of the crop
+    // (rotated if need be), a crop covering all of it and no transform. The
+    // original buffer goes back to the producer as soon as the copy is
+    // queued. format must be renderable by the GPU, such as
+    // HAL_PIXEL_FORMAT_RGBA_8888; 0 turns the conversion off, which is the
+    // default. Persistent mappings aren't used for converted buffers.
+    status_t setConvertedFormat(PixelFormat format);
+
   private:
     // Maximum number of buffers that can be locked at a time
     uint32_t mMaxLockedBuffers;
@@ -112,6 +142,21 @@ class CpuConsumer : public ConsumerBase
 
     virtual void freeBufferLocked(int slotIndex);
 
+    // mapSlotLocked waits for fence and returns the persistent mapping of a
+    // slot, creating it if the slot isn't mapped yet.
+    status_t mapSlotLocked(int slot, const sp<Fence>& fence,
+            void** outPointer, android_ycbcr* outYCbCr);
+
+    // unmapSlotLocked drops the persistent mapping of a slot. If the buffer is
+    // still locked by the user it is unlocked when the user unlocks it.
+    void unmapSlotLocked(int slot);
+
+    // lockConvertedLocked is lockNextBuffer for a buffer that has to be
+    // converted, see setConvertedFormat. The buffer is released to the
+    // producer once the copy is queued.
+    status_t lockConvertedLocked(const BufferQueue::BufferItem& item,
+            LockedBuffer* nativeBuffer);
+
     // Tracking for buffers acquired by the user
     struct AcquiredBuffer {
         // Need to track the original mSlot index and the buffer itself because
@@ -120,10 +165,20 @@ class CpuConsumer : public ConsumerBase
         int mSlot;
         sp<GraphicBuffer> mGraphicBuffer;
         void *mBufferPointer;
+        // Whether the buffer was handed out from a persistent mapping
+        bool mPersistent;
+        // Whether mGraphicBuffer is mConvertedBuffer, the slot is then
+        // already released
+        bool mConverted;
+        // The buffer the slots are converted into for this entry, kept from
+        // one frame to the next
+        sp<GraphicBuffer> mConvertedBuffer;
 
         AcquiredBuffer() :
                 mSlot(BufferQueue::INVALID_BUFFER_SLOT),
-                mBufferPointer(NULL) {
+                mBufferPointer(NULL),
+                mPersistent(false),
+                mConverted(false) {
         }
     };
     Vector<AcquiredBuffer> mAcquiredBuffers;
@@ -131,6 +186,25 @@ class CpuConsumer : public ConsumerBase
     // Count of currently locked buffers
     uint32_t mCurrentLockedBuffers;
 
+    // Persistent CPU mappings, see setPersistentMapping
+    struct MappedSlot {
+        sp<GraphicBuffer> mGraphicBuffer;
+        void *mBufferPointer;
+        android_ycbcr mYCbCr;
+
+        MappedSlot() :
+                mBufferPointer(NULL),
+                mYCbCr(android_ycbcr()) {
+        }
+    };
+    MappedSlot mMappedSlots[BufferQueue::NUM_BUFFER_SLOTS];
+    bool mPersistentMapping;
+
+    // See setConvertedFormat, 0 if the buffers aren't converted
+    PixelFormat mConvertedFormat;
+    sp<BufferConverter> mConverter;
+    sp<IGraphicBufferAlloc> mGraphicBufferAlloc;
+
 };
 
 } // namespace android
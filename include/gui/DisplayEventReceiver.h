@@ -23,6 +23,7 @@
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
+#include <utils/Vector.h>
 
 #include <binder/IInterface.h>
 
@@ -54,6 +55,9 @@ public:
 
         struct VSync {
             uint32_t count;
+            // when the following vsync is expected, from SurfaceFlinger's
+            // vsync model; 0 if it isn't known
+            nsecs_t deadline __attribute__((aligned(8)));
         };
 
         struct Hotplug {
@@ -105,6 +109,17 @@ public:
     static ssize_t getEvents(const sp<BitTube>& dataChannel,
             Event* events, size_t count);
 
+    /*
+     * getLatestVsync drains the queue, reading several messages per system
+     * call, and returns the most recent vsync event in outVsync. The other
+     * events read are appended to outOtherEvents unless it is NULL.
+     * Returns how many vsync events were read, so all but one of them were
+     * missed, 0 if there were none, or a negative error code.
+     */
+    ssize_t getLatestVsync(Event* outVsync, Vector<Event>* outOtherEvents);
+    static ssize_t getLatestVsync(const sp<BitTube>& dataChannel,
+            Event* outVsync, Vector<Event>* outOtherEvents);
+
     /*
      * sendEvents write events to the queue and returns how many events were
      * written.
@@ -192,6 +192,11 @@ public:
     // getCurrentScalingMode returns the scaling mode of the current buffer.
     uint32_t getCurrentScalingMode() const;
 
+    // getCurrentSurfaceDamage returns the part of the current buffer that
+    // changed since the previous one, in buffer coordinates. It is invalid
+    // if unknown, meaning the whole buffer.
+    Rect getCurrentSurfaceDamage() const;
+
     // getCurrentFence returns the fence indicating when the current buffer is
     // ready to be read from.
     sp<Fence> getCurrentFence() const;
@@ -278,6 +283,12 @@ protected:
     // newly-acquired buffer.
     status_t updateAndReleaseLocked(const BufferQueue::BufferItem& item);
 
+    // Creates the EGLImage for a newly-acquired buffer ahead of
+    // updateAndReleaseLocked(), which then finds it already there. This
+    // needs no current context, so it may be called from any thread once
+    // mEglDisplay is known; NO_INIT is returned until then.
+    status_t createEglImageLocked(const BufferQueue::BufferItem& item);
+
     // Binds mTexName and the current buffer to mTexTarget.  Uses
     // mCurrentTexture if it's set, mCurrentTextureImage if not.  If the
     // bind succeeds, this calls doGLFenceWait.
@@ -312,6 +323,12 @@ private:
         // texture in the specified texture target.
         void bindToTextureTarget(uint32_t texTarget);
 
+        // isCreatedFor returns whether createIfNeeded has nothing to do for
+        // this display and crop-rect.
+        bool isCreatedFor(EGLDisplay display, const Rect& cropRect) const;
+
+        bool isCreated() const { return mEglImage != EGL_NO_IMAGE_KHR; }
+
         const sp<GraphicBuffer>& graphicBuffer() { return mGraphicBuffer; }
         const native_handle* graphicBufferHandle() {
             return mGraphicBuffer == NULL ? NULL : mGraphicBuffer->handle;
@@ -349,6 +366,26 @@ private:
         Rect mCropRect;
     };
 
+    // getEglImageLocked returns the EglImage to use for the buffer of the
+    // given image with the given crop: the image itself if it was created
+    // for that crop, one from mEglImageCache if one was, or a new one
+    // (which is then added to the cache) otherwise.
+    sp<EglImage> getEglImageLocked(const sp<EglImage>& image,
+            const Rect& cropRect);
+
+    // isEglImageInUseLocked returns whether the image is held by one of the
+    // slots, or is the current texture image.
+    bool isEglImageInUseLocked(const sp<EglImage>& image) const;
+
+    // isBufferInSlotLocked returns whether one of the slots holds the
+    // buffer of the given image.
+    bool isBufferInSlotLocked(const sp<EglImage>& image) const;
+
+    // trimEglImageCacheLocked evicts the images that aren't in use from
+    // mEglImageCache: all of those whose buffer was freed, and the least
+    // recently used others beyond MAX_UNUSED_EGL_IMAGES.
+    void trimEglImageCacheLocked();
+
     // freeBufferLocked frees up the given buffer slot. If the slot has been
     // initialized this will release the reference to the GraphicBuffer in that
     // slot and destroy the EGLImage in that slot.  Otherwise it has no effect.
@@ -391,6 +428,10 @@ private:
     // It gets set each time updateTexImage is called.
     Rect mCurrentCrop;
 
+    // mCurrentSurfaceDamage is the damage of the current texture, see
+    // getCurrentSurfaceDamage. It gets set each time updateTexImage is called.
+    Rect mCurrentSurfaceDamage;
+
     // mCurrentTransform is the transform identifier for the current texture. It
     // gets set each time updateTexImage is called.
     uint32_t mCurrentTransform;
@@ -510,6 +551,22 @@ private:
     // attachToContext.
     bool mAttached;
 
+    enum {
+        // Images that no slot uses any more, for other crops of the buffers
+        // still in the slots. Images of freed buffers aren't kept, as they
+        // would keep their buffer alive.
+        MAX_UNUSED_EGL_IMAGES = 4,
+    };
+
+    // mEglImageCache holds the EglImages this GLConsumer created, most
+    // recently used first, so that a buffer that comes back with a crop it
+    // had before doesn't need a new EGLImage. The counters below are
+    // reported by dumpLocked.
+    Vector< sp<EglImage> > mEglImageCache;
+    uint32_t mEglImageCacheHits;
+    uint32_t mEglImageCacheMisses;
+    uint32_t mEglImageCacheEvictions;
+
     // protects static initialization
     static Mutex sStaticInitLock;
 
@@ -23,6 +23,7 @@
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
+#include <utils/Vector.h>
 
 #include <binder/IInterface.h>
 #include <ui/Rect.h>
@@ -108,6 +109,17 @@ public:
         // Indicates this buffer must be transformed by the inverse transform of the screen
         // it is displayed onto. This is applied after mTransform.
         bool mTransformToDisplayInverse;
+
+        // mSurfaceDamage is the part of the buffer, in buffer coordinates, that
+        // changed since the previous frame of the producer. It is invalid when
+        // unknown, meaning the whole buffer.
+        Rect mSurfaceDamage;
+
+        // mDroppedFrameCount is how many queued frames acquireBuffer dropped
+        // to get to this one. Unlike the gap in frame numbers, it doesn't
+        // count the frames that replaced each other in the queue, which the
+        // consumer listener was never told about.
+        uint32_t mDroppedFrameCount;
     };
 
     enum {
@@ -205,6 +217,39 @@ public:
             EGLDisplay display, EGLSyncKHR fence,
             const sp<Fence>& releaseFence) = 0;
 
+    // acquireBuffers acquires up to maxCount of the pending buffers at once,
+    // oldest first, and appends them to outBuffers. Each one is acquired as
+    // acquireBuffer would, but the BufferQueue is locked, and called through
+    // Binder, only once for all of them. The batch ends early at the first
+    // buffer that can't be acquired, which is only an error if it was the
+    // first one.
+    //
+    // Return of NO_ERROR means at least one buffer was acquired. Otherwise
+    // the value is the one acquireBuffer would have returned, or BAD_VALUE
+    // if maxCount is 0 or outBuffers is NULL.
+    virtual status_t acquireBuffers(size_t maxCount,
+            Vector<BufferItem>* outBuffers, nsecs_t presentWhen) = 0;
+
+    // A buffer for releaseBuffers to give back: its slot, the frame number
+    // it was acquired with and the fence to signal once it is idle.
+    struct ReleasedBuffer {
+        int mBuf;
+        uint64_t mFrameNumber;
+        sp<Fence> mFence;
+    };
+
+    // releaseBuffers releases several buffer slots at once, as releaseBuffer
+    // would release each of them, locking the BufferQueue and calling
+    // through Binder only once. All the buffers are handled even if some of
+    // them fail. The slots for which releaseBuffer would have returned
+    // STALE_BUFFER_SLOT are set in outStaleSlots, one bit per slot.
+    //
+    // Return of NO_ERROR means every buffer was released or was stale.
+    // Otherwise the value is the first error releaseBuffer would have
+    // returned for one of the buffers.
+    virtual status_t releaseBuffers(const Vector<ReleasedBuffer>& buffers,
+            uint64_t* outStaleSlots) = 0;
+
     // consumerConnect connects a consumer to the BufferQueue.  Only one
     // consumer may be connected, and when that consumer disconnects the
     // BufferQueue is placed into the "abandoned" state, causing most
@@ -304,12 +349,28 @@ public:
     // Return of a value other than NO_ERROR means an unknown error has occurred.
     virtual status_t setTransformHint(uint32_t hint) = 0;
 
+    // setDropLateFrames makes acquireBuffer drop the queued buffers that
+    // have been superseded by a later buffer whose desired present time has
+    // passed, even when their timestamps were generated automatically by
+    // Surface. By default only buffers with explicit timestamps are
+    // dropped.
+    //
+    // Return of a value other than NO_ERROR means an unknown error has occurred.
+    virtual status_t setDropLateFrames(bool enabled) = 0;
+
     // Retrieve the sideband buffer stream, if any.
     virtual sp<NativeHandle> getSidebandStream() const = 0;
 
     // dump state into a string
     virtual void dump(String8& result, const char* prefix) const = 0;
 
+    // dumpLatencyStats appends histograms of where the frames released so
+    // far spent their time: waiting in dequeueBuffer, between dequeue and
+    // queue (producer), between queue and the acquire fence signaling
+    // (GPU), in the queue, and between acquire and release (consumer).
+    // If clear is true the histograms are reset afterwards.
+    virtual void dumpLatencyStats(String8& result, bool clear) = 0;
+
 public:
     DECLARE_META_INTERFACE(GraphicBufferConsumer);
 };
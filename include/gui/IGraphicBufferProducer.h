@@ -284,7 +284,7 @@ public:
                 const sp<Fence>& fence, uint32_t sticky = 0)
         : timestamp(timestamp), isAutoTimestamp(isAutoTimestamp), crop(crop),
           scalingMode(scalingMode), transform(transform), stickyTransform(sticky),
-          async(async), fence(fence) { }
+          async(async), fence(fence) { surfaceDamage.makeInvalid(); }
         inline void deflate(int64_t* outTimestamp, bool* outIsAutoTimestamp,
                 Rect* outCrop, int* outScalingMode, uint32_t* outTransform,
                 bool* outAsync, sp<Fence>* outFence,
@@ -301,6 +301,13 @@ public:
             }
         }
 
+        // surfaceDamage - the part of the buffer, in buffer coordinates, that
+        //                 changed since the previous buffer queued by the same
+        //                 producer. It is invalid (the default) if unknown,
+        //                 in which case the whole buffer is assumed damaged.
+        inline const Rect& getSurfaceDamage() const { return surfaceDamage; }
+        inline void setSurfaceDamage(const Rect& damage) { surfaceDamage = damage; }
+
         // Flattenable protocol
         size_t getFlattenedSize() const;
         size_t getFdCount() const;
@@ -315,6 +322,7 @@ public:
         uint32_t transform;
         uint32_t stickyTransform;
         int async;
+        Rect surfaceDamage;
         sp<Fence> fence;
     };
 
@@ -453,6 +461,29 @@ public:
     // allocated, this function has no effect.
     virtual void allocateBuffers(bool async, uint32_t width, uint32_t height,
             uint32_t format, uint32_t usage) = 0;
+
+    // getControlChannel returns, in outFd, an ashmem fd through which a
+    // connected producer may make dequeueBuffer/queueBuffer/cancelBuffer
+    // calls without a binder transaction (see BufferQueueControl.h). The
+    // caller owns the returned fd. The channel is closed when the producer
+    // disconnects.
+    //
+    // Returns INVALID_OPERATION if the implementation doesn't support it and
+    // NO_INIT if no producer is connected.
+    virtual status_t getControlChannel(int* outFd) = 0;
+
+    // attachAndQueueBuffer is attachBuffer followed by queueBuffer of the
+    // returned slot, made in a single call. It is meant for callers that
+    // hand the same buffer to several queues (see StreamSplitter) and don't
+    // mirror slot->buffer mappings, so the flags returned by attachBuffer
+    // are dropped.
+    //
+    // If attaching fails its error is returned and nothing was queued;
+    // otherwise the result of queueBuffer is returned and outSlot is the slot
+    // the buffer was attached to.
+    virtual status_t attachAndQueueBuffer(int* outSlot,
+            const sp<GraphicBuffer>& buffer, const QueueBufferInput& input,
+            QueueBufferOutput* output) = 0;
 };
 
 // ----------------------------------------------------------------------------
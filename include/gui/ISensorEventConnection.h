@@ -22,6 +22,8 @@
 
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
 
 #include <binder/IInterface.h>
 
@@ -35,11 +37,29 @@ class ISensorEventConnection : public IInterface
 public:
     DECLARE_META_INTERFACE(SensorEventConnection);
 
+    // The arguments of one enableDisable() call.
+    struct SensorConfig {
+        int32_t handle;
+        bool    enabled;
+        nsecs_t samplingPeriodNs;
+        nsecs_t maxBatchReportLatencyNs;
+        int32_t reservedFlags;
+    };
+
     virtual sp<BitTube> getSensorChannel() const = 0;
     virtual status_t enableDisable(int handle, bool enabled, nsecs_t samplingPeriodNs,
                                    nsecs_t maxBatchReportLatencyNs, int reservedFlags) = 0;
     virtual status_t setEventRate(int handle, nsecs_t ns) = 0;
     virtual status_t flush() = 0;
+    // Returns a dup of the ashmem fd of a SensorEventRing through which
+    // events are delivered from then on, instead of the sensor channel. It
+    // must be asked for before any sensor is enabled.
+    virtual status_t getEventRing(int* outFd) = 0;
+    // Applies each config as enableDisable() would, in order, with a single
+    // transaction. outResults gets the result of each of them. The default
+    // implementation calls enableDisable() for each config.
+    virtual status_t configureSensors(const Vector<SensorConfig>& configs,
+                                      Vector<status_t>* outResults);
 };
 
 // ----------------------------------------------------------------------------
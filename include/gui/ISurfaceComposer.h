@@ -22,11 +22,14 @@
 
 #include <utils/RefBase.h>
 #include <utils/Errors.h>
+#include <utils/String8.h>
 #include <utils/Timers.h>
 #include <utils/Vector.h>
 
 #include <binder/IInterface.h>
 
+#include <ui/CompositionTiming.h>
+#include <ui/FrameStatInfo.h>
 #include <ui/FrameStats.h>
 #include <ui/PixelFormat.h>
 
@@ -165,6 +168,21 @@ public:
      * Requires the ACCESS_SURFACE_FLINGER permission.
      */
     virtual status_t getAnimationFrameStats(FrameStats* outStats) const = 0;
+
+    /* Gets a summary of the frame statistics of every layer, along with
+     * their names. The first entry is for animations.
+     *
+     * Requires the ACCESS_SURFACE_FLINGER permission.
+     */
+    virtual status_t getLayerFrameStatInfo(Vector<String8>* outNames,
+            Vector<FrameStatInfo>* outInfos) const = 0;
+
+    /* Gets the phase timings of the most recent refreshes, oldest first.
+     *
+     * Requires the ACCESS_SURFACE_FLINGER permission.
+     */
+    virtual status_t getCompositionTimeline(
+            Vector<CompositionTiming>* outTimings) const = 0;
 };
 
 // ----------------------------------------------------------------------------
@@ -192,6 +210,8 @@ public:
         GET_ANIMATION_FRAME_STATS,
         SET_POWER_MODE,
         GET_DISPLAY_STATS,
+        GET_LAYER_FRAME_STAT_INFO,
+        GET_COMPOSITION_TIMELINE,
     };
 
     virtual status_t onTransact(uint32_t code, const Parcel& data,
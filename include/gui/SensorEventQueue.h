@@ -23,8 +23,10 @@
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
+#include <utils/Vector.h>
 
 #include <gui/BitTube.h>
+#include <gui/ISensorEventConnection.h>
 
 // ----------------------------------------------------------------------------
 #define WAKE_UP_SENSOR_EVENT_NEEDS_ACK (1U << 31)
@@ -42,10 +44,23 @@ namespace android {
 
 class ISensorEventConnection;
 class Sensor;
+class SensorEventRing;
 class Looper;
 
 // ----------------------------------------------------------------------------
 
+// An event of a sensor with at most three values, such as the accelerometer, the gyroscope or
+// the magnetic field: 32 bytes instead of the 104 of ASensorEvent.
+struct CompactSensorEvent {
+    int64_t timestamp;
+    int32_t sensor;
+    int32_t type;
+    float values[3];
+    uint32_t flags;
+};
+
+// ----------------------------------------------------------------------------
+
 class SensorEventQueue : public ASensorEventQueue, public RefBase
 {
 public:
@@ -61,7 +76,11 @@ public:
     static ssize_t write(const sp<BitTube>& tube,
             ASensorEvent const* events, size_t numEvents);
 
+    // When numEvents is at least MAX_RECEIVE_BUFFER_EVENT_COUNT, events are received straight
+    // into the caller's buffer instead of going through an internal one.
     ssize_t read(ASensorEvent* events, size_t numEvents);
+    // Same as read() but only keeps the first three values of each event.
+    ssize_t readCompact(CompactSensorEvent* events, size_t numEvents);
 
     status_t waitForEvent() const;
     status_t wake() const;
@@ -75,18 +94,39 @@ public:
                           int reservedFlags) const;
     status_t disableSensor(int32_t handle) const;
     status_t flush() const;
+
+    // Enables, disables or reconfigures several sensors with one call to the
+    // sensor service. results gets the status of each config, in order.
+    status_t configureSensors(
+            const Vector<ISensorEventConnection::SensorConfig>& configs,
+            Vector<status_t>* results) const;
+
+    // When window is not 0, a flush() requested less than window after the
+    // previous one is merged with it: it returns NO_ERROR without asking the
+    // service, so no flush complete event comes for it. Disabled by default.
+    void setFlushCoalescingWindow(nsecs_t window);
     // Send an ack for every wake_up sensor event that is set to WAKE_UP_SENSOR_EVENT_NEEDS_ACK.
     void sendAck(const ASensorEvent* events, int count);
+    void sendAck(const CompactSensorEvent* events, int count);
 private:
     sp<Looper> getLooper() const;
+    ssize_t readFromRing(ASensorEvent* events, size_t numEvents);
+    // Fills mRecBuffer if it is empty, returns how many events are in it.
+    ssize_t fillRecBuffer();
+    void sendPendingAcks();
+    bool sendToService(uint32_t count);
     sp<ISensorEventConnection> mSensorEventConnection;
     sp<BitTube> mSensorChannel;
+    // when set, events arrive here and mSensorChannel only wakes us up
+    sp<SensorEventRing> mRing;
     mutable Mutex mLock;
     mutable sp<Looper> mLooper;
     ASensorEvent* mRecBuffer;
     size_t mAvailable;
     size_t mConsumed;
     uint32_t mNumAcksToSend;
+    nsecs_t mFlushCoalescingWindow;
+    mutable nsecs_t mLastFlushTime;
 };
 
 // ----------------------------------------------------------------------------
@@ -20,6 +20,8 @@
 #include <gui/IConsumerListener.h>
 #include <gui/IProducerListener.h>
 
+#include <ui/Fence.h>
+
 #include <utils/Condition.h>
 #include <utils/KeyedVector.h>
 #include <utils/Mutex.h>
@@ -131,9 +133,11 @@ private:
         BufferTracker(const sp<GraphicBuffer>& buffer);
 
         const sp<GraphicBuffer>& getBuffer() const { return mBuffer; }
-        const sp<Fence>& getMergedFence() const { return mMergedFence; }
 
-        void mergeFence(const sp<Fence>& with);
+        // addFence adds an output's release fence; mergeFences returns a
+        // fence covering all of the ones that are still pending.
+        void addFence(const sp<Fence>& fence);
+        sp<Fence> mergeFences();
 
         // Returns the new value
         // Only called while mMutex is held
@@ -149,7 +153,7 @@ private:
         BufferTracker& operator=(const BufferTracker& other);
 
         sp<GraphicBuffer> mBuffer; // One instance that holds this native handle
-        sp<Fence> mMergedFence;
+        FenceSet mReleaseFences;
         size_t mReleaseCount;
     };
 
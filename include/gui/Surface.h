@@ -31,6 +31,20 @@ struct ANativeWindow_Buffer;
 
 namespace android {
 
+class BufferQueueControlClient;
+
+/*
+ * Surface specific perform() operations, numbered well clear of the ones in
+ * system/window.h.
+ */
+enum {
+    // Takes an int: non-zero enables dequeue-ahead, see
+    // Surface::setDequeueAhead.
+    NATIVE_WINDOW_SET_DEQUEUE_AHEAD = 0x1000,
+    // Takes an android_native_rect_t const*, see Surface::setSurfaceDamage.
+    NATIVE_WINDOW_SET_SURFACE_DAMAGE = 0x1001,
+};
+
 /*
  * An implementation of ANativeWindow that feeds graphics buffers into a
  * BufferQueue.
@@ -101,6 +115,27 @@ public:
      */
     void allocateBuffers();
 
+    /* Enables or disables dequeue-ahead.
+     *
+     * While enabled, each successful queueBuffer starts dequeueing the next
+     * buffer on a background thread, so that the binder call and any wait
+     * for a free slot are out of the way by the time dequeueBuffer is
+     * called. If the buffer parameters changed in between, the prefetched
+     * buffer is canceled and dequeueBuffer dequeues a new one as usual.
+     *
+     * This keeps one more buffer dequeued between frames, so it is only
+     * worth it with enough buffers in the queue. Disabled by default.
+     */
+    void setDequeueAhead(bool enabled);
+
+    /* Sets the part of the next queued buffer, in buffer coordinates, that
+     * differs from the previously queued one, letting the consumer update
+     * only that area. An invalid rect (the default) means the whole buffer.
+     * It applies to the next queueBuffer only. lock() sets it from the
+     * dirty region it returns.
+     */
+    void setSurfaceDamage(const Rect& damage);
+
 protected:
     virtual ~Surface();
 
@@ -146,6 +181,8 @@ private:
     int dispatchLock(va_list args);
     int dispatchUnlockAndPost(va_list args);
     int dispatchSetSidebandStream(va_list args);
+    int dispatchSetDequeueAhead(va_list args);
+    int dispatchSetSurfaceDamage(va_list args);
 
 protected:
     virtual int dequeueBuffer(ANativeWindowBuffer** buffer, int* fenceFd);
@@ -226,6 +263,11 @@ private:
     // that gets queued. It is set by calling setCrop.
     Rect mCrop;
 
+    // mSurfaceDamage is the damage that will be sent with the next buffer
+    // that gets queued. It is set by calling setSurfaceDamage or lock, and
+    // invalidated by each queueBuffer.
+    Rect mSurfaceDamage;
+
     // mScalingMode is the scaling mode that will be used for the next
     // buffers that get queued. It is set by calling setScalingMode.
     int mScalingMode;
@@ -274,6 +316,17 @@ private:
     // one buffer behind the producer.
     mutable bool mConsumerRunningBehind;
 
+    // mControlChannel, if set, carries dequeueBuffer and fence-less
+    // queueBuffer/cancelBuffer calls to the BufferQueue without binder. It
+    // is obtained at connect time when the debug.gui.control_channel
+    // property is set, and dropped on disconnect.
+    sp<BufferQueueControlClient> mControlChannel;
+
+    // mDequeueAhead is the thread prefetching the next buffer while
+    // dequeue-ahead is enabled, see setDequeueAhead.
+    class DequeueAhead;
+    sp<DequeueAhead> mDequeueAhead;
+
     // mMutex is the mutex used to prevent concurrent access to the member
     // variables of Surface objects. It must be locked whenever the
     // member variables are accessed.
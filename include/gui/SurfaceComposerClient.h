@@ -28,6 +28,8 @@
 #include <utils/SortedVector.h>
 #include <utils/threads.h>
 
+#include <ui/CompositionTiming.h>
+#include <ui/FrameStatInfo.h>
 #include <ui/FrameStats.h>
 #include <ui/PixelFormat.h>
 
@@ -40,6 +42,9 @@ namespace android {
 
 class DisplayInfo;
 class Composer;
+struct ComposerState;
+struct DisplayState;
+struct layer_state_t;
 class ISurfaceComposerClient;
 class IGraphicBufferProducer;
 class Region;
@@ -123,6 +128,98 @@ public:
     //! Flag the currently open transaction as an animation transaction.
     static void setAnimationTransaction();
 
+    // ------------------------------------------------------------------------
+    // Explicit transactions
+    //
+    // A Transaction collects changes to surfaces and displays like the global
+    // transaction, but belongs to whoever created it rather than to the
+    // process: it takes no lock, so threads each building their own don't
+    // contend with one another, and apply() commits all its changes at once.
+    // A Transaction must not be used by several threads at a time. It is
+    // independent of the global transaction, whose changes are not part of
+    // it even while a global transaction is open.
+    class Transaction {
+    public:
+        Transaction();
+        ~Transaction();
+
+        status_t setPosition(const sp<SurfaceControl>& sc, float x, float y);
+        status_t setSize(const sp<SurfaceControl>& sc, uint32_t w, uint32_t h);
+        status_t setLayer(const sp<SurfaceControl>& sc, int32_t z);
+        status_t setFlags(const sp<SurfaceControl>& sc, uint32_t flags,
+                uint32_t mask);
+        status_t show(const sp<SurfaceControl>& sc);
+        status_t hide(const sp<SurfaceControl>& sc);
+        status_t setTransparentRegionHint(const sp<SurfaceControl>& sc,
+                const Region& transparentRegion);
+        status_t setAlpha(const sp<SurfaceControl>& sc, float alpha);
+        status_t setMatrix(const sp<SurfaceControl>& sc,
+                float dsdx, float dtdx, float dsdy, float dtdy);
+        status_t setCrop(const sp<SurfaceControl>& sc, const Rect& crop);
+        status_t setLayerStack(const sp<SurfaceControl>& sc,
+                uint32_t layerStack);
+
+        void setDisplaySurface(const sp<IBinder>& token,
+                const sp<IGraphicBufferProducer>& bufferProducer);
+        void setDisplayLayerStack(const sp<IBinder>& token,
+                uint32_t layerStack);
+        void setDisplayProjection(const sp<IBinder>& token,
+                uint32_t orientation,
+                const Rect& layerStackRect,
+                const Rect& displayRect);
+        void setDisplaySize(const sp<IBinder>& token,
+                uint32_t width, uint32_t height);
+
+        //! Flag the transaction as an animation transaction.
+        void setAnimation();
+
+        //! Send the changes to SurfaceFlinger in a single IPC, and start
+        //! over with an empty transaction.
+        status_t apply(bool synchronous = false);
+
+    private:
+        friend class Composer;
+
+        // can't be copied
+        Transaction(const Transaction& rhs);
+        Transaction& operator = (const Transaction& rhs);
+
+        layer_state_t* getLayerState(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id);
+        DisplayState& getDisplayState(const sp<IBinder>& token);
+
+        // moves the changes out of the transaction and returns the flags
+        // to send them with
+        uint32_t take(Vector<ComposerState>* outStates,
+                Vector<DisplayState>* outDisplayStates, bool synchronous);
+
+        status_t setPosition(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id, float x, float y);
+        status_t setSize(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id, uint32_t w, uint32_t h);
+        status_t setLayer(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id, int32_t z);
+        status_t setFlags(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id, uint32_t flags, uint32_t mask);
+        status_t setTransparentRegionHint(
+                const sp<SurfaceComposerClient>& client, const sp<IBinder>& id,
+                const Region& transparentRegion);
+        status_t setAlpha(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id, float alpha);
+        status_t setMatrix(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id,
+                float dsdx, float dtdx, float dsdy, float dtdy);
+        status_t setCrop(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id, const Rect& crop);
+        status_t setLayerStack(const sp<SurfaceComposerClient>& client,
+                const sp<IBinder>& id, uint32_t layerStack);
+
+        SortedVector<ComposerState> mComposerStates;
+        SortedVector<DisplayState>  mDisplayStates;
+        bool                        mForceSynchronous;
+        bool                        mAnimation;
+    };
+
     status_t    hide(const sp<IBinder>& id);
     status_t    show(const sp<IBinder>& id);
     status_t    setFlags(const sp<IBinder>& id, uint32_t flags, uint32_t mask);
@@ -141,6 +238,10 @@ public:
 
     static status_t clearAnimationFrameStats();
     static status_t getAnimationFrameStats(FrameStats* outStats);
+    static status_t getLayerFrameStatInfo(Vector<String8>* outNames,
+            Vector<FrameStatInfo>* outInfos);
+    static status_t getCompositionTimeline(
+            Vector<CompositionTiming>* outTimings);
 
     static void setDisplaySurface(const sp<IBinder>& token,
             const sp<IGraphicBufferProducer>& bufferProducer);
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_YUVPLANES_H
+#define ANDROID_GUI_YUVPLANES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <gui/CpuConsumer.h>
+
+namespace android {
+
+/*
+ * Helpers for the usual first steps of processing a CpuConsumer buffer on
+ * the CPU. They work on strided 8 bit planes, row by row, and are vectorized
+ * on ARM. Strides are in bytes.
+ */
+
+// copyPlane copies height rows of width bytes.
+void copyPlane(uint8_t* dst, size_t dstStride,
+        const uint8_t* src, size_t srcStride, size_t width, size_t height);
+
+// splitChroma copies the chroma planes of a locked YUV buffer into two
+// planar ones of chromaWidth x chromaHeight samples, whether Cb and Cr are
+// interleaved or not. Returns BAD_VALUE if the buffer has no chroma planes.
+status_t splitChroma(const CpuConsumer::LockedBuffer& buffer,
+        uint8_t* dstCb, uint8_t* dstCr, size_t dstStride);
+
+// downsamplePlane halves a plane in both directions, each destination sample
+// being the rounded average of 2x2 source samples. width and height are the
+// size of the destination; the source must have twice as many rows and
+// columns.
+void downsamplePlane(uint8_t* dst, size_t dstStride,
+        const uint8_t* src, size_t srcStride, size_t width, size_t height);
+
+}; // namespace android
+
+#endif // ANDROID_GUI_YUVPLANES_H
@@ -21,6 +21,9 @@
  * Native input event structures.
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <android/input.h>
 #include <utils/BitSet.h>
 #include <utils/KeyedVector.h>
@@ -256,6 +259,107 @@ struct PointerProperties {
     void copyFrom(const PointerProperties& other);
 };
 
+/*
+ * A vector for the pointers and samples of a MotionEvent. Unlike Vector,
+ * clearing it keeps its storage: a MotionEvent that is reused, like the one
+ * of a PreallocatedInputEventFactory or the ones PooledInputEventFactory
+ * recycles, then only reallocates when a batch is deeper than any it held
+ * before. Items are moved with memcpy, so T must be a plain struct.
+ */
+template <typename T>
+class RetainingVector {
+public:
+    RetainingVector() : mArray(NULL), mSize(0), mCapacity(0) { }
+    RetainingVector(const RetainingVector<T>& other) :
+            mArray(NULL), mSize(0), mCapacity(0) {
+        appendArray(other.mArray, other.mSize);
+    }
+    ~RetainingVector() { free(mArray); }
+
+    RetainingVector<T>& operator=(const RetainingVector<T>& other) {
+        if (this != &other) {
+            mSize = 0;
+            appendArray(other.mArray, other.mSize);
+        }
+        return *this;
+    }
+
+    inline size_t size() const { return mSize; }
+    inline bool isEmpty() const { return mSize == 0; }
+    inline size_t capacity() const { return mCapacity; }
+    inline const T* array() const { return mArray; }
+    inline const T& operator[](size_t index) const { return mArray[index]; }
+    inline const T& itemAt(size_t index) const { return mArray[index]; }
+    inline T& editItemAt(size_t index) { return mArray[index]; }
+    inline T& editTop() { return mArray[mSize - 1]; }
+
+    // Removes all the items, keeping the storage.
+    inline void clear() { mSize = 0; }
+
+    // Makes room for at least capacity items. Never shrinks the storage.
+    // On failure the storage is left as it was.
+    status_t setCapacity(size_t capacity) {
+        if (capacity <= mCapacity) {
+            return OK;
+        }
+        if (capacity > size_t(-1) / sizeof(T)) {
+            return NO_MEMORY;
+        }
+        T* array = static_cast<T*>(realloc(mArray, capacity * sizeof(T)));
+        if (!array) {
+            return NO_MEMORY;
+        }
+        mArray = array;
+        mCapacity = capacity;
+        return OK;
+    }
+
+    // Appends a cleared item.
+    ssize_t push() {
+        if (mSize == mCapacity && grow(1)) {
+            return NO_MEMORY;
+        }
+        mArray[mSize].clear();
+        return mSize++;
+    }
+
+    ssize_t push(const T& item) {
+        if (mSize == mCapacity && grow(1)) {
+            return NO_MEMORY;
+        }
+        mArray[mSize] = item;
+        return mSize++;
+    }
+
+    ssize_t appendArray(const T* items, size_t count) {
+        if (count > size_t(-1) - mSize) {
+            return NO_MEMORY;
+        }
+        if (mSize + count > mCapacity && grow(count)) {
+            return NO_MEMORY;
+        }
+        memcpy(mArray + mSize, items, count * sizeof(T));
+        const size_t index = mSize;
+        mSize += count;
+        return index;
+    }
+
+private:
+    status_t grow(size_t count) {
+        const size_t needed = mSize + count;
+        if (needed < 4) {
+            return setCapacity(4);
+        }
+        // Grow by half again, unless that would overflow.
+        const size_t capacity = needed + needed / 2;
+        return setCapacity(capacity > needed ? capacity : needed);
+    }
+
+    T* mArray;
+    size_t mSize;
+    size_t mCapacity;
+};
+
 /*
  * Input events.
  */
@@ -540,6 +644,11 @@ public:
             nsecs_t eventTime,
             const PointerCoords* pointerCoords);
 
+    // Makes room for sampleCount samples of pointerCount pointers, so that
+    // initializing the event and adding that many samples doesn't
+    // reallocate. The storage is kept when the event is initialized again.
+    void reserveSamples(size_t sampleCount, size_t pointerCount);
+
     void offsetLocation(float xOffset, float yOffset);
 
     void scale(float scaleFactor);
@@ -581,9 +690,9 @@ protected:
     float mXPrecision;
     float mYPrecision;
     nsecs_t mDownTime;
-    Vector<PointerProperties> mPointerProperties;
-    Vector<nsecs_t> mSampleEventTimes;
-    Vector<PointerCoords> mSamplePointerCoords;
+    RetainingVector<PointerProperties> mPointerProperties;
+    RetainingVector<nsecs_t> mSampleEventTimes;
+    RetainingVector<PointerCoords> mSamplePointerCoords;
 };
 
 /*
@@ -619,6 +728,8 @@ private:
 
 /*
  * An input event factory implementation that maintains a pool of input events.
+ * Motion events keep their storage while pooled, and new ones are made with
+ * room for as many samples and pointers as the deepest batch recycled so far.
  */
 class PooledInputEventFactory : public InputEventFactoryInterface {
 public:
@@ -635,6 +746,10 @@ private:
 
     Vector<KeyEvent*> mKeyEventPool;
     Vector<MotionEvent*> mMotionEventPool;
+
+    // The most samples and pointers seen in a recycled motion event.
+    size_t mMotionSampleCount;
+    size_t mMotionPointerCount;
 };
 
 } // namespace android
@@ -27,7 +27,10 @@
  * The InputConsumer is used by the application to receive events from the input dispatcher.
  */
 
+#include <stddef.h>
+
 #include <input/Input.h>
+#include <input/TouchPredictor.h>
 #include <utils/Errors.h>
 #include <utils/Timers.h>
 #include <utils/RefBase.h>
@@ -48,6 +51,9 @@ struct InputMessage {
         TYPE_KEY = 1,
         TYPE_MOTION = 2,
         TYPE_FINISHED = 3,
+        // A TYPE_MOTION message in the encoding of Body::CompactMotion.  Only used on the
+        // wire: InputChannel converts motion messages to and from it.
+        TYPE_MOTION_COMPACT = 4,
     };
 
     struct Header {
@@ -112,6 +118,21 @@ struct InputMessage {
             }
         } motion;
 
+        // The fields of Motion that precede its pointers, as is, followed by each
+        // pointer's properties, its axis bits and the values of the axes present in
+        // the bits only.  Most pointers only have a handful of axes, so this is a
+        // fraction of the size of the full PointerCoords.
+        struct CompactMotion {
+            uint8_t fields[offsetof(Motion, pointers)];
+            uint32_t dataSize;
+            uint32_t padding;
+            uint8_t data[sizeof(Motion::Pointer) * MAX_POINTERS];
+
+            inline size_t size() const {
+                return sizeof(CompactMotion) - sizeof(data) + dataSize;
+            }
+        } compactMotion;
+
         struct Finished {
             uint32_t seq;
             bool handled;
@@ -124,6 +145,11 @@ struct InputMessage {
 
     bool isValid(size_t actualSize) const;
     size_t size() const;
+
+    // Converts between a TYPE_MOTION message and its TYPE_MOTION_COMPACT encoding.
+    // decodeCompactMotion returns false if the encoded message is malformed.
+    static void encodeCompactMotion(const InputMessage& msg, InputMessage* outMsg);
+    static bool decodeCompactMotion(const InputMessage& msg, InputMessage* outMsg);
 };
 
 /*
@@ -151,6 +177,12 @@ public:
     inline String8 getName() const { return mName; }
     inline int getFd() const { return mFd; }
 
+    /* Sets whether motion messages are sent in their compact encoding.  Enabled by default.
+     * Both encodings are always accepted by receiveMessage, which hands out motion
+     * messages in their full form regardless.
+     */
+    inline void setCompactMotionEncoding(bool enabled) { mCompactMotionEncoding = enabled; }
+
     /* Sends a message to the other endpoint.
      *
      * If the channel is full then the message is guaranteed not to have been sent at all.
@@ -176,12 +208,40 @@ public:
      */
     status_t receiveMessage(InputMessage* msg);
 
+    /* Converts a message to the form it is sent in on this channel, see
+     * setCompactMotionEncoding().
+     */
+    void encodeMessage(const InputMessage* msg, InputMessage* outMsg) const;
+
+    /* Sends several messages, encoded by encodeMessage(), with as few system calls as
+     * possible.  The messages are sent in order and stop at the first one that can't be
+     * sent.  The number of messages sent is returned in *outSent.
+     *
+     * Returns OK if all the messages were sent, or the error sendMessage() would have
+     * returned for the first message that wasn't.
+     */
+    status_t sendMessages(const InputMessage* msgs, size_t count, size_t* outSent);
+
+    /* Receives as many of the pending messages as fit in msgs with as few system calls as
+     * possible.  The number of messages received is returned in *outReceived.
+     *
+     * Returns OK if at least one message was received.  If a message is invalid, the
+     * messages before it are still returned and BAD_VALUE is returned on the next call.
+     * Otherwise returns the errors of receiveMessage().
+     */
+    status_t receiveMessages(InputMessage* msgs, size_t count, size_t* outReceived);
+
     /* Returns a new object that has a duplicate of this channel's fd. */
     sp<InputChannel> dup() const;
 
 private:
     String8 mName;
     int mFd;
+    bool mCompactMotionEncoding;
+    // The error of an invalid message dropped by receiveMessages(), to be returned next.
+    status_t mPendingReceiveError;
+
+    status_t checkReceivedMessage(InputMessage* msg, size_t size);
 };
 
 /*
@@ -246,6 +306,26 @@ public:
             const PointerProperties* pointerProperties,
             const PointerCoords* pointerCoords);
 
+    enum { MAX_BATCH_SIZE = 8 };
+
+    /* Starts a batch: until endBatch() is called, the events published by publishKeyEvent()
+     * and publishMotionEvent() are queued, then sent together by endBatch().  This saves a
+     * system call per event when several of them are ready to go out.
+     *
+     * The publish methods only fail if their arguments are invalid while batching, or with
+     * NO_MEMORY once MAX_BATCH_SIZE events are queued.
+     */
+    void beginBatch();
+
+    /* Sends the events queued since beginBatch() and ends the batch.  The events are sent
+     * in order and stop at the first one that can't be sent.  The number of events sent is
+     * returned in *outPublished.
+     *
+     * Returns OK if all the events were sent, or the error the publish method would have
+     * returned for the first event that wasn't.
+     */
+    status_t endBatch(size_t* outPublished);
+
     /* Receives the finished signal from the consumer in reply to the original dispatch signal.
      * If a signal was received, returns the message sequence number,
      * and whether the consumer handled the message.
@@ -261,6 +341,15 @@ public:
 
 private:
     sp<InputChannel> mChannel;
+
+    // The messages queued since beginBatch(), already encoded for the channel.
+    // mBatch only grows to the largest batch published so far; most connections
+    // never see more than one event at a time.
+    bool mBatching;
+    size_t mBatchSize;
+    Vector<InputMessage> mBatch;
+
+    status_t publishMessage(const InputMessage* msg);
 };
 
 /*
@@ -342,12 +431,26 @@ private:
     // True if touch resampling is enabled.
     const bool mResampleTouch;
 
+    // How far past the frame time touch positions are predicted, and the
+    // TouchPredictor used for it. No prediction is done if the horizon is 0.
+    // Both come from system properties and apply to every touch device.
+    const nsecs_t mPredictionHorizon;
+    String8 mPredictorName;
+
     // The input channel.
     sp<InputChannel> mChannel;
 
     // The current input message.
     InputMessage mMsg;
 
+    // Messages received from the channel in one go and not handled yet: the ones from
+    // mReceivedIndex to mReceivedCount.  mReceived holds one message until a receive
+    // fills it, then grows to RECEIVE_BATCH_SIZE.
+    enum { RECEIVE_BATCH_SIZE = 8 };
+    Vector<InputMessage> mReceived;
+    size_t mReceivedIndex;
+    size_t mReceivedCount;
+
     // True if mMsg contains a valid input message that was deferred from the previous
     // call to consume and that still needs to be handled.
     bool mMsgDeferred;
@@ -387,6 +490,8 @@ private:
         size_t historySize;
         History history[2];
         History lastResample;
+        // only set when touch prediction is enabled
+        sp<TouchPredictor> predictor;
 
         void initialize(int32_t deviceId, int32_t source) {
             this->deviceId = deviceId;
@@ -395,6 +500,9 @@ private:
             historySize = 0;
             lastResample.eventTime = 0;
             lastResample.idBits.clear();
+            if (predictor != NULL) {
+                predictor->clear();
+            }
         }
 
         void addHistory(const InputMessage* msg) {
@@ -403,6 +511,19 @@ private:
                 historySize += 1;
             }
             history[historyCurrent].initializeFrom(msg);
+            if (predictor != NULL) {
+                const History& current(history[historyCurrent]);
+                VelocityTracker::Position positions[MAX_POINTERS];
+                uint32_t count = 0;
+                for (BitSet32 idBits(current.idBits); !idBits.isEmpty(); ) {
+                    const PointerCoords& coords(
+                            current.getPointerById(idBits.clearFirstMarkedBit()));
+                    positions[count].x = coords.getX();
+                    positions[count].y = coords.getY();
+                    count++;
+                }
+                predictor->addMovement(current.eventTime, current.idBits, positions);
+            }
         }
 
         const History* getHistory(size_t index) const {
@@ -421,6 +542,7 @@ private:
     };
     Vector<SeqChain> mSeqChains;
 
+    status_t receiveMessage(InputMessage* msg);
     status_t consumeBatch(InputEventFactoryInterface* factory,
             nsecs_t frameTime, uint32_t* outSeq, InputEvent** outEvent);
     status_t consumeSamples(InputEventFactoryInterface* factory,
@@ -430,6 +552,8 @@ private:
     void rewriteMessage(const TouchState& state, InputMessage* msg);
     void resampleTouchState(nsecs_t frameTime, MotionEvent* event,
             const InputMessage *next);
+    bool predictTouchState(TouchState& touchState, nsecs_t sampleTime,
+            nsecs_t predictTime, MotionEvent* event);
 
     ssize_t findBatch(int32_t deviceId, int32_t source) const;
     ssize_t findTouchState(int32_t deviceId, int32_t source) const;
@@ -444,6 +568,8 @@ private:
     static bool shouldResampleTool(int32_t toolType);
 
     static bool isTouchResamplingEnabled();
+    static nsecs_t getTouchPredictionHorizon();
+    static String8 getTouchPredictorName();
 };
 
 } // namespace android
@@ -211,6 +211,26 @@ private:
         status_t parseCharacterLiteral(char16_t* outCharacter);
     };
 
+    /* Where to find a key in the lookup tables. */
+    struct KeyEntry {
+        /* The key, or NULL if the key code isn't mapped. */
+        const Key* key;
+
+        /* The behaviors of the key, in order, in mBehaviorArray. */
+        size_t firstBehavior;
+        size_t numBehaviors;
+
+        /* The table of the behaviors of the key by meta state index in
+         * mMetaTables, or -1 if the behaviors must be walked. */
+        ssize_t metaTable;
+    };
+
+    /* The key and meta state generating a character, see findKey(). */
+    struct CharEntry {
+        int32_t keyCode;
+        int32_t metaState;
+    };
+
     static sp<KeyCharacterMap> sEmpty;
 
     KeyedVector<int32_t, Key*> mKeys;
@@ -219,9 +239,29 @@ private:
     KeyedVector<int32_t, int32_t> mKeysByScanCode;
     KeyedVector<int32_t, int32_t> mKeysByUsageCode;
 
+    /* Lookup tables, built from mKeys by buildLookupTables() once the map
+     * is loaded.
+     *
+     * A meta state table gives for each meta state index the behavior of a
+     * key, 1 based, or 0 if none matches. The index has bit i set when the
+     * meta state has any of mMetaTableBits[i]: these are only the bits that
+     * may change which behavior matches, a single one for the left and
+     * right variants of a modifier unless a behavior tells them apart.
+     * Keys with the same list of behavior meta states share a table. */
+    Vector<KeyEntry> mKeyTable;             // by key code
+    Vector<const Behavior*> mBehaviorArray;
+    Vector<uint8_t> mMetaTables;
+    Vector<int32_t> mMetaTableBits;
+    /* Meta states with any of these bits walk the behaviors. */
+    int32_t mMetaTableFallbackMask;
+    /* Meta states with any of these bits match no behavior. */
+    int32_t mMetaTablePoisonMask;
+    KeyedVector<char16_t, CharEntry> mKeysByChar;
+
     KeyCharacterMap();
     KeyCharacterMap(const KeyCharacterMap& other);
 
+    void buildLookupTables();
     bool getKey(int32_t keyCode, const Key** outKey) const;
     bool getKeyBehavior(int32_t keyCode, int32_t metaState,
             const Key** outKey, const Behavior** outBehavior) const;
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LIBINPUT_TOUCH_PREDICTOR_H
+#define _LIBINPUT_TOUCH_PREDICTOR_H
+
+#include <input/VelocityTracker.h>
+#include <utils/BitSet.h>
+#include <utils/RefBase.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/*
+ * Predicts where the pointers of a touch will be a short time after their
+ * last known position, from their recent movements.
+ */
+class TouchPredictor : public RefBase {
+public:
+    // Creates a predictor by name. The names of the VelocityTracker strategies,
+    // e.g. "lsq2", give a predictor extrapolating the motion polynomial fitted
+    // by that strategy; unknown ones fall back to its default strategy.
+    // Returns NULL if the name is NULL or empty.
+    static sp<TouchPredictor> create(const char* name);
+
+    virtual ~TouchPredictor() { }
+
+    // Resets the predictor state.
+    virtual void clear() = 0;
+
+    // Resets the predictor state for specific pointers, e.g. ones that just
+    // went down and may reuse an id.
+    virtual void clearPointers(BitSet32 idBits) = 0;
+
+    // Adds positions for a set of pointers, in order by increasing id, as
+    // with VelocityTracker::addMovement().
+    virtual void addMovement(nsecs_t eventTime, BitSet32 idBits,
+            const VelocityTracker::Position* positions) = 0;
+
+    // Predicts the position of a pointer at the given time. Returns false if
+    // there isn't enough information to predict it confidently.
+    virtual bool predict(uint32_t id, nsecs_t when, float* outX, float* outY) const = 0;
+};
+
+/*
+ * Extrapolates the motion polynomial of a VelocityTracker estimator.
+ */
+class EstimatorTouchPredictor : public TouchPredictor {
+public:
+    // Estimators whose fit is worse than this aren't used for prediction.
+    static const float MIN_CONFIDENCE;
+
+    EstimatorTouchPredictor(const char* strategy);
+    virtual ~EstimatorTouchPredictor();
+
+    virtual void clear();
+    virtual void clearPointers(BitSet32 idBits);
+    virtual void addMovement(nsecs_t eventTime, BitSet32 idBits,
+            const VelocityTracker::Position* positions);
+    virtual bool predict(uint32_t id, nsecs_t when, float* outX, float* outY) const;
+
+private:
+    VelocityTracker mTracker;
+};
+
+} // namespace android
+
+#endif // _LIBINPUT_TOUCH_PREDICTOR_H
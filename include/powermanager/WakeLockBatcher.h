@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_WAKELOCKBATCHER_H
+#define ANDROID_WAKELOCKBATCHER_H
+
+#include <binder/IBinder.h>
+#include <powermanager/IPowerManager.h>
+#include <utils/Condition.h>
+#include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
+#include <utils/String16.h>
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+/*
+ * WakeLockBatcher stands between a native service and IPowerManager for
+ * wake locks that are toggled often. Calls only record the state each lock
+ * should be in; a thread of its own sends the difference with what
+ * PowerManagerService was last told, as oneway calls, one window after the
+ * first change. An acquire and release of the same lock within a window
+ * thus cancel out and cost no IPC at all, and a lock that stays held
+ * across a release/acquire pair is never dropped.
+ *
+ * PowerManagerService only implements the transactions of
+ * IPowerManager.aidl, so there is no batched transaction: the changes of
+ * all the locks of a window are sent back to back instead.
+ */
+class WakeLockBatcher : public RefBase
+{
+public:
+    WakeLockBatcher(const sp<IPowerManager>& powerManager, nsecs_t window);
+    virtual ~WakeLockBatcher();
+
+    void acquireWakeLock(int flags, const sp<IBinder>& lock,
+            const String16& tag, const String16& packageName);
+    void acquireWakeLockWithUid(int flags, const sp<IBinder>& lock,
+            const String16& tag, const String16& packageName, int uid);
+    void releaseWakeLock(const sp<IBinder>& lock, int flags);
+    void updateWakeLockUids(const sp<IBinder>& lock, int len, const int* uids);
+
+    // flush sends the pending changes now
+    void flush();
+
+    // the number of calls made to IPowerManager, and of the ones saved
+    struct Stats {
+        uint32_t sent;
+        uint32_t coalesced;
+    };
+    Stats getStats() const;
+
+private:
+    class FlushThread;
+    friend class FlushThread;
+
+    struct LockState {
+        sp<IBinder> lock;
+        // what PowerManagerService was last told, and what it should be
+        bool held;
+        bool wanted;
+        int flags;
+        String16 tag;
+        String16 packageName;
+        int uid;                // -1 to acquire without one
+        // set when the lock is acquired again with other arguments, which
+        // must then be sent even if the lock is already held
+        bool argsChanged;
+        int releaseFlags;
+        bool uidsChanged;
+        Vector<int> uids;
+    };
+
+    LockState& editLockLocked(const sp<IBinder>& lock);
+    void scheduleFlushLocked();
+    void flushLocked();
+    // waits for the window of the first pending change to end, and returns
+    // false once the batcher is going away
+    bool waitForFlush();
+
+    const sp<IPowerManager> mPowerManager;
+    const nsecs_t mWindow;
+
+    mutable Mutex mLock;
+    Condition mCondition;
+    KeyedVector<IBinder*, LockState> mLocks;
+    // 0 when nothing is pending
+    nsecs_t mFlushTime;
+    bool mExiting;
+    Stats mStats;
+    sp<FlushThread> mThread;
+};
+
+// ----------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif // ANDROID_WAKELOCKBATCHER_H
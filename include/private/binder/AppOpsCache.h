@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PRIVATE_BINDER_APP_OPS_CACHE_H
+#define ANDROID_PRIVATE_BINDER_APP_OPS_CACHE_H
+
+#include <binder/IAppOpsCallback.h>
+#include <binder/IAppOpsService.h>
+
+#include <utils/KeyedVector.h>
+#include <utils/SortedVector.h>
+#include <utils/String16.h>
+#include <utils/threads.h>
+
+// ---------------------------------------------------------------------------
+namespace android {
+
+/*
+ * The modes checkOp() got from the service, shared by all the AppOpsManager
+ * of the process.
+ *
+ * A mode is only cached once the cache watches its switch op (see
+ * AppOpsManager::opToSwitch()) for its package, so that no change can go
+ * unnoticed: the first mode checked for them only starts the watch. The
+ * service reports a change with the switch op, which drops the modes of all
+ * the ops it switches, for all uids. The number of watches is bounded, the
+ * cache stops them all and starts over when it runs out, or when the
+ * service is replaced.
+ */
+class AppOpsCache : public BnAppOpsCallback {
+public:
+    struct Key {
+        int32_t op;
+        int32_t uid;
+        String16 package;
+        inline bool operator < (const Key& k) const {
+            if (op != k.op) return op < k.op;
+            if (uid != k.uid) return uid < k.uid;
+            return package < k.package;
+        }
+    };
+
+    enum {
+        MAX_MODES = 512,
+        MAX_WATCHED = 128,
+    };
+
+    AppOpsCache();
+
+    // Returns NAME_NOT_FOUND on a miss, along with the generation to pass
+    // to put() with the mode checked by the service.
+    status_t get(const sp<IAppOpsService>& service, const Key& key,
+            int32_t* mode, uint32_t* generation);
+
+    // Caches the mode checked by the service, unless it changed since get()
+    // returned the generation, or the op and package aren't watched yet, in
+    // which case it starts watching them.
+    void put(const sp<IAppOpsService>& service, const Key& key,
+            int32_t mode, uint32_t generation);
+
+    virtual void opChanged(int32_t op, const String16& packageName);
+
+private:
+    void resetLocked(const sp<IAppOpsService>& service);
+
+    // held while the watches change, before mLock
+    Mutex mWatchLock;
+    Mutex mLock;
+    uint32_t mGeneration;
+    sp<IBinder> mService;
+    KeyedVector<Key, int32_t> mModes;
+    // the switch ops and packages watched, with a uid of 0
+    SortedVector<Key> mWatched;
+};
+
+}; // namespace android
+// ---------------------------------------------------------------------------
+
+#endif // ANDROID_PRIVATE_BINDER_APP_OPS_CACHE_H
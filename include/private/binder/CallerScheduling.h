@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PRIVATE_BINDER_CALLER_SCHEDULING_H
+#define ANDROID_PRIVATE_BINDER_CALLER_SCHEDULING_H
+
+#include <stdint.h>
+#include <sched.h>
+#include <sys/types.h>
+
+// ---------------------------------------------------------------------------
+namespace android {
+
+/*
+ * The scheduling of the caller of an IBinder::FLAG_LATENCY_CRITICAL
+ * transaction travels in bits of its flags that the driver passes on
+ * untouched: the real-time priority if CALLER_REALTIME is set, its nice
+ * value + 20 otherwise.
+ *
+ * Those bits are written by the caller, so the receiving thread only
+ * honours them for callers running as a system uid, and never goes above
+ * MAX_INHERITED_RT_PRIORITY or below MIN_INHERITED_NICE whatever they say.
+ */
+enum {
+    CALLER_REALTIME             = 0x00000200,
+    CALLER_PRIORITY_SHIFT       = 16,
+    CALLER_PRIORITY_MASK        = 0x00ff0000,
+
+    MAX_INHERITED_RT_PRIORITY   = 2,
+    MIN_INHERITED_NICE          = -8    // ANDROID_PRIORITY_URGENT_DISPLAY
+};
+
+// The scheduling bits for a transaction made by thread tid.
+uint32_t callerSchedulingFlags(pid_t tid);
+
+// What inheritCallerScheduling() changed, to be put back by
+// restoreScheduling() once the transaction is handled.
+struct SavedScheduling {
+    bool policyChanged;
+    bool niceChanged;
+    int policy;
+    struct sched_param param;
+    int nice;
+};
+
+// Whether a transaction from callingUid may raise the priority of the
+// thread handling it.
+bool isTrustedSchedulingCaller(uid_t callingUid);
+
+// Raises the scheduling of thread tid to the one flags carry, within the
+// limits above. Returns whether anything was changed, in which case
+// restoreScheduling() must be called with saved.
+bool inheritCallerScheduling(pid_t tid, uint32_t flags, uid_t callingUid,
+        SavedScheduling* saved);
+
+void restoreScheduling(pid_t tid, const SavedScheduling& saved);
+
+}; // namespace android
+
+// ---------------------------------------------------------------------------
+
+#endif // ANDROID_PRIVATE_BINDER_CALLER_SCHEDULING_H
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PRIVATE_BINDER_TRANSACTION_STATS_H
+#define ANDROID_PRIVATE_BINDER_TRANSACTION_STATS_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utils/String16.h>
+#include <utils/Timers.h>
+
+// ---------------------------------------------------------------------------
+namespace android {
+
+class Parcel;
+class String8;
+
+/*
+ * Latency histograms for the transactions made or served by one thread,
+ * keyed by interface descriptor, transaction code and direction.
+ *
+ * Only the owning thread ever writes to a TransactionStats; other threads
+ * may read it at any time (see ProcessState::dumpTransactionStats()).
+ * Entries are appended and published by a release store of the entry count
+ * once their key is filled in, and never move afterwards, so readers need
+ * no lock. Counters are plain 32-bit words: a concurrent reader may see a
+ * slightly stale histogram, which is fine for statistics.
+ */
+class TransactionStats {
+public:
+    enum direction_t {
+        OUTGOING = 0,   // IPCThreadState::transact()
+        INCOMING = 1    // BBinder::transact() from executeCommand()
+    };
+
+    enum {
+        // bucket i counts durations in [2^(i-1), 2^i) microseconds
+        BUCKET_COUNT = 24,
+        MAX_ENTRIES = 128
+    };
+
+    struct Entry {
+        uint32_t            hash;
+        uint32_t            direction;
+        uint32_t            code;
+        String16            descriptor;
+        uint32_t            count;
+        uint32_t            buckets[BUCKET_COUNT];
+        nsecs_t             totalTime;
+        nsecs_t             maxTime;
+    };
+
+    TransactionStats();
+
+    // Records one transaction whose data starts with an interface token
+    // (if it doesn't, the transaction is accounted to an empty descriptor).
+    void record(direction_t direction, const Parcel& data, uint32_t code,
+            nsecs_t duration);
+
+    size_t size() const;
+    const Entry& entryAt(size_t index) const { return mEntries[index]; }
+    uint32_t dropped() const { return mDropped; }
+
+    static size_t bucketFor(nsecs_t duration);
+
+private:
+    TransactionStats(const TransactionStats&);
+    TransactionStats& operator=(const TransactionStats&);
+
+    Entry*  findOrCreate(uint32_t direction, const char16_t* descriptor,
+            size_t len, uint32_t code);
+
+    Entry               mEntries[MAX_ENTRIES];
+    volatile int32_t    mCount;
+    uint32_t            mDropped;
+};
+
+}; // namespace android
+
+// ---------------------------------------------------------------------------
+
+#endif // ANDROID_PRIVATE_BINDER_TRANSACTION_STATS_H
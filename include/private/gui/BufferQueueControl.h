@@ -0,0 +1,154 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_BUFFERQUEUECONTROL_H
+#define ANDROID_GUI_BUFFERQUEUECONTROL_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <ui/Rect.h>
+
+#include <utils/Errors.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
+#include <utils/StrongPointer.h>
+#include <utils/Thread.h>
+
+namespace android {
+
+class IBinder;
+class IGraphicBufferProducer;
+
+/*
+ * A control block shared between a producer process and the
+ * BufferQueueProducer it talks to, through which dequeueBuffer,
+ * queueBuffer and cancelBuffer can be made without a binder transaction.
+ * The client writes one request, bumps requestSeq and wakes the server
+ * thread with a futex; the server makes the call locally, writes the
+ * response and bumps responseSeq.
+ *
+ * File descriptors can't go through shared memory, so only calls without a
+ * fence are sent this way: the client falls back to binder for
+ * queueBuffer/cancelBuffer with a fence, and the server waits for the
+ * release fence of a dequeued buffer before answering (which is why this is
+ * opt-in, see Surface). Reallocated buffers are still fetched with
+ * requestBuffer over binder.
+ */
+struct buffer_queue_control_t {
+    enum { VERSION = 2 };
+
+    enum {
+        OP_DEQUEUE = 1,
+        OP_QUEUE = 2,
+        OP_CANCEL = 3
+    };
+
+    uint32_t            version;
+    volatile int32_t    requestSeq;
+    volatile int32_t    responseSeq;
+    volatile int32_t    closed;
+
+    // request
+    int32_t             op;
+    int32_t             slot;
+    int32_t             async;
+    uint32_t            width;
+    uint32_t            height;
+    uint32_t            format;
+    uint32_t            usage;
+    int32_t             isAutoTimestamp;
+    int64_t             timestamp;
+    Rect                crop;
+    int32_t             scalingMode;
+    uint32_t            transform;
+    uint32_t            stickyTransform;
+    Rect                surfaceDamage;
+
+    // response
+    int32_t             status;
+    int32_t             outSlot;
+    uint32_t            outWidth;
+    uint32_t            outHeight;
+    uint32_t            outTransformHint;
+    uint32_t            outNumPendingBuffers;
+};
+
+// The server end, owned by BufferQueueProducer. Its thread serves requests
+// until stop() is called (when the producer disconnects).
+class BufferQueueControlServer : public Thread {
+public:
+    BufferQueueControlServer(const wp<IGraphicBufferProducer>& producer);
+    virtual ~BufferQueueControlServer();
+
+    // initCheck returns NO_ERROR if the shared memory could be set up.
+    status_t initCheck() const;
+
+    // getFd returns the ashmem fd to hand to the client. It stays owned by
+    // the server.
+    int getFd() const { return mFd; }
+
+    void stop();
+
+private:
+    virtual bool threadLoop();
+    void serve();
+
+    wp<IGraphicBufferProducer> mProducer;
+    int mFd;
+    buffer_queue_control_t* mControl;
+    int32_t mLastRequestSeq;
+};
+
+// The client end, owned by Surface.
+class BufferQueueControlClient : public RefBase {
+public:
+    // Takes ownership of fd. binder is the IGraphicBufferProducer, used to
+    // notice that the server went away.
+    BufferQueueControlClient(int fd, const sp<IBinder>& binder);
+    virtual ~BufferQueueControlClient();
+
+    status_t initCheck() const;
+
+    // Each of these returns false without doing anything if the call can't
+    // be made through the control block right now (another call is in
+    // flight, or the server is gone); the caller then uses binder.
+    bool dequeueBuffer(int* outSlot, bool async, uint32_t width,
+            uint32_t height, uint32_t format, uint32_t usage,
+            status_t* outResult);
+    bool queueBuffer(int slot, int64_t timestamp, bool isAutoTimestamp,
+            const Rect& crop, int scalingMode, uint32_t transform,
+            uint32_t stickyTransform, bool async, const Rect& surfaceDamage,
+            uint32_t* outWidth,
+            uint32_t* outHeight, uint32_t* outTransformHint,
+            uint32_t* outNumPendingBuffers, status_t* outResult);
+    bool cancelBuffer(int slot);
+
+private:
+    // transactLocked posts the request already written to mControl and
+    // waits for the response.
+    bool transactLocked();
+
+    Mutex mMutex;
+    int mFd;
+    buffer_queue_control_t* mControl;
+    wp<IBinder> mBinder;
+    bool mDead;
+};
+
+}; // namespace android
+
+#endif // ANDROID_GUI_BUFFERQUEUECONTROL_H
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_SENSOREVENTRING_H
+#define ANDROID_GUI_SENSOREVENTRING_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+#include <utils/StrongPointer.h>
+
+struct ASensorEvent;
+
+namespace android {
+
+/*
+ * A single-producer single-consumer ring of sensor events shared between
+ * SensorService and one SensorEventQueue. It replaces the BitTube as the
+ * path events take; the BitTube stays around to wake the client up, to
+ * carry acks for wake-up sensors and to notice that either end died.
+ *
+ * writeIndex and readIndex are free-running event counts. The reader only
+ * needs a wakeup once it found the ring empty: it then sets readerWaiting,
+ * and the writer sends one message over the BitTube the next time it
+ * publishes events. Likewise the writer sets writerWaiting when the ring is
+ * full, and the reader tells it over the BitTube once it made room.
+ *
+ * The flags are set and cleared with read-modify-write atomics, which are
+ * full barriers: each side publishes its index before looking at the
+ * other side's flag, so a wakeup can't be missed.
+ */
+struct sensor_event_ring_t {
+    enum { VERSION = 1 };
+
+    uint32_t            version;
+    uint32_t            capacity;
+    volatile int32_t    writeIndex;
+    volatile int32_t    readIndex;
+    volatile int32_t    readerWaiting;
+    volatile int32_t    writerWaiting;
+    uint32_t            reserved[2];
+    // followed by 'capacity' events
+};
+
+class SensorEventRing : public RefBase {
+public:
+    // create makes a new ring with room for 'capacity' events, map maps one
+    // created by another process and takes ownership of fd. Both return
+    // NULL on failure.
+    static sp<SensorEventRing> create(size_t capacity);
+    static sp<SensorEventRing> map(int fd);
+
+    virtual ~SensorEventRing();
+
+    // getFd returns the ashmem fd backing the ring. It stays owned by the
+    // ring.
+    int getFd() const { return mFd; }
+    size_t getCapacity() const { return mCapacity; }
+
+    // Writer side. write either copies all the events or, if they don't
+    // fit, none of them and returns -EAGAIN (in which case the reader will
+    // say when it made room). On success outWakeReader tells whether the
+    // reader is waiting for a wakeup.
+    ssize_t write(ASensorEvent const* events, size_t numEvents,
+            bool* outWakeReader);
+
+    // Reader side. read copies up to numEvents events and returns how many,
+    // 0 if the ring is empty.
+    size_t read(ASensorEvent* events, size_t numEvents);
+    // armReaderWakeup asks for a wakeup with the next event written, and
+    // returns false if there are events in the ring already.
+    bool armReaderWakeup();
+    // takeWriterWaiting returns true, once, if the writer is waiting for
+    // room in the ring.
+    bool takeWriterWaiting();
+
+private:
+    SensorEventRing(int fd, sensor_event_ring_t* ring, size_t size);
+
+    static size_t sizeFor(size_t capacity);
+
+    int mFd;
+    sensor_event_ring_t* mRing;
+    ASensorEvent* mEvents;
+    size_t mSize;
+    uint32_t mCapacity;
+};
+
+}; // namespace android
+
+#endif // ANDROID_GUI_SENSOREVENTRING_H
@@ -17,6 +17,9 @@
 #ifndef ANDROID_GUI_SYNC_FEATURES_H
 #define ANDROID_GUI_SYNC_FEATURES_H
 
+#include <EGL/egl.h>
+
+#include <ui/Fence.h>
 #include <utils/Singleton.h>
 #include <utils/String8.h>
 
@@ -30,6 +33,10 @@ class SyncFeatures : public Singleton<SyncFeatures> {
     bool mHasFenceSync;
     bool mHasWaitSync;
     String8 mString;
+    // how the fences given to waitForFence() were waited for
+    volatile int32_t mSignaledWaits;
+    volatile int32_t mGpuWaits;
+    volatile int32_t mCpuWaits;
     SyncFeatures();
 
 public:
@@ -37,6 +44,17 @@ public:
     bool useFenceSync() const;
     bool useWaitSync() const;
     String8 toString() const;
+
+    // waitForFence makes the GL commands issued next on the current context
+    // of dpy wait for fence. That's done on the GPU with EGL_KHR_wait_sync,
+    // and otherwise by blocking the calling thread, which Fence's wait
+    // statistics record under logname. Fences known to have signaled cost
+    // nothing either way.
+    status_t waitForFence(EGLDisplay dpy, const sp<Fence>& fence,
+            const char* logname);
+    // dumpFenceWaits appends how many waitForFence() calls had nothing to
+    // wait for, waited on the GPU, and blocked a thread.
+    void dumpFenceWaits(String8& result) const;
 };
 
 // ----------------------------------------------------------------------------
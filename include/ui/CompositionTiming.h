@@ -0,0 +1,46 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_UI_COMPOSITION_TIMING_H
+#define ANDROID_UI_COMPOSITION_TIMING_H
+
+#include <stdint.h>
+
+#include <utils/Timers.h>
+
+namespace android {
+
+/*
+ * How long each phase of one SurfaceFlinger refresh took, and how the
+ * layers of that refresh were composed. Layer counts are summed over all
+ * the displays that are on; a layer shown on two displays counts twice.
+ */
+struct CompositionTiming {
+    nsecs_t refreshTime;            // when the refresh started
+    nsecs_t preComposition;
+    nsecs_t rebuildLayerStacks;
+    nsecs_t setUpHWComposer;
+    nsecs_t doComposition;          // including debug region flashing
+    nsecs_t postComposition;
+    uint32_t displayCount;
+    uint32_t layerCount;
+    uint32_t glesLayerCount;        // HWC_FRAMEBUFFER, or no HWC list
+    uint32_t overlayLayerCount;     // everything else HWC composes
+};
+
+}; // namespace android
+
+#endif // ANDROID_UI_COMPOSITION_TIMING_H
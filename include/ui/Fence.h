@@ -26,6 +26,7 @@
 #include <utils/Flattenable.h>
 #include <utils/String8.h>
 #include <utils/Timers.h>
+#include <utils/Vector.h>
 
 struct ANativeWindowBuffer;
 
@@ -94,9 +95,16 @@ public:
     // getSignalTime returns the system monotonic clock time at which the
     // fence transitioned to the signaled state.  If the fence is not signaled
     // then INT64_MAX is returned.  If the fence is invalid or if an error
-    // occurs then -1 is returned.
+    // occurs then -1 is returned.  The time is kept once known, so polling a
+    // fence until it signals only costs a poll(2) per call.
     nsecs_t getSignalTime() const;
 
+    // The wait statistics count, for each logname passed to waitForever()
+    // ("wait" for wait()), how often and how long the process blocked on a
+    // fence. They are off by default since they take a lock on every wait.
+    static void setWaitStatsEnabled(bool enabled);
+    static void dumpWaitStats(String8& result);
+
     // Flattenable interface
     size_t getFlattenedSize() const;
     size_t getFdCount() const;
@@ -104,6 +112,8 @@ public:
     status_t unflatten(void const*& buffer, size_t& size, int const*& fds, size_t& count);
 
 private:
+    friend class FenceSet;
+
     // Only allow instantiation using ref counting.
     friend class LightRefBase<Fence>;
     ~Fence();
@@ -113,7 +123,67 @@ private:
     Fence& operator = (const Fence& rhs);
     const Fence& operator = (const Fence& rhs) const;
 
+    // Notes that the fence signaled, waits then return without a system
+    // call.
+    void setSignaled() const;
+
+    enum {
+        STATE_PENDING     = 0,
+        STATE_SIGNALED    = 1,
+        STATE_SIGNAL_TIME = 2,  // signaled and mSignalTime is set
+    };
+
     int mFenceFd;
+    mutable volatile int32_t mState;
+    mutable nsecs_t mSignalTime;
+};
+
+// ===========================================================================
+// FenceSet
+// ===========================================================================
+
+// FenceSet collects fences that must all signal before something may proceed
+// without merging them up front. Fences that have already signaled are
+// dropped when the set is resolved, so in the common case (one fence still
+// pending) no new sync fd is created at all.
+class FenceSet {
+public:
+    FenceSet();
+
+    // add adds a fence to the set. Invalid fences (e.g. NO_FENCE) are
+    // ignored.
+    void add(const sp<Fence>& fence);
+
+    void clear() { mFences.clear(); }
+    bool isEmpty() const { return mFences.isEmpty(); }
+    size_t size() const { return mFences.size(); }
+
+    // merge returns a single fence that signals once every fence in the set
+    // has signaled, merging only the fences that are still pending, and
+    // leaves the set holding just that fence. This is what to call before
+    // handing the fences to another process. NO_FENCE is returned if nothing
+    // is pending. If a merge fails an error is logged and the most recently
+    // added fence is returned, hoping fences signal in order.
+    sp<Fence> merge(const String8& name);
+
+    // waitForAll waits for up to timeout milliseconds for every fence in the
+    // set to signal, polling all of them in a single call. It returns
+    // NO_ERROR once they have, -ETIME if the timeout expires first.
+    // Signaled fences are removed from the set.
+    status_t waitForAll(int timeout);
+
+    // waitForAny waits for up to timeout milliseconds for at least one fence
+    // in the set to signal. It returns NO_ERROR (and leaves the set
+    // untouched) if one has or the set is empty, -ETIME otherwise.
+    status_t waitForAny(int timeout);
+
+private:
+    // pollFences polls all fences in the set with one poll(2) call, reports in
+    // outSignaled how many have signaled and, if removeSignaled is set,
+    // removes those from the set.
+    status_t pollFences(int timeout, bool removeSignaled, size_t* outSignaled);
+
+    Vector<sp<Fence> > mFences;
 };
 
 }; // namespace android
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_UI_FRAME_STAT_INFO_H
+#define ANDROID_UI_FRAME_STAT_INFO_H
+
+#include <stdint.h>
+
+#include <utils/Timers.h>
+
+namespace android {
+
+/*
+ * Summary of the frames presented for a layer since its statistics were
+ * last cleared. Latencies are measured from the desired present time of a
+ * frame to the time it was actually presented, and are rounded up to the
+ * millisecond.
+ */
+struct FrameStatInfo {
+    nsecs_t refreshPeriod;
+    uint32_t frameCount;
+    uint32_t missedVsyncCount;
+    nsecs_t latencyP50;
+    nsecs_t latencyP90;
+    nsecs_t latencyP99;
+};
+
+}; // namespace android
+
+#endif // ANDROID_UI_FRAME_STAT_INFO_H
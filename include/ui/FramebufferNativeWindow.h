@@ -26,6 +26,7 @@
 
 #include <utils/threads.h>
 #include <utils/String8.h>
+#include <utils/Vector.h>
 
 #include <ui/ANativeObjectBase.h>
 #include <ui/Rect.h>
@@ -34,7 +35,7 @@
 #define NUM_FRAME_BUFFERS 3
 #else
 #define MIN_NUM_FRAME_BUFFERS  2
-#define MAX_NUM_FRAME_BUFFERS  3
+#define MAX_NUM_FRAME_BUFFERS  4
 #endif
 
 extern "C" EGLNativeWindowType android_createDisplaySurface(void);
@@ -43,6 +44,7 @@ extern "C" EGLNativeWindowType android_createDisplaySurface(void);
 namespace android {
 // ---------------------------------------------------------------------------
 
+class Fence;
 class Surface;
 class NativeBuffer;
 
@@ -81,6 +83,14 @@ private:
     static int queueBuffer_DEPRECATED(ANativeWindow* window, ANativeWindowBuffer* buffer);
     static int lockBuffer_DEPRECATED(ANativeWindow* window, ANativeWindowBuffer* buffer);
 
+    // PostThread posts the queued buffers to the framebuffer once their
+    // fences have signaled, when debug.fb.async_post is set.
+    class PostThread;
+    struct PendingPost {
+        sp<NativeBuffer> buffer;
+        sp<Fence> fence;
+    };
+
     framebuffer_device_t* fbDev;
     alloc_device_t* grDev;
 
@@ -98,6 +108,11 @@ private:
     int32_t mBufferHead;
     int32_t mCurrentBufferIndex;
     bool mUpdateOnDemand;
+
+    // the buffers queued but not posted yet, oldest first; guarded by
+    // mutex and only used with mPostThread
+    Vector<PendingPost> mPendingPosts;
+    sp<PostThread> mPostThread;
 };
     
 // ---------------------------------------------------------------------------
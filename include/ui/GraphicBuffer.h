@@ -107,6 +107,10 @@ public:
     uint64_t getId() const              { return mId; }
 
     status_t reallocate(uint32_t w, uint32_t h, PixelFormat f, uint32_t usage);
+    // Same as reallocate(), but the buffer may be recycled from the ones
+    // poolOwner freed recently, see GraphicBufferAllocator::allocPooled().
+    status_t reallocatePooled(uint32_t w, uint32_t h, PixelFormat f,
+            uint32_t usage, uint32_t poolOwner);
 
     status_t lock(uint32_t usage, void** vaddr);
     status_t lock(uint32_t usage, const Rect& rect, void** vaddr);
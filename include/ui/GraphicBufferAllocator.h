@@ -26,6 +26,8 @@
 #include <utils/KeyedVector.h>
 #include <utils/threads.h>
 #include <utils/Singleton.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
 
 #include <ui/PixelFormat.h>
 
@@ -70,6 +72,22 @@ public:
             buffer_handle_t* handle, int32_t* stride, uint32_t bufferSize);
 #endif
 
+    // Like alloc(), but may return a buffer of the same size, format and
+    // usage that was freed by the same owner a moment ago, if the pool is
+    // enabled. The content of such a buffer is whatever the owner left in
+    // it, which is why buffers are never recycled from one owner to another.
+    status_t allocPooled(uint32_t w, uint32_t h, PixelFormat format, int usage,
+            uint32_t owner, buffer_handle_t* handle, int32_t* stride);
+
+    // Buffers allocated by allocPooled() are kept in the pool instead of
+    // being freed, until they are reused or older than maxAge, and as long
+    // as the pool holds less than maxBytes. maxBytes 0 disables the pool.
+    void setPoolLimits(size_t maxBytes, nsecs_t maxAge);
+    // Frees the pooled buffers older than maxAge.
+    void trimPool();
+    // Frees all the pooled buffers.
+    void flushPool();
+
     status_t free(buffer_handle_t handle);
 
     void dump(String8& res) const;
@@ -83,10 +101,43 @@ private:
         PixelFormat format;
         uint32_t usage;
         size_t size;
+        bool pooled;
+        uint32_t owner;
+    };
+
+    // The records are only used by dump(). They are spread over several
+    // lists, so that the threads allocating at once don't wait for each
+    // other.
+    enum { NUM_SHARDS = 16 };
+    struct alloc_shard_t {
+        Mutex lock;
+        KeyedVector<buffer_handle_t, alloc_rec_t> list;
     };
+
+    struct pool_entry_t {
+        buffer_handle_t handle;
+        alloc_rec_t rec;
+        nsecs_t freedAt;
+    };
+
+    bool takeFromPool(uint32_t w, uint32_t h, PixelFormat format, int usage,
+            uint32_t owner, buffer_handle_t* handle, int32_t* stride);
+    void trimPoolLocked(nsecs_t now, size_t maxBytes,
+            Vector<buffer_handle_t>* handles);
+    void freeHandles(const Vector<buffer_handle_t>& handles);
     
-    static Mutex sLock;
-    static KeyedVector<buffer_handle_t, alloc_rec_t> sAllocList;
+    static alloc_shard_t& shardFor(buffer_handle_t handle);
+
+    static alloc_shard_t sShards[NUM_SHARDS];
+    // sPoolLock protects the pool, it is never held with a shard lock
+    static Mutex sPoolLock;
+    // oldest first, the records of the pooled buffers stay in the shards
+    static Vector<pool_entry_t> sPool;
+    static size_t sPoolBytes;
+    static size_t sPoolMaxBytes;
+    static nsecs_t sPoolMaxAge;
+    static uint32_t sPoolHits;
+    static uint32_t sPoolMisses;
     
     friend class Singleton<GraphicBufferAllocator>;
     GraphicBufferAllocator();
@@ -171,6 +171,13 @@ private:
     static void boolean_operation(int op, Region& dst,
             const Region& lhs, const Rect& rhs);
 
+    // handles the operations whose result follows from the bounds of the
+    // operands alone. rhs is NULL if the right operand is just rhsBounds.
+    // dst may be lhs. Returns false if the generic path is needed.
+    static bool fast_boolean_operation(int op, Region& dst,
+            const Region& lhs, const Region* rhs, Rect rhsBounds,
+            int dx, int dy);
+
     static void translate(Region& reg, int dx, int dy);
     static void translate(Region& dst, const Region& reg, int dx, int dy);
 
@@ -23,6 +23,14 @@
 #include <ui/vec4.h>
 #include <utils/String8.h>
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define UI_MAT4_USE_NEON 1
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define UI_MAT4_USE_SSE 1
+#endif
+
 #define TMAT_IMPLEMENTATION
 #include <ui/TMatHelpers.h>
 
@@ -373,6 +381,53 @@ tmat44<T> PURE operator *(U rv, const tmat44<T>& lv) {
     return result;
 }
 
+// ----------------------------------------------------------------------------------------
+// float specializations
+// ----------------------------------------------------------------------------------------
+
+/* RenderEngine multiplies a few float matrices per layer and per frame; with
+ * NEON or SSE each column of a product is 4 multiply-adds of whole columns.
+ * These overloads are picked over the templates above for mat4 operands.
+ */
+
+#if defined(UI_MAT4_USE_NEON) || defined(UI_MAT4_USE_SSE)
+
+namespace matrix {
+// out = m * v, where m points to 4 columns of 4 floats. out may be v.
+inline void multiplyColumn(float* out, const float* m, const float* v) {
+#if defined(UI_MAT4_USE_NEON)
+    float32x4_t r = vmulq_n_f32(vld1q_f32(m), v[0]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 4),  v[1]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 8),  v[2]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 12), v[3]);
+    vst1q_f32(out, r);
+#else
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4),  _mm_set1_ps(v[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8),  _mm_set1_ps(v[2])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3])));
+    _mm_storeu_ps(out, r);
+#endif
+}
+}; // namespace matrix
+
+// matrix * matrix
+inline tmat44<float> PURE operator *(const tmat44<float>& lv, const tmat44<float>& rv) {
+    tmat44<float> result(tmat44<float>::NO_INIT);
+    for (size_t c=0 ; c<tmat44<float>::row_size() ; c++)
+        matrix::multiplyColumn(&result[c][0], lv.asArray(), &rv[c][0]);
+    return result;
+}
+
+// matrix * vector
+inline tvec4<float> PURE operator *(const tmat44<float>& lv, const tvec4<float>& rv) {
+    tvec4<float> result(tvec4<float>::NO_INIT);
+    matrix::multiplyColumn(&result[0], lv.asArray(), &rv[0]);
+    return result;
+}
+
+#endif
+
 // ----------------------------------------------------------------------------------------
 
 /* FIXME: this should go into TMatSquareFunctions<> but for some reason
@@ -14,10 +14,13 @@
 
 # we have the common sources, plus some device-specific stuff
 sources := \
+    AppOpsCache.cpp \
     AppOpsManager.cpp \
     Binder.cpp \
     BpBinder.cpp \
     BufferedTextOutput.cpp \
+    CallerScheduling.cpp \
+    ChunkedTextOutput.cpp \
     Debug.cpp \
     IAppOpsCallback.cpp \
     IAppOpsService.cpp \
@@ -35,6 +38,7 @@ sources := \
     ProcessState.cpp \
     Static.cpp \
     TextOutput.cpp \
+    TransactionStats.cpp \
 
 LOCAL_PATH:= $(call my-dir)
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <private/binder/AppOpsCache.h>
+
+#include <binder/AppOpsManager.h>
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+AppOpsCache::AppOpsCache() : mGeneration(0) {
+}
+
+status_t AppOpsCache::get(const sp<IAppOpsService>& service, const Key& key,
+        int32_t* mode, uint32_t* generation) {
+    Mutex::Autolock _l(mLock);
+    if (mService != service->asBinder()) {
+        resetLocked(service);
+    }
+    *generation = mGeneration;
+    ssize_t index = mModes.indexOfKey(key);
+    if (index < 0) {
+        return NAME_NOT_FOUND;
+    }
+    *mode = mModes.valueAt(index);
+    return NO_ERROR;
+}
+
+void AppOpsCache::put(const sp<IAppOpsService>& service, const Key& key,
+        int32_t mode, uint32_t generation) {
+    Key watched(key);
+    watched.op = AppOpsManager::opToSwitch(key.op);
+    watched.uid = 0;
+    {
+        Mutex::Autolock _l(mLock);
+        if (generation != mGeneration || mService != service->asBinder()) {
+            // changed while the service was checking
+            return;
+        }
+        if (mWatched.indexOf(watched) >= 0) {
+            if (mModes.size() >= MAX_MODES) {
+                mModes.clear();
+            }
+            mModes.add(key, mode);
+            return;
+        }
+    }
+
+    // The mode may have changed between the check and the watch, it is
+    // cached next time.  mWatchLock keeps the watches the service has in
+    // line with mWatched.
+    Mutex::Autolock _w(mWatchLock);
+    bool reset = false;
+    {
+        Mutex::Autolock _l(mLock);
+        if (mService != service->asBinder() || mWatched.indexOf(watched) >= 0) {
+            return;
+        }
+        if (mWatched.size() >= MAX_WATCHED) {
+            mGeneration++;
+            mModes.clear();
+            mWatched.clear();
+            reset = true;
+        }
+        mWatched.add(watched);
+    }
+    if (reset) {
+        service->stopWatchingMode(this);
+    }
+    service->startWatchingMode(watched.op, watched.package, this);
+}
+
+void AppOpsCache::opChanged(int32_t op, const String16& packageName) {
+    Mutex::Autolock _l(mLock);
+    mGeneration++;
+    for (size_t i = mModes.size(); i > 0; i--) {
+        const Key& k(mModes.keyAt(i - 1));
+        if (AppOpsManager::opToSwitch(k.op) == op && k.package == packageName) {
+            mModes.removeItemsAt(i - 1);
+        }
+    }
+}
+
+void AppOpsCache::resetLocked(const sp<IAppOpsService>& service) {
+    mGeneration++;
+    mModes.clear();
+    mWatched.clear();
+    mService = service->asBinder();
+}
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
@@ -18,6 +18,8 @@
 #include <binder/Binder.h>
 #include <binder/IServiceManager.h>
 
+#include <private/binder/AppOpsCache.h>
+
 #include <utils/SystemClock.h>
 
 namespace android {
@@ -35,10 +37,67 @@ static const sp<IBinder>& getToken(const sp<IAppOpsService>& service) {
     return gToken;
 }
 
+// ---------------------------------------------------------------------------
+
+static Mutex gCacheMutex;
+static sp<AppOpsCache> gCache;
+
+static sp<AppOpsCache> getCache() {
+    Mutex::Autolock _l(gCacheMutex);
+    if (gCache == NULL) {
+        gCache = new AppOpsCache();
+    }
+    return gCache;
+}
+
+// ---------------------------------------------------------------------------
+
+// The op whose mode each op follows, as in AppOpsManager.java.
+static const int32_t sOpToSwitch[] = {
+    AppOpsManager::OP_COARSE_LOCATION,      // OP_COARSE_LOCATION
+    AppOpsManager::OP_COARSE_LOCATION,      // OP_FINE_LOCATION
+    AppOpsManager::OP_COARSE_LOCATION,      // OP_GPS
+    AppOpsManager::OP_VIBRATE,
+    AppOpsManager::OP_READ_CONTACTS,
+    AppOpsManager::OP_WRITE_CONTACTS,
+    AppOpsManager::OP_READ_CALL_LOG,
+    AppOpsManager::OP_WRITE_CALL_LOG,
+    AppOpsManager::OP_READ_CALENDAR,
+    AppOpsManager::OP_WRITE_CALENDAR,
+    AppOpsManager::OP_COARSE_LOCATION,      // OP_WIFI_SCAN
+    AppOpsManager::OP_POST_NOTIFICATION,
+    AppOpsManager::OP_COARSE_LOCATION,      // OP_NEIGHBORING_CELLS
+    AppOpsManager::OP_CALL_PHONE,
+    AppOpsManager::OP_READ_SMS,
+    AppOpsManager::OP_WRITE_SMS,
+    AppOpsManager::OP_READ_SMS,             // OP_RECEIVE_SMS
+    AppOpsManager::OP_READ_SMS,             // OP_RECEIVE_EMERGECY_SMS
+    AppOpsManager::OP_READ_SMS,             // OP_RECEIVE_MMS
+    AppOpsManager::OP_READ_SMS,             // OP_RECEIVE_WAP_PUSH
+    AppOpsManager::OP_SEND_SMS,
+    AppOpsManager::OP_READ_SMS,             // OP_READ_ICC_SMS
+    AppOpsManager::OP_WRITE_SMS,            // OP_WRITE_ICC_SMS
+    AppOpsManager::OP_WRITE_SETTINGS,
+    AppOpsManager::OP_SYSTEM_ALERT_WINDOW,
+    AppOpsManager::OP_ACCESS_NOTIFICATIONS,
+    AppOpsManager::OP_CAMERA,
+    AppOpsManager::OP_RECORD_AUDIO,
+    AppOpsManager::OP_PLAY_AUDIO,
+};
+
 AppOpsManager::AppOpsManager()
 {
 }
 
+int32_t AppOpsManager::opToSwitch(int32_t op)
+{
+    if (op < 0 || size_t(op) >= sizeof(sOpToSwitch) / sizeof(sOpToSwitch[0])) {
+        // an op this table doesn't know yet switches itself
+        return op;
+    }
+    return sOpToSwitch[op];
+}
+
 sp<IAppOpsService> AppOpsManager::getService()
 {
     int64_t startTime = 0;
@@ -68,7 +127,21 @@ sp<IAppOpsService> AppOpsManager::getService()
 int32_t AppOpsManager::checkOp(int32_t op, int32_t uid, const String16& callingPackage)
 {
     sp<IAppOpsService> service = getService();
-    return service != NULL ? service->checkOperation(op, uid, callingPackage) : MODE_IGNORED;
+    if (service == NULL) {
+        return MODE_IGNORED;
+    }
+    const sp<AppOpsCache> cache(getCache());
+    AppOpsCache::Key key;
+    key.op = op;
+    key.uid = uid;
+    key.package = callingPackage;
+    int32_t mode;
+    uint32_t generation;
+    if (cache->get(service, key, &mode, &generation) != NO_ERROR) {
+        mode = service->checkOperation(op, uid, callingPackage);
+        cache->put(service, key, mode, generation);
+    }
+    return mode;
 }
 
 int32_t AppOpsManager::noteOp(int32_t op, int32_t uid, const String16& callingPackage) {
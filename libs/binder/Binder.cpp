@@ -61,6 +61,16 @@ bool IBinder::checkSubclass(const void* /*subclassID*/) const
 
 // ---------------------------------------------------------------------------
 
+void IBinder::DeathRecipient::bindersDied(const Vector<wp<IBinder> >& who)
+{
+    const size_t N = who.size();
+    for (size_t i = 0; i < N; i++) {
+        binderDied(who[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
 class BBinder::Extras
 {
 public:
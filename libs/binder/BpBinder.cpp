@@ -266,7 +266,12 @@ void BpBinder::sendObituary()
     if (obits != NULL) {
         const size_t N = obits->size();
         for (size_t i=0; i<N; i++) {
-            reportOneDeath(obits->itemAt(i));
+            const Obituary& obit = obits->itemAt(i);
+            if (obit.flags & DEATH_BATCHED) {
+                IPCThreadState::self()->queueDeath(obit.recipient, this);
+            } else {
+                reportOneDeath(obit);
+            }
         }
 
         delete obits;
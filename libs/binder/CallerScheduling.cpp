@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CallerScheduling"
+
+#include <private/binder/CallerScheduling.h>
+
+#include <private/android_filesystem_config.h>
+
+#include <sys/resource.h>
+
+// ---------------------------------------------------------------------------
+namespace android {
+
+uint32_t callerSchedulingFlags(pid_t tid)
+{
+    const int policy = sched_getscheduler(tid);
+    if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        struct sched_param param;
+        if (sched_getparam(tid, &param) == 0) {
+            return CALLER_REALTIME |
+                    (uint32_t(param.sched_priority) << CALLER_PRIORITY_SHIFT);
+        }
+    }
+    return uint32_t(getpriority(PRIO_PROCESS, tid) + 20) << CALLER_PRIORITY_SHIFT;
+}
+
+bool isTrustedSchedulingCaller(uid_t callingUid)
+{
+    // system uids of any user, but not apps
+    return (callingUid % AID_USER) < AID_APP;
+}
+
+bool inheritCallerScheduling(pid_t tid, uint32_t flags, uid_t callingUid,
+        SavedScheduling* saved)
+{
+    saved->policyChanged = false;
+    saved->niceChanged = false;
+    if (!isTrustedSchedulingCaller(callingUid)) {
+        return false;
+    }
+    saved->policy = sched_getscheduler(tid);
+    if (saved->policy < 0 || sched_getparam(tid, &saved->param) < 0) {
+        return false;
+    }
+    const bool realtime = saved->policy == SCHED_FIFO || saved->policy == SCHED_RR;
+    const int callerPriority = (flags & CALLER_PRIORITY_MASK) >> CALLER_PRIORITY_SHIFT;
+
+    int callerNice;
+    if (flags & CALLER_REALTIME) {
+        struct sched_param param;
+        param.sched_priority = callerPriority < MAX_INHERITED_RT_PRIORITY ?
+                callerPriority : MAX_INHERITED_RT_PRIORITY;
+        if (param.sched_priority <= 0 ||
+                (realtime && saved->param.sched_priority >= param.sched_priority)) {
+            return false;
+        }
+        if (sched_setscheduler(tid, SCHED_FIFO, &param) == 0) {
+            saved->policyChanged = true;
+            return true;
+        }
+        // not allowed to go real-time, get as close as we can
+        callerNice = MIN_INHERITED_NICE;
+    } else {
+        callerNice = callerPriority - 20;
+        if (callerNice < MIN_INHERITED_NICE) {
+            callerNice = MIN_INHERITED_NICE;
+        }
+    }
+    if (realtime) {
+        return false;
+    }
+    // for synchronous calls, the driver has set our nice value already
+    saved->nice = getpriority(PRIO_PROCESS, tid);
+    if (callerNice >= saved->nice) {
+        return false;
+    }
+    if (setpriority(PRIO_PROCESS, tid, callerNice) == 0) {
+        saved->niceChanged = true;
+    }
+    return saved->niceChanged;
+}
+
+void restoreScheduling(pid_t tid, const SavedScheduling& saved)
+{
+    if (saved.policyChanged) {
+        sched_setscheduler(tid, saved.policy, &saved.param);
+    }
+    if (saved.niceChanged) {
+        setpriority(PRIO_PROCESS, tid, saved.nice);
+    }
+}
+
+}; // namespace android
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/ChunkedTextOutput.h>
+
+#include <utils/String8.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+
+namespace android {
+
+ChunkedTextOutput::ChunkedTextOutput(int fd, size_t reserveBytes)
+    : mFd(fd), mPage(0), mUsed(0), mIndent(0), mAtLineStart(true)
+{
+    const size_t pages = reserveBytes ? (reserveBytes + CHUNK_SIZE - 1) / CHUNK_SIZE : 1;
+    for (size_t i = 0; i < pages; i++) {
+        char* page = (char*)malloc(CHUNK_SIZE);
+        if (page == NULL) {
+            break;
+        }
+        mPages.add(page);
+    }
+}
+
+ChunkedTextOutput::~ChunkedTextOutput()
+{
+    flush();
+    for (size_t i = 0; i < mPages.size(); i++) {
+        free(mPages[i]);
+    }
+}
+
+status_t ChunkedTextOutput::nextPage()
+{
+    if (mPage + 1 == mPages.size()) {
+        char* page = (char*)malloc(CHUNK_SIZE);
+        if (page == NULL) {
+            return NO_MEMORY;
+        }
+        mPages.add(page);
+    }
+    mPage++;
+    mUsed = 0;
+    return NO_ERROR;
+}
+
+status_t ChunkedTextOutput::write(const char* txt, size_t len)
+{
+    if (mPages.isEmpty()) {
+        return NO_MEMORY;
+    }
+    while (len > 0) {
+        if (mUsed == CHUNK_SIZE) {
+            status_t err = nextPage();
+            if (err != NO_ERROR) {
+                return err;
+            }
+        }
+        const size_t n = len < CHUNK_SIZE - mUsed ? len : CHUNK_SIZE - mUsed;
+        memcpy(mPages[mPage] + mUsed, txt, n);
+        mUsed += n;
+        txt += n;
+        len -= n;
+    }
+    return NO_ERROR;
+}
+
+status_t ChunkedTextOutput::print(const char* txt, size_t len)
+{
+    static const char kSpaces[] = "                                ";
+    while (len > 0) {
+        if (mAtLineStart && mIndent > 0) {
+            for (size_t n = mIndent; n > 0; ) {
+                const size_t chunk = n < sizeof(kSpaces) - 1 ? n : sizeof(kSpaces) - 1;
+                write(kSpaces, chunk);
+                n -= chunk;
+            }
+        }
+        const char* eol = (const char*)memchr(txt, '\n', len);
+        const size_t n = eol ? eol - txt + 1 : len;
+        status_t err = write(txt, n);
+        if (err != NO_ERROR) {
+            return err;
+        }
+        mAtLineStart = eol != NULL;
+        txt += n;
+        len -= n;
+    }
+    return NO_ERROR;
+}
+
+void ChunkedTextOutput::moveIndent(int delta)
+{
+    mIndent += delta;
+    if (mIndent < 0) mIndent = 0;
+}
+
+void ChunkedTextOutput::pushBundle()
+{
+}
+
+void ChunkedTextOutput::popBundle()
+{
+}
+
+status_t ChunkedTextOutput::format(const char* fmt, ...)
+{
+    if (mPages.isEmpty()) {
+        return NO_MEMORY;
+    }
+    va_list args;
+    va_start(args, fmt);
+    va_list copy;
+    va_copy(copy, args);
+    const size_t avail = CHUNK_SIZE - mUsed;
+    int n = -1;
+    if (mIndent == 0) {
+        // most of the time, what is left of the current page is enough
+        n = vsnprintf(mPages[mPage] + mUsed, avail, fmt, copy);
+        if (n >= 0 && size_t(n) < avail) {
+            mUsed += n;
+            mAtLineStart = n > 0 ? mPages[mPage][mUsed - 1] == '\n' : mAtLineStart;
+            va_end(copy);
+            va_end(args);
+            return NO_ERROR;
+        }
+    } else {
+        n = vsnprintf(NULL, 0, fmt, copy);
+    }
+    va_end(copy);
+
+    status_t err = BAD_VALUE;
+    if (n >= 0) {
+        // spans two pages or more, or needs indenting
+        char buf[CHUNK_SIZE];
+        char* str = size_t(n) < sizeof(buf) ? buf : (char*)malloc(n + 1);
+        if (str == NULL) {
+            err = NO_MEMORY;
+        } else {
+            vsnprintf(str, n + 1, fmt, args);
+            err = print(str, n);
+            if (str != buf) {
+                free(str);
+            }
+        }
+    }
+    va_end(args);
+    return err;
+}
+
+status_t ChunkedTextOutput::append(const String8& str)
+{
+    return print(str.string(), str.size());
+}
+
+status_t ChunkedTextOutput::flush()
+{
+    status_t err = NO_ERROR;
+    for (size_t i = 0; i <= mPage && i < mPages.size(); i++) {
+        const char* data = mPages[i];
+        size_t len = i == mPage ? mUsed : CHUNK_SIZE;
+        while (len > 0 && err == NO_ERROR) {
+            const ssize_t n = ::write(mFd, data, len);
+            if (n < 0) {
+                if (errno != EINTR) {
+                    err = -errno;
+                }
+            } else {
+                data += n;
+                len -= n;
+            }
+        }
+    }
+    mPage = 0;
+    mUsed = 0;
+    return err;
+}
+
+size_t ChunkedTextOutput::size() const
+{
+    return mPage * CHUNK_SIZE + mUsed;
+}
+
+// ---------------------------------------------------------------------------
+}; // namespace android
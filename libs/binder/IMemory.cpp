@@ -26,6 +26,7 @@
 #include <sys/mman.h>
 
 #include <binder/IMemory.h>
+#include <binder/IPCThreadState.h>
 #include <utils/KeyedVector.h>
 #include <utils/threads.h>
 #include <utils/Atomic.h>
@@ -59,8 +60,18 @@ private:
 
     void free_heap(const wp<IBinder>& binder);
 
-    Mutex mHeapCacheLock;
-    KeyedVector< wp<IBinder>, heap_info_t > mHeapCache;
+    // The heaps are spread over shards by binder address, so threads mapping
+    // different heaps don't wait on each other.
+    enum { NUM_SHARDS = 8 };
+    struct shard_t {
+        Mutex lock;
+        KeyedVector< wp<IBinder>, heap_info_t > heaps;
+    };
+    static size_t shardFor(const void* binder) {
+        return (uintptr_t(binder) >> 4) % NUM_SHARDS;
+    }
+
+    shard_t mShards[NUM_SHARDS];
 };
 
 static sp<HeapCache> gHeapCache = new HeapCache();
@@ -85,6 +96,7 @@ public:
 
 private:
     friend class IMemory;
+    friend class BpMemory;
     friend class HeapCache;
 
     // for debugging in this module
@@ -103,6 +115,13 @@ private:
 
     void assertMapped() const;
     void assertReallyMapped() const;
+    // Maps the heap of the cache shared by all the BpMemoryHeaps of this
+    // binder from what the server sent along with an IMemory, rather than
+    // asking for it.
+    void assertMapped(int fd, ssize_t size, uint32_t flags,
+            uint32_t offset) const;
+    void map(int parcel_fd, ssize_t size, uint32_t flags,
+            uint32_t offset) const;
 
     mutable volatile int32_t mHeapId;
     mutable void*       mBase;
@@ -189,6 +208,18 @@ sp<IMemoryHeap> BpMemory::getMemory(ssize_t* offset, size_t* size) const
                 if (mHeap != 0) {
                     mOffset = o;
                     mSize = s;
+                    // Servers that describe the heap inline save us the
+                    // HEAP_ID transaction the first use of the heap makes.
+                    if (reply.readInt32() == 1 && heap->remoteBinder() != NULL) {
+                        int fd = reply.readFileDescriptor();
+                        ssize_t size = reply.readInt32();
+                        uint32_t flags = reply.readInt32();
+                        uint32_t offset = reply.readInt32();
+                        if (fd >= 0) {
+                            static_cast<BpMemoryHeap*>(mHeap.get())->assertMapped(
+                                    fd, size, flags, offset);
+                        }
+                    }
                 }
             }
         }
@@ -208,6 +239,33 @@ BnMemory::BnMemory() {
 BnMemory::~BnMemory() {
 }
 
+// The heaps GET_MEMORY described lately, and to which process. A client
+// keeps a heap mapped while it holds any IMemory of it, so describing the
+// heap again with each of them would only cost a file descriptor. A client
+// which unmapped the heap meanwhile gets it with HEAP_ID instead.
+enum { NUM_DESCRIBED_HEAPS = 16 };
+struct described_heap_t {
+    const IBinder* heap;
+    pid_t pid;
+};
+static Mutex gDescribedHeapsLock;
+static described_heap_t gDescribedHeaps[NUM_DESCRIBED_HEAPS];
+static size_t gNextDescribedHeap = 0;
+
+static bool shouldDescribeHeap(const IBinder* heap, pid_t pid)
+{
+    Mutex::Autolock _l(gDescribedHeapsLock);
+    for (size_t i=0 ; i<NUM_DESCRIBED_HEAPS ; i++) {
+        if (gDescribedHeaps[i].heap == heap && gDescribedHeaps[i].pid == pid) {
+            return false;
+        }
+    }
+    gDescribedHeaps[gNextDescribedHeap].heap = heap;
+    gDescribedHeaps[gNextDescribedHeap].pid = pid;
+    gNextDescribedHeap = (gNextDescribedHeap + 1) % NUM_DESCRIBED_HEAPS;
+    return true;
+}
+
 status_t BnMemory::onTransact(
     uint32_t code, const Parcel& data, Parcel* reply, uint32_t flags)
 {
@@ -216,9 +274,23 @@ status_t BnMemory::onTransact(
             CHECK_INTERFACE(IMemory, data, reply);
             ssize_t offset;
             size_t size;
-            reply->writeStrongBinder( getMemory(&offset, &size)->asBinder() );
+            sp<IMemoryHeap> heap(getMemory(&offset, &size));
+            reply->writeStrongBinder( heap->asBinder() );
             reply->writeInt32(offset);
             reply->writeInt32(size);
+            // Describe the heap as HEAP_ID does; older clients ignore it.
+            // Only our own heaps: asking a heap forwarded from another
+            // process would make a HEAP_ID transaction and map it here.
+            sp<IBinder> heapBinder(heap->asBinder());
+            if (heapBinder->localBinder() != NULL && heap->getHeapID() >= 0 &&
+                    shouldDescribeHeap(heapBinder.get(),
+                            IPCThreadState::self()->getCallingPid())) {
+                reply->writeInt32(1);
+                reply->writeFileDescriptor(heap->getHeapID());
+                reply->writeInt32(heap->getSize());
+                reply->writeInt32(heap->getFlags());
+                reply->writeInt32(heap->getOffset());
+            }
             return NO_ERROR;
         } break;
         default:
@@ -280,6 +352,30 @@ void BpMemoryHeap::assertMapped() const
     }
 }
 
+void BpMemoryHeap::assertMapped(int fd, ssize_t size, uint32_t flags,
+        uint32_t offset) const
+{
+    if (mHeapId == -1) {
+        sp<IBinder> binder(const_cast<BpMemoryHeap*>(this)->asBinder());
+        sp<BpMemoryHeap> heap(static_cast<BpMemoryHeap*>(find_heap(binder).get()));
+        if (heap->mHeapId == -1) {
+            heap->map(fd, size, flags, offset);
+        }
+        if (heap->mBase != MAP_FAILED) {
+            Mutex::Autolock _l(mLock);
+            if (mHeapId == -1) {
+                mBase   = heap->mBase;
+                mSize   = heap->mSize;
+                mOffset = heap->mOffset;
+                android_atomic_write( dup( heap->mHeapId ), &mHeapId );
+            }
+        } else {
+            // something went wrong
+            free_heap(binder);
+        }
+    }
+}
+
 void BpMemoryHeap::assertReallyMapped() const
 {
     if (mHeapId == -1) {
@@ -299,30 +395,39 @@ void BpMemoryHeap::assertReallyMapped() const
         ALOGE_IF(err, "binder=%p transaction failed fd=%d, size=%zd, err=%d (%s)",
                 asBinder().get(), parcel_fd, size, err, strerror(-err));
 
-        int fd = dup( parcel_fd );
-        ALOGE_IF(fd==-1, "cannot dup fd=%d, size=%zd, err=%d (%s)",
-                parcel_fd, size, err, strerror(errno));
+        map(parcel_fd, size, flags, offset);
+    }
+}
 
-        int access = PROT_READ;
-        if (!(flags & READ_ONLY)) {
-            access |= PROT_WRITE;
-        }
+void BpMemoryHeap::map(int parcel_fd, ssize_t size, uint32_t flags,
+        uint32_t offset) const
+{
+    int fd = dup( parcel_fd );
+    ALOGE_IF(fd==-1, "cannot dup fd=%d, size=%zd, err=%d (%s)",
+            parcel_fd, size, errno, strerror(errno));
 
-        Mutex::Autolock _l(mLock);
-        if (mHeapId == -1) {
-            mRealHeap = true;
-            mBase = mmap(0, size, access, MAP_SHARED, fd, offset);
-            if (mBase == MAP_FAILED) {
-                ALOGE("cannot map BpMemoryHeap (binder=%p), size=%zd, fd=%d (%s)",
-                        asBinder().get(), size, fd, strerror(errno));
-                close(fd);
-            } else {
-                mSize = size;
-                mFlags = flags;
-                mOffset = offset;
-                android_atomic_write(fd, &mHeapId);
-            }
+    int access = PROT_READ;
+    if (!(flags & READ_ONLY)) {
+        access |= PROT_WRITE;
+    }
+
+    Mutex::Autolock _l(mLock);
+    if (mHeapId == -1) {
+        mRealHeap = true;
+        mBase = mmap(0, size, access, MAP_SHARED, fd, offset);
+        if (mBase == MAP_FAILED) {
+            ALOGE("cannot map BpMemoryHeap (binder=%p), size=%zd, fd=%d (%s)",
+                    asBinder().get(), size, fd, strerror(errno));
+            close(fd);
+        } else {
+            mSize = size;
+            mFlags = flags;
+            mOffset = offset;
+            android_atomic_write(fd, &mHeapId);
         }
+    } else if (fd >= 0) {
+        // mapped by another thread meanwhile
+        close(fd);
     }
 }
 
@@ -397,10 +502,11 @@ void HeapCache::binderDied(const wp<IBinder>& binder)
 
 sp<IMemoryHeap> HeapCache::find_heap(const sp<IBinder>& binder)
 {
-    Mutex::Autolock _l(mHeapCacheLock);
-    ssize_t i = mHeapCache.indexOfKey(binder);
+    shard_t& shard(mShards[shardFor(binder.get())]);
+    Mutex::Autolock _l(shard.lock);
+    ssize_t i = shard.heaps.indexOfKey(binder);
     if (i>=0) {
-        heap_info_t& info = mHeapCache.editValueAt(i);
+        heap_info_t& info = shard.heaps.editValueAt(i);
         ALOGD_IF(VERBOSE,
                 "found binder=%p, heap=%p, size=%zu, fd=%d, count=%d",
                 binder.get(), info.heap.get(),
@@ -415,7 +521,7 @@ sp<IMemoryHeap> HeapCache::find_heap(const sp<IBinder>& binder)
         info.count = 1;
         //ALOGD("adding binder=%p, heap=%p, count=%d",
         //      binder.get(), info.heap.get(), info.count);
-        mHeapCache.add(binder, info);
+        shard.heaps.add(binder, info);
         return info.heap;
     }
 }
@@ -428,10 +534,11 @@ void HeapCache::free_heap(const wp<IBinder>& binder)
 {
     sp<IMemoryHeap> rel;
     {
-        Mutex::Autolock _l(mHeapCacheLock);
-        ssize_t i = mHeapCache.indexOfKey(binder);
+        shard_t& shard(mShards[shardFor(binder.unsafe_get())]);
+        Mutex::Autolock _l(shard.lock);
+        ssize_t i = shard.heaps.indexOfKey(binder);
         if (i>=0) {
-            heap_info_t& info(mHeapCache.editValueAt(i));
+            heap_info_t& info(shard.heaps.editValueAt(i));
             int32_t c = android_atomic_dec(&info.count);
             if (c == 1) {
                 ALOGD_IF(VERBOSE,
@@ -440,8 +547,8 @@ void HeapCache::free_heap(const wp<IBinder>& binder)
                         static_cast<BpMemoryHeap*>(info.heap.get())->mSize,
                         static_cast<BpMemoryHeap*>(info.heap.get())->mHeapId,
                         info.count);
-                rel = mHeapCache.valueAt(i).heap;
-                mHeapCache.removeItemsAt(i);
+                rel = shard.heaps.valueAt(i).heap;
+                shard.heaps.removeItemsAt(i);
             }
         } else {
             ALOGE("free_heap binder=%p not found!!!", binder.unsafe_get());
@@ -452,24 +559,28 @@ void HeapCache::free_heap(const wp<IBinder>& binder)
 sp<IMemoryHeap> HeapCache::get_heap(const sp<IBinder>& binder)
 {
     sp<IMemoryHeap> realHeap;
-    Mutex::Autolock _l(mHeapCacheLock);
-    ssize_t i = mHeapCache.indexOfKey(binder);
-    if (i>=0)   realHeap = mHeapCache.valueAt(i).heap;
+    shard_t& shard(mShards[shardFor(binder.get())]);
+    Mutex::Autolock _l(shard.lock);
+    ssize_t i = shard.heaps.indexOfKey(binder);
+    if (i>=0)   realHeap = shard.heaps.valueAt(i).heap;
     else        realHeap = interface_cast<IMemoryHeap>(binder);
     return realHeap;
 }
 
 void HeapCache::dump_heaps()
 {
-    Mutex::Autolock _l(mHeapCacheLock);
-    int c = mHeapCache.size();
-    for (int i=0 ; i<c ; i++) {
-        const heap_info_t& info = mHeapCache.valueAt(i);
-        BpMemoryHeap const* h(static_cast<BpMemoryHeap const *>(info.heap.get()));
-        ALOGD("hey=%p, heap=%p, count=%d, (fd=%d, base=%p, size=%zu)",
-                mHeapCache.keyAt(i).unsafe_get(),
-                info.heap.get(), info.count,
-                h->mHeapId, h->mBase, h->mSize);
+    for (size_t s=0 ; s<NUM_SHARDS ; s++) {
+        shard_t& shard(mShards[s]);
+        Mutex::Autolock _l(shard.lock);
+        int c = shard.heaps.size();
+        for (int i=0 ; i<c ; i++) {
+            const heap_info_t& info = shard.heaps.valueAt(i);
+            BpMemoryHeap const* h(static_cast<BpMemoryHeap const *>(info.heap.get()));
+            ALOGD("hey=%p, heap=%p, count=%d, (fd=%d, base=%p, size=%zu)",
+                    shard.heaps.keyAt(i).unsafe_get(),
+                    info.heap.get(), info.count,
+                    h->mHeapId, h->mBase, h->mSize);
+        }
     }
 }
 
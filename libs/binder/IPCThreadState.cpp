@@ -26,8 +26,10 @@
 #include <utils/Log.h>
 #include <utils/threads.h>
 
+#include <private/binder/CallerScheduling.h>
 #include <private/binder/binder_module.h>
 #include <private/binder/Static.h>
+#include <private/binder/TransactionStats.h>
 
 #include <sys/ioctl.h>
 #include <signal.h>
@@ -295,6 +297,16 @@ static pthread_key_t gTLS = 0;
 static bool gShutdown = false;
 static bool gDisableBackgroundScheduling = false;
 
+// Upper bound on the number of idle Parcels each thread keeps around,
+// and on the capacity a Parcel may have and still be worth keeping.
+static const size_t kMaxPooledParcels = 4;
+static const size_t kMaxPooledParcelCapacity = 16 * 1024;
+
+// Read buffer size of a thread once it has seen a binder die: the other
+// binders of the process usually die next, and the more of their deaths a
+// read returns, the fewer bindersDied() calls they take.
+static const size_t kDeathReadSize = 2048;
+
 IPCThreadState* IPCThreadState::self()
 {
     if (gHaveTLS) {
@@ -414,15 +426,44 @@ void IPCThreadState::flushCommands()
 {
     if (mProcess->mDriverFD <= 0)
         return;
+    if (mOnewayBatchCount > 0) {
+        flushOnewayBatch();
+        return;
+    }
     talkWithDriver(false);
 }
 
+void IPCThreadState::setOnewayBatching(size_t maxBytes, nsecs_t maxDelay)
+{
+    if (maxBytes == 0 && mOnewayBatchCount > 0) {
+        flushOnewayBatch();
+    }
+    mOnewayBatchBytes = maxBytes;
+    mOnewayBatchDelay = maxDelay;
+}
+
+void IPCThreadState::setLatencyCritical(bool critical)
+{
+    mLatencyCritical = critical;
+}
+
+status_t IPCThreadState::flushOnewayBatch()
+{
+    // The driver acknowledges batched transactions in order, so waiting
+    // for the completion of the last one also collects all the others;
+    // waitForResponse() absorbs those while mOnewayBatchCount is non-zero.
+    mOnewayBatchCount--;
+    return waitForResponse(NULL, NULL);
+}
+
 status_t IPCThreadState::getAndExecuteCommand()
 {
     status_t result;
     int32_t cmd;
 
+    const nsecs_t waitStart = systemTime(SYSTEM_TIME_MONOTONIC);
     result = talkWithDriver();
+    mLastWorkWait = systemTime(SYSTEM_TIME_MONOTONIC) - waitStart;
     if (result >= NO_ERROR) {
         size_t IN = mIn.dataAvail();
         if (IN < sizeof(int32_t)) return result;
@@ -451,6 +492,8 @@ status_t IPCThreadState::getAndExecuteCommand()
 void IPCThreadState::processPendingDerefs()
 {
     if (mIn.dataPosition() >= mIn.dataSize()) {
+        trimParcelPool();
+
         size_t numPending = mPendingWeakDerefs.size();
         if (numPending > 0) {
             for (size_t i = 0; i < numPending; i++) {
@@ -481,10 +524,15 @@ void IPCThreadState::joinThreadPool(bool isMain)
     // scheduling group, so first we will make sure it is in the foreground
     // one to avoid performing an initial transaction in the background.
     set_sched_policy(mMyThreadId, SP_FOREGROUND);
+
+    mInThreadPool = true;
+    mProcess->threadPoolThreadJoined();
         
-    status_t result;
+    bool retired = false;
+    status_t result = NO_ERROR;
     do {
         processPendingDerefs();
+
         // now get the next command to be processed, waiting if necessary
         result = getAndExecuteCommand();
 
@@ -499,10 +547,27 @@ void IPCThreadState::joinThreadPool(bool isMain)
         if(result == TIMED_OUT && !isMain) {
             break;
         }
+
+        // A thread that sat in the driver for longer than the idle timeout
+        // before this command came in is surplus to the pool; let it go once
+        // it has nothing left queued.  The wait itself stays a plain blocking
+        // read so the driver keeps counting us as ready and does not ask for
+        // more threads.
+        if (!isMain && result >= NO_ERROR && mIn.dataPosition() >= mIn.dataSize()) {
+            const nsecs_t idleTimeout = mProcess->getThreadPoolIdleTimeout();
+            if (idleTimeout > 0 && mLastWorkWait >= idleTimeout
+                    && mProcess->threadPoolThreadMayRetire()) {
+                retired = true;
+                break;
+            }
+        }
     } while (result != -ECONNREFUSED && result != -EBADF);
 
     LOG_THREADPOOL("**** THREAD %p (PID %d) IS LEAVING THE THREAD POOL err=%p\n",
-        (void*)pthread_self(), getpid(), (void*)result);
+        (void*)pthread_self(), getpid(), retired ? (void*)TIMED_OUT : (void*)result);
+
+    mInThreadPool = false;
+    mProcess->threadPoolThreadLeft(retired);
     
     mOut.writeInt32(BC_EXIT_LOOPER);
     talkWithDriver(false);
@@ -549,6 +614,16 @@ status_t IPCThreadState::transact(int32_t handle,
     status_t err = data.errorCheck();
 
     flags |= TF_ACCEPT_FDS;
+    if (mLatencyCritical) {
+        flags |= IBinder::FLAG_LATENCY_CRITICAL;
+    }
+    if (flags & IBinder::FLAG_LATENCY_CRITICAL) {
+        flags = (flags & ~(CALLER_REALTIME | CALLER_PRIORITY_MASK))
+                | callerSchedulingFlags(mMyThreadId);
+    }
+
+    const nsecs_t start = mProcess->isTransactionStatsEnabled() ?
+            systemTime(SYSTEM_TIME_MONOTONIC) : 0;
 
     IF_LOG_TRANSACTIONS() {
         TextOutput::Bundle _b(alog);
@@ -579,8 +654,9 @@ status_t IPCThreadState::transact(int32_t handle,
         if (reply) {
             err = waitForResponse(reply);
         } else {
-            Parcel fakeReply;
-            err = waitForResponse(&fakeReply);
+            Parcel* fakeReply = obtainParcel();
+            err = waitForResponse(fakeReply);
+            recycleParcel(fakeReply);
         }
         #if 0
         if (code == 4) { // relayout
@@ -597,13 +673,37 @@ status_t IPCThreadState::transact(int32_t handle,
             if (reply) alog << indent << *reply << dedent << endl;
             else alog << "(none requested)" << endl;
         }
+    } else if (mOnewayBatchBytes > 0) {
+        const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (mOnewayBatchCount++ == 0) {
+            mOnewayBatchStart = now;
+        }
+        if (mOut.dataSize() >= mOnewayBatchBytes
+                || now - mOnewayBatchStart >= mOnewayBatchDelay) {
+            err = flushOnewayBatch();
+        }
     } else {
         err = waitForResponse(NULL, NULL);
     }
+
+    if (start) {
+        recordTransaction(TransactionStats::OUTGOING, data, code, start);
+    }
     
     return err;
 }
 
+void IPCThreadState::recordTransaction(int direction, const Parcel& data,
+        uint32_t code, nsecs_t start)
+{
+    const nsecs_t duration = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    if (mTransactionStats == NULL) {
+        mTransactionStats = mProcess->acquireTransactionStats();
+    }
+    mTransactionStats->record(TransactionStats::direction_t(direction),
+            data, code, duration);
+}
+
 void IPCThreadState::incStrongHandle(int32_t handle)
 {
     LOG_REMOTEREFS("IPCThreadState::incStrongHandle(%d)\n", handle);
@@ -680,9 +780,44 @@ status_t IPCThreadState::clearDeathNotification(int32_t handle, BpBinder* proxy)
     return NO_ERROR;
 }
 
+void IPCThreadState::queueDeath(const wp<IBinder::DeathRecipient>& recipient,
+        const wp<IBinder>& proxy)
+{
+    ssize_t index = mPendingDeaths.indexOfKey(recipient);
+    if (index < 0) {
+        index = mPendingDeaths.add(recipient, Vector<wp<IBinder> >());
+    }
+    mPendingDeaths.editValueAt(index).add(proxy);
+}
+
+void IPCThreadState::deliverPendingDeaths()
+{
+    // the recipients may make binder calls, and end up here again
+    KeyedVector<wp<IBinder::DeathRecipient>, Vector<wp<IBinder> > > deaths(
+            mPendingDeaths);
+    mPendingDeaths.clear();
+    const size_t N = deaths.size();
+    for (size_t i = 0; i < N; i++) {
+        sp<IBinder::DeathRecipient> recipient = deaths.keyAt(i).promote();
+        if (recipient != NULL) {
+            recipient->bindersDied(deaths.valueAt(i));
+        }
+    }
+}
+
 IPCThreadState::IPCThreadState()
     : mProcess(ProcessState::self()),
       mMyThreadId(androidGetTid()),
+      mParcelsInUse(0),
+      mParcelsInUsePeak(0),
+      mOnewayBatchBytes(0),
+      mOnewayBatchDelay(0),
+      mOnewayBatchStart(0),
+      mOnewayBatchCount(0),
+      mTransactionStats(NULL),
+      mInThreadPool(false),
+      mLastWorkWait(0),
+      mLatencyCritical(false),
       mStrictModePolicy(0),
       mLastTransactionBinderFlags(0)
 {
@@ -694,6 +829,65 @@ IPCThreadState::IPCThreadState()
 
 IPCThreadState::~IPCThreadState()
 {
+    if (mTransactionStats != NULL) {
+        mProcess->releaseTransactionStats(mTransactionStats);
+    }
+    for (size_t i = 0; i < mParcelPool.size(); i++) {
+        delete mParcelPool[i];
+    }
+}
+
+Parcel* IPCThreadState::obtainParcel()
+{
+    Parcel* parcel;
+    const size_t pooled = mParcelPool.size();
+    if (pooled > 0) {
+        parcel = mParcelPool[pooled-1];
+        mParcelPool.removeAt(pooled-1);
+    } else {
+        parcel = new Parcel;
+    }
+    if (++mParcelsInUse > mParcelsInUsePeak) {
+        mParcelsInUsePeak = mParcelsInUse;
+    }
+    return parcel;
+}
+
+void IPCThreadState::recycleParcel(Parcel* parcel)
+{
+    mParcelsInUse--;
+    if (mParcelPool.size() >= kMaxPooledParcels
+            || parcel->dataCapacity() > kMaxPooledParcelCapacity) {
+        delete parcel;
+        return;
+    }
+
+    if (parcel->mOwner) {
+        // The data belongs to the driver; hand it back rather than
+        // copying it into storage we own.
+        parcel->freeData();
+    } else {
+        parcel->restartWrite(parcel->dataCapacity());
+    }
+    parcel->setError(NO_ERROR);
+    mParcelPool.push(parcel);
+}
+
+// Called whenever the thread runs out of incoming work: drop pooled Parcels
+// beyond what was needed at once since the last trim, and give back an
+// oversized command buffer if it happens to be empty.
+void IPCThreadState::trimParcelPool()
+{
+    while (mParcelPool.size() > mParcelsInUsePeak) {
+        const size_t last = mParcelPool.size() - 1;
+        delete mParcelPool[last];
+        mParcelPool.removeAt(last);
+    }
+    mParcelsInUsePeak = mParcelsInUse;
+
+    if (mOut.dataSize() == 0 && mOut.dataCapacity() > kMaxPooledParcelCapacity) {
+        mOut.restartWrite(256);
+    }
 }
 
 status_t IPCThreadState::sendReply(const Parcel& reply, uint32_t flags)
@@ -726,14 +920,29 @@ status_t IPCThreadState::waitForResponse(Parcel *reply, status_t *acquireResult)
 
         switch (cmd) {
         case BR_TRANSACTION_COMPLETE:
+            if (mOnewayBatchCount > 0) {
+                // Belongs to an earlier batched oneway transaction.
+                mOnewayBatchCount--;
+                break;
+            }
             if (!reply && !acquireResult) goto finish;
             break;
         
         case BR_DEAD_REPLY:
+            if (mOnewayBatchCount > 0) {
+                mOnewayBatchCount--;
+                mLastError = DEAD_OBJECT;
+                break;
+            }
             err = DEAD_OBJECT;
             goto finish;
 
         case BR_FAILED_REPLY:
+            if (mOnewayBatchCount > 0) {
+                mOnewayBatchCount--;
+                mLastError = FAILED_TRANSACTION;
+                break;
+            }
             err = FAILED_TRANSACTION;
             goto finish;
         
@@ -793,6 +1002,10 @@ finish:
         if (reply) reply->setError(err);
         mLastError = err;
     }
+
+    if (!mPendingDeaths.isEmpty()) {
+        deliverPendingDeaths();
+    }
     
     return err;
 }
@@ -946,6 +1159,12 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
     BBinder* obj;
     RefBase::weakref_type* refs;
     status_t result = NO_ERROR;
+
+    // batched deaths go out before anything that came after them
+    if (!mPendingDeaths.isEmpty() && cmd != BR_DEAD_BINDER
+            && cmd != BR_CLEAR_DEATH_NOTIFICATION_DONE && cmd != BR_NOOP) {
+        deliverPendingDeaths();
+    }
     
     switch (cmd) {
     case BR_ERROR:
@@ -1064,9 +1283,20 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                 }
             }
 
+            // The driver only passes on the caller's nice value, and only
+            // for synchronous calls; latency-critical ones get its
+            // scheduling policy too, and do for oneway calls.  The caller
+            // writes those flags itself, so only system callers are
+            // believed, and only up to a ceiling.
+            SavedScheduling savedScheduling;
+            const bool inheritedScheduling =
+                    (tr.flags & IBinder::FLAG_LATENCY_CRITICAL) != 0 &&
+                    inheritCallerScheduling(mMyThreadId, tr.flags, mCallingUid,
+                            &savedScheduling);
+
             //ALOGI(">>>> TRANSACT from pid %d uid %d\n", mCallingPid, mCallingUid);
 
-            Parcel reply;
+            Parcel& reply = *obtainParcel();
             status_t error;
             IF_LOG_TRANSACTIONS() {
                 TextOutput::Bundle _b(alog);
@@ -1079,6 +1309,11 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                     << ", offsets addr="
                     << reinterpret_cast<const size_t*>(tr.data.ptr.offsets) << endl;
             }
+            const nsecs_t start = mProcess->isTransactionStatsEnabled() ?
+                    systemTime(SYSTEM_TIME_MONOTONIC) : 0;
+            if (mInThreadPool) {
+                mProcess->threadPoolThreadBusy();
+            }
             if (tr.target.ptr) {
                 sp<BBinder> b((BBinder*)tr.cookie);
                 error = b->transact(tr.code, buffer, &reply, tr.flags);
@@ -1086,6 +1321,12 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
             } else {
                 error = the_context_object->transact(tr.code, buffer, &reply, tr.flags);
             }
+            if (mInThreadPool) {
+                mProcess->threadPoolThreadIdle();
+            }
+            if (start) {
+                recordTransaction(TransactionStats::INCOMING, buffer, tr.code, start);
+            }
 
             //ALOGI("<<<< TRANSACT from pid %d restore pid %d uid %d\n",
             //     mCallingPid, origPid, origUid);
@@ -1097,6 +1338,9 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
             } else {
                 LOG_ONEWAY("NOT sending reply to %d!", mCallingPid);
             }
+            if (inheritedScheduling) {
+                restoreScheduling(mMyThreadId, savedScheduling);
+            }
             
             mCallingPid = origPid;
             mCallingUid = origUid;
@@ -1108,7 +1352,8 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                 alog << "BC_REPLY thr " << (void*)pthread_self() << " / obj "
                     << tr.target.ptr << ": " << indent << reply << dedent << endl;
             }
-            
+
+            recycleParcel(&reply);
         }
         break;
     
@@ -1118,6 +1363,9 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
             proxy->sendObituary();
             mOut.writeInt32(BC_DEAD_BINDER_DONE);
             mOut.writePointer((uintptr_t)proxy);
+            if (mIn.dataCapacity() < kDeathReadSize) {
+                mIn.setDataCapacity(kDeathReadSize);
+            }
         } break;
         
     case BR_CLEAR_DEATH_NOTIFICATION_DONE:
@@ -1136,6 +1384,19 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
     case BR_SPAWN_LOOPER:
         mProcess->spawnPooledThread(false);
         break;
+
+    case BR_TRANSACTION_COMPLETE:
+    case BR_DEAD_REPLY:
+    case BR_FAILED_REPLY:
+        // A batched oneway transaction may be acknowledged while we are
+        // waiting for something else entirely (e.g. in the thread pool).
+        if (mOnewayBatchCount > 0) {
+            mOnewayBatchCount--;
+            break;
+        }
+        printf("*** BAD COMMAND %d received from Binder driver\n", cmd);
+        result = UNKNOWN_ERROR;
+        break;
         
     default:
         printf("*** BAD COMMAND %d received from Binder driver\n", cmd);
@@ -1146,6 +1407,10 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
     if (result != NO_ERROR) {
         mLastError = result;
     }
+
+    if (!mPendingDeaths.isEmpty() && mIn.dataAvail() == 0) {
+        deliverPendingDeaths();
+    }
     
     return result;
 }
@@ -21,8 +21,10 @@
 #include <utils/Log.h>
 #include <binder/IPCThreadState.h>
 #include <binder/Parcel.h>
+#include <utils/KeyedVector.h>
 #include <utils/String8.h>
 #include <utils/SystemClock.h>
+#include <utils/threads.h>
 
 #include <private/binder/Static.h>
 
@@ -125,31 +127,212 @@ bool checkPermission(const String16& permission, pid_t pid, uid_t uid)
 
 class BpServiceManager : public BpInterface<IServiceManager>
 {
+    // Remote services found by checkService() are remembered while this
+    // process still holds them and until they die, so repeated lookups of
+    // the same name don't go back to the service manager. Only weak
+    // references are kept: the cache doesn't keep a service alive, and once
+    // the process lets go of it the next lookup asks the service manager
+    // again, picking up a service registered anew under the same name.
+    // Local services and failed lookups aren't cached.
+    class CacheDeathRecipient : public IBinder::DeathRecipient {
+    public:
+        CacheDeathRecipient(BpServiceManager* sm) : mServiceManager(sm) { }
+        virtual void binderDied(const wp<IBinder>& who) {
+            sp<BpServiceManager> sm(mServiceManager.promote());
+            if (sm != NULL) {
+                sm->evict(who);
+            }
+        }
+    private:
+        wp<BpServiceManager> mServiceManager;
+    };
+
+    // Callback given to the service manager by waitForService(), which
+    // sends it the service once it is registered.
+    class ServiceNotification : public BBinder {
+    public:
+        enum {
+            // must match SVC_MGR_SERVICE_REGISTERED in servicemanager
+            SERVICE_REGISTERED_TRANSACTION = IBinder::FIRST_CALL_TRANSACTION,
+        };
+
+        virtual status_t onTransact(uint32_t code, const Parcel& data,
+                Parcel* reply, uint32_t flags = 0) {
+            if (code != SERVICE_REGISTERED_TRANSACTION) {
+                return BBinder::onTransact(code, data, reply, flags);
+            }
+            Mutex::Autolock _l(mLock);
+            mService = data.readStrongBinder();
+            mCondition.broadcast();
+            return NO_ERROR;
+        }
+
+        sp<IBinder> wait(nsecs_t timeout) {
+            Mutex::Autolock _l(mLock);
+            if (mService == NULL) {
+                mCondition.waitRelative(mLock, timeout);
+            }
+            return mService;
+        }
+
+    private:
+        Mutex mLock;
+        Condition mCondition;
+        sp<IBinder> mService;
+    };
+
 public:
     BpServiceManager(const sp<IBinder>& impl)
         : BpInterface<IServiceManager>(impl)
     {
     }
 
+    void evict(const wp<IBinder>& who) const
+    {
+        Mutex::Autolock _l(mCacheLock);
+        for (size_t i = mCache.size(); i > 0; i--) {
+            if (mCache.valueAt(i-1) == who) {
+                mCache.removeItemsAt(i-1);
+            }
+        }
+    }
+
+    void evict(const String16& name) const
+    {
+        sp<IBinder> svc;
+        sp<IBinder::DeathRecipient> recipient;
+        {
+            Mutex::Autolock _l(mCacheLock);
+            ssize_t index = mCache.indexOfKey(name);
+            if (index < 0) {
+                return;
+            }
+            svc = mCache.valueAt(index).promote();
+            mCache.removeItemsAt(index);
+            if (svc == NULL || isCachedLocked(svc)) {
+                // still linked for another name
+                return;
+            }
+            recipient = mDeathRecipient;
+        }
+        svc->unlinkToDeath(recipient);
+    }
+
+    bool isCachedLocked(const sp<IBinder>& svc) const
+    {
+        for (size_t i = 0; i < mCache.size(); i++) {
+            if (mCache.valueAt(i) == svc) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     virtual sp<IBinder> getService(const String16& name) const
     {
-        unsigned n;
-        for (n = 0; n < 5; n++){
-            sp<IBinder> svc = checkService(name);
-            if (svc != NULL) return svc;
-            ALOGI("Waiting for service %s...\n", String8(name).string());
-            sleep(1);
+        return waitForService(name, seconds_to_nanoseconds(5));
+    }
+
+    virtual sp<IBinder> waitForService(const String16& name, nsecs_t timeout) const
+    {
+        sp<IBinder> svc = checkService(name);
+        if (svc != NULL) return svc;
+
+        // Ask to be told when the service is registered. The service
+        // manager replies with the service instead if it was registered
+        // in the meantime. An older one doesn't know the transaction, and
+        // the loop below falls back to checking every second. Callers
+        // waiting for the same name share one callback, which the service
+        // manager keeps only once, even after they have given up.
+        sp<ServiceNotification> notification = getNotification(name);
+        Parcel data, reply;
+        data.writeInterfaceToken(IServiceManager::getInterfaceDescriptor());
+        data.writeString16(name);
+        data.writeStrongBinder(notification);
+        if (remote()->transact(NOTIFY_SERVICE_TRANSACTION, data, &reply) == NO_ERROR) {
+            svc = reply.readStrongBinder();
+            if (svc != NULL) {
+                forgetNotification(name, notification);
+                return svc;
+            }
+        }
+
+        ALOGI("Waiting for service %s...\n", String8(name).string());
+        const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (;;) {
+            nsecs_t wait = seconds_to_nanoseconds(1);
+            if (timeout >= 0) {
+                nsecs_t left = start + timeout - systemTime(SYSTEM_TIME_MONOTONIC);
+                if (left <= 0) return NULL;
+                if (left < wait) wait = left;
+            }
+            svc = notification->wait(wait);
+            if (svc == NULL) {
+                svc = checkService(name);
+            }
+            if (svc != NULL) {
+                forgetNotification(name, notification);
+                return svc;
+            }
+        }
+    }
+
+    sp<ServiceNotification> getNotification(const String16& name) const
+    {
+        Mutex::Autolock _l(mNotificationLock);
+        ssize_t index = mNotifications.indexOfKey(name);
+        if (index >= 0) {
+            return mNotifications.valueAt(index);
+        }
+        sp<ServiceNotification> notification = new ServiceNotification();
+        mNotifications.add(name, notification);
+        return notification;
+    }
+
+    // Once the service is found, the service manager has already sent it
+    // to the callback and dropped it.
+    void forgetNotification(const String16& name,
+            const sp<ServiceNotification>& notification) const
+    {
+        Mutex::Autolock _l(mNotificationLock);
+        ssize_t index = mNotifications.indexOfKey(name);
+        if (index >= 0 && mNotifications.valueAt(index) == notification) {
+            mNotifications.removeItemsAt(index);
         }
-        return NULL;
     }
 
     virtual sp<IBinder> checkService( const String16& name) const
     {
+        {
+            Mutex::Autolock _l(mCacheLock);
+            ssize_t index = mCache.indexOfKey(name);
+            if (index >= 0) {
+                sp<IBinder> svc(mCache.valueAt(index).promote());
+                if (svc != NULL) {
+                    return svc;
+                }
+                mCache.removeItemsAt(index);
+            }
+        }
+
         Parcel data, reply;
         data.writeInterfaceToken(IServiceManager::getInterfaceDescriptor());
         data.writeString16(name);
         remote()->transact(CHECK_SERVICE_TRANSACTION, data, &reply);
-        return reply.readStrongBinder();
+        sp<IBinder> svc(reply.readStrongBinder());
+
+        if (svc != NULL && svc->remoteBinder() != NULL) {
+            Mutex::Autolock _l(mCacheLock);
+            if (mDeathRecipient == NULL) {
+                mDeathRecipient = new CacheDeathRecipient(
+                        const_cast<BpServiceManager*>(this));
+            }
+            if (isCachedLocked(svc) ||
+                    svc->linkToDeath(mDeathRecipient) == NO_ERROR) {
+                mCache.add(name, svc);
+            }
+        }
+        return svc;
     }
 
     virtual status_t addService(const String16& name, const sp<IBinder>& service,
@@ -160,6 +343,7 @@ public:
         data.writeString16(name);
         data.writeStrongBinder(service);
         data.writeInt32(allowIsolated ? 1 : 0);
+        evict(name);
         status_t err = remote()->transact(ADD_SERVICE_TRANSACTION, data, &reply);
         return err == NO_ERROR ? reply.readExceptionCode() : err;
     }
@@ -180,6 +364,13 @@ public:
         }
         return res;
     }
+
+private:
+    mutable Mutex mCacheLock;
+    mutable KeyedVector<String16, wp<IBinder> > mCache;
+    mutable sp<IBinder::DeathRecipient> mDeathRecipient;
+    mutable Mutex mNotificationLock;
+    mutable KeyedVector<String16, sp<ServiceNotification> > mNotifications;
 };
 
 IMPLEMENT_META_INTERFACE(ServiceManager, "android.os.IServiceManager");
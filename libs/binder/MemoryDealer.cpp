@@ -122,10 +122,11 @@ private:
 
 class SimpleBestFitAllocator
 {
+public:
     enum {
         PAGE_ALIGNED = 0x00000001
     };
-public:
+
     SimpleBestFitAllocator(size_t size);
     ~SimpleBestFitAllocator();
 
@@ -134,6 +135,8 @@ public:
     size_t      size() const;
     void        dump(const char* what) const;
     void        dump(String8& res, const char* what) const;
+    void        getFreeStats(size_t* freeBytes, size_t* largestFree,
+                        size_t* freeChunks) const;
 
 private:
 
@@ -161,6 +164,67 @@ private:
 
 // ----------------------------------------------------------------------------
 
+/*
+ * Serves small allocations from one page slabs of equally sized blocks, one
+ * power of two size class per slab, taking the pages from the best-fit
+ * allocator. A bitmap tracks the blocks of each slab, and the slabs with a
+ * free block are kept in a list per class, so neither allocating nor freeing
+ * scans anything but a slab's bitmap. Slabs are indexed by page, which is
+ * how a freed offset finds its slab.
+ */
+class SizeClassAllocator
+{
+public:
+    SizeClassAllocator(SimpleBestFitAllocator* pages);
+    ~SizeClassAllocator();
+
+    // allocate returns NO_MEMORY if size is 0 or larger than the largest
+    // class, deallocate NAME_NOT_FOUND if offset isn't in a slab: both must
+    // then go to the best-fit allocator.
+    ssize_t     allocate(size_t size);
+    status_t    deallocate(size_t offset);
+    void        dump(String8& res) const;
+
+private:
+    enum {
+        kMinClassShift = 5,     // 32 bytes, SimpleBestFitAllocator's alignment
+        kMaxClassShift = 11,    // 2KB
+        kNumClasses = kMaxClassShift - kMinClassShift + 1
+    };
+
+    struct slab_t {
+        size_t      page;
+        size_t      used;
+        slab_t*     prev;
+        slab_t*     next;
+        uint32_t    cls;
+        uint32_t    bitmap[1];  // mBitmapWords words, 1 bits are allocated
+    };
+
+    struct class_t {
+        class_t() : slabs(0), used(0), spare(0) { }
+        LinkedList<slab_t>  partial;    // slabs with at least one free block
+        size_t              slabs;
+        size_t              used;
+        slab_t*             spare;      // an empty slab kept to avoid churn
+    };
+
+    static uint32_t classOf(size_t size);
+    size_t capacity(uint32_t cls) const { return mPageSize >> (cls + kMinClassShift); }
+    slab_t* newSlab_l(uint32_t cls);
+    void freeSlab_l(slab_t* slab);
+
+    mutable Mutex               mLock;
+    SimpleBestFitAllocator*     mPages;
+    const size_t                mPageSize;
+    const size_t                mBitmapWords;
+    slab_t**                    mSlabs;     // by page index, NULL if not a slab
+    size_t                      mNumPages;
+    class_t                     mClasses[kNumClasses];
+};
+
+// ----------------------------------------------------------------------------
+
 Allocation::Allocation(
         const sp<MemoryDealer>& dealer,
         const sp<IMemoryHeap>& heap, ssize_t offset, size_t size)
@@ -226,26 +290,38 @@ Allocation::~Allocation()
 // ----------------------------------------------------------------------------
 
 MemoryDealer::MemoryDealer(size_t size, const char* name, uint32_t flags)
-    : mHeap(new MemoryHeapBase(size, flags, name)),
-    mAllocator(new SimpleBestFitAllocator(size))
+    : mHeap(new MemoryHeapBase(size, flags & ~SIZE_CLASSES, name)),
+    mAllocator(new SimpleBestFitAllocator(size)),
+    mSizeClasses(0)
 {
+    if (flags & SIZE_CLASSES) {
+        mSizeClasses = new SizeClassAllocator(mAllocator);
+    }
 }
 
 MemoryDealer::MemoryDealer(size_t size, const char* name)
     : mHeap(new MemoryHeapBase(size, 0, name)),
-    mAllocator(new SimpleBestFitAllocator(size))
+    mAllocator(new SimpleBestFitAllocator(size)),
+    mSizeClasses(0)
 {
 }
 
 MemoryDealer::~MemoryDealer()
 {
+    delete mSizeClasses;
     delete mAllocator;
 }
 
 sp<IMemory> MemoryDealer::allocate(size_t size)
 {
     sp<IMemory> memory;
-    const ssize_t offset = allocator()->allocate(size);
+    ssize_t offset = NO_MEMORY;
+    if (mSizeClasses) {
+        offset = mSizeClasses->allocate(size);
+    }
+    if (offset < 0) {
+        offset = allocator()->allocate(size);
+    }
     if (offset >= 0) {
         memory = new Allocation(this, heap(), offset, size);
     }
@@ -254,12 +330,20 @@ sp<IMemory> MemoryDealer::allocate(size_t size)
 
 void MemoryDealer::deallocate(size_t offset)
 {
+    if (mSizeClasses && mSizeClasses->deallocate(offset) == NO_ERROR) {
+        return;
+    }
     allocator()->deallocate(offset);
 }
 
 void MemoryDealer::dump(const char* what) const
 {
     allocator()->dump(what);
+    if (mSizeClasses) {
+        String8 result;
+        mSizeClasses->dump(result);
+        ALOGD("%s", result.string());
+    }
 }
 
 const sp<IMemoryHeap>& MemoryDealer::heap() const {
@@ -272,6 +356,163 @@ SimpleBestFitAllocator* MemoryDealer::allocator() const {
 
 // ----------------------------------------------------------------------------
 
+SizeClassAllocator::SizeClassAllocator(SimpleBestFitAllocator* pages)
+    : mPages(pages),
+      mPageSize(getpagesize()),
+      mBitmapWords(((mPageSize >> kMinClassShift) + 31) / 32)
+{
+    mNumPages = pages->size() / mPageSize;
+    mSlabs = new slab_t*[mNumPages];
+    memset(mSlabs, 0, mNumPages * sizeof(slab_t*));
+}
+
+SizeClassAllocator::~SizeClassAllocator()
+{
+    // the pages go away with the best-fit allocator
+    for (size_t i = 0; i < mNumPages; i++) {
+        free(mSlabs[i]);
+    }
+    delete[] mSlabs;
+}
+
+uint32_t SizeClassAllocator::classOf(size_t size)
+{
+    uint32_t cls = 0;
+    size = (size - 1) >> kMinClassShift;
+    while (size) {
+        size >>= 1;
+        cls++;
+    }
+    return cls;
+}
+
+SizeClassAllocator::slab_t* SizeClassAllocator::newSlab_l(uint32_t cls)
+{
+    const ssize_t offset = mPages->allocate(mPageSize,
+            SimpleBestFitAllocator::PAGE_ALIGNED);
+    if (offset < 0) {
+        return 0;
+    }
+    slab_t* slab = (slab_t*)calloc(1,
+            sizeof(slab_t) + (mBitmapWords - 1) * sizeof(uint32_t));
+    if (slab == 0) {
+        mPages->deallocate(offset);
+        return 0;
+    }
+    slab->page = offset / mPageSize;
+    slab->cls = cls;
+    mSlabs[slab->page] = slab;
+    mClasses[cls].slabs++;
+    return slab;
+}
+
+void SizeClassAllocator::freeSlab_l(slab_t* slab)
+{
+    mClasses[slab->cls].slabs--;
+    mSlabs[slab->page] = 0;
+    mPages->deallocate(slab->page * mPageSize);
+    free(slab);
+}
+
+ssize_t SizeClassAllocator::allocate(size_t size)
+{
+    if (size == 0 || size > (1 << kMaxClassShift)) {
+        return NO_MEMORY;
+    }
+    const uint32_t cls = classOf(size);
+    class_t& c = mClasses[cls];
+
+    Mutex::Autolock _l(mLock);
+    slab_t* slab = c.partial.head();
+    if (slab == 0) {
+        if (c.spare) {
+            slab = c.spare;
+            c.spare = 0;
+        } else {
+            slab = newSlab_l(cls);
+            if (slab == 0) {
+                return NO_MEMORY;
+            }
+        }
+        c.partial.insertHead(slab);
+    }
+
+    size_t w = 0;
+    while (slab->bitmap[w] == 0xFFFFFFFF) {
+        w++;
+    }
+    const uint32_t bit = __builtin_ctz(~slab->bitmap[w]);
+    slab->bitmap[w] |= 1u << bit;
+    c.used++;
+    if (++slab->used == capacity(cls)) {
+        c.partial.remove(slab);
+    }
+    const size_t index = w * 32 + bit;
+    return slab->page * mPageSize + (index << (cls + kMinClassShift));
+}
+
+status_t SizeClassAllocator::deallocate(size_t offset)
+{
+    const size_t page = offset / mPageSize;
+    if (page >= mNumPages) {
+        return NAME_NOT_FOUND;
+    }
+
+    Mutex::Autolock _l(mLock);
+    slab_t* slab = mSlabs[page];
+    if (slab == 0) {
+        return NAME_NOT_FOUND;
+    }
+    class_t& c = mClasses[slab->cls];
+    const size_t index = (offset - page * mPageSize) >> (slab->cls + kMinClassShift);
+    const uint32_t mask = 1u << (index % 32);
+    LOG_FATAL_IF(!(slab->bitmap[index / 32] & mask),
+            "block at offset 0x%08zX already freed", offset);
+    slab->bitmap[index / 32] &= ~mask;
+    c.used--;
+    if (slab->used-- == capacity(slab->cls)) {
+        c.partial.insertHead(slab);
+    }
+    if (slab->used == 0) {
+        c.partial.remove(slab);
+        if (c.spare) {
+            freeSlab_l(slab);
+        } else {
+            c.spare = slab;
+        }
+    }
+    return NO_ERROR;
+}
+
+void SizeClassAllocator::dump(String8& result) const
+{
+    size_t freeBytes, largestFree, freeChunks;
+    mPages->getFreeStats(&freeBytes, &largestFree, &freeChunks);
+
+    Mutex::Autolock _l(mLock);
+    size_t slabBytes = 0;
+    size_t usedBytes = 0;
+    result.appendFormat("  size classes (%p)\n", this);
+    for (uint32_t i = 0; i < kNumClasses; i++) {
+        const class_t& c = mClasses[i];
+        const size_t blockSize = 1 << (i + kMinClassShift);
+        result.appendFormat("  %5zu: %4zu slabs | %6zu/%6zu blocks used\n",
+                blockSize, c.slabs, c.used, c.slabs * capacity(i));
+        slabBytes += c.slabs * mPageSize;
+        usedBytes += c.used * blockSize;
+    }
+    // internal fragmentation is what the slabs hold but don't hand out,
+    // external what the free space of the heap is split into
+    result.appendFormat("  slabs: %zu KB, %zu%% unused\n", slabBytes / 1024,
+            slabBytes ? 100 - usedBytes * 100 / slabBytes : 0);
+    result.appendFormat("  free: %zu KB in %zu chunks, largest %zu KB "
+            "(%zu%% fragmented)\n", freeBytes / 1024, freeChunks,
+            largestFree / 1024,
+            freeBytes ? 100 - largestFree * 100 / freeBytes : 0);
+}
+
+// ----------------------------------------------------------------------------
+
 // align all the memory blocks on a cache-line boundary
 const int SimpleBestFitAllocator::kMemoryAlign = 32;
 
@@ -411,6 +652,23 @@ SimpleBestFitAllocator::chunk_t* SimpleBestFitAllocator::dealloc(size_t start)
     return 0;
 }
 
+void SimpleBestFitAllocator::getFreeStats(size_t* freeBytes,
+        size_t* largestFree, size_t* freeChunks) const
+{
+    Mutex::Autolock _l(mLock);
+    *freeBytes = *largestFree = *freeChunks = 0;
+    for (chunk_t const* cur = mList.head(); cur; cur = cur->next) {
+        if (cur->free) {
+            const size_t size = cur->size * kMemoryAlign;
+            *freeBytes += size;
+            if (size > *largestFree) {
+                *largestFree = size;
+            }
+            (*freeChunks)++;
+        }
+    }
+}
+
 void SimpleBestFitAllocator::dump(const char* what) const
 {
     Mutex::Autolock _l(mLock);
@@ -33,6 +33,7 @@
 #include <utils/String16.h>
 #include <utils/misc.h>
 #include <utils/Flattenable.h>
+#include <utils/threads.h>
 #include <cutils/ashmem.h>
 
 #include <private/binder/binder_module.h>
@@ -43,6 +44,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #ifndef INT32_MAX
 #define INT32_MAX ((int32_t)(2147483647))
@@ -388,13 +390,22 @@ status_t Parcel::appendFrom(const Parcel *parcel, size_t offset, size_t len)
     }
 
     // Count objects in range
-    for (int i = 0; i < (int) size; i++) {
-        size_t off = objects[i];
-        if ((off >= offset) && (off < offset + len)) {
-            if (firstIndex == -1) {
-                firstIndex = i;
+    if (parcel->mObjectsSorted) {
+        const size_t first = parcel->lowerBoundObject(offset);
+        const size_t end = parcel->lowerBoundObject(offset + len);
+        if (first < end) {
+            firstIndex = first;
+            lastIndex = end - 1;
+        }
+    } else {
+        for (int i = 0; i < (int) size; i++) {
+            size_t off = objects[i];
+            if ((off >= offset) && (off < offset + len)) {
+                if (firstIndex == -1) {
+                    firstIndex = i;
+                }
+                lastIndex = i;
             }
-            lastIndex = i;
         }
     }
     int numObjects = lastIndex - firstIndex + 1;
@@ -418,16 +429,18 @@ status_t Parcel::appendFrom(const Parcel *parcel, size_t offset, size_t len)
         // grow objects
         if (mObjectsCapacity < mObjectsSize + numObjects) {
             int newSize = ((mObjectsSize + numObjects)*3)/2;
-            binder_size_t *objects =
-                (binder_size_t*)realloc(mObjects, newSize*sizeof(binder_size_t));
-            if (objects == (binder_size_t*)0) {
+            if (reallocObjects(newSize) != NO_ERROR) {
                 return NO_MEMORY;
             }
-            mObjects = objects;
-            mObjectsCapacity = newSize;
         }
 
         // append and acquire objects
+        if (mObjectsSize > 0 && mObjects[mObjectsSize-1] >= binder_size_t(startPos)) {
+            mObjectsSorted = false;
+        }
+        if (!parcel->mObjectsSorted) {
+            mObjectsSorted = false;
+        }
         int idx = mObjectsSize;
         for (int i = firstIndex; i <= lastIndex; i++) {
             size_t off = objects[i] - offset + startPos;
@@ -444,7 +457,9 @@ status_t Parcel::appendFrom(const Parcel *parcel, size_t offset, size_t len)
                 // officially know we have fds.
                 flat->handle = dup(flat->handle);
                 flat->cookie = 1;
-                mHasFds = mFdsKnown = true;
+                if (mFdsKnown) {
+                    mFdCount++;
+                }
                 if (!mAllowFds) {
                     err = FDS_NOT_ALLOWED;
                 }
@@ -474,7 +489,7 @@ bool Parcel::hasFileDescriptors() const
     if (!mFdsKnown) {
         scanForFds();
     }
-    return mHasFds;
+    return mFdCount > 0;
 }
 
 // Write RPC headers.  (previously just the interface token)
@@ -508,12 +523,17 @@ bool Parcel::enforceInterface(const String16& interface,
     } else {
       threadState->setStrictModePolicy(strictPolicy);
     }
-    const String16 str(readString16());
-    if (str == interface) {
+    // Compare in place rather than materializing a String16: this runs at
+    // the start of every incoming transaction.
+    size_t len;
+    const char16_t* str = readString16Inplace(&len);
+    if (str != NULL && len == interface.size()
+            && (len == 0 || memcmp(str, interface.string(), len*sizeof(char16_t)) == 0)) {
         return true;
     } else {
         ALOGW("**** enforceInterface() expected '%s' but read '%s'",
-                String8(interface).string(), String8(str).string());
+                String8(interface).string(),
+                str != NULL ? String8(str, len).string() : "");
         return false;
     }
 }
@@ -827,7 +847,164 @@ status_t Parcel::writeParcelFileDescriptor(int fd, int commChannel) {
     return status;
 }
 
+// --- Blob region pool ---
+
+// An ashmem region, mapped read/write in this process, handed out by
+// writeBlob() when the pool is enabled. Once the last reference goes away
+// the region goes back to the pool instead of being unmapped and closed.
+// Whoever received its fd may still have it mapped, so a region is only
+// ever handed out again for the same receiver.
+class BlobRegion : public RefBase {
+public:
+    BlobRegion(int fd, void* data, size_t size, const wp<IBinder>& receiver)
+        : mFd(fd), mData(data), mSize(size), mReceiver(receiver) { }
+    int fd() const { return mFd; }
+    void* data() const { return mData; }
+    size_t size() const { return mSize; }
+protected:
+    virtual ~BlobRegion();
+private:
+    const int mFd;
+    void* const mData;
+    const size_t mSize;
+    const wp<IBinder> mReceiver;
+};
+
+class BlobPool {
+public:
+    struct region_t {
+        int fd;
+        void* data;
+        size_t size;
+        // The binder the region was sent to.  A wp compares equal only to
+        // the same object, even if another one reuses its address.
+        wp<IBinder> receiver;
+    };
+
+    static Mutex sLock;
+    static Vector<region_t> sIdle;
+    static size_t sIdleBytes;
+    static size_t sMaxIdleBytes;
+
+    static bool isEnabled() {
+        Mutex::Autolock _l(sLock);
+        return sMaxIdleBytes > 0;
+    }
+
+    static void destroy(const region_t& r) {
+        ::munmap(r.data, r.size);
+        ::close(r.fd);
+    }
+
+    // Returns an idle region of at least len bytes (and not wastefully
+    // larger) last sent to the same receiver, or creates a fresh one.
+    static sp<BlobRegion> obtain(size_t len, const wp<IBinder>& receiver) {
+        const size_t pageSize = getpagesize();
+        const size_t size = (len + pageSize - 1) & ~(pageSize - 1);
+        {
+            Mutex::Autolock _l(sLock);
+            ssize_t best = -1;
+            for (size_t i = 0; i < sIdle.size(); i++) {
+                const size_t s = sIdle[i].size;
+                if (sIdle[i].receiver == receiver && s >= size && s <= 2*size
+                        && (best < 0 || s < sIdle[best].size)) {
+                    best = i;
+                }
+            }
+            if (best >= 0) {
+                const region_t r(sIdle[best]);
+                sIdle.removeAt(best);
+                sIdleBytes -= r.size;
+                // Don't let the tail of the previous blob show past this one.
+                memset(reinterpret_cast<uint8_t*>(r.data) + len, 0, r.size - len);
+                return new BlobRegion(r.fd, r.data, r.size, receiver);
+            }
+        }
+
+        int fd = ashmem_create_region("Parcel Blob", size);
+        if (fd < 0) return NULL;
+        if (ashmem_set_prot_region(fd, PROT_READ | PROT_WRITE) < 0) {
+            ::close(fd);
+            return NULL;
+        }
+        void* ptr = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            ::close(fd);
+            return NULL;
+        }
+        // Our own mapping stays writable; receivers can only map it
+        // read-only from here on.
+        if (ashmem_set_prot_region(fd, PROT_READ) < 0) {
+            ::munmap(ptr, size);
+            ::close(fd);
+            return NULL;
+        }
+        return new BlobRegion(fd, ptr, size, receiver);
+    }
+
+    static void recycle(const region_t& r) {
+        Vector<region_t> evicted;
+        {
+            Mutex::Autolock _l(sLock);
+            // Evict the oldest idle regions to stay under the limit.
+            while (!sIdle.isEmpty() && sIdleBytes + r.size > sMaxIdleBytes) {
+                sIdleBytes -= sIdle[0].size;
+                evicted.add(sIdle[0]);
+                sIdle.removeAt(0);
+            }
+            if (r.size <= sMaxIdleBytes) {
+                sIdle.add(r);
+                sIdleBytes += r.size;
+            } else {
+                evicted.add(r);
+            }
+        }
+        for (size_t i = 0; i < evicted.size(); i++) {
+            destroy(evicted[i]);
+        }
+    }
+};
+
+Mutex BlobPool::sLock;
+Vector<BlobPool::region_t> BlobPool::sIdle;
+size_t BlobPool::sIdleBytes = 0;
+size_t BlobPool::sMaxIdleBytes = 0;
+
+BlobRegion::~BlobRegion()
+{
+    BlobPool::region_t r;
+    r.fd = mFd;
+    r.data = mData;
+    r.size = mSize;
+    r.receiver = mReceiver;
+    BlobPool::recycle(r);
+}
+
+void Parcel::setBlobPoolLimit(size_t maxIdleBytes)
+{
+    Vector<BlobPool::region_t> evicted;
+    {
+        Mutex::Autolock _l(BlobPool::sLock);
+        BlobPool::sMaxIdleBytes = maxIdleBytes;
+        while (!BlobPool::sIdle.isEmpty()
+                && BlobPool::sIdleBytes > maxIdleBytes) {
+            BlobPool::sIdleBytes -= BlobPool::sIdle[0].size;
+            evicted.add(BlobPool::sIdle[0]);
+            BlobPool::sIdle.removeAt(0);
+        }
+    }
+    for (size_t i = 0; i < evicted.size(); i++) {
+        BlobPool::destroy(evicted[i]);
+    }
+}
+
 status_t Parcel::writeBlob(size_t len, WritableBlob* outBlob)
+{
+    return writeBlob(len, NULL, outBlob);
+}
+
+status_t Parcel::writeBlob(size_t len, const sp<IBinder>& receiver,
+        WritableBlob* outBlob)
 {
     status_t status;
 
@@ -843,6 +1020,20 @@ status_t Parcel::writeBlob(size_t len, WritableBlob* outBlob)
         return NO_ERROR;
     }
 
+    if (receiver != NULL && BlobPool::isEnabled()) {
+        ALOGV("writeBlob: write to pooled ashmem");
+        sp<BlobRegion> region(BlobPool::obtain(len, receiver));
+        if (region == NULL) return NO_MEMORY;
+        status = writeInt32(1);
+        if (status) return status;
+        // The region keeps its fd; the Parcel holds a reference instead.
+        status = writeFileDescriptor(region->fd(), false /*takeOwnership*/);
+        if (status) return status;
+        mBlobRegions.push(region);
+        outBlob->init(true /*mapped*/, region->data(), len, region);
+        return NO_ERROR;
+    }
+
     ALOGV("writeBlob: write to ashmem");
     int fd = ashmem_create_region("Parcel Blob", len);
     if (fd < 0) return NO_MEMORY;
@@ -927,7 +1118,11 @@ restart_write:
         *reinterpret_cast<flat_binder_object*>(mData+mDataPos) = val;
 
         // Need to write meta-data?
-        if (nullMetaData || val.binder != 0) {
+        const bool recorded = nullMetaData || val.binder != 0;
+        if (recorded) {
+            if (mObjectsSize > 0 && mObjects[mObjectsSize-1] >= mDataPos) {
+                mObjectsSorted = false;
+            }
             mObjects[mObjectsSize] = mDataPos;
             acquire_object(ProcessState::self(), val, this);
             mObjectsSize++;
@@ -938,7 +1133,9 @@ restart_write:
             if (!mAllowFds) {
                 return FDS_NOT_ALLOWED;
             }
-            mHasFds = mFdsKnown = true;
+            if (recorded && mFdsKnown) {
+                mFdCount++;
+            }
         }
 
         return finishWrite(sizeof(flat_binder_object));
@@ -950,10 +1147,7 @@ restart_write:
     }
     if (!enoughObjects) {
         size_t newSize = ((mObjectsSize+2)*3)/2;
-        binder_size_t* objects = (binder_size_t*)realloc(mObjects, newSize*sizeof(binder_size_t));
-        if (objects == NULL) return NO_MEMORY;
-        mObjects = objects;
-        mObjectsCapacity = newSize;
+        if (reallocObjects(newSize) != NO_ERROR) return NO_MEMORY;
     }
 
     goto restart_write;
@@ -1373,6 +1567,25 @@ const flat_binder_object* Parcel::readObject(bool nullMetaData) const
             ALOGV("Parcel %p looking for obj at %zu, hint=%zu",
                  this, DPOS, opos);
 
+            // Objects are nearly always read back in order, so the hint is
+            // usually spot on.  Otherwise binary search if we can.
+            if (opos < N && OBJS[opos] == DPOS) {
+                mNextObjectHint = opos+1;
+                return obj;
+            }
+            if (mObjectsSorted) {
+                opos = lowerBoundObject(DPOS);
+                if (opos < N && OBJS[opos] == DPOS) {
+                    ALOGV("Parcel %p found obj %zu at index %zu with binary search",
+                         this, DPOS, opos);
+                    mNextObjectHint = opos+1;
+                    return obj;
+                }
+                ALOGW("Attempt to read object from Parcel %p at offset %zu that is not in the object list",
+                     this, DPOS);
+                return NULL;
+            }
+
             // Start at the current hint position, looking for an object at
             // the current data position.
             if (opos < N) {
@@ -1461,6 +1674,8 @@ void Parcel::ipcSetDataReference(const uint8_t* data, size_t dataSize,
     mObjects = const_cast<binder_size_t*>(objects);
     mObjectsSize = mObjectsCapacity = objectsCount;
     mNextObjectHint = 0;
+    // The loop below rejects anything that isn't in increasing order.
+    mObjectsSorted = true;
     mOwner = relFunc;
     mOwnerCookie = relCookie;
     for (size_t i = 0; i < mObjectsSize; i++) {
@@ -1543,9 +1758,10 @@ void Parcel::freeDataNoInit()
         mOwner(this, mData, mDataSize, mObjects, mObjectsSize, mOwnerCookie);
     } else {
         releaseObjects();
-        if (mData) free(mData);
-        if (mObjects) free(mObjects);
+        freeDataStorage(mData);
+        freeObjectsStorage(mObjects);
     }
+    mBlobRegions.clear();
 }
 
 status_t Parcel::growData(size_t len)
@@ -1563,29 +1779,27 @@ status_t Parcel::restartWrite(size_t desired)
         return continueWrite(desired);
     }
 
-    uint8_t* data = (uint8_t*)realloc(mData, desired);
-    if (!data && desired > mDataCapacity) {
-        mError = NO_MEMORY;
-        return NO_MEMORY;
-    }
-
     releaseObjects();
+    freeObjectsStorage(mObjects);
+    mObjects = NULL;
+    mObjectsSize = mObjectsCapacity = 0;
+    mNextObjectHint = 0;
+    mBlobRegions.clear();
 
-    if (data) {
-        mData = data;
-        mDataCapacity = desired;
-    }
-
+    // Nothing in the old data needs to survive, so don't let the
+    // reallocation copy stale contents around.
     mDataSize = mDataPos = 0;
     ALOGV("restartWrite Setting data size of %p to %zu", this, mDataSize);
     ALOGV("restartWrite Setting data pos of %p to %zu", this, mDataPos);
 
-    free(mObjects);
-    mObjects = NULL;
-    mObjectsSize = mObjectsCapacity = 0;
-    mNextObjectHint = 0;
-    mHasFds = false;
+    if (reallocData(desired) != NO_ERROR && desired > mDataCapacity) {
+        mError = NO_MEMORY;
+        return NO_MEMORY;
+    }
+
+    mFdCount = 0;
     mFdsKnown = true;
+    mObjectsSorted = true;
     mAllowFds = true;
 
     return NO_ERROR;
@@ -1617,17 +1831,19 @@ status_t Parcel::continueWrite(size_t desired)
 
         // If there is a different owner, we need to take
         // posession.
-        uint8_t* data = (uint8_t*)malloc(desired);
+        size_t dataCapacity = 0;
+        uint8_t* data = allocData(desired, &dataCapacity);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
         }
         binder_size_t* objects = NULL;
+        size_t objectsCapacity = 0;
 
         if (objectsSize) {
-            objects = (binder_size_t*)malloc(objectsSize*sizeof(binder_size_t));
+            objects = allocObjects(objectsSize, &objectsCapacity);
             if (!objects) {
-                free(data);
+                freeDataStorage(data);
 
                 mError = NO_MEMORY;
                 return NO_MEMORY;
@@ -1651,12 +1867,18 @@ status_t Parcel::continueWrite(size_t desired)
         mOwner(this, mData, mDataSize, mObjects, mObjectsSize, mOwnerCookie);
         mOwner = NULL;
 
+        if (objectsSize < mObjectsSize) {
+            // may have lopped off some of the FDs
+            mFdsKnown = false;
+        }
+
         mData = data;
         mObjects = objects;
         mDataSize = (mDataSize < desired) ? mDataSize : desired;
         ALOGV("continueWrite Setting data size of %p to %zu", this, mDataSize);
-        mDataCapacity = desired;
-        mObjectsSize = mObjectsCapacity = objectsSize;
+        mDataCapacity = dataCapacity;
+        mObjectsSize = objectsSize;
+        mObjectsCapacity = objectsCapacity;
         mNextObjectHint = 0;
 
     } else if (mData) {
@@ -1666,28 +1888,19 @@ status_t Parcel::continueWrite(size_t desired)
             for (size_t i=objectsSize; i<mObjectsSize; i++) {
                 const flat_binder_object* flat
                     = reinterpret_cast<flat_binder_object*>(mData+mObjects[i]);
-                if (flat->type == BINDER_TYPE_FD) {
-                    // will need to rescan because we may have lopped off the only FDs
-                    mFdsKnown = false;
+                if (flat->type == BINDER_TYPE_FD && mFdsKnown) {
+                    mFdCount--;
                 }
                 release_object(proc, *flat, this);
             }
-            binder_size_t* objects =
-                (binder_size_t*)realloc(mObjects, objectsSize*sizeof(binder_size_t));
-            if (objects) {
-                mObjects = objects;
-            }
             mObjectsSize = objectsSize;
+            reallocObjects(objectsSize);
             mNextObjectHint = 0;
         }
 
         // We own the data, so we can just do a realloc().
         if (desired > mDataCapacity) {
-            uint8_t* data = (uint8_t*)realloc(mData, desired);
-            if (data) {
-                mData = data;
-                mDataCapacity = desired;
-            } else if (desired > mDataCapacity) {
+            if (reallocData(desired) != NO_ERROR) {
                 mError = NO_MEMORY;
                 return NO_MEMORY;
             }
@@ -1704,7 +1917,8 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        size_t dataCapacity = 0;
+        uint8_t* data = allocData(desired, &dataCapacity);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -1719,12 +1933,123 @@ status_t Parcel::continueWrite(size_t desired)
         mDataSize = mDataPos = 0;
         ALOGV("continueWrite Setting data size of %p to %zu", this, mDataSize);
         ALOGV("continueWrite Setting data pos of %p to %zu", this, mDataPos);
-        mDataCapacity = desired;
+        mDataCapacity = dataCapacity;
+    }
+
+    return NO_ERROR;
+}
+
+uint8_t* Parcel::allocData(size_t desired, size_t* outCapacity)
+{
+    if (desired <= INLINE_DATA_SIZE) {
+        *outCapacity = INLINE_DATA_SIZE;
+        return mInlineData;
+    }
+    uint8_t* data = (uint8_t*)malloc(desired);
+    if (data) {
+        *outCapacity = desired;
+    }
+    return data;
+}
+
+status_t Parcel::reallocData(size_t desired)
+{
+    // Only valid while we own mData; the current contents up to
+    // mDataSize are carried over to the new storage.
+    const size_t keep = (mDataSize < desired) ? mDataSize : desired;
+    if (desired <= INLINE_DATA_SIZE) {
+        if (mData != mInlineData) {
+            if (mData) {
+                memcpy(mInlineData, mData, keep);
+                free(mData);
+            }
+            mData = mInlineData;
+        }
+        mDataCapacity = INLINE_DATA_SIZE;
+        return NO_ERROR;
+    }
+
+    if (mData && mData != mInlineData && desired == mDataCapacity) {
+        return NO_ERROR;
     }
 
+    uint8_t* data;
+    if (mData == mInlineData) {
+        data = (uint8_t*)malloc(desired);
+        if (data) {
+            memcpy(data, mInlineData, keep);
+        }
+    } else {
+        data = (uint8_t*)realloc(mData, desired);
+    }
+    if (!data) {
+        return NO_MEMORY;
+    }
+    mData = data;
+    mDataCapacity = desired;
     return NO_ERROR;
 }
 
+void Parcel::freeDataStorage(uint8_t* data)
+{
+    if (data && data != mInlineData) {
+        free(data);
+    }
+}
+
+binder_size_t* Parcel::allocObjects(size_t count, size_t* outCapacity)
+{
+    if (count <= INLINE_OBJECTS_COUNT) {
+        *outCapacity = INLINE_OBJECTS_COUNT;
+        return mInlineObjects;
+    }
+    binder_size_t* objects = (binder_size_t*)malloc(count*sizeof(binder_size_t));
+    if (objects) {
+        *outCapacity = count;
+    }
+    return objects;
+}
+
+status_t Parcel::reallocObjects(size_t count)
+{
+    // Only valid while we own mObjects; the first mObjectsSize
+    // offsets are carried over to the new storage.
+    if (count <= INLINE_OBJECTS_COUNT) {
+        if (mObjects != mInlineObjects) {
+            if (mObjects) {
+                memcpy(mInlineObjects, mObjects, mObjectsSize*sizeof(binder_size_t));
+                free(mObjects);
+            }
+            mObjects = mInlineObjects;
+        }
+        mObjectsCapacity = INLINE_OBJECTS_COUNT;
+        return NO_ERROR;
+    }
+
+    binder_size_t* objects;
+    if (mObjects == mInlineObjects) {
+        objects = (binder_size_t*)malloc(count*sizeof(binder_size_t));
+        if (objects) {
+            memcpy(objects, mInlineObjects, mObjectsSize*sizeof(binder_size_t));
+        }
+    } else {
+        objects = (binder_size_t*)realloc(mObjects, count*sizeof(binder_size_t));
+    }
+    if (!objects) {
+        return NO_MEMORY;
+    }
+    mObjects = objects;
+    mObjectsCapacity = count;
+    return NO_ERROR;
+}
+
+void Parcel::freeObjectsStorage(binder_size_t* objects)
+{
+    if (objects && objects != mInlineObjects) {
+        free(objects);
+    }
+}
+
 void Parcel::initState()
 {
     mError = NO_ERROR;
@@ -1738,27 +2063,43 @@ void Parcel::initState()
     mObjectsSize = 0;
     mObjectsCapacity = 0;
     mNextObjectHint = 0;
-    mHasFds = false;
+    mFdCount = 0;
     mFdsKnown = true;
+    mObjectsSorted = true;
     mAllowFds = true;
     mOwner = NULL;
 }
 
 void Parcel::scanForFds() const
 {
-    bool hasFds = false;
+    size_t fdCount = 0;
     for (size_t i=0; i<mObjectsSize; i++) {
         const flat_binder_object* flat
             = reinterpret_cast<const flat_binder_object*>(mData + mObjects[i]);
         if (flat->type == BINDER_TYPE_FD) {
-            hasFds = true;
-            break;
+            fdCount++;
         }
     }
-    mHasFds = hasFds;
+    mFdCount = fdCount;
     mFdsKnown = true;
 }
 
+// Index of the first object at or after offset; mObjects must be sorted.
+size_t Parcel::lowerBoundObject(size_t offset) const
+{
+    size_t lo = 0;
+    size_t hi = mObjectsSize;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (mObjects[mid] < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
 // --- Parcel::Blob ---
 
 Parcel::Blob::Blob() :
@@ -1770,22 +2111,25 @@ Parcel::Blob::~Blob() {
 }
 
 void Parcel::Blob::release() {
-    if (mMapped && mData) {
+    if (mMapped && mData && mRegion == NULL) {
         ::munmap(mData, mSize);
     }
     clear();
 }
 
-void Parcel::Blob::init(bool mapped, void* data, size_t size) {
+void Parcel::Blob::init(bool mapped, void* data, size_t size,
+        const sp<RefBase>& region) {
     mMapped = mapped;
     mData = data;
     mSize = size;
+    mRegion = region;
 }
 
 void Parcel::Blob::clear() {
     mMapped = false;
     mData = NULL;
     mSize = 0;
+    mRegion.clear();
 }
 
 }; // namespace android
@@ -31,29 +31,39 @@ ANDROID_SINGLETON_STATIC_INSTANCE(PermissionCache) ;
 
 // ----------------------------------------------------------------------------
 
-PermissionCache::PermissionCache() {
+const nsecs_t PermissionCache::kDeniedTimeout = s2ns(10);
+
+PermissionCache::PermissionCache() : mGeneration(0) {
 }
 
 status_t PermissionCache::check(bool* granted,
-        const String16& permission, uid_t uid) const {
-    Mutex::Autolock _l(mLock);
+        const String16& permission, uid_t uid, uint32_t* generation) const {
+    RWLock::AutoRLock _l(mLock);
+    *generation = mGeneration;
     Entry e;
     e.name = permission;
     e.uid  = uid;
     ssize_t index = mCache.indexOf(e);
     if (index >= 0) {
-        *granted = mCache.itemAt(index).granted;
-        return NO_ERROR;
+        const Entry& entry(mCache.itemAt(index));
+        if (entry.granted || systemTime() < entry.expires) {
+            *granted = entry.granted;
+            return NO_ERROR;
+        }
     }
     return NAME_NOT_FOUND;
 }
 
 void PermissionCache::cache(const String16& permission,
-        uid_t uid, bool granted) {
-    Mutex::Autolock _l(mLock);
+        uid_t uid, bool granted, uint32_t generation) {
+    RWLock::AutoWLock _l(mLock);
+    if (generation != mGeneration) {
+        // purged while checking, the result may be stale already
+        return;
+    }
     Entry e;
     ssize_t index = mPermissionNamesPool.indexOf(permission);
-    if (index > 0) {
+    if (index >= 0) {
         e.name = mPermissionNamesPool.itemAt(index);
     } else {
         mPermissionNamesPool.add(permission);
@@ -63,15 +73,27 @@ void PermissionCache::cache(const String16& permission,
     // permission checks
     e.uid  = uid;
     e.granted = granted;
-    index = mCache.indexOf(e);
-    if (index < 0) {
-        mCache.add(e);
-    }
+    e.expires = granted ? 0 : systemTime() + kDeniedTimeout;
+    // replaces an expired denial
+    mCache.add(e);
 }
 
 void PermissionCache::purge() {
-    Mutex::Autolock _l(mLock);
-    mCache.clear();
+    PermissionCache& pc(PermissionCache::getInstance());
+    RWLock::AutoWLock _l(pc.mLock);
+    pc.mGeneration++;
+    pc.mCache.clear();
+}
+
+void PermissionCache::purgeUid(uid_t uid) {
+    PermissionCache& pc(PermissionCache::getInstance());
+    RWLock::AutoWLock _l(pc.mLock);
+    pc.mGeneration++;
+    for (size_t i = pc.mCache.size(); i > 0; i--) {
+        if (pc.mCache.itemAt(i - 1).uid == uid) {
+            pc.mCache.removeAt(i - 1);
+        }
+    }
 }
 
 bool PermissionCache::checkCallingPermission(const String16& permission) {
@@ -97,14 +119,15 @@ bool PermissionCache::checkPermission(
 
     PermissionCache& pc(PermissionCache::getInstance());
     bool granted = false;
-    if (pc.check(&granted, permission, uid) != NO_ERROR) {
+    uint32_t generation;
+    if (pc.check(&granted, permission, uid, &generation) != NO_ERROR) {
         nsecs_t t = -systemTime();
         granted = android::checkPermission(permission, pid, uid);
         t += systemTime();
         ALOGD("checking %s for uid=%d => %s (%d us)",
                 String8(permission).string(), uid,
                 granted?"granted":"denied", (int)ns2us(t));
-        pc.cache(permission, uid, granted);
+        pc.cache(permission, uid, granted, generation);
     }
     return granted;
 }
@@ -17,6 +17,7 @@
 #define LOG_TAG "ProcessState"
 
 #include <cutils/process_name.h>
+#include <cutils/properties.h>
 
 #include <binder/ProcessState.h>
 
@@ -31,6 +32,7 @@
 
 #include <private/binder/binder_module.h>
 #include <private/binder/Static.h>
+#include <private/binder/TransactionStats.h>
 
 #include <errno.h>
 #include <fcntl.h>
@@ -42,6 +44,7 @@
 #include <sys/stat.h>
 
 #define BINDER_VM_SIZE ((1*1024*1024) - (4096 *2))
+#define DEFAULT_MAX_BINDER_THREADS 15
 
 
 // ---------------------------------------------------------------------------
@@ -162,26 +165,34 @@ bool ProcessState::becomeContextManager(context_check_func checkFunc, void* user
     return mManagesContexts;
 }
 
-ProcessState::handle_entry* ProcessState::lookupHandleLocked(int32_t handle)
+ProcessState::handle_stripe& ProcessState::stripeForHandle(int32_t handle)
 {
-    const size_t N=mHandleToObject.size();
-    if (N <= (size_t)handle) {
+    return mHandleToObject[uint32_t(handle) % HANDLE_STRIPE_COUNT];
+}
+
+ProcessState::handle_entry* ProcessState::lookupHandleLocked(
+        handle_stripe& stripe, int32_t handle)
+{
+    const size_t index = uint32_t(handle) / HANDLE_STRIPE_COUNT;
+    const size_t N=stripe.entries.size();
+    if (N <= index) {
         handle_entry e;
         e.binder = NULL;
         e.refs = NULL;
-        status_t err = mHandleToObject.insertAt(e, N, handle+1-N);
+        status_t err = stripe.entries.insertAt(e, N, index+1-N);
         if (err < NO_ERROR) return NULL;
     }
-    return &mHandleToObject.editItemAt(handle);
+    return &stripe.entries.editItemAt(index);
 }
 
 sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
 {
     sp<IBinder> result;
 
-    AutoMutex _l(mLock);
+    handle_stripe& stripe(stripeForHandle(handle));
+    AutoMutex _l(stripe.lock);
 
-    handle_entry* e = lookupHandleLocked(handle);
+    handle_entry* e = lookupHandleLocked(stripe, handle);
 
     if (e != NULL) {
         // We need to create a new BpBinder if there isn't currently one, OR we
@@ -236,15 +247,16 @@ wp<IBinder> ProcessState::getWeakProxyForHandle(int32_t handle)
 {
     wp<IBinder> result;
 
-    AutoMutex _l(mLock);
+    handle_stripe& stripe(stripeForHandle(handle));
+    AutoMutex _l(stripe.lock);
 
-    handle_entry* e = lookupHandleLocked(handle);
+    handle_entry* e = lookupHandleLocked(stripe, handle);
 
     if (e != NULL) {        
         // We need to create a new BpBinder if there isn't currently one, OR we
         // are unable to acquire a weak reference on this current one.  The
         // attemptIncWeak() is safe because we know the BpBinder destructor will always
-        // call expungeHandle(), which acquires the same lock we are holding now.
+        // call expungeHandle(), which acquires the same stripe lock we are holding now.
         // We need to do this because there is a race condition between someone
         // releasing a reference on this BpBinder, and a new reference on its handle
         // arriving from the driver.
@@ -265,9 +277,10 @@ wp<IBinder> ProcessState::getWeakProxyForHandle(int32_t handle)
 
 void ProcessState::expungeHandle(int32_t handle, IBinder* binder)
 {
-    AutoMutex _l(mLock);
+    handle_stripe& stripe(stripeForHandle(handle));
+    AutoMutex _l(stripe.lock);
     
-    handle_entry* e = lookupHandleLocked(handle);
+    handle_entry* e = lookupHandleLocked(stripe, handle);
 
     // This handle may have already been replaced with a new BpBinder
     // (if someone failed the AttemptIncWeak() above); we don't want
@@ -293,18 +306,235 @@ void ProcessState::spawnPooledThread(bool isMain)
 }
 
 status_t ProcessState::setThreadPoolMaxThreadCount(size_t maxThreads) {
+    AutoMutex _l(mThreadPoolLock);
+    // The driver never forgets about threads it asked us to spawn, even
+    // once they have exited, so retired threads have to be added back in
+    // for it to be willing to spawn replacements.
+    size_t driverMax = maxThreads + mRetiredThreads;
     status_t result = NO_ERROR;
-    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &maxThreads) == -1) {
+    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &driverMax) == -1) {
         result = -errno;
         ALOGE("Binder ioctl to set max threads failed: %s", strerror(-result));
+    } else {
+        mMaxThreads = maxThreads;
     }
     return result;
 }
 
+void ProcessState::setThreadPoolIdleTimeout(nsecs_t idleTimeout) {
+    AutoMutex _l(mThreadPoolLock);
+    mIdleThreadTimeout = idleTimeout;
+}
+
+nsecs_t ProcessState::getThreadPoolIdleTimeout() const {
+    AutoMutex _l(mThreadPoolLock);
+    return mIdleThreadTimeout;
+}
+
+void ProcessState::threadPoolThreadJoined() {
+    android_atomic_inc(&mPooledThreads);
+}
+
+bool ProcessState::threadPoolThreadMayRetire() {
+    AutoMutex _l(mThreadPoolLock);
+    // Each retirement permanently raises the driver's limit by one, so only
+    // allow as many as there are threads in the configured pool; after that
+    // idle threads simply stay.
+    if (mRetiredThreads >= mMaxThreads) {
+        return false;
+    }
+    // Always leave one idle thread besides the one asking to go. On success
+    // the caller is no longer counted as part of the pool.
+    while (true) {
+        const int32_t pooled = android_atomic_acquire_load(&mPooledThreads);
+        if (pooled - android_atomic_acquire_load(&mBusyThreads) <= 1) {
+            return false;
+        }
+        if (android_atomic_cmpxchg(pooled, pooled - 1, &mPooledThreads) == 0) {
+            mRetiredThreads++;
+            return true;
+        }
+    }
+}
+
+void ProcessState::threadPoolThreadLeft(bool retired) {
+    if (!retired) {
+        android_atomic_dec(&mPooledThreads);
+    } else {
+        AutoMutex _l(mThreadPoolLock);
+        size_t driverMax = mMaxThreads + mRetiredThreads;
+        if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &driverMax) == -1) {
+            ALOGE("Binder ioctl to set max threads failed: %s", strerror(errno));
+        }
+    }
+}
+
+void ProcessState::threadPoolThreadBusy() {
+    const int32_t busy = android_atomic_inc(&mBusyThreads) + 1;
+    if (busy >= android_atomic_acquire_load(&mPooledThreads)) {
+        AutoMutex _l(mThreadPoolLock);
+        if (mSaturationStart == 0) {
+            mSaturationStart = systemTime(SYSTEM_TIME_MONOTONIC);
+        }
+    }
+}
+
+void ProcessState::threadPoolThreadIdle() {
+    android_atomic_dec(&mBusyThreads);
+    AutoMutex _l(mThreadPoolLock);
+    if (mSaturationStart != 0) {
+        saturation_event& e(mSaturations[mSaturationCount % SATURATION_HISTORY]);
+        e.start = mSaturationStart;
+        e.duration = systemTime(SYSTEM_TIME_MONOTONIC) - mSaturationStart;
+        e.threads = mPooledThreads;
+        mSaturationCount++;
+        mSaturationStart = 0;
+        ALOGW_IF(e.duration > ms2ns(100),
+                "Binder thread pool saturated for %.1fms (%d threads)",
+                e.duration / 1000000.0, e.threads);
+    }
+}
+
+void ProcessState::dumpThreadPoolStats(String8& result) const {
+    AutoMutex _l(mThreadPoolLock);
+    result.appendFormat("Binder thread pool: %d threads (%d busy), max %zu, "
+            "%zu retired, idle timeout %.1fs\n",
+            mPooledThreads, mBusyThreads, mMaxThreads, mRetiredThreads,
+            mIdleThreadTimeout / 1000000000.0);
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (mSaturationStart != 0) {
+        result.appendFormat("  saturated right now, for %.1fms\n",
+                (now - mSaturationStart) / 1000000.0);
+    }
+    result.appendFormat("  %zu saturation episodes", mSaturationCount);
+    const size_t N = mSaturationCount < SATURATION_HISTORY ?
+            mSaturationCount : SATURATION_HISTORY;
+    result.append(N ? ", most recent first:\n" : "\n");
+    for (size_t i = 0; i < N; i++) {
+        const saturation_event& e(
+                mSaturations[(mSaturationCount - 1 - i) % SATURATION_HISTORY]);
+        result.appendFormat("    %.3fs ago: %.3fms with %d threads\n",
+                (now - e.start) / 1000000000.0, e.duration / 1000000.0,
+                e.threads);
+    }
+}
+
 void ProcessState::giveThreadPoolName() {
     androidSetThreadName( makeBinderThreadName().string() );
 }
 
+void ProcessState::setTransactionStatsEnabled(bool enabled)
+{
+    android_atomic_release_store(enabled ? 1 : 0, &mTransactionStatsEnabled);
+}
+
+bool ProcessState::isTransactionStatsEnabled() const
+{
+    return mTransactionStatsEnabled != 0;
+}
+
+TransactionStats* ProcessState::acquireTransactionStats()
+{
+    AutoMutex _l(mStatsLock);
+    const size_t N = mTransactionStats.size();
+    for (size_t i = 0; i < N; i++) {
+        stats_entry& e = mTransactionStats.editItemAt(i);
+        if (!e.inUse) {
+            e.inUse = true;
+            return e.stats;
+        }
+    }
+    stats_entry e;
+    e.stats = new TransactionStats();
+    e.inUse = true;
+    mTransactionStats.add(e);
+    return e.stats;
+}
+
+void ProcessState::releaseTransactionStats(TransactionStats* stats)
+{
+    AutoMutex _l(mStatsLock);
+    const size_t N = mTransactionStats.size();
+    for (size_t i = 0; i < N; i++) {
+        stats_entry& e = mTransactionStats.editItemAt(i);
+        if (e.stats == stats) {
+            e.inUse = false;
+            return;
+        }
+    }
+}
+
+// Sum of the entries with the same key across all threads.
+struct merged_stats_entry {
+    const TransactionStats::Entry* key;
+    uint32_t count;
+    uint32_t buckets[TransactionStats::BUCKET_COUNT];
+    nsecs_t totalTime;
+    nsecs_t maxTime;
+};
+
+void ProcessState::dumpTransactionStats(String8& result) const
+{
+    Vector<merged_stats_entry> merged;
+    uint32_t dropped = 0;
+
+    AutoMutex _l(mStatsLock);
+    for (size_t t = 0; t < mTransactionStats.size(); t++) {
+        const TransactionStats* stats = mTransactionStats[t].stats;
+        dropped += stats->dropped();
+        const size_t N = stats->size();
+        for (size_t i = 0; i < N; i++) {
+            const TransactionStats::Entry& e(stats->entryAt(i));
+            size_t j = 0;
+            for (; j < merged.size(); j++) {
+                const TransactionStats::Entry* k = merged[j].key;
+                if (k->hash == e.hash && k->code == e.code
+                        && k->direction == e.direction
+                        && k->descriptor == e.descriptor) {
+                    break;
+                }
+            }
+            if (j == merged.size()) {
+                merged_stats_entry m;
+                memset(&m, 0, sizeof(m));
+                m.key = &e;
+                merged.add(m);
+            }
+            merged_stats_entry& m = merged.editItemAt(j);
+            m.count += e.count;
+            for (size_t b = 0; b < TransactionStats::BUCKET_COUNT; b++) {
+                m.buckets[b] += e.buckets[b];
+            }
+            m.totalTime += e.totalTime;
+            if (e.maxTime > m.maxTime) {
+                m.maxTime = e.maxTime;
+            }
+        }
+    }
+
+    result.appendFormat("Binder transaction stats (%s, %zu threads, %u dropped):\n",
+            isTransactionStatsEnabled() ? "enabled" : "disabled",
+            mTransactionStats.size(), dropped);
+    for (size_t j = 0; j < merged.size(); j++) {
+        const merged_stats_entry& m(merged[j]);
+        if (m.count == 0) continue;
+        result.appendFormat("  %s %s code=%u: count=%u avg=%.3fms max=%.3fms\n",
+                m.key->direction == TransactionStats::INCOMING ? "in " : "out",
+                m.key->descriptor.size() ?
+                        String8(m.key->descriptor).string() : "<no token>",
+                m.key->code, m.count,
+                (m.totalTime / double(m.count)) / 1000000.0,
+                m.maxTime / 1000000.0);
+        result.append("   ");
+        for (size_t b = 0; b < TransactionStats::BUCKET_COUNT; b++) {
+            if (m.buckets[b] == 0) continue;
+            result.appendFormat(" <%lluus:%u",
+                    (unsigned long long)(1ULL << b), m.buckets[b]);
+        }
+        result.append("\n");
+    }
+}
+
 static int open_driver()
 {
     int fd = open("/dev/binder", O_RDWR);
@@ -322,7 +552,7 @@ static int open_driver()
             close(fd);
             fd = -1;
         }
-        size_t maxThreads = 15;
+        size_t maxThreads = DEFAULT_MAX_BINDER_THREADS;
         result = ioctl(fd, BINDER_SET_MAX_THREADS, &maxThreads);
         if (result == -1) {
             ALOGE("Binder ioctl to set max threads failed: %s", strerror(errno));
@@ -341,7 +571,19 @@ ProcessState::ProcessState()
     , mBinderContextUserData(NULL)
     , mThreadPoolStarted(false)
     , mThreadPoolSeq(1)
+    , mMaxThreads(DEFAULT_MAX_BINDER_THREADS)
+    , mRetiredThreads(0)
+    , mIdleThreadTimeout(0)
+    , mPooledThreads(0)
+    , mBusyThreads(0)
+    , mSaturationCount(0)
+    , mSaturationStart(0)
+    , mTransactionStatsEnabled(0)
 {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.binder.stats", value, "0");
+    mTransactionStatsEnabled = atoi(value) ? 1 : 0;
+
     if (mDriverFD >= 0) {
         // XXX Ideally, there should be a specific define for whether we
         // have mmap (or whether we could possibly have the kernel module
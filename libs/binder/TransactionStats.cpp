@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionStats"
+
+#include <private/binder/TransactionStats.h>
+
+#include <binder/Parcel.h>
+
+#include <cutils/atomic.h>
+
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+namespace android {
+
+// Peeks at the interface token written by Parcel::writeInterfaceToken(),
+// i.e. an int32 strict mode header followed by a String16, without
+// consuming or copying it.
+static const char16_t* peekInterfaceToken(const Parcel& data, size_t* outLen)
+{
+    const size_t size = data.dataSize();
+    const uint8_t* p = data.data();
+    if (p == NULL || size < 2*sizeof(int32_t)) {
+        return NULL;
+    }
+    const int32_t len = *reinterpret_cast<const int32_t*>(p + sizeof(int32_t));
+    const size_t avail = (size - 2*sizeof(int32_t)) / sizeof(char16_t);
+    if (len < 0 || size_t(len) >= avail) {
+        return NULL;
+    }
+    const char16_t* str =
+            reinterpret_cast<const char16_t*>(p + 2*sizeof(int32_t));
+    if (str[len] != 0) {
+        return NULL;
+    }
+    *outLen = len;
+    return str;
+}
+
+static uint32_t hashDescriptor(const char16_t* str, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ str[i]) * 16777619u;
+    }
+    return hash;
+}
+
+TransactionStats::TransactionStats()
+    : mCount(0), mDropped(0)
+{
+}
+
+size_t TransactionStats::size() const
+{
+    return android_atomic_acquire_load(&mCount);
+}
+
+size_t TransactionStats::bucketFor(nsecs_t duration)
+{
+    const nsecs_t us = duration / 1000;
+    if (us <= 0) {
+        return 0;
+    }
+    const size_t bucket = 64 - __builtin_clzll(uint64_t(us));
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+TransactionStats::Entry* TransactionStats::findOrCreate(uint32_t direction,
+        const char16_t* descriptor, size_t len, uint32_t code)
+{
+    const uint32_t hash = hashDescriptor(descriptor, len);
+    const size_t count = mCount;
+    for (size_t i = 0; i < count; i++) {
+        Entry& e = mEntries[i];
+        if (e.hash == hash && e.code == code && e.direction == direction
+                && e.descriptor.size() == len
+                && !memcmp(e.descriptor.string(), descriptor,
+                        len*sizeof(char16_t))) {
+            return &e;
+        }
+    }
+
+    if (count >= MAX_ENTRIES) {
+        return NULL;
+    }
+
+    Entry& e = mEntries[count];
+    e.hash = hash;
+    e.direction = direction;
+    e.code = code;
+    e.descriptor.setTo(descriptor, len);
+    e.count = 0;
+    memset(e.buckets, 0, sizeof(e.buckets));
+    e.totalTime = 0;
+    e.maxTime = 0;
+    android_atomic_release_store(count + 1, &mCount);
+    return &e;
+}
+
+void TransactionStats::record(direction_t direction, const Parcel& data,
+        uint32_t code, nsecs_t duration)
+{
+    static const char16_t kNoDescriptor[] = { 0 };
+    size_t len = 0;
+    const char16_t* descriptor = peekInterfaceToken(data, &len);
+    if (descriptor == NULL) {
+        descriptor = kNoDescriptor;
+        len = 0;
+    }
+
+    Entry* e = findOrCreate(direction, descriptor, len, code);
+    if (e == NULL) {
+        mDropped++;
+        return;
+    }
+    e->count++;
+    e->buckets[bucketFor(duration)]++;
+    e->totalTime += duration;
+    if (duration > e->maxTime) {
+        e->maxTime = duration;
+    }
+}
+
+}; // namespace android
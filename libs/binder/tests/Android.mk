@@ -0,0 +1,40 @@
+# Build the binder micro benchmarks and unit tests.
+LOCAL_PATH:= $(call my-dir)
+
+benchmark_src_files := \
+    binderHandleBenchmark.cpp \
+    binderTransactionBenchmark.cpp \
+    memoryDealerBenchmark.cpp
+
+shared_libraries := \
+    libbinder \
+    libcutils \
+    libutils
+
+$(foreach file,$(benchmark_src_files), \
+    $(eval include $(CLEAR_VARS)) \
+    $(eval LOCAL_SHARED_LIBRARIES := $(shared_libraries)) \
+    $(eval LOCAL_SRC_FILES := $(file)) \
+    $(eval LOCAL_MODULE := $(notdir $(file:%.cpp=%))) \
+    $(eval LOCAL_MODULE_TAGS := tests) \
+    $(eval include $(BUILD_EXECUTABLE)) \
+)
+
+# Build the unit tests.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libbinder_test
+LOCAL_MODULE_TAGS := tests
+LOCAL_SRC_FILES := \
+    AppOpsCache_test.cpp \
+    CallerScheduling_test.cpp \
+    IMemory_test.cpp
+
+LOCAL_SHARED_LIBRARIES := $(shared_libraries)
+
+LOCAL_C_INCLUDES := \
+    bionic \
+    bionic/libstdc++/include \
+    external/gtest/include \
+    external/stlport/stlport \
+
+include $(BUILD_NATIVE_TEST)
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AppOpsCache_test"
+
+#include <gtest/gtest.h>
+
+#include <binder/AppOpsManager.h>
+#include <private/binder/AppOpsCache.h>
+#include <utils/String8.h>
+
+namespace android {
+
+static const int32_t APP_UID = 10001;
+static const String16 PACKAGE("com.example.app");
+
+// An in-process service which records the watches started on it.
+class FakeAppOpsService : public BnAppOpsService {
+public:
+    int32_t startWatchingCount;
+    int32_t stopWatchingCount;
+    int32_t lastWatchedOp;
+
+    FakeAppOpsService() :
+            startWatchingCount(0), stopWatchingCount(0), lastWatchedOp(-1) {
+    }
+
+    virtual int32_t checkOperation(int32_t, int32_t, const String16&) {
+        return AppOpsManager::MODE_ALLOWED;
+    }
+    virtual int32_t noteOperation(int32_t, int32_t, const String16&) {
+        return AppOpsManager::MODE_ALLOWED;
+    }
+    virtual int32_t startOperation(const sp<IBinder>&, int32_t, int32_t,
+            const String16&) {
+        return AppOpsManager::MODE_ALLOWED;
+    }
+    virtual void finishOperation(const sp<IBinder>&, int32_t, int32_t,
+            const String16&) {
+    }
+    virtual void startWatchingMode(int32_t op, const String16&,
+            const sp<IAppOpsCallback>&) {
+        startWatchingCount++;
+        lastWatchedOp = op;
+    }
+    virtual void stopWatchingMode(const sp<IAppOpsCallback>&) {
+        stopWatchingCount++;
+    }
+    virtual sp<IBinder> getToken(const sp<IBinder>& clientToken) {
+        return clientToken;
+    }
+};
+
+class AppOpsCacheTest : public testing::Test {
+protected:
+    sp<FakeAppOpsService> mService;
+    sp<AppOpsCache> mCache;
+
+    virtual void SetUp() {
+        mService = new FakeAppOpsService();
+        mCache = new AppOpsCache();
+    }
+
+    static AppOpsCache::Key makeKey(int32_t op, const String16& package = PACKAGE) {
+        AppOpsCache::Key key;
+        key.op = op;
+        key.uid = APP_UID;
+        key.package = package;
+        return key;
+    }
+
+    // Looks up a key, and caches mode for it on a miss, like checkOp().
+    // Returns whether it was a hit.
+    bool check(const AppOpsCache::Key& key, int32_t mode) {
+        int32_t cached;
+        uint32_t generation;
+        if (mCache->get(mService, key, &cached, &generation) == NO_ERROR) {
+            return true;
+        }
+        mCache->put(mService, key, mode, generation);
+        return false;
+    }
+};
+
+TEST_F(AppOpsCacheTest, WatchesBeforeCaching) {
+    const AppOpsCache::Key key(makeKey(AppOpsManager::OP_CAMERA));
+    EXPECT_FALSE(check(key, AppOpsManager::MODE_ALLOWED));
+    EXPECT_EQ(1, mService->startWatchingCount);
+
+    // The first mode may predate the watch, it isn't cached.
+    EXPECT_FALSE(check(key, AppOpsManager::MODE_ALLOWED));
+    EXPECT_EQ(1, mService->startWatchingCount);
+    EXPECT_TRUE(check(key, AppOpsManager::MODE_ALLOWED));
+}
+
+TEST_F(AppOpsCacheTest, WatchesTheSwitchOp) {
+    const AppOpsCache::Key fine(makeKey(AppOpsManager::OP_FINE_LOCATION));
+    const AppOpsCache::Key gps(makeKey(AppOpsManager::OP_GPS));
+    check(fine, AppOpsManager::MODE_ALLOWED);
+    EXPECT_EQ(AppOpsManager::OP_COARSE_LOCATION, mService->lastWatchedOp);
+
+    // Ops with the same switch share its watch.
+    check(gps, AppOpsManager::MODE_ALLOWED);
+    EXPECT_EQ(1, mService->startWatchingCount);
+}
+
+TEST_F(AppOpsCacheTest, SwitchOpChangeDropsTheOpsItSwitches) {
+    const AppOpsCache::Key fine(makeKey(AppOpsManager::OP_FINE_LOCATION));
+    const AppOpsCache::Key camera(makeKey(AppOpsManager::OP_CAMERA));
+    check(fine, AppOpsManager::MODE_ALLOWED);
+    check(fine, AppOpsManager::MODE_ALLOWED);
+    check(camera, AppOpsManager::MODE_ALLOWED);
+    check(camera, AppOpsManager::MODE_ALLOWED);
+    ASSERT_TRUE(check(fine, AppOpsManager::MODE_ALLOWED));
+    ASSERT_TRUE(check(camera, AppOpsManager::MODE_ALLOWED));
+
+    // The service reports the change with the switch op.
+    mCache->opChanged(AppOpsManager::OP_COARSE_LOCATION, PACKAGE);
+    EXPECT_FALSE(check(fine, AppOpsManager::MODE_IGNORED));
+    EXPECT_TRUE(check(camera, AppOpsManager::MODE_ALLOWED));
+}
+
+TEST_F(AppOpsCacheTest, ChangeDuringCheckIsNotCached) {
+    const AppOpsCache::Key key(makeKey(AppOpsManager::OP_CAMERA));
+    check(key, AppOpsManager::MODE_ALLOWED);
+
+    int32_t mode;
+    uint32_t generation;
+    ASSERT_EQ(NAME_NOT_FOUND, mCache->get(mService, key, &mode, &generation));
+    mCache->opChanged(AppOpsManager::OP_CAMERA, PACKAGE);
+    mCache->put(mService, key, AppOpsManager::MODE_ALLOWED, generation);
+    EXPECT_FALSE(check(key, AppOpsManager::MODE_IGNORED));
+}
+
+TEST_F(AppOpsCacheTest, WatchesAreBounded) {
+    for (int i = 0; i < AppOpsCache::MAX_WATCHED; i++) {
+        check(makeKey(AppOpsManager::OP_CAMERA,
+                String16(String8::format("com.example.app%d", i))),
+                AppOpsManager::MODE_ALLOWED);
+    }
+    EXPECT_EQ(AppOpsCache::MAX_WATCHED, mService->startWatchingCount);
+    EXPECT_EQ(0, mService->stopWatchingCount);
+
+    // One more stops them all and starts over.
+    check(makeKey(AppOpsManager::OP_CAMERA), AppOpsManager::MODE_ALLOWED);
+    EXPECT_EQ(1, mService->stopWatchingCount);
+    EXPECT_EQ(AppOpsCache::MAX_WATCHED + 1, mService->startWatchingCount);
+    check(makeKey(AppOpsManager::OP_CAMERA), AppOpsManager::MODE_ALLOWED);
+    EXPECT_TRUE(check(makeKey(AppOpsManager::OP_CAMERA), AppOpsManager::MODE_ALLOWED));
+}
+
+TEST_F(AppOpsCacheTest, OpToSwitch) {
+    EXPECT_EQ(AppOpsManager::OP_COARSE_LOCATION,
+            AppOpsManager::opToSwitch(AppOpsManager::OP_WIFI_SCAN));
+    EXPECT_EQ(AppOpsManager::OP_READ_SMS,
+            AppOpsManager::opToSwitch(AppOpsManager::OP_RECEIVE_MMS));
+    EXPECT_EQ(AppOpsManager::OP_CAMERA,
+            AppOpsManager::opToSwitch(AppOpsManager::OP_CAMERA));
+    // ops added to the service later switch themselves
+    EXPECT_EQ(1000, AppOpsManager::opToSwitch(1000));
+}
+
+}; // namespace android
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CallerScheduling_test"
+
+#include <gtest/gtest.h>
+
+#include <private/binder/CallerScheduling.h>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace android {
+
+static const uid_t SYSTEM_UID = 1000;
+static const uid_t APP_UID = 10001;
+static const uid_t SECONDARY_USER_APP_UID = 1010001;
+
+static uint32_t realtimeFlags(int priority) {
+    return CALLER_REALTIME | (uint32_t(priority) << CALLER_PRIORITY_SHIFT);
+}
+
+static uint32_t niceFlags(int nice) {
+    return uint32_t(nice + 20) << CALLER_PRIORITY_SHIFT;
+}
+
+class CallerSchedulingTest : public ::testing::Test {
+protected:
+    pid_t mTid;
+    int mPolicy;
+    struct sched_param mParam;
+    int mNice;
+
+    virtual void SetUp() {
+        mTid = syscall(__NR_gettid);
+        mPolicy = sched_getscheduler(mTid);
+        sched_getparam(mTid, &mParam);
+        mNice = getpriority(PRIO_PROCESS, mTid);
+    }
+
+    virtual void TearDown() {
+        sched_setscheduler(mTid, mPolicy, &mParam);
+        setpriority(PRIO_PROCESS, mTid, mNice);
+    }
+
+    void expectUnchanged() {
+        struct sched_param param;
+        EXPECT_EQ(mPolicy, sched_getscheduler(mTid));
+        ASSERT_EQ(0, sched_getparam(mTid, &param));
+        EXPECT_EQ(mParam.sched_priority, param.sched_priority);
+        EXPECT_EQ(mNice, getpriority(PRIO_PROCESS, mTid));
+    }
+};
+
+TEST_F(CallerSchedulingTest, OnlySystemUidsAreTrusted) {
+    EXPECT_TRUE(isTrustedSchedulingCaller(0));
+    EXPECT_TRUE(isTrustedSchedulingCaller(SYSTEM_UID));
+    EXPECT_FALSE(isTrustedSchedulingCaller(APP_UID));
+    EXPECT_FALSE(isTrustedSchedulingCaller(SECONDARY_USER_APP_UID));
+}
+
+TEST_F(CallerSchedulingTest, AppCallerIsIgnored) {
+    SavedScheduling saved;
+    EXPECT_FALSE(inheritCallerScheduling(mTid, realtimeFlags(99), APP_UID, &saved));
+    EXPECT_FALSE(inheritCallerScheduling(mTid, niceFlags(-20), APP_UID, &saved));
+    expectUnchanged();
+}
+
+TEST_F(CallerSchedulingTest, RealtimeIsCappedAndRestored) {
+    SavedScheduling saved;
+    if (!inheritCallerScheduling(mTid, realtimeFlags(99), SYSTEM_UID, &saved)) {
+        // not allowed to change our own scheduling, nothing to check
+        expectUnchanged();
+        return;
+    }
+
+    if (saved.policyChanged) {
+        struct sched_param param;
+        EXPECT_EQ(SCHED_FIFO, sched_getscheduler(mTid));
+        ASSERT_EQ(0, sched_getparam(mTid, &param));
+        EXPECT_EQ(MAX_INHERITED_RT_PRIORITY, param.sched_priority);
+    } else {
+        // fell back to a nice value, which is capped too
+        EXPECT_TRUE(saved.niceChanged);
+        EXPECT_EQ(MIN_INHERITED_NICE, getpriority(PRIO_PROCESS, mTid));
+    }
+
+    restoreScheduling(mTid, saved);
+    expectUnchanged();
+}
+
+TEST_F(CallerSchedulingTest, NiceIsCappedAndRestored) {
+    if (mPolicy != SCHED_OTHER) {
+        return;
+    }
+    SavedScheduling saved;
+    if (!inheritCallerScheduling(mTid, niceFlags(-20), SYSTEM_UID, &saved)) {
+        expectUnchanged();
+        return;
+    }
+
+    EXPECT_FALSE(saved.policyChanged);
+    EXPECT_TRUE(saved.niceChanged);
+    EXPECT_EQ(MIN_INHERITED_NICE, getpriority(PRIO_PROCESS, mTid));
+
+    restoreScheduling(mTid, saved);
+    expectUnchanged();
+}
+
+TEST_F(CallerSchedulingTest, LowerPriorityIsNotInherited) {
+    if (mPolicy != SCHED_OTHER || mNice <= -20) {
+        return;
+    }
+    SavedScheduling saved;
+    EXPECT_FALSE(inheritCallerScheduling(mTid, niceFlags(mNice + 1), SYSTEM_UID, &saved));
+    EXPECT_FALSE(saved.policyChanged);
+    EXPECT_FALSE(saved.niceChanged);
+    expectUnchanged();
+}
+
+TEST_F(CallerSchedulingTest, CallerFlagsRoundTrip) {
+    const uint32_t flags = callerSchedulingFlags(mTid);
+    if (mPolicy == SCHED_FIFO || mPolicy == SCHED_RR) {
+        EXPECT_TRUE(flags & CALLER_REALTIME);
+        EXPECT_EQ(uint32_t(mParam.sched_priority),
+                (flags & CALLER_PRIORITY_MASK) >> CALLER_PRIORITY_SHIFT);
+    } else {
+        EXPECT_FALSE(flags & CALLER_REALTIME);
+        EXPECT_EQ(uint32_t(mNice + 20),
+                (flags & CALLER_PRIORITY_MASK) >> CALLER_PRIORITY_SHIFT);
+    }
+}
+
+} // namespace android
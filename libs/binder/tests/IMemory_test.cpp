@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "IMemory_test"
+
+#include <gtest/gtest.h>
+
+#include <binder/IMemory.h>
+#include <binder/IServiceManager.h>
+#include <binder/MemoryBase.h>
+#include <binder/MemoryHeapBase.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+// The only transaction of IMemory.
+static const uint32_t GET_MEMORY = IBinder::FIRST_CALL_TRANSACTION;
+
+static const size_t HEAP_SIZE = 4096;
+
+// A heap received from another process and passed on, like a BpMemoryHeap,
+// which counts how often it is asked for its fd.
+class FakeForwardedHeap : public IMemoryHeap {
+public:
+    mutable int getHeapIDCount;
+
+    FakeForwardedHeap() : getHeapIDCount(0) {}
+
+    virtual int getHeapID() const {
+        getHeapIDCount++;
+        return -1;
+    }
+    virtual void* getBase() const { return MAP_FAILED; }
+    virtual size_t getSize() const { return HEAP_SIZE; }
+    virtual uint32_t getFlags() const { return 0; }
+    virtual uint32_t getOffset() const { return 0; }
+
+protected:
+    virtual IBinder* onAsBinder() {
+        // any proxy will do
+        return defaultServiceManager()->asBinder().get();
+    }
+};
+
+// Makes the call BpMemory makes, and returns the reply.
+static status_t getMemory(const sp<IMemory>& memory, Parcel* reply) {
+    Parcel data;
+    data.writeInterfaceToken(IMemory::getInterfaceDescriptor());
+    return memory->asBinder()->transact(GET_MEMORY, data, reply);
+}
+
+TEST(IMemoryTest, LocalHeapIsDescribedOnceToAProcess) {
+    sp<MemoryHeapBase> heap = new MemoryHeapBase(HEAP_SIZE, 0, "IMemoryTest");
+    ASSERT_GE(heap->getHeapID(), 0);
+    sp<MemoryBase> first = new MemoryBase(heap, 0, HEAP_SIZE / 2);
+    sp<MemoryBase> second = new MemoryBase(heap, HEAP_SIZE / 2, HEAP_SIZE / 2);
+
+    Parcel firstReply;
+    ASSERT_EQ(NO_ERROR, getMemory(first, &firstReply));
+    EXPECT_EQ(2U, firstReply.objectsCount())
+            << "Should send the heap's fd along with its first IMemory";
+
+    Parcel secondReply;
+    ASSERT_EQ(NO_ERROR, getMemory(second, &secondReply));
+    EXPECT_EQ(1U, secondReply.objectsCount())
+            << "Should not send the heap's fd again to the same process";
+}
+
+TEST(IMemoryTest, ForwardedHeapIsNotDescribed) {
+    sp<FakeForwardedHeap> heap = new FakeForwardedHeap();
+    sp<MemoryBase> memory = new MemoryBase(heap, 0, HEAP_SIZE);
+
+    Parcel reply;
+    ASSERT_EQ(NO_ERROR, getMemory(memory, &reply));
+    EXPECT_EQ(0, heap->getHeapIDCount)
+            << "Should not map a heap of another process to describe it";
+    EXPECT_EQ(1U, reply.objectsCount());
+}
+
+} // namespace android
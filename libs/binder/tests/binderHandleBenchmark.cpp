@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures how ProcessState::getStrongProxyForHandle() scales when many
+ * threads look up proxies at once.  Every thread repeatedly resolves the
+ * handles of a few well known services, which only exercises the handle
+ * table (the proxies already exist, no transaction is made).
+ *
+ * usage: binderHandleBenchmark [max threads] [lookups per thread]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <binder/BpBinder.h>
+#include <binder/IServiceManager.h>
+#include <binder/ProcessState.h>
+#include <utils/String16.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+#include <utils/threads.h>
+
+using namespace android;
+
+static Vector<int32_t> gHandles;
+static size_t gIterations = 200000;
+static volatile int32_t gStart = 0;
+
+class LookupThread : public Thread {
+public:
+    LookupThread() : Thread(false) { }
+private:
+    virtual bool threadLoop() {
+        while (!gStart) {
+            sched_yield();
+        }
+        const sp<ProcessState> proc(ProcessState::self());
+        const size_t N = gHandles.size();
+        for (size_t i = 0; i < gIterations; i++) {
+            sp<IBinder> b(proc->getStrongProxyForHandle(gHandles[i % N]));
+        }
+        return false;
+    }
+};
+
+static nsecs_t run(size_t threadCount)
+{
+    Vector<sp<Thread> > threads;
+    gStart = 0;
+    for (size_t i = 0; i < threadCount; i++) {
+        sp<Thread> t(new LookupThread());
+        t->run("lookup");
+        threads.add(t);
+    }
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    gStart = 1;
+    for (size_t i = 0; i < threadCount; i++) {
+        threads[i]->join();
+    }
+    return systemTime(SYSTEM_TIME_MONOTONIC) - start;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t maxThreads = argc > 1 ? atoi(argv[1]) : 16;
+    if (argc > 2) {
+        gIterations = atoi(argv[2]);
+    }
+
+    static const char* const kServices[] = {
+        "SurfaceFlinger", "activity", "package", "window",
+        "power", "sensorservice", "media.player", "input",
+    };
+
+    // Keep a strong reference on every proxy so that lookups never need
+    // to create one.
+    Vector<sp<IBinder> > binders;
+    sp<IServiceManager> sm(defaultServiceManager());
+    for (size_t i = 0; i < sizeof(kServices)/sizeof(kServices[0]); i++) {
+        sp<IBinder> b(sm->checkService(String16(kServices[i])));
+        BpBinder* proxy = b != NULL ? b->remoteBinder() : NULL;
+        if (proxy != NULL) {
+            binders.add(b);
+            gHandles.add(proxy->handle());
+        }
+    }
+    if (gHandles.isEmpty()) {
+        fprintf(stderr, "no services found\n");
+        return 1;
+    }
+
+    printf("%zu handles, %zu lookups per thread\n", gHandles.size(), gIterations);
+    printf("threads\ttotal ms\tns/lookup\tlookups/s\n");
+    for (size_t n = 1; n <= maxThreads; n *= 2) {
+        const nsecs_t t = run(n);
+        const double lookups = double(n) * gIterations;
+        printf("%zu\t%.2f\t%.1f\t%.0f\n", n, t / 1000000.0,
+                t / lookups * n, lookups / (t / 1000000000.0));
+    }
+    return 0;
+}
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Binder IPC benchmarks.  Forks a service process, then measures from one
+ * or more client processes:
+ *
+ *  - synchronous round trips for a range of payload sizes
+ *  - oneway transactions for the same sizes
+ *  - transactions carrying file descriptors and binder objects
+ *  - many clients calling the same service at once (fan-in)
+ *
+ * and, without any IPC, the cost of the basic Parcel write/read calls.
+ *
+ * Every result is printed as one tab separated line:
+ *   <test> <parameter> <iterations> <avg us> <min us> <max us> <ops/s>
+ *
+ * usage: binderTransactionBenchmark [-i iterations] [-c clients]
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <binder/Binder.h>
+#include <binder/IPCThreadState.h>
+#include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
+#include <binder/ProcessState.h>
+#include <utils/String16.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+using namespace android;
+
+static const char* const kServiceName = "binderTransactionBenchmark";
+
+enum {
+    ECHO_TRANSACTION = IBinder::FIRST_CALL_TRANSACTION,
+    SINK_TRANSACTION,
+    OBJECTS_TRANSACTION,
+};
+
+// ---------------------------------------------------------------------------
+
+class BenchmarkService : public BBinder {
+protected:
+    virtual status_t onTransact(uint32_t code, const Parcel& data,
+            Parcel* reply, uint32_t flags) {
+        switch (code) {
+            case ECHO_TRANSACTION:
+                return reply->appendFrom(&data, 0, data.dataSize());
+            case SINK_TRANSACTION:
+                return NO_ERROR;
+            case OBJECTS_TRANSACTION: {
+                const int32_t fds = data.readInt32();
+                for (int32_t i = 0; i < fds; i++) {
+                    data.readFileDescriptor();
+                }
+                const int32_t binders = data.readInt32();
+                for (int32_t i = 0; i < binders; i++) {
+                    data.readStrongBinder();
+                }
+                return NO_ERROR;
+            }
+        }
+        return BBinder::onTransact(code, data, reply, flags);
+    }
+};
+
+static void runService()
+{
+    defaultServiceManager()->addService(String16(kServiceName),
+            new BenchmarkService());
+    ProcessState::self()->startThreadPool();
+    IPCThreadState::self()->joinThreadPool();
+}
+
+// ---------------------------------------------------------------------------
+
+struct Result {
+    size_t iterations;
+    nsecs_t total;
+    nsecs_t min;
+    nsecs_t max;
+
+    Result() : iterations(0), total(0), min(0), max(0) { }
+
+    void add(nsecs_t t) {
+        if (iterations == 0 || t < min) min = t;
+        if (t > max) max = t;
+        total += t;
+        iterations++;
+    }
+
+    void print(const char* test, const char* param) const {
+        if (iterations == 0) return;
+        const double avg = total / double(iterations);
+        printf("%s\t%s\t%zu\t%.2f\t%.2f\t%.2f\t%.0f\n", test, param, iterations,
+                avg / 1000.0, min / 1000.0, max / 1000.0,
+                1000000000.0 / avg);
+        fflush(stdout);
+    }
+};
+
+static const size_t kPayloadSizes[] = { 0, 64, 256, 1024, 4096, 16384, 65536 };
+static const size_t kPayloadCount = sizeof(kPayloadSizes)/sizeof(kPayloadSizes[0]);
+
+static sp<IBinder> getBenchmarkService()
+{
+    sp<IBinder> b;
+    for (int i = 0; i < 50 && b == NULL; i++) {
+        b = defaultServiceManager()->checkService(String16(kServiceName));
+        if (b == NULL) usleep(100000);
+    }
+    return b;
+}
+
+static Result benchmarkTransact(const sp<IBinder>& service, uint32_t code,
+        size_t payload, uint32_t flags, size_t iterations)
+{
+    Result r;
+    Parcel data, reply;
+    data.setDataSize(payload);
+    for (size_t i = 0; i < iterations; i++) {
+        reply.freeData();
+        const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        status_t err = service->transact(code, data, &reply, flags);
+        r.add(systemTime(SYSTEM_TIME_MONOTONIC) - start);
+        if (err != NO_ERROR) {
+            fprintf(stderr, "transact failed: %d\n", err);
+            break;
+        }
+    }
+    return r;
+}
+
+static Result benchmarkObjects(const sp<IBinder>& service, int32_t fds,
+        int32_t binders, size_t iterations)
+{
+    Result r;
+    const sp<IBinder> token(new BBinder());
+    for (size_t i = 0; i < iterations; i++) {
+        Parcel data, reply;
+        const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        data.writeInt32(fds);
+        for (int32_t j = 0; j < fds; j++) {
+            data.writeDupFileDescriptor(STDERR_FILENO);
+        }
+        data.writeInt32(binders);
+        for (int32_t j = 0; j < binders; j++) {
+            data.writeStrongBinder(token);
+        }
+        status_t err = service->transact(OBJECTS_TRANSACTION, data, &reply);
+        r.add(systemTime(SYSTEM_TIME_MONOTONIC) - start);
+        if (err != NO_ERROR) {
+            fprintf(stderr, "transact failed: %d\n", err);
+            break;
+        }
+    }
+    return r;
+}
+
+static void runClient(size_t iterations)
+{
+    sp<IBinder> service(getBenchmarkService());
+    if (service == NULL) {
+        fprintf(stderr, "can't find %s\n", kServiceName);
+        exit(1);
+    }
+
+    char param[32];
+    for (size_t i = 0; i < kPayloadCount; i++) {
+        snprintf(param, sizeof(param), "%zu", kPayloadSizes[i]);
+        benchmarkTransact(service, ECHO_TRANSACTION, kPayloadSizes[i], 0,
+                iterations).print("sync_echo", param);
+        benchmarkTransact(service, SINK_TRANSACTION, kPayloadSizes[i], 0,
+                iterations).print("sync_sink", param);
+        benchmarkTransact(service, SINK_TRANSACTION, kPayloadSizes[i],
+                IBinder::FLAG_ONEWAY, iterations).print("oneway", param);
+    }
+
+    static const int32_t kObjectCounts[] = { 1, 4, 16 };
+    for (size_t i = 0; i < sizeof(kObjectCounts)/sizeof(kObjectCounts[0]); i++) {
+        snprintf(param, sizeof(param), "%d", kObjectCounts[i]);
+        benchmarkObjects(service, kObjectCounts[i], 0, iterations)
+                .print("fds", param);
+        benchmarkObjects(service, 0, kObjectCounts[i], iterations)
+                .print("binders", param);
+    }
+}
+
+// Each client runs in its own process; only client 0 reports, the point
+// being how latency degrades while the others compete for the service.
+static void runFanIn(size_t clients, size_t iterations)
+{
+    Vector<pid_t> pids;
+    for (size_t c = 0; c < clients; c++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            sp<IBinder> service(getBenchmarkService());
+            if (service == NULL) _exit(1);
+            Result r(benchmarkTransact(service, ECHO_TRANSACTION, 256, 0,
+                    iterations));
+            if (c == 0) {
+                char param[32];
+                snprintf(param, sizeof(param), "%zu", clients);
+                r.print("fan_in", param);
+            }
+            _exit(0);
+        }
+        pids.add(pid);
+    }
+    for (size_t c = 0; c < pids.size(); c++) {
+        waitpid(pids[c], NULL, 0);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+static void benchmarkParcel(size_t iterations)
+{
+    const String16 str(kServiceName);
+    char buffer[4096];
+    memset(buffer, 0, sizeof(buffer));
+
+    Result writeInt32, readInt32, writeString16, readString16, writeBuffer;
+    for (size_t i = 0; i < iterations; i++) {
+        Parcel p;
+        nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int j = 0; j < 64; j++) p.writeInt32(j);
+        writeInt32.add((systemTime(SYSTEM_TIME_MONOTONIC) - start) / 64);
+
+        p.setDataPosition(0);
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int j = 0; j < 64; j++) p.readInt32();
+        readInt32.add((systemTime(SYSTEM_TIME_MONOTONIC) - start) / 64);
+
+        Parcel s;
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int j = 0; j < 16; j++) s.writeString16(str);
+        writeString16.add((systemTime(SYSTEM_TIME_MONOTONIC) - start) / 16);
+
+        s.setDataPosition(0);
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int j = 0; j < 16; j++) s.readString16();
+        readString16.add((systemTime(SYSTEM_TIME_MONOTONIC) - start) / 16);
+
+        Parcel b;
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        b.write(buffer, sizeof(buffer));
+        writeBuffer.add(systemTime(SYSTEM_TIME_MONOTONIC) - start);
+    }
+    writeInt32.print("parcel_writeInt32", "64");
+    readInt32.print("parcel_readInt32", "64");
+    writeString16.print("parcel_writeString16", "16");
+    readString16.print("parcel_readString16", "16");
+    writeBuffer.print("parcel_write", "4096");
+}
+
+int main(int argc, char** argv)
+{
+    size_t iterations = 10000;
+    size_t clients = 4;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:c:")) != -1) {
+        switch (opt) {
+            case 'i': iterations = atoi(optarg); break;
+            case 'c': clients = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-i iterations] [-c clients]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // Parcel only tests first, before anything opens the driver.
+    printf("test\tparam\titerations\tavg_us\tmin_us\tmax_us\tops_per_s\n");
+    benchmarkParcel(iterations);
+
+    // The service must be forked off before the driver is opened here.
+    pid_t service = fork();
+    if (service == 0) {
+        runService();
+        _exit(0);
+    }
+
+    pid_t client = fork();
+    if (client == 0) {
+        runClient(iterations);
+        _exit(0);
+    }
+    waitpid(client, NULL, 0);
+
+    for (size_t n = 1; n <= clients; n *= 2) {
+        runFanIn(n, iterations);
+    }
+
+    kill(service, SIGTERM);
+    waitpid(service, NULL, 0);
+    return 0;
+}
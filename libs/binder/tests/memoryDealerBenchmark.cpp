@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Compares the best-fit allocator of MemoryDealer with its size classes
+ * (MemoryDealer::SIZE_CLASSES).  Keeps a working set of small allocations of
+ * random sizes alive, replacing a random one at each step, then dumps the
+ * state of both dealers to the log.
+ *
+ * usage: memoryDealerBenchmark [live allocations] [replacements]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <binder/IMemory.h>
+#include <binder/MemoryDealer.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+using namespace android;
+
+static nsecs_t run(const sp<MemoryDealer>& dealer, size_t live,
+        size_t iterations)
+{
+    Vector<sp<IMemory> > memory;
+    memory.insertAt(0, live);
+
+    srand(42);
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (size_t i = 0; i < live + iterations; i++) {
+        const size_t slot = i < live ? i : rand() % live;
+        memory.editItemAt(slot).clear();
+        memory.editItemAt(slot) = dealer->allocate(16 + rand() % 1024);
+        if (memory[slot] == NULL) {
+            fprintf(stderr, "out of memory after %zu allocations\n", i);
+            break;
+        }
+    }
+    const nsecs_t t = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    dealer->dump("memoryDealerBenchmark");
+    return t;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t live = argc > 1 ? atoi(argv[1]) : 4000;
+    const size_t iterations = argc > 2 ? atoi(argv[2]) : 200000;
+    const size_t heapSize = live * 2048;
+
+    printf("%zu live allocations, %zu replacements\n", live, iterations);
+    printf("allocator\ttotal ms\tns/replacement\n");
+    const nsecs_t bestFit = run(new MemoryDealer(heapSize, "bestfit"),
+            live, iterations);
+    printf("best fit\t%.2f\t%.1f\n", bestFit / 1000000.0,
+            double(bestFit) / (live + iterations));
+    const nsecs_t classes = run(new MemoryDealer(heapSize, "classes",
+            MemoryDealer::SIZE_CLASSES), live, iterations);
+    printf("size classes\t%.2f\t%.1f\n", classes / 1000000.0,
+            double(classes) / (live + iterations));
+    return 0;
+}
@@ -17,7 +17,11 @@
 
 #include <dirent.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include <diskusage/dirsize.h>
 
@@ -35,41 +39,181 @@ int64_t stat_size(struct stat *s)
     return size;
 }
 
-int64_t calculate_dir_size(int dfd)
+/* the layout of the records getdents64 returns */
+struct linux_dirent64 {
+    uint64_t        d_ino;
+    int64_t         d_off;
+    unsigned short  d_reclen;
+    unsigned char   d_type;
+    char            d_name[];
+};
+
+/* large enough for a few hundred entries per system call */
+#define DIRENT_BUFFER_SIZE  (32 * 1024)
+
+/* the most threads and queued directories of calculate_dir_size_parallel() */
+#define MAX_WALK_THREADS    4
+#define MAX_QUEUED_DIRS     256
+
+/* the directories calculate_dir_size_parallel() has yet to size, shared by
+   its threads */
+struct dir_walk {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int fds[MAX_QUEUED_DIRS];
+    size_t count;
+    int busy;           /* threads sizing a directory */
+    int64_t size;
+};
+
+/* hands fd to an idle thread, unless enough directories are queued already */
+static int queue_dir(struct dir_walk *walk, int fd)
+{
+    int queued = 0;
+    pthread_mutex_lock(&walk->lock);
+    if (walk->count < MAX_QUEUED_DIRS) {
+        walk->fds[walk->count++] = fd;
+        pthread_cond_signal(&walk->cond);
+        queued = 1;
+    }
+    pthread_mutex_unlock(&walk->lock);
+    return queued;
+}
+
+/* returns the size of the entries of dfd and of its subdirectories, except
+   the ones queued to walk, and closes dfd. buf is DIRENT_BUFFER_SIZE bytes. */
+static int64_t size_dir(int dfd, char *buf, struct dir_walk *walk)
 {
     int64_t size = 0;
     struct stat s;
-    DIR *d;
-    struct dirent *de;
+    char *subbuf = NULL;
+    long len;
 
-    d = fdopendir(dfd);
-    if (d == NULL) {
-        close(dfd);
-        return 0;
-    }
+    while ((len = syscall(__NR_getdents64, dfd, buf, DIRENT_BUFFER_SIZE)) > 0) {
+        long pos;
+        for (pos = 0; pos < len; ) {
+            struct linux_dirent64 *de = (struct linux_dirent64 *) (buf + pos);
+            const char *name = de->d_name;
+            int isdir;
+            pos += de->d_reclen;
 
-    while ((de = readdir(d))) {
-        const char *name = de->d_name;
-        if (fstatat(dfd, name, &s, AT_SYMLINK_NOFOLLOW) == 0) {
+            if (fstatat(dfd, name, &s, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
             size += stat_size(&s);
-        }
-        if (de->d_type == DT_DIR) {
-            int subfd;
+            isdir = de->d_type == DT_DIR ||
+                    (de->d_type == DT_UNKNOWN && S_ISDIR(s.st_mode));
+            if (isdir) {
+                int subfd;
+
+                /* always skip "." and ".." */
+                if (name[0] == '.') {
+                    if (name[1] == 0)
+                        continue;
+                    if ((name[1] == '.') && (name[2] == 0))
+                        continue;
+                }
 
-            /* always skip "." and ".." */
-            if (name[0] == '.') {
-                if (name[1] == 0)
+                subfd = openat(dfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                if (subfd < 0 || (walk && queue_dir(walk, subfd))) {
                     continue;
-                if ((name[1] == '.') && (name[2] == 0))
+                }
+                /* buf is still in use, the subdirectory needs its own */
+                if (subbuf == NULL && (subbuf = malloc(DIRENT_BUFFER_SIZE)) == NULL) {
+                    close(subfd);
                     continue;
-            }
-
-            subfd = openat(dfd, name, O_RDONLY | O_DIRECTORY);
-            if (subfd >= 0) {
-                size += calculate_dir_size(subfd);
+                }
+                size += size_dir(subfd, subbuf, walk);
             }
         }
     }
-    closedir(d);
+    free(subbuf);
+    close(dfd);
+    return size;
+}
+
+int64_t calculate_dir_size(int dfd)
+{
+    char *buf = malloc(DIRENT_BUFFER_SIZE);
+    if (buf == NULL) {
+        close(dfd);
+        return 0;
+    }
+    int64_t size = size_dir(dfd, buf, NULL);
+    free(buf);
     return size;
 }
+
+static void *walk_thread(void *arg)
+{
+    struct dir_walk *walk = arg;
+    char *buf = malloc(DIRENT_BUFFER_SIZE);
+
+    pthread_mutex_lock(&walk->lock);
+    for (;;) {
+        while (walk->count == 0 && walk->busy > 0) {
+            pthread_cond_wait(&walk->cond, &walk->lock);
+        }
+        if (walk->count == 0) {
+            /* nothing queued and nobody left to queue anything: done */
+            pthread_cond_broadcast(&walk->cond);
+            break;
+        }
+        int fd = walk->fds[--walk->count];
+        if (buf == NULL) {
+            close(fd);
+            continue;
+        }
+        walk->busy++;
+        pthread_mutex_unlock(&walk->lock);
+
+        int64_t size = size_dir(fd, buf, walk);
+
+        pthread_mutex_lock(&walk->lock);
+        walk->size += size;
+        walk->busy--;
+    }
+    pthread_mutex_unlock(&walk->lock);
+    free(buf);
+    return NULL;
+}
+
+int64_t calculate_dir_size_parallel(int dfd, int threads)
+{
+    struct dir_walk walk;
+    pthread_t tids[MAX_WALK_THREADS];
+    int started = 0;
+    int i;
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? cpus : 1;
+    }
+    if (threads > MAX_WALK_THREADS) {
+        threads = MAX_WALK_THREADS;
+    }
+    if (threads == 1) {
+        return calculate_dir_size(dfd);
+    }
+
+    pthread_mutex_init(&walk.lock, NULL);
+    pthread_cond_init(&walk.cond, NULL);
+    walk.fds[0] = dfd;
+    walk.count = 1;
+    walk.busy = 0;
+    walk.size = 0;
+
+    for (i = 1; i < threads; i++) {
+        if (pthread_create(&tids[started], NULL, walk_thread, &walk) == 0) {
+            started++;
+        }
+    }
+    walk_thread(&walk);
+    for (i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    pthread_cond_destroy(&walk.cond);
+    pthread_mutex_destroy(&walk.lock);
+    return walk.size;
+}
@@ -5,10 +5,12 @@ LOCAL_SRC_FILES:= \
 	IGraphicBufferConsumer.cpp \
 	IConsumerListener.cpp \
 	BitTube.cpp \
+	BufferConverter.cpp \
 	BufferItem.cpp \
 	BufferItemConsumer.cpp \
 	BufferQueue.cpp \
 	BufferQueueConsumer.cpp \
+	BufferQueueControl.cpp \
 	BufferQueueCore.cpp \
 	BufferQueueProducer.cpp \
 	BufferSlot.cpp \
@@ -29,12 +31,14 @@ LOCAL_SRC_FILES:= \
 	LayerState.cpp \
 	Sensor.cpp \
 	SensorEventQueue.cpp \
+	SensorEventRing.cpp \
 	SensorManager.cpp \
 	StreamSplitter.cpp \
 	Surface.cpp \
 	SurfaceControl.cpp \
 	SurfaceComposerClient.cpp \
 	SyncFeatures.cpp \
+	YuvPlanes.cpp \
 
 LOCAL_SHARED_LIBRARIES := \
 	libbinder \
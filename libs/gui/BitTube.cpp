@@ -18,7 +18,9 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <utils/Errors.h>
@@ -104,6 +106,15 @@ int BitTube::getSendFd() const
     return mSendFd;
 }
 
+status_t BitTube::setSendBufferSize(size_t size)
+{
+    int sndbuf = int(size);
+    if (setsockopt(mSendFd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)) < 0) {
+        return -errno;
+    }
+    return NO_ERROR;
+}
+
 ssize_t BitTube::write(void const* vaddr, size_t size)
 {
     ssize_t err, len;
@@ -172,5 +183,44 @@ ssize_t BitTube::recvObjects(const sp<BitTube>& tube,
     return size < 0 ? size : size / objSize;
 }
 
+ssize_t BitTube::recvObjectMessages(const sp<BitTube>& tube,
+        void* slots, size_t slotCount, size_t maxMessages,
+        size_t* outCounts, size_t objSize)
+{
+    enum { MAX_MESSAGES = 16 };
+    struct mmsghdr msgs[MAX_MESSAGES];
+    struct iovec iov[MAX_MESSAGES];
+    char* vaddr = reinterpret_cast<char*>(slots);
+    const size_t slotSize = slotCount * objSize;
+
+    if (maxMessages > MAX_MESSAGES) {
+        maxMessages = MAX_MESSAGES;
+    }
+    memset(msgs, 0, sizeof(msgs[0]) * maxMessages);
+    for (size_t i = 0; i < maxMessages; i++) {
+        iov[i].iov_base = vaddr + i * slotSize;
+        iov[i].iov_len = slotSize;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int n, err;
+    do {
+        n = ::recvmmsg(tube->mReceiveFd, msgs, maxMessages, MSG_DONTWAIT, NULL);
+        err = n < 0 ? errno : 0;
+    } while (err == EINTR);
+    if (err == EAGAIN || err == EWOULDBLOCK) {
+        return 0;
+    }
+    if (err != 0) {
+        return -err;
+    }
+    for (int i = 0; i < n; i++) {
+        // a truncated message only loses its whole objects past the slot
+        outCounts[i] = msgs[i].msg_len / objSize;
+    }
+    return n;
+}
+
 // ----------------------------------------------------------------------------
 }; // namespace android
@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BufferConverter"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+//#define LOG_NDEBUG 0
+
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include <unistd.h>
+
+#include <system/window.h>
+
+#include <gui/BufferConverter.h>
+
+#include <private/gui/SyncFeatures.h>
+
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+namespace android {
+
+// Beyond this many buffers the images are all dropped, the producer has
+// probably reallocated its buffers.
+static const size_t MAX_CACHED_IMAGES = 16;
+
+static const char kVertexShader[] =
+        "attribute vec2 aPosition;\n"
+        "attribute vec2 aTexCoord;\n"
+        "varying vec2 vTexCoord;\n"
+        "void main() {\n"
+        "  gl_Position = vec4(aPosition, 0.0, 1.0);\n"
+        "  vTexCoord = aTexCoord;\n"
+        "}\n";
+
+// Sampling through an external texture has the driver convert YUV to RGB.
+static const char kFragmentShader[] =
+        "#extension GL_OES_EGL_image_external : require\n"
+        "precision mediump float;\n"
+        "uniform samplerExternalOES uTexture;\n"
+        "varying vec2 vTexCoord;\n"
+        "void main() {\n"
+        "  gl_FragColor = texture2D(uTexture, vTexCoord);\n"
+        "}\n";
+
+static GLuint loadShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        ALOGE("error compiling shader: %s", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// mapToSource maps a point of the destination, in [0,1] with the origin on
+// the first row of the buffer, to the point of the source shown there once
+// transform is applied.
+static void mapToSource(uint32_t transform, float u, float v,
+        float* outX, float* outY) {
+    if (transform & NATIVE_WINDOW_TRANSFORM_ROT_90) {
+        float t = u;
+        u = v;
+        v = 1.0f - t;
+    }
+    if (transform & NATIVE_WINDOW_TRANSFORM_FLIP_H) {
+        u = 1.0f - u;
+    }
+    if (transform & NATIVE_WINDOW_TRANSFORM_FLIP_V) {
+        v = 1.0f - v;
+    }
+    *outX = u;
+    *outY = v;
+}
+
+BufferConverter::BufferConverter() :
+    mInitError(NO_INIT),
+    mEglDisplay(EGL_NO_DISPLAY),
+    mEglContext(EGL_NO_CONTEXT),
+    mEglSurface(EGL_NO_SURFACE),
+    mProgram(0),
+    mPositionLoc(-1),
+    mTexCoordLoc(-1),
+    mSrcTexture(0),
+    mDstTexture(0),
+    mFramebuffer(0) {
+}
+
+BufferConverter::~BufferConverter() {
+    if (mEglContext == EGL_NO_CONTEXT) {
+        return;
+    }
+    EGLDisplay prevDisplay = eglGetCurrentDisplay();
+    EGLContext prevContext = eglGetCurrentContext();
+    EGLSurface prevDraw = eglGetCurrentSurface(EGL_DRAW);
+    EGLSurface prevRead = eglGetCurrentSurface(EGL_READ);
+    if (eglMakeCurrent(mEglDisplay, mEglSurface, mEglSurface, mEglContext)) {
+        glDeleteFramebuffers(1, &mFramebuffer);
+        glDeleteTextures(1, &mSrcTexture);
+        glDeleteTextures(1, &mDstTexture);
+        glDeleteProgram(mProgram);
+        clearImagesLocked();
+    }
+    if (prevContext != EGL_NO_CONTEXT) {
+        eglMakeCurrent(prevDisplay, prevDraw, prevRead, prevContext);
+    } else {
+        eglMakeCurrent(mEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                EGL_NO_CONTEXT);
+    }
+    eglDestroySurface(mEglDisplay, mEglSurface);
+    eglDestroyContext(mEglDisplay, mEglContext);
+}
+
+status_t BufferConverter::initLocked() {
+    mEglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (mEglDisplay == EGL_NO_DISPLAY ||
+            !eglInitialize(mEglDisplay, NULL, NULL)) {
+        ALOGE("initLocked: unable to initialize EGL: %#x", eglGetError());
+        return NO_INIT;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(mEglDisplay, configAttribs, &config, 1, &numConfigs)
+            || numConfigs < 1) {
+        ALOGE("initLocked: no suitable EGLConfig: %#x", eglGetError());
+        return NO_INIT;
+    }
+
+    const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    mEglContext = eglCreateContext(mEglDisplay, config, EGL_NO_CONTEXT,
+            contextAttribs);
+    // Rendering only goes to framebuffer objects, but not every driver
+    // supports surfaceless contexts.
+    const EGLint surfaceAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    mEglSurface = eglCreatePbufferSurface(mEglDisplay, config, surfaceAttribs);
+    if (mEglContext == EGL_NO_CONTEXT || mEglSurface == EGL_NO_SURFACE ||
+            !eglMakeCurrent(mEglDisplay, mEglSurface, mEglSurface,
+                    mEglContext)) {
+        ALOGE("initLocked: unable to create an EGL context: %#x",
+                eglGetError());
+        return NO_INIT;
+    }
+
+    GLuint vs = loadShader(GL_VERTEX_SHADER, kVertexShader);
+    GLuint fs = loadShader(GL_FRAGMENT_SHADER, kFragmentShader);
+    if (!vs || !fs) {
+        return NO_INIT;
+    }
+    mProgram = glCreateProgram();
+    glAttachShader(mProgram, vs);
+    glAttachShader(mProgram, fs);
+    glLinkProgram(mProgram);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    GLint linked = 0;
+    glGetProgramiv(mProgram, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        ALOGE("initLocked: error linking the program");
+        return NO_INIT;
+    }
+    mPositionLoc = glGetAttribLocation(mProgram, "aPosition");
+    mTexCoordLoc = glGetAttribLocation(mProgram, "aTexCoord");
+    glUseProgram(mProgram);
+    glUniform1i(glGetUniformLocation(mProgram, "uTexture"), 0);
+
+    glGenTextures(1, &mSrcTexture);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, mSrcTexture);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenTextures(1, &mDstTexture);
+    glGenFramebuffers(1, &mFramebuffer);
+    glDisable(GL_BLEND);
+    glDisable(GL_DITHER);
+    return NO_ERROR;
+}
+
+EGLImageKHR BufferConverter::getImageLocked(const sp<GraphicBuffer>& buffer) {
+    ssize_t index = mImages.indexOfKey(buffer->getId());
+    if (index >= 0) {
+        if (mImages.valueAt(index).mGraphicBuffer == buffer) {
+            return mImages.valueAt(index).mEglImage;
+        }
+        eglDestroyImageKHR(mEglDisplay, mImages.valueAt(index).mEglImage);
+        mImages.removeItemsAt(index);
+    }
+    if (mImages.size() >= MAX_CACHED_IMAGES) {
+        clearImagesLocked();
+    }
+
+    const EGLint attrs[] = { EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE };
+    EGLImageKHR image = eglCreateImageKHR(mEglDisplay, EGL_NO_CONTEXT,
+            EGL_NATIVE_BUFFER_ANDROID,
+            (EGLClientBuffer)buffer->getNativeBuffer(), attrs);
+    if (image == EGL_NO_IMAGE_KHR) {
+        ALOGE("getImageLocked: error creating EGLImage: %#x", eglGetError());
+        return EGL_NO_IMAGE_KHR;
+    }
+    CachedImage cached;
+    cached.mGraphicBuffer = buffer;
+    cached.mEglImage = image;
+    mImages.add(buffer->getId(), cached);
+    return image;
+}
+
+void BufferConverter::clearImagesLocked() {
+    for (size_t i = 0; i < mImages.size(); i++) {
+        eglDestroyImageKHR(mEglDisplay, mImages.valueAt(i).mEglImage);
+    }
+    mImages.clear();
+}
+
+status_t BufferConverter::convert(const sp<GraphicBuffer>& src,
+        const sp<Fence>& srcFence, const Rect& crop, uint32_t transform,
+        const sp<GraphicBuffer>& dst, sp<Fence>* outFence) {
+    ATRACE_CALL();
+    Mutex::Autolock lock(mMutex);
+
+    EGLDisplay prevDisplay = eglGetCurrentDisplay();
+    EGLContext prevContext = eglGetCurrentContext();
+    EGLSurface prevDraw = eglGetCurrentSurface(EGL_DRAW);
+    EGLSurface prevRead = eglGetCurrentSurface(EGL_READ);
+
+    status_t err;
+    if (mInitError == NO_INIT) {
+        mInitError = initLocked();
+        err = mInitError;
+    } else if (mInitError == NO_ERROR) {
+        err = eglMakeCurrent(mEglDisplay, mEglSurface, mEglSurface,
+                mEglContext) ? status_t(NO_ERROR) : status_t(UNKNOWN_ERROR);
+    } else {
+        err = mInitError;
+    }
+    if (err == NO_ERROR) {
+        err = convertLocked(src, srcFence, crop, transform, dst, outFence);
+    }
+
+    if (prevContext != EGL_NO_CONTEXT) {
+        eglMakeCurrent(prevDisplay, prevDraw, prevRead, prevContext);
+    } else if (mEglDisplay != EGL_NO_DISPLAY) {
+        eglMakeCurrent(mEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                EGL_NO_CONTEXT);
+    }
+    return err;
+}
+
+status_t BufferConverter::convertLocked(const sp<GraphicBuffer>& src,
+        const sp<Fence>& srcFence, const Rect& crop, uint32_t transform,
+        const sp<GraphicBuffer>& dst, sp<Fence>* outFence) {
+    EGLImageKHR srcImage = getImageLocked(src);
+    EGLImageKHR dstImage = getImageLocked(dst);
+    if (srcImage == EGL_NO_IMAGE_KHR || dstImage == EGL_NO_IMAGE_KHR) {
+        return BAD_VALUE;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, mDstTexture);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)dstImage);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, mDstTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        ALOGE("convert: format %d can't be rendered to (%#x)",
+                dst->getPixelFormat(), status);
+        return BAD_VALUE;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, mSrcTexture);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES,
+            (GLeglImageOES)srcImage);
+
+    // Have the GPU wait for the producer, rather than this thread
+    if (srcFence != NULL) {
+        status_t err = SyncFeatures::getInstance().waitForFence(mEglDisplay,
+                srcFence, "BufferConverter::convert");
+        if (err != NO_ERROR) {
+            return err;
+        }
+    }
+
+    // The source coordinates of the corners of the destination, in the
+    // order of the triangle strip below
+    Rect srcCrop(crop.isEmpty() ? src->getBounds() : crop);
+    const float srcW = float(src->getWidth());
+    const float srcH = float(src->getHeight());
+    static const GLfloat positions[] = { -1, -1,  1, -1,  -1, 1,  1, 1 };
+    static const float corners[] = { 0, 0,  1, 0,  0, 1,  1, 1 };
+    GLfloat texCoords[8];
+    for (int i = 0; i < 4; i++) {
+        float x, y;
+        mapToSource(transform, corners[i*2], corners[i*2 + 1], &x, &y);
+        texCoords[i*2] = (srcCrop.left + x * srcCrop.width()) / srcW;
+        texCoords[i*2 + 1] = (srcCrop.top + y * srcCrop.height()) / srcH;
+    }
+
+    glViewport(0, 0, dst->getWidth(), dst->getHeight());
+    glUseProgram(mProgram);
+    glVertexAttribPointer(mPositionLoc, 2, GL_FLOAT, GL_FALSE, 0, positions);
+    glEnableVertexAttribArray(mPositionLoc);
+    glVertexAttribPointer(mTexCoordLoc, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+    glEnableVertexAttribArray(mTexCoordLoc);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    GLenum glErr = glGetError();
+    if (glErr != GL_NO_ERROR) {
+        ALOGE("convert: GL error %#x", glErr);
+        return UNKNOWN_ERROR;
+    }
+
+    *outFence = Fence::NO_FENCE;
+    if (SyncFeatures::getInstance().useNativeFenceSync()) {
+        EGLSyncKHR sync = eglCreateSyncKHR(mEglDisplay,
+                EGL_SYNC_NATIVE_FENCE_ANDROID, NULL);
+        if (sync != EGL_NO_SYNC_KHR) {
+            glFlush();
+            int fenceFd = eglDupNativeFenceFDANDROID(mEglDisplay, sync);
+            eglDestroySyncKHR(mEglDisplay, sync);
+            if (fenceFd != EGL_NO_NATIVE_FENCE_FD_ANDROID) {
+                *outFence = new Fence(fenceFd);
+                return NO_ERROR;
+            }
+        }
+        ALOGW("convert: no native fence, waiting for the GPU: %#x",
+                eglGetError());
+    }
+    glFinish();
+    return NO_ERROR;
+}
+
+}; // namespace android
@@ -23,6 +23,11 @@
 
 namespace android {
 
+template <typename T>
+static inline T min(T a, T b) { return a < b ? a : b; }
+template <typename T>
+static inline T max(T a, T b) { return a > b ? a : b; }
+
 BufferItem::BufferItem() :
     mTransform(0),
     mScalingMode(NATIVE_WINDOW_SCALING_MODE_FREEZE),
@@ -34,6 +39,7 @@ BufferItem::BufferItem() :
     mAcquireCalled(false),
     mTransformToDisplayInverse(false) {
     mCrop.makeInvalid();
+    mSurfaceDamage.makeInvalid();
 }
 
 BufferItem::operator IGraphicBufferConsumer::BufferItem() const {
@@ -50,9 +56,24 @@ BufferItem::operator IGraphicBufferConsumer::BufferItem() const {
     bufferItem.mIsDroppable = mIsDroppable;
     bufferItem.mAcquireCalled = mAcquireCalled;
     bufferItem.mTransformToDisplayInverse = mTransformToDisplayInverse;
+    bufferItem.mSurfaceDamage = mSurfaceDamage;
     return bufferItem;
 }
 
+void BufferItem::addOlderSurfaceDamage(const Rect& damage) {
+    if (!mSurfaceDamage.isValid() || !damage.isValid()) {
+        mSurfaceDamage.makeInvalid();
+    } else if (mSurfaceDamage.isEmpty()) {
+        mSurfaceDamage = damage;
+    } else if (!damage.isEmpty()) {
+        mSurfaceDamage = Rect(
+                min(mSurfaceDamage.left, damage.left),
+                min(mSurfaceDamage.top, damage.top),
+                max(mSurfaceDamage.right, damage.right),
+                max(mSurfaceDamage.bottom, damage.bottom));
+    }
+}
+
 size_t BufferItem::getPodSize() const {
     size_t c =  sizeof(mCrop) +
             sizeof(mTransform) +
@@ -63,7 +84,8 @@ size_t BufferItem::getPodSize() const {
             sizeof(mSlot) +
             sizeof(mIsDroppable) +
             sizeof(mAcquireCalled) +
-            sizeof(mTransformToDisplayInverse);
+            sizeof(mTransformToDisplayInverse) +
+            sizeof(mSurfaceDamage);
     return c;
 }
 
@@ -134,6 +156,7 @@ status_t BufferItem::flatten(
     FlattenableUtils::write(buffer, size, mIsDroppable);
     FlattenableUtils::write(buffer, size, mAcquireCalled);
     FlattenableUtils::write(buffer, size, mTransformToDisplayInverse);
+    FlattenableUtils::write(buffer, size, mSurfaceDamage);
 
     return NO_ERROR;
 }
@@ -176,6 +199,7 @@ status_t BufferItem::unflatten(
     FlattenableUtils::read(buffer, size, mIsDroppable);
     FlattenableUtils::read(buffer, size, mAcquireCalled);
     FlattenableUtils::read(buffer, size, mTransformToDisplayInverse);
+    FlattenableUtils::read(buffer, size, mSurfaceDamage);
 
     return NO_ERROR;
 }
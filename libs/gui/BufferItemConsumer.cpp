@@ -100,6 +100,58 @@ status_t BufferItemConsumer::releaseBuffer(const BufferItem &item,
     return err;
 }
 
+status_t BufferItemConsumer::acquireBuffers(size_t maxCount,
+        Vector<BufferItem>* items, nsecs_t presentWhen, bool waitForFence) {
+    status_t err;
+
+    if (!items) return BAD_VALUE;
+
+    Mutex::Autolock _l(mMutex);
+
+    const size_t first = items->size();
+    err = acquireBuffersLocked(maxCount, items, presentWhen);
+    if (err != OK) {
+        if (err != NO_BUFFER_AVAILABLE) {
+            BI_LOGE("Error acquiring buffers: %s (%d)", strerror(err), err);
+        }
+        return err;
+    }
+
+    for (size_t i = first; i < items->size(); i++) {
+        BufferItem& item(items->editItemAt(i));
+        if (waitForFence) {
+            err = item.mFence->waitForever("BufferItemConsumer::acquireBuffers");
+            if (err != OK) {
+                BI_LOGE("Failed to wait for fence of acquired buffer: %s (%d)",
+                        strerror(-err), err);
+                return err;
+            }
+        }
+        item.mGraphicBuffer = mSlots[item.mBuf].mGraphicBuffer;
+    }
+
+    return OK;
+}
+
+status_t BufferItemConsumer::releaseBuffers(const Vector<BufferItem>& items,
+        const sp<Fence>& releaseFence) {
+    status_t err;
+
+    Mutex::Autolock _l(mMutex);
+
+    for (size_t i = 0; i < items.size(); i++) {
+        addReleaseFenceLocked(items[i].mBuf, items[i].mGraphicBuffer,
+                releaseFence);
+    }
+
+    err = releaseBuffersLocked(items);
+    if (err != OK) {
+        BI_LOGE("Failed to release buffers: %s (%d)",
+                strerror(-err), err);
+    }
+    return err;
+}
+
 status_t BufferItemConsumer::setDefaultBufferSize(uint32_t w, uint32_t h) {
     Mutex::Autolock _l(mMutex);
     return mConsumer->setDefaultBufferSize(w, h);
@@ -26,6 +26,8 @@
 #include <gui/IConsumerListener.h>
 #include <gui/IProducerListener.h>
 
+#include <private/gui/BufferQueueControl.h>
+
 namespace android {
 
 BufferQueueConsumer::BufferQueueConsumer(const sp<BufferQueueCore>& core) :
@@ -40,16 +42,71 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
     ATRACE_CALL();
     Mutex::Autolock lock(mCore->mMutex);
 
+    status_t result = acquireBufferLocked(outBuffer, expectedPresent);
+    if (result != NO_ERROR) {
+        return result;
+    }
+
+    // We might have freed a slot while dropping old buffers, or the producer
+    // may be blocked waiting for the number of buffers in the queue to
+    // decrease.
+    mCore->mDequeueCondition.broadcast();
+
+    ATRACE_INT(mCore->mConsumerName.string(), mCore->mQueue.size());
+
+    return NO_ERROR;
+}
+
+status_t BufferQueueConsumer::acquireBuffers(size_t maxCount,
+        Vector<BufferItem>* outBuffers, nsecs_t expectedPresent) {
+    ATRACE_CALL();
+
+    if (maxCount == 0 || outBuffers == NULL) {
+        return BAD_VALUE;
+    }
+
+    Mutex::Autolock lock(mCore->mMutex);
+
+    size_t acquired = 0;
+    status_t result = NO_ERROR;
+    while (acquired < maxCount) {
+        // Once a buffer is acquired, running out of queued buffers or of
+        // buffers to acquire only ends the batch
+        if (acquired > 0 && (mCore->mQueue.empty() ||
+                mCore->countSlotsLocked(BufferSlot::ACQUIRED,
+                        BufferQueueDefs::NUM_BUFFER_SLOTS) >=
+                mCore->mMaxAcquiredBufferCount + 1)) {
+            break;
+        }
+
+        BufferItem item;
+        status_t err = acquireBufferLocked(&item, expectedPresent);
+        if (err != NO_ERROR) {
+            if (acquired == 0) {
+                result = err;
+            }
+            break;
+        }
+        outBuffers->push_back(item);
+        acquired++;
+    }
+
+    if (acquired > 0) {
+        mCore->mDequeueCondition.broadcast();
+        ATRACE_INT(mCore->mConsumerName.string(), mCore->mQueue.size());
+    }
+
+    return result;
+}
+
+status_t BufferQueueConsumer::acquireBufferLocked(BufferItem* outBuffer,
+        nsecs_t expectedPresent) {
     // Check that the consumer doesn't currently have the maximum number of
     // buffers acquired. We allow the max buffer count to be exceeded by one
     // buffer so that the consumer can successfully set up the newly acquired
     // buffer before releasing the old one.
-    int numAcquiredBuffers = 0;
-    for (int s = 0; s < BufferQueueDefs::NUM_BUFFER_SLOTS; ++s) {
-        if (mSlots[s].mBufferState == BufferSlot::ACQUIRED) {
-            ++numAcquiredBuffers;
-        }
-    }
+    const int numAcquiredBuffers = mCore->countSlotsLocked(
+            BufferSlot::ACQUIRED, BufferQueueDefs::NUM_BUFFER_SLOTS);
     if (numAcquiredBuffers >= mCore->mMaxAcquiredBufferCount + 1) {
         BQ_LOGE("acquireBuffer: max acquired buffer count reached: %d (max %d)",
                 numAcquiredBuffers, mCore->mMaxAcquiredBufferCount);
@@ -64,6 +121,7 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
     }
 
     BufferQueueCore::Fifo::iterator front(mCore->mQueue.begin());
+    uint32_t droppedFrames = 0;
 
     // If expectedPresent is specified, we may not want to return a buffer yet.
     // If it's specified and there's more than one buffer queued, we may want
@@ -86,10 +144,12 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
         // are positive.
 
         // Start by checking to see if we can drop frames. We skip this check if
-        // the timestamps are being auto-generated by Surface. If the app isn't
-        // generating timestamps explicitly, it probably doesn't want frames to
-        // be discarded based on them.
-        while (mCore->mQueue.size() > 1 && !mCore->mQueue[0].mIsAutoTimestamp) {
+        // the timestamps are being auto-generated by Surface, unless the
+        // consumer asked for it. If the app isn't generating timestamps
+        // explicitly, it probably doesn't want frames to be discarded based
+        // on them.
+        while (mCore->mQueue.size() > 1 && (mCore->mDropLateFrames ||
+                !mCore->mQueue[0].mIsAutoTimestamp)) {
             // If entry[1] is timely, drop entry[0] (and repeat). We apply an
             // additional criterion here: we only drop the earlier buffer if our
             // desiredPresent falls within +/- 1 second of the expected present.
@@ -119,10 +179,15 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
                     desiredPresent, expectedPresent, mCore->mQueue.size());
             if (mCore->stillTracking(front)) {
                 // Front buffer is still in mSlots, so mark the slot as free
-                mSlots[front->mSlot].mBufferState = BufferSlot::FREE;
+                mCore->setBufferStateLocked(front->mSlot, BufferSlot::FREE);
+                mCore->recordDropLocked(front->mSlot);
             }
+            // The next frame now also has to carry the dropped one's damage
+            mCore->mQueue.editItemAt(1).addOlderSurfaceDamage(
+                    front->mSurfaceDamage);
             mCore->mQueue.erase(front);
             front = mCore->mQueue.begin();
+            droppedFrames++;
         }
 
         // See if the front buffer is due
@@ -145,6 +210,7 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
 
     int slot = front->mSlot;
     *outBuffer = *front;
+    outBuffer->mDroppedFrameCount = droppedFrames;
     ATRACE_BUFFER_INDEX(slot);
 
     BQ_LOGV("acquireBuffer: acquiring { slot=%d/%" PRIu64 " buffer=%p }",
@@ -153,7 +219,8 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
     if (mCore->stillTracking(front)) {
         mSlots[slot].mAcquireCalled = true;
         mSlots[slot].mNeedsCleanupOnRelease = false;
-        mSlots[slot].mBufferState = BufferSlot::ACQUIRED;
+        mCore->setBufferStateLocked(slot, BufferSlot::ACQUIRED);
+        mCore->recordAcquireLocked(slot);
         mSlots[slot].mFence = Fence::NO_FENCE;
     }
 
@@ -166,13 +233,6 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
 
     mCore->mQueue.erase(front);
 
-    // We might have freed a slot while dropping old buffers, or the producer
-    // may be blocked waiting for the number of buffers in the queue to
-    // decrease.
-    mCore->mDequeueCondition.broadcast();
-
-    ATRACE_INT(mCore->mConsumerName.string(), mCore->mQueue.size());
-
     return NO_ERROR;
 }
 
@@ -219,18 +279,10 @@ status_t BufferQueueConsumer::attachBuffer(int* outSlot,
 
     // Make sure we don't have too many acquired buffers and find a free slot
     // to put the buffer into (the oldest if there are multiple).
-    int numAcquiredBuffers = 0;
-    int found = BufferQueueCore::INVALID_BUFFER_SLOT;
-    for (int s = 0; s < BufferQueueDefs::NUM_BUFFER_SLOTS; ++s) {
-        if (mSlots[s].mBufferState == BufferSlot::ACQUIRED) {
-            ++numAcquiredBuffers;
-        } else if (mSlots[s].mBufferState == BufferSlot::FREE) {
-            if (found == BufferQueueCore::INVALID_BUFFER_SLOT ||
-                    mSlots[s].mFrameNumber < mSlots[found].mFrameNumber) {
-                found = s;
-            }
-        }
-    }
+    const int numAcquiredBuffers = mCore->countSlotsLocked(
+            BufferSlot::ACQUIRED, BufferQueueDefs::NUM_BUFFER_SLOTS);
+    const int found = mCore->findOldestFreeSlotLocked(
+            BufferQueueDefs::NUM_BUFFER_SLOTS);
 
     if (numAcquiredBuffers >= mCore->mMaxAcquiredBufferCount + 1) {
         BQ_LOGE("attachBuffer(P): max acquired buffer count reached: %d "
@@ -248,7 +300,8 @@ status_t BufferQueueConsumer::attachBuffer(int* outSlot,
     BQ_LOGV("attachBuffer(C): returning slot %d", *outSlot);
 
     mSlots[*outSlot].mGraphicBuffer = buffer;
-    mSlots[*outSlot].mBufferState = BufferSlot::ACQUIRED;
+    mCore->setBufferStateLocked(*outSlot, BufferSlot::ACQUIRED);
+    mCore->mFrameTimes[*outSlot] = BufferQueueCore::FrameTimes();
     mSlots[*outSlot].mAttachedByConsumer = true;
     mSlots[*outSlot].mNeedsCleanupOnRelease = false;
     mSlots[*outSlot].mFence = Fence::NO_FENCE;
@@ -280,56 +333,119 @@ status_t BufferQueueConsumer::releaseBuffer(int slot, uint64_t frameNumber,
     ATRACE_CALL();
     ATRACE_BUFFER_INDEX(slot);
 
-    if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS ||
-            releaseFence == NULL) {
+    sp<IProducerListener> listener;
+    { // Autolock scope
+        Mutex::Autolock lock(mCore->mMutex);
+
+        status_t result = releaseBufferLocked(slot, frameNumber, releaseFence,
+                eglDisplay, eglFence);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        listener = mCore->mConnectedProducerListener;
+
+        mCore->mDequeueCondition.broadcast();
+    } // Autolock scope
+
+    mCore->recordGpuTimes();
+
+    // Call back without lock held
+    if (listener != NULL) {
+        listener->onBufferReleased();
+    }
+
+    return NO_ERROR;
+}
+
+status_t BufferQueueConsumer::releaseBuffers(
+        const Vector<ReleasedBuffer>& buffers, uint64_t* outStaleSlots) {
+    ATRACE_CALL();
+
+    if (outStaleSlots == NULL) {
         return BAD_VALUE;
     }
+    *outStaleSlots = 0;
 
+    size_t released = 0;
+    status_t result = NO_ERROR;
     sp<IProducerListener> listener;
     { // Autolock scope
         Mutex::Autolock lock(mCore->mMutex);
 
-        // If the frame number has changed because the buffer has been reallocated,
-        // we can ignore this releaseBuffer for the old buffer
-        if (frameNumber != mSlots[slot].mFrameNumber) {
-            return STALE_BUFFER_SLOT;
-        }
-
-        // Make sure this buffer hasn't been queued while acquired by the consumer
-        BufferQueueCore::Fifo::iterator current(mCore->mQueue.begin());
-        while (current != mCore->mQueue.end()) {
-            if (current->mSlot == slot) {
-                BQ_LOGE("releaseBuffer: buffer slot %d pending release is "
-                        "currently queued", slot);
-                return BAD_VALUE;
+        for (size_t i = 0; i < buffers.size(); i++) {
+            const ReleasedBuffer& buffer(buffers[i]);
+            status_t err = releaseBufferLocked(buffer.mBuf,
+                    buffer.mFrameNumber, buffer.mFence, EGL_NO_DISPLAY,
+                    EGL_NO_SYNC_KHR);
+            if (err == NO_ERROR) {
+                released++;
+            } else if (err == STALE_BUFFER_SLOT) {
+                *outStaleSlots |= 1ULL << buffer.mBuf;
+            } else if (result == NO_ERROR) {
+                result = err;
             }
-            ++current;
         }
 
-        if (mSlots[slot].mBufferState == BufferSlot::ACQUIRED) {
-            mSlots[slot].mEglDisplay = eglDisplay;
-            mSlots[slot].mEglFence = eglFence;
-            mSlots[slot].mFence = releaseFence;
-            mSlots[slot].mBufferState = BufferSlot::FREE;
+        if (released > 0) {
             listener = mCore->mConnectedProducerListener;
-            BQ_LOGV("releaseBuffer: releasing slot %d", slot);
-        } else if (mSlots[slot].mNeedsCleanupOnRelease) {
-            BQ_LOGV("releaseBuffer: releasing a stale buffer slot %d "
-                    "(state = %d)", slot, mSlots[slot].mBufferState);
-            mSlots[slot].mNeedsCleanupOnRelease = false;
-            return STALE_BUFFER_SLOT;
-        } else {
-            BQ_LOGV("releaseBuffer: attempted to release buffer slot %d "
-                    "but its state was %d", slot, mSlots[slot].mBufferState);
-            return BAD_VALUE;
+            mCore->mDequeueCondition.broadcast();
         }
-
-        mCore->mDequeueCondition.broadcast();
     } // Autolock scope
 
-    // Call back without lock held
+    mCore->recordGpuTimes();
+
+    // Call back without lock held, once per buffer as if they had been
+    // released one by one
     if (listener != NULL) {
-        listener->onBufferReleased();
+        for (size_t i = 0; i < released; i++) {
+            listener->onBufferReleased();
+        }
+    }
+
+    return result;
+}
+
+status_t BufferQueueConsumer::releaseBufferLocked(int slot,
+        uint64_t frameNumber, const sp<Fence>& releaseFence,
+        EGLDisplay eglDisplay, EGLSyncKHR eglFence) {
+    if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS ||
+            releaseFence == NULL) {
+        return BAD_VALUE;
+    }
+
+    // If the frame number has changed because the buffer has been reallocated,
+    // we can ignore this releaseBuffer for the old buffer
+    if (frameNumber != mSlots[slot].mFrameNumber) {
+        return STALE_BUFFER_SLOT;
+    }
+
+    // Make sure this buffer hasn't been queued while acquired by the consumer
+    BufferQueueCore::Fifo::iterator current(mCore->mQueue.begin());
+    while (current != mCore->mQueue.end()) {
+        if (current->mSlot == slot) {
+            BQ_LOGE("releaseBuffer: buffer slot %d pending release is "
+                    "currently queued", slot);
+            return BAD_VALUE;
+        }
+        ++current;
+    }
+
+    if (mSlots[slot].mBufferState == BufferSlot::ACQUIRED) {
+        mSlots[slot].mEglDisplay = eglDisplay;
+        mSlots[slot].mEglFence = eglFence;
+        mSlots[slot].mFence = releaseFence;
+        mCore->setBufferStateLocked(slot, BufferSlot::FREE);
+        mCore->recordReleaseLocked(slot);
+        BQ_LOGV("releaseBuffer: releasing slot %d", slot);
+    } else if (mSlots[slot].mNeedsCleanupOnRelease) {
+        BQ_LOGV("releaseBuffer: releasing a stale buffer slot %d "
+                "(state = %d)", slot, mSlots[slot].mBufferState);
+        mSlots[slot].mNeedsCleanupOnRelease = false;
+        return STALE_BUFFER_SLOT;
+    } else {
+        BQ_LOGV("releaseBuffer: attempted to release buffer slot %d "
+                "but its state was %d", slot, mSlots[slot].mBufferState);
+        return BAD_VALUE;
     }
 
     return NO_ERROR;
@@ -365,18 +481,29 @@ status_t BufferQueueConsumer::disconnect() {
 
     BQ_LOGV("disconnect(C)");
 
-    Mutex::Autolock lock(mCore->mMutex);
+    sp<BufferQueueControlServer> controlServer;
+    { // Autolock scope
+        Mutex::Autolock lock(mCore->mMutex);
 
-    if (mCore->mConsumerListener == NULL) {
-        BQ_LOGE("disconnect(C): no consumer is connected");
-        return BAD_VALUE;
-    }
+        if (mCore->mConsumerListener == NULL) {
+            BQ_LOGE("disconnect(C): no consumer is connected");
+            return BAD_VALUE;
+        }
 
-    mCore->mIsAbandoned = true;
-    mCore->mConsumerListener = NULL;
-    mCore->mQueue.clear();
-    mCore->freeAllBuffersLocked();
-    mCore->mDequeueCondition.broadcast();
+        mCore->mIsAbandoned = true;
+        mCore->mConsumerListener = NULL;
+        mCore->mQueue.clear();
+        mCore->freeAllBuffersLocked();
+        mCore->mDequeueCondition.broadcast();
+        controlServer = mCore->mControlServer;
+        mCore->mControlServer.clear();
+    } // Autolock scope
+
+    // The control thread may be blocked in dequeueBuffer, which returns
+    // now that the BufferQueue is abandoned, so stop it without the lock.
+    if (controlServer != NULL) {
+        controlServer->stop();
+    }
     return NO_ERROR;
 }
 
@@ -431,15 +558,26 @@ status_t BufferQueueConsumer::setDefaultBufferSize(uint32_t width,
     BQ_LOGV("setDefaultBufferSize: width=%u height=%u", width, height);
 
     Mutex::Autolock lock(mCore->mMutex);
+    const bool changed = mCore->mDefaultWidth != static_cast<int>(width) ||
+            mCore->mDefaultHeight != static_cast<int>(height);
     mCore->mDefaultWidth = width;
     mCore->mDefaultHeight = height;
+    if (changed) {
+        mCore->scheduleReallocationLocked();
+    }
     return NO_ERROR;
 }
 
 status_t BufferQueueConsumer::setDefaultMaxBufferCount(int bufferCount) {
     ATRACE_CALL();
     Mutex::Autolock lock(mCore->mMutex);
-    return mCore->setDefaultMaxBufferCountLocked(bufferCount);
+    status_t result = mCore->setDefaultMaxBufferCountLocked(bufferCount);
+    if (result == NO_ERROR) {
+        // Don't wait for the producer's next dequeue to drop the buffers
+        // that no longer fit; it may not come for a long time.
+        mCore->freeBuffersBeyondMaxCountLocked();
+    }
+    return result;
 }
 
 status_t BufferQueueConsumer::disableAsyncBuffer() {
@@ -492,7 +630,11 @@ status_t BufferQueueConsumer::setDefaultBufferFormat(uint32_t defaultFormat) {
     ATRACE_CALL();
     BQ_LOGV("setDefaultBufferFormat: %u", defaultFormat);
     Mutex::Autolock lock(mCore->mMutex);
+    const bool changed = mCore->mDefaultBufferFormat != defaultFormat;
     mCore->mDefaultBufferFormat = defaultFormat;
+    if (changed) {
+        mCore->scheduleReallocationLocked();
+    }
     return NO_ERROR;
 }
 
@@ -512,6 +654,14 @@ status_t BufferQueueConsumer::setTransformHint(uint32_t hint) {
     return NO_ERROR;
 }
 
+status_t BufferQueueConsumer::setDropLateFrames(bool enabled) {
+    ATRACE_CALL();
+    BQ_LOGV("setDropLateFrames: %d", enabled);
+    Mutex::Autolock lock(mCore->mMutex);
+    mCore->mDropLateFrames = enabled;
+    return NO_ERROR;
+}
+
 sp<NativeHandle> BufferQueueConsumer::getSidebandStream() const {
     return mCore->mSidebandStream;
 }
@@ -520,4 +670,9 @@ void BufferQueueConsumer::dump(String8& result, const char* prefix) const {
     mCore->dump(result, prefix);
 }
 
+void BufferQueueConsumer::dumpLatencyStats(String8& result, bool clear) {
+    Mutex::Autolock lock(mCore->mMutex);
+    mCore->dumpLatencyStatsLocked(result, clear);
+}
+
 } // namespace android
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BufferQueueControl"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+//#define LOG_NDEBUG 0
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <binder/IBinder.h>
+
+#include <cutils/ashmem.h>
+#include <cutils/atomic.h>
+
+#include <gui/IGraphicBufferProducer.h>
+
+#include <private/gui/BufferQueueControl.h>
+
+#include <ui/Fence.h>
+
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+namespace android {
+
+// How long a waiter sleeps before checking whether the other end is gone
+static const long kWaitTimeoutNs = 500000000; // 500ms
+
+// The control block is mapped by two processes, so these are deliberately
+// not FUTEX_PRIVATE.
+static int futexWait(volatile int32_t* addr, int32_t value, long timeoutNs) {
+    struct timespec ts;
+    ts.tv_sec = timeoutNs / 1000000000;
+    ts.tv_nsec = timeoutNs % 1000000000;
+    return syscall(__NR_futex, addr, FUTEX_WAIT, value, &ts, NULL, 0);
+}
+
+static void futexWake(volatile int32_t* addr) {
+    syscall(__NR_futex, addr, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+static buffer_queue_control_t* mapControl(int fd) {
+    void* base = mmap(NULL, sizeof(buffer_queue_control_t),
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return base == MAP_FAILED ? NULL :
+            static_cast<buffer_queue_control_t*>(base);
+}
+
+// ----------------------------------------------------------------------------
+
+BufferQueueControlServer::BufferQueueControlServer(
+        const wp<IGraphicBufferProducer>& producer) :
+    Thread(false),
+    mProducer(producer),
+    mFd(-1),
+    mControl(NULL),
+    mLastRequestSeq(0)
+{
+    mFd = ashmem_create_region("BufferQueueControl",
+            sizeof(buffer_queue_control_t));
+    if (mFd < 0) {
+        ALOGE("can't create control block: %s", strerror(errno));
+        return;
+    }
+    mControl = mapControl(mFd);
+    if (mControl == NULL) {
+        ALOGE("can't map control block: %s", strerror(errno));
+        close(mFd);
+        mFd = -1;
+        return;
+    }
+    memset(mControl, 0, sizeof(buffer_queue_control_t));
+    mControl->version = buffer_queue_control_t::VERSION;
+}
+
+BufferQueueControlServer::~BufferQueueControlServer() {
+    if (mControl != NULL) {
+        munmap(mControl, sizeof(buffer_queue_control_t));
+    }
+    if (mFd >= 0) {
+        close(mFd);
+    }
+}
+
+status_t BufferQueueControlServer::initCheck() const {
+    return mControl != NULL ? NO_ERROR : NO_INIT;
+}
+
+void BufferQueueControlServer::stop() {
+    requestExit();
+    if (mControl != NULL) {
+        android_atomic_release_store(1, &mControl->closed);
+        futexWake(&mControl->responseSeq);
+        futexWake(&mControl->requestSeq);
+    }
+}
+
+bool BufferQueueControlServer::threadLoop() {
+    const int32_t seq = android_atomic_acquire_load(&mControl->requestSeq);
+    if (seq == mLastRequestSeq) {
+        futexWait(&mControl->requestSeq, seq, kWaitTimeoutNs);
+        return !exitPending();
+    }
+    mLastRequestSeq = seq;
+    serve();
+    android_atomic_release_store(seq, &mControl->responseSeq);
+    futexWake(&mControl->responseSeq);
+    return !exitPending();
+}
+
+void BufferQueueControlServer::serve() {
+    ATRACE_CALL();
+    buffer_queue_control_t* c = mControl;
+    sp<IGraphicBufferProducer> producer(mProducer.promote());
+    if (producer == NULL) {
+        // The producer is gone without stopping us; nothing left to serve.
+        c->status = NO_INIT;
+        stop();
+        return;
+    }
+
+    switch (c->op) {
+        case buffer_queue_control_t::OP_DEQUEUE: {
+            int slot = -1;
+            sp<Fence> fence;
+            c->status = producer->dequeueBuffer(&slot, &fence, c->async,
+                    c->width, c->height, c->format, c->usage);
+            c->outSlot = slot;
+            // The fence can't be passed back, so wait for it here
+            if (c->status >= 0 && fence != NULL && fence->isValid()) {
+                fence->waitForever("BufferQueueControl::dequeueBuffer");
+            }
+            break;
+        }
+        case buffer_queue_control_t::OP_QUEUE: {
+            IGraphicBufferProducer::QueueBufferInput input(c->timestamp,
+                    c->isAutoTimestamp, c->crop, c->scalingMode, c->transform,
+                    c->async, Fence::NO_FENCE, c->stickyTransform);
+            input.setSurfaceDamage(c->surfaceDamage);
+            IGraphicBufferProducer::QueueBufferOutput output;
+            c->status = producer->queueBuffer(c->slot, input, &output);
+            output.deflate(&c->outWidth, &c->outHeight,
+                    &c->outTransformHint, &c->outNumPendingBuffers);
+            break;
+        }
+        case buffer_queue_control_t::OP_CANCEL:
+            producer->cancelBuffer(c->slot, Fence::NO_FENCE);
+            c->status = NO_ERROR;
+            break;
+        default:
+            ALOGE("unknown control op %d", c->op);
+            c->status = BAD_VALUE;
+            break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+BufferQueueControlClient::BufferQueueControlClient(int fd,
+        const sp<IBinder>& binder) :
+    mFd(fd),
+    mControl(NULL),
+    mBinder(binder),
+    mDead(false)
+{
+    mControl = mapControl(mFd);
+    if (mControl != NULL &&
+            mControl->version != buffer_queue_control_t::VERSION) {
+        ALOGE("control block version %u, expected %u", mControl->version,
+                buffer_queue_control_t::VERSION);
+        munmap(mControl, sizeof(buffer_queue_control_t));
+        mControl = NULL;
+    }
+}
+
+BufferQueueControlClient::~BufferQueueControlClient() {
+    if (mControl != NULL) {
+        munmap(mControl, sizeof(buffer_queue_control_t));
+    }
+    if (mFd >= 0) {
+        close(mFd);
+    }
+}
+
+status_t BufferQueueControlClient::initCheck() const {
+    return mControl != NULL ? NO_ERROR : NO_INIT;
+}
+
+bool BufferQueueControlClient::transactLocked() {
+    ATRACE_CALL();
+    const int32_t seq = mControl->requestSeq + 1;
+    android_atomic_release_store(seq, &mControl->requestSeq);
+    futexWake(&mControl->requestSeq);
+
+    while (true) {
+        const int32_t response =
+                android_atomic_acquire_load(&mControl->responseSeq);
+        if (response == seq) {
+            return true;
+        }
+        if (android_atomic_acquire_load(&mControl->closed)) {
+            mDead = true;
+            return false;
+        }
+        if (futexWait(&mControl->responseSeq, response, kWaitTimeoutNs) &&
+                errno == ETIMEDOUT) {
+            sp<IBinder> binder(mBinder.promote());
+            if (binder == NULL || !binder->isBinderAlive()) {
+                mDead = true;
+                return false;
+            }
+        }
+    }
+}
+
+bool BufferQueueControlClient::dequeueBuffer(int* outSlot, bool async,
+        uint32_t width, uint32_t height, uint32_t format, uint32_t usage,
+        status_t* outResult) {
+    // Never queue up behind another call: a blocked dequeueBuffer could
+    // be waiting on the very buffer another thread is about to queue.
+    if (mMutex.tryLock() != NO_ERROR) {
+        return false;
+    }
+    bool handled = false;
+    if (!mDead) {
+        mControl->op = buffer_queue_control_t::OP_DEQUEUE;
+        mControl->async = async;
+        mControl->width = width;
+        mControl->height = height;
+        mControl->format = format;
+        mControl->usage = usage;
+        if (transactLocked()) {
+            *outSlot = mControl->outSlot;
+            *outResult = mControl->status;
+            handled = true;
+        }
+    }
+    mMutex.unlock();
+    return handled;
+}
+
+bool BufferQueueControlClient::queueBuffer(int slot, int64_t timestamp,
+        bool isAutoTimestamp, const Rect& crop, int scalingMode,
+        uint32_t transform, uint32_t stickyTransform, bool async,
+        const Rect& surfaceDamage, uint32_t* outWidth, uint32_t* outHeight,
+        uint32_t* outTransformHint, uint32_t* outNumPendingBuffers,
+        status_t* outResult) {
+    if (mMutex.tryLock() != NO_ERROR) {
+        return false;
+    }
+    bool handled = false;
+    if (!mDead) {
+        mControl->op = buffer_queue_control_t::OP_QUEUE;
+        mControl->slot = slot;
+        mControl->timestamp = timestamp;
+        mControl->isAutoTimestamp = isAutoTimestamp;
+        mControl->crop = crop;
+        mControl->scalingMode = scalingMode;
+        mControl->transform = transform;
+        mControl->stickyTransform = stickyTransform;
+        mControl->async = async;
+        mControl->surfaceDamage = surfaceDamage;
+        if (transactLocked()) {
+            *outWidth = mControl->outWidth;
+            *outHeight = mControl->outHeight;
+            *outTransformHint = mControl->outTransformHint;
+            *outNumPendingBuffers = mControl->outNumPendingBuffers;
+            *outResult = mControl->status;
+            handled = true;
+        }
+    }
+    mMutex.unlock();
+    return handled;
+}
+
+bool BufferQueueControlClient::cancelBuffer(int slot) {
+    if (mMutex.tryLock() != NO_ERROR) {
+        return false;
+    }
+    bool handled = false;
+    if (!mDead) {
+        mControl->op = buffer_queue_control_t::OP_CANCEL;
+        mControl->slot = slot;
+        handled = transactLocked();
+    }
+    mMutex.unlock();
+    return handled;
+}
+
+}; // namespace android
@@ -21,6 +21,7 @@
 #define EGL_EGLEXT_PROTOTYPES
 
 #include <inttypes.h>
+#include <string.h>
 
 #include <gui/BufferItem.h>
 #include <gui/BufferQueueCore.h>
@@ -28,13 +29,30 @@
 #include <gui/IGraphicBufferAlloc.h>
 #include <gui/IProducerListener.h>
 #include <gui/ISurfaceComposer.h>
+#include <private/gui/BufferQueueControl.h>
 #include <private/gui/ComposerService.h>
 
+#include <ui/GraphicBuffer.h>
+
 template <typename T>
 static inline T max(T a, T b) { return a > b ? a : b; }
 
 namespace android {
 
+class BufferQueueCore::ReallocationThread : public Thread {
+public:
+    ReallocationThread(const sp<BufferQueueCore>& core) :
+        Thread(false), mCore(core) {}
+
+private:
+    virtual bool threadLoop() {
+        mCore->reallocateBuffers();
+        return false;
+    }
+
+    sp<BufferQueueCore> mCore;
+};
+
 static String8 getUniqueName() {
     static volatile int32_t counter = 0;
     return String8::format("unnamed-%d-%d", getpid(),
@@ -65,8 +83,20 @@ BufferQueueCore::BufferQueueCore(const sp<IGraphicBufferAlloc>& allocator) :
     mBufferHasBeenQueued(false),
     mFrameCounter(0),
     mTransformHint(0),
+    mDropLateFrames(false),
     mIsAllocating(false),
-    mIsAllocatingCondition()
+    mIsAllocatingCondition(),
+    mFreeSlots(~0ULL),
+    mDequeuedSlots(0),
+    mAcquiredSlots(0),
+    mProducerUsesDefaultSize(false),
+    mProducerFormat(0),
+    mProducerUsage(0),
+    mProducerAsync(false),
+    mFreedBeyondMaxCount(false),
+    mIsReallocating(false),
+    mReallocationPending(false),
+    mDroppedFrames(0)
 {
     if (allocator == NULL) {
         sp<ISurfaceComposer> composer(ComposerService::getComposerService());
@@ -193,7 +223,7 @@ void BufferQueueCore::freeBufferLocked(int slot) {
     if (mSlots[slot].mBufferState == BufferSlot::ACQUIRED) {
         mSlots[slot].mNeedsCleanupOnRelease = true;
     }
-    mSlots[slot].mBufferState = BufferSlot::FREE;
+    setBufferStateLocked(slot, BufferSlot::FREE);
     mSlots[slot].mFrameNumber = UINT32_MAX;
     mSlots[slot].mAcquireCalled = false;
 
@@ -205,6 +235,21 @@ void BufferQueueCore::freeBufferLocked(int slot) {
     mSlots[slot].mFence = Fence::NO_FENCE;
 }
 
+void BufferQueueCore::freeBuffersBeyondMaxCountLocked() {
+    if (mIsAllocating || mIsReallocating) {
+        return;
+    }
+    const int maxBufferCount = getMaxBufferCountLocked(mProducerAsync);
+    for (int s = maxBufferCount; s < BufferQueueDefs::NUM_BUFFER_SLOTS; ++s) {
+        if (mSlots[s].mBufferState == BufferSlot::FREE &&
+                mSlots[s].mGraphicBuffer != NULL) {
+            BQ_LOGV("freeBuffersBeyondMaxCountLocked: freeing slot %d", s);
+            freeBufferLocked(s);
+            mFreedBeyondMaxCount = true;
+        }
+    }
+}
+
 void BufferQueueCore::freeAllBuffersLocked() {
     mBufferHasBeenQueued = false;
     for (int s = 0; s < BufferQueueDefs::NUM_BUFFER_SLOTS; ++s) {
@@ -230,9 +275,318 @@ bool BufferQueueCore::stillTracking(const BufferItem* item) const {
 
 void BufferQueueCore::waitWhileAllocatingLocked() const {
     ATRACE_CALL();
-    while (mIsAllocating) {
+    while (mIsAllocating || mIsReallocating) {
         mIsAllocatingCondition.wait(mMutex);
     }
 }
 
+static inline uint64_t slotsBelow(int maxBufferCount) {
+    return maxBufferCount >= BufferQueueDefs::NUM_BUFFER_SLOTS ?
+            ~0ULL : (1ULL << maxBufferCount) - 1;
+}
+
+void BufferQueueCore::setBufferStateLocked(int slot,
+        BufferSlot::BufferState state) {
+    const uint64_t bit = 1ULL << slot;
+    mFreeSlots &= ~bit;
+    mDequeuedSlots &= ~bit;
+    mAcquiredSlots &= ~bit;
+    switch (state) {
+        case BufferSlot::FREE:
+            mFreeSlots |= bit;
+            break;
+        case BufferSlot::DEQUEUED:
+            mDequeuedSlots |= bit;
+            break;
+        case BufferSlot::ACQUIRED:
+            mAcquiredSlots |= bit;
+            break;
+        default:
+            break;
+    }
+    mSlots[slot].mBufferState = state;
+}
+
+int BufferQueueCore::countSlotsLocked(BufferSlot::BufferState state,
+        int maxBufferCount) const {
+    uint64_t slots = 0;
+    switch (state) {
+        case BufferSlot::FREE:
+            slots = mFreeSlots;
+            break;
+        case BufferSlot::DEQUEUED:
+            slots = mDequeuedSlots;
+            break;
+        case BufferSlot::ACQUIRED:
+            slots = mAcquiredSlots;
+            break;
+        default:
+            break;
+    }
+    return __builtin_popcountll(slots & slotsBelow(maxBufferCount));
+}
+
+int BufferQueueCore::findOldestFreeSlotLocked(int maxBufferCount) const {
+    int found = INVALID_BUFFER_SLOT;
+    uint64_t slots = mFreeSlots & slotsBelow(maxBufferCount);
+    while (slots) {
+        const int s = __builtin_ctzll(slots);
+        slots &= slots - 1;
+        // We return the oldest of the free buffers to avoid stalling the
+        // producer if possible, since the consumer may still have pending
+        // reads of in-flight buffers
+        if (found == INVALID_BUFFER_SLOT ||
+                mSlots[s].mFrameNumber < mSlots[found].mFrameNumber) {
+            found = s;
+        }
+    }
+    return found;
+}
+
+void BufferQueueCore::LatencyHistogram::clear() {
+    count = 0;
+    total = 0;
+    max = 0;
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void BufferQueueCore::LatencyHistogram::add(nsecs_t duration) {
+    if (duration < 0) {
+        return;
+    }
+    const uint64_t us = duration / 1000;
+    size_t bucket = us ? 64 - __builtin_clzll(us) : 0;
+    if (bucket >= BUCKET_COUNT) {
+        bucket = BUCKET_COUNT - 1;
+    }
+    buckets[bucket]++;
+    count++;
+    total += duration;
+    if (duration > max) {
+        max = duration;
+    }
+}
+
+nsecs_t BufferQueueCore::LatencyHistogram::percentile(uint32_t percent) const {
+    // Returns the upper bound of the bucket holding the percentile
+    const uint64_t target = (uint64_t(count) * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKET_COUNT; b++) {
+        seen += buckets[b];
+        if (seen >= target) {
+            return b < BUCKET_COUNT - 1 ? nsecs_t(1000) << b : max;
+        }
+    }
+    return max;
+}
+
+void BufferQueueCore::LatencyHistogram::dump(String8& result,
+        const char* name) const {
+    if (count == 0) {
+        result.appendFormat("  %-12s       0\n", name);
+        return;
+    }
+    result.appendFormat("  %-12s %7u avg=%7.2f p50<=%7.2f p90<=%7.2f "
+            "p99<=%7.2f max=%7.2f ms\n", name, count,
+            ns2us(total / count) / 1000.0,
+            ns2us(percentile(50)) / 1000.0,
+            ns2us(percentile(90)) / 1000.0,
+            ns2us(percentile(99)) / 1000.0,
+            ns2us(max) / 1000.0);
+}
+
+void BufferQueueCore::recordDequeueLocked(int slot, nsecs_t dequeueStart) {
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    mDequeueWaitTime.add(now - dequeueStart);
+    mFrameTimes[slot] = FrameTimes();
+    mFrameTimes[slot].dequeueTime = now;
+}
+
+void BufferQueueCore::recordQueueLocked(int slot, const sp<Fence>& fence) {
+    FrameTimes& times(mFrameTimes[slot]);
+    times.queueTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    times.acquireTime = 0;
+    times.fence = fence;
+    if (times.dequeueTime) {
+        mProducerTime.add(times.queueTime - times.dequeueTime);
+    }
+}
+
+void BufferQueueCore::recordAcquireLocked(int slot) {
+    FrameTimes& times(mFrameTimes[slot]);
+    times.acquireTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (times.queueTime) {
+        mQueuedTime.add(times.acquireTime - times.queueTime);
+    }
+}
+
+void BufferQueueCore::recordDropLocked(int slot) {
+    mDroppedFrames++;
+    mFrameTimes[slot] = FrameTimes();
+}
+
+void BufferQueueCore::recordReleaseLocked(int slot) {
+    FrameTimes& times(mFrameTimes[slot]);
+    if (times.acquireTime) {
+        mConsumerTime.add(systemTime(SYSTEM_TIME_MONOTONIC) -
+                times.acquireTime);
+    }
+    if (times.queueTime && times.fence != NULL && times.fence->isValid()) {
+        Mutex::Autolock lock(mGpuTimeLock);
+        mReleasedFrames.push_back(times);
+    }
+    mFrameTimes[slot] = FrameTimes();
+}
+
+void BufferQueueCore::recordGpuTimes() {
+    Vector<FrameTimes> frames;
+    {
+        Mutex::Autolock lock(mGpuTimeLock);
+        if (mReleasedFrames.isEmpty()) {
+            return;
+        }
+        frames = mReleasedFrames;
+        mReleasedFrames.clear();
+    }
+
+    // By now the consumer has waited for the acquire fence, so it has
+    // usually signaled; frames whose fence is still pending are skipped.
+    Vector<nsecs_t> durations;
+    durations.setCapacity(frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        const nsecs_t signalTime = frames[i].fence->getSignalTime();
+        if (signalTime != INT64_MAX && signalTime > 0) {
+            durations.push_back(
+                    max(signalTime - frames[i].queueTime, nsecs_t(0)));
+        }
+    }
+
+    Mutex::Autolock lock(mGpuTimeLock);
+    for (size_t i = 0; i < durations.size(); i++) {
+        mGpuTime.add(durations[i]);
+    }
+}
+
+void BufferQueueCore::dumpLatencyStatsLocked(String8& result, bool clear) {
+    result.appendFormat("%s: %u dropped\n", mConsumerName.string(),
+            mDroppedFrames);
+    mDequeueWaitTime.dump(result, "dequeue-wait");
+    mProducerTime.dump(result, "producer");
+    mGpuTimeLock.lock();
+    mGpuTime.dump(result, "gpu");
+    mGpuTimeLock.unlock();
+    mQueuedTime.dump(result, "queued");
+    mConsumerTime.dump(result, "consumer");
+    if (clear) {
+        mDequeueWaitTime.clear();
+        mProducerTime.clear();
+        mGpuTimeLock.lock();
+        mGpuTime.clear();
+        mGpuTimeLock.unlock();
+        mQueuedTime.clear();
+        mConsumerTime.clear();
+        mDroppedFrames = 0;
+    }
+}
+
+void BufferQueueCore::scheduleReallocationLocked() {
+    if (mIsAbandoned || mConnectedApi == NO_CONNECTED_API ||
+            !mProducerUsesDefaultSize || mAllocator == NULL) {
+        return;
+    }
+
+    if (mIsReallocating) {
+        mReallocationPending = true;
+        return;
+    }
+
+    sp<Thread> thread(new ReallocationThread(this));
+    if (thread->run("BufferQueueRealloc") == NO_ERROR) {
+        mIsReallocating = true;
+    }
+}
+
+void BufferQueueCore::reallocateBuffers() {
+    ATRACE_CALL();
+    sp<GraphicBuffer> oldBuffer;
+    mMutex.lock();
+    while (true) {
+        mReallocationPending = false;
+        if (mIsAbandoned || mConnectedApi == NO_CONNECTED_API) {
+            break;
+        }
+
+        const uint32_t width = mDefaultWidth;
+        const uint32_t height = mDefaultHeight;
+        const uint32_t format = mProducerFormat != 0 ?
+                mProducerFormat : mDefaultBufferFormat;
+        const uint32_t usage = mProducerUsage | mConsumerUsageBits;
+
+        // Find a FREE slot whose buffer dequeueBuffer would reject
+        int found = INVALID_BUFFER_SLOT;
+        if (mProducerUsesDefaultSize) {
+            for (int s = 0; s < BufferQueueDefs::NUM_BUFFER_SLOTS; ++s) {
+                const sp<GraphicBuffer>& buffer(mSlots[s].mGraphicBuffer);
+                if (mSlots[s].mBufferState == BufferSlot::FREE &&
+                        buffer != NULL &&
+                        ((static_cast<uint32_t>(buffer->width) != width) ||
+                         (static_cast<uint32_t>(buffer->height) != height) ||
+                         (static_cast<uint32_t>(buffer->format) != format) ||
+                         ((static_cast<uint32_t>(buffer->usage) & usage) != usage))) {
+                    found = s;
+                    break;
+                }
+            }
+        }
+        if (found == INVALID_BUFFER_SLOT) {
+            break;
+        }
+
+        oldBuffer = mSlots[found].mGraphicBuffer;
+        mMutex.unlock();
+        status_t error = NO_ERROR;
+        sp<GraphicBuffer> graphicBuffer(mAllocator->createGraphicBuffer(
+                width, height, format, usage, &error));
+        oldBuffer.clear();
+        mMutex.lock();
+
+        if (graphicBuffer == NULL) {
+            BQ_LOGE("reallocateBuffers: createGraphicBuffer failed (%d)",
+                    error);
+            break;
+        }
+
+        // The producer may have dequeued the slot, or the defaults may have
+        // changed again, while we weren't holding the lock; if so, drop this
+        // buffer and re-evaluate.
+        if (mSlots[found].mBufferState != BufferSlot::FREE ||
+                mSlots[found].mGraphicBuffer.get() == NULL ||
+                static_cast<uint32_t>(mDefaultWidth) != width ||
+                static_cast<uint32_t>(mDefaultHeight) != height ||
+                (mProducerFormat != 0 ?
+                        mProducerFormat : mDefaultBufferFormat) != format ||
+                (mProducerUsage | mConsumerUsageBits) != usage) {
+            BQ_LOGV("reallocateBuffers: slot %d changed while allocating",
+                    found);
+            continue;
+        }
+
+        oldBuffer = mSlots[found].mGraphicBuffer;
+        freeBufferLocked(found);
+        mSlots[found].mGraphicBuffer = graphicBuffer;
+        mSlots[found].mRequestBufferCalled = false;
+        // Make this the first FREE slot handed out by dequeueBuffer
+        mSlots[found].mFrameNumber = 0;
+        BQ_LOGV("reallocateBuffers: reallocated slot %d", found);
+
+        // Release the old buffer outside of the lock
+        mMutex.unlock();
+        oldBuffer.clear();
+        mMutex.lock();
+    }
+    mIsReallocating = false;
+    mIsAllocatingCondition.broadcast();
+    mMutex.unlock();
+}
+
 } // namespace android
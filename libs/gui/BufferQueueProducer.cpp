@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <inttypes.h>
+#include <unistd.h>
 
 #define LOG_TAG "BufferQueueProducer"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
@@ -29,6 +31,8 @@
 #include <gui/IGraphicBufferAlloc.h>
 #include <gui/IProducerListener.h>
 
+#include <private/gui/BufferQueueControl.h>
+
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
@@ -40,7 +44,19 @@ BufferQueueProducer::BufferQueueProducer(const sp<BufferQueueCore>& core) :
     mConsumerName(),
     mStickyTransform(0) {}
 
-BufferQueueProducer::~BufferQueueProducer() {}
+BufferQueueProducer::~BufferQueueProducer() {
+    // The control thread only holds a weak reference to us, so it would
+    // otherwise keep running, answering NO_INIT, until the core goes away.
+    sp<BufferQueueControlServer> controlServer;
+    { // Autolock scope
+        Mutex::Autolock lock(mCore->mMutex);
+        controlServer = mCore->mControlServer;
+        mCore->mControlServer.clear();
+    }
+    if (controlServer != NULL) {
+        controlServer->stop();
+    }
+}
 
 status_t BufferQueueProducer::requestBuffer(int slot, sp<GraphicBuffer>* buf) {
     ATRACE_CALL();
@@ -88,11 +104,9 @@ status_t BufferQueueProducer::setBufferCount(int bufferCount) {
         }
 
         // There must be no dequeued buffers when changing the buffer count.
-        for (int s = 0; s < BufferQueueDefs::NUM_BUFFER_SLOTS; ++s) {
-            if (mSlots[s].mBufferState == BufferSlot::DEQUEUED) {
-                BQ_LOGE("setBufferCount: buffer owned by producer");
-                return BAD_VALUE;
-            }
+        if (mCore->mDequeuedSlots != 0) {
+            BQ_LOGE("setBufferCount: buffer owned by producer");
+            return BAD_VALUE;
         }
 
         if (bufferCount == 0) {
@@ -155,32 +169,18 @@ status_t BufferQueueProducer::waitForFreeSlotThenRelock(const char* caller,
                 *returnFlags |= RELEASE_ALL_BUFFERS;
             }
         }
+        // The consumer may have freed some already when it lowered the count
+        if (mCore->mFreedBeyondMaxCount) {
+            mCore->mFreedBeyondMaxCount = false;
+            *returnFlags |= RELEASE_ALL_BUFFERS;
+        }
 
         // Look for a free buffer to give to the client
-        *found = BufferQueueCore::INVALID_BUFFER_SLOT;
-        int dequeuedCount = 0;
-        int acquiredCount = 0;
-        for (int s = 0; s < maxBufferCount; ++s) {
-            switch (mSlots[s].mBufferState) {
-                case BufferSlot::DEQUEUED:
-                    ++dequeuedCount;
-                    break;
-                case BufferSlot::ACQUIRED:
-                    ++acquiredCount;
-                    break;
-                case BufferSlot::FREE:
-                    // We return the oldest of the free buffers to avoid
-                    // stalling the producer if possible, since the consumer
-                    // may still have pending reads of in-flight buffers
-                    if (*found == BufferQueueCore::INVALID_BUFFER_SLOT ||
-                            mSlots[s].mFrameNumber < mSlots[*found].mFrameNumber) {
-                        *found = s;
-                    }
-                    break;
-                default:
-                    break;
-            }
-        }
+        *found = mCore->findOldestFreeSlotLocked(maxBufferCount);
+        const int dequeuedCount =
+                mCore->countSlotsLocked(BufferSlot::DEQUEUED, maxBufferCount);
+        const int acquiredCount =
+                mCore->countSlotsLocked(BufferSlot::ACQUIRED, maxBufferCount);
 
         // Producers are not allowed to dequeue more than one buffer if they
         // did not set a buffer count
@@ -247,11 +247,7 @@ status_t BufferQueueProducer::dequeueBuffer(int *outSlot,
         sp<android::Fence> *outFence, bool async,
         uint32_t width, uint32_t height, uint32_t format, uint32_t usage) {
     ATRACE_CALL();
-    { // Autolock scope
-        Mutex::Autolock lock(mCore->mMutex);
-        mConsumerName = mCore->mConsumerName;
-    } // Autolock scope
-
+    const nsecs_t dequeueStart = systemTime(SYSTEM_TIME_MONOTONIC);
     BQ_LOGV("dequeueBuffer: async=%s w=%u h=%u format=%#x, usage=%#x",
             async ? "true" : "false", width, height, format, usage);
 
@@ -264,11 +260,20 @@ status_t BufferQueueProducer::dequeueBuffer(int *outSlot,
     EGLDisplay eglDisplay = EGL_NO_DISPLAY;
     EGLSyncKHR eglFence = EGL_NO_SYNC_KHR;
     bool attachedByConsumer = false;
+    bool needsAllocation = false;
 
     { // Autolock scope
         Mutex::Autolock lock(mCore->mMutex);
+        mConsumerName = mCore->mConsumerName;
         mCore->waitWhileAllocatingLocked();
 
+        // Remember what the producer asks for, so that buffers can be
+        // reallocated ahead of time when the defaults change
+        mCore->mProducerUsesDefaultSize = !width && !height;
+        mCore->mProducerFormat = format;
+        mCore->mProducerUsage = usage;
+        mCore->mProducerAsync = async;
+
         if (format == 0) {
             format = mCore->mDefaultBufferFormat;
         }
@@ -302,7 +307,8 @@ status_t BufferQueueProducer::dequeueBuffer(int *outSlot,
             height = mCore->mDefaultHeight;
         }
 
-        mSlots[found].mBufferState = BufferSlot::DEQUEUED;
+        mCore->setBufferStateLocked(found, BufferSlot::DEQUEUED);
+        mCore->recordDequeueLocked(found, dequeueStart);
 
         const sp<GraphicBuffer>& buffer(mSlots[found].mGraphicBuffer);
         if ((buffer == NULL) ||
@@ -318,6 +324,12 @@ status_t BufferQueueProducer::dequeueBuffer(int *outSlot,
             mSlots[found].mEglFence = EGL_NO_SYNC_KHR;
             mSlots[found].mFence = Fence::NO_FENCE;
 
+            needsAllocation = true;
+            returnFlags |= BUFFER_NEEDS_REALLOCATION;
+        } else if (!mSlots[found].mRequestBufferCalled) {
+            // The buffer was allocated by allocateBuffers or by the
+            // reallocation thread; the producer has to request it, but it
+            // doesn't need to be allocated here.
             returnFlags |= BUFFER_NEEDS_REALLOCATION;
         }
 
@@ -334,7 +346,7 @@ status_t BufferQueueProducer::dequeueBuffer(int *outSlot,
         mSlots[found].mFence = Fence::NO_FENCE;
     } // Autolock scope
 
-    if (returnFlags & BUFFER_NEEDS_REALLOCATION) {
+    if (needsAllocation) {
         status_t error;
         BQ_LOGV("dequeueBuffer: allocating a new buffer for slot %d", *outSlot);
         sp<GraphicBuffer> graphicBuffer(mCore->mAllocator->createGraphicBuffer(
@@ -498,7 +510,8 @@ status_t BufferQueueProducer::attachBuffer(int* outSlot,
             *outSlot, returnFlags);
 
     mSlots[*outSlot].mGraphicBuffer = buffer;
-    mSlots[*outSlot].mBufferState = BufferSlot::DEQUEUED;
+    mCore->setBufferStateLocked(*outSlot, BufferSlot::DEQUEUED);
+    mCore->mFrameTimes[*outSlot] = BufferQueueCore::FrameTimes();
     mSlots[*outSlot].mEglFence = EGL_NO_SYNC_KHR;
     mSlots[*outSlot].mFence = Fence::NO_FENCE;
     mSlots[*outSlot].mRequestBufferCalled = true;
@@ -595,7 +608,8 @@ status_t BufferQueueProducer::queueBuffer(int slot,
         }
 
         mSlots[slot].mFence = fence;
-        mSlots[slot].mBufferState = BufferSlot::QUEUED;
+        mCore->setBufferStateLocked(slot, BufferSlot::QUEUED);
+        mCore->recordQueueLocked(slot, fence);
         ++mCore->mFrameCounter;
         mSlots[slot].mFrameNumber = mCore->mFrameCounter;
 
@@ -613,6 +627,10 @@ status_t BufferQueueProducer::queueBuffer(int slot,
         item.mSlot = slot;
         item.mFence = fence;
         item.mIsDroppable = mCore->mDequeueBufferCannotBlock || async;
+        item.mSurfaceDamage = input.getSurfaceDamage();
+        if (item.mSurfaceDamage.isValid()) {
+            item.mSurfaceDamage.intersect(bufferRect, &item.mSurfaceDamage);
+        }
 
         mStickyTransform = stickyTransform;
 
@@ -629,12 +647,16 @@ status_t BufferQueueProducer::queueBuffer(int slot,
                 // If the front queued buffer is still being tracked, we first
                 // mark it as freed
                 if (mCore->stillTracking(front)) {
-                    mSlots[front->mSlot].mBufferState = BufferSlot::FREE;
+                    mCore->setBufferStateLocked(front->mSlot,
+                            BufferSlot::FREE);
+                    mCore->recordDropLocked(front->mSlot);
                     // Reset the frame number of the freed buffer so that it is
                     // the first in line to be dequeued again
                     mSlots[front->mSlot].mFrameNumber = 0;
                 }
-                // Overwrite the droppable buffer with the incoming one
+                // Overwrite the droppable buffer with the incoming one, which
+                // then also has to carry the dropped one's damage
+                item.addOlderSurfaceDamage(front->mSurfaceDamage);
                 *front = item;
             } else {
                 mCore->mQueue.push_back(item);
@@ -682,7 +704,7 @@ void BufferQueueProducer::cancelBuffer(int slot, const sp<Fence>& fence) {
         return;
     }
 
-    mSlots[slot].mBufferState = BufferSlot::FREE;
+    mCore->setBufferStateLocked(slot, BufferSlot::FREE);
     mSlots[slot].mFrameNumber = 0;
     mSlots[slot].mFence = fence;
     mCore->mDequeueCondition.broadcast();
@@ -805,6 +827,7 @@ status_t BufferQueueProducer::disconnect(int api) {
 
     int status = NO_ERROR;
     sp<IConsumerListener> listener;
+    sp<BufferQueueControlServer> controlServer;
     { // Autolock scope
         Mutex::Autolock lock(mCore->mMutex);
         mCore->waitWhileAllocatingLocked();
@@ -835,8 +858,15 @@ status_t BufferQueueProducer::disconnect(int api) {
                     mCore->mConnectedProducerListener = NULL;
                     mCore->mConnectedApi = BufferQueueCore::NO_CONNECTED_API;
                     mCore->mSidebandStream.clear();
+                    mCore->mProducerUsesDefaultSize = false;
+                    mCore->mProducerFormat = 0;
+                    mCore->mProducerUsage = 0;
+                    mCore->mProducerAsync = false;
+                    mCore->mFreedBeyondMaxCount = false;
                     mCore->mDequeueCondition.broadcast();
                     listener = mCore->mConsumerListener;
+                    controlServer = mCore->mControlServer;
+                    mCore->mControlServer.clear();
                 } else {
                     BQ_LOGE("disconnect(P): connected to another API "
                             "(cur=%d req=%d)", mCore->mConnectedApi, api);
@@ -850,6 +880,12 @@ status_t BufferQueueProducer::disconnect(int api) {
         }
     } // Autolock scope
 
+    // The control thread may be blocked in dequeueBuffer, so it can only be
+    // stopped without the lock held; it exits once that call returns.
+    if (controlServer != NULL) {
+        controlServer->stop();
+    }
+
     // Call back without lock held
     if (listener != NULL) {
         listener->onBuffersReleased();
@@ -972,6 +1008,53 @@ void BufferQueueProducer::allocateBuffers(bool async, uint32_t width,
     }
 }
 
+status_t BufferQueueProducer::getControlChannel(int* outFd) {
+    ATRACE_CALL();
+    Mutex::Autolock lock(mCore->mMutex);
+
+    if (mCore->mIsAbandoned) {
+        BQ_LOGE("getControlChannel: BufferQueue has been abandoned");
+        return NO_INIT;
+    }
+
+    if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
+        BQ_LOGE("getControlChannel: no producer is connected");
+        return NO_INIT;
+    }
+
+    if (mCore->mControlServer == NULL) {
+        sp<BufferQueueControlServer> server(new BufferQueueControlServer(
+                wp<IGraphicBufferProducer>(this)));
+        status_t err = server->initCheck();
+        if (err == NO_ERROR) {
+            err = server->run("BufferQueueControl", PRIORITY_URGENT_DISPLAY);
+        }
+        if (err != NO_ERROR) {
+            BQ_LOGE("getControlChannel: can't start control thread (%d)", err);
+            return err;
+        }
+        mCore->mControlServer = server;
+    }
+
+    int fd = dup(mCore->mControlServer->getFd());
+    if (fd < 0) {
+        return -errno;
+    }
+    *outFd = fd;
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::attachAndQueueBuffer(int* outSlot,
+        const sp<GraphicBuffer>& buffer, const QueueBufferInput& input,
+        QueueBufferOutput* output) {
+    ATRACE_CALL();
+    status_t result = attachBuffer(outSlot, buffer);
+    if (result < 0) {
+        return result;
+    }
+    return queueBuffer(*outSlot, input, output);
+}
+
 void BufferQueueProducer::binderDied(const wp<android::IBinder>& /* who */) {
     // If we're here, it means that a producer we were connected to died.
     // We're guaranteed that we are still connected to it because we remove
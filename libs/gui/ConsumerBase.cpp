@@ -47,6 +47,59 @@
 
 namespace android {
 
+// Calls the FrameAvailableListener of a ConsumerBase for the frames posted
+// since the last call. It only holds a weak reference to the ConsumerBase,
+// and exits once that is gone or stop is called.
+class ConsumerBase::FrameDispatcher : public Thread {
+public:
+    FrameDispatcher(const wp<ConsumerBase>& consumer, bool coalesce) :
+        Thread(false), mConsumer(consumer), mCoalesce(coalesce),
+        mPendingFrames(0) {
+    }
+
+    void post() {
+        Mutex::Autolock lock(mMutex);
+        mPendingFrames++;
+        mCondition.signal();
+    }
+
+    void stop() {
+        requestExit();
+        Mutex::Autolock lock(mMutex);
+        mCondition.signal();
+    }
+
+private:
+    virtual bool threadLoop() {
+        uint32_t count;
+        { // scope for the lock
+            Mutex::Autolock lock(mMutex);
+            while (mPendingFrames == 0 && !exitPending()) {
+                mCondition.wait(mMutex);
+            }
+            if (exitPending()) {
+                return false;
+            }
+            count = mCoalesce ? 1 : mPendingFrames;
+            mPendingFrames = 0;
+        }
+
+        sp<ConsumerBase> consumer(mConsumer.promote());
+        if (consumer == NULL) {
+            return false;
+        }
+        consumer->dispatchFrameAvailable(count);
+        return true;
+    }
+
+    const wp<ConsumerBase> mConsumer;
+    const bool mCoalesce;
+
+    Mutex mMutex;
+    Condition mCondition;
+    uint32_t mPendingFrames;
+};
+
 // Get an ID that's unique within this process.
 static int32_t createProcessUniqueId() {
     static volatile int32_t globalCounter = 0;
@@ -95,6 +148,7 @@ void ConsumerBase::freeBufferLocked(int slotIndex) {
     CB_LOGV("freeBufferLocked: slotIndex=%d", slotIndex);
     mSlots[slotIndex].mGraphicBuffer = 0;
     mSlots[slotIndex].mFence = Fence::NO_FENCE;
+    mSlots[slotIndex].mReleaseFences.clear();
     mSlots[slotIndex].mFrameNumber = 0;
 }
 
@@ -102,17 +156,38 @@ void ConsumerBase::onFrameAvailable() {
     CB_LOGV("onFrameAvailable");
 
     sp<FrameAvailableListener> listener;
+    sp<FrameDispatcher> dispatcher;
     { // scope for the lock
         Mutex::Autolock lock(mMutex);
-        listener = mFrameAvailableListener.promote();
+        dispatcher = mFrameDispatcher;
+        if (dispatcher == NULL) {
+            listener = mFrameAvailableListener.promote();
+        }
     }
 
-    if (listener != NULL) {
+    if (dispatcher != NULL) {
+        dispatcher->post();
+    } else if (listener != NULL) {
         CB_LOGV("actually calling onFrameAvailable");
         listener->onFrameAvailable();
     }
 }
 
+void ConsumerBase::dispatchFrameAvailable(uint32_t count) {
+    sp<FrameAvailableListener> listener;
+    { // scope for the lock
+        Mutex::Autolock lock(mMutex);
+        listener = mFrameAvailableListener.promote();
+    }
+
+    if (listener != NULL) {
+        CB_LOGV("dispatching onFrameAvailable x%u", count);
+        for (uint32_t i = 0; i < count; i++) {
+            listener->onFrameAvailable();
+        }
+    }
+}
+
 void ConsumerBase::onBuffersReleased() {
     Mutex::Autolock lock(mMutex);
 
@@ -150,6 +225,10 @@ void ConsumerBase::abandonLocked() {
     for (int i =0; i < BufferQueue::NUM_BUFFER_SLOTS; i++) {
         freeBufferLocked(i);
     }
+    if (mFrameDispatcher != NULL) {
+        mFrameDispatcher->stop();
+        mFrameDispatcher.clear();
+    }
     // disconnect from the BufferQueue
     mConsumer->consumerDisconnect();
     mConsumer.clear();
@@ -162,6 +241,25 @@ void ConsumerBase::setFrameAvailableListener(
     mFrameAvailableListener = listener;
 }
 
+void ConsumerBase::setAsyncFrameAvailable(bool enabled, bool coalesce) {
+    CB_LOGV("setAsyncFrameAvailable: enabled=%d coalesce=%d", enabled,
+            coalesce);
+    Mutex::Autolock lock(mMutex);
+    if (mAbandoned) {
+        return;
+    }
+    if (mFrameDispatcher != NULL) {
+        mFrameDispatcher->stop();
+        mFrameDispatcher.clear();
+    }
+    if (enabled) {
+        mFrameDispatcher = new FrameDispatcher(this, coalesce);
+        mFrameDispatcher->run(
+                String8::format("%s-frames", mName.string()).string(),
+                PRIORITY_URGENT_DISPLAY);
+    }
+}
+
 void ConsumerBase::dump(String8& result) const {
     dump(result, "");
 }
@@ -171,6 +269,13 @@ void ConsumerBase::dump(String8& result, const char* prefix) const {
     dumpLocked(result, prefix);
 }
 
+void ConsumerBase::dumpLatencyStats(String8& result, bool clear) {
+    Mutex::Autolock _l(mMutex);
+    if (!mAbandoned) {
+        mConsumer->dumpLatencyStats(result, clear);
+    }
+}
+
 void ConsumerBase::dumpLocked(String8& result, const char* prefix) const {
     result.appendFormat("%smAbandoned=%d\n", prefix, int(mAbandoned));
 
@@ -192,6 +297,7 @@ status_t ConsumerBase::acquireBufferLocked(BufferQueue::BufferItem *item,
 
     mSlots[item->mBuf].mFrameNumber = item->mFrameNumber;
     mSlots[item->mBuf].mFence = item->mFence;
+    mSlots[item->mBuf].mReleaseFences.clear();
 
     CB_LOGV("acquireBufferLocked: -> slot=%d/%" PRIu64,
             item->mBuf, item->mFrameNumber);
@@ -199,6 +305,31 @@ status_t ConsumerBase::acquireBufferLocked(BufferQueue::BufferItem *item,
     return OK;
 }
 
+status_t ConsumerBase::acquireBuffersLocked(size_t maxCount,
+        Vector<BufferQueue::BufferItem>* items, nsecs_t presentWhen) {
+    const size_t first = items->size();
+    status_t err = mConsumer->acquireBuffers(maxCount, items, presentWhen);
+    if (err != NO_ERROR) {
+        return err;
+    }
+
+    for (size_t i = first; i < items->size(); i++) {
+        const BufferQueue::BufferItem& item(items->itemAt(i));
+        if (item.mGraphicBuffer != NULL) {
+            mSlots[item.mBuf].mGraphicBuffer = item.mGraphicBuffer;
+        }
+
+        mSlots[item.mBuf].mFrameNumber = item.mFrameNumber;
+        mSlots[item.mBuf].mFence = item.mFence;
+        mSlots[item.mBuf].mReleaseFences.clear();
+
+        CB_LOGV("acquireBuffersLocked: -> slot=%d/%" PRIu64,
+                item.mBuf, item.mFrameNumber);
+    }
+
+    return OK;
+}
+
 status_t ConsumerBase::addReleaseFence(int slot,
         const sp<GraphicBuffer> graphicBuffer, const sp<Fence>& fence) {
     Mutex::Autolock lock(mMutex);
@@ -215,21 +346,14 @@ status_t ConsumerBase::addReleaseFenceLocked(int slot,
         return OK;
     }
 
-    if (!mSlots[slot].mFence.get()) {
-        mSlots[slot].mFence = fence;
-    } else {
-        sp<Fence> mergedFence = Fence::merge(
-                String8::format("%.28s:%d", mName.string(), slot),
-                mSlots[slot].mFence, fence);
-        if (!mergedFence.get()) {
-            CB_LOGE("failed to merge release fences");
-            // synchronization is broken, the best we can do is hope fences
-            // signal in order so the new fence will act like a union
-            mSlots[slot].mFence = fence;
-            return BAD_VALUE;
-        }
-        mSlots[slot].mFence = mergedFence;
+    // Merging is deferred until the buffer is released, by which time some
+    // of these may have signaled already. A layer shown on several displays
+    // otherwise creates a new sync fd for every composition.
+    FenceSet& fences(mSlots[slot].mReleaseFences);
+    if (fences.isEmpty()) {
+        fences.add(mSlots[slot].mFence);
     }
+    fences.add(fence);
 
     return OK;
 }
@@ -246,6 +370,13 @@ status_t ConsumerBase::releaseBufferLocked(
 
     CB_LOGV("releaseBufferLocked: slot=%d/%" PRIu64,
             slot, mSlots[slot].mFrameNumber);
+    FenceSet& fences(mSlots[slot].mReleaseFences);
+    if (!fences.isEmpty()) {
+        mSlots[slot].mFence = fences.merge(
+                String8::format("%.28s:%d", mName.string(), slot));
+        fences.clear();
+    }
+
     status_t err = mConsumer->releaseBuffer(slot, mSlots[slot].mFrameNumber,
             display, eglFence, mSlots[slot].mFence);
     if (err == IGraphicBufferConsumer::STALE_BUFFER_SLOT) {
@@ -257,6 +388,46 @@ status_t ConsumerBase::releaseBufferLocked(
     return err;
 }
 
+status_t ConsumerBase::releaseBuffersLocked(
+        const Vector<BufferQueue::BufferItem>& items) {
+    Vector<IGraphicBufferConsumer::ReleasedBuffer> buffers;
+    for (size_t i = 0; i < items.size(); i++) {
+        const int slot = items[i].mBuf;
+        if (!stillTracking(slot, items[i].mGraphicBuffer)) {
+            continue;
+        }
+
+        CB_LOGV("releaseBuffersLocked: slot=%d/%" PRIu64,
+                slot, mSlots[slot].mFrameNumber);
+        FenceSet& fences(mSlots[slot].mReleaseFences);
+        if (!fences.isEmpty()) {
+            mSlots[slot].mFence = fences.merge(
+                    String8::format("%.28s:%d", mName.string(), slot));
+            fences.clear();
+        }
+
+        IGraphicBufferConsumer::ReleasedBuffer buffer;
+        buffer.mBuf = slot;
+        buffer.mFrameNumber = mSlots[slot].mFrameNumber;
+        buffer.mFence = mSlots[slot].mFence;
+        buffers.push_back(buffer);
+        mSlots[slot].mFence = Fence::NO_FENCE;
+    }
+    if (buffers.isEmpty()) {
+        return OK;
+    }
+
+    uint64_t staleSlots = 0;
+    status_t err = mConsumer->releaseBuffers(buffers, &staleSlots);
+    for (int slot = 0; staleSlots != 0; slot++, staleSlots >>= 1) {
+        if (staleSlots & 1) {
+            freeBufferLocked(slot);
+        }
+    }
+
+    return err;
+}
+
 bool ConsumerBase::stillTracking(int slot,
         const sp<GraphicBuffer> graphicBuffer) {
     if (slot < 0 || slot >= BufferQueue::NUM_BUFFER_SLOTS) {
@@ -21,6 +21,8 @@
 #include <cutils/compiler.h>
 #include <utils/Log.h>
 #include <gui/CpuConsumer.h>
+#include <gui/ISurfaceComposer.h>
+#include <private/gui/ComposerService.h>
 
 #define CC_LOGV(x, ...) ALOGV("[%s] "x, mName.string(), ##__VA_ARGS__)
 #define CC_LOGD(x, ...) ALOGD("[%s] "x, mName.string(), ##__VA_ARGS__)
@@ -30,11 +32,51 @@
 
 namespace android {
 
+// getPlaneLayout fills ycbcr with the planes of a buffer mapped at base, for
+// the YUV formats whose layout is defined by graphics.h. Returns false for
+// the other formats.
+static bool getPlaneLayout(PixelFormat format, uint8_t* base, uint32_t stride,
+        uint32_t height, android_ycbcr* ycbcr) {
+    uint8_t* chroma = base + stride * height;
+    switch (format) {
+        case HAL_PIXEL_FORMAT_YV12: {
+            // Y, then Cr and Cb with a stride aligned to 16 bytes
+            size_t cstride = ((stride / 2) + 15) & ~15;
+            ycbcr->cr = chroma;
+            ycbcr->cb = chroma + cstride * height / 2;
+            ycbcr->cstride = cstride;
+            ycbcr->chroma_step = 1;
+            break;
+        }
+        case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+            // NV21: Y, then interleaved Cr and Cb
+            ycbcr->cr = chroma;
+            ycbcr->cb = chroma + 1;
+            ycbcr->cstride = stride;
+            ycbcr->chroma_step = 2;
+            break;
+        case HAL_PIXEL_FORMAT_YCbCr_422_SP:
+            // NV16: Y, then interleaved Cb and Cr on every line
+            ycbcr->cb = chroma;
+            ycbcr->cr = chroma + 1;
+            ycbcr->cstride = stride;
+            ycbcr->chroma_step = 2;
+            break;
+        default:
+            return false;
+    }
+    ycbcr->y = base;
+    ycbcr->ystride = stride;
+    return true;
+}
+
 CpuConsumer::CpuConsumer(const sp<IGraphicBufferConsumer>& bq,
         uint32_t maxLockedBuffers, bool controlledByApp) :
     ConsumerBase(bq, controlledByApp),
     mMaxLockedBuffers(maxLockedBuffers),
-    mCurrentLockedBuffers(0)
+    mCurrentLockedBuffers(0),
+    mPersistentMapping(false),
+    mConvertedFormat(0)
 {
     // Create tracking entries for locked buffers
     mAcquiredBuffers.insertAt(0, maxLockedBuffers);
@@ -67,6 +109,92 @@ status_t CpuConsumer::setDefaultBufferFormat(uint32_t defaultFormat)
     return mConsumer->setDefaultBufferFormat(defaultFormat);
 }
 
+void CpuConsumer::setPersistentMapping(bool enabled)
+{
+    Mutex::Autolock _l(mMutex);
+    if (mPersistentMapping == enabled) {
+        return;
+    }
+    mPersistentMapping = enabled;
+    if (!enabled) {
+        for (int i = 0; i < BufferQueue::NUM_BUFFER_SLOTS; i++) {
+            unmapSlotLocked(i);
+        }
+    }
+}
+
+status_t CpuConsumer::setConvertedFormat(PixelFormat format)
+{
+    Mutex::Autolock _l(mMutex);
+    mConvertedFormat = format;
+    // the GPU reads the buffers to convert them
+    return mConsumer->setConsumerUsageBits(GRALLOC_USAGE_SW_READ_OFTEN |
+            (format != 0 ? GRALLOC_USAGE_HW_TEXTURE : 0));
+}
+
+status_t CpuConsumer::mapSlotLocked(int slot, const sp<Fence>& fence,
+        void** outPointer, android_ycbcr* outYCbCr) {
+    // The mapping may be reused, so wait for the producer here rather than
+    // letting gralloc do it; waiting first also means a new mapping only
+    // sees the finished frame.
+    if (fence != NULL) {
+        status_t err = fence->waitForever("CpuConsumer::lockNextBuffer");
+        if (err != OK) {
+            CC_LOGE("Failed to wait for acquire fence: %s (%d)",
+                    strerror(-err), err);
+            return err;
+        }
+    }
+
+    MappedSlot& mapped(mMappedSlots[slot]);
+    const sp<GraphicBuffer>& graphicBuffer(mSlots[slot].mGraphicBuffer);
+    if (mapped.mGraphicBuffer != graphicBuffer) {
+        // The slot has been reallocated since it was last mapped
+        unmapSlotLocked(slot);
+
+        status_t err;
+        if (graphicBuffer->getPixelFormat() == HAL_PIXEL_FORMAT_YCbCr_420_888) {
+            err = graphicBuffer->lockYCbCr(GraphicBuffer::USAGE_SW_READ_OFTEN,
+                    &mapped.mYCbCr);
+            mapped.mBufferPointer = mapped.mYCbCr.y;
+        } else {
+            err = graphicBuffer->lock(GraphicBuffer::USAGE_SW_READ_OFTEN,
+                    &mapped.mBufferPointer);
+        }
+        if (err != OK) {
+            CC_LOGE("Unable to map buffer for CPU reading: %s (%d)",
+                    strerror(-err), err);
+            mapped = MappedSlot();
+            return err;
+        }
+        mapped.mGraphicBuffer = graphicBuffer;
+    }
+
+    *outPointer = mapped.mBufferPointer;
+    *outYCbCr = mapped.mYCbCr;
+    return OK;
+}
+
+void CpuConsumer::unmapSlotLocked(int slot) {
+    MappedSlot& mapped(mMappedSlots[slot]);
+    if (mapped.mGraphicBuffer == NULL) {
+        return;
+    }
+    // A buffer the user still holds is unmapped when it's unlocked
+    bool locked = false;
+    for (size_t i = 0; i < mMaxLockedBuffers; i++) {
+        if (mAcquiredBuffers[i].mPersistent &&
+                mAcquiredBuffers[i].mGraphicBuffer == mapped.mGraphicBuffer) {
+            locked = true;
+            break;
+        }
+    }
+    if (!locked) {
+        mapped.mGraphicBuffer->unlock();
+    }
+    mapped = MappedSlot();
+}
+
 status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
     status_t err;
 
@@ -93,10 +221,20 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
 
     int buf = b.mBuf;
 
+    if (mConvertedFormat != 0 &&
+            mSlots[buf].mGraphicBuffer->getPixelFormat() != mConvertedFormat) {
+        return lockConvertedLocked(b, nativeBuffer);
+    }
+
     void *bufferPointer = NULL;
     android_ycbcr ycbcr = android_ycbcr();
 
-    if (b.mFence.get()) {
+    if (mPersistentMapping) {
+        err = mapSlotLocked(buf, b.mFence, &bufferPointer, &ycbcr);
+        if (err != OK) {
+            return err;
+        }
+    } else if (b.mFence.get()) {
         if (mSlots[buf].mGraphicBuffer->getPixelFormat() ==
                 HAL_PIXEL_FORMAT_YCbCr_420_888) {
             err = mSlots[buf].mGraphicBuffer->lockAsyncYCbCr(
@@ -152,6 +290,14 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
         }
     }
 
+    const sp<GraphicBuffer>& graphicBuffer(mSlots[buf].mGraphicBuffer);
+    if (ycbcr.y == NULL) {
+        getPlaneLayout(graphicBuffer->getPixelFormat(),
+                reinterpret_cast<uint8_t*>(bufferPointer),
+                graphicBuffer->getStride(), graphicBuffer->getHeight(),
+                &ycbcr);
+    }
+
     size_t lockedIdx = 0;
     for (; lockedIdx < mMaxLockedBuffers; lockedIdx++) {
         if (mAcquiredBuffers[lockedIdx].mSlot ==
@@ -165,6 +311,7 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
     ab.mSlot = buf;
     ab.mBufferPointer = bufferPointer;
     ab.mGraphicBuffer = mSlots[buf].mGraphicBuffer;
+    ab.mPersistent = mPersistentMapping;
 
     nativeBuffer->data   =
             reinterpret_cast<uint8_t*>(bufferPointer);
@@ -185,6 +332,113 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
     nativeBuffer->dataCr       = reinterpret_cast<uint8_t*>(ycbcr.cr);
     nativeBuffer->chromaStride = ycbcr.cstride;
     nativeBuffer->chromaStep   = ycbcr.chroma_step;
+    if (ycbcr.cb != NULL) {
+        // only NV16 keeps the full vertical chroma resolution
+        nativeBuffer->chromaWidth  = (nativeBuffer->width + 1) / 2;
+        nativeBuffer->chromaHeight = nativeBuffer->format ==
+                HAL_PIXEL_FORMAT_YCbCr_422_SP ?
+                nativeBuffer->height : (nativeBuffer->height + 1) / 2;
+    } else {
+        nativeBuffer->chromaWidth  = 0;
+        nativeBuffer->chromaHeight = 0;
+    }
+
+    mCurrentLockedBuffers++;
+
+    return OK;
+}
+
+status_t CpuConsumer::lockConvertedLocked(const BufferQueue::BufferItem& b,
+        LockedBuffer* nativeBuffer) {
+    int buf = b.mBuf;
+    sp<GraphicBuffer> src(mSlots[buf].mGraphicBuffer);
+    Rect crop(b.mCrop.isEmpty() ? src->getBounds() : b.mCrop);
+    uint32_t width = crop.width();
+    uint32_t height = crop.height();
+    if (b.mTransform & NATIVE_WINDOW_TRANSFORM_ROT_90) {
+        uint32_t tmp = width;
+        width = height;
+        height = tmp;
+    }
+
+    size_t lockedIdx = 0;
+    for (; lockedIdx < mMaxLockedBuffers; lockedIdx++) {
+        if (mAcquiredBuffers[lockedIdx].mSlot ==
+                BufferQueue::INVALID_BUFFER_SLOT) {
+            break;
+        }
+    }
+    assert(lockedIdx < mMaxLockedBuffers);
+    AcquiredBuffer &ab = mAcquiredBuffers.editItemAt(lockedIdx);
+
+    status_t err = OK;
+    sp<GraphicBuffer>& dst(ab.mConvertedBuffer);
+    if (dst == NULL || dst->getWidth() != width ||
+            dst->getHeight() != height ||
+            dst->getPixelFormat() != mConvertedFormat) {
+        if (mGraphicBufferAlloc == NULL) {
+            sp<ISurfaceComposer> composer(
+                    ComposerService::getComposerService());
+            mGraphicBufferAlloc = composer->createGraphicBufferAlloc();
+        }
+        dst = mGraphicBufferAlloc->createGraphicBuffer(width, height,
+                mConvertedFormat,
+                GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_SW_READ_OFTEN, &err);
+        if (dst == NULL) {
+            CC_LOGE("Unable to allocate a %ux%u buffer to convert into: "
+                    "%s (%d)", width, height, strerror(-err), err);
+            releaseBufferLocked(buf, src, EGL_NO_DISPLAY, EGL_NO_SYNC_KHR);
+            return err != OK ? err : NO_MEMORY;
+        }
+    }
+
+    if (mConverter == NULL) {
+        mConverter = new BufferConverter();
+    }
+    sp<Fence> fence;
+    err = mConverter->convert(src, b.mFence, crop, b.mTransform, dst, &fence);
+    if (err == OK && fence->isValid()) {
+        // the producer may reuse the buffer once the GPU has read it
+        addReleaseFenceLocked(buf, src, fence);
+    }
+    releaseBufferLocked(buf, src, EGL_NO_DISPLAY, EGL_NO_SYNC_KHR);
+    if (err != OK) {
+        CC_LOGE("Unable to convert buffer: %s (%d)", strerror(-err), err);
+        return err;
+    }
+
+    void *bufferPointer = NULL;
+    err = dst->lockAsync(GraphicBuffer::USAGE_SW_READ_OFTEN, &bufferPointer,
+            fence->dup());
+    if (err != OK) {
+        CC_LOGE("Unable to lock converted buffer for CPU reading: %s (%d)",
+                strerror(-err), err);
+        return err;
+    }
+
+    ab.mSlot = buf;
+    ab.mBufferPointer = bufferPointer;
+    ab.mGraphicBuffer = dst;
+    ab.mPersistent = false;
+    ab.mConverted = true;
+
+    nativeBuffer->data        = reinterpret_cast<uint8_t*>(bufferPointer);
+    nativeBuffer->width       = width;
+    nativeBuffer->height      = height;
+    nativeBuffer->format      = mConvertedFormat;
+    nativeBuffer->stride      = dst->getStride();
+    nativeBuffer->crop        = Rect(width, height);
+    nativeBuffer->transform   = 0;
+    nativeBuffer->scalingMode = b.mScalingMode;
+    nativeBuffer->timestamp   = b.mTimestamp;
+    nativeBuffer->frameNumber = b.mFrameNumber;
+
+    nativeBuffer->dataCb       = NULL;
+    nativeBuffer->dataCr       = NULL;
+    nativeBuffer->chromaStride = 0;
+    nativeBuffer->chromaStep   = 0;
+    nativeBuffer->chromaWidth  = 0;
+    nativeBuffer->chromaHeight = 0;
 
     mCurrentLockedBuffers++;
 
@@ -211,14 +465,37 @@ status_t CpuConsumer::unlockBuffer(const LockedBuffer &nativeBuffer) {
 status_t CpuConsumer::releaseAcquiredBufferLocked(int lockedIdx) {
     status_t err;
     int fd = -1;
+    int buf = mAcquiredBuffers[lockedIdx].mSlot;
 
-    err = mAcquiredBuffers[lockedIdx].mGraphicBuffer->unlockAsync(&fd);
-    if (err != OK) {
-        CC_LOGE("%s: Unable to unlock graphic buffer %d", __FUNCTION__,
-                lockedIdx);
+    if (mAcquiredBuffers[lockedIdx].mConverted) {
+        // The slot was released when the buffer was converted, only the
+        // copy is left to unlock
+        AcquiredBuffer &ab = mAcquiredBuffers.editItemAt(lockedIdx);
+        err = ab.mGraphicBuffer->unlock();
+        ab.mSlot = BufferQueue::INVALID_BUFFER_SLOT;
+        ab.mBufferPointer = NULL;
+        ab.mGraphicBuffer.clear();
+        ab.mConverted = false;
+        mCurrentLockedBuffers--;
         return err;
     }
-    int buf = mAcquiredBuffers[lockedIdx].mSlot;
+
+    if (mAcquiredBuffers[lockedIdx].mPersistent) {
+        // Keep the mapping for the next time this slot is acquired, unless
+        // the slot has been unmapped or reallocated in the meantime. The
+        // CPU is done with the buffer, so there is no release fence.
+        if (mMappedSlots[buf].mGraphicBuffer !=
+                mAcquiredBuffers[lockedIdx].mGraphicBuffer) {
+            mAcquiredBuffers[lockedIdx].mGraphicBuffer->unlock();
+        }
+    } else {
+        err = mAcquiredBuffers[lockedIdx].mGraphicBuffer->unlockAsync(&fd);
+        if (err != OK) {
+            CC_LOGE("%s: Unable to unlock graphic buffer %d", __FUNCTION__,
+                    lockedIdx);
+            return err;
+        }
+    }
     if (CC_LIKELY(fd != -1)) {
         sp<Fence> fence(new Fence(fd));
         addReleaseFenceLocked(
@@ -241,12 +518,14 @@ status_t CpuConsumer::releaseAcquiredBufferLocked(int lockedIdx) {
     ab.mSlot = BufferQueue::INVALID_BUFFER_SLOT;
     ab.mBufferPointer = NULL;
     ab.mGraphicBuffer.clear();
+    ab.mPersistent = false;
 
     mCurrentLockedBuffers--;
     return OK;
 }
 
 void CpuConsumer::freeBufferLocked(int slotIndex) {
+    unmapSlotLocked(slotIndex);
     ConsumerBase::freeBufferLocked(slotIndex);
 }
 
@@ -88,6 +88,49 @@ ssize_t DisplayEventReceiver::getEvents(const sp<BitTube>& dataChannel,
     return BitTube::recvObjects(dataChannel, events, count);
 }
 
+ssize_t DisplayEventReceiver::getLatestVsync(Event* outVsync,
+        Vector<Event>* outOtherEvents) {
+    if (mDataChannel == NULL)
+        return NO_INIT;
+
+    return DisplayEventReceiver::getLatestVsync(mDataChannel, outVsync,
+            outOtherEvents);
+}
+
+ssize_t DisplayEventReceiver::getLatestVsync(const sp<BitTube>& dataChannel,
+        Event* outVsync, Vector<Event>* outOtherEvents)
+{
+    // SurfaceFlinger sends one event per message; room for a few more
+    // in case several are sent at once
+    enum { MESSAGES = 16, EVENTS_PER_MESSAGE = 4 };
+    Event buffer[MESSAGES * EVENTS_PER_MESSAGE];
+    size_t counts[MESSAGES];
+    ssize_t vsyncCount = 0;
+
+    for (;;) {
+        ssize_t n = BitTube::recvObjectMessages(dataChannel, buffer,
+                EVENTS_PER_MESSAGE, MESSAGES, counts);
+        if (n < 0) {
+            return n;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            const Event* events = buffer + i * EVENTS_PER_MESSAGE;
+            for (size_t j = 0; j < counts[i]; j++) {
+                if (events[j].header.type == DISPLAY_EVENT_VSYNC) {
+                    *outVsync = events[j];
+                    vsyncCount++;
+                } else if (outOtherEvents != NULL) {
+                    outOtherEvents->add(events[j]);
+                }
+            }
+        }
+        if (n < MESSAGES) {
+            break;
+        }
+    }
+    return vsyncCount;
+}
+
 ssize_t DisplayEventReceiver::sendEvents(const sp<BitTube>& dataChannel,
         Event const* events, size_t count)
 {
@@ -116,6 +116,17 @@ static bool isEglImageCroppable(const Rect& crop) {
     return hasEglAndroidImageCrop() && (crop.left == 0 && crop.top == 0);
 }
 
+// The crop EglImage::createImage actually passes on to EGL. Images created
+// with crops that end up the same are the same image.
+static Rect eglImageCrop(const Rect& crop) {
+    if (crop.isValid() && isEglImageCroppable(crop)) {
+        return crop;
+    }
+    Rect noCrop;
+    noCrop.makeInvalid();
+    return noCrop;
+}
+
 GLConsumer::GLConsumer(const sp<IGraphicBufferConsumer>& bq, uint32_t tex,
         uint32_t texTarget, bool useFenceSync, bool isControlledByApp) :
     ConsumerBase(bq, isControlledByApp),
@@ -136,12 +147,16 @@ GLConsumer::GLConsumer(const sp<IGraphicBufferConsumer>& bq, uint32_t tex,
 #ifdef STE_HARDWARE
     mNextBlitSlot(0),
 #endif
-    mAttached(true)
+    mAttached(true),
+    mEglImageCacheHits(0),
+    mEglImageCacheMisses(0),
+    mEglImageCacheEvictions(0)
 {
     ST_LOGV("GLConsumer");
 
     memcpy(mCurrentTransformMatrix, mtxIdentity,
             sizeof(mCurrentTransformMatrix));
+    mCurrentSurfaceDamage.makeInvalid();
 
 #ifdef STE_HARDWARE
     hw_module_t const* module;
@@ -181,12 +196,16 @@ GLConsumer::GLConsumer(const sp<IGraphicBufferConsumer>& bq, uint32_t texTarget,
 #ifdef STE_HARDWARE
     mNextBlitSlot(0),
 #endif
-    mAttached(false)
+    mAttached(false),
+    mEglImageCacheHits(0),
+    mEglImageCacheMisses(0),
+    mEglImageCacheEvictions(0)
 {
     ST_LOGV("GLConsumer");
 
     memcpy(mCurrentTransformMatrix, mtxIdentity,
             sizeof(mCurrentTransformMatrix));
+    mCurrentSurfaceDamage.makeInvalid();
 
 #ifdef STE_HARDWARE
     hw_module_t const* module;
@@ -208,7 +227,20 @@ GLConsumer::GLConsumer(const sp<IGraphicBufferConsumer>& bq, uint32_t texTarget,
 
 status_t GLConsumer::setDefaultMaxBufferCount(int bufferCount) {
     Mutex::Autolock lock(mMutex);
-    return mConsumer->setDefaultMaxBufferCount(bufferCount);
+    status_t err = mConsumer->setDefaultMaxBufferCount(bufferCount);
+    if (err == NO_ERROR && !mAbandoned) {
+        // Lowering the count frees the buffers that no longer fit right away;
+        // drop our references to them too. This is what onBuffersReleased
+        // does, which the BufferQueue can't call back while we hold mMutex.
+        uint64_t mask = 0;
+        mConsumer->getReleasedBuffers(&mask);
+        for (int i = 0; i < BufferQueue::NUM_BUFFER_SLOTS; i++) {
+            if (mask & (1ULL << i)) {
+                freeBufferLocked(i);
+            }
+        }
+    }
+    return err;
 }
 
 #ifdef STE_HARDWARE
@@ -332,6 +364,7 @@ status_t GLConsumer::releaseTexImage() {
         mCurrentTexture = BufferQueue::INVALID_BUFFER_SLOT;
         mCurrentTextureImage = mReleasedTexImage;
         mCurrentCrop.makeInvalid();
+        mCurrentSurfaceDamage.makeInvalid();
         mCurrentTransform = 0;
         mCurrentScalingMode = NATIVE_WINDOW_SCALING_MODE_FREEZE;
         mCurrentTimestamp = 0;
@@ -502,6 +535,8 @@ status_t GLConsumer::updateAndReleaseLocked(const BufferQueue::BufferItem& item)
     // ConsumerBase.
     // We may have to do this even when item.mGraphicBuffer == NULL (which
     // means the buffer was previously acquired).
+    mEglSlots[buf].mEglImage = getEglImageLocked(mEglSlots[buf].mEglImage,
+            item.mCrop);
     err = mEglSlots[buf].mEglImage->createIfNeeded(mEglDisplay, item.mCrop);
 
     if (err != NO_ERROR) {
@@ -546,6 +581,7 @@ status_t GLConsumer::updateAndReleaseLocked(const BufferQueue::BufferItem& item)
     mCurrentTexture = buf;
     mCurrentTextureImage = mEglSlots[buf].mEglImage;
     mCurrentCrop = item.mCrop;
+    mCurrentSurfaceDamage = item.mSurfaceDamage;
     mCurrentTransform = item.mTransform;
     mCurrentScalingMode = item.mScalingMode;
     mCurrentTimestamp = item.mTimestamp;
@@ -557,6 +593,86 @@ status_t GLConsumer::updateAndReleaseLocked(const BufferQueue::BufferItem& item)
     return err;
 }
 
+status_t GLConsumer::createEglImageLocked(const BufferQueue::BufferItem& item) {
+    if (mEglDisplay == EGL_NO_DISPLAY) {
+        return NO_INIT;
+    }
+    mEglSlots[item.mBuf].mEglImage = getEglImageLocked(
+            mEglSlots[item.mBuf].mEglImage, item.mCrop);
+    return mEglSlots[item.mBuf].mEglImage->createIfNeeded(mEglDisplay,
+            item.mCrop);
+}
+
+sp<GLConsumer::EglImage> GLConsumer::getEglImageLocked(
+        const sp<EglImage>& image, const Rect& cropRect) {
+    if (image->isCreatedFor(mEglDisplay, cropRect)) {
+        mEglImageCacheHits++;
+        return image;
+    }
+
+    const uint64_t id = image->graphicBuffer()->getId();
+    for (size_t i = 0; i < mEglImageCache.size(); i++) {
+        sp<EglImage> cached(mEglImageCache[i]);
+        if (cached->graphicBuffer()->getId() == id &&
+                cached->isCreatedFor(mEglDisplay, cropRect)) {
+            mEglImageCache.removeAt(i);
+            mEglImageCache.insertAt(cached, 0);
+            mEglImageCacheHits++;
+            return cached;
+        }
+    }
+
+    // This is going to create an image. Don't recreate one that was
+    // created for another crop, it may still be cached for that one.
+    sp<EglImage> result(image);
+    if (image->isCreated()) {
+        result = new EglImage(image->graphicBuffer());
+    }
+    if (mEglImageCache.indexOf(result) < 0) {
+        mEglImageCache.insertAt(result, 0);
+    }
+    mEglImageCacheMisses++;
+    trimEglImageCacheLocked();
+    return result;
+}
+
+bool GLConsumer::isEglImageInUseLocked(const sp<EglImage>& image) const {
+    if (image == mCurrentTextureImage) {
+        return true;
+    }
+    for (int i = 0; i < BufferQueue::NUM_BUFFER_SLOTS; i++) {
+        if (mEglSlots[i].mEglImage == image) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GLConsumer::isBufferInSlotLocked(const sp<EglImage>& image) const {
+    const uint64_t id = image->graphicBuffer()->getId();
+    for (int i = 0; i < BufferQueue::NUM_BUFFER_SLOTS; i++) {
+        const sp<EglImage>& slotImage(mEglSlots[i].mEglImage);
+        if (slotImage != NULL && slotImage->graphicBuffer()->getId() == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GLConsumer::trimEglImageCacheLocked() {
+    size_t unused = 0;
+    for (size_t i = 0; i < mEglImageCache.size(); ) {
+        const sp<EglImage>& image(mEglImageCache[i]);
+        if (!isEglImageInUseLocked(image) && (!isBufferInSlotLocked(image) ||
+                ++unused > MAX_UNUSED_EGL_IMAGES)) {
+            mEglImageCache.removeAt(i);
+            mEglImageCacheEvictions++;
+        } else {
+            i++;
+        }
+    }
+}
+
 status_t GLConsumer::bindTextureImageLocked() {
     if (mEglDisplay == EGL_NO_DISPLAY) {
         ALOGE("bindTextureImage: invalid display");
@@ -1027,6 +1143,11 @@ uint32_t GLConsumer::getCurrentScalingMode() const {
     return mCurrentScalingMode;
 }
 
+Rect GLConsumer::getCurrentSurfaceDamage() const {
+    Mutex::Autolock lock(mMutex);
+    return mCurrentSurfaceDamage;
+}
+
 sp<Fence> GLConsumer::getCurrentFence() const {
     Mutex::Autolock lock(mMutex);
     return mCurrentFence;
@@ -1052,49 +1173,8 @@ status_t GLConsumer::doGLFenceWaitLocked() const {
         return INVALID_OPERATION;
     }
 
-    if (mCurrentFence->isValid()) {
-        if (SyncFeatures::getInstance().useWaitSync()) {
-            // Create an EGLSyncKHR from the current fence.
-            int fenceFd = mCurrentFence->dup();
-            if (fenceFd == -1) {
-                ST_LOGE("doGLFenceWait: error dup'ing fence fd: %d", errno);
-                return -errno;
-            }
-            EGLint attribs[] = {
-                EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fenceFd,
-                EGL_NONE
-            };
-            EGLSyncKHR sync = eglCreateSyncKHR(dpy,
-                    EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
-            if (sync == EGL_NO_SYNC_KHR) {
-                close(fenceFd);
-                ST_LOGE("doGLFenceWait: error creating EGL fence: %#x",
-                        eglGetError());
-                return UNKNOWN_ERROR;
-            }
-
-            // XXX: The spec draft is inconsistent as to whether this should
-            // return an EGLint or void.  Ignore the return value for now, as
-            // it's not strictly needed.
-            eglWaitSyncKHR(dpy, sync, 0);
-            EGLint eglErr = eglGetError();
-            eglDestroySyncKHR(dpy, sync);
-            if (eglErr != EGL_SUCCESS) {
-                ST_LOGE("doGLFenceWait: error waiting for EGL fence: %#x",
-                        eglErr);
-                return UNKNOWN_ERROR;
-            }
-        } else {
-            status_t err = mCurrentFence->waitForever(
-                    "GLConsumer::doGLFenceWaitLocked");
-            if (err != NO_ERROR) {
-                ST_LOGE("doGLFenceWait: error waiting for fence: %d", err);
-                return err;
-            }
-        }
-    }
-
-    return NO_ERROR;
+    return SyncFeatures::getInstance().waitForFence(dpy, mCurrentFence,
+            "GLConsumer::doGLFenceWaitLocked");
 }
 
 void GLConsumer::freeBufferLocked(int slotIndex) {
@@ -1103,12 +1183,14 @@ void GLConsumer::freeBufferLocked(int slotIndex) {
         mCurrentTexture = BufferQueue::INVALID_BUFFER_SLOT;
     }
     mEglSlots[slotIndex].mEglImage.clear();
+    trimEglImageCacheLocked();
     ConsumerBase::freeBufferLocked(slotIndex);
 }
 
 void GLConsumer::abandonLocked() {
     ST_LOGV("abandonLocked");
     mCurrentTextureImage.clear();
+    mEglImageCache.clear();
     ConsumerBase::abandonLocked();
 }
 
@@ -1142,6 +1224,10 @@ void GLConsumer::dumpLocked(String8& result, const char* prefix) const
        prefix, mTexName, mCurrentTexture, prefix, mCurrentCrop.left,
        mCurrentCrop.top, mCurrentCrop.right, mCurrentCrop.bottom,
        mCurrentTransform);
+    result.appendFormat(
+       "%sEGLImage cache: %zu images, %u hits, %u misses, %u evictions\n",
+       prefix, mEglImageCache.size(), mEglImageCacheHits,
+       mEglImageCacheMisses, mEglImageCacheEvictions);
 
     ConsumerBase::dumpLocked(result, prefix);
 }
@@ -1239,9 +1325,10 @@ status_t GLConsumer::EglImage::createIfNeeded(EGLDisplay eglDisplay,
                                               const Rect& cropRect,
                                               bool forceCreation) {
     // If there's an image and it's no longer valid, destroy it.
+    const Rect imageCrop(eglImageCrop(cropRect));
     bool haveImage = mEglImage != EGL_NO_IMAGE_KHR;
     bool displayInvalid = mEglDisplay != eglDisplay;
-    bool cropInvalid = hasEglAndroidImageCrop() && mCropRect != cropRect;
+    bool cropInvalid = mCropRect != imageCrop;
     if (haveImage && (displayInvalid || cropInvalid || forceCreation)) {
         if (!eglDestroyImageKHR(mEglDisplay, mEglImage)) {
            ALOGE("createIfNeeded: eglDestroyImageKHR failed");
@@ -1253,7 +1340,7 @@ status_t GLConsumer::EglImage::createIfNeeded(EGLDisplay eglDisplay,
     // If there's no image, create one.
     if (mEglImage == EGL_NO_IMAGE_KHR) {
         mEglDisplay = eglDisplay;
-        mCropRect = cropRect;
+        mCropRect = imageCrop;
         mEglImage = createImage(mEglDisplay, mGraphicBuffer, mCropRect);
     }
 
@@ -1271,6 +1358,12 @@ status_t GLConsumer::EglImage::createIfNeeded(EGLDisplay eglDisplay,
     return OK;
 }
 
+bool GLConsumer::EglImage::isCreatedFor(EGLDisplay eglDisplay,
+                                        const Rect& cropRect) const {
+    return mEglImage != EGL_NO_IMAGE_KHR && mEglDisplay == eglDisplay &&
+            mCropRect == eglImageCrop(cropRect);
+}
+
 void GLConsumer::EglImage::bindToTextureTarget(uint32_t texTarget) {
     glEGLImageTargetTexture2DOES(texTarget, (GLeglImageOES)mEglImage);
 }
@@ -17,6 +17,8 @@
 
 #include <cutils/log.h>
 
+#include <binder/IPCThreadState.h>
+
 #include <ui/GraphicBuffer.h>
 
 #include <gui/GraphicBufferAlloc.h>
@@ -33,8 +35,11 @@ GraphicBufferAlloc::~GraphicBufferAlloc() {
 
 sp<GraphicBuffer> GraphicBufferAlloc::createGraphicBuffer(uint32_t w, uint32_t h,
         PixelFormat format, uint32_t usage, status_t* error) {
-    sp<GraphicBuffer> graphicBuffer(new GraphicBuffer(w, h, format, usage));
-    status_t err = graphicBuffer->initCheck();
+    // The buffers are only recycled within the process that asked for them,
+    // the others must not see what it drew.
+    sp<GraphicBuffer> graphicBuffer(new GraphicBuffer());
+    status_t err = graphicBuffer->reallocatePooled(w, h, format, usage,
+            IPCThreadState::self()->getCallingPid());
     *error = err;
     if (err != 0 || graphicBuffer->handle == 0) {
         if (err == NO_MEMORY) {
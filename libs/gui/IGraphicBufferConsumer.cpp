@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 #include <binder/IInterface.h>
 
+#include <gui/BufferQueueDefs.h>
 #include <gui/IConsumerListener.h>
 #include <gui/IGraphicBufferConsumer.h>
 
@@ -43,8 +44,10 @@ IGraphicBufferConsumer::BufferItem::BufferItem() :
     mBuf(INVALID_BUFFER_SLOT),
     mIsDroppable(false),
     mAcquireCalled(false),
-    mTransformToDisplayInverse(false) {
+    mTransformToDisplayInverse(false),
+    mDroppedFrameCount(0) {
     mCrop.makeInvalid();
+    mSurfaceDamage.makeInvalid();
 }
 
 size_t IGraphicBufferConsumer::BufferItem::getPodSize() const {
@@ -57,7 +60,9 @@ size_t IGraphicBufferConsumer::BufferItem::getPodSize() const {
             sizeof(mBuf) +
             sizeof(mIsDroppable) +
             sizeof(mAcquireCalled) +
-            sizeof(mTransformToDisplayInverse);
+            sizeof(mTransformToDisplayInverse) +
+            sizeof(mSurfaceDamage) +
+            sizeof(mDroppedFrameCount);
     return c;
 }
 
@@ -138,6 +143,8 @@ status_t IGraphicBufferConsumer::BufferItem::flatten(
     writeBoolAsInt(buffer, size, mIsDroppable);
     writeBoolAsInt(buffer, size, mAcquireCalled);
     writeBoolAsInt(buffer, size, mTransformToDisplayInverse);
+    FlattenableUtils::write(buffer, size, mSurfaceDamage);
+    FlattenableUtils::write(buffer, size, mDroppedFrameCount);
 
     return NO_ERROR;
 }
@@ -180,6 +187,8 @@ status_t IGraphicBufferConsumer::BufferItem::unflatten(
     mIsDroppable = readBoolFromInt(buffer, size);
     mAcquireCalled = readBoolFromInt(buffer, size);
     mTransformToDisplayInverse = readBoolFromInt(buffer, size);
+    FlattenableUtils::read(buffer, size, mSurfaceDamage);
+    FlattenableUtils::read(buffer, size, mDroppedFrameCount);
 
     return NO_ERROR;
 }
@@ -204,6 +213,10 @@ enum {
     SET_TRANSFORM_HINT,
     GET_SIDEBAND_STREAM,
     DUMP,
+    DUMP_LATENCY_STATS,
+    SET_DROP_LATE_FRAMES,
+    ACQUIRE_BUFFERS,
+    RELEASE_BUFFERS,
 };
 
 
@@ -270,6 +283,52 @@ public:
         return reply.readInt32();
     }
 
+    virtual status_t acquireBuffers(size_t maxCount,
+            Vector<BufferItem>* outBuffers, nsecs_t presentWhen) {
+        if (maxCount == 0 || outBuffers == NULL) {
+            return BAD_VALUE;
+        }
+        Parcel data, reply;
+        data.writeInterfaceToken(IGraphicBufferConsumer::getInterfaceDescriptor());
+        data.writeInt32(maxCount);
+        data.writeInt64(presentWhen);
+        status_t result = remote()->transact(ACQUIRE_BUFFERS, data, &reply);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        const size_t count = reply.readInt32();
+        for (size_t i = 0; i < count; i++) {
+            BufferItem item;
+            result = reply.read(item);
+            if (result != NO_ERROR) {
+                return result;
+            }
+            outBuffers->push_back(item);
+        }
+        return reply.readInt32();
+    }
+
+    virtual status_t releaseBuffers(const Vector<ReleasedBuffer>& buffers,
+            uint64_t* outStaleSlots) {
+        if (outStaleSlots == NULL) {
+            return BAD_VALUE;
+        }
+        Parcel data, reply;
+        data.writeInterfaceToken(IGraphicBufferConsumer::getInterfaceDescriptor());
+        data.writeInt32(buffers.size());
+        for (size_t i = 0; i < buffers.size(); i++) {
+            data.writeInt32(buffers[i].mBuf);
+            data.writeInt64(buffers[i].mFrameNumber);
+            data.write(*buffers[i].mFence);
+        }
+        status_t result = remote()->transact(RELEASE_BUFFERS, data, &reply);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        *outStaleSlots = reply.readInt64();
+        return reply.readInt32();
+    }
+
     virtual status_t consumerConnect(const sp<IConsumerListener>& consumer, bool controlledByApp) {
         Parcel data, reply;
         data.writeInterfaceToken(IGraphicBufferConsumer::getInterfaceDescriptor());
@@ -391,6 +450,17 @@ public:
         return reply.readInt32();
     }
 
+    virtual status_t setDropLateFrames(bool enabled) {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGraphicBufferConsumer::getInterfaceDescriptor());
+        data.writeInt32(enabled);
+        status_t result = remote()->transact(SET_DROP_LATE_FRAMES, data, &reply);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        return reply.readInt32();
+    }
+
     virtual sp<NativeHandle> getSidebandStream() const {
         Parcel data, reply;
         status_t err;
@@ -413,6 +483,15 @@ public:
         remote()->transact(DUMP, data, &reply);
         reply.readString8();
     }
+
+    virtual void dumpLatencyStats(String8& result, bool clear) {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGraphicBufferConsumer::getInterfaceDescriptor());
+        data.writeInt32(clear);
+        if (remote()->transact(DUMP_LATENCY_STATS, data, &reply) == NO_ERROR) {
+            result.append(reply.readString8());
+        }
+    }
 };
 
 IMPLEMENT_META_INTERFACE(GraphicBufferConsumer, "android.gui.IGraphicBufferConsumer");
@@ -546,6 +625,57 @@ status_t BnGraphicBufferConsumer::onTransact(
             reply->writeString8(result);
             return NO_ERROR;
         }
+        case DUMP_LATENCY_STATS: {
+            CHECK_INTERFACE(IGraphicBufferConsumer, data, reply);
+            bool clear = data.readInt32();
+            String8 result;
+            dumpLatencyStats(result, clear);
+            reply->writeString8(result);
+            return NO_ERROR;
+        }
+        case SET_DROP_LATE_FRAMES: {
+            CHECK_INTERFACE(IGraphicBufferConsumer, data, reply);
+            bool enabled = data.readInt32();
+            status_t result = setDropLateFrames(enabled);
+            reply->writeInt32(result);
+            return NO_ERROR;
+        }
+        case ACQUIRE_BUFFERS: {
+            CHECK_INTERFACE(IGraphicBufferConsumer, data, reply);
+            size_t maxCount = data.readInt32();
+            int64_t presentWhen = data.readInt64();
+            Vector<BufferItem> items;
+            status_t result = acquireBuffers(maxCount, &items, presentWhen);
+            reply->writeInt32(items.size());
+            for (size_t i = 0; i < items.size(); i++) {
+                status_t err = reply->write(items[i]);
+                if (err) return err;
+            }
+            reply->writeInt32(result);
+            return NO_ERROR;
+        }
+        case RELEASE_BUFFERS: {
+            CHECK_INTERFACE(IGraphicBufferConsumer, data, reply);
+            const size_t count = data.readInt32();
+            if (count > size_t(BufferQueueDefs::NUM_BUFFER_SLOTS)) {
+                return BAD_VALUE;
+            }
+            Vector<ReleasedBuffer> buffers;
+            buffers.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                ReleasedBuffer& buffer(buffers.editItemAt(i));
+                buffer.mBuf = data.readInt32();
+                buffer.mFrameNumber = data.readInt64();
+                buffer.mFence = new Fence();
+                status_t err = data.read(*buffer.mFence);
+                if (err) return err;
+            }
+            uint64_t staleSlots = 0;
+            status_t result = releaseBuffers(buffers, &staleSlots);
+            reply->writeInt64(staleSlots);
+            reply->writeInt32(result);
+            return NO_ERROR;
+        }
     }
     return BBinder::onTransact(code, data, reply, flags);
 }
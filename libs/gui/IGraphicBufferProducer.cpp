@@ -17,6 +17,9 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <errno.h>
+#include <unistd.h>
+
 #include <utils/Errors.h>
 #include <utils/NativeHandle.h>
 #include <utils/RefBase.h>
@@ -46,6 +49,8 @@ enum {
     DISCONNECT,
     SET_SIDEBAND_STREAM,
     ALLOCATE_BUFFERS,
+    GET_CONTROL_CHANNEL,
+    ATTACH_AND_QUEUE_BUFFER,
 };
 
 class BpGraphicBufferProducer : public BpInterface<IGraphicBufferProducer>
@@ -268,6 +273,46 @@ public:
             ALOGE("allocateBuffers failed to transact: %d", result);
         }
     }
+
+    virtual status_t getControlChannel(int* outFd) {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGraphicBufferProducer::getInterfaceDescriptor());
+        status_t result = remote()->transact(GET_CONTROL_CHANNEL, data, &reply);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        result = reply.readInt32();
+        if (result == NO_ERROR) {
+            int fd = dup(reply.readFileDescriptor());
+            if (fd < 0) {
+                return -errno;
+            }
+            *outFd = fd;
+        }
+        return result;
+    }
+
+    virtual status_t attachAndQueueBuffer(int* outSlot,
+            const sp<GraphicBuffer>& buffer, const QueueBufferInput& input,
+            QueueBufferOutput* output) {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGraphicBufferProducer::getInterfaceDescriptor());
+        data.write(*buffer.get());
+        data.write(input);
+        status_t result = remote()->transact(ATTACH_AND_QUEUE_BUFFER, data,
+                &reply);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        *outSlot = reply.readInt32();
+        const void* out = reply.readInplace(sizeof(*output));
+        if (out == NULL) {
+            return BAD_VALUE;
+        }
+        memcpy(output, out, sizeof(*output));
+        result = reply.readInt32();
+        return result;
+    }
 };
 
 IMPLEMENT_META_INTERFACE(GraphicBufferProducer, "android.gui.IGraphicBufferProducer");
@@ -410,6 +455,34 @@ status_t BnGraphicBufferProducer::onTransact(
             reply->writeInt32(result);
             return NO_ERROR;
         } break;
+        case GET_CONTROL_CHANNEL: {
+            CHECK_INTERFACE(IGraphicBufferProducer, data, reply);
+            int fd = -1;
+            status_t result = getControlChannel(&fd);
+            reply->writeInt32(result);
+            if (result == NO_ERROR) {
+                reply->writeFileDescriptor(fd, true);
+            }
+            return NO_ERROR;
+        }
+        case ATTACH_AND_QUEUE_BUFFER: {
+            CHECK_INTERFACE(IGraphicBufferProducer, data, reply);
+            sp<GraphicBuffer> buffer = new GraphicBuffer();
+            data.read(*buffer.get());
+            QueueBufferInput input(data);
+            int slot = -1;
+            QueueBufferOutput output;
+            status_t result = attachAndQueueBuffer(&slot, buffer, input,
+                    &output);
+            reply->writeInt32(slot);
+            void* out = reply->writeInplace(sizeof(output));
+            if (out == NULL) {
+                return NO_MEMORY;
+            }
+            memcpy(out, &output, sizeof(output));
+            reply->writeInt32(result);
+            return NO_ERROR;
+        }
         case ALLOCATE_BUFFERS:
             CHECK_INTERFACE(IGraphicBufferProducer, data, reply);
             bool async = static_cast<bool>(data.readInt32());
@@ -437,6 +510,7 @@ size_t IGraphicBufferProducer::QueueBufferInput::getFlattenedSize() const {
          + sizeof(transform)
          + sizeof(stickyTransform)
          + sizeof(async)
+         + sizeof(surfaceDamage)
          + fence->getFlattenedSize();
 }
 
@@ -457,6 +531,7 @@ status_t IGraphicBufferProducer::QueueBufferInput::flatten(
     FlattenableUtils::write(buffer, size, transform);
     FlattenableUtils::write(buffer, size, stickyTransform);
     FlattenableUtils::write(buffer, size, async);
+    FlattenableUtils::write(buffer, size, surfaceDamage);
     return fence->flatten(buffer, size, fds, count);
 }
 
@@ -470,7 +545,8 @@ status_t IGraphicBufferProducer::QueueBufferInput::unflatten(
             + sizeof(scalingMode)
             + sizeof(transform)
             + sizeof(stickyTransform)
-            + sizeof(async);
+            + sizeof(async)
+            + sizeof(surfaceDamage);
 
     if (size < minNeeded) {
         return NO_MEMORY;
@@ -483,6 +559,7 @@ status_t IGraphicBufferProducer::QueueBufferInput::unflatten(
     FlattenableUtils::read(buffer, size, transform);
     FlattenableUtils::read(buffer, size, stickyTransform);
     FlattenableUtils::read(buffer, size, async);
+    FlattenableUtils::read(buffer, size, surfaceDamage);
 
     fence = new Fence();
     return fence->unflatten(buffer, size, fds, count);
@@ -14,8 +14,10 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
@@ -34,9 +36,14 @@ enum {
     GET_SENSOR_CHANNEL = IBinder::FIRST_CALL_TRANSACTION,
     ENABLE_DISABLE,
     SET_EVENT_RATE,
-    FLUSH_SENSOR
+    FLUSH_SENSOR,
+    GET_EVENT_RING,
+    CONFIGURE_SENSORS
 };
 
+// More configs than sensors a device could have is a malformed request.
+static const size_t MAX_SENSOR_CONFIGS = 256;
+
 class BpSensorEventConnection : public BpInterface<ISensorEventConnection>
 {
 public:
@@ -83,10 +90,67 @@ public:
         remote()->transact(FLUSH_SENSOR, data, &reply);
         return reply.readInt32();
     }
+
+    virtual status_t getEventRing(int* outFd) {
+        Parcel data, reply;
+        data.writeInterfaceToken(ISensorEventConnection::getInterfaceDescriptor());
+        status_t result = remote()->transact(GET_EVENT_RING, data, &reply);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        result = reply.readInt32();
+        if (result == NO_ERROR) {
+            int fd = dup(reply.readFileDescriptor());
+            if (fd < 0) {
+                return -errno;
+            }
+            *outFd = fd;
+        }
+        return result;
+    }
+
+    virtual status_t configureSensors(const Vector<SensorConfig>& configs,
+                                      Vector<status_t>* outResults) {
+        Parcel data, reply;
+        data.writeInterfaceToken(ISensorEventConnection::getInterfaceDescriptor());
+        data.writeInt32(configs.size());
+        for (size_t i = 0; i < configs.size(); i++) {
+            const SensorConfig& config(configs[i]);
+            data.writeInt32(config.handle);
+            data.writeInt32(config.enabled);
+            data.writeInt64(config.samplingPeriodNs);
+            data.writeInt64(config.maxBatchReportLatencyNs);
+            data.writeInt32(config.reservedFlags);
+        }
+        status_t result = remote()->transact(CONFIGURE_SENSORS, data, &reply);
+        if (result != NO_ERROR) {
+            return result;
+        }
+        result = reply.readInt32();
+        if (result == NO_ERROR) {
+            outResults->clear();
+            for (size_t i = 0; i < configs.size(); i++) {
+                outResults->add(reply.readInt32());
+            }
+        }
+        return result;
+    }
 };
 
 IMPLEMENT_META_INTERFACE(SensorEventConnection, "android.gui.SensorEventConnection");
 
+status_t ISensorEventConnection::configureSensors(
+        const Vector<SensorConfig>& configs, Vector<status_t>* outResults) {
+    outResults->clear();
+    for (size_t i = 0; i < configs.size(); i++) {
+        const SensorConfig& config(configs[i]);
+        outResults->add(enableDisable(config.handle, config.enabled,
+                config.samplingPeriodNs, config.maxBatchReportLatencyNs,
+                config.reservedFlags));
+    }
+    return NO_ERROR;
+}
+
 // ----------------------------------------------------------------------------
 
 status_t BnSensorEventConnection::onTransact(
@@ -125,6 +189,44 @@ status_t BnSensorEventConnection::onTransact(
             reply->writeInt32(result);
             return NO_ERROR;
         } break;
+        case CONFIGURE_SENSORS: {
+            CHECK_INTERFACE(ISensorEventConnection, data, reply);
+            size_t count = data.readInt32();
+            if (count > MAX_SENSOR_CONFIGS) {
+                reply->writeInt32(BAD_VALUE);
+                return NO_ERROR;
+            }
+            Vector<SensorConfig> configs;
+            configs.setCapacity(count);
+            for (size_t i = 0; i < count; i++) {
+                SensorConfig config;
+                config.handle = data.readInt32();
+                config.enabled = data.readInt32();
+                config.samplingPeriodNs = data.readInt64();
+                config.maxBatchReportLatencyNs = data.readInt64();
+                config.reservedFlags = data.readInt32();
+                configs.add(config);
+            }
+            Vector<status_t> results;
+            status_t result = configureSensors(configs, &results);
+            reply->writeInt32(result);
+            if (result == NO_ERROR) {
+                for (size_t i = 0; i < count; i++) {
+                    reply->writeInt32(i < results.size() ? results[i] : UNKNOWN_ERROR);
+                }
+            }
+            return NO_ERROR;
+        } break;
+        case GET_EVENT_RING: {
+            CHECK_INTERFACE(ISensorEventConnection, data, reply);
+            int fd = -1;
+            status_t result = getEventRing(&fd);
+            reply->writeInt32(result);
+            if (result == NO_ERROR) {
+                reply->writeFileDescriptor(fd, true);
+            }
+            return NO_ERROR;
+        } break;
     }
     return BBinder::onTransact(code, data, reply, flags);
 }
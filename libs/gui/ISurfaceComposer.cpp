@@ -289,6 +289,66 @@ public:
         reply.read(*outStats);
         return reply.readInt32();
     }
+
+    virtual status_t getLayerFrameStatInfo(Vector<String8>* outNames,
+            Vector<FrameStatInfo>* outInfos) const {
+        if (outNames == NULL || outInfos == NULL) {
+            return BAD_VALUE;
+        }
+        Parcel data, reply;
+        data.writeInterfaceToken(ISurfaceComposer::getInterfaceDescriptor());
+        remote()->transact(BnSurfaceComposer::GET_LAYER_FRAME_STAT_INFO,
+                data, &reply);
+        status_t result = reply.readInt32();
+        if (result == NO_ERROR) {
+            size_t count = reply.readInt32();
+            outNames->clear();
+            outInfos->clear();
+            outNames->setCapacity(count);
+            outInfos->setCapacity(count);
+            for (size_t i = 0; i < count; i++) {
+                const void* info = reply.readInplace(sizeof(FrameStatInfo));
+                if (info == NULL) {
+                    return BAD_VALUE;
+                }
+                outInfos->add(*static_cast<const FrameStatInfo*>(info));
+                outNames->add(reply.readString8());
+            }
+        }
+        return result;
+    }
+
+    virtual status_t getCompositionTimeline(
+            Vector<CompositionTiming>* outTimings) const {
+        if (outTimings == NULL) {
+            return BAD_VALUE;
+        }
+        Parcel data, reply;
+        data.writeInterfaceToken(ISurfaceComposer::getInterfaceDescriptor());
+        remote()->transact(BnSurfaceComposer::GET_COMPOSITION_TIMELINE,
+                data, &reply);
+        status_t result = reply.readInt32();
+        if (result == NO_ERROR) {
+            size_t count = reply.readInt32();
+            outTimings->clear();
+            if (count == 0) {
+                return result;
+            }
+            // count comes from the remote; bound it by what the reply holds
+            // so count * sizeof(CompositionTiming) can't overflow.
+            if (count > reply.dataAvail() / sizeof(CompositionTiming)) {
+                return BAD_VALUE;
+            }
+            const void* timings =
+                    reply.readInplace(count * sizeof(CompositionTiming));
+            if (timings == NULL) {
+                return BAD_VALUE;
+            }
+            outTimings->appendArray(
+                    static_cast<const CompositionTiming*>(timings), count);
+        }
+        return result;
+    }
 };
 
 IMPLEMENT_META_INTERFACE(SurfaceComposer, "android.ui.ISurfaceComposer");
@@ -451,6 +511,41 @@ status_t BnSurfaceComposer::onTransact(
             reply->writeInt32(result);
             return NO_ERROR;
         }
+        case GET_LAYER_FRAME_STAT_INFO: {
+            CHECK_INTERFACE(ISurfaceComposer, data, reply);
+            Vector<String8> names;
+            Vector<FrameStatInfo> infos;
+            status_t result = getLayerFrameStatInfo(&names, &infos);
+            reply->writeInt32(result);
+            if (result == NO_ERROR) {
+                reply->writeInt32(static_cast<int32_t>(infos.size()));
+                for (size_t i = 0; i < infos.size(); i++) {
+                    memcpy(reply->writeInplace(sizeof(FrameStatInfo)),
+                            &infos[i], sizeof(FrameStatInfo));
+                    reply->writeString8(names[i]);
+                }
+            }
+            return NO_ERROR;
+        }
+        case GET_COMPOSITION_TIMELINE: {
+            CHECK_INTERFACE(ISurfaceComposer, data, reply);
+            Vector<CompositionTiming> timings;
+            status_t result = getCompositionTimeline(&timings);
+            reply->writeInt32(result);
+            if (result == NO_ERROR) {
+                reply->writeInt32(static_cast<int32_t>(timings.size()));
+                if (!timings.isEmpty()) {
+                    const size_t size =
+                            timings.size() * sizeof(CompositionTiming);
+                    void* dest = reply->writeInplace(size);
+                    if (dest == NULL) {
+                        return NO_MEMORY;
+                    }
+                    memcpy(dest, timings.array(), size);
+                }
+            }
+            return NO_ERROR;
+        }
         case SET_POWER_MODE: {
             CHECK_INTERFACE(ISurfaceComposer, data, reply);
             sp<IBinder> display = data.readStrongBinder();
@@ -22,44 +22,83 @@
 
 namespace android {
 
+// Only the fields flagged in what are written, in the order of the flags,
+// so a transaction moving many layers doesn't send their matrix, crop and
+// transparent region every frame. read() leaves the other fields untouched.
+
 status_t layer_state_t::write(Parcel& output) const
 {
     output.writeStrongBinder(surface);
     output.writeInt32(what);
-    output.writeFloat(x);
-    output.writeFloat(y);
-    output.writeInt32(z);
-    output.writeInt32(w);
-    output.writeInt32(h);
-    output.writeInt32(layerStack);
-    output.writeFloat(alpha);
-    output.writeInt32(flags);
-    output.writeInt32(mask);
-    *reinterpret_cast<layer_state_t::matrix22_t *>(
-            output.writeInplace(sizeof(layer_state_t::matrix22_t))) = matrix;
-    output.write(crop);
-    output.write(transparentRegion);
+    if (what & ePositionChanged) {
+        output.writeFloat(x);
+        output.writeFloat(y);
+    }
+    if (what & eLayerChanged) {
+        output.writeInt32(z);
+    }
+    if (what & eSizeChanged) {
+        output.writeInt32(w);
+        output.writeInt32(h);
+    }
+    if (what & eAlphaChanged) {
+        output.writeFloat(alpha);
+    }
+    if (what & eMatrixChanged) {
+        output.writeTrivial(matrix);
+    }
+    if (what & eTransparentRegionChanged) {
+        output.write(transparentRegion);
+    }
+    if (what & (eVisibilityChanged | eOpacityChanged)) {
+        output.writeInt32(flags);
+        output.writeInt32(mask);
+    }
+    if (what & eLayerStackChanged) {
+        output.writeInt32(layerStack);
+    }
+    if (what & eCropChanged) {
+        output.writeTrivial(crop);
+    }
     return NO_ERROR;
 }
 
 status_t layer_state_t::read(const Parcel& input)
 {
+    status_t err = NO_ERROR;
     surface = input.readStrongBinder();
     what = input.readInt32();
-    x = input.readFloat();
-    y = input.readFloat();
-    z = input.readInt32();
-    w = input.readInt32();
-    h = input.readInt32();
-    layerStack = input.readInt32();
-    alpha = input.readFloat();
-    flags = input.readInt32();
-    mask = input.readInt32();
-    matrix = *reinterpret_cast<layer_state_t::matrix22_t const *>(
-            input.readInplace(sizeof(layer_state_t::matrix22_t)));
-    input.read(crop);
-    input.read(transparentRegion);
-    return NO_ERROR;
+    if (what & ePositionChanged) {
+        x = input.readFloat();
+        y = input.readFloat();
+    }
+    if (what & eLayerChanged) {
+        z = input.readInt32();
+    }
+    if (what & eSizeChanged) {
+        w = input.readInt32();
+        h = input.readInt32();
+    }
+    if (what & eAlphaChanged) {
+        alpha = input.readFloat();
+    }
+    if ((what & eMatrixChanged) && err == NO_ERROR) {
+        err = input.readTrivial(&matrix);
+    }
+    if ((what & eTransparentRegionChanged) && err == NO_ERROR) {
+        err = input.read(transparentRegion);
+    }
+    if (what & (eVisibilityChanged | eOpacityChanged)) {
+        flags = input.readInt32();
+        mask = input.readInt32();
+    }
+    if (what & eLayerStackChanged) {
+        layerStack = input.readInt32();
+    }
+    if ((what & eCropChanged) && err == NO_ERROR) {
+        err = input.readTrivial(&crop);
+    }
+    return err;
 }
 
 status_t ComposerState::write(Parcel& output) const {
@@ -73,29 +112,47 @@ status_t ComposerState::read(const Parcel& input) {
 }
 
 
+// As for layer_state_t, the fixed size part of a DisplayState.
+struct display_state_data_t {
+    uint32_t    what;
+    uint32_t    layerStack;
+    uint32_t    orientation;
+    Rect        viewport;
+    Rect        frame;
+    uint32_t    width;
+    uint32_t    height;
+};
+
 status_t DisplayState::write(Parcel& output) const {
+    display_state_data_t data;
+    data.what = what;
+    data.layerStack = layerStack;
+    data.orientation = orientation;
+    data.viewport = viewport;
+    data.frame = frame;
+    data.width = width;
+    data.height = height;
+
     output.writeStrongBinder(token);
     output.writeStrongBinder(surface->asBinder());
-    output.writeInt32(what);
-    output.writeInt32(layerStack);
-    output.writeInt32(orientation);
-    output.write(viewport);
-    output.write(frame);
-    output.writeInt32(width);
-    output.writeInt32(height);
-    return NO_ERROR;
+    return output.writeTrivial(data);
 }
 
 status_t DisplayState::read(const Parcel& input) {
     token = input.readStrongBinder();
     surface = interface_cast<IGraphicBufferProducer>(input.readStrongBinder());
-    what = input.readInt32();
-    layerStack = input.readInt32();
-    orientation = input.readInt32();
-    input.read(viewport);
-    input.read(frame);
-    width = input.readInt32();
-    height = input.readInt32();
+    display_state_data_t data;
+    status_t err = input.readTrivial(&data);
+    if (err != NO_ERROR) {
+        return err;
+    }
+    what = data.what;
+    layerStack = data.layerStack;
+    orientation = data.orientation;
+    viewport = data.viewport;
+    frame = data.frame;
+    width = data.width;
+    height = data.height;
     return NO_ERROR;
 }
 
@@ -29,6 +29,8 @@
 #include <gui/SensorEventQueue.h>
 #include <gui/ISensorEventConnection.h>
 
+#include <private/gui/SensorEventRing.h>
+
 #include <android/sensor.h>
 
 // ----------------------------------------------------------------------------
@@ -37,7 +39,7 @@ namespace android {
 
 SensorEventQueue::SensorEventQueue(const sp<ISensorEventConnection>& connection)
     : mSensorEventConnection(connection), mRecBuffer(NULL), mAvailable(0), mConsumed(0),
-      mNumAcksToSend(0) {
+      mNumAcksToSend(0), mFlushCoalescingWindow(0), mLastFlushTime(0) {
     mRecBuffer = new ASensorEvent[MAX_RECEIVE_BUFFER_EVENT_COUNT];
 }
 
@@ -48,6 +50,10 @@ SensorEventQueue::~SensorEventQueue() {
 void SensorEventQueue::onFirstRef()
 {
     mSensorChannel = mSensorEventConnection->getSensorChannel();
+    int fd = -1;
+    if (mSensorEventConnection->getEventRing(&fd) == NO_ERROR) {
+        mRing = SensorEventRing::map(fd);
+    }
 }
 
 int SensorEventQueue::getFd() const
@@ -63,13 +69,17 @@ ssize_t SensorEventQueue::write(const sp<BitTube>& tube,
 
 ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
     if (mAvailable == 0) {
-        ssize_t err = BitTube::recvObjects(mSensorChannel,
-                mRecBuffer, MAX_RECEIVE_BUFFER_EVENT_COUNT);
-        if (err < 0) {
+        if (mRing != NULL) {
+            return readFromRing(events, numEvents);
+        }
+        if (numEvents >= MAX_RECEIVE_BUFFER_EVENT_COUNT) {
+            // SensorService never sends more events than that at once
+            return BitTube::recvObjects(mSensorChannel, events, numEvents);
+        }
+        ssize_t err = fillRecBuffer();
+        if (err <= 0) {
             return err;
         }
-        mAvailable = err;
-        mConsumed = 0;
     }
     size_t count = numEvents < mAvailable ? numEvents : mAvailable;
     memcpy(events, mRecBuffer + mConsumed, count*sizeof(ASensorEvent));
@@ -78,6 +88,59 @@ ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
     return count;
 }
 
+ssize_t SensorEventQueue::readCompact(CompactSensorEvent* events, size_t numEvents) {
+    if (mAvailable == 0) {
+        ssize_t err = fillRecBuffer();
+        if (err <= 0) {
+            return err;
+        }
+    }
+    size_t count = numEvents < mAvailable ? numEvents : mAvailable;
+    ASensorEvent const* in = mRecBuffer + mConsumed;
+    for (size_t i = 0; i < count; i++) {
+        events[i].timestamp = in[i].timestamp;
+        events[i].sensor = in[i].sensor;
+        events[i].type = in[i].type;
+        memcpy(events[i].values, in[i].data, sizeof(events[i].values));
+        events[i].flags = in[i].flags;
+    }
+    mAvailable -= count;
+    mConsumed += count;
+    return count;
+}
+
+ssize_t SensorEventQueue::fillRecBuffer() {
+    ssize_t err = mRing != NULL ?
+            readFromRing(mRecBuffer, MAX_RECEIVE_BUFFER_EVENT_COUNT) :
+            BitTube::recvObjects(mSensorChannel, mRecBuffer, MAX_RECEIVE_BUFFER_EVENT_COUNT);
+    if (err < 0) {
+        return err;
+    }
+    mAvailable = err;
+    mConsumed = 0;
+    return err;
+}
+
+ssize_t SensorEventQueue::readFromRing(ASensorEvent* events, size_t numEvents) {
+    size_t count = mRing->read(events, numEvents);
+    if (count == 0) {
+        // The ring is empty: drop the wakeups we got so far and ask for one
+        // with the next event. Events written in between are read now.
+        char wakeups[16];
+        while (::recv(mSensorChannel->getFd(), wakeups, sizeof(wakeups), MSG_DONTWAIT) > 0) {
+        }
+        if (mRing->armReaderWakeup()) {
+            return 0;
+        }
+        count = mRing->read(events, numEvents);
+    }
+    if (mRing->takeWriterWaiting()) {
+        // SensorService had to keep events back, tell it there is room now
+        sendToService(0);
+    }
+    return count;
+}
+
 sp<Looper> SensorEventQueue::getLooper() const
 {
     Mutex::Autolock _l(mLock);
@@ -135,9 +198,31 @@ status_t SensorEventQueue::enableSensor(int32_t handle, int32_t samplingPeriodUs
 }
 
 status_t SensorEventQueue::flush() const {
+    { // scope for the lock
+        Mutex::Autolock _l(mLock);
+        if (mFlushCoalescingWindow > 0) {
+            const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+            if (mLastFlushTime != 0 && now - mLastFlushTime < mFlushCoalescingWindow) {
+                return NO_ERROR;
+            }
+            mLastFlushTime = now;
+        }
+    }
     return mSensorEventConnection->flush();
 }
 
+void SensorEventQueue::setFlushCoalescingWindow(nsecs_t window) {
+    Mutex::Autolock _l(mLock);
+    mFlushCoalescingWindow = window;
+    mLastFlushTime = 0;
+}
+
+status_t SensorEventQueue::configureSensors(
+        const Vector<ISensorEventConnection::SensorConfig>& configs,
+        Vector<status_t>* results) const {
+    return mSensorEventConnection->configureSensors(configs, results);
+}
+
 status_t SensorEventQueue::disableSensor(int32_t handle) const {
     return mSensorEventConnection->enableDisable(handle, false, 0, 0, false);
 }
@@ -152,17 +237,34 @@ void SensorEventQueue::sendAck(const ASensorEvent* events, int count) {
             ++mNumAcksToSend;
         }
     }
-    // Send mNumAcksToSend to acknowledge for the wake up sensor events received.
-    if (mNumAcksToSend > 0) {
-        ssize_t size = ::send(mSensorChannel->getFd(), &mNumAcksToSend, sizeof(mNumAcksToSend),
-                MSG_DONTWAIT | MSG_NOSIGNAL);
-        if (size < 0) {
-            ALOGE("sendAck failure %d %d", size, mNumAcksToSend);
-        } else {
-            mNumAcksToSend = 0;
+    sendPendingAcks();
+}
+
+void SensorEventQueue::sendAck(const CompactSensorEvent* events, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (events[i].flags & WAKE_UP_SENSOR_EVENT_NEEDS_ACK) {
+            ++mNumAcksToSend;
         }
     }
-    return;
+    sendPendingAcks();
+}
+
+void SensorEventQueue::sendPendingAcks() {
+    // Send mNumAcksToSend to acknowledge for the wake up sensor events received.
+    if (mNumAcksToSend > 0 && sendToService(mNumAcksToSend)) {
+        mNumAcksToSend = 0;
+    }
+}
+
+bool SensorEventQueue::sendToService(uint32_t count) {
+    // A count of zero isn't an ack, it says there's room in the event ring.
+    ssize_t size = ::send(mSensorChannel->getFd(), &count, sizeof(count),
+            MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (size < 0) {
+        ALOGE("sendAck failure %d %d", size, count);
+        return false;
+    }
+    return true;
 }
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "SensorEventRing"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cutils/ashmem.h>
+#include <cutils/atomic.h>
+
+#include <private/gui/SensorEventRing.h>
+
+#include <utils/Log.h>
+
+#include <android/sensor.h>
+
+namespace android {
+
+size_t SensorEventRing::sizeFor(size_t capacity) {
+    return sizeof(sensor_event_ring_t) + capacity * sizeof(ASensorEvent);
+}
+
+sp<SensorEventRing> SensorEventRing::create(size_t capacity) {
+    if (capacity == 0 || capacity > INT32_MAX / sizeof(ASensorEvent)) {
+        return NULL;
+    }
+    const size_t size = sizeFor(capacity);
+    int fd = ashmem_create_region("SensorEventRing", size);
+    if (fd < 0) {
+        ALOGE("can't create event ring: %s", strerror(errno));
+        return NULL;
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("can't map event ring: %s", strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    sensor_event_ring_t* ring = static_cast<sensor_event_ring_t*>(base);
+    memset(ring, 0, sizeof(sensor_event_ring_t));
+    ring->version = sensor_event_ring_t::VERSION;
+    ring->capacity = capacity;
+    return new SensorEventRing(fd, ring, size);
+}
+
+sp<SensorEventRing> SensorEventRing::map(int fd) {
+    const int size = ashmem_get_size_region(fd);
+    if (size < int(sizeof(sensor_event_ring_t))) {
+        ALOGE("bad event ring size %d", size);
+        close(fd);
+        return NULL;
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("can't map event ring: %s", strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    sensor_event_ring_t* ring = static_cast<sensor_event_ring_t*>(base);
+    if (ring->version != sensor_event_ring_t::VERSION || ring->capacity == 0 ||
+            sizeFor(ring->capacity) > size_t(size)) {
+        ALOGE("event ring version %u capacity %u, expected version %u",
+                ring->version, ring->capacity, sensor_event_ring_t::VERSION);
+        munmap(base, size);
+        close(fd);
+        return NULL;
+    }
+    return new SensorEventRing(fd, ring, size);
+}
+
+SensorEventRing::SensorEventRing(int fd, sensor_event_ring_t* ring,
+        size_t size) :
+    mFd(fd),
+    mRing(ring),
+    mEvents(reinterpret_cast<ASensorEvent*>(ring + 1)),
+    mSize(size),
+    // read once: the other process could change it under us
+    mCapacity(ring->capacity)
+{
+}
+
+SensorEventRing::~SensorEventRing() {
+    munmap(mRing, mSize);
+    close(mFd);
+}
+
+ssize_t SensorEventRing::write(ASensorEvent const* events, size_t numEvents,
+        bool* outWakeReader) {
+    const uint32_t w = uint32_t(mRing->writeIndex);
+    uint32_t used = w - uint32_t(android_atomic_acquire_load(&mRing->readIndex));
+    if (numEvents > mCapacity - used) {
+        // ask to be told once there's room, then check again in case the
+        // reader made room before it could see the flag
+        android_atomic_or(1, &mRing->writerWaiting);
+        used = w - uint32_t(android_atomic_acquire_load(&mRing->readIndex));
+        if (numEvents > mCapacity - used) {
+            return -EAGAIN;
+        }
+        android_atomic_and(0, &mRing->writerWaiting);
+    }
+
+    const uint32_t start = w % mCapacity;
+    const size_t first = numEvents < mCapacity - start ?
+            numEvents : mCapacity - start;
+    memcpy(mEvents + start, events, first * sizeof(ASensorEvent));
+    memcpy(mEvents, events + first, (numEvents - first) * sizeof(ASensorEvent));
+    android_atomic_add(int32_t(numEvents), &mRing->writeIndex);
+
+    *outWakeReader = android_atomic_and(0, &mRing->readerWaiting) != 0;
+    return numEvents;
+}
+
+size_t SensorEventRing::read(ASensorEvent* events, size_t numEvents) {
+    const uint32_t r = uint32_t(mRing->readIndex);
+    uint32_t available =
+            uint32_t(android_atomic_acquire_load(&mRing->writeIndex)) - r;
+    if (available > mCapacity) {
+        ALOGE("event ring overrun (%u events, capacity %u)", available,
+                mCapacity);
+        available = mCapacity;
+    }
+    const size_t count = numEvents < available ? numEvents : available;
+    if (count == 0) {
+        return 0;
+    }
+
+    const uint32_t start = r % mCapacity;
+    const size_t first = count < mCapacity - start ? count : mCapacity - start;
+    memcpy(events, mEvents + start, first * sizeof(ASensorEvent));
+    memcpy(events + first, mEvents, (count - first) * sizeof(ASensorEvent));
+    android_atomic_add(int32_t(count), &mRing->readIndex);
+    return count;
+}
+
+bool SensorEventRing::armReaderWakeup() {
+    android_atomic_or(1, &mRing->readerWaiting);
+    return android_atomic_acquire_load(&mRing->writeIndex) ==
+            mRing->readIndex;
+}
+
+bool SensorEventRing::takeWriterWaiting() {
+    if (android_atomic_acquire_load(&mRing->writerWaiting) == 0) {
+        return false;
+    }
+    return android_atomic_and(0, &mRing->writerWaiting) != 0;
+}
+
+}; // namespace android
@@ -144,27 +144,16 @@ void StreamSplitter::onFrameAvailable() {
             bufferItem.mCrop, bufferItem.mScalingMode,
             bufferItem.mTransform, bufferItem.mIsDroppable,
             bufferItem.mFence);
+    queueInput.setSurfaceDamage(bufferItem.mSurfaceDamage);
 
-    // Attach and queue the buffer to each of the outputs
+    // Attach and queue the buffer to each of the outputs. This is a single
+    // call per output, so the cost of adding an output is one transaction.
     Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
     for (; output != mOutputs.end(); ++output) {
         int slot;
-        status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
-        if (status == NO_INIT) {
-            // If we just discovered that this output has been abandoned, note
-            // that, increment the release count so that we still release this
-            // buffer eventually, and move on to the next output
-            onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
-            continue;
-        } else {
-            LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-                    "attaching buffer to output failed (%d)", status);
-        }
-
         IGraphicBufferProducer::QueueBufferOutput queueOutput;
-        status = (*output)->queueBuffer(slot, queueInput, &queueOutput);
+        status = (*output)->attachAndQueueBuffer(&slot,
+                bufferItem.mGraphicBuffer, queueInput, &queueOutput);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
@@ -175,7 +164,8 @@ void StreamSplitter::onFrameAvailable() {
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-                    "queueing buffer to output failed (%d)", status);
+                    "attaching and queueing buffer to output failed (%d)",
+                    status);
         }
 
         ALOGV("queued buffer %#" PRIx64 " to output %p",
@@ -206,9 +196,10 @@ void StreamSplitter::onBufferReleasedByOutput(
 
     const sp<BufferTracker>& tracker = mBuffers.editValueFor(buffer->getId());
 
-    // Merge the release fence of the incoming buffer so that the fence we send
-    // back to the input includes all of the outputs' fences
-    tracker->mergeFence(fence);
+    // Collect the release fence of the incoming buffer so that the fence we
+    // send back to the input includes all of the outputs' fences. They are
+    // only merged once the last output has released the buffer.
+    tracker->addFence(fence);
 
     // Check to see if this is the last outstanding reference to this buffer
     size_t releaseCount = tracker->incrementReleaseCountLocked();
@@ -232,7 +223,7 @@ void StreamSplitter::onBufferReleasedByOutput(
             "attaching buffer to input failed (%d)", status);
 
     status = mInput->releaseBuffer(consumerSlot, /* frameNumber */ 0,
-            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, tracker->getMergedFence());
+            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, tracker->mergeFences());
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "releasing buffer to input failed (%d)", status);
 
@@ -273,12 +264,16 @@ void StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who */) {
 }
 
 StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer)
-      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mReleaseCount(0) {}
+      : mBuffer(buffer), mReleaseFences(), mReleaseCount(0) {}
 
 StreamSplitter::BufferTracker::~BufferTracker() {}
 
-void StreamSplitter::BufferTracker::mergeFence(const sp<Fence>& with) {
-    mMergedFence = Fence::merge(String8("StreamSplitter"), mMergedFence, with);
+void StreamSplitter::BufferTracker::addFence(const sp<Fence>& fence) {
+    mReleaseFences.add(fence);
+}
+
+sp<Fence> StreamSplitter::BufferTracker::mergeFences() {
+    return mReleaseFences.merge(String8("StreamSplitter"));
 }
 
 } // namespace android
@@ -18,11 +18,17 @@
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 //#define LOG_NDEBUG 0
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <android/native_window.h>
 
 #include <binder/Parcel.h>
 
+#include <cutils/properties.h>
+
 #include <utils/Log.h>
+#include <utils/Thread.h>
 #include <utils/Trace.h>
 #include <utils/NativeHandle.h>
 
@@ -34,10 +40,157 @@
 #include <gui/GLConsumer.h>
 #include <gui/Surface.h>
 
+#include <private/gui/BufferQueueControl.h>
 #include <private/gui/ComposerService.h>
 
 namespace android {
 
+// Dequeues a single buffer ahead of time on its own thread. It only talks to
+// the IGraphicBufferProducer, never to the Surface, so that it can outlive it
+// while a dequeueBuffer call is still blocked.
+class Surface::DequeueAhead : public Thread {
+public:
+    struct Params {
+        bool async;
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+        uint32_t usage;
+
+        bool operator == (const Params& rhs) const {
+            return async == rhs.async && width == rhs.width &&
+                    height == rhs.height && format == rhs.format &&
+                    usage == rhs.usage;
+        }
+    };
+
+    DequeueAhead(const sp<IGraphicBufferProducer>& producer) :
+        Thread(false), mProducer(producer), mState(IDLE), mSlot(-1),
+        mResult(NO_ERROR) {
+        memset(&mParams, 0, sizeof(mParams));
+    }
+
+    // request starts dequeueing a buffer, unless one is already being
+    // dequeued or waiting to be taken.
+    void request(const Params& params) {
+        Mutex::Autolock lock(mMutex);
+        if (mState == IDLE) {
+            mParams = params;
+            mState = REQUESTED;
+            mCondition.broadcast();
+        }
+    }
+
+    // take waits for the requested buffer and returns it if it was dequeued
+    // with the given parameters. A buffer dequeued with other parameters is
+    // canceled. Returns false if there is no buffer to use.
+    bool take(const Params& params, int* outSlot, sp<Fence>* outFence,
+            status_t* outResult) {
+        Mutex::Autolock lock(mMutex);
+        while (mState == REQUESTED || mState == DEQUEUEING) {
+            mCondition.wait(mMutex);
+        }
+        if (mState != DONE) {
+            return false;
+        }
+        mState = IDLE;
+        if (mResult < 0) {
+            return false;
+        }
+        if (!(params == mParams)) {
+            mProducer->cancelBuffer(mSlot, mFence);
+            return false;
+        }
+        *outSlot = mSlot;
+        *outFence = mFence;
+        *outResult = mResult;
+        mFence.clear();
+        return true;
+    }
+
+    // discard waits for the requested buffer, if any, and drops it. It is
+    // canceled unless cancel is false (because the producer disconnected).
+    void discard(bool cancel) {
+        Mutex::Autolock lock(mMutex);
+        while (mState == REQUESTED || mState == DEQUEUEING) {
+            mCondition.wait(mMutex);
+        }
+        if (mState == DONE && mResult >= 0 && cancel) {
+            mProducer->cancelBuffer(mSlot, mFence);
+        }
+        mState = IDLE;
+        mFence.clear();
+    }
+
+    // stop makes the thread exit without waiting for it. A buffer that is
+    // still being dequeued is canceled by the thread once it gets it.
+    void stop() {
+        requestExit();
+        Mutex::Autolock lock(mMutex);
+        if (mState == DONE && mResult >= 0) {
+            mProducer->cancelBuffer(mSlot, mFence);
+        }
+        if (mState != DEQUEUEING) {
+            mState = IDLE;
+        }
+        mFence.clear();
+        mCondition.broadcast();
+    }
+
+private:
+    enum State { IDLE, REQUESTED, DEQUEUEING, DONE };
+
+    virtual bool threadLoop() {
+        Params params;
+        {
+            Mutex::Autolock lock(mMutex);
+            while (mState != REQUESTED && !exitPending()) {
+                mCondition.wait(mMutex);
+            }
+            if (exitPending()) {
+                return false;
+            }
+            mState = DEQUEUEING;
+            params = mParams;
+        }
+
+        ATRACE_NAME("dequeueAhead");
+        int slot = -1;
+        sp<Fence> fence;
+        status_t result = mProducer->dequeueBuffer(&slot, &fence,
+                params.async, params.width, params.height, params.format,
+                params.usage);
+
+        Mutex::Autolock lock(mMutex);
+        if (exitPending()) {
+            if (result >= 0) {
+                mProducer->cancelBuffer(slot, fence);
+            }
+            mState = IDLE;
+            mCondition.broadcast();
+            return false;
+        }
+        mSlot = slot;
+        mFence = fence;
+        mResult = result;
+        mState = DONE;
+        mCondition.broadcast();
+        return true;
+    }
+
+    const sp<IGraphicBufferProducer> mProducer;
+
+    Mutex mMutex;
+    Condition mCondition;
+    State mState;
+    Params mParams;
+    int mSlot;
+    sp<Fence> mFence;
+    status_t mResult;
+};
+
+// ----------------------------------------------------------------------------
+
 Surface::Surface(
         const sp<IGraphicBufferProducer>& bufferProducer,
         bool controlledByApp)
@@ -65,6 +218,7 @@ Surface::Surface(
     mReqUsage = 0;
     mTimestamp = NATIVE_WINDOW_TIMESTAMP_AUTO;
     mCrop.clear();
+    mSurfaceDamage.makeInvalid();
     mScalingMode = NATIVE_WINDOW_SCALING_MODE_FREEZE;
     mTransform = 0;
     mStickyTransform = 0;
@@ -83,6 +237,9 @@ Surface::~Surface() {
     if (mConnectedToCpu) {
         Surface::disconnect(NATIVE_WINDOW_API_CPU);
     }
+    if (mDequeueAhead != NULL) {
+        mDequeueAhead->stop();
+    }
 }
 
 sp<IGraphicBufferProducer> Surface::getIGraphicBufferProducer() const {
@@ -93,6 +250,25 @@ void Surface::setSidebandStream(const sp<NativeHandle>& stream) {
     mGraphicBufferProducer->setSidebandStream(stream);
 }
 
+void Surface::setDequeueAhead(bool enabled) {
+    Mutex::Autolock lock(mMutex);
+    if (enabled == (mDequeueAhead != NULL)) {
+        return;
+    }
+    if (enabled) {
+        mDequeueAhead = new DequeueAhead(mGraphicBufferProducer);
+        mDequeueAhead->run("SurfaceDequeueAhead", PRIORITY_URGENT_DISPLAY);
+    } else {
+        mDequeueAhead->stop();
+        mDequeueAhead.clear();
+    }
+}
+
+void Surface::setSurfaceDamage(const Rect& damage) {
+    Mutex::Autolock lock(mMutex);
+    mSurfaceDamage = damage;
+}
+
 void Surface::allocateBuffers() {
     uint32_t reqWidth = mReqWidth ? mReqWidth : mUserWidth;
     uint32_t reqHeight = mReqHeight ? mReqHeight : mUserHeight;
@@ -198,6 +374,8 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
     bool swapIntervalZero;
     uint32_t reqFormat;
     uint32_t reqUsage;
+    sp<BufferQueueControlClient> controlChannel;
+    sp<DequeueAhead> dequeueAhead;
 
     {
         Mutex::Autolock lock(mMutex);
@@ -208,12 +386,26 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
         swapIntervalZero = mSwapIntervalZero;
         reqFormat = mReqFormat;
         reqUsage = mReqUsage;
+        controlChannel = mControlChannel;
+        dequeueAhead = mDequeueAhead;
     } // Drop the lock so that we can still touch the Surface while blocking in IGBP::dequeueBuffer
 
     int buf = -1;
     sp<Fence> fence;
-    status_t result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence, swapIntervalZero,
-            reqW, reqH, reqFormat, reqUsage);
+    status_t result;
+    const DequeueAhead::Params params = { swapIntervalZero, uint32_t(reqW),
+            uint32_t(reqH), reqFormat, reqUsage };
+    if (dequeueAhead != NULL &&
+            dequeueAhead->take(params, &buf, &fence, &result)) {
+        // Dequeued while the previous frame was being queued
+    } else if (controlChannel != NULL && controlChannel->dequeueBuffer(&buf,
+            swapIntervalZero, reqW, reqH, reqFormat, reqUsage, &result)) {
+        // The release fence was already waited for on the other side
+        fence = Fence::NO_FENCE;
+    } else {
+        result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence,
+                swapIntervalZero, reqW, reqH, reqFormat, reqUsage);
+    }
 
     if (result < 0) {
         ALOGV("dequeueBuffer: IGraphicBufferProducer::dequeueBuffer(%d, %d, %d, %d, %d)"
@@ -267,6 +459,10 @@ int Surface::cancelBuffer(android_native_buffer_t* buffer,
     if (i < 0) {
         return i;
     }
+    if (fenceFd < 0 && mControlChannel != NULL &&
+            mControlChannel->cancelBuffer(i)) {
+        return OK;
+    }
     sp<Fence> fence(fenceFd >= 0 ? new Fence(fenceFd) : Fence::NO_FENCE);
     mGraphicBufferProducer->cancelBuffer(i, fence);
     return OK;
@@ -315,19 +511,35 @@ int Surface::queueBuffer(android_native_buffer_t* buffer, int fenceFd) {
     Rect crop;
     mCrop.intersect(Rect(buffer->width, buffer->height), &crop);
 
-    sp<Fence> fence(fenceFd >= 0 ? new Fence(fenceFd) : Fence::NO_FENCE);
-    IGraphicBufferProducer::QueueBufferOutput output;
-    IGraphicBufferProducer::QueueBufferInput input(timestamp, isAutoTimestamp,
-            crop, mScalingMode, mTransform ^ mStickyTransform, mSwapIntervalZero,
-            fence, mStickyTransform);
-    status_t err = mGraphicBufferProducer->queueBuffer(i, input, &output);
-    if (err != OK)  {
-        ALOGE("queueBuffer: error queuing buffer to SurfaceTexture, %d", err);
-    }
+    // The damage only describes this frame
+    const Rect damage(mSurfaceDamage);
+    mSurfaceDamage.makeInvalid();
+
+    status_t err;
     uint32_t numPendingBuffers = 0;
     uint32_t hint = 0;
-    output.deflate(&mDefaultWidth, &mDefaultHeight, &hint,
-            &numPendingBuffers);
+    if (fenceFd < 0 && mControlChannel != NULL &&
+            mControlChannel->queueBuffer(i, timestamp, isAutoTimestamp, crop,
+                    mScalingMode, mTransform ^ mStickyTransform,
+                    mStickyTransform, mSwapIntervalZero, damage, &mDefaultWidth,
+                    &mDefaultHeight, &hint, &numPendingBuffers, &err)) {
+        if (err != OK)  {
+            ALOGE("queueBuffer: error queuing buffer to SurfaceTexture, %d", err);
+        }
+    } else {
+        sp<Fence> fence(fenceFd >= 0 ? new Fence(fenceFd) : Fence::NO_FENCE);
+        IGraphicBufferProducer::QueueBufferOutput output;
+        IGraphicBufferProducer::QueueBufferInput input(timestamp, isAutoTimestamp,
+                crop, mScalingMode, mTransform ^ mStickyTransform, mSwapIntervalZero,
+                fence, mStickyTransform);
+        input.setSurfaceDamage(damage);
+        err = mGraphicBufferProducer->queueBuffer(i, input, &output);
+        if (err != OK)  {
+            ALOGE("queueBuffer: error queuing buffer to SurfaceTexture, %d", err);
+        }
+        output.deflate(&mDefaultWidth, &mDefaultHeight, &hint,
+                &numPendingBuffers);
+    }
 
     // Disable transform hint if sticky transform is set.
     if (mStickyTransform == 0) {
@@ -336,6 +548,13 @@ int Surface::queueBuffer(android_native_buffer_t* buffer, int fenceFd) {
 
     mConsumerRunningBehind = (numPendingBuffers >= 2);
 
+    if (err == OK && mDequeueAhead != NULL) {
+        const DequeueAhead::Params params = { mSwapIntervalZero,
+                mReqWidth ? mReqWidth : mUserWidth,
+                mReqHeight ? mReqHeight : mUserHeight, mReqFormat, mReqUsage };
+        mDequeueAhead->request(params);
+    }
+
     return err;
 }
 
@@ -448,6 +667,12 @@ int Surface::perform(int operation, va_list args)
     case NATIVE_WINDOW_SET_SIDEBAND_STREAM:
         res = dispatchSetSidebandStream(args);
         break;
+    case NATIVE_WINDOW_SET_DEQUEUE_AHEAD:
+        res = dispatchSetDequeueAhead(args);
+        break;
+    case NATIVE_WINDOW_SET_SURFACE_DAMAGE:
+        res = dispatchSetSurfaceDamage(args);
+        break;
     default:
         res = NAME_NOT_FOUND;
         break;
@@ -545,6 +770,24 @@ int Surface::dispatchSetSidebandStream(va_list args) {
     return OK;
 }
 
+int Surface::dispatchSetDequeueAhead(va_list args) {
+    int enabled = va_arg(args, int);
+    setDequeueAhead(enabled != 0);
+    return OK;
+}
+
+int Surface::dispatchSetSurfaceDamage(va_list args) {
+    android_native_rect_t const* rect = va_arg(args, android_native_rect_t*);
+    Rect damage;
+    if (rect) {
+        damage = *reinterpret_cast<Rect const*>(rect);
+    } else {
+        damage.makeInvalid();
+    }
+    setSurfaceDamage(damage);
+    return NO_ERROR;
+}
+
 int Surface::connect(int api) {
     ATRACE_CALL();
     ALOGV("Surface::connect");
@@ -568,6 +811,19 @@ int Surface::connect(int api) {
     if (!err && api == NATIVE_WINDOW_API_CPU) {
         mConnectedToCpu = true;
     }
+    if (!err) {
+        char value[PROPERTY_VALUE_MAX];
+        property_get("debug.gui.control_channel", value, "0");
+        int fd = -1;
+        if (atoi(value) &&
+                mGraphicBufferProducer->getControlChannel(&fd) == NO_ERROR) {
+            sp<BufferQueueControlClient> channel(new BufferQueueControlClient(
+                    fd, mGraphicBufferProducer->asBinder()));
+            if (channel->initCheck() == NO_ERROR) {
+                mControlChannel = channel;
+            }
+        }
+    }
     return err;
 }
 
@@ -577,13 +833,19 @@ int Surface::disconnect(int api) {
     ALOGV("Surface::disconnect");
     Mutex::Autolock lock(mMutex);
     freeAllBuffers();
+    mControlChannel.clear();
     int err = mGraphicBufferProducer->disconnect(api);
+    if (mDequeueAhead != NULL) {
+        // Disconnecting woke up a blocked prefetch; its buffer is gone.
+        mDequeueAhead->discard(err != NO_ERROR);
+    }
     if (!err) {
         mReqFormat = 0;
         mReqWidth = 0;
         mReqHeight = 0;
         mReqUsage = 0;
         mCrop.clear();
+        mSurfaceDamage.makeInvalid();
         mScalingMode = NATIVE_WINDOW_SCALING_MODE_FREEZE;
         mTransform = 0;
         mStickyTransform = 0;
@@ -626,8 +888,19 @@ int Surface::setBufferCount(int bufferCount)
 {
     ATRACE_CALL();
     ALOGV("Surface::setBufferCount");
-    Mutex::Autolock lock(mMutex);
+    sp<DequeueAhead> dequeueAhead;
+    {
+        Mutex::Autolock lock(mMutex);
+        dequeueAhead = mDequeueAhead;
+    }
 
+    // The count can't change while a prefetched buffer is dequeued. Waiting
+    // for it can block in IGBP::dequeueBuffer, so don't hold the lock.
+    if (dequeueAhead != NULL) {
+        dequeueAhead->discard(true);
+    }
+
+    Mutex::Autolock lock(mMutex);
     status_t err = mGraphicBufferProducer->setBufferCount(bufferCount);
     ALOGE_IF(err, "IGraphicBufferProducer::setBufferCount(%d) returned %s",
             bufferCount, strerror(-err));
@@ -858,6 +1131,9 @@ status_t Surface::lock(
                 mDirtyRegion.subtract(dirtyRegion);
                 dirtyRegion = newDirtyRegion;
             }
+            // everything outside of what the caller repaints was copied
+            // back from the previous frame
+            mSurfaceDamage = newDirtyRegion.getBounds();
         }
 
         mDirtyRegion.orSelf(newDirtyRegion);
@@ -108,31 +108,322 @@ int compare_type(const DisplayState& lhs, const DisplayState& rhs) {
     return compare_type(lhs.token, rhs.token);
 }
 
+// ---------------------------------------------------------------------------
+
+SurfaceComposerClient::Transaction::Transaction()
+    : mForceSynchronous(false), mAnimation(false)
+{
+}
+
+SurfaceComposerClient::Transaction::~Transaction() {
+}
+
+uint32_t SurfaceComposerClient::Transaction::take(
+        Vector<ComposerState>* outStates,
+        Vector<DisplayState>* outDisplayStates, bool synchronous) {
+    uint32_t flags = 0;
+    if (mForceSynchronous || synchronous) {
+        flags |= ISurfaceComposer::eSynchronous;
+    }
+    if (mAnimation) {
+        flags |= ISurfaceComposer::eAnimation;
+    }
+
+    *outStates = mComposerStates;
+    mComposerStates.clear();
+    *outDisplayStates = mDisplayStates;
+    mDisplayStates.clear();
+    mForceSynchronous = false;
+    mAnimation = false;
+    return flags;
+}
+
+status_t SurfaceComposerClient::Transaction::apply(bool synchronous) {
+    sp<ISurfaceComposer> sm(ComposerService::getComposerService());
+
+    Vector<ComposerState> transaction;
+    Vector<DisplayState> displayTransaction;
+    uint32_t flags = take(&transaction, &displayTransaction, synchronous);
+
+    if (transaction.isEmpty() && displayTransaction.isEmpty() &&
+            !(flags & ISurfaceComposer::eSynchronous)) {
+        return NO_ERROR;
+    }
+    sm->setTransactionState(transaction, displayTransaction, flags);
+    return NO_ERROR;
+}
+
+void SurfaceComposerClient::Transaction::setAnimation() {
+    mAnimation = true;
+}
+
+layer_state_t* SurfaceComposerClient::Transaction::getLayerState(
+        const sp<SurfaceComposerClient>& client, const sp<IBinder>& id) {
+
+    ComposerState s;
+    s.client = client->mClient;
+    s.state.surface = id;
+
+    ssize_t index = mComposerStates.indexOf(s);
+    if (index < 0) {
+        // we don't have it, add an initialized layer_state to our list
+        index = mComposerStates.add(s);
+    }
+
+    ComposerState* const out = mComposerStates.editArray();
+    return &(out[index].state);
+}
+
+status_t SurfaceComposerClient::Transaction::setPosition(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, float x, float y) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::ePositionChanged;
+    s->x = x;
+    s->y = y;
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setSize(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, uint32_t w, uint32_t h) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::eSizeChanged;
+    s->w = w;
+    s->h = h;
+
+    // Resizing a surface makes the transaction synchronous.
+    mForceSynchronous = true;
+
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setLayer(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, int32_t z) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::eLayerChanged;
+    s->z = z;
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setFlags(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, uint32_t flags,
+        uint32_t mask) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    if (mask & layer_state_t::eLayerOpaque) {
+        s->what |= layer_state_t::eOpacityChanged;
+    }
+    if (mask & layer_state_t::eLayerHidden) {
+        s->what |= layer_state_t::eVisibilityChanged;
+    }
+    s->flags &= ~mask;
+    s->flags |= (flags & mask);
+    s->mask |= mask;
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setTransparentRegionHint(
+        const sp<SurfaceComposerClient>& client, const sp<IBinder>& id,
+        const Region& transparentRegion) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::eTransparentRegionChanged;
+    s->transparentRegion = transparentRegion;
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setAlpha(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, float alpha) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::eAlphaChanged;
+    s->alpha = alpha;
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setLayerStack(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, uint32_t layerStack) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::eLayerStackChanged;
+    s->layerStack = layerStack;
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setMatrix(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, float dsdx, float dtdx,
+        float dsdy, float dtdy) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::eMatrixChanged;
+    layer_state_t::matrix22_t matrix;
+    matrix.dsdx = dsdx;
+    matrix.dtdx = dtdx;
+    matrix.dsdy = dsdy;
+    matrix.dtdy = dtdy;
+    s->matrix = matrix;
+    return NO_ERROR;
+}
+
+status_t SurfaceComposerClient::Transaction::setCrop(
+        const sp<SurfaceComposerClient>& client,
+        const sp<IBinder>& id, const Rect& crop) {
+    layer_state_t* s = getLayerState(client, id);
+    if (!s)
+        return BAD_INDEX;
+    s->what |= layer_state_t::eCropChanged;
+    s->crop = crop;
+    return NO_ERROR;
+}
+
+// The public setters identify the surface by its SurfaceControl.
+
+status_t SurfaceComposerClient::Transaction::setPosition(
+        const sp<SurfaceControl>& sc, float x, float y) {
+    return setPosition(sc->mClient, sc->mHandle, x, y);
+}
+
+status_t SurfaceComposerClient::Transaction::setSize(
+        const sp<SurfaceControl>& sc, uint32_t w, uint32_t h) {
+    return setSize(sc->mClient, sc->mHandle, w, h);
+}
+
+status_t SurfaceComposerClient::Transaction::setLayer(
+        const sp<SurfaceControl>& sc, int32_t z) {
+    return setLayer(sc->mClient, sc->mHandle, z);
+}
+
+status_t SurfaceComposerClient::Transaction::setFlags(
+        const sp<SurfaceControl>& sc, uint32_t flags, uint32_t mask) {
+    return setFlags(sc->mClient, sc->mHandle, flags, mask);
+}
+
+status_t SurfaceComposerClient::Transaction::show(
+        const sp<SurfaceControl>& sc) {
+    return setFlags(sc->mClient, sc->mHandle, 0, layer_state_t::eLayerHidden);
+}
+
+status_t SurfaceComposerClient::Transaction::hide(
+        const sp<SurfaceControl>& sc) {
+    return setFlags(sc->mClient, sc->mHandle, layer_state_t::eLayerHidden,
+            layer_state_t::eLayerHidden);
+}
+
+status_t SurfaceComposerClient::Transaction::setTransparentRegionHint(
+        const sp<SurfaceControl>& sc, const Region& transparentRegion) {
+    return setTransparentRegionHint(sc->mClient, sc->mHandle,
+            transparentRegion);
+}
+
+status_t SurfaceComposerClient::Transaction::setAlpha(
+        const sp<SurfaceControl>& sc, float alpha) {
+    return setAlpha(sc->mClient, sc->mHandle, alpha);
+}
+
+status_t SurfaceComposerClient::Transaction::setMatrix(
+        const sp<SurfaceControl>& sc, float dsdx, float dtdx,
+        float dsdy, float dtdy) {
+    return setMatrix(sc->mClient, sc->mHandle, dsdx, dtdx, dsdy, dtdy);
+}
+
+status_t SurfaceComposerClient::Transaction::setCrop(
+        const sp<SurfaceControl>& sc, const Rect& crop) {
+    return setCrop(sc->mClient, sc->mHandle, crop);
+}
+
+status_t SurfaceComposerClient::Transaction::setLayerStack(
+        const sp<SurfaceControl>& sc, uint32_t layerStack) {
+    return setLayerStack(sc->mClient, sc->mHandle, layerStack);
+}
+
+// ---------------------------------------------------------------------------
+
+DisplayState& SurfaceComposerClient::Transaction::getDisplayState(
+        const sp<IBinder>& token) {
+    DisplayState s;
+    s.token = token;
+    ssize_t index = mDisplayStates.indexOf(s);
+    if (index < 0) {
+        // we don't have it, add an initialized layer_state to our list
+        s.what = 0;
+        index = mDisplayStates.add(s);
+    }
+    return mDisplayStates.editItemAt(index);
+}
+
+void SurfaceComposerClient::Transaction::setDisplaySurface(
+        const sp<IBinder>& token,
+        const sp<IGraphicBufferProducer>& bufferProducer) {
+    DisplayState& s(getDisplayState(token));
+    s.surface = bufferProducer;
+    s.what |= DisplayState::eSurfaceChanged;
+}
+
+void SurfaceComposerClient::Transaction::setDisplayLayerStack(
+        const sp<IBinder>& token, uint32_t layerStack) {
+    DisplayState& s(getDisplayState(token));
+    s.layerStack = layerStack;
+    s.what |= DisplayState::eLayerStackChanged;
+}
+
+void SurfaceComposerClient::Transaction::setDisplayProjection(
+        const sp<IBinder>& token,
+        uint32_t orientation,
+        const Rect& layerStackRect,
+        const Rect& displayRect) {
+    DisplayState& s(getDisplayState(token));
+    s.orientation = orientation;
+    s.viewport = layerStackRect;
+    s.frame = displayRect;
+    s.what |= DisplayState::eDisplayProjectionChanged;
+    mForceSynchronous = true; // TODO: do we actually still need this?
+}
+
+void SurfaceComposerClient::Transaction::setDisplaySize(
+        const sp<IBinder>& token, uint32_t width, uint32_t height) {
+    DisplayState& s(getDisplayState(token));
+    s.width = width;
+    s.height = height;
+    s.what |= DisplayState::eDisplaySizeChanged;
+}
+
+// ---------------------------------------------------------------------------
+
+// Composer holds the global transaction, shared by all the threads of the
+// process, and serializes the changes made to it.
 class Composer : public Singleton<Composer>
 {
     friend class Singleton<Composer>;
 
-    mutable Mutex               mLock;
-    SortedVector<ComposerState> mComposerStates;
-    SortedVector<DisplayState > mDisplayStates;
-    uint32_t                    mForceSynchronous;
-    uint32_t                    mTransactionNestCount;
-    bool                        mAnimation;
+    mutable Mutex                       mLock;
+    SurfaceComposerClient::Transaction  mTransaction;
+    uint32_t                            mTransactionNestCount;
 
     Composer() : Singleton<Composer>(),
-        mForceSynchronous(0), mTransactionNestCount(0),
-        mAnimation(false)
+        mTransactionNestCount(0)
     { }
 
     void openGlobalTransactionImpl();
     void closeGlobalTransactionImpl(bool synchronous);
     void setAnimationTransactionImpl();
 
-    layer_state_t* getLayerStateLocked(
-            const sp<SurfaceComposerClient>& client, const sp<IBinder>& id);
-
-    DisplayState& getDisplayStateLocked(const sp<IBinder>& token);
-
 public:
     sp<IBinder> createDisplay(const String8& displayName, bool secure);
     void destroyDisplay(const sp<IBinder>& display);
@@ -214,7 +505,7 @@ void Composer::closeGlobalTransactionImpl(bool synchronous) {
 
     { // scope for the lock
         Mutex::Autolock _l(mLock);
-        mForceSynchronous |= synchronous;
+        mTransaction.mForceSynchronous |= synchronous;
         if (!mTransactionNestCount) {
             ALOGW("At least one call to closeGlobalTransaction() was not matched by a prior "
                     "call to openGlobalTransaction().");
@@ -222,21 +513,7 @@ void Composer::closeGlobalTransactionImpl(bool synchronous) {
             return;
         }
 
-        transaction = mComposerStates;
-        mComposerStates.clear();
-
-        displayTransaction = mDisplayStates;
-        mDisplayStates.clear();
-
-        if (mForceSynchronous) {
-            flags |= ISurfaceComposer::eSynchronous;
-        }
-        if (mAnimation) {
-            flags |= ISurfaceComposer::eAnimation;
-        }
-
-        mForceSynchronous = false;
-        mAnimation = false;
+        flags = mTransaction.take(&transaction, &displayTransaction, false);
     }
 
    sm->setTransactionState(transaction, displayTransaction, flags);
@@ -244,174 +521,79 @@ void Composer::closeGlobalTransactionImpl(bool synchronous) {
 
 void Composer::setAnimationTransactionImpl() {
     Mutex::Autolock _l(mLock);
-    mAnimation = true;
-}
-
-layer_state_t* Composer::getLayerStateLocked(
-        const sp<SurfaceComposerClient>& client, const sp<IBinder>& id) {
-
-    ComposerState s;
-    s.client = client->mClient;
-    s.state.surface = id;
-
-    ssize_t index = mComposerStates.indexOf(s);
-    if (index < 0) {
-        // we don't have it, add an initialized layer_state to our list
-        index = mComposerStates.add(s);
-    }
-
-    ComposerState* const out = mComposerStates.editArray();
-    return &(out[index].state);
+    mTransaction.setAnimation();
 }
 
 status_t Composer::setPosition(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, float x, float y) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::ePositionChanged;
-    s->x = x;
-    s->y = y;
-    return NO_ERROR;
+    return mTransaction.setPosition(client, id, x, y);
 }
 
 status_t Composer::setSize(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, uint32_t w, uint32_t h) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::eSizeChanged;
-    s->w = w;
-    s->h = h;
-
-    // Resizing a surface makes the transaction synchronous.
-    mForceSynchronous = true;
-
-    return NO_ERROR;
+    return mTransaction.setSize(client, id, w, h);
 }
 
 status_t Composer::setLayer(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, int32_t z) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::eLayerChanged;
-    s->z = z;
-    return NO_ERROR;
+    return mTransaction.setLayer(client, id, z);
 }
 
 status_t Composer::setFlags(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, uint32_t flags,
         uint32_t mask) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    if (mask & layer_state_t::eLayerOpaque) {
-        s->what |= layer_state_t::eOpacityChanged;
-    }
-    if (mask & layer_state_t::eLayerHidden) {
-        s->what |= layer_state_t::eVisibilityChanged;
-    }
-    s->flags &= ~mask;
-    s->flags |= (flags & mask);
-    s->mask |= mask;
-    return NO_ERROR;
+    return mTransaction.setFlags(client, id, flags, mask);
 }
 
 status_t Composer::setTransparentRegionHint(
         const sp<SurfaceComposerClient>& client, const sp<IBinder>& id,
         const Region& transparentRegion) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::eTransparentRegionChanged;
-    s->transparentRegion = transparentRegion;
-    return NO_ERROR;
+    return mTransaction.setTransparentRegionHint(client, id,
+            transparentRegion);
 }
 
 status_t Composer::setAlpha(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, float alpha) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::eAlphaChanged;
-    s->alpha = alpha;
-    return NO_ERROR;
+    return mTransaction.setAlpha(client, id, alpha);
 }
 
 status_t Composer::setLayerStack(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, uint32_t layerStack) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::eLayerStackChanged;
-    s->layerStack = layerStack;
-    return NO_ERROR;
+    return mTransaction.setLayerStack(client, id, layerStack);
 }
 
 status_t Composer::setMatrix(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, float dsdx, float dtdx,
         float dsdy, float dtdy) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::eMatrixChanged;
-    layer_state_t::matrix22_t matrix;
-    matrix.dsdx = dsdx;
-    matrix.dtdx = dtdx;
-    matrix.dsdy = dsdy;
-    matrix.dtdy = dtdy;
-    s->matrix = matrix;
-    return NO_ERROR;
+    return mTransaction.setMatrix(client, id, dsdx, dtdx, dsdy, dtdy);
 }
 
 status_t Composer::setCrop(const sp<SurfaceComposerClient>& client,
         const sp<IBinder>& id, const Rect& crop) {
     Mutex::Autolock _l(mLock);
-    layer_state_t* s = getLayerStateLocked(client, id);
-    if (!s)
-        return BAD_INDEX;
-    s->what |= layer_state_t::eCropChanged;
-    s->crop = crop;
-    return NO_ERROR;
+    return mTransaction.setCrop(client, id, crop);
 }
 
 // ---------------------------------------------------------------------------
 
-DisplayState& Composer::getDisplayStateLocked(const sp<IBinder>& token) {
-    DisplayState s;
-    s.token = token;
-    ssize_t index = mDisplayStates.indexOf(s);
-    if (index < 0) {
-        // we don't have it, add an initialized layer_state to our list
-        s.what = 0;
-        index = mDisplayStates.add(s);
-    }
-    return mDisplayStates.editItemAt(index);
-}
-
 void Composer::setDisplaySurface(const sp<IBinder>& token,
         const sp<IGraphicBufferProducer>& bufferProducer) {
     Mutex::Autolock _l(mLock);
-    DisplayState& s(getDisplayStateLocked(token));
-    s.surface = bufferProducer;
-    s.what |= DisplayState::eSurfaceChanged;
+    mTransaction.setDisplaySurface(token, bufferProducer);
 }
 
 void Composer::setDisplayLayerStack(const sp<IBinder>& token,
         uint32_t layerStack) {
     Mutex::Autolock _l(mLock);
-    DisplayState& s(getDisplayStateLocked(token));
-    s.layerStack = layerStack;
-    s.what |= DisplayState::eLayerStackChanged;
+    mTransaction.setDisplayLayerStack(token, layerStack);
 }
 
 void Composer::setDisplayProjection(const sp<IBinder>& token,
@@ -419,20 +601,13 @@ void Composer::setDisplayProjection(const sp<IBinder>& token,
         const Rect& layerStackRect,
         const Rect& displayRect) {
     Mutex::Autolock _l(mLock);
-    DisplayState& s(getDisplayStateLocked(token));
-    s.orientation = orientation;
-    s.viewport = layerStackRect;
-    s.frame = displayRect;
-    s.what |= DisplayState::eDisplayProjectionChanged;
-    mForceSynchronous = true; // TODO: do we actually still need this?
+    mTransaction.setDisplayProjection(token, orientation, layerStackRect,
+            displayRect);
 }
 
 void Composer::setDisplaySize(const sp<IBinder>& token, uint32_t width, uint32_t height) {
     Mutex::Autolock _l(mLock);
-    DisplayState& s(getDisplayStateLocked(token));
-    s.width = width;
-    s.height = height;
-    s.what |= DisplayState::eDisplaySizeChanged;
+    mTransaction.setDisplaySize(token, width, height);
 }
 
 // ---------------------------------------------------------------------------
@@ -682,6 +857,18 @@ status_t SurfaceComposerClient::getAnimationFrameStats(FrameStats* outStats) {
     return ComposerService::getComposerService()->getAnimationFrameStats(outStats);
 }
 
+status_t SurfaceComposerClient::getLayerFrameStatInfo(
+        Vector<String8>* outNames, Vector<FrameStatInfo>* outInfos) {
+    return ComposerService::getComposerService()->getLayerFrameStatInfo(
+            outNames, outInfos);
+}
+
+status_t SurfaceComposerClient::getCompositionTimeline(
+        Vector<CompositionTiming>* outTimings) {
+    return ComposerService::getComposerService()->getCompositionTimeline(
+            outTimings);
+}
+
 // ----------------------------------------------------------------------------
 
 status_t ScreenshotClient::capture(
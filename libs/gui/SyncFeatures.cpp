@@ -19,9 +19,13 @@
 #define GL_GLEXT_PROTOTYPES
 #define EGL_EGLEXT_PROTOTYPES
 
+#include <errno.h>
+#include <unistd.h>
+
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
+#include <cutils/atomic.h>
 #include <utils/Log.h>
 #include <utils/Singleton.h>
 #include <utils/String8.h>
@@ -37,7 +41,10 @@ ANDROID_SINGLETON_STATIC_INSTANCE(SyncFeatures);
 SyncFeatures::SyncFeatures() : Singleton<SyncFeatures>(),
         mHasNativeFenceSync(false),
         mHasFenceSync(false),
-        mHasWaitSync(false) {
+        mHasWaitSync(false),
+        mSignaledWaits(0),
+        mGpuWaits(0),
+        mCpuWaits(0) {
     EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     // This can only be called after EGL has been initialized; otherwise the
     // check below will abort.
@@ -91,4 +98,61 @@ String8 SyncFeatures::toString() const {
     return mString;
 }
 
+status_t SyncFeatures::waitForFence(EGLDisplay dpy, const sp<Fence>& fence,
+        const char* logname) {
+    if (!fence->isValid()) {
+        return NO_ERROR;
+    }
+    const nsecs_t signalTime = fence->getSignalTime();
+    if (signalTime >= 0 && signalTime != INT64_MAX) {
+        android_atomic_inc(&mSignaledWaits);
+        return NO_ERROR;
+    }
+
+    if (useWaitSync()) {
+        int fenceFd = fence->dup();
+        if (fenceFd == -1) {
+            ALOGE("%s: error dup'ing fence fd: %d", logname, errno);
+            return -errno;
+        }
+        EGLint attribs[] = {
+            EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fenceFd,
+            EGL_NONE
+        };
+        EGLSyncKHR sync = eglCreateSyncKHR(dpy,
+                EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+        if (sync != EGL_NO_SYNC_KHR) {
+            // XXX: The spec draft is inconsistent as to whether this should
+            // return an EGLint or void.  Ignore the return value for now, as
+            // it's not strictly needed.
+            eglWaitSyncKHR(dpy, sync, 0);
+            EGLint eglErr = eglGetError();
+            eglDestroySyncKHR(dpy, sync);
+            if (eglErr != EGL_SUCCESS) {
+                ALOGE("%s: error waiting for EGL fence: %#x", logname, eglErr);
+                return UNKNOWN_ERROR;
+            }
+            android_atomic_inc(&mGpuWaits);
+            return NO_ERROR;
+        }
+        close(fenceFd);
+        ALOGW("%s: error creating EGL fence, waiting on the CPU: %#x",
+                logname, eglGetError());
+    }
+
+    android_atomic_inc(&mCpuWaits);
+    status_t err = fence->waitForever(logname);
+    if (err != NO_ERROR) {
+        ALOGE("%s: error waiting for fence: %d", logname, err);
+    }
+    return err;
+}
+
+void SyncFeatures::dumpFenceWaits(String8& result) const {
+    result.appendFormat("Fence waits for GL: %d signaled, %d on the GPU, "
+            "%d blocking on the CPU\n", android_atomic_acquire_load(&mSignaledWaits),
+            android_atomic_acquire_load(&mGpuWaits),
+            android_atomic_acquire_load(&mCpuWaits));
+}
+
 } // namespace android
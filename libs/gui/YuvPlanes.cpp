@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define YUV_USE_NEON 1
+#endif
+
+#include <gui/YuvPlanes.h>
+
+namespace android {
+
+void copyPlane(uint8_t* dst, size_t dstStride,
+        const uint8_t* src, size_t srcStride, size_t width, size_t height) {
+    if (dstStride == width && srcStride == width) {
+        memcpy(dst, src, width * height);
+        return;
+    }
+    for (size_t y = 0; y < height; y++) {
+        memcpy(dst, src, width);
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+// Splits a row of interleaved samples, the even ones going to dst0.
+static void deinterleaveRow(uint8_t* dst0, uint8_t* dst1, const uint8_t* src,
+        size_t width) {
+    size_t x = 0;
+#if YUV_USE_NEON
+    for ( ; x + 16 <= width; x += 16) {
+        uint8x16x2_t v = vld2q_u8(src + 2 * x);
+        vst1q_u8(dst0 + x, v.val[0]);
+        vst1q_u8(dst1 + x, v.val[1]);
+    }
+#endif
+    for ( ; x < width; x++) {
+        dst0[x] = src[2 * x];
+        dst1[x] = src[2 * x + 1];
+    }
+}
+
+status_t splitChroma(const CpuConsumer::LockedBuffer& buffer,
+        uint8_t* dstCb, uint8_t* dstCr, size_t dstStride) {
+    const uint8_t* cb = buffer.dataCb;
+    const uint8_t* cr = buffer.dataCr;
+    const size_t width = buffer.chromaWidth;
+    const size_t height = buffer.chromaHeight;
+    const size_t step = buffer.chromaStep;
+    const size_t stride = buffer.chromaStride;
+
+    if (cb == NULL || cr == NULL || step == 0) {
+        return BAD_VALUE;
+    }
+    if (step == 1) {
+        copyPlane(dstCb, dstStride, cb, stride, width, height);
+        copyPlane(dstCr, dstStride, cr, stride, width, height);
+        return NO_ERROR;
+    }
+    if (step == 2 && (cr == cb + 1 || cb == cr + 1)) {
+        const bool cbFirst = cb < cr;
+        const uint8_t* src = cbFirst ? cb : cr;
+        for (size_t y = 0; y < height; y++) {
+            if (cbFirst) {
+                deinterleaveRow(dstCb, dstCr, src, width);
+            } else {
+                deinterleaveRow(dstCr, dstCb, src, width);
+            }
+            dstCb += dstStride;
+            dstCr += dstStride;
+            src += stride;
+        }
+        return NO_ERROR;
+    }
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            dstCb[x] = cb[x * step];
+            dstCr[x] = cr[x * step];
+        }
+        dstCb += dstStride;
+        dstCr += dstStride;
+        cb += stride;
+        cr += stride;
+    }
+    return NO_ERROR;
+}
+
+void downsamplePlane(uint8_t* dst, size_t dstStride,
+        const uint8_t* src, size_t srcStride, size_t width, size_t height) {
+    for (size_t y = 0; y < height; y++) {
+        const uint8_t* row0 = src;
+        const uint8_t* row1 = src + srcStride;
+        size_t x = 0;
+#if YUV_USE_NEON
+        for ( ; x + 8 <= width; x += 8) {
+            // add the pairs of each row, then the two rows, and divide by
+            // 4 with rounding
+            uint16x8_t sum = vpaddlq_u8(vld1q_u8(row0 + 2 * x));
+            sum = vpadalq_u8(sum, vld1q_u8(row1 + 2 * x));
+            vst1_u8(dst + x, vrshrn_n_u16(sum, 2));
+        }
+#endif
+        for ( ; x < width; x++) {
+            dst[x] = (row0[2 * x] + row0[2 * x + 1] +
+                    row1[2 * x] + row1[2 * x + 1] + 2) >> 2;
+        }
+        dst += dstStride;
+        src += 2 * srcStride;
+    }
+}
+
+}; // namespace android
@@ -14,6 +14,7 @@ LOCAL_SRC_FILES := \
     IGraphicBufferProducer_test.cpp \
     MultiTextureConsumer_test.cpp \
     SRGB_test.cpp \
+    SensorEventRing_test.cpp \
     StreamSplitter_test.cpp \
     SurfaceTextureClient_test.cpp \
     SurfaceTextureFBO_test.cpp \
@@ -23,6 +24,7 @@ LOCAL_SRC_FILES := \
     SurfaceTextureMultiContextGL_test.cpp \
     Surface_test.cpp \
     TextureRenderer.cpp \
+    YuvPlanes_test.cpp \
 
 LOCAL_SHARED_LIBRARIES := \
 	libEGL \
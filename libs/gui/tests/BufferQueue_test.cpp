@@ -19,6 +19,8 @@
 
 #include <gui/BufferQueue.h>
 #include <gui/IProducerListener.h>
+#include <gui/ISurfaceComposer.h>
+#include <private/gui/ComposerService.h>
 
 #include <ui/GraphicBuffer.h>
 
@@ -173,6 +175,59 @@ TEST_F(BufferQueueTest, AcquireBuffer_ExceedsMaxAcquireCount_Fails) {
     ASSERT_EQ(INVALID_OPERATION, mConsumer->acquireBuffer(&item, 0));
 }
 
+TEST_F(BufferQueueTest, AcquireAndReleaseBuffers_HandleBatches) {
+    createBufferQueue();
+    sp<DummyConsumer> dc(new DummyConsumer);
+    mConsumer->consumerConnect(dc, false);
+    IGraphicBufferProducer::QueueBufferOutput qbo;
+    mProducer->connect(new DummyProducerListener, NATIVE_WINDOW_API_CPU, false,
+            &qbo);
+    mProducer->setBufferCount(4);
+
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> buf;
+    IGraphicBufferProducer::QueueBufferInput qbi(0, false, Rect(0, 0, 1, 1),
+            NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, false, Fence::NO_FENCE);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+                mProducer->dequeueBuffer(&slot, &fence, false, 1, 1, 0,
+                    GRALLOC_USAGE_SW_READ_OFTEN));
+        ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buf));
+        ASSERT_EQ(OK, mProducer->queueBuffer(slot, qbi, &qbo));
+    }
+
+    // Only two buffers may be acquired at a time: the batch stops there.
+    Vector<BufferQueue::BufferItem> items;
+    ASSERT_EQ(OK, mConsumer->acquireBuffers(8, &items, 0));
+    ASSERT_EQ(2u, items.size());
+    ASSERT_EQ(1u, items[0].mFrameNumber);
+    ASSERT_EQ(2u, items[1].mFrameNumber);
+    Vector<BufferQueue::BufferItem> more;
+    ASSERT_EQ(INVALID_OPERATION, mConsumer->acquireBuffers(8, &more, 0));
+    ASSERT_EQ(0u, more.size());
+
+    Vector<IGraphicBufferConsumer::ReleasedBuffer> released;
+    for (size_t i = 0; i < items.size(); i++) {
+        IGraphicBufferConsumer::ReleasedBuffer buffer;
+        buffer.mBuf = items[i].mBuf;
+        buffer.mFrameNumber = items[i].mFrameNumber;
+        buffer.mFence = Fence::NO_FENCE;
+        released.push_back(buffer);
+    }
+    uint64_t staleSlots = ~0ULL;
+    ASSERT_EQ(OK, mConsumer->releaseBuffers(released, &staleSlots));
+    ASSERT_EQ(0u, staleSlots);
+    // They can't be released twice.
+    ASSERT_EQ(BAD_VALUE, mConsumer->releaseBuffers(released, &staleSlots));
+
+    ASSERT_EQ(OK, mConsumer->acquireBuffers(8, &more, 0));
+    ASSERT_EQ(1u, more.size());
+    ASSERT_EQ(3u, more[0].mFrameNumber);
+    ASSERT_EQ(BufferQueue::NO_BUFFER_AVAILABLE,
+            mConsumer->acquireBuffers(8, &more, 0));
+}
+
 TEST_F(BufferQueueTest, SetMaxAcquiredBufferCountWithIllegalValues_ReturnsError) {
     createBufferQueue();
     sp<DummyConsumer> dc(new DummyConsumer);
@@ -358,4 +413,188 @@ TEST_F(BufferQueueTest, MoveFromConsumerToProducer) {
     ASSERT_EQ(OK, item.mGraphicBuffer->unlock());
 }
 
+// Records the thread each buffer is allocated on.
+class ThreadRecordingAllocator : public BnGraphicBufferAlloc {
+public:
+    ThreadRecordingAllocator() : mAllocCount(0), mLastAllocTid(0) {
+        sp<ISurfaceComposer> composer(ComposerService::getComposerService());
+        mAllocator = composer->createGraphicBufferAlloc();
+    }
+
+    virtual sp<GraphicBuffer> createGraphicBuffer(uint32_t w, uint32_t h,
+            PixelFormat format, uint32_t usage, status_t* error) {
+        ++mAllocCount;
+        mLastAllocTid = gettid();
+        return mAllocator->createGraphicBuffer(w, h, format, usage, error);
+    }
+
+    int getAllocCount() const { return mAllocCount; }
+    pid_t getLastAllocTid() const { return mLastAllocTid; }
+
+private:
+    sp<IGraphicBufferAlloc> mAllocator;
+    int mAllocCount;
+    pid_t mLastAllocTid;
+};
+
+TEST_F(BufferQueueTest, DefaultSizeChangeReallocatesInBackground) {
+    sp<ThreadRecordingAllocator> allocator(new ThreadRecordingAllocator);
+    BufferQueue::createBufferQueue(&mProducer, &mConsumer, allocator);
+    sp<DummyConsumer> dc(new DummyConsumer);
+    ASSERT_EQ(OK, mConsumer->consumerConnect(dc, false));
+    IGraphicBufferProducer::QueueBufferOutput output;
+    ASSERT_EQ(OK,
+            mProducer->connect(NULL, NATIVE_WINDOW_API_CPU, false, &output));
+
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> buffer;
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+            mProducer->dequeueBuffer(&slot, &fence, false, 0, 0, 0,
+                    GRALLOC_USAGE_SW_WRITE_OFTEN));
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    ASSERT_EQ(OK, mProducer->cancelBuffer(slot, Fence::NO_FENCE));
+    ASSERT_EQ(1, allocator->getAllocCount());
+
+    ASSERT_EQ(OK, mConsumer->setDefaultBufferSize(16, 8));
+
+    // dequeueBuffer waits for the reallocation thread rather than allocating
+    // itself; the producer must still be told to request the new buffer.
+    int newSlot;
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+            mProducer->dequeueBuffer(&newSlot, &fence, false, 0, 0, 0,
+                    GRALLOC_USAGE_SW_WRITE_OFTEN));
+    EXPECT_EQ(2, allocator->getAllocCount());
+    EXPECT_NE(gettid(), allocator->getLastAllocTid());
+    ASSERT_EQ(OK, mProducer->requestBuffer(newSlot, &buffer));
+    ASSERT_EQ(16U, buffer->getWidth());
+    ASSERT_EQ(8U, buffer->getHeight());
+}
+
+TEST_F(BufferQueueTest, SurfaceDamageIsMergedWhenFrameIsDropped) {
+    createBufferQueue();
+    sp<DummyConsumer> dc(new DummyConsumer);
+    ASSERT_EQ(OK, mConsumer->consumerConnect(dc, false));
+    IGraphicBufferProducer::QueueBufferOutput output;
+    ASSERT_EQ(OK,
+            mProducer->connect(NULL, NATIVE_WINDOW_API_CPU, false, &output));
+
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> buffer;
+    IGraphicBufferProducer::QueueBufferInput input(0, false, Rect(0, 0, 16, 16),
+            NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, true, Fence::NO_FENCE);
+
+    // The first frame is replaced by the second before it is acquired, so the
+    // consumer must see the union of both damage rects.
+    input.setSurfaceDamage(Rect(0, 0, 4, 4));
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+            mProducer->dequeueBuffer(&slot, &fence, true, 16, 16, 0,
+                    GRALLOC_USAGE_SW_WRITE_OFTEN));
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    ASSERT_EQ(OK, mProducer->queueBuffer(slot, input, &output));
+
+    input.setSurfaceDamage(Rect(8, 8, 12, 12));
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+            mProducer->dequeueBuffer(&slot, &fence, true, 16, 16, 0,
+                    GRALLOC_USAGE_SW_WRITE_OFTEN));
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    ASSERT_EQ(OK, mProducer->queueBuffer(slot, input, &output));
+
+    IGraphicBufferConsumer::BufferItem item;
+    ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, static_cast<nsecs_t>(0)));
+    ASSERT_EQ(Rect(0, 0, 12, 12), item.mSurfaceDamage);
+    ASSERT_EQ(OK, mConsumer->releaseBuffer(item.mBuf, item.mFrameNumber,
+            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+
+    // A frame queued without damage invalidates the whole buffer.
+    Rect noDamage;
+    noDamage.makeInvalid();
+    input.setSurfaceDamage(noDamage);
+    ASSERT_LE(0, mProducer->dequeueBuffer(&slot, &fence, true, 16, 16, 0,
+            GRALLOC_USAGE_SW_WRITE_OFTEN));
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    ASSERT_EQ(OK, mProducer->queueBuffer(slot, input, &output));
+    ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, static_cast<nsecs_t>(0)));
+    ASSERT_FALSE(item.mSurfaceDamage.isValid());
+}
+
+TEST_F(BufferQueueTest, DropLateFramesDropsAutoTimestampedFrames) {
+    createBufferQueue();
+    sp<DummyConsumer> dc(new DummyConsumer);
+    ASSERT_EQ(OK, mConsumer->consumerConnect(dc, false));
+    ASSERT_EQ(OK, mConsumer->setDefaultMaxBufferCount(4));
+    IGraphicBufferProducer::QueueBufferOutput output;
+    ASSERT_EQ(OK,
+            mProducer->connect(NULL, NATIVE_WINDOW_API_CPU, false, &output));
+
+    // Queue three frames due at 1000, 2000 and 3000, as when Surface picks
+    // the timestamps.
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> buffer;
+    for (nsecs_t timestamp = 1000; timestamp <= 3000; timestamp += 1000) {
+        IGraphicBufferProducer::QueueBufferInput input(timestamp, true,
+                Rect(0, 0, 1, 1), NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, false,
+                Fence::NO_FENCE);
+        ASSERT_LE(0, mProducer->dequeueBuffer(&slot, &fence, false, 1, 1, 0,
+                GRALLOC_USAGE_SW_WRITE_OFTEN));
+        ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+        ASSERT_EQ(OK, mProducer->queueBuffer(slot, input, &output));
+    }
+
+    // By default nothing is dropped.
+    IGraphicBufferConsumer::BufferItem item;
+    ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, 2500));
+    ASSERT_EQ(1000, item.mTimestamp);
+    ASSERT_EQ(0u, item.mDroppedFrameCount);
+    ASSERT_EQ(OK, mConsumer->releaseBuffer(item.mBuf, item.mFrameNumber,
+            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+
+    // The second frame is superseded by the third, which is due, while a
+    // fourth one isn't yet.
+    ASSERT_EQ(OK, mConsumer->setDropLateFrames(true));
+    IGraphicBufferProducer::QueueBufferInput input(4000, true,
+            Rect(0, 0, 1, 1), NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, false,
+            Fence::NO_FENCE);
+    ASSERT_LE(0, mProducer->dequeueBuffer(&slot, &fence, false, 1, 1, 0,
+            GRALLOC_USAGE_SW_WRITE_OFTEN));
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    ASSERT_EQ(OK, mProducer->queueBuffer(slot, input, &output));
+    ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, 3500));
+    ASSERT_EQ(3000, item.mTimestamp);
+    ASSERT_EQ(3u, item.mFrameNumber);
+    ASSERT_EQ(1u, item.mDroppedFrameCount);
+}
+
+TEST_F(BufferQueueTest, ReplacedFramesAreNotCountedAsDropped) {
+    createBufferQueue();
+    sp<DummyConsumer> dc(new DummyConsumer);
+    ASSERT_EQ(OK, mConsumer->consumerConnect(dc, false));
+    IGraphicBufferProducer::QueueBufferOutput output;
+    ASSERT_EQ(OK,
+            mProducer->connect(NULL, NATIVE_WINDOW_API_CPU, false, &output));
+
+    // In async mode the second frame replaces the first in the queue, and
+    // the consumer only hears about one of them.
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> buffer;
+    for (nsecs_t timestamp = 1000; timestamp <= 2000; timestamp += 1000) {
+        IGraphicBufferProducer::QueueBufferInput input(timestamp, true,
+                Rect(0, 0, 1, 1), NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, true,
+                Fence::NO_FENCE);
+        ASSERT_LE(0, mProducer->dequeueBuffer(&slot, &fence, true, 1, 1, 0,
+                GRALLOC_USAGE_SW_WRITE_OFTEN));
+        ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+        ASSERT_EQ(OK, mProducer->queueBuffer(slot, input, &output));
+    }
+
+    ASSERT_EQ(OK, mConsumer->setDropLateFrames(true));
+    IGraphicBufferConsumer::BufferItem item;
+    ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, 2500));
+    ASSERT_EQ(2u, item.mFrameNumber);
+    ASSERT_EQ(0u, item.mDroppedFrameCount);
+}
+
 } // namespace android
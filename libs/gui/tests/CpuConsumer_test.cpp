@@ -200,7 +200,8 @@ void checkPixel(const CpuConsumer::LockedBuffer &buf,
             EXPECT_EQ(r, *bPtr) << "at x = " << x << " y = " << y;
             break;
         }
-        case HAL_PIXEL_FORMAT_RGBA_8888: {
+        case HAL_PIXEL_FORMAT_RGBA_8888:
+        case HAL_PIXEL_FORMAT_RGBX_8888: {
             const int bytesPerPixel = 4;
             uint8_t *bPtr = (uint8_t*)buf.data;
             bPtr += (y * buf.stride + x) * bytesPerPixel;
@@ -614,6 +615,43 @@ TEST_P(CpuConsumerTest, FromCpuManyInQueue) {
     }
 }
 
+TEST_P(CpuConsumerTest, FromCpuPersistentMapping) {
+    status_t err;
+    CpuConsumerTestParams params = GetParam();
+
+    const int numFrames = 5;
+    // Set up
+
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, 1));
+    mCC->setPersistentMapping(true);
+
+    // Produce and consume one at a time, so that slots are mapped again
+
+    for (int i = 0; i < numFrames; i++) {
+        const int64_t time = i + 1;
+        uint32_t stride;
+        ASSERT_NO_FATAL_FAILURE(produceOneFrame(mANW, params, time,
+                        &stride));
+
+        CpuConsumer::LockedBuffer b;
+        err = mCC->lockNextBuffer(&b);
+        ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+
+        ASSERT_TRUE(b.data != NULL);
+        EXPECT_EQ(params.width,  b.width);
+        EXPECT_EQ(params.height, b.height);
+        EXPECT_EQ(params.format, b.format);
+        EXPECT_EQ(stride, b.stride);
+        EXPECT_EQ(time, b.timestamp);
+
+        checkAnyBuffer(b, GetParam().format);
+
+        mCC->unlockBuffer(b);
+    }
+
+    mCC->setPersistentMapping(false);
+}
+
 // This test is disabled because the HAL_PIXEL_FORMAT_RAW_SENSOR format is not
 // supported on all devices.
 TEST_P(CpuConsumerTest, FromCpuLockMax) {
@@ -691,6 +729,46 @@ TEST_P(CpuConsumerTest, FromCpuLockMax) {
 
 }
 
+// Only RGBA buffers are converted, the other formats under test can't be
+// sampled by every GPU.
+TEST_P(CpuConsumerTest, FromCpuConverted) {
+    status_t err;
+    CpuConsumerTestParams params = GetParam();
+    if (params.format != HAL_PIXEL_FORMAT_RGBA_8888) {
+        return;
+    }
+
+    // Set up
+
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, 1));
+    err = mCC->setConvertedFormat(HAL_PIXEL_FORMAT_RGBX_8888);
+    ASSERT_NO_ERROR(err, "setConvertedFormat error: ");
+
+    // Produce
+
+    const int64_t time = 12345678L;
+    uint32_t stride;
+    ASSERT_NO_FATAL_FAILURE(produceOneFrame(mANW, params, time,
+                    &stride));
+
+    // Consume a copy of the frame, the stride is the one of the copy
+
+    CpuConsumer::LockedBuffer b;
+    err = mCC->lockNextBuffer(&b);
+    ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+
+    ASSERT_TRUE(b.data != NULL);
+    EXPECT_EQ(params.width,  b.width);
+    EXPECT_EQ(params.height, b.height);
+    EXPECT_EQ(HAL_PIXEL_FORMAT_RGBX_8888, b.format);
+    EXPECT_EQ(time, b.timestamp);
+
+    checkAnyBuffer(b, GetParam().format);
+    mCC->unlockBuffer(b);
+
+    mCC->setConvertedFormat(0);
+}
+
 CpuConsumerTestParams y8TestSets[] = {
     { 512,   512, 1, HAL_PIXEL_FORMAT_Y8},
     { 512,   512, 3, HAL_PIXEL_FORMAT_Y8},
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "SensorEventRing_test"
+//#define LOG_NDEBUG 0
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <android/sensor.h>
+#include <private/gui/SensorEventRing.h>
+
+#include <gtest/gtest.h>
+
+namespace android {
+
+class SensorEventRingTest : public ::testing::Test {
+protected:
+    enum { CAPACITY = 8 };
+
+    virtual void SetUp() {
+        mWriter = SensorEventRing::create(CAPACITY);
+        ASSERT_TRUE(mWriter != NULL);
+        mReader = SensorEventRing::map(dup(mWriter->getFd()));
+        ASSERT_TRUE(mReader != NULL);
+        ASSERT_EQ(size_t(CAPACITY), mReader->getCapacity());
+    }
+
+    static void fill(ASensorEvent* events, size_t count, int32_t first) {
+        memset(events, 0, count * sizeof(ASensorEvent));
+        for (size_t i = 0; i < count; i++) {
+            events[i].sensor = first + i;
+        }
+    }
+
+    sp<SensorEventRing> mWriter;
+    sp<SensorEventRing> mReader;
+};
+
+TEST_F(SensorEventRingTest, EventsArriveInOrderAcrossTheWrap) {
+    ASensorEvent in[CAPACITY];
+    ASensorEvent out[CAPACITY];
+    bool wake;
+    int32_t next = 0;
+    int32_t expected = 0;
+    for (int round = 0; round < 5; round++) {
+        fill(in, 5, next);
+        ASSERT_EQ(5, mWriter->write(in, 5, &wake));
+        next += 5;
+        size_t count;
+        while ((count = mReader->read(out, 3)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                EXPECT_EQ(expected++, out[i].sensor);
+            }
+        }
+    }
+    EXPECT_EQ(next, expected);
+}
+
+TEST_F(SensorEventRingTest, FullRingTakesNothingAndAsksForRoom) {
+    ASensorEvent events[CAPACITY];
+    bool wake;
+    fill(events, CAPACITY, 0);
+    ASSERT_EQ(CAPACITY - 2, mWriter->write(events, CAPACITY - 2, &wake));
+    EXPECT_FALSE(mReader->takeWriterWaiting());
+
+    EXPECT_EQ(-EAGAIN, mWriter->write(events, 3, &wake));
+    EXPECT_EQ(size_t(1), mReader->read(events, 1));
+    EXPECT_TRUE(mReader->takeWriterWaiting());
+    EXPECT_FALSE(mReader->takeWriterWaiting());
+    EXPECT_EQ(3, mWriter->write(events, 3, &wake));
+}
+
+TEST_F(SensorEventRingTest, ReaderIsWokenOnlyWhenArmed) {
+    ASensorEvent events[2];
+    bool wake = true;
+    fill(events, 2, 0);
+    ASSERT_EQ(1, mWriter->write(events, 1, &wake));
+    EXPECT_FALSE(wake);
+
+    // there's an event waiting, so no wakeup is needed
+    EXPECT_FALSE(mReader->armReaderWakeup());
+    EXPECT_EQ(size_t(1), mReader->read(events, 2));
+    EXPECT_TRUE(mReader->armReaderWakeup());
+    EXPECT_EQ(size_t(0), mReader->read(events, 2));
+
+    ASSERT_EQ(1, mWriter->write(events, 1, &wake));
+    EXPECT_TRUE(wake);
+    ASSERT_EQ(1, mWriter->write(events, 1, &wake));
+    EXPECT_FALSE(wake);
+}
+
+TEST_F(SensorEventRingTest, MapRejectsOtherRegions) {
+    EXPECT_TRUE(SensorEventRing::map(dup(STDIN_FILENO)) == NULL);
+}
+
+} // namespace android
@@ -203,6 +203,67 @@ TEST_F(StreamSplitterTest, OneInputMultipleOutputs) {
     ASSERT_EQ(1, allocator->getAllocCount());
 }
 
+TEST_F(StreamSplitterTest, ManyFramesToManyOutputs) {
+    const int MAX_OUTPUTS = 8;
+    const int NUM_FRAMES = 10;
+
+    for (int numOutputs = 2; numOutputs <= MAX_OUTPUTS; numOutputs *= 2) {
+        sp<IGraphicBufferProducer> inputProducer;
+        sp<IGraphicBufferConsumer> inputConsumer;
+        BufferQueue::createBufferQueue(&inputProducer, &inputConsumer);
+
+        sp<IGraphicBufferProducer> outputProducers[MAX_OUTPUTS] = {};
+        sp<IGraphicBufferConsumer> outputConsumers[MAX_OUTPUTS] = {};
+        for (int output = 0; output < numOutputs; ++output) {
+            BufferQueue::createBufferQueue(&outputProducers[output],
+                    &outputConsumers[output]);
+            ASSERT_EQ(OK, outputConsumers[output]->consumerConnect(
+                        new DummyListener, false));
+        }
+
+        sp<StreamSplitter> splitter;
+        ASSERT_EQ(OK, StreamSplitter::createSplitter(inputConsumer, &splitter));
+        for (int output = 0; output < numOutputs; ++output) {
+            ASSERT_EQ(OK, splitter->addOutput(outputProducers[output]));
+        }
+
+        IGraphicBufferProducer::QueueBufferOutput qbOutput;
+        ASSERT_EQ(OK, inputProducer->connect(new DummyProducerListener,
+                NATIVE_WINDOW_API_CPU, false, &qbOutput));
+
+        // Every output has to release a frame before the input gets its
+        // buffer back, so the input would run out of buffers if a release
+        // was lost.
+        for (int frame = 1; frame <= NUM_FRAMES; ++frame) {
+            int slot;
+            sp<Fence> fence;
+            status_t result = inputProducer->dequeueBuffer(&slot, &fence,
+                    false, 0, 0, 0, GRALLOC_USAGE_SW_WRITE_OFTEN);
+            ASSERT_LE(0, result);
+            if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+                sp<GraphicBuffer> buffer;
+                ASSERT_EQ(OK, inputProducer->requestBuffer(slot, &buffer));
+            }
+            IGraphicBufferProducer::QueueBufferInput qbInput(frame, false,
+                    Rect(0, 0, 1, 1), NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                    false, Fence::NO_FENCE);
+            ASSERT_EQ(OK, inputProducer->queueBuffer(slot, qbInput,
+                    &qbOutput));
+
+            for (int output = 0; output < numOutputs; ++output) {
+                IGraphicBufferConsumer::BufferItem item;
+                ASSERT_EQ(OK, outputConsumers[output]->acquireBuffer(&item,
+                        0));
+                ASSERT_EQ(frame, item.mTimestamp)
+                        << "output " << output << " of " << numOutputs;
+                ASSERT_EQ(OK, outputConsumers[output]->releaseBuffer(
+                        item.mBuf, item.mFrameNumber, EGL_NO_DISPLAY,
+                        EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+            }
+        }
+    }
+}
+
 TEST_F(StreamSplitterTest, OutputAbandonment) {
     sp<IGraphicBufferProducer> inputProducer;
     sp<IGraphicBufferConsumer> inputConsumer;
@@ -73,6 +73,20 @@ TEST_F(SurfaceTest, QueuesToWindowComposerIsTrueWhenVisible) {
     EXPECT_EQ(1, result);
 }
 
+TEST_F(SurfaceTest, TransactionAppliesOutsideGlobalTransaction) {
+    SurfaceComposerClient::openGlobalTransaction();
+    SurfaceComposerClient::Transaction t;
+    ASSERT_EQ(NO_ERROR, t.setLayer(mSurfaceControl, 0x7ffffffe));
+    ASSERT_EQ(NO_ERROR, t.setPosition(mSurfaceControl, 1, 1));
+    ASSERT_EQ(NO_ERROR, t.hide(mSurfaceControl));
+    ASSERT_EQ(NO_ERROR, t.show(mSurfaceControl));
+    EXPECT_EQ(NO_ERROR, t.apply(true));
+    SurfaceComposerClient::closeGlobalTransaction();
+
+    // applying it again sends nothing
+    EXPECT_EQ(NO_ERROR, t.apply());
+}
+
 TEST_F(SurfaceTest, QueuesToWindowComposerIsTrueWhenPurgatorized) {
     mSurfaceControl.clear();
 
@@ -155,4 +169,104 @@ TEST_F(SurfaceTest, QueryConsumerUsage) {
     ASSERT_EQ(TEST_USAGE_FLAGS, flags);
 }
 
+TEST_F(SurfaceTest, DequeueAheadDeliversEveryFrame) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    sp<BufferItemConsumer> c = new BufferItemConsumer(consumer,
+            GRALLOC_USAGE_SW_READ_OFTEN);
+    sp<Surface> s = new Surface(producer);
+
+    sp<ANativeWindow> anw(s);
+    ASSERT_EQ(NO_ERROR, native_window_api_connect(anw.get(),
+            NATIVE_WINDOW_API_CPU));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(anw.get(), 4));
+    ASSERT_EQ(NO_ERROR, anw->perform(anw.get(),
+            NATIVE_WINDOW_SET_DEQUEUE_AHEAD, 1));
+
+    for (int i = 0; i < 10; i++) {
+        // Changing the dimensions halfway through drops a prefetched buffer
+        if (i == 5) {
+            ASSERT_EQ(NO_ERROR, native_window_set_buffers_dimensions(
+                    anw.get(), 16, 16));
+        }
+        ANativeWindowBuffer* buffer;
+        ASSERT_EQ(NO_ERROR, native_window_dequeue_buffer_and_wait(anw.get(),
+                &buffer));
+        ASSERT_EQ(NO_ERROR, anw->queueBuffer(anw.get(), buffer, -1));
+
+        BufferItemConsumer::BufferItem item;
+        ASSERT_EQ(NO_ERROR, c->acquireBuffer(&item, 0));
+        if (i >= 5) {
+            EXPECT_EQ(16U, item.mGraphicBuffer->getWidth());
+        }
+        ASSERT_EQ(NO_ERROR, c->releaseBuffer(item));
+    }
+
+    ASSERT_EQ(NO_ERROR, native_window_api_disconnect(anw.get(),
+            NATIVE_WINDOW_API_CPU));
+}
+
+// Counts the frames, and whether any was announced on the given thread
+class FrameCounter : public ConsumerBase::FrameAvailableListener {
+public:
+    FrameCounter(pid_t tid) : mTid(tid), mFrames(0), mOnTid(false) {}
+
+    void waitForFrames(int frames) {
+        Mutex::Autolock lock(mMutex);
+        while (mFrames < frames) {
+            mCondition.wait(mMutex);
+        }
+    }
+
+    bool calledOnTid() {
+        Mutex::Autolock lock(mMutex);
+        return mOnTid;
+    }
+
+    virtual void onFrameAvailable() {
+        Mutex::Autolock lock(mMutex);
+        mFrames++;
+        mOnTid |= gettid() == mTid;
+        mCondition.signal();
+    }
+
+private:
+    const pid_t mTid;
+    int mFrames;
+    bool mOnTid;
+    Mutex mMutex;
+    Condition mCondition;
+};
+
+TEST_F(SurfaceTest, AsyncFrameAvailableDeliversEveryFrame) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    sp<BufferItemConsumer> c = new BufferItemConsumer(consumer,
+            GRALLOC_USAGE_SW_READ_OFTEN);
+    sp<FrameCounter> counter = new FrameCounter(gettid());
+    c->setFrameAvailableListener(counter);
+    c->setAsyncFrameAvailable(true);
+    sp<Surface> s = new Surface(producer);
+
+    sp<ANativeWindow> anw(s);
+    ASSERT_EQ(NO_ERROR, native_window_api_connect(anw.get(),
+            NATIVE_WINDOW_API_CPU));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(anw.get(), 4));
+
+    // Nothing is acquired, so each of the frames must be announced
+    for (int i = 0; i < 3; i++) {
+        ANativeWindowBuffer* buffer;
+        ASSERT_EQ(NO_ERROR, native_window_dequeue_buffer_and_wait(anw.get(),
+                &buffer));
+        ASSERT_EQ(NO_ERROR, anw->queueBuffer(anw.get(), buffer, -1));
+    }
+    counter->waitForFrames(3);
+    EXPECT_FALSE(counter->calledOnTid());
+
+    ASSERT_EQ(NO_ERROR, native_window_api_disconnect(anw.get(),
+            NATIVE_WINDOW_API_CPU));
+}
+
 }
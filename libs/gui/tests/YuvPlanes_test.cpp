@@ -0,0 +1,98 @@
+/*
+ * Copyright 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "YuvPlanes_test"
+//#define LOG_NDEBUG 0
+
+#include <string.h>
+
+#include <gui/YuvPlanes.h>
+
+#include <gtest/gtest.h>
+
+namespace android {
+
+// Odd sizes, so that both the vector loops and the tails run
+enum { WIDTH = 37, HEIGHT = 5, STRIDE = 48 };
+
+TEST(YuvPlanesTest, CopyPlaneHonorsStrides) {
+    uint8_t src[HEIGHT * STRIDE];
+    uint8_t dst[HEIGHT * WIDTH];
+    for (size_t i = 0; i < sizeof(src); i++) {
+        src[i] = i * 7;
+    }
+    copyPlane(dst, WIDTH, src, STRIDE, WIDTH, HEIGHT);
+    for (int y = 0; y < HEIGHT; y++) {
+        ASSERT_EQ(0, memcmp(dst + y * WIDTH, src + y * STRIDE, WIDTH))
+                << "row " << y;
+    }
+}
+
+TEST(YuvPlanesTest, SplitChromaDeinterleavesNV21) {
+    // NV21 stores Cr first
+    uint8_t chroma[HEIGHT * STRIDE * 2];
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            chroma[y * STRIDE * 2 + 2 * x] = 100 + x + y;
+            chroma[y * STRIDE * 2 + 2 * x + 1] = 10 + x + y;
+        }
+    }
+    CpuConsumer::LockedBuffer b;
+    memset(&b, 0, sizeof(b));
+    b.dataCr = chroma;
+    b.dataCb = chroma + 1;
+    b.chromaStride = STRIDE * 2;
+    b.chromaStep = 2;
+    b.chromaWidth = WIDTH;
+    b.chromaHeight = HEIGHT;
+
+    uint8_t cb[HEIGHT * WIDTH];
+    uint8_t cr[HEIGHT * WIDTH];
+    ASSERT_EQ(NO_ERROR, splitChroma(b, cb, cr, WIDTH));
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            EXPECT_EQ(10 + x + y, cb[y * WIDTH + x]) << x << "," << y;
+            EXPECT_EQ(100 + x + y, cr[y * WIDTH + x]) << x << "," << y;
+        }
+    }
+}
+
+TEST(YuvPlanesTest, SplitChromaNeedsChroma) {
+    CpuConsumer::LockedBuffer b;
+    memset(&b, 0, sizeof(b));
+    uint8_t cb[1], cr[1];
+    EXPECT_EQ(BAD_VALUE, splitChroma(b, cb, cr, 1));
+}
+
+TEST(YuvPlanesTest, DownsamplePlaneAveragesWithRounding) {
+    uint8_t src[HEIGHT * 2 * STRIDE * 2];
+    uint8_t dst[HEIGHT * WIDTH];
+    const size_t srcStride = STRIDE * 2;
+    for (size_t i = 0; i < sizeof(src); i++) {
+        src[i] = (i * 13) & 0xff;
+    }
+    downsamplePlane(dst, WIDTH, src, srcStride, WIDTH, HEIGHT);
+    for (int y = 0; y < HEIGHT; y++) {
+        const uint8_t* r0 = src + 2 * y * srcStride;
+        const uint8_t* r1 = r0 + srcStride;
+        for (int x = 0; x < WIDTH; x++) {
+            int sum = r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1];
+            EXPECT_EQ((sum + 2) / 4, dst[y * WIDTH + x]) << x << "," << y;
+        }
+    }
+}
+
+} // namespace android
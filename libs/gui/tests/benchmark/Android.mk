@@ -0,0 +1,18 @@
+# Build the libgui micro benchmarks.
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    transactionBenchmark.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+    libbinder \
+    libcutils \
+    libgui \
+    libui \
+    libutils
+
+LOCAL_MODULE := transactionBenchmark
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_EXECUTABLE)
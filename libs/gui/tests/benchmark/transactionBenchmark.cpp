@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures the cost of marshalling the layer states of a transaction, as
+ * ISurfaceComposer::setTransactionState() does, without sending it. Each
+ * run writes and reads back the states of a number of layers that changed
+ * a few fields, from only the position (a typical animation frame) to
+ * everything.
+ *
+ * usage: transactionBenchmark [layers] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <private/gui/LayerState.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+using namespace android;
+
+static void makeStates(Vector<layer_state_t>* states, size_t count,
+        uint32_t what) {
+    states->clear();
+    for (size_t i = 0; i < count; i++) {
+        layer_state_t s;
+        s.surface = new BBinder();
+        s.what = what;
+        s.x = i;
+        s.y = i * 2;
+        s.z = i;
+        s.w = s.h = 64;
+        s.alpha = 0.5f;
+        s.crop = Rect(32, 32);
+        s.transparentRegion.orSelf(Rect(8, 8));
+        s.transparentRegion.orSelf(Rect(16, 16, 24, 24));
+        states->add(s);
+    }
+}
+
+static void run(const char* name, size_t layers, size_t iterations,
+        uint32_t what) {
+    Vector<layer_state_t> states;
+    makeStates(&states, layers, what);
+
+    size_t bytes = 0;
+    nsecs_t writeTime = 0;
+    nsecs_t readTime = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        Parcel parcel;
+        nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        parcel.writeInt32(layers);
+        for (size_t j = 0; j < layers; j++) {
+            states[j].write(parcel);
+        }
+        nsecs_t written = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        parcel.setDataPosition(0);
+        size_t count = parcel.readInt32();
+        for (size_t j = 0; j < count; j++) {
+            layer_state_t s;
+            s.read(parcel);
+        }
+        nsecs_t end = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        bytes = parcel.dataSize();
+        writeTime += written - start;
+        readTime += end - written;
+    }
+    printf("%-10s\t%zu\t%.1f\t%.1f\n", name, bytes,
+            writeTime / double(iterations) / 1000.0,
+            readTime / double(iterations) / 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+    const size_t layers = argc > 1 ? atoi(argv[1]) : 32;
+    const size_t iterations = argc > 2 ? atoi(argv[2]) : 10000;
+
+    printf("%zu layers, %zu iterations\n", layers, iterations);
+    printf("changes   \tbytes\twrite us\tread us\n");
+    run("position", layers, iterations, layer_state_t::ePositionChanged);
+    run("pos+alpha", layers, iterations,
+            layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged);
+    run("geometry", layers, iterations,
+            layer_state_t::ePositionChanged | layer_state_t::eSizeChanged |
+            layer_state_t::eMatrixChanged | layer_state_t::eCropChanged);
+    run("all", layers, iterations, 0xffffffff);
+    return 0;
+}
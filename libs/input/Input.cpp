@@ -282,6 +282,12 @@ void MotionEvent::addSample(
     mSamplePointerCoords.appendArray(pointerCoords, getPointerCount());
 }
 
+void MotionEvent::reserveSamples(size_t sampleCount, size_t pointerCount) {
+    mPointerProperties.setCapacity(pointerCount);
+    mSampleEventTimes.setCapacity(sampleCount);
+    mSamplePointerCoords.setCapacity(sampleCount * pointerCount);
+}
+
 const PointerCoords* MotionEvent::getRawPointerCoords(size_t pointerIndex) const {
     return &mSamplePointerCoords[getHistorySize() * getPointerCount() + pointerIndex];
 }
@@ -425,6 +431,14 @@ status_t MotionEvent::readFromParcel(Parcel* parcel) {
         return BAD_VALUE;
     }
 
+    // Each sample takes at least its event time and the axis bits of each
+    // pointer, so the parcel cannot hold more samples than this.  Bounding
+    // the count here keeps a bogus one from sizing the storage below.
+    const size_t minSampleSize = sizeof(int64_t) * (1 + pointerCount);
+    if (sampleCount > parcel->dataAvail() / minSampleSize) {
+        return BAD_VALUE;
+    }
+
     mDeviceId = parcel->readInt32();
     mSource = parcel->readInt32();
     mAction = parcel->readInt32();
@@ -439,11 +453,13 @@ status_t MotionEvent::readFromParcel(Parcel* parcel) {
     mDownTime = parcel->readInt64();
 
     mPointerProperties.clear();
-    mPointerProperties.setCapacity(pointerCount);
     mSampleEventTimes.clear();
-    mSampleEventTimes.setCapacity(sampleCount);
     mSamplePointerCoords.clear();
-    mSamplePointerCoords.setCapacity(sampleCount * pointerCount);
+    if (mPointerProperties.setCapacity(pointerCount)
+            || mSampleEventTimes.setCapacity(sampleCount)
+            || mSamplePointerCoords.setCapacity(sampleCount * pointerCount)) {
+        return NO_MEMORY;
+    }
 
     for (size_t i = 0; i < pointerCount; i++) {
         mPointerProperties.push();
@@ -534,7 +550,7 @@ int32_t MotionEvent::getAxisFromLabel(const char* label) {
 // --- PooledInputEventFactory ---
 
 PooledInputEventFactory::PooledInputEventFactory(size_t maxPoolSize) :
-        mMaxPoolSize(maxPoolSize) {
+        mMaxPoolSize(maxPoolSize), mMotionSampleCount(0), mMotionPointerCount(0) {
 }
 
 PooledInputEventFactory::~PooledInputEventFactory() {
@@ -561,7 +577,11 @@ MotionEvent* PooledInputEventFactory::createMotionEvent() {
         mMotionEventPool.pop();
         return event;
     }
-    return new MotionEvent();
+    MotionEvent* event = new MotionEvent();
+    if (mMotionSampleCount) {
+        event->reserveSamples(mMotionSampleCount, mMotionPointerCount);
+    }
+    return event;
 }
 
 void PooledInputEventFactory::recycle(InputEvent* event) {
@@ -572,13 +592,22 @@ void PooledInputEventFactory::recycle(InputEvent* event) {
             return;
         }
         break;
-    case AINPUT_EVENT_TYPE_MOTION:
+    case AINPUT_EVENT_TYPE_MOTION: {
+        MotionEvent* motionEvent = static_cast<MotionEvent*>(event);
+        const size_t sampleCount = motionEvent->getHistorySize() + 1;
+        if (sampleCount > mMotionSampleCount) {
+            mMotionSampleCount = sampleCount;
+        }
+        if (motionEvent->getPointerCount() > mMotionPointerCount) {
+            mMotionPointerCount = motionEvent->getPointerCount();
+        }
         if (mMotionEventPool.size() < mMaxPoolSize) {
-            mMotionEventPool.push(static_cast<MotionEvent*>(event));
+            mMotionEventPool.push(motionEvent);
             return;
         }
         break;
     }
+    }
     delete event;
 }
 
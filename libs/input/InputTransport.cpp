@@ -24,8 +24,11 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <cutils/log.h>
@@ -41,6 +44,9 @@ namespace android {
 // behind processing touches.
 static const size_t SOCKET_BUFFER_SIZE = 32 * 1024;
 
+// Largest number of messages passed to a single sendmmsg or recvmmsg call.
+static const size_t MAX_MESSAGES_PER_CALL = 8;
+
 // Nanoseconds per milliseconds.
 static const nsecs_t NANOS_PER_MS = 1000000;
 
@@ -55,6 +61,10 @@ static const nsecs_t RESAMPLE_MIN_DELTA = 2 * NANOS_PER_MS;
 // far into the future.  This time is further bounded by 50% of the last time delta.
 static const nsecs_t RESAMPLE_MAX_PREDICTION = 8 * NANOS_PER_MS;
 
+// Largest accepted value of ro.input.touch_prediction_ms.  Predicting further than a
+// couple of frames ahead overshoots more than it helps.
+static const int MAX_TOUCH_PREDICTION_HORIZON_MS = 32;
+
 template<typename T>
 inline static T min(const T& a, const T& b) {
     return a < b ? a : b;
@@ -76,6 +86,8 @@ bool InputMessage::isValid(size_t actualSize) const {
                     && body.motion.pointerCount <= MAX_POINTERS;
         case TYPE_FINISHED:
             return true;
+        case TYPE_MOTION_COMPACT:
+            return body.compactMotion.dataSize <= sizeof(body.compactMotion.data);
         }
     }
     return false;
@@ -89,15 +101,71 @@ size_t InputMessage::size() const {
         return sizeof(Header) + body.motion.size();
     case TYPE_FINISHED:
         return sizeof(Header) + body.finished.size();
+    case TYPE_MOTION_COMPACT:
+        return sizeof(Header) + body.compactMotion.size();
     }
     return sizeof(Header);
 }
 
+void InputMessage::encodeCompactMotion(const InputMessage& msg, InputMessage* outMsg) {
+    const Body::Motion& motion = msg.body.motion;
+    Body::CompactMotion& compact = outMsg->body.compactMotion;
+    outMsg->header.type = TYPE_MOTION_COMPACT;
+    outMsg->header.padding = 0;
+    memcpy(compact.fields, &motion, sizeof(compact.fields));
+    compact.padding = 0;
+
+    uint8_t* data = compact.data;
+    for (uint32_t i = 0; i < motion.pointerCount; i++) {
+        const PointerCoords& coords = motion.pointers[i].coords;
+        size_t valuesSize = sizeof(float) * BitSet64::count(coords.bits);
+        memcpy(data, &motion.pointers[i].properties, sizeof(PointerProperties));
+        data += sizeof(PointerProperties);
+        memcpy(data, &coords.bits, sizeof(coords.bits));
+        data += sizeof(coords.bits);
+        memcpy(data, coords.values, valuesSize);
+        data += valuesSize;
+    }
+    compact.dataSize = data - compact.data;
+}
+
+bool InputMessage::decodeCompactMotion(const InputMessage& msg, InputMessage* outMsg) {
+    const Body::CompactMotion& compact = msg.body.compactMotion;
+    Body::Motion& motion = outMsg->body.motion;
+    memcpy(&motion, compact.fields, sizeof(compact.fields));
+    if (motion.pointerCount == 0 || motion.pointerCount > MAX_POINTERS) {
+        return false;
+    }
+
+    const uint8_t* data = compact.data;
+    const uint8_t* end = compact.data + compact.dataSize;
+    for (uint32_t i = 0; i < motion.pointerCount; i++) {
+        PointerCoords& coords = motion.pointers[i].coords;
+        if (size_t(end - data) < sizeof(PointerProperties) + sizeof(coords.bits)) {
+            return false;
+        }
+        memcpy(&motion.pointers[i].properties, data, sizeof(PointerProperties));
+        data += sizeof(PointerProperties);
+        memcpy(&coords.bits, data, sizeof(coords.bits));
+        data += sizeof(coords.bits);
+
+        uint32_t count = BitSet64::count(coords.bits);
+        if (count > PointerCoords::MAX_AXES || size_t(end - data) < sizeof(float) * count) {
+            return false;
+        }
+        memcpy(coords.values, data, sizeof(float) * count);
+        data += sizeof(float) * count;
+    }
+    outMsg->header.type = TYPE_MOTION;
+    outMsg->header.padding = 0;
+    return data == end;
+}
+
 
 // --- InputChannel ---
 
 InputChannel::InputChannel(const String8& name, int fd) :
-        mName(name), mFd(fd) {
+        mName(name), mFd(fd), mCompactMotionEncoding(true), mPendingReceiveError(OK) {
 #if DEBUG_CHANNEL_LIFECYCLE
     ALOGD("Input channel constructed: name='%s', fd=%d",
             mName.string(), fd);
@@ -145,7 +213,41 @@ status_t InputChannel::openInputChannelPair(const String8& name,
     return OK;
 }
 
+static status_t sendErrorToStatus(int error) {
+    if (error == EAGAIN || error == EWOULDBLOCK) {
+        return WOULD_BLOCK;
+    }
+    if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
+        return DEAD_OBJECT;
+    }
+    return -error;
+}
+
+static status_t receiveErrorToStatus(int error) {
+    if (error == EAGAIN || error == EWOULDBLOCK) {
+        return WOULD_BLOCK;
+    }
+    if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
+        return DEAD_OBJECT;
+    }
+    return -error;
+}
+
+void InputChannel::encodeMessage(const InputMessage* msg, InputMessage* outMsg) const {
+    if (mCompactMotionEncoding && msg->header.type == InputMessage::TYPE_MOTION) {
+        InputMessage::encodeCompactMotion(*msg, outMsg);
+    } else {
+        memcpy(outMsg, msg, msg->size());
+    }
+}
+
 status_t InputChannel::sendMessage(const InputMessage* msg) {
+    InputMessage compactMsg;
+    if (mCompactMotionEncoding && msg->header.type == InputMessage::TYPE_MOTION) {
+        InputMessage::encodeCompactMotion(*msg, &compactMsg);
+        msg = &compactMsg;
+    }
+
     size_t msgLength = msg->size();
     ssize_t nWrite;
     do {
@@ -158,13 +260,7 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
         ALOGD("channel '%s' ~ error sending message of type %d, errno=%d", mName.string(),
                 msg->header.type, error);
 #endif
-        if (error == EAGAIN || error == EWOULDBLOCK) {
-            return WOULD_BLOCK;
-        }
-        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
-            return DEAD_OBJECT;
-        }
-        return -error;
+        return sendErrorToStatus(error);
     }
 
     if (size_t(nWrite) != msgLength) {
@@ -181,7 +277,60 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
     return OK;
 }
 
+status_t InputChannel::sendMessages(const InputMessage* msgs, size_t count, size_t* outSent) {
+    *outSent = 0;
+    while (*outSent < count) {
+        struct iovec iovs[MAX_MESSAGES_PER_CALL];
+        struct mmsghdr headers[MAX_MESSAGES_PER_CALL];
+        size_t n = min(count - *outSent, MAX_MESSAGES_PER_CALL);
+        memset(headers, 0, sizeof(struct mmsghdr) * n);
+        for (size_t i = 0; i < n; i++) {
+            const InputMessage& msg = msgs[*outSent + i];
+            iovs[i].iov_base = const_cast<InputMessage*>(&msg);
+            iovs[i].iov_len = msg.size();
+            headers[i].msg_hdr.msg_iov = &iovs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int nWrite;
+        do {
+            nWrite = ::sendmmsg(mFd, headers, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } while (nWrite == -1 && errno == EINTR);
+
+        if (nWrite <= 0) {
+            int error = nWrite ? errno : EAGAIN;
+#if DEBUG_CHANNEL_MESSAGES
+            ALOGD("channel '%s' ~ error sending %zu messages, errno=%d", mName.string(),
+                    n, error);
+#endif
+            return sendErrorToStatus(error);
+        }
+
+        for (int i = 0; i < nWrite; i++) {
+            if (headers[i].msg_len != iovs[i].iov_len) {
+#if DEBUG_CHANNEL_MESSAGES
+                ALOGD("channel '%s' ~ error sending message type %d, send was incomplete",
+                        mName.string(), msgs[*outSent].header.type);
+#endif
+                return DEAD_OBJECT;
+            }
+            *outSent += 1;
+        }
+
+#if DEBUG_CHANNEL_MESSAGES
+        ALOGD("channel '%s' ~ sent %d messages", mName.string(), nWrite);
+#endif
+    }
+    return OK;
+}
+
 status_t InputChannel::receiveMessage(InputMessage* msg) {
+    if (mPendingReceiveError) {
+        status_t result = mPendingReceiveError;
+        mPendingReceiveError = OK;
+        return result;
+    }
+
     ssize_t nRead;
     do {
         nRead = ::recv(mFd, msg, sizeof(InputMessage), MSG_DONTWAIT);
@@ -192,29 +341,86 @@ status_t InputChannel::receiveMessage(InputMessage* msg) {
 #if DEBUG_CHANNEL_MESSAGES
         ALOGD("channel '%s' ~ receive message failed, errno=%d", mName.string(), errno);
 #endif
-        if (error == EAGAIN || error == EWOULDBLOCK) {
-            return WOULD_BLOCK;
-        }
-        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
-            return DEAD_OBJECT;
+        return receiveErrorToStatus(error);
+    }
+
+    return checkReceivedMessage(msg, nRead);
+}
+
+status_t InputChannel::receiveMessages(InputMessage* msgs, size_t count,
+        size_t* outReceived) {
+    *outReceived = 0;
+    if (mPendingReceiveError) {
+        status_t result = mPendingReceiveError;
+        mPendingReceiveError = OK;
+        return result;
+    }
+
+    struct iovec iovs[MAX_MESSAGES_PER_CALL];
+    struct mmsghdr headers[MAX_MESSAGES_PER_CALL];
+    size_t n = min(count, MAX_MESSAGES_PER_CALL);
+    memset(headers, 0, sizeof(struct mmsghdr) * n);
+    for (size_t i = 0; i < n; i++) {
+        iovs[i].iov_base = &msgs[i];
+        iovs[i].iov_len = sizeof(InputMessage);
+        headers[i].msg_hdr.msg_iov = &iovs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int nRead;
+    do {
+        nRead = ::recvmmsg(mFd, headers, n, MSG_DONTWAIT, NULL);
+    } while (nRead == -1 && errno == EINTR);
+
+    if (nRead < 0) {
+        int error = errno;
+#if DEBUG_CHANNEL_MESSAGES
+        ALOGD("channel '%s' ~ receive messages failed, errno=%d", mName.string(), errno);
+#endif
+        return receiveErrorToStatus(error);
+    }
+
+    for (int i = 0; i < nRead; i++) {
+        status_t result = checkReceivedMessage(&msgs[i], headers[i].msg_len);
+        if (result) {
+            if (i == 0) {
+                return result;
+            }
+            // Hand out the messages before this one first.
+            mPendingReceiveError = result;
+            break;
         }
-        return -error;
+        *outReceived += 1;
     }
+    return OK;
+}
 
-    if (nRead == 0) { // check for EOF
+status_t InputChannel::checkReceivedMessage(InputMessage* msg, size_t size) {
+    if (size == 0) { // check for EOF
 #if DEBUG_CHANNEL_MESSAGES
         ALOGD("channel '%s' ~ receive message failed because peer was closed", mName.string());
 #endif
         return DEAD_OBJECT;
     }
 
-    if (!msg->isValid(nRead)) {
+    if (!msg->isValid(size)) {
 #if DEBUG_CHANNEL_MESSAGES
         ALOGD("channel '%s' ~ received invalid message", mName.string());
 #endif
         return BAD_VALUE;
     }
 
+    if (msg->header.type == InputMessage::TYPE_MOTION_COMPACT) {
+        InputMessage compactMsg;
+        memcpy(&compactMsg, msg, size);
+        if (!InputMessage::decodeCompactMotion(compactMsg, msg)) {
+#if DEBUG_CHANNEL_MESSAGES
+            ALOGD("channel '%s' ~ received malformed compact motion message", mName.string());
+#endif
+            return BAD_VALUE;
+        }
+    }
+
 #if DEBUG_CHANNEL_MESSAGES
     ALOGD("channel '%s' ~ received message of type %d", mName.string(), msg->header.type);
 #endif
@@ -223,14 +429,19 @@ status_t InputChannel::receiveMessage(InputMessage* msg) {
 
 sp<InputChannel> InputChannel::dup() const {
     int fd = ::dup(getFd());
-    return fd >= 0 ? new InputChannel(getName(), fd) : NULL;
+    if (fd < 0) {
+        return NULL;
+    }
+    sp<InputChannel> channel = new InputChannel(getName(), fd);
+    channel->setCompactMotionEncoding(mCompactMotionEncoding);
+    return channel;
 }
 
 
 // --- InputPublisher ---
 
 InputPublisher::InputPublisher(const sp<InputChannel>& channel) :
-        mChannel(channel) {
+        mChannel(channel), mBatching(false), mBatchSize(0) {
 }
 
 InputPublisher::~InputPublisher() {
@@ -275,7 +486,7 @@ status_t InputPublisher::publishKeyEvent(
     msg.body.key.repeatCount = repeatCount;
     msg.body.key.downTime = downTime;
     msg.body.key.eventTime = eventTime;
-    return mChannel->sendMessage(&msg);
+    return publishMessage(&msg);
 }
 
 status_t InputPublisher::publishMotionEvent(
@@ -339,7 +550,33 @@ status_t InputPublisher::publishMotionEvent(
         msg.body.motion.pointers[i].properties.copyFrom(pointerProperties[i]);
         msg.body.motion.pointers[i].coords.copyFrom(pointerCoords[i]);
     }
-    return mChannel->sendMessage(&msg);
+    return publishMessage(&msg);
+}
+
+void InputPublisher::beginBatch() {
+    mBatching = true;
+    mBatchSize = 0;
+}
+
+status_t InputPublisher::endBatch(size_t* outPublished) {
+    mBatching = false;
+    status_t result = mChannel->sendMessages(mBatch.array(), mBatchSize, outPublished);
+    mBatchSize = 0;
+    return result;
+}
+
+status_t InputPublisher::publishMessage(const InputMessage* msg) {
+    if (!mBatching) {
+        return mChannel->sendMessage(msg);
+    }
+    if (mBatchSize == MAX_BATCH_SIZE) {
+        return NO_MEMORY;
+    }
+    if (mBatchSize == mBatch.size()) {
+        mBatch.push();
+    }
+    mChannel->encodeMessage(msg, &mBatch.editItemAt(mBatchSize++));
+    return OK;
 }
 
 status_t InputPublisher::receiveFinishedSignal(uint32_t* outSeq, bool* outHandled) {
@@ -369,7 +606,11 @@ status_t InputPublisher::receiveFinishedSignal(uint32_t* outSeq, bool* outHandle
 
 InputConsumer::InputConsumer(const sp<InputChannel>& channel) :
         mResampleTouch(isTouchResamplingEnabled()),
-        mChannel(channel), mMsgDeferred(false) {
+        mPredictionHorizon(mResampleTouch ? getTouchPredictionHorizon() : 0),
+        mChannel(channel), mMsgDeferred(false), mReceivedIndex(0), mReceivedCount(0) {
+    if (mPredictionHorizon) {
+        mPredictorName = getTouchPredictorName();
+    }
 }
 
 InputConsumer::~InputConsumer() {
@@ -390,6 +631,24 @@ bool InputConsumer::isTouchResamplingEnabled() {
     return true;
 }
 
+nsecs_t InputConsumer::getTouchPredictionHorizon() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.input.touch_prediction_ms", value, "0");
+    int horizon = atoi(value);
+    if (horizon < 0 || horizon > MAX_TOUCH_PREDICTION_HORIZON_MS) {
+        ALOGD("Ignoring out of range value for 'ro.input.touch_prediction_ms'.  "
+                "Use 0 to %d.", MAX_TOUCH_PREDICTION_HORIZON_MS);
+        return 0;
+    }
+    return horizon * NANOS_PER_MS;
+}
+
+String8 InputConsumer::getTouchPredictorName() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.input.touch_predictor", value, "lsq2");
+    return String8(value);
+}
+
 status_t InputConsumer::consume(InputEventFactoryInterface* factory,
         bool consumeBatches, nsecs_t frameTime, uint32_t* outSeq, InputEvent** outEvent) {
 #if DEBUG_TRANSPORT_ACTIONS
@@ -409,7 +668,7 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory,
             mMsgDeferred = false;
         } else {
             // Receive a fresh message.
-            status_t result = mChannel->receiveMessage(&mMsg);
+            status_t result = receiveMessage(&mMsg);
             if (result) {
                 // Consume the next batched event unless batches are being held for later.
                 if (consumeBatches || result != WOULD_BLOCK) {
@@ -593,6 +852,9 @@ void InputConsumer::updateTouchState(InputMessage* msg) {
             index = mTouchStates.size() - 1;
         }
         TouchState& touchState = mTouchStates.editItemAt(index);
+        if (mPredictionHorizon && touchState.predictor == NULL) {
+            touchState.predictor = TouchPredictor::create(mPredictorName.string());
+        }
         touchState.initialize(deviceId, source);
         touchState.addHistory(msg);
         break;
@@ -617,6 +879,10 @@ void InputConsumer::updateTouchState(InputMessage* msg) {
         if (index >= 0) {
             TouchState& touchState = mTouchStates.editItemAt(index);
             touchState.lastResample.idBits.clearBit(msg->body.motion.getActionId());
+            if (touchState.predictor != NULL) {
+                touchState.predictor->clearPointers(
+                        BitSet32::valueForBit(msg->body.motion.getActionId()));
+            }
             rewriteMessage(touchState, msg);
         }
         break;
@@ -710,11 +976,30 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         }
     }
 
+    // While an earlier prediction is still ahead of the sample time, the real samples
+    // up to it have been rewritten to the predicted position; keep the pointers there
+    // rather than move them back to a resampled one.
+    bool predictionAhead = sampleTime < touchState.lastResample.eventTime;
+    for (size_t i = 0; predictionAhead && i < pointerCount; i++) {
+        predictionAhead = touchState.lastResample.idBits.hasBit(event->getPointerId(i));
+    }
+
     // Find the data to use for resampling.
     const History* other;
     History future;
     float alpha;
-    if (next) {
+    if (!next && mPredictionHorizon
+            && predictTouchState(touchState, sampleTime,
+                    sampleTime + RESAMPLE_LATENCY + mPredictionHorizon, event)) {
+        // Predicted from the motion so far.
+        return;
+    } else if (predictionAhead) {
+#if DEBUG_RESAMPLING
+        ALOGD("Not resampled, holding prediction for %lld ns.",
+                touchState.lastResample.eventTime - sampleTime);
+#endif
+        return;
+    } else if (next) {
         // Interpolate between current sample and future sample.
         // So current->eventTime <= sampleTime <= future.eventTime.
         future.initializeFrom(next);
@@ -793,6 +1078,56 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
     event->addSample(sampleTime, touchState.lastResample.pointers);
 }
 
+bool InputConsumer::predictTouchState(TouchState& touchState, nsecs_t sampleTime,
+        nsecs_t predictTime, MotionEvent* event) {
+    // Don't predict from a stale position; the panel may simply have stopped
+    // reporting a finger that isn't moving.
+    const History* current = touchState.getHistory(0);
+    if (touchState.predictor == NULL
+            || predictTime - current->eventTime > mPredictionHorizon + RESAMPLE_MAX_PREDICTION) {
+        return false;
+    }
+
+    size_t pointerCount = event->getPointerCount();
+    PointerCoords predictedCoords[MAX_POINTERS];
+    for (size_t i = 0; i < pointerCount; i++) {
+        uint32_t id = event->getPointerId(i);
+        const PointerCoords& currentCoords = current->getPointerById(id);
+        predictedCoords[i].copyFrom(currentCoords);
+        if (!shouldResampleTool(event->getToolType(i))) {
+            continue;
+        }
+        float x, y;
+        if (!touchState.predictor->predict(id, predictTime, &x, &y)) {
+#if DEBUG_RESAMPLING
+            ALOGD("Not predicted, no confident estimate for id %d", id);
+#endif
+            return false;
+        }
+        predictedCoords[i].setAxisValue(AMOTION_EVENT_AXIS_X, x);
+        predictedCoords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, y);
+#if DEBUG_RESAMPLING
+        ALOGD("[%d] - predicted (%0.3f, %0.3f) at +%lld ns, cur (%0.3f, %0.3f)",
+                id, x, y, predictTime - current->eventTime,
+                currentCoords.getX(), currentCoords.getY());
+#endif
+    }
+
+    // The sample is reported at the sample time, so that event times keep increasing,
+    // but the real samples up to the predicted time are rewritten to the predicted
+    // position so the pointers don't move back once they come in.
+    touchState.lastResample.eventTime = predictTime;
+    touchState.lastResample.idBits.clear();
+    for (size_t i = 0; i < pointerCount; i++) {
+        uint32_t id = event->getPointerId(i);
+        touchState.lastResample.idToIndex[id] = i;
+        touchState.lastResample.idBits.markBit(id);
+        touchState.lastResample.pointers[i].copyFrom(predictedCoords[i]);
+    }
+    event->addSample(sampleTime, predictedCoords);
+    return true;
+}
+
 bool InputConsumer::shouldResampleTool(int32_t toolType) {
     return toolType == AMOTION_EVENT_TOOL_TYPE_FINGER
             || toolType == AMOTION_EVENT_TOOL_TYPE_UNKNOWN;
@@ -851,8 +1186,31 @@ status_t InputConsumer::sendUnchainedFinishedSignal(uint32_t seq, bool handled)
     return mChannel->sendMessage(&msg);
 }
 
+status_t InputConsumer::receiveMessage(InputMessage* msg) {
+    if (mReceivedIndex == mReceivedCount) {
+        if (mReceived.isEmpty()) {
+            mReceived.push();
+        } else if (mReceivedCount == mReceived.size()
+                && mReceived.size() < RECEIVE_BATCH_SIZE) {
+            // The last receive filled the buffer, so more messages may be waiting.
+            mReceived.insertAt(mReceived.size(), RECEIVE_BATCH_SIZE - mReceived.size());
+        }
+        mReceivedIndex = 0;
+        status_t result = mChannel->receiveMessages(mReceived.editArray(), mReceived.size(),
+                &mReceivedCount);
+        if (result) {
+            return result;
+        }
+    }
+    const InputMessage& received = mReceived.itemAt(mReceivedIndex++);
+    memcpy(msg, &received, received.size());
+    return OK;
+}
+
 bool InputConsumer::hasDeferredEvent() const {
-    return mMsgDeferred;
+    // Received messages that weren't handled yet are just as invisible to the
+    // caller's poll loop as a deferred one.
+    return mMsgDeferred || mReceivedIndex < mReceivedCount;
 }
 
 bool InputConsumer::hasPendingBatch() const {
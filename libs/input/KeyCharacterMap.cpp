@@ -87,13 +87,35 @@ static String8 toString(const char16_t* chars, size_t numChars) {
 
 sp<KeyCharacterMap> KeyCharacterMap::sEmpty = new KeyCharacterMap();
 
+// Key codes up to this one are looked up in a table.
+static const int32_t MAX_TABLE_KEY_CODE = 1023;
+
+// The most bits a meta state index may have, there are
+// 2^MAX_META_TABLE_BITS entries per table.
+static const size_t MAX_META_TABLE_BITS = 10;
+
+// Modifiers with left and right variants.
+static const int32_t META_GROUPS[][3] = {
+    { AMETA_SHIFT_ON, AMETA_SHIFT_LEFT_ON, AMETA_SHIFT_RIGHT_ON },
+    { AMETA_ALT_ON, AMETA_ALT_LEFT_ON, AMETA_ALT_RIGHT_ON },
+    { AMETA_CTRL_ON, AMETA_CTRL_LEFT_ON, AMETA_CTRL_RIGHT_ON },
+    { AMETA_META_ON, AMETA_META_LEFT_ON, AMETA_META_RIGHT_ON },
+};
+
+// Modifiers that must match exactly, see matchesMetaState().
+static const int32_t EXACT_META_STATES =
+        AMETA_CTRL_ON | AMETA_CTRL_LEFT_ON | AMETA_CTRL_RIGHT_ON
+        | AMETA_ALT_ON | AMETA_ALT_LEFT_ON | AMETA_ALT_RIGHT_ON
+        | AMETA_META_ON | AMETA_META_LEFT_ON | AMETA_META_RIGHT_ON;
+
 KeyCharacterMap::KeyCharacterMap() :
-    mType(KEYBOARD_TYPE_UNKNOWN) {
+    mType(KEYBOARD_TYPE_UNKNOWN), mMetaTableFallbackMask(0), mMetaTablePoisonMask(0) {
 }
 
 KeyCharacterMap::KeyCharacterMap(const KeyCharacterMap& other) :
     RefBase(), mType(other.mType), mKeysByScanCode(other.mKeysByScanCode),
-    mKeysByUsageCode(other.mKeysByUsageCode) {
+    mKeysByUsageCode(other.mKeysByUsageCode),
+    mMetaTableFallbackMask(0), mMetaTablePoisonMask(0) {
     for (size_t i = 0; i < other.mKeys.size(); i++) {
         mKeys.add(other.mKeys.keyAt(i), new Key(*other.mKeys.valueAt(i)));
     }
@@ -149,6 +171,9 @@ status_t KeyCharacterMap::load(Tokenizer* tokenizer,
 #endif
         Parser parser(map.get(), tokenizer, format);
         status = parser.parse();
+        if (!status) {
+            map->buildLookupTables();
+        }
 #if DEBUG_PARSER_PERFORMANCE
         nsecs_t elapsedTime = systemTime(SYSTEM_TIME_MONOTONIC) - startTime;
         ALOGD("Parsed key character map file '%s' %d lines in %0.3fms.",
@@ -193,6 +218,7 @@ sp<KeyCharacterMap> KeyCharacterMap::combine(const sp<KeyCharacterMap>& base,
         map->mKeysByUsageCode.replaceValueFor(overlay->mKeysByUsageCode.keyAt(i),
                 overlay->mKeysByUsageCode.valueAt(i));
     }
+    map->buildLookupTables();
     return map;
 }
 
@@ -299,6 +325,9 @@ bool KeyCharacterMap::getEvents(int32_t deviceId, const char16_t* chars, size_t
         Vector<KeyEvent>& outEvents) const {
     nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
 
+    // A down and an up per character, plus those of the modifiers now and then
+    outEvents.setCapacity(outEvents.size() + numChars * 4);
+
     for (size_t i = 0; i < numChars; i++) {
         int32_t keyCode, metaState;
         char16_t ch = chars[i];
@@ -359,7 +388,152 @@ status_t KeyCharacterMap::mapKey(int32_t scanCode, int32_t usageCode, int32_t* o
     return NAME_NOT_FOUND;
 }
 
+void KeyCharacterMap::buildLookupTables() {
+    mKeyTable.clear();
+    mBehaviorArray.clear();
+    mMetaTables.clear();
+    mMetaTableBits.clear();
+    mMetaTableFallbackMask = 0;
+    mMetaTablePoisonMask = 0;
+    mKeysByChar.clear();
+
+    const size_t numKeys = mKeys.size();
+    if (!numKeys) {
+        return;
+    }
+
+    // Flatten the behaviors and find the characters.
+    int32_t behaviorMetaStates = 0;
+    bool tablesFit = true;
+    const int32_t maxKeyCode = mKeys.keyAt(numKeys - 1);
+    KeyEntry none;
+    none.key = NULL;
+    none.firstBehavior = 0;
+    none.numBehaviors = 0;
+    none.metaTable = -1;
+    if (maxKeyCode >= 0 && maxKeyCode <= MAX_TABLE_KEY_CODE) {
+        mKeyTable.insertAt(none, 0, maxKeyCode + 1);
+    }
+    for (size_t i = 0; i < numKeys; i++) {
+        const int32_t keyCode = mKeys.keyAt(i);
+        const Key* key = mKeys.valueAt(i);
+        KeyEntry entry(none);
+        entry.key = key;
+        entry.firstBehavior = mBehaviorArray.size();
+        for (const Behavior* behavior = key->firstBehavior; behavior; behavior = behavior->next) {
+            mBehaviorArray.add(behavior);
+            behaviorMetaStates |= behavior->metaState;
+        }
+        entry.numBehaviors = mBehaviorArray.size() - entry.firstBehavior;
+        if (entry.numBehaviors > 0xff - 1) {
+            tablesFit = false;
+        }
+        if (keyCode >= 0 && size_t(keyCode) < mKeyTable.size()) {
+            mKeyTable.editItemAt(keyCode) = entry;
+        }
+
+        // The most general behavior of the first key generating a character
+        // is the one that findKey() picks.
+        for (size_t j = entry.numBehaviors; j > 0; j--) {
+            const Behavior* behavior = mBehaviorArray[entry.firstBehavior + j - 1];
+            if (behavior->character && mKeysByChar.indexOfKey(behavior->character) < 0) {
+                CharEntry c;
+                c.keyCode = keyCode;
+                c.metaState = behavior->metaState;
+                mKeysByChar.add(behavior->character, c);
+            }
+        }
+    }
+
+    // Pick the bits of the meta state index. Left and right variants only
+    // matter if a behavior tells them apart: then the meta states with them
+    // walk the behaviors. Otherwise, which behavior matches only depends on
+    // whether the generic bit and either variant are set, and only for the
+    // exact modifiers and those behaviors use.
+    for (size_t g = 0; g < sizeof(META_GROUPS) / sizeof(META_GROUPS[0]); g++) {
+        const int32_t on = META_GROUPS[g][0];
+        const int32_t sides = META_GROUPS[g][1] | META_GROUPS[g][2];
+        const bool exact = on & EXACT_META_STATES;
+        if (behaviorMetaStates & sides) {
+            mMetaTableFallbackMask |= on | sides;
+        } else if (behaviorMetaStates & on) {
+            mMetaTableBits.add(on);
+            if (exact) {
+                mMetaTableBits.add(sides);
+            }
+        } else if (exact) {
+            // no behavior has the modifier, so none matches with it
+            mMetaTablePoisonMask |= on | sides;
+        }
+    }
+    static const int32_t OTHER_META_STATES[] = {
+        AMETA_SYM_ON, AMETA_FUNCTION_ON,
+        AMETA_CAPS_LOCK_ON, AMETA_NUM_LOCK_ON, AMETA_SCROLL_LOCK_ON,
+    };
+    for (size_t i = 0; i < sizeof(OTHER_META_STATES) / sizeof(OTHER_META_STATES[0]); i++) {
+        if (behaviorMetaStates & OTHER_META_STATES[i]) {
+            mMetaTableBits.add(OTHER_META_STATES[i]);
+        }
+    }
+    if (!tablesFit || mMetaTableBits.size() > MAX_META_TABLE_BITS) {
+        mMetaTableBits.clear();
+        mMetaTableFallbackMask = 0;
+        mMetaTablePoisonMask = 0;
+        return;
+    }
+
+    // Fill a table per list of behavior meta states, evaluating the
+    // behaviors with a meta state made of the lowest bit of each part of the
+    // index.
+    const size_t numIndices = 1 << mMetaTableBits.size();
+    Vector<int32_t> metaStates;
+    metaStates.setCapacity(numIndices);
+    for (size_t index = 0; index < numIndices; index++) {
+        int32_t metaState = 0;
+        for (size_t b = 0; b < mMetaTableBits.size(); b++) {
+            if (index & (1 << b)) {
+                metaState |= mMetaTableBits[b] & -mMetaTableBits[b];
+            }
+        }
+        metaStates.add(metaState);
+    }
+    KeyedVector<String8, ssize_t> tablesByBehaviors;
+    for (size_t i = 0; i < mKeyTable.size(); i++) {
+        KeyEntry& entry(mKeyTable.editItemAt(i));
+        if (!entry.key) {
+            continue;
+        }
+        Vector<int32_t> behaviorStates;
+        String8 signature;
+        for (size_t j = 0; j < entry.numBehaviors; j++) {
+            behaviorStates.add(mBehaviorArray[entry.firstBehavior + j]->metaState);
+            signature.appendFormat("%x,", behaviorStates[j]);
+        }
+        ssize_t found = tablesByBehaviors.indexOfKey(signature);
+        if (found >= 0) {
+            entry.metaTable = tablesByBehaviors.valueAt(found);
+            continue;
+        }
+        entry.metaTable = mMetaTables.size();
+        for (size_t index = 0; index < numIndices; index++) {
+            uint8_t match = 0;
+            for (size_t j = 0; j < behaviorStates.size(); j++) {
+                if (matchesMetaState(metaStates[index], behaviorStates[j])) {
+                    match = j + 1;
+                    break;
+                }
+            }
+            mMetaTables.add(match);
+        }
+        tablesByBehaviors.add(signature, entry.metaTable);
+    }
+}
+
 bool KeyCharacterMap::getKey(int32_t keyCode, const Key** outKey) const {
+    if (keyCode >= 0 && size_t(keyCode) < mKeyTable.size()) {
+        *outKey = mKeyTable[keyCode].key;
+        return *outKey != NULL;
+    }
     ssize_t index = mKeys.indexOfKey(keyCode);
     if (index >= 0) {
         *outKey = mKeys.valueAt(index);
@@ -370,6 +544,40 @@ bool KeyCharacterMap::getKey(int32_t keyCode, const Key** outKey) const {
 
 bool KeyCharacterMap::getKeyBehavior(int32_t keyCode, int32_t metaState,
         const Key** outKey, const Behavior** outBehavior) const {
+    if (keyCode >= 0 && size_t(keyCode) < mKeyTable.size()) {
+        const KeyEntry& entry(mKeyTable[keyCode]);
+        if (!entry.key) {
+            return false;
+        }
+        if (entry.metaTable >= 0 && !(metaState & mMetaTableFallbackMask)) {
+            if (metaState & mMetaTablePoisonMask) {
+                return false;
+            }
+            size_t index = 0;
+            for (size_t b = 0; b < mMetaTableBits.size(); b++) {
+                if (metaState & mMetaTableBits[b]) {
+                    index |= 1 << b;
+                }
+            }
+            const uint8_t match = mMetaTables[entry.metaTable + index];
+            if (!match) {
+                return false;
+            }
+            *outKey = entry.key;
+            *outBehavior = mBehaviorArray[entry.firstBehavior + match - 1];
+            return true;
+        }
+        for (size_t j = 0; j < entry.numBehaviors; j++) {
+            const Behavior* behavior = mBehaviorArray[entry.firstBehavior + j];
+            if (matchesMetaState(metaState, behavior->metaState)) {
+                *outKey = entry.key;
+                *outBehavior = behavior;
+                return true;
+            }
+        }
+        return false;
+    }
+
     const Key* key;
     if (getKey(keyCode, &key)) {
         const Behavior* behavior = key->firstBehavior;
@@ -391,10 +599,6 @@ bool KeyCharacterMap::matchesMetaState(int32_t eventMetaState, int32_t behaviorM
     // match those, taking into account that a behavior can specify that it handles
     // one, both or either of a left/right modifier pair.
     if ((eventMetaState & behaviorMetaState) == behaviorMetaState) {
-        const int32_t EXACT_META_STATES =
-                AMETA_CTRL_ON | AMETA_CTRL_LEFT_ON | AMETA_CTRL_RIGHT_ON
-                | AMETA_ALT_ON | AMETA_ALT_LEFT_ON | AMETA_ALT_RIGHT_ON
-                | AMETA_META_ON | AMETA_META_LEFT_ON | AMETA_META_RIGHT_ON;
         int32_t unmatchedMetaState = eventMetaState & ~behaviorMetaState & EXACT_META_STATES;
         if (behaviorMetaState & AMETA_CTRL_ON) {
             unmatchedMetaState &= ~(AMETA_CTRL_LEFT_ON | AMETA_CTRL_RIGHT_ON);
@@ -421,24 +625,13 @@ bool KeyCharacterMap::findKey(char16_t ch, int32_t* outKeyCode, int32_t* outMeta
         return false;
     }
 
-    for (size_t i = 0; i < mKeys.size(); i++) {
-        const Key* key = mKeys.valueAt(i);
-
-        // Try to find the most general behavior that maps to this character.
-        // For example, the base key behavior will usually be last in the list.
-        const Behavior* found = NULL;
-        for (const Behavior* behavior = key->firstBehavior; behavior; behavior = behavior->next) {
-            if (behavior->character == ch) {
-                found = behavior;
-            }
-        }
-        if (found) {
-            *outKeyCode = mKeys.keyAt(i);
-            *outMetaState = found->metaState;
-            return true;
-        }
+    ssize_t index = mKeysByChar.indexOfKey(ch);
+    if (index < 0) {
+        return false;
     }
-    return false;
+    *outKeyCode = mKeysByChar.valueAt(index).keyCode;
+    *outMetaState = mKeysByChar.valueAt(index).metaState;
+    return true;
 }
 
 void KeyCharacterMap::addKey(Vector<KeyEvent>& outEvents,
@@ -604,6 +797,7 @@ sp<KeyCharacterMap> KeyCharacterMap::readFromParcel(Parcel* parcel) {
             return NULL;
         }
     }
+    map->buildLookupTables();
     return map;
 }
 
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <limits.h>
+#include <sys/stat.h>
 
 #include <input/Keyboard.h>
 #include <input/InputEventLabels.h>
@@ -26,10 +27,77 @@
 #include <input/KeyCharacterMap.h>
 #include <input/InputDevice.h>
 #include <utils/Errors.h>
+#include <utils/KeyedVector.h>
 #include <utils/Log.h>
+#include <utils/Mutex.h>
 
 namespace android {
 
+// --- KeyMapCache ---
+
+// Key layout and key character maps are immutable once loaded, so the devices that use
+// the same file share a single copy instead of parsing it each time one is opened.
+// An entry is only reused while the file's modification time, size and inode are
+// unchanged, so edits are picked up the next time a device is opened.
+template <typename T>
+class KeyMapCache {
+public:
+    typedef status_t (*Loader)(const String8& path, sp<T>* outMap);
+
+    explicit KeyMapCache(Loader loader) : mLoader(loader) { }
+
+    status_t load(const String8& path, sp<T>* outMap) {
+        struct stat st;
+        if (stat(path.string(), &st)) {
+            // Let the loader report the error.
+            return mLoader(path, outMap);
+        }
+
+        AutoMutex _l(mLock);
+        ssize_t index = mEntries.indexOfKey(path);
+        if (index >= 0) {
+            const Entry& entry = mEntries.valueAt(index);
+            if (entry.mtime == st.st_mtime && entry.size == st.st_size
+                    && entry.ino == st.st_ino) {
+                *outMap = entry.map;
+                return OK;
+            }
+            mEntries.removeItemsAt(index);
+        }
+
+        status_t status = mLoader(path, outMap);
+        if (!status) {
+            Entry entry;
+            entry.mtime = st.st_mtime;
+            entry.size = st.st_size;
+            entry.ino = st.st_ino;
+            entry.map = *outMap;
+            mEntries.add(path, entry);
+        }
+        return status;
+    }
+
+private:
+    struct Entry {
+        time_t mtime;
+        off_t size;
+        ino_t ino;
+        sp<T> map;
+    };
+
+    Loader mLoader;
+    Mutex mLock;
+    KeyedVector<String8, Entry> mEntries;
+};
+
+static status_t loadBaseKeyCharacterMap(const String8& path, sp<KeyCharacterMap>* outMap) {
+    return KeyCharacterMap::load(path, KeyCharacterMap::FORMAT_BASE, outMap);
+}
+
+static KeyMapCache<KeyLayoutMap> gKeyLayoutMapCache(KeyLayoutMap::load);
+static KeyMapCache<KeyCharacterMap> gKeyCharacterMapCache(loadBaseKeyCharacterMap);
+
+
 // --- KeyMap ---
 
 KeyMap::KeyMap() {
@@ -111,7 +179,7 @@ status_t KeyMap::loadKeyLayout(const InputDeviceIdentifier& deviceIdentifier,
         return NAME_NOT_FOUND;
     }
 
-    status_t status = KeyLayoutMap::load(path, &keyLayoutMap);
+    status_t status = gKeyLayoutMapCache.load(path, &keyLayoutMap);
     if (status) {
         return status;
     }
@@ -128,8 +196,7 @@ status_t KeyMap::loadKeyCharacterMap(const InputDeviceIdentifier& deviceIdentifi
         return NAME_NOT_FOUND;
     }
 
-    status_t status = KeyCharacterMap::load(path,
-            KeyCharacterMap::FORMAT_BASE, &keyCharacterMap);
+    status_t status = gKeyCharacterMapCache.load(path, &keyCharacterMap);
     if (status) {
         return status;
     }
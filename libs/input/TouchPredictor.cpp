@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TouchPredictor"
+//#define LOG_NDEBUG 0
+
+#include <input/TouchPredictor.h>
+
+namespace android {
+
+// --- TouchPredictor ---
+
+sp<TouchPredictor> TouchPredictor::create(const char* name) {
+    if (!name || !*name) {
+        return NULL;
+    }
+    return new EstimatorTouchPredictor(name);
+}
+
+// --- EstimatorTouchPredictor ---
+
+const float EstimatorTouchPredictor::MIN_CONFIDENCE = 0.5f;
+
+EstimatorTouchPredictor::EstimatorTouchPredictor(const char* strategy) :
+        mTracker(strategy) {
+}
+
+EstimatorTouchPredictor::~EstimatorTouchPredictor() {
+}
+
+void EstimatorTouchPredictor::clear() {
+    mTracker.clear();
+}
+
+void EstimatorTouchPredictor::clearPointers(BitSet32 idBits) {
+    mTracker.clearPointers(idBits);
+}
+
+void EstimatorTouchPredictor::addMovement(nsecs_t eventTime, BitSet32 idBits,
+        const VelocityTracker::Position* positions) {
+    mTracker.addMovement(eventTime, idBits, positions);
+}
+
+bool EstimatorTouchPredictor::predict(uint32_t id, nsecs_t when,
+        float* outX, float* outY) const {
+    VelocityTracker::Estimator estimator;
+    if (!mTracker.getEstimator(id, &estimator)
+            || estimator.degree < 1 || estimator.confidence < MIN_CONFIDENCE) {
+        return false;
+    }
+
+    // The coefficients are in seconds relative to the estimator time base.
+    const float t = (when - estimator.time) * 0.000000001f;
+    float x = 0, y = 0, tn = 1;
+    for (uint32_t i = 0; i <= estimator.degree; i++) {
+        x += estimator.xCoeff[i] * tn;
+        y += estimator.yCoeff[i] * tn;
+        tn *= t;
+    }
+    *outX = x;
+    *outY = y;
+    return true;
+}
+
+} // namespace android
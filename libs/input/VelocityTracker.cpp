@@ -388,6 +388,42 @@ void LeastSquaresVelocityTrackerStrategy::addMovement(nsecs_t eventTime, BitSet3
     }
 }
 
+/**
+ * Calculates the coefficient of determination of the polynomial B fitted to the
+ * data points X and Y with weights W, as 1 - (SSerr / SStot) where SSerr is the
+ * residual sum of squares (variance of the error), and SStot is the total sum of
+ * squares (variance of the data) where each has been weighted.
+ */
+static float computeDetermination(const float* x, const float* y,
+        const float* w, uint32_t m, uint32_t n, const float* b) {
+    float ymean = 0;
+    for (uint32_t h = 0; h < m; h++) {
+        ymean += y[h];
+    }
+    ymean /= m;
+
+    float sserr = 0;
+    float sstot = 0;
+    for (uint32_t h = 0; h < m; h++) {
+        float err = y[h] - b[0];
+        float term = 1;
+        for (uint32_t i = 1; i < n; i++) {
+            term *= x[h];
+            err -= term * b[i];
+        }
+        sserr += w[h] * w[h] * err * err;
+        float var = y[h] - ymean;
+        sstot += w[h] * w[h] * var * var;
+    }
+    float det = sstot > 0.000001f ? 1.0f - (sserr / sstot) : 1;
+#if DEBUG_STRATEGY
+    ALOGD("  - sserr=%f", sserr);
+    ALOGD("  - sstot=%f", sstot);
+    ALOGD("  - det=%f", det);
+#endif
+    return det;
+}
+
 /**
  * Solves a linear least squares problem to obtain a N degree polynomial that fits
  * the specified input data as nearly as possible.
@@ -522,35 +558,95 @@ static bool solveLeastSquares(const float* x, const float* y,
     ALOGD("  - b=%s", vectorToString(outB, n).string());
 #endif
 
-    // Calculate the coefficient of determination as 1 - (SSerr / SStot) where
-    // SSerr is the residual sum of squares (variance of the error),
-    // and SStot is the total sum of squares (variance of the data) where each
-    // has been weighted.
-    float ymean = 0;
-    for (uint32_t h = 0; h < m; h++) {
-        ymean += y[h];
-    }
-    ymean /= m;
+    *outDet = computeDetermination(x, y, w, m, n, outB);
+    return true;
+}
 
-    float sserr = 0;
-    float sstot = 0;
+/**
+ * Solves the same problem as solveLeastSquares for two vectors of data points Y0 and Y1
+ * that share X and W, for polynomials of degree 2 or lower (n <= 3).
+ *
+ * Instead of decomposing A, this accumulates the normal equations
+ * (At W^2 A) B = At W^2 Y in double precision and solves them with a Cholesky
+ * decomposition of At W^2 A.  That matrix only depends on X and W so it is only
+ * decomposed once for both vectors, and it is built from sums of powers of X in a
+ * single pass over the data.  Double precision keeps the normal equations as accurate
+ * as the QR decomposition for the small degrees handled here.
+ *
+ * The diagonal of the Cholesky factor is the diagonal of R in the QR decomposition,
+ * so the same test rejects linearly dependent data.
+ */
+static bool solveLeastSquaresDeg2(const float* x, const float* y0, const float* y1,
+        const float* w, uint32_t m, uint32_t n, float* outB0, float* outB1,
+        float* outDet0, float* outDet1) {
+    // Sums of w^2 x^k for k in 0..2n-2, and of w^2 x^k y for k in 0..n-1.
+    double moments[5] = { 0, 0, 0, 0, 0 };
+    double rhs0[3] = { 0, 0, 0 };
+    double rhs1[3] = { 0, 0, 0 };
     for (uint32_t h = 0; h < m; h++) {
-        float err = y[h] - outB[0];
-        float term = 1;
-        for (uint32_t i = 1; i < n; i++) {
+        double term = double(w[h]) * w[h];
+        for (uint32_t k = 0; k < 2 * n - 1; k++) {
+            moments[k] += term;
+            if (k < n) {
+                rhs0[k] += term * y0[h];
+                rhs1[k] += term * y1[h];
+            }
             term *= x[h];
-            err -= term * outB[i];
         }
-        sserr += w[h] * w[h] * err * err;
-        float var = y[h] - ymean;
-        sstot += w[h] * w[h] * var * var;
     }
-    *outDet = sstot > 0.000001f ? 1.0f - (sserr / sstot) : 1;
+
+    // Cholesky decomposition of the matrix of moments into L Lt.
+    double l[3][3];
+    for (uint32_t j = 0; j < n; j++) {
+        double diagonal = moments[2 * j];
+        for (uint32_t k = 0; k < j; k++) {
+            diagonal -= l[j][k] * l[j][k];
+        }
+        double norm = diagonal > 0 ? sqrt(diagonal) : 0;
+        if (norm < 0.000001) {
+            // vectors are linearly dependent or zero so no solution
 #if DEBUG_STRATEGY
-    ALOGD("  - sserr=%f", sserr);
-    ALOGD("  - sstot=%f", sstot);
-    ALOGD("  - det=%f", *outDet);
+            ALOGD("  - no solution, norm=%f", norm);
 #endif
+            return false;
+        }
+        l[j][j] = norm;
+        for (uint32_t i = j + 1; i < n; i++) {
+            double sum = moments[i + j];
+            for (uint32_t k = 0; k < j; k++) {
+                sum -= l[i][k] * l[j][k];
+            }
+            l[i][j] = sum / norm;
+        }
+    }
+
+    // Solve L Z = At W^2 Y, then Lt B = Z.
+    double* rhs[2] = { rhs0, rhs1 };
+    float* outB[2] = { outB0, outB1 };
+    for (uint32_t v = 0; v < 2; v++) {
+        double z[3];
+        for (uint32_t i = 0; i < n; i++) {
+            z[i] = rhs[v][i];
+            for (uint32_t k = 0; k < i; k++) {
+                z[i] -= l[i][k] * z[k];
+            }
+            z[i] /= l[i][i];
+        }
+        for (uint32_t i = n; i-- != 0; ) {
+            for (uint32_t k = i + 1; k < n; k++) {
+                z[i] -= l[k][i] * z[k];
+            }
+            z[i] /= l[i][i];
+            outB[v][i] = float(z[i]);
+        }
+    }
+#if DEBUG_STRATEGY
+    ALOGD("solveLeastSquaresDeg2: m=%d, n=%d, b0=%s, b1=%s", int(m), int(n),
+            vectorToString(outB0, n).string(), vectorToString(outB1, n).string());
+#endif
+
+    *outDet0 = computeDetermination(x, y0, w, m, n, outB0);
+    *outDet1 = computeDetermination(x, y1, w, m, n, outB1);
     return true;
 }
 
@@ -597,8 +693,15 @@ bool LeastSquaresVelocityTrackerStrategy::getEstimator(uint32_t id,
     if (degree >= 1) {
         float xdet, ydet;
         uint32_t n = degree + 1;
-        if (solveLeastSquares(time, x, w, m, n, outEstimator->xCoeff, &xdet)
-                && solveLeastSquares(time, y, w, m, n, outEstimator->yCoeff, &ydet)) {
+        bool solved;
+        if (degree <= 2) {
+            solved = solveLeastSquaresDeg2(time, x, y, w, m, n,
+                    outEstimator->xCoeff, outEstimator->yCoeff, &xdet, &ydet);
+        } else {
+            solved = solveLeastSquares(time, x, w, m, n, outEstimator->xCoeff, &xdet)
+                    && solveLeastSquares(time, y, w, m, n, outEstimator->yCoeff, &ydet);
+        }
+        if (solved) {
             outEstimator->time = newestMovement.eventTime;
             outEstimator->degree = degree;
             outEstimator->confidence = xdet * ydet;
@@ -6,7 +6,10 @@ include $(CLEAR_VARS)
 test_src_files := \
     InputChannel_test.cpp \
     InputEvent_test.cpp \
-    InputPublisherAndConsumer_test.cpp
+    InputPublisherAndConsumer_test.cpp \
+    KeyCharacterMap_test.cpp \
+    TouchPredictor_test.cpp \
+    VelocityTracker_test.cpp
 
 shared_libraries := \
     libinput \
@@ -108,6 +108,82 @@ TEST_F(InputChannelTest, OpenInputChannelPair_ReturnsAPairOfConnectedChannels) {
             << "server channel should receive the correct message from client channel";
 }
 
+TEST_F(InputChannelTest, SendAndReceive_MotionMessage_RoundTripsThroughCompactEncoding) {
+    sp<InputChannel> serverChannel, clientChannel;
+
+    status_t result = InputChannel::openInputChannelPair(String8("channel name"),
+            serverChannel, clientChannel);
+
+    ASSERT_EQ(OK, result)
+            << "should have successfully opened a channel pair";
+
+    InputMessage serverMsg;
+    memset(&serverMsg, 0, sizeof(InputMessage));
+    serverMsg.header.type = InputMessage::TYPE_MOTION;
+    serverMsg.body.motion.seq = 7;
+    serverMsg.body.motion.action = AMOTION_EVENT_ACTION_MOVE;
+    serverMsg.body.motion.downTime = 1000;
+    serverMsg.body.motion.pointerCount = 2;
+    for (uint32_t i = 0; i < 2; i++) {
+        InputMessage::Body::Motion::Pointer& pointer = serverMsg.body.motion.pointers[i];
+        pointer.properties.id = i + 3;
+        pointer.properties.toolType = AMOTION_EVENT_TOOL_TYPE_FINGER;
+        pointer.coords.setAxisValue(AMOTION_EVENT_AXIS_X, 100 + i);
+        pointer.coords.setAxisValue(AMOTION_EVENT_AXIS_Y, 200 + i);
+        pointer.coords.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, 0.5f);
+    }
+
+    InputMessage compactMsg;
+    InputMessage::encodeCompactMotion(serverMsg, &compactMsg);
+    EXPECT_LT(compactMsg.size(), serverMsg.size())
+            << "compact encoding should be smaller than the full message";
+
+    EXPECT_EQ(OK, serverChannel->sendMessage(&serverMsg))
+            << "server channel should be able to send message to client channel";
+
+    InputMessage clientMsg;
+    EXPECT_EQ(OK, clientChannel->receiveMessage(&clientMsg))
+            << "client channel should be able to receive message from server channel";
+    EXPECT_EQ(uint32_t(InputMessage::TYPE_MOTION), clientMsg.header.type)
+            << "client channel should receive the message in its full form";
+    EXPECT_EQ(serverMsg.body.motion.seq, clientMsg.body.motion.seq);
+    EXPECT_EQ(serverMsg.body.motion.action, clientMsg.body.motion.action);
+    EXPECT_EQ(serverMsg.body.motion.downTime, clientMsg.body.motion.downTime);
+    ASSERT_EQ(serverMsg.body.motion.pointerCount, clientMsg.body.motion.pointerCount);
+    for (uint32_t i = 0; i < 2; i++) {
+        EXPECT_EQ(serverMsg.body.motion.pointers[i].properties,
+                clientMsg.body.motion.pointers[i].properties);
+        EXPECT_EQ(serverMsg.body.motion.pointers[i].coords,
+                clientMsg.body.motion.pointers[i].coords);
+    }
+}
+
+TEST_F(InputChannelTest, ReceiveMessage_WhenCompactMotionIsMalformed_ReturnsAnError) {
+    sp<InputChannel> serverChannel, clientChannel;
+
+    status_t result = InputChannel::openInputChannelPair(String8("channel name"),
+            serverChannel, clientChannel);
+
+    ASSERT_EQ(OK, result)
+            << "should have successfully opened a channel pair";
+
+    InputMessage motionMsg;
+    memset(&motionMsg, 0, sizeof(InputMessage));
+    motionMsg.header.type = InputMessage::TYPE_MOTION;
+    motionMsg.body.motion.pointerCount = 1;
+    motionMsg.body.motion.pointers[0].coords.setAxisValue(AMOTION_EVENT_AXIS_X, 1);
+
+    // Truncate the last axis value.
+    InputMessage compactMsg;
+    InputMessage::encodeCompactMotion(motionMsg, &compactMsg);
+    compactMsg.body.compactMotion.dataSize -= sizeof(float);
+    EXPECT_EQ(OK, serverChannel->sendMessage(&compactMsg));
+
+    InputMessage clientMsg;
+    EXPECT_EQ(BAD_VALUE, clientChannel->receiveMessage(&clientMsg))
+            << "receiveMessage should have returned BAD_VALUE";
+}
+
 TEST_F(InputChannelTest, ReceiveSignal_WhenNoSignalPresent_ReturnsAnError) {
     sp<InputChannel> serverChannel, clientChannel;
 
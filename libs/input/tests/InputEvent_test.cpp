@@ -471,6 +471,38 @@ TEST_F(MotionEventTest, CopyFrom_DoNotKeepHistory) {
     ASSERT_EQ(event.getX(0), copy.getX(0));
 }
 
+TEST_F(MotionEventTest, Initialize_KeepsSampleStorage) {
+    MotionEvent event;
+    initializeEventWithHistory(&event);
+    const nsecs_t* sampleEventTimes = event.getSampleEventTimes();
+    const PointerCoords* samplePointerCoords = event.getSamplePointerCoords();
+
+    // Reinitializing the event with as many samples must not reallocate.
+    initializeEventWithHistory(&event);
+
+    ASSERT_EQ(sampleEventTimes, event.getSampleEventTimes());
+    ASSERT_EQ(samplePointerCoords, event.getSamplePointerCoords());
+    ASSERT_NO_FATAL_FAILURE(assertEqualsEventWithHistory(&event));
+}
+
+TEST_F(MotionEventTest, PooledInputEventFactory_ReservesRecycledDepth) {
+    PooledInputEventFactory factory(0);
+    MotionEvent* event = factory.createMotionEvent();
+    initializeEventWithHistory(event);
+    factory.recycle(event);
+
+    // The pool is empty, so this is a new event with room for the samples.
+    event = factory.createMotionEvent();
+    event->initialize(0, 0, AMOTION_EVENT_ACTION_MOVE, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, NULL, NULL);
+    const nsecs_t* sampleEventTimes = event->getSampleEventTimes();
+    initializeEventWithHistory(event);
+
+    ASSERT_EQ(sampleEventTimes, event->getSampleEventTimes());
+    ASSERT_NO_FATAL_FAILURE(assertEqualsEventWithHistory(event));
+    factory.recycle(event);
+}
+
 TEST_F(MotionEventTest, OffsetLocation) {
     MotionEvent event;
     initializeEventWithHistory(&event);
@@ -518,6 +550,37 @@ TEST_F(MotionEventTest, Parcel) {
     ASSERT_NO_FATAL_FAILURE(assertEqualsEventWithHistory(&outEvent));
 }
 
+TEST_F(MotionEventTest, Parcel_RejectsBogusSampleCount) {
+    Parcel parcel;
+    parcel.writeInt32(MAX_POINTERS);
+    parcel.writeInt32(0x7fffffff);
+    for (int i = 0; i < 64; i++) {
+        parcel.writeInt32(0);
+    }
+    parcel.setDataPosition(0);
+
+    MotionEvent event;
+    ASSERT_EQ(BAD_VALUE, event.readFromParcel(&parcel));
+}
+
+TEST_F(MotionEventTest, Parcel_RejectsBogusPointerCount) {
+    Parcel parcel;
+    parcel.writeInt32(MAX_POINTERS + 1);
+    parcel.writeInt32(1);
+    parcel.setDataPosition(0);
+
+    MotionEvent event;
+    ASSERT_EQ(BAD_VALUE, event.readFromParcel(&parcel));
+}
+
+TEST_F(MotionEventTest, RetainingVector_RejectsOverflowingCapacity) {
+    RetainingVector<PointerCoords> coords;
+    ASSERT_EQ(OK, coords.setCapacity(2));
+
+    ASSERT_EQ(NO_MEMORY, coords.setCapacity(size_t(-1) / sizeof(PointerCoords) + 1));
+    ASSERT_EQ(2U, coords.capacity());
+}
+
 static void setRotationMatrix(float matrix[9], float angle) {
     float sin = sinf(angle);
     float cos = cosf(angle);
@@ -285,4 +285,47 @@ TEST_F(InputPublisherAndConsumerTest, PublishMultipleEvents_EndToEnd) {
     ASSERT_NO_FATAL_FAILURE(PublishAndConsumeKeyEvent());
 }
 
+TEST_F(InputPublisherAndConsumerTest, PublishBatch_DeliversEventsInOrder) {
+    status_t status;
+    const size_t count = InputPublisher::MAX_BATCH_SIZE;
+
+    mPublisher->beginBatch();
+    for (size_t i = 0; i < count; i++) {
+        status = mPublisher->publishKeyEvent(i + 1, 1, AINPUT_SOURCE_KEYBOARD,
+                AKEY_EVENT_ACTION_DOWN, 0, AKEYCODE_A, 30, 0, 0, 3, 4 + i);
+        ASSERT_EQ(OK, status)
+                << "publisher publishKeyEvent should queue the event while batching";
+    }
+    status = mPublisher->publishKeyEvent(count + 1, 1, AINPUT_SOURCE_KEYBOARD,
+            AKEY_EVENT_ACTION_DOWN, 0, AKEYCODE_A, 30, 0, 0, 3, 4);
+    ASSERT_EQ(NO_MEMORY, status)
+            << "publisher publishKeyEvent should return NO_MEMORY once the batch is full";
+
+    uint32_t consumeSeq;
+    InputEvent* event;
+    status = mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1, &consumeSeq, &event);
+    ASSERT_EQ(WOULD_BLOCK, status)
+            << "batched events should not be sent before the batch ends";
+
+    size_t published;
+    status = mPublisher->endBatch(&published);
+    ASSERT_EQ(OK, status)
+            << "publisher endBatch should return OK";
+    ASSERT_EQ(count, published);
+
+    for (size_t i = 0; i < count; i++) {
+        status = mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1,
+                &consumeSeq, &event);
+        ASSERT_EQ(OK, status)
+                << "consumer consume should return OK";
+        ASSERT_EQ(AINPUT_EVENT_TYPE_KEY, event->getType());
+        EXPECT_EQ(i + 1, consumeSeq);
+        EXPECT_EQ(nsecs_t(4 + i), static_cast<KeyEvent*>(event)->getEventTime());
+    }
+
+    status = mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1, &consumeSeq, &event);
+    ASSERT_EQ(WOULD_BLOCK, status)
+            << "consumer should have consumed every event of the batch";
+}
+
 } // namespace android
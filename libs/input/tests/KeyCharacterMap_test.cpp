@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <input/Input.h>
+#include <input/KeyCharacterMap.h>
+
+namespace android {
+
+// Behaviors that exercise the meta state tables: shift and caps lock,
+// alt either side, a right alt only behavior (so alt sides are told apart)
+// and ctrl and meta fallbacks.
+static const char* const kContents =
+        "type FULL\n"
+        "\n"
+        "key A {\n"
+        "    label: 'A'\n"
+        "    base: 'a'\n"
+        "    shift, capslock: 'A'\n"
+        "    alt: '\\u00e1'\n"
+        "}\n"
+        "\n"
+        "key B {\n"
+        "    label: 'B'\n"
+        "    base: 'b'\n"
+        "    shift, capslock: 'B'\n"
+        "    ralt: '\\u00df'\n"
+        "}\n"
+        "\n"
+        "key SPACE {\n"
+        "    label: ' '\n"
+        "    base: ' '\n"
+        "    alt, meta: fallback SEARCH\n"
+        "    ctrl: fallback LANGUAGE_SWITCH\n"
+        "}\n";
+
+class KeyCharacterMapTest : public testing::Test {
+protected:
+    sp<KeyCharacterMap> mMap;
+
+    virtual void SetUp() {
+        ASSERT_EQ(OK, KeyCharacterMap::loadContents(String8("test.kcm"), kContents,
+                KeyCharacterMap::FORMAT_BASE, &mMap));
+    }
+};
+
+TEST_F(KeyCharacterMapTest, GetCharacterMatchesMetaState) {
+    EXPECT_EQ('a', mMap->getCharacter(AKEYCODE_A, 0));
+    EXPECT_EQ('A', mMap->getCharacter(AKEYCODE_A, AMETA_SHIFT_ON | AMETA_SHIFT_LEFT_ON));
+    EXPECT_EQ('A', mMap->getCharacter(AKEYCODE_A, AMETA_CAPS_LOCK_ON));
+    EXPECT_EQ('A', mMap->getCharacter(AKEYCODE_A, AMETA_SHIFT_ON | AMETA_NUM_LOCK_ON));
+    EXPECT_EQ(0xe1, mMap->getCharacter(AKEYCODE_A, AMETA_ALT_ON | AMETA_ALT_LEFT_ON));
+    EXPECT_EQ(0xe1, mMap->getCharacter(AKEYCODE_A, AMETA_ALT_ON | AMETA_ALT_RIGHT_ON));
+    // ctrl must match exactly, and no behavior has it
+    EXPECT_EQ(0, mMap->getCharacter(AKEYCODE_A, AMETA_CTRL_ON | AMETA_CTRL_LEFT_ON));
+
+    EXPECT_EQ(0xdf, mMap->getCharacter(AKEYCODE_B, AMETA_ALT_ON | AMETA_ALT_RIGHT_ON));
+    EXPECT_EQ(0, mMap->getCharacter(AKEYCODE_B, AMETA_ALT_ON | AMETA_ALT_LEFT_ON));
+    EXPECT_EQ('B', mMap->getCharacter(AKEYCODE_B, AMETA_CAPS_LOCK_ON));
+
+    EXPECT_EQ(0, mMap->getCharacter(AKEYCODE_C, 0));
+    EXPECT_EQ(0, mMap->getCharacter(-1, 0));
+    EXPECT_EQ(0, mMap->getCharacter(100000, 0));
+}
+
+TEST_F(KeyCharacterMapTest, GetFallbackAction) {
+    KeyCharacterMap::FallbackAction action;
+    ASSERT_TRUE(mMap->getFallbackAction(AKEYCODE_SPACE,
+            AMETA_META_ON | AMETA_META_LEFT_ON, &action));
+    EXPECT_EQ(AKEYCODE_SEARCH, action.keyCode);
+    ASSERT_TRUE(mMap->getFallbackAction(AKEYCODE_SPACE,
+            AMETA_CTRL_ON | AMETA_CTRL_RIGHT_ON, &action));
+    EXPECT_EQ(AKEYCODE_LANGUAGE_SWITCH, action.keyCode);
+    EXPECT_EQ(AMETA_CTRL_RIGHT_ON, action.metaState);
+    EXPECT_FALSE(mMap->getFallbackAction(AKEYCODE_SPACE, 0, &action));
+}
+
+TEST_F(KeyCharacterMapTest, GetEventsUsesMostGeneralBehavior) {
+    const char16_t chars[] = { 'a', 'B', ' ' };
+    Vector<KeyEvent> events;
+    ASSERT_TRUE(mMap->getEvents(1, chars, 3, events));
+    // 'B' is typed with shift, the first behavior generating it
+    ASSERT_EQ(8U, events.size());
+    EXPECT_EQ(AKEYCODE_A, events[0].getKeyCode());
+    EXPECT_EQ(AKEYCODE_SHIFT_LEFT, events[2].getKeyCode());
+    EXPECT_EQ(AKEYCODE_B, events[3].getKeyCode());
+    EXPECT_EQ(AKEYCODE_SPACE, events[6].getKeyCode());
+
+    const char16_t missing[] = { 'z' };
+    EXPECT_FALSE(mMap->getEvents(1, missing, 1, events));
+}
+
+TEST_F(KeyCharacterMapTest, CombinedMapUsesOverlay) {
+    sp<KeyCharacterMap> overlay;
+    ASSERT_EQ(OK, KeyCharacterMap::loadContents(String8("overlay.kcm"),
+            "key A {\n    label: 'Q'\n    base: 'q'\n}\n",
+            KeyCharacterMap::FORMAT_OVERLAY, &overlay));
+    sp<KeyCharacterMap> map = KeyCharacterMap::combine(mMap, overlay);
+    EXPECT_EQ('q', map->getCharacter(AKEYCODE_A, 0));
+    EXPECT_EQ('q', map->getCharacter(AKEYCODE_A, AMETA_SHIFT_ON));
+    EXPECT_EQ('b', map->getCharacter(AKEYCODE_B, 0));
+}
+
+} // namespace android
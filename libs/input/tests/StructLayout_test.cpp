@@ -62,6 +62,10 @@ void TestInputMessageAlignment() {
   CHECK_OFFSET(InputMessage::Body::Motion, yPrecision, 68);
   CHECK_OFFSET(InputMessage::Body::Motion, pointerCount, 72);
   CHECK_OFFSET(InputMessage::Body::Motion, pointers, 80);
+
+  CHECK_OFFSET(InputMessage::Body::CompactMotion, fields, 0);
+  CHECK_OFFSET(InputMessage::Body::CompactMotion, dataSize, 80);
+  CHECK_OFFSET(InputMessage::Body::CompactMotion, data, 88);
 }
 
 } // namespace android
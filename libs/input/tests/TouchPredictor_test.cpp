@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <input/TouchPredictor.h>
+
+namespace android {
+
+// Nanoseconds per milliseconds.
+static const nsecs_t NANOS_PER_MS = 1000000;
+
+class TouchPredictorTest : public testing::Test {
+protected:
+    virtual void SetUp() { }
+    virtual void TearDown() { }
+
+    // moves pointer 0 10 pixels right and 5 down every 4 ms
+    static void addLinearMotion(const sp<TouchPredictor>& predictor, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            VelocityTracker::Position position;
+            position.x = 100 + 10 * i;
+            position.y = 200 + 5 * i;
+            predictor->addMovement(i * 4 * NANOS_PER_MS, BitSet32::valueForBit(0),
+                    &position);
+        }
+    }
+};
+
+TEST_F(TouchPredictorTest, CreateWithoutNameReturnsNull) {
+    EXPECT_TRUE(TouchPredictor::create(NULL) == NULL);
+    EXPECT_TRUE(TouchPredictor::create("") == NULL);
+}
+
+TEST_F(TouchPredictorTest, PredictsLinearMotion) {
+    sp<TouchPredictor> predictor = TouchPredictor::create("lsq2");
+    ASSERT_TRUE(predictor != NULL);
+    addLinearMotion(predictor, 5);
+
+    // 8 ms after the last sample at (140, 220)
+    float x, y;
+    ASSERT_TRUE(predictor->predict(0, 24 * NANOS_PER_MS, &x, &y));
+    EXPECT_NEAR(160, x, 0.5f);
+    EXPECT_NEAR(230, y, 0.5f);
+}
+
+TEST_F(TouchPredictorTest, DoesNotPredictUnknownOrClearedPointers) {
+    sp<TouchPredictor> predictor = TouchPredictor::create("lsq2");
+    ASSERT_TRUE(predictor != NULL);
+    addLinearMotion(predictor, 5);
+
+    float x, y;
+    EXPECT_FALSE(predictor->predict(1, 24 * NANOS_PER_MS, &x, &y));
+    predictor->clearPointers(BitSet32::valueForBit(0));
+    EXPECT_FALSE(predictor->predict(0, 24 * NANOS_PER_MS, &x, &y));
+}
+
+} // namespace android
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <input/VelocityTracker.h>
+#include <utils/BitSet.h>
+
+namespace android {
+
+// Nanoseconds per milliseconds.
+static const nsecs_t NANOS_PER_MS = 1000000;
+
+class VelocityTrackerTest : public testing::Test {
+protected:
+    virtual void SetUp() { }
+    virtual void TearDown() { }
+
+    // Moves pointer 0 along x(t) = 100 + 500 t + 2000 t^2 and y(t) = 50 - 300 t, with t
+    // in seconds, every 8 ms.
+    void addParabola(VelocityTracker& tracker, size_t count) {
+        BitSet32 idBits;
+        idBits.markBit(0);
+        for (size_t i = 0; i < count; i++) {
+            float t = i * 0.008f;
+            VelocityTracker::Position position;
+            position.x = 100 + 500 * t + 2000 * t * t;
+            position.y = 50 - 300 * t;
+            tracker.addMovement(i * 8 * NANOS_PER_MS, idBits, &position);
+        }
+    }
+};
+
+
+TEST_F(VelocityTrackerTest, Lsq2_FitsParabolaExactly) {
+    VelocityTracker tracker("lsq2");
+    addParabola(tracker, 10);
+
+    VelocityTracker::Estimator estimator;
+    ASSERT_TRUE(tracker.getEstimator(0, &estimator));
+    ASSERT_EQ(2U, estimator.degree);
+
+    // The polynomial is relative to the newest sample, at t = 72 ms.
+    float t = 0.072f;
+    EXPECT_NEAR(100 + 500 * t + 2000 * t * t, estimator.xCoeff[0], 0.01f);
+    EXPECT_NEAR(500 + 4000 * t, estimator.xCoeff[1], 0.1f);
+    EXPECT_NEAR(2000, estimator.xCoeff[2], 1);
+    EXPECT_NEAR(50 - 300 * t, estimator.yCoeff[0], 0.01f);
+    EXPECT_NEAR(-300, estimator.yCoeff[1], 0.1f);
+    EXPECT_NEAR(0, estimator.yCoeff[2], 1);
+    EXPECT_NEAR(1, estimator.confidence, 0.001f);
+}
+
+TEST_F(VelocityTrackerTest, Lsq3_MatchesLsq2OnParabola) {
+    VelocityTracker lsq2("lsq2");
+    VelocityTracker lsq3("lsq3");
+    addParabola(lsq2, 10);
+    addParabola(lsq3, 10);
+
+    float vx2, vy2, vx3, vy3;
+    ASSERT_TRUE(lsq2.getVelocity(0, &vx2, &vy2));
+    ASSERT_TRUE(lsq3.getVelocity(0, &vx3, &vy3));
+    EXPECT_NEAR(vx3, vx2, 1);
+    EXPECT_NEAR(vy3, vy2, 1);
+}
+
+TEST_F(VelocityTrackerTest, Lsq2_WithTwoSamples_FallsBackToLine) {
+    VelocityTracker tracker("lsq2");
+    addParabola(tracker, 2);
+
+    VelocityTracker::Estimator estimator;
+    ASSERT_TRUE(tracker.getEstimator(0, &estimator));
+    ASSERT_EQ(1U, estimator.degree);
+
+    // The slope between the two samples.
+    EXPECT_NEAR(500 + 2000 * 0.008f, estimator.xCoeff[1], 0.1f);
+    EXPECT_NEAR(-300, estimator.yCoeff[1], 0.1f);
+}
+
+TEST_F(VelocityTrackerTest, Lsq2_WithSamplesAtTheSameTime_ReturnsPosition) {
+    VelocityTracker tracker("lsq2");
+    BitSet32 idBits;
+    idBits.markBit(0);
+    VelocityTracker::Position position;
+    position.x = 10;
+    position.y = 20;
+    tracker.addMovement(0, idBits, &position);
+    position.x = 12;
+    tracker.addMovement(0, idBits, &position);
+
+    VelocityTracker::Estimator estimator;
+    ASSERT_TRUE(tracker.getEstimator(0, &estimator));
+    EXPECT_EQ(0U, estimator.degree);
+    EXPECT_EQ(12, estimator.xCoeff[0]);
+    EXPECT_EQ(20, estimator.yCoeff[0]);
+}
+
+} // namespace android
@@ -21,22 +21,74 @@
  // This is needed for stdint.h to define INT64_MAX in C++
  #define __STDC_LIMIT_MACROS
 
+#include <cutils/atomic.h>
+#include <poll.h>
 #include <sync/sync.h>
 #include <ui/Fence.h>
 #include <unistd.h>
+#include <utils/KeyedVector.h>
 #include <utils/Log.h>
+#include <utils/threads.h>
 #include <utils/Trace.h>
 
 namespace android {
 
 const sp<Fence> Fence::NO_FENCE = sp<Fence>(new Fence);
 
+struct wait_stats_t {
+    uint32_t waits;     // on fences that hadn't signaled yet
+    nsecs_t total;
+    nsecs_t max;
+};
+
+static volatile bool sWaitStatsEnabled = false;
+static Mutex sWaitStatsLock;
+static KeyedVector<String8, wait_stats_t> sWaitStats;
+
+static void recordWait(const char* name, nsecs_t blocked) {
+    Mutex::Autolock _l(sWaitStatsLock);
+    String8 key(name);
+    ssize_t index = sWaitStats.indexOfKey(key);
+    if (index < 0) {
+        wait_stats_t stats = { 0, 0, 0 };
+        index = sWaitStats.add(key, stats);
+    }
+    wait_stats_t& stats(sWaitStats.editValueAt(index));
+    stats.waits++;
+    stats.total += blocked;
+    if (blocked > stats.max) {
+        stats.max = blocked;
+    }
+}
+
 Fence::Fence() :
-    mFenceFd(-1) {
+    mFenceFd(-1), mState(STATE_PENDING), mSignalTime(INT64_MAX) {
 }
 
 Fence::Fence(int fenceFd) :
-    mFenceFd(fenceFd) {
+    mFenceFd(fenceFd), mState(STATE_PENDING), mSignalTime(INT64_MAX) {
+}
+
+void Fence::setSignaled() const {
+    android_atomic_release_cas(STATE_PENDING, STATE_SIGNALED, &mState);
+}
+
+void Fence::setWaitStatsEnabled(bool enabled) {
+    sWaitStatsEnabled = enabled;
+}
+
+void Fence::dumpWaitStats(String8& result) {
+    if (!sWaitStatsEnabled) {
+        return;
+    }
+    Mutex::Autolock _l(sWaitStatsLock);
+    result.append("Fence waits (count, total ms, max ms):\n");
+    for (size_t i = 0; i < sWaitStats.size(); i++) {
+        const wait_stats_t& stats(sWaitStats.valueAt(i));
+        result.appendFormat("  %-32s %8u %10.2f %8.2f\n",
+                sWaitStats.keyAt(i).string(), stats.waits,
+                stats.total / 1e6, stats.max / 1e6);
+    }
 }
 
 Fence::~Fence() {
@@ -47,18 +99,44 @@ Fence::~Fence() {
 
 status_t Fence::wait(unsigned int timeout) {
     ATRACE_CALL();
-    if (mFenceFd == -1) {
+    if (mFenceFd == -1 || android_atomic_acquire_load(&mState) != STATE_PENDING) {
         return NO_ERROR;
     }
+    nsecs_t start = 0;
+    if (sWaitStatsEnabled) {
+        // only the waits which block are counted
+        if (sync_wait(mFenceFd, 0) == 0) {
+            setSignaled();
+            return NO_ERROR;
+        }
+        start = systemTime();
+    }
     int err = sync_wait(mFenceFd, timeout);
-    return err < 0 ? -errno : status_t(NO_ERROR);
+    if (err < 0) {
+        err = -errno;
+    } else {
+        setSignaled();
+    }
+    if (start) {
+        recordWait("wait", systemTime() - start);
+    }
+    return err;
 }
 
 status_t Fence::waitForever(const char* logname) {
     ATRACE_CALL();
-    if (mFenceFd == -1) {
+    if (mFenceFd == -1 || android_atomic_acquire_load(&mState) != STATE_PENDING) {
         return NO_ERROR;
     }
+    nsecs_t start = 0;
+    if (sWaitStatsEnabled) {
+        // only the waits which block are counted
+        if (sync_wait(mFenceFd, 0) == 0) {
+            setSignaled();
+            return NO_ERROR;
+        }
+        start = systemTime();
+    }
     unsigned int warningTimeout = 3000;
     int err = sync_wait(mFenceFd, warningTimeout);
     if (err < 0 && errno == ETIME) {
@@ -66,7 +144,15 @@ status_t Fence::waitForever(const char* logname) {
                 warningTimeout);
         err = sync_wait(mFenceFd, TIMEOUT_NEVER);
     }
-    return err < 0 ? -errno : status_t(NO_ERROR);
+    if (err < 0) {
+        err = -errno;
+    } else {
+        setSignaled();
+    }
+    if (start) {
+        recordWait(logname, systemTime() - start);
+    }
+    return err;
 }
 
 sp<Fence> Fence::merge(const String8& name, const sp<Fence>& f1,
@@ -104,6 +190,21 @@ nsecs_t Fence::getSignalTime() const {
         return -1;
     }
 
+    const int32_t state = android_atomic_acquire_load(&mState);
+    if (state == STATE_SIGNAL_TIME) {
+        return mSignalTime;
+    }
+    if (state == STATE_PENDING) {
+        // much cheaper than getting the fence info only to find it pending
+        struct pollfd pfd;
+        pfd.fd = mFenceFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, 0) == 0) {
+            return INT64_MAX;
+        }
+    }
+
     struct sync_fence_info_data* finfo = sync_fence_info(mFenceFd);
     if (finfo == NULL) {
         ALOGE("sync_fence_info returned NULL for fd %d", mFenceFd);
@@ -123,7 +224,10 @@ nsecs_t Fence::getSignalTime() const {
     }
     sync_fence_info_free(finfo);
 
-    return nsecs_t(timestamp);
+    // Several threads may get here at once, they all store the same time.
+    mSignalTime = nsecs_t(timestamp);
+    android_atomic_release_store(STATE_SIGNAL_TIME, &mState);
+    return mSignalTime;
 }
 
 size_t Fence::getFlattenedSize() const {
@@ -175,4 +279,119 @@ status_t Fence::unflatten(void const*& buffer, size_t& size, int const*& fds, si
     return NO_ERROR;
 }
 
+// ===========================================================================
+
+FenceSet::FenceSet() {
+}
+
+void FenceSet::add(const sp<Fence>& fence) {
+    if (fence != NULL && fence->isValid()) {
+        mFences.add(fence);
+    }
+}
+
+status_t FenceSet::pollFences(int timeout, bool removeSignaled,
+        size_t* outSignaled) {
+    const size_t count = mFences.size();
+    Vector<struct pollfd> fds;
+    fds.insertAt(0, count);
+    for (size_t i = 0; i < count; i++) {
+        struct pollfd& pfd(fds.editItemAt(i));
+        pfd.fd = mFences[i]->mFenceFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+    }
+
+    int err;
+    do {
+        err = ::poll(fds.editArray(), count, timeout);
+    } while (err < 0 && errno == EINTR);
+    if (err < 0) {
+        err = -errno;
+        ALOGE("pollFences: poll returned an error: %s (%d)", strerror(-err),
+                err);
+        return err;
+    }
+
+    size_t signaled = 0;
+    for (size_t i = count; i > 0; i--) {
+        const short revents = fds[i - 1].revents;
+        if (revents & (POLLERR | POLLNVAL)) {
+            ALOGE("pollFences: fence %d is in an error state",
+                    fds[i - 1].fd);
+            return BAD_VALUE;
+        }
+        if (revents & POLLIN) {
+            signaled++;
+            if (removeSignaled) {
+                mFences.removeAt(i - 1);
+            }
+        }
+    }
+    *outSignaled = signaled;
+    return NO_ERROR;
+}
+
+sp<Fence> FenceSet::merge(const String8& name) {
+    ATRACE_CALL();
+    if (mFences.size() > 1) {
+        // Errors leave the set as it is, the merge below will report them
+        size_t signaled;
+        pollFences(0, true, &signaled);
+    }
+    if (mFences.isEmpty()) {
+        return Fence::NO_FENCE;
+    }
+
+    sp<Fence> result(mFences[0]);
+    for (size_t i = 1; i < mFences.size(); i++) {
+        sp<Fence> merged(Fence::merge(name, result, mFences[i]));
+        if (!merged->isValid()) {
+            ALOGE("merge: failed to merge %zu fences", mFences.size());
+            result = mFences.top();
+            break;
+        }
+        result = merged;
+    }
+    mFences.clear();
+    mFences.add(result);
+    return result;
+}
+
+status_t FenceSet::waitForAll(int timeout) {
+    ATRACE_CALL();
+    const nsecs_t deadline = systemTime() + ms2ns(timeout);
+    while (!mFences.isEmpty()) {
+        int remaining = timeout;
+        if (timeout != Fence::TIMEOUT_NEVER) {
+            remaining = int(ns2ms(deadline - systemTime()));
+            if (remaining < 0) {
+                remaining = 0;
+            }
+        }
+        size_t signaled;
+        status_t err = pollFences(remaining, true, &signaled);
+        if (err != NO_ERROR) {
+            return err;
+        }
+        if (signaled == 0) {
+            return -ETIME;
+        }
+    }
+    return NO_ERROR;
+}
+
+status_t FenceSet::waitForAny(int timeout) {
+    ATRACE_CALL();
+    if (mFences.isEmpty()) {
+        return NO_ERROR;
+    }
+    size_t signaled;
+    status_t err = pollFences(timeout, false, &signaled);
+    if (err != NO_ERROR) {
+        return err;
+    }
+    return signaled > 0 ? status_t(NO_ERROR) : -ETIME;
+}
+
 } // namespace android
@@ -24,6 +24,7 @@
 
 #include <cutils/log.h>
 #include <cutils/atomic.h>
+#include <cutils/properties.h>
 #include <utils/threads.h>
 #include <utils/RefBase.h>
 
@@ -59,6 +60,57 @@ private:
     ~NativeBuffer() { }; // this class cannot be overloaded
 };
 
+/*
+ * Posts the queued buffers in order, each once its fence has signaled, so
+ * that queueBuffer neither waits for the GPU nor for the flip. A buffer
+ * becomes free to dequeue again once the next one has been posted.
+ */
+class FramebufferNativeWindow::PostThread : public Thread {
+public:
+    PostThread(FramebufferNativeWindow* window) :
+        Thread(false), mWindow(window) {
+    }
+
+    void stop() {
+        requestExit();
+        {
+            Mutex::Autolock _l(mWindow->mutex);
+            mWindow->mCondition.broadcast();
+        }
+        join();
+    }
+
+private:
+    virtual bool threadLoop() {
+        FramebufferNativeWindow* self = mWindow;
+        PendingPost post;
+        {
+            Mutex::Autolock _l(self->mutex);
+            while (self->mPendingPosts.isEmpty() && !exitPending()) {
+                self->mCondition.wait(self->mutex);
+            }
+            if (exitPending()) {
+                return false;
+            }
+            post = self->mPendingPosts[0];
+            self->mPendingPosts.removeAt(0);
+        }
+
+        post.fence->wait(Fence::TIMEOUT_NEVER);
+        framebuffer_device_t* fb = self->fbDev;
+        int err = fb->post(fb, post.buffer->handle);
+        ALOGE_IF(err, "framebuffer post failed (%s)", strerror(-err));
+
+        Mutex::Autolock _l(self->mutex);
+        self->front = post.buffer;
+        self->mNumFreeBuffers++;
+        self->mCondition.broadcast();
+        return true;
+    }
+
+    FramebufferNativeWindow* const mWindow;
+};
+
 
 /*
  * This implements the (main) framebuffer management. This class is used
@@ -102,6 +154,14 @@ FramebufferNativeWindow::FramebufferNativeWindow()
         } else {
             mNumBuffers = MIN_NUM_FRAME_BUFFERS;
         }
+
+        // debug.fb.num_buffers may use fewer buffers than the HAL has
+        char value[PROPERTY_VALUE_MAX];
+        property_get("debug.fb.num_buffers", value, "0");
+        const int numBuffers = atoi(value);
+        if (numBuffers >= MIN_NUM_FRAME_BUFFERS && numBuffers < mNumBuffers) {
+            mNumBuffers = numBuffers;
+        }
 #endif
         mNumFreeBuffers = mNumBuffers;
         mBufferHead = mNumBuffers-1;
@@ -142,6 +202,15 @@ FramebufferNativeWindow::FramebufferNativeWindow()
                 }
         }
 
+        // Optionally post from a thread of our own. Not with partial
+        // updates, as the update rectangle applies to the next post.
+        char asyncPost[PROPERTY_VALUE_MAX];
+        property_get("debug.fb.async_post", asyncPost, "0");
+        if (atoi(asyncPost) && !mUpdateOnDemand) {
+            mPostThread = new PostThread(this);
+            mPostThread->run("FramebufferPost", PRIORITY_URGENT_DISPLAY);
+        }
+
         const_cast<uint32_t&>(ANativeWindow::flags) = fbDev->flags; 
         const_cast<float&>(ANativeWindow::xdpi) = fbDev->xdpi;
         const_cast<float&>(ANativeWindow::ydpi) = fbDev->ydpi;
@@ -166,6 +235,10 @@ FramebufferNativeWindow::FramebufferNativeWindow()
 
 FramebufferNativeWindow::~FramebufferNativeWindow() 
 {
+    if (mPostThread != NULL) {
+        mPostThread->stop();
+    }
+
     if (grDev) {
         for(int i = 0; i < mNumBuffers; i++) {
             if (buffers[i] != NULL) {
@@ -288,6 +361,16 @@ int FramebufferNativeWindow::queueBuffer(ANativeWindow* window,
     buffer_handle_t handle = static_cast<NativeBuffer*>(buffer)->handle;
 
     sp<Fence> fence(new Fence(fenceFd));
+
+    if (self->mPostThread != NULL) {
+        PendingPost post;
+        post.buffer = static_cast<NativeBuffer*>(buffer);
+        post.fence = fence;
+        self->mPendingPosts.push(post);
+        self->mCondition.broadcast();
+        return NO_ERROR;
+    }
+
     fence->wait(Fence::TIMEOUT_NEVER);
 
     const int index = self->mCurrentBufferIndex;
@@ -164,6 +164,31 @@ status_t GraphicBuffer::reallocate(uint32_t w, uint32_t h, PixelFormat f,
     return initSize(w, h, f, reqUsage);
 }
 
+status_t GraphicBuffer::reallocatePooled(uint32_t w, uint32_t h, PixelFormat f,
+        uint32_t reqUsage, uint32_t poolOwner)
+{
+    if (mOwner != ownData)
+        return INVALID_OPERATION;
+
+    if (handle && w==width && h==height && f==format && reqUsage==usage)
+        return NO_ERROR;
+
+    GraphicBufferAllocator& allocator(GraphicBufferAllocator::get());
+    if (handle) {
+        allocator.free(handle);
+        handle = 0;
+    }
+    status_t err = allocator.allocPooled(w, h, f, reqUsage, poolOwner,
+            &handle, &stride);
+    if (err == NO_ERROR) {
+        this->width  = w;
+        this->height = h;
+        this->format = f;
+        this->usage  = reqUsage;
+    }
+    return err;
+}
+
 status_t GraphicBuffer::initSize(uint32_t w, uint32_t h, PixelFormat format,
         uint32_t reqUsage)
 {
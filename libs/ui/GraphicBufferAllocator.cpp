@@ -31,9 +31,15 @@ namespace android {
 
 ANDROID_SINGLETON_STATIC_INSTANCE( GraphicBufferAllocator )
 
-Mutex GraphicBufferAllocator::sLock;
-KeyedVector<buffer_handle_t,
-    GraphicBufferAllocator::alloc_rec_t> GraphicBufferAllocator::sAllocList;
+GraphicBufferAllocator::alloc_shard_t
+    GraphicBufferAllocator::sShards[GraphicBufferAllocator::NUM_SHARDS];
+Mutex GraphicBufferAllocator::sPoolLock;
+Vector<GraphicBufferAllocator::pool_entry_t> GraphicBufferAllocator::sPool;
+size_t GraphicBufferAllocator::sPoolBytes = 0;
+size_t GraphicBufferAllocator::sPoolMaxBytes = 0;
+nsecs_t GraphicBufferAllocator::sPoolMaxAge = 0;
+uint32_t GraphicBufferAllocator::sPoolHits = 0;
+uint32_t GraphicBufferAllocator::sPoolMisses = 0;
 
 GraphicBufferAllocator::GraphicBufferAllocator()
     : mAllocDev(0)
@@ -51,32 +57,48 @@ GraphicBufferAllocator::~GraphicBufferAllocator()
     gralloc_close(mAllocDev);
 }
 
+GraphicBufferAllocator::alloc_shard_t& GraphicBufferAllocator::shardFor(
+        buffer_handle_t handle)
+{
+    // the handles are heap pointers, their low bits are always the same
+    return sShards[(uintptr_t(handle) >> 4) % NUM_SHARDS];
+}
+
 void GraphicBufferAllocator::dump(String8& result) const
 {
-    Mutex::Autolock _l(sLock);
-    KeyedVector<buffer_handle_t, alloc_rec_t>& list(sAllocList);
     size_t total = 0;
     const size_t SIZE = 4096;
     char buffer[SIZE];
     snprintf(buffer, SIZE, "Allocated buffers:\n");
     result.append(buffer);
-    const size_t c = list.size();
-    for (size_t i=0 ; i<c ; i++) {
-        const alloc_rec_t& rec(list.valueAt(i));
-        if (rec.size) {
-            snprintf(buffer, SIZE, "%10p: %7.2f KiB | %4u (%4u) x %4u | %8X | 0x%08x\n",
-                    list.keyAt(i), rec.size/1024.0f,
-                    rec.w, rec.s, rec.h, rec.format, rec.usage);
-        } else {
-            snprintf(buffer, SIZE, "%10p: unknown     | %4u (%4u) x %4u | %8X | 0x%08x\n",
-                    list.keyAt(i),
-                    rec.w, rec.s, rec.h, rec.format, rec.usage);
+    for (size_t s=0 ; s<NUM_SHARDS ; s++) {
+        Mutex::Autolock _l(sShards[s].lock);
+        const KeyedVector<buffer_handle_t, alloc_rec_t>& list(sShards[s].list);
+        const size_t c = list.size();
+        for (size_t i=0 ; i<c ; i++) {
+            const alloc_rec_t& rec(list.valueAt(i));
+            if (rec.size) {
+                snprintf(buffer, SIZE, "%10p: %7.2f KiB | %4u (%4u) x %4u | %8X | 0x%08x\n",
+                        list.keyAt(i), rec.size/1024.0f,
+                        rec.w, rec.s, rec.h, rec.format, rec.usage);
+            } else {
+                snprintf(buffer, SIZE, "%10p: unknown     | %4u (%4u) x %4u | %8X | 0x%08x\n",
+                        list.keyAt(i),
+                        rec.w, rec.s, rec.h, rec.format, rec.usage);
+            }
+            result.append(buffer);
+            total += rec.size;
         }
-        result.append(buffer);
-        total += rec.size;
     }
     snprintf(buffer, SIZE, "Total allocated (estimate): %.2f KB\n", total/1024.0f);
     result.append(buffer);
+    Mutex::Autolock _l(sPoolLock);
+    if (sPoolMaxBytes) {
+        snprintf(buffer, SIZE, "Buffer pool: %zu buffers, %.2f KB (max %.2f KB), "
+                "%u hits, %u misses\n", sPool.size(), sPoolBytes/1024.0f,
+                sPoolMaxBytes/1024.0f, sPoolHits, sPoolMisses);
+        result.append(buffer);
+    }
     if (mAllocDev->common.version >= 1 && mAllocDev->dump) {
         mAllocDev->dump(mAllocDev, buffer, SIZE);
         result.append(buffer);
@@ -128,8 +150,8 @@ status_t GraphicBufferAllocator::alloc(uint32_t w, uint32_t h,
 #endif
 
     if (err == NO_ERROR) {
-        Mutex::Autolock _l(sLock);
-        KeyedVector<buffer_handle_t, alloc_rec_t>& list(sAllocList);
+        alloc_shard_t& shard(shardFor(*handle));
+        Mutex::Autolock _l(shard.lock);
         int bpp = bytesPerPixel(format);
         if (bpp < 0) {
             // probably a HAL custom format. in any case, we don't know
@@ -143,24 +165,167 @@ status_t GraphicBufferAllocator::alloc(uint32_t w, uint32_t h,
         rec.format = format;
         rec.usage = usage;
         rec.size = h * stride[0] * bpp;
-        list.add(*handle, rec);
+        rec.pooled = false;
+        rec.owner = 0;
+        shard.list.add(*handle, rec);
+    }
+
+    return err;
+}
+
+bool GraphicBufferAllocator::takeFromPool(uint32_t w, uint32_t h,
+        PixelFormat format, int usage, uint32_t owner,
+        buffer_handle_t* handle, int32_t* stride)
+{
+    Mutex::Autolock _l(sPoolLock);
+    if (!sPoolMaxBytes) {
+        return false;
+    }
+    // the most recently freed buffer first, its pages are the most likely
+    // to still be in the caches
+    for (size_t i = sPool.size(); i-- > 0; ) {
+        const alloc_rec_t& rec(sPool[i].rec);
+        if (rec.w == w && rec.h == h && rec.format == format
+                && rec.usage == uint32_t(usage) && rec.owner == owner) {
+            *handle = sPool[i].handle;
+            *stride = rec.s;
+            sPoolBytes -= rec.size;
+            sPool.removeAt(i);
+            sPoolHits++;
+            return true;
+        }
     }
+    sPoolMisses++;
+    return false;
+}
+
+status_t GraphicBufferAllocator::allocPooled(uint32_t w, uint32_t h,
+        PixelFormat format, int usage, uint32_t owner,
+        buffer_handle_t* handle, int32_t* stride)
+{
+    ATRACE_CALL();
+    if (!w || !h)
+        w = h = 1;
 
+    if (takeFromPool(w, h, format, usage, owner, handle, stride)) {
+        return NO_ERROR;
+    }
+
+    status_t err = alloc(w, h, format, usage, handle, stride);
+    if (err == NO_MEMORY) {
+        // the pooled buffers may be what the allocator is missing
+        flushPool();
+        err = alloc(w, h, format, usage, handle, stride);
+    }
+    if (err == NO_ERROR) {
+        alloc_shard_t& shard(shardFor(*handle));
+        Mutex::Autolock _l(shard.lock);
+        alloc_rec_t& rec(shard.list.editValueFor(*handle));
+        rec.pooled = true;
+        rec.owner = owner;
+    }
     return err;
 }
 
+void GraphicBufferAllocator::trimPoolLocked(nsecs_t now, size_t maxBytes,
+        Vector<buffer_handle_t>* handles)
+{
+    while (!sPool.isEmpty() && (sPoolBytes > maxBytes
+            || now - sPool[0].freedAt > sPoolMaxAge)) {
+        handles->add(sPool[0].handle);
+        sPoolBytes -= sPool[0].rec.size;
+        sPool.removeAt(0);
+    }
+}
+
+void GraphicBufferAllocator::freeHandles(const Vector<buffer_handle_t>& handles)
+{
+    for (size_t i = 0; i < handles.size(); i++) {
+        status_t err = mAllocDev->free(mAllocDev, handles[i]);
+        ALOGW_IF(err, "free(...) failed %d (%s)", err, strerror(-err));
+        if (err == NO_ERROR) {
+            alloc_shard_t& shard(shardFor(handles[i]));
+            Mutex::Autolock _l(shard.lock);
+            shard.list.removeItem(handles[i]);
+        }
+    }
+}
+
+void GraphicBufferAllocator::setPoolLimits(size_t maxBytes, nsecs_t maxAge)
+{
+    Vector<buffer_handle_t> handles;
+    {
+        Mutex::Autolock _l(sPoolLock);
+        sPoolMaxBytes = maxBytes;
+        sPoolMaxAge = maxAge;
+        trimPoolLocked(systemTime(), maxBytes, &handles);
+    }
+    freeHandles(handles);
+}
+
+void GraphicBufferAllocator::trimPool()
+{
+    Vector<buffer_handle_t> handles;
+    {
+        Mutex::Autolock _l(sPoolLock);
+        trimPoolLocked(systemTime(), sPoolMaxBytes, &handles);
+    }
+    freeHandles(handles);
+}
+
+void GraphicBufferAllocator::flushPool()
+{
+    Vector<buffer_handle_t> handles;
+    {
+        Mutex::Autolock _l(sPoolLock);
+        trimPoolLocked(systemTime(), 0, &handles);
+    }
+    freeHandles(handles);
+}
+
 status_t GraphicBufferAllocator::free(buffer_handle_t handle)
 {
     ATRACE_CALL();
     status_t err;
 
+    alloc_shard_t& shard(shardFor(handle));
+    pool_entry_t entry;
+    entry.handle = handle;
+    entry.rec.pooled = false;
+    shard.lock.lock();
+    ssize_t index = shard.list.indexOfKey(handle);
+    if (index >= 0) {
+        entry.rec = shard.list.valueAt(index);
+    }
+    shard.lock.unlock();
+
+    // only buffers whose size is known are pooled, so that the pool can be
+    // kept within its limit
+    if (entry.rec.pooled && entry.rec.size
+            && !(entry.rec.usage & GRALLOC_USAGE_PROTECTED)) {
+        bool pooled = false;
+        Vector<buffer_handle_t> handles;
+        sPoolLock.lock();
+        if (sPoolMaxBytes && entry.rec.size <= sPoolMaxBytes) {
+            entry.freedAt = systemTime();
+            sPool.add(entry);
+            sPoolBytes += entry.rec.size;
+            trimPoolLocked(entry.freedAt, sPoolMaxBytes, &handles);
+            pooled = true;
+        }
+        sPoolLock.unlock();
+        if (pooled) {
+            freeHandles(handles);
+            return NO_ERROR;
+        }
+    }
+
     err = mAllocDev->free(mAllocDev, handle);
 
     ALOGW_IF(err, "free(...) failed %d (%s)", err, strerror(-err));
     if (err == NO_ERROR) {
-        Mutex::Autolock _l(sLock);
-        KeyedVector<buffer_handle_t, alloc_rec_t>& list(sAllocList);
-        list.removeItem(handle);
+        Mutex::Autolock _l(shard.lock);
+        shard.list.removeItem(handle);
     }
 
     return err;
@@ -22,6 +22,14 @@
 #include <inttypes.h>
 #include <limits.h>
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define REGION_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define REGION_USE_SSE2 1
+#endif
+
 #include <utils/Log.h>
 #include <utils/String8.h>
 #include <utils/CallStack.h>
@@ -243,20 +251,23 @@ bool Region::contains(int x, int y) const {
 
 void Region::clear()
 {
-    mStorage.clear();
-    mStorage.add(Rect(0,0));
+    set(Rect(0,0));
 }
 
 void Region::set(const Rect& r)
 {
-    mStorage.clear();
-    mStorage.add(r);
+    if (mStorage.size() == 1) {
+        // reuse the storage rather than freeing and reallocating it
+        mStorage.editItemAt(0) = r;
+    } else {
+        mStorage.clear();
+        mStorage.add(r);
+    }
 }
 
 void Region::set(uint32_t w, uint32_t h)
 {
-    mStorage.clear();
-    mStorage.add(Rect(w,h));
+    set(Rect(w,h));
 }
 
 bool Region::isTriviallyEqual(const Region& region) const {
@@ -287,6 +298,9 @@ Region& Region::subtractSelf(const Rect& r) {
     return operationSelf(r, op_nand);
 }
 Region& Region::operationSelf(const Rect& r, int op) {
+    if (fast_boolean_operation(op, *this, *this, NULL, r, 0, 0)) {
+        return *this;
+    }
     Region lhs(*this);
     boolean_operation(op, *this, lhs, r);
     return *this;
@@ -307,6 +321,9 @@ Region& Region::subtractSelf(const Region& rhs) {
     return operationSelf(rhs, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, int op) {
+    if (fast_boolean_operation(op, *this, *this, &rhs, rhs.getBounds(), 0, 0)) {
+        return *this;
+    }
     Region lhs(*this);
     boolean_operation(op, *this, lhs, rhs);
     return *this;
@@ -378,6 +395,9 @@ Region& Region::subtractSelf(const Region& rhs, int dx, int dy) {
     return operationSelf(rhs, dx, dy, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, int dx, int dy, int op) {
+    if (fast_boolean_operation(op, *this, *this, &rhs, rhs.getBounds(), dx, dy)) {
+        return *this;
+    }
     Region lhs(*this);
     boolean_operation(op, *this, lhs, rhs, dx, dy);
     return *this;
@@ -559,6 +579,123 @@ bool Region::validate(const Region& reg, const char* name, bool silent)
     return result;
 }
 
+static inline bool rectContains(const Rect& outer, const Rect& inner) {
+    return outer.left <= inner.left && outer.top <= inner.top &&
+            outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+// The difference of two intersecting rects is a single rect when b spans a
+// entirely in one direction and covers one of its ends in the other.
+static inline bool subtractRect(const Rect& a, const Rect& b, Rect* result) {
+    if (b.left <= a.left && b.right >= a.right) {
+        if (b.top <= a.top) {
+            *result = Rect(a.left, b.bottom, a.right, a.bottom);
+            return true;
+        }
+        if (b.bottom >= a.bottom) {
+            *result = Rect(a.left, a.top, a.right, b.top);
+            return true;
+        }
+    }
+    if (b.top <= a.top && b.bottom >= a.bottom) {
+        if (b.left <= a.left) {
+            *result = Rect(b.right, a.top, a.right, a.bottom);
+            return true;
+        }
+        if (b.right >= a.right) {
+            *result = Rect(a.left, a.top, b.left, a.bottom);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Region::fast_boolean_operation(int op, Region& dst,
+        const Region& lhs, const Region* rhs, Rect rhsBounds,
+        int dx, int dy)
+{
+    if (VALIDATE_WITH_CORECG || VALIDATE_REGIONS) {
+        // always check the generic path
+        return false;
+    }
+    if (!rhsBounds.isValid()) {
+        // let the generic path report it
+        return false;
+    }
+    rhsBounds.offsetBy(dx, dy);
+
+    const Rect lhsBounds(lhs.getBounds());
+    const bool lhsIsRect = lhs.isRect();
+    const bool rhsIsRect = rhs == NULL || rhs->isRect();
+    Rect common;
+    const bool intersects = lhsBounds.intersect(rhsBounds, &common);
+
+    // these only ever copy one operand, or produce a single rect
+    bool copyLhs = false;
+    bool copyRhs = false;
+    bool singleRect = false;
+    Rect result;
+
+    switch (op) {
+        case op_and:
+            if (!intersects) {
+                singleRect = true;
+                result = Rect(0,0);
+            } else if (lhsIsRect && rhsIsRect) {
+                singleRect = true;
+                result = common;
+            } else if (rhsIsRect && rectContains(rhsBounds, lhsBounds)) {
+                copyLhs = true;
+            } else if (lhsIsRect && rectContains(lhsBounds, rhsBounds)) {
+                copyRhs = true;
+            }
+            break;
+        case op_nand:
+            if (!intersects) {
+                copyLhs = true;
+            } else if (rhsIsRect && rectContains(rhsBounds, lhsBounds)) {
+                singleRect = true;
+                result = Rect(0,0);
+            } else if (lhsIsRect && rhsIsRect) {
+                singleRect = subtractRect(lhsBounds, rhsBounds, &result);
+            }
+            break;
+        case op_or:
+            if (rhsBounds.isEmpty()) {
+                copyLhs = true;
+            } else if (lhsBounds.isEmpty() ||
+                    (rhsIsRect && rectContains(rhsBounds, lhsBounds))) {
+                copyRhs = true;
+            } else if (lhsIsRect && rectContains(lhsBounds, rhsBounds)) {
+                copyLhs = true;
+            }
+            break;
+        case op_xor:
+            if (rhsBounds.isEmpty()) {
+                copyLhs = true;
+            } else if (lhsBounds.isEmpty()) {
+                copyRhs = true;
+            }
+            break;
+    }
+
+    if (singleRect) {
+        dst.set(result.isEmpty() ? Rect(0,0) : result);
+    } else if (copyLhs) {
+        dst = lhs;
+    } else if (copyRhs) {
+        if (rhs == NULL || rhs->isRect()) {
+            dst.set(rhsBounds);
+        } else {
+            dst = *rhs;
+            translate(dst, dx, dy);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
 void Region::boolean_operation(int op, Region& dst,
         const Region& lhs,
         const Region& rhs, int dx, int dy)
@@ -569,6 +706,10 @@ void Region::boolean_operation(int op, Region& dst,
     validate(dst, "boolean_operation (before): dst");
 #endif
 
+    if (fast_boolean_operation(op, dst, lhs, &rhs, rhs.getBounds(), dx, dy)) {
+        return;
+    }
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
@@ -682,6 +823,10 @@ void Region::boolean_operation(int op, Region& dst,
 #if VALIDATE_WITH_CORECG || VALIDATE_REGIONS
     boolean_operation(op, dst, lhs, Region(rhs), dx, dy);
 #else
+    if (fast_boolean_operation(op, dst, lhs, NULL, rhs, dx, dy)) {
+        return;
+    }
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
@@ -708,19 +853,39 @@ void Region::boolean_operation(int op, Region& dst,
     boolean_operation(op, dst, lhs, rhs, 0, 0);
 }
 
+// A Rect is four int32_t (left, top, right, bottom), so a whole rect is
+// offset with a single 128-bit add of (dx, dy, dx, dy).
+static void offsetRects(Rect* rects, size_t count, int dx, int dy)
+{
+#if REGION_USE_NEON
+    const int32_t offset[4] = { dx, dy, dx, dy };
+    const int32x4_t d = vld1q_s32(offset);
+    int32_t* p = reinterpret_cast<int32_t*>(rects);
+    for (size_t i=0 ; i<count ; i++, p+=4) {
+        vst1q_s32(p, vaddq_s32(vld1q_s32(p), d));
+    }
+#elif REGION_USE_SSE2
+    const __m128i d = _mm_setr_epi32(dx, dy, dx, dy);
+    __m128i* p = reinterpret_cast<__m128i*>(rects);
+    for (size_t i=0 ; i<count ; i++, p++) {
+        _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), d));
+    }
+#else
+    while (count) {
+        rects->offsetBy(dx, dy);
+        rects++;
+        count--;
+    }
+#endif
+}
+
 void Region::translate(Region& reg, int dx, int dy)
 {
     if ((dx || dy) && !reg.isEmpty()) {
 #if VALIDATE_REGIONS
         validate(reg, "translate (before)");
 #endif
-        size_t count = reg.mStorage.size();
-        Rect* rects = reg.mStorage.editArray();
-        while (count) {
-            rects->offsetBy(dx, dy);
-            rects++;
-            count--;
-        }
+        offsetRects(reg.mStorage.editArray(), reg.mStorage.size(), dx, dy);
 #if VALIDATE_REGIONS
         validate(reg, "translate (after)");
 #endif
@@ -4,6 +4,7 @@ include $(CLEAR_VARS)
 
 # Build the unit tests.
 test_src_files := \
+    Fence_test.cpp \
     Region_test.cpp \
     vec_test.cpp \
     mat_test.cpp
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FenceTest"
+
+#include <errno.h>
+#include <unistd.h>
+#include <ui/Fence.h>
+#include <gtest/gtest.h>
+
+namespace android {
+
+// FenceSet only polls its fds (until it has to merge), so the read end of a
+// pipe stands in for a fence: it signals once something is written to it.
+class FenceSetTest : public testing::Test {
+protected:
+    sp<Fence> createFence(int* outSignalFd) {
+        int fds[2];
+        EXPECT_EQ(0, pipe(fds));
+        *outSignalFd = fds[1];
+        return new Fence(fds[0]);
+    }
+
+    void signal(int signalFd) {
+        char c = 0;
+        EXPECT_EQ(1, write(signalFd, &c, 1));
+        close(signalFd);
+    }
+};
+
+TEST_F(FenceSetTest, InvalidFencesAreIgnored) {
+    FenceSet fences;
+    fences.add(Fence::NO_FENCE);
+    fences.add(new Fence());
+    EXPECT_TRUE(fences.isEmpty());
+    EXPECT_EQ(Fence::NO_FENCE, fences.merge(String8("test")));
+    EXPECT_EQ(NO_ERROR, fences.waitForAll(0));
+    EXPECT_EQ(NO_ERROR, fences.waitForAny(0));
+}
+
+TEST_F(FenceSetTest, SignaledFencesAreDroppedBeforeMerging) {
+    int signalFd1, signalFd2;
+    sp<Fence> f1(createFence(&signalFd1));
+    sp<Fence> f2(createFence(&signalFd2));
+
+    FenceSet fences;
+    fences.add(f1);
+    fences.add(f2);
+    signal(signalFd1);
+
+    // Only f2 is still pending, so it is returned without a merge
+    EXPECT_EQ(f2, fences.merge(String8("test")));
+    EXPECT_EQ(1U, fences.size());
+    signal(signalFd2);
+}
+
+TEST_F(FenceSetTest, WaitForAnyAndAll) {
+    int signalFd1, signalFd2;
+    FenceSet fences;
+    fences.add(createFence(&signalFd1));
+    fences.add(createFence(&signalFd2));
+
+    EXPECT_EQ(-ETIME, fences.waitForAny(0));
+    EXPECT_EQ(-ETIME, fences.waitForAll(0));
+
+    signal(signalFd2);
+    EXPECT_EQ(NO_ERROR, fences.waitForAny(0));
+    EXPECT_EQ(2U, fences.size());
+    EXPECT_EQ(-ETIME, fences.waitForAll(10));
+    EXPECT_EQ(1U, fences.size());
+
+    signal(signalFd1);
+    EXPECT_EQ(NO_ERROR, fences.waitForAll(Fence::TIMEOUT_NEVER));
+    EXPECT_TRUE(fences.isEmpty());
+}
+
+}; // namespace android
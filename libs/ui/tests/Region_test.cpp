@@ -152,5 +152,108 @@ TEST_F(RegionTest, Random_TJunction) {
     }
 }
 
+static Rect randomRect() {
+    int l = random() % X_MAX;
+    int t = random() % Y_MAX;
+    int r = l + random() % (X_MAX - l + 1);
+    int b = t + random() % (Y_MAX - t + 1);
+    return Rect(l, t, r, b);
+}
+
+static void checkPixels(const Region& result, const Region& lhs,
+        const Region& rhs, char op) {
+    for (int x = 0; x < X_MAX; x++) {
+        for (int y = 0; y < Y_MAX; y++) {
+            bool l = lhs.contains(x, y);
+            bool r = rhs.contains(x, y);
+            bool expected = false;
+            switch (op) {
+                case '&': expected = l && r; break;
+                case '-': expected = l && !r; break;
+                case '|': expected = l || r; break;
+                case '^': expected = l != r; break;
+            }
+            EXPECT_EQ(expected, result.contains(x, y)) << "op " << op <<
+                    " at " << x << "," << y;
+        }
+    }
+}
+
+TEST_F(RegionTest, Random_RectOperations) {
+    srandom(12345);
+
+    for (int iter = 0; iter < ITER_MAX; iter++) {
+        const Rect a(randomRect());
+        const Rect b(randomRect());
+        const Region ra(a);
+        const Region rb(b);
+
+        checkPixels(ra.intersect(b), ra, rb, '&');
+        checkPixels(ra.subtract(b), ra, rb, '-');
+        checkPixels(ra.merge(b), ra, rb, '|');
+        checkPixels(ra.mergeExclusive(b), ra, rb, '^');
+        checkPixels(ra & rb, ra, rb, '&');
+        checkPixels(ra - rb, ra, rb, '-');
+
+        // the intersection of two rects is always a single rect
+        EXPECT_TRUE(ra.intersect(b).isRect());
+
+        Region self(a);
+        self.subtractSelf(b);
+        checkPixels(self, ra, rb, '-');
+    }
+}
+
+TEST_F(RegionTest, Random_RegionRectOperations) {
+    srandom(54321);
+
+    for (int iter = 0; iter < ITER_MAX; iter++) {
+        Region r;
+        for (int i = 0; i < 3; i++) {
+            r.orSelf(randomRect());
+        }
+        const Rect b(randomRect());
+        const Region rb(b);
+
+        checkPixels(r.intersect(b), r, rb, '&');
+        checkPixels(r.subtract(b), r, rb, '-');
+        checkPixels(r.merge(b), r, rb, '|');
+        checkPixels(rb & r, rb, r, '&');
+        checkPixels(rb - r, rb, r, '-');
+        checkPixels(rb | r, rb, r, '|');
+
+        Region self(r);
+        self.andSelf(b);
+        checkPixels(self, r, rb, '&');
+        self = r;
+        self.orSelf(self);
+        checkPixels(self, r, r, '|');
+    }
+}
+
+TEST_F(RegionTest, Random_Translate) {
+    srandom(23456);
+
+    for (int iter = 0; iter < ITER_MAX; iter++) {
+        Region r;
+        for (int i = 0; i < 4; i++) {
+            r.orSelf(randomRect());
+        }
+        const int dx = random() % 5 - 2;
+        const int dy = random() % 5 - 2;
+        const Region moved(r.translate(dx, dy));
+        for (int x = -2; x < X_MAX + 2; x++) {
+            for (int y = -2; y < Y_MAX + 2; y++) {
+                EXPECT_EQ(r.contains(x - dx, y - dy), moved.contains(x, y));
+            }
+        }
+        Rect bounds(r.getBounds());
+        if (!r.isEmpty()) {
+            bounds.offsetBy(dx, dy);
+        }
+        EXPECT_EQ(bounds, moved.getBounds());
+    }
+}
+
 }; // namespace android
 
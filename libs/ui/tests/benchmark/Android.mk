@@ -0,0 +1,14 @@
+# Build the libui micro benchmarks.
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    matBenchmark.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+    libutils
+
+LOCAL_MODULE := matBenchmark
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures the mat4 products RenderEngine computes per layer, comparing the
+ * mat4 operators (vectorized on ARM and x86) with the generic templates.
+ *
+ * usage: matBenchmark [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ui/mat4.h>
+#include <utils/Timers.h>
+
+using namespace android;
+
+// keeps the compiler from optimizing the loops away
+static volatile float sSink;
+
+static double perIteration(nsecs_t start, size_t iterations) {
+    return (systemTime(SYSTEM_TIME_MONOTONIC) - start) / double(iterations);
+}
+
+int main(int argc, char** argv)
+{
+    const size_t iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    mat4 m(vec4(1,0,0,0), vec4(0,1,0,0), vec4(0,0,1,0), vec4(0.5f,0.5f,0,1));
+    const mat4 step(mat4::rotate(0.001f, vec3(0,0,1)) * mat4::scale(vec4(1.0001f)));
+    vec4 v(1, 2, 3, 1);
+
+    printf("%zu iterations\n", iterations);
+    printf("product   \tns (mat4)\tns (generic)\n");
+
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    mat4 a(m);
+    for (size_t i = 0; i < iterations; i++) {
+        a = a * step;
+    }
+    sSink = a[3][0];
+    const double mm = perIteration(start, iterations);
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    a = m;
+    for (size_t i = 0; i < iterations; i++) {
+        a = matrix::multiply<mat4>(a, step);
+    }
+    sSink = a[3][0];
+    printf("mat4*mat4 \t%.1f\t\t%.1f\n", mm, perIteration(start, iterations));
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    vec4 r(v);
+    for (size_t i = 0; i < iterations; i++) {
+        r = step * r;
+    }
+    sSink = r.x;
+    const double mv = perIteration(start, iterations);
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    r = v;
+    for (size_t i = 0; i < iterations; i++) {
+        vec4 t;
+        for (size_t c = 0; c < 4; c++) {
+            t += r[c] * step[c];
+        }
+        r = t;
+    }
+    sSink = r.x;
+    printf("mat4*vec4 \t%.1f\t\t%.1f\n", mv, perIteration(start, iterations));
+    return 0;
+}
@@ -136,4 +136,24 @@ TEST_F(MatTest, MiscOps) {
     EXPECT_EQ(m1, m1*identity);
 }
 
+TEST_F(MatTest, Products) {
+    // compare the (possibly vectorized) mat4 products with the generic ones
+    mat4 m0(vec4(1,2,3,4), vec4(5,6,7,8), vec4(9,10,11,12), vec4(13,14,15,17));
+    mat4 m1(vec4(2,0,1,0), vec4(0,3,0,1), vec4(1,1,1,1), vec4(4,3,2,1));
+    vec4 v(1,-2,3,-4);
+
+    EXPECT_EQ(matrix::multiply<mat4>(m0, m1), m0*m1);
+    EXPECT_EQ(matrix::multiply<mat4>(m1, m0), m1*m0);
+
+    vec4 r;
+    for (size_t i=0 ; i<4 ; i++)
+        r += v[i]*m0[i];
+    EXPECT_EQ(r, m0*v);
+    EXPECT_EQ(vec4(-34,-36,-38,-44), m0*v);
+
+    // the result may be one of the operands
+    v = m1*v;
+    EXPECT_EQ(vec4(-11,-15,-4,-3), v);
+}
+
 }; // namespace android
@@ -67,6 +67,16 @@ etc1_uint32 etc1_get_encoded_data_size(etc1_uint32 width, etc1_uint32 height);
 int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
         etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut);
 
+// Encode an entire image, splitting the rows of blocks across threads.
+// Same arguments and output as etc1_encode_image.
+// threadCount - maximum number of threads to use, including the calling thread.
+//       0 uses one thread per online CPU, 1 encodes on the calling thread only.
+// returns non-zero if there is an error.
+
+int etc1_encode_image_mt(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut,
+        etc1_uint32 threadCount);
+
 // Decode an entire image.
 // pIn - pointer to encoded data.
 // pOut - pointer to the image data. Will be written such that
@@ -79,6 +89,27 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
         etc1_uint32 width, etc1_uint32 height,
         etc1_uint32 pixelSize, etc1_uint32 stride);
 
+// Pixel formats for etc1_decode_image_rows. The value of each format is its
+// size in bytes. 2 is an GL_UNSIGNED_SHORT_5_6_5 image, 3 is a GL_BYTE RGB
+// image and 4 is a GL_BYTE RGBA image with an opaque alpha.
+
+#define ETC1_FORMAT_RGB565 2
+#define ETC1_FORMAT_RGB888 3
+#define ETC1_FORMAT_RGBA8888 4
+
+// Decode lineCount lines of an image, starting at line y, so that a texture
+// can be decoded as its encoded data arrives or one band at a time.
+// pIn - pointer to the encoded data of the row of blocks holding line y.
+// pOut - pointer to the destination of line y. Pixel (x,y+n) is written
+//        at pOut + format * x + stride * n.
+// y must be a multiple of 4. Lines past the height of the image are ignored.
+// returns non-zero if there is an error.
+
+int etc1_decode_image_rows(const etc1_byte* pIn, etc1_byte* pOut,
+        etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 y, etc1_uint32 lineCount,
+        etc1_uint32 format, etc1_uint32 stride);
+
 // Size of a PKM header, in bytes.
 
 #define ETC_PKM_HEADER_SIZE 16
@@ -20,6 +20,7 @@ LOCAL_SRC_FILES:= \
 	matrix.cpp.arm		        \
 	mipmap.cpp.arm		        \
 	primitives.cpp.arm	        \
+	tiler.cpp.arm		        \
 	vertex.cpp.arm
 
 LOCAL_CFLAGS += -DLOG_TAG=\"libagl\"
@@ -43,3 +44,5 @@ LOCAL_MODULE_RELATIVE_PATH := egl
 LOCAL_MODULE:= libGLES_android
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -17,6 +17,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <cutils/log.h>
+#include <cutils/properties.h>
+#include <utils/Timers.h>
+
 #include "context.h"
 #include "fp.h"
 #include "state.h"
@@ -29,15 +33,9 @@
 
 // ----------------------------------------------------------------------------
 
-#define VC_CACHE_STATISTICS     0
-#define VC_CACHE_TYPE_NONE      0
-#define VC_CACHE_TYPE_INDEXED   1
-#define VC_CACHE_TYPE_LRU       2
-#define VC_CACHE_TYPE           VC_CACHE_TYPE_INDEXED
-
-#if VC_CACHE_STATISTICS
-#include <utils/Timers.h>
-#endif
+#define VC_CACHE_TYPE_NONE          0
+#define VC_CACHE_TYPE_ASSOCIATIVE   1
+#define VC_CACHE_TYPE               VC_CACHE_TYPE_ASSOCIATIVE
 
 // ----------------------------------------------------------------------------
 
@@ -45,10 +43,10 @@ namespace android {
 
 static void validate_arrays(ogles_context_t* c, GLenum mode);
 
-static void compileElements__generic(ogles_context_t*,
-        vertex_t*, GLint, GLsizei);
 static void compileElement__generic(ogles_context_t*,
         vertex_t*, GLint);
+static void compileElements__batched(ogles_context_t*,
+        vertex_t*, GLint, GLsizei);
 
 static void drawPrimitivesPoints(ogles_context_t*, GLint, GLsizei);
 static void drawPrimitivesLineStrip(ogles_context_t*, GLint, GLsizei);
@@ -350,8 +348,23 @@ void vertex_cache_t::init()
     // make sure the size of vertex_t allows cache-line alignment
     CTA<(sizeof(vertex_t) & 0x1F) == 0> assertAlignedSize;
 
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.agl.vertex_cache_size", value, "0");
+    uint32_t requested = atoi(value);
+    if (requested == 0)
+        requested = DEFAULT_CACHE_SIZE;
+    cacheSize = VERTEX_CACHE_SIZE;
+    while (cacheSize < requested && cacheSize < MAX_CACHE_SIZE)
+        cacheSize <<= 1;
+    setShift = 32 - (31 - __builtin_clz(cacheSize / CACHE_WAYS));
+
+    property_get("debug.agl.vertex_cache_stats", value, "0");
+    stats = atoi(value) != 0;
+    totalVertices = 0;
+    totalMisses = 0;
+
     const int align = 32;
-    const size_t s = VERTEX_BUFFER_SIZE + VERTEX_CACHE_SIZE;
+    const size_t s = VERTEX_BUFFER_SIZE + cacheSize;
     const size_t size = s*sizeof(vertex_t) + align;
     base = malloc(size);
     if (base) {
@@ -370,26 +383,17 @@ void vertex_cache_t::uninit()
 
 void vertex_cache_t::clear()
 {
-#if VC_CACHE_STATISTICS
-    startTime = systemTime(SYSTEM_TIME_THREAD);
-    total = 0;
-    misses = 0;
-#endif
-
-#if VC_CACHE_TYPE == VC_CACHE_TYPE_LRU
-    vertex_t* v = vBuffer;
-    size_t count = VERTEX_BUFFER_SIZE + VERTEX_CACHE_SIZE;
-    do {
-        v->mru = 0;
-        v++;
-    } while (--count);
-#endif
+    if (ggl_unlikely(stats)) {
+        startTime = systemTime(SYSTEM_TIME_THREAD);
+        total = 0;
+        misses = 0;
+    }
 
     sequence += INDEX_SEQ;
     if (sequence >= 0x80000000LU) {
         sequence = INDEX_SEQ;
         vertex_t* v = vBuffer;
-        size_t count = VERTEX_BUFFER_SIZE + VERTEX_CACHE_SIZE;
+        size_t count = VERTEX_BUFFER_SIZE + cacheSize;
         do {
             v->index = 0;
             v++;
@@ -397,9 +401,10 @@ void vertex_cache_t::clear()
     }
 }
 
-#if VC_CACHE_STATISTICS
 void vertex_cache_t::dump_stats(GLenum mode)
 {
+    if (!stats || !total)
+        return;
     nsecs_t time = systemTime(SYSTEM_TIME_THREAD) - startTime;
     uint32_t hits = total - misses;
     uint32_t prim_count;
@@ -413,17 +418,19 @@ void vertex_cache_t::dump_stats(GLenum mode)
     case GL_TRIANGLES:          prim_count = total / 3;     break;
     default:    return;
     }
-    printf( "total=%5u, hits=%5u, miss=%5u, hitrate=%3u%%,"
-            " prims=%5u, time=%6u us, prims/s=%d, v/t=%f\n",
-            total, hits, misses, (hits*100)/total,
-            prim_count, int(ns2us(time)), int(prim_count*float(seconds(1))/time),
+    if (!prim_count || !time)
+        return;
+    totalVertices += total;
+    totalMisses += misses;
+    ALOGD("vertex cache (%u entries): total=%5u, hits=%5u, miss=%5u, "
+            "hitrate=%3u%% (overall %3u%%), prims=%5u, time=%6u us, "
+            "prims/s=%d, v/t=%f",
+            cacheSize, total, hits, misses, (hits*100)/total,
+            uint32_t(((totalVertices - totalMisses)*100) / totalVertices),
+            prim_count, int(ns2us(time)),
+            int(prim_count*float(seconds(1))/time),
             float(misses) / prim_count);
 }
-#else
-void vertex_cache_t::dump_stats(GLenum /*mode*/)
-{
-}
-#endif
 
 // ----------------------------------------------------------------------------
 #if 0
@@ -454,23 +461,27 @@ void enableDisableClientState(ogles_context_t* c, GLenum array, bool enable)
 #endif
 
 static __attribute__((noinline))
-vertex_t* cache_vertex(ogles_context_t* c, vertex_t* v, uint32_t index)
+vertex_t* cache_vertex(ogles_context_t* c, vertex_t* set, uint32_t index)
 {
-    #if VC_CACHE_STATISTICS
-        c->vc.misses++;
-    #endif
-    if (ggl_unlikely(v->locked)) {
-        // we're just looking for an entry in the cache that is not locked.
-        // and we know that there cannot be more than 2 locked entries
-        // because a triangle needs at most 3 vertices.
-        // We never use the first and second entries because they might be in
-        // use by the striper or faner. Any other entry will do as long as
-        // it's not locked.
-        // We compute directly the index of a "free" entry from the locked
-        // state of v[2] and v[3].
-        v = c->vc.vBuffer + 2;
-        v += v[0].locked | (v[1].locked<<1);
-    }
+    c->vc.misses++;
+
+#if VC_CACHE_TYPE == VC_CACHE_TYPE_ASSOCIATIVE
+    // entries of a set are replaced in FIFO order, the next one to
+    // replace is recorded in the first entry of the set. Locked entries
+    // are skipped, since a triangle needs at most 3 vertices there can't
+    // be more than 2 of them.
+    int way = set[0].mru;
+    while (ggl_unlikely(set[way].locked))
+        way = (way + 1) & (vertex_cache_t::CACHE_WAYS - 1);
+    set[0].mru = (way + 1) & (vertex_cache_t::CACHE_WAYS - 1);
+    vertex_t* const v = set + way;
+#else
+    // just for debugging, we never use the first and second entries of
+    // vBuffer because they might be in use by the striper or faner.
+    vertex_t* v = c->vc.vBuffer + 2;
+    v += v[0].locked | (v[1].locked<<1);
+#endif
+
     // note: compileElement clears v->flags
     c->arrays.compileElement(c, v, index);
     v->locked = 1;
@@ -482,44 +493,23 @@ vertex_t* fetch_vertex(ogles_context_t* c, size_t index)
 {
     index |= c->vc.sequence;
 
-#if VC_CACHE_TYPE == VC_CACHE_TYPE_INDEXED
+#if VC_CACHE_TYPE == VC_CACHE_TYPE_ASSOCIATIVE
 
-    vertex_t* const v = c->vc.vCache +
-            (index & (vertex_cache_t::VERTEX_CACHE_SIZE-1));
+    vertex_t* const set = c->vc.set(index);
 
-    if (ggl_likely(v->index == index)) {
-        v->locked = 1;
-        return v;
-    }
-    return cache_vertex(c, v, index);
-
-#elif VC_CACHE_TYPE == VC_CACHE_TYPE_LRU
-
-    vertex_t* v = c->vc.vCache +
-            (index & ((vertex_cache_t::VERTEX_CACHE_SIZE-1)>>1))*2;
-
-    // always record LRU in v[0]
-    if (ggl_likely(v[0].index == index)) {
-        v[0].locked = 1;
-        v[0].mru = 0;
-        return &v[0];
-    }
-
-    if (ggl_likely(v[1].index == index)) {
-        v[1].locked = 1;
-        v[0].mru = 1;
-        return &v[1];
-    }
-
-    const int lru = 1 - v[0].mru;
-    v[0].mru = lru;
-    return cache_vertex(c, &v[lru], index);
+    vertex_t* v = set;
+    vertex_t* const end = set + vertex_cache_t::CACHE_WAYS;
+    do {
+        if (v->index == index) {
+            v->locked = 1;
+            return v;
+        }
+    } while (++v != end);
+    return cache_vertex(c, set, index);
 
 #elif VC_CACHE_TYPE == VC_CACHE_TYPE_NONE
 
-    // just for debugging...
-    vertex_t* v = c->vc.vBuffer + 2;
-    return cache_vertex(c, v, index);
+    return cache_vertex(c, 0, index);
 
 #endif
 }
@@ -962,24 +952,54 @@ void compileElement__generic(ogles_context_t* c,
     c->arrays.perspective(c, v);
 }
 
-void compileElements__generic(ogles_context_t* c,
+// Vertices are transformed and projected a batch at a time, which avoids
+// several indirect calls per vertex and lets the transform use SIMD.
+void compileElements__batched(ogles_context_t* c,
         vertex_t* v, GLint first, GLsizei count)
 {
     const GLubyte* vp = c->arrays.vertex.element(
             first & vertex_cache_t::INDEX_MASK);
     const size_t stride = c->arrays.vertex.stride;
+    const int size = c->arrays.vertex.size;
+    const bool isFloat = (c->arrays.vertex.type == GL_FLOAT) &&
+            (c->arrays.vertex.fetch != fetchNop);
     transform_t const* const mvp = &c->transforms.mvp;
+    vec4_batch_t obj;
+    vec4_batch_t clip;
     do {
-        v->flags = 0;
-        v->index = first++;
-        v->obj.z = 0;
-        v->obj.w = 0x10000;
-        c->arrays.vertex.fetch(c, v->obj.v, vp);
-        c->arrays.mvp_transform(mvp, &v->clip, &v->obj);
-        c->arrays.perspective(c, v);
-        vp += stride;
-        v++;
-    } while (--count);
+        const GLsizei num = count > vec4_batch_t::SIZE ?
+                vec4_batch_t::SIZE : count;
+        for (GLsizei i=0 ; i<num ; i++) {
+            vertex_t* const e = v + i;
+            e->flags = 0;
+            e->index = first++;
+            e->obj.z = 0;
+            e->obj.w = 0x10000;
+            if (isFloat) {
+                const GLfloat* p = (const GLfloat*)vp;
+                for (int j=0 ; j<size ; j++)
+                    e->obj.v[j] = gglFloatToFixed(p[j]);
+            } else {
+                c->arrays.vertex.fetch(c, e->obj.v, vp);
+            }
+            obj.x[i] = e->obj.x;
+            obj.y[i] = e->obj.y;
+            obj.z[i] = e->obj.z;
+            obj.w[i] = e->obj.w;
+            vp += stride;
+        }
+        mvp->batchv[size - 2](mvp, &clip, &obj, num);
+        for (GLsizei i=0 ; i<num ; i++) {
+            vertex_t* const e = v + i;
+            e->clip.x = clip.x[i];
+            e->clip.y = clip.y[i];
+            e->clip.z = clip.z[i];
+            e->clip.w = clip.w[i];
+        }
+        ogles_vertices_perspective(c, v, num);
+        v += num;
+        count -= num;
+    } while (count);
 }
 
 /*
@@ -1135,7 +1155,7 @@ void validate_arrays(ogles_context_t* c, GLenum mode)
 
     // vertex compilers
     c->arrays.compileElement = compileElement__generic;
-    c->arrays.compileElements = compileElements__generic;
+    c->arrays.compileElements = compileElements__batched;
 
     // vertex transform
     c->arrays.mvp_transform =
@@ -1379,11 +1399,6 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count)
 
     if (enables & GGL_ENABLE_TMUS)
         ogles_unlock_textures(c);
-
-#if VC_CACHE_STATISTICS
-    c->vc.total = count;
-    c->vc.dump_stats(mode);
-#endif
 }
 
 void glDrawElements(
@@ -1440,11 +1455,11 @@ void glDrawElements(
     if (enables & GGL_ENABLE_TMUS)
         ogles_unlock_textures(c);
 
-    
-#if VC_CACHE_STATISTICS
-    c->vc.total = count;
-    c->vc.dump_stats(mode);
-#endif
+
+    if (ggl_unlikely(c->vc.stats)) {
+        c->vc.total = count;
+        c->vc.dump_stats(mode);
+    }
 }
 
 // ----------------------------------------------------------------------------
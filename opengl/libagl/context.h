@@ -50,6 +50,7 @@ struct ogles_context_t;
 struct matrixx_t;
 struct transform_t;
 struct buffer_t;
+struct tiler_t;
 
 ogles_context_t* getGlContext();
 
@@ -100,6 +101,18 @@ struct vec4_t {
     };
 };
 
+// a batch of vec4_t stored one component after the other, so that
+// they can be transformed several at a time.
+struct vec4_batch_t {
+    enum {
+        SIZE = 16
+    };
+    GLfixed x[SIZE];
+    GLfixed y[SIZE];
+    GLfixed z[SIZE];
+    GLfixed w[SIZE];
+};
+
 struct vertex_t {
     enum {
         // these constant matter for our clipping
@@ -229,20 +242,41 @@ struct vertex_cache_t {
         // 3 vertice for triangles
         // or 2 + 2 for indexed triangles w/ cache contention
         VERTEX_BUFFER_SIZE  = 8,
-        // must be a power of two and at least 3
+        // must be a power of two and at least 3, this is also the
+        // number of vertices non-indexed primitives transform at once
         VERTEX_CACHE_SIZE   = 64,   // 8 KB
 
+        // the cache is made of sets of CACHE_WAYS entries, replaced in
+        // FIFO order. Its size is set by debug.agl.vertex_cache_size,
+        // and is a power of two in [VERTEX_CACHE_SIZE, MAX_CACHE_SIZE]
+        CACHE_WAYS          = 4,
+        DEFAULT_CACHE_SIZE  = 256,  // 32 KB
+        MAX_CACHE_SIZE      = 4096,
+
         INDEX_BITS      = 16,
         INDEX_MASK      = ((1LU<<INDEX_BITS)-1),
         INDEX_SEQ       = 1LU<<INDEX_BITS,
     };
     vertex_t*       vBuffer;
     vertex_t*       vCache;
+    uint32_t        cacheSize;
+    uint32_t        setShift;   // 32 - log2(number of sets)
     uint32_t        sequence;
     void*           base;
     uint32_t        total;
     uint32_t        misses;
+    uint64_t        totalVertices;
+    uint64_t        totalMisses;
     int64_t         startTime;
+    bool            stats;      // debug.agl.vertex_cache_stats
+
+    // spreads both sequential indices and indices a power-of-two apart,
+    // such as the rows of a grid mesh, over the sets.
+    inline vertex_t* set(uint32_t index) const {
+        const uint32_t h = ((index & INDEX_MASK) * 0x9E3779B1U) >> setShift;
+        return vCache + h * CACHE_WAYS;
+    }
+
     void init();
     void uninit();
     void clear();
@@ -431,6 +465,20 @@ struct transform_t {
         void (*pointv[3])(transform_t const* t, vec4_t*, vec4_t const*);
     };
 
+    // same as above, for 'count' vectors of a batch
+    union {
+        struct {
+            void (*batch2)(transform_t const* t, vec4_batch_t*,
+                    vec4_batch_t const*, int count);
+            void (*batch3)(transform_t const* t, vec4_batch_t*,
+                    vec4_batch_t const*, int count);
+            void (*batch4)(transform_t const* t, vec4_batch_t*,
+                    vec4_batch_t const*, int count);
+        };
+        void (*batchv[3])(transform_t const* t, vec4_batch_t*,
+                vec4_batch_t const*, int count);
+    };
+
     void loadIdentity();
     void picker();
     void dump(const char* what);
@@ -628,6 +676,7 @@ struct ogles_context_t {
     uint32_t                transformTextures : 1;
     EGLSurfaceManager*      surfaceManager;
     EGLBufferObjectManager* bufferObjectManager;
+    tiler_t*                tiler;
 
     GLenum                  error;
 
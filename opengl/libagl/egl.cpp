@@ -45,6 +45,7 @@
 #include "state.h"
 #include "texture.h"
 #include "matrix.h"
+#include "tiler.h"
 
 #undef NELEM
 #define NELEM(x) (sizeof(x)/sizeof(*(x)))
@@ -1734,6 +1735,9 @@ EGLBoolean eglMakeCurrent(  EGLDisplay dpy, EGLSurface draw,
             egl_surface_t* d = (egl_surface_t*)draw;
             egl_surface_t* r = (egl_surface_t*)read;
             
+            // rasterize what was drawn into the previous surfaces
+            ogles_flush_tiler(gl);
+
             if (c->draw) {
                 egl_surface_t* s = reinterpret_cast<egl_surface_t*>(c->draw);
                 s->disconnect();
@@ -1869,6 +1873,10 @@ EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface draw)
     if (d->dpy != dpy)
         return setError(EGL_BAD_DISPLAY, EGL_FALSE);
 
+    // finish rendering before posting the surface
+    if (d->ctx != EGL_NO_CONTEXT)
+        ogles_flush_tiler((ogles_context_t*)d->ctx);
+
     // post the surface
     d->swapBuffers();
 
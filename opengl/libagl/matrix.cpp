@@ -29,6 +29,11 @@
 #warning "matrix.cpp should not be compiled in thumb on ARM."
 #endif
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MATRIX_USE_NEON 1
+#endif
+
 #define I(_i, _j) ((_j)+ 4*(_i))
 
 namespace android {
@@ -58,6 +63,14 @@ static void point4__generic(transform_t const*, vec4_t* c, vec4_t const* o);
 static void point3__mvui(transform_t const*, vec4_t* c, vec4_t const* o);
 static void point4__mvui(transform_t const*, vec4_t* c, vec4_t const* o);
 
+static void batch2__nop(transform_t const*, vec4_batch_t* c, vec4_batch_t const* o, int n);
+static void batch3__nop(transform_t const*, vec4_batch_t* c, vec4_batch_t const* o, int n);
+static void batch4__nop(transform_t const*, vec4_batch_t* c, vec4_batch_t const* o, int n);
+
+static void batch2__generic(transform_t const*, vec4_batch_t* c, vec4_batch_t const* o, int n);
+static void batch3__generic(transform_t const*, vec4_batch_t* c, vec4_batch_t const* o, int n);
+static void batch4__generic(transform_t const*, vec4_batch_t* c, vec4_batch_t const* o, int n);
+
 // ----------------------------------------------------------------------------
 #if 0
 #pragma mark -
@@ -176,6 +189,9 @@ void transform_t::loadIdentity() {
     point2 = point2__nop;
     point3 = point3__nop;
     point4 = point4__nop;
+    batch2 = batch2__nop;
+    batch3 = batch3__nop;
+    batch4 = batch4__nop;
 }
 
 
@@ -199,6 +215,9 @@ void transform_t::picker()
     point2 = point2__generic;
     point3 = point3__generic;
     point4 = point4__generic;
+    batch2 = batch2__generic;
+    batch3 = batch3__generic;
+    batch4 = batch4__generic;
     
     // find out if this is a 2D projection
     if (!(notZero(m[3]) | notZero(m[7]) | notZero(m[11]) | notOne(m[15]))) {
@@ -806,6 +825,155 @@ void point4__nop(transform_t const*, vec4_t* lhs, vec4_t const* rhs) {
         *lhs = *rhs;
 }
 
+// ----------------------------------------------------------------------------
+#if 0
+#pragma mark -
+#pragma mark matrix * batch of vertices
+#endif
+
+// These give the same results as their point*__generic counterparts.
+// With NEON, two vertices are transformed at a time using 64-bits
+// accumulators, the narrowing shifts truncate (mla2a, mla3a) or round
+// (mla4) exactly like the scalar code.
+
+#if MATRIX_USE_NEON
+
+static inline
+int32x2_t mla2a_neon(int32x2_t a0, GLfixed b0, int32x2_t a1, GLfixed b1,
+        GLfixed c)
+{
+    int64x2_t r = vmull_n_s32(a0, b0);
+    r = vmlal_n_s32(r, a1, b1);
+    return vadd_s32(vshrn_n_s64(r, 16), vdup_n_s32(c));
+}
+
+static inline
+int32x2_t mla3a_neon(int32x2_t a0, GLfixed b0, int32x2_t a1, GLfixed b1,
+        int32x2_t a2, GLfixed b2, GLfixed c)
+{
+    int64x2_t r = vmull_n_s32(a0, b0);
+    r = vmlal_n_s32(r, a1, b1);
+    r = vmlal_n_s32(r, a2, b2);
+    return vadd_s32(vshrn_n_s64(r, 16), vdup_n_s32(c));
+}
+
+static inline
+int32x2_t mla4_neon(int32x2_t a0, GLfixed b0, int32x2_t a1, GLfixed b1,
+        int32x2_t a2, GLfixed b2, int32x2_t a3, GLfixed b3)
+{
+    int64x2_t r = vmull_n_s32(a0, b0);
+    r = vmlal_n_s32(r, a1, b1);
+    r = vmlal_n_s32(r, a2, b2);
+    r = vmlal_n_s32(r, a3, b3);
+    return vrshrn_n_s64(r, 16);
+}
+
+#endif
+
+void batch2__generic(transform_t const* mx,
+        vec4_batch_t* lhs, vec4_batch_t const* rhs, int count) {
+    const GLfixed* const m = mx->matrix.m;
+    int i = 0;
+#if MATRIX_USE_NEON
+    for ( ; i+2 <= count ; i += 2) {
+        const int32x2_t rx = vld1_s32(rhs->x + i);
+        const int32x2_t ry = vld1_s32(rhs->y + i);
+        vst1_s32(lhs->x + i, mla2a_neon(rx, m[ 0], ry, m[ 4], m[12]));
+        vst1_s32(lhs->y + i, mla2a_neon(rx, m[ 1], ry, m[ 5], m[13]));
+        vst1_s32(lhs->z + i, mla2a_neon(rx, m[ 2], ry, m[ 6], m[14]));
+        vst1_s32(lhs->w + i, mla2a_neon(rx, m[ 3], ry, m[ 7], m[15]));
+    }
+#endif
+    for ( ; i<count ; i++) {
+        const GLfixed rx = rhs->x[i];
+        const GLfixed ry = rhs->y[i];
+        lhs->x[i] = mla2a(rx, m[ 0], ry, m[ 4], m[12]);
+        lhs->y[i] = mla2a(rx, m[ 1], ry, m[ 5], m[13]);
+        lhs->z[i] = mla2a(rx, m[ 2], ry, m[ 6], m[14]);
+        lhs->w[i] = mla2a(rx, m[ 3], ry, m[ 7], m[15]);
+    }
+}
+
+void batch3__generic(transform_t const* mx,
+        vec4_batch_t* lhs, vec4_batch_t const* rhs, int count) {
+    const GLfixed* const m = mx->matrix.m;
+    int i = 0;
+#if MATRIX_USE_NEON
+    for ( ; i+2 <= count ; i += 2) {
+        const int32x2_t rx = vld1_s32(rhs->x + i);
+        const int32x2_t ry = vld1_s32(rhs->y + i);
+        const int32x2_t rz = vld1_s32(rhs->z + i);
+        vst1_s32(lhs->x + i, mla3a_neon(rx, m[ 0], ry, m[ 4], rz, m[ 8], m[12]));
+        vst1_s32(lhs->y + i, mla3a_neon(rx, m[ 1], ry, m[ 5], rz, m[ 9], m[13]));
+        vst1_s32(lhs->z + i, mla3a_neon(rx, m[ 2], ry, m[ 6], rz, m[10], m[14]));
+        vst1_s32(lhs->w + i, mla3a_neon(rx, m[ 3], ry, m[ 7], rz, m[11], m[15]));
+    }
+#endif
+    for ( ; i<count ; i++) {
+        const GLfixed rx = rhs->x[i];
+        const GLfixed ry = rhs->y[i];
+        const GLfixed rz = rhs->z[i];
+        lhs->x[i] = mla3a(rx, m[ 0], ry, m[ 4], rz, m[ 8], m[12]);
+        lhs->y[i] = mla3a(rx, m[ 1], ry, m[ 5], rz, m[ 9], m[13]);
+        lhs->z[i] = mla3a(rx, m[ 2], ry, m[ 6], rz, m[10], m[14]);
+        lhs->w[i] = mla3a(rx, m[ 3], ry, m[ 7], rz, m[11], m[15]);
+    }
+}
+
+void batch4__generic(transform_t const* mx,
+        vec4_batch_t* lhs, vec4_batch_t const* rhs, int count) {
+    const GLfixed* const m = mx->matrix.m;
+    int i = 0;
+#if MATRIX_USE_NEON
+    for ( ; i+2 <= count ; i += 2) {
+        const int32x2_t rx = vld1_s32(rhs->x + i);
+        const int32x2_t ry = vld1_s32(rhs->y + i);
+        const int32x2_t rz = vld1_s32(rhs->z + i);
+        const int32x2_t rw = vld1_s32(rhs->w + i);
+        vst1_s32(lhs->x + i, mla4_neon(rx, m[ 0], ry, m[ 4], rz, m[ 8], rw, m[12]));
+        vst1_s32(lhs->y + i, mla4_neon(rx, m[ 1], ry, m[ 5], rz, m[ 9], rw, m[13]));
+        vst1_s32(lhs->z + i, mla4_neon(rx, m[ 2], ry, m[ 6], rz, m[10], rw, m[14]));
+        vst1_s32(lhs->w + i, mla4_neon(rx, m[ 3], ry, m[ 7], rz, m[11], rw, m[15]));
+    }
+#endif
+    for ( ; i<count ; i++) {
+        const GLfixed rx = rhs->x[i];
+        const GLfixed ry = rhs->y[i];
+        const GLfixed rz = rhs->z[i];
+        const GLfixed rw = rhs->w[i];
+        lhs->x[i] = mla4(rx, m[ 0], ry, m[ 4], rz, m[ 8], rw, m[12]);
+        lhs->y[i] = mla4(rx, m[ 1], ry, m[ 5], rz, m[ 9], rw, m[13]);
+        lhs->z[i] = mla4(rx, m[ 2], ry, m[ 6], rz, m[10], rw, m[14]);
+        lhs->w[i] = mla4(rx, m[ 3], ry, m[ 7], rz, m[11], rw, m[15]);
+    }
+}
+
+void batch2__nop(transform_t const*,
+        vec4_batch_t* lhs, vec4_batch_t const* rhs, int count) {
+    for (int i=0 ; i<count ; i++) {
+        lhs->x[i] = rhs->x[i];
+        lhs->y[i] = rhs->y[i];
+        lhs->z[i] = 0;
+        lhs->w[i] = 0x10000;
+    }
+}
+
+void batch3__nop(transform_t const*,
+        vec4_batch_t* lhs, vec4_batch_t const* rhs, int count) {
+    for (int i=0 ; i<count ; i++) {
+        lhs->x[i] = rhs->x[i];
+        lhs->y[i] = rhs->y[i];
+        lhs->z[i] = rhs->z[i];
+        lhs->w[i] = 0x10000;
+    }
+}
+
+void batch4__nop(transform_t const*,
+        vec4_batch_t* lhs, vec4_batch_t const* rhs, int /*count*/) {
+    if (lhs != rhs)
+        memcpy(lhs, rhs, sizeof(vec4_batch_t));
+}
+
 
 static void frustumf(
             GLfloat left, GLfloat right, 
@@ -17,16 +17,298 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "context.h"
 #include "state.h"
 #include "texture.h"
 #include "TextureObjectManager.h"
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MIPMAP_USE_NEON 1
+#endif
+
 namespace android {
 
 // ----------------------------------------------------------------------------
 
+// Each kernel box-filters rows [y, y+count) of a w pixels wide level from
+// the level above it. The destination stride is w.
+typedef void (*downsample_t)(const GGLSurface* base, GGLSurface* cur,
+        int w, int y, int count);
+
+static void downsample_565(const GGLSurface* base, GGLSurface* cur,
+        int w, int y, int count)
+{
+    const int bs = base->stride;
+    const int stride = w;
+    uint16_t const * src = (uint16_t const *)base->data;
+    uint16_t* dst = (uint16_t*)cur->data;
+    const uint32_t mask = 0x07E0F81F;
+    for (const int end = y + count ; y<end ; y++) {
+        size_t offset = (y*2) * bs;
+        int x = 0;
+#if MIPMAP_USE_NEON
+        const uint16x8_t m5 = vdupq_n_u16(0x1F);
+        const uint16x8_t m6 = vdupq_n_u16(0x3F);
+        for ( ; x+8 <= w ; x+=8) {
+            uint16x8x2_t t = vld2q_u16(src + offset);
+            uint16x8x2_t b = vld2q_u16(src + offset + bs);
+            uint16x8_t r = vaddq_u16(
+                    vaddq_u16(vshrq_n_u16(t.val[0], 11), vshrq_n_u16(t.val[1], 11)),
+                    vaddq_u16(vshrq_n_u16(b.val[0], 11), vshrq_n_u16(b.val[1], 11)));
+            uint16x8_t g = vaddq_u16(
+                    vaddq_u16(vandq_u16(vshrq_n_u16(t.val[0], 5), m6),
+                              vandq_u16(vshrq_n_u16(t.val[1], 5), m6)),
+                    vaddq_u16(vandq_u16(vshrq_n_u16(b.val[0], 5), m6),
+                              vandq_u16(vshrq_n_u16(b.val[1], 5), m6)));
+            uint16x8_t bl = vaddq_u16(
+                    vaddq_u16(vandq_u16(t.val[0], m5), vandq_u16(t.val[1], m5)),
+                    vaddq_u16(vandq_u16(b.val[0], m5), vandq_u16(b.val[1], m5)));
+            uint16x8_t rgb = vorrq_u16(
+                    vshlq_n_u16(vshrq_n_u16(r, 2), 11),
+                    vorrq_u16(vshlq_n_u16(vshrq_n_u16(g, 2), 5),
+                              vshrq_n_u16(bl, 2)));
+            vst1q_u16(dst + x + y*stride, rgb);
+            offset += 16;
+        }
+#endif
+        for ( ; x<w ; x++) {
+            uint32_t p00 = src[offset];
+            uint32_t p10 = src[offset+1];
+            uint32_t p01 = src[offset+bs];
+            uint32_t p11 = src[offset+bs+1];
+            p00 = (p00 | (p00 << 16)) & mask;
+            p01 = (p01 | (p01 << 16)) & mask;
+            p10 = (p10 | (p10 << 16)) & mask;
+            p11 = (p11 | (p11 << 16)) & mask;
+            uint32_t grb = ((p00 + p10 + p01 + p11) >> 2) & mask;
+            uint32_t rgb = (grb & 0xFFFF) | (grb >> 16);
+            dst[x + y*stride] = rgb;
+            offset += 2;
+        }
+    }
+}
+
+static void downsample_5551(const GGLSurface* base, GGLSurface* cur,
+        int w, int y, int count)
+{
+    const int bs = base->stride;
+    const int stride = w;
+    uint16_t const * src = (uint16_t const *)base->data;
+    uint16_t* dst = (uint16_t*)cur->data;
+    for (const int end = y + count ; y<end ; y++) {
+        size_t offset = (y*2) * bs;
+        for (int x=0 ; x<w ; x++) {
+            uint32_t p00 = src[offset];
+            uint32_t p10 = src[offset+1];
+            uint32_t p01 = src[offset+bs];
+            uint32_t p11 = src[offset+bs+1];
+            uint32_t r = ((p00>>11)+(p10>>11)+(p01>>11)+(p11>>11)+2)>>2;
+            uint32_t g = (((p00>>6)+(p10>>6)+(p01>>6)+(p11>>6)+2)>>2)&0x3F;
+            uint32_t b = ((p00&0x3E)+(p10&0x3E)+(p01&0x3E)+(p11&0x3E)+4)>>3;
+            uint32_t a = ((p00&1)+(p10&1)+(p01&1)+(p11&1)+2)>>2;
+            dst[x + y*stride] = (r<<11)|(g<<6)|(b<<1)|a;
+            offset += 2;
+        }
+    }
+}
+
+static void downsample_8888(const GGLSurface* base, GGLSurface* cur,
+        int w, int y, int count)
+{
+    const int bs = base->stride;
+    const int stride = w;
+    uint32_t const * src = (uint32_t const *)base->data;
+    uint32_t* dst = (uint32_t*)cur->data;
+    for (const int end = y + count ; y<end ; y++) {
+        size_t offset = (y*2) * bs;
+        int x = 0;
+#if MIPMAP_USE_NEON
+        for ( ; x+8 <= w ; x+=8) {
+            // each channel of 16 pixels, summed by pairs of columns
+            uint8x16x4_t t = vld4q_u8((uint8_t const *)(src + offset));
+            uint8x16x4_t b = vld4q_u8((uint8_t const *)(src + offset + bs));
+            uint8x8x4_t rgba;
+            for (int i=0 ; i<4 ; i++) {
+                uint16x8_t sum = vpadalq_u8(vpaddlq_u8(t.val[i]), b.val[i]);
+                rgba.val[i] = vshrn_n_u16(sum, 2);
+            }
+            vst4_u8((uint8_t*)(dst + x + y*stride), rgba);
+            offset += 16;
+        }
+#endif
+        for ( ; x<w ; x++) {
+            uint32_t p00 = src[offset];
+            uint32_t p10 = src[offset+1];
+            uint32_t p01 = src[offset+bs];
+            uint32_t p11 = src[offset+bs+1];
+            uint32_t rb00 = p00 & 0x00FF00FF;
+            uint32_t rb01 = p01 & 0x00FF00FF;
+            uint32_t rb10 = p10 & 0x00FF00FF;
+            uint32_t rb11 = p11 & 0x00FF00FF;
+            uint32_t ga00 = (p00 >> 8) & 0x00FF00FF;
+            uint32_t ga01 = (p01 >> 8) & 0x00FF00FF;
+            uint32_t ga10 = (p10 >> 8) & 0x00FF00FF;
+            uint32_t ga11 = (p11 >> 8) & 0x00FF00FF;
+            uint32_t rb = (rb00 + rb01 + rb10 + rb11)>>2;
+            uint32_t ga = (ga00 + ga01 + ga10 + ga11)>>2;
+            uint32_t rgba = (rb & 0x00FF00FF) | ((ga & 0x00FF00FF)<<8);
+            dst[x + y*stride] = rgba;
+            offset += 2;
+        }
+    }
+}
+
+static void downsample_bytes(const GGLSurface* base, GGLSurface* cur,
+        int w, int y, int count)
+{
+    int skip;
+    switch (base->format) {
+    case GGL_PIXEL_FORMAT_RGB_888:  skip = 3;   break;
+    case GGL_PIXEL_FORMAT_LA_88:    skip = 2;   break;
+    default:                        skip = 1;   break;
+    }
+    const int bs = base->stride * skip;
+    const int stride = w * skip;
+    uint8_t const * src = (uint8_t const *)base->data;
+    uint8_t* dst = (uint8_t*)cur->data;
+    for (const int end = y + count ; y<end ; y++) {
+        size_t offset = (y*2) * bs;
+        for (int x=0 ; x<w ; x++) {
+            for (int c=0 ; c<skip ; c++) {
+                uint32_t p00 = src[c+offset];
+                uint32_t p10 = src[c+offset+skip];
+                uint32_t p01 = src[c+offset+bs];
+                uint32_t p11 = src[c+offset+bs+skip];
+                dst[x*skip + y*stride + c] = (p00 + p10 + p01 + p11) >> 2;
+            }
+            offset += 2*skip;
+        }
+    }
+}
+
+static void downsample_4444(const GGLSurface* base, GGLSurface* cur,
+        int w, int y, int count)
+{
+    const int bs = base->stride;
+    const int stride = w;
+    uint16_t const * src = (uint16_t const *)base->data;
+    uint16_t* dst = (uint16_t*)cur->data;
+    for (const int end = y + count ; y<end ; y++) {
+        size_t offset = (y*2) * bs;
+        int x = 0;
+#if MIPMAP_USE_NEON
+        // the even and odd nibbles are summed in separate bytes
+        const uint16x8_t m = vdupq_n_u16(0x0F0F);
+        for ( ; x+8 <= w ; x+=8) {
+            uint16x8x2_t t = vld2q_u16(src + offset);
+            uint16x8x2_t b = vld2q_u16(src + offset + bs);
+            uint16x8_t lo = vaddq_u16(
+                    vaddq_u16(vandq_u16(t.val[0], m), vandq_u16(t.val[1], m)),
+                    vaddq_u16(vandq_u16(b.val[0], m), vandq_u16(b.val[1], m)));
+            uint16x8_t hi = vaddq_u16(
+                    vaddq_u16(vandq_u16(vshrq_n_u16(t.val[0], 4), m),
+                              vandq_u16(vshrq_n_u16(t.val[1], 4), m)),
+                    vaddq_u16(vandq_u16(vshrq_n_u16(b.val[0], 4), m),
+                              vandq_u16(vshrq_n_u16(b.val[1], 4), m)));
+            uint16x8_t rgba = vorrq_u16(
+                    vandq_u16(vshrq_n_u16(lo, 2), m),
+                    vshlq_n_u16(vandq_u16(vshrq_n_u16(hi, 2), m), 4));
+            vst1q_u16(dst + x + y*stride, rgba);
+            offset += 16;
+        }
+#endif
+        for ( ; x<w ; x++) {
+            uint32_t p00 = src[offset];
+            uint32_t p10 = src[offset+1];
+            uint32_t p01 = src[offset+bs];
+            uint32_t p11 = src[offset+bs+1];
+            p00 = ((p00 << 12) & 0x0F0F0000) | (p00 & 0x0F0F);
+            p10 = ((p10 << 12) & 0x0F0F0000) | (p10 & 0x0F0F);
+            p01 = ((p01 << 12) & 0x0F0F0000) | (p01 & 0x0F0F);
+            p11 = ((p11 << 12) & 0x0F0F0000) | (p11 & 0x0F0F);
+            uint32_t rbga = (p00 + p10 + p01 + p11) >> 2;
+            uint32_t rgba = (rbga & 0x0F0F) | ((rbga>>12) & 0xF0F0);
+            dst[x + y*stride] = rgba;
+            offset += 2;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+enum {
+    // levels smaller than this are filtered by the calling thread only
+    MIN_PARALLEL_PIXELS     = 128*128,
+    MAX_MIPMAP_THREADS      = 4
+};
+
+struct downsample_job_t {
+    downsample_t        downsample;
+    const GGLSurface*   base;
+    GGLSurface*         cur;
+    int                 w;
+    int                 y;
+    int                 count;
+};
+
+static void* downsampleThread(void* arg)
+{
+    downsample_job_t* job = static_cast<downsample_job_t*>(arg);
+    job->downsample(job->base, job->cur, job->w, job->y, job->count);
+    return 0;
+}
+
+static int mipmapThreadCount()
+{
+    static int sCount = 0;
+    if (!sCount) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        sCount = (n < 1) ? 1 : int(min(n, long(MAX_MIPMAP_THREADS)));
+    }
+    return sCount;
+}
+
+// large levels are split in bands of rows filtered concurrently, each
+// level still needs the previous one to be complete.
+static void downsample(downsample_t kernel,
+        const GGLSurface* base, GGLSurface* cur, int w, int h)
+{
+    int n = (w*h >= MIN_PARALLEL_PIXELS) ? mipmapThreadCount() : 1;
+    if (n > h)
+        n = h;
+
+    downsample_job_t jobs[MAX_MIPMAP_THREADS];
+    pthread_t threads[MAX_MIPMAP_THREADS];
+    int started = 0;
+    for (int i=1 ; i<n ; i++) {
+        downsample_job_t& job(jobs[i]);
+        job.downsample = kernel;
+        job.base = base;
+        job.cur = cur;
+        job.w = w;
+        job.y = (h * i) / n;
+        job.count = (h * (i+1)) / n - job.y;
+        if (pthread_create(&threads[i], 0, downsampleThread, &job) != 0)
+            break;
+        started = i;
+    }
+
+    // the calling thread takes the first band, and whatever couldn't be
+    // handed to another thread.
+    kernel(base, cur, w, 0, h / n);
+    if (started+1 < n) {
+        const int y = (h * (started+1)) / n;
+        kernel(base, cur, w, y, h - y);
+    }
+    for (int i=1 ; i<=started ; i++) {
+        pthread_join(threads[i], 0);
+    }
+}
+
 status_t buildAPyramid(ogles_context_t* c, EGLTextureObject* tex)
 {
     int level = 0;
@@ -38,6 +320,21 @@ status_t buildAPyramid(ogles_context_t* c, EGLTextureObject* tex)
     if ((w&h) == 1)
         return NO_ERROR;
 
+    downsample_t kernel;
+    switch (base->format) {
+    case GGL_PIXEL_FORMAT_RGB_565:      kernel = downsample_565;    break;
+    case GGL_PIXEL_FORMAT_RGBA_5551:    kernel = downsample_5551;   break;
+    case GGL_PIXEL_FORMAT_RGBA_8888:    kernel = downsample_8888;   break;
+    case GGL_PIXEL_FORMAT_RGBA_4444:    kernel = downsample_4444;   break;
+    case GGL_PIXEL_FORMAT_RGB_888:
+    case GGL_PIXEL_FORMAT_LA_88:
+    case GGL_PIXEL_FORMAT_A_8:
+    case GGL_PIXEL_FORMAT_L_8:          kernel = downsample_bytes;  break;
+    default:
+        ALOGE("Unsupported format (%d)", base->format);
+        return BAD_TYPE;
+    }
+
     w = (w>>1) ? : 1;
     h = (h>>1) ? : 1;
 
@@ -48,135 +345,9 @@ status_t buildAPyramid(ogles_context_t* c, EGLTextureObject* tex)
                 base->format, base->compressedFormat, bpr) != NO_ERROR) {
             return NO_MEMORY;
         }
-    
-        int stride = w;
-        int bs = base->stride;
-        GGLSurface& cur = tex->editMip(level);
 
-        if (base->format == GGL_PIXEL_FORMAT_RGB_565)
-        {
-            uint16_t const * src = (uint16_t const *)base->data;
-            uint16_t* dst = (uint16_t*)cur.data;
-            const uint32_t mask = 0x07E0F81F;
-            for (int y=0 ; y<h ; y++) {
-                size_t offset = (y*2) * bs;
-                for (int x=0 ; x<w ; x++) {
-                    uint32_t p00 = src[offset];
-                    uint32_t p10 = src[offset+1];
-                    uint32_t p01 = src[offset+bs];
-                    uint32_t p11 = src[offset+bs+1];
-                    p00 = (p00 | (p00 << 16)) & mask;
-                    p01 = (p01 | (p01 << 16)) & mask;
-                    p10 = (p10 | (p10 << 16)) & mask;
-                    p11 = (p11 | (p11 << 16)) & mask;
-                    uint32_t grb = ((p00 + p10 + p01 + p11) >> 2) & mask;
-                    uint32_t rgb = (grb & 0xFFFF) | (grb >> 16);
-                    dst[x + y*stride] = rgb;
-                    offset += 2;
-                }
-            }
-        }
-        else if (base->format == GGL_PIXEL_FORMAT_RGBA_5551)
-        {
-            uint16_t const * src = (uint16_t const *)base->data;
-            uint16_t* dst = (uint16_t*)cur.data;
-            for (int y=0 ; y<h ; y++) {
-                size_t offset = (y*2) * bs;
-                for (int x=0 ; x<w ; x++) {
-                    uint32_t p00 = src[offset];
-                    uint32_t p10 = src[offset+1];
-                    uint32_t p01 = src[offset+bs];
-                    uint32_t p11 = src[offset+bs+1];
-                    uint32_t r = ((p00>>11)+(p10>>11)+(p01>>11)+(p11>>11)+2)>>2;
-                    uint32_t g = (((p00>>6)+(p10>>6)+(p01>>6)+(p11>>6)+2)>>2)&0x3F;
-                    uint32_t b = ((p00&0x3E)+(p10&0x3E)+(p01&0x3E)+(p11&0x3E)+4)>>3;
-                    uint32_t a = ((p00&1)+(p10&1)+(p01&1)+(p11&1)+2)>>2;
-                    dst[x + y*stride] = (r<<11)|(g<<6)|(b<<1)|a;
-                    offset += 2;
-                }
-            }
-        }
-        else if (base->format == GGL_PIXEL_FORMAT_RGBA_8888)
-        {
-            uint32_t const * src = (uint32_t const *)base->data;
-            uint32_t* dst = (uint32_t*)cur.data;
-            for (int y=0 ; y<h ; y++) {
-                size_t offset = (y*2) * bs;
-                for (int x=0 ; x<w ; x++) {
-                    uint32_t p00 = src[offset];
-                    uint32_t p10 = src[offset+1];
-                    uint32_t p01 = src[offset+bs];
-                    uint32_t p11 = src[offset+bs+1];
-                    uint32_t rb00 = p00 & 0x00FF00FF;
-                    uint32_t rb01 = p01 & 0x00FF00FF;
-                    uint32_t rb10 = p10 & 0x00FF00FF;
-                    uint32_t rb11 = p11 & 0x00FF00FF;
-                    uint32_t ga00 = (p00 >> 8) & 0x00FF00FF;
-                    uint32_t ga01 = (p01 >> 8) & 0x00FF00FF;
-                    uint32_t ga10 = (p10 >> 8) & 0x00FF00FF;
-                    uint32_t ga11 = (p11 >> 8) & 0x00FF00FF;
-                    uint32_t rb = (rb00 + rb01 + rb10 + rb11)>>2;
-                    uint32_t ga = (ga00 + ga01 + ga10 + ga11)>>2;
-                    uint32_t rgba = (rb & 0x00FF00FF) | ((ga & 0x00FF00FF)<<8);
-                    dst[x + y*stride] = rgba;
-                    offset += 2;
-                }
-            }
-        }
-        else if ((base->format == GGL_PIXEL_FORMAT_RGB_888) ||
-                 (base->format == GGL_PIXEL_FORMAT_LA_88) ||
-                 (base->format == GGL_PIXEL_FORMAT_A_8) ||
-                 (base->format == GGL_PIXEL_FORMAT_L_8))
-        {
-            int skip;
-            switch (base->format) {
-            case GGL_PIXEL_FORMAT_RGB_888:  skip = 3;   break;
-            case GGL_PIXEL_FORMAT_LA_88:    skip = 2;   break;
-            default:                        skip = 1;   break;
-            }
-            uint8_t const * src = (uint8_t const *)base->data;
-            uint8_t* dst = (uint8_t*)cur.data;            
-            bs *= skip;
-            stride *= skip;
-            for (int y=0 ; y<h ; y++) {
-                size_t offset = (y*2) * bs;
-                for (int x=0 ; x<w ; x++) {
-                    for (int c=0 ; c<skip ; c++) {
-                        uint32_t p00 = src[c+offset];
-                        uint32_t p10 = src[c+offset+skip];
-                        uint32_t p01 = src[c+offset+bs];
-                        uint32_t p11 = src[c+offset+bs+skip];
-                        dst[x + y*stride + c] = (p00 + p10 + p01 + p11) >> 2;
-                    }
-                    offset += 2*skip;
-                }
-            }
-        }
-        else if (base->format == GGL_PIXEL_FORMAT_RGBA_4444)
-        {
-            uint16_t const * src = (uint16_t const *)base->data;
-            uint16_t* dst = (uint16_t*)cur.data;
-            for (int y=0 ; y<h ; y++) {
-                size_t offset = (y*2) * bs;
-                for (int x=0 ; x<w ; x++) {
-                    uint32_t p00 = src[offset];
-                    uint32_t p10 = src[offset+1];
-                    uint32_t p01 = src[offset+bs];
-                    uint32_t p11 = src[offset+bs+1];
-                    p00 = ((p00 << 12) & 0x0F0F0000) | (p00 & 0x0F0F);
-                    p10 = ((p10 << 12) & 0x0F0F0000) | (p10 & 0x0F0F);
-                    p01 = ((p01 << 12) & 0x0F0F0000) | (p01 & 0x0F0F);
-                    p11 = ((p11 << 12) & 0x0F0F0000) | (p11 & 0x0F0F);
-                    uint32_t rbga = (p00 + p10 + p01 + p11) >> 2;
-                    uint32_t rgba = (rbga & 0x0F0F) | ((rbga>>12) & 0xF0F0);
-                    dst[x + y*stride] = rgba;
-                    offset += 2;
-                }
-            }
-        } else {
-            ALOGE("Unsupported format (%d)", base->format);
-            return BAD_TYPE;
-        }
+        GGLSurface& cur = tex->editMip(level);
+        downsample(kernel, base, &cur, w, h);
 
         // exit condition: we just processed the 1x1 LODs
         if ((w&h) == 1)
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tiler_bands.h"
+
+namespace android {
+
+TEST(TilerTest, BandsCoverTheColorBuffer) {
+    const int32_t height = 1080;
+    const int numBands = 4;
+    int32_t top, bottom, lastBottom = 0;
+    for (int i = 0; i < numBands; i++) {
+        ogles_tiler_band_rows(height, numBands, i, &top, &bottom);
+        EXPECT_EQ(lastBottom, top);
+        EXPECT_LT(top, bottom);
+        lastBottom = bottom;
+    }
+    EXPECT_GE(lastBottom, height);
+}
+
+TEST(TilerTest, FirstBandScissorDoesNotOverflow) {
+    int32_t top, bottom;
+    ogles_tiler_band_rows(1080, 2, 0, &top, &bottom);
+    int32_t s[4];
+    ogles_tiler_band_scissor(top, bottom, NULL, s);
+    EXPECT_EQ(0, s[1]);
+    EXPECT_EQ(bottom, s[3]);
+}
+
+TEST(TilerTest, SingleBandScissorIsTheWholeBuffer) {
+    int32_t top, bottom;
+    ogles_tiler_band_rows(1080, 1, 0, &top, &bottom);
+    int32_t s[4];
+    ogles_tiler_band_scissor(top, bottom, NULL, s);
+    EXPECT_EQ(0, s[0]);
+    EXPECT_EQ(0, s[1]);
+    EXPECT_EQ(0x7FFF, s[2]);
+    EXPECT_GT(s[3], 0);
+}
+
+TEST(TilerTest, BandScissorIsClippedToTheContextScissor) {
+    const int32_t scissor[4] = { 10, 100, 50, 400 };
+    int32_t s[4];
+    ogles_tiler_band_scissor(0, 270, scissor, s);
+    EXPECT_EQ(10, s[0]);
+    EXPECT_EQ(100, s[1]);
+    EXPECT_EQ(50, s[2]);
+    EXPECT_EQ(170, s[3]);
+
+    // a band the context's scissor doesn't reach is empty
+    ogles_tiler_band_scissor(810, INT_MAX, scissor, s);
+    EXPECT_EQ(0, s[3]);
+}
+
+TEST(TilerTest, HugeContextScissorDoesNotOverflow) {
+    const int32_t scissor[4] = { INT_MAX - 1, INT_MAX - 1, INT_MAX, INT_MAX };
+    int32_t s[4];
+    ogles_tiler_band_scissor(0, INT_MAX, scissor, s);
+    EXPECT_GE(s[2], 0);
+    EXPECT_EQ(1, s[3]);
+}
+
+}; // namespace android
@@ -21,6 +21,7 @@
 #include "fp.h"
 #include "state.h"
 #include "texture.h"
+#include "tiler.h"
 #include "TextureObjectManager.h"
 
 #include <ETC1/etc1.h>
@@ -163,6 +164,8 @@ void ogles_unlock_textures(ogles_context_t* c)
                 gralloc_module_t const* module =
                     reinterpret_cast<gralloc_module_t const*>(pModule);
 
+                // the buffer can't be used once unlocked
+                ogles_flush_tiler(c);
                 module->unlock(module, native_buffer->handle);
                 u.texture->setImageBits(NULL);
                 c->rasterizer.procs.bindTexture(c, &(u.texture->surface));
@@ -288,6 +291,25 @@ int copyPixels(
         return 0;
     }
 
+    if ((dst.format == src.format) &&
+        (dst.compressedFormat == 0) &&
+        (src.compressedFormat == 0) &&
+        (dst.stride > 0) && (src.stride > 0))
+    {
+        // no conversion needed, but the strides or the rectangles differ,
+        // for instance because of GL_UNPACK_ALIGNMENT. copy row by row.
+        const size_t bpp = c->rasterizer.formats[src.format].size;
+        const size_t bpr = w * bpp;
+        const GGLubyte* s = src.data + (y * src.stride + x) * bpp;
+        GGLubyte* d = dst.data + (yoffset * dst.stride + xoffset) * bpp;
+        for (GLsizei i=0 ; i<h ; i++) {
+            memcpy(d, s, bpr);
+            s += src.stride * bpp;
+            d += dst.stride * bpp;
+        }
+        return 0;
+    }
+
     // use pixel-flinger to handle all the conversions
     GGLContext* ggl = getRasterizer(c);
     if (!ggl) {
@@ -902,6 +924,7 @@ void glGenTextures(GLsizei n, GLuint *textures)
 void glDeleteTextures(GLsizei n, const GLuint *textures)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if (n<0) {
         ogles_error(c, GL_INVALID_VALUE);
         return;
@@ -1059,6 +1082,7 @@ void glCompressedTexImage2D(
         GLsizei imageSize, const GLvoid *data)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if (target != GL_TEXTURE_2D) {
         ogles_error(c, GL_INVALID_ENUM);
         return;
@@ -1169,6 +1193,7 @@ void glTexImage2D(
         GLenum format, GLenum type, const GLvoid *pixels)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if (target != GL_TEXTURE_2D) {
         ogles_error(c, GL_INVALID_ENUM);
         return;
@@ -1232,12 +1257,75 @@ void glCompressedTexSubImage2D(
     ogles_error(c, GL_INVALID_ENUM);
 }
 
+// Textures bound to an EGLImage are written in place, the pixels must
+// already be in the format of the underlying gralloc buffer.
+static void texSubImageNativeBuffer(ogles_context_t* c,
+        EGLTextureObject* tex, GLint level,
+        GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, const GLvoid *pixels)
+{
+    ANativeWindowBuffer* native_buffer = tex->buffer;
+    const int32_t formatIdx = convertGLPixelFormat(format, type);
+    if (level != 0 || formatIdx == 0 || formatIdx != native_buffer->format) {
+        ogles_error(c, GL_INVALID_OPERATION);
+        return;
+    }
+    if (xoffset < 0 || yoffset < 0 || width < 0 || height < 0 ||
+        (xoffset > native_buffer->width - width) ||
+        (yoffset > native_buffer->height - height)) {
+        ogles_error(c, GL_INVALID_VALUE);
+        return;
+    }
+    if (!width || !height) {
+        return; // okay, but no-op.
+    }
+
+    hw_module_t const* pModule;
+    if (hw_get_module(GRALLOC_HARDWARE_MODULE_ID, &pModule)) {
+        ogles_error(c, GL_INVALID_OPERATION);
+        return;
+    }
+    gralloc_module_t const* module =
+        reinterpret_cast<gralloc_module_t const*>(pModule);
+
+    void* vaddr;
+    if (module->lock(module, native_buffer->handle,
+            GRALLOC_USAGE_SW_WRITE_OFTEN,
+            xoffset, yoffset, width, height, &vaddr) != 0) {
+        ogles_error(c, GL_OUT_OF_MEMORY);
+        return;
+    }
+
+    const GGLFormat& pixelFormat(c->rasterizer.formats[formatIdx]);
+    const int32_t align = c->textures.unpackAlignment-1;
+    const int32_t bpr = ((width * pixelFormat.size) + align) & ~align;
+    GGLSurface userSurface;
+    userSurface.version = sizeof(userSurface);
+    userSurface.width  = width;
+    userSurface.height = height;
+    userSurface.stride = bpr / pixelFormat.size;
+    userSurface.format = formatIdx;
+    userSurface.compressedFormat = 0;
+    userSurface.data = (GLubyte*)pixels;
+
+    GGLSurface bufferSurface(tex->surface);
+    bufferSurface.data = (GGLubyte*)vaddr;
+    int err = copyPixels(c,
+            bufferSurface, xoffset, yoffset,
+            userSurface, 0, 0, width, height);
+    module->unlock(module, native_buffer->handle);
+    if (err) {
+        ogles_error(c, err);
+    }
+}
+
 void glTexSubImage2D(
         GLenum target, GLint level, GLint xoffset,
         GLint yoffset, GLsizei width, GLsizei height,
         GLenum format, GLenum type, const GLvoid *pixels)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if (target != GL_TEXTURE_2D) {
         ogles_error(c, GL_INVALID_ENUM);
         return;
@@ -1255,6 +1343,12 @@ void glTexSubImage2D(
     EGLTextureObject* tex = c->textures.tmu[active].texture;
     const GGLSurface& surface(tex->mip(level));
 
+    if (tex->direct && tex->buffer) {
+        texSubImageNativeBuffer(c, tex, level,
+                xoffset, yoffset, width, height, format, type, pixels);
+        return;
+    }
+
     if (!tex->internalformat || tex->direct) {
         ogles_error(c, GL_INVALID_OPERATION);
         return;
@@ -1316,6 +1410,7 @@ void glCopyTexImage2D(
         GLint border)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if (target != GL_TEXTURE_2D) {
         ogles_error(c, GL_INVALID_ENUM);
         return;
@@ -1422,6 +1517,7 @@ void glCopyTexSubImage2D(
         GLint x, GLint y, GLsizei width, GLsizei height)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if (target != GL_TEXTURE_2D) {
         ogles_error(c, GL_INVALID_ENUM);
         return;
@@ -1484,6 +1580,7 @@ void glReadPixels(
         GLenum format, GLenum type, GLvoid *pixels)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if ((format != GL_RGBA) && (format != GL_RGB)) {
         ogles_error(c, GL_INVALID_ENUM);
         return;
@@ -1604,6 +1701,7 @@ void glDrawTexxOES(GLfixed x, GLfixed y, GLfixed z, GLfixed w, GLfixed h) {
 void glEGLImageTargetTexture2DOES(GLenum target, GLeglImageOES image)
 {
     ogles_context_t* c = ogles_context_t::get();
+    ogles_flush_tiler(c);
     if (target != GL_TEXTURE_2D && target != GL_TEXTURE_EXTERNAL_OES) {
         ogles_error(c, GL_INVALID_ENUM);
         return;
@@ -0,0 +1,867 @@
+/* libs/opengles/tiler.cpp
+**
+** Copyright 2006, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "context.h"
+#include "tiler.h"
+#include "tiler_bands.h"
+
+/*
+ * When debug.agl.raster_threads is greater than 1, the rasterizer calls made
+ * by a context are recorded instead of being executed, and replayed at flush
+ * time by that many pixelflinger contexts, each one clipped to its own
+ * horizontal band of the color buffer.
+ *
+ * The context's own rasterizer still executes the state changes, because
+ * libagl reads its state back, but it never draws anything.
+ *
+ * Each band context replays all the state changes in order, so its state is
+ * always the one the context had when a primitive was recorded. Primitives
+ * that don't cover a band are skipped for that band. Since a pixel belongs
+ * to a single band, it sees the same operations in the same order as without
+ * the tiler.
+ */
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+enum {
+    MAX_RASTER_THREADS  = 8,
+    MAX_COMMANDS        = 16384
+};
+
+enum {
+    // state changes
+    OP_SCISSOR,
+    OP_ACTIVE_TEXTURE,
+    OP_BIND_TEXTURE,
+    OP_BIND_TEXTURE_LOD,
+    OP_COLOR_BUFFER,
+    OP_READ_BUFFER,
+    OP_DEPTH_BUFFER,
+    OP_ENABLE_DISABLE,
+    OP_SHADE_MODEL,
+    OP_COLOR,
+    OP_COLOR_GRAD,
+    OP_Z_GRAD,
+    OP_W_GRAD,
+    OP_FOG_GRAD,
+    OP_FOG_COLOR,
+    OP_BLEND_FUNC,
+    OP_TEX_ENVI,
+    OP_TEX_ENVXV,
+    OP_TEX_PARAMETERI,
+    OP_TEX_COORD,
+    OP_TEX_COORD_GRAD,
+    OP_TEX_GENI,
+    OP_COLOR_MASK,
+    OP_DEPTH_MASK,
+    OP_STENCIL_MASK,
+    OP_ALPHA_FUNC,
+    OP_DEPTH_FUNC,
+    OP_LOGIC_OP,
+    OP_CLEAR_COLOR,
+    OP_CLEAR_DEPTH,
+    OP_CLEAR_STENCIL,
+
+    // primitives, only replayed by the bands they cover
+    OP_FIRST_PRIMITIVE,
+    OP_CLEAR = OP_FIRST_PRIMITIVE,
+    OP_RECT,
+    OP_POINT,
+    OP_LINE,
+    OP_TRIANGLE
+};
+
+struct raster_command_t {
+    uint32_t    op;
+    int32_t     top;        // rows [top, bottom) covered by a primitive
+    int32_t     bottom;
+    union {
+        GGLint      i[12];
+        GGLfixed    v[12];
+        GGLSurface  surface;
+        struct {
+            GGLuint     tmu;
+            GGLSurface  surface;
+        } lod;
+    };
+};
+
+struct raster_band_t {
+    tiler_t*        tiler;
+    GGLContext*     gl;
+    pthread_t       thread;
+    int32_t         top;
+    int32_t         bottom;
+    GGLint          scissor[4];     // the context's scissor
+    bool            scissorTest;
+};
+
+namespace gl {
+
+struct tiler_t {
+    GGLContext          procs;      // the context's own rasterizer procs
+    raster_command_t*   commands;
+    size_t              count;
+    int                 numBands;
+    raster_band_t       bands[MAX_RASTER_THREADS];
+
+    pthread_mutex_t     lock;
+    pthread_cond_t      start;
+    pthread_cond_t      done;
+    uint32_t            generation;
+    int                 pending;
+    bool                exiting;
+};
+
+}; // namespace gl
+
+// ----------------------------------------------------------------------------
+#if 0
+#pragma mark -
+#pragma mark Recording
+#endif
+
+static inline ogles_context_t* getContext(void* con) {
+    return static_cast<ogles_context_t*>(con);
+}
+
+static void tiler_clear(void* con, GGLbitfield mask);
+static void tiler_recti(void* con, GGLint l, GGLint t, GGLint r, GGLint b);
+static void tiler_pointx(void* con, const GGLcoord* v, GGLcoord radius);
+static void tiler_linex(void* con,
+        const GGLcoord* v0, const GGLcoord* v1, GGLcoord width);
+static void tiler_trianglex(void* con,
+        GGLcoord const* v0, GGLcoord const* v1, GGLcoord const* v2);
+
+// pixelflinger replaces its primitive procs when its state changes,
+// put ours back after each state change.
+static inline void restorePrimitives(ogles_context_t* c) {
+    GGLContext& procs(c->rasterizer.procs);
+    procs.clear = tiler_clear;
+    procs.recti = tiler_recti;
+    procs.pointx = tiler_pointx;
+    procs.linex = tiler_linex;
+    procs.trianglex = tiler_trianglex;
+}
+
+static raster_command_t* record(ogles_context_t* c, uint32_t op)
+{
+    tiler_t* t = c->tiler;
+    if (ggl_unlikely(t->count == MAX_COMMANDS))
+        ogles_flush_tiler(c);
+    raster_command_t* cmd = t->commands + t->count++;
+    cmd->op = op;
+    return cmd;
+}
+
+static void tiler_scissor(void* con,
+        GGLint x, GGLint y, GGLsizei width, GGLsizei height)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_SCISSOR);
+    cmd->i[0] = x;
+    cmd->i[1] = y;
+    cmd->i[2] = width;
+    cmd->i[3] = height;
+    c->tiler->procs.scissor(con, x, y, width, height);
+    restorePrimitives(c);
+}
+
+static void tiler_activeTexture(void* con, GGLuint tmu)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_ACTIVE_TEXTURE)->i[0] = tmu;
+    c->tiler->procs.activeTexture(con, tmu);
+    restorePrimitives(c);
+}
+
+static void tiler_bindTexture(void* con, GGLSurface* surface)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_BIND_TEXTURE)->surface = *surface;
+    c->tiler->procs.bindTexture(con, surface);
+    restorePrimitives(c);
+}
+
+static void tiler_bindTextureLod(void* con,
+        GGLuint tmu, const GGLSurface* surface)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_BIND_TEXTURE_LOD);
+    cmd->lod.tmu = tmu;
+    cmd->lod.surface = *surface;
+    c->tiler->procs.bindTextureLod(con, tmu, surface);
+    restorePrimitives(c);
+}
+
+static void tiler_colorBuffer(void* con, GGLSurface* surface)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_COLOR_BUFFER)->surface = *surface;
+    c->tiler->procs.colorBuffer(con, surface);
+    restorePrimitives(c);
+}
+
+static void tiler_readBuffer(void* con, GGLSurface* surface)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_READ_BUFFER)->surface = *surface;
+    c->tiler->procs.readBuffer(con, surface);
+    restorePrimitives(c);
+}
+
+static void tiler_depthBuffer(void* con, GGLSurface* surface)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_DEPTH_BUFFER)->surface = *surface;
+    c->tiler->procs.depthBuffer(con, surface);
+    restorePrimitives(c);
+}
+
+static void tiler_enableDisable(void* con, GGLenum name, GGLboolean en)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_ENABLE_DISABLE);
+    cmd->i[0] = name;
+    cmd->i[1] = en;
+    c->tiler->procs.enableDisable(con, name, en);
+    restorePrimitives(c);
+}
+
+static void tiler_enable(void* con, GGLenum name)
+{
+    tiler_enableDisable(con, name, 1);
+}
+
+static void tiler_disable(void* con, GGLenum name)
+{
+    tiler_enableDisable(con, name, 0);
+}
+
+static void tiler_shadeModel(void* con, GGLenum mode)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_SHADE_MODEL)->i[0] = mode;
+    c->tiler->procs.shadeModel(con, mode);
+    restorePrimitives(c);
+}
+
+static void tiler_color4xv(void* con, const GGLclampx* color)
+{
+    ogles_context_t* c = getContext(con);
+    memcpy(record(c, OP_COLOR)->v, color, 4*sizeof(GGLclampx));
+    c->tiler->procs.color4xv(con, color);
+    restorePrimitives(c);
+}
+
+static void tiler_colorGrad12xv(void* con, const GGLcolor* grad)
+{
+    ogles_context_t* c = getContext(con);
+    memcpy(record(c, OP_COLOR_GRAD)->v, grad, 12*sizeof(GGLcolor));
+    c->tiler->procs.colorGrad12xv(con, grad);
+    restorePrimitives(c);
+}
+
+static void tiler_zGrad3xv(void* con, const GGLfixed32* grad)
+{
+    ogles_context_t* c = getContext(con);
+    memcpy(record(c, OP_Z_GRAD)->v, grad, 3*sizeof(GGLfixed32));
+    c->tiler->procs.zGrad3xv(con, grad);
+    restorePrimitives(c);
+}
+
+static void tiler_wGrad3xv(void* con, const GGLfixed* grad)
+{
+    ogles_context_t* c = getContext(con);
+    memcpy(record(c, OP_W_GRAD)->v, grad, 3*sizeof(GGLfixed));
+    c->tiler->procs.wGrad3xv(con, grad);
+    restorePrimitives(c);
+}
+
+static void tiler_fogGrad3xv(void* con, const GGLfixed* grad)
+{
+    ogles_context_t* c = getContext(con);
+    memcpy(record(c, OP_FOG_GRAD)->v, grad, 3*sizeof(GGLfixed));
+    c->tiler->procs.fogGrad3xv(con, grad);
+    restorePrimitives(c);
+}
+
+static void tiler_fogColor3xv(void* con, const GGLclampx* color)
+{
+    ogles_context_t* c = getContext(con);
+    memcpy(record(c, OP_FOG_COLOR)->v, color, 3*sizeof(GGLclampx));
+    c->tiler->procs.fogColor3xv(con, color);
+    restorePrimitives(c);
+}
+
+static void tiler_blendFunc(void* con, GGLenum src, GGLenum dst)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_BLEND_FUNC);
+    cmd->i[0] = src;
+    cmd->i[1] = dst;
+    c->tiler->procs.blendFunc(con, src, dst);
+    restorePrimitives(c);
+}
+
+static void tiler_texEnvi(void* con,
+        GGLenum target, GGLenum pname, GGLint param)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_TEX_ENVI);
+    cmd->i[0] = target;
+    cmd->i[1] = pname;
+    cmd->i[2] = param;
+    c->tiler->procs.texEnvi(con, target, pname, param);
+    restorePrimitives(c);
+}
+
+static void tiler_texEnvxv(void* con,
+        GGLenum target, GGLenum pname, const GGLfixed* params)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_TEX_ENVXV);
+    cmd->i[0] = target;
+    cmd->i[1] = pname;
+    const int n = (pname == GGL_TEXTURE_ENV_COLOR) ? 4 : 1;
+    memcpy(cmd->v + 2, params, n*sizeof(GGLfixed));
+    c->tiler->procs.texEnvxv(con, target, pname, params);
+    restorePrimitives(c);
+}
+
+static void tiler_texParameteri(void* con,
+        GGLenum target, GGLenum pname, GGLint param)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_TEX_PARAMETERI);
+    cmd->i[0] = target;
+    cmd->i[1] = pname;
+    cmd->i[2] = param;
+    c->tiler->procs.texParameteri(con, target, pname, param);
+    restorePrimitives(c);
+}
+
+static void tiler_texCoord2i(void* con, GGLint s, GGLint t)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_TEX_COORD);
+    cmd->i[0] = s;
+    cmd->i[1] = t;
+    c->tiler->procs.texCoord2i(con, s, t);
+    restorePrimitives(c);
+}
+
+static void tiler_texCoordGradScale8xv(void* con,
+        GGLint tmu, const int32_t* grad8)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_TEX_COORD_GRAD);
+    cmd->i[0] = tmu;
+    memcpy(cmd->i + 1, grad8, 8*sizeof(int32_t));
+    c->tiler->procs.texCoordGradScale8xv(con, tmu, grad8);
+    restorePrimitives(c);
+}
+
+static void tiler_texGeni(void* con,
+        GGLenum coord, GGLenum pname, GGLint param)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_TEX_GENI);
+    cmd->i[0] = coord;
+    cmd->i[1] = pname;
+    cmd->i[2] = param;
+    c->tiler->procs.texGeni(con, coord, pname, param);
+    restorePrimitives(c);
+}
+
+static void tiler_colorMask(void* con, GGLboolean red,
+        GGLboolean green, GGLboolean blue, GGLboolean alpha)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_COLOR_MASK);
+    cmd->i[0] = red;
+    cmd->i[1] = green;
+    cmd->i[2] = blue;
+    cmd->i[3] = alpha;
+    c->tiler->procs.colorMask(con, red, green, blue, alpha);
+    restorePrimitives(c);
+}
+
+static void tiler_depthMask(void* con, GGLboolean flag)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_DEPTH_MASK)->i[0] = flag;
+    c->tiler->procs.depthMask(con, flag);
+    restorePrimitives(c);
+}
+
+static void tiler_stencilMask(void* con, GGLuint mask)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_STENCIL_MASK)->i[0] = mask;
+    c->tiler->procs.stencilMask(con, mask);
+    restorePrimitives(c);
+}
+
+static void tiler_alphaFuncx(void* con, GGLenum func, GGLclampx ref)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_ALPHA_FUNC);
+    cmd->i[0] = func;
+    cmd->i[1] = ref;
+    c->tiler->procs.alphaFuncx(con, func, ref);
+    restorePrimitives(c);
+}
+
+static void tiler_depthFunc(void* con, GGLenum func)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_DEPTH_FUNC)->i[0] = func;
+    c->tiler->procs.depthFunc(con, func);
+    restorePrimitives(c);
+}
+
+static void tiler_logicOp(void* con, GGLenum opcode)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_LOGIC_OP)->i[0] = opcode;
+    c->tiler->procs.logicOp(con, opcode);
+    restorePrimitives(c);
+}
+
+static void tiler_clearColorx(void* con,
+        GGLclampx r, GGLclampx g, GGLclampx b, GGLclampx a)
+{
+    ogles_context_t* c = getContext(con);
+    raster_command_t* cmd = record(c, OP_CLEAR_COLOR);
+    cmd->i[0] = r;
+    cmd->i[1] = g;
+    cmd->i[2] = b;
+    cmd->i[3] = a;
+    c->tiler->procs.clearColorx(con, r, g, b, a);
+    restorePrimitives(c);
+}
+
+static void tiler_clearDepthx(void* con, GGLclampx depth)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_CLEAR_DEPTH)->i[0] = depth;
+    c->tiler->procs.clearDepthx(con, depth);
+    restorePrimitives(c);
+}
+
+static void tiler_clearStencil(void* con, GGLint s)
+{
+    ogles_context_t* c = getContext(con);
+    record(c, OP_CLEAR_STENCIL)->i[0] = s;
+    c->tiler->procs.clearStencil(con, s);
+    restorePrimitives(c);
+}
+
+// Primitives are only recorded, along with the rows they may cover.
+// Coordinates are in the TRI_FRACTION_BITS fixed-point format, the bounds
+// are conservative.
+
+static inline int32_t triTop(GGLcoord y) {
+    return (y >> TRI_FRACTION_BITS) - 1;
+}
+
+static inline int32_t triBottom(GGLcoord y) {
+    return (y >> TRI_FRACTION_BITS) + 2;
+}
+
+void tiler_clear(void* con, GGLbitfield mask)
+{
+    raster_command_t* cmd = record(getContext(con), OP_CLEAR);
+    cmd->top = INT_MIN;
+    cmd->bottom = INT_MAX;
+    cmd->i[0] = mask;
+}
+
+void tiler_recti(void* con, GGLint l, GGLint t, GGLint r, GGLint b)
+{
+    raster_command_t* cmd = record(getContext(con), OP_RECT);
+    cmd->top = t;
+    cmd->bottom = b;
+    cmd->i[0] = l;
+    cmd->i[1] = t;
+    cmd->i[2] = r;
+    cmd->i[3] = b;
+}
+
+void tiler_pointx(void* con, const GGLcoord* v, GGLcoord radius)
+{
+    raster_command_t* cmd = record(getContext(con), OP_POINT);
+    cmd->top = triTop(v[1] - radius);
+    cmd->bottom = triBottom(v[1] + radius);
+    memcpy(cmd->v, v, 4*sizeof(GGLcoord));
+    cmd->v[4] = radius;
+}
+
+void tiler_linex(void* con,
+        const GGLcoord* v0, const GGLcoord* v1, GGLcoord width)
+{
+    raster_command_t* cmd = record(getContext(con), OP_LINE);
+    cmd->top = triTop(min(v0[1], v1[1]) - width);
+    cmd->bottom = triBottom(max(v0[1], v1[1]) + width);
+    memcpy(cmd->v, v0, 4*sizeof(GGLcoord));
+    memcpy(cmd->v + 4, v1, 4*sizeof(GGLcoord));
+    cmd->v[8] = width;
+}
+
+void tiler_trianglex(void* con,
+        GGLcoord const* v0, GGLcoord const* v1, GGLcoord const* v2)
+{
+    raster_command_t* cmd = record(getContext(con), OP_TRIANGLE);
+    cmd->top = triTop(min(v0[1], v1[1], v2[1]));
+    cmd->bottom = triBottom(max(v0[1], v1[1], v2[1]));
+    memcpy(cmd->v, v0, 4*sizeof(GGLcoord));
+    memcpy(cmd->v + 4, v1, 4*sizeof(GGLcoord));
+    memcpy(cmd->v + 8, v2, 4*sizeof(GGLcoord));
+}
+
+// ----------------------------------------------------------------------------
+#if 0
+#pragma mark -
+#pragma mark Replay
+#endif
+
+// The band's scissor is the context's scissor, if enabled, clipped to
+// the band.
+static void setBandScissor(raster_band_t* band)
+{
+    GGLContext* gl = band->gl;
+    int32_t s[4];
+    ogles_tiler_band_scissor(band->top, band->bottom,
+            band->scissorTest ? band->scissor : 0, s);
+    gl->scissor(gl, s[0], s[1], s[2], s[3]);
+}
+
+static void replay(raster_band_t* band,
+        const raster_command_t* cmd, size_t count)
+{
+    GGLContext* gl = band->gl;
+    for (size_t n=0 ; n<count ; n++, cmd++) {
+        if (cmd->op >= OP_FIRST_PRIMITIVE &&
+                (cmd->bottom <= band->top || cmd->top >= band->bottom))
+            continue;
+
+        const GGLint* i = cmd->i;
+        switch (cmd->op) {
+        case OP_SCISSOR:
+            memcpy(band->scissor, i, sizeof(band->scissor));
+            setBandScissor(band);
+            break;
+        case OP_ACTIVE_TEXTURE:
+            gl->activeTexture(gl, i[0]);
+            break;
+        case OP_BIND_TEXTURE:
+            gl->bindTexture(gl, const_cast<GGLSurface*>(&cmd->surface));
+            break;
+        case OP_BIND_TEXTURE_LOD:
+            gl->bindTextureLod(gl, cmd->lod.tmu, &cmd->lod.surface);
+            break;
+        case OP_COLOR_BUFFER:
+            gl->colorBuffer(gl, const_cast<GGLSurface*>(&cmd->surface));
+            setBandScissor(band);
+            break;
+        case OP_READ_BUFFER:
+            gl->readBuffer(gl, const_cast<GGLSurface*>(&cmd->surface));
+            break;
+        case OP_DEPTH_BUFFER:
+            gl->depthBuffer(gl, const_cast<GGLSurface*>(&cmd->surface));
+            break;
+        case OP_ENABLE_DISABLE:
+            // the band's scissor test is always enabled
+            if (i[0] == GGL_SCISSOR_TEST) {
+                band->scissorTest = i[1];
+                setBandScissor(band);
+            } else {
+                gl->enableDisable(gl, i[0], i[1]);
+            }
+            break;
+        case OP_SHADE_MODEL:
+            gl->shadeModel(gl, i[0]);
+            break;
+        case OP_COLOR:
+            gl->color4xv(gl, cmd->v);
+            break;
+        case OP_COLOR_GRAD:
+            gl->colorGrad12xv(gl, cmd->v);
+            break;
+        case OP_Z_GRAD:
+            gl->zGrad3xv(gl, (const GGLfixed32*)cmd->v);
+            break;
+        case OP_W_GRAD:
+            gl->wGrad3xv(gl, cmd->v);
+            break;
+        case OP_FOG_GRAD:
+            gl->fogGrad3xv(gl, cmd->v);
+            break;
+        case OP_FOG_COLOR:
+            gl->fogColor3xv(gl, cmd->v);
+            break;
+        case OP_BLEND_FUNC:
+            gl->blendFunc(gl, i[0], i[1]);
+            break;
+        case OP_TEX_ENVI:
+            gl->texEnvi(gl, i[0], i[1], i[2]);
+            break;
+        case OP_TEX_ENVXV:
+            gl->texEnvxv(gl, i[0], i[1], cmd->v + 2);
+            break;
+        case OP_TEX_PARAMETERI:
+            gl->texParameteri(gl, i[0], i[1], i[2]);
+            break;
+        case OP_TEX_COORD:
+            gl->texCoord2i(gl, i[0], i[1]);
+            break;
+        case OP_TEX_COORD_GRAD:
+            gl->texCoordGradScale8xv(gl, i[0], i + 1);
+            break;
+        case OP_TEX_GENI:
+            gl->texGeni(gl, i[0], i[1], i[2]);
+            break;
+        case OP_COLOR_MASK:
+            gl->colorMask(gl, i[0], i[1], i[2], i[3]);
+            break;
+        case OP_DEPTH_MASK:
+            gl->depthMask(gl, i[0]);
+            break;
+        case OP_STENCIL_MASK:
+            gl->stencilMask(gl, i[0]);
+            break;
+        case OP_ALPHA_FUNC:
+            gl->alphaFuncx(gl, i[0], i[1]);
+            break;
+        case OP_DEPTH_FUNC:
+            gl->depthFunc(gl, i[0]);
+            break;
+        case OP_LOGIC_OP:
+            gl->logicOp(gl, i[0]);
+            break;
+        case OP_CLEAR_COLOR:
+            gl->clearColorx(gl, i[0], i[1], i[2], i[3]);
+            break;
+        case OP_CLEAR_DEPTH:
+            gl->clearDepthx(gl, i[0]);
+            break;
+        case OP_CLEAR_STENCIL:
+            gl->clearStencil(gl, i[0]);
+            break;
+        case OP_CLEAR:
+            gl->clear(gl, i[0]);
+            break;
+        case OP_RECT:
+            gl->recti(gl, i[0], i[1], i[2], i[3]);
+            break;
+        case OP_POINT:
+            gl->pointx(gl, cmd->v, cmd->v[4]);
+            break;
+        case OP_LINE:
+            gl->linex(gl, cmd->v, cmd->v + 4, cmd->v[8]);
+            break;
+        case OP_TRIANGLE:
+            gl->trianglex(gl, cmd->v, cmd->v + 4, cmd->v + 8);
+            break;
+        }
+    }
+}
+
+static void* bandThread(void* arg)
+{
+    raster_band_t* band = static_cast<raster_band_t*>(arg);
+    tiler_t* t = band->tiler;
+    uint32_t generation = 0;
+    pthread_mutex_lock(&t->lock);
+    while (true) {
+        while (!t->exiting && t->generation == generation)
+            pthread_cond_wait(&t->start, &t->lock);
+        if (t->exiting)
+            break;
+        generation = t->generation;
+        pthread_mutex_unlock(&t->lock);
+
+        replay(band, t->commands, t->count);
+
+        pthread_mutex_lock(&t->lock);
+        if (--t->pending == 0)
+            pthread_cond_signal(&t->done);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+#if 0
+#pragma mark -
+#endif
+
+void ogles_init_tiler(ogles_context_t* c)
+{
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.agl.raster_threads", value, "0");
+    int numBands = atoi(value);
+    if (numBands <= 1)
+        return;
+    if (numBands > MAX_RASTER_THREADS)
+        numBands = MAX_RASTER_THREADS;
+
+    tiler_t* t = (tiler_t*)calloc(1, sizeof(tiler_t));
+    if (!t)
+        return;
+    t->commands = (raster_command_t*)malloc(
+            MAX_COMMANDS * sizeof(raster_command_t));
+    if (!t->commands) {
+        free(t);
+        return;
+    }
+    pthread_mutex_init(&t->lock, 0);
+    pthread_cond_init(&t->start, 0);
+    pthread_cond_init(&t->done, 0);
+
+    // the bands start from pixelflinger's initial state, so this
+    // must happen before the context changes its rasterizer's state.
+    GGLContext& procs(c->rasterizer.procs);
+    t->procs = procs;
+    c->tiler = t;
+
+    // the first band is rasterized by the thread flushing the context
+    for (int i=0 ; i<numBands ; i++) {
+        raster_band_t* band = &t->bands[i];
+        band->tiler = t;
+        if (gglInit(&band->gl) != 0)
+            break;
+        band->gl->enable(band->gl, GGL_SCISSOR_TEST);
+        if (i && pthread_create(&band->thread, 0, bandThread, band) != 0) {
+            gglUninit(band->gl);
+            break;
+        }
+        t->numBands++;
+    }
+    if (t->numBands <= 1) {
+        ALOGW("couldn't start the raster threads, rasterizing serially");
+        ogles_uninit_tiler(c);
+        return;
+    }
+
+    procs.scissor = tiler_scissor;
+    procs.activeTexture = tiler_activeTexture;
+    procs.bindTexture = tiler_bindTexture;
+    procs.bindTextureLod = tiler_bindTextureLod;
+    procs.colorBuffer = tiler_colorBuffer;
+    procs.readBuffer = tiler_readBuffer;
+    procs.depthBuffer = tiler_depthBuffer;
+    procs.enable = tiler_enable;
+    procs.disable = tiler_disable;
+    procs.enableDisable = tiler_enableDisable;
+    procs.shadeModel = tiler_shadeModel;
+    procs.color4xv = tiler_color4xv;
+    procs.colorGrad12xv = tiler_colorGrad12xv;
+    procs.zGrad3xv = tiler_zGrad3xv;
+    procs.wGrad3xv = tiler_wGrad3xv;
+    procs.fogGrad3xv = tiler_fogGrad3xv;
+    procs.fogColor3xv = tiler_fogColor3xv;
+    procs.blendFunc = tiler_blendFunc;
+    procs.texEnvi = tiler_texEnvi;
+    procs.texEnvxv = tiler_texEnvxv;
+    procs.texParameteri = tiler_texParameteri;
+    procs.texCoord2i = tiler_texCoord2i;
+    procs.texCoordGradScale8xv = tiler_texCoordGradScale8xv;
+    procs.texGeni = tiler_texGeni;
+    procs.colorMask = tiler_colorMask;
+    procs.depthMask = tiler_depthMask;
+    procs.stencilMask = tiler_stencilMask;
+    procs.alphaFuncx = tiler_alphaFuncx;
+    procs.depthFunc = tiler_depthFunc;
+    procs.logicOp = tiler_logicOp;
+    procs.clearColorx = tiler_clearColorx;
+    procs.clearDepthx = tiler_clearDepthx;
+    procs.clearStencil = tiler_clearStencil;
+    restorePrimitives(c);
+}
+
+void ogles_uninit_tiler(ogles_context_t* c)
+{
+    tiler_t* t = c->tiler;
+    if (!t)
+        return;
+
+    // whatever wasn't flushed is discarded along with the context
+    pthread_mutex_lock(&t->lock);
+    t->exiting = true;
+    pthread_cond_broadcast(&t->start);
+    pthread_mutex_unlock(&t->lock);
+    for (int i=0 ; i<t->numBands ; i++) {
+        if (i)
+            pthread_join(t->bands[i].thread, 0);
+        gglUninit(t->bands[i].gl);
+    }
+    pthread_cond_destroy(&t->done);
+    pthread_cond_destroy(&t->start);
+    pthread_mutex_destroy(&t->lock);
+
+    c->rasterizer.procs = t->procs;
+    free(t->commands);
+    free(t);
+    c->tiler = 0;
+}
+
+void ogles_flush_tiler(ogles_context_t* c)
+{
+    tiler_t* t = c->tiler;
+    if (!t || !t->count)
+        return;
+
+    // split the color buffer in bands of rows, nothing is drawn above
+    // row 0 so the first band starts there.
+    const int32_t height = c->rasterizer.state.buffers.color.height;
+    const int numBands = t->numBands;
+    for (int i=0 ; i<numBands ; i++) {
+        raster_band_t* band = &t->bands[i];
+        ogles_tiler_band_rows(height, numBands, i, &band->top, &band->bottom);
+        setBandScissor(band);
+    }
+
+    pthread_mutex_lock(&t->lock);
+    t->generation++;
+    t->pending = numBands - 1;
+    pthread_cond_broadcast(&t->start);
+    pthread_mutex_unlock(&t->lock);
+
+    replay(&t->bands[0], t->commands, t->count);
+
+    pthread_mutex_lock(&t->lock);
+    while (t->pending)
+        pthread_cond_wait(&t->done, &t->lock);
+    pthread_mutex_unlock(&t->lock);
+
+    t->count = 0;
+}
+
+// ----------------------------------------------------------------------------
+}; // namespace android
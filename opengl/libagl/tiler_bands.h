@@ -0,0 +1,63 @@
+/* libs/opengles/tiler_bands.h
+**
+** Copyright 2006, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_OPENGLES_TILER_BANDS_H
+#define ANDROID_OPENGLES_TILER_BANDS_H
+
+#include <limits.h>
+#include <stdint.h>
+
+namespace android {
+
+// Rows [top, bottom) of band i out of numBands splitting a color buffer
+// of the given height. The last band also covers anything below the
+// color buffer, since the recorded commands may target a taller one.
+inline void ogles_tiler_band_rows(int32_t height, int numBands, int i,
+        int32_t* top, int32_t* bottom)
+{
+    *top = int32_t((int64_t(height) * i) / numBands);
+    *bottom = (i < numBands-1) ?
+            int32_t((int64_t(height) * (i+1)) / numBands) : INT_MAX;
+}
+
+// The scissor {l, t, w, h} of the band [top, bottom), clipped to the
+// context's scissor when it is non-NULL. Computed in 64 bits since the
+// context's scissor comes straight from the application.
+inline void ogles_tiler_band_scissor(int32_t top, int32_t bottom,
+        const int32_t* scissor, int32_t* out)
+{
+    int64_t l = 0;
+    int64_t t = top;
+    int64_t r = 0x7FFF;
+    int64_t b = bottom;
+    if (scissor) {
+        l = scissor[0];
+        r = int64_t(scissor[0]) + scissor[2];
+        if (t < scissor[1])
+            t = scissor[1];
+        if (b > int64_t(scissor[1]) + scissor[3])
+            b = int64_t(scissor[1]) + scissor[3];
+    }
+    out[0] = int32_t(l);
+    out[1] = int32_t(t);
+    out[2] = r > l ? int32_t(r - l < INT_MAX ? r - l : INT_MAX) : 0;
+    out[3] = b > t ? int32_t(b - t < INT_MAX ? b - t : INT_MAX) : 0;
+}
+
+}; // namespace android
+
+#endif // ANDROID_OPENGLES_TILER_BANDS_H
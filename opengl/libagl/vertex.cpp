@@ -161,6 +161,45 @@ void ogles_vertex_clipAllPerspective3D(ogles_context_t* c, vertex_t* v) {
     clipAllPerspective(c, v, 0);
 }
 
+// Same as calling c->arrays.perspective on each vertex, without an
+// indirect call per vertex for the common cases.
+void ogles_vertices_perspective(ogles_context_t* c, vertex_t* v, int count)
+{
+    if (c->arrays.perspective != ogles_vertex_perspective2D &&
+        c->arrays.perspective != ogles_vertex_perspective3D &&
+        c->arrays.perspective != ogles_vertex_perspective3DZ) {
+        // the first call may validate c->arrays.perspective
+        c->arrays.perspective(c, v++);
+        if (!--count)
+            return;
+    }
+
+    void (* const perspective)(ogles_context_t*, vertex_t*) =
+            c->arrays.perspective;
+    if (perspective == ogles_vertex_perspective3DZ) {
+        do {
+            clipFrustumPerspective(c, v++, GGL_ENABLE_DEPTH_TEST);
+        } while (--count);
+    } else if (perspective == ogles_vertex_perspective3D) {
+        do {
+            clipFrustumPerspective(c, v++, 0);
+        } while (--count);
+    } else if (perspective == ogles_vertex_perspective2D) {
+        c->arrays.cull = 0;
+        do {
+            v->window.x = TRI_FROM_FIXED(v->clip.x);
+            v->window.y = TRI_FROM_FIXED(v->clip.y);
+            v->window.z = v->clip.z;
+            v->window.w = v->clip.w << 12;
+            v++;
+        } while (--count);
+    } else {
+        do {
+            perspective(c, v++);
+        } while (--count);
+    }
+}
+
 static void clipPlanex(GLenum plane, const GLfixed* equ, ogles_context_t* c)
 {
     const int p = plane - GL_CLIP_PLANE0;
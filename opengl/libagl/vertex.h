@@ -42,6 +42,8 @@ void ogles_vertex_clipAllPerspective3DZ(ogles_context_t*, vertex_t*);
 
 void ogles_vertex_project(ogles_context_t* c, vertex_t*);
 
+void ogles_vertices_perspective(ogles_context_t* c, vertex_t* v, int count);
+
 }; // namespace android
 
 #endif // ANDROID_OPENGLES_VERTEX_H
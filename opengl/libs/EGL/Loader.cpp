@@ -117,6 +117,7 @@ static char const * getProcessCmdline() {
 // ----------------------------------------------------------------------------
 
 Loader::driver_t::driver_t(void* gles)
+    : loaded(0)
 {
     dso[0] = gles;
     for (size_t i=1 ; i<NELEM(dso) ; i++)
@@ -172,7 +173,9 @@ void* Loader::open(egl_connection_t* cnx)
     void* dso;
     driver_t* hnd = 0;
 
-    dso = load_driver("GLES", cnx, EGL | GLESv1_CM | GLESv2);
+    // Most processes only ever use OpenGL ES 2.0 and up, GLESv1_CM is
+    // loaded and its hooks initialized by openGLESv1() when needed.
+    dso = load_driver("GLES", cnx, EGL | GLESv2);
     if (dso) {
         hnd = new driver_t(dso);
     } else {
@@ -180,10 +183,12 @@ void* Loader::open(egl_connection_t* cnx)
         dso = load_driver("EGL", cnx, EGL);
         if (dso) {
             hnd = new driver_t(dso);
-            hnd->set( load_driver("GLESv1_CM", cnx, GLESv1_CM), GLESv1_CM );
             hnd->set( load_driver("GLESv2",    cnx, GLESv2),    GLESv2 );
         }
     }
+    if (hnd) {
+        hnd->loaded = EGL | GLESv2;
+    }
 
     LOG_ALWAYS_FATAL_IF(!hnd, "couldn't find an OpenGL ES implementation");
 
@@ -205,6 +210,28 @@ void* Loader::open(egl_connection_t* cnx)
     return (void*)hnd;
 }
 
+status_t Loader::openGLESv1(egl_connection_t* cnx)
+{
+    driver_t* hnd = (driver_t*)cnx->dso;
+    if (hnd == NULL) {
+        return NO_INIT;
+    }
+    if (hnd->loaded & GLESv1_CM) {
+        return NO_ERROR;
+    }
+    if (hnd->dso[2] == 0) {
+        // single library, only the hooks are missing
+        init_api(hnd->dso[0], gl_names,
+            (__eglMustCastToProperFunctionPointerType*)
+                &cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl,
+            getProcAddress);
+    } else {
+        hnd->set( load_driver("GLESv1_CM", cnx, GLESv1_CM), GLESv1_CM );
+    }
+    hnd->loaded |= GLESv1_CM;
+    return NO_ERROR;
+}
+
 status_t Loader::close(void* driver)
 {
     driver_t* hnd = (driver_t*)driver;
@@ -50,6 +50,8 @@ class Loader : public Singleton<Loader>
         ~driver_t();
         status_t set(void* hnd, int32_t api);
         void* dso[3];
+        // the APIs whose hooks have been initialized
+        uint32_t loaded;
     };
     
     getProcAddressType getProcAddress;
@@ -57,7 +59,11 @@ class Loader : public Singleton<Loader>
 public:
     ~Loader();
     
+    // open loads the EGL and GLESv2 drivers. GLESv1_CM is only loaded by
+    // openGLESv1 when the first OpenGL ES 1.x context is created; callers
+    // must hold the driver initialization lock (see egl_init_gles1_driver).
     void* open(egl_connection_t* cnx);
+    status_t openGLESv1(egl_connection_t* cnx);
     status_t close(void* driver);
     
 private:
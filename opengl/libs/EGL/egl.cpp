@@ -38,6 +38,7 @@
 #include "egldefs.h"
 #include "Loader.h"
 
+#include "egl_cache.h"
 #include "egl_display.h"
 #include "egl_object.h"
 
@@ -297,7 +298,39 @@ const GLubyte * egl_get_string_for_current_context(GLenum name) {
 // this mutex protects:
 //    d->disp[]
 //    egl_init_drivers_locked()
+//    egl_init_gles1_driver()
 //
+static pthread_mutex_t sInitDriverMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The drivers may be loaded in a process which then forks, such as the
+// zygote, so that its children share the relocated driver pages.  None of
+// the per-process state may leak into the children: the locks must not be
+// held by a thread which doesn't exist in the child, the blob cache files
+// are the parent's and the calling thread's EGL state is stale.
+static void egl_prepare_fork() {
+    pthread_mutex_lock(&sInitDriverMutex);
+    egl_cache_t::get()->prepareFork();
+}
+
+static void egl_parent_fork() {
+    egl_cache_t::get()->parentFork();
+    pthread_mutex_unlock(&sInitDriverMutex);
+}
+
+static void egl_child_fork() {
+    egl_cache_t::get()->childFork();
+    pthread_mutex_unlock(&sInitDriverMutex);
+
+    // The drivers can only be shared if they were never initialized, the
+    // child can't use the parent's display connection.
+    ALOGE_IF(egl_display_t::hasInitializedDisplays(),
+            "EGL was initialized before fork(), "
+            "the child must not use the inherited displays");
+
+    egl_tls_t::clearTLS();
+    setGLHooksThreadSpecific(&gHooksNoContext);
+}
+
 static EGLBoolean egl_init_drivers_locked() {
     if (sEarlyInitState) {
         // initialized by static ctor. should be set here.
@@ -315,13 +348,14 @@ static EGLBoolean egl_init_drivers_locked() {
         cnx->hooks[egl_connection_t::GLESv2_INDEX] =
                 &gHooks[egl_connection_t::GLESv2_INDEX];
         cnx->dso = loader.open(cnx);
+        if (cnx->dso) {
+            pthread_atfork(egl_prepare_fork, egl_parent_fork, egl_child_fork);
+        }
     }
 
     return cnx->dso ? EGL_TRUE : EGL_FALSE;
 }
 
-static pthread_mutex_t sInitDriverMutex = PTHREAD_MUTEX_INITIALIZER;
-
 EGLBoolean egl_init_drivers() {
     EGLBoolean res;
     pthread_mutex_lock(&sInitDriverMutex);
@@ -330,6 +364,18 @@ EGLBoolean egl_init_drivers() {
     return res;
 }
 
+EGLBoolean egl_init_gles1_driver() {
+    EGLBoolean res;
+    pthread_mutex_lock(&sInitDriverMutex);
+    res = egl_init_drivers_locked();
+    if (res == EGL_TRUE) {
+        res = Loader::getInstance().openGLESv1(&gEGLImpl) == NO_ERROR ?
+                EGL_TRUE : EGL_FALSE;
+    }
+    pthread_mutex_unlock(&sInitDriverMutex);
+    return res;
+}
+
 static pthread_mutex_t sLogPrintMutex = PTHREAD_MUTEX_INITIALIZER;
 static nsecs_t sLogPrintTime = 0;
 #define NSECS_DURATION 1000000000
@@ -184,10 +184,81 @@ static void(*findProcAddress(const char* name,
     return NULL;
 }
 
+/*
+ * Every name eglGetProcAddress() resolved, whether to one of our entry
+ * points, a builtin wrapper or an extension forwarder. Some engines look
+ * functions up every frame; this lets them skip the dlsym() calls and the
+ * mutex. It's an open-addressing table that only grows: entries are written
+ * under sExtensionMapMutex and published by setting their state last, so
+ * lookups need no lock.
+ */
+#define PROC_CACHE_SIZE 1024 // power of 2
+
+struct proc_cache_entry_t {
+    volatile int32_t state; // non-zero once name and address are set
+    const char* name;
+    __eglMustCastToProperFunctionPointerType address;
+};
+
+static proc_cache_entry_t sProcCache[PROC_CACHE_SIZE];
+static size_t sProcCacheCount = 0; // protected by sExtensionMapMutex
+
+static uint32_t hashProcName(const char* name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char* p = name; *p; p++) {
+        hash = (hash ^ uint8_t(*p)) * 16777619u;
+    }
+    return hash;
+}
+
+static __eglMustCastToProperFunctionPointerType findCachedProcAddress(
+        const char* procname, uint32_t hash) {
+    for (uint32_t i = 0; i < PROC_CACHE_SIZE; i++) {
+        const proc_cache_entry_t& entry =
+                sProcCache[(hash + i) & (PROC_CACHE_SIZE - 1)];
+        if (!android_atomic_acquire_load(&entry.state)) {
+            return NULL;
+        }
+        if (!strcmp(entry.name, procname)) {
+            return entry.address;
+        }
+    }
+    return NULL;
+}
+
+// Must be called with sExtensionMapMutex held.
+static void cacheProcAddressLocked(const char* procname, uint32_t hash,
+        __eglMustCastToProperFunctionPointerType address) {
+    // keep chains short, past that the slow path is good enough
+    if (sProcCacheCount >= PROC_CACHE_SIZE * 3 / 4) {
+        return;
+    }
+    for (uint32_t i = 0; i < PROC_CACHE_SIZE; i++) {
+        proc_cache_entry_t& entry = sProcCache[(hash + i) & (PROC_CACHE_SIZE - 1)];
+        if (entry.state) {
+            if (!strcmp(entry.name, procname)) {
+                return;
+            }
+            continue;
+        }
+        char* name = strdup(procname);
+        if (!name) {
+            return;
+        }
+        entry.name = name;
+        entry.address = address;
+        android_atomic_release_store(1, &entry.state);
+        sProcCacheCount++;
+        return;
+    }
+}
+
 // ----------------------------------------------------------------------------
 
 extern void setGLHooksThreadSpecific(gl_hooks_t const *value);
 extern EGLBoolean egl_init_drivers();
+extern EGLBoolean egl_init_gles1_driver();
 extern const __eglMustCastToProperFunctionPointerType gExtensionForwarders[MAX_NUMBER_OF_GL_EXTENSIONS];
 extern int getEGLDebugLevel();
 extern void setEGLDebugLevel(int level);
@@ -528,7 +599,7 @@ EGLSurface eglCreateWindowSurface(  EGLDisplay dpy, EGLConfig config,
         if (surface != EGL_NO_SURFACE) {
             egl_surface_t* s = new egl_surface_t(dp.get(), config, window,
                     surface, cnx);
-            return s;
+            return s->getHandle();
         }
 
         // EGLSurface creation failed
@@ -552,7 +623,7 @@ EGLSurface eglCreatePixmapSurface(  EGLDisplay dpy, EGLConfig config,
         if (surface != EGL_NO_SURFACE) {
             egl_surface_t* s = new egl_surface_t(dp.get(), config, NULL,
                     surface, cnx);
-            return s;
+            return s->getHandle();
         }
     }
     return EGL_NO_SURFACE;
@@ -571,7 +642,7 @@ EGLSurface eglCreatePbufferSurface( EGLDisplay dpy, EGLConfig config,
         if (surface != EGL_NO_SURFACE) {
             egl_surface_t* s = new egl_surface_t(dp.get(), config, NULL,
                     surface, cnx);
-            return s;
+            return s->getHandle();
         }
     }
     return EGL_NO_SURFACE;
@@ -648,31 +719,33 @@ EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config,
             egl_context_t* const c = get_context(share_list);
             share_list = c->context;
         }
+        // figure out if it's a GLESv1 or GLESv2
+        int version = 0;
+        if (attrib_list) {
+            for (const EGLint* attr = attrib_list; *attr != EGL_NONE; attr += 2) {
+                if (attr[0] == EGL_CONTEXT_CLIENT_VERSION) {
+                    if (attr[1] == 1) {
+                        version = egl_connection_t::GLESv1_INDEX;
+                    } else if (attr[1] == 2 || attr[1] == 3) {
+                        version = egl_connection_t::GLESv2_INDEX;
+                    }
+                }
+            }
+        }
+        if (version == egl_connection_t::GLESv1_INDEX) {
+            // GLESv1_CM is only loaded once it is used
+            egl_init_gles1_driver();
+        }
         EGLContext context = cnx->egl.eglCreateContext(
                 dp->disp.dpy, config, share_list, attrib_list);
         if (context != EGL_NO_CONTEXT) {
-            // figure out if it's a GLESv1 or GLESv2
-            int version = 0;
-            if (attrib_list) {
-                while (*attrib_list != EGL_NONE) {
-                    GLint attr = *attrib_list++;
-                    GLint value = *attrib_list++;
-                    if (attr == EGL_CONTEXT_CLIENT_VERSION) {
-                        if (value == 1) {
-                            version = egl_connection_t::GLESv1_INDEX;
-                        } else if (value == 2 || value == 3) {
-                            version = egl_connection_t::GLESv2_INDEX;
-                        }
-                    }
-                };
-            }
             egl_context_t* c = new egl_context_t(dpy, context, config, cnx,
                     version);
 #if EGL_TRACE
             if (getEGLDebugLevel() > 0)
-                GLTrace_eglCreateContext(version, c);
+                GLTrace_eglCreateContext(version, c->getHandle());
 #endif
-            return c;
+            return c->getHandle();
         }
     }
     return EGL_NO_CONTEXT;
@@ -926,18 +999,29 @@ __eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
         return  NULL;
     }
 
+    // filtered names are never cached
+    const uint32_t hash = hashProcName(procname);
+    __eglMustCastToProperFunctionPointerType addr;
+    addr = findCachedProcAddress(procname, hash);
+    if (addr) return addr;
+
     if (FILTER_EXTENSIONS(procname)) {
         return NULL;
     }
 
-    __eglMustCastToProperFunctionPointerType addr;
     addr = findProcAddress(procname, sExtensionMap, NELEM(sExtensionMap));
-    if (addr) return addr;
-
-    addr = findBuiltinWrapper(procname);
-    if (addr) return addr;
+    if (!addr) {
+        addr = findBuiltinWrapper(procname);
+    }
+    if (addr) {
+        pthread_mutex_lock(&sExtensionMapMutex);
+        cacheProcAddressLocked(procname, hash, addr);
+        pthread_mutex_unlock(&sExtensionMapMutex);
+        return addr;
+    }
 
-    // this protects accesses to sGLExtentionMap and sGLExtentionSlot
+    // this protects accesses to sGLExtentionMap, sGLExtentionSlot and
+    // sProcCache
     pthread_mutex_lock(&sExtensionMapMutex);
 
         /*
@@ -993,6 +1077,10 @@ __eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
             }
         }
 
+        if (addr) {
+            cacheProcAddressLocked(procname, hash, addr);
+        }
+
     pthread_mutex_unlock(&sExtensionMapMutex);
     return addr;
 }
@@ -21,13 +21,19 @@
 #include "egldefs.h"
 
 #include <fcntl.h>
+#include <stdlib.h>
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <cutils/properties.h>
+
+#include <utils/SortedVector.h>
+
 #ifndef MAX_EGL_CACHE_ENTRY_SIZE
-#define MAX_EGL_CACHE_ENTRY_SIZE (16 * 1024);
+#define MAX_EGL_CACHE_ENTRY_SIZE (256 * 1024);
 #endif
 
 #ifndef MAX_EGL_CACHE_KEY_SIZE
@@ -35,20 +41,25 @@
 #endif
 
 #ifndef MAX_EGL_CACHE_SIZE
-#define MAX_EGL_CACHE_SIZE (64 * 1024);
+#define MAX_EGL_CACHE_SIZE (32 * 1024 * 1024);
 #endif
 
 // Cache size limits.
 static const size_t maxKeySize = MAX_EGL_CACHE_KEY_SIZE;
 static const size_t maxValueSize = MAX_EGL_CACHE_ENTRY_SIZE;
 static const size_t maxTotalSize = MAX_EGL_CACHE_SIZE;
+static const size_t maxShardSize = maxTotalSize / android::egl_cache_t::NUM_SHARDS;
+
+// Shard file header: magic and format version
+static const char* shardFileMagic = "EGL#";
+static const uint32_t shardFileVersion = 1;
+static const size_t shardFileHeaderSize = 8;
 
-// Cache file header
-static const char* cacheFileMagic = "EGL$";
-static const size_t cacheFileHeaderSize = 8;
+// A shard isn't compacted for less unused space than this.
+static const size_t minCompactionGain = 64 * 1024;
 
-// The time in seconds to wait before saving newly inserted cache entries.
-static const unsigned int deferredSaveDelay = 4;
+// The time in seconds to wait before compacting shards.
+static const unsigned int deferredCompactionDelay = 4;
 
 // ----------------------------------------------------------------------------
 namespace android {
@@ -56,6 +67,735 @@ namespace android {
 
 #define BC_EXT_STR "EGL_ANDROID_blob_cache"
 
+static uint32_t crc32c(const uint8_t* buf, size_t len, uint32_t r = 0) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        const uint32_t polyBits = 0x82F63B78;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int j = 0; j < 8; j++) {
+                c = (c & 1) ? (c >> 1) ^ polyBits : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+    for (size_t i = 0; i < len; i++) {
+        r = table[(r ^ buf[i]) & 0xff] ^ (r >> 8);
+    }
+    return r;
+}
+
+// FNV-1a hash of a key, used to pick its shard and to look it up.
+static uint32_t hashKey(const void* key, size_t keySize) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(key);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < keySize; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+//
+// egl_cache_shard_t definition
+//
+// A shard is a file of key/value records which are only ever appended to,
+// mapped in memory so that getBlob only pages in the records it reads.  A
+// record replaced by a newer one for the same key is left in place until the
+// shard is compacted, which rewrites the file with the live records only,
+// evicting the least recently used ones if more room is needed.  Without a
+// file name the records are kept in anonymous memory instead.  A read-only
+// shard maps a file written by another process and is never modified.
+//
+// Several processes may use the same file.  Records are appended at the end
+// of the file with an exclusive flock held, and each process indexes the
+// records the others appended before its own.  The file is only ever cut
+// short under that lock, past the records anyone could have indexed, and
+// compaction replaces it with a new file rather than rewriting it, so that
+// the pages other processes have mapped stay valid.
+//
+class egl_cache_shard_t {
+public:
+    // The outcome of write().
+    enum WriteResult {
+        WRITE_OK,
+        WRITE_FAILED,
+        // The file was replaced by another process, remap the shard.
+        WRITE_REPLACED,
+        // The record doesn't fit, compact the shard.
+        WRITE_FULL,
+    };
+
+    egl_cache_shard_t(const String8& filename, bool readOnly = false);
+    ~egl_cache_shard_t();
+
+    // isFile returns true if the shard is stored in a file, whose records
+    // are appended with write() rather than set().
+    bool isFile() const { return mFilename.length() > 0; }
+
+    // set stores a key/value pair in a shard kept in anonymous memory.
+    void set(uint32_t hash, const void* key, size_t keySize, const void* value,
+            size_t valueSize);
+    size_t get(uint32_t hash, const void* key, size_t keySize, void* value,
+            size_t valueSize);
+
+    // contains returns true, and counts it as a use, if the shard already
+    // holds this key/value pair.
+    bool contains(uint32_t hash, const void* key, size_t keySize,
+            const void* value, size_t valueSize);
+
+    // map maps the shard file, creating it if needed, and indexes its
+    // records.  It returns false if the shard can't be used.
+    bool map();
+
+    // remap maps the shard file again, after another process replaced it.
+    bool remap();
+
+    // write appends a record made by makeRecord to the shard file and
+    // returns the end of its file, up to which catchUp must then index the
+    // records.  It leaves the index alone so that it can be called without
+    // the cache mutex, but only on a mapped shard, and not concurrently with
+    // anything that maps, compacts or unmaps it.
+    WriteResult write(const uint8_t* record, size_t size, size_t* outEnd);
+
+    // catchUp indexes the records appended up to 'end', by this process or
+    // others.
+    void catchUp(size_t end);
+
+    // makeRecord returns a new[] allocated record for a key/value pair, and
+    // its size.
+    static uint8_t* makeRecord(uint32_t hash, const void* key, size_t keySize,
+            const void* value, size_t valueSize, size_t* outSize);
+
+    // getFromRecord copies the value of a record made by makeRecord if it
+    // has the given key, and returns the value size, or -1 if it doesn't.
+    static ssize_t getFromRecord(const uint8_t* record, uint32_t hash,
+            const void* key, size_t keySize, void* value, size_t valueSize);
+
+    // trim releases the pages of a file shard, which are read back from
+    // the file when needed.  Those of an anonymous shard are its only copy.
+    void trim();
+
+    // needsCompaction returns true if replaced or corrupt records take up
+    // more than half of the shard.
+    bool needsCompaction() const;
+
+    // compact rewrites the shard with the live records only, evicting the
+    // least recently used ones until at least 'reserve' more bytes fit.
+    void compact(size_t reserve);
+
+private:
+    // The header of a record, followed by the key, the value and up to three
+    // bytes of padding.  The CRC covers the key and the value, and is only
+    // checked the first time the record is read.
+    struct RecordHeader {
+        uint32_t hash;
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint32_t crc;
+    };
+
+    struct Entry {
+        uint32_t hash;
+        uint32_t offset;
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint64_t lastUse;
+        bool verified;
+        bool operator < (const Entry& rhs) const {
+            return (hash == rhs.hash) ? (offset < rhs.offset) : (hash < rhs.hash);
+        }
+    };
+
+    static size_t recordSize(size_t keySize, size_t valueSize) {
+        return (sizeof(RecordHeader) + keySize + valueSize + 3) & ~3;
+    }
+
+    // indexRecords indexes the records from mSize up to 'end', and returns
+    // the offset at which it stopped, at 'end' unless the file is torn.
+    size_t indexRecords(size_t end);
+    // validEnd returns the end of the last whole record before 'end',
+    // starting from mSize, without indexing them.
+    size_t validEnd(size_t end) const;
+    void unmap();
+
+    // lock flocks the shard file, retrying if interrupted.
+    bool lock(int operation);
+    // isReplaced returns true if the shard file was replaced or removed
+    // since it was opened.
+    bool isReplaced() const;
+
+    // find returns the index in mEntries of the entry for a key, or -1.
+    ssize_t find(uint32_t hash, const void* key, size_t keySize) const;
+    void removeEntry(size_t index);
+
+    String8 mFilename;
+    bool mReadOnly;
+    int mFd;
+    uint8_t* mBase;
+    bool mMapped;
+    // mSize is the number of bytes in use, including the file header.
+    size_t mSize;
+    // mDeadSize is the number of bytes taken by replaced or corrupt records.
+    size_t mDeadSize;
+    // mClock is incremented each time an entry is used, for LRU eviction.
+    uint64_t mClock;
+    SortedVector<Entry> mEntries;
+};
+
+egl_cache_shard_t::egl_cache_shard_t(const String8& filename, bool readOnly) :
+        mFilename(filename), mReadOnly(readOnly), mFd(-1), mBase(NULL), mMapped(false), mSize(0),
+        mDeadSize(0), mClock(0) {
+}
+
+egl_cache_shard_t::~egl_cache_shard_t() {
+    unmap();
+}
+
+bool egl_cache_shard_t::map() {
+    if (mMapped) {
+        return mBase != NULL;
+    }
+    mMapped = true;
+
+    if (mFilename.length() == 0) {
+        void* base = mmap(NULL, maxShardSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            ALOGE("error mapping cache shard: %s (%d)", strerror(errno), errno);
+            return false;
+        }
+        mBase = reinterpret_cast<uint8_t*>(base);
+        mSize = shardFileHeaderSize;
+        return true;
+    }
+
+    const char* fname = mFilename.string();
+    if (mReadOnly) {
+        mFd = open(fname, O_RDONLY, 0);
+    } else {
+        mFd = open(fname, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+    }
+    if (mFd == -1) {
+        if (!mReadOnly || errno != ENOENT) {
+            ALOGE("error opening cache file %s: %s (%d)", fname,
+                    strerror(errno), errno);
+        }
+        return false;
+    }
+
+    // Readers only need the file not to be cut short while they index it,
+    // writers may fix its header or drop a torn record.
+    if (!lock(mReadOnly ? LOCK_SH : LOCK_EX)) {
+        unmap();
+        return false;
+    }
+
+    struct stat statBuf;
+    if (fstat(mFd, &statBuf) == -1) {
+        ALOGE("error stat'ing cache file: %s (%d)", strerror(errno), errno);
+        unmap();
+        return false;
+    }
+
+    // The whole shard is mapped up front, pages past the end of the file
+    // become readable as records are appended.
+    void* base = mmap(NULL, maxShardSize, PROT_READ, MAP_SHARED, mFd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("error mmaping cache file: %s (%d)", strerror(errno), errno);
+        unmap();
+        return false;
+    }
+    mBase = reinterpret_cast<uint8_t*>(base);
+
+    size_t fileSize = statBuf.st_size;
+    uint32_t version = 0;
+    if (fileSize >= shardFileHeaderSize) {
+        memcpy(&version, mBase + 4, sizeof(version));
+    }
+    if (fileSize < shardFileHeaderSize || fileSize > maxShardSize ||
+            memcmp(mBase, shardFileMagic, 4) != 0 || version != shardFileVersion) {
+        if (mReadOnly) {
+            ALOGE("shared cache file %s has bad mojo", fname);
+            unmap();
+            return false;
+        }
+        if (fileSize > 0) {
+            ALOGW("discarding cache file %s with bad mojo", fname);
+        }
+        uint8_t header[shardFileHeaderSize];
+        memcpy(header, shardFileMagic, 4);
+        memcpy(header + 4, &shardFileVersion, sizeof(shardFileVersion));
+        if (ftruncate(mFd, 0) == -1 ||
+                pwrite(mFd, header, sizeof(header), 0) != ssize_t(sizeof(header))) {
+            ALOGE("error writing cache file %s: %s (%d)", fname,
+                    strerror(errno), errno);
+            unmap();
+            return false;
+        }
+        fileSize = shardFileHeaderSize;
+    }
+
+    mSize = shardFileHeaderSize;
+    const size_t offset = indexRecords(fileSize);
+    if (offset != fileSize && !mReadOnly) {
+        // The end of the file was torn by a crash, drop it.  Nobody could
+        // index it, and nobody is appending to the file while we hold the
+        // lock.
+        ALOGW("truncating cache file %s from %zu to %zu bytes",
+                mFilename.string(), fileSize, offset);
+        ftruncate(mFd, offset);
+    }
+    lock(LOCK_UN);
+    return true;
+}
+
+bool egl_cache_shard_t::remap() {
+    unmap();
+    mMapped = false;
+    return map();
+}
+
+bool egl_cache_shard_t::lock(int operation) {
+    while (flock(mFd, operation) == -1) {
+        if (errno != EINTR) {
+            ALOGE("error locking cache file %s: %s (%d)", mFilename.string(),
+                    strerror(errno), errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool egl_cache_shard_t::isReplaced() const {
+    struct stat fileStat, fdStat;
+    if (stat(mFilename.string(), &fileStat) == -1 ||
+            fstat(mFd, &fdStat) == -1) {
+        return true;
+    }
+    return fileStat.st_dev != fdStat.st_dev || fileStat.st_ino != fdStat.st_ino;
+}
+
+size_t egl_cache_shard_t::validEnd(size_t end) const {
+    size_t offset = mSize;
+    while (offset + sizeof(RecordHeader) <= end) {
+        RecordHeader header;
+        memcpy(&header, mBase + offset, sizeof(header));
+        if (header.keySize == 0 || header.keySize > maxKeySize ||
+                header.valueSize > maxValueSize ||
+                offset + recordSize(header.keySize, header.valueSize) > end) {
+            break;
+        }
+        offset += recordSize(header.keySize, header.valueSize);
+    }
+    return offset;
+}
+
+size_t egl_cache_shard_t::indexRecords(size_t end) {
+    // Only the record headers are read here, the keys are compared and the
+    // values checked when they are looked up.
+    size_t offset = mSize;
+    while (offset + sizeof(RecordHeader) <= end) {
+        RecordHeader header;
+        memcpy(&header, mBase + offset, sizeof(header));
+        if (header.keySize == 0 || header.keySize > maxKeySize ||
+                header.valueSize > maxValueSize ||
+                offset + recordSize(header.keySize, header.valueSize) > end) {
+            break;
+        }
+        // A later record for the same key replaces the earlier one.
+        ssize_t index = find(header.hash, mBase + offset + sizeof(RecordHeader),
+                header.keySize);
+        if (index >= 0) {
+            removeEntry(index);
+        }
+        Entry entry;
+        entry.hash = header.hash;
+        entry.offset = offset;
+        entry.keySize = header.keySize;
+        entry.valueSize = header.valueSize;
+        // Records further in the file were written more recently.
+        entry.lastUse = ++mClock;
+        entry.verified = false;
+        mEntries.add(entry);
+        offset += recordSize(header.keySize, header.valueSize);
+    }
+    mSize = offset;
+    return offset;
+}
+
+void egl_cache_shard_t::catchUp(size_t end) {
+    if (mBase != NULL && end > mSize && end <= maxShardSize) {
+        indexRecords(end);
+    }
+}
+
+void egl_cache_shard_t::unmap() {
+    if (mBase != NULL) {
+        munmap(mBase, maxShardSize);
+        mBase = NULL;
+    }
+    if (mFd != -1) {
+        close(mFd);
+        mFd = -1;
+    }
+    mEntries.clear();
+    mSize = 0;
+    mDeadSize = 0;
+}
+
+ssize_t egl_cache_shard_t::find(uint32_t hash, const void* key,
+        size_t keySize) const {
+    // Find the first entry with this hash, then compare the keys of all of
+    // them.
+    size_t lo = 0, hi = mEntries.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (mEntries[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (size_t i = lo; i < mEntries.size() && mEntries[i].hash == hash; i++) {
+        const Entry& entry(mEntries[i]);
+        if (entry.keySize == keySize &&
+                memcmp(mBase + entry.offset + sizeof(RecordHeader), key,
+                        keySize) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void egl_cache_shard_t::removeEntry(size_t index) {
+    const Entry& entry(mEntries[index]);
+    mDeadSize += recordSize(entry.keySize, entry.valueSize);
+    mEntries.removeAt(index);
+}
+
+egl_cache_shard_t::WriteResult egl_cache_shard_t::write(
+        const uint8_t* record, size_t size, size_t* outEnd) {
+    if (mReadOnly || mFd == -1 || !lock(LOCK_EX)) {
+        return WRITE_FAILED;
+    }
+    if (isReplaced()) {
+        lock(LOCK_UN);
+        return WRITE_REPLACED;
+    }
+
+    // Other processes may have appended records since we last looked, or
+    // crashed while doing so.  Append after the last whole one.
+    struct stat statBuf;
+    if (fstat(mFd, &statBuf) == -1) {
+        ALOGE("error stat'ing cache file: %s (%d)", strerror(errno), errno);
+        lock(LOCK_UN);
+        return WRITE_FAILED;
+    }
+    size_t fileSize = statBuf.st_size;
+    if (fileSize < mSize) {
+        // Cut short by someone who doesn't play by the rules, start over.
+        lock(LOCK_UN);
+        return WRITE_REPLACED;
+    }
+    if (fileSize > maxShardSize) {
+        fileSize = maxShardSize;
+    }
+    const size_t end = validEnd(fileSize);
+    if (end != size_t(statBuf.st_size)) {
+        ALOGW("truncating cache file %s from %zu to %zu bytes",
+                mFilename.string(), size_t(statBuf.st_size), end);
+        ftruncate(mFd, end);
+    }
+    if (end + size > maxShardSize) {
+        lock(LOCK_UN);
+        return WRITE_FULL;
+    }
+
+    WriteResult result = WRITE_OK;
+    if (pwrite(mFd, record, size, end) != ssize_t(size)) {
+        ALOGE("error writing cache file %s: %s (%d)", mFilename.string(),
+                strerror(errno), errno);
+        // Drop whatever part of the record made it to the file.
+        ftruncate(mFd, end);
+        result = WRITE_FAILED;
+    }
+    lock(LOCK_UN);
+    *outEnd = result == WRITE_OK ? end + size : end;
+    return result;
+}
+
+uint8_t* egl_cache_shard_t::makeRecord(uint32_t hash, const void* key,
+        size_t keySize, const void* value, size_t valueSize, size_t* outSize) {
+    const size_t size = recordSize(keySize, valueSize);
+    uint8_t* record = new uint8_t[size];
+    RecordHeader header;
+    header.hash = hash;
+    header.keySize = keySize;
+    header.valueSize = valueSize;
+    header.crc = crc32c(reinterpret_cast<const uint8_t*>(value), valueSize,
+            crc32c(reinterpret_cast<const uint8_t*>(key), keySize));
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), key, keySize);
+    memcpy(record + sizeof(header) + keySize, value, valueSize);
+    memset(record + sizeof(header) + keySize + valueSize, 0,
+            size - (sizeof(header) + keySize + valueSize));
+    *outSize = size;
+    return record;
+}
+
+ssize_t egl_cache_shard_t::getFromRecord(const uint8_t* record, uint32_t hash,
+        const void* key, size_t keySize, void* value, size_t valueSize) {
+    RecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    if (header.hash != hash || header.keySize != keySize ||
+            memcmp(record + sizeof(header), key, keySize) != 0) {
+        return -1;
+    }
+    if (header.valueSize <= valueSize) {
+        memcpy(value, record + sizeof(header) + keySize, header.valueSize);
+    }
+    return header.valueSize;
+}
+
+bool egl_cache_shard_t::contains(uint32_t hash, const void* key,
+        size_t keySize, const void* value, size_t valueSize) {
+    if (!map()) {
+        return false;
+    }
+    ssize_t index = find(hash, key, keySize);
+    if (index < 0) {
+        return false;
+    }
+    Entry& entry(mEntries.editItemAt(index));
+    if (entry.valueSize != valueSize ||
+            memcmp(mBase + entry.offset + sizeof(RecordHeader) + keySize,
+                    value, valueSize) != 0) {
+        return false;
+    }
+    entry.lastUse = ++mClock;
+    return true;
+}
+
+void egl_cache_shard_t::set(uint32_t hash, const void* key, size_t keySize,
+        const void* value, size_t valueSize) {
+    if (isFile() || keySize == 0 || keySize > maxKeySize ||
+            valueSize > maxValueSize) {
+        return;
+    }
+    if (!map() || contains(hash, key, keySize, value, valueSize)) {
+        return;
+    }
+
+    ssize_t index = find(hash, key, keySize);
+    if (index >= 0) {
+        removeEntry(index);
+    }
+
+    size_t size = recordSize(keySize, valueSize);
+    if (mSize + size > maxShardSize) {
+        compact(size);
+        if (mSize + size > maxShardSize) {
+            return;
+        }
+    }
+
+    uint8_t* record = makeRecord(hash, key, keySize, value, valueSize, &size);
+    memcpy(mBase + mSize, record, size);
+    delete [] record;
+
+    Entry entry;
+    entry.hash = hash;
+    entry.offset = mSize;
+    entry.keySize = keySize;
+    entry.valueSize = valueSize;
+    entry.lastUse = ++mClock;
+    entry.verified = true;
+    mEntries.add(entry);
+    mSize += size;
+}
+
+size_t egl_cache_shard_t::get(uint32_t hash, const void* key, size_t keySize,
+        void* value, size_t valueSize) {
+    if (!map()) {
+        return 0;
+    }
+    ssize_t index = find(hash, key, keySize);
+    if (index < 0) {
+        return 0;
+    }
+    Entry& entry(mEntries.editItemAt(index));
+    const uint8_t* data = mBase + entry.offset + sizeof(RecordHeader);
+    if (!entry.verified) {
+        RecordHeader header;
+        memcpy(&header, mBase + entry.offset, sizeof(header));
+        if (crc32c(data, entry.keySize + entry.valueSize) != header.crc) {
+            ALOGE("cache entry failed CRC check");
+            removeEntry(index);
+            return 0;
+        }
+        entry.verified = true;
+    }
+    entry.lastUse = ++mClock;
+    if (entry.valueSize <= valueSize) {
+        memcpy(value, data + entry.keySize, entry.valueSize);
+    }
+    return entry.valueSize;
+}
+
+void egl_cache_shard_t::trim() {
+    if (mBase != NULL && mFd != -1) {
+        madvise(mBase, maxShardSize, MADV_DONTNEED);
+    }
+}
+
+bool egl_cache_shard_t::needsCompaction() const {
+    return !mReadOnly && mDeadSize >= minCompactionGain && mDeadSize * 2 > mSize;
+}
+
+static int compareLastUse(const void* lhs, const void* rhs) {
+    uint64_t l = *reinterpret_cast<const uint64_t*>(lhs);
+    uint64_t r = *reinterpret_cast<const uint64_t*>(rhs);
+    return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+void egl_cache_shard_t::compact(size_t reserve) {
+    if (mBase == NULL || mReadOnly) {
+        return;
+    }
+
+    if (mFd != -1) {
+        // Keep other processes from appending records that the new file
+        // wouldn't have, and compact the records they already appended too.
+        if (!lock(LOCK_EX)) {
+            return;
+        }
+        struct stat statBuf;
+        if (isReplaced() || fstat(mFd, &statBuf) == -1 ||
+                size_t(statBuf.st_size) < mSize) {
+            // Someone else compacted it already.
+            remap();
+            return;
+        }
+        indexRecords(size_t(statBuf.st_size) < maxShardSize ?
+                size_t(statBuf.st_size) : maxShardSize);
+    }
+
+    // Order the entries from the least to the most recently used, so that
+    // the oldest ones are evicted first and the file keeps the order across
+    // program invocations.
+    const size_t count = mEntries.size();
+    struct UseOrder {
+        uint64_t lastUse;
+        size_t index;
+    };
+    UseOrder* order = new UseOrder[count];
+    size_t liveSize = 0;
+    for (size_t i = 0; i < count; i++) {
+        order[i].lastUse = mEntries[i].lastUse;
+        order[i].index = i;
+        liveSize += recordSize(mEntries[i].keySize, mEntries[i].valueSize);
+    }
+    qsort(order, count, sizeof(UseOrder), compareLastUse);
+
+    // Evict down to three quarters of the shard when making room, so that
+    // the next few appends don't need another compaction.
+    const size_t target = reserve ? (maxShardSize * 3) / 4 : maxShardSize;
+    size_t first = 0;
+    while (first < count &&
+            shardFileHeaderSize + liveSize + reserve > target) {
+        const Entry& entry(mEntries[order[first].index]);
+        liveSize -= recordSize(entry.keySize, entry.valueSize);
+        first++;
+    }
+
+    uint8_t* newBase = NULL;
+    int newFd = -1;
+    String8 tmpName;
+    if (mFd == -1) {
+        void* base = mmap(NULL, maxShardSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            ALOGE("error mapping cache shard: %s (%d)", strerror(errno), errno);
+            delete [] order;
+            return;
+        }
+        newBase = reinterpret_cast<uint8_t*>(base);
+    } else {
+        // Write the live records to a new file and move it over the old one,
+        // so that a crash leaves either of them, and the processes which
+        // mapped the old one can still read it.
+        tmpName = String8::format("%s.%d.tmp", mFilename.string(), getpid());
+        newFd = open(tmpName.string(), O_CREAT | O_TRUNC | O_RDWR,
+                S_IRUSR | S_IWUSR);
+        if (newFd == -1) {
+            ALOGE("error creating cache file %s: %s (%d)", tmpName.string(),
+                    strerror(errno), errno);
+            lock(LOCK_UN);
+            delete [] order;
+            return;
+        }
+    }
+
+    SortedVector<Entry> entries;
+    size_t offset = shardFileHeaderSize;
+    bool ok = true;
+    uint8_t header[shardFileHeaderSize];
+    memcpy(header, shardFileMagic, 4);
+    memcpy(header + 4, &shardFileVersion, sizeof(shardFileVersion));
+    if (newBase != NULL) {
+        memcpy(newBase, header, sizeof(header));
+    } else {
+        ok = write(newFd, header, sizeof(header)) == ssize_t(sizeof(header));
+    }
+    for (size_t i = first; ok && i < count; i++) {
+        Entry entry(mEntries[order[i].index]);
+        const size_t size = recordSize(entry.keySize, entry.valueSize);
+        const uint8_t* record = mBase + entry.offset;
+        if (newBase != NULL) {
+            memcpy(newBase + offset, record, size);
+        } else {
+            ok = write(newFd, record, size) == ssize_t(size);
+        }
+        entry.offset = offset;
+        entries.add(entry);
+        offset += size;
+    }
+    delete [] order;
+
+    if (newBase != NULL) {
+        munmap(mBase, maxShardSize);
+        mBase = newBase;
+    } else {
+        void* base = MAP_FAILED;
+        if (ok) {
+            base = mmap(NULL, maxShardSize, PROT_READ, MAP_SHARED, newFd, 0);
+        }
+        if (!ok || base == MAP_FAILED ||
+                rename(tmpName.string(), mFilename.string()) == -1) {
+            ALOGE("error compacting cache file %s: %s (%d)",
+                    mFilename.string(), strerror(errno), errno);
+            if (base != MAP_FAILED) {
+                munmap(base, maxShardSize);
+            }
+            close(newFd);
+            unlink(tmpName.string());
+            lock(LOCK_UN);
+            return;
+        }
+        // Closing the old file releases its lock, the processes waiting
+        // on it then find out it was replaced.
+        munmap(mBase, maxShardSize);
+        close(mFd);
+        mBase = reinterpret_cast<uint8_t*>(base);
+        mFd = newFd;
+    }
+    mEntries = entries;
+    mSize = offset;
+    mDeadSize = 0;
+}
+
 //
 // Callback functions passed to EGL.
 //
@@ -74,7 +814,10 @@ static EGLsizeiANDROID getBlob(const void* key, EGLsizeiANDROID keySize,
 //
 egl_cache_t::egl_cache_t() :
         mInitialized(false),
-        mBlobCache(NULL) {
+        mCompactPending(false),
+        mWriterRunning(false) {
+    memset(mShards, 0, sizeof(mShards));
+    memset(mSharedShards, 0, sizeof(mSharedShards));
 }
 
 egl_cache_t::~egl_cache_t() {
@@ -121,13 +864,57 @@ void egl_cache_t::initialize(egl_display_t *display) {
         }
     }
 
+    if (mSharedFilename.length() == 0) {
+        char filename[PROPERTY_VALUE_MAX];
+        if (property_get("ro.egl.shared_blob_cache", filename, NULL) > 0) {
+            mSharedFilename = filename;
+        }
+    }
+
     mInitialized = true;
 }
 
 void egl_cache_t::terminate() {
     Mutex::Autolock lock(mMutex);
-    saveBlobCacheLocked();
-    mBlobCache = NULL;
+    while (mWriterRunning) {
+        mWriterDone.wait(mMutex);
+    }
+    closeShardsLocked();
+}
+
+void egl_cache_t::trimMemory() {
+    Mutex::Autolock lock(mMutex);
+    for (size_t i = 0; i < NUM_SHARDS; i++) {
+        if (mShards[i] != NULL) {
+            mShards[i]->trim();
+        }
+        if (mSharedShards[i] != NULL) {
+            mSharedShards[i]->trim();
+        }
+    }
+}
+
+void egl_cache_t::prepareFork() {
+    mWriteMutex.lock();
+    mMutex.lock();
+}
+
+void egl_cache_t::parentFork() {
+    mMutex.unlock();
+    mWriteMutex.unlock();
+}
+
+void egl_cache_t::childFork() {
+    // The child uses its own cache, if any.  The writer and deferred
+    // compaction threads only exist in the parent, which writes its own
+    // pending records.
+    clearPendingWritesLocked();
+    mWriterRunning = false;
+    closeShardsLocked();
+    mFilename.clear();
+    mCompactPending = false;
+    mMutex.unlock();
+    mWriteMutex.unlock();
 }
 
 void egl_cache_t::setBlob(const void* key, EGLsizeiANDROID keySize,
@@ -140,35 +927,122 @@ void egl_cache_t::setBlob(const void* key, EGLsizeiANDROID keySize,
     }
 
     if (mInitialized) {
-        sp<BlobCache> bc = getBlobCacheLocked();
-        bc->set(key, keySize, value, valueSize);
+        if (keySize == 0 || size_t(keySize) > maxKeySize ||
+                size_t(valueSize) > maxValueSize) {
+            return;
+        }
+        const uint32_t hash = hashKey(key, keySize);
+        egl_cache_shard_t* shard = getShardLocked(hash);
+        if (!shard->isFile()) {
+            shard->set(hash, key, keySize, value, valueSize);
+            scheduleCompactionLocked(shard);
+            return;
+        }
+
+        // Leave the disk I/O to the writer thread.  A pending record for
+        // the same key stays until it's written, getBlob finds the newer
+        // one first.
+        if (shard->contains(hash, key, keySize, value, valueSize)) {
+            return;
+        }
+        PendingWrite pending;
+        pending.hash = hash;
+        pending.record = egl_cache_shard_t::makeRecord(hash, key, keySize,
+                value, valueSize, &pending.size);
+        mPendingWrites.push(pending);
 
-        if (!mSavePending) {
-            class DeferredSaveThread : public Thread {
+        if (!mWriterRunning) {
+            class WriterThread : public Thread {
             public:
-                DeferredSaveThread() : Thread(false) {}
+                WriterThread() : Thread(false) {}
 
                 virtual bool threadLoop() {
-                    sleep(deferredSaveDelay);
-                    egl_cache_t* c = egl_cache_t::get();
-                    Mutex::Autolock lock(c->mMutex);
-                    if (c->mInitialized) {
-                        c->saveBlobCacheLocked();
-                    }
-                    c->mSavePending = false;
+                    egl_cache_t::get()->writePendingBlobs();
                     return false;
                 }
             };
 
             // The thread will hold a strong ref to itself until it has finished
             // running, so there's no need to keep a ref around.
-            sp<Thread> deferredSaveThread(new DeferredSaveThread());
-            mSavePending = true;
-            deferredSaveThread->run();
+            sp<Thread> writerThread(new WriterThread());
+            mWriterRunning = true;
+            writerThread->run();
         }
     }
 }
 
+void egl_cache_t::scheduleCompactionLocked(egl_cache_shard_t* shard) {
+    if (shard->needsCompaction() && !mCompactPending) {
+        class DeferredCompactionThread : public Thread {
+        public:
+            DeferredCompactionThread() : Thread(false) {}
+
+            virtual bool threadLoop() {
+                sleep(deferredCompactionDelay);
+                egl_cache_t* c = egl_cache_t::get();
+                Mutex::Autolock writeLock(c->mWriteMutex);
+                Mutex::Autolock lock(c->mMutex);
+                if (c->mInitialized) {
+                    c->compactShardsLocked();
+                }
+                c->mCompactPending = false;
+                return false;
+            }
+        };
+
+        // The thread will hold a strong ref to itself until it has finished
+        // running, so there's no need to keep a ref around.
+        sp<Thread> deferredCompactionThread(new DeferredCompactionThread());
+        mCompactPending = true;
+        deferredCompactionThread->run();
+    }
+}
+
+void egl_cache_t::writePendingBlobs() {
+    Mutex::Autolock writeLock(mWriteMutex);
+    mMutex.lock();
+    while (!mPendingWrites.isEmpty()) {
+        // The record stays pending until it's indexed, so that getBlob
+        // always finds it.  Only this thread removes pending records.
+        const PendingWrite pending(mPendingWrites[0]);
+        egl_cache_shard_t* shard = getShardLocked(pending.hash);
+        bool mapped = shard->map();
+
+        // A replaced or full file is dealt with and the write retried once.
+        for (int attempt = 0; mapped && attempt < 2; attempt++) {
+            size_t end = 0;
+            mMutex.unlock();
+            egl_cache_shard_t::WriteResult result = shard->write(
+                    pending.record, pending.size, &end);
+            mMutex.lock();
+            if (result == egl_cache_shard_t::WRITE_OK) {
+                shard->catchUp(end);
+                scheduleCompactionLocked(shard);
+                break;
+            } else if (result == egl_cache_shard_t::WRITE_REPLACED) {
+                mapped = shard->remap();
+            } else if (result == egl_cache_shard_t::WRITE_FULL) {
+                shard->compact(pending.size);
+            } else {
+                break;
+            }
+        }
+
+        mPendingWrites.removeAt(0);
+        delete [] pending.record;
+    }
+    mWriterRunning = false;
+    mWriterDone.broadcast();
+    mMutex.unlock();
+}
+
+void egl_cache_t::clearPendingWritesLocked() {
+    for (size_t i = 0; i < mPendingWrites.size(); i++) {
+        delete [] mPendingWrites[i].record;
+    }
+    mPendingWrites.clear();
+}
+
 EGLsizeiANDROID egl_cache_t::getBlob(const void* key, EGLsizeiANDROID keySize,
         void* value, EGLsizeiANDROID valueSize) {
     Mutex::Autolock lock(mMutex);
@@ -179,8 +1053,24 @@ EGLsizeiANDROID egl_cache_t::getBlob(const void* key, EGLsizeiANDROID keySize,
     }
 
     if (mInitialized) {
-        sp<BlobCache> bc = getBlobCacheLocked();
-        return bc->get(key, keySize, value, valueSize);
+        const uint32_t hash = hashKey(key, keySize);
+        for (size_t i = mPendingWrites.size(); i > 0; i--) {
+            ssize_t size = egl_cache_shard_t::getFromRecord(
+                    mPendingWrites[i-1].record, hash, key, keySize, value,
+                    valueSize);
+            if (size >= 0) {
+                return size;
+            }
+        }
+        egl_cache_shard_t* shared = getSharedShardLocked(hash);
+        if (shared != NULL) {
+            EGLsizeiANDROID size = shared->get(hash, key, keySize, value,
+                    valueSize);
+            if (size > 0) {
+                return size;
+            }
+        }
+        return getShardLocked(hash)->get(hash, key, keySize, value, valueSize);
     }
     return 0;
 }
@@ -190,161 +1080,53 @@ void egl_cache_t::setCacheFilename(const char* filename) {
     mFilename = filename;
 }
 
-sp<BlobCache> egl_cache_t::getBlobCacheLocked() {
-    if (mBlobCache == NULL) {
-        mBlobCache = new BlobCache(maxKeySize, maxValueSize, maxTotalSize);
-        loadBlobCacheLocked();
-    }
-    return mBlobCache;
+void egl_cache_t::setSharedCacheFilename(const char* filename) {
+    Mutex::Autolock lock(mMutex);
+    mSharedFilename = filename;
 }
 
-static uint32_t crc32c(const uint8_t* buf, size_t len) {
-    const uint32_t polyBits = 0x82F63B78;
-    uint32_t r = 0;
-    for (size_t i = 0; i < len; i++) {
-        r ^= buf[i];
-        for (int j = 0; j < 8; j++) {
-            if (r & 1) {
-                r = (r >> 1) ^ polyBits;
-            } else {
-                r >>= 1;
-            }
+egl_cache_shard_t* egl_cache_t::getShardLocked(uint32_t keyHash) {
+    const size_t index = keyHash % NUM_SHARDS;
+    if (mShards[index] == NULL) {
+        String8 filename;
+        if (mFilename.length() > 0) {
+            filename = String8::format("%s.%zu", mFilename.string(), index);
+            // The file the whole cache used to be saved to isn't read
+            // anymore.
+            unlink(mFilename.string());
         }
+        mShards[index] = new egl_cache_shard_t(filename);
     }
-    return r;
+    return mShards[index];
 }
 
-void egl_cache_t::saveBlobCacheLocked() {
-    if (mFilename.length() > 0 && mBlobCache != NULL) {
-        size_t cacheSize = mBlobCache->getFlattenedSize();
-        size_t headerSize = cacheFileHeaderSize;
-        const char* fname = mFilename.string();
-
-        // Try to create the file with no permissions so we can write it
-        // without anyone trying to read it.
-        int fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
-        if (fd == -1) {
-            if (errno == EEXIST) {
-                // The file exists, delete it and try again.
-                if (unlink(fname) == -1) {
-                    // No point in retrying if the unlink failed.
-                    ALOGE("error unlinking cache file %s: %s (%d)", fname,
-                            strerror(errno), errno);
-                    return;
-                }
-                // Retry now that we've unlinked the file.
-                fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
-            }
-            if (fd == -1) {
-                ALOGE("error creating cache file %s: %s (%d)", fname,
-                        strerror(errno), errno);
-                return;
-            }
-        }
-
-        size_t fileSize = headerSize + cacheSize;
-
-        uint8_t* buf = new uint8_t [fileSize];
-        if (!buf) {
-            ALOGE("error allocating buffer for cache contents: %s (%d)",
-                    strerror(errno), errno);
-            close(fd);
-            unlink(fname);
-            return;
-        }
-
-        status_t err = mBlobCache->flatten(buf + headerSize, cacheSize);
-        if (err != OK) {
-            ALOGE("error writing cache contents: %s (%d)", strerror(-err),
-                    -err);
-            delete [] buf;
-            close(fd);
-            unlink(fname);
-            return;
-        }
-
-        // Write the file magic and CRC
-        memcpy(buf, cacheFileMagic, 4);
-        uint32_t* crc = reinterpret_cast<uint32_t*>(buf + 4);
-        *crc = crc32c(buf + headerSize, cacheSize);
-
-        if (write(fd, buf, fileSize) == -1) {
-            ALOGE("error writing cache file: %s (%d)", strerror(errno),
-                    errno);
-            delete [] buf;
-            close(fd);
-            unlink(fname);
-            return;
-        }
-
-        delete [] buf;
-        fchmod(fd, S_IRUSR);
-        close(fd);
+egl_cache_shard_t* egl_cache_t::getSharedShardLocked(uint32_t keyHash) {
+    if (mSharedFilename.length() == 0) {
+        return NULL;
+    }
+    const size_t index = keyHash % NUM_SHARDS;
+    if (mSharedShards[index] == NULL) {
+        mSharedShards[index] = new egl_cache_shard_t(
+                String8::format("%s.%zu", mSharedFilename.string(), index),
+                true);
     }
+    return mSharedShards[index];
 }
 
-void egl_cache_t::loadBlobCacheLocked() {
-    if (mFilename.length() > 0) {
-        size_t headerSize = cacheFileHeaderSize;
-
-        int fd = open(mFilename.string(), O_RDONLY, 0);
-        if (fd == -1) {
-            if (errno != ENOENT) {
-                ALOGE("error opening cache file %s: %s (%d)", mFilename.string(),
-                        strerror(errno), errno);
-            }
-            return;
-        }
-
-        struct stat statBuf;
-        if (fstat(fd, &statBuf) == -1) {
-            ALOGE("error stat'ing cache file: %s (%d)", strerror(errno), errno);
-            close(fd);
-            return;
-        }
-
-        // Sanity check the size before trying to mmap it.
-        size_t fileSize = statBuf.st_size;
-        if (fileSize > maxTotalSize * 2) {
-            ALOGE("cache file is too large: %#llx", statBuf.st_size);
-            close(fd);
-            return;
-        }
-
-        uint8_t* buf = reinterpret_cast<uint8_t*>(mmap(NULL, fileSize,
-                PROT_READ, MAP_PRIVATE, fd, 0));
-        if (buf == MAP_FAILED) {
-            ALOGE("error mmaping cache file: %s (%d)", strerror(errno),
-                    errno);
-            close(fd);
-            return;
-        }
-
-        // Check the file magic and CRC
-        size_t cacheSize = fileSize - headerSize;
-        if (memcmp(buf, cacheFileMagic, 4) != 0) {
-            ALOGE("cache file has bad mojo");
-            close(fd);
-            return;
-        }
-        uint32_t* crc = reinterpret_cast<uint32_t*>(buf + 4);
-        if (crc32c(buf + headerSize, cacheSize) != *crc) {
-            ALOGE("cache file failed CRC check");
-            close(fd);
-            return;
-        }
-
-        status_t err = mBlobCache->unflatten(buf + headerSize, cacheSize);
-        if (err != OK) {
-            ALOGE("error reading cache contents: %s (%d)", strerror(-err),
-                    -err);
-            munmap(buf, fileSize);
-            close(fd);
-            return;
+void egl_cache_t::compactShardsLocked() {
+    for (size_t i = 0; i < NUM_SHARDS; i++) {
+        if (mShards[i] != NULL && mShards[i]->needsCompaction()) {
+            mShards[i]->compact(0);
         }
+    }
+}
 
-        munmap(buf, fileSize);
-        close(fd);
+void egl_cache_t::closeShardsLocked() {
+    for (size_t i = 0; i < NUM_SHARDS; i++) {
+        delete mShards[i];
+        mShards[i] = NULL;
+        delete mSharedShards[i];
+        mSharedShards[i] = NULL;
     }
 }
 
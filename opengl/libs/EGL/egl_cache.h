@@ -20,15 +20,17 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
-#include <utils/BlobCache.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
 #include <utils/String8.h>
-#include <utils/StrongPointer.h>
+#include <utils/Vector.h>
 
 // ----------------------------------------------------------------------------
 namespace android {
 // ----------------------------------------------------------------------------
 
 class egl_display_t;
+class egl_cache_shard_t;
 
 class EGLAPI egl_cache_t {
 public:
@@ -46,12 +48,14 @@ public:
 
     // terminate puts the egl_cache_t back into the uninitialized state.  When
     // in this state the getBlob and setBlob methods will return without
-    // performing any cache operations.
+    // performing any cache operations.  It waits for the pending writes to
+    // the cache files to complete.
     void terminate();
 
     // setBlob attempts to insert a new key/value blob pair into the cache.
     // This will be called by the hardware vendor's EGL implementation via the
-    // EGL_ANDROID_blob_cache extension.
+    // EGL_ANDROID_blob_cache extension.  The pair is written to the cache
+    // file by a background thread, so as not to block the caller on disk I/O.
     void setBlob(const void* key, EGLsizeiANDROID keySize, const void* value,
         EGLsizeiANDROID valueSize);
 
@@ -62,9 +66,36 @@ public:
         void* value, EGLsizeiANDROID valueSize);
 
     // setCacheFilename sets the name of the file that should be used to store
-    // cache contents from one program invocation to another.
+    // cache contents from one program invocation to another.  The contents
+    // are split among NUM_SHARDS files named after it.
     void setCacheFilename(const char* filename);
 
+    // setSharedCacheFilename sets the name of a cache written by another
+    // process, such as one prepopulated for the whole system, which getBlob
+    // looks in before this process' own cache and which is never written to.
+    // Its files are indexed under a shared flock, so that the process which
+    // owns them can keep appending to and compacting them meanwhile.  It
+    // defaults to the ro.egl.shared_blob_cache property.
+    void setSharedCacheFilename(const char* filename);
+
+    // trimMemory releases the pages of the cache files mapped in memory,
+    // which are read back from the files when needed again.  The contents
+    // of a cache without a file are kept.
+    void trimMemory();
+
+    // prepareFork, parentFork and childFork are called around fork() so that
+    // a process which preloaded EGL can fork children that each use their own
+    // cache.  prepareFork makes sure no other thread is using the cache,
+    // parentFork releases it and childFork additionally drops the parent's
+    // shards, pending writes and cache file name, which the child must set
+    // again.
+    void prepareFork();
+    void parentFork();
+    void childFork();
+
+    // The number of shards the cache is split into, by key hash.
+    enum { NUM_SHARDS = 8 };
+
 private:
     // Creation and (the lack of) destruction is handled internally.
     egl_cache_t();
@@ -74,19 +105,43 @@ private:
     egl_cache_t(const egl_cache_t&); // not implemented
     void operator=(const egl_cache_t&); // not implemented
 
-    // getBlobCacheLocked returns the BlobCache object being used to store the
-    // key/value blob pairs.  If the BlobCache object has not yet been created,
-    // this will do so, loading the serialized cache contents from disk if
-    // possible.
-    sp<BlobCache> getBlobCacheLocked();
+    // getShardLocked returns the shard in which the key/value blob pairs
+    // with the given key hash are stored.  If the shard has not yet been
+    // created, this will do so, mapping its file from disk if possible.
+    egl_cache_shard_t* getShardLocked(uint32_t keyHash);
+
+    // getSharedShardLocked returns the read-only shard of the shared cache in
+    // which the key/value blob pairs with the given key hash are, or NULL if
+    // there is no shared cache.
+    egl_cache_shard_t* getSharedShardLocked(uint32_t keyHash);
+
+    // compactShardsLocked rewrites the shards in which replaced or corrupt
+    // entries take up more than half of the space.
+    void compactShardsLocked();
+
+    // closeShardsLocked unmaps and destroys all the shards, shared ones
+    // included.  Their contents stay on disk.
+    void closeShardsLocked();
+
+    // scheduleCompactionLocked starts a deferred compaction if the shard
+    // needs one and none is pending.
+    void scheduleCompactionLocked(egl_cache_shard_t* shard);
+
+    // writePendingBlobs appends the pending records to their shard files,
+    // on the writer thread, until there are none left.
+    void writePendingBlobs();
 
-    // saveBlobCache attempts to save the current contents of mBlobCache to
-    // disk.
-    void saveBlobCacheLocked();
+    // A record waiting to be appended to a shard file by the writer thread.
+    // getBlob looks in these before the shards.
+    struct PendingWrite {
+        uint32_t hash;
+        uint8_t* record;
+        size_t size;
+    };
 
-    // loadBlobCache attempts to load the saved cache contents from disk into
-    // mBlobCache.
-    void loadBlobCacheLocked();
+    // clearPendingWritesLocked drops the pending records without writing
+    // them.
+    void clearPendingWritesLocked();
 
     // mInitialized indicates whether the egl_cache_t is in the initialized
     // state.  It is initialized to false at construction time, and gets set to
@@ -96,10 +151,14 @@ private:
     // operations.
     bool mInitialized;
 
-    // mBlobCache is the cache in which the key/value blob pairs are stored.  It
-    // is initially NULL, and will be initialized by getBlobCacheLocked the
-    // first time it's needed.
-    sp<BlobCache> mBlobCache;
+    // mShards are the append-only stores in which the key/value blob pairs
+    // are stored.  They are initially NULL, and each one is created by
+    // getShardLocked the first time it's needed.
+    egl_cache_shard_t* mShards[NUM_SHARDS];
+
+    // mSharedShards are the read-only shards of the shared cache, created by
+    // getSharedShardLocked the first time they're needed.
+    egl_cache_shard_t* mSharedShards[NUM_SHARDS];
 
     // mFilename is the name of the file for storing cache contents in between
     // program invocations.  It is initialized to an empty string at
@@ -108,17 +167,36 @@ private:
     // from disk.
     String8 mFilename;
 
-    // mSavePending indicates whether or not a deferred save operation is
-    // pending.  Each time a key/value pair is inserted into the cache via
-    // setBlob, a deferred save is initiated if one is not already pending.
-    // This will wait some amount of time and then trigger a save of the cache
-    // contents to disk.
-    bool mSavePending;
+    // mSharedFilename is the name of the shared cache files, empty if there
+    // is none.  It is set with setSharedCacheFilename or from a system
+    // property when the cache is initialized.
+    String8 mSharedFilename;
+
+    // mCompactPending indicates whether or not a deferred compaction is
+    // pending.  When a key/value pair inserted into the cache via setBlob
+    // leaves a shard with too much unused space, a deferred compaction is
+    // initiated if one is not already pending.  This will wait some amount of
+    // time and then rewrite the shards that need it.
+    bool mCompactPending;
+
+    // mPendingWrites are the records waiting to be written, oldest first.
+    Vector<PendingWrite> mPendingWrites;
+
+    // mWriterRunning indicates whether the writer thread is running.  It
+    // clears it and signals mWriterDone once mPendingWrites is empty.
+    bool mWriterRunning;
+    Condition mWriterDone;
 
     // mMutex is the mutex used to prevent concurrent access to the member
     // variables. It must be locked whenever the member variables are accessed.
     mutable Mutex mMutex;
 
+    // mWriteMutex is held by whatever writes, compacts, maps or unmaps the
+    // shard files outside of the GL thread's calls, so that the writer
+    // thread can write a record without holding mMutex.  It is locked before
+    // mMutex.
+    Mutex mWriteMutex;
+
     // sCache is the singleton egl_cache_t object.
     static egl_cache_t sCache;
 };
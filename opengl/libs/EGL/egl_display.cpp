@@ -16,7 +16,9 @@
 
 #define __STDC_LIMIT_MACROS 1
 
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "../egl_impl.h"
 
@@ -80,11 +82,9 @@ void egl_display_t::removeObject(egl_object_t* object) {
     objects.remove(object);
 }
 
-bool egl_display_t::getObject(egl_object_t* object) const {
-    Mutex::Autolock _l(lock);
-    if (objects.indexOf(object) >= 0) {
-        if (object->getDisplay() == this) {
-            object->incRef();
+bool egl_display_t::hasInitializedDisplays() {
+    for (size_t i = 0; i < NUM_DISPLAYS; i++) {
+        if (sDisplay[i].refs > 0) {
             return true;
         }
     }
@@ -270,10 +270,10 @@ EGLBoolean egl_display_t::terminate() {
     ALOGW_IF(count, "eglTerminate() called w/ %d objects remaining", count);
     for (size_t i=0 ; i<count ; i++) {
         egl_object_t* o = objects.itemAt(i);
+        // this marks the object's handle as "terminated"
+        o->invalidate();
         o->destroy();
     }
-
-    // this marks all object handles are "terminated"
     objects.clear();
 
     refs--;
@@ -324,25 +324,25 @@ EGLBoolean egl_display_t::makeCurrent(egl_context_t* c, egl_context_t* cur_c,
     SurfaceRef _cur_r(cur_c ? get_surface(cur_c->read) : NULL);
     SurfaceRef _cur_d(cur_c ? get_surface(cur_c->draw) : NULL);
 
-    { // scope for the lock
-        Mutex::Autolock _l(lock);
-        if (c) {
-            result = c->cnx->egl.eglMakeCurrent(
-                    disp.dpy, impl_draw, impl_read, impl_ctx);
-            if (result == EGL_TRUE) {
-                c->onMakeCurrent(draw, read);
-                if (!cur_c) {
-                    mHibernation.incWakeCount(HibernationMachine::STRONG);
-                }
-            }
-        } else {
-            result = cur_c->cnx->egl.eglMakeCurrent(
-                    disp.dpy, impl_draw, impl_read, impl_ctx);
-            if (result == EGL_TRUE) {
-                cur_c->onLooseCurrent();
-                mHibernation.decWakeCount(HibernationMachine::STRONG);
+    // The display's lock isn't held here: the implementation's eglMakeCurrent
+    // is thread-safe, and c and cur_c may only be modified by the thread
+    // they're current to, so render threads don't serialize on each other.
+    if (c) {
+        result = c->cnx->egl.eglMakeCurrent(
+                disp.dpy, impl_draw, impl_read, impl_ctx);
+        if (result == EGL_TRUE) {
+            c->onMakeCurrent(draw, read);
+            if (!cur_c) {
+                mHibernation.incWakeCount(HibernationMachine::STRONG);
             }
         }
+    } else {
+        result = cur_c->cnx->egl.eglMakeCurrent(
+                disp.dpy, impl_draw, impl_read, impl_ctx);
+        if (result == EGL_TRUE) {
+            cur_c->onLooseCurrent();
+            mHibernation.decWakeCount(HibernationMachine::STRONG);
+        }
     }
 
     if (result == EGL_TRUE) {
@@ -366,45 +366,134 @@ bool egl_display_t::haveExtension(const char* name, size_t nameLen) const {
 
 // ----------------------------------------------------------------------------
 
-bool egl_display_t::HibernationMachine::incWakeCount(WakeRefStrength strength) {
+egl_display_t::HibernationMachine::HibernationMachine(): mWakeCount(0),
+        mHibernating(false), mAttemptHibernation(false), mDpyValid(false),
+#if BOARD_ALLOW_EGL_HIBERNATION
+        mAllowHibernation(true),
+#else
+        mAllowHibernation(false),
+#endif
+        mMode(FULL), mResidentBytesAtWake(0) {
+    memset(&mStats, 0, sizeof(mStats));
+    if (mAllowHibernation) {
+        char value[PROPERTY_VALUE_MAX];
+        property_get("ro.egl.hibernation", value, "full");
+        if (!strcmp(value, "soft")) {
+            mMode = SOFT;
+        }
+    }
+}
+
+int64_t egl_display_t::HibernationMachine::getResidentBytes() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    long long size = 0, resident = 0;
+    if (fscanf(f, "%lld %lld", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(f);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+void egl_display_t::HibernationMachine::onHibernated() {
+    // SOFT hibernation has nothing of the driver's to free, but the blob
+    // cache pages can be read back from its files when needed again.
+    if (mMode == SOFT) {
+        egl_cache_t::get()->trimMemory();
+    }
+    const int64_t resident = getResidentBytes();
     Mutex::Autolock _l(mLock);
-    ALOGE_IF(mWakeCount < 0 || mWakeCount == INT32_MAX,
-             "Invalid WakeCount (%d) on enter\n", mWakeCount);
+    const int64_t freed = mResidentBytesAtWake - resident;
+    mStats.hibernations++;
+    mStats.lastFreedBytes = freed;
+    mStats.totalFreedBytes += freed;
+    ALOGV("%s hibernation #%u: %lld KB released since the last wake up",
+            mMode == SOFT ? "Soft" : "Full", mStats.hibernations,
+            (long long)(freed / 1024));
+}
 
-    mWakeCount++;
-    if (strength == STRONG)
-        mAttemptHibernation = false;
+void egl_display_t::HibernationMachine::onAwakened(nsecs_t startTime) {
+    const nsecs_t duration = systemTime(SYSTEM_TIME_MONOTONIC) - startTime;
+    const int64_t resident = getResidentBytes();
+    Mutex::Autolock _l(mLock);
+    mStats.awakenings++;
+    mStats.lastAwakenTime = duration;
+    if (duration > mStats.maxAwakenTime) {
+        mStats.maxAwakenTime = duration;
+    }
+    mResidentBytesAtWake = resident;
+    ALOGV("Awakened in %.3fms", duration / 1000000.0);
+}
 
-    if (CC_UNLIKELY(mHibernating)) {
-        ALOGV("Awakening\n");
-        egl_connection_t* const cnx = &gEGLImpl;
+bool egl_display_t::HibernationMachine::incWakeCount(WakeRefStrength strength) {
+    // the wake count is only needed to decide when to hibernate, don't
+    // serialize every EGL call on it otherwise
+    if (!mAllowHibernation) {
+        return true;
+    }
+
+    nsecs_t startTime;
+    {
+        Mutex::Autolock _l(mLock);
+        ALOGE_IF(mWakeCount < 0 || mWakeCount == INT32_MAX,
+                 "Invalid WakeCount (%d) on enter\n", mWakeCount);
 
-        // These conditions should be guaranteed before entering hibernation;
-        // we don't want to get into a state where we can't wake up.
-        ALOGD_IF(!mDpyValid || !cnx->egl.eglAwakenProcessIMG,
-                 "Invalid hibernation state, unable to awaken\n");
+        mWakeCount++;
+        if (strength == STRONG)
+            mAttemptHibernation = false;
 
-        if (!cnx->egl.eglAwakenProcessIMG()) {
-            ALOGE("Failed to awaken EGL implementation\n");
-            return false;
+        if (CC_LIKELY(!mHibernating)) {
+            return true;
+        }
+
+        ALOGV("Awakening\n");
+        startTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (mMode == FULL) {
+            egl_connection_t* const cnx = &gEGLImpl;
+
+            // These conditions should be guaranteed before entering
+            // hibernation; we don't want to get into a state where we can't
+            // wake up.
+            ALOGD_IF(!mDpyValid || !cnx->egl.eglAwakenProcessIMG,
+                     "Invalid hibernation state, unable to awaken\n");
+
+            if (!cnx->egl.eglAwakenProcessIMG()) {
+                ALOGE("Failed to awaken EGL implementation\n");
+                return false;
+            }
         }
         mHibernating = false;
     }
+    onAwakened(startTime);
     return true;
 }
 
 void egl_display_t::HibernationMachine::decWakeCount(WakeRefStrength strength) {
-    Mutex::Autolock _l(mLock);
-    ALOGE_IF(mWakeCount <= 0, "Invalid WakeCount (%d) on leave\n", mWakeCount);
+    // the wake count is only needed to decide when to hibernate, don't
+    // serialize every EGL call on it otherwise
+    if (!mAllowHibernation) {
+        return;
+    }
+
+    {
+        Mutex::Autolock _l(mLock);
+        ALOGE_IF(mWakeCount <= 0, "Invalid WakeCount (%d) on leave\n", mWakeCount);
 
-    mWakeCount--;
-    if (strength == STRONG)
-        mAttemptHibernation = true;
+        mWakeCount--;
+        if (strength == STRONG)
+            mAttemptHibernation = true;
 
-    if (mWakeCount == 0 && CC_UNLIKELY(mAttemptHibernation)) {
+        if (mWakeCount != 0 || CC_LIKELY(!mAttemptHibernation)) {
+            return;
+        }
         egl_connection_t* const cnx = &gEGLImpl;
         mAttemptHibernation = false;
-        if (mAllowHibernation && mDpyValid &&
+        if (mAllowHibernation && mDpyValid && mMode == SOFT) {
+            ALOGV("Hibernating (soft)\n");
+            mHibernating = true;
+        } else if (mAllowHibernation && mDpyValid &&
                 cnx->egl.eglHibernateProcessIMG &&
                 cnx->egl.eglAwakenProcessIMG) {
             ALOGV("Hibernating\n");
@@ -413,13 +502,52 @@ void egl_display_t::HibernationMachine::decWakeCount(WakeRefStrength strength) {
                 return;
             }
             mHibernating = true;
+        } else {
+            return;
         }
     }
+    onHibernated();
 }
 
 void egl_display_t::HibernationMachine::setDisplayValid(bool valid) {
+    const int64_t resident = valid ? getResidentBytes() : 0;
     Mutex::Autolock _l(mLock);
     mDpyValid = valid;
+    if (valid) {
+        mResidentBytesAtWake = resident;
+    }
+}
+
+void egl_display_t::HibernationMachine::dump(String8& result) const {
+    if (!mAllowHibernation) {
+        result.append("EGL hibernation: disabled\n");
+        return;
+    }
+    Mutex::Autolock _l(mLock);
+    result.appendFormat("EGL hibernation: %s, %s\n",
+            mMode == SOFT ? "soft" : "full",
+            mHibernating ? "hibernating" : "awake");
+    result.appendFormat("  hibernations=%u, awakenings=%u, "
+            "last awakening=%.3fms, max awakening=%.3fms\n",
+            mStats.hibernations, mStats.awakenings,
+            mStats.lastAwakenTime / 1000000.0,
+            mStats.maxAwakenTime / 1000000.0);
+    result.appendFormat("  released: last=%lld KB, total=%lld KB\n",
+            (long long)(mStats.lastFreedBytes / 1024),
+            (long long)(mStats.totalFreedBytes / 1024));
+}
+
+void egl_display_t::dump(String8& result) const {
+    mHibernation.dump(result);
+}
+
+// Global entry point for the dumps of the processes using EGL, such as
+// SurfaceFlinger's: appends the state of the displays to result.
+extern "C"
+void EGLAPI dumpEGLDisplays(String8& result) {
+    for (uintptr_t i = 0; i < NUM_DISPLAYS; i++) {
+        egl_display_t::get(EGLDisplay(i + 1))->dump(result);
+    }
 }
 
 // ----------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include <utils/SortedVector.h>
 #include <utils/threads.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 
 #include "egldefs.h"
 #include "../hooks.h"
@@ -65,8 +66,6 @@ public:
     void addObject(egl_object_t* object);
     // remove object from this display's list
     void removeObject(egl_object_t* object);
-    // add reference to this object. returns true if this is a valid object.
-    bool getObject(egl_object_t* object) const;
 
     // These notifications allow the display to keep track of how many window
     // surfaces exist, which it uses to decide whether to hibernate the
@@ -90,6 +89,10 @@ public:
             EGLSurface impl_draw, EGLSurface impl_read, EGLContext impl_ctx);
     static void loseCurrent(egl_context_t * cur_c);
 
+    // hasInitializedDisplays returns whether eglInitialize was called on any
+    // display without a matching eglTerminate.
+    static bool hasInitializedDisplays();
+
     inline bool isReady() const { return (refs > 0); }
     inline bool isValid() const { return magic == '_dpy'; }
     inline bool isAlive() const { return isValid(); }
@@ -101,6 +104,9 @@ public:
 
     bool haveExtension(const char* name, size_t nameLen = 0) const;
 
+    // appends the hibernation state and stats to result
+    void dump(String8& result) const;
+
     inline uint32_t getRefsCount() const { return refs; }
 
     struct strings_t {
@@ -154,14 +160,32 @@ private:
             STRONG = 1,
         };
 
-        HibernationMachine(): mWakeCount(0), mHibernating(false),
-                mAttemptHibernation(false), mDpyValid(false),
-#if BOARD_ALLOW_EGL_HIBERNATION
-                mAllowHibernation(true)
-#else
-                mAllowHibernation(false)
-#endif
-        {}
+        // FULL hibernation hands the process to the implementation's
+        // eglHibernateProcessIMG, which frees the most but has to
+        // reinitialize the driver on wake up. SOFT hibernation keeps the
+        // driver initialized and only drops the blob cache pages, which are
+        // read back from its files on demand: the rest of the memory given
+        // back is the surfaces and textures the app released on its way to
+        // the background, and waking up is free. ro.egl.hibernation=soft
+        // selects it.
+        enum Mode {
+            FULL = 0,
+            SOFT = 1,
+        };
+
+        // Appended to dump().
+        struct Stats {
+            uint32_t hibernations;
+            uint32_t awakenings;
+            nsecs_t  lastAwakenTime;
+            nsecs_t  maxAwakenTime;
+            // resident memory released between the last wake up and the
+            // following hibernation, negative if it grew
+            int64_t  lastFreedBytes;
+            int64_t  totalFreedBytes;
+        };
+
+        HibernationMachine();
         ~HibernationMachine() {}
 
         bool incWakeCount(WakeRefStrength strenth);
@@ -169,13 +193,24 @@ private:
 
         void setDisplayValid(bool valid);
 
+        void dump(String8& result) const;
+
     private:
-        Mutex      mLock;
+        static int64_t getResidentBytes();
+        // Called without mLock held after a transition, /proc/self/statm
+        // can take a while to read.
+        void onHibernated();
+        void onAwakened(nsecs_t startTime);
+
+        mutable Mutex mLock;
         int32_t    mWakeCount;
         bool       mHibernating;
         bool       mAttemptHibernation;
         bool       mDpyValid;
         const bool mAllowHibernation;
+        Mode       mMode;
+        int64_t    mResidentBytesAtWake;
+        Stats      mStats;
     };
     HibernationMachine mHibernation;
 };
@@ -17,10 +17,13 @@
 #include <ctype.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
+#include <cutils/log.h>
+
 #include <utils/threads.h>
 
 #include "egl_object.h"
@@ -29,17 +32,87 @@
 namespace android {
 // ----------------------------------------------------------------------------
 
+egl_object_t::slot_t* volatile egl_object_t::sChunks[NUM_CHUNKS];
+Mutex egl_object_t::sSlotLock;
+Vector<uint32_t> egl_object_t::sFreeSlots;
+uint32_t egl_object_t::sNumSlots = 0;
+
+egl_object_t::slot_t* egl_object_t::getSlot(uint32_t index) {
+    return &sChunks[index / SLOTS_PER_CHUNK][index % SLOTS_PER_CHUNK];
+}
+
+egl_object_t::slot_t* egl_object_t::getSlot(void const* handle,
+        uint32_t* generation) {
+    uintptr_t h = uintptr_t(handle);
+    uint32_t index = uint32_t(h & ((1 << HANDLE_GENERATION_SHIFT) - 1));
+    if (index == 0 || (h >> HANDLE_GENERATION_SHIFT) > GENERATION_MASK) {
+        return NULL;
+    }
+    index--;
+    // chunks are never freed, and one is allocated before any handle to
+    // its slots exists
+    slot_t* chunk = index < SLOTS_PER_CHUNK * NUM_CHUNKS ?
+            sChunks[index / SLOTS_PER_CHUNK] : NULL;
+    if (chunk == NULL) {
+        return NULL;
+    }
+    *generation = uint32_t(h >> HANDLE_GENERATION_SHIFT);
+    return &chunk[index % SLOTS_PER_CHUNK];
+}
+
 egl_object_t::egl_object_t(egl_display_t* disp) :
-    display(disp), count(1) {
+    display(disp), index(0), handle(0) {
+    { // scope for the lock
+        Mutex::Autolock _l(sSlotLock);
+        if (!sFreeSlots.isEmpty()) {
+            index = sFreeSlots.top();
+            sFreeSlots.pop();
+        } else {
+            index = sNumSlots;
+            LOG_ALWAYS_FATAL_IF(index >= SLOTS_PER_CHUNK * NUM_CHUNKS,
+                    "too many EGL objects (%u)", index);
+            if (index % SLOTS_PER_CHUNK == 0) {
+                slot_t* chunk = new slot_t[SLOTS_PER_CHUNK];
+                memset(chunk, 0, sizeof(slot_t) * SLOTS_PER_CHUNK);
+                sChunks[index / SLOTS_PER_CHUNK] = chunk;
+            }
+            sNumSlots++;
+        }
+    }
+
     // NOTE: this does an implicit incRef
+    slot_t* slot = getSlot(index);
+    uint32_t generation = uint32_t(slot->state) >> GENERATION_SHIFT;
+    slot->object = this;
+    handle = reinterpret_cast<void*>(
+            (uintptr_t(generation) << HANDLE_GENERATION_SHIFT) | (index + 1));
+    android_atomic_release_store(
+            int32_t((generation << GENERATION_SHIFT) | VALID | 1),
+            &slot->state);
     display->addObject(this);
 }
 
 egl_object_t::~egl_object_t() {
+    // the next object in this slot gets a new generation, so that this
+    // object's handle becomes stale
+    slot_t* slot = getSlot(index);
+    uint32_t generation = ((uint32_t(slot->state) >> GENERATION_SHIFT) + 1) &
+            GENERATION_MASK;
+    slot->object = NULL;
+    android_atomic_release_store(int32_t(generation << GENERATION_SHIFT),
+            &slot->state);
+
+    Mutex::Autolock _l(sSlotLock);
+    sFreeSlots.push(index);
+}
+
+void egl_object_t::invalidate() {
+    android_atomic_and(~VALID, &getSlot(index)->state);
 }
 
 void egl_object_t::terminate() {
     // this marks the object as "terminated"
+    invalidate();
     display->removeObject(this);
     if (decRef() == 1) {
         // shouldn't happen because this is called from LocalRef
@@ -53,10 +126,40 @@ void egl_object_t::destroy() {
     }
 }
 
-bool egl_object_t::get(egl_display_t const* display, egl_object_t* object) {
+egl_object_t* egl_object_t::get(egl_display_t const* display,
+        void const* handle) {
     // used by LocalRef, this does an incRef() atomically with
     // checking that the object is valid.
-    return display->getObject(object);
+    uint32_t generation;
+    slot_t* slot = getSlot(handle, &generation);
+    if (slot == NULL) {
+        return NULL;
+    }
+    int32_t state;
+    do {
+        state = slot->state;
+        if (!(state & VALID) ||
+                (uint32_t(state) >> GENERATION_SHIFT) != generation) {
+            return NULL;
+        }
+    } while (android_atomic_acquire_cas(state, state + 1, &slot->state));
+
+    egl_object_t* object = slot->object;
+    if (object->getDisplay() != display) {
+        object->destroy();
+        return NULL;
+    }
+    return object;
+}
+
+egl_object_t* egl_object_t::lookup(void const* handle) {
+    uint32_t generation;
+    slot_t* slot = getSlot(handle, &generation);
+    if (slot == NULL ||
+            (uint32_t(slot->state) >> GENERATION_SHIFT) != generation) {
+        return NULL;
+    }
+    return slot->object;
 }
 
 // ----------------------------------------------------------------------------
@@ -25,8 +25,11 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
+#include <cutils/atomic.h>
+
 #include <utils/threads.h>
 #include <utils/String8.h>
+#include <utils/Vector.h>
 
 #include <system/window.h>
 
@@ -38,9 +41,40 @@ namespace android {
 
 struct egl_display_t;
 
+// The EGLSurface and EGLContext handles given to the application are not
+// pointers to our objects but indices into a process-wide table, tagged
+// with a generation number.  Each table slot keeps the generation, whether
+// the object is still valid (not terminated) and its reference count in a
+// single word, so a handle can be validated and a reference acquired with a
+// single compare-and-swap, without holding the display's lock, and a stale
+// handle can never reach an object that was deleted.
 class egl_object_t {
+    struct slot_t {
+        volatile int32_t state;
+        egl_object_t* volatile object;
+    };
+
+    enum {
+        COUNT_MASK      = 0x0000FFFF,
+        VALID           = 0x00010000,
+        GENERATION_SHIFT = 17,
+        GENERATION_MASK = 0x7FFF,
+        HANDLE_GENERATION_SHIFT = 16,
+        SLOTS_PER_CHUNK = 256,
+        NUM_CHUNKS      = 255
+    };
+
+    static slot_t* volatile sChunks[NUM_CHUNKS];
+    static Mutex sSlotLock;
+    static Vector<uint32_t> sFreeSlots;
+    static uint32_t sNumSlots;
+
+    static slot_t* getSlot(uint32_t index);
+    static slot_t* getSlot(void const* handle, uint32_t* generation);
+
     egl_display_t *display;
-    mutable volatile int32_t count;
+    uint32_t index;
+    void* handle;
 
 protected:
     virtual ~egl_object_t();
@@ -49,13 +83,28 @@ public:
     egl_object_t(egl_display_t* display);
     void destroy();
 
-    inline int32_t incRef() { return android_atomic_inc(&count); }
-    inline int32_t decRef() { return android_atomic_dec(&count); }
+    inline int32_t incRef() {
+        return android_atomic_inc(&getSlot(index)->state) & COUNT_MASK;
+    }
+    inline int32_t decRef() {
+        return android_atomic_dec(&getSlot(index)->state) & COUNT_MASK;
+    }
     inline egl_display_t* getDisplay() const { return display; }
+    inline void* getHandle() const { return handle; }
+
+    // invalidate marks the object as terminated, its handle can no longer be
+    // used to acquire a reference to it.
+    void invalidate();
+
+    // lookup returns the object a handle refers to, terminated or not,
+    // without acquiring a reference to it.  The caller must otherwise own a
+    // reference, for instance through a LocalRef or by the object being
+    // current.
+    static egl_object_t* lookup(void const* handle);
 
 private:
     void terminate();
-    static bool get(egl_display_t const* display, egl_object_t* object);
+    static egl_object_t* get(egl_display_t const* display, void const* handle);
 
 public:
     template <typename N, typename T>
@@ -67,9 +116,8 @@ public:
         ~LocalRef();
         explicit LocalRef(egl_object_t* rhs);
         explicit LocalRef(egl_display_t const* display, T o) : ref(0) {
-            egl_object_t* native = reinterpret_cast<N*>(o);
-            if (o && egl_object_t::get(display, native)) {
-                ref = native;
+            if (o) {
+                ref = egl_object_t::get(display, o);
             }
         }
         inline N* get() {
@@ -168,19 +216,14 @@ typedef egl_context_t::Ref  ContextRef;
 
 // ----------------------------------------------------------------------------
 
-template<typename NATIVE, typename EGL>
-static inline NATIVE* egl_to_native_cast(EGL arg) {
-    return reinterpret_cast<NATIVE*>(arg);
-}
-
 static inline
 egl_surface_t* get_surface(EGLSurface surface) {
-    return egl_to_native_cast<egl_surface_t>(surface);
+    return static_cast<egl_surface_t*>(egl_object_t::lookup(surface));
 }
 
 static inline
 egl_context_t* get_context(EGLContext context) {
-    return egl_to_native_cast<egl_context_t>(context);
+    return static_cast<egl_context_t*>(egl_object_t::lookup(context));
 }
 
 // ----------------------------------------------------------------------------
@@ -14,7 +14,17 @@
 
 #include <ETC1/etc1.h>
 
+#include <pthread.h>
 #include <string.h>
+#include <unistd.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ETC1_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ETC1_USE_SSE2 1
+#endif
 
 /* From http://www.khronos.org/registry/gles/extensions/OES/OES_compressed_ETC1_RGB8_texture.txt
 
@@ -163,71 +173,213 @@ inline int convertDiff(int base, int diff) {
     return convert5To8((0x1f & base) + kLookup[0x7 & diff]);
 }
 
-static
-void decode_subblock(etc1_byte* pOut, int r, int g, int b, const int* table,
-        etc1_uint32 low, bool second, bool flipped) {
-    int baseX = 0;
-    int baseY = 0;
-    if (second) {
-        if (flipped) {
-            baseY = 2;
-        } else {
-            baseX = 2;
-        }
-    }
-    for (int i = 0; i < 8; i++) {
-        int x, y;
-        if (flipped) {
-            x = baseX + (i >> 1);
-            y = baseY + (i & 1);
-        } else {
-            x = baseX + (i >> 2);
-            y = baseY + (i & 3);
-        }
-        int k = y + (x * 4);
-        int offset = ((low >> k) & 1) | ((low >> (k + 15)) & 2);
-        int delta = table[offset];
-        etc1_byte* q = pOut + 3 * (x + 4 * y);
-        *q++ = clamp(r + delta);
-        *q++ = clamp(g + delta);
-        *q++ = clamp(b + delta);
-    }
-}
+// Modifier and base colors of each pixel of a block, in the order of
+// the decoded pixels: pixel (x, y) is at index x + 4 * y.
 
-// Input is an ETC1 compressed version of the data.
-// Output is a 4 x 4 square of 3-byte pixels in form R, G, B
+typedef struct {
+    short delta[16];
+    int base[6];        // r, g, b of the first then the second sub-block
+    bool flipped;
+} etc_decoded_block;
 
-void etc1_decode_block(const etc1_byte* pIn, etc1_byte* pOut) {
+static
+void etc_decode_block_modifiers(const etc1_byte* pIn, etc_decoded_block* pOut) {
     etc1_uint32 high = (pIn[0] << 24) | (pIn[1] << 16) | (pIn[2] << 8) | pIn[3];
     etc1_uint32 low = (pIn[4] << 24) | (pIn[5] << 16) | (pIn[6] << 8) | pIn[7];
-    int r1, r2, g1, g2, b1, b2;
+    int* base = pOut->base;
     if (high & 2) {
         // differential
         int rBase = high >> 27;
         int gBase = high >> 19;
         int bBase = high >> 11;
-        r1 = convert5To8(rBase);
-        r2 = convertDiff(rBase, high >> 24);
-        g1 = convert5To8(gBase);
-        g2 = convertDiff(gBase, high >> 16);
-        b1 = convert5To8(bBase);
-        b2 = convertDiff(bBase, high >> 8);
+        base[0] = convert5To8(rBase);
+        base[3] = convertDiff(rBase, high >> 24);
+        base[1] = convert5To8(gBase);
+        base[4] = convertDiff(gBase, high >> 16);
+        base[2] = convert5To8(bBase);
+        base[5] = convertDiff(bBase, high >> 8);
     } else {
         // not differential
-        r1 = convert4To8(high >> 28);
-        r2 = convert4To8(high >> 24);
-        g1 = convert4To8(high >> 20);
-        g2 = convert4To8(high >> 16);
-        b1 = convert4To8(high >> 12);
-        b2 = convert4To8(high >> 8);
-    }
-    int tableIndexA = 7 & (high >> 5);
-    int tableIndexB = 7 & (high >> 2);
-    const int* tableA = kModifierTable + tableIndexA * 4;
-    const int* tableB = kModifierTable + tableIndexB * 4;
+        base[0] = convert4To8(high >> 28);
+        base[3] = convert4To8(high >> 24);
+        base[1] = convert4To8(high >> 20);
+        base[4] = convert4To8(high >> 16);
+        base[2] = convert4To8(high >> 12);
+        base[5] = convert4To8(high >> 8);
+    }
+    const int* tables[2] = {
+        kModifierTable + (7 & (high >> 5)) * 4,
+        kModifierTable + (7 & (high >> 2)) * 4
+    };
     bool flipped = (high & 1) != 0;
-    decode_subblock(pOut, r1, g1, b1, tableA, low, false, flipped);
-    decode_subblock(pOut, r2, g2, b2, tableB, low, true, flipped);
+    for (int i = 0; i < 16; i++) {
+        int x = i & 3;
+        int y = i >> 2;
+        int k = y + (x * 4);
+        int offset = ((low >> k) & 1) | ((low >> (k + 15)) & 2);
+        int second = (flipped ? y : x) >> 1;
+        pOut->delta[i] = (short) tables[second][offset];
+    }
+    pOut->flipped = flipped;
+}
+
+// Decode a block into 4 rows of 4 pixels of the given format, written
+// contiguously at pOut.
+
+#if defined(ETC1_USE_NEON)
+
+static
+void etc_decode_block(const etc1_byte* pIn, etc1_uint32 format, etc1_byte* pOut) {
+    etc_decoded_block block;
+    etc_decode_block_modifiers(pIn, &block);
+
+    // Lanes of the pixels of the second sub-block.
+    static const unsigned short kSecondColumns[8] = {
+        0, 0, 0xffff, 0xffff, 0, 0, 0xffff, 0xffff };
+    uint16x8_t second0, second1;
+    if (block.flipped) {
+        second0 = vdupq_n_u16(0);
+        second1 = vdupq_n_u16(0xffff);
+    } else {
+        second0 = second1 = vld1q_u16(kSecondColumns);
+    }
+    int16x8_t delta0 = vld1q_s16(block.delta);
+    int16x8_t delta1 = vld1q_s16(block.delta + 8);
+
+    // The saturating narrowing clamps the components to [0, 255].
+    uint8x16_t c[3];
+    for (int i = 0; i < 3; i++) {
+        int16x8_t first = vdupq_n_s16((short) block.base[i]);
+        int16x8_t last = vdupq_n_s16((short) block.base[i + 3]);
+        c[i] = vcombine_u8(
+                vqmovun_s16(vaddq_s16(vbslq_s16(second0, last, first), delta0)),
+                vqmovun_s16(vaddq_s16(vbslq_s16(second1, last, first), delta1)));
+    }
+
+    if (format == ETC1_FORMAT_RGB888) {
+        uint8x16x3_t rgb = { { c[0], c[1], c[2] } };
+        vst3q_u8(pOut, rgb);
+    } else if (format == ETC1_FORMAT_RGBA8888) {
+        uint8x16x4_t rgba = { { c[0], c[1], c[2], vdupq_n_u8(0xff) } };
+        vst4q_u8(pOut, rgba);
+    } else {
+        for (int i = 0; i < 2; i++) {
+            uint8x8_t r = i ? vget_high_u8(c[0]) : vget_low_u8(c[0]);
+            uint8x8_t g = i ? vget_high_u8(c[1]) : vget_low_u8(c[1]);
+            uint8x8_t b = i ? vget_high_u8(c[2]) : vget_low_u8(c[2]);
+            uint16x8_t pixel = vshlq_n_u16(vmovl_u8(vshr_n_u8(r, 3)), 11);
+            pixel = vorrq_u16(pixel, vshll_n_u8(vshr_n_u8(g, 2), 5));
+            pixel = vorrq_u16(pixel, vmovl_u8(vshr_n_u8(b, 3)));
+            vst1q_u16((uint16_t*) pOut + i * 8, pixel);
+        }
+    }
+}
+
+#elif defined(ETC1_USE_SSE2)
+
+static
+void etc_decode_block(const etc1_byte* pIn, etc1_uint32 format, etc1_byte* pOut) {
+    etc_decoded_block block;
+    etc_decode_block_modifiers(pIn, &block);
+
+    __m128i second0, second1;
+    if (block.flipped) {
+        second0 = _mm_setzero_si128();
+        second1 = _mm_set1_epi16(-1);
+    } else {
+        second0 = second1 = _mm_set_epi16(-1, -1, 0, 0, -1, -1, 0, 0);
+    }
+    __m128i delta0 = _mm_loadu_si128((const __m128i*) block.delta);
+    __m128i delta1 = _mm_loadu_si128((const __m128i*) (block.delta + 8));
+
+    // Components of the 16 pixels, as 16 bit values clamped to [0, 255].
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    __m128i c[3][2];
+    for (int i = 0; i < 3; i++) {
+        __m128i first = _mm_set1_epi16((short) block.base[i]);
+        __m128i last = _mm_set1_epi16((short) block.base[i + 3]);
+        __m128i base0 = _mm_or_si128(_mm_and_si128(second0, last),
+                _mm_andnot_si128(second0, first));
+        __m128i base1 = _mm_or_si128(_mm_and_si128(second1, last),
+                _mm_andnot_si128(second1, first));
+        c[i][0] = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(base0, delta0), zero), max);
+        c[i][1] = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(base1, delta1), zero), max);
+    }
+
+    if (format == ETC1_FORMAT_RGB565) {
+        for (int i = 0; i < 2; i++) {
+            __m128i pixel = _mm_slli_epi16(_mm_srli_epi16(c[0][i], 3), 11);
+            pixel = _mm_or_si128(pixel, _mm_slli_epi16(_mm_srli_epi16(c[1][i], 2), 5));
+            pixel = _mm_or_si128(pixel, _mm_srli_epi16(c[2][i], 3));
+            _mm_storeu_si128((__m128i*) pOut + i, pixel);
+        }
+        return;
+    }
+
+    __m128i r = _mm_packus_epi16(c[0][0], c[0][1]);
+    __m128i g = _mm_packus_epi16(c[1][0], c[1][1]);
+    __m128i b = _mm_packus_epi16(c[2][0], c[2][1]);
+    if (format == ETC1_FORMAT_RGBA8888) {
+        __m128i ba = _mm_set1_epi8((char) 0xff);
+        __m128i rgLow = _mm_unpacklo_epi8(r, g);
+        __m128i rgHigh = _mm_unpackhi_epi8(r, g);
+        __m128i baLow = _mm_unpacklo_epi8(b, ba);
+        __m128i baHigh = _mm_unpackhi_epi8(b, ba);
+        __m128i* q = (__m128i*) pOut;
+        _mm_storeu_si128(q++, _mm_unpacklo_epi16(rgLow, baLow));
+        _mm_storeu_si128(q++, _mm_unpackhi_epi16(rgLow, baLow));
+        _mm_storeu_si128(q++, _mm_unpacklo_epi16(rgHigh, baHigh));
+        _mm_storeu_si128(q++, _mm_unpackhi_epi16(rgHigh, baHigh));
+    } else {
+        // SSE2 has no 3 way interleave.
+        etc1_byte planes[3][16];
+        _mm_storeu_si128((__m128i*) planes[0], r);
+        _mm_storeu_si128((__m128i*) planes[1], g);
+        _mm_storeu_si128((__m128i*) planes[2], b);
+        for (int i = 0; i < 16; i++) {
+            *pOut++ = planes[0][i];
+            *pOut++ = planes[1][i];
+            *pOut++ = planes[2][i];
+        }
+    }
+}
+
+#else
+
+static
+void etc_decode_block(const etc1_byte* pIn, etc1_uint32 format, etc1_byte* pOut) {
+    etc_decoded_block block;
+    etc_decode_block_modifiers(pIn, &block);
+
+    for (int i = 0; i < 16; i++) {
+        int second = ((block.flipped ? (i >> 2) : i) & 2) ? 3 : 0;
+        int delta = block.delta[i];
+        etc1_byte r = clamp(block.base[second] + delta);
+        etc1_byte g = clamp(block.base[second + 1] + delta);
+        etc1_byte b = clamp(block.base[second + 2] + delta);
+        if (format == ETC1_FORMAT_RGB565) {
+            etc1_uint32 pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+            *pOut++ = (etc1_byte) pixel;
+            *pOut++ = (etc1_byte) (pixel >> 8);
+        } else {
+            *pOut++ = r;
+            *pOut++ = g;
+            *pOut++ = b;
+            if (format == ETC1_FORMAT_RGBA8888) {
+                *pOut++ = 0xff;
+            }
+        }
+    }
+}
+
+#endif
+
+// Input is an ETC1 compressed version of the data.
+// Output is a 4 x 4 square of 3-byte pixels in form R, G, B
+
+void etc1_decode_block(const etc1_byte* pIn, etc1_byte* pOut) {
+    etc_decode_block(pIn, ETC1_FORMAT_RGB888, pOut);
 }
 
 typedef struct {
@@ -295,6 +447,50 @@ inline int square(int x) {
     return x * x;
 }
 
+#ifdef ETC1_USE_NEON
+
+// Scores the four modifiers at once. The scalar version below skips a
+// modifier as soon as its partial score can't beat the best one, which can
+// only discard modifiers that would not have been picked, so taking the
+// first modifier with the lowest score gives the same result.
+
+static etc1_uint32 chooseModifier(const etc1_byte* pBaseColors,
+        const etc1_byte* pIn, etc1_uint32 *pLow, int bitIndex,
+        const int* pModifierTable) {
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max = vdupq_n_s32(255);
+    int32x4_t modifier = vld1q_s32(pModifierTable);
+    int32x4_t dr = vsubq_s32(vminq_s32(vmaxq_s32(
+            vaddq_s32(vdupq_n_s32(pBaseColors[0]), modifier), zero), max),
+            vdupq_n_s32(pIn[0]));
+    int32x4_t dg = vsubq_s32(vminq_s32(vmaxq_s32(
+            vaddq_s32(vdupq_n_s32(pBaseColors[1]), modifier), zero), max),
+            vdupq_n_s32(pIn[1]));
+    int32x4_t db = vsubq_s32(vminq_s32(vmaxq_s32(
+            vaddq_s32(vdupq_n_s32(pBaseColors[2]), modifier), zero), max),
+            vdupq_n_s32(pIn[2]));
+    int32x4_t score = vmulq_n_s32(vmulq_s32(dg, dg), 6);
+    score = vmlaq_n_s32(score, vmulq_s32(dr, dr), 3);
+    score = vmlaq_s32(score, db, db);
+
+    etc1_uint32 scores[4];
+    vst1q_u32(scores, vreinterpretq_u32_s32(score));
+    etc1_uint32 bestScore = scores[0];
+    int bestIndex = 0;
+    for (int i = 1; i < 4; i++) {
+        if (scores[i] < bestScore) {
+            bestScore = scores[i];
+            bestIndex = i;
+        }
+    }
+    etc1_uint32 lowMask = (((bestIndex >> 1) << 16) | (bestIndex & 1))
+            << bitIndex;
+    *pLow |= lowMask;
+    return bestScore;
+}
+
+#else
+
 static etc1_uint32 chooseModifier(const etc1_byte* pBaseColors,
         const etc1_byte* pIn, etc1_uint32 *pLow, int bitIndex,
         const int* pModifierTable) {
@@ -331,6 +527,8 @@ static etc1_uint32 chooseModifier(const etc1_byte* pBaseColors,
     return bestScore;
 }
 
+#endif // ETC1_USE_NEON
+
 static
 void etc_encode_subblock_helper(const etc1_byte* pIn, etc1_uint32 inMask,
         etc_compressed* pCompressed, bool flipped, bool second,
@@ -504,6 +702,51 @@ etc1_uint32 etc1_get_encoded_data_size(etc1_uint32 width, etc1_uint32 height) {
     return (((width + 3) & ~3) * ((height + 3) & ~3)) >> 1;
 }
 
+// Encode the row of blocks starting at line y of the image into pOut.
+
+static void etc1_encode_block_row(const etc1_byte* pIn, etc1_uint32 width,
+        etc1_uint32 height, etc1_uint32 pixelSize, etc1_uint32 stride,
+        etc1_uint32 y, etc1_byte* pOut) {
+    static const unsigned short kYMask[] = { 0x0, 0xf, 0xff, 0xfff, 0xffff };
+    static const unsigned short kXMask[] = { 0x0, 0x1111, 0x3333, 0x7777,
+            0xffff };
+    etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
+    etc1_byte encoded[ETC1_ENCODED_BLOCK_SIZE];
+
+    etc1_uint32 encodedWidth = (width + 3) & ~3;
+
+    etc1_uint32 yEnd = height - y;
+    if (yEnd > 4) {
+        yEnd = 4;
+    }
+    int ymask = kYMask[yEnd];
+    for (etc1_uint32 x = 0; x < encodedWidth; x += 4) {
+        etc1_uint32 xEnd = width - x;
+        if (xEnd > 4) {
+            xEnd = 4;
+        }
+        int mask = ymask & kXMask[xEnd];
+        for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
+            etc1_byte* q = block + (cy * 4) * 3;
+            const etc1_byte* p = pIn + pixelSize * x + stride * (y + cy);
+            if (pixelSize == 3) {
+                memcpy(q, p, xEnd * 3);
+            } else {
+                for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
+                    int pixel = (p[1] << 8) | p[0];
+                    *q++ = convert5To8(pixel >> 11);
+                    *q++ = convert6To8(pixel >> 5);
+                    *q++ = convert5To8(pixel);
+                    p += pixelSize;
+                }
+            }
+        }
+        etc1_encode_block(block, mask, encoded);
+        memcpy(pOut, encoded, sizeof(encoded));
+        pOut += sizeof(encoded);
+    }
+}
+
 // Encode an entire image.
 // pIn - pointer to the image data. Formatted such that the Red component of
 //       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset;
@@ -514,46 +757,96 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
     if (pixelSize < 2 || pixelSize > 3) {
         return -1;
     }
-    static const unsigned short kYMask[] = { 0x0, 0xf, 0xff, 0xfff, 0xffff };
-    static const unsigned short kXMask[] = { 0x0, 0x1111, 0x3333, 0x7777,
-            0xffff };
-    etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
-    etc1_byte encoded[ETC1_ENCODED_BLOCK_SIZE];
-
-    etc1_uint32 encodedWidth = (width + 3) & ~3;
     etc1_uint32 encodedHeight = (height + 3) & ~3;
+    etc1_uint32 rowSize = ((width + 3) >> 2) * ETC1_ENCODED_BLOCK_SIZE;
 
     for (etc1_uint32 y = 0; y < encodedHeight; y += 4) {
-        etc1_uint32 yEnd = height - y;
-        if (yEnd > 4) {
-            yEnd = 4;
+        etc1_encode_block_row(pIn, width, height, pixelSize, stride, y, pOut);
+        pOut += rowSize;
+    }
+    return 0;
+}
+
+// Work shared by the threads of etc1_encode_image_mt. Block rows are handed
+// out one at a time so that threads finishing early pick up the remaining
+// rows. Each row is written to its own place in the output, so the result
+// does not depend on which thread encoded it.
+
+struct etc1_encode_job {
+    const etc1_byte* pIn;
+    etc1_uint32 width;
+    etc1_uint32 height;
+    etc1_uint32 pixelSize;
+    etc1_uint32 stride;
+    etc1_byte* pOut;
+    etc1_uint32 rowSize;
+    etc1_uint32 rowCount;
+    volatile etc1_uint32 nextRow;
+};
+
+static void* etc1_encode_worker(void* arg) {
+    etc1_encode_job* job = (etc1_encode_job*) arg;
+    for (;;) {
+        etc1_uint32 row = __sync_fetch_and_add(&job->nextRow, 1);
+        if (row >= job->rowCount) {
+            break;
         }
-        int ymask = kYMask[yEnd];
-        for (etc1_uint32 x = 0; x < encodedWidth; x += 4) {
-            etc1_uint32 xEnd = width - x;
-            if (xEnd > 4) {
-                xEnd = 4;
-            }
-            int mask = ymask & kXMask[xEnd];
-            for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
-                etc1_byte* q = block + (cy * 4) * 3;
-                const etc1_byte* p = pIn + pixelSize * x + stride * (y + cy);
-                if (pixelSize == 3) {
-                    memcpy(q, p, xEnd * 3);
-                } else {
-                    for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
-                        int pixel = (p[1] << 8) | p[0];
-                        *q++ = convert5To8(pixel >> 11);
-                        *q++ = convert6To8(pixel >> 5);
-                        *q++ = convert5To8(pixel);
-                        p += pixelSize;
-                    }
-                }
-            }
-            etc1_encode_block(block, mask, encoded);
-            memcpy(pOut, encoded, sizeof(encoded));
-            pOut += sizeof(encoded);
+        etc1_encode_block_row(job->pIn, job->width, job->height,
+                job->pixelSize, job->stride, row * 4,
+                job->pOut + row * job->rowSize);
+    }
+    return NULL;
+}
+
+#define ETC1_MAX_ENCODE_THREADS 16
+
+// Encode an entire image using up to threadCount threads, including the
+// calling one. The output is identical to the one of etc1_encode_image.
+
+int etc1_encode_image_mt(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut,
+        etc1_uint32 threadCount) {
+    if (pixelSize < 2 || pixelSize > 3) {
+        return -1;
+    }
+    if (threadCount == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (etc1_uint32) cpus : 1;
+    }
+    etc1_uint32 rowCount = (height + 3) >> 2;
+    if (threadCount > rowCount) {
+        threadCount = rowCount;
+    }
+    if (threadCount > ETC1_MAX_ENCODE_THREADS) {
+        threadCount = ETC1_MAX_ENCODE_THREADS;
+    }
+    if (threadCount <= 1) {
+        return etc1_encode_image(pIn, width, height, pixelSize, stride, pOut);
+    }
+
+    etc1_encode_job job;
+    job.pIn = pIn;
+    job.width = width;
+    job.height = height;
+    job.pixelSize = pixelSize;
+    job.stride = stride;
+    job.pOut = pOut;
+    job.rowSize = ((width + 3) >> 2) * ETC1_ENCODED_BLOCK_SIZE;
+    job.rowCount = rowCount;
+    job.nextRow = 0;
+
+    // If a thread can't be created the rows are encoded by the ones that were.
+    pthread_t threads[ETC1_MAX_ENCODE_THREADS - 1];
+    etc1_uint32 started = 0;
+    while (started < threadCount - 1) {
+        if (pthread_create(&threads[started], NULL, etc1_encode_worker, &job)) {
+            break;
         }
+        started++;
+    }
+    etc1_encode_worker(&job);
+    for (etc1_uint32 i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
     }
     return 0;
 }
@@ -571,13 +864,34 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
     if (pixelSize < 2 || pixelSize > 3) {
         return -1;
     }
-    etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
+    return etc1_decode_image_rows(pIn, pOut, width, height, 0, height,
+            pixelSize, stride);
+}
+
+// Decode lines [y, y + lineCount) of an image.
+// pIn - pointer to the encoded row of blocks holding line y.
+// pOut - pointer to line y of the image data.
+
+int etc1_decode_image_rows(const etc1_byte* pIn, etc1_byte* pOut,
+        etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 y, etc1_uint32 lineCount,
+        etc1_uint32 format, etc1_uint32 stride) {
+    if (format < ETC1_FORMAT_RGB565 || format > ETC1_FORMAT_RGBA8888) {
+        return -1;
+    }
+    if ((y & 3) || y > height) {
+        return -1;
+    }
+    if (lineCount > height - y) {
+        lineCount = height - y;
+    }
+    etc1_uint32 pixelSize = format;
+    etc1_byte block[16 * 4];
 
     etc1_uint32 encodedWidth = (width + 3) & ~3;
-    etc1_uint32 encodedHeight = (height + 3) & ~3;
 
-    for (etc1_uint32 y = 0; y < encodedHeight; y += 4) {
-        etc1_uint32 yEnd = height - y;
+    for (etc1_uint32 line = 0; line < lineCount; line += 4) {
+        etc1_uint32 yEnd = lineCount - line;
         if (yEnd > 4) {
             yEnd = 4;
         }
@@ -586,23 +900,11 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
             if (xEnd > 4) {
                 xEnd = 4;
             }
-            etc1_decode_block(pIn, block);
+            etc_decode_block(pIn, format, block);
             pIn += ETC1_ENCODED_BLOCK_SIZE;
             for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
-                const etc1_byte* q = block + (cy * 4) * 3;
-                etc1_byte* p = pOut + pixelSize * x + stride * (y + cy);
-                if (pixelSize == 3) {
-                    memcpy(p, q, xEnd * 3);
-                } else {
-                    for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
-                        etc1_byte r = *q++;
-                        etc1_byte g = *q++;
-                        etc1_byte b = *q++;
-                        etc1_uint32 pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-                        *p++ = (etc1_byte) pixel;
-                        *p++ = (etc1_byte) (pixel >> 8);
-                    }
-                }
+                memcpy(pOut + pixelSize * x + stride * (line + cy),
+                        block + cy * 4 * pixelSize, xEnd * pixelSize);
             }
         }
     }
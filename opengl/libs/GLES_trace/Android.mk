@@ -10,7 +10,8 @@ LOCAL_SRC_FILES := \
     src/gltrace_fixup.cpp \
     src/gltrace_hooks.cpp \
     src/gltrace.pb.cpp \
-    src/gltrace_transport.cpp
+    src/gltrace_transport.cpp \
+    src/gltrace_worker.cpp
 
 LOCAL_C_INCLUDES := \
     $(LOCAL_PATH) \
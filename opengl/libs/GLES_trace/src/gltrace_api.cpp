@@ -20,6 +20,7 @@
 #include <utils/Timers.h>
 
 #include "gltrace.pb.h"
+#include "gltrace_compact.h"
 #include "gltrace_context.h"
 #include "gltrace_fixup.h"
 #include "gltrace_transport.h"
@@ -30,9 +31,25 @@ namespace gltrace {
 // Definitions for GL2 APIs
 
 void GLTrace_glActiveTexture(GLenum texture) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glActiveTexture(texture);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glActiveTexture, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glActiveTexture);
 
     // copy argument texture
@@ -58,9 +75,26 @@ void GLTrace_glActiveTexture(GLenum texture) {
 }
 
 void GLTrace_glAttachShader(GLuint program, GLuint shader) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glAttachShader(program, shader);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glAttachShader, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)shader);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glAttachShader);
 
     // copy argument program
@@ -133,9 +167,26 @@ void GLTrace_glBindAttribLocation(GLuint program, GLuint index, const GLchar * n
 }
 
 void GLTrace_glBindBuffer(GLenum target, GLuint buffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindBuffer(target, buffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindBuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindBuffer);
 
     // copy argument target
@@ -167,9 +218,26 @@ void GLTrace_glBindBuffer(GLenum target, GLuint buffer) {
 }
 
 void GLTrace_glBindFramebuffer(GLenum target, GLuint framebuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindFramebuffer(target, framebuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindFramebuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)framebuffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindFramebuffer);
 
     // copy argument target
@@ -201,9 +269,26 @@ void GLTrace_glBindFramebuffer(GLenum target, GLuint framebuffer) {
 }
 
 void GLTrace_glBindRenderbuffer(GLenum target, GLuint renderbuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindRenderbuffer(target, renderbuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindRenderbuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)renderbuffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindRenderbuffer);
 
     // copy argument target
@@ -235,9 +320,26 @@ void GLTrace_glBindRenderbuffer(GLenum target, GLuint renderbuffer) {
 }
 
 void GLTrace_glBindTexture(GLenum target, GLuint texture) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindTexture(target, texture);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindTexture, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindTexture);
 
     // copy argument target
@@ -269,9 +371,28 @@ void GLTrace_glBindTexture(GLenum target, GLuint texture) {
 }
 
 void GLTrace_glBlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendColor(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendColor, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(red);
+        msg.addFloat(green);
+        msg.addFloat(blue);
+        msg.addFloat(alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendColor);
 
     // copy argument red
@@ -315,9 +436,25 @@ void GLTrace_glBlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alph
 }
 
 void GLTrace_glBlendEquation(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendEquation(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendEquation, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendEquation);
 
     // copy argument mode
@@ -343,9 +480,26 @@ void GLTrace_glBlendEquation(GLenum mode) {
 }
 
 void GLTrace_glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendEquationSeparate(modeRGB, modeAlpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendEquationSeparate, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)modeRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)modeAlpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendEquationSeparate);
 
     // copy argument modeRGB
@@ -377,9 +531,26 @@ void GLTrace_glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha) {
 }
 
 void GLTrace_glBlendFunc(GLenum sfactor, GLenum dfactor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendFunc(sfactor, dfactor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendFunc, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)sfactor);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dfactor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendFunc);
 
     // copy argument sfactor
@@ -411,9 +582,28 @@ void GLTrace_glBlendFunc(GLenum sfactor, GLenum dfactor) {
 }
 
 void GLTrace_glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendFuncSeparate(sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendFuncSeparate, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)sfactorRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dfactorRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)sfactorAlpha);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dfactorAlpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendFuncSeparate);
 
     // copy argument sfactorRGB
@@ -551,9 +741,27 @@ void GLTrace_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, co
 }
 
 GLenum GLTrace_glCheckFramebufferStatus(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLenum retValue = glContext->hooks->gl.glCheckFramebufferStatus(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCheckFramebufferStatus, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCheckFramebufferStatus);
 
     // copy argument target
@@ -587,9 +795,25 @@ GLenum GLTrace_glCheckFramebufferStatus(GLenum target) {
 }
 
 void GLTrace_glClear(GLbitfield mask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClear(mask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClear, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClear);
 
     // copy argument mask
@@ -615,9 +839,28 @@ void GLTrace_glClear(GLbitfield mask) {
 }
 
 void GLTrace_glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearColor(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearColor, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(red);
+        msg.addFloat(green);
+        msg.addFloat(blue);
+        msg.addFloat(alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearColor);
 
     // copy argument red
@@ -661,9 +904,25 @@ void GLTrace_glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alph
 }
 
 void GLTrace_glClearDepthf(GLfloat d) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearDepthf(d);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearDepthf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(d);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearDepthf);
 
     // copy argument d
@@ -689,9 +948,25 @@ void GLTrace_glClearDepthf(GLfloat d) {
 }
 
 void GLTrace_glClearStencil(GLint s) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearStencil(s);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearStencil, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)s);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearStencil);
 
     // copy argument s
@@ -717,9 +992,28 @@ void GLTrace_glClearStencil(GLint s) {
 }
 
 void GLTrace_glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glColorMask(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glColorMask, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)red);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)green);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)blue);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glColorMask);
 
     // copy argument red
@@ -763,9 +1057,25 @@ void GLTrace_glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboole
 }
 
 void GLTrace_glCompileShader(GLuint shader) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCompileShader(shader);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCompileShader, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)shader);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCompileShader);
 
     // copy argument shader
@@ -939,9 +1249,32 @@ void GLTrace_glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset
 }
 
 void GLTrace_glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyTexImage2D(target, level, internalformat, x, y, width, height, border);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyTexImage2D, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)border);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyTexImage2D);
 
     // copy argument target
@@ -1009,9 +1342,32 @@ void GLTrace_glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat,
 }
 
 void GLTrace_glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyTexSubImage2D, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)xoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)yoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyTexSubImage2D);
 
     // copy argument target
@@ -1079,9 +1435,26 @@ void GLTrace_glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLin
 }
 
 GLuint GLTrace_glCreateProgram(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLuint retValue = glContext->hooks->gl.glCreateProgram();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCreateProgram, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCreateProgram);
 
     // call function
@@ -1109,9 +1482,27 @@ GLuint GLTrace_glCreateProgram(void) {
 }
 
 GLuint GLTrace_glCreateShader(GLenum type) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLuint retValue = glContext->hooks->gl.glCreateShader(type);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCreateShader, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)type);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCreateShader);
 
     // copy argument type
@@ -1145,9 +1536,25 @@ GLuint GLTrace_glCreateShader(GLenum type) {
 }
 
 void GLTrace_glCullFace(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCullFace(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCullFace, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCullFace);
 
     // copy argument mode
@@ -1243,9 +1650,25 @@ void GLTrace_glDeleteFramebuffers(GLsizei n, const GLuint * framebuffers) {
 }
 
 void GLTrace_glDeleteProgram(GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDeleteProgram(program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDeleteProgram, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDeleteProgram);
 
     // copy argument program
@@ -1306,9 +1729,25 @@ void GLTrace_glDeleteRenderbuffers(GLsizei n, const GLuint * renderbuffers) {
 }
 
 void GLTrace_glDeleteShader(GLuint shader) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDeleteShader(shader);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDeleteShader, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)shader);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDeleteShader);
 
     // copy argument shader
@@ -1369,9 +1808,25 @@ void GLTrace_glDeleteTextures(GLsizei n, const GLuint * textures) {
 }
 
 void GLTrace_glDepthFunc(GLenum func) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDepthFunc(func);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDepthFunc, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)func);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDepthFunc);
 
     // copy argument func
@@ -1397,9 +1852,25 @@ void GLTrace_glDepthFunc(GLenum func) {
 }
 
 void GLTrace_glDepthMask(GLboolean flag) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDepthMask(flag);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDepthMask, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)flag);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDepthMask);
 
     // copy argument flag
@@ -1425,9 +1896,26 @@ void GLTrace_glDepthMask(GLboolean flag) {
 }
 
 void GLTrace_glDepthRangef(GLfloat n, GLfloat f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDepthRangef(n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDepthRangef, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(n);
+        msg.addFloat(f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDepthRangef);
 
     // copy argument n
@@ -1459,9 +1947,26 @@ void GLTrace_glDepthRangef(GLfloat n, GLfloat f) {
 }
 
 void GLTrace_glDetachShader(GLuint program, GLuint shader) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDetachShader(program, shader);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDetachShader, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)shader);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDetachShader);
 
     // copy argument program
@@ -1493,9 +1998,25 @@ void GLTrace_glDetachShader(GLuint program, GLuint shader) {
 }
 
 void GLTrace_glDisable(GLenum cap) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDisable(cap);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDisable, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)cap);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDisable);
 
     // copy argument cap
@@ -1521,9 +2042,25 @@ void GLTrace_glDisable(GLenum cap) {
 }
 
 void GLTrace_glDisableVertexAttribArray(GLuint index) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDisableVertexAttribArray(index);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDisableVertexAttribArray, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDisableVertexAttribArray);
 
     // copy argument index
@@ -1636,9 +2173,25 @@ void GLTrace_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void
 }
 
 void GLTrace_glEnable(GLenum cap) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEnable(cap);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEnable, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)cap);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEnable);
 
     // copy argument cap
@@ -1664,9 +2217,25 @@ void GLTrace_glEnable(GLenum cap) {
 }
 
 void GLTrace_glEnableVertexAttribArray(GLuint index) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEnableVertexAttribArray(index);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEnableVertexAttribArray, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEnableVertexAttribArray);
 
     // copy argument index
@@ -1692,9 +2261,24 @@ void GLTrace_glEnableVertexAttribArray(GLuint index) {
 }
 
 void GLTrace_glFinish(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFinish();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFinish, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFinish);
 
     // call function
@@ -1714,9 +2298,24 @@ void GLTrace_glFinish(void) {
 }
 
 void GLTrace_glFlush(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFlush();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFlush, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFlush);
 
     // call function
@@ -1736,9 +2335,28 @@ void GLTrace_glFlush(void) {
 }
 
 void GLTrace_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferRenderbuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)renderbuffertarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)renderbuffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferRenderbuffer);
 
     // copy argument target
@@ -1782,9 +2400,29 @@ void GLTrace_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum
 }
 
 void GLTrace_glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferTexture2D(target, attachment, textarget, texture, level);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferTexture2D, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)textarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferTexture2D);
 
     // copy argument target
@@ -1834,9 +2472,25 @@ void GLTrace_glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum tex
 }
 
 void GLTrace_glFrontFace(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFrontFace(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFrontFace, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFrontFace);
 
     // copy argument mode
@@ -1897,9 +2551,25 @@ void GLTrace_glGenBuffers(GLsizei n, GLuint * buffers) {
 }
 
 void GLTrace_glGenerateMipmap(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glGenerateMipmap(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glGenerateMipmap, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glGenerateMipmap);
 
     // copy argument target
@@ -2333,9 +3003,26 @@ void GLTrace_glGetBufferParameteriv(GLenum target, GLenum pname, GLint * params)
 }
 
 GLenum GLTrace_glGetError(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLenum retValue = glContext->hooks->gl.glGetError();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glGetError, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glGetError);
 
     // call function
@@ -3162,9 +3849,26 @@ void GLTrace_glGetVertexAttribPointerv(GLuint index, GLenum pname, void ** point
 }
 
 void GLTrace_glHint(GLenum target, GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glHint(target, mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glHint, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glHint);
 
     // copy argument target
@@ -3196,9 +3900,27 @@ void GLTrace_glHint(GLenum target, GLenum mode) {
 }
 
 GLboolean GLTrace_glIsBuffer(GLuint buffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsBuffer(buffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsBuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buffer);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsBuffer);
 
     // copy argument buffer
@@ -3232,9 +3954,27 @@ GLboolean GLTrace_glIsBuffer(GLuint buffer) {
 }
 
 GLboolean GLTrace_glIsEnabled(GLenum cap) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsEnabled(cap);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsEnabled, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)cap);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsEnabled);
 
     // copy argument cap
@@ -3268,9 +4008,27 @@ GLboolean GLTrace_glIsEnabled(GLenum cap) {
 }
 
 GLboolean GLTrace_glIsFramebuffer(GLuint framebuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsFramebuffer(framebuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsFramebuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)framebuffer);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsFramebuffer);
 
     // copy argument framebuffer
@@ -3304,9 +4062,27 @@ GLboolean GLTrace_glIsFramebuffer(GLuint framebuffer) {
 }
 
 GLboolean GLTrace_glIsProgram(GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsProgram(program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsProgram, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsProgram);
 
     // copy argument program
@@ -3340,9 +4116,27 @@ GLboolean GLTrace_glIsProgram(GLuint program) {
 }
 
 GLboolean GLTrace_glIsRenderbuffer(GLuint renderbuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsRenderbuffer(renderbuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsRenderbuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)renderbuffer);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsRenderbuffer);
 
     // copy argument renderbuffer
@@ -3376,9 +4170,27 @@ GLboolean GLTrace_glIsRenderbuffer(GLuint renderbuffer) {
 }
 
 GLboolean GLTrace_glIsShader(GLuint shader) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsShader(shader);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsShader, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)shader);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsShader);
 
     // copy argument shader
@@ -3412,9 +4224,27 @@ GLboolean GLTrace_glIsShader(GLuint shader) {
 }
 
 GLboolean GLTrace_glIsTexture(GLuint texture) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsTexture(texture);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsTexture, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsTexture);
 
     // copy argument texture
@@ -3448,9 +4278,25 @@ GLboolean GLTrace_glIsTexture(GLuint texture) {
 }
 
 void GLTrace_glLineWidth(GLfloat width) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLineWidth(width);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLineWidth, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(width);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLineWidth);
 
     // copy argument width
@@ -3504,9 +4350,26 @@ void GLTrace_glLinkProgram(GLuint program) {
 }
 
 void GLTrace_glPixelStorei(GLenum pname, GLint param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPixelStorei(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPixelStorei, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPixelStorei);
 
     // copy argument pname
@@ -3538,9 +4401,26 @@ void GLTrace_glPixelStorei(GLenum pname, GLint param) {
 }
 
 void GLTrace_glPolygonOffset(GLfloat factor, GLfloat units) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPolygonOffset(factor, units);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPolygonOffset, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(factor);
+        msg.addFloat(units);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPolygonOffset);
 
     // copy argument factor
@@ -3637,9 +4517,24 @@ void GLTrace_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenu
 }
 
 void GLTrace_glReleaseShaderCompiler(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glReleaseShaderCompiler();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glReleaseShaderCompiler, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glReleaseShaderCompiler);
 
     // call function
@@ -3659,9 +4554,28 @@ void GLTrace_glReleaseShaderCompiler(void) {
 }
 
 void GLTrace_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorage(target, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorage, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorage);
 
     // copy argument target
@@ -3705,9 +4619,26 @@ void GLTrace_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei
 }
 
 void GLTrace_glSampleCoverage(GLfloat value, GLboolean invert) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSampleCoverage(value, invert);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSampleCoverage, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(value);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)invert);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSampleCoverage);
 
     // copy argument value
@@ -3739,9 +4670,28 @@ void GLTrace_glSampleCoverage(GLfloat value, GLboolean invert) {
 }
 
 void GLTrace_glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glScissor(x, y, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glScissor, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glScissor);
 
     // copy argument x
@@ -3887,9 +4837,27 @@ void GLTrace_glShaderSource(GLuint shader, GLsizei count, const GLchar *const* s
 }
 
 void GLTrace_glStencilFunc(GLenum func, GLint ref, GLuint mask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glStencilFunc(func, ref, mask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glStencilFunc, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)func);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)ref);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glStencilFunc);
 
     // copy argument func
@@ -3927,9 +4895,28 @@ void GLTrace_glStencilFunc(GLenum func, GLint ref, GLuint mask) {
 }
 
 void GLTrace_glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glStencilFuncSeparate(face, func, ref, mask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glStencilFuncSeparate, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)face);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)func);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)ref);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glStencilFuncSeparate);
 
     // copy argument face
@@ -3973,9 +4960,25 @@ void GLTrace_glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint m
 }
 
 void GLTrace_glStencilMask(GLuint mask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glStencilMask(mask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glStencilMask, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glStencilMask);
 
     // copy argument mask
@@ -4001,9 +5004,26 @@ void GLTrace_glStencilMask(GLuint mask) {
 }
 
 void GLTrace_glStencilMaskSeparate(GLenum face, GLuint mask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glStencilMaskSeparate(face, mask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glStencilMaskSeparate, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)face);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glStencilMaskSeparate);
 
     // copy argument face
@@ -4035,9 +5055,27 @@ void GLTrace_glStencilMaskSeparate(GLenum face, GLuint mask) {
 }
 
 void GLTrace_glStencilOp(GLenum fail, GLenum zfail, GLenum zpass) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glStencilOp(fail, zfail, zpass);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glStencilOp, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)fail);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)zfail);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)zpass);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glStencilOp);
 
     // copy argument fail
@@ -4075,9 +5113,28 @@ void GLTrace_glStencilOp(GLenum fail, GLenum zfail, GLenum zpass) {
 }
 
 void GLTrace_glStencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glStencilOpSeparate(face, sfail, dpfail, dppass);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glStencilOpSeparate, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)face);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)sfail);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dpfail);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dppass);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glStencilOpSeparate);
 
     // copy argument face
@@ -4198,9 +5255,27 @@ void GLTrace_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsi
 }
 
 void GLTrace_glTexParameterf(GLenum target, GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexParameterf(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexParameterf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexParameterf);
 
     // copy argument target
@@ -4279,9 +5354,27 @@ void GLTrace_glTexParameterfv(GLenum target, GLenum pname, const GLfloat * param
 }
 
 void GLTrace_glTexParameteri(GLenum target, GLenum pname, GLint param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexParameteri(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexParameteri, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexParameteri);
 
     // copy argument target
@@ -4437,9 +5530,26 @@ void GLTrace_glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yo
 }
 
 void GLTrace_glUniform1f(GLint location, GLfloat v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform1f(location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform1f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform1f);
 
     // copy argument location
@@ -4512,9 +5622,26 @@ void GLTrace_glUniform1fv(GLint location, GLsizei count, const GLfloat * value)
 }
 
 void GLTrace_glUniform1i(GLint location, GLint v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform1i(location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform1i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform1i);
 
     // copy argument location
@@ -4587,9 +5714,27 @@ void GLTrace_glUniform1iv(GLint location, GLsizei count, const GLint * value) {
 }
 
 void GLTrace_glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform2f(location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform2f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform2f);
 
     // copy argument location
@@ -4668,9 +5813,27 @@ void GLTrace_glUniform2fv(GLint location, GLsizei count, const GLfloat * value)
 }
 
 void GLTrace_glUniform2i(GLint location, GLint v0, GLint v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform2i(location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform2i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform2i);
 
     // copy argument location
@@ -4749,9 +5912,28 @@ void GLTrace_glUniform2iv(GLint location, GLsizei count, const GLint * value) {
 }
 
 void GLTrace_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform3f(location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform3f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        msg.addFloat(v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform3f);
 
     // copy argument location
@@ -4836,9 +6018,28 @@ void GLTrace_glUniform3fv(GLint location, GLsizei count, const GLfloat * value)
 }
 
 void GLTrace_glUniform3i(GLint location, GLint v0, GLint v1, GLint v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform3i(location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform3i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform3i);
 
     // copy argument location
@@ -4923,9 +6124,29 @@ void GLTrace_glUniform3iv(GLint location, GLsizei count, const GLint * value) {
 }
 
 void GLTrace_glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform4f(location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform4f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        msg.addFloat(v2);
+        msg.addFloat(v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform4f);
 
     // copy argument location
@@ -5016,9 +6237,29 @@ void GLTrace_glUniform4fv(GLint location, GLsizei count, const GLfloat * value)
 }
 
 void GLTrace_glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform4i(location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform4i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform4i);
 
     // copy argument location
@@ -5250,9 +6491,25 @@ void GLTrace_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpo
 }
 
 void GLTrace_glUseProgram(GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUseProgram(program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUseProgram, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUseProgram);
 
     // copy argument program
@@ -5278,9 +6535,25 @@ void GLTrace_glUseProgram(GLuint program) {
 }
 
 void GLTrace_glValidateProgram(GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glValidateProgram(program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glValidateProgram, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glValidateProgram);
 
     // copy argument program
@@ -5306,9 +6579,26 @@ void GLTrace_glValidateProgram(GLuint program) {
 }
 
 void GLTrace_glVertexAttrib1f(GLuint index, GLfloat x) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttrib1f(index, x);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttrib1f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addFloat(x);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttrib1f);
 
     // copy argument index
@@ -5375,9 +6665,27 @@ void GLTrace_glVertexAttrib1fv(GLuint index, const GLfloat * v) {
 }
 
 void GLTrace_glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttrib2f(index, x, y);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttrib2f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addFloat(x);
+        msg.addFloat(y);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttrib2f);
 
     // copy argument index
@@ -5450,9 +6758,28 @@ void GLTrace_glVertexAttrib2fv(GLuint index, const GLfloat * v) {
 }
 
 void GLTrace_glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttrib3f(index, x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttrib3f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addFloat(x);
+        msg.addFloat(y);
+        msg.addFloat(z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttrib3f);
 
     // copy argument index
@@ -5531,9 +6858,29 @@ void GLTrace_glVertexAttrib3fv(GLuint index, const GLfloat * v) {
 }
 
 void GLTrace_glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttrib4f(index, x, y, z, w);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttrib4f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addFloat(x);
+        msg.addFloat(y);
+        msg.addFloat(z);
+        msg.addFloat(w);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttrib4f);
 
     // copy argument index
@@ -5677,9 +7024,28 @@ void GLTrace_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLbool
 }
 
 void GLTrace_glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glViewport(x, y, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glViewport, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glViewport);
 
     // copy argument x
@@ -5723,9 +7089,25 @@ void GLTrace_glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
 }
 
 void GLTrace_glReadBuffer(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glReadBuffer(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glReadBuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glReadBuffer);
 
     // copy argument mode
@@ -5982,9 +7364,33 @@ void GLTrace_glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yo
 }
 
 void GLTrace_glCopyTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyTexSubImage3D(target, level, xoffset, yoffset, zoffset, x, y, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyTexSubImage3D, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)xoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)yoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)zoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyTexSubImage3D);
 
     // copy argument target
@@ -6294,9 +7700,27 @@ void GLTrace_glDeleteQueries(GLsizei n, const GLuint * ids) {
 }
 
 GLboolean GLTrace_glIsQuery(GLuint id) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsQuery(id);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsQuery, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)id);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsQuery);
 
     // copy argument id
@@ -6330,9 +7754,26 @@ GLboolean GLTrace_glIsQuery(GLuint id) {
 }
 
 void GLTrace_glBeginQuery(GLenum target, GLuint id) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBeginQuery(target, id);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBeginQuery, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)id);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBeginQuery);
 
     // copy argument target
@@ -6364,9 +7805,25 @@ void GLTrace_glBeginQuery(GLenum target, GLuint id) {
 }
 
 void GLTrace_glEndQuery(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEndQuery(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEndQuery, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEndQuery);
 
     // copy argument target
@@ -6474,9 +7931,27 @@ void GLTrace_glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint * params) {
 }
 
 GLboolean GLTrace_glUnmapBuffer(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glUnmapBuffer(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUnmapBuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUnmapBuffer);
 
     // copy argument target
@@ -6868,9 +8343,34 @@ void GLTrace_glUniformMatrix4x3fv(GLint location, GLsizei count, GLboolean trans
 }
 
 void GLTrace_glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlitFramebuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcX0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcY0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcX1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcY1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstX0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstY0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstX1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstY1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)filter);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlitFramebuffer);
 
     // copy argument srcX0
@@ -6950,9 +8450,29 @@ void GLTrace_glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY
 }
 
 void GLTrace_glRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorageMultisample(target, samples, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorageMultisample, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorageMultisample);
 
     // copy argument target
@@ -7002,9 +8522,29 @@ void GLTrace_glRenderbufferStorageMultisample(GLenum target, GLsizei samples, GL
 }
 
 void GLTrace_glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferTextureLayer(target, attachment, texture, level, layer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferTextureLayer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)layer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferTextureLayer);
 
     // copy argument target
@@ -7109,9 +8649,27 @@ void * GLTrace_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr lengt
 }
 
 void GLTrace_glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFlushMappedBufferRange(target, offset, length);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFlushMappedBufferRange, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)offset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)length);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFlushMappedBufferRange);
 
     // copy argument target
@@ -7149,9 +8707,25 @@ void GLTrace_glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr
 }
 
 void GLTrace_glBindVertexArray(GLuint array) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindVertexArray(array);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindVertexArray, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)array);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindVertexArray);
 
     // copy argument array
@@ -7247,9 +8821,27 @@ void GLTrace_glGenVertexArrays(GLsizei n, GLuint * arrays) {
 }
 
 GLboolean GLTrace_glIsVertexArray(GLuint array) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsVertexArray(array);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsVertexArray, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)array);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsVertexArray);
 
     // copy argument array
@@ -7324,9 +8916,25 @@ void GLTrace_glGetIntegeri_v(GLenum target, GLuint index, GLint * data) {
 }
 
 void GLTrace_glBeginTransformFeedback(GLenum primitiveMode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBeginTransformFeedback(primitiveMode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBeginTransformFeedback, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)primitiveMode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBeginTransformFeedback);
 
     // copy argument primitiveMode
@@ -7352,9 +8960,24 @@ void GLTrace_glBeginTransformFeedback(GLenum primitiveMode) {
 }
 
 void GLTrace_glEndTransformFeedback(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEndTransformFeedback();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEndTransformFeedback, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEndTransformFeedback);
 
     // call function
@@ -7374,9 +8997,29 @@ void GLTrace_glEndTransformFeedback(void) {
 }
 
 void GLTrace_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindBufferRange(target, index, buffer, offset, size);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindBufferRange, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buffer);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)offset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindBufferRange);
 
     // copy argument target
@@ -7426,9 +9069,27 @@ void GLTrace_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLint
 }
 
 void GLTrace_glBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindBufferBase(target, index, buffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindBufferBase, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindBufferBase);
 
     // copy argument target
@@ -7716,9 +9377,29 @@ void GLTrace_glGetVertexAttribIuiv(GLuint index, GLenum pname, GLuint * params)
 }
 
 void GLTrace_glVertexAttribI4i(GLuint index, GLint x, GLint y, GLint z, GLint w) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribI4i(index, x, y, z, w);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribI4i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)w);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribI4i);
 
     // copy argument index
@@ -7768,9 +9449,29 @@ void GLTrace_glVertexAttribI4i(GLuint index, GLint x, GLint y, GLint z, GLint w)
 }
 
 void GLTrace_glVertexAttribI4ui(GLuint index, GLuint x, GLuint y, GLuint z, GLuint w) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribI4ui(index, x, y, z, w);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribI4ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)w);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribI4ui);
 
     // copy argument index
@@ -7974,9 +9675,26 @@ GLint GLTrace_glGetFragDataLocation(GLuint program, const GLchar * name) {
 }
 
 void GLTrace_glUniform1ui(GLint location, GLuint v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform1ui(location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform1ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform1ui);
 
     // copy argument location
@@ -8008,9 +9726,27 @@ void GLTrace_glUniform1ui(GLint location, GLuint v0) {
 }
 
 void GLTrace_glUniform2ui(GLint location, GLuint v0, GLuint v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform2ui(location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform2ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform2ui);
 
     // copy argument location
@@ -8048,9 +9784,28 @@ void GLTrace_glUniform2ui(GLint location, GLuint v0, GLuint v1) {
 }
 
 void GLTrace_glUniform3ui(GLint location, GLuint v0, GLuint v1, GLuint v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform3ui(location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform3ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform3ui);
 
     // copy argument location
@@ -8094,9 +9849,29 @@ void GLTrace_glUniform3ui(GLint location, GLuint v0, GLuint v1, GLuint v2) {
 }
 
 void GLTrace_glUniform4ui(GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniform4ui(location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUniform4ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUniform4ui);
 
     // copy argument location
@@ -8433,9 +10208,28 @@ void GLTrace_glClearBufferfv(GLenum buffer, GLint drawbuffer, const GLfloat * va
 }
 
 void GLTrace_glClearBufferfi(GLenum buffer, GLint drawbuffer, GLfloat depth, GLint stencil) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearBufferfi(buffer, drawbuffer, depth, stencil);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearBufferfi, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)buffer);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)drawbuffer);
+        msg.addFloat(depth);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)stencil);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearBufferfi);
 
     // copy argument buffer
@@ -8522,9 +10316,29 @@ const GLubyte * GLTrace_glGetStringi(GLenum name, GLuint index) {
 }
 
 void GLTrace_glCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyBufferSubData(readTarget, writeTarget, readOffset, writeOffset, size);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyBufferSubData, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)readTarget);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)writeTarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)readOffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)writeOffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyBufferSubData);
 
     // copy argument readTarget
@@ -8820,12 +10634,30 @@ void GLTrace_glGetActiveUniformBlockName(GLuint program, GLuint uniformBlockInde
 }
 
 void GLTrace_glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
-    glmsg.set_function(GLMessage::glUniformBlockBinding);
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUniformBlockBinding(program, uniformBlockIndex, uniformBlockBinding);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
 
-    // copy argument program
+        CompactGLMessage msg(GLMessage::glUniformBlockBinding, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)uniformBlockIndex);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)uniformBlockBinding);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
+    glmsg.set_function(GLMessage::glUniformBlockBinding);
+
+    // copy argument program
     GLMessage_DataType *arg_program = glmsg.add_args();
     arg_program->set_isarray(false);
     arg_program->set_type(GLMessage::DataType::INT);
@@ -8860,9 +10692,28 @@ void GLTrace_glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLu
 }
 
 void GLTrace_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawArraysInstanced(mode, first, count, instancecount);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawArraysInstanced, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)first);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)count);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)instancecount);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawArraysInstanced);
 
     // copy argument mode
@@ -9400,9 +11251,27 @@ void GLTrace_glDeleteSamplers(GLsizei count, const GLuint * samplers) {
 }
 
 GLboolean GLTrace_glIsSampler(GLuint sampler) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsSampler(sampler);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsSampler, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)sampler);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsSampler);
 
     // copy argument sampler
@@ -9436,9 +11305,26 @@ GLboolean GLTrace_glIsSampler(GLuint sampler) {
 }
 
 void GLTrace_glBindSampler(GLuint unit, GLuint sampler) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindSampler(unit, sampler);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindSampler, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)unit);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)sampler);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindSampler);
 
     // copy argument unit
@@ -9470,9 +11356,27 @@ void GLTrace_glBindSampler(GLuint unit, GLuint sampler) {
 }
 
 void GLTrace_glSamplerParameteri(GLuint sampler, GLenum pname, GLint param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSamplerParameteri(sampler, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSamplerParameteri, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)sampler);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSamplerParameteri);
 
     // copy argument sampler
@@ -9551,9 +11455,27 @@ void GLTrace_glSamplerParameteriv(GLuint sampler, GLenum pname, const GLint * pa
 }
 
 void GLTrace_glSamplerParameterf(GLuint sampler, GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSamplerParameterf(sampler, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSamplerParameterf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)sampler);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSamplerParameterf);
 
     // copy argument sampler
@@ -9714,9 +11636,26 @@ void GLTrace_glGetSamplerParameterfv(GLuint sampler, GLenum pname, GLfloat * par
 }
 
 void GLTrace_glVertexAttribDivisor(GLuint index, GLuint divisor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribDivisor(index, divisor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribDivisor, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)divisor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribDivisor);
 
     // copy argument index
@@ -9748,9 +11687,26 @@ void GLTrace_glVertexAttribDivisor(GLuint index, GLuint divisor) {
 }
 
 void GLTrace_glBindTransformFeedback(GLenum target, GLuint id) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindTransformFeedback(target, id);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindTransformFeedback, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)id);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindTransformFeedback);
 
     // copy argument target
@@ -9852,9 +11808,27 @@ void GLTrace_glGenTransformFeedbacks(GLsizei n, GLuint * ids) {
 }
 
 GLboolean GLTrace_glIsTransformFeedback(GLuint id) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsTransformFeedback(id);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsTransformFeedback, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)id);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsTransformFeedback);
 
     // copy argument id
@@ -9888,9 +11862,24 @@ GLboolean GLTrace_glIsTransformFeedback(GLuint id) {
 }
 
 void GLTrace_glPauseTransformFeedback(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPauseTransformFeedback();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPauseTransformFeedback, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPauseTransformFeedback);
 
     // call function
@@ -9910,9 +11899,24 @@ void GLTrace_glPauseTransformFeedback(void) {
 }
 
 void GLTrace_glResumeTransformFeedback(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glResumeTransformFeedback();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glResumeTransformFeedback, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glResumeTransformFeedback);
 
     // call function
@@ -10034,9 +12038,27 @@ void GLTrace_glProgramBinary(GLuint program, GLenum binaryFormat, const void * b
 }
 
 void GLTrace_glProgramParameteri(GLuint program, GLenum pname, GLint value) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramParameteri(program, pname, value);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramParameteri, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)value);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramParameteri);
 
     // copy argument program
@@ -10180,9 +12202,29 @@ void GLTrace_glInvalidateSubFramebuffer(GLenum target, GLsizei numAttachments, c
 }
 
 void GLTrace_glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexStorage2D(target, levels, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexStorage2D, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexStorage2D);
 
     // copy argument target
@@ -10232,9 +12274,30 @@ void GLTrace_glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat
 }
 
 void GLTrace_glTexStorage3D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexStorage3D(target, levels, internalformat, width, height, depth);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexStorage3D, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)depth);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexStorage3D);
 
     // copy argument target
@@ -10343,9 +12406,27 @@ void GLTrace_glGetInternalformativ(GLenum target, GLenum internalformat, GLenum
 }
 
 void GLTrace_glDispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDispatchCompute(num_groups_x, num_groups_y, num_groups_z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDispatchCompute, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)num_groups_x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)num_groups_y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)num_groups_z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDispatchCompute);
 
     // copy argument num_groups_x
@@ -10383,9 +12464,25 @@ void GLTrace_glDispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint
 }
 
 void GLTrace_glDispatchComputeIndirect(GLintptr indirect) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDispatchComputeIndirect(indirect);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDispatchComputeIndirect, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)indirect);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDispatchComputeIndirect);
 
     // copy argument indirect
@@ -10487,9 +12584,27 @@ void GLTrace_glDrawElementsIndirect(GLenum mode, GLenum type, const void * indir
 }
 
 void GLTrace_glFramebufferParameteri(GLenum target, GLenum pname, GLint param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferParameteri(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferParameteri, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferParameteri);
 
     // copy argument target
@@ -10846,9 +12961,27 @@ GLint GLTrace_glGetProgramResourceLocation(GLuint program, GLenum programInterfa
 }
 
 void GLTrace_glUseProgramStages(GLuint pipeline, GLbitfield stages, GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUseProgramStages(pipeline, stages, program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUseProgramStages, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)stages);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUseProgramStages);
 
     // copy argument pipeline
@@ -10886,9 +13019,26 @@ void GLTrace_glUseProgramStages(GLuint pipeline, GLbitfield stages, GLuint progr
 }
 
 void GLTrace_glActiveShaderProgram(GLuint pipeline, GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glActiveShaderProgram(pipeline, program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glActiveShaderProgram, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glActiveShaderProgram);
 
     // copy argument pipeline
@@ -10969,9 +13119,25 @@ GLuint GLTrace_glCreateShaderProgramv(GLenum type, GLsizei count, const GLchar *
 }
 
 void GLTrace_glBindProgramPipeline(GLuint pipeline) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindProgramPipeline(pipeline);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindProgramPipeline, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindProgramPipeline);
 
     // copy argument pipeline
@@ -11067,9 +13233,27 @@ void GLTrace_glGenProgramPipelines(GLsizei n, GLuint * pipelines) {
 }
 
 GLboolean GLTrace_glIsProgramPipeline(GLuint pipeline) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsProgramPipeline(pipeline);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsProgramPipeline, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsProgramPipeline);
 
     // copy argument pipeline
@@ -11144,9 +13328,27 @@ void GLTrace_glGetProgramPipelineiv(GLuint pipeline, GLenum pname, GLint * param
 }
 
 void GLTrace_glProgramUniform1i(GLuint program, GLint location, GLint v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform1i(program, location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform1i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform1i);
 
     // copy argument program
@@ -11184,9 +13386,28 @@ void GLTrace_glProgramUniform1i(GLuint program, GLint location, GLint v0) {
 }
 
 void GLTrace_glProgramUniform2i(GLuint program, GLint location, GLint v0, GLint v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform2i(program, location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform2i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform2i);
 
     // copy argument program
@@ -11230,9 +13451,29 @@ void GLTrace_glProgramUniform2i(GLuint program, GLint location, GLint v0, GLint
 }
 
 void GLTrace_glProgramUniform3i(GLuint program, GLint location, GLint v0, GLint v1, GLint v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform3i(program, location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform3i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform3i);
 
     // copy argument program
@@ -11282,9 +13523,30 @@ void GLTrace_glProgramUniform3i(GLuint program, GLint location, GLint v0, GLint
 }
 
 void GLTrace_glProgramUniform4i(GLuint program, GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform4i(program, location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform4i, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform4i);
 
     // copy argument program
@@ -11340,9 +13602,27 @@ void GLTrace_glProgramUniform4i(GLuint program, GLint location, GLint v0, GLint
 }
 
 void GLTrace_glProgramUniform1ui(GLuint program, GLint location, GLuint v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform1ui(program, location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform1ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform1ui);
 
     // copy argument program
@@ -11380,9 +13660,28 @@ void GLTrace_glProgramUniform1ui(GLuint program, GLint location, GLuint v0) {
 }
 
 void GLTrace_glProgramUniform2ui(GLuint program, GLint location, GLuint v0, GLuint v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform2ui(program, location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform2ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform2ui);
 
     // copy argument program
@@ -11426,9 +13725,29 @@ void GLTrace_glProgramUniform2ui(GLuint program, GLint location, GLuint v0, GLui
 }
 
 void GLTrace_glProgramUniform3ui(GLuint program, GLint location, GLuint v0, GLuint v1, GLuint v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform3ui(program, location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform3ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform3ui);
 
     // copy argument program
@@ -11478,9 +13797,30 @@ void GLTrace_glProgramUniform3ui(GLuint program, GLint location, GLuint v0, GLui
 }
 
 void GLTrace_glProgramUniform4ui(GLuint program, GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform4ui(program, location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform4ui, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform4ui);
 
     // copy argument program
@@ -11536,9 +13876,27 @@ void GLTrace_glProgramUniform4ui(GLuint program, GLint location, GLuint v0, GLui
 }
 
 void GLTrace_glProgramUniform1f(GLuint program, GLint location, GLfloat v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform1f(program, location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform1f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform1f);
 
     // copy argument program
@@ -11576,9 +13934,28 @@ void GLTrace_glProgramUniform1f(GLuint program, GLint location, GLfloat v0) {
 }
 
 void GLTrace_glProgramUniform2f(GLuint program, GLint location, GLfloat v0, GLfloat v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform2f(program, location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform2f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform2f);
 
     // copy argument program
@@ -11622,9 +13999,29 @@ void GLTrace_glProgramUniform2f(GLuint program, GLint location, GLfloat v0, GLfl
 }
 
 void GLTrace_glProgramUniform3f(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform3f(program, location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform3f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        msg.addFloat(v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform3f);
 
     // copy argument program
@@ -11674,9 +14071,30 @@ void GLTrace_glProgramUniform3f(GLuint program, GLint location, GLfloat v0, GLfl
 }
 
 void GLTrace_glProgramUniform4f(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform4f(program, location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform4f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        msg.addFloat(v2);
+        msg.addFloat(v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform4f);
 
     // copy argument program
@@ -12773,9 +15191,25 @@ void GLTrace_glProgramUniformMatrix4x3fv(GLuint program, GLint location, GLsizei
 }
 
 void GLTrace_glValidateProgramPipeline(GLuint pipeline) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glValidateProgramPipeline(pipeline);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glValidateProgramPipeline, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glValidateProgramPipeline);
 
     // copy argument pipeline
@@ -12849,9 +15283,31 @@ void GLTrace_glGetProgramPipelineInfoLog(GLuint pipeline, GLsizei bufSize, GLsiz
 }
 
 void GLTrace_glBindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindImageTexture(unit, texture, level, layered, layer, access, format);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindImageTexture, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)unit);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)layered);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)layer);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)access);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)format);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindImageTexture);
 
     // copy argument unit
@@ -12954,9 +15410,25 @@ void GLTrace_glGetBooleani_v(GLenum target, GLuint index, GLboolean * data) {
 }
 
 void GLTrace_glMemoryBarrier(GLbitfield barriers) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMemoryBarrier(barriers);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMemoryBarrier, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)barriers);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMemoryBarrier);
 
     // copy argument barriers
@@ -12982,9 +15454,25 @@ void GLTrace_glMemoryBarrier(GLbitfield barriers) {
 }
 
 void GLTrace_glMemoryBarrierByRegion(GLbitfield barriers) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMemoryBarrierByRegion(barriers);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMemoryBarrierByRegion, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)barriers);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMemoryBarrierByRegion);
 
     // copy argument barriers
@@ -13010,9 +15498,30 @@ void GLTrace_glMemoryBarrierByRegion(GLbitfield barriers) {
 }
 
 void GLTrace_glTexStorage2DMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexStorage2DMultisample(target, samples, internalformat, width, height, fixedsamplelocations);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexStorage2DMultisample, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)fixedsamplelocations);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexStorage2DMultisample);
 
     // copy argument target
@@ -13109,9 +15618,26 @@ void GLTrace_glGetMultisamplefv(GLenum pname, GLuint index, GLfloat * val) {
 }
 
 void GLTrace_glSampleMaski(GLuint maskNumber, GLbitfield mask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSampleMaski(maskNumber, mask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSampleMaski, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)maskNumber);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSampleMaski);
 
     // copy argument maskNumber
@@ -13237,9 +15763,28 @@ void GLTrace_glGetTexLevelParameterfv(GLenum target, GLint level, GLenum pname,
 }
 
 void GLTrace_glBindVertexBuffer(GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindVertexBuffer(bindingindex, buffer, offset, stride);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindVertexBuffer, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)bindingindex);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buffer);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)offset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)stride);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindVertexBuffer);
 
     // copy argument bindingindex
@@ -13283,9 +15828,29 @@ void GLTrace_glBindVertexBuffer(GLuint bindingindex, GLuint buffer, GLintptr off
 }
 
 void GLTrace_glVertexAttribFormat(GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribFormat(attribindex, size, type, normalized, relativeoffset);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribFormat, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)attribindex);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)type);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)normalized);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)relativeoffset);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribFormat);
 
     // copy argument attribindex
@@ -13335,9 +15900,28 @@ void GLTrace_glVertexAttribFormat(GLuint attribindex, GLint size, GLenum type, G
 }
 
 void GLTrace_glVertexAttribIFormat(GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribIFormat(attribindex, size, type, relativeoffset);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribIFormat, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)attribindex);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)type);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)relativeoffset);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribIFormat);
 
     // copy argument attribindex
@@ -13381,9 +15965,26 @@ void GLTrace_glVertexAttribIFormat(GLuint attribindex, GLint size, GLenum type,
 }
 
 void GLTrace_glVertexAttribBinding(GLuint attribindex, GLuint bindingindex) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribBinding(attribindex, bindingindex);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribBinding, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)attribindex);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)bindingindex);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribBinding);
 
     // copy argument attribindex
@@ -13415,9 +16016,26 @@ void GLTrace_glVertexAttribBinding(GLuint attribindex, GLuint bindingindex) {
 }
 
 void GLTrace_glVertexBindingDivisor(GLuint bindingindex, GLuint divisor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexBindingDivisor(bindingindex, divisor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexBindingDivisor, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)bindingindex);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)divisor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexBindingDivisor);
 
     // copy argument bindingindex
@@ -13452,9 +16070,24 @@ void GLTrace_glVertexBindingDivisor(GLuint bindingindex, GLuint divisor) {
 // Definitions for GL2Ext APIs
 
 void GLTrace_glBlendBarrierKHR(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendBarrierKHR();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendBarrierKHR, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendBarrierKHR);
 
     // call function
@@ -13759,9 +16392,24 @@ void GLTrace_glPushDebugGroupKHR(GLenum source, GLuint id, GLsizei length, const
 }
 
 void GLTrace_glPopDebugGroupKHR(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPopDebugGroupKHR();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPopDebugGroupKHR, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPopDebugGroupKHR);
 
     // call function
@@ -14223,9 +16871,27 @@ void * GLTrace_glMapBufferOES(GLenum target, GLenum access) {
 }
 
 GLboolean GLTrace_glUnmapBufferOES(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glUnmapBufferOES(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUnmapBufferOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUnmapBufferOES);
 
     // copy argument target
@@ -14300,9 +16966,25 @@ void GLTrace_glGetBufferPointervOES(GLenum target, GLenum pname, void ** params)
 }
 
 void GLTrace_glMinSampleShadingOES(GLfloat value) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMinSampleShadingOES(value);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMinSampleShadingOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(value);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMinSampleShadingOES);
 
     // copy argument value
@@ -14500,9 +17182,33 @@ void GLTrace_glTexSubImage3DOES(GLenum target, GLint level, GLint xoffset, GLint
 }
 
 void GLTrace_glCopyTexSubImage3DOES(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyTexSubImage3DOES(target, level, xoffset, yoffset, zoffset, x, y, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyTexSubImage3DOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)xoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)yoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)zoffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyTexSubImage3DOES);
 
     // copy argument target
@@ -14742,9 +17448,30 @@ void GLTrace_glCompressedTexSubImage3DOES(GLenum target, GLint level, GLint xoff
 }
 
 void GLTrace_glFramebufferTexture3DOES(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLint zoffset) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferTexture3DOES(target, attachment, textarget, texture, level, zoffset);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferTexture3DOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)textarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)zoffset);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferTexture3DOES);
 
     // copy argument target
@@ -14800,9 +17527,31 @@ void GLTrace_glFramebufferTexture3DOES(GLenum target, GLenum attachment, GLenum
 }
 
 void GLTrace_glTexStorage3DMultisampleOES(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLboolean fixedsamplelocations) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexStorage3DMultisampleOES(target, samples, internalformat, width, height, depth, fixedsamplelocations);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexStorage3DMultisampleOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)depth);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)fixedsamplelocations);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexStorage3DMultisampleOES);
 
     // copy argument target
@@ -14864,9 +17613,25 @@ void GLTrace_glTexStorage3DMultisampleOES(GLenum target, GLsizei samples, GLenum
 }
 
 void GLTrace_glBindVertexArrayOES(GLuint array) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindVertexArrayOES(array);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindVertexArrayOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)array);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindVertexArrayOES);
 
     // copy argument array
@@ -14962,9 +17727,27 @@ void GLTrace_glGenVertexArraysOES(GLsizei n, GLuint * arrays) {
 }
 
 GLboolean GLTrace_glIsVertexArrayOES(GLuint array) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsVertexArrayOES(array);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsVertexArrayOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)array);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsVertexArrayOES);
 
     // copy argument array
@@ -15367,9 +18150,25 @@ void GLTrace_glSelectPerfMonitorCountersAMD(GLuint monitor, GLboolean enable, GL
 }
 
 void GLTrace_glBeginPerfMonitorAMD(GLuint monitor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBeginPerfMonitorAMD(monitor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBeginPerfMonitorAMD, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)monitor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBeginPerfMonitorAMD);
 
     // copy argument monitor
@@ -15395,9 +18194,25 @@ void GLTrace_glBeginPerfMonitorAMD(GLuint monitor) {
 }
 
 void GLTrace_glEndPerfMonitorAMD(GLuint monitor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEndPerfMonitorAMD(monitor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEndPerfMonitorAMD, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)monitor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEndPerfMonitorAMD);
 
     // copy argument monitor
@@ -15477,9 +18292,34 @@ void GLTrace_glGetPerfMonitorCounterDataAMD(GLuint monitor, GLenum pname, GLsize
 }
 
 void GLTrace_glBlitFramebufferANGLE(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlitFramebufferANGLE(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlitFramebufferANGLE, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcX0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcY0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcX1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcY1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstX0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstY0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstX1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstY1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)filter);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlitFramebufferANGLE);
 
     // copy argument srcX0
@@ -15559,9 +18399,29 @@ void GLTrace_glBlitFramebufferANGLE(GLint srcX0, GLint srcY0, GLint srcX1, GLint
 }
 
 void GLTrace_glRenderbufferStorageMultisampleANGLE(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorageMultisampleANGLE(target, samples, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorageMultisampleANGLE, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorageMultisampleANGLE);
 
     // copy argument target
@@ -15611,9 +18471,28 @@ void GLTrace_glRenderbufferStorageMultisampleANGLE(GLenum target, GLsizei sample
 }
 
 void GLTrace_glDrawArraysInstancedANGLE(GLenum mode, GLint first, GLsizei count, GLsizei primcount) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawArraysInstancedANGLE(mode, first, count, primcount);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawArraysInstancedANGLE, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)first);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)count);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)primcount);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawArraysInstancedANGLE);
 
     // copy argument mode
@@ -15710,9 +18589,26 @@ void GLTrace_glDrawElementsInstancedANGLE(GLenum mode, GLsizei count, GLenum typ
 }
 
 void GLTrace_glVertexAttribDivisorANGLE(GLuint index, GLuint divisor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribDivisorANGLE(index, divisor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribDivisorANGLE, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)divisor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribDivisorANGLE);
 
     // copy argument index
@@ -15792,9 +18688,28 @@ void GLTrace_glGetTranslatedShaderSourceANGLE(GLuint shader, GLsizei bufsize, GL
 }
 
 void GLTrace_glCopyTextureLevelsAPPLE(GLuint destinationTexture, GLuint sourceTexture, GLint sourceBaseLevel, GLsizei sourceLevelCount) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyTextureLevelsAPPLE(destinationTexture, sourceTexture, sourceBaseLevel, sourceLevelCount);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyTextureLevelsAPPLE, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)destinationTexture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)sourceTexture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)sourceBaseLevel);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)sourceLevelCount);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyTextureLevelsAPPLE);
 
     // copy argument destinationTexture
@@ -15838,9 +18753,29 @@ void GLTrace_glCopyTextureLevelsAPPLE(GLuint destinationTexture, GLuint sourceTe
 }
 
 void GLTrace_glRenderbufferStorageMultisampleAPPLE(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorageMultisampleAPPLE(target, samples, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorageMultisampleAPPLE, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorageMultisampleAPPLE);
 
     // copy argument target
@@ -15890,9 +18825,24 @@ void GLTrace_glRenderbufferStorageMultisampleAPPLE(GLenum target, GLsizei sample
 }
 
 void GLTrace_glResolveMultisampleFramebufferAPPLE(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glResolveMultisampleFramebufferAPPLE();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glResolveMultisampleFramebufferAPPLE, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glResolveMultisampleFramebufferAPPLE);
 
     // call function
@@ -16201,9 +19151,39 @@ void GLTrace_glGetSyncivAPPLE(GLsync sync, GLenum pname, GLsizei bufSize, GLsize
 }
 
 void GLTrace_glCopyImageSubDataEXT(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ, GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyImageSubDataEXT(srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyImageSubDataEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcName);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)srcTarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcLevel);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcX);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcY);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcZ);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstName);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dstTarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstLevel);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstX);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstY);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstZ);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcWidth);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcHeight);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcDepth);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyImageSubDataEXT);
 
     // copy argument srcName
@@ -16484,9 +19464,24 @@ void GLTrace_glPushGroupMarkerEXT(GLsizei length, const GLchar * marker) {
 }
 
 void GLTrace_glPopGroupMarkerEXT(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPopGroupMarkerEXT();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPopGroupMarkerEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPopGroupMarkerEXT);
 
     // call function
@@ -16617,9 +19612,27 @@ void GLTrace_glDeleteQueriesEXT(GLsizei n, const GLuint * ids) {
 }
 
 GLboolean GLTrace_glIsQueryEXT(GLuint id) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsQueryEXT(id);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsQueryEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)id);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsQueryEXT);
 
     // copy argument id
@@ -16653,9 +19666,26 @@ GLboolean GLTrace_glIsQueryEXT(GLuint id) {
 }
 
 void GLTrace_glBeginQueryEXT(GLenum target, GLuint id) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBeginQueryEXT(target, id);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBeginQueryEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)id);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBeginQueryEXT);
 
     // copy argument target
@@ -16687,9 +19717,25 @@ void GLTrace_glBeginQueryEXT(GLenum target, GLuint id) {
 }
 
 void GLTrace_glEndQueryEXT(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEndQueryEXT(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEndQueryEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEndQueryEXT);
 
     // copy argument target
@@ -16715,9 +19761,26 @@ void GLTrace_glEndQueryEXT(GLenum target) {
 }
 
 void GLTrace_glQueryCounterEXT(GLuint id, GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glQueryCounterEXT(id, target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glQueryCounterEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)id);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glQueryCounterEXT);
 
     // copy argument id
@@ -16989,9 +20052,26 @@ void GLTrace_glDrawBuffersEXT(GLsizei n, const GLenum * bufs) {
 }
 
 void GLTrace_glEnableiEXT(GLenum target, GLuint index) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEnableiEXT(target, index);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEnableiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEnableiEXT);
 
     // copy argument target
@@ -17023,9 +20103,26 @@ void GLTrace_glEnableiEXT(GLenum target, GLuint index) {
 }
 
 void GLTrace_glDisableiEXT(GLenum target, GLuint index) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDisableiEXT(target, index);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDisableiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDisableiEXT);
 
     // copy argument target
@@ -17057,9 +20154,26 @@ void GLTrace_glDisableiEXT(GLenum target, GLuint index) {
 }
 
 void GLTrace_glBlendEquationiEXT(GLuint buf, GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendEquationiEXT(buf, mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendEquationiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buf);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendEquationiEXT);
 
     // copy argument buf
@@ -17091,9 +20205,27 @@ void GLTrace_glBlendEquationiEXT(GLuint buf, GLenum mode) {
 }
 
 void GLTrace_glBlendEquationSeparateiEXT(GLuint buf, GLenum modeRGB, GLenum modeAlpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendEquationSeparateiEXT(buf, modeRGB, modeAlpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendEquationSeparateiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buf);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)modeRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)modeAlpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendEquationSeparateiEXT);
 
     // copy argument buf
@@ -17131,9 +20263,27 @@ void GLTrace_glBlendEquationSeparateiEXT(GLuint buf, GLenum modeRGB, GLenum mode
 }
 
 void GLTrace_glBlendFunciEXT(GLuint buf, GLenum src, GLenum dst) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendFunciEXT(buf, src, dst);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendFunciEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buf);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)src);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dst);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendFunciEXT);
 
     // copy argument buf
@@ -17171,9 +20321,29 @@ void GLTrace_glBlendFunciEXT(GLuint buf, GLenum src, GLenum dst) {
 }
 
 void GLTrace_glBlendFuncSeparateiEXT(GLuint buf, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendFuncSeparateiEXT(buf, srcRGB, dstRGB, srcAlpha, dstAlpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendFuncSeparateiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buf);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)srcRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dstRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)srcAlpha);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dstAlpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendFuncSeparateiEXT);
 
     // copy argument buf
@@ -17223,9 +20393,29 @@ void GLTrace_glBlendFuncSeparateiEXT(GLuint buf, GLenum srcRGB, GLenum dstRGB, G
 }
 
 void GLTrace_glColorMaskiEXT(GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glColorMaskiEXT(index, r, g, b, a);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glColorMaskiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)r);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)g);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)b);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)a);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glColorMaskiEXT);
 
     // copy argument index
@@ -17275,9 +20465,28 @@ void GLTrace_glColorMaskiEXT(GLuint index, GLboolean r, GLboolean g, GLboolean b
 }
 
 GLboolean GLTrace_glIsEnablediEXT(GLenum target, GLuint index) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsEnablediEXT(target, index);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsEnablediEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsEnablediEXT);
 
     // copy argument target
@@ -17317,9 +20526,28 @@ GLboolean GLTrace_glIsEnablediEXT(GLenum target, GLuint index) {
 }
 
 void GLTrace_glDrawArraysInstancedEXT(GLenum mode, GLint start, GLsizei count, GLsizei primcount) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawArraysInstancedEXT(mode, start, count, primcount);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawArraysInstancedEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)start);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)count);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)primcount);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawArraysInstancedEXT);
 
     // copy argument mode
@@ -17416,9 +20644,28 @@ void GLTrace_glDrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type,
 }
 
 void GLTrace_glFramebufferTextureEXT(GLenum target, GLenum attachment, GLuint texture, GLint level) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferTextureEXT(target, attachment, texture, level);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferTextureEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferTextureEXT);
 
     // copy argument target
@@ -17462,9 +20709,26 @@ void GLTrace_glFramebufferTextureEXT(GLenum target, GLenum attachment, GLuint te
 }
 
 void GLTrace_glVertexAttribDivisorEXT(GLuint index, GLuint divisor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribDivisorEXT(index, divisor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribDivisorEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)divisor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribDivisorEXT);
 
     // copy argument index
@@ -17551,9 +20815,27 @@ void * GLTrace_glMapBufferRangeEXT(GLenum target, GLintptr offset, GLsizeiptr le
 }
 
 void GLTrace_glFlushMappedBufferRangeEXT(GLenum target, GLintptr offset, GLsizeiptr length) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFlushMappedBufferRangeEXT(target, offset, length);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFlushMappedBufferRangeEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)offset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)length);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFlushMappedBufferRangeEXT);
 
     // copy argument target
@@ -17693,9 +20975,29 @@ void GLTrace_glMultiDrawElementsEXT(GLenum mode, const GLsizei * count, GLenum t
 }
 
 void GLTrace_glRenderbufferStorageMultisampleEXT(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorageMultisampleEXT(target, samples, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorageMultisampleEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorageMultisampleEXT);
 
     // copy argument target
@@ -17745,9 +21047,30 @@ void GLTrace_glRenderbufferStorageMultisampleEXT(GLenum target, GLsizei samples,
 }
 
 void GLTrace_glFramebufferTexture2DMultisampleEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLsizei samples) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferTexture2DMultisampleEXT(target, attachment, textarget, texture, level, samples);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferTexture2DMultisampleEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)textarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferTexture2DMultisampleEXT);
 
     // copy argument target
@@ -17803,9 +21126,26 @@ void GLTrace_glFramebufferTexture2DMultisampleEXT(GLenum target, GLenum attachme
 }
 
 void GLTrace_glReadBufferIndexedEXT(GLenum src, GLint index) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glReadBufferIndexedEXT(src, index);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glReadBufferIndexedEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)src);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glReadBufferIndexedEXT);
 
     // copy argument src
@@ -17920,9 +21260,32 @@ void GLTrace_glGetIntegeri_vEXT(GLenum target, GLuint index, GLint * data) {
 }
 
 void GLTrace_glPrimitiveBoundingBoxEXT(GLfloat minX, GLfloat minY, GLfloat minZ, GLfloat minW, GLfloat maxX, GLfloat maxY, GLfloat maxZ, GLfloat maxW) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPrimitiveBoundingBoxEXT(minX, minY, minZ, minW, maxX, maxY, maxZ, maxW);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPrimitiveBoundingBoxEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(minX);
+        msg.addFloat(minY);
+        msg.addFloat(minZ);
+        msg.addFloat(minW);
+        msg.addFloat(maxX);
+        msg.addFloat(maxY);
+        msg.addFloat(maxZ);
+        msg.addFloat(maxW);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPrimitiveBoundingBoxEXT);
 
     // copy argument minX
@@ -17990,9 +21353,26 @@ void GLTrace_glPrimitiveBoundingBoxEXT(GLfloat minX, GLfloat minY, GLfloat minZ,
 }
 
 GLenum GLTrace_glGetGraphicsResetStatusEXT(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLenum retValue = glContext->hooks->gl.glGetGraphicsResetStatusEXT();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glGetGraphicsResetStatusEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glGetGraphicsResetStatusEXT);
 
     // call function
@@ -18185,9 +21565,26 @@ void GLTrace_glGetnUniformivEXT(GLuint program, GLint location, GLsizei bufSize,
 }
 
 void GLTrace_glActiveShaderProgramEXT(GLuint pipeline, GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glActiveShaderProgramEXT(pipeline, program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glActiveShaderProgramEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glActiveShaderProgramEXT);
 
     // copy argument pipeline
@@ -18219,9 +21616,25 @@ void GLTrace_glActiveShaderProgramEXT(GLuint pipeline, GLuint program) {
 }
 
 void GLTrace_glBindProgramPipelineEXT(GLuint pipeline) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindProgramPipelineEXT(pipeline);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindProgramPipelineEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindProgramPipelineEXT);
 
     // copy argument pipeline
@@ -18455,9 +21868,27 @@ void GLTrace_glGetProgramPipelineivEXT(GLuint pipeline, GLenum pname, GLint * pa
 }
 
 GLboolean GLTrace_glIsProgramPipelineEXT(GLuint pipeline) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsProgramPipelineEXT(pipeline);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsProgramPipelineEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsProgramPipelineEXT);
 
     // copy argument pipeline
@@ -18491,9 +21922,27 @@ GLboolean GLTrace_glIsProgramPipelineEXT(GLuint pipeline) {
 }
 
 void GLTrace_glProgramParameteriEXT(GLuint program, GLenum pname, GLint value) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramParameteriEXT(program, pname, value);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramParameteriEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)value);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramParameteriEXT);
 
     // copy argument program
@@ -18531,9 +21980,27 @@ void GLTrace_glProgramParameteriEXT(GLuint program, GLenum pname, GLint value) {
 }
 
 void GLTrace_glProgramUniform1fEXT(GLuint program, GLint location, GLfloat v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform1fEXT(program, location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform1fEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform1fEXT);
 
     // copy argument program
@@ -18618,9 +22085,27 @@ void GLTrace_glProgramUniform1fvEXT(GLuint program, GLint location, GLsizei coun
 }
 
 void GLTrace_glProgramUniform1iEXT(GLuint program, GLint location, GLint v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform1iEXT(program, location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform1iEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform1iEXT);
 
     // copy argument program
@@ -18705,9 +22190,28 @@ void GLTrace_glProgramUniform1ivEXT(GLuint program, GLint location, GLsizei coun
 }
 
 void GLTrace_glProgramUniform2fEXT(GLuint program, GLint location, GLfloat v0, GLfloat v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform2fEXT(program, location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform2fEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform2fEXT);
 
     // copy argument program
@@ -18798,9 +22302,28 @@ void GLTrace_glProgramUniform2fvEXT(GLuint program, GLint location, GLsizei coun
 }
 
 void GLTrace_glProgramUniform2iEXT(GLuint program, GLint location, GLint v0, GLint v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform2iEXT(program, location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform2iEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform2iEXT);
 
     // copy argument program
@@ -18891,9 +22414,29 @@ void GLTrace_glProgramUniform2ivEXT(GLuint program, GLint location, GLsizei coun
 }
 
 void GLTrace_glProgramUniform3fEXT(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform3fEXT(program, location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform3fEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        msg.addFloat(v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform3fEXT);
 
     // copy argument program
@@ -18990,9 +22533,29 @@ void GLTrace_glProgramUniform3fvEXT(GLuint program, GLint location, GLsizei coun
 }
 
 void GLTrace_glProgramUniform3iEXT(GLuint program, GLint location, GLint v0, GLint v1, GLint v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform3iEXT(program, location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform3iEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform3iEXT);
 
     // copy argument program
@@ -19089,9 +22652,30 @@ void GLTrace_glProgramUniform3ivEXT(GLuint program, GLint location, GLsizei coun
 }
 
 void GLTrace_glProgramUniform4fEXT(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform4fEXT(program, location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform4fEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addFloat(v0);
+        msg.addFloat(v1);
+        msg.addFloat(v2);
+        msg.addFloat(v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform4fEXT);
 
     // copy argument program
@@ -19194,9 +22778,30 @@ void GLTrace_glProgramUniform4fvEXT(GLuint program, GLint location, GLsizei coun
 }
 
 void GLTrace_glProgramUniform4iEXT(GLuint program, GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform4iEXT(program, location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform4iEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform4iEXT);
 
     // copy argument program
@@ -19458,9 +23063,27 @@ void GLTrace_glProgramUniformMatrix4fvEXT(GLuint program, GLint location, GLsize
 }
 
 void GLTrace_glUseProgramStagesEXT(GLuint pipeline, GLbitfield stages, GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glUseProgramStagesEXT(pipeline, stages, program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glUseProgramStagesEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)stages);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glUseProgramStagesEXT);
 
     // copy argument pipeline
@@ -19498,9 +23121,25 @@ void GLTrace_glUseProgramStagesEXT(GLuint pipeline, GLbitfield stages, GLuint pr
 }
 
 void GLTrace_glValidateProgramPipelineEXT(GLuint pipeline) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glValidateProgramPipelineEXT(pipeline);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glValidateProgramPipelineEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)pipeline);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glValidateProgramPipelineEXT);
 
     // copy argument pipeline
@@ -19526,9 +23165,27 @@ void GLTrace_glValidateProgramPipelineEXT(GLuint pipeline) {
 }
 
 void GLTrace_glProgramUniform1uiEXT(GLuint program, GLint location, GLuint v0) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform1uiEXT(program, location, v0);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform1uiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform1uiEXT);
 
     // copy argument program
@@ -19566,9 +23223,28 @@ void GLTrace_glProgramUniform1uiEXT(GLuint program, GLint location, GLuint v0) {
 }
 
 void GLTrace_glProgramUniform2uiEXT(GLuint program, GLint location, GLuint v0, GLuint v1) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform2uiEXT(program, location, v0, v1);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform2uiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform2uiEXT);
 
     // copy argument program
@@ -19612,9 +23288,29 @@ void GLTrace_glProgramUniform2uiEXT(GLuint program, GLint location, GLuint v0, G
 }
 
 void GLTrace_glProgramUniform3uiEXT(GLuint program, GLint location, GLuint v0, GLuint v1, GLuint v2) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform3uiEXT(program, location, v0, v1, v2);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glProgramUniform3uiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glProgramUniform3uiEXT);
 
     // copy argument program
@@ -19664,12 +23360,33 @@ void GLTrace_glProgramUniform3uiEXT(GLuint program, GLint location, GLuint v0, G
 }
 
 void GLTrace_glProgramUniform4uiEXT(GLuint program, GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
-    glmsg.set_function(GLMessage::glProgramUniform4uiEXT);
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glProgramUniform4uiEXT(program, location, v0, v1, v2, v3);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
 
-    // copy argument program
+        CompactGLMessage msg(GLMessage::glProgramUniform4uiEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)location);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v2);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)v3);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
+    glmsg.set_function(GLMessage::glProgramUniform4uiEXT);
+
+    // copy argument program
     GLMessage_DataType *arg_program = glmsg.add_args();
     arg_program->set_isarray(false);
     arg_program->set_type(GLMessage::DataType::INT);
@@ -20228,9 +23945,26 @@ void GLTrace_glProgramUniformMatrix4x3fvEXT(GLuint program, GLint location, GLsi
 }
 
 void GLTrace_glPatchParameteriEXT(GLenum pname, GLint value) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPatchParameteriEXT(pname, value);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPatchParameteriEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)value);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPatchParameteriEXT);
 
     // copy argument pname
@@ -20590,9 +24324,27 @@ void GLTrace_glGetSamplerParameterIuivEXT(GLuint sampler, GLenum pname, GLuint *
 }
 
 void GLTrace_glTexBufferEXT(GLenum target, GLenum internalformat, GLuint buffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexBufferEXT(target, internalformat, buffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexBufferEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexBufferEXT);
 
     // copy argument target
@@ -20630,9 +24382,29 @@ void GLTrace_glTexBufferEXT(GLenum target, GLenum internalformat, GLuint buffer)
 }
 
 void GLTrace_glTexBufferRangeEXT(GLenum target, GLenum internalformat, GLuint buffer, GLintptr offset, GLsizeiptr size) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexBufferRangeEXT(target, internalformat, buffer, offset, size);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexBufferRangeEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)buffer);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)offset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexBufferRangeEXT);
 
     // copy argument target
@@ -20682,9 +24454,28 @@ void GLTrace_glTexBufferRangeEXT(GLenum target, GLenum internalformat, GLuint bu
 }
 
 void GLTrace_glTexStorage1DEXT(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexStorage1DEXT(target, levels, internalformat, width);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexStorage1DEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexStorage1DEXT);
 
     // copy argument target
@@ -20728,9 +24519,29 @@ void GLTrace_glTexStorage1DEXT(GLenum target, GLsizei levels, GLenum internalfor
 }
 
 void GLTrace_glTexStorage2DEXT(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexStorage2DEXT(target, levels, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexStorage2DEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexStorage2DEXT);
 
     // copy argument target
@@ -20780,9 +24591,30 @@ void GLTrace_glTexStorage2DEXT(GLenum target, GLsizei levels, GLenum internalfor
 }
 
 void GLTrace_glTexStorage3DEXT(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexStorage3DEXT(target, levels, internalformat, width, height, depth);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexStorage3DEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)depth);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexStorage3DEXT);
 
     // copy argument target
@@ -20838,9 +24670,29 @@ void GLTrace_glTexStorage3DEXT(GLenum target, GLsizei levels, GLenum internalfor
 }
 
 void GLTrace_glTextureStorage1DEXT(GLuint texture, GLenum target, GLsizei levels, GLenum internalformat, GLsizei width) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTextureStorage1DEXT(texture, target, levels, internalformat, width);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTextureStorage1DEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTextureStorage1DEXT);
 
     // copy argument texture
@@ -20890,9 +24742,30 @@ void GLTrace_glTextureStorage1DEXT(GLuint texture, GLenum target, GLsizei levels
 }
 
 void GLTrace_glTextureStorage2DEXT(GLuint texture, GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTextureStorage2DEXT(texture, target, levels, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTextureStorage2DEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTextureStorage2DEXT);
 
     // copy argument texture
@@ -20948,9 +24821,31 @@ void GLTrace_glTextureStorage2DEXT(GLuint texture, GLenum target, GLsizei levels
 }
 
 void GLTrace_glTextureStorage3DEXT(GLuint texture, GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTextureStorage3DEXT(texture, target, levels, internalformat, width, height, depth);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTextureStorage3DEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)levels);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)depth);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTextureStorage3DEXT);
 
     // copy argument texture
@@ -21012,9 +24907,32 @@ void GLTrace_glTextureStorage3DEXT(GLuint texture, GLenum target, GLsizei levels
 }
 
 void GLTrace_glTextureViewEXT(GLuint texture, GLenum target, GLuint origtexture, GLenum internalformat, GLuint minlevel, GLuint numlevels, GLuint minlayer, GLuint numlayers) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTextureViewEXT(texture, target, origtexture, internalformat, minlevel, numlevels, minlayer, numlayers);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTextureViewEXT, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)origtexture);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)minlevel);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)numlevels);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)minlayer);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)numlayers);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTextureViewEXT);
 
     // copy argument texture
@@ -21082,9 +25000,29 @@ void GLTrace_glTextureViewEXT(GLuint texture, GLenum target, GLuint origtexture,
 }
 
 void GLTrace_glRenderbufferStorageMultisampleIMG(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorageMultisampleIMG(target, samples, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorageMultisampleIMG, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorageMultisampleIMG);
 
     // copy argument target
@@ -21134,9 +25072,30 @@ void GLTrace_glRenderbufferStorageMultisampleIMG(GLenum target, GLsizei samples,
 }
 
 void GLTrace_glFramebufferTexture2DMultisampleIMG(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLsizei samples) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferTexture2DMultisampleIMG(target, attachment, textarget, texture, level, samples);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferTexture2DMultisampleIMG, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)textarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferTexture2DMultisampleIMG);
 
     // copy argument target
@@ -21192,9 +25151,25 @@ void GLTrace_glFramebufferTexture2DMultisampleIMG(GLenum target, GLenum attachme
 }
 
 void GLTrace_glBeginPerfQueryINTEL(GLuint queryHandle) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBeginPerfQueryINTEL(queryHandle);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBeginPerfQueryINTEL, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)queryHandle);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBeginPerfQueryINTEL);
 
     // copy argument queryHandle
@@ -21255,9 +25230,25 @@ void GLTrace_glCreatePerfQueryINTEL(GLuint queryId, GLuint * queryHandle) {
 }
 
 void GLTrace_glDeletePerfQueryINTEL(GLuint queryHandle) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDeletePerfQueryINTEL(queryHandle);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDeletePerfQueryINTEL, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)queryHandle);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDeletePerfQueryINTEL);
 
     // copy argument queryHandle
@@ -21283,9 +25274,25 @@ void GLTrace_glDeletePerfQueryINTEL(GLuint queryHandle) {
 }
 
 void GLTrace_glEndPerfQueryINTEL(GLuint queryHandle) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEndPerfQueryINTEL(queryHandle);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEndPerfQueryINTEL, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)queryHandle);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEndPerfQueryINTEL);
 
     // copy argument queryHandle
@@ -21629,9 +25636,26 @@ void GLTrace_glGetPerfQueryInfoINTEL(GLuint queryId, GLuint queryNameLength, GLc
 }
 
 void GLTrace_glBlendParameteriNV(GLenum pname, GLint value) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendParameteriNV(pname, value);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendParameteriNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)value);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendParameteriNV);
 
     // copy argument pname
@@ -21663,9 +25687,24 @@ void GLTrace_glBlendParameteriNV(GLenum pname, GLint value) {
 }
 
 void GLTrace_glBlendBarrierNV(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendBarrierNV();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendBarrierNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendBarrierNV);
 
     // call function
@@ -21685,9 +25724,29 @@ void GLTrace_glBlendBarrierNV(void) {
 }
 
 void GLTrace_glCopyBufferSubDataNV(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCopyBufferSubDataNV(readTarget, writeTarget, readOffset, writeOffset, size);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCopyBufferSubDataNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)readTarget);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)writeTarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)readOffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)writeOffset);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCopyBufferSubDataNV);
 
     // copy argument readTarget
@@ -21737,9 +25796,25 @@ void GLTrace_glCopyBufferSubDataNV(GLenum readTarget, GLenum writeTarget, GLintp
 }
 
 void GLTrace_glCoverageMaskNV(GLboolean mask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCoverageMaskNV(mask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCoverageMaskNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)mask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCoverageMaskNV);
 
     // copy argument mask
@@ -21765,9 +25840,25 @@ void GLTrace_glCoverageMaskNV(GLboolean mask) {
 }
 
 void GLTrace_glCoverageOperationNV(GLenum operation) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCoverageOperationNV(operation);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCoverageOperationNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)operation);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCoverageOperationNV);
 
     // copy argument operation
@@ -21828,9 +25919,28 @@ void GLTrace_glDrawBuffersNV(GLsizei n, const GLenum * bufs) {
 }
 
 void GLTrace_glDrawArraysInstancedNV(GLenum mode, GLint first, GLsizei count, GLsizei primcount) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawArraysInstancedNV(mode, first, count, primcount);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawArraysInstancedNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)first);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)count);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)primcount);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawArraysInstancedNV);
 
     // copy argument mode
@@ -21997,9 +26107,27 @@ void GLTrace_glGenFencesNV(GLsizei n, GLuint * fences) {
 }
 
 GLboolean GLTrace_glIsFenceNV(GLuint fence) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsFenceNV(fence);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsFenceNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)fence);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsFenceNV);
 
     // copy argument fence
@@ -22033,9 +26161,27 @@ GLboolean GLTrace_glIsFenceNV(GLuint fence) {
 }
 
 GLboolean GLTrace_glTestFenceNV(GLuint fence) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glTestFenceNV(fence);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTestFenceNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)fence);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTestFenceNV);
 
     // copy argument fence
@@ -22110,9 +26256,25 @@ void GLTrace_glGetFenceivNV(GLuint fence, GLenum pname, GLint * params) {
 }
 
 void GLTrace_glFinishFenceNV(GLuint fence) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFinishFenceNV(fence);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFinishFenceNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)fence);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFinishFenceNV);
 
     // copy argument fence
@@ -22138,9 +26300,26 @@ void GLTrace_glFinishFenceNV(GLuint fence) {
 }
 
 void GLTrace_glSetFenceNV(GLuint fence, GLenum condition) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSetFenceNV(fence, condition);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSetFenceNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)fence);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)condition);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSetFenceNV);
 
     // copy argument fence
@@ -22172,9 +26351,34 @@ void GLTrace_glSetFenceNV(GLuint fence, GLenum condition) {
 }
 
 void GLTrace_glBlitFramebufferNV(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlitFramebufferNV(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlitFramebufferNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcX0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcY0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcX1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)srcY1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstX0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstY0);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstX1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)dstY1);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)mask);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)filter);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlitFramebufferNV);
 
     // copy argument srcX0
@@ -22254,9 +26458,29 @@ void GLTrace_glBlitFramebufferNV(GLint srcX0, GLint srcY0, GLint srcX1, GLint sr
 }
 
 void GLTrace_glRenderbufferStorageMultisampleNV(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorageMultisampleNV(target, samples, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorageMultisampleNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)samples);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorageMultisampleNV);
 
     // copy argument target
@@ -22306,9 +26530,26 @@ void GLTrace_glRenderbufferStorageMultisampleNV(GLenum target, GLsizei samples,
 }
 
 void GLTrace_glVertexAttribDivisorNV(GLuint index, GLuint divisor) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertexAttribDivisorNV(index, divisor);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertexAttribDivisorNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)index);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)divisor);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertexAttribDivisorNV);
 
     // copy argument index
@@ -22622,9 +26863,25 @@ void GLTrace_glUniformMatrix4x3fvNV(GLint location, GLsizei count, GLboolean tra
 }
 
 void GLTrace_glReadBufferNV(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glReadBufferNV(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glReadBufferNV, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glReadBufferNV);
 
     // copy argument mode
@@ -22650,9 +26907,26 @@ void GLTrace_glReadBufferNV(GLenum mode) {
 }
 
 void GLTrace_glAlphaFuncQCOM(GLenum func, GLclampf ref) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glAlphaFuncQCOM(func, ref);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glAlphaFuncQCOM, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)func);
+        msg.addFloat(ref);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glAlphaFuncQCOM);
 
     // copy argument func
@@ -22774,9 +27048,25 @@ void GLTrace_glGetDriverControlStringQCOM(GLuint driverControl, GLsizei bufSize,
 }
 
 void GLTrace_glEnableDriverControlQCOM(GLuint driverControl) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEnableDriverControlQCOM(driverControl);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEnableDriverControlQCOM, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)driverControl);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEnableDriverControlQCOM);
 
     // copy argument driverControl
@@ -22802,9 +27092,25 @@ void GLTrace_glEnableDriverControlQCOM(GLuint driverControl) {
 }
 
 void GLTrace_glDisableDriverControlQCOM(GLuint driverControl) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDisableDriverControlQCOM(driverControl);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDisableDriverControlQCOM, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)driverControl);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDisableDriverControlQCOM);
 
     // copy argument driverControl
@@ -23051,9 +27357,27 @@ void GLTrace_glExtGetTexLevelParameterivQCOM(GLuint texture, GLenum face, GLint
 }
 
 void GLTrace_glExtTexObjectStateOverrideiQCOM(GLenum target, GLenum pname, GLint param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glExtTexObjectStateOverrideiQCOM(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glExtTexObjectStateOverrideiQCOM, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glExtTexObjectStateOverrideiQCOM);
 
     // copy argument target
@@ -23299,9 +27623,27 @@ void GLTrace_glExtGetProgramsQCOM(GLuint * programs, GLint maxPrograms, GLint *
 }
 
 GLboolean GLTrace_glExtIsProgramBinaryQCOM(GLuint program) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glExtIsProgramBinaryQCOM(program);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glExtIsProgramBinaryQCOM, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)program);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glExtIsProgramBinaryQCOM);
 
     // copy argument program
@@ -23383,9 +27725,29 @@ void GLTrace_glExtGetProgramBinarySourceQCOM(GLuint program, GLenum shadertype,
 }
 
 void GLTrace_glStartTilingQCOM(GLuint x, GLuint y, GLuint width, GLuint height, GLbitfield preserveMask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glStartTilingQCOM(x, y, width, height, preserveMask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glStartTilingQCOM, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)preserveMask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glStartTilingQCOM);
 
     // copy argument x
@@ -23435,9 +27797,25 @@ void GLTrace_glStartTilingQCOM(GLuint x, GLuint y, GLuint width, GLuint height,
 }
 
 void GLTrace_glEndTilingQCOM(GLbitfield preserveMask) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEndTilingQCOM(preserveMask);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEndTilingQCOM, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)preserveMask);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEndTilingQCOM);
 
     // copy argument preserveMask
@@ -23466,9 +27844,26 @@ void GLTrace_glEndTilingQCOM(GLbitfield preserveMask) {
 // Definitions for GL1 APIs
 
 void GLTrace_glAlphaFunc(GLenum func, GLfloat ref) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glAlphaFunc(func, ref);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glAlphaFunc, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)func);
+        msg.addFloat(ref);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glAlphaFunc);
 
     // copy argument func
@@ -23535,9 +27930,28 @@ void GLTrace_glClipPlanef(GLenum p, const GLfloat * eqn) {
 }
 
 void GLTrace_glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glColor4f(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glColor4f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(red);
+        msg.addFloat(green);
+        msg.addFloat(blue);
+        msg.addFloat(alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glColor4f);
 
     // copy argument red
@@ -23581,9 +27995,26 @@ void GLTrace_glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
 }
 
 void GLTrace_glFogf(GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFogf(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFogf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFogf);
 
     // copy argument pname
@@ -23650,9 +28081,30 @@ void GLTrace_glFogfv(GLenum pname, const GLfloat * params) {
 }
 
 void GLTrace_glFrustumf(GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFrustumf(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFrustumf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(l);
+        msg.addFloat(r);
+        msg.addFloat(b);
+        msg.addFloat(t);
+        msg.addFloat(n);
+        msg.addFloat(f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFrustumf);
 
     // copy argument l
@@ -23866,9 +28318,26 @@ void GLTrace_glGetTexEnvfv(GLenum target, GLenum pname, GLfloat * params) {
 }
 
 void GLTrace_glLightModelf(GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLightModelf(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLightModelf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLightModelf);
 
     // copy argument pname
@@ -23935,9 +28404,27 @@ void GLTrace_glLightModelfv(GLenum pname, const GLfloat * params) {
 }
 
 void GLTrace_glLightf(GLenum light, GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLightf(light, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLightf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)light);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLightf);
 
     // copy argument light
@@ -24045,9 +28532,27 @@ void GLTrace_glLoadMatrixf(const GLfloat * m) {
 }
 
 void GLTrace_glMaterialf(GLenum face, GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMaterialf(face, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMaterialf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)face);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMaterialf);
 
     // copy argument face
@@ -24155,9 +28660,29 @@ void GLTrace_glMultMatrixf(const GLfloat * m) {
 }
 
 void GLTrace_glMultiTexCoord4f(GLenum target, GLfloat s, GLfloat t, GLfloat r, GLfloat q) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMultiTexCoord4f(target, s, t, r, q);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMultiTexCoord4f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addFloat(s);
+        msg.addFloat(t);
+        msg.addFloat(r);
+        msg.addFloat(q);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMultiTexCoord4f);
 
     // copy argument target
@@ -24207,9 +28732,27 @@ void GLTrace_glMultiTexCoord4f(GLenum target, GLfloat s, GLfloat t, GLfloat r, G
 }
 
 void GLTrace_glNormal3f(GLfloat nx, GLfloat ny, GLfloat nz) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glNormal3f(nx, ny, nz);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glNormal3f, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(nx);
+        msg.addFloat(ny);
+        msg.addFloat(nz);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glNormal3f);
 
     // copy argument nx
@@ -24247,9 +28790,30 @@ void GLTrace_glNormal3f(GLfloat nx, GLfloat ny, GLfloat nz) {
 }
 
 void GLTrace_glOrthof(GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glOrthof(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glOrthof, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(l);
+        msg.addFloat(r);
+        msg.addFloat(b);
+        msg.addFloat(t);
+        msg.addFloat(n);
+        msg.addFloat(f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glOrthof);
 
     // copy argument l
@@ -24305,9 +28869,26 @@ void GLTrace_glOrthof(GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLf
 }
 
 void GLTrace_glPointParameterf(GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPointParameterf(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPointParameterf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPointParameterf);
 
     // copy argument pname
@@ -24374,9 +28955,25 @@ void GLTrace_glPointParameterfv(GLenum pname, const GLfloat * params) {
 }
 
 void GLTrace_glPointSize(GLfloat size) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPointSize(size);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPointSize, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(size);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPointSize);
 
     // copy argument size
@@ -24402,9 +28999,28 @@ void GLTrace_glPointSize(GLfloat size) {
 }
 
 void GLTrace_glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRotatef(angle, x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRotatef, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(angle);
+        msg.addFloat(x);
+        msg.addFloat(y);
+        msg.addFloat(z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRotatef);
 
     // copy argument angle
@@ -24448,9 +29064,27 @@ void GLTrace_glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
 }
 
 void GLTrace_glScalef(GLfloat x, GLfloat y, GLfloat z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glScalef(x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glScalef, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(x);
+        msg.addFloat(y);
+        msg.addFloat(z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glScalef);
 
     // copy argument x
@@ -24488,9 +29122,27 @@ void GLTrace_glScalef(GLfloat x, GLfloat y, GLfloat z) {
 }
 
 void GLTrace_glTexEnvf(GLenum target, GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexEnvf(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexEnvf, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexEnvf);
 
     // copy argument target
@@ -24569,9 +29221,27 @@ void GLTrace_glTexEnvfv(GLenum target, GLenum pname, const GLfloat * params) {
 }
 
 void GLTrace_glTranslatef(GLfloat x, GLfloat y, GLfloat z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTranslatef(x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTranslatef, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(x);
+        msg.addFloat(y);
+        msg.addFloat(z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTranslatef);
 
     // copy argument x
@@ -24609,9 +29279,26 @@ void GLTrace_glTranslatef(GLfloat x, GLfloat y, GLfloat z) {
 }
 
 void GLTrace_glAlphaFuncx(GLenum func, GLfixed ref) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glAlphaFuncx(func, ref);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glAlphaFuncx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)func);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)ref);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glAlphaFuncx);
 
     // copy argument func
@@ -24643,9 +29330,28 @@ void GLTrace_glAlphaFuncx(GLenum func, GLfixed ref) {
 }
 
 void GLTrace_glClearColorx(GLfixed red, GLfixed green, GLfixed blue, GLfixed alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearColorx(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearColorx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)red);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)green);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)blue);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearColorx);
 
     // copy argument red
@@ -24689,9 +29395,25 @@ void GLTrace_glClearColorx(GLfixed red, GLfixed green, GLfixed blue, GLfixed alp
 }
 
 void GLTrace_glClearDepthx(GLfixed depth) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearDepthx(depth);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearDepthx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)depth);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearDepthx);
 
     // copy argument depth
@@ -24717,9 +29439,25 @@ void GLTrace_glClearDepthx(GLfixed depth) {
 }
 
 void GLTrace_glClientActiveTexture(GLenum texture) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClientActiveTexture(texture);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClientActiveTexture, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClientActiveTexture);
 
     // copy argument texture
@@ -24780,9 +29518,28 @@ void GLTrace_glClipPlanex(GLenum plane, const GLfixed * equation) {
 }
 
 void GLTrace_glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glColor4ub(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glColor4ub, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)red);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)green);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)blue);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glColor4ub);
 
     // copy argument red
@@ -24826,9 +29583,28 @@ void GLTrace_glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
 }
 
 void GLTrace_glColor4x(GLfixed red, GLfixed green, GLfixed blue, GLfixed alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glColor4x(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glColor4x, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)red);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)green);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)blue);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glColor4x);
 
     // copy argument red
@@ -24919,9 +29695,26 @@ void GLTrace_glColorPointer(GLint size, GLenum type, GLsizei stride, const void
 }
 
 void GLTrace_glDepthRangex(GLfixed n, GLfixed f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDepthRangex(n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDepthRangex, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)n);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDepthRangex);
 
     // copy argument n
@@ -24953,9 +29746,25 @@ void GLTrace_glDepthRangex(GLfixed n, GLfixed f) {
 }
 
 void GLTrace_glDisableClientState(GLenum array) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDisableClientState(array);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDisableClientState, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)array);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDisableClientState);
 
     // copy argument array
@@ -24981,9 +29790,25 @@ void GLTrace_glDisableClientState(GLenum array) {
 }
 
 void GLTrace_glEnableClientState(GLenum array) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glEnableClientState(array);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glEnableClientState, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)array);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glEnableClientState);
 
     // copy argument array
@@ -25009,9 +29834,26 @@ void GLTrace_glEnableClientState(GLenum array) {
 }
 
 void GLTrace_glFogx(GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFogx(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFogx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFogx);
 
     // copy argument pname
@@ -25078,9 +29920,30 @@ void GLTrace_glFogxv(GLenum pname, const GLfixed * param) {
 }
 
 void GLTrace_glFrustumx(GLfixed l, GLfixed r, GLfixed b, GLfixed t, GLfixed n, GLfixed f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFrustumx(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFrustumx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)l);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)r);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)b);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)t);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)n);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFrustumx);
 
     // copy argument l
@@ -25446,9 +30309,26 @@ void GLTrace_glGetTexParameterxv(GLenum target, GLenum pname, GLfixed * params)
 }
 
 void GLTrace_glLightModelx(GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLightModelx(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLightModelx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLightModelx);
 
     // copy argument pname
@@ -25515,9 +30395,27 @@ void GLTrace_glLightModelxv(GLenum pname, const GLfixed * param) {
 }
 
 void GLTrace_glLightx(GLenum light, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLightx(light, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLightx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)light);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLightx);
 
     // copy argument light
@@ -25596,9 +30494,25 @@ void GLTrace_glLightxv(GLenum light, GLenum pname, const GLfixed * params) {
 }
 
 void GLTrace_glLineWidthx(GLfixed width) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLineWidthx(width);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLineWidthx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLineWidthx);
 
     // copy argument width
@@ -25624,9 +30538,24 @@ void GLTrace_glLineWidthx(GLfixed width) {
 }
 
 void GLTrace_glLoadIdentity(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLoadIdentity();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLoadIdentity, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLoadIdentity);
 
     // call function
@@ -25675,9 +30604,25 @@ void GLTrace_glLoadMatrixx(const GLfixed * m) {
 }
 
 void GLTrace_glLogicOp(GLenum opcode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLogicOp(opcode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLogicOp, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)opcode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLogicOp);
 
     // copy argument opcode
@@ -25703,9 +30648,27 @@ void GLTrace_glLogicOp(GLenum opcode) {
 }
 
 void GLTrace_glMaterialx(GLenum face, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMaterialx(face, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMaterialx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)face);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMaterialx);
 
     // copy argument face
@@ -25784,9 +30747,25 @@ void GLTrace_glMaterialxv(GLenum face, GLenum pname, const GLfixed * param) {
 }
 
 void GLTrace_glMatrixMode(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMatrixMode(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMatrixMode, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMatrixMode);
 
     // copy argument mode
@@ -25841,9 +30820,29 @@ void GLTrace_glMultMatrixx(const GLfixed * m) {
 }
 
 void GLTrace_glMultiTexCoord4x(GLenum texture, GLfixed s, GLfixed t, GLfixed r, GLfixed q) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMultiTexCoord4x(texture, s, t, r, q);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMultiTexCoord4x, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)s);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)t);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)r);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)q);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMultiTexCoord4x);
 
     // copy argument texture
@@ -25893,9 +30892,27 @@ void GLTrace_glMultiTexCoord4x(GLenum texture, GLfixed s, GLfixed t, GLfixed r,
 }
 
 void GLTrace_glNormal3x(GLfixed nx, GLfixed ny, GLfixed nz) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glNormal3x(nx, ny, nz);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glNormal3x, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)nx);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)ny);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)nz);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glNormal3x);
 
     // copy argument nx
@@ -25974,9 +30991,30 @@ void GLTrace_glNormalPointer(GLenum type, GLsizei stride, const void * pointer)
 }
 
 void GLTrace_glOrthox(GLfixed l, GLfixed r, GLfixed b, GLfixed t, GLfixed n, GLfixed f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glOrthox(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glOrthox, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)l);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)r);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)b);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)t);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)n);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glOrthox);
 
     // copy argument l
@@ -26032,9 +31070,26 @@ void GLTrace_glOrthox(GLfixed l, GLfixed r, GLfixed b, GLfixed t, GLfixed n, GLf
 }
 
 void GLTrace_glPointParameterx(GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPointParameterx(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPointParameterx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPointParameterx);
 
     // copy argument pname
@@ -26101,9 +31156,25 @@ void GLTrace_glPointParameterxv(GLenum pname, const GLfixed * params) {
 }
 
 void GLTrace_glPointSizex(GLfixed size) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPointSizex(size);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPointSizex, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPointSizex);
 
     // copy argument size
@@ -26129,9 +31200,26 @@ void GLTrace_glPointSizex(GLfixed size) {
 }
 
 void GLTrace_glPolygonOffsetx(GLfixed factor, GLfixed units) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPolygonOffsetx(factor, units);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPolygonOffsetx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)factor);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)units);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPolygonOffsetx);
 
     // copy argument factor
@@ -26163,9 +31251,24 @@ void GLTrace_glPolygonOffsetx(GLfixed factor, GLfixed units) {
 }
 
 void GLTrace_glPopMatrix(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPopMatrix();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPopMatrix, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPopMatrix);
 
     // call function
@@ -26185,9 +31288,24 @@ void GLTrace_glPopMatrix(void) {
 }
 
 void GLTrace_glPushMatrix(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPushMatrix();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPushMatrix, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPushMatrix);
 
     // call function
@@ -26207,9 +31325,28 @@ void GLTrace_glPushMatrix(void) {
 }
 
 void GLTrace_glRotatex(GLfixed angle, GLfixed x, GLfixed y, GLfixed z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRotatex(angle, x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRotatex, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)angle);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRotatex);
 
     // copy argument angle
@@ -26253,9 +31390,26 @@ void GLTrace_glRotatex(GLfixed angle, GLfixed x, GLfixed y, GLfixed z) {
 }
 
 void GLTrace_glSampleCoveragex(GLclampx value, GLboolean invert) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSampleCoveragex(value, invert);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSampleCoveragex, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)value);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)invert);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSampleCoveragex);
 
     // copy argument value
@@ -26287,9 +31441,27 @@ void GLTrace_glSampleCoveragex(GLclampx value, GLboolean invert) {
 }
 
 void GLTrace_glScalex(GLfixed x, GLfixed y, GLfixed z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glScalex(x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glScalex, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glScalex);
 
     // copy argument x
@@ -26327,9 +31499,25 @@ void GLTrace_glScalex(GLfixed x, GLfixed y, GLfixed z) {
 }
 
 void GLTrace_glShadeModel(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glShadeModel(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glShadeModel, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glShadeModel);
 
     // copy argument mode
@@ -26402,9 +31590,27 @@ void GLTrace_glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const vo
 }
 
 void GLTrace_glTexEnvi(GLenum target, GLenum pname, GLint param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexEnvi(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexEnvi, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexEnvi);
 
     // copy argument target
@@ -26442,9 +31648,27 @@ void GLTrace_glTexEnvi(GLenum target, GLenum pname, GLint param) {
 }
 
 void GLTrace_glTexEnvx(GLenum target, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexEnvx(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexEnvx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexEnvx);
 
     // copy argument target
@@ -26564,9 +31788,27 @@ void GLTrace_glTexEnvxv(GLenum target, GLenum pname, const GLfixed * params) {
 }
 
 void GLTrace_glTexParameterx(GLenum target, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexParameterx(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexParameterx, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexParameterx);
 
     // copy argument target
@@ -26645,9 +31887,27 @@ void GLTrace_glTexParameterxv(GLenum target, GLenum pname, const GLfixed * param
 }
 
 void GLTrace_glTranslatex(GLfixed x, GLfixed y, GLfixed z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTranslatex(x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTranslatex, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTranslatex);
 
     // copy argument x
@@ -26735,9 +31995,26 @@ void GLTrace_glVertexPointer(GLint size, GLenum type, GLsizei stride, const void
 // Definitions for GL1Ext APIs
 
 void GLTrace_glBlendEquationSeparateOES(GLenum modeRGB, GLenum modeAlpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendEquationSeparateOES(modeRGB, modeAlpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendEquationSeparateOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)modeRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)modeAlpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendEquationSeparateOES);
 
     // copy argument modeRGB
@@ -26769,9 +32046,28 @@ void GLTrace_glBlendEquationSeparateOES(GLenum modeRGB, GLenum modeAlpha) {
 }
 
 void GLTrace_glBlendFuncSeparateOES(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendFuncSeparateOES(srcRGB, dstRGB, srcAlpha, dstAlpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendFuncSeparateOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)srcRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dstRGB);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)srcAlpha);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)dstAlpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendFuncSeparateOES);
 
     // copy argument srcRGB
@@ -26815,9 +32111,25 @@ void GLTrace_glBlendFuncSeparateOES(GLenum srcRGB, GLenum dstRGB, GLenum srcAlph
 }
 
 void GLTrace_glBlendEquationOES(GLenum mode) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBlendEquationOES(mode);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBlendEquationOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)mode);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBlendEquationOES);
 
     // copy argument mode
@@ -26843,9 +32155,26 @@ void GLTrace_glBlendEquationOES(GLenum mode) {
 }
 
 void GLTrace_glMultiTexCoord1bOES(GLenum texture, GLbyte s) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMultiTexCoord1bOES(texture, s);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMultiTexCoord1bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMultiTexCoord1bOES);
 
     // copy argument texture
@@ -26912,9 +32241,27 @@ void GLTrace_glMultiTexCoord1bvOES(GLenum texture, const GLbyte * coords) {
 }
 
 void GLTrace_glMultiTexCoord2bOES(GLenum texture, GLbyte s, GLbyte t) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMultiTexCoord2bOES(texture, s, t);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMultiTexCoord2bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)t);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMultiTexCoord2bOES);
 
     // copy argument texture
@@ -26987,9 +32334,28 @@ void GLTrace_glMultiTexCoord2bvOES(GLenum texture, const GLbyte * coords) {
 }
 
 void GLTrace_glMultiTexCoord3bOES(GLenum texture, GLbyte s, GLbyte t, GLbyte r) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMultiTexCoord3bOES(texture, s, t, r);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMultiTexCoord3bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)t);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)r);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMultiTexCoord3bOES);
 
     // copy argument texture
@@ -27068,9 +32434,29 @@ void GLTrace_glMultiTexCoord3bvOES(GLenum texture, const GLbyte * coords) {
 }
 
 void GLTrace_glMultiTexCoord4bOES(GLenum texture, GLbyte s, GLbyte t, GLbyte r, GLbyte q) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMultiTexCoord4bOES(texture, s, t, r, q);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMultiTexCoord4bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)t);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)r);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)q);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMultiTexCoord4bOES);
 
     // copy argument texture
@@ -27155,9 +32541,25 @@ void GLTrace_glMultiTexCoord4bvOES(GLenum texture, const GLbyte * coords) {
 }
 
 void GLTrace_glTexCoord1bOES(GLbyte s) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexCoord1bOES(s);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexCoord1bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexCoord1bOES);
 
     // copy argument s
@@ -27212,9 +32614,26 @@ void GLTrace_glTexCoord1bvOES(const GLbyte * coords) {
 }
 
 void GLTrace_glTexCoord2bOES(GLbyte s, GLbyte t) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexCoord2bOES(s, t);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexCoord2bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)t);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexCoord2bOES);
 
     // copy argument s
@@ -27275,9 +32694,27 @@ void GLTrace_glTexCoord2bvOES(const GLbyte * coords) {
 }
 
 void GLTrace_glTexCoord3bOES(GLbyte s, GLbyte t, GLbyte r) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexCoord3bOES(s, t, r);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexCoord3bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)t);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)r);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexCoord3bOES);
 
     // copy argument s
@@ -27344,9 +32781,28 @@ void GLTrace_glTexCoord3bvOES(const GLbyte * coords) {
 }
 
 void GLTrace_glTexCoord4bOES(GLbyte s, GLbyte t, GLbyte r, GLbyte q) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexCoord4bOES(s, t, r, q);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexCoord4bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)s);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)t);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)r);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)q);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexCoord4bOES);
 
     // copy argument s
@@ -27419,9 +32875,25 @@ void GLTrace_glTexCoord4bvOES(const GLbyte * coords) {
 }
 
 void GLTrace_glVertex2bOES(GLbyte x) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertex2bOES(x);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertex2bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)x);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertex2bOES);
 
     // copy argument x
@@ -27476,9 +32948,26 @@ void GLTrace_glVertex2bvOES(const GLbyte * coords) {
 }
 
 void GLTrace_glVertex3bOES(GLbyte x, GLbyte y) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertex3bOES(x, y);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertex3bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)x);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)y);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertex3bOES);
 
     // copy argument x
@@ -27539,9 +33028,27 @@ void GLTrace_glVertex3bvOES(const GLbyte * coords) {
 }
 
 void GLTrace_glVertex4bOES(GLbyte x, GLbyte y, GLbyte z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glVertex4bOES(x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glVertex4bOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)x);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)y);
+        msg.addInt(GLMessage::DataType::BYTE, (int32_t)z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glVertex4bOES);
 
     // copy argument x
@@ -27608,9 +33115,29 @@ void GLTrace_glVertex4bvOES(const GLbyte * coords) {
 }
 
 void GLTrace_glDrawTexsOES(GLshort x, GLshort y, GLshort z, GLshort width, GLshort height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawTexsOES(x, y, z, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawTexsOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawTexsOES);
 
     // copy argument x
@@ -27660,9 +33187,29 @@ void GLTrace_glDrawTexsOES(GLshort x, GLshort y, GLshort z, GLshort width, GLsho
 }
 
 void GLTrace_glDrawTexiOES(GLint x, GLint y, GLint z, GLint width, GLint height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawTexiOES(x, y, z, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawTexiOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawTexiOES);
 
     // copy argument x
@@ -27712,9 +33259,29 @@ void GLTrace_glDrawTexiOES(GLint x, GLint y, GLint z, GLint width, GLint height)
 }
 
 void GLTrace_glDrawTexxOES(GLfixed x, GLfixed y, GLfixed z, GLfixed width, GLfixed height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawTexxOES(x, y, z, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawTexxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawTexxOES);
 
     // copy argument x
@@ -27851,9 +33418,29 @@ void GLTrace_glDrawTexxvOES(const GLfixed * coords) {
 }
 
 void GLTrace_glDrawTexfOES(GLfloat x, GLfloat y, GLfloat z, GLfloat width, GLfloat height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDrawTexfOES(x, y, z, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDrawTexfOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(x);
+        msg.addFloat(y);
+        msg.addFloat(z);
+        msg.addFloat(width);
+        msg.addFloat(height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDrawTexfOES);
 
     // copy argument x
@@ -27932,9 +33519,26 @@ void GLTrace_glDrawTexfvOES(const GLfloat * coords) {
 }
 
 void GLTrace_glAlphaFuncxOES(GLenum func, GLfixed ref) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glAlphaFuncxOES(func, ref);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glAlphaFuncxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)func);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)ref);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glAlphaFuncxOES);
 
     // copy argument func
@@ -27966,9 +33570,28 @@ void GLTrace_glAlphaFuncxOES(GLenum func, GLfixed ref) {
 }
 
 void GLTrace_glClearColorxOES(GLfixed red, GLfixed green, GLfixed blue, GLfixed alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearColorxOES(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearColorxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)red);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)green);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)blue);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearColorxOES);
 
     // copy argument red
@@ -28012,9 +33635,25 @@ void GLTrace_glClearColorxOES(GLfixed red, GLfixed green, GLfixed blue, GLfixed
 }
 
 void GLTrace_glClearDepthxOES(GLfixed depth) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearDepthxOES(depth);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearDepthxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)depth);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearDepthxOES);
 
     // copy argument depth
@@ -28075,9 +33714,28 @@ void GLTrace_glClipPlanexOES(GLenum plane, const GLfixed * equation) {
 }
 
 void GLTrace_glColor4xOES(GLfixed red, GLfixed green, GLfixed blue, GLfixed alpha) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glColor4xOES(red, green, blue, alpha);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glColor4xOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)red);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)green);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)blue);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)alpha);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glColor4xOES);
 
     // copy argument red
@@ -28121,9 +33779,26 @@ void GLTrace_glColor4xOES(GLfixed red, GLfixed green, GLfixed blue, GLfixed alph
 }
 
 void GLTrace_glDepthRangexOES(GLfixed n, GLfixed f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDepthRangexOES(n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDepthRangexOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)n);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDepthRangexOES);
 
     // copy argument n
@@ -28155,9 +33830,26 @@ void GLTrace_glDepthRangexOES(GLfixed n, GLfixed f) {
 }
 
 void GLTrace_glFogxOES(GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFogxOES(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFogxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFogxOES);
 
     // copy argument pname
@@ -28224,9 +33916,30 @@ void GLTrace_glFogxvOES(GLenum pname, const GLfixed * param) {
 }
 
 void GLTrace_glFrustumxOES(GLfixed l, GLfixed r, GLfixed b, GLfixed t, GLfixed n, GLfixed f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFrustumxOES(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFrustumxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)l);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)r);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)b);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)t);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)n);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFrustumxOES);
 
     // copy argument l
@@ -28434,9 +34147,26 @@ void GLTrace_glGetTexParameterxvOES(GLenum target, GLenum pname, GLfixed * param
 }
 
 void GLTrace_glLightModelxOES(GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLightModelxOES(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLightModelxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLightModelxOES);
 
     // copy argument pname
@@ -28503,9 +34233,27 @@ void GLTrace_glLightModelxvOES(GLenum pname, const GLfixed * param) {
 }
 
 void GLTrace_glLightxOES(GLenum light, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLightxOES(light, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLightxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)light);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLightxOES);
 
     // copy argument light
@@ -28584,9 +34332,25 @@ void GLTrace_glLightxvOES(GLenum light, GLenum pname, const GLfixed * params) {
 }
 
 void GLTrace_glLineWidthxOES(GLfixed width) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLineWidthxOES(width);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLineWidthxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLineWidthxOES);
 
     // copy argument width
@@ -28641,9 +34405,27 @@ void GLTrace_glLoadMatrixxOES(const GLfixed * m) {
 }
 
 void GLTrace_glMaterialxOES(GLenum face, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMaterialxOES(face, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMaterialxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)face);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMaterialxOES);
 
     // copy argument face
@@ -28751,9 +34533,29 @@ void GLTrace_glMultMatrixxOES(const GLfixed * m) {
 }
 
 void GLTrace_glMultiTexCoord4xOES(GLenum texture, GLfixed s, GLfixed t, GLfixed r, GLfixed q) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glMultiTexCoord4xOES(texture, s, t, r, q);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glMultiTexCoord4xOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)s);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)t);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)r);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)q);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glMultiTexCoord4xOES);
 
     // copy argument texture
@@ -28803,9 +34605,27 @@ void GLTrace_glMultiTexCoord4xOES(GLenum texture, GLfixed s, GLfixed t, GLfixed
 }
 
 void GLTrace_glNormal3xOES(GLfixed nx, GLfixed ny, GLfixed nz) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glNormal3xOES(nx, ny, nz);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glNormal3xOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)nx);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)ny);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)nz);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glNormal3xOES);
 
     // copy argument nx
@@ -28843,9 +34663,30 @@ void GLTrace_glNormal3xOES(GLfixed nx, GLfixed ny, GLfixed nz) {
 }
 
 void GLTrace_glOrthoxOES(GLfixed l, GLfixed r, GLfixed b, GLfixed t, GLfixed n, GLfixed f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glOrthoxOES(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glOrthoxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)l);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)r);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)b);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)t);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)n);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glOrthoxOES);
 
     // copy argument l
@@ -28936,9 +34777,25 @@ void GLTrace_glPointParameterxvOES(GLenum pname, const GLfixed * params) {
 }
 
 void GLTrace_glPointSizexOES(GLfixed size) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPointSizexOES(size);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPointSizexOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)size);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPointSizexOES);
 
     // copy argument size
@@ -28964,9 +34821,26 @@ void GLTrace_glPointSizexOES(GLfixed size) {
 }
 
 void GLTrace_glPolygonOffsetxOES(GLfixed factor, GLfixed units) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPolygonOffsetxOES(factor, units);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPolygonOffsetxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)factor);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)units);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPolygonOffsetxOES);
 
     // copy argument factor
@@ -28998,9 +34872,28 @@ void GLTrace_glPolygonOffsetxOES(GLfixed factor, GLfixed units) {
 }
 
 void GLTrace_glRotatexOES(GLfixed angle, GLfixed x, GLfixed y, GLfixed z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRotatexOES(angle, x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRotatexOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)angle);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRotatexOES);
 
     // copy argument angle
@@ -29044,9 +34937,26 @@ void GLTrace_glRotatexOES(GLfixed angle, GLfixed x, GLfixed y, GLfixed z) {
 }
 
 void GLTrace_glSampleCoverageOES(GLfixed value, GLboolean invert) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSampleCoverageOES(value, invert);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSampleCoverageOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)value);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)invert);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSampleCoverageOES);
 
     // copy argument value
@@ -29078,9 +34988,27 @@ void GLTrace_glSampleCoverageOES(GLfixed value, GLboolean invert) {
 }
 
 void GLTrace_glScalexOES(GLfixed x, GLfixed y, GLfixed z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glScalexOES(x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glScalexOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glScalexOES);
 
     // copy argument x
@@ -29118,9 +35046,27 @@ void GLTrace_glScalexOES(GLfixed x, GLfixed y, GLfixed z) {
 }
 
 void GLTrace_glTexEnvxOES(GLenum target, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexEnvxOES(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexEnvxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexEnvxOES);
 
     // copy argument target
@@ -29199,9 +35145,27 @@ void GLTrace_glTexEnvxvOES(GLenum target, GLenum pname, const GLfixed * params)
 }
 
 void GLTrace_glTexParameterxOES(GLenum target, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexParameterxOES(target, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexParameterxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexParameterxOES);
 
     // copy argument target
@@ -29280,9 +35244,27 @@ void GLTrace_glTexParameterxvOES(GLenum target, GLenum pname, const GLfixed * pa
 }
 
 void GLTrace_glTranslatexOES(GLfixed x, GLfixed y, GLfixed z) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTranslatexOES(x, y, z);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTranslatexOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)x);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)y);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)z);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTranslatexOES);
 
     // copy argument x
@@ -29402,9 +35384,26 @@ void GLTrace_glGetMaterialxvOES(GLenum face, GLenum pname, GLfixed * params) {
 }
 
 void GLTrace_glPointParameterxOES(GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glPointParameterxOES(pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glPointParameterxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glPointParameterxOES);
 
     // copy argument pname
@@ -29436,9 +35435,26 @@ void GLTrace_glPointParameterxOES(GLenum pname, GLfixed param) {
 }
 
 void GLTrace_glSampleCoveragexOES(GLclampx value, GLboolean invert) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glSampleCoveragexOES(value, invert);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glSampleCoveragexOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)value);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)invert);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glSampleCoveragexOES);
 
     // copy argument value
@@ -29511,9 +35527,27 @@ void GLTrace_glGetTexGenxvOES(GLenum coord, GLenum pname, GLfixed * params) {
 }
 
 void GLTrace_glTexGenxOES(GLenum coord, GLenum pname, GLfixed param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexGenxOES(coord, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexGenxOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)coord);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexGenxOES);
 
     // copy argument coord
@@ -29592,9 +35626,27 @@ void GLTrace_glTexGenxvOES(GLenum coord, GLenum pname, const GLfixed * params) {
 }
 
 GLboolean GLTrace_glIsRenderbufferOES(GLuint renderbuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsRenderbufferOES(renderbuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsRenderbufferOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)renderbuffer);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsRenderbufferOES);
 
     // copy argument renderbuffer
@@ -29628,9 +35680,26 @@ GLboolean GLTrace_glIsRenderbufferOES(GLuint renderbuffer) {
 }
 
 void GLTrace_glBindRenderbufferOES(GLenum target, GLuint renderbuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindRenderbufferOES(target, renderbuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindRenderbufferOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)renderbuffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindRenderbufferOES);
 
     // copy argument target
@@ -29732,9 +35801,28 @@ void GLTrace_glGenRenderbuffersOES(GLsizei n, GLuint * renderbuffers) {
 }
 
 void GLTrace_glRenderbufferStorageOES(GLenum target, GLenum internalformat, GLsizei width, GLsizei height) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glRenderbufferStorageOES(target, internalformat, width, height);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glRenderbufferStorageOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)internalformat);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)width);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)height);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glRenderbufferStorageOES);
 
     // copy argument target
@@ -29819,9 +35907,27 @@ void GLTrace_glGetRenderbufferParameterivOES(GLenum target, GLenum pname, GLint
 }
 
 GLboolean GLTrace_glIsFramebufferOES(GLuint framebuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLboolean retValue = glContext->hooks->gl.glIsFramebufferOES(framebuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glIsFramebufferOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)framebuffer);
+        msg.addInt(GLMessage::DataType::BOOL, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glIsFramebufferOES);
 
     // copy argument framebuffer
@@ -29855,9 +35961,26 @@ GLboolean GLTrace_glIsFramebufferOES(GLuint framebuffer) {
 }
 
 void GLTrace_glBindFramebufferOES(GLenum target, GLuint framebuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glBindFramebufferOES(target, framebuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glBindFramebufferOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)framebuffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glBindFramebufferOES);
 
     // copy argument target
@@ -29959,9 +36082,27 @@ void GLTrace_glGenFramebuffersOES(GLsizei n, GLuint * framebuffers) {
 }
 
 GLenum GLTrace_glCheckFramebufferStatusOES(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        GLenum retValue = glContext->hooks->gl.glCheckFramebufferStatusOES(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCheckFramebufferStatusOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)retValue);
+        msg.setReturnValue();
+        glContext->traceGLMessage(&msg);
+        return retValue;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCheckFramebufferStatusOES);
 
     // copy argument target
@@ -29995,9 +36136,28 @@ GLenum GLTrace_glCheckFramebufferStatusOES(GLenum target) {
 }
 
 void GLTrace_glFramebufferRenderbufferOES(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferRenderbufferOES(target, attachment, renderbuffertarget, renderbuffer);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferRenderbufferOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)renderbuffertarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)renderbuffer);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferRenderbufferOES);
 
     // copy argument target
@@ -30041,9 +36201,29 @@ void GLTrace_glFramebufferRenderbufferOES(GLenum target, GLenum attachment, GLen
 }
 
 void GLTrace_glFramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFramebufferTexture2DOES(target, attachment, textarget, texture, level);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFramebufferTexture2DOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)attachment);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)textarget);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)texture);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)level);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFramebufferTexture2DOES);
 
     // copy argument target
@@ -30140,9 +36320,25 @@ void GLTrace_glGetFramebufferAttachmentParameterivOES(GLenum target, GLenum atta
 }
 
 void GLTrace_glGenerateMipmapOES(GLenum target) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glGenerateMipmapOES(target);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glGenerateMipmapOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)target);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glGenerateMipmapOES);
 
     // copy argument target
@@ -30168,9 +36364,25 @@ void GLTrace_glGenerateMipmapOES(GLenum target) {
 }
 
 void GLTrace_glCurrentPaletteMatrixOES(GLuint matrixpaletteindex) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glCurrentPaletteMatrixOES(matrixpaletteindex);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glCurrentPaletteMatrixOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)matrixpaletteindex);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glCurrentPaletteMatrixOES);
 
     // copy argument matrixpaletteindex
@@ -30196,9 +36408,24 @@ void GLTrace_glCurrentPaletteMatrixOES(GLuint matrixpaletteindex) {
 }
 
 void GLTrace_glLoadPaletteFromModelViewMatrixOES(void) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glLoadPaletteFromModelViewMatrixOES();
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glLoadPaletteFromModelViewMatrixOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glLoadPaletteFromModelViewMatrixOES);
 
     // call function
@@ -30397,9 +36624,25 @@ GLbitfield GLTrace_glQueryMatrixxOES(GLfixed * mantissa, GLint * exponent) {
 }
 
 void GLTrace_glClearDepthfOES(GLclampf depth) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glClearDepthfOES(depth);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glClearDepthfOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(depth);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glClearDepthfOES);
 
     // copy argument depth
@@ -30460,9 +36703,26 @@ void GLTrace_glClipPlanefOES(GLenum plane, const GLfloat * equation) {
 }
 
 void GLTrace_glDepthRangefOES(GLclampf n, GLclampf f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glDepthRangefOES(n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glDepthRangefOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(n);
+        msg.addFloat(f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glDepthRangefOES);
 
     // copy argument n
@@ -30494,9 +36754,30 @@ void GLTrace_glDepthRangefOES(GLclampf n, GLclampf f) {
 }
 
 void GLTrace_glFrustumfOES(GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glFrustumfOES(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glFrustumfOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(l);
+        msg.addFloat(r);
+        msg.addFloat(b);
+        msg.addFloat(t);
+        msg.addFloat(n);
+        msg.addFloat(f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glFrustumfOES);
 
     // copy argument l
@@ -30587,9 +36868,30 @@ void GLTrace_glGetClipPlanefOES(GLenum plane, GLfloat * equation) {
 }
 
 void GLTrace_glOrthofOES(GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glOrthofOES(l, r, b, t, n, f);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glOrthofOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addFloat(l);
+        msg.addFloat(r);
+        msg.addFloat(b);
+        msg.addFloat(t);
+        msg.addFloat(n);
+        msg.addFloat(f);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glOrthofOES);
 
     // copy argument l
@@ -30645,9 +36947,27 @@ void GLTrace_glOrthofOES(GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n,
 }
 
 void GLTrace_glTexGenfOES(GLenum coord, GLenum pname, GLfloat param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexGenfOES(coord, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexGenfOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)coord);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addFloat(param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexGenfOES);
 
     // copy argument coord
@@ -30726,9 +37046,27 @@ void GLTrace_glTexGenfvOES(GLenum coord, GLenum pname, const GLfloat * params) {
 }
 
 void GLTrace_glTexGeniOES(GLenum coord, GLenum pname, GLint param) {
-    GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
 
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+        glContext->hooks->gl.glTexGeniOES(coord, pname, param);
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::glTexGeniOES, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)coord);
+        msg.addInt(GLMessage::DataType::ENUM, (int32_t)pname);
+        msg.addInt(GLMessage::DataType::INT, (int32_t)param);
+        glContext->traceGLMessage(&msg);
+        return;
+    }
+
+    GLMessage glmsg;
+
     glmsg.set_function(GLMessage::glTexGeniOES);
 
     // copy argument coord
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2014, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GLTRACE_COMPACT_H_
+#define __GLTRACE_COMPACT_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <utils/Timers.h>
+
+#include "gltrace.pb.h"
+
+namespace android {
+namespace gltrace {
+
+/**
+ * CompactGLMessage is a binary encoding of a GL call whose arguments and
+ * return value are all scalars, used instead of a GLMessage when the
+ * "debug.egl.trace.compact" property is set. It is built on the stack, with
+ * no allocation, and converted to a GLMessage by the host
+ * (see tools/gltrace_convert.py).
+ *
+ * A record is, in native byte order:
+ *      uint32_t    size of the rest of the record, with COMPACT_RECORD set
+ *      uint32_t    function, a GLMessage::Function
+ *      int32_t     context id
+ *      int64_t     start time
+ *      uint32_t    duration
+ *      uint32_t    thread time
+ *      uint8_t     number of values
+ *      uint8_t     1 if the last value is the return value, 0 otherwise
+ * followed by each value as a uint8_t GLMessage::DataType::Type and either
+ * 8 bytes for INT64 values, or 4 bytes (int32_t or float) for the others.
+ */
+class CompactGLMessage {
+public:
+    /** Bit set in the size of a record, to tell it apart from the size of a
+        serialized GLMessage. */
+    static const uint32_t COMPACT_RECORD = 0x40000000;
+
+    CompactGLMessage(GLMessage_Function function, int contextId,
+            nsecs_t wallStart, nsecs_t wallEnd,
+            nsecs_t threadStart, nsecs_t threadEnd) :
+            mSize(HEADER_SIZE) {
+        uint32_t function32 = function;
+        int32_t contextId32 = contextId;
+        int64_t startTime = wallStart;
+        uint32_t duration = (uint32_t)(wallEnd - wallStart);
+        uint32_t threadTime = (uint32_t)(threadEnd - threadStart);
+        memcpy(mData + 4, &function32, 4);
+        memcpy(mData + 8, &contextId32, 4);
+        memcpy(mData + 12, &startTime, 8);
+        memcpy(mData + 20, &duration, 4);
+        memcpy(mData + 24, &threadTime, 4);
+        mData[COUNT_OFFSET] = 0;
+        mData[COUNT_OFFSET + 1] = 0;
+    }
+
+    void addInt(GLMessage::DataType::Type type, int32_t value) {
+        addValue(type, &value, sizeof(value));
+    }
+
+    void addFloat(float value) {
+        addValue(GLMessage::DataType::FLOAT, &value, sizeof(value));
+    }
+
+    void addInt64(int64_t value) {
+        addValue(GLMessage::DataType::INT64, &value, sizeof(value));
+    }
+
+    /** Mark the last value added as the return value. */
+    void setReturnValue() {
+        mData[COUNT_OFFSET + 1] = 1;
+    }
+
+    /** The encoded record, with its size. */
+    const void *data() {
+        uint32_t header = (mSize - sizeof(uint32_t)) | COMPACT_RECORD;
+        memcpy(mData, &header, sizeof(header));
+        return mData;
+    }
+    size_t size() const { return mSize; }
+
+private:
+    enum {
+        COUNT_OFFSET = 28,
+        HEADER_SIZE = 30,
+        /* genapi.py only compacts calls with at most 16 values. */
+        MAX_SIZE = HEADER_SIZE + 16 * 9,
+    };
+
+    void addValue(GLMessage::DataType::Type type, const void *value, size_t size) {
+        if (mSize + 1 + size > MAX_SIZE) {
+            return;
+        }
+        mData[mSize] = (uint8_t)type;
+        memcpy(mData + mSize + 1, value, size);
+        mSize += 1 + size;
+        mData[COUNT_OFFSET]++;
+    }
+
+    uint8_t mData[MAX_SIZE];
+    size_t mSize;
+};
+
+};
+};
+
+#endif
@@ -16,12 +16,14 @@
 
 #include <pthread.h>
 #include <cutils/log.h>
+#include <cutils/properties.h>
 
 extern "C" {
 #include "liblzf/lzf.h"
 }
 
 #include "gltrace_context.h"
+#include "gltrace_worker.h"
 
 namespace android {
 namespace gltrace {
@@ -64,9 +66,21 @@ GLTraceState::GLTraceState(TCPStream *stream) {
     mCollectFbOnGlDraw = false;
     mCollectTextureDataOnGlTexImage = false;
     pthread_rwlock_init(&mTraceOptionsRwLock, NULL);
+
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.egl.trace.sample_frames", value, "1");
+    mSampleFrames = atoi(value) > 1 ? atoi(value) : 1;
+    mFullDetailRequest = 0;
+
+    property_get("debug.egl.trace.fixup_thread", value, "0");
+    mWorker = atoi(value) ? new FixupWorker() : NULL;
 }
 
 GLTraceState::~GLTraceState() {
+    // like the stream, the worker may still be used by the contexts
+    if (mWorker) {
+        mWorker->close();
+    }
     if (mStream) {
         mStream->closeStream();
         mStream = NULL;
@@ -114,6 +128,14 @@ bool GLTraceState::shouldCollectTextureDataOnGlTexImage() {
     return safeGetValue(&mCollectTextureDataOnGlTexImage, &mTraceOptionsRwLock);
 }
 
+void GLTraceState::requestFullDetailFrames(unsigned frames) {
+    // a new sequence number tells the contexts a new window started
+    const uint32_t sequence = (mFullDetailRequest & ~FULL_DETAIL_FRAMES_MASK) +
+            (FULL_DETAIL_FRAMES_MASK + 1);
+    __sync_lock_test_and_set(&mFullDetailRequest,
+            sequence | (frames & FULL_DETAIL_FRAMES_MASK));
+}
+
 GLTraceContext *GLTraceState::createTraceContext(int version, EGLContext eglContext) {
     int id = __sync_fetch_and_add(&mTraceContextIds, 1);
 
@@ -138,10 +160,21 @@ GLTraceContext::GLTraceContext(int id, int version, GLTraceState *state,
     mVersionParsed(false),
     mState(state),
     mBufferedOutputStream(stream),
+    mCompactMessages(state->getStream()->useCompactMessages()),
+    mFrameCount(0),
+    mFullDetail(true),
+    mFullDetailFramesLeft(0),
+    mFullDetailRequest(state->getFullDetailRequest()),
+    mWorker(state->getWorker()),
+    mJobsInFlight(0),
     mElementArrayBuffers(DefaultKeyedVector<GLuint, ElementArrayBuffer*>(NULL))
 {
-    fbcontents = fbcompressed = NULL;
-    fbcontentsSize = 0;
+}
+
+GLTraceContext::~GLTraceContext() {
+    if (mWorker != NULL) {
+        mWorker->waitForJobs(&mJobsInFlight);
+    }
 }
 
 int GLTraceContext::getId() {
@@ -186,30 +219,175 @@ void GLTraceContext::parseGlesVersion() {
     mVersionMinor = minor;
 }
 
-void GLTraceContext::resizeFBMemory(unsigned minSize) {
-    if (fbcontentsSize >= minSize) {
-        return;
+FrameBufferCapture::FrameBufferCapture() :
+    mPrevious(NULL),
+    mPreviousWidth(0),
+    mPreviousHeight(0),
+    mTileData(NULL),
+    mCompressed(NULL),
+    mDataSize(0),
+    mDesc(NULL),
+    mDescSize(0),
+    mPboNext(0)
+{
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.egl.trace.fb_tiles", value, "0");
+    mTiles = atoi(value) != 0;
+    property_get("debug.egl.trace.fb_async", value, "0");
+    mAsync = atoi(value) != 0;
+    property_get("debug.egl.trace.fb_scale", value, "1");
+    mScale = atoi(value) > 1 ? atoi(value) : 1;
+
+    for (int i = 0; i < 2; i++) {
+        mPbos[i] = 0;
+        mPboWidth[i] = mPboHeight[i] = 0;
+        mPboPending[i] = false;
+    }
+}
+
+FrameBufferCapture::~FrameBufferCapture() {
+    // the pixel buffer objects go away with the GL context
+    free(mPrevious);
+    free(mTileData);
+    free(mCompressed);
+    free(mDesc);
+}
+
+void FrameBufferCapture::resizeData(size_t size) {
+    if (mDataSize < size) {
+        free(mTileData);
+        free(mCompressed);
+        mTileData = (uint8_t *)malloc(size);
+        mCompressed = (uint8_t *)malloc(size);
+        mDataSize = size;
+    }
+}
+
+/**
+ * Start reading the framebuffer into one pixel buffer object, and copy the
+ * contents of the other, read by the previous capture, into @snapshot.
+ * Returns false if there was no previous capture.
+ */
+bool FrameBufferCapture::readAsync(gl_hooks_t *hooks, const int viewport[4],
+        FrameSnapshot *snapshot) {
+    GLint boundPbo = 0;
+    hooks->gl.glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &boundPbo);
+    if (mPbos[0] == 0) {
+        hooks->gl.glGenBuffers(2, mPbos);
+    }
+
+    const int current = mPboNext;
+    const int previous = 1 - current;
+
+    hooks->gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, mPbos[current]);
+    if (mPboWidth[current] != (unsigned)viewport[2] ||
+            mPboHeight[current] != (unsigned)viewport[3]) {
+        mPboWidth[current] = viewport[2];
+        mPboHeight[current] = viewport[3];
+        hooks->gl.glBufferData(GL_PIXEL_PACK_BUFFER,
+                mPboWidth[current] * mPboHeight[current] * 4, NULL, GL_STREAM_READ);
+    }
+    hooks->gl.glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3],
+                                        GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    mPboPending[current] = true;
+    mPboNext = previous;
+
+    bool haveContents = false;
+    if (mPboPending[previous]) {
+        const size_t size = mPboWidth[previous] * mPboHeight[previous] * 4;
+        hooks->gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, mPbos[previous]);
+        void *src = hooks->gl.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size,
+                GL_MAP_READ_BIT);
+        if (src != NULL) {
+            snapshot->pixels = (uint8_t *)malloc(size);
+            memcpy(snapshot->pixels, src, size);
+            hooks->gl.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            snapshot->width = mPboWidth[previous];
+            snapshot->height = mPboHeight[previous];
+            haveContents = true;
+        }
+        mPboPending[previous] = false;
     }
 
-    if (fbcontents != NULL) {
-        free(fbcontents);
-        free(fbcompressed);
+    hooks->gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, boundPbo);
+    return haveContents;
+}
+
+/** Downsample @snapshot in place, keeping one pixel out of mScale x mScale. */
+void FrameBufferCapture::downsample(FrameSnapshot *snapshot) {
+    const unsigned srcWidth = snapshot->width;
+    const unsigned w = srcWidth / mScale;
+    const unsigned h = snapshot->height / mScale;
+    uint8_t *pixels = snapshot->pixels;
+
+    for (unsigned y = 0; y < h; y++) {
+        const uint8_t *src = pixels + y * mScale * srcWidth * 4;
+        uint8_t *dst = pixels + y * w * 4;
+        for (unsigned x = 0; x < w; x++) {
+            memcpy(dst + x * 4, src + x * mScale * 4, 4);
+        }
     }
 
-    fbcontents = malloc(minSize);
-    fbcompressed = malloc(minSize);
+    snapshot->width = w;
+    snapshot->height = h;
+}
+
+/**
+ * Copy the tiles of @pixels which differ from mPrevious into mTileData, and
+ * set their bits in @bitmap. All the tiles are sent if the size of the
+ * framebuffer changed. Returns the size of the tile data.
+ */
+size_t FrameBufferCapture::diffTiles(const uint8_t *pixels, unsigned width, unsigned height,
+        uint8_t *bitmap) {
+    const bool keyframe = mPrevious == NULL ||
+            width != mPreviousWidth || height != mPreviousHeight;
+    if (keyframe) {
+        free(mPrevious);
+        mPrevious = (uint8_t *)malloc(width * height * 4);
+        mPreviousWidth = width;
+        mPreviousHeight = height;
+    }
 
-    fbcontentsSize = minSize;
+    const unsigned stride = width * 4;
+    const unsigned tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const unsigned tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    memset(bitmap, 0, (tilesX * tilesY + 7) / 8);
+
+    size_t size = 0;
+    for (unsigned ty = 0; ty < tilesY; ty++) {
+        const unsigned y0 = ty * TILE_SIZE;
+        const unsigned th = height - y0 < TILE_SIZE ? height - y0 : TILE_SIZE;
+        for (unsigned tx = 0; tx < tilesX; tx++) {
+            const unsigned x0 = tx * TILE_SIZE;
+            const unsigned tw = width - x0 < TILE_SIZE ? width - x0 : TILE_SIZE;
+            const size_t offset = y0 * stride + x0 * 4;
+
+            bool changed = keyframe;
+            for (unsigned y = 0; y < th && !changed; y++) {
+                changed = memcmp(pixels + offset + y * stride,
+                        mPrevious + offset + y * stride, tw * 4) != 0;
+            }
+            if (!changed) {
+                continue;
+            }
+
+            const unsigned tile = ty * tilesX + tx;
+            bitmap[tile / 8] |= 1 << (tile % 8);
+            for (unsigned y = 0; y < th; y++) {
+                memcpy(mTileData + size, pixels + offset + y * stride, tw * 4);
+                memcpy(mPrevious + offset + y * stride,
+                        pixels + offset + y * stride, tw * 4);
+                size += tw * 4;
+            }
+        }
+    }
+    return size;
 }
 
-/** obtain a pointer to the compressed framebuffer image */
-void GLTraceContext::getCompressedFB(void **fb, unsigned *fbsize, unsigned *fbwidth, 
-                            unsigned *fbheight, FBBinding fbToRead) {
+sp<FrameSnapshot> FrameBufferCapture::read(gl_hooks_t *hooks, bool es3, FBBinding fbToRead) {
+    sp<FrameSnapshot> snapshot = new FrameSnapshot();
     int viewport[4] = {};
     hooks->gl.glGetIntegerv(GL_VIEWPORT, viewport);
-    unsigned fbContentsSize = viewport[2] * viewport[3] * 4;
-
-    resizeFBMemory(fbContentsSize);
 
     // switch current framebuffer binding if necessary
     GLint currentFb = -1;
@@ -223,21 +401,167 @@ void GLTraceContext::getCompressedFB(void **fb, unsigned *fbsize, unsigned *fbwi
         }
     }
 
-    hooks->gl.glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3],
-                                        GL_RGBA, GL_UNSIGNED_BYTE, fbcontents);
+    snapshot->lagged = mAsync && es3;
+    if (snapshot->lagged) {
+        readAsync(hooks, viewport, snapshot.get());
+    } else {
+        // a bound pixel pack buffer would turn our pointer into an offset
+        GLint boundPbo = 0;
+        if (es3) {
+            hooks->gl.glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &boundPbo);
+            if (boundPbo != 0) {
+                hooks->gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            }
+        }
+        snapshot->width = viewport[2];
+        snapshot->height = viewport[3];
+        snapshot->pixels = (uint8_t *)malloc(snapshot->width * snapshot->height * 4);
+        hooks->gl.glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3],
+                                        GL_RGBA, GL_UNSIGNED_BYTE, snapshot->pixels);
+        if (boundPbo != 0) {
+            hooks->gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, boundPbo);
+        }
+    }
 
     // switch back to previously bound buffer if necessary
     if (fbSwitched) {
         hooks->gl.glBindFramebuffer(GL_FRAMEBUFFER, currentFb);
     }
+    return snapshot;
+}
+
+void FrameBufferCapture::encode(const sp<FrameSnapshot>& snapshot,
+        void **fb, unsigned *fbsize, unsigned *fbwidth, unsigned *fbheight,
+        void **desc, unsigned *descSize) {
+    const bool lagged = snapshot->lagged;
+    if (snapshot->pixels == NULL) {
+        snapshot->width = snapshot->height = 0;
+    } else if (mScale > 1) {
+        downsample(snapshot.get());
+    }
+
+    const unsigned width = snapshot->width;
+    const unsigned height = snapshot->height;
+    const size_t size = width * height * 4;
+    resizeData(size);
+    *fbwidth = width;
+    *fbheight = height;
+    *fb = mCompressed;
+
+    if (!mTiles && !lagged && mScale == 1) {
+        // plain capture
+        *fbsize = lzf_compress(snapshot->pixels, size, mCompressed, size);
+        *desc = NULL;
+        *descSize = 0;
+        return;
+    }
+
+    // the descriptor is 5 words: magic, flags, scale, tile size and number
+    // of tiles, followed by the bitmap of the tiles sent
+    const size_t headerSize = 5 * sizeof(uint32_t);
+    uint32_t header[5] = { DESC_MAGIC, lagged ? DESC_LAGGED : 0, mScale, TILE_SIZE, 0 };
+    size_t bitmapSize = 0;
+    if (mTiles) {
+        header[1] |= DESC_TILES;
+        header[4] = ((width + TILE_SIZE - 1) / TILE_SIZE) *
+                ((height + TILE_SIZE - 1) / TILE_SIZE);
+        bitmapSize = (header[4] + 7) / 8;
+    }
+    if (mDescSize < headerSize + bitmapSize) {
+        free(mDesc);
+        mDescSize = headerSize + bitmapSize;
+        mDesc = (uint8_t *)malloc(mDescSize);
+    }
+    memcpy(mDesc, header, headerSize);
 
-    *fbsize = lzf_compress(fbcontents, fbContentsSize, fbcompressed, fbContentsSize);
-    *fb = fbcompressed;
-    *fbwidth = viewport[2];
-    *fbheight = viewport[3];
+    const uint8_t *data = snapshot->pixels;
+    size_t dataSize = size;
+    if (mTiles && size > 0) {
+        dataSize = diffTiles(snapshot->pixels, width, height, mDesc + headerSize);
+        data = mTileData;
+    }
+
+    *fbsize = dataSize > 0 ? lzf_compress(data, dataSize, mCompressed, dataSize) : 0;
+    *desc = mDesc;
+    *descSize = headerSize + bitmapSize;
+}
+
+void GLTraceContext::addFBContents(GLMessage *msg, FBBinding fbToRead) {
+    sp<FrameSnapshot> snapshot = mFBCapture.read(hooks, getVersionMajor() >= 3, fbToRead);
+    if (mWorker != NULL) {
+        // compressed along with the message, see traceGLMessage()
+        mPendingFB = snapshot;
+        return;
+    }
+    encodeFBContents(snapshot, msg);
+}
+
+void GLTraceContext::encodeFBContents(const sp<FrameSnapshot>& snapshot, GLMessage *msg) {
+    void *fbcontents, *fbdesc;
+    unsigned fbsize, fbwidth, fbheight, fbdescsize;
+    mFBCapture.encode(snapshot, &fbcontents, &fbsize, &fbwidth, &fbheight,
+            &fbdesc, &fbdescsize);
+
+    GLMessage_FrameBuffer *fb = msg->mutable_fb();
+    fb->set_width(fbwidth);
+    fb->set_height(fbheight);
+    fb->add_contents(fbcontents, fbsize);
+    if (fbdescsize > 0) {
+        // a partial or delayed capture, see FrameBufferCapture
+        fb->add_contents(fbdesc, fbdescsize);
+    }
+}
+
+void GLTraceContext::startFrame() {
+    mFrameCount++;
+
+    const uint32_t request = mState->getFullDetailRequest();
+    if (request != mFullDetailRequest) {
+        mFullDetailRequest = request;
+        mFullDetailFramesLeft = request & GLTraceState::FULL_DETAIL_FRAMES_MASK;
+    }
+
+    if (mFullDetailFramesLeft > 0) {
+        mFullDetailFramesLeft--;
+        mFullDetail = true;
+    } else {
+        mFullDetail = mFrameCount % mState->getSampleFrames() == 0;
+    }
 }
 
 void GLTraceContext::traceGLMessage(GLMessage *msg) {
+    GLMessage_Function func = msg->function();
+    if (!mFullDetail && func != GLMessage::eglSwapBuffers
+            && func != GLMessage::eglCreateContext
+            && func != GLMessage::eglMakeCurrent) {
+        // a sampled out frame only has the calls and their timing
+        CompactGLMessage compact(func, mId, msg->start_time(),
+                msg->start_time() + msg->duration(), 0, msg->threadtime());
+        traceGLMessage(&compact);
+        return;
+    }
+
+    if (mWorker != NULL) {
+        __sync_fetch_and_add(&mJobsInFlight, 1);
+        mWorker->submit(this, msg, mPendingFB);
+        mPendingFB.clear();
+        return;
+    }
+    sendGLMessage(msg);
+}
+
+void GLTraceContext::traceGLMessage(CompactGLMessage *msg) {
+    // stay behind the messages the worker hasn't sent yet
+    __sync_synchronize();
+    if (mWorker != NULL && mJobsInFlight > 0) {
+        __sync_fetch_and_add(&mJobsInFlight, 1);
+        mWorker->submit(this, msg);
+        return;
+    }
+    sendGLMessage(msg);
+}
+
+void GLTraceContext::sendGLMessage(GLMessage *msg) {
     mBufferedOutputStream->send(msg);
 
     GLMessage_Function func = msg->function();
@@ -250,6 +574,12 @@ void GLTraceContext::traceGLMessage(GLMessage *msg) {
     }
 }
 
+void GLTraceContext::sendGLMessage(CompactGLMessage *msg) {
+    // calls which must be flushed right away are never sent compacted, but
+    // for draws in sampled out frames, which wait for the next swap
+    mBufferedOutputStream->send(msg);
+}
+
 void GLTraceContext::bindBuffer(GLuint bufferId, GLvoid *data, GLsizeiptr size) {
     // free previously bound buffer if any
     ElementArrayBuffer *oldBuffer = mElementArrayBuffers.valueFor(bufferId);
@@ -19,7 +19,9 @@
 
 #include <map>
 #include <pthread.h>
+#include <stdlib.h>
 #include <utils/KeyedVector.h>
+#include <utils/RefBase.h>
 
 #include "hooks.h"
 #include "gltrace_transport.h"
@@ -32,6 +34,7 @@ using ::android::gl_hooks_t;
 enum FBBinding {CURRENTLY_BOUND_FB, FB0};
 
 class GLTraceState;
+class FixupWorker;
 
 class ElementArrayBuffer {
     GLvoid *mBuf;
@@ -47,6 +50,89 @@ public:
     GLsizeiptr getSize();
 };
 
+/**
+ * The RGBA contents of a framebuffer as read back by FrameBufferCapture,
+ * shared with the fixup worker which compresses them.
+ */
+class FrameSnapshot : public LightRefBase<FrameSnapshot> {
+public:
+    uint8_t *pixels;
+    unsigned width;
+    unsigned height;
+    bool lagged;                /* contents of the previous read, see fb_async */
+
+    FrameSnapshot() : pixels(NULL), width(0), height(0), lagged(false) {}
+    ~FrameSnapshot() { free(pixels); }
+};
+
+/**
+ * Reads back and compresses the framebuffer of a trace context.
+ *
+ * By default, each capture is the whole framebuffer, lzf compressed. These
+ * properties make captures cheaper, at the cost of a format that the host
+ * must expand with tools/gltrace_convert.py:
+ *   debug.egl.trace.fb_tiles   only send the tiles which changed since the
+ *                              context's previous capture.
+ *   debug.egl.trace.fb_scale   downsample the framebuffer by this factor.
+ *   debug.egl.trace.fb_async   on OpenGL ES 3 contexts, read back through
+ *                              pixel buffer objects without waiting for the
+ *                              GPU; each capture then carries the contents
+ *                              of the previous one.
+ * A capture in that format comes with a descriptor, see DESIGN.txt.
+ *
+ * read() must be called on the thread the context is current to, encode()
+ * may be called on another thread, one snapshot at a time, in order.
+ */
+class FrameBufferCapture {
+    enum {
+        TILE_SIZE = 32,
+        DESC_MAGIC = 0x44544246,    /* "FBTD" */
+        DESC_TILES = 1 << 0,
+        DESC_LAGGED = 1 << 1,
+    };
+
+    bool mTiles;
+    bool mAsync;
+    unsigned mScale;
+
+    uint8_t *mPrevious;         /* previous capture, for tile diffing */
+    unsigned mPreviousWidth;
+    unsigned mPreviousHeight;
+    uint8_t *mTileData;         /* contents of the tiles which changed */
+    uint8_t *mCompressed;       /* destination for lzf compressed data */
+    size_t mDataSize;           /* size of mTileData & mCompressed */
+    uint8_t *mDesc;
+    size_t mDescSize;
+
+    GLuint mPbos[2];            /* pixel buffer objects for async reads */
+    unsigned mPboWidth[2];
+    unsigned mPboHeight[2];
+    bool mPboPending[2];
+    int mPboNext;
+
+    void resizeData(size_t size);
+    bool readAsync(gl_hooks_t *hooks, const int viewport[4], FrameSnapshot *snapshot);
+    void downsample(FrameSnapshot *snapshot);
+    size_t diffTiles(const uint8_t *pixels, unsigned width, unsigned height,
+            uint8_t *bitmap);
+public:
+    FrameBufferCapture();
+    ~FrameBufferCapture();
+
+    /** Read back the framebuffer, @fbToRead if it isn't the bound one. */
+    sp<FrameSnapshot> read(gl_hooks_t *hooks, bool es3, FBBinding fbToRead);
+
+    /**
+     * Compress @snapshot, downsampling it in place. Sets @fb to the
+     * compressed contents, @desc to the descriptor, or NULL for a plain
+     * capture, and @fbwidth x @fbheight to the size of the image. The
+     * outputs are valid until the next call.
+     */
+    void encode(const sp<FrameSnapshot>& snapshot,
+            void **fb, unsigned *fbsize, unsigned *fbwidth, unsigned *fbheight,
+            void **desc, unsigned *descSize);
+};
+
 /** GL Trace Context info associated with each EGLContext */
 class GLTraceContext {
     int mId;                    /* unique context id */
@@ -56,11 +142,19 @@ class GLTraceContext {
     bool mVersionParsed;        /* True if major and minor versions have been parsed. */
     GLTraceState *mState;       /* parent GL Trace state (for per process GL Trace State Info) */
 
-    void *fbcontents;           /* memory area to read framebuffer contents */
-    void *fbcompressed;         /* destination for lzf compressed framebuffer */
-    unsigned fbcontentsSize;    /* size of fbcontents & fbcompressed buffers */
+    FrameBufferCapture mFBCapture; /* framebuffer readback and compression */
 
     BufferedOutputStream *mBufferedOutputStream; /* stream where trace info is sent */
+    bool mCompactMessages;      /* true if scalar only calls are sent as CompactGLMessages */
+
+    unsigned mFrameCount;       /* number of eglSwapBuffers so far */
+    bool mFullDetail;           /* false if the current frame is only timed, see DESIGN.txt */
+    unsigned mFullDetailFramesLeft; /* of the last window requested by the host */
+    uint32_t mFullDetailRequest;    /* last window request seen */
+
+    FixupWorker *mWorker;       /* NULL if messages are sent from the GL thread */
+    volatile int32_t mJobsInFlight; /* messages handed to mWorker and not sent yet */
+    sp<FrameSnapshot> mPendingFB;   /* for the message being traced, if mWorker */
 
     /* list of element array buffers in use. */
     DefaultKeyedVector<GLuint, ElementArrayBuffer*> mElementArrayBuffers;
@@ -68,19 +162,19 @@ class GLTraceContext {
     /* Parses the GL version string returned from glGetString(GL_VERSION) to get find the major and
        minor versions of the GLES API. The context must be current before calling. */
     void parseGlesVersion();
-    void resizeFBMemory(unsigned minSize);
 public:
     gl_hooks_t *hooks;
 
     GLTraceContext(int id, int version, GLTraceState *state, BufferedOutputStream *stream);
+    ~GLTraceContext();
     int getId();
     int getVersion();
     int getVersionMajor();
     int getVersionMinor();
     GLTraceState *getGlobalTraceState();
-    void getCompressedFB(void **fb, unsigned *fbsize,
-                            unsigned *fbwidth, unsigned *fbheight,
-                            FBBinding fbToRead);
+
+    /** Add the framebuffer contents to @msg, or have the worker do it. */
+    void addFBContents(GLMessage *msg, FBBinding fbToRead);
 
     // Methods to work with element array buffers
     void bindBuffer(GLuint bufferId, GLvoid *data, GLsizeiptr size);
@@ -89,6 +183,19 @@ public:
     void deleteBuffer(GLuint bufferId);
 
     void traceGLMessage(GLMessage *msg);
+    void traceGLMessage(CompactGLMessage *msg);
+    bool useCompactMessages() const { return mCompactMessages; }
+
+    /** Whether the calls of the current frame are traced with their data. */
+    bool isFullDetail() const { return mFullDetail; }
+    /** Called after eglSwapBuffers is traced, decides the detail of the next frame. */
+    void startFrame();
+
+    /* Used by FixupWorker, on its thread. */
+    void sendGLMessage(GLMessage *msg);
+    void sendGLMessage(CompactGLMessage *msg);
+    void encodeFBContents(const sp<FrameSnapshot>& snapshot, GLMessage *msg);
+    void jobDone() { __sync_fetch_and_sub(&mJobsInFlight, 1); }
 };
 
 /** Per process trace state. */
@@ -104,10 +211,19 @@ class GLTraceState {
     bool mCollectTextureDataOnGlTexImage;
     pthread_rwlock_t mTraceOptionsRwLock;
 
+    /* Frame sampling, see DESIGN.txt. */
+    unsigned mSampleFrames;
+    volatile uint32_t mFullDetailRequest;   /* sequence number, then window size */
+
+    FixupWorker *mWorker;
+
     /* helper methods to get/set values using provided lock for mutual exclusion. */
     void safeSetValue(bool *ptr, bool value, pthread_rwlock_t *lock);
     bool safeGetValue(bool *ptr, pthread_rwlock_t *lock);
 public:
+    /** Bits of a full detail request holding the number of frames. */
+    static const uint32_t FULL_DETAIL_FRAMES_MASK = 0xffff;
+
     GLTraceState(TCPStream *stream);
     ~GLTraceState();
 
@@ -125,6 +241,15 @@ public:
     bool shouldCollectFbOnEglSwap();
     bool shouldCollectFbOnGlDraw();
     bool shouldCollectTextureDataOnGlTexImage();
+
+    /** Frames are traced with full detail one in this many, 1 for all of them. */
+    unsigned getSampleFrames() const { return mSampleFrames; }
+    /** Trace the next @frames frames of each context with full detail. */
+    void requestFullDetailFrames(unsigned frames);
+    uint32_t getFullDetailRequest() const { return mFullDetailRequest; }
+
+    /** The worker of the contexts, NULL unless "debug.egl.trace.fixup_thread" is set. */
+    FixupWorker *getWorker() { return mWorker; }
 };
 
 void setupTraceContextThreadSpecific(GLTraceContext *context);
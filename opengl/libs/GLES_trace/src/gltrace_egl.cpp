@@ -78,7 +78,8 @@ void GLTrace_eglSwapBuffers(void* /*dpy*/, void* /*draw*/) {
     glmessage.set_context_id(glContext->getId());
     glmessage.set_function(GLMessage::eglSwapBuffers);
 
-    if (glContext->getGlobalTraceState()->shouldCollectFbOnEglSwap()) {
+    if (glContext->isFullDetail() &&
+            glContext->getGlobalTraceState()->shouldCollectFbOnEglSwap()) {
         // read FB0 since that is what is displayed on the screen
         fixup_addFBContents(glContext, &glmessage, FB0);
     }
@@ -88,6 +89,7 @@ void GLTrace_eglSwapBuffers(void* /*dpy*/, void* /*draw*/) {
     glmessage.set_duration(0);
 
     glContext->traceGLMessage(&glmessage);
+    glContext->startFrame();
 }
 
 };
@@ -59,6 +59,8 @@ static void *commandReceiveTask(void *arg) {
         READ_FB_ON_EGLSWAP_MASK = 1 << 0,
         READ_FB_ON_GLDRAW_MASK = 1 << 1,
         READ_TEXTURE_DATA_ON_GLTEXIMAGE_MASK = 1 << 2,
+        /* trace that many frames with full detail from now on, when sampling */
+        FULL_DETAIL_FRAMES_SHIFT = 16,
     };
 
     while (true) {
@@ -98,8 +100,13 @@ static void *commandReceiveTask(void *arg) {
         state->setCollectFbOnGlDraw(collectFbOnGlDraw);
         state->setCollectTextureDataOnGlTexImage(collectTextureData);
 
-        ALOGD("trace options: eglswap: %d, gldraw: %d, texImage: %d",
-            collectFbOnEglSwap, collectFbOnGlDraw, collectTextureData);
+        unsigned fullDetailFrames = cmd >> FULL_DETAIL_FRAMES_SHIFT;
+        if (fullDetailFrames > 0) {
+            state->requestFullDetailFrames(fullDetailFrames);
+        }
+
+        ALOGD("trace options: eglswap: %d, gldraw: %d, texImage: %d, full detail frames: %u",
+            collectFbOnEglSwap, collectFbOnGlDraw, collectTextureData, fullDetailFrames);
     }
 
     ALOGE("Stopping OpenGL Trace Command Receiver\n");
@@ -108,6 +115,29 @@ static void *commandReceiveTask(void *arg) {
     return NULL;
 }
 
+/**
+ * Returns the TCPStream flags selected by the "debug.egl.trace.compress",
+ * "debug.egl.trace.drop" and "debug.egl.trace.compact" properties.
+ */
+static int getTransportFlags() {
+    char value[PROPERTY_VALUE_MAX];
+    int flags = 0;
+
+    property_get("debug.egl.trace.compress", value, "0");
+    if (atoi(value)) {
+        flags |= TCPStream::COMPRESS;
+    }
+    property_get("debug.egl.trace.drop", value, "0");
+    if (atoi(value)) {
+        flags |= TCPStream::DROP_WHEN_FULL;
+    }
+    property_get("debug.egl.trace.compact", value, "0");
+    if (atoi(value)) {
+        flags |= TCPStream::COMPACT_MESSAGES;
+    }
+    return flags;
+}
+
 /**
  * Starts Trace Server and waits for connection from the host.
  * Returns -1 in case of connection error, 0 otherwise.
@@ -135,7 +165,7 @@ int GLTrace_start() {
     sGlTraceInProgress = 1;
 
     // create communication channel to the host
-    stream = new TCPStream(clientSocket);
+    stream = new TCPStream(clientSocket, getTransportFlags());
 
     // initialize tracing state
     sGLTraceState = new GLTraceState(stream);
@@ -172,14 +172,7 @@ void fixup_glGetString(GLMessage *glmsg, void *pointersToFixup[]) {
 
 /* Add the contents of the framebuffer to the protobuf message */
 void fixup_addFBContents(GLTraceContext *context, GLMessage *glmsg, FBBinding fbToRead) {
-    void *fbcontents;
-    unsigned fbsize, fbwidth, fbheight;
-    context->getCompressedFB(&fbcontents, &fbsize, &fbwidth, &fbheight, fbToRead);
-
-    GLMessage_FrameBuffer *fb = glmsg->mutable_fb();
-    fb->set_width(fbwidth);
-    fb->set_height(fbheight);
-    fb->add_contents(fbcontents, fbsize);
+    context->addFBContents(glmsg, fbToRead);
 }
 
 /** Common fixup routing for glTexImage2D & glTexSubImage2D. */
@@ -475,18 +468,36 @@ void addGlBufferData(GLMessage *glmsg, int dataIndex, GLvoid *src, GLsizeiptr le
     arg_datap->add_rawbytes(src, len);
 }
 
+/**
+ * Save element array buffers for future use to fixup glVertexAttribPointers
+ * when a glDrawElements() call is performed. Done for every glBufferData and
+ * glBufferSubData call, including those of sampled out frames.
+ */
+void trackElementArrayBuffer(GLTraceContext *context, GLMessage *glmsg,
+        void *pointersToFixup[]) {
+    GLenum target = glmsg->args(0).intvalue(0);
+    if (target != GL_ELEMENT_ARRAY_BUFFER) {
+        return;
+    }
+
+    GLint bufferId = glGetInteger(context, GL_ELEMENT_ARRAY_BUFFER_BINDING);
+    GLvoid *datap = (GLvoid *) pointersToFixup[0];
+    if (glmsg->function() == GLMessage::glBufferData) {
+        GLsizeiptr size = glmsg->args(1).intvalue(0);
+        context->bindBuffer(bufferId, datap, size);
+    } else {
+        GLintptr offset = glmsg->args(1).intvalue(0);
+        GLsizeiptr size = glmsg->args(2).intvalue(0);
+        context->updateBufferSubData(bufferId, offset, datap, size);
+    }
+}
+
 void fixup_glBufferData(GLTraceContext *context, GLMessage *glmsg, void *pointersToFixup[]) {
     /* void glBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) */
     GLsizeiptr size = glmsg->args(1).intvalue(0);
     GLvoid *datap = (GLvoid *) pointersToFixup[0];
 
-    // Save element array buffers for future use to fixup glVertexAttribPointers
-    // when a glDrawElements() call is performed.
-    GLenum target = glmsg->args(0).intvalue(0);
-    if (target == GL_ELEMENT_ARRAY_BUFFER) {
-        GLint bufferId = glGetInteger(context, GL_ELEMENT_ARRAY_BUFFER_BINDING);
-        context->bindBuffer(bufferId, datap, size);
-    }
+    trackElementArrayBuffer(context, glmsg, pointersToFixup);
 
     // add buffer data to the protobuf message
     if (datap != NULL) {
@@ -496,14 +507,10 @@ void fixup_glBufferData(GLTraceContext *context, GLMessage *glmsg, void *pointer
 
 void fixup_glBufferSubData(GLTraceContext *context, GLMessage *glmsg, void *pointersToFixup[]) {
     /* void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) */
-    GLenum target = glmsg->args(0).intvalue(0);
-    GLintptr offset = glmsg->args(1).intvalue(0);
     GLsizeiptr size = glmsg->args(2).intvalue(0);
     GLvoid *datap = (GLvoid *) pointersToFixup[0];
-    if (target == GL_ELEMENT_ARRAY_BUFFER) {
-        GLint bufferId = glGetInteger(context, GL_ELEMENT_ARRAY_BUFFER_BINDING);
-        context->updateBufferSubData(bufferId, offset, datap, size);
-    }
+
+    trackElementArrayBuffer(context, glmsg, pointersToFixup);
 
     // add buffer data to the protobuf message
     addGlBufferData(glmsg, 3, datap, size);
@@ -764,6 +771,15 @@ void fixupGLMessage(GLTraceContext *context, nsecs_t wallStart, nsecs_t wallEnd,
     glmsg->set_duration((unsigned)(wallEnd - wallStart));
     glmsg->set_threadtime((unsigned)(threadEnd - threadStart));
 
+    // a sampled out frame is sent without data, only keep what later frames need
+    if (!context->isFullDetail()) {
+        if (glmsg->function() == GLMessage::glBufferData
+                || glmsg->function() == GLMessage::glBufferSubData) {
+            trackElementArrayBuffer(context, glmsg, pointersToFixup);
+        }
+        return;
+    }
+
     // do any custom message dependent processing
     switch (glmsg->function()) {
     case GLMessage::glDeleteBuffers:      /* glDeleteBuffers(GLsizei n, GLuint *buffers); */
@@ -26,6 +26,10 @@
 #include <cutils/log.h>
 #include <private/android_filesystem_config.h>
 
+extern "C" {
+#include "liblzf/lzf.h"
+}
+
 #include "gltrace_transport.h"
 
 namespace android {
@@ -91,16 +95,41 @@ int acceptClientConnection(char *sockname) {
     return clientSocket;
 }
 
-TCPStream::TCPStream(int socket) {
+TCPStream::TCPStream(int socket, int flags) {
     mSocket = socket;
+    mFlags = flags;
     pthread_mutex_init(&mSocketWriteMutex, NULL);
+
+    pthread_mutex_init(&mSenderLock, NULL);
+    pthread_cond_init(&mSenderCond, NULL);
+    pthread_cond_init(&mSpaceCond, NULL);
+    mSenderWaiting = 0;
+    mProducersWaiting = 0;
+    mClosed = 0;
+    mCompressBuffer = NULL;
+    mCompressBufferSize = 0;
+
+    pthread_create(&mSenderThread, NULL, senderTask, this);
 }
 
 TCPStream::~TCPStream() {
+    closeStream();
+    pthread_join(mSenderThread, NULL);
+
+    pthread_cond_destroy(&mSpaceCond);
+    pthread_cond_destroy(&mSenderCond);
+    pthread_mutex_destroy(&mSenderLock);
     pthread_mutex_destroy(&mSocketWriteMutex);
+    free(mCompressBuffer);
 }
 
 void TCPStream::closeStream() {
+    pthread_mutex_lock(&mSenderLock);
+    mClosed = 1;
+    pthread_cond_broadcast(&mSenderCond);
+    pthread_cond_broadcast(&mSpaceCond);
+    pthread_mutex_unlock(&mSenderLock);
+
     if (mSocket > 0) {
         close(mSocket);
         mSocket = 0;
@@ -113,10 +142,137 @@ int TCPStream::send(void *buf, size_t len) {
     }
 
     pthread_mutex_lock(&mSocketWriteMutex);
-    int n = write(mSocket, buf, len);
+    size_t totalWritten = 0;
+    while (totalWritten < len) {
+        int n = write(mSocket, (uint8_t*)buf + totalWritten, len - totalWritten);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        totalWritten += n;
+    }
     pthread_mutex_unlock(&mSocketWriteMutex);
 
-    return n;
+    return totalWritten == len ? 0 : -1;
+}
+
+int TCPStream::sendChunk(const void *data, size_t len) {
+    if ((mFlags & COMPRESS) && len > 2 * sizeof(uint32_t)) {
+        if (mCompressBufferSize < len) {
+            free(mCompressBuffer);
+            mCompressBuffer = malloc(len);
+            mCompressBufferSize = mCompressBuffer != NULL ? len : 0;
+        }
+
+        // only send the compressed data if it saves the header's size
+        const size_t headerSize = 2 * sizeof(uint32_t);
+        size_t compressedSize = 0;
+        if (mCompressBuffer != NULL) {
+            compressedSize = lzf_compress(data, len,
+                    (uint8_t*)mCompressBuffer + headerSize, len - headerSize - 1);
+        }
+        if (compressedSize > 0) {
+            uint32_t *header = (uint32_t *)mCompressBuffer;
+            header[0] = compressedSize | COMPRESSED_CHUNK;
+            header[1] = len;
+            return send(mCompressBuffer, headerSize + compressedSize);
+        }
+    }
+
+    return send((void *)data, len);
+}
+
+void *TCPStream::senderTask(void *arg) {
+    ((TCPStream *)arg)->senderLoop();
+    return NULL;
+}
+
+void TCPStream::senderLoop() {
+    std::vector<BufferedOutputStream *> streams;
+
+    while (!mClosed) {
+        pthread_mutex_lock(&mSenderLock);
+        streams = mOutputStreams;
+        pthread_mutex_unlock(&mSenderLock);
+
+        bool sent = false;
+        bool error = false;
+        for (size_t i = 0; i < streams.size(); i++) {
+            int n = streams[i]->drain();
+            if (n < 0) {
+                error = true;
+                break;
+            }
+            sent |= n > 0;
+        }
+
+        if (error) {
+            ALOGE("Error sending trace data, stopping the trace sender");
+            break;
+        }
+
+        if (sent) {
+            // let writers blocked on a full ring continue
+            __sync_synchronize();
+            if (mProducersWaiting) {
+                pthread_mutex_lock(&mSenderLock);
+                pthread_cond_broadcast(&mSpaceCond);
+                pthread_mutex_unlock(&mSenderLock);
+            }
+            continue;
+        }
+
+        // Nothing left to send, wait for a flush. A writer which flushed
+        // before mSenderWaiting was set is seen by the check below, any later
+        // one sees mSenderWaiting and signals.
+        pthread_mutex_lock(&mSenderLock);
+        __sync_lock_test_and_set(&mSenderWaiting, 1);
+        __sync_synchronize();
+        bool pending = false;
+        for (size_t i = 0; i < mOutputStreams.size(); i++) {
+            pending |= mOutputStreams[i]->hasPendingBuffers();
+        }
+        if (!pending && !mClosed) {
+            pthread_cond_wait(&mSenderCond, &mSenderLock);
+        }
+        __sync_lock_test_and_set(&mSenderWaiting, 0);
+        pthread_mutex_unlock(&mSenderLock);
+    }
+
+    // don't leave writers blocked forever
+    pthread_mutex_lock(&mSenderLock);
+    mClosed = 1;
+    pthread_cond_broadcast(&mSpaceCond);
+    pthread_mutex_unlock(&mSenderLock);
+}
+
+void TCPStream::addOutputStream(BufferedOutputStream *stream) {
+    pthread_mutex_lock(&mSenderLock);
+    mOutputStreams.push_back(stream);
+    pthread_mutex_unlock(&mSenderLock);
+}
+
+void TCPStream::wakeSender() {
+    __sync_synchronize();
+    if (mSenderWaiting) {
+        pthread_mutex_lock(&mSenderLock);
+        pthread_cond_signal(&mSenderCond);
+        pthread_mutex_unlock(&mSenderLock);
+    }
+}
+
+bool TCPStream::waitForSpace(BufferedOutputStream *stream) {
+    pthread_mutex_lock(&mSenderLock);
+    __sync_fetch_and_add(&mProducersWaiting, 1);
+    while (stream->isFull() && !mClosed) {
+        pthread_cond_wait(&mSpaceCond, &mSenderLock);
+    }
+    __sync_fetch_and_sub(&mProducersWaiting, 1);
+    bool closed = mClosed;
+    pthread_mutex_unlock(&mSenderLock);
+    return !closed;
 }
 
 int TCPStream::receive(void *data, size_t len) {
@@ -142,35 +298,110 @@ BufferedOutputStream::BufferedOutputStream(TCPStream *stream, size_t bufferSize)
     mStream = stream;
 
     mBufferSize = bufferSize;
-    mStringBuffer = "";
-    mStringBuffer.reserve(bufferSize);
+    for (size_t i = 0; i < NUM_BUFFERS; i++) {
+        mBuffers[i].reserve(bufferSize);
+    }
+    mHead = 0;
+    mTail = 0;
+    mDroppedMessages = 0;
+
+    mStream->addOutputStream(this);
 }
 
 int BufferedOutputStream::flush() {
-    if (mStringBuffer.size() == 0) {
+    if (isFull()) {
+        // the current buffer still belongs to the sender, nothing to flush
+        return 0;
+    }
+
+    std::string &buffer = mBuffers[mHead % NUM_BUFFERS];
+    if (buffer.size() == 0) {
         return 0;
     }
 
-    int n = mStream->send((void *)mStringBuffer.data(), mStringBuffer.size());
-    mStringBuffer.clear();
-    return n;
+    // publish the buffer to the sender thread
+    __sync_fetch_and_add(&mHead, 1);
+    mStream->wakeSender();
+    return 0;
+}
+
+int BufferedOutputStream::drain() {
+    const uint32_t head = mHead;
+    __sync_synchronize();
+
+    int totalSent = 0;
+    while (mTail != head) {
+        std::string &buffer = mBuffers[mTail % NUM_BUFFERS];
+        if (mStream->sendChunk(buffer.data(), buffer.size()) < 0) {
+            return -1;
+        }
+        totalSent += buffer.size();
+
+        // don't hold on to the memory used by an unusually large message
+        if (buffer.capacity() > 4 * mBufferSize) {
+            std::string().swap(buffer);
+            buffer.reserve(mBufferSize);
+        } else {
+            buffer.clear();
+        }
+
+        // hand the buffer back to the writer
+        __sync_fetch_and_add(&mTail, 1);
+    }
+    return totalSent;
 }
 
 void BufferedOutputStream::enqueueMessage(GLMessage *msg) {
+    std::string &buffer = mBuffers[mHead % NUM_BUFFERS];
     const uint32_t len = msg->ByteSize();
 
-    mStringBuffer.append((const char *)&len, sizeof(len));    // append header
-    msg->AppendToString(&mStringBuffer);                      // append message
+    buffer.append((const char *)&len, sizeof(len));    // append header
+    msg->AppendToString(&buffer);                      // append message
+}
+
+int BufferedOutputStream::reserve() {
+    if (isFull()) {
+        if (mStream->shouldDropWhenFull()) {
+            if ((mDroppedMessages++ % 1024) == 0) {
+                ALOGW("Trace sender can't keep up, %u messages dropped",
+                        mDroppedMessages);
+            }
+            return 0;
+        }
+        if (!mStream->waitForSpace(this)) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+int BufferedOutputStream::flushIfFull() {
+    if (mBuffers[mHead % NUM_BUFFERS].size() > mBufferSize) {
+        return flush();
+    }
+    return 0;
 }
 
 int BufferedOutputStream::send(GLMessage *msg) {
+    int n = reserve();
+    if (n <= 0) {
+        return n;
+    }
+
     enqueueMessage(msg);
+    return flushIfFull();
+}
 
-    if (mStringBuffer.size() > mBufferSize) {
-        return flush();
+int BufferedOutputStream::send(CompactGLMessage *msg) {
+    int n = reserve();
+    if (n <= 0) {
+        return n;
     }
 
-    return 0;
+    // the record starts with its own size
+    const void *data = msg->data();
+    mBuffers[mHead % NUM_BUFFERS].append((const char *)data, msg->size());
+    return flushIfFull();
 }
 
 };  // namespace gltrace
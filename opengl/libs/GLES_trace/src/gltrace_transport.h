@@ -18,22 +18,58 @@
 #define __GLTRACE_TRANSPORT_H_
 
 #include <pthread.h>
+#include <vector>
 
 #include "gltrace.pb.h"
+#include "gltrace_compact.h"
 
 namespace android {
 namespace gltrace {
 
+class BufferedOutputStream;
+
 /**
  * TCPStream provides a TCP based communication channel from the device to
  * the host for transferring GLMessages.
+ *
+ * Messages are written to the channel by a sender thread owned by the stream,
+ * which drains the buffers of all the BufferedOutputStreams created over it.
  */
 class TCPStream {
     int mSocket;
+    int mFlags;
     pthread_mutex_t mSocketWriteMutex;
+
+    pthread_t mSenderThread;
+    pthread_mutex_t mSenderLock;
+    pthread_cond_t mSenderCond;     /* signaled when a buffer is ready */
+    pthread_cond_t mSpaceCond;      /* signaled when a buffer was sent */
+    volatile int32_t mSenderWaiting;
+    volatile int32_t mProducersWaiting;
+    volatile int32_t mClosed;
+    std::vector<BufferedOutputStream *> mOutputStreams;
+
+    void *mCompressBuffer;
+    size_t mCompressBufferSize;
+
+    static void *senderTask(void *arg);
+    void senderLoop();
 public:
+    enum {
+        /** Compress the data sent with lzf, see sendChunk(). */
+        COMPRESS        = 1 << 0,
+        /** Drop messages instead of blocking the GL thread when the sender
+            can't keep up. */
+        DROP_WHEN_FULL  = 1 << 1,
+        /** Send scalar only GL calls as CompactGLMessages. */
+        COMPACT_MESSAGES = 1 << 2,
+    };
+
+    /** Bit set in the length of a compressed chunk, see sendChunk(). */
+    static const uint32_t COMPRESSED_CHUNK = 0x80000000;
+
     /** Create a TCP based communication channel over @socket */
-    TCPStream(int socket);
+    TCPStream(int socket, int flags = 0);
     ~TCPStream();
 
     /** Close the channel. */
@@ -42,25 +78,60 @@ public:
     /** Send @data of size @len to host. . Returns -1 on error, 0 on success. */
     int send(void *data, size_t len);
 
+    /**
+     * Send @len bytes of messages at @data to the host. If compression is
+     * enabled and worthwhile, the chunk is sent as a 32 bit length with
+     * COMPRESSED_CHUNK set, the 32 bit uncompressed length and the lzf
+     * compressed data. Returns -1 on error, 0 on success.
+     */
+    int sendChunk(const void *data, size_t len);
+
     /**
      * Receive @len bytes of data into @buf from the remote end. This is a blocking call.
      * Returns -1 on failure, 0 on success.
      */
     int receive(void *buf, size_t len);
+
+    bool shouldDropWhenFull() const { return (mFlags & DROP_WHEN_FULL) != 0; }
+    bool useCompactMessages() const { return (mFlags & COMPACT_MESSAGES) != 0; }
+
+    /* Used by BufferedOutputStream to hand buffers to the sender thread. */
+    void addOutputStream(BufferedOutputStream *stream);
+    void wakeSender();
+    /** Wait until @stream has room for a new message, returns false if
+        the stream was closed. */
+    bool waitForSpace(BufferedOutputStream *stream);
 };
 
 /**
  * BufferedOutputStream provides buffering of data sent to the underlying
  * unbuffered channel.
+ *
+ * Messages are serialized into a ring of buffers, flushed buffers are sent by
+ * the TCPStream's sender thread. A stream must only be written to by one
+ * thread at a time, such as the one its GL context is current to, and no
+ * lock is taken unless the sender thread is idle or the ring is full.
  */
 class BufferedOutputStream {
+    enum { NUM_BUFFERS = 16 };
+
     TCPStream *mStream;
 
     size_t mBufferSize;
-    std::string mStringBuffer;
+    std::string mBuffers[NUM_BUFFERS];
+    volatile uint32_t mHead;    /* buffer being filled, owned by the writer */
+    volatile uint32_t mTail;    /* next buffer to send, owned by the sender */
+    uint32_t mDroppedMessages;
 
     /** Enqueue message into internal buffer. */
     void enqueueMessage(GLMessage *msg);
+
+    /** Make room for a message in the current buffer. Returns 1 if there
+        is room, 0 if the message must be dropped and -1 on error. */
+    int reserve();
+
+    /** Flush the current buffer if it is full. */
+    int flushIfFull();
 public:
     /**
      * Construct a Buffered stream of size @bufferSize, using @stream as
@@ -73,9 +144,23 @@ public:
      * subsequent message. Returns -1 on error, 0 on success.
      */
     int send(GLMessage *msg);
+    int send(CompactGLMessage *msg);
 
-    /** Send any buffered messages, returns -1 on error, 0 on success. */
+    /** Hand any buffered messages to the sender thread, returns -1 on
+        error, 0 on success. */
     int flush();
+
+    /** Whether there are flushed buffers waiting to be sent. */
+    bool hasPendingBuffers() const { return mHead != mTail; }
+
+    /** Whether all the buffers are waiting to be sent. */
+    bool isFull() const { return mHead - mTail >= NUM_BUFFERS; }
+
+    /**
+     * Send the flushed buffers, called by the sender thread. Returns the
+     * number of bytes sent, or -1 on error.
+     */
+    int drain();
 };
 
 /**
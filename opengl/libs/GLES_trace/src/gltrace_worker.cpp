@@ -0,0 +1,153 @@
+/*
+ * Copyright 2014, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cutils/log.h>
+
+#include "gltrace_worker.h"
+
+namespace android {
+namespace gltrace {
+
+FixupWorker::FixupWorker() {
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mJobCond, NULL);
+    pthread_cond_init(&mDoneCond, NULL);
+    mHead = NULL;
+    mTail = NULL;
+    mCount = 0;
+    mClosed = false;
+
+    pthread_create(&mThread, NULL, workerTask, this);
+}
+
+FixupWorker::~FixupWorker() {
+    close();
+    pthread_join(mThread, NULL);
+
+    pthread_cond_destroy(&mDoneCond);
+    pthread_cond_destroy(&mJobCond);
+    pthread_mutex_destroy(&mLock);
+}
+
+void FixupWorker::close() {
+    pthread_mutex_lock(&mLock);
+    mClosed = true;
+    pthread_cond_broadcast(&mJobCond);
+    pthread_cond_broadcast(&mDoneCond);
+    pthread_mutex_unlock(&mLock);
+}
+
+void FixupWorker::enqueue(Job *job) {
+    pthread_mutex_lock(&mLock);
+    while (mCount >= MAX_JOBS && !mClosed) {
+        pthread_cond_wait(&mDoneCond, &mLock);
+    }
+    if (mClosed) {
+        pthread_mutex_unlock(&mLock);
+        job->context->jobDone();
+        delete job;
+        return;
+    }
+
+    if (mTail != NULL) {
+        mTail->next = job;
+    } else {
+        mHead = job;
+    }
+    mTail = job;
+    if (mCount++ == 0) {
+        pthread_cond_signal(&mJobCond);
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+void FixupWorker::submit(GLTraceContext *context, GLMessage *msg,
+        const sp<FrameSnapshot>& fb) {
+    Job *job = new Job();
+    job->context = context;
+    job->msg.Swap(msg);
+    job->fb = fb;
+    enqueue(job);
+}
+
+void FixupWorker::submit(GLTraceContext *context, CompactGLMessage *msg) {
+    Job *job = new Job();
+    job->context = context;
+    job->compact = new CompactGLMessage(*msg);
+    enqueue(job);
+}
+
+void FixupWorker::waitForJobs(volatile int32_t *jobsInFlight) {
+    pthread_mutex_lock(&mLock);
+    while (*jobsInFlight > 0 && !mClosed) {
+        pthread_cond_wait(&mDoneCond, &mLock);
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+void *FixupWorker::workerTask(void *arg) {
+    ((FixupWorker *)arg)->workerLoop();
+    return NULL;
+}
+
+void FixupWorker::workerLoop() {
+    pthread_mutex_lock(&mLock);
+    while (true) {
+        while (mHead == NULL && !mClosed) {
+            pthread_cond_wait(&mJobCond, &mLock);
+        }
+        if (mClosed) {
+            break;
+        }
+
+        Job *job = mHead;
+        mHead = job->next;
+        if (mHead == NULL) {
+            mTail = NULL;
+        }
+        pthread_mutex_unlock(&mLock);
+
+        if (job->compact != NULL) {
+            job->context->sendGLMessage(job->compact);
+        } else {
+            if (job->fb != NULL) {
+                job->context->encodeFBContents(job->fb, &job->msg);
+            }
+            job->context->sendGLMessage(&job->msg);
+        }
+        job->context->jobDone();
+        delete job;
+
+        pthread_mutex_lock(&mLock);
+        mCount--;
+        pthread_cond_broadcast(&mDoneCond);
+    }
+
+    // the queued messages are dropped, don't leave their contexts waiting
+    while (mHead != NULL) {
+        Job *job = mHead;
+        mHead = job->next;
+        job->context->jobDone();
+        delete job;
+    }
+    mTail = NULL;
+    mCount = 0;
+    pthread_cond_broadcast(&mDoneCond);
+    pthread_mutex_unlock(&mLock);
+}
+
+};  // namespace gltrace
+};  // namespace android
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GLTRACE_WORKER_H_
+#define __GLTRACE_WORKER_H_
+
+#include <pthread.h>
+
+#include "gltrace.pb.h"
+#include "gltrace_compact.h"
+#include "gltrace_context.h"
+
+namespace android {
+namespace gltrace {
+
+/**
+ * FixupWorker takes the expensive part of tracing a call off the GL thread:
+ * it compresses framebuffer snapshots into their messages, and serializes
+ * the messages into their context's stream. It is used when the
+ * "debug.egl.trace.fixup_thread" property is set.
+ *
+ * Data behind the pointers of a call is still copied on the GL thread,
+ * since the application may reuse it as soon as the call returns.
+ *
+ * While a context has messages queued, its compact records are queued
+ * behind them, so that the worker is the only writer of the context's
+ * stream until it catches up and the context's messages stay in order.
+ */
+class FixupWorker {
+    enum { MAX_JOBS = 256 };
+
+    struct Job {
+        GLTraceContext *context;
+        GLMessage msg;
+        CompactGLMessage *compact;  /* sent instead of msg if set */
+        sp<FrameSnapshot> fb;       /* compressed into msg if set */
+        Job *next;
+
+        Job() : context(NULL), compact(NULL), next(NULL) {}
+        ~Job() { delete compact; }
+    };
+
+    pthread_t mThread;
+    pthread_mutex_t mLock;
+    pthread_cond_t mJobCond;        /* signaled when a job is queued */
+    pthread_cond_t mDoneCond;       /* signaled when a job is done */
+    Job *mHead;
+    Job *mTail;
+    size_t mCount;
+    bool mClosed;
+
+    static void *workerTask(void *arg);
+    void workerLoop();
+    void enqueue(Job *job);
+public:
+    FixupWorker();
+    ~FixupWorker();
+
+    /**
+     * Queue @msg, taking its contents, to be sent with the contents of @fb
+     * if it isn't NULL. Blocks while MAX_JOBS messages are queued.
+     */
+    void submit(GLTraceContext *context, GLMessage *msg, const sp<FrameSnapshot>& fb);
+    void submit(GLTraceContext *context, CompactGLMessage *msg);
+
+    /** Wait until the messages counted by @jobsInFlight are sent. */
+    void waitForJobs(volatile int32_t *jobsInFlight);
+
+    /** Drop the queued messages and the ones submitted from now on. */
+    void close();
+};
+
+};
+};
+
+#endif
@@ -67,6 +67,16 @@ class DataType:
         else:
             raise ValueError("Unknown value type %s" % self.name)
 
+    def getCompactCall(self):
+        if self.name == "float":
+            return "addFloat("
+        elif self.name == "int64":
+            return "addInt64("
+        elif self.name in ("char", "byte", "enum", "int", "bool"):
+            return "addInt(GLMessage::DataType::%s, (int32_t)" % self
+        else:
+            raise ValueError("No compact encoding for value type %s" % self.name)
+
 DataType.VOID = DataType("void")
 DataType.CHAR = DataType("char")
 DataType.BYTE = DataType("byte")
@@ -106,6 +116,15 @@ GLPROTOBUF_TYPE_MAP = {
     "GLDEBUGPROCKHR":DataType.POINTER,
 }
 
+# functions with only scalar arguments that still need fixupGLMessage
+COMPACT_EXCLUDED_FUNCS = [
+    "glDrawArrays",     # may read back the framebuffer
+    "glLinkProgram",    # queries the program's active attributes and uniforms
+]
+
+# CompactGLMessage holds at most this many values
+COMPACT_MAX_VALUES = 16
+
 API_SPECS = [
     ('GL2','../GLES2/gl2_api.in'),
     ('GL2Ext','../GLES2/gl2ext_api.in'),
@@ -137,6 +156,7 @@ HEADER_INCLUDES = """
 #include <utils/Timers.h>
 
 #include "gltrace.pb.h"
+#include "gltrace_compact.h"
 #include "gltrace_context.h"
 #include "gltrace_fixup.h"
 #include "gltrace_transport.h"
@@ -154,8 +174,43 @@ FOOTER_TEXT = """
 
 TRACE_CALL_TEMPLATE = pyratemp.Template(
 """$!retType!$ GLTrace_$!func!$($!inputArgList!$) {
+<!--(if compact)-->
+    GLTraceContext *glContext = getGLTraceContext();
+
+    if (glContext->useCompactMessages()) {
+        nsecs_t wallStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t threadStartTime = systemTime(SYSTEM_TIME_THREAD);
+    <!--(if retType != "void")-->
+        $!retType!$ retValue = glContext->hooks->gl.$!callsite!$;
+    <!--(else)-->
+        glContext->hooks->gl.$!callsite!$;
+    <!--(end)-->
+        nsecs_t threadEndTime = systemTime(SYSTEM_TIME_THREAD);
+        nsecs_t wallEndTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        CompactGLMessage msg(GLMessage::$!func!$, glContext->getId(),
+                             wallStartTime, wallEndTime,
+                             threadStartTime, threadEndTime);
+    <!--(for argname, argtype in parsedArgs)-->
+        msg.$!argtype.getCompactCall()!$$!argname!$);
+    <!--(end)-->
+    <!--(if retType != "void")-->
+        msg.$!retDataType.getCompactCall()!$retValue);
+        msg.setReturnValue();
+    <!--(end)-->
+        glContext->traceGLMessage(&msg);
+    <!--(if retType != "void")-->
+        return retValue;
+    <!--(else)-->
+        return;
+    <!--(end)-->
+    }
+
+    GLMessage glmsg;
+<!--(else)-->
     GLMessage glmsg;
     GLTraceContext *glContext = getGLTraceContext();
+<!--(end)-->
 
     glmsg.set_function(GLMessage::$!func!$);
 <!--(if len(parsedArgs) > 0)-->
@@ -334,8 +389,27 @@ class ApiCall(object):
     def genDeclaration(self):
         return "%s GLTrace_%s(%s);" % (self.ret, self.func, self.arglist)
 
+    def isCompact(self):
+        '''Whether the call can be traced as a CompactGLMessage: all its
+        arguments and its return value must be scalars.'''
+        if self.func in COMPACT_EXCLUDED_FUNCS:
+            return False
+        retDataType = getDataTypeFromKw(self.ret)
+        if retDataType == DataType.POINTER:
+            return False
+        values = [argtype for (argname, argtype) in parseArgs(self.arglist)]
+        if retDataType != DataType.VOID:
+            values.append(retDataType)
+        if len(values) > COMPACT_MAX_VALUES:
+            return False
+        for argtype in values:
+            if argtype == DataType.POINTER or argtype == DataType.VOID:
+                return False
+        return True
+
     def genCode(self):
         return TRACE_CALL_TEMPLATE(func = self.func,
+                                   compact = self.isCompact(),
                                    retType = self.ret,
                                    retDataType = getDataTypeFromKw(self.ret),
                                    inputArgList = self.arglist,
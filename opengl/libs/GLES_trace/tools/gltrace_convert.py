@@ -0,0 +1,247 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2014 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# ABOUT
+#   This script converts a trace captured with any of the properties
+#   "debug.egl.trace.compress", "debug.egl.trace.compact" or
+#   "debug.egl.trace.fb_*" set into a plain stream of length prefixed
+#   GLMessage protobufs with complete framebuffer images, which is what the
+#   trace viewers expect. See DESIGN.txt and src/gltrace_compact.h for the
+#   formats.
+#
+# PREREQUISITES
+#   The python protobuf module, and gltrace_pb2.py generated with
+#   $ protoc --python_out=tools gltrace.proto
+#
+# USAGE
+#   $ ./tools/gltrace_convert.py trace.raw trace.gltrace
+
+import struct
+import sys
+
+import gltrace_pb2
+
+COMPRESSED_CHUNK = 0x80000000
+COMPACT_RECORD = 0x40000000
+
+# struct layout of a CompactGLMessage, after its size
+COMPACT_HEADER = struct.Struct('<Iiqii2B')
+
+# framebuffer capture descriptor, see FrameBufferCapture
+FB_DESC_HEADER = struct.Struct('<5I')
+FB_DESC_MAGIC = 0x44544246
+FB_DESC_TILES = 1 << 0
+FB_DESC_LAGGED = 1 << 1
+
+def lzfDecompress(data, size):
+    '''Decompress lzf compressed data, of uncompressed size size.'''
+    data = bytearray(data)
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        ctrl = data[i]
+        i += 1
+        if ctrl < 32:
+            # literal run
+            out += data[i:i + ctrl + 1]
+            i += ctrl + 1
+        else:
+            # back reference
+            length = ctrl >> 5
+            ref = len(out) - ((ctrl & 0x1f) << 8) - 1
+            if length == 7:
+                length += data[i]
+                i += 1
+            ref -= data[i]
+            i += 1
+            for k in range(length + 2):
+                out.append(out[ref + k])
+    if size is not None and len(out) != size:
+        raise ValueError('corrupt compressed chunk')
+    return bytes(out)
+
+def lzfLiterals(data):
+    '''Encode data as an lzf stream of literal runs, which any lzf
+    decompressor accepts.'''
+    out = []
+    for i in range(0, len(data), 32):
+        run = data[i:i + 32]
+        out.append(struct.pack('B', len(run) - 1))
+        out.append(bytes(run))
+    return b''.join(out)
+
+def decompress(stream):
+    '''Return the contents of a trace stream with its compressed chunks
+    expanded.'''
+    out = []
+    pos = 0
+    while pos + 4 <= len(stream):
+        (size,) = struct.unpack_from('<I', stream, pos)
+        if size & COMPRESSED_CHUNK:
+            size &= ~COMPRESSED_CHUNK
+            (rawSize,) = struct.unpack_from('<I', stream, pos + 4)
+            out.append(lzfDecompress(stream[pos + 8:pos + 8 + size], rawSize))
+            pos += 8 + size
+        else:
+            # an uncompressed chunk is a sequence of messages, copy one
+            out.append(stream[pos:pos + 4 + (size & ~COMPACT_RECORD)])
+            pos += 4 + (size & ~COMPACT_RECORD)
+    return b''.join(out)
+
+def compactToGLMessage(record):
+    '''Convert a CompactGLMessage record, without its size, to a GLMessage.'''
+    (function, contextId, startTime, duration, threadTime, count, hasReturn) = \
+            COMPACT_HEADER.unpack_from(record, 0)
+
+    msg = gltrace_pb2.GLMessage()
+    msg.function = function
+    msg.context_id = contextId
+    msg.start_time = startTime
+    msg.duration = duration
+    msg.threadtime = threadTime
+
+    DataType = gltrace_pb2.GLMessage.DataType
+    pos = COMPACT_HEADER.size
+    for i in range(count):
+        valueType = bytearray(record[pos:pos + 1])[0]
+        pos += 1
+        if hasReturn and i == count - 1:
+            value = msg.returnValue
+        else:
+            value = msg.args.add()
+        value.type = valueType
+        value.isArray = False
+        if valueType == DataType.INT64:
+            value.int64Value.append(struct.unpack_from('<q', record, pos)[0])
+            pos += 8
+        elif valueType == DataType.FLOAT:
+            value.floatValue.append(struct.unpack_from('<f', record, pos)[0])
+            pos += 4
+        elif valueType == DataType.BOOL:
+            value.boolValue.append(struct.unpack_from('<i', record, pos)[0] != 0)
+            pos += 4
+        else:
+            value.intValue.append(struct.unpack_from('<i', record, pos)[0])
+            pos += 4
+    return msg
+
+class FrameBufferState(object):
+    '''The last framebuffer image of a context, to apply tiles to.'''
+    def __init__(self):
+        self.image = None
+        self.width = 0
+        self.height = 0
+        # the message whose capture is carried by the next lagged capture
+        self.lastMessage = None
+
+def expandTiles(state, width, height, tileSize, bitmap, data):
+    '''Apply the tiles in data, flagged in bitmap, to the previous image.'''
+    if state.image is None or state.width != width or state.height != height:
+        state.image = bytearray(width * height * 4)
+        state.width = width
+        state.height = height
+    image = state.image
+    stride = width * 4
+    tilesX = (width + tileSize - 1) // tileSize
+    tilesY = (height + tileSize - 1) // tileSize
+    pos = 0
+    for ty in range(tilesY):
+        y0 = ty * tileSize
+        th = min(tileSize, height - y0)
+        for tx in range(tilesX):
+            tile = ty * tilesX + tx
+            if not bitmap[tile // 8] & (1 << (tile % 8)):
+                continue
+            x0 = tx * tileSize
+            tw = min(tileSize, width - x0)
+            for y in range(th):
+                offset = (y0 + y) * stride + x0 * 4
+                image[offset:offset + tw * 4] = data[pos:pos + tw * 4]
+                pos += tw * 4
+    return bytes(image)
+
+def expandFrameBuffer(states, msg):
+    '''Replace a partial or delayed framebuffer capture in msg with the
+    complete image, in the message it was captured for.'''
+    if not msg.HasField('fb') or len(msg.fb.contents) != 2:
+        return
+    state = states.setdefault(msg.context_id, FrameBufferState())
+    desc = msg.fb.contents[1]
+    (magic, flags, scale, tileSize, numTiles) = FB_DESC_HEADER.unpack_from(desc, 0)
+    if magic != FB_DESC_MAGIC:
+        raise ValueError('unknown framebuffer descriptor')
+
+    width = msg.fb.width
+    height = msg.fb.height
+    image = None
+    if width > 0 and height > 0:
+        data = lzfDecompress(msg.fb.contents[0], None)
+        if flags & FB_DESC_TILES:
+            bitmap = bytearray(desc[FB_DESC_HEADER.size:])
+            image = expandTiles(state, width, height, tileSize, bitmap, data)
+        else:
+            image = data
+
+    target = msg
+    if flags & FB_DESC_LAGGED:
+        # this message's own capture comes with the next one, if any
+        target = state.lastMessage
+        state.lastMessage = msg
+        msg.ClearField('fb')
+    if target is None:
+        return
+    if image is None:
+        target.ClearField('fb')
+    else:
+        target.fb.width = width
+        target.fb.height = height
+        del target.fb.contents[:]
+        target.fb.contents.append(lzfLiterals(image))
+
+def convert(stream):
+    '''Return the trace stream with all its messages as GLMessages.'''
+    stream = decompress(stream)
+    messages = []
+    states = {}
+    pos = 0
+    while pos + 4 <= len(stream):
+        (size,) = struct.unpack_from('<I', stream, pos)
+        pos += 4
+        if size & COMPACT_RECORD:
+            size &= ~COMPACT_RECORD
+            msg = compactToGLMessage(stream[pos:pos + size])
+        else:
+            msg = gltrace_pb2.GLMessage()
+            msg.ParseFromString(stream[pos:pos + size])
+            expandFrameBuffer(states, msg)
+        messages.append(msg)
+        pos += size
+
+    out = []
+    for msg in messages:
+        data = msg.SerializeToString()
+        out.append(struct.pack('<I', len(data)))
+        out.append(data)
+    return b''.join(out)
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print 'usage: %s <trace> <converted trace>' % sys.argv[0]
+        sys.exit(1)
+    with open(sys.argv[1], 'rb') as f:
+        stream = f.read()
+    with open(sys.argv[2], 'wb') as f:
+        f.write(convert(stream))
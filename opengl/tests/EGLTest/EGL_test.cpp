@@ -164,5 +164,45 @@ TEST_F(EGLTest, EGLConfigRGBA8888First) {
     EXPECT_GE(components[3], 8);
 }
 
+TEST_F(EGLTest, EGLDestroyedSurfaceHandleIsInvalid) {
+    EGLint numConfigs;
+    EGLConfig config;
+    EGLint attrs[] = {
+            EGL_SURFACE_TYPE,       EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE,    EGL_OPENGL_ES2_BIT,
+            EGL_NONE
+    };
+    EGLint pbufferAttrs[] = {
+            EGL_WIDTH,              16,
+            EGL_HEIGHT,             16,
+            EGL_NONE
+    };
+    ASSERT_TRUE(eglChooseConfig(mEglDisplay, attrs, &config, 1, &numConfigs));
+    ASSERT_GE(numConfigs, 1);
+
+    EGLSurface surface = eglCreatePbufferSurface(mEglDisplay, config,
+            pbufferAttrs);
+    ASSERT_EQ(EGL_SUCCESS, eglGetError());
+    ASSERT_NE(EGL_NO_SURFACE, surface);
+    ASSERT_EQ(EGL_TRUE, eglDestroySurface(mEglDisplay, surface));
+
+    // The new surface may reuse the destroyed one's slot, but not its handle
+    EGLSurface other = eglCreatePbufferSurface(mEglDisplay, config,
+            pbufferAttrs);
+    ASSERT_EQ(EGL_SUCCESS, eglGetError());
+    ASSERT_NE(EGL_NO_SURFACE, other);
+    EXPECT_NE(surface, other);
+
+    EGLint width;
+    EXPECT_EQ(EGL_FALSE, eglQuerySurface(mEglDisplay, surface, EGL_WIDTH,
+            &width));
+    EXPECT_EQ(EGL_BAD_SURFACE, eglGetError());
+    EXPECT_EQ(EGL_TRUE, eglQuerySurface(mEglDisplay, other, EGL_WIDTH,
+            &width));
+    EXPECT_EQ(16, width);
+
+    EXPECT_EQ(EGL_TRUE, eglDestroySurface(mEglDisplay, other));
+}
+
 
 }
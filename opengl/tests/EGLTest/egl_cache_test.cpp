@@ -19,6 +19,11 @@
 
 #include <gtest/gtest.h>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <utils/Log.h>
 
 #include "egl_cache.h"
@@ -34,6 +39,7 @@ protected:
 
     virtual void TearDown() {
         mCache->setCacheFilename("");
+        mCache->setSharedCacheFilename("");
         mCache->terminate();
     }
 
@@ -86,10 +92,36 @@ protected:
     }
 
     virtual void TearDown() {
-        unlink(mFilename.string());
+        removeCacheFiles(mFilename);
         EGLCacheTest::TearDown();
     }
 
+    static void removeCacheFiles(const String8& filename) {
+        unlink(filename.string());
+        for (size_t i = 0; i < egl_cache_t::NUM_SHARDS; i++) {
+            unlink(String8::format("%s.%zu", filename.string(), i).string());
+        }
+    }
+
+    // readCacheFiles returns the contents of all the shard files of a cache.
+    static String8 readCacheFiles(const String8& filename) {
+        String8 contents;
+        for (size_t i = 0; i < egl_cache_t::NUM_SHARDS; i++) {
+            String8 name = String8::format("%s.%zu", filename.string(), i);
+            int fd = open(name.string(), O_RDONLY);
+            if (fd == -1) {
+                continue;
+            }
+            char buf[4096];
+            ssize_t n;
+            while ((n = read(fd, buf, sizeof(buf))) > 0) {
+                contents.append(buf, n);
+            }
+            close(fd);
+        }
+        return contents;
+    }
+
     String8 mFilename;
 };
 
@@ -107,4 +139,114 @@ TEST_F(EGLCacheSerializationTest, ReinitializedCacheContainsValues) {
     ASSERT_EQ('h', buf[3]);
 }
 
+TEST_F(EGLCacheSerializationTest, SharedCacheContainsValues) {
+    char buf[4] = { 0xee, 0xee, 0xee, 0xee };
+    mCache->setCacheFilename(mFilename);
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("abcd", 4, "efgh", 4);
+    mCache->terminate();
+    mCache->setCacheFilename("");
+    mCache->setSharedCacheFilename(mFilename);
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    ASSERT_EQ(4, mCache->getBlob("abcd", 4, buf, 4));
+    ASSERT_EQ('e', buf[0]);
+    ASSERT_EQ('f', buf[1]);
+    ASSERT_EQ('g', buf[2]);
+    ASSERT_EQ('h', buf[3]);
+}
+
+TEST_F(EGLCacheSerializationTest, SharedCacheIsNotWritten) {
+    char buf[4] = { 0xee, 0xee, 0xee, 0xee };
+    mCache->setCacheFilename(mFilename);
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("abcd", 4, "efgh", 4);
+    mCache->terminate();
+    const String8 sharedContents(readCacheFiles(mFilename));
+    ASSERT_LT(size_t(0), sharedContents.length());
+
+    // Use the cache as the shared one, with a cache of our own next to it.
+    const String8 ownFilename(mFilename + "-own");
+    mCache->setCacheFilename(ownFilename);
+    mCache->setSharedCacheFilename(mFilename);
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("abcd", 4, "ijkl", 4);
+    mCache->setBlob("mnop", 4, "qrst", 4);
+    ASSERT_EQ(4, mCache->getBlob("mnop", 4, buf, 4));
+    mCache->terminate();
+
+    String8 ownContents(readCacheFiles(ownFilename));
+    removeCacheFiles(ownFilename);
+    ASSERT_LT(size_t(0), ownContents.length());
+    ASSERT_EQ(sharedContents, readCacheFiles(mFilename));
+}
+
+TEST_F(EGLCacheSerializationTest, ConcurrentWritersKeepEachOthersValues) {
+    const int count = 64;
+    char value[1024];
+    mCache->setCacheFilename(mFilename);
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    const char* prefix = pid == 0 ? "child" : "parent";
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    for (int i = 0; i < count; i++) {
+        String8 key = String8::format("%s-%d", prefix, i);
+        memset(value, i, sizeof(value));
+        mCache->setBlob(key.string(), key.length(), value, sizeof(value));
+    }
+    mCache->terminate();
+    if (pid == 0) {
+        _exit(0);
+    }
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+
+    char buf[sizeof(value)];
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    for (int i = 0; i < count; i++) {
+        memset(value, i, sizeof(value));
+        String8 key = String8::format("child-%d", i);
+        ASSERT_EQ(EGLsizeiANDROID(sizeof(value)),
+                mCache->getBlob(key.string(), key.length(), buf, sizeof(buf)));
+        ASSERT_EQ(0, memcmp(value, buf, sizeof(value)));
+        key = String8::format("parent-%d", i);
+        ASSERT_EQ(EGLsizeiANDROID(sizeof(value)),
+                mCache->getBlob(key.string(), key.length(), buf, sizeof(buf)));
+        ASSERT_EQ(0, memcmp(value, buf, sizeof(value)));
+    }
+}
+
+TEST_F(EGLCacheSerializationTest, ReinitializedCacheContainsLargeValues) {
+    const size_t size = 100 * 1024;
+    char* value = new char[size];
+    char* buf = new char[size];
+    memset(value, 0xab, size);
+    memset(buf, 0xee, size);
+    mCache->setCacheFilename(mFilename);
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("abcd", 4, value, size);
+    mCache->terminate();
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    ASSERT_EQ(EGLsizeiANDROID(size), mCache->getBlob("abcd", 4, buf, size));
+    ASSERT_EQ(0, memcmp(value, buf, size));
+    delete [] value;
+    delete [] buf;
+}
+
+TEST_F(EGLCacheSerializationTest, ReinitializedCacheContainsReplacedValues) {
+    char buf[4] = { 0xee, 0xee, 0xee, 0xee };
+    mCache->setCacheFilename(mFilename);
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("abcd", 4, "efgh", 4);
+    mCache->setBlob("abcd", 4, "ijkl", 4);
+    mCache->terminate();
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    ASSERT_EQ(4, mCache->getBlob("abcd", 4, buf, 4));
+    ASSERT_EQ('i', buf[0]);
+    ASSERT_EQ('j', buf[1]);
+    ASSERT_EQ('k', buf[2]);
+    ASSERT_EQ('l', buf[3]);
+}
+
 }
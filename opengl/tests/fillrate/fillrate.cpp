@@ -19,19 +19,48 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <getopt.h>
 
 #include <EGL/egl.h>
 #include <GLES/gl.h>
 #include <GLES/glext.h>
 
 #include <utils/StopWatch.h>
+#include <BenchmarkReport.h>
 #include <WindowSurface.h>
 #include <EGLUtils.h>
 
 using namespace android;
 
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-o text|json|csv] [-t seconds]\n", name);
+    fprintf(stderr, "  -o  format of the results, defaults to text\n");
+    fprintf(stderr, "  -t  minimum duration of each layer count\n");
+}
+
 int main(int argc, char** argv)
 {
+    BenchmarkReport::Format format = BenchmarkReport::FORMAT_TEXT;
+    nsecs_t minDuration = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:t:")) != -1) {
+        switch (opt) {
+        case 'o':
+            if (!BenchmarkReport::parseFormat(optarg, &format)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 't':
+            minDuration = nsecs_t(atof(optarg) * 1000000000.0);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
     EGLint configAttribs[] = {
          EGL_DEPTH_SIZE, 0,
          EGL_NONE
@@ -64,7 +93,13 @@ int main(int argc, char** argv)
      eglQuerySurface(dpy, surface, EGL_WIDTH, &w);
      eglQuerySurface(dpy, surface, EGL_HEIGHT, &h);
      
-     printf("w=%d, h=%d\n", w, h);
+     BenchmarkReport report("fillrate", format);
+     report.collectDeviceInfo(dpy);
+     GpuTimer gpuTimer(dpy);
+
+     if (!report.isMachineReadable()) {
+         printf("w=%d, h=%d\n", w, h);
+     }
      
      glBindTexture(GL_TEXTURE_2D, 0);
      glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -126,6 +161,7 @@ int main(int argc, char** argv)
      
 
      nsecs_t times[32];
+     nsecs_t gpuTimes[32];
 
      for (int c=1 ; c<32 ; c++) {
          glClear(GL_COLOR_BUFFER_BIT);
@@ -139,23 +175,48 @@ int main(int argc, char** argv)
      //     for (int c=31 ; c>=1 ; c--) {
      int j=0;
      for (int c=1 ; c<32 ; c++) {
-         glClear(GL_COLOR_BUFFER_BIT);
-         nsecs_t now = systemTime();
-         for (int i=0 ; i<c ; i++) {
-             glDrawArrays(GL_TRIANGLE_FAN, 0, 4); 
-         }
-         eglSwapBuffers(dpy, surface);
-         nsecs_t t = systemTime() - now;
-         times[j++] = t;
+         nsecs_t start = systemTime();
+         nsecs_t total = 0;
+         nsecs_t gpuTotal = 0;
+         int frames = 0;
+         do {
+             gpuTimer.begin();
+             glClear(GL_COLOR_BUFFER_BIT);
+             nsecs_t now = systemTime();
+             for (int i=0 ; i<c ; i++) {
+                 glDrawArrays(GL_TRIANGLE_FAN, 0, 4); 
+             }
+             eglSwapBuffers(dpy, surface);
+             total += systemTime() - now;
+             nsecs_t gpuTime = gpuTimer.end();
+             if (gpuTime > 0) {
+                 gpuTotal += gpuTime;
+             }
+             frames++;
+         } while (systemTime() - start < minDuration);
+         times[j] = total / frames;
+         gpuTimes[j] = gpuTotal / frames;
+         j++;
      }
 
      for (int c=1, j=0 ; c<32 ; c++, j++) {
          nsecs_t t = times[j];
-         printf("%lld\t%d\t%f\n", t, c, (double(t)/c)/1000000.0);
+         if (!report.isMachineReadable()) {
+             printf("%lld\t%d\t%f\n", t, c, (double(t)/c)/1000000.0);
+         } else {
+             char params[64];
+             snprintf(params, sizeof(params), "%dx%d layers=%d", w, h, c);
+             report.addResult("fullscreen blended quads", params,
+                     "frame_time", double(t)/1000000.0, "ms");
+             report.addResult("fullscreen blended quads", params,
+                     "gpu_frame_time", double(gpuTimes[j])/1000000.0, "ms");
+             report.addResult("fullscreen blended quads", params,
+                     "fill_rate", double(w)*h*c/(double(t)/1000.0), "Mpix/s");
+         }
      }
 
+     report.write(stdout);
 
-       
      eglTerminate(dpy);
      
      return 0;
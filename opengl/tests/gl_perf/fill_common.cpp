@@ -19,7 +19,20 @@
 FILE * fOut = NULL;
 void ptSwap();
 
+// Waits for the GPU to complete the frame that was just swapped, timed
+// tells whether the frame is part of a measurement.
+void ptFinish(bool timed);
+
+// Called with the result of each test, when it isn't written to fOut.
+void ptReport(const char* testName, const char* scenario, const char* params,
+        double mpps, double dc60);
+
+// Each test is repeated for at least this long, when not 0.
+static uint64_t gMinDuration = 0;
+
 static char gCurrentTestName[1024];
+static char gCurrentTestScenario[256];
+static char gCurrentTestParams[256];
 static uint32_t gWidth = 0;
 static uint32_t gHeight = 0;
 
@@ -130,7 +143,8 @@ static void endTimer(int count) {
         fprintf(fOut, "%s, %f, %f\r\n", gCurrentTestName, mpps, dc60);
         fflush(fOut);
     } else {
-        printf("%s, %f, %f\n", gCurrentTestName, mpps, dc60);
+        ptReport(gCurrentTestName, gCurrentTestScenario, gCurrentTestParams,
+                mpps, dc60);
     }
     ALOGI("%s, %f, %f\r\n", gCurrentTestName, mpps, dc60);
 }
@@ -204,26 +218,30 @@ static void doLoop(bool warmup, int pgm, uint32_t passCount) {
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
         glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
         ptSwap();
-        glFinish();
+        ptFinish(false);
         return;
     }
 
+    uint32_t count = 0;
     startTimer();
-    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-    for (uint32_t ct=0; ct < passCount; ct++) {
-        GLint loc = glGetUniformLocation(pgm, "u_texOff");
-        glUniform2f(loc, ((float)ct) / passCount, ((float)ct) / 2.f / passCount);
-
-        randUniform(pgm, "u_color");
-        randUniform(pgm, "u_0");
-        randUniform(pgm, "u_1");
-        randUniform(pgm, "u_2");
-        randUniform(pgm, "u_3");
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    }
-    ptSwap();
-    glFinish();
-    endTimer(passCount);
+    do {
+        glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+        for (uint32_t ct=0; ct < passCount; ct++) {
+            GLint loc = glGetUniformLocation(pgm, "u_texOff");
+            glUniform2f(loc, ((float)ct) / passCount, ((float)ct) / 2.f / passCount);
+
+            randUniform(pgm, "u_color");
+            randUniform(pgm, "u_0");
+            randUniform(pgm, "u_1");
+            randUniform(pgm, "u_2");
+            randUniform(pgm, "u_3");
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        ptSwap();
+        ptFinish(true);
+        count += passCount;
+    } while (getTime() - gTime < gMinDuration);
+    endTimer(count);
 }
 
 
@@ -292,6 +310,10 @@ static void doSingleTest(uint32_t pgmNum, int tex) {
 
     glEnable(GL_BLEND);
     sprintf(gCurrentTestName, "%s, %i, %i, 1", gFragmentTests[pgmNum]->name, pgmNum, tex);
+    snprintf(gCurrentTestScenario, sizeof(gCurrentTestScenario), "%s",
+            gFragmentTests[pgmNum]->name);
+    snprintf(gCurrentTestParams, sizeof(gCurrentTestParams),
+            "program=%i texture=%i blend=1", pgmNum, tex);
     doLoop(true, pgm, 100);
     doLoop(false, pgm, 100);
 }
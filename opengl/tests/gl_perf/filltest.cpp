@@ -34,14 +34,64 @@ using namespace android;
 #include "fill_common.cpp"
 
 
-bool doTest(uint32_t w, uint32_t h) {
+// Uploads a size x size RGBA texture with glTexSubImage2D and draws a quad
+// with it, Mpps counts the uploaded pixels.
+static void doUploadTest(uint32_t size) {
+    const char *pgmTxt = fpCopyTex.txt;
+    int pgm = createProgram(gVertexShader, pgmTxt);
+    if (!pgm) {
+        printf("error running test\n");
+        return;
+    }
+    GLint loc = glGetUniformLocation(pgm, "u_tex0");
+    if (loc >= 0) glUniform1i(loc, 0);
+
+    uint32_t *m = (uint32_t *)malloc(size*size*4);
+    for (uint32_t i = 0; i < size*size; i++) {
+        m[i] = rgb(i, i >> 8, i >> 16);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 3);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, m);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glDisable(GL_BLEND);
+
+    sprintf(gCurrentTestName, "texture upload, %u", size);
+    snprintf(gCurrentTestScenario, sizeof(gCurrentTestScenario), "texture upload");
+    snprintf(gCurrentTestParams, sizeof(gCurrentTestParams), "size=%ux%u", size, size);
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, m);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    ptSwap();
+    ptFinish(false);
+
+    uint32_t count = 0;
+    startTimer();
+    do {
+        // change the data so that it can't be skipped
+        m[0] = count;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, m);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        ptSwap();
+        ptFinish(true);
+        count++;
+    } while (getTime() - gTime < gMinDuration);
+
+    double delta = ((double)(getTime() - gTime)) / 1000000000;
+    double mpps = ((double)size * size * count) / delta / 1000000;
+    double dc60 = ((double)count) / delta / 60;
+    ptReport(gCurrentTestName, gCurrentTestScenario, gCurrentTestParams, mpps, dc60);
+    free(m);
+}
+
+bool doTest(uint32_t w, uint32_t h, uint32_t minDurationMs) {
     gWidth = w;
     gHeight = h;
+    gMinDuration = (uint64_t)minDurationMs * 1000 * 1000;
     setupVA();
     genTextures();
 
-    printf("\nvarColor, texCount, modulate, extraMath, texSize, blend, Mpps, DC60\n");
-
     for (uint32_t num = 0; num < gFragmentTestCount; num++) {
         doSingleTest(num, 2);
         if (gFragmentTests[num]->texCount) {
@@ -49,6 +99,8 @@ bool doTest(uint32_t w, uint32_t h) {
         }
     }
 
-    exit(0);
+    doUploadTest(256);
+    doUploadTest(1024);
+
     return true;
 }
@@ -16,6 +16,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <getopt.h>
 #include <time.h>
 #include <sched.h>
 #include <sys/resource.h>
@@ -26,6 +27,7 @@
 
 #include <utils/Timers.h>
 
+#include <BenchmarkReport.h>
 #include <WindowSurface.h>
 #include <EGLUtils.h>
 
@@ -51,12 +53,43 @@ static void checkGlError(const char* op) {
     }
 }
 
-bool doTest(uint32_t w, uint32_t h);
+bool doTest(uint32_t w, uint32_t h, uint32_t minDurationMs);
 
 static EGLDisplay dpy;
 static EGLSurface surface;
 
+static BenchmarkReport* gReport;
+static GpuTimer* gGpuTimer;
+static nsecs_t gGpuTime;
+static uint32_t gGpuFrames;
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-o text|json|csv] [-t seconds]\n", name);
+    fprintf(stderr, "  -o  format of the results, defaults to text\n");
+    fprintf(stderr, "  -t  minimum duration of each test\n");
+}
+
 int main(int argc, char** argv) {
+    BenchmarkReport::Format format = BenchmarkReport::FORMAT_TEXT;
+    uint32_t minDurationMs = 0;
+    int c;
+    while ((c = getopt(argc, argv, "o:t:")) != -1) {
+        switch (c) {
+        case 'o':
+            if (!BenchmarkReport::parseFormat(optarg, &format)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 't':
+            minDurationMs = uint32_t(atof(optarg) * 1000);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
     EGLBoolean returnValue;
     EGLConfig myConfig = {0};
 
@@ -122,11 +155,18 @@ int main(int argc, char** argv) {
 
     glViewport(0, 0, w, h);
 
-    for (;;) {
-        doTest(w, h);
-        eglSwapBuffers(dpy, surface);
-        checkEglError("eglSwapBuffers");
+    BenchmarkReport report("gl2_perf", format);
+    report.collectDeviceInfo(dpy);
+    GpuTimer gpuTimer(dpy);
+    gReport = &report;
+    gGpuTimer = &gpuTimer;
+
+    if (!report.isMachineReadable()) {
+        printf("\nvarColor, texCount, modulate, extraMath, texSize, blend, Mpps, DC60\n");
     }
+    gpuTimer.begin();
+    doTest(w, h, minDurationMs);
+    report.write(stdout);
 
     return 0;
 }
@@ -135,3 +175,29 @@ void ptSwap() {
     eglSwapBuffers(dpy, surface);
 }
 
+void ptFinish(bool timed) {
+    nsecs_t t = gGpuTimer->end();
+    if (timed && t >= 0) {
+        gGpuTime += t;
+        gGpuFrames++;
+    }
+    gGpuTimer->begin();
+}
+
+void ptReport(const char* testName, const char* scenario, const char* params,
+        double mpps, double dc60) {
+    if (!gReport->isMachineReadable()) {
+        printf("%s, %f, %f\n", testName, mpps, dc60);
+    } else {
+        gReport->addResult(scenario, params, "fill_rate", mpps, "Mpix/s");
+        gReport->addResult(scenario, params, "draws_per_60hz_frame", dc60,
+                "draws");
+        if (gGpuFrames) {
+            gReport->addResult(scenario, params, "gpu_frame_time",
+                    double(gGpuTime) / gGpuFrames / 1000000, "ms");
+        }
+    }
+    gGpuTime = 0;
+    gGpuFrames = 0;
+}
+
@@ -38,6 +38,15 @@ int pgm;
 void ptSwap() {
 }
 
+void ptFinish(bool timed) {
+    glFinish();
+}
+
+void ptReport(const char* testName, const char* scenario, const char* params,
+        double mpps, double dc60) {
+    printf("%s, %f, %f\n", testName, mpps, dc60);
+}
+
 void doTest() {
     uint32_t testNum = stateClock >> 2;
     int texSize = ((stateClock >> 1) & 0x1) + 1;
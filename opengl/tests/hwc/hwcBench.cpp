@@ -0,0 +1,607 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Hardware Composer Benchmark
+ *
+ * Synopsis
+ *   hwcBench [options]
+ *     options:
+ *       -l list   Layer counts, default 1,2,4,8
+ *       -f list   Graphic formats, default all the known formats
+ *       -S list   Scale factors from source crop to display frame,
+ *                 default 1.0,0.5,2.0
+ *       -b list   Blending, from none, premult and coverage, default all
+ *       -n num    Frames measured per configuration, default 120
+ *       -w num    Frames composed before measuring, default 10
+ *       -o file   Write the results to file instead of stdout
+ *       -v        Verbose
+ *
+ * Description
+ *   Sweeps every combination of the layer counts, graphic formats,
+ *   scale factors and blending operations given, and for each one composes
+ *   a number of frames the way SurfaceFlinger does: a prepare call then a
+ *   set call per frame, with the geometry changed flag set on the first
+ *   frame only, and the buffers of each layer flipped between frames.
+ *   This lets the HWC implementations of several devices be compared
+ *   quantitatively, unlike hwcStress and hwcCommit, which validate them.
+ *
+ *   Each layer is half the size of the display, cascaded from the top left
+ *   corner, and its buffer is the display frame times the scale factor,
+ *   so a scale of 0.5 is a 2x magnification.  Layers are filled with a
+ *   solid color, opaque unless blended.
+ *
+ *   The results are written as comma separated values, one line per
+ *   configuration after a header line:
+ *     layers, format, scale, blending, frames
+ *     prepare_mean_us, prepare_p50_us, prepare_p95_us, prepare_max_us
+ *     set_mean_us, set_p50_us, set_p95_us, set_max_us
+ *     overlay_pct      layers the HWC accepted as overlays, in percent
+ *     fence_mean_us, fence_p95_us
+ *                      time from the start of a set call to the signal
+ *                      of its retire fence
+ *     fences           number of frames which had a retire fence
+ *   Latencies are empty if no frame had a retire fence.
+ */
+
+// This is needed for stdint.h to define INT64_MAX in C++
+#define __STDC_LIMIT_MACROS
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <libgen.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+
+#define LOG_TAG "hwcBench"
+#include <utils/Log.h>
+#include <utils/Timers.h>
+#include <testUtil.h>
+
+#include <hardware/hwcomposer.h>
+
+#include <glTestLib.h>
+#include "hwcTestLib.h"
+
+using namespace std;
+using namespace android;
+
+// Defaults for command-line options
+const bool defaultVerbose = false;
+const char *defaultLayerCounts = "1,2,4,8";
+const char *defaultScales = "1.0,0.5,2.0";
+const char *defaultBlendings = "none,premult,coverage";
+const unsigned int defaultNumFrames = 120;
+const unsigned int defaultWarmupFrames = 10;
+
+const float blendedAlpha = 0.5;          // Alpha of the blended layers
+const unsigned int fenceTimeoutMs = 1000; // Give up on a retire fence
+                                          // after this long
+const size_t buffersPerLayer = 2;         // Flipped between frames
+
+// Command-line option settings
+static bool verbose = defaultVerbose;
+static unsigned int numFrames = defaultNumFrames;
+static unsigned int warmupFrames = defaultWarmupFrames;
+
+#define MAXCMD               200
+#define CMD_STOP_FRAMEWORK   "stop 2>&1"
+#define CMD_START_FRAMEWORK  "start 2>&1"
+
+#define NUMA(a) (sizeof(a) / sizeof(a [0]))
+
+const struct blendingOp {
+    uint32_t op;
+    const char *desc;
+} blendingOps[] = {
+    {HWC_BLENDING_NONE,     "none"},
+    {HWC_BLENDING_PREMULT,  "premult"},
+    {HWC_BLENDING_COVERAGE, "coverage"},
+};
+
+// File scope globals
+static const int texUsage = GraphicBuffer::USAGE_HW_TEXTURE |
+        GraphicBuffer::USAGE_SW_WRITE_RARELY;
+static hwc_composer_device_1_t *hwcDevice;
+static EGLDisplay dpy;
+static EGLSurface surface;
+static EGLint width, height;
+
+// Measurements of one configuration
+struct BenchResult {
+    vector<nsecs_t> prepareTimes;
+    vector<nsecs_t> setTimes;
+    vector<nsecs_t> fenceTimes;
+    size_t layersOffered;
+    size_t layersAccepted;
+
+    BenchResult() : layersOffered(0), layersAccepted(0) {}
+};
+
+// File scope prototypes
+static void init(void);
+static vector<string> splitList(const char *list);
+static void usage(const char *cmd);
+static void runConfig(size_t numLayers, const struct hwcTestGraphicFormat *format,
+    float scale, const struct blendingOp *blending, BenchResult *result);
+static void composeFrame(hwc_display_contents_1_t *list, bool measure,
+    BenchResult *result);
+static void printResult(FILE *out, size_t numLayers,
+    const struct hwcTestGraphicFormat *format, float scale,
+    const struct blendingOp *blending, BenchResult *result);
+
+/*
+ * Main
+ *
+ * Parses the lists of the command-line, stops the framework, then
+ * measures each configuration in turn and writes its results as soon as
+ * it is done, so that a run cut short still has the configurations
+ * measured so far.
+ */
+int
+main(int argc, char *argv[])
+{
+    int rv, opt;
+    char *chptr;
+    char cmd[MAXCMD];
+    const char *layerCountsOpt = defaultLayerCounts;
+    const char *formatsOpt = NULL;
+    const char *scalesOpt = defaultScales;
+    const char *blendingsOpt = defaultBlendings;
+    const char *outputOpt = NULL;
+
+    testSetLogCatTag(LOG_TAG);
+
+    // Parse command line arguments
+    while ((opt = getopt(argc, argv, "l:f:S:b:n:w:o:v?h")) != -1) {
+        switch (opt) {
+          case 'l': // Layer counts
+            layerCountsOpt = optarg;
+            break;
+
+          case 'f': // Graphic formats
+            formatsOpt = optarg;
+            break;
+
+          case 'S': // Scale factors
+            scalesOpt = optarg;
+            break;
+
+          case 'b': // Blending operations
+            blendingsOpt = optarg;
+            break;
+
+          case 'n': // Frames per configuration
+            numFrames = strtoul(optarg, &chptr, 10);
+            if ((*chptr != '\0') || (numFrames == 0)) {
+                testPrintE("Invalid command-line specified number of "
+                           "frames of: %s", optarg);
+                exit(1);
+            }
+            break;
+
+          case 'w': // Warm up frames
+            warmupFrames = strtoul(optarg, &chptr, 10);
+            if (*chptr != '\0') {
+                testPrintE("Invalid command-line specified number of "
+                           "warm up frames of: %s", optarg);
+                exit(2);
+            }
+            break;
+
+          case 'o': // Output file
+            outputOpt = optarg;
+            break;
+
+          case 'v': // Verbose
+            verbose = true;
+            break;
+
+          case 'h': // Help
+          case '?':
+          default:
+            usage(argv[0]);
+            exit(((optopt == 0) || (optopt == '?')) ? 0 : 3);
+        }
+    }
+    if (argc != optind) {
+        testPrintE("Unexpected command-line postional argument");
+        usage(argv[0]);
+        exit(4);
+    }
+
+    // Resolve the lists
+    vector<size_t> layerCounts;
+    vector<string> items = splitList(layerCountsOpt);
+    for (size_t n1 = 0; n1 < items.size(); n1++) {
+        unsigned long count = strtoul(items[n1].c_str(), &chptr, 10);
+        if ((*chptr != '\0') || (count == 0)) {
+            testPrintE("Invalid layer count of: %s", items[n1].c_str());
+            exit(5);
+        }
+        layerCounts.push_back(count);
+    }
+
+    vector<const struct hwcTestGraphicFormat *> formats;
+    if (formatsOpt == NULL) {
+        for (size_t n1 = 0; n1 < NUMA(hwcTestGraphicFormat); n1++) {
+            formats.push_back(&hwcTestGraphicFormat[n1]);
+        }
+    } else {
+        items = splitList(formatsOpt);
+        for (size_t n1 = 0; n1 < items.size(); n1++) {
+            const struct hwcTestGraphicFormat *format
+                = hwcTestGraphicFormatLookup(items[n1].c_str());
+            if (format == NULL) {
+                testPrintE("Unknown graphic format of: %s", items[n1].c_str());
+                exit(6);
+            }
+            formats.push_back(format);
+        }
+    }
+
+    vector<float> scales;
+    items = splitList(scalesOpt);
+    for (size_t n1 = 0; n1 < items.size(); n1++) {
+        float scale = strtod(items[n1].c_str(), &chptr);
+        if ((*chptr != '\0') || (scale <= 0.0)) {
+            testPrintE("Invalid scale factor of: %s", items[n1].c_str());
+            exit(7);
+        }
+        scales.push_back(scale);
+    }
+
+    vector<const struct blendingOp *> blendings;
+    items = splitList(blendingsOpt);
+    for (size_t n1 = 0; n1 < items.size(); n1++) {
+        const struct blendingOp *blending = NULL;
+        for (size_t n2 = 0; n2 < NUMA(blendingOps); n2++) {
+            if (items[n1] == blendingOps[n2].desc) {
+                blending = &blendingOps[n2];
+            }
+        }
+        if (blending == NULL) {
+            testPrintE("Unknown blending of: %s", items[n1].c_str());
+            exit(8);
+        }
+        blendings.push_back(blending);
+    }
+
+    FILE *out = stdout;
+    if (outputOpt != NULL) {
+        if ((out = fopen(outputOpt, "w")) == NULL) {
+            testPrintE("Unable to open %s: %s", outputOpt, strerror(errno));
+            exit(9);
+        }
+    }
+
+    // Stop framework
+    rv = snprintf(cmd, sizeof(cmd), "%s", CMD_STOP_FRAMEWORK);
+    if (rv >= (signed) sizeof(cmd) - 1) {
+        testPrintE("Command too long for: %s", CMD_STOP_FRAMEWORK);
+        exit(10);
+    }
+    testExecCmd(cmd);
+    testDelay(1.0);
+
+    init();
+
+    fprintf(out, "layers,format,scale,blending,frames,"
+        "prepare_mean_us,prepare_p50_us,prepare_p95_us,prepare_max_us,"
+        "set_mean_us,set_p50_us,set_p95_us,set_max_us,"
+        "overlay_pct,fence_mean_us,fence_p95_us,fences\n");
+    fflush(out);
+
+    unsigned int numConfigs = 0;
+    for (size_t l = 0; l < layerCounts.size(); l++) {
+        for (size_t f = 0; f < formats.size(); f++) {
+            for (size_t s = 0; s < scales.size(); s++) {
+                for (size_t b = 0; b < blendings.size(); b++) {
+                    BenchResult result;
+                    runConfig(layerCounts[l], formats[f], scales[s],
+                        blendings[b], &result);
+                    printResult(out, layerCounts[l], formats[f], scales[s],
+                        blendings[b], &result);
+                    numConfigs++;
+                }
+            }
+        }
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    // Start framework
+    rv = snprintf(cmd, sizeof(cmd), "%s", CMD_START_FRAMEWORK);
+    if (rv >= (signed) sizeof(cmd) - 1) {
+        testPrintE("Command too long for: %s", CMD_START_FRAMEWORK);
+        exit(11);
+    }
+    testExecCmd(cmd);
+
+    testPrintI("Successfully measured %u configurations", numConfigs);
+
+    return 0;
+}
+
+static void init(void)
+{
+    hwcTestInitDisplay(verbose, &dpy, &surface, &width, &height);
+
+    hwcTestOpenHwc(&hwcDevice);
+}
+
+static void usage(const char *cmd)
+{
+    testPrintE("  %s [options]", basename(cmd));
+    testPrintE("    options:");
+    testPrintE("      -l Layer counts, e.g. 1,2,4,8");
+    testPrintE("      -f Graphic formats, e.g. RGBA8888,YV12");
+    testPrintE("      -S Scale factors, e.g. 1.0,0.5,2.0");
+    testPrintE("      -b Blending, from none,premult,coverage");
+    testPrintE("      -n Frames measured per configuration");
+    testPrintE("      -w Frames composed before measuring");
+    testPrintE("      -o Output file");
+    testPrintE("      -v Verbose");
+}
+
+// Split a comma separated list, skipping empty items
+static vector<string> splitList(const char *list)
+{
+    vector<string> items;
+    string item;
+
+    for (const char *p = list; ; p++) {
+        if ((*p == ',') || (*p == '\0')) {
+            if (!item.empty()) { items.push_back(item); }
+            item.clear();
+            if (*p == '\0') { break; }
+        } else {
+            item += *p;
+        }
+    }
+
+    return items;
+}
+
+// Round up size to a multiple of mod, and to at least mod
+static uint32_t roundUp(uint32_t size, uint32_t mod)
+{
+    size = max(size, mod);
+    if ((size % mod) != 0) {
+        size += mod - (size % mod);
+    }
+
+    return size;
+}
+
+/*
+ * Run Configuration
+ *
+ * Creates the buffers of numLayers layers, composes warmupFrames frames
+ * then numFrames measured ones, flipping the buffers of every layer
+ * between frames.
+ */
+static void runConfig(size_t numLayers, const struct hwcTestGraphicFormat *format,
+    float scale, const struct blendingOp *blending, BenchResult *result)
+{
+    int rv;
+    const bool blended = blending->op != HWC_BLENDING_NONE;
+
+    if (verbose) {
+        testPrintI("==== layers: %zu format: %s scale: %g blending: %s",
+                   numLayers, format->desc, scale, blending->desc);
+    }
+
+    hwc_display_contents_1_t *list = hwcTestCreateLayerList(numLayers);
+    if (list == NULL) {
+        testPrintE("hwcTestCreateLayerList failed");
+        exit(20);
+    }
+
+    // Layers are half the display, cascaded so that each one is visible
+    const uint32_t frameWidth = max(width / 2, 1);
+    const uint32_t frameHeight = max(height / 2, 1);
+    const uint32_t stepX = (width - frameWidth) / max(numLayers, size_t(1));
+    const uint32_t stepY = (height - frameHeight) / max(numLayers, size_t(1));
+    const uint32_t bufWidth = roundUp(uint32_t(frameWidth * scale), format->wMod);
+    const uint32_t bufHeight = roundUp(uint32_t(frameHeight * scale), format->hMod);
+
+    vector<vector<sp<GraphicBuffer> > > buffers(numLayers);
+    for (size_t n1 = 0; n1 < numLayers; n1++) {
+        for (size_t n2 = 0; n2 < buffersPerLayer; n2++) {
+            sp<GraphicBuffer> gBuf = new GraphicBuffer(bufWidth, bufHeight,
+                format->format, texUsage);
+            if ((rv = gBuf->initCheck()) != NO_ERROR) {
+                testPrintE("GraphicBuffer initCheck failed, rv: %i", rv);
+                testPrintE("  width: %u height: %u format: %u %s",
+                           bufWidth, bufHeight, format->format, format->desc);
+                exit(21);
+            }
+            ColorFract color(float(n1 + 1) / numLayers, float(n2) / buffersPerLayer,
+                0.5);
+            hwcTestFillColor(gBuf.get(), color, blended ? blendedAlpha : 1.0);
+            buffers[n1].push_back(gBuf);
+        }
+
+        hwc_layer_1_t *layer = &list->hwLayers[n1];
+        layer->handle = buffers[n1][0]->handle;
+        layer->blending = blending->op;
+        layer->flags = 0;
+        layer->transform = 0;
+        layer->sourceCrop.left = 0;
+        layer->sourceCrop.top = 0;
+        layer->sourceCrop.right = bufWidth;
+        layer->sourceCrop.bottom = bufHeight;
+        layer->displayFrame.left = n1 * stepX;
+        layer->displayFrame.top = n1 * stepY;
+        layer->displayFrame.right = layer->displayFrame.left + frameWidth;
+        layer->displayFrame.bottom = layer->displayFrame.top + frameHeight;
+        layer->visibleRegionScreen.numRects = 1;
+        layer->visibleRegionScreen.rects = &layer->displayFrame;
+        layer->acquireFenceFd = -1;
+        layer->releaseFenceFd = -1;
+    }
+    list->retireFenceFd = -1;
+
+    for (unsigned int frame = 0; frame < warmupFrames + numFrames; frame++) {
+        for (size_t n1 = 0; n1 < numLayers; n1++) {
+            list->hwLayers[n1].handle
+                = buffers[n1][frame % buffersPerLayer]->handle;
+        }
+        composeFrame(list, frame >= warmupFrames, result);
+    }
+
+    hwcTestFreeLayerList(list);
+}
+
+/*
+ * Compose Frame
+ *
+ * Performs a prepare then a set call on list, and when measure is set,
+ * records their latency, how many layers the HWC took as overlays,
+ * and when the retire fence of the frame signaled.
+ */
+static void composeFrame(hwc_display_contents_1_t *list, bool measure,
+    BenchResult *result)
+{
+    // Every layer is offered to the HWC again on each frame
+    for (size_t n1 = 0; n1 < list->numHwLayers; n1++) {
+        list->hwLayers[n1].compositionType = HWC_FRAMEBUFFER;
+        list->hwLayers[n1].hints = 0;
+    }
+
+    if (verbose && measure && result->prepareTimes.empty()) {
+        testPrintI("Prepare:");
+        hwcTestDisplayList(list);
+    }
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    hwcDevice->prepare(hwcDevice, 1, &list);
+    nsecs_t prepared = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (verbose && measure && result->prepareTimes.empty()) {
+        testPrintI("Post Prepare:");
+        hwcTestDisplayListPrepareModifiable(list);
+    }
+
+    // Only the first frame changes geometry
+    list->flags &= ~HWC_GEOMETRY_CHANGED;
+
+    list->dpy = dpy;
+    list->sur = surface;
+    nsecs_t setStart = systemTime(SYSTEM_TIME_MONOTONIC);
+    hwcDevice->set(hwcDevice, 1, &list);
+    nsecs_t setDone = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    // The release fences aren't needed, the buffers are never written to
+    for (size_t n1 = 0; n1 < list->numHwLayers; n1++) {
+        hwc_layer_1_t *layer = &list->hwLayers[n1];
+        if (layer->releaseFenceFd >= 0) {
+            close(layer->releaseFenceFd);
+            layer->releaseFenceFd = -1;
+        }
+    }
+
+    nsecs_t fenceTime = -1;
+    if (list->retireFenceFd >= 0) {
+        sp<Fence> retireFence = new Fence(list->retireFenceFd);
+        list->retireFenceFd = -1;
+        if (retireFence->wait(fenceTimeoutMs) == NO_ERROR) {
+            nsecs_t signalTime = retireFence->getSignalTime();
+            if ((signalTime > 0) && (signalTime != INT64_MAX)) {
+                fenceTime = max(signalTime - setStart, nsecs_t(0));
+            }
+        } else if (measure) {
+            testPrintE("Retire fence not signaled after %u ms", fenceTimeoutMs);
+        }
+    }
+
+    if (!measure) {
+        return;
+    }
+
+    result->prepareTimes.push_back(prepared - start);
+    result->setTimes.push_back(setDone - setStart);
+    if (fenceTime >= 0) {
+        result->fenceTimes.push_back(fenceTime);
+    }
+    for (size_t n1 = 0; n1 < list->numHwLayers; n1++) {
+        result->layersOffered++;
+        if (list->hwLayers[n1].compositionType == HWC_OVERLAY) {
+            result->layersAccepted++;
+        }
+    }
+}
+
+// Sort times and return the value at percentile pct, in microseconds
+static double percentileUs(vector<nsecs_t>& times, unsigned int pct)
+{
+    if (times.empty()) { return 0.0; }
+    sort(times.begin(), times.end());
+    size_t idx = (times.size() - 1) * pct / 100;
+
+    return times[idx] / 1000.0;
+}
+
+static double meanUs(const vector<nsecs_t>& times)
+{
+    if (times.empty()) { return 0.0; }
+    double sum = 0.0;
+    for (size_t n1 = 0; n1 < times.size(); n1++) {
+        sum += times[n1];
+    }
+
+    return sum / times.size() / 1000.0;
+}
+
+static void printResult(FILE *out, size_t numLayers,
+    const struct hwcTestGraphicFormat *format, float scale,
+    const struct blendingOp *blending, BenchResult *result)
+{
+    fprintf(out, "%zu,%s,%g,%s,%zu,", numLayers, format->desc, scale,
+        blending->desc, result->prepareTimes.size());
+    fprintf(out, "%.1f,%.1f,%.1f,%.1f,", meanUs(result->prepareTimes),
+        percentileUs(result->prepareTimes, 50),
+        percentileUs(result->prepareTimes, 95),
+        percentileUs(result->prepareTimes, 100));
+    fprintf(out, "%.1f,%.1f,%.1f,%.1f,", meanUs(result->setTimes),
+        percentileUs(result->setTimes, 50),
+        percentileUs(result->setTimes, 95),
+        percentileUs(result->setTimes, 100));
+    fprintf(out, "%.1f,", result->layersOffered == 0 ? 0.0
+        : 100.0 * result->layersAccepted / result->layersOffered);
+    if (result->fenceTimes.empty()) {
+        fprintf(out, ",,0\n");
+    } else {
+        fprintf(out, "%.1f,%.1f,%zu\n", meanUs(result->fenceTimes),
+            percentileUs(result->fenceTimes, 95), result->fenceTimes.size());
+    }
+    fflush(out);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GL_TEST_BENCHMARK_REPORT_H
+#define ANDROID_GL_TEST_BENCHMARK_REPORT_H
+
+#include <stdio.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+/*
+ * Collects the results of a benchmark, along with a description of the
+ * device and of the EGL/GL implementation, and writes them as JSON or CSV
+ * so that runs on different devices and drivers can be compared by tools.
+ *
+ * All the benchmarks using this class write the same columns, so their CSV
+ * outputs can simply be concatenated.
+ */
+class BenchmarkReport {
+public:
+    enum Format {
+        FORMAT_TEXT,    // the benchmark's own human readable output
+        FORMAT_JSON,
+        FORMAT_CSV
+    };
+
+    // Parses "text", "json" or "csv", returns false for anything else.
+    static bool parseFormat(const char* name, Format* format);
+
+    BenchmarkReport(const char* suite, Format format);
+
+    Format format() const { return mFormat; }
+    bool isMachineReadable() const { return mFormat != FORMAT_TEXT; }
+
+    // Records the device's build properties and the strings of dpy and of
+    // the current GL context. Must be called with a context current.
+    void collectDeviceInfo(EGLDisplay dpy);
+    bool hasDeviceInfo() const { return !mDevice.isEmpty(); }
+
+    // Adds a result of scenario, params describes the variant that ran,
+    // for instance "1280x720" or "program=3 texture=1".
+    void addResult(const char* scenario, const char* params,
+            const char* metric, double value, const char* unit);
+
+    // Writes the report in its format, nothing is written for FORMAT_TEXT.
+    void write(FILE* out) const;
+
+private:
+    struct Property {
+        String8 name;
+        String8 value;
+    };
+
+    struct Result {
+        String8 scenario;
+        String8 params;
+        String8 metric;
+        String8 unit;
+        double value;
+    };
+
+    void addProperty(const char* name, const char* value);
+    void writeJson(FILE* out) const;
+    void writeCsv(FILE* out) const;
+
+    String8 mSuite;
+    Format mFormat;
+    Vector<Property> mDevice;
+    Vector<Result> mResults;
+};
+
+/*
+ * Measures the time the GPU spends on the commands issued between begin()
+ * and end(). With EGL_ANDROID_native_fence_sync, this is the difference
+ * between the signal times of fences inserted at both ends. Otherwise it
+ * falls back to the CPU time taken until glFinish() returns.
+ */
+class GpuTimer {
+public:
+    GpuTimer(EGLDisplay dpy);
+
+    bool usesFences() const { return mUseFences; }
+
+    void begin();
+
+    // Waits for the commands to complete and returns their duration in
+    // nanoseconds, or -1 on error.
+    nsecs_t end();
+
+private:
+    int createFence();
+
+    EGLDisplay mDisplay;
+    bool mUseFences;
+    int mStartFence;
+    nsecs_t mStartTime;
+};
+
+}; // namespace android
+
+#endif // ANDROID_GL_TEST_BENCHMARK_REPORT_H
@@ -17,7 +17,7 @@ LOCAL_PATH:= $(call my-dir)
 include $(CLEAR_VARS)
 LOCAL_MODULE_TAGS := tests
 LOCAL_MODULE:= libglTest
-LOCAL_SRC_FILES:= glTestLib.cpp WindowSurface.cpp
+LOCAL_SRC_FILES:= glTestLib.cpp WindowSurface.cpp BenchmarkReport.cpp
 LOCAL_C_INCLUDES += system/extras/tests/include \
     bionic \
     bionic/libstdc++/include \
@@ -26,7 +26,7 @@ LOCAL_C_INCLUDES += system/extras/tests/include \
 
 LOCAL_CFLAGS := -DGL_GLEXT_PROTOTYPES -DEGL_EGLEXT_PROTOTYPES
 
-LOCAL_SHARED_LIBRARIES += libcutils libutils libstlport
+LOCAL_SHARED_LIBRARIES += libcutils libutils libui libstlport
 
 
 include $(BUILD_STATIC_LIBRARY)
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <BenchmarkReport.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#include <cutils/properties.h>
+#include <ui/Fence.h>
+
+namespace android {
+
+static const char* const kBuildProperties[] = {
+    "ro.product.manufacturer",
+    "ro.product.model",
+    "ro.product.board",
+    "ro.hardware",
+    "ro.build.fingerprint",
+};
+
+static void writeJsonString(FILE* out, const char* s) {
+    fputc('"', out);
+    for ( ; *s ; s++) {
+        switch (*s) {
+        case '"':   fputs("\\\"", out); break;
+        case '\\':  fputs("\\\\", out); break;
+        case '\n':  fputs("\\n", out);  break;
+        case '\t':  fputs("\\t", out);  break;
+        default:
+            if ((unsigned char)*s < 0x20) {
+                fprintf(out, "\\u%04x", *s);
+            } else {
+                fputc(*s, out);
+            }
+        }
+    }
+    fputc('"', out);
+}
+
+static void writeCsvField(FILE* out, const char* s) {
+    if (!strpbrk(s, ",\"\r\n")) {
+        fputs(s, out);
+        return;
+    }
+    fputc('"', out);
+    for ( ; *s ; s++) {
+        if (*s == '"') {
+            fputc('"', out);
+        }
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+bool BenchmarkReport::parseFormat(const char* name, Format* format) {
+    if (!strcmp(name, "text")) {
+        *format = FORMAT_TEXT;
+    } else if (!strcmp(name, "json")) {
+        *format = FORMAT_JSON;
+    } else if (!strcmp(name, "csv")) {
+        *format = FORMAT_CSV;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+BenchmarkReport::BenchmarkReport(const char* suite, Format format) :
+    mSuite(suite),
+    mFormat(format) {
+}
+
+void BenchmarkReport::addProperty(const char* name, const char* value) {
+    Property p;
+    p.name = name;
+    p.value = value ? value : "";
+    mDevice.add(p);
+}
+
+void BenchmarkReport::collectDeviceInfo(EGLDisplay dpy) {
+    mDevice.clear();
+    for (size_t i = 0; i < sizeof(kBuildProperties)/sizeof(*kBuildProperties);
+            i++) {
+        char value[PROPERTY_VALUE_MAX];
+        property_get(kBuildProperties[i], value, "");
+        addProperty(kBuildProperties[i], value);
+    }
+    addProperty("egl.vendor", eglQueryString(dpy, EGL_VENDOR));
+    addProperty("egl.version", eglQueryString(dpy, EGL_VERSION));
+    addProperty("gl.vendor", (const char*)glGetString(GL_VENDOR));
+    addProperty("gl.renderer", (const char*)glGetString(GL_RENDERER));
+    addProperty("gl.version", (const char*)glGetString(GL_VERSION));
+}
+
+void BenchmarkReport::addResult(const char* scenario, const char* params,
+        const char* metric, double value, const char* unit) {
+    Result r;
+    r.scenario = scenario;
+    r.params = params;
+    r.metric = metric;
+    r.unit = unit;
+    r.value = value;
+    mResults.add(r);
+}
+
+void BenchmarkReport::write(FILE* out) const {
+    switch (mFormat) {
+    case FORMAT_JSON:
+        writeJson(out);
+        break;
+    case FORMAT_CSV:
+        writeCsv(out);
+        break;
+    default:
+        break;
+    }
+    fflush(out);
+}
+
+void BenchmarkReport::writeJson(FILE* out) const {
+    fputs("{\n  \"suite\": ", out);
+    writeJsonString(out, mSuite.string());
+    fputs(",\n  \"device\": {", out);
+    for (size_t i = 0; i < mDevice.size(); i++) {
+        fputs(i ? ",\n    " : "\n    ", out);
+        writeJsonString(out, mDevice[i].name.string());
+        fputs(": ", out);
+        writeJsonString(out, mDevice[i].value.string());
+    }
+    fputs("\n  },\n  \"results\": [", out);
+    for (size_t i = 0; i < mResults.size(); i++) {
+        const Result& r(mResults[i]);
+        fputs(i ? ",\n    { \"scenario\": " : "\n    { \"scenario\": ", out);
+        writeJsonString(out, r.scenario.string());
+        fputs(", \"params\": ", out);
+        writeJsonString(out, r.params.string());
+        fputs(", \"metric\": ", out);
+        writeJsonString(out, r.metric.string());
+        // JSON has no NaN nor infinity, a ratio with a zero duration has no value.
+        if (isfinite(r.value)) {
+            fprintf(out, ", \"value\": %.6f, \"unit\": ", r.value);
+        } else {
+            fputs(", \"value\": null, \"unit\": ", out);
+        }
+        writeJsonString(out, r.unit.string());
+        fputs(" }", out);
+    }
+    fputs("\n  ]\n}\n", out);
+}
+
+// Each row repeats the device description so that the outputs of several
+// devices and benchmarks can be concatenated and still be told apart.
+void BenchmarkReport::writeCsv(FILE* out) const {
+    fputs("suite", out);
+    for (size_t i = 0; i < mDevice.size(); i++) {
+        fputc(',', out);
+        writeCsvField(out, mDevice[i].name.string());
+    }
+    fputs(",scenario,params,metric,value,unit\n", out);
+
+    for (size_t i = 0; i < mResults.size(); i++) {
+        const Result& r(mResults[i]);
+        writeCsvField(out, mSuite.string());
+        for (size_t j = 0; j < mDevice.size(); j++) {
+            fputc(',', out);
+            writeCsvField(out, mDevice[j].value.string());
+        }
+        fputc(',', out);
+        writeCsvField(out, r.scenario.string());
+        fputc(',', out);
+        writeCsvField(out, r.params.string());
+        fputc(',', out);
+        writeCsvField(out, r.metric.string());
+        fprintf(out, ",%.6f,", r.value);
+        writeCsvField(out, r.unit.string());
+        fputc('\n', out);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+GpuTimer::GpuTimer(EGLDisplay dpy) :
+    mDisplay(dpy),
+    mUseFences(false),
+    mStartFence(-1),
+    mStartTime(0) {
+    const char* exts = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (exts && strstr(exts, "EGL_ANDROID_native_fence_sync")) {
+        int fd = createFence();
+        if (fd >= 0) {
+            close(fd);
+            mUseFences = true;
+        }
+    }
+}
+
+int GpuTimer::createFence() {
+    EGLSyncKHR sync = eglCreateSyncKHR(mDisplay,
+            EGL_SYNC_NATIVE_FENCE_ANDROID, NULL);
+    if (sync == EGL_NO_SYNC_KHR) {
+        return -1;
+    }
+    // the fence fd only exists once the sync object was flushed
+    glFlush();
+    int fd = eglDupNativeFenceFDANDROID(mDisplay, sync);
+    eglDestroySyncKHR(mDisplay, sync);
+    return fd;
+}
+
+void GpuTimer::begin() {
+    if (mUseFences) {
+        if (mStartFence >= 0) {
+            close(mStartFence);
+        }
+        mStartFence = createFence();
+    } else {
+        glFinish();
+        mStartTime = systemTime();
+    }
+}
+
+nsecs_t GpuTimer::end() {
+    if (!mUseFences) {
+        glFinish();
+        return systemTime() - mStartTime;
+    }
+
+    int endFence = createFence();
+    if (mStartFence < 0 || endFence < 0) {
+        if (endFence >= 0) {
+            close(endFence);
+        }
+        return -1;
+    }
+
+    // the Fences own the file descriptors
+    sp<Fence> start = new Fence(mStartFence);
+    sp<Fence> end = new Fence(endFence);
+    mStartFence = -1;
+    if (end->wait(Fence::TIMEOUT_NEVER) != NO_ERROR ||
+            start->wait(Fence::TIMEOUT_NEVER) != NO_ERROR) {
+        return -1;
+    }
+    return end->getSignalTime() - start->getSignalTime();
+}
+
+}; // namespace android
@@ -124,6 +124,14 @@ getPointer(JNIEnv *_env, jobject buffer, jarray *array, jint *remaining, jint *o
     limit = _env->GetIntField(buffer, limitID);
     elementSizeShift = _env->GetIntField(buffer, elementSizeShiftID);
     *remaining = (limit - position) << elementSizeShift;
+
+    // Direct buffers don't need the round trip through NIOAccess
+    char* address = (char*) _env->GetDirectBufferAddress(buffer);
+    if (address != NULL) {
+        *array = NULL;
+        return address + (position << elementSizeShift);
+    }
+
     pointer = _env->CallStaticLongMethod(nioAccessClass,
             getBasePointerID, buffer);
     if (pointer != 0L) {
@@ -3,11 +3,13 @@ include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES:= \
 	BatteryProperties.cpp \
+	BatteryPropertiesSnapshot.cpp \
 	BatteryProperty.cpp \
 	IBatteryPropertiesListener.cpp \
 	IBatteryPropertiesRegistrar.cpp
 
 LOCAL_STATIC_LIBRARIES := \
+	libcutils \
 	libutils \
 	libbinder
 
@@ -16,3 +18,5 @@ LOCAL_MODULE:= libbatteryservice
 LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_STATIC_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BatteryPropertiesSnapshot"
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cutils/ashmem.h>
+#include <cutils/atomic.h>
+
+#include <batteryservice/BatteryPropertiesSnapshot.h>
+#include <batteryservice/IBatteryPropertiesRegistrar.h>
+#include <binder/IServiceManager.h>
+#include <utils/String16.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+// An update only takes a moment, so a reader that keeps finding one in
+// progress gives up rather than spin on a registrar that died mid-update.
+static const int MAX_READ_ATTEMPTS = 1000;
+
+sp<BatteryPropertiesSnapshot> BatteryPropertiesSnapshot::create() {
+    const size_t size = sizeof(battery_properties_shared_t);
+    int fd = ashmem_create_region("BatteryProperties", size);
+    if (fd < 0) {
+        ALOGE("can't create battery properties snapshot: %s", strerror(errno));
+        return NULL;
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("can't map battery properties snapshot: %s", strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    // clients may only map it read-only from now on
+    ashmem_set_prot_region(fd, PROT_READ);
+
+    battery_properties_shared_t* shared =
+            static_cast<battery_properties_shared_t*>(base);
+    memset(shared, 0, size);
+    shared->version = battery_properties_shared_t::VERSION;
+    return new BatteryPropertiesSnapshot(fd, shared, true);
+}
+
+sp<BatteryPropertiesSnapshot> BatteryPropertiesSnapshot::map(int fd) {
+    const size_t size = sizeof(battery_properties_shared_t);
+    const int regionSize = ashmem_get_size_region(fd);
+    if (regionSize < int(size)) {
+        ALOGE("bad battery properties snapshot size %d", regionSize);
+        close(fd);
+        return NULL;
+    }
+    void* base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("can't map battery properties snapshot: %s", strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    battery_properties_shared_t* shared =
+            static_cast<battery_properties_shared_t*>(base);
+    if (shared->version != battery_properties_shared_t::VERSION) {
+        ALOGE("battery properties snapshot version %u, expected %u",
+                shared->version, battery_properties_shared_t::VERSION);
+        munmap(base, size);
+        close(fd);
+        return NULL;
+    }
+    return new BatteryPropertiesSnapshot(fd, shared, false);
+}
+
+sp<BatteryPropertiesSnapshot> BatteryPropertiesSnapshot::connect() {
+    sp<IBinder> binder = defaultServiceManager()->checkService(
+            String16("batteryproperties"));
+    if (binder == NULL) {
+        return NULL;
+    }
+    sp<IBatteryPropertiesRegistrar> registrar =
+            interface_cast<IBatteryPropertiesRegistrar>(binder);
+    return registrar->getPropertiesSnapshot();
+}
+
+BatteryPropertiesSnapshot::BatteryPropertiesSnapshot(int fd,
+        battery_properties_shared_t* shared, bool writable) :
+    mFd(fd),
+    mShared(shared),
+    mWritable(writable)
+{
+}
+
+BatteryPropertiesSnapshot::~BatteryPropertiesSnapshot() {
+    munmap(mShared, sizeof(battery_properties_shared_t));
+    close(mFd);
+}
+
+static bool equals(const BatteryProperties& a, const BatteryProperties& b) {
+    return a.chargerAcOnline == b.chargerAcOnline &&
+            a.chargerUsbOnline == b.chargerUsbOnline &&
+            a.chargerWirelessOnline == b.chargerWirelessOnline &&
+            a.batteryStatus == b.batteryStatus &&
+            a.batteryHealth == b.batteryHealth &&
+            a.batteryPresent == b.batteryPresent &&
+            a.batteryLevel == b.batteryLevel &&
+            a.batteryVoltage == b.batteryVoltage &&
+            a.batteryTemperature == b.batteryTemperature &&
+            a.batteryTechnology == b.batteryTechnology;
+}
+
+bool BatteryPropertiesSnapshot::publish(const BatteryProperties& props) {
+    LOG_ALWAYS_FATAL_IF(!mWritable, "publish() on a client snapshot");
+    const int32_t sequence = mShared->sequence;
+    if (sequence != 0 && equals(props, mLast)) {
+        return false;
+    }
+    mLast = props;
+
+    // odd while we write; the barrier keeps the writes below from being
+    // seen before it
+    android_atomic_release_store(sequence + 1, &mShared->sequence);
+    android_memory_barrier();
+    mShared->timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
+    mShared->chargerAcOnline = props.chargerAcOnline;
+    mShared->chargerUsbOnline = props.chargerUsbOnline;
+    mShared->chargerWirelessOnline = props.chargerWirelessOnline;
+    mShared->batteryStatus = props.batteryStatus;
+    mShared->batteryHealth = props.batteryHealth;
+    mShared->batteryPresent = props.batteryPresent;
+    mShared->batteryLevel = props.batteryLevel;
+    mShared->batteryVoltage = props.batteryVoltage;
+    mShared->batteryTemperature = props.batteryTemperature;
+    strncpy(mShared->batteryTechnology, props.batteryTechnology.string(),
+            battery_properties_shared_t::TECHNOLOGY_SIZE - 1);
+    mShared->batteryTechnology[battery_properties_shared_t::TECHNOLOGY_SIZE - 1] = 0;
+    android_atomic_release_store(sequence + 2, &mShared->sequence);
+    return true;
+}
+
+status_t BatteryPropertiesSnapshot::read(BatteryProperties* props,
+        uint32_t* outSequence, nsecs_t* outTimestamp) const {
+    battery_properties_shared_t copy;
+    int32_t sequence;
+    int attempt;
+    for (attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        sequence = android_atomic_acquire_load(&mShared->sequence);
+        if (sequence & 1) {
+            // the registrar is writing, which only takes a moment
+            sched_yield();
+            continue;
+        }
+        memcpy(&copy, mShared, sizeof(copy));
+        android_memory_barrier();
+        if (mShared->sequence == sequence) {
+            break;
+        }
+    }
+    if (attempt == MAX_READ_ATTEMPTS) {
+        // the registrar died in the middle of an update, or is stuck there
+        ALOGW("battery properties snapshot is being updated for too long");
+        return WOULD_BLOCK;
+    }
+    if (sequence == 0) {
+        return NO_INIT;
+    }
+
+    props->chargerAcOnline = copy.chargerAcOnline;
+    props->chargerUsbOnline = copy.chargerUsbOnline;
+    props->chargerWirelessOnline = copy.chargerWirelessOnline;
+    props->batteryStatus = copy.batteryStatus;
+    props->batteryHealth = copy.batteryHealth;
+    props->batteryPresent = copy.batteryPresent;
+    props->batteryLevel = copy.batteryLevel;
+    props->batteryVoltage = copy.batteryVoltage;
+    props->batteryTemperature = copy.batteryTemperature;
+    copy.batteryTechnology[battery_properties_shared_t::TECHNOLOGY_SIZE - 1] = 0;
+    props->batteryTechnology = copy.batteryTechnology;
+    if (outSequence) {
+        *outSequence = uint32_t(sequence) / 2;
+    }
+    if (outTimestamp) {
+        *outTimestamp = copy.timestamp;
+    }
+    return NO_ERROR;
+}
+
+uint32_t BatteryPropertiesSnapshot::getSequence() const {
+    return uint32_t(android_atomic_acquire_load(&mShared->sequence)) / 2;
+}
+
+}; // namespace android
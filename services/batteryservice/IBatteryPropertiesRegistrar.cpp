@@ -21,6 +21,7 @@
 #include <batteryservice/IBatteryPropertiesListener.h>
 #include <batteryservice/IBatteryPropertiesRegistrar.h>
 #include <stdint.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <binder/Parcel.h>
 
@@ -60,6 +61,21 @@ public:
                 val->readFromParcel(&reply);
             return ret;
         }
+
+        sp<BatteryPropertiesSnapshot> getPropertiesSnapshot() {
+            Parcel data, reply;
+            data.writeInterfaceToken(IBatteryPropertiesRegistrar::getInterfaceDescriptor());
+            status_t err = remote()->transact(GET_PROPERTIES_SNAPSHOT, data, &reply);
+            if (err != NO_ERROR || reply.readExceptionCode() != 0 ||
+                    !reply.readInt32()) {
+                return NULL;
+            }
+            int fd = dup(reply.readFileDescriptor());
+            if (fd < 0) {
+                return NULL;
+            }
+            return BatteryPropertiesSnapshot::map(fd);
+        }
 };
 
 IMPLEMENT_META_INTERFACE(BatteryPropertiesRegistrar, "android.os.IBatteryPropertiesRegistrar");
@@ -97,10 +113,50 @@ status_t BnBatteryPropertiesRegistrar::onTransact(uint32_t code,
             val.writeToParcel(reply);
             return OK;
         }
+
+        case GET_PROPERTIES_SNAPSHOT: {
+            CHECK_INTERFACE(IBatteryPropertiesRegistrar, data, reply);
+            sp<BatteryPropertiesSnapshot> snapshot = getPropertiesSnapshot();
+            reply->writeNoException();
+            reply->writeInt32(snapshot != NULL ? 1 : 0);
+            if (snapshot != NULL) {
+                reply->writeDupFileDescriptor(snapshot->getFd());
+            }
+            return OK;
+        }
     }
     return BBinder::onTransact(code, data, reply, flags);
 };
 
+// Publishes the updates the registrar sends its listeners to the snapshot.
+class SnapshotPublisher : public BnInterface<IBatteryPropertiesListener> {
+public:
+    SnapshotPublisher(const sp<BatteryPropertiesSnapshot>& snapshot)
+        : mSnapshot(snapshot) {}
+
+    virtual void batteryPropertiesChanged(struct BatteryProperties props) {
+        mSnapshot->publish(props);
+    }
+
+private:
+    sp<BatteryPropertiesSnapshot> mSnapshot;
+};
+
+sp<BatteryPropertiesSnapshot> BnBatteryPropertiesRegistrar::getPropertiesSnapshot()
+{
+    Mutex::Autolock _l(mSnapshotLock);
+    if (mSnapshot == NULL) {
+        sp<BatteryPropertiesSnapshot> snapshot = BatteryPropertiesSnapshot::create();
+        if (snapshot == NULL) {
+            return NULL;
+        }
+        // registrars send the current properties to new listeners
+        registerListener(new SnapshotPublisher(snapshot));
+        mSnapshot = snapshot;
+    }
+    return mSnapshot;
+}
+
 // ----------------------------------------------------------------------------
 
 }; // namespace android
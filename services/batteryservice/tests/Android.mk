@@ -0,0 +1,24 @@
+# Build the unit tests.
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libbatteryservice_test
+LOCAL_MODULE_TAGS := tests
+LOCAL_SRC_FILES := \
+    BatteryPropertiesSnapshot_test.cpp
+
+LOCAL_STATIC_LIBRARIES := \
+    libbatteryservice
+
+LOCAL_SHARED_LIBRARIES := \
+    libbinder \
+    libcutils \
+    libutils
+
+LOCAL_C_INCLUDES := \
+    bionic \
+    bionic/libstdc++/include \
+    external/gtest/include \
+    external/stlport/stlport \
+
+include $(BUILD_NATIVE_TEST)
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BatteryPropertiesSnapshot_test"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <batteryservice/BatteryPropertiesSnapshot.h>
+#include <batteryservice/IBatteryPropertiesRegistrar.h>
+#include <binder/Parcel.h>
+#include <cutils/ashmem.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+// Sends the current properties to new listeners, like healthd does.
+class FakeRegistrar : public BnBatteryPropertiesRegistrar {
+public:
+    FakeRegistrar(const BatteryProperties& props) : mProps(props) {}
+
+    virtual void registerListener(const sp<IBatteryPropertiesListener>& listener) {
+        mListeners.add(listener);
+        listener->batteryPropertiesChanged(mProps);
+    }
+
+    virtual void unregisterListener(const sp<IBatteryPropertiesListener>& listener) {
+        for (size_t i = 0; i < mListeners.size(); i++) {
+            if (mListeners[i] == listener) {
+                mListeners.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    virtual status_t getProperty(int, struct BatteryProperty*) {
+        return NAME_NOT_FOUND;
+    }
+
+    void update(const BatteryProperties& props) {
+        mProps = props;
+        for (size_t i = 0; i < mListeners.size(); i++) {
+            mListeners[i]->batteryPropertiesChanged(mProps);
+        }
+    }
+
+    size_t getListenerCount() const { return mListeners.size(); }
+
+private:
+    BatteryProperties mProps;
+    Vector<sp<IBatteryPropertiesListener> > mListeners;
+};
+
+class BatteryPropertiesSnapshotTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        mProps.chargerAcOnline = true;
+        mProps.chargerUsbOnline = false;
+        mProps.chargerWirelessOnline = false;
+        mProps.batteryStatus = BATTERY_STATUS_CHARGING;
+        mProps.batteryHealth = BATTERY_HEALTH_GOOD;
+        mProps.batteryPresent = true;
+        mProps.batteryLevel = 42;
+        mProps.batteryVoltage = 3900;
+        mProps.batteryTemperature = 250;
+        mProps.batteryTechnology = "Li-ion";
+    }
+
+    // Maps a region laid out like a snapshot, with the given sequence, so
+    // that tests can stage what a registrar would have left behind.
+    sp<BatteryPropertiesSnapshot> mapFake(int32_t sequence) {
+        const size_t size = sizeof(battery_properties_shared_t);
+        int fd = ashmem_create_region("BatteryPropertiesSnapshotTest", size);
+        if (fd < 0) {
+            return NULL;
+        }
+        void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            return NULL;
+        }
+        battery_properties_shared_t* shared =
+                static_cast<battery_properties_shared_t*>(base);
+        memset(shared, 0, size);
+        shared->version = battery_properties_shared_t::VERSION;
+        shared->sequence = sequence;
+        shared->batteryLevel = mProps.batteryLevel;
+        munmap(base, size);
+        return BatteryPropertiesSnapshot::map(fd);
+    }
+
+    BatteryProperties mProps;
+};
+
+TEST_F(BatteryPropertiesSnapshotTest, ReadsWhatWasPublished) {
+    sp<BatteryPropertiesSnapshot> snapshot = BatteryPropertiesSnapshot::create();
+    ASSERT_TRUE(snapshot != NULL);
+
+    BatteryProperties props;
+    EXPECT_EQ(NO_INIT, snapshot->read(&props));
+
+    EXPECT_TRUE(snapshot->publish(mProps));
+    uint32_t sequence;
+    ASSERT_EQ(NO_ERROR, snapshot->read(&props, &sequence));
+    EXPECT_EQ(1U, sequence);
+    EXPECT_EQ(snapshot->getSequence(), sequence);
+    EXPECT_EQ(mProps.chargerAcOnline, props.chargerAcOnline);
+    EXPECT_EQ(mProps.batteryStatus, props.batteryStatus);
+    EXPECT_EQ(mProps.batteryLevel, props.batteryLevel);
+    EXPECT_EQ(mProps.batteryTemperature, props.batteryTemperature);
+    EXPECT_STREQ(mProps.batteryTechnology.string(), props.batteryTechnology.string());
+}
+
+TEST_F(BatteryPropertiesSnapshotTest, ClientSeesUpdatesThroughItsOwnMapping) {
+    sp<BatteryPropertiesSnapshot> snapshot = BatteryPropertiesSnapshot::create();
+    ASSERT_TRUE(snapshot != NULL);
+    sp<BatteryPropertiesSnapshot> client =
+            BatteryPropertiesSnapshot::map(dup(snapshot->getFd()));
+    ASSERT_TRUE(client != NULL);
+
+    snapshot->publish(mProps);
+    mProps.batteryLevel = 43;
+    snapshot->publish(mProps);
+
+    BatteryProperties props;
+    ASSERT_EQ(NO_ERROR, client->read(&props));
+    EXPECT_EQ(43, props.batteryLevel);
+    EXPECT_EQ(2U, client->getSequence());
+}
+
+TEST_F(BatteryPropertiesSnapshotTest, UnchangedUpdatesAreCoalesced) {
+    sp<BatteryPropertiesSnapshot> snapshot = BatteryPropertiesSnapshot::create();
+    ASSERT_TRUE(snapshot != NULL);
+
+    EXPECT_TRUE(snapshot->publish(mProps));
+    EXPECT_FALSE(snapshot->publish(mProps));
+    EXPECT_EQ(1U, snapshot->getSequence());
+
+    mProps.batteryVoltage++;
+    EXPECT_TRUE(snapshot->publish(mProps));
+    EXPECT_EQ(2U, snapshot->getSequence());
+}
+
+TEST_F(BatteryPropertiesSnapshotTest, ReadGivesUpOnUpdateThatNeverEnds) {
+    // odd: the registrar died in the middle of an update
+    sp<BatteryPropertiesSnapshot> snapshot = mapFake(3);
+    ASSERT_TRUE(snapshot != NULL);
+
+    BatteryProperties props;
+    EXPECT_EQ(WOULD_BLOCK, snapshot->read(&props));
+}
+
+TEST_F(BatteryPropertiesSnapshotTest, ReadsCompleteUpdate) {
+    sp<BatteryPropertiesSnapshot> snapshot = mapFake(4);
+    ASSERT_TRUE(snapshot != NULL);
+
+    BatteryProperties props;
+    uint32_t sequence;
+    ASSERT_EQ(NO_ERROR, snapshot->read(&props, &sequence));
+    EXPECT_EQ(2U, sequence);
+    EXPECT_EQ(mProps.batteryLevel, props.batteryLevel);
+}
+
+TEST_F(BatteryPropertiesSnapshotTest, RegistrarPublishesItsUpdates) {
+    sp<FakeRegistrar> registrar = new FakeRegistrar(mProps);
+
+    // what BpBatteryPropertiesRegistrar::getPropertiesSnapshot() sends
+    Parcel data, reply;
+    data.writeInterfaceToken(IBatteryPropertiesRegistrar::getInterfaceDescriptor());
+    ASSERT_EQ(NO_ERROR, registrar->transact(GET_PROPERTIES_SNAPSHOT, data, &reply));
+    ASSERT_EQ(0, reply.readExceptionCode());
+    ASSERT_EQ(1, reply.readInt32());
+    sp<BatteryPropertiesSnapshot> client =
+            BatteryPropertiesSnapshot::map(dup(reply.readFileDescriptor()));
+    ASSERT_TRUE(client != NULL);
+    EXPECT_EQ(1U, registrar->getListenerCount());
+
+    BatteryProperties props;
+    ASSERT_EQ(NO_ERROR, client->read(&props));
+    EXPECT_EQ(mProps.batteryLevel, props.batteryLevel);
+
+    mProps.batteryLevel = 50;
+    registrar->update(mProps);
+    ASSERT_EQ(NO_ERROR, client->read(&props));
+    EXPECT_EQ(50, props.batteryLevel);
+
+    // later requests share the same snapshot and listener
+    EXPECT_TRUE(registrar->getPropertiesSnapshot() != NULL);
+    EXPECT_EQ(1U, registrar->getListenerCount());
+}
+
+} // namespace android
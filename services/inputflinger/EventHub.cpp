@@ -20,6 +20,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <memory.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,6 +40,7 @@
 
 #include <hardware_legacy/power.h>
 
+#include <cutils/atomic.h>
 #include <cutils/properties.h>
 #include <openssl/sha.h>
 #include <utils/Log.h>
@@ -173,6 +175,7 @@ const uint32_t EventHub::EPOLL_ID_INOTIFY;
 const uint32_t EventHub::EPOLL_ID_WAKE;
 const int EventHub::EPOLL_SIZE_HINT;
 const int EventHub::EPOLL_MAX_EVENTS;
+const size_t EventHub::MIN_DEVICE_READ_SIZE;
 
 EventHub::EventHub(void) :
         mBuiltInKeyboardId(NO_BUILT_IN_KEYBOARD), mNextDeviceId(1), mControllerNumbers(),
@@ -807,8 +810,19 @@ size_t EventHub::getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSiz
 
             Device* device = mDevices.valueAt(deviceIndex);
             if (eventItem.events & EPOLLIN) {
+                // Leave room for the other ready devices; whatever is left
+                // unread is picked up by the next poll.
+                size_t readCapacity = capacity;
+                const size_t readyDevices = countPendingDeviceReadsLocked();
+                if (readyDevices > 1) {
+                    readCapacity = capacity / readyDevices;
+                    if (readCapacity < MIN_DEVICE_READ_SIZE) {
+                        readCapacity = MIN_DEVICE_READ_SIZE < capacity ?
+                                MIN_DEVICE_READ_SIZE : capacity;
+                    }
+                }
                 int32_t readSize = read(device->fd, readBuffer,
-                        sizeof(struct input_event) * capacity);
+                        sizeof(struct input_event) * readCapacity);
                 if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
                     // Device was removed before INotify noticed.
                     ALOGW("could not get event, removed? (fd: %d size: %" PRId32
@@ -1003,6 +1017,20 @@ size_t EventHub::getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSiz
     return event - buffer;
 }
 
+size_t EventHub::countPendingDeviceReadsLocked() const {
+    // mPendingEventIndex has already moved past the event being handled
+    size_t count = 0;
+    for (size_t i = mPendingEventIndex - 1; i < mPendingEventCount; i++) {
+        const struct epoll_event& eventItem = mPendingEventItems[i];
+        if (eventItem.data.u32 != EPOLL_ID_INOTIFY
+                && eventItem.data.u32 != EPOLL_ID_WAKE
+                && (eventItem.events & EPOLLIN)) {
+            count++;
+        }
+    }
+    return count;
+}
+
 void EventHub::wake() {
     ALOGV("wake() called");
 
@@ -1049,8 +1077,19 @@ static const int32_t GAMEPAD_KEYCODES[] = {
 };
 
 status_t EventHub::openDeviceLocked(const char *devicePath) {
+    Device* device;
+    status_t status = probeDevice(devicePath, &device);
+    if (status) {
+        return status;
+    }
+    return registerDeviceLocked(device);
+}
+
+status_t EventHub::probeDevice(const char* devicePath, Device** outDevice) {
     char buffer[80];
 
+    *outDevice = NULL;
+
     ALOGV("Opening device: %s", devicePath);
 
     int fd = open(devicePath, O_RDWR | O_CLOEXEC);
@@ -1115,9 +1154,6 @@ status_t EventHub::openDeviceLocked(const char *devicePath) {
         identifier.uniqueId.setTo(buffer);
     }
 
-    // Fill in the descriptor.
-    assignDescriptorLocked(identifier);
-
     // Make file descriptor non-blocking for use with poll().
     if (fcntl(fd, F_SETFL, O_NONBLOCK)) {
         ALOGE("Error %d making device file descriptor non-blocking.", errno);
@@ -1126,10 +1162,10 @@ status_t EventHub::openDeviceLocked(const char *devicePath) {
     }
 
     // Allocate device.  (The device object takes ownership of the fd at this point.)
-    int32_t deviceId = mNextDeviceId++;
-    Device* device = new Device(fd, deviceId, String8(devicePath), identifier);
+    // Its id and descriptor are assigned when it is registered.
+    Device* device = new Device(fd, -1, String8(devicePath), identifier);
 
-    ALOGV("add device %d: %s\n", deviceId, devicePath);
+    ALOGV("probe device: %s\n", devicePath);
     ALOGV("  bus:        %04x\n"
          "  vendor      %04x\n"
          "  product     %04x\n"
@@ -1138,7 +1174,6 @@ status_t EventHub::openDeviceLocked(const char *devicePath) {
     ALOGV("  name:       \"%s\"\n", identifier.name.string());
     ALOGV("  location:   \"%s\"\n", identifier.location.string());
     ALOGV("  unique id:  \"%s\"\n", identifier.uniqueId.string());
-    ALOGV("  descriptor: \"%s\"\n", identifier.descriptor.string());
     ALOGV("  driver:     v%d.%d.%d\n",
         driverVersion >> 16, (driverVersion >> 8) & 0xff, driverVersion & 0xff);
 
@@ -1230,22 +1265,13 @@ status_t EventHub::openDeviceLocked(const char *devicePath) {
 
     // Load the key map.
     // We need to do this for joysticks too because the key layout may specify axes.
-    status_t keyMapStatus = NAME_NOT_FOUND;
     if (device->classes & (INPUT_DEVICE_CLASS_KEYBOARD | INPUT_DEVICE_CLASS_JOYSTICK)) {
         // Load the keymap for the device.
-        keyMapStatus = loadKeyMapLocked(device);
+        loadKeyMapLocked(device);
     }
 
     // Configure the keyboard, gamepad or virtual keyboard.
     if (device->classes & INPUT_DEVICE_CLASS_KEYBOARD) {
-        // Register the keyboard as a built-in keyboard if it is eligible.
-        if (!keyMapStatus
-                && mBuiltInKeyboardId == NO_BUILT_IN_KEYBOARD
-                && isEligibleBuiltInKeyboard(device->identifier,
-                        device->configuration, &device->keyMap)) {
-            mBuiltInKeyboardId = device->id;
-        }
-
         // 'Q' key support = cheap test of whether this is an alpha-capable kbd
         if (hasKeycodeLocked(device, AKEYCODE_Q)) {
             device->classes |= INPUT_DEVICE_CLASS_ALPHAKEY;
@@ -1277,8 +1303,8 @@ status_t EventHub::openDeviceLocked(const char *devicePath) {
 
     // If the device isn't recognized as something we handle, don't monitor it.
     if (device->classes == 0) {
-        ALOGV("Dropping device: id=%d, path='%s', name='%s'",
-                deviceId, devicePath, device->identifier.name.string());
+        ALOGV("Dropping device: path='%s', name='%s'",
+                devicePath, device->identifier.name.string());
         delete device;
         return -1;
     }
@@ -1288,6 +1314,31 @@ status_t EventHub::openDeviceLocked(const char *devicePath) {
         device->classes |= INPUT_DEVICE_CLASS_EXTERNAL;
     }
 
+    *outDevice = device;
+    return OK;
+}
+
+status_t EventHub::registerDeviceLocked(Device* device) {
+    const char* devicePath = device->path.string();
+    int fd = device->fd;
+
+    // Fill in the descriptor and assign the device id.
+    assignDescriptorLocked(device->identifier);
+    int32_t deviceId = mNextDeviceId++;
+    device->id = deviceId;
+
+    ALOGV("add device %d: %s, descriptor \"%s\"\n", deviceId, devicePath,
+            device->identifier.descriptor.string());
+
+    // Register the keyboard as a built-in keyboard if it is eligible.
+    if ((device->classes & INPUT_DEVICE_CLASS_KEYBOARD)
+            && device->keyMap.isComplete()
+            && mBuiltInKeyboardId == NO_BUILT_IN_KEYBOARD
+            && isEligibleBuiltInKeyboard(device->identifier,
+                    device->configuration, &device->keyMap)) {
+        mBuiltInKeyboardId = deviceId;
+    }
+
     if (device->classes & (INPUT_DEVICE_CLASS_JOYSTICK | INPUT_DEVICE_CLASS_DPAD)
             && device->classes & INPUT_DEVICE_CLASS_GAMEPAD) {
         device->controllerNumber = getNextControllerNumberLocked(device);
@@ -1597,18 +1648,77 @@ status_t EventHub::scanDirLocked(const char *dirname)
     strcpy(devname, dirname);
     filename = devname + strlen(devname);
     *filename++ = '/';
+    Vector<String8> devicePaths;
     while((de = readdir(dir))) {
         if(de->d_name[0] == '.' &&
            (de->d_name[1] == '\0' ||
             (de->d_name[1] == '.' && de->d_name[2] == '\0')))
             continue;
         strcpy(filename, de->d_name);
-        openDeviceLocked(devname);
+        devicePaths.add(String8(devname));
     }
     closedir(dir);
+
+    // Probing a device takes a number of ioctls and may require loading several files,
+    // so probe them all at once and only register them with the lock held.  They are
+    // registered in directory order so that device ids don't depend on timing.
+    Vector<Device*> devices;
+    devices.insertAt(NULL, 0, devicePaths.size());
+    probeDevices(devicePaths, devices.editArray());
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (devices[i]) {
+            registerDeviceLocked(devices[i]);
+        }
+    }
     return 0;
 }
 
+struct EventHub::ProbeTask {
+    EventHub* eventHub;
+    const Vector<String8>* devicePaths;
+    Device** devices;
+    volatile int32_t nextIndex;
+};
+
+void* EventHub::probeThread(void* data) {
+    ProbeTask* task = static_cast<ProbeTask*>(data);
+    for (;;) {
+        size_t index = size_t(android_atomic_inc(&task->nextIndex));
+        if (index >= task->devicePaths->size()) {
+            break;
+        }
+        task->eventHub->probeDevice(task->devicePaths->itemAt(index).string(),
+                &task->devices[index]);
+    }
+    return NULL;
+}
+
+void EventHub::probeDevices(const Vector<String8>& devicePaths, Device** outDevices) {
+    ProbeTask task;
+    task.eventHub = this;
+    task.devicePaths = &devicePaths;
+    task.devices = outDevices;
+    task.nextIndex = 0;
+
+    size_t threadCount = devicePaths.size() < MAX_PROBE_THREADS
+            ? devicePaths.size() : MAX_PROBE_THREADS;
+    pthread_t threads[MAX_PROBE_THREADS];
+    size_t startedCount = 0;
+    // The calling thread does its share of the work too.
+    while (startedCount + 1 < threadCount) {
+        int result = pthread_create(&threads[startedCount], NULL, probeThread, &task);
+        if (result) {
+            ALOGW("Could not start device probe thread, error=%d", result);
+            break;
+        }
+        startedCount += 1;
+    }
+    probeThread(&task);
+    for (size_t i = 0; i < startedCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
 void EventHub::requestReopenDevices() {
     ALOGV("requestReopenDevices() called");
 
@@ -325,9 +325,9 @@ private:
         Device* next;
 
         int fd; // may be -1 if device is virtual
-        const int32_t id;
+        int32_t id; // assigned when the device is registered, never changes afterwards
         const String8 path;
-        const InputDeviceIdentifier identifier;
+        InputDeviceIdentifier identifier; // the descriptor is filled in on registration
 
         uint32_t classes;
 
@@ -371,6 +371,12 @@ private:
     };
 
     status_t openDeviceLocked(const char *devicePath);
+    // Opens a device and figures out its classes, configuration and key maps.
+    // Only reads the excluded devices list, so several devices may be probed at
+    // once by threads that don't hold the lock while the scanning thread does.
+    status_t probeDevice(const char* devicePath, Device** outDevice);
+    // Assigns an id and descriptor to a probed device and starts monitoring it.
+    status_t registerDeviceLocked(Device* device);
     void createVirtualKeyboardLocked();
     void addDeviceLocked(Device* device);
     void assignDescriptorLocked(InputDeviceIdentifier& identifier);
@@ -380,9 +386,19 @@ private:
     void closeAllDevicesLocked();
 
     status_t scanDirLocked(const char *dirname);
+    // Probes the devices on up to MAX_PROBE_THREADS threads, including the calling one.
+    // The devices that could not be opened, or that we don't handle, are set to NULL.
+    enum { MAX_PROBE_THREADS = 4 };
+    struct ProbeTask;
+    void probeDevices(const Vector<String8>& devicePaths, Device** outDevices);
+    static void* probeThread(void* data);
     void scanDevicesLocked();
     status_t readNotifyLocked();
 
+    // returns how many of the pending epoll events, from the one being
+    // handled on, are for devices with events to read
+    size_t countPendingDeviceReadsLocked() const;
+
     Device* getDeviceByDescriptorLocked(String8& descriptor) const;
     Device* getDeviceLocked(int32_t deviceId) const;
     Device* getDeviceByPathLocked(const char* devicePath) const;
@@ -441,7 +457,12 @@ private:
     static const int EPOLL_SIZE_HINT = 8;
 
     // Maximum number of signalled FDs to handle at a time.
-    static const int EPOLL_MAX_EVENTS = 16;
+    static const int EPOLL_MAX_EVENTS = 32;
+
+    // When several devices are ready, each is read for at most its share of
+    // the caller's buffer, but never for fewer events than this, so that a
+    // device flooding events doesn't hold back the others.
+    static const size_t MIN_DEVICE_READ_SIZE = 16;
 
     // The array of pending epoll events and the index of the next event to be handled.
     struct epoll_event mPendingEventItems[EPOLL_MAX_EVENTS];
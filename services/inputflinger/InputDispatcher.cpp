@@ -45,6 +45,7 @@
 
 #include "InputDispatcher.h"
 
+#include <binder/IPCThreadState.h>
 #include <utils/Trace.h>
 #include <cutils/log.h>
 #include <powermanager/PowerManager.h>
@@ -53,6 +54,7 @@
 #include <stddef.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 #include <limits.h>
 #include <time.h>
 
@@ -85,9 +87,102 @@ const nsecs_t STREAM_AHEAD_EVENT_TIMEOUT = 500 * 1000000LL; // 0.5sec
 // Log a warning when an event takes longer than this to process, even if an ANR does not occur.
 const nsecs_t SLOW_EVENT_PROCESSING_WARNING_TIMEOUT = 2000 * 1000000LL; // 2sec
 
+// A monitor whose events take longer than this to be finished, on average, is lagging.
+// Pending MOVE samples sent to it are then replaced by newer ones instead of being
+// queued behind each other.
+const nsecs_t MONITOR_LAG_THRESHOLD = 50 * 1000000LL; // 50ms
+
 // Number of recent events to keep for debugging purposes.
 const size_t RECENT_QUEUE_MAX_SIZE = 10;
 
+// Number of released entries of each type kept for reuse, so that the entries
+// created for each event don't go through the heap once the dispatcher is warmed up.
+const size_t KEY_ENTRY_POOL_SIZE = 32;
+const size_t MOTION_ENTRY_POOL_SIZE = 64;
+const size_t DISPATCH_ENTRY_POOL_SIZE = 128;
+
+// A free list of blocks for entries of one type, used by their operator new and
+// operator delete.  It has its own lock since entries may be released by any of
+// the dispatchers in the process, but it is not contended in practice: entries
+// are created and released with the dispatcher lock held.
+class EntryPool {
+public:
+    EntryPool(size_t blockSize, size_t capacity) :
+            mBlockSize(blockSize), mCapacity(capacity), mFreeList(NULL), mFreeCount(0),
+            mInUse(0), mPeakInUse(0), mHeapAllocations(0) {
+    }
+
+    void* allocate(size_t size) {
+        if (size != mBlockSize) {
+            // A derived type that didn't declare its own operator new.
+            return ::operator new(size);
+        }
+
+        AutoMutex _l(mLock);
+        mInUse += 1;
+        if (mInUse > mPeakInUse) {
+            mPeakInUse = mInUse;
+        }
+        if (mFreeList) {
+            FreeBlock* block = mFreeList;
+            mFreeList = block->next;
+            mFreeCount -= 1;
+            return block;
+        }
+        mHeapAllocations += 1;
+        return ::operator new(size);
+    }
+
+    void free(void* ptr, size_t size) {
+        if (!ptr) {
+            return;
+        }
+        if (size != mBlockSize) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        AutoMutex _l(mLock);
+        mInUse -= 1;
+        if (mFreeCount >= mCapacity) {
+            ::operator delete(ptr);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = mFreeList;
+        mFreeList = block;
+        mFreeCount += 1;
+    }
+
+    void dump(String8& dump, const char* name) {
+        AutoMutex _l(mLock);
+        dump.appendFormat(INDENT2 "%s: inUse=%zu, peakInUse=%zu, pooled=%zu/%zu, "
+                "heapAllocations=%zu\n",
+                name, mInUse, mPeakInUse, mFreeCount, mCapacity, mHeapAllocations);
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    const size_t mBlockSize;
+    const size_t mCapacity;
+
+    Mutex mLock;
+    FreeBlock* mFreeList;
+    size_t mFreeCount;
+    size_t mInUse;
+    size_t mPeakInUse;
+    size_t mHeapAllocations; // blocks that had to be taken from the heap
+};
+
+template <typename T>
+static EntryPool& getEntryPool(size_t capacity) {
+    static EntryPool pool(sizeof(T), capacity);
+    return pool;
+}
+
 static inline nsecs_t now() {
     return systemTime(SYSTEM_TIME_MONOTONIC);
 }
@@ -198,10 +293,13 @@ static void dumpRegion(String8& dump, const Region& region) {
 
 InputDispatcher::InputDispatcher(const sp<InputDispatcherPolicyInterface>& policy) :
     mPolicy(policy),
-    mPendingEvent(NULL), mAppSwitchSawKeyDown(false), mAppSwitchDueTime(LONG_LONG_MAX),
+    mPendingEvent(NULL),
+    mInboundRingHead(0), mInboundRingTail(0), mInboundRingWakePending(0),
+    mAppSwitchSawKeyDown(false), mAppSwitchDueTime(LONG_LONG_MAX),
     mNextUnblockedEvent(NULL),
     mDispatchEnabled(false), mDispatchFrozen(false), mInputFilterEnabled(false),
-    mInputTargetWaitCause(INPUT_TARGET_WAIT_CAUSE_NONE) {
+    mInputTargetWaitCause(INPUT_TARGET_WAIT_CAUSE_NONE),
+    mDispatchingLaneDisplayId(ADISPLAY_ID_NONE) {
     mLooper = new Looper(false);
 
     mKeyRepeatState.lastKeyEntry = NULL;
@@ -215,7 +313,14 @@ InputDispatcher::~InputDispatcher() {
 
         resetKeyRepeatLocked();
         releasePendingEventLocked();
+        drainDisplayLanesLocked();
+        drainInboundRingLocked();
         drainInboundQueueLocked();
+        drainScheduledInjectionQueueLocked();
+        for (size_t i = 0; i < mInjectionBatches.size(); i++) {
+            mInjectionBatches[i]->release();
+        }
+        mInjectionBatches.clear();
     }
 
     while (mConnectionsByFd.size() != 0) {
@@ -229,10 +334,17 @@ void InputDispatcher::dispatchOnce() {
         AutoMutex _l(mLock);
         mDispatcherIsAliveCondition.broadcast();
 
+        // Pick up the events handed over by the reader.  Clear the wake flag first so that
+        // events added past this point wake us up again.
+        android_atomic_and(0, &mInboundRingWakePending);
+        drainInboundRingLocked();
+        processInjectionBatchesLocked(now(), &nextWakeupTime);
+
         // Run a dispatch loop if there are no pending commands.
         // The dispatch loop might enqueue commands to run afterwards.
         if (!haveCommandsLocked()) {
             dispatchOnceInnerLocked(&nextWakeupTime);
+            updateInjectionBatchesLocked();
         }
 
         // Run all pending commands if there are any.
@@ -274,6 +386,11 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) {
         *nextWakeupTime = mAppSwitchDueTime;
     }
 
+    // Retry the events waiting in display lanes, independently of the main path.
+    if (!mDisplayLanes.isEmpty()) {
+        dispatchDisplayLanesLocked(currentTime, nextWakeupTime);
+    }
+
     // Ready to start a new event.
     // If we don't already have a pending event, go grab one.
     if (! mPendingEvent) {
@@ -304,6 +421,13 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) {
             // Inbound queue has at least one entry.
             mPendingEvent = mInboundQueue.dequeueAtHead();
             traceInboundQueueLengthLocked();
+
+            // Keep the events of a display with a lane in order behind the lane's.
+            if (enqueueDisplayLaneEventLocked(mPendingEvent)) {
+                mPendingEvent = NULL;
+                *nextWakeupTime = LONG_LONG_MIN;  // force next poll to wake up immediately
+                return;
+            }
         }
 
         // Poke user activity for this event.
@@ -397,7 +521,185 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) {
 
         releasePendingEventLocked();
         *nextWakeupTime = LONG_LONG_MIN;  // force next poll to wake up immediately
+    } else if (parkPendingEventLocked()) {
+        *nextWakeupTime = LONG_LONG_MIN;  // force next poll to wake up immediately
+    }
+}
+
+int32_t InputDispatcher::getFocusedDisplayIdLocked() {
+    if (mFocusedWindowHandle != NULL) {
+        const InputWindowInfo* info = mFocusedWindowHandle->getInfo();
+        if (info) {
+            return info->displayId;
+        }
+    }
+    return ADISPLAY_ID_DEFAULT;
+}
+
+bool InputDispatcher::parkPendingEventLocked() {
+    if (mPendingEvent->type != EventEntry::TYPE_MOTION) {
+        return false;
+    }
+    MotionEntry* motionEntry = static_cast<MotionEntry*>(mPendingEvent);
+    if (!(motionEntry->source & AINPUT_SOURCE_CLASS_POINTER)
+            || motionEntry->displayId == getFocusedDisplayIdLocked()
+            || mDisplayLanes.indexOfKey(motionEntry->displayId) >= 0) {
+        return false;
+    }
+
+#if DEBUG_FOCUS
+    ALOGD("Waiting for targets of display %d in a lane of its own.", motionEntry->displayId);
+#endif
+    DisplayLane* lane = new DisplayLane();
+    lane->pendingEvent = mPendingEvent;
+    swapInputTargetWaitLocked(lane);
+    mDisplayLanes.add(motionEntry->displayId, lane);
+
+    mPendingEvent = NULL;
+    resetANRTimeoutsLocked();
+    return true;
+}
+
+bool InputDispatcher::enqueueDisplayLaneEventLocked(EventEntry* entry) {
+    if (mDisplayLanes.isEmpty() || entry->type != EventEntry::TYPE_MOTION) {
+        return false;
+    }
+    MotionEntry* motionEntry = static_cast<MotionEntry*>(entry);
+    if (!(motionEntry->source & AINPUT_SOURCE_CLASS_POINTER)) {
+        return false;
+    }
+    ssize_t laneIndex = mDisplayLanes.indexOfKey(motionEntry->displayId);
+    if (laneIndex < 0) {
+        return false;
+    }
+
+    // The main path no longer waits for this event.
+    if (entry == mNextUnblockedEvent) {
+        mNextUnblockedEvent = NULL;
+    }
+    mDisplayLanes.valueAt(laneIndex)->queue.enqueueAtTail(entry);
+    return true;
+}
+
+void InputDispatcher::dispatchDisplayLanesLocked(nsecs_t currentTime, nsecs_t* nextWakeupTime) {
+    size_t i = 0;
+    while (i < mDisplayLanes.size()) {
+        DisplayLane* lane = mDisplayLanes.valueAt(i);
+        MotionEntry* entry = static_cast<MotionEntry*>(lane->pendingEvent);
+        if (entry == mNextUnblockedEvent) {
+            mNextUnblockedEvent = NULL;
+        }
+
+        DropReason dropReason = DROP_REASON_NOT_DROPPED;
+        if (!(entry->policyFlags & POLICY_FLAG_PASS_TO_USER)) {
+            dropReason = DROP_REASON_POLICY;
+        } else if (!mDispatchEnabled) {
+            dropReason = DROP_REASON_DISABLED;
+        } else if (isStaleEventLocked(currentTime, entry)) {
+            dropReason = DROP_REASON_STALE;
+        }
+
+        mDispatchingLaneDisplayId = mDisplayLanes.keyAt(i);
+        swapInputTargetWaitLocked(lane);
+        bool done = dispatchMotionLocked(currentTime, entry, &dropReason, nextWakeupTime);
+        if (done && dropReason != DROP_REASON_NOT_DROPPED) {
+            dropInboundEventLocked(entry, dropReason);
+        }
+        swapInputTargetWaitLocked(lane);
+        mDispatchingLaneDisplayId = ADISPLAY_ID_NONE;
+
+        if (!done) {
+            i += 1;
+            continue;
+        }
+
+        releaseInboundEventLocked(entry);
+        *nextWakeupTime = LONG_LONG_MIN;  // force next poll to wake up immediately
+        if (lane->queue.isEmpty()) {
+            // The display has caught up, its events go through the main path again.
+            delete lane;
+            mDisplayLanes.removeItemsAt(i);
+            continue;
+        }
+
+        lane->pendingEvent = lane->queue.dequeueAtHead();
+        lane->inputTargetWaitCause = INPUT_TARGET_WAIT_CAUSE_NONE;
+        lane->inputTargetWaitApplicationHandle.clear();
+        if (lane->pendingEvent->policyFlags & POLICY_FLAG_PASS_TO_USER) {
+            pokeUserActivityLocked(lane->pendingEvent);
+        }
+        i += 1;
+    }
+}
+
+void InputDispatcher::swapInputTargetWaitLocked(DisplayLane* lane) {
+    InputTargetWaitCause cause = mInputTargetWaitCause;
+    mInputTargetWaitCause = lane->inputTargetWaitCause;
+    lane->inputTargetWaitCause = cause;
+
+    nsecs_t startTime = mInputTargetWaitStartTime;
+    mInputTargetWaitStartTime = lane->inputTargetWaitStartTime;
+    lane->inputTargetWaitStartTime = startTime;
+
+    nsecs_t timeoutTime = mInputTargetWaitTimeoutTime;
+    mInputTargetWaitTimeoutTime = lane->inputTargetWaitTimeoutTime;
+    lane->inputTargetWaitTimeoutTime = timeoutTime;
+
+    bool timeoutExpired = mInputTargetWaitTimeoutExpired;
+    mInputTargetWaitTimeoutExpired = lane->inputTargetWaitTimeoutExpired;
+    lane->inputTargetWaitTimeoutExpired = timeoutExpired;
+
+    sp<InputApplicationHandle> applicationHandle = mInputTargetWaitApplicationHandle;
+    mInputTargetWaitApplicationHandle = lane->inputTargetWaitApplicationHandle;
+    lane->inputTargetWaitApplicationHandle = applicationHandle;
+}
+
+void InputDispatcher::drainDisplayLanesLocked() {
+    for (size_t i = 0; i < mDisplayLanes.size(); i++) {
+        DisplayLane* lane = mDisplayLanes.valueAt(i);
+        releaseInboundEventLocked(lane->pendingEvent);
+        while (!lane->queue.isEmpty()) {
+            releaseInboundEventLocked(lane->queue.dequeueAtHead());
+        }
+        delete lane;
+    }
+    mDisplayLanes.clear();
+}
+
+void InputDispatcher::enqueueInboundEventFromReader(EventEntry* entry) {
+    const int32_t head = mInboundRingHead;
+    if (head - android_atomic_acquire_load(&mInboundRingTail) >= INBOUND_RING_SIZE) {
+        // The dispatcher is falling behind, hand the events over directly.
+        bool needWake;
+        { // acquire lock
+            AutoMutex _l(mLock);
+            needWake = drainInboundRingLocked();
+            needWake |= enqueueInboundEventLocked(entry);
+        } // release lock
+
+        if (needWake) {
+            mLooper->wake();
+        }
+        return;
+    }
+
+    mInboundRing[head & (INBOUND_RING_SIZE - 1)] = entry;
+    android_atomic_release_store(head + 1, &mInboundRingHead);
+    if (android_atomic_cmpxchg(0, 1, &mInboundRingWakePending) == 0) {
+        mLooper->wake();
+    }
+}
+
+bool InputDispatcher::drainInboundRingLocked() {
+    const int32_t head = android_atomic_acquire_load(&mInboundRingHead);
+    int32_t tail = mInboundRingTail;
+    bool needWake = false;
+    while (tail != head) {
+        EventEntry* entry = mInboundRing[tail & (INBOUND_RING_SIZE - 1)];
+        android_atomic_release_store(++tail, &mInboundRingTail);
+        needWake |= enqueueInboundEventLocked(entry);
     }
+    return needWake;
 }
 
 bool InputDispatcher::enqueueInboundEventLocked(EventEntry* entry) {
@@ -470,10 +772,16 @@ void InputDispatcher::addRecentEventLocked(EventEntry* entry) {
 
 sp<InputWindowHandle> InputDispatcher::findTouchedWindowAtLocked(int32_t displayId,
         int32_t x, int32_t y) {
+    const WindowGrid* grid = getWindowGridLocked(displayId);
+    if (!grid) {
+        return NULL;
+    }
+
     // Traverse windows from front to back to find touched window.
-    size_t numWindows = mWindowHandles.size();
+    const Vector<size_t>& candidates = grid->getTouchCandidates(x, y);
+    size_t numWindows = candidates.size();
     for (size_t i = 0; i < numWindows; i++) {
-        sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(i);
+        sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(candidates[i]);
         const InputWindowInfo* windowInfo = windowHandle->getInfo();
         if (windowInfo->displayId == displayId) {
             int32_t flags = windowInfo->layoutParamsFlags;
@@ -1194,9 +1502,11 @@ int32_t InputDispatcher::findTouchedWindowTargetsLocked(nsecs_t currentTime,
         bool isTouchModal = false;
 
         // Traverse windows from front to back to find touched window and outside targets.
-        size_t numWindows = mWindowHandles.size();
+        const WindowGrid* grid = getWindowGridLocked(displayId);
+        const Vector<size_t>* candidates = grid ? &grid->getTouchCandidates(x, y) : NULL;
+        size_t numWindows = candidates ? candidates->size() : 0;
         for (size_t i = 0; i < numWindows; i++) {
-            sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(i);
+            sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(candidates->itemAt(i));
             const InputWindowInfo* windowInfo = windowHandle->getInfo();
             if (windowInfo->displayId != displayId) {
                 continue; // wrong display
@@ -1625,12 +1935,19 @@ bool InputDispatcher::checkInjectionPermission(const sp<InputWindowHandle>& wind
 bool InputDispatcher::isWindowObscuredAtPointLocked(
         const sp<InputWindowHandle>& windowHandle, int32_t x, int32_t y) const {
     int32_t displayId = windowHandle->getInfo()->displayId;
-    size_t numWindows = mWindowHandles.size();
-    for (size_t i = 0; i < numWindows; i++) {
-        sp<InputWindowHandle> otherHandle = mWindowHandles.itemAt(i);
-        if (otherHandle == windowHandle) {
-            break;
-        }
+    const WindowGrid* grid = getWindowGridLocked(displayId);
+    if (!grid) {
+        return false;
+    }
+
+    // Only the windows in front of this one can obscure it.
+    ssize_t windowIndex = mWindowHandleIndices.indexOfKey(windowHandle.get());
+    size_t limit = windowIndex >= 0
+            ? mWindowHandleIndices.valueAt(windowIndex) : mWindowHandles.size();
+    const Vector<size_t>& candidates = grid->getObscuringCandidates(x, y);
+    size_t numWindows = candidates.size();
+    for (size_t i = 0; i < numWindows && candidates[i] < limit; i++) {
+        sp<InputWindowHandle> otherHandle = mWindowHandles.itemAt(candidates[i]);
 
         const InputWindowInfo* otherInfo = otherHandle->getInfo();
         if (otherInfo->displayId == displayId
@@ -1834,17 +2151,17 @@ void InputDispatcher::enqueueDispatchEntriesLocked(nsecs_t currentTime,
     bool wasEmpty = connection->outboundQueue.isEmpty();
 
     // Enqueue dispatch entries for the requested modes.
-    enqueueDispatchEntryLocked(connection, eventEntry, inputTarget,
+    enqueueDispatchEntryLocked(currentTime, connection, eventEntry, inputTarget,
             InputTarget::FLAG_DISPATCH_AS_HOVER_EXIT);
-    enqueueDispatchEntryLocked(connection, eventEntry, inputTarget,
+    enqueueDispatchEntryLocked(currentTime, connection, eventEntry, inputTarget,
             InputTarget::FLAG_DISPATCH_AS_OUTSIDE);
-    enqueueDispatchEntryLocked(connection, eventEntry, inputTarget,
+    enqueueDispatchEntryLocked(currentTime, connection, eventEntry, inputTarget,
             InputTarget::FLAG_DISPATCH_AS_HOVER_ENTER);
-    enqueueDispatchEntryLocked(connection, eventEntry, inputTarget,
+    enqueueDispatchEntryLocked(currentTime, connection, eventEntry, inputTarget,
             InputTarget::FLAG_DISPATCH_AS_IS);
-    enqueueDispatchEntryLocked(connection, eventEntry, inputTarget,
+    enqueueDispatchEntryLocked(currentTime, connection, eventEntry, inputTarget,
             InputTarget::FLAG_DISPATCH_AS_SLIPPERY_EXIT);
-    enqueueDispatchEntryLocked(connection, eventEntry, inputTarget,
+    enqueueDispatchEntryLocked(currentTime, connection, eventEntry, inputTarget,
             InputTarget::FLAG_DISPATCH_AS_SLIPPERY_ENTER);
 
     // If the outbound queue was previously empty, start the dispatch cycle going.
@@ -1853,7 +2170,7 @@ void InputDispatcher::enqueueDispatchEntriesLocked(nsecs_t currentTime,
     }
 }
 
-void InputDispatcher::enqueueDispatchEntryLocked(
+void InputDispatcher::enqueueDispatchEntryLocked(nsecs_t currentTime,
         const sp<Connection>& connection, EventEntry* eventEntry, const InputTarget* inputTarget,
         int32_t dispatchMode) {
     int32_t inputTargetFlags = inputTarget->flags;
@@ -1867,6 +2184,7 @@ void InputDispatcher::enqueueDispatchEntryLocked(
     DispatchEntry* dispatchEntry = new DispatchEntry(eventEntry, // increments ref
             inputTargetFlags, inputTarget->xOffset, inputTarget->yOffset,
             inputTarget->scaleFactor);
+    dispatchEntry->enqueueTime = currentTime;
 
     // Apply target flags and update the connection's input state.
     switch (eventEntry->type) {
@@ -1926,6 +2244,14 @@ void InputDispatcher::enqueueDispatchEntryLocked(
             delete dispatchEntry;
             return; // skip the inconsistent event
         }
+
+        // Don't let a lagging monitor fall further behind: the sample still waiting to be
+        // published is superseded by this one.
+        if (dispatchEntry->resolvedAction == AMOTION_EVENT_ACTION_MOVE
+                && connection->monitor && connection->isLagging()
+                && dropPendingMoveLocked(connection, dispatchEntry)) {
+            connection->droppedMoveCount += 1;
+        }
         break;
     }
     }
@@ -1940,6 +2266,42 @@ void InputDispatcher::enqueueDispatchEntryLocked(
     traceOutboundQueueLengthLocked(connection);
 }
 
+bool InputDispatcher::dropPendingMoveLocked(const sp<Connection>& connection,
+        const DispatchEntry* entry) {
+    DispatchEntry* pendingEntry = connection->outboundQueue.tail;
+    if (!pendingEntry || pendingEntry->eventEntry->type != EventEntry::TYPE_MOTION
+            || pendingEntry->resolvedAction != AMOTION_EVENT_ACTION_MOVE
+            || pendingEntry->resolvedFlags != entry->resolvedFlags
+            || pendingEntry->targetFlags != entry->targetFlags) {
+        return false;
+    }
+
+    const MotionEntry* pendingMotionEntry =
+            static_cast<const MotionEntry*>(pendingEntry->eventEntry);
+    const MotionEntry* motionEntry = static_cast<const MotionEntry*>(entry->eventEntry);
+    if (pendingMotionEntry->deviceId != motionEntry->deviceId
+            || pendingMotionEntry->source != motionEntry->source
+            || pendingMotionEntry->displayId != motionEntry->displayId
+            || pendingMotionEntry->pointerCount != motionEntry->pointerCount) {
+        return false;
+    }
+    for (uint32_t i = 0; i < motionEntry->pointerCount; i++) {
+        if (pendingMotionEntry->pointerProperties[i].id
+                != motionEntry->pointerProperties[i].id) {
+            return false;
+        }
+    }
+
+#if DEBUG_DISPATCH_CYCLE
+    ALOGD("channel '%s' ~ dropping pending motion sample because the connection is lagging",
+            connection->getInputChannelName());
+#endif
+    connection->outboundQueue.dequeue(pendingEntry);
+    traceOutboundQueueLengthLocked(connection);
+    releaseDispatchEntryLocked(pendingEntry);
+    return true;
+}
+
 void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
         const sp<Connection>& connection) {
 #if DEBUG_DISPATCH_CYCLE
@@ -1949,76 +2311,38 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
 
     while (connection->status == Connection::STATUS_NORMAL
             && !connection->outboundQueue.isEmpty()) {
-        DispatchEntry* dispatchEntry = connection->outboundQueue.head;
-        dispatchEntry->deliveryTime = currentTime;
-
-        // Publish the event.
-        status_t status;
-        EventEntry* eventEntry = dispatchEntry->eventEntry;
-        switch (eventEntry->type) {
-        case EventEntry::TYPE_KEY: {
-            KeyEntry* keyEntry = static_cast<KeyEntry*>(eventEntry);
-
-            // Publish the key event.
-            status = connection->inputPublisher.publishKeyEvent(dispatchEntry->seq,
-                    keyEntry->deviceId, keyEntry->source,
-                    dispatchEntry->resolvedAction, dispatchEntry->resolvedFlags,
-                    keyEntry->keyCode, keyEntry->scanCode,
-                    keyEntry->metaState, keyEntry->repeatCount, keyEntry->downTime,
-                    keyEntry->eventTime);
-            break;
-        }
-
-        case EventEntry::TYPE_MOTION: {
-            MotionEntry* motionEntry = static_cast<MotionEntry*>(eventEntry);
-
-            PointerCoords scaledCoords[MAX_POINTERS];
-            const PointerCoords* usingCoords = motionEntry->pointerCoords;
-
-            // Set the X and Y offset depending on the input source.
-            float xOffset, yOffset, scaleFactor;
-            if ((motionEntry->source & AINPUT_SOURCE_CLASS_POINTER)
-                    && !(dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS)) {
-                scaleFactor = dispatchEntry->scaleFactor;
-                xOffset = dispatchEntry->xOffset * scaleFactor;
-                yOffset = dispatchEntry->yOffset * scaleFactor;
-                if (scaleFactor != 1.0f) {
-                    for (uint32_t i = 0; i < motionEntry->pointerCount; i++) {
-                        scaledCoords[i] = motionEntry->pointerCoords[i];
-                        scaledCoords[i].scale(scaleFactor);
-                    }
-                    usingCoords = scaledCoords;
-                }
-            } else {
-                xOffset = 0.0f;
-                yOffset = 0.0f;
-                scaleFactor = 1.0f;
-
-                // We don't want the dispatch target to know.
-                if (dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS) {
-                    for (uint32_t i = 0; i < motionEntry->pointerCount; i++) {
-                        scaledCoords[i].clear();
-                    }
-                    usingCoords = scaledCoords;
-                }
+        // Publish as many of the pending events as possible at once.
+        status_t status = OK;
+        size_t batchSize = 0;
+        connection->inputPublisher.beginBatch();
+        for (DispatchEntry* dispatchEntry = connection->outboundQueue.head;
+                dispatchEntry && batchSize < InputPublisher::MAX_BATCH_SIZE;
+                dispatchEntry = dispatchEntry->next) {
+            dispatchEntry->deliveryTime = currentTime;
+            status = publishDispatchEntryLocked(connection, dispatchEntry);
+            if (status) {
+                break;
             }
+            batchSize += 1;
+        }
 
-            // Publish the motion event.
-            status = connection->inputPublisher.publishMotionEvent(dispatchEntry->seq,
-                    motionEntry->deviceId, motionEntry->source,
-                    dispatchEntry->resolvedAction, dispatchEntry->resolvedFlags,
-                    motionEntry->edgeFlags, motionEntry->metaState, motionEntry->buttonState,
-                    xOffset, yOffset,
-                    motionEntry->xPrecision, motionEntry->yPrecision,
-                    motionEntry->downTime, motionEntry->eventTime,
-                    motionEntry->pointerCount, motionEntry->pointerProperties,
-                    usingCoords);
-            break;
+        size_t publishedCount;
+        status_t batchStatus = connection->inputPublisher.endBatch(&publishedCount);
+        if (batchStatus) {
+            // This event comes before the one that couldn't be queued, if any.
+            status = batchStatus;
         }
 
-        default:
-            ALOG_ASSERT(false);
-            return;
+        // Re-enqueue the published events on the wait queue.
+        for (size_t i = 0; i < publishedCount; i++) {
+            DispatchEntry* dispatchEntry = connection->outboundQueue.head;
+            connection->publishLatency.add(currentTime - dispatchEntry->enqueueTime);
+            connection->outboundQueue.dequeue(dispatchEntry);
+            connection->waitQueue.enqueueAtTail(dispatchEntry);
+        }
+        if (publishedCount) {
+            traceOutboundQueueLengthLocked(connection);
+            traceWaitQueueLengthLocked(connection);
         }
 
         // Check the result.
@@ -2047,12 +2371,74 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
             }
             return;
         }
+    }
+}
+
+status_t InputDispatcher::publishDispatchEntryLocked(const sp<Connection>& connection,
+        DispatchEntry* dispatchEntry) {
+    EventEntry* eventEntry = dispatchEntry->eventEntry;
+    switch (eventEntry->type) {
+    case EventEntry::TYPE_KEY: {
+        KeyEntry* keyEntry = static_cast<KeyEntry*>(eventEntry);
+
+        // Publish the key event.
+        return connection->inputPublisher.publishKeyEvent(dispatchEntry->seq,
+                keyEntry->deviceId, keyEntry->source,
+                dispatchEntry->resolvedAction, dispatchEntry->resolvedFlags,
+                keyEntry->keyCode, keyEntry->scanCode,
+                keyEntry->metaState, keyEntry->repeatCount, keyEntry->downTime,
+                keyEntry->eventTime);
+    }
+
+    case EventEntry::TYPE_MOTION: {
+        MotionEntry* motionEntry = static_cast<MotionEntry*>(eventEntry);
+
+        PointerCoords scaledCoords[MAX_POINTERS];
+        const PointerCoords* usingCoords = motionEntry->pointerCoords;
+
+        // Set the X and Y offset depending on the input source.
+        float xOffset, yOffset, scaleFactor;
+        if ((motionEntry->source & AINPUT_SOURCE_CLASS_POINTER)
+                && !(dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS)) {
+            scaleFactor = dispatchEntry->scaleFactor;
+            xOffset = dispatchEntry->xOffset * scaleFactor;
+            yOffset = dispatchEntry->yOffset * scaleFactor;
+            if (scaleFactor != 1.0f) {
+                for (uint32_t i = 0; i < motionEntry->pointerCount; i++) {
+                    scaledCoords[i] = motionEntry->pointerCoords[i];
+                    scaledCoords[i].scale(scaleFactor);
+                }
+                usingCoords = scaledCoords;
+            }
+        } else {
+            xOffset = 0.0f;
+            yOffset = 0.0f;
+            scaleFactor = 1.0f;
+
+            // We don't want the dispatch target to know.
+            if (dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS) {
+                for (uint32_t i = 0; i < motionEntry->pointerCount; i++) {
+                    scaledCoords[i].clear();
+                }
+                usingCoords = scaledCoords;
+            }
+        }
+
+        // Publish the motion event.
+        return connection->inputPublisher.publishMotionEvent(dispatchEntry->seq,
+                motionEntry->deviceId, motionEntry->source,
+                dispatchEntry->resolvedAction, dispatchEntry->resolvedFlags,
+                motionEntry->edgeFlags, motionEntry->metaState, motionEntry->buttonState,
+                xOffset, yOffset,
+                motionEntry->xPrecision, motionEntry->yPrecision,
+                motionEntry->downTime, motionEntry->eventTime,
+                motionEntry->pointerCount, motionEntry->pointerProperties,
+                usingCoords);
+    }
 
-        // Re-enqueue the event on the wait queue.
-        connection->outboundQueue.dequeue(dispatchEntry);
-        traceOutboundQueueLengthLocked(connection);
-        connection->waitQueue.enqueueAtTail(dispatchEntry);
-        traceWaitQueueLengthLocked(connection);
+    default:
+        ALOG_ASSERT(false);
+        return BAD_VALUE;
     }
 }
 
@@ -2241,7 +2627,8 @@ void InputDispatcher::synthesizeCancelationEventsForConnectionLocked(
             target.inputChannel = connection->inputChannel;
             target.flags = InputTarget::FLAG_DISPATCH_AS_IS;
 
-            enqueueDispatchEntryLocked(connection, cancelationEventEntry, // increments ref
+            enqueueDispatchEntryLocked(currentTime, connection,
+                    cancelationEventEntry, // increments ref
                     &target, InputTarget::FLAG_DISPATCH_AS_IS);
 
             cancelationEventEntry->release();
@@ -2346,17 +2733,8 @@ void InputDispatcher::notifyConfigurationChanged(const NotifyConfigurationChange
     ALOGD("notifyConfigurationChanged - eventTime=%lld", args->eventTime);
 #endif
 
-    bool needWake;
-    { // acquire lock
-        AutoMutex _l(mLock);
-
-        ConfigurationChangedEntry* newEntry = new ConfigurationChangedEntry(args->eventTime);
-        needWake = enqueueInboundEventLocked(newEntry);
-    } // release lock
-
-    if (needWake) {
-        mLooper->wake();
-    }
+    ConfigurationChangedEntry* newEntry = new ConfigurationChangedEntry(args->eventTime);
+    enqueueInboundEventFromReader(newEntry);
 }
 
 void InputDispatcher::notifyKey(const NotifyKeyArgs* args) {
@@ -2420,38 +2798,23 @@ void InputDispatcher::notifyKey(const NotifyKeyArgs* args) {
 
     mPolicy->interceptKeyBeforeQueueing(&event, /*byref*/ policyFlags);
 
-    bool needWake;
-    { // acquire lock
-        mLock.lock();
-
-        if (shouldSendKeyToInputFilterLocked(args)) {
-            mLock.unlock();
-
-            policyFlags |= POLICY_FLAG_FILTERED;
-            if (!mPolicy->filterInputEvent(&event, policyFlags)) {
-                return; // event was consumed by the filter
-            }
-
-            mLock.lock();
+    if (shouldSendKeyToInputFilter(args)) {
+        policyFlags |= POLICY_FLAG_FILTERED;
+        if (!mPolicy->filterInputEvent(&event, policyFlags)) {
+            return; // event was consumed by the filter
         }
-
-        int32_t repeatCount = 0;
-        KeyEntry* newEntry = new KeyEntry(args->eventTime,
-                args->deviceId, args->source, policyFlags,
-                args->action, flags, keyCode, args->scanCode,
-                metaState, repeatCount, args->downTime);
-
-        needWake = enqueueInboundEventLocked(newEntry);
-        mLock.unlock();
-    } // release lock
-
-    if (needWake) {
-        mLooper->wake();
     }
+
+    int32_t repeatCount = 0;
+    KeyEntry* newEntry = new KeyEntry(args->eventTime,
+            args->deviceId, args->source, policyFlags,
+            args->action, flags, keyCode, args->scanCode,
+            metaState, repeatCount, args->downTime);
+    enqueueInboundEventFromReader(newEntry);
 }
 
-bool InputDispatcher::shouldSendKeyToInputFilterLocked(const NotifyKeyArgs* args) {
-    return mInputFilterEnabled;
+bool InputDispatcher::shouldSendKeyToInputFilter(const NotifyKeyArgs* args) {
+    return android_atomic_acquire_load(&mInputFilterEnabled);
 }
 
 void InputDispatcher::notifyMotion(const NotifyMotionArgs* args) {
@@ -2488,48 +2851,33 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs* args) {
     policyFlags |= POLICY_FLAG_TRUSTED;
     mPolicy->interceptMotionBeforeQueueing(args->eventTime, /*byref*/ policyFlags);
 
-    bool needWake;
-    { // acquire lock
-        mLock.lock();
-
-        if (shouldSendMotionToInputFilterLocked(args)) {
-            mLock.unlock();
-
-            MotionEvent event;
-            event.initialize(args->deviceId, args->source, args->action, args->flags,
-                    args->edgeFlags, args->metaState, args->buttonState, 0, 0,
-                    args->xPrecision, args->yPrecision,
-                    args->downTime, args->eventTime,
-                    args->pointerCount, args->pointerProperties, args->pointerCoords);
+    if (shouldSendMotionToInputFilter(args)) {
+        MotionEvent event;
+        event.initialize(args->deviceId, args->source, args->action, args->flags,
+                args->edgeFlags, args->metaState, args->buttonState, 0, 0,
+                args->xPrecision, args->yPrecision,
+                args->downTime, args->eventTime,
+                args->pointerCount, args->pointerProperties, args->pointerCoords);
 
-            policyFlags |= POLICY_FLAG_FILTERED;
-            if (!mPolicy->filterInputEvent(&event, policyFlags)) {
-                return; // event was consumed by the filter
-            }
-
-            mLock.lock();
+        policyFlags |= POLICY_FLAG_FILTERED;
+        if (!mPolicy->filterInputEvent(&event, policyFlags)) {
+            return; // event was consumed by the filter
         }
-
-        // Just enqueue a new motion event.
-        MotionEntry* newEntry = new MotionEntry(args->eventTime,
-                args->deviceId, args->source, policyFlags,
-                args->action, args->flags, args->metaState, args->buttonState,
-                args->edgeFlags, args->xPrecision, args->yPrecision, args->downTime,
-                args->displayId,
-                args->pointerCount, args->pointerProperties, args->pointerCoords, 0, 0);
-
-        needWake = enqueueInboundEventLocked(newEntry);
-        mLock.unlock();
-    } // release lock
-
-    if (needWake) {
-        mLooper->wake();
     }
+
+    // Just enqueue a new motion event.
+    MotionEntry* newEntry = new MotionEntry(args->eventTime,
+            args->deviceId, args->source, policyFlags,
+            args->action, args->flags, args->metaState, args->buttonState,
+            args->edgeFlags, args->xPrecision, args->yPrecision, args->downTime,
+            args->displayId,
+            args->pointerCount, args->pointerProperties, args->pointerCoords, 0, 0);
+    enqueueInboundEventFromReader(newEntry);
 }
 
-bool InputDispatcher::shouldSendMotionToInputFilterLocked(const NotifyMotionArgs* args) {
+bool InputDispatcher::shouldSendMotionToInputFilter(const NotifyMotionArgs* args) {
     // TODO: support sending secondary display events to input filter
-    return mInputFilterEnabled && isMainDisplay(args->displayId);
+    return android_atomic_acquire_load(&mInputFilterEnabled) && isMainDisplay(args->displayId);
 }
 
 void InputDispatcher::notifySwitch(const NotifySwitchArgs* args) {
@@ -2551,17 +2899,8 @@ void InputDispatcher::notifyDeviceReset(const NotifyDeviceResetArgs* args) {
             args->eventTime, args->deviceId);
 #endif
 
-    bool needWake;
-    { // acquire lock
-        AutoMutex _l(mLock);
-
-        DeviceResetEntry* newEntry = new DeviceResetEntry(args->eventTime, args->deviceId);
-        needWake = enqueueInboundEventLocked(newEntry);
-    } // release lock
-
-    if (needWake) {
-        mLooper->wake();
-    }
+    DeviceResetEntry* newEntry = new DeviceResetEntry(args->eventTime, args->deviceId);
+    enqueueInboundEventFromReader(newEntry);
 }
 
 int32_t InputDispatcher::injectInputEvent(const InputEvent* event, int32_t displayId,
@@ -2582,90 +2921,20 @@ int32_t InputDispatcher::injectInputEvent(const InputEvent* event, int32_t displ
 
     EventEntry* firstInjectedEntry;
     EventEntry* lastInjectedEntry;
-    switch (event->getType()) {
-    case AINPUT_EVENT_TYPE_KEY: {
-        const KeyEvent* keyEvent = static_cast<const KeyEvent*>(event);
-        int32_t action = keyEvent->getAction();
-        if (! validateKeyEvent(action)) {
-            return INPUT_EVENT_INJECTION_FAILED;
-        }
+    int32_t result = makeInjectedEntries(event, displayId, policyFlags, true,
+            &firstInjectedEntry, &lastInjectedEntry);
+    if (result != INPUT_EVENT_INJECTION_SUCCEEDED) {
+        return result;
+    }
 
-        int32_t flags = keyEvent->getFlags();
-        if (flags & AKEY_EVENT_FLAG_VIRTUAL_HARD_KEY) {
-            policyFlags |= POLICY_FLAG_VIRTUAL;
-        }
+    mLock.lock();
+    InjectionState* injectionState = new InjectionState(injectorPid, injectorUid);
+    if (syncMode == INPUT_EVENT_INJECTION_SYNC_NONE) {
+        injectionState->injectionIsAsync = true;
+    }
 
-        if (!(policyFlags & POLICY_FLAG_FILTERED)) {
-            mPolicy->interceptKeyBeforeQueueing(keyEvent, /*byref*/ policyFlags);
-        }
-
-        mLock.lock();
-        firstInjectedEntry = new KeyEntry(keyEvent->getEventTime(),
-                keyEvent->getDeviceId(), keyEvent->getSource(),
-                policyFlags, action, flags,
-                keyEvent->getKeyCode(), keyEvent->getScanCode(), keyEvent->getMetaState(),
-                keyEvent->getRepeatCount(), keyEvent->getDownTime());
-        lastInjectedEntry = firstInjectedEntry;
-        break;
-    }
-
-    case AINPUT_EVENT_TYPE_MOTION: {
-        const MotionEvent* motionEvent = static_cast<const MotionEvent*>(event);
-        int32_t action = motionEvent->getAction();
-        size_t pointerCount = motionEvent->getPointerCount();
-        const PointerProperties* pointerProperties = motionEvent->getPointerProperties();
-        if (! validateMotionEvent(action, pointerCount, pointerProperties)) {
-            return INPUT_EVENT_INJECTION_FAILED;
-        }
-
-        if (!(policyFlags & POLICY_FLAG_FILTERED)) {
-            nsecs_t eventTime = motionEvent->getEventTime();
-            mPolicy->interceptMotionBeforeQueueing(eventTime, /*byref*/ policyFlags);
-        }
-
-        mLock.lock();
-        const nsecs_t* sampleEventTimes = motionEvent->getSampleEventTimes();
-        const PointerCoords* samplePointerCoords = motionEvent->getSamplePointerCoords();
-        firstInjectedEntry = new MotionEntry(*sampleEventTimes,
-                motionEvent->getDeviceId(), motionEvent->getSource(), policyFlags,
-                action, motionEvent->getFlags(),
-                motionEvent->getMetaState(), motionEvent->getButtonState(),
-                motionEvent->getEdgeFlags(),
-                motionEvent->getXPrecision(), motionEvent->getYPrecision(),
-                motionEvent->getDownTime(), displayId,
-                uint32_t(pointerCount), pointerProperties, samplePointerCoords,
-                motionEvent->getXOffset(), motionEvent->getYOffset());
-        lastInjectedEntry = firstInjectedEntry;
-        for (size_t i = motionEvent->getHistorySize(); i > 0; i--) {
-            sampleEventTimes += 1;
-            samplePointerCoords += pointerCount;
-            MotionEntry* nextInjectedEntry = new MotionEntry(*sampleEventTimes,
-                    motionEvent->getDeviceId(), motionEvent->getSource(), policyFlags,
-                    action, motionEvent->getFlags(),
-                    motionEvent->getMetaState(), motionEvent->getButtonState(),
-                    motionEvent->getEdgeFlags(),
-                    motionEvent->getXPrecision(), motionEvent->getYPrecision(),
-                    motionEvent->getDownTime(), displayId,
-                    uint32_t(pointerCount), pointerProperties, samplePointerCoords,
-                    motionEvent->getXOffset(), motionEvent->getYOffset());
-            lastInjectedEntry->next = nextInjectedEntry;
-            lastInjectedEntry = nextInjectedEntry;
-        }
-        break;
-    }
-
-    default:
-        ALOGW("Cannot inject event of type %d", event->getType());
-        return INPUT_EVENT_INJECTION_FAILED;
-    }
-
-    InjectionState* injectionState = new InjectionState(injectorPid, injectorUid);
-    if (syncMode == INPUT_EVENT_INJECTION_SYNC_NONE) {
-        injectionState->injectionIsAsync = true;
-    }
-
-    injectionState->refCount += 1;
-    lastInjectedEntry->injectionState = injectionState;
+    injectionState->refCount += 1;
+    lastInjectedEntry->injectionState = injectionState;
 
     bool needWake = false;
     for (EventEntry* entry = firstInjectedEntry; entry != NULL; ) {
@@ -2740,6 +3009,158 @@ int32_t InputDispatcher::injectInputEvent(const InputEvent* event, int32_t displ
     return injectionResult;
 }
 
+int32_t InputDispatcher::makeInjectedEntries(const InputEvent* event, int32_t displayId,
+        uint32_t policyFlags, bool intercept,
+        EventEntry** outFirstEntry, EventEntry** outLastEntry) {
+    switch (event->getType()) {
+    case AINPUT_EVENT_TYPE_KEY: {
+        const KeyEvent* keyEvent = static_cast<const KeyEvent*>(event);
+        int32_t action = keyEvent->getAction();
+        if (! validateKeyEvent(action)) {
+            return INPUT_EVENT_INJECTION_FAILED;
+        }
+
+        int32_t flags = keyEvent->getFlags();
+        if (flags & AKEY_EVENT_FLAG_VIRTUAL_HARD_KEY) {
+            policyFlags |= POLICY_FLAG_VIRTUAL;
+        }
+
+        if (intercept && !(policyFlags & POLICY_FLAG_FILTERED)) {
+            mPolicy->interceptKeyBeforeQueueing(keyEvent, /*byref*/ policyFlags);
+        }
+
+        *outFirstEntry = new KeyEntry(keyEvent->getEventTime(),
+                keyEvent->getDeviceId(), keyEvent->getSource(),
+                policyFlags, action, flags,
+                keyEvent->getKeyCode(), keyEvent->getScanCode(), keyEvent->getMetaState(),
+                keyEvent->getRepeatCount(), keyEvent->getDownTime());
+        *outLastEntry = *outFirstEntry;
+        return INPUT_EVENT_INJECTION_SUCCEEDED;
+    }
+
+    case AINPUT_EVENT_TYPE_MOTION: {
+        const MotionEvent* motionEvent = static_cast<const MotionEvent*>(event);
+        int32_t action = motionEvent->getAction();
+        size_t pointerCount = motionEvent->getPointerCount();
+        const PointerProperties* pointerProperties = motionEvent->getPointerProperties();
+        if (! validateMotionEvent(action, pointerCount, pointerProperties)) {
+            return INPUT_EVENT_INJECTION_FAILED;
+        }
+
+        if (intercept && !(policyFlags & POLICY_FLAG_FILTERED)) {
+            nsecs_t eventTime = motionEvent->getEventTime();
+            mPolicy->interceptMotionBeforeQueueing(eventTime, /*byref*/ policyFlags);
+        }
+
+        const nsecs_t* sampleEventTimes = motionEvent->getSampleEventTimes();
+        const PointerCoords* samplePointerCoords = motionEvent->getSamplePointerCoords();
+        *outFirstEntry = new MotionEntry(*sampleEventTimes,
+                motionEvent->getDeviceId(), motionEvent->getSource(), policyFlags,
+                action, motionEvent->getFlags(),
+                motionEvent->getMetaState(), motionEvent->getButtonState(),
+                motionEvent->getEdgeFlags(),
+                motionEvent->getXPrecision(), motionEvent->getYPrecision(),
+                motionEvent->getDownTime(), displayId,
+                uint32_t(pointerCount), pointerProperties, samplePointerCoords,
+                motionEvent->getXOffset(), motionEvent->getYOffset());
+        *outLastEntry = *outFirstEntry;
+        for (size_t i = motionEvent->getHistorySize(); i > 0; i--) {
+            sampleEventTimes += 1;
+            samplePointerCoords += pointerCount;
+            MotionEntry* nextInjectedEntry = new MotionEntry(*sampleEventTimes,
+                    motionEvent->getDeviceId(), motionEvent->getSource(), policyFlags,
+                    action, motionEvent->getFlags(),
+                    motionEvent->getMetaState(), motionEvent->getButtonState(),
+                    motionEvent->getEdgeFlags(),
+                    motionEvent->getXPrecision(), motionEvent->getYPrecision(),
+                    motionEvent->getDownTime(), displayId,
+                    uint32_t(pointerCount), pointerProperties, samplePointerCoords,
+                    motionEvent->getXOffset(), motionEvent->getYOffset());
+            (*outLastEntry)->next = nextInjectedEntry;
+            *outLastEntry = nextInjectedEntry;
+        }
+        return INPUT_EVENT_INJECTION_SUCCEEDED;
+    }
+
+    default:
+        ALOGW("Cannot inject event of type %d", event->getType());
+        return INPUT_EVENT_INJECTION_FAILED;
+    }
+}
+
+int32_t InputDispatcher::injectInputEvents(const Vector<const InputEvent*>& events,
+        int32_t displayId, int32_t injectorPid, int32_t injectorUid, int32_t timeoutMillis,
+        uint32_t policyFlags, const sp<InputInjectionCallback>& callback) {
+#if DEBUG_INBOUND_EVENT_DETAILS
+    ALOGD("injectInputEvents - eventCount=%zu, injectorPid=%d, injectorUid=%d, "
+            "timeoutMillis=%d, policyFlags=0x%08x",
+            events.size(), injectorPid, injectorUid, timeoutMillis, policyFlags);
+#endif
+
+    if (events.isEmpty()) {
+        return INPUT_EVENT_INJECTION_FAILED;
+    }
+
+    policyFlags |= POLICY_FLAG_INJECTED;
+    if (hasInjectionPermission(injectorPid, injectorUid)) {
+        policyFlags |= POLICY_FLAG_TRUSTED;
+    }
+
+    // The entries of all the events, in order.  As with injectInputEvent, only the last
+    // entry of each event gets an injection state.  The policy intercepts each entry once
+    // it is due rather than now, so that what it does happens at the event's time.
+    Queue<EventEntry> injectedEntries;
+    Vector<EventEntry*> lastInjectedEntries;
+    nsecs_t lastEventTime = LONG_LONG_MIN;
+    for (size_t i = 0; i < events.size(); i++) {
+        EventEntry* firstInjectedEntry;
+        EventEntry* lastInjectedEntry;
+        if (makeInjectedEntries(events[i], displayId, policyFlags, false,
+                &firstInjectedEntry, &lastInjectedEntry) != INPUT_EVENT_INJECTION_SUCCEEDED) {
+            while (!injectedEntries.isEmpty()) {
+                injectedEntries.dequeueAtHead()->release();
+            }
+            return INPUT_EVENT_INJECTION_FAILED;
+        }
+        for (EventEntry* entry = firstInjectedEntry; entry != NULL; ) {
+            EventEntry* nextEntry = entry->next;
+            injectedEntries.enqueueAtTail(entry);
+            entry = nextEntry;
+        }
+        lastInjectedEntries.push(lastInjectedEntry);
+        if (lastInjectedEntry->eventTime > lastEventTime) {
+            lastEventTime = lastInjectedEntry->eventTime;
+        }
+    }
+
+    { // acquire lock
+        AutoMutex _l(mLock);
+
+        nsecs_t timeoutTime = now();
+        if (lastEventTime > timeoutTime) {
+            timeoutTime = lastEventTime;
+        }
+        timeoutTime += milliseconds_to_nanoseconds(timeoutMillis);
+        InjectionBatch* batch = new InjectionBatch(callback, timeoutTime,
+                int32_t(lastInjectedEntries.size()));
+        for (size_t i = 0; i < lastInjectedEntries.size(); i++) {
+            InjectionState* injectionState = new InjectionState(injectorPid, injectorUid);
+            batch->refCount += 1;
+            injectionState->batch = batch;
+            lastInjectedEntries[i]->injectionState = injectionState;
+        }
+        mInjectionBatches.push(batch);
+
+        while (!injectedEntries.isEmpty()) {
+            mScheduledInjectionQueue.enqueueAtTail(injectedEntries.dequeueAtHead());
+        }
+    } // release lock
+
+    // The dispatcher has to pick its next wakeup time again.
+    mLooper->wake();
+    return INPUT_EVENT_INJECTION_PENDING;
+}
+
 bool InputDispatcher::hasInjectionPermission(int32_t injectorPid, int32_t injectorUid) {
     return injectorUid == 0
             || mPolicy->checkInjectEventsPermissionNonReentrant(injectorPid, injectorUid);
@@ -2773,8 +3194,24 @@ void InputDispatcher::setInjectionResultLocked(EventEntry* entry, int32_t inject
             }
         }
 
+        const bool wasPending = injectionState->injectionResult
+                == INPUT_EVENT_INJECTION_PENDING;
         injectionState->injectionResult = injectionResult;
         mInjectionResultAvailableCondition.broadcast();
+
+        InjectionBatch* batch = injectionState->batch;
+        if (batch && wasPending) {
+            batch->pendingResults -= 1;
+            if (injectionResult == INPUT_EVENT_INJECTION_SUCCEEDED) {
+                batch->injectedCount += 1;
+            } else if (batch->injectionResult == INPUT_EVENT_INJECTION_SUCCEEDED) {
+                batch->injectionResult = injectionResult;
+            }
+            // The result of a dispatched event is set before its foreground dispatches
+            // are counted, so a success can't complete the batch here; see
+            // updateInjectionBatchesLocked().
+            updateInjectionBatchLocked(batch, false);
+        }
     }
 }
 
@@ -2782,6 +3219,9 @@ void InputDispatcher::incrementPendingForegroundDispatchesLocked(EventEntry* ent
     InjectionState* injectionState = entry->injectionState;
     if (injectionState) {
         injectionState->pendingForegroundDispatches += 1;
+        if (injectionState->batch) {
+            injectionState->batch->pendingForegroundDispatches += 1;
+        }
     }
 }
 
@@ -2793,9 +3233,86 @@ void InputDispatcher::decrementPendingForegroundDispatchesLocked(EventEntry* ent
         if (injectionState->pendingForegroundDispatches == 0) {
             mInjectionSyncFinishedCondition.broadcast();
         }
+
+        InjectionBatch* batch = injectionState->batch;
+        if (batch) {
+            batch->pendingForegroundDispatches -= 1;
+            updateInjectionBatchLocked(batch, false);
+        }
     }
 }
 
+void InputDispatcher::processInjectionBatchesLocked(nsecs_t currentTime,
+        nsecs_t* nextWakeupTime) {
+    while (!mScheduledInjectionQueue.isEmpty()) {
+        EventEntry* entry = mScheduledInjectionQueue.head;
+        if (entry->eventTime > currentTime) {
+            if (entry->eventTime < *nextWakeupTime) {
+                *nextWakeupTime = entry->eventTime;
+            }
+            break;
+        }
+        mScheduledInjectionQueue.dequeueAtHead();
+        CommandEntry* commandEntry = postCommandLocked(
+                & InputDispatcher::doInterceptScheduledInjectionLockedInterruptible);
+        commandEntry->eventEntry = entry;
+    }
+
+    for (size_t i = 0; i < mInjectionBatches.size(); ) {
+        InjectionBatch* batch = mInjectionBatches[i];
+        if (!batch->finished && batch->timeoutTime <= currentTime) {
+#if DEBUG_INJECTION
+            ALOGD("Injection batch timed out with %d results and %d foreground dispatches "
+                    "pending.", batch->pendingResults, batch->pendingForegroundDispatches);
+#endif
+            batch->injectionResult = INPUT_EVENT_INJECTION_TIMED_OUT;
+            finishInjectionBatchLocked(batch);
+        }
+        if (batch->finished) {
+            mInjectionBatches.removeAt(i);
+            batch->release();
+            continue;
+        }
+        if (batch->timeoutTime < *nextWakeupTime) {
+            *nextWakeupTime = batch->timeoutTime;
+        }
+        i++;
+    }
+}
+
+void InputDispatcher::drainScheduledInjectionQueueLocked() {
+    while (!mScheduledInjectionQueue.isEmpty()) {
+        releaseInboundEventLocked(mScheduledInjectionQueue.dequeueAtHead());
+    }
+}
+
+void InputDispatcher::updateInjectionBatchLocked(InjectionBatch* batch, bool dispatchDone) {
+    if (batch->finished) {
+        return;
+    }
+    // A batch is done as soon as one of its events fails, as the injector
+    // would have been told with injectInputEvent.
+    if (batch->injectionResult != INPUT_EVENT_INJECTION_SUCCEEDED
+            || (dispatchDone && batch->pendingResults == 0
+                    && batch->pendingForegroundDispatches == 0)) {
+        finishInjectionBatchLocked(batch);
+    }
+}
+
+void InputDispatcher::updateInjectionBatchesLocked() {
+    for (size_t i = 0; i < mInjectionBatches.size(); i++) {
+        updateInjectionBatchLocked(mInjectionBatches[i], true);
+    }
+}
+
+void InputDispatcher::finishInjectionBatchLocked(InjectionBatch* batch) {
+    batch->finished = true;
+    CommandEntry* commandEntry = postCommandLocked(
+            & InputDispatcher::doNotifyInjectionFinishedLockedInterruptible);
+    batch->refCount += 1;
+    commandEntry->injectionBatch = batch;
+}
+
 sp<InputWindowHandle> InputDispatcher::getWindowHandleLocked(
         const sp<InputChannel>& inputChannel) const {
     size_t numWindows = mWindowHandles.size();
@@ -2819,6 +3336,26 @@ bool InputDispatcher::hasWindowHandleLocked(
     return false;
 }
 
+void InputDispatcher::rebuildWindowGridsLocked() {
+    mWindowGrids.clear();
+    mWindowHandleIndices.clear();
+    for (size_t i = 0; i < mWindowHandles.size(); i++) {
+        const sp<InputWindowHandle>& windowHandle = mWindowHandles.itemAt(i);
+        mWindowHandleIndices.add(windowHandle.get(), i);
+        int32_t displayId = windowHandle->getInfo()->displayId;
+        if (mWindowGrids.indexOfKey(displayId) < 0) {
+            mWindowGrids.add(displayId, WindowGrid());
+            mWindowGrids.editValueFor(displayId).build(displayId, mWindowHandles);
+        }
+    }
+}
+
+const InputDispatcher::WindowGrid* InputDispatcher::getWindowGridLocked(
+        int32_t displayId) const {
+    ssize_t index = mWindowGrids.indexOfKey(displayId);
+    return index >= 0 ? &mWindowGrids.valueAt(index) : NULL;
+}
+
 void InputDispatcher::setInputWindows(const Vector<sp<InputWindowHandle> >& inputWindowHandles) {
 #if DEBUG_FOCUS
     ALOGD("setInputWindows");
@@ -2849,6 +3386,8 @@ void InputDispatcher::setInputWindows(const Vector<sp<InputWindowHandle> >& inpu
             mLastHoverWindowHandle = NULL;
         }
 
+        rebuildWindowGridsLocked();
+
         if (mFocusedWindowHandle != newFocusedWindowHandle) {
             if (mFocusedWindowHandle != NULL) {
 #if DEBUG_FOCUS
@@ -2988,11 +3527,12 @@ void InputDispatcher::setInputFilterEnabled(bool enabled) {
     { // acquire lock
         AutoMutex _l(mLock);
 
-        if (mInputFilterEnabled == enabled) {
+        if (bool(mInputFilterEnabled) == enabled) {
             return;
         }
 
-        mInputFilterEnabled = enabled;
+        android_atomic_release_store(enabled, &mInputFilterEnabled);
+        drainInboundRingLocked();
         resetAndDropEverythingLocked("input filter is being enabled or disabled");
     } // release lock
 
@@ -3092,7 +3632,9 @@ void InputDispatcher::resetAndDropEverythingLocked(const char* reason) {
 
     resetKeyRepeatLocked();
     releasePendingEventLocked();
+    drainDisplayLanesLocked();
     drainInboundQueueLocked();
+    drainScheduledInjectionQueueLocked();
     resetANRTimeoutsLocked();
 
     mTouchStatesByDisplay.clear();
@@ -3223,6 +3765,24 @@ void InputDispatcher::dumpDispatchStateLocked(String8& dump) {
         dump.append(INDENT "PendingEvent: <none>\n");
     }
 
+    // Dump the events waiting in display lanes.
+    if (!mDisplayLanes.isEmpty()) {
+        dump.append(INDENT "DisplayLanes:\n");
+        for (size_t i = 0; i < mDisplayLanes.size(); i++) {
+            const DisplayLane* lane = mDisplayLanes.valueAt(i);
+            dump.appendFormat(INDENT2 "%d: queueLength=%u, waitingForApplication=%s\n",
+                    mDisplayLanes.keyAt(i), lane->queue.count(),
+                    toString(lane->inputTargetWaitCause
+                            == INPUT_TARGET_WAIT_CAUSE_APPLICATION_NOT_READY));
+            dump.append(INDENT3);
+            lane->pendingEvent->appendDescription(dump);
+            dump.appendFormat(", age=%0.1fms\n",
+                    (currentTime - lane->pendingEvent->eventTime) * 0.000001f);
+        }
+    } else {
+        dump.append(INDENT "DisplayLanes: <none>\n");
+    }
+
     // Dump inbound events from oldest to newest.
     if (!mInboundQueue.isEmpty()) {
         dump.appendFormat(INDENT "InboundQueue: length=%u\n", mInboundQueue.count());
@@ -3236,6 +3796,21 @@ void InputDispatcher::dumpDispatchStateLocked(String8& dump) {
         dump.append(INDENT "InboundQueue: <empty>\n");
     }
 
+    // Dump scheduled injections in the order they will be dispatched.
+    if (!mScheduledInjectionQueue.isEmpty()) {
+        dump.appendFormat(INDENT "ScheduledInjectionQueue: length=%u, batches=%zu\n",
+                mScheduledInjectionQueue.count(), mInjectionBatches.size());
+        for (EventEntry* entry = mScheduledInjectionQueue.head; entry; entry = entry->next) {
+            dump.append(INDENT2);
+            entry->appendDescription(dump);
+            dump.appendFormat(", dueIn=%0.1fms\n",
+                    (entry->eventTime - currentTime) * 0.000001f);
+        }
+    } else {
+        dump.appendFormat(INDENT "ScheduledInjectionQueue: <empty>, batches=%zu\n",
+                mInjectionBatches.size());
+    }
+
     if (!mReplacedKeys.isEmpty()) {
         dump.append(INDENT "ReplacedKeys:\n");
         for (size_t i = 0; i < mReplacedKeys.size(); i++) {
@@ -3258,6 +3833,15 @@ void InputDispatcher::dumpDispatchStateLocked(String8& dump) {
                     connection->getStatusLabel(), toString(connection->monitor),
                     toString(connection->inputPublisherBlocked));
 
+            dump.append(INDENT3 "PublishLatency: ");
+            connection->publishLatency.dump(dump);
+            dump.append("\n" INDENT3 "FinishLatency: ");
+            connection->finishLatency.dump(dump);
+            dump.appendFormat("\n" INDENT3 "AverageFinishLatency: %0.1fms, lagging=%s, "
+                    "droppedMoveCount=%u\n",
+                    connection->averageFinishLatency * 0.000001f,
+                    toString(connection->isLagging()), connection->droppedMoveCount);
+
             if (!connection->outboundQueue.isEmpty()) {
                 dump.appendFormat(INDENT3 "OutboundQueue: length=%u\n",
                         connection->outboundQueue.count());
@@ -3301,6 +3885,11 @@ void InputDispatcher::dumpDispatchStateLocked(String8& dump) {
         dump.append(INDENT "AppSwitch: not pending\n");
     }
 
+    dump.append(INDENT "EntryPools:\n");
+    getEntryPool<KeyEntry>(KEY_ENTRY_POOL_SIZE).dump(dump, "KeyEntry");
+    getEntryPool<MotionEntry>(MOTION_ENTRY_POOL_SIZE).dump(dump, "MotionEntry");
+    getEntryPool<DispatchEntry>(DISPATCH_ENTRY_POOL_SIZE).dump(dump, "DispatchEntry");
+
     dump.append(INDENT "Configuration:\n");
     dump.appendFormat(INDENT2 "KeyRepeatDelay: %0.1fms\n",
             mConfig.keyRepeatDelay * 0.000001f);
@@ -3459,6 +4048,7 @@ void InputDispatcher::onANRLocked(
     commandEntry->inputApplicationHandle = applicationHandle;
     commandEntry->inputWindowHandle = windowHandle;
     commandEntry->reason = reason;
+    commandEntry->laneDisplayId = mDispatchingLaneDisplayId;
 }
 
 void InputDispatcher::doNotifyConfigurationChangedInterruptible(
@@ -3493,9 +4083,23 @@ void InputDispatcher::doNotifyANRLockedInterruptible(
 
     mLock.lock();
 
+    // Resume the wait of the lane the ANR came from.  If the lane has caught up since,
+    // only the connection is brought back in sync.
+    DisplayLane* lane = NULL;
+    DisplayLane caughtUpLane;
+    if (commandEntry->laneDisplayId != ADISPLAY_ID_NONE) {
+        ssize_t laneIndex = mDisplayLanes.indexOfKey(commandEntry->laneDisplayId);
+        lane = laneIndex >= 0 ? mDisplayLanes.valueAt(laneIndex) : &caughtUpLane;
+        swapInputTargetWaitLocked(lane);
+    }
+
     resumeAfterTargetsNotReadyTimeoutLocked(newTimeout,
             commandEntry->inputWindowHandle != NULL
                     ? commandEntry->inputWindowHandle->getInputChannel() : NULL);
+
+    if (lane) {
+        swapInputTargetWaitLocked(lane);
+    }
 }
 
 void InputDispatcher::doInterceptKeyBeforeDispatchingLockedInterruptible(
@@ -3534,6 +4138,7 @@ void InputDispatcher::doDispatchCycleFinishedLockedInterruptible(
     DispatchEntry* dispatchEntry = connection->findWaitQueueEntry(seq);
     if (dispatchEntry) {
         nsecs_t eventDuration = finishTime - dispatchEntry->deliveryTime;
+        connection->recordFinishLatency(eventDuration);
         if (eventDuration > SLOW_EVENT_PROCESSING_WARNING_TIMEOUT) {
             String8 msg;
             msg.appendFormat("Window '%s' spent %0.1fms processing the last input event: ",
@@ -3760,6 +4365,55 @@ void InputDispatcher::doPokeUserActivityLockedInterruptible(CommandEntry* comman
     mLock.lock();
 }
 
+void InputDispatcher::doNotifyInjectionFinishedLockedInterruptible(
+        CommandEntry* commandEntry) {
+    InjectionBatch* batch = commandEntry->injectionBatch;
+    sp<InputInjectionCallback> callback = batch->callback;
+    int32_t injectionResult = batch->injectionResult;
+    size_t injectedCount = batch->injectedCount;
+    batch->release();
+
+    if (callback != NULL) {
+        mLock.unlock();
+
+        callback->onInjectionFinished(injectionResult, injectedCount);
+
+        mLock.lock();
+    }
+}
+
+void InputDispatcher::doInterceptScheduledInjectionLockedInterruptible(
+        CommandEntry* commandEntry) {
+    EventEntry* entry = commandEntry->eventEntry;
+    uint32_t policyFlags = entry->policyFlags;
+
+    if (!(policyFlags & POLICY_FLAG_FILTERED)) {
+        switch (entry->type) {
+        case EventEntry::TYPE_KEY: {
+            KeyEvent event;
+            initializeKeyEvent(&event, static_cast<KeyEntry*>(entry));
+
+            mLock.unlock();
+            mPolicy->interceptKeyBeforeQueueing(&event, /*byref*/ policyFlags);
+            mLock.lock();
+            break;
+        }
+
+        case EventEntry::TYPE_MOTION: {
+            nsecs_t eventTime = entry->eventTime;
+
+            mLock.unlock();
+            mPolicy->interceptMotionBeforeQueueing(eventTime, /*byref*/ policyFlags);
+            mLock.lock();
+            break;
+        }
+        }
+    }
+
+    entry->policyFlags = policyFlags;
+    enqueueInboundEventLocked(entry);
+}
+
 void InputDispatcher::initializeKeyEvent(KeyEvent* event, const KeyEntry* entry) {
     event->initialize(entry->deviceId, entry->source, entry->action, entry->flags,
             entry->keyCode, entry->scanCode, entry->metaState, entry->repeatCount,
@@ -3832,10 +4486,13 @@ InputDispatcher::InjectionState::InjectionState(int32_t injectorPid, int32_t inj
         refCount(1),
         injectorPid(injectorPid), injectorUid(injectorUid),
         injectionResult(INPUT_EVENT_INJECTION_PENDING), injectionIsAsync(false),
-        pendingForegroundDispatches(0) {
+        pendingForegroundDispatches(0), batch(NULL) {
 }
 
 InputDispatcher::InjectionState::~InjectionState() {
+    if (batch) {
+        batch->release();
+    }
 }
 
 void InputDispatcher::InjectionState::release() {
@@ -3848,6 +4505,29 @@ void InputDispatcher::InjectionState::release() {
 }
 
 
+// --- InputDispatcher::InjectionBatch ---
+
+InputDispatcher::InjectionBatch::InjectionBatch(const sp<InputInjectionCallback>& callback,
+        nsecs_t timeoutTime, int32_t eventCount) :
+        refCount(1), callback(callback), timeoutTime(timeoutTime),
+        pendingResults(eventCount), pendingForegroundDispatches(0),
+        injectionResult(INPUT_EVENT_INJECTION_SUCCEEDED), injectedCount(0),
+        finished(false) {
+}
+
+InputDispatcher::InjectionBatch::~InjectionBatch() {
+}
+
+void InputDispatcher::InjectionBatch::release() {
+    refCount -= 1;
+    if (refCount == 0) {
+        delete this;
+    } else {
+        ALOG_ASSERT(refCount > 0);
+    }
+}
+
+
 // --- InputDispatcher::EventEntry ---
 
 InputDispatcher::EventEntry::EventEntry(int32_t type, nsecs_t eventTime, uint32_t policyFlags) :
@@ -3924,6 +4604,14 @@ InputDispatcher::KeyEntry::KeyEntry(nsecs_t eventTime,
 InputDispatcher::KeyEntry::~KeyEntry() {
 }
 
+void* InputDispatcher::KeyEntry::operator new(size_t size) {
+    return getEntryPool<KeyEntry>(KEY_ENTRY_POOL_SIZE).allocate(size);
+}
+
+void InputDispatcher::KeyEntry::operator delete(void* ptr, size_t size) {
+    getEntryPool<KeyEntry>(KEY_ENTRY_POOL_SIZE).free(ptr, size);
+}
+
 void InputDispatcher::KeyEntry::appendDescription(String8& msg) const {
     msg.appendFormat("KeyEvent(deviceId=%d, source=0x%08x, action=%d, "
             "flags=0x%08x, keyCode=%d, scanCode=%d, metaState=0x%08x, "
@@ -3969,6 +4657,14 @@ InputDispatcher::MotionEntry::MotionEntry(nsecs_t eventTime,
 InputDispatcher::MotionEntry::~MotionEntry() {
 }
 
+void* InputDispatcher::MotionEntry::operator new(size_t size) {
+    return getEntryPool<MotionEntry>(MOTION_ENTRY_POOL_SIZE).allocate(size);
+}
+
+void InputDispatcher::MotionEntry::operator delete(void* ptr, size_t size) {
+    getEntryPool<MotionEntry>(MOTION_ENTRY_POOL_SIZE).free(ptr, size);
+}
+
 void InputDispatcher::MotionEntry::appendDescription(String8& msg) const {
     msg.appendFormat("MotionEvent(deviceId=%d, source=0x%08x, action=%d, "
             "flags=0x%08x, metaState=0x%08x, buttonState=0x%08x, edgeFlags=0x%08x, "
@@ -3995,7 +4691,7 @@ InputDispatcher::DispatchEntry::DispatchEntry(EventEntry* eventEntry,
         seq(nextSeq()),
         eventEntry(eventEntry), targetFlags(targetFlags),
         xOffset(xOffset), yOffset(yOffset), scaleFactor(scaleFactor),
-        deliveryTime(0), resolvedAction(0), resolvedFlags(0) {
+        enqueueTime(0), deliveryTime(0), resolvedAction(0), resolvedFlags(0) {
     eventEntry->refCount += 1;
 }
 
@@ -4003,6 +4699,14 @@ InputDispatcher::DispatchEntry::~DispatchEntry() {
     eventEntry->release();
 }
 
+void* InputDispatcher::DispatchEntry::operator new(size_t size) {
+    return getEntryPool<DispatchEntry>(DISPATCH_ENTRY_POOL_SIZE).allocate(size);
+}
+
+void InputDispatcher::DispatchEntry::operator delete(void* ptr, size_t size) {
+    getEntryPool<DispatchEntry>(DISPATCH_ENTRY_POOL_SIZE).free(ptr, size);
+}
+
 uint32_t InputDispatcher::DispatchEntry::nextSeq() {
     // Sequence number 0 is reserved and will never be returned.
     uint32_t seq;
@@ -4367,13 +5071,43 @@ bool InputDispatcher::InputState::shouldCancelMotion(const MotionMemento& mement
 }
 
 
+// --- InputDispatcher::LatencyHistogram ---
+
+InputDispatcher::LatencyHistogram::LatencyHistogram() : max(0) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void InputDispatcher::LatencyHistogram::add(nsecs_t latency) {
+    if (latency < 0) {
+        latency = 0;
+    }
+    size_t bucket = 0;
+    for (nsecs_t limit = 1000000LL; bucket < BUCKET_COUNT - 1 && latency >= limit; limit *= 2) {
+        bucket += 1;
+    }
+    buckets[bucket] += 1;
+    if (latency > max) {
+        max = latency;
+    }
+}
+
+void InputDispatcher::LatencyHistogram::dump(String8& dump) const {
+    for (size_t i = 0; i < BUCKET_COUNT - 1; i++) {
+        dump.appendFormat("<%dms=%u, ", 1 << i, buckets[i]);
+    }
+    dump.appendFormat(">=%dms=%u, max=%0.1fms", 1 << (BUCKET_COUNT - 2),
+            buckets[BUCKET_COUNT - 1], max * 0.000001f);
+}
+
+
 // --- InputDispatcher::Connection ---
 
 InputDispatcher::Connection::Connection(const sp<InputChannel>& inputChannel,
         const sp<InputWindowHandle>& inputWindowHandle, bool monitor) :
         status(STATUS_NORMAL), inputChannel(inputChannel), inputWindowHandle(inputWindowHandle),
         monitor(monitor),
-        inputPublisher(inputChannel), inputPublisherBlocked(false) {
+        inputPublisher(inputChannel), inputPublisherBlocked(false),
+        averageFinishLatency(0), droppedMoveCount(0) {
 }
 
 InputDispatcher::Connection::~Connection() {
@@ -4405,6 +5139,16 @@ const char* InputDispatcher::Connection::getStatusLabel() const {
     }
 }
 
+void InputDispatcher::Connection::recordFinishLatency(nsecs_t latency) {
+    finishLatency.add(latency);
+    // Exponential moving average over roughly the last 8 events.
+    averageFinishLatency += (latency - averageFinishLatency) / 8;
+}
+
+bool InputDispatcher::Connection::isLagging() const {
+    return inputPublisherBlocked || averageFinishLatency > MONITOR_LAG_THRESHOLD;
+}
+
 InputDispatcher::DispatchEntry* InputDispatcher::Connection::findWaitQueueEntry(uint32_t seq) {
     for (DispatchEntry* entry = waitQueue.head; entry != NULL; entry = entry->next) {
         if (entry->seq == seq) {
@@ -4419,13 +5163,128 @@ InputDispatcher::DispatchEntry* InputDispatcher::Connection::findWaitQueueEntry(
 
 InputDispatcher::CommandEntry::CommandEntry(Command command) :
     command(command), eventTime(0), keyEntry(NULL), userActivityEventType(0),
-    seq(0), handled(false) {
+    seq(0), handled(false), injectionBatch(NULL), laneDisplayId(ADISPLAY_ID_NONE),
+    eventEntry(NULL) {
 }
 
 InputDispatcher::CommandEntry::~CommandEntry() {
 }
 
 
+// --- InputDispatcher::DisplayLane ---
+
+InputDispatcher::DisplayLane::DisplayLane() :
+    pendingEvent(NULL), inputTargetWaitCause(INPUT_TARGET_WAIT_CAUSE_NONE),
+    inputTargetWaitStartTime(0), inputTargetWaitTimeoutTime(0),
+    inputTargetWaitTimeoutExpired(false) {
+}
+
+
+// --- InputDispatcher::WindowGrid ---
+
+void InputDispatcher::WindowGrid::build(int32_t displayId,
+        const Vector<sp<InputWindowHandle> >& windowHandles) {
+    // Cover the frames and touchable regions of all the windows of the display.
+    // Frames include their right and bottom edges.
+    bounds.makeInvalid();
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const InputWindowInfo* info = windowHandles.itemAt(i)->getInfo();
+        if (info->displayId != displayId) {
+            continue;
+        }
+        Rect rects[2] = {
+            Rect(info->frameLeft, info->frameTop, info->frameRight + 1, info->frameBottom + 1),
+            info->touchableRegion.getBounds(),
+        };
+        for (size_t r = 0; r < 2; r++) {
+            if (rects[r].isEmpty()) {
+                continue;
+            }
+            const Rect& rect(rects[r]);
+            if (bounds.isEmpty()) {
+                bounds = rect;
+                continue;
+            }
+            if (rect.left < bounds.left) bounds.left = rect.left;
+            if (rect.top < bounds.top) bounds.top = rect.top;
+            if (rect.right > bounds.right) bounds.right = rect.right;
+            if (rect.bottom > bounds.bottom) bounds.bottom = rect.bottom;
+        }
+    }
+    cellWidth = bounds.isEmpty() ? 1 : (bounds.getWidth() + SIZE - 1) / SIZE;
+    cellHeight = bounds.isEmpty() ? 1 : (bounds.getHeight() + SIZE - 1) / SIZE;
+
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const InputWindowInfo* info = windowHandles.itemAt(i)->getInfo();
+        if (info->displayId != displayId) {
+            continue;
+        }
+
+        // These mirror the checks made by findTouchedWindowAtLocked and
+        // findTouchedWindowTargetsLocked.
+        int32_t flags = info->layoutParamsFlags;
+        bool touchable = info->visible && !(flags & InputWindowInfo::FLAG_NOT_TOUCHABLE);
+        bool touchModal = touchable && (flags & (InputWindowInfo::FLAG_NOT_FOCUSABLE
+                | InputWindowInfo::FLAG_NOT_TOUCH_MODAL)) == 0;
+        bool anywhere = touchModal
+                || (info->visible && (flags & InputWindowInfo::FLAG_WATCH_OUTSIDE_TOUCH))
+                || (info->layoutParamsPrivateFlags & InputWindowInfo::PRIVATE_FLAG_SYSTEM_ERROR);
+        if (anywhere) {
+            touchOutside.add(i);
+            for (size_t c = 0; c < SIZE * SIZE; c++) {
+                touchCells[c].add(i);
+            }
+        } else if (touchable) {
+            addToCells(touchCells, info->touchableRegion.getBounds(), i);
+        }
+
+        // This mirrors isWindowObscuredAtPointLocked.
+        if (info->visible && !info->isTrustedOverlay()) {
+            addToCells(obscuringCells, Rect(info->frameLeft, info->frameTop,
+                    info->frameRight + 1, info->frameBottom + 1), i);
+        }
+    }
+}
+
+const Vector<size_t>& InputDispatcher::WindowGrid::getTouchCandidates(
+        int32_t x, int32_t y) const {
+    ssize_t cell = getCellIndex(x, y);
+    return cell >= 0 ? touchCells[cell] : touchOutside;
+}
+
+const Vector<size_t>& InputDispatcher::WindowGrid::getObscuringCandidates(
+        int32_t x, int32_t y) const {
+    // No frame reaches outside of the grid.
+    static const Vector<size_t> none;
+    ssize_t cell = getCellIndex(x, y);
+    return cell >= 0 ? obscuringCells[cell] : none;
+}
+
+ssize_t InputDispatcher::WindowGrid::getCellIndex(int32_t x, int32_t y) const {
+    if (x < bounds.left || x >= bounds.right || y < bounds.top || y >= bounds.bottom) {
+        return -1;
+    }
+    return ((y - bounds.top) / cellHeight) * SIZE + (x - bounds.left) / cellWidth;
+}
+
+void InputDispatcher::WindowGrid::addToCells(Vector<size_t>* cells, const Rect& rect,
+        size_t index) {
+    Rect clipped;
+    if (!rect.intersect(bounds, &clipped)) {
+        return;
+    }
+    int32_t left = (clipped.left - bounds.left) / cellWidth;
+    int32_t right = (clipped.right - 1 - bounds.left) / cellWidth;
+    int32_t top = (clipped.top - bounds.top) / cellHeight;
+    int32_t bottom = (clipped.bottom - 1 - bounds.top) / cellHeight;
+    for (int32_t row = top; row <= bottom; row++) {
+        for (int32_t column = left; column <= right; column++) {
+            cells[row * SIZE + column].add(index);
+        }
+    }
+}
+
+
 // --- InputDispatcher::TouchState ---
 
 InputDispatcher::TouchState::TouchState() :
@@ -4539,6 +5398,12 @@ InputDispatcherThread::InputDispatcherThread(const sp<InputDispatcherInterface>&
 InputDispatcherThread::~InputDispatcherThread() {
 }
 
+status_t InputDispatcherThread::readyToRun() {
+    // the policy calls made while dispatching hold up the input pipeline
+    IPCThreadState::self()->setLatencyCritical(true);
+    return NO_ERROR;
+}
+
 bool InputDispatcherThread::threadLoop() {
     mDispatcher->dispatchOnce();
     return true;
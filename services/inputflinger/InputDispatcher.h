@@ -44,7 +44,8 @@ namespace android {
  * Constants used to report the outcome of input event injection.
  */
 enum {
-    /* (INTERNAL USE ONLY) Specifies that injection is pending and its outcome is unknown. */
+    /* Specifies that injection is pending and its outcome is unknown.
+     * Only returned by injectInputEvents, whose callback gets the outcome. */
     INPUT_EVENT_INJECTION_PENDING = -1,
 
     /* Injection succeeded. */
@@ -181,6 +182,24 @@ struct InputDispatcherConfiguration {
 };
 
 
+/*
+ * Tells the injector of a batch of events how its injection went.
+ * See InputDispatcherInterface::injectInputEvents.
+ */
+class InputInjectionCallback : public virtual RefBase {
+protected:
+    InputInjectionCallback() { }
+    virtual ~InputInjectionCallback() { }
+
+public:
+    /* Called once per batch, on the input dispatcher thread, without any of its locks held.
+     * injectionResult is one of the INPUT_EVENT_INJECTION_XXX constants other than
+     * INPUT_EVENT_INJECTION_PENDING, injectedCount the number of events of the batch
+     * that were dispatched. */
+    virtual void onInjectionFinished(int32_t injectionResult, size_t injectedCount) = 0;
+};
+
+
 /*
  * Input dispatcher policy interface.
  *
@@ -298,6 +317,21 @@ public:
             int32_t injectorPid, int32_t injectorUid, int32_t syncMode, int32_t timeoutMillis,
             uint32_t policyFlags) = 0;
 
+    /* Injects a sequence of input events without waiting for them.
+     * Each event is dispatched once its event time has come, and after the ones before it.
+     * The callback is called once: when all of the events have been completely processed,
+     * as with INPUT_EVENT_INJECTION_SYNC_WAIT_FOR_FINISHED, when one of them could not be
+     * dispatched, or timeoutMillis after the event time of the last one.
+     * Returns INPUT_EVENT_INJECTION_PENDING if the events were queued, in which case the
+     * callback will be called, or INPUT_EVENT_INJECTION_FAILED if one of them is not valid,
+     * in which case none of them were.
+     *
+     * This method may be called on any thread (usually by the input manager).
+     */
+    virtual int32_t injectInputEvents(const Vector<const InputEvent*>& events,
+            int32_t displayId, int32_t injectorPid, int32_t injectorUid, int32_t timeoutMillis,
+            uint32_t policyFlags, const sp<InputInjectionCallback>& callback) = 0;
+
     /* Sets the list of input windows.
      *
      * This method may be called on any thread (usually by the input manager).
@@ -381,6 +415,9 @@ public:
     virtual int32_t injectInputEvent(const InputEvent* event, int32_t displayId,
             int32_t injectorPid, int32_t injectorUid, int32_t syncMode, int32_t timeoutMillis,
             uint32_t policyFlags);
+    virtual int32_t injectInputEvents(const Vector<const InputEvent*>& events,
+            int32_t displayId, int32_t injectorPid, int32_t injectorUid, int32_t timeoutMillis,
+            uint32_t policyFlags, const sp<InputInjectionCallback>& callback);
 
     virtual void setInputWindows(const Vector<sp<InputWindowHandle> >& inputWindowHandles);
     virtual void setFocusedApplication(const sp<InputApplicationHandle>& inputApplicationHandle);
@@ -404,6 +441,26 @@ private:
         inline Link() : next(NULL), prev(NULL) { }
     };
 
+    // The events of an injectInputEvents() call, each with an InjectionState of its own.
+    struct InjectionBatch {
+        mutable int32_t refCount;
+
+        sp<InputInjectionCallback> callback;
+        nsecs_t timeoutTime;
+        int32_t pendingResults; // the number of events whose injection result is unknown
+        int32_t pendingForegroundDispatches; // the sum of those of the events
+        int32_t injectionResult; // the first result that isn't INPUT_EVENT_INJECTION_SUCCEEDED
+        size_t injectedCount; // the number of events whose result is SUCCEEDED
+        bool finished; // set once the callback has been scheduled
+
+        InjectionBatch(const sp<InputInjectionCallback>& callback, nsecs_t timeoutTime,
+                int32_t eventCount);
+        void release();
+
+    private:
+        ~InjectionBatch();
+    };
+
     struct InjectionState {
         mutable int32_t refCount;
 
@@ -412,6 +469,7 @@ private:
         int32_t injectionResult;  // initially INPUT_EVENT_INJECTION_PENDING
         bool injectionIsAsync; // set to true if injection is not waiting for the result
         int32_t pendingForegroundDispatches; // the number of foreground dispatches in progress
+        InjectionBatch* batch; // the batch the event is part of, or null
 
         InjectionState(int32_t injectorPid, int32_t injectorUid);
         void release();
@@ -495,6 +553,10 @@ private:
         virtual void appendDescription(String8& msg) const;
         void recycle();
 
+        // Allocated from a pool, see InputDispatcher.cpp.
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+
     protected:
         virtual ~KeyEntry();
     };
@@ -526,6 +588,10 @@ private:
                 float xOffset, float yOffset);
         virtual void appendDescription(String8& msg) const;
 
+        // Allocated from a pool, see InputDispatcher.cpp.
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+
     protected:
         virtual ~MotionEntry();
     };
@@ -539,6 +605,7 @@ private:
         float xOffset;
         float yOffset;
         float scaleFactor;
+        nsecs_t enqueueTime; // time when the entry was added to the outbound queue
         nsecs_t deliveryTime; // time when the event was actually delivered
 
         // Set to the resolved action and flags when the event is enqueued.
@@ -549,6 +616,10 @@ private:
                 int32_t targetFlags, float xOffset, float yOffset, float scaleFactor);
         ~DispatchEntry();
 
+        // Allocated from a pool, see InputDispatcher.cpp.
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+
         inline bool hasForegroundTarget() const {
             return targetFlags & InputTarget::FLAG_FOREGROUND;
         }
@@ -599,6 +670,9 @@ private:
         int32_t userActivityEventType;
         uint32_t seq;
         bool handled;
+        InjectionBatch* injectionBatch;
+        int32_t laneDisplayId; // display lane that posted the command, or ADISPLAY_ID_NONE
+        EventEntry* eventEntry; // a scheduled injection that has come due
     };
 
     // Generic queue implementation.
@@ -782,6 +856,19 @@ private:
                 const CancelationOptions& options);
     };
 
+    /* Counts latencies in power of two millisecond buckets. */
+    struct LatencyHistogram {
+        enum { BUCKET_COUNT = 10 }; // <1ms, <2ms, <4ms, ... <256ms, >=256ms
+
+        uint32_t buckets[BUCKET_COUNT];
+        nsecs_t max;
+
+        LatencyHistogram();
+
+        void add(nsecs_t latency);
+        void dump(String8& dump) const;
+    };
+
     /* Manages the dispatch state associated with a single input channel. */
     class Connection : public RefBase {
     protected:
@@ -815,6 +902,19 @@ private:
         // yet received a "finished" response from the application.
         Queue<DispatchEntry> waitQueue;
 
+        // Time spent by events in the outbound queue, and waiting for the application
+        // to finish them once published.
+        LatencyHistogram publishLatency;
+        LatencyHistogram finishLatency;
+
+        // Moving average of the finish latency, used to tell whether the application
+        // is keeping up with the events.
+        nsecs_t averageFinishLatency;
+
+        // Number of pending motion samples that were replaced by newer ones because
+        // the connection was lagging.
+        uint32_t droppedMoveCount;
+
         explicit Connection(const sp<InputChannel>& inputChannel,
                 const sp<InputWindowHandle>& inputWindowHandle, bool monitor);
 
@@ -824,6 +924,12 @@ private:
         const char* getStatusLabel() const;
 
         DispatchEntry* findWaitQueueEntry(uint32_t seq);
+
+        // Records the time it took the application to finish an event.
+        void recordFinishLatency(nsecs_t latency);
+
+        // True if the application does not keep up with the events sent to it.
+        bool isLagging() const;
     };
 
     enum DropReason {
@@ -854,6 +960,21 @@ private:
     // Enqueues an inbound event.  Returns true if mLooper->wake() should be called.
     bool enqueueInboundEventLocked(EventEntry* entry);
 
+    // Events from the reader are handed over through a single producer, single consumer
+    // ring so that the reader doesn't have to wait for mLock while the dispatcher is busy.
+    // The producer is the thread calling the notify methods, the consumer is whoever holds
+    // mLock.  The dispatcher is woken once for each batch of events.
+    enum { INBOUND_RING_SIZE = 256 }; // must be a power of two
+    EventEntry* mInboundRing[INBOUND_RING_SIZE];
+    volatile int32_t mInboundRingHead; // written by the producer
+    volatile int32_t mInboundRingTail; // written by the consumer
+    volatile int32_t mInboundRingWakePending;
+
+    void enqueueInboundEventFromReader(EventEntry* entry);
+    // Moves the ring's events to mInboundQueue.  Returns true if mLooper->wake() should
+    // be called.
+    bool drainInboundRingLocked();
+
     // Cleans up input state when dropping an inbound event.
     void dropInboundEventLocked(EventEntry* entry, DropReason dropReason);
 
@@ -890,6 +1011,29 @@ private:
     Condition mInjectionResultAvailableCondition;
     bool hasInjectionPermission(int32_t injectorPid, int32_t injectorUid);
     void setInjectionResultLocked(EventEntry* entry, int32_t injectionResult);
+    // Validates an event to inject and, if intercept is set, lets the policy intercept
+    // it, then makes the entries to enqueue for it: more than one for a motion event
+    // with history. Returns INPUT_EVENT_INJECTION_SUCCEEDED, or
+    // INPUT_EVENT_INJECTION_FAILED if the event isn't valid.
+    int32_t makeInjectedEntries(const InputEvent* event, int32_t displayId,
+            uint32_t policyFlags, bool intercept,
+            EventEntry** outFirstEntry, EventEntry** outLastEntry);
+
+    // The events of injectInputEvents() batches that aren't due yet, in order, and the
+    // batches whose callback hasn't been scheduled yet.
+    Queue<EventEntry> mScheduledInjectionQueue;
+    Vector<InjectionBatch*> mInjectionBatches;
+    // Hands the scheduled injections that are due to the policy, which then enqueues
+    // them, and times out batches.
+    void processInjectionBatchesLocked(nsecs_t currentTime, nsecs_t* nextWakeupTime);
+    void drainScheduledInjectionQueueLocked();
+    // Schedules the batch's callback if one of its events failed, or if all of them
+    // succeeded and were finished by their targets. The latter is only checked when
+    // dispatchDone is set, i.e. from updateInjectionBatchesLocked() once the dispatch
+    // of an event is over and all its foreground dispatches are counted.
+    void updateInjectionBatchLocked(InjectionBatch* batch, bool dispatchDone);
+    void updateInjectionBatchesLocked();
+    void finishInjectionBatchLocked(InjectionBatch* batch);
 
     Condition mInjectionSyncFinishedCondition;
     void incrementPendingForegroundDispatchesLocked(EventEntry* entry);
@@ -924,8 +1068,8 @@ private:
     CommandEntry* postCommandLocked(Command command);
 
     // Input filter processing.
-    bool shouldSendKeyToInputFilterLocked(const NotifyKeyArgs* args);
-    bool shouldSendMotionToInputFilterLocked(const NotifyMotionArgs* args);
+    bool shouldSendKeyToInputFilter(const NotifyKeyArgs* args);
+    bool shouldSendMotionToInputFilter(const NotifyMotionArgs* args);
 
     // Inbound event processing.
     void drainInboundQueueLocked();
@@ -935,13 +1079,50 @@ private:
     // Dispatch state.
     bool mDispatchEnabled;
     bool mDispatchFrozen;
-    bool mInputFilterEnabled;
+    volatile int32_t mInputFilterEnabled; // also read without mLock by the notify methods
 
     Vector<sp<InputWindowHandle> > mWindowHandles;
 
     sp<InputWindowHandle> getWindowHandleLocked(const sp<InputChannel>& inputChannel) const;
     bool hasWindowHandleLocked(const sp<InputWindowHandle>& windowHandle) const;
 
+    // Hit-testing index over the windows of one display.  The display area covered by
+    // its windows is split into a uniform grid, and each cell lists the indices in
+    // mWindowHandles of the windows that may matter at a point inside it, in front to
+    // back order.  Walking a cell's list gives the same answer as walking all the
+    // windows of the display, since the others can't be touched at, or obscure, that
+    // point.  Rebuilt by setInputWindows.
+    struct WindowGrid {
+        enum { SIZE = 8 };
+
+        Rect bounds;
+        int32_t cellWidth;
+        int32_t cellHeight;
+        // Windows that may be touched or affect touch dispatch at a point: touch modal,
+        // watching outside touches or system error windows anywhere, and the others
+        // where their touchable region is.
+        Vector<size_t> touchCells[SIZE * SIZE];
+        // The touch modal, watching outside touches and system error windows, which is
+        // all that matters at points outside of the grid.
+        Vector<size_t> touchOutside;
+        // Visible windows that aren't trusted overlays, where their frame is.
+        Vector<size_t> obscuringCells[SIZE * SIZE];
+
+        void build(int32_t displayId, const Vector<sp<InputWindowHandle> >& windowHandles);
+        const Vector<size_t>& getTouchCandidates(int32_t x, int32_t y) const;
+        const Vector<size_t>& getObscuringCandidates(int32_t x, int32_t y) const;
+
+    private:
+        ssize_t getCellIndex(int32_t x, int32_t y) const;
+        void addToCells(Vector<size_t>* cells, const Rect& rect, size_t index);
+    };
+    KeyedVector<int32_t, WindowGrid> mWindowGrids;
+    // The index of each window in mWindowHandles.
+    KeyedVector<const InputWindowHandle*, size_t> mWindowHandleIndices;
+
+    void rebuildWindowGridsLocked();
+    const WindowGrid* getWindowGridLocked(int32_t displayId) const;
+
     // Focus tracking for keys, trackball, etc.
     sp<InputWindowHandle> mFocusedWindowHandle;
 
@@ -1010,6 +1191,36 @@ private:
     bool mInputTargetWaitTimeoutExpired;
     sp<InputApplicationHandle> mInputTargetWaitApplicationHandle;
 
+    // Pointer events of a display other than the focused one that are waiting for their
+    // targets to become ready are set aside in a lane of their own, so that the input of
+    // the other displays isn't held up behind a slow window.  A lane has its own pending
+    // event, the later events of its display in order, and its own ANR wait state, which
+    // is swapped into the mInputTargetWait* members while the lane is being dispatched.
+    // Keys and focus are shared and stay on the main path.
+    struct DisplayLane {
+        EventEntry* pendingEvent;
+        Queue<EventEntry> queue;
+        InputTargetWaitCause inputTargetWaitCause;
+        nsecs_t inputTargetWaitStartTime;
+        nsecs_t inputTargetWaitTimeoutTime;
+        bool inputTargetWaitTimeoutExpired;
+        sp<InputApplicationHandle> inputTargetWaitApplicationHandle;
+
+        DisplayLane();
+    };
+    KeyedVector<int32_t, DisplayLane*> mDisplayLanes;
+    // The display whose lane is being dispatched, or ADISPLAY_ID_NONE for the main path.
+    int32_t mDispatchingLaneDisplayId;
+
+    int32_t getFocusedDisplayIdLocked();
+    // Moves the pending event to a lane of its display if it can wait there.
+    bool parkPendingEventLocked();
+    // Appends an inbound event to the lane of its display if there is one.
+    bool enqueueDisplayLaneEventLocked(EventEntry* entry);
+    void dispatchDisplayLanesLocked(nsecs_t currentTime, nsecs_t* nextWakeupTime);
+    void swapInputTargetWaitLocked(DisplayLane* lane);
+    void drainDisplayLanesLocked();
+
     // Contains the last window which received a hover event.
     sp<InputWindowHandle> mLastHoverWindowHandle;
 
@@ -1053,9 +1264,12 @@ private:
             EventEntry* eventEntry, const InputTarget* inputTarget);
     void enqueueDispatchEntriesLocked(nsecs_t currentTime, const sp<Connection>& connection,
             EventEntry* eventEntry, const InputTarget* inputTarget);
-    void enqueueDispatchEntryLocked(const sp<Connection>& connection,
+    void enqueueDispatchEntryLocked(nsecs_t currentTime, const sp<Connection>& connection,
             EventEntry* eventEntry, const InputTarget* inputTarget, int32_t dispatchMode);
+    bool dropPendingMoveLocked(const sp<Connection>& connection, const DispatchEntry* entry);
     void startDispatchCycleLocked(nsecs_t currentTime, const sp<Connection>& connection);
+    status_t publishDispatchEntryLocked(const sp<Connection>& connection,
+            DispatchEntry* dispatchEntry);
     void finishDispatchCycleLocked(nsecs_t currentTime, const sp<Connection>& connection,
             uint32_t seq, bool handled);
     void abortBrokenDispatchCycleLocked(nsecs_t currentTime, const sp<Connection>& connection,
@@ -1110,6 +1324,8 @@ private:
     bool afterMotionEventLockedInterruptible(const sp<Connection>& connection,
             DispatchEntry* dispatchEntry, MotionEntry* motionEntry, bool handled);
     void doPokeUserActivityLockedInterruptible(CommandEntry* commandEntry);
+    void doNotifyInjectionFinishedLockedInterruptible(CommandEntry* commandEntry);
+    void doInterceptScheduledInjectionLockedInterruptible(CommandEntry* commandEntry);
     void initializeKeyEvent(KeyEvent* event, const KeyEntry* entry);
 
     // Statistics gathering.
@@ -1127,6 +1343,7 @@ public:
     ~InputDispatcherThread();
 
 private:
+    virtual status_t readyToRun();
     virtual bool threadLoop();
 
     sp<InputDispatcherInterface> mDispatcher;
@@ -502,7 +502,16 @@ void InputReader::handleConfigurationChangedLocked(nsecs_t when) {
     mQueuedListener->notifyConfigurationChanged(&args);
 }
 
+static bool isDisplayInfoChanged(const InputReaderConfiguration& oldConfig,
+        const InputReaderConfiguration& newConfig, bool external) {
+    DisplayViewport oldViewport, newViewport;
+    bool hadDisplay = oldConfig.getDisplayInfo(external, &oldViewport);
+    bool hasDisplay = newConfig.getDisplayInfo(external, &newViewport);
+    return hadDisplay != hasDisplay || (hasDisplay && oldViewport != newViewport);
+}
+
 void InputReader::refreshConfigurationLocked(uint32_t changes) {
+    InputReaderConfiguration oldConfig(mConfig);
     mPolicy->getReaderConfiguration(&mConfig);
     mEventHub->setExcludedDevices(mConfig.excludedDeviceNames);
 
@@ -513,9 +522,22 @@ void InputReader::refreshConfigurationLocked(uint32_t changes) {
         if (changes & InputReaderConfiguration::CHANGE_MUST_REOPEN) {
             mEventHub->requestReopenDevices();
         } else {
+            // Only reconfigure the devices the changes concern: rotating one
+            // display should not stall every keyboard and touch pad.
+            bool internalDisplayChanged = false;
+            bool externalDisplayChanged = false;
+            if (changes & InputReaderConfiguration::CHANGE_DISPLAY_INFO) {
+                internalDisplayChanged = isDisplayInfoChanged(oldConfig, mConfig, false);
+                externalDisplayChanged = isDisplayInfoChanged(oldConfig, mConfig, true);
+            }
+
             for (size_t i = 0; i < mDevices.size(); i++) {
                 InputDevice* device = mDevices.valueAt(i);
-                device->configure(now, &mConfig, changes);
+                uint32_t deviceChanges = device->getRelevantConfigurationChanges(changes,
+                        internalDisplayChanged, externalDisplayChanged);
+                if (deviceChanges) {
+                    device->configure(now, &mConfig, deviceChanges);
+                }
             }
         }
     }
@@ -948,6 +970,35 @@ void InputDevice::configure(nsecs_t when, const InputReaderConfiguration* config
     }
 }
 
+uint32_t InputDevice::getRelevantConfigurationChanges(uint32_t changes,
+        bool internalDisplayChanged, bool externalDisplayChanged) {
+    if (isIgnored()) {
+        return 0;
+    }
+
+    uint32_t relevantChanges = 0;
+    if (!(mClasses & INPUT_DEVICE_CLASS_VIRTUAL)) {
+        relevantChanges |= changes & InputReaderConfiguration::CHANGE_DEVICE_ALIAS;
+        // Only devices with a key map can have a keyboard layout overlay.
+        if (mClasses & (INPUT_DEVICE_CLASS_KEYBOARD | INPUT_DEVICE_CLASS_JOYSTICK)) {
+            relevantChanges |= changes & InputReaderConfiguration::CHANGE_KEYBOARD_LAYOUTS;
+        }
+    }
+
+    size_t numMappers = mMappers.size();
+    for (size_t i = 0; i < numMappers; i++) {
+        InputMapper* mapper = mMappers[i];
+        uint32_t mapperChanges = changes & mapper->getConfigurationChangesOfInterest();
+        if ((mapperChanges & InputReaderConfiguration::CHANGE_DISPLAY_INFO)
+                && !(internalDisplayChanged && mapper->usesDisplay(false))
+                && !(externalDisplayChanged && mapper->usesDisplay(true))) {
+            mapperChanges &= ~InputReaderConfiguration::CHANGE_DISPLAY_INFO;
+        }
+        relevantChanges |= mapperChanges;
+    }
+    return relevantChanges;
+}
+
 void InputDevice::reset(nsecs_t when) {
     size_t numMappers = mMappers.size();
     for (size_t i = 0; i < numMappers; i++) {
@@ -1756,6 +1807,14 @@ void InputMapper::configure(nsecs_t when,
         const InputReaderConfiguration* config, uint32_t changes) {
 }
 
+uint32_t InputMapper::getConfigurationChangesOfInterest() {
+    return 0;
+}
+
+bool InputMapper::usesDisplay(bool external) {
+    return false;
+}
+
 void InputMapper::reset(nsecs_t when) {
 }
 
@@ -2038,6 +2097,14 @@ void KeyboardInputMapper::configure(nsecs_t when,
     }
 }
 
+uint32_t KeyboardInputMapper::getConfigurationChangesOfInterest() {
+    return InputReaderConfiguration::CHANGE_DISPLAY_INFO;
+}
+
+bool KeyboardInputMapper::usesDisplay(bool external) {
+    return !external && mParameters.orientationAware && mParameters.hasAssociatedDisplay;
+}
+
 void KeyboardInputMapper::configureParameters() {
     mParameters.orientationAware = false;
     getDevice()->getConfiguration().tryGetProperty(String8("keyboard.orientationAware"),
@@ -2365,6 +2432,16 @@ void CursorInputMapper::configure(nsecs_t when,
     }
 }
 
+uint32_t CursorInputMapper::getConfigurationChangesOfInterest() {
+    return InputReaderConfiguration::CHANGE_POINTER_SPEED
+            | InputReaderConfiguration::CHANGE_DISPLAY_INFO;
+}
+
+bool CursorInputMapper::usesDisplay(bool external) {
+    // The pointer controller of a mouse follows the internal display too.
+    return !external && mParameters.hasAssociatedDisplay;
+}
+
 void CursorInputMapper::configureParameters() {
     mParameters.mode = Parameters::MODE_POINTER;
     String8 cursorModeString;
@@ -2795,6 +2872,19 @@ void TouchInputMapper::configure(nsecs_t when,
     }
 }
 
+uint32_t TouchInputMapper::getConfigurationChangesOfInterest() {
+    return InputReaderConfiguration::TOUCH_AFFINE_TRANSFORMATION
+            | InputReaderConfiguration::CHANGE_POINTER_SPEED
+            | InputReaderConfiguration::CHANGE_DISPLAY_INFO
+            | InputReaderConfiguration::CHANGE_POINTER_GESTURE_ENABLEMENT
+            | InputReaderConfiguration::CHANGE_SHOW_TOUCHES;
+}
+
+bool TouchInputMapper::usesDisplay(bool external) {
+    return mParameters.hasAssociatedDisplay
+            && mParameters.associatedDisplayIsExternal == external;
+}
+
 void TouchInputMapper::configureParameters() {
     // Use the pointer presentation mode for devices that do not support distinct
     // multitouch.  The spot-based presentation relies on being able to accurately
@@ -3680,6 +3770,53 @@ void TouchInputMapper::dumpAffineTransformation(String8& dump) {
 void TouchInputMapper::updateAffineTransformation() {
     mAffineTransform = getPolicy()->getTouchAffineTransformation(mDevice->getDescriptor(),
             mSurfaceOrientation);
+
+    // Map the raw axes onto the surface, rotating them to match its orientation.
+    const float xOffset = mXTranslate - mRawPointerAxes.x.minValue * mXScale;
+    const float xFlippedOffset = mXTranslate + mRawPointerAxes.x.maxValue * mXScale;
+    const float yOffset = mYTranslate - mRawPointerAxes.y.minValue * mYScale;
+    const float yFlippedOffset = mYTranslate + mRawPointerAxes.y.maxValue * mYScale;
+    switch (mSurfaceOrientation) {
+    case DISPLAY_ORIENTATION_90:
+        mRawToSurfaceTransform = TouchAffineTransformation(0, mYScale, yOffset,
+                -mXScale, 0, xFlippedOffset);
+        mCoverageSwapX = false;
+        mCoverageSwapY = true;
+        mOrientationOffset = -M_PI_2;
+        break;
+    case DISPLAY_ORIENTATION_180:
+        mRawToSurfaceTransform = TouchAffineTransformation(-mXScale, 0, xFlippedOffset,
+                0, -mYScale, yFlippedOffset);
+        mCoverageSwapX = true;
+        mCoverageSwapY = true;
+        mOrientationOffset = -M_PI;
+        break;
+    case DISPLAY_ORIENTATION_270:
+        mRawToSurfaceTransform = TouchAffineTransformation(0, -mYScale, yFlippedOffset,
+                mXScale, 0, xOffset);
+        mCoverageSwapX = true;
+        mCoverageSwapY = false;
+        mOrientationOffset = M_PI_2;
+        break;
+    default:
+        mRawToSurfaceTransform = TouchAffineTransformation(mXScale, 0, xOffset,
+                0, mYScale, yOffset);
+        mCoverageSwapX = false;
+        mCoverageSwapY = false;
+        mOrientationOffset = 0;
+        break;
+    }
+
+    // Then fold in the calibration, which applies to the raw coordinates.
+    const TouchAffineTransformation& s = mRawToSurfaceTransform;
+    const TouchAffineTransformation& c = mAffineTransform;
+    mCookedTransform = TouchAffineTransformation(
+            s.x_scale * c.x_scale + s.x_ymix * c.y_xmix,
+            s.x_scale * c.x_ymix + s.x_ymix * c.y_scale,
+            s.x_scale * c.x_offset + s.x_ymix * c.y_offset + s.x_offset,
+            s.y_xmix * c.x_scale + s.y_scale * c.y_xmix,
+            s.y_xmix * c.x_ymix + s.y_scale * c.y_scale,
+            s.y_xmix * c.x_offset + s.y_scale * c.y_offset + s.y_offset);
 }
 
 void TouchInputMapper::reset(nsecs_t when) {
@@ -4297,60 +4434,29 @@ void TouchInputMapper::cookPointerData() {
             break;
         }
 
-        // Adjust X,Y coords for device calibration
-        // TODO: Adjust coverage coords?
-        float xTransformed = in.x, yTransformed = in.y;
-        mAffineTransform.applyTo(xTransformed, yTransformed);
+        // Adjust X, Y, and coverage coords for device calibration and surface orientation.
+        // TODO: Adjust coverage coords for device calibration?
+        float x = in.x, y = in.y;
+        mCookedTransform.applyTo(x, y);
 
-        // Adjust X, Y, and coverage coords for surface orientation.
-        float x, y;
-        float left, top, right, bottom;
+        float left = rawLeft, top = rawTop;
+        float right = rawRight, bottom = rawBottom;
+        mRawToSurfaceTransform.applyTo(left, top);
+        mRawToSurfaceTransform.applyTo(right, bottom);
+        if (mCoverageSwapX) {
+            swap(left, right);
+        }
+        if (mCoverageSwapY) {
+            swap(top, bottom);
+        }
 
-        switch (mSurfaceOrientation) {
-        case DISPLAY_ORIENTATION_90:
-            x = float(yTransformed - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-            y = float(mRawPointerAxes.x.maxValue - xTransformed) * mXScale + mXTranslate;
-            left = float(rawTop - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-            right = float(rawBottom- mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-            bottom = float(mRawPointerAxes.x.maxValue - rawLeft) * mXScale + mXTranslate;
-            top = float(mRawPointerAxes.x.maxValue - rawRight) * mXScale + mXTranslate;
-            orientation -= M_PI_2;
-            if (orientation < mOrientedRanges.orientation.min) {
-                orientation += (mOrientedRanges.orientation.max - mOrientedRanges.orientation.min);
-            }
-            break;
-        case DISPLAY_ORIENTATION_180:
-            x = float(mRawPointerAxes.x.maxValue - xTransformed) * mXScale + mXTranslate;
-            y = float(mRawPointerAxes.y.maxValue - yTransformed) * mYScale + mYTranslate;
-            left = float(mRawPointerAxes.x.maxValue - rawRight) * mXScale + mXTranslate;
-            right = float(mRawPointerAxes.x.maxValue - rawLeft) * mXScale + mXTranslate;
-            bottom = float(mRawPointerAxes.y.maxValue - rawTop) * mYScale + mYTranslate;
-            top = float(mRawPointerAxes.y.maxValue - rawBottom) * mYScale + mYTranslate;
-            orientation -= M_PI;
+        if (mOrientationOffset) {
+            orientation += mOrientationOffset;
             if (orientation < mOrientedRanges.orientation.min) {
                 orientation += (mOrientedRanges.orientation.max - mOrientedRanges.orientation.min);
-            }
-            break;
-        case DISPLAY_ORIENTATION_270:
-            x = float(mRawPointerAxes.y.maxValue - yTransformed) * mYScale + mYTranslate;
-            y = float(xTransformed - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-            left = float(mRawPointerAxes.y.maxValue - rawBottom) * mYScale + mYTranslate;
-            right = float(mRawPointerAxes.y.maxValue - rawTop) * mYScale + mYTranslate;
-            bottom = float(rawRight - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-            top = float(rawLeft - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-            orientation += M_PI_2;
-            if (orientation > mOrientedRanges.orientation.max) {
+            } else if (orientation > mOrientedRanges.orientation.max) {
                 orientation -= (mOrientedRanges.orientation.max - mOrientedRanges.orientation.min);
             }
-            break;
-        default:
-            x = float(xTransformed - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-            y = float(yTransformed - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-            left = float(rawLeft - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-            right = float(rawRight - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-            bottom = float(rawBottom - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-            top = float(rawTop - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-            break;
         }
 
         // Write output coords.
@@ -6201,7 +6307,9 @@ bool MultiTouchInputMapper::hasStylus() const {
 // --- JoystickInputMapper ---
 
 JoystickInputMapper::JoystickInputMapper(InputDevice* device) :
-        InputMapper(device) {
+        InputMapper(device),
+        mLastEventTime(LLONG_MIN), mSyncPending(false), mPendingSyncTime(0) {
+    memset(mAxisIndices, -1, sizeof(mAxisIndices));
 }
 
 JoystickInputMapper::~JoystickInputMapper() {
@@ -6254,6 +6362,7 @@ int32_t JoystickInputMapper::getCompatAxis(int32_t axis) {
 
 void JoystickInputMapper::dump(String8& dump) {
     dump.append(INDENT2 "Joystick Input Mapper:\n");
+    dumpParameters(dump);
 
     dump.append(INDENT3 "Axes:\n");
     size_t numAxes = mAxes.size();
@@ -6294,6 +6403,9 @@ void JoystickInputMapper::configure(nsecs_t when,
     InputMapper::configure(when, config, changes);
 
     if (!changes) { // first time only
+        // Configure basic parameters.
+        configureParameters();
+
         // Collect all axes.
         for (int32_t abs = 0; abs <= ABS_MAX; abs++) {
             if (!(getAbsAxisUsage(abs, getDevice()->getClasses())
@@ -6345,6 +6457,10 @@ void JoystickInputMapper::configure(nsecs_t when,
                 // in axis values up front.
                 axis.filter = axis.fuzz ? axis.fuzz : axis.flat * 0.25f;
 
+                if (axisInfo.mode != AxisInfo::MODE_SPLIT && isCenteredAxis(axisInfo.axis)) {
+                    axis.deadband = mParameters.deadband;
+                }
+
                 mAxes.add(abs, axis);
             }
         }
@@ -6381,9 +6497,42 @@ void JoystickInputMapper::configure(nsecs_t when,
                 }
             }
         }
+
+        memset(mAxisIndices, -1, sizeof(mAxisIndices));
+        for (size_t i = 0; i < mAxes.size(); i++) {
+            mAxisIndices[mAxes.keyAt(i)] = i;
+        }
+    }
+}
+
+void JoystickInputMapper::configureParameters() {
+    mParameters.deadband = 0;
+    getDevice()->getConfiguration().tryGetProperty(String8("joystick.deadband"),
+            mParameters.deadband);
+    if (mParameters.deadband < 0 || mParameters.deadband >= 1) {
+        ALOGW("Invalid value for joystick.deadband: %f", mParameters.deadband);
+        mParameters.deadband = 0;
+    }
+
+    mParameters.minEventInterval = 0;
+    int32_t maxEventRate;
+    if (getDevice()->getConfiguration().tryGetProperty(String8("joystick.maxEventRate"),
+            maxEventRate)) {
+        if (maxEventRate > 0) {
+            mParameters.minEventInterval = 1000000000LL / maxEventRate;
+        } else {
+            ALOGW("Invalid value for joystick.maxEventRate: %d", maxEventRate);
+        }
     }
 }
 
+void JoystickInputMapper::dumpParameters(String8& dump) {
+    dump.append(INDENT3 "Parameters:\n");
+    dump.appendFormat(INDENT4 "Deadband: %0.3f\n", mParameters.deadband);
+    dump.appendFormat(INDENT4 "MinEventInterval: %0.3fms\n",
+            mParameters.minEventInterval * 0.000001f);
+}
+
 bool JoystickInputMapper::haveAxis(int32_t axisId) {
     size_t numAxes = mAxes.size();
     for (size_t i = 0; i < numAxes; i++) {
@@ -6436,13 +6585,17 @@ void JoystickInputMapper::reset(nsecs_t when) {
         axis.resetValue();
     }
 
+    mLastEventTime = LLONG_MIN;
+    mSyncPending = false;
+
     InputMapper::reset(when);
 }
 
 void JoystickInputMapper::process(const RawEvent* rawEvent) {
     switch (rawEvent->type) {
     case EV_ABS: {
-        ssize_t index = mAxes.indexOfKey(rawEvent->code);
+        ssize_t index = rawEvent->code >= 0 && rawEvent->code <= ABS_MAX
+                ? mAxisIndices[rawEvent->code] : -1;
         if (index >= 0) {
             Axis& axis = mAxes.editValueAt(index);
             float newValue, highNewValue;
@@ -6471,6 +6624,9 @@ void JoystickInputMapper::process(const RawEvent* rawEvent) {
                 highNewValue = 0.0f;
                 break;
             }
+            if (fabs(newValue) < axis.deadband) {
+                newValue = 0.0f;
+            }
             axis.newValue = newValue;
             axis.highNewValue = highNewValue;
         }
@@ -6480,17 +6636,35 @@ void JoystickInputMapper::process(const RawEvent* rawEvent) {
     case EV_SYN:
         switch (rawEvent->code) {
         case SYN_REPORT:
-            sync(rawEvent->when, false /*force*/);
+            sync(rawEvent->when, false /*force*/, rawEvent->when);
             break;
         }
         break;
     }
 }
 
-void JoystickInputMapper::sync(nsecs_t when, bool force) {
+void JoystickInputMapper::timeoutExpired(nsecs_t when) {
+    if (mSyncPending) {
+        sync(mPendingSyncTime, false /*force*/, when);
+    }
+}
+
+void JoystickInputMapper::sync(nsecs_t when, bool force, nsecs_t now) {
+    if (!force && mParameters.minEventInterval
+            && now < mLastEventTime + mParameters.minEventInterval) {
+        // Too soon after the last event: hold on to the new values, the next
+        // sync or the timeout sends them in one event.
+        mSyncPending = true;
+        mPendingSyncTime = when;
+        getContext()->requestTimeoutAtTime(mLastEventTime + mParameters.minEventInterval);
+        return;
+    }
+    mSyncPending = false;
+
     if (!filterAxes(force)) {
         return;
     }
+    mLastEventTime = now;
 
     int32_t metaState = mContext->getGlobalMetaState();
     int32_t buttonState = 0;
@@ -476,8 +476,9 @@ private:
 
     InputReaderConfiguration mConfig;
 
-    // The event queue.
-    static const int EVENT_BUFFER_SIZE = 256;
+    // The event queue. Large enough for a few reports of a high rate
+    // multi-touch panel from each of several devices.
+    static const int EVENT_BUFFER_SIZE = 1024;
     RawEvent mEventBuffer[EVENT_BUFFER_SIZE];
 
     KeyedVector<int32_t, InputDevice*> mDevices;
@@ -560,6 +561,10 @@ public:
     void dump(String8& dump);
     void addMapper(InputMapper* mapper);
     void configure(nsecs_t when, const InputReaderConfiguration* config, uint32_t changes);
+    // Returns the part of the changes the device must be reconfigured for, given
+    // whether the viewport of the internal and external displays changed.
+    uint32_t getRelevantConfigurationChanges(uint32_t changes,
+            bool internalDisplayChanged, bool externalDisplayChanged);
     void reset(nsecs_t when);
     void process(const RawEvent* rawEvents, size_t count);
     void timeoutExpired(nsecs_t when);
@@ -965,6 +970,13 @@ public:
     virtual void process(const RawEvent* rawEvent) = 0;
     virtual void timeoutExpired(nsecs_t when);
 
+    // The configuration changes the mapper reacts to, and whether it depends on
+    // the viewport of the internal or external display. The reader skips
+    // reconfiguring devices a change does not concern, so mappers acting on
+    // changes in configure() must report them here.
+    virtual uint32_t getConfigurationChangesOfInterest();
+    virtual bool usesDisplay(bool external);
+
     virtual int32_t getKeyCodeState(uint32_t sourceMask, int32_t keyCode);
     virtual int32_t getScanCodeState(uint32_t sourceMask, int32_t scanCode);
     virtual int32_t getSwitchState(uint32_t sourceMask, int32_t switchCode);
@@ -1048,6 +1060,8 @@ public:
     virtual void populateDeviceInfo(InputDeviceInfo* deviceInfo);
     virtual void dump(String8& dump);
     virtual void configure(nsecs_t when, const InputReaderConfiguration* config, uint32_t changes);
+    virtual uint32_t getConfigurationChangesOfInterest();
+    virtual bool usesDisplay(bool external);
     virtual void reset(nsecs_t when);
     virtual void process(const RawEvent* rawEvent);
 
@@ -1117,6 +1131,8 @@ public:
     virtual void populateDeviceInfo(InputDeviceInfo* deviceInfo);
     virtual void dump(String8& dump);
     virtual void configure(nsecs_t when, const InputReaderConfiguration* config, uint32_t changes);
+    virtual uint32_t getConfigurationChangesOfInterest();
+    virtual bool usesDisplay(bool external);
     virtual void reset(nsecs_t when);
     virtual void process(const RawEvent* rawEvent);
 
@@ -1182,6 +1198,8 @@ public:
     virtual void populateDeviceInfo(InputDeviceInfo* deviceInfo);
     virtual void dump(String8& dump);
     virtual void configure(nsecs_t when, const InputReaderConfiguration* config, uint32_t changes);
+    virtual uint32_t getConfigurationChangesOfInterest();
+    virtual bool usesDisplay(bool external);
     virtual void reset(nsecs_t when);
     virtual void process(const RawEvent* rawEvent);
 
@@ -1331,6 +1349,15 @@ protected:
     // Affine location transformation/calibration
     struct TouchAffineTransformation mAffineTransform;
 
+    // Maps raw coordinates onto surface coordinates for the current surface orientation,
+    // without and with the calibration above applied first, so that cooking a pointer
+    // doesn't depend on the orientation.  Updated by updateAffineTransformation().
+    TouchAffineTransformation mRawToSurfaceTransform;
+    TouchAffineTransformation mCookedTransform;
+    bool mCoverageSwapX; // the surface transform swaps the left and right coverage bounds
+    bool mCoverageSwapY; // the surface transform swaps the top and bottom coverage bounds
+    float mOrientationOffset; // added to the orientation of each pointer
+
     // Raw pointer axis information from the driver.
     RawPointerAxes mRawPointerAxes;
 
@@ -1778,8 +1805,20 @@ public:
     virtual void configure(nsecs_t when, const InputReaderConfiguration* config, uint32_t changes);
     virtual void reset(nsecs_t when);
     virtual void process(const RawEvent* rawEvent);
+    virtual void timeoutExpired(nsecs_t when);
 
 private:
+    // Immutable configuration parameters.
+    struct Parameters {
+        // Normalized distance from the center within which centered axes
+        // report 0.
+        float deadband;
+
+        // Minimum time between two motion events, 0 if unlimited. Axis
+        // changes arriving sooner are coalesced into the next event.
+        nsecs_t minEventInterval;
+    } mParameters;
+
     struct Axis {
         RawAbsoluteAxisInfo rawAxisInfo;
         AxisInfo axisInfo;
@@ -1798,6 +1837,7 @@ private:
         float resolution; // normalized resolution in units/mm
 
         float filter;  // filter out small variations of this size
+        float deadband; // values within this distance of 0 are reported as 0
         float currentValue; // current value
         float newValue; // most recent value
         float highCurrentValue; // current value of high split
@@ -1820,6 +1860,7 @@ private:
             this->fuzz = fuzz;
             this->resolution = resolution;
             this->filter = 0;
+            this->deadband = 0;
             resetValue();
         }
 
@@ -1834,7 +1875,18 @@ private:
     // Axes indexed by raw ABS_* axis index.
     KeyedVector<int32_t, Axis> mAxes;
 
-    void sync(nsecs_t when, bool force);
+    // Index in mAxes of each raw ABS_* axis, or -1, so that the events of
+    // high rate controllers skip the binary search.
+    int8_t mAxisIndices[ABS_CNT];
+
+    nsecs_t mLastEventTime;
+    bool mSyncPending;
+    nsecs_t mPendingSyncTime;
+
+    void configureParameters();
+    void dumpParameters(String8& dump);
+
+    void sync(nsecs_t when, bool force, nsecs_t now);
 
     bool haveAxis(int32_t axisId);
     void pruneAxes(bool ignoreExplicitlyMappedAxes);
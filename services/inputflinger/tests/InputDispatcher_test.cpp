@@ -30,10 +30,20 @@ static const int32_t DEVICE_ID = 1;
 // An arbitrary display id.
 static const int32_t DISPLAY_ID = 0;
 
+// A display other than DISPLAY_ID.
+static const int32_t SECOND_DISPLAY_ID = 1;
+
 // An arbitrary injector pid / uid pair that has permission to inject events.
 static const int32_t INJECTOR_PID = 999;
 static const int32_t INJECTOR_UID = 1001;
 
+// The size of the fake windows.
+static const int32_t WINDOW_WIDTH = 480;
+static const int32_t WINDOW_HEIGHT = 800;
+
+// A dispatching timeout long enough that no test runs into it by accident.
+static const nsecs_t DISPATCHING_TIMEOUT = seconds_to_nanoseconds(5);
+
 
 // --- FakeInputDispatcherPolicy ---
 
@@ -45,7 +55,13 @@ protected:
     }
 
 public:
-    FakeInputDispatcherPolicy() {
+    bool passToUser; // whether intercepted events are passed on to the windows
+    int32_t interceptCount; // calls to interceptKey/MotionBeforeQueueing
+    int32_t anrCount; // calls to notifyANR
+    nsecs_t anrTimeout; // returned by notifyANR, 0 to give up waiting
+
+    FakeInputDispatcherPolicy() :
+            passToUser(false), interceptCount(0), anrCount(0), anrTimeout(0) {
     }
 
 private:
@@ -55,7 +71,8 @@ private:
     virtual nsecs_t notifyANR(const sp<InputApplicationHandle>& inputApplicationHandle,
             const sp<InputWindowHandle>& inputWindowHandle,
             const String8& reason) {
-        return 0;
+        anrCount += 1;
+        return anrTimeout;
     }
 
     virtual void notifyInputChannelBroken(const sp<InputWindowHandle>& inputWindowHandle) {
@@ -70,9 +87,17 @@ private:
     }
 
     virtual void interceptKeyBeforeQueueing(const KeyEvent* keyEvent, uint32_t& policyFlags) {
+        interceptCount += 1;
+        if (passToUser) {
+            policyFlags |= POLICY_FLAG_PASS_TO_USER;
+        }
     }
 
     virtual void interceptMotionBeforeQueueing(nsecs_t when, uint32_t& policyFlags) {
+        interceptCount += 1;
+        if (passToUser) {
+            policyFlags |= POLICY_FLAG_PASS_TO_USER;
+        }
     }
 
     virtual nsecs_t interceptKeyBeforeDispatching(const sp<InputWindowHandle>& inputWindowHandle,
@@ -99,12 +124,157 @@ private:
 };
 
 
+// --- FakeInputInjectionCallback ---
+
+class FakeInputInjectionCallback : public InputInjectionCallback {
+protected:
+    virtual ~FakeInputInjectionCallback() {
+    }
+
+public:
+    int32_t callCount;
+    int32_t lastInjectionResult;
+    size_t lastInjectedCount;
+
+    FakeInputInjectionCallback() :
+            callCount(0), lastInjectionResult(INPUT_EVENT_INJECTION_PENDING),
+            lastInjectedCount(0) {
+    }
+
+    virtual void onInjectionFinished(int32_t injectionResult, size_t injectedCount) {
+        callCount += 1;
+        lastInjectionResult = injectionResult;
+        lastInjectedCount = injectedCount;
+    }
+};
+
+
+// --- FakeApplicationHandle ---
+
+class FakeApplicationHandle : public InputApplicationHandle {
+protected:
+    virtual ~FakeApplicationHandle() {
+    }
+
+public:
+    FakeApplicationHandle() {
+    }
+
+    virtual bool updateInfo() {
+        if (!mInfo) {
+            mInfo = new InputApplicationInfo();
+        }
+        mInfo->name = String8("Fake Application");
+        mInfo->dispatchingTimeout = DISPATCHING_TIMEOUT;
+        return true;
+    }
+};
+
+
+// --- FakeWindowHandle ---
+
+// A full-size window with its own input channel pair; the test consumes the events sent
+// to it through consumer.
+class FakeWindowHandle : public InputWindowHandle {
+    sp<InputChannel> mServerChannel;
+    sp<InputChannel> mClientChannel;
+    String8 mName;
+    int32_t mDisplayId;
+
+protected:
+    virtual ~FakeWindowHandle() {
+        delete consumer;
+    }
+
+public:
+    InputConsumer* consumer;
+    PreallocatedInputEventFactory eventFactory;
+    // Picked up the next time the windows are set.
+    bool focused;
+    bool paused;
+    nsecs_t dispatchingTimeout;
+
+    FakeWindowHandle(const sp<InputApplicationHandle>& inputApplicationHandle,
+            const char* name, int32_t displayId) :
+            InputWindowHandle(inputApplicationHandle), mName(name), mDisplayId(displayId),
+            focused(true), paused(false), dispatchingTimeout(DISPATCHING_TIMEOUT) {
+        InputChannel::openInputChannelPair(mName, mServerChannel, mClientChannel);
+        consumer = new InputConsumer(mClientChannel);
+    }
+
+    const sp<InputChannel>& getServerChannel() const {
+        return mServerChannel;
+    }
+
+    virtual bool updateInfo() {
+        if (!mInfo) {
+            mInfo = new InputWindowInfo();
+        }
+        mInfo->inputChannel = mServerChannel;
+        mInfo->name = mName;
+        mInfo->layoutParamsFlags = 0;
+        mInfo->layoutParamsPrivateFlags = 0;
+        mInfo->layoutParamsType = InputWindowInfo::TYPE_APPLICATION;
+        mInfo->dispatchingTimeout = dispatchingTimeout;
+        mInfo->frameLeft = 0;
+        mInfo->frameTop = 0;
+        mInfo->frameRight = WINDOW_WIDTH;
+        mInfo->frameBottom = WINDOW_HEIGHT;
+        mInfo->scaleFactor = 1.0f;
+        mInfo->touchableRegion = Region(Rect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT));
+        mInfo->visible = true;
+        mInfo->canReceiveKeys = true;
+        mInfo->hasFocus = focused;
+        mInfo->hasWallpaper = false;
+        mInfo->paused = paused;
+        mInfo->layer = 0;
+        mInfo->ownerPid = INJECTOR_PID;
+        mInfo->ownerUid = INJECTOR_UID;
+        mInfo->inputFeatures = 0;
+        mInfo->displayId = mDisplayId;
+        return true;
+    }
+
+    // Consumes the next event sent to the window, if there is one, without finishing it.
+    // Returns its sequence number, or 0 if there is none.
+    uint32_t consumeEvent(InputEvent** outEvent = NULL) {
+        uint32_t seq = 0;
+        InputEvent* event = NULL;
+        if (consumer->consume(&eventFactory, true, -1, &seq, &event) != OK) {
+            return 0;
+        }
+        if (outEvent) {
+            *outEvent = event;
+        }
+        return seq;
+    }
+
+    // Consumes and finishes all of the events that were sent to the window so far.
+    // Returns the number of motion samples in them, and the time of the last one.
+    size_t consumeAndFinishMotions(nsecs_t* outLastEventTime) {
+        size_t sampleCount = 0;
+        InputEvent* event;
+        uint32_t seq;
+        while ((seq = consumeEvent(&event)) != 0) {
+            if (event->getType() == AINPUT_EVENT_TYPE_MOTION) {
+                MotionEvent* motionEvent = static_cast<MotionEvent*>(event);
+                sampleCount += motionEvent->getHistorySize() + 1;
+                *outLastEventTime = motionEvent->getEventTime();
+            }
+            consumer->sendFinishedSignal(seq, true);
+        }
+        return sampleCount;
+    }
+};
+
+
 // --- InputDispatcherTest ---
 
 class InputDispatcherTest : public testing::Test {
 protected:
     sp<FakeInputDispatcherPolicy> mFakePolicy;
     sp<InputDispatcher> mDispatcher;
+    Vector<sp<InputWindowHandle> > mWindows;
 
     virtual void SetUp() {
         mFakePolicy = new FakeInputDispatcherPolicy();
@@ -112,9 +282,65 @@ protected:
     }
 
     virtual void TearDown() {
+        for (size_t i = 0; i < mWindows.size(); i++) {
+            mDispatcher->unregisterInputChannel(mWindows[i]->getInputChannel());
+        }
+        mWindows.clear();
         mFakePolicy.clear();
         mDispatcher.clear();
     }
+
+    // Adds a window on top of the others and registers its channel, with the policy
+    // passing all events on to windows.
+    sp<FakeWindowHandle> addWindow(const sp<InputApplicationHandle>& application,
+            const char* name, int32_t displayId) {
+        sp<FakeWindowHandle> window = new FakeWindowHandle(application, name, displayId);
+        mDispatcher->registerInputChannel(window->getServerChannel(), window, false);
+        mWindows.insertAt(window, 0);
+        mDispatcher->setInputWindows(mWindows);
+        mDispatcher->setInputDispatchMode(true, false);
+        mFakePolicy->passToUser = true;
+        return window;
+    }
+
+    // Runs the dispatch loop a few times.  Setting the windows again wakes the loop up,
+    // so that it doesn't block waiting for events when there is nothing left to do.
+    void dispatch(int iterations = 4) {
+        for (int i = 0; i < iterations; i++) {
+            mDispatcher->setInputWindows(mWindows);
+            mDispatcher->dispatchOnce();
+        }
+    }
+
+    // Injects a touch in the fake windows asynchronously.
+    int32_t injectMotion(int32_t displayId, int32_t action, nsecs_t downTime,
+            nsecs_t eventTime) {
+        MotionEvent event;
+        PointerProperties pointerProperties;
+        PointerCoords pointerCoords;
+        pointerProperties.clear();
+        pointerProperties.id = 0;
+        pointerProperties.toolType = AMOTION_EVENT_TOOL_TYPE_FINGER;
+        pointerCoords.clear();
+        pointerCoords.setAxisValue(AMOTION_EVENT_AXIS_X, WINDOW_WIDTH / 2);
+        pointerCoords.setAxisValue(AMOTION_EVENT_AXIS_Y, WINDOW_HEIGHT / 2);
+        event.initialize(DEVICE_ID, AINPUT_SOURCE_TOUCHSCREEN,
+                action, 0, 0, AMETA_NONE, 0, 0, 0, 0, 0,
+                downTime, eventTime,
+                /*pointerCount*/ 1, &pointerProperties, &pointerCoords);
+        return mDispatcher->injectInputEvent(&event, displayId,
+                INJECTOR_PID, INJECTOR_UID, INPUT_EVENT_INJECTION_SYNC_NONE, 0, 0);
+    }
+
+    // Injects a key down for the focused window asynchronously.
+    int32_t injectKeyDown(nsecs_t eventTime) {
+        KeyEvent event;
+        event.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+                AKEY_EVENT_ACTION_DOWN, 0,
+                AKEYCODE_A, KEY_A, AMETA_NONE, 0, eventTime, eventTime);
+        return mDispatcher->injectInputEvent(&event, DISPLAY_ID,
+                INJECTOR_PID, INJECTOR_UID, INPUT_EVENT_INJECTION_SYNC_NONE, 0, 0);
+    }
 };
 
 
@@ -255,4 +481,264 @@ TEST_F(InputDispatcherTest, InjectInputEvent_ValidatesMotionEvents) {
             << "Should reject motion events with duplicate pointer ids.";
 }
 
+TEST_F(InputDispatcherTest, InjectInputEvents_RejectsWholeBatchWithAnInvalidEvent) {
+    sp<FakeInputInjectionCallback> callback = new FakeInputInjectionCallback();
+    KeyEvent down, bad;
+    down.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+            AKEY_EVENT_ACTION_DOWN, 0,
+            AKEYCODE_A, KEY_A, AMETA_NONE, 0, ARBITRARY_TIME, ARBITRARY_TIME);
+    bad.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+            /*action*/ -1, 0,
+            AKEYCODE_A, KEY_A, AMETA_NONE, 0, ARBITRARY_TIME, ARBITRARY_TIME);
+    Vector<const InputEvent*> events;
+    events.push(&down);
+    events.push(&bad);
+
+    ASSERT_EQ(INPUT_EVENT_INJECTION_FAILED, mDispatcher->injectInputEvents(
+            events, DISPLAY_ID, INJECTOR_PID, INJECTOR_UID, 0, 0, callback))
+            << "Should reject a batch with an undefined key action in it.";
+
+    mDispatcher->dispatchOnce();
+    ASSERT_EQ(0, callback->callCount)
+            << "Should not call back for a batch that was rejected.";
+}
+
+TEST_F(InputDispatcherTest, InjectInputEvents_CallsBackOnceForTheBatch) {
+    sp<FakeInputInjectionCallback> callback = new FakeInputInjectionCallback();
+    KeyEvent down, up;
+    down.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+            AKEY_EVENT_ACTION_DOWN, 0,
+            AKEYCODE_A, KEY_A, AMETA_NONE, 0, ARBITRARY_TIME, ARBITRARY_TIME);
+    up.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+            AKEY_EVENT_ACTION_UP, 0,
+            AKEYCODE_A, KEY_A, AMETA_NONE, 0, ARBITRARY_TIME, ARBITRARY_TIME);
+    Vector<const InputEvent*> events;
+    events.push(&down);
+    events.push(&up);
+
+    ASSERT_EQ(INPUT_EVENT_INJECTION_PENDING, mDispatcher->injectInputEvents(
+            events, DISPLAY_ID, INJECTOR_PID, INJECTOR_UID, 1000, 0, callback));
+
+    // Without POLICY_FLAG_PASS_TO_USER, the policy consumes both events, which is a success.
+    for (int i = 0; i < 4; i++) {
+        mDispatcher->dispatchOnce();
+    }
+    ASSERT_EQ(1, callback->callCount)
+            << "Should call back once for the whole batch.";
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, callback->lastInjectionResult);
+    ASSERT_EQ(size_t(2), callback->lastInjectedCount);
+}
+
+TEST_F(InputDispatcherTest, InjectInputEvents_WaitsUntilTheTargetFinishes) {
+    sp<FakeApplicationHandle> application = new FakeApplicationHandle();
+    mDispatcher->setFocusedApplication(application);
+    sp<FakeWindowHandle> window = addWindow(application, "Window", DISPLAY_ID);
+
+    sp<FakeInputInjectionCallback> callback = new FakeInputInjectionCallback();
+    const nsecs_t eventTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    KeyEvent down, up;
+    down.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+            AKEY_EVENT_ACTION_DOWN, 0,
+            AKEYCODE_A, KEY_A, AMETA_NONE, 0, eventTime, eventTime);
+    up.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+            AKEY_EVENT_ACTION_UP, 0,
+            AKEYCODE_A, KEY_A, AMETA_NONE, 0, eventTime, eventTime);
+    Vector<const InputEvent*> events;
+    events.push(&down);
+    events.push(&up);
+
+    ASSERT_EQ(INPUT_EVENT_INJECTION_PENDING, mDispatcher->injectInputEvents(
+            events, DISPLAY_ID, INJECTOR_PID, INJECTOR_UID, 5000, 0, callback));
+
+    dispatch();
+    uint32_t downSeq = window->consumeEvent();
+    ASSERT_NE(0U, downSeq);
+    ASSERT_EQ(OK, window->consumer->sendFinishedSignal(downSeq, true));
+    dispatch();
+    uint32_t upSeq = window->consumeEvent();
+    ASSERT_NE(0U, upSeq);
+
+    // Both events have been dispatched successfully, but the last one isn't finished.
+    dispatch();
+    ASSERT_EQ(0, callback->callCount)
+            << "Should not call back before the target finishes the last event.";
+
+    ASSERT_EQ(OK, window->consumer->sendFinishedSignal(upSeq, true));
+    dispatch();
+    ASSERT_EQ(1, callback->callCount)
+            << "Should call back once the target finished the last event.";
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, callback->lastInjectionResult);
+    ASSERT_EQ(size_t(2), callback->lastInjectedCount);
+}
+
+TEST_F(InputDispatcherTest, InjectInputEvents_InterceptsEachEventWhenItIsDue) {
+    sp<FakeInputInjectionCallback> callback = new FakeInputInjectionCallback();
+    const nsecs_t eventTime = systemTime(SYSTEM_TIME_MONOTONIC) + milliseconds_to_nanoseconds(50);
+    KeyEvent down;
+    down.initialize(DEVICE_ID, AINPUT_SOURCE_KEYBOARD,
+            AKEY_EVENT_ACTION_DOWN, 0,
+            AKEYCODE_A, KEY_A, AMETA_NONE, 0, eventTime, eventTime);
+    Vector<const InputEvent*> events;
+    events.push(&down);
+
+    ASSERT_EQ(INPUT_EVENT_INJECTION_PENDING, mDispatcher->injectInputEvents(
+            events, DISPLAY_ID, INJECTOR_PID, INJECTOR_UID, 1000, 0, callback));
+    ASSERT_EQ(0, mFakePolicy->interceptCount)
+            << "Should not let the policy intercept an event before it is due.";
+
+    // The dispatcher sleeps until the event is due.
+    for (int i = 0; i < 10 && mFakePolicy->interceptCount == 0; i++) {
+        mDispatcher->dispatchOnce();
+    }
+    ASSERT_EQ(1, mFakePolicy->interceptCount);
+    ASSERT_GE(systemTime(SYSTEM_TIME_MONOTONIC), eventTime);
+}
+
+TEST_F(InputDispatcherTest, DisplayLanes_ParkedEventDoesNotBlockTheFocusedDisplay) {
+    sp<FakeApplicationHandle> application = new FakeApplicationHandle();
+    mDispatcher->setFocusedApplication(application);
+    sp<FakeWindowHandle> focusedWindow = addWindow(application, "Focused", DISPLAY_ID);
+    sp<FakeWindowHandle> pausedWindow = addWindow(application, "Paused", SECOND_DISPLAY_ID);
+    pausedWindow->focused = false;
+    pausedWindow->paused = true;
+
+    const nsecs_t eventTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectMotion(SECOND_DISPLAY_ID,
+            AMOTION_EVENT_ACTION_DOWN, eventTime, eventTime));
+    dispatch();
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectKeyDown(eventTime));
+    dispatch();
+
+    InputEvent* event = NULL;
+    ASSERT_NE(0U, focusedWindow->consumeEvent(&event))
+            << "Should dispatch to the focused display while the other one waits.";
+    ASSERT_EQ(AINPUT_EVENT_TYPE_KEY, event->getType());
+    ASSERT_EQ(0U, pausedWindow->consumeEvent())
+            << "Should not dispatch to a paused window.";
+}
+
+TEST_F(InputDispatcherTest, DisplayLanes_KeepTheOrderOfTheirEvents) {
+    sp<FakeApplicationHandle> application = new FakeApplicationHandle();
+    mDispatcher->setFocusedApplication(application);
+    addWindow(application, "Focused", DISPLAY_ID);
+    sp<FakeWindowHandle> pausedWindow = addWindow(application, "Paused", SECOND_DISPLAY_ID);
+    pausedWindow->focused = false;
+    pausedWindow->paused = true;
+
+    const nsecs_t downTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    const nsecs_t moveTime = downTime + milliseconds_to_nanoseconds(1);
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectMotion(SECOND_DISPLAY_ID,
+            AMOTION_EVENT_ACTION_DOWN, downTime, downTime));
+    dispatch();
+    // Queued in the lane behind the down, which is still waiting.
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectMotion(SECOND_DISPLAY_ID,
+            AMOTION_EVENT_ACTION_MOVE, downTime, moveTime));
+    dispatch();
+    ASSERT_EQ(0U, pausedWindow->consumeEvent());
+
+    pausedWindow->paused = false;
+    dispatch();
+
+    InputEvent* event = NULL;
+    ASSERT_NE(0U, pausedWindow->consumeEvent(&event));
+    ASSERT_EQ(AINPUT_EVENT_TYPE_MOTION, event->getType());
+    EXPECT_EQ(AMOTION_EVENT_ACTION_DOWN, static_cast<MotionEvent*>(event)->getAction());
+    EXPECT_EQ(downTime, static_cast<MotionEvent*>(event)->getEventTime());
+
+    ASSERT_NE(0U, pausedWindow->consumeEvent(&event));
+    ASSERT_EQ(AINPUT_EVENT_TYPE_MOTION, event->getType());
+    EXPECT_EQ(AMOTION_EVENT_ACTION_MOVE, static_cast<MotionEvent*>(event)->getAction());
+    EXPECT_EQ(moveTime, static_cast<MotionEvent*>(event)->getEventTime());
+}
+
+TEST_F(InputDispatcherTest, DisplayLanes_ANRResponseEndsTheWaitOfItsLane) {
+    sp<FakeApplicationHandle> application = new FakeApplicationHandle();
+    mDispatcher->setFocusedApplication(application);
+    addWindow(application, "Focused", DISPLAY_ID);
+    sp<FakeWindowHandle> pausedWindow = addWindow(application, "Paused", SECOND_DISPLAY_ID);
+    pausedWindow->focused = false;
+    pausedWindow->paused = true;
+    pausedWindow->dispatchingTimeout = milliseconds_to_nanoseconds(20);
+    mFakePolicy->anrTimeout = 0; // give up waiting
+
+    const nsecs_t firstDownTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectMotion(SECOND_DISPLAY_ID,
+            AMOTION_EVENT_ACTION_DOWN, firstDownTime, firstDownTime));
+    dispatch();
+
+    // The dispatcher sleeps until the wait of the lane times out.
+    for (int i = 0; i < 10 && mFakePolicy->anrCount == 0; i++) {
+        mDispatcher->dispatchOnce();
+    }
+    ASSERT_EQ(1, mFakePolicy->anrCount);
+
+    // Had the response gone to the main path, the lane would still be waiting, and
+    // raise the ANR again.
+    dispatch();
+    EXPECT_EQ(1, mFakePolicy->anrCount)
+            << "Should give up the wait of the lane the ANR came from.";
+
+    pausedWindow->paused = false;
+    const nsecs_t secondDownTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectMotion(SECOND_DISPLAY_ID,
+            AMOTION_EVENT_ACTION_DOWN, secondDownTime, secondDownTime));
+    dispatch();
+
+    InputEvent* event = NULL;
+    ASSERT_NE(0U, pausedWindow->consumeEvent(&event));
+    ASSERT_EQ(AINPUT_EVENT_TYPE_MOTION, event->getType());
+    EXPECT_EQ(secondDownTime, static_cast<MotionEvent*>(event)->getEventTime())
+            << "Should have dropped the event the lane gave up on.";
+}
+
+TEST_F(InputDispatcherTest, LaggingMonitor_PendingMoveIsReplacedByTheNextOne) {
+    sp<FakeApplicationHandle> application = new FakeApplicationHandle();
+    mDispatcher->setFocusedApplication(application);
+    sp<FakeWindowHandle> window = addWindow(application, "Window", DISPLAY_ID);
+    // Only used for its channel pair, the monitor never finishes its events here.
+    sp<FakeWindowHandle> monitor = new FakeWindowHandle(application, "Monitor", DISPLAY_ID);
+    mDispatcher->registerInputChannel(monitor->getServerChannel(), NULL, true);
+
+    // Enough samples to fill the socket of the monitor several times over.
+    const size_t moveCount = 300;
+    const nsecs_t downTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    nsecs_t eventTime = downTime;
+    size_t windowSampleCount = 0;
+    nsecs_t windowLastEventTime = 0;
+    ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectMotion(DISPLAY_ID,
+            AMOTION_EVENT_ACTION_DOWN, downTime, eventTime));
+    dispatch(2);
+    windowSampleCount += window->consumeAndFinishMotions(&windowLastEventTime);
+    for (size_t i = 0; i < moveCount; i++) {
+        eventTime += milliseconds_to_nanoseconds(1);
+        ASSERT_EQ(INPUT_EVENT_INJECTION_SUCCEEDED, injectMotion(DISPLAY_ID,
+                AMOTION_EVENT_ACTION_MOVE, downTime, eventTime));
+        dispatch(2);
+        windowSampleCount += window->consumeAndFinishMotions(&windowLastEventTime);
+    }
+
+    EXPECT_EQ(moveCount + 1, windowSampleCount)
+            << "Should never drop the samples sent to a window.";
+    EXPECT_EQ(eventTime, windowLastEventTime);
+
+    // Catch up: what the monitor finishes lets the pending sample through.
+    size_t monitorSampleCount = 0;
+    nsecs_t monitorLastEventTime = 0;
+    for (int i = 0; i < 10; i++) {
+        size_t sampleCount = monitor->consumeAndFinishMotions(&monitorLastEventTime);
+        if (sampleCount == 0) {
+            break;
+        }
+        monitorSampleCount += sampleCount;
+        dispatch(2);
+    }
+
+    EXPECT_LT(monitorSampleCount, moveCount + 1)
+            << "Should drop the pending samples of a monitor whose socket is full.";
+    EXPECT_EQ(eventTime, monitorLastEventTime)
+            << "Should still deliver the latest sample to the monitor.";
+
+    mDispatcher->unregisterInputChannel(monitor->getServerChannel());
+}
+
 } // namespace android
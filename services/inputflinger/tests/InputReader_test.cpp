@@ -794,6 +794,9 @@ class FakeInputMapper : public InputMapper {
     KeyedVector<int32_t, int32_t> mSwitchStates;
     Vector<int32_t> mSupportedKeyCodes;
     RawEvent mLastEvent;
+    uint32_t mConfigurationChangesOfInterest;
+    bool mUsesInternalDisplay;
+    bool mUsesExternalDisplay;
 
     bool mConfigureWasCalled;
     bool mResetWasCalled;
@@ -803,7 +806,8 @@ public:
     FakeInputMapper(InputDevice* device, uint32_t sources) :
             InputMapper(device),
             mSources(sources), mKeyboardType(AINPUT_KEYBOARD_TYPE_NONE),
-            mMetaState(0),
+            mMetaState(0), mConfigurationChangesOfInterest(~0u),
+            mUsesInternalDisplay(true), mUsesExternalDisplay(true),
             mConfigureWasCalled(false), mResetWasCalled(false), mProcessWasCalled(false) {
     }
 
@@ -817,12 +821,26 @@ public:
         mMetaState = metaState;
     }
 
+    void setConfigurationChangesOfInterest(uint32_t changes) {
+        mConfigurationChangesOfInterest = changes;
+    }
+
+    void setUsedDisplays(bool internal, bool external) {
+        mUsesInternalDisplay = internal;
+        mUsesExternalDisplay = external;
+    }
+
     void assertConfigureWasCalled() {
         ASSERT_TRUE(mConfigureWasCalled)
                 << "Expected configure() to have been called.";
         mConfigureWasCalled = false;
     }
 
+    void assertConfigureWasNotCalled() {
+        ASSERT_FALSE(mConfigureWasCalled)
+                << "Expected configure() to not have been called.";
+    }
+
     void assertResetWasCalled() {
         ASSERT_TRUE(mResetWasCalled)
                 << "Expected reset() to have been called.";
@@ -872,6 +890,14 @@ private:
         mConfigureWasCalled = true;
     }
 
+    virtual uint32_t getConfigurationChangesOfInterest() {
+        return mConfigurationChangesOfInterest;
+    }
+
+    virtual bool usesDisplay(bool external) {
+        return external ? mUsesExternalDisplay : mUsesInternalDisplay;
+    }
+
     virtual void reset(nsecs_t when) {
         mResetWasCalled = true;
     }
@@ -1185,6 +1211,41 @@ TEST_F(InputReaderTest, LoopOnce_ForwardsRawEventsToMappers) {
     ASSERT_EQ(1, event.value);
 }
 
+TEST_F(InputReaderTest, RefreshConfiguration_OnlyReconfiguresConcernedDevices) {
+    FakeInputMapper* mapper = NULL;
+    ASSERT_NO_FATAL_FAILURE(mapper = addDeviceWithFakeInputMapper(1, 0, String8("fake"),
+            INPUT_DEVICE_CLASS_KEYBOARD, AINPUT_SOURCE_KEYBOARD, NULL));
+    ASSERT_NO_FATAL_FAILURE(mapper->assertConfigureWasCalled());
+    mapper->setConfigurationChangesOfInterest(InputReaderConfiguration::CHANGE_POINTER_SPEED);
+
+    mReader->requestRefreshConfiguration(InputReaderConfiguration::CHANGE_SHOW_TOUCHES);
+    mReader->loopOnce();
+    ASSERT_NO_FATAL_FAILURE(mapper->assertConfigureWasNotCalled());
+
+    mReader->requestRefreshConfiguration(InputReaderConfiguration::CHANGE_POINTER_SPEED);
+    mReader->loopOnce();
+    ASSERT_NO_FATAL_FAILURE(mapper->assertConfigureWasCalled());
+}
+
+TEST_F(InputReaderTest, RefreshConfiguration_OnlyReconfiguresDevicesOnChangedDisplays) {
+    FakeInputMapper* mapper = NULL;
+    ASSERT_NO_FATAL_FAILURE(mapper = addDeviceWithFakeInputMapper(1, 0, String8("fake"),
+            INPUT_DEVICE_CLASS_TOUCH, AINPUT_SOURCE_TOUCHSCREEN, NULL));
+    ASSERT_NO_FATAL_FAILURE(mapper->assertConfigureWasCalled());
+    mapper->setConfigurationChangesOfInterest(InputReaderConfiguration::CHANGE_DISPLAY_INFO);
+    mapper->setUsedDisplays(false /*internal*/, true /*external*/);
+
+    // Same viewports as before.
+    mReader->requestRefreshConfiguration(InputReaderConfiguration::CHANGE_DISPLAY_INFO);
+    mReader->loopOnce();
+    ASSERT_NO_FATAL_FAILURE(mapper->assertConfigureWasNotCalled());
+
+    mFakePolicy->setDisplayInfo(0, 480, 800, DISPLAY_ORIENTATION_90);
+    mReader->requestRefreshConfiguration(InputReaderConfiguration::CHANGE_DISPLAY_INFO);
+    mReader->loopOnce();
+    ASSERT_NO_FATAL_FAILURE(mapper->assertConfigureWasCalled());
+}
+
 
 // --- InputDeviceTest ---
 
@@ -5150,4 +5211,72 @@ TEST_F(MultiTouchInputMapperTest, Process_WhenAbsMTPressureIsPresent_HoversIfIts
 }
 
 
+
+// --- JoystickInputMapperTest ---
+
+class JoystickInputMapperTest : public InputMapperTest {
+protected:
+    virtual void SetUp() {
+        InputMapperTest::SetUp();
+
+        // Joysticks only claim the axes of devices of the joystick class.
+        delete mDevice;
+        InputDeviceIdentifier identifier;
+        identifier.name = DEVICE_NAME;
+        mDevice = new InputDevice(mFakeContext, DEVICE_ID, DEVICE_GENERATION,
+                DEVICE_CONTROLLER_NUMBER, identifier, INPUT_DEVICE_CLASS_JOYSTICK);
+    }
+
+    void processAxis(JoystickInputMapper* mapper, nsecs_t when, int32_t value) {
+        process(mapper, when, DEVICE_ID, EV_ABS, ABS_X, value);
+        process(mapper, when, DEVICE_ID, EV_SYN, SYN_REPORT, 0);
+    }
+};
+
+TEST_F(JoystickInputMapperTest, Process_ReportsEveryAxisChange) {
+    mFakeEventHub->addAbsoluteAxis(DEVICE_ID, ABS_X, 0, 255, 0, 0);
+    JoystickInputMapper* mapper = new JoystickInputMapper(mDevice);
+    addMapperAndConfigure(mapper);
+
+    NotifyMotionArgs args;
+    processAxis(mapper, ARBITRARY_TIME, 51);
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasCalled(&args));
+    ASSERT_EQ(AINPUT_SOURCE_JOYSTICK, args.source);
+    ASSERT_NEAR(0.2f, args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_GENERIC_1),
+            EPSILON);
+
+    processAxis(mapper, ARBITRARY_TIME + 1000000, 102);
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasCalled(&args));
+    ASSERT_NEAR(0.4f, args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_GENERIC_1),
+            EPSILON);
+}
+
+TEST_F(JoystickInputMapperTest, Process_WhenMaxEventRateIsSet_CoalescesAxisChanges) {
+    mFakeEventHub->addAbsoluteAxis(DEVICE_ID, ABS_X, 0, 255, 0, 0);
+    addConfigurationProperty("joystick.maxEventRate", "100");
+    JoystickInputMapper* mapper = new JoystickInputMapper(mDevice);
+    addMapperAndConfigure(mapper);
+
+    NotifyMotionArgs args;
+    processAxis(mapper, ARBITRARY_TIME, 51);
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasCalled(&args));
+
+    // Within 10ms of the last event: held back.
+    processAxis(mapper, ARBITRARY_TIME + 1000000, 102);
+    processAxis(mapper, ARBITRARY_TIME + 2000000, 153);
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasNotCalled());
+
+    // The timeout sends the latest values in a single event.
+    mapper->timeoutExpired(ARBITRARY_TIME + 10000000);
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasCalled(&args));
+    ASSERT_EQ(ARBITRARY_TIME + 2000000, args.eventTime);
+    ASSERT_NEAR(0.6f, args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_GENERIC_1),
+            EPSILON);
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasNotCalled());
+
+    mapper->timeoutExpired(ARBITRARY_TIME + 30000000);
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasNotCalled());
+}
+
+
 } // namespace android
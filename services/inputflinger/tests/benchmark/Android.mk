@@ -0,0 +1,21 @@
+# Build the input pipeline benchmark.
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    InputPipelineBenchmark.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    liblog \
+    libutils \
+    libui \
+    libinput \
+    libinputflinger
+
+LOCAL_CFLAGS += -Wno-unused-parameter
+
+LOCAL_MODULE := InputPipelineBenchmark
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_EXECUTABLE)
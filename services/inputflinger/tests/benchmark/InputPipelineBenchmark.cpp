@@ -0,0 +1,1130 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Input pipeline benchmark.  Replays evdev event streams through a real
+ * InputReader and InputDispatcher to a full screen window whose events are
+ * consumed with an InputConsumer on another thread, and reports for each
+ * stream:
+ *
+ *  - reader:   from the time the event hub returns an event to the time the
+ *              reader hands the resulting key or motion to the dispatcher
+ *  - dispatch: from there to the time the consumer receives it
+ *  - total:    from the event hub to the consumer
+ *
+ * and the CPU time used by the process per evdev event and per delivered
+ * sample.  Every latency result is printed as one tab separated line:
+ *   <stream> <stage> <samples> <p50 us> <p90 us> <p99 us> <max us>
+ *
+ * Without a file, built-in streams are used: ten fingers moving on a
+ * touch screen at 240Hz, a stylus drawing at 120Hz, and bursts of key
+ * presses.  A stream file describes its devices, then lists its events:
+ *
+ *   # comment
+ *   device <id> <path> <classes> <name>
+ *   config <id> <key> <value>
+ *   abs <id> <axis> <min> <max>
+ *   key <id> <scan code> <key code>
+ *   event <time us> <id> <type> <code> <value>
+ *
+ * Numbers may be decimal or hex.  The output of 'getevent -t' can be used
+ * as is in place of event lines, with the devices identified by path:
+ *   [    1234.567890] /dev/input/event2: 0003 0035 000001c2
+ *
+ * usage: InputPipelineBenchmark [-f] [-d] [stream file...]
+ *   -f  replay as fast as possible instead of at the recorded pace
+ *   -d  print the dispatcher state after each stream
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <android/keycodes.h>
+#include <input/Input.h>
+#include <input/InputTransport.h>
+#include <utils/KeyedVector.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+#include "../../EventHub.h"
+#include "../../InputDispatcher.h"
+#include "../../InputReader.h"
+
+using namespace android;
+
+static const int32_t DISPLAY_WIDTH = 1080;
+static const int32_t DISPLAY_HEIGHT = 1920;
+
+static const nsecs_t DISPATCHING_TIMEOUT = 5000 * 1000000LL; // 5s
+
+// How long the pipeline must stay idle after the last event before a
+// stream is considered done.
+static const nsecs_t SETTLE_TIME = 200 * 1000000LL; // 200ms
+
+static nsecs_t processCpuTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return nsecs_t(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+
+struct ReplayDevice {
+    int32_t id;
+    String8 path;
+    uint32_t classes;
+    InputDeviceIdentifier identifier;
+    PropertyMap configuration;
+    KeyedVector<int32_t, RawAbsoluteAxisInfo> absoluteAxes;
+    KeyedVector<int32_t, int32_t> keyCodes; // by scan code
+};
+
+struct ReplayEvent {
+    nsecs_t time; // relative to the start of the stream
+    int32_t deviceId;
+    int32_t type;
+    int32_t code;
+    int32_t value;
+};
+
+struct ReplayStream {
+    String8 name;
+    Vector<ReplayDevice> devices;
+    Vector<ReplayEvent> events;
+
+    ReplayDevice* getDevice(int32_t id) {
+        for (size_t i = 0; i < devices.size(); i++) {
+            if (devices[i].id == id) {
+                return &devices.editItemAt(i);
+            }
+        }
+        return NULL;
+    }
+
+    ReplayDevice& addDevice(int32_t id, const char* path, uint32_t classes, const char* name) {
+        ReplayDevice device;
+        device.id = id;
+        device.path.setTo(path);
+        device.classes = classes;
+        device.identifier.name.setTo(name);
+        devices.add(device);
+        return devices.editTop();
+    }
+
+    void addAxis(ReplayDevice& device, int32_t axis, int32_t minValue, int32_t maxValue) {
+        RawAbsoluteAxisInfo info;
+        info.valid = true;
+        info.minValue = minValue;
+        info.maxValue = maxValue;
+        info.flat = 0;
+        info.fuzz = 0;
+        info.resolution = 0;
+        device.absoluteAxes.add(axis, info);
+    }
+
+    void addEvent(nsecs_t time, int32_t deviceId, int32_t type, int32_t code, int32_t value) {
+        ReplayEvent event;
+        event.time = time;
+        event.deviceId = deviceId;
+        event.type = type;
+        event.code = code;
+        event.value = value;
+        events.add(event);
+    }
+};
+
+// ---------------------------------------------------------------------------
+
+/*
+ * Feeds a stream to the reader.  The devices are reported as added by the
+ * first call to getEvents(), then each call returns the events up to the
+ * next SYN_REPORT once it is due, stamped with the time it was returned.
+ */
+class ReplayEventHub : public EventHubInterface {
+public:
+    ReplayEventHub(const ReplayStream& stream, bool paced) :
+            mStream(stream), mPaced(paced), mStartTime(0), mNextEvent(0),
+            mDevicesAdded(false), mDone(false), mWakeRequested(false) {
+    }
+
+    bool isDone() const {
+        AutoMutex _l(mLock);
+        return mDone;
+    }
+
+    virtual uint32_t getDeviceClasses(int32_t deviceId) const {
+        const ReplayDevice* device = getDevice(deviceId);
+        return device ? device->classes : 0;
+    }
+
+    virtual InputDeviceIdentifier getDeviceIdentifier(int32_t deviceId) const {
+        const ReplayDevice* device = getDevice(deviceId);
+        return device ? device->identifier : InputDeviceIdentifier();
+    }
+
+    virtual int32_t getDeviceControllerNumber(int32_t deviceId) const {
+        return 0;
+    }
+
+    virtual void getConfiguration(int32_t deviceId, PropertyMap* outConfiguration) const {
+        const ReplayDevice* device = getDevice(deviceId);
+        if (device) {
+            *outConfiguration = device->configuration;
+        }
+    }
+
+    virtual status_t getAbsoluteAxisInfo(int32_t deviceId, int axis,
+            RawAbsoluteAxisInfo* outAxisInfo) const {
+        const ReplayDevice* device = getDevice(deviceId);
+        if (device) {
+            ssize_t index = device->absoluteAxes.indexOfKey(axis);
+            if (index >= 0) {
+                *outAxisInfo = device->absoluteAxes.valueAt(index);
+                return OK;
+            }
+        }
+        outAxisInfo->clear();
+        return -1;
+    }
+
+    virtual bool hasRelativeAxis(int32_t deviceId, int axis) const {
+        return false;
+    }
+
+    virtual bool hasInputProperty(int32_t deviceId, int property) const {
+        return false;
+    }
+
+    virtual status_t mapKey(int32_t deviceId, int32_t scanCode, int32_t usageCode,
+            int32_t* outKeycode, uint32_t* outFlags) const {
+        const ReplayDevice* device = getDevice(deviceId);
+        if (device) {
+            ssize_t index = device->keyCodes.indexOfKey(scanCode);
+            if (index >= 0) {
+                *outKeycode = device->keyCodes.valueAt(index);
+                *outFlags = 0;
+                return OK;
+            }
+        }
+        return NAME_NOT_FOUND;
+    }
+
+    virtual status_t mapAxis(int32_t deviceId, int32_t scanCode,
+            AxisInfo* outAxisInfo) const {
+        return NAME_NOT_FOUND;
+    }
+
+    virtual void setExcludedDevices(const Vector<String8>& devices) {
+    }
+
+    virtual size_t getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSize) {
+        AutoMutex _l(mLock);
+        if (!mDevicesAdded) {
+            mDevicesAdded = true;
+            size_t count = 0;
+            for (size_t i = 0; i < mStream.devices.size() && count + 1 < bufferSize; i++) {
+                setRawEvent(&buffer[count++], systemTime(SYSTEM_TIME_MONOTONIC),
+                        mStream.devices[i].id, DEVICE_ADDED, 0, 0);
+            }
+            setRawEvent(&buffer[count++], systemTime(SYSTEM_TIME_MONOTONIC),
+                    0, FINISHED_DEVICE_SCAN, 0, 0);
+            return count;
+        }
+
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (!mStartTime) {
+            // Leave the reader time to configure the devices first.
+            mStartTime = now + SETTLE_TIME;
+        }
+
+        nsecs_t deadline = timeoutMillis < 0 ? LLONG_MAX : now + milliseconds_to_nanoseconds(
+                timeoutMillis);
+        while (!mWakeRequested) {
+            nsecs_t due = LLONG_MAX;
+            if (mNextEvent < mStream.events.size()) {
+                due = mPaced ? mStartTime + mStream.events[mNextEvent].time : now;
+            }
+            if (due <= now) {
+                break;
+            }
+            nsecs_t until = due < deadline ? due : deadline;
+            if (until <= now) {
+                return 0;
+            }
+            if (until == LLONG_MAX) {
+                mCondition.wait(mLock);
+            } else {
+                mCondition.waitRelative(mLock, until - now);
+            }
+            now = systemTime(SYSTEM_TIME_MONOTONIC);
+        }
+        if (mWakeRequested) {
+            mWakeRequested = false;
+            return 0;
+        }
+
+        size_t count = 0;
+        while (mNextEvent < mStream.events.size() && count < bufferSize) {
+            const ReplayEvent& event = mStream.events[mNextEvent++];
+            setRawEvent(&buffer[count++], now, event.deviceId,
+                    event.type, event.code, event.value);
+            if (event.type == EV_SYN && event.code == SYN_REPORT) {
+                break;
+            }
+        }
+        if (mNextEvent == mStream.events.size()) {
+            mDone = true;
+        }
+        return count;
+    }
+
+    virtual int32_t getScanCodeState(int32_t deviceId, int32_t scanCode) const {
+        return AKEY_STATE_UP;
+    }
+
+    virtual int32_t getKeyCodeState(int32_t deviceId, int32_t keyCode) const {
+        return AKEY_STATE_UP;
+    }
+
+    virtual int32_t getSwitchState(int32_t deviceId, int32_t sw) const {
+        return AKEY_STATE_UP;
+    }
+
+    virtual status_t getAbsoluteAxisValue(int32_t deviceId, int32_t axis,
+            int32_t* outValue) const {
+        *outValue = 0;
+        return OK;
+    }
+
+    virtual bool markSupportedKeyCodes(int32_t deviceId, size_t numCodes, const int32_t* keyCodes,
+            uint8_t* outFlags) const {
+        const ReplayDevice* device = getDevice(deviceId);
+        bool result = false;
+        for (size_t i = 0; device && i < numCodes; i++) {
+            for (size_t j = 0; j < device->keyCodes.size(); j++) {
+                if (device->keyCodes.valueAt(j) == keyCodes[i]) {
+                    outFlags[i] = 1;
+                    result = true;
+                }
+            }
+        }
+        return result;
+    }
+
+    virtual bool hasScanCode(int32_t deviceId, int32_t scanCode) const {
+        const ReplayDevice* device = getDevice(deviceId);
+        return device && device->keyCodes.indexOfKey(scanCode) >= 0;
+    }
+
+    virtual bool hasLed(int32_t deviceId, int32_t led) const {
+        return false;
+    }
+
+    virtual void setLedState(int32_t deviceId, int32_t led, bool on) {
+    }
+
+    virtual void getVirtualKeyDefinitions(int32_t deviceId,
+            Vector<VirtualKeyDefinition>& outVirtualKeys) const {
+        outVirtualKeys.clear();
+    }
+
+    virtual sp<KeyCharacterMap> getKeyCharacterMap(int32_t deviceId) const {
+        return NULL;
+    }
+
+    virtual bool setKeyboardLayoutOverlay(int32_t deviceId, const sp<KeyCharacterMap>& map) {
+        return false;
+    }
+
+    virtual void vibrate(int32_t deviceId, nsecs_t duration) {
+    }
+
+    virtual void cancelVibrate(int32_t deviceId) {
+    }
+
+    virtual void requestReopenDevices() {
+    }
+
+    virtual void wake() {
+        AutoMutex _l(mLock);
+        mWakeRequested = true;
+        mCondition.broadcast();
+    }
+
+    virtual void dump(String8& dump) {
+    }
+
+    virtual void monitor() {
+    }
+
+protected:
+    virtual ~ReplayEventHub() {
+    }
+
+private:
+    const ReplayStream& mStream;
+    const bool mPaced;
+
+    mutable Mutex mLock;
+    Condition mCondition;
+    nsecs_t mStartTime;
+    size_t mNextEvent;
+    bool mDevicesAdded;
+    bool mDone;
+    bool mWakeRequested;
+
+    const ReplayDevice* getDevice(int32_t id) const {
+        for (size_t i = 0; i < mStream.devices.size(); i++) {
+            if (mStream.devices[i].id == id) {
+                return &mStream.devices[i];
+            }
+        }
+        return NULL;
+    }
+
+    static void setRawEvent(RawEvent* event, nsecs_t when, int32_t deviceId,
+            int32_t type, int32_t code, int32_t value) {
+        event->when = when;
+        event->deviceId = deviceId;
+        event->type = type;
+        event->code = code;
+        event->value = value;
+    }
+};
+
+// ---------------------------------------------------------------------------
+
+class BenchmarkReaderPolicy : public InputReaderPolicyInterface {
+public:
+    BenchmarkReaderPolicy() {
+        DisplayViewport v;
+        v.displayId = ADISPLAY_ID_DEFAULT;
+        v.orientation = DISPLAY_ORIENTATION_0;
+        v.logicalRight = v.physicalRight = v.deviceWidth = DISPLAY_WIDTH;
+        v.logicalBottom = v.physicalBottom = v.deviceHeight = DISPLAY_HEIGHT;
+        mConfig.setDisplayInfo(false /*external*/, v);
+        mConfig.setDisplayInfo(true /*external*/, v);
+    }
+
+    virtual void getReaderConfiguration(InputReaderConfiguration* outConfig) {
+        *outConfig = mConfig;
+    }
+
+    virtual sp<PointerControllerInterface> obtainPointerController(int32_t deviceId) {
+        return NULL;
+    }
+
+    virtual void notifyInputDevicesChanged(const Vector<InputDeviceInfo>& inputDevices) {
+    }
+
+    virtual sp<KeyCharacterMap> getKeyboardLayoutOverlay(const InputDeviceIdentifier& identifier) {
+        return NULL;
+    }
+
+    virtual String8 getDeviceAlias(const InputDeviceIdentifier& identifier) {
+        return String8::empty();
+    }
+
+    virtual TouchAffineTransformation getTouchAffineTransformation(
+            const String8& inputDeviceDescriptor, int32_t surfaceRotation) {
+        return TouchAffineTransformation();
+    }
+
+protected:
+    virtual ~BenchmarkReaderPolicy() {
+    }
+
+private:
+    InputReaderConfiguration mConfig;
+};
+
+class BenchmarkDispatcherPolicy : public InputDispatcherPolicyInterface {
+public:
+    BenchmarkDispatcherPolicy() {
+    }
+
+    virtual void notifyConfigurationChanged(nsecs_t when) {
+    }
+
+    virtual nsecs_t notifyANR(const sp<InputApplicationHandle>& inputApplicationHandle,
+            const sp<InputWindowHandle>& inputWindowHandle, const String8& reason) {
+        fprintf(stderr, "ANR: %s\n", reason.string());
+        return 0;
+    }
+
+    virtual void notifyInputChannelBroken(const sp<InputWindowHandle>& inputWindowHandle) {
+    }
+
+    virtual void getDispatcherConfiguration(InputDispatcherConfiguration* outConfig) {
+        *outConfig = InputDispatcherConfiguration();
+    }
+
+    virtual bool filterInputEvent(const InputEvent* inputEvent, uint32_t policyFlags) {
+        return true;
+    }
+
+    virtual void interceptKeyBeforeQueueing(const KeyEvent* keyEvent, uint32_t& policyFlags) {
+        policyFlags |= POLICY_FLAG_PASS_TO_USER;
+    }
+
+    virtual void interceptMotionBeforeQueueing(nsecs_t when, uint32_t& policyFlags) {
+        policyFlags |= POLICY_FLAG_PASS_TO_USER;
+    }
+
+    virtual nsecs_t interceptKeyBeforeDispatching(const sp<InputWindowHandle>& inputWindowHandle,
+            const KeyEvent* keyEvent, uint32_t policyFlags) {
+        return 0;
+    }
+
+    virtual bool dispatchUnhandledKey(const sp<InputWindowHandle>& inputWindowHandle,
+            const KeyEvent* keyEvent, uint32_t policyFlags, KeyEvent* outFallbackKeyEvent) {
+        return false;
+    }
+
+    virtual void notifySwitch(nsecs_t when,
+            uint32_t switchValues, uint32_t switchMask, uint32_t policyFlags) {
+    }
+
+    virtual void pokeUserActivity(nsecs_t eventTime, int32_t eventType) {
+    }
+
+    virtual bool checkInjectEventsPermissionNonReentrant(
+            int32_t injectorPid, int32_t injectorUid) {
+        return false;
+    }
+
+protected:
+    virtual ~BenchmarkDispatcherPolicy() {
+    }
+};
+
+class BenchmarkApplicationHandle : public InputApplicationHandle {
+public:
+    virtual bool updateInfo() {
+        if (!mInfo) {
+            mInfo = new InputApplicationInfo();
+            mInfo->name.setTo("InputPipelineBenchmark");
+            mInfo->dispatchingTimeout = DISPATCHING_TIMEOUT;
+        }
+        return true;
+    }
+};
+
+class BenchmarkWindowHandle : public InputWindowHandle {
+public:
+    BenchmarkWindowHandle(const sp<InputApplicationHandle>& inputApplicationHandle,
+            const sp<InputChannel>& inputChannel) :
+            InputWindowHandle(inputApplicationHandle), mInputChannel(inputChannel) {
+    }
+
+    virtual bool updateInfo() {
+        if (!mInfo) {
+            mInfo = new InputWindowInfo();
+            mInfo->inputChannel = mInputChannel;
+            mInfo->name.setTo("InputPipelineBenchmark");
+            mInfo->layoutParamsFlags = 0;
+            mInfo->layoutParamsPrivateFlags = 0;
+            mInfo->layoutParamsType = InputWindowInfo::TYPE_APPLICATION;
+            mInfo->dispatchingTimeout = DISPATCHING_TIMEOUT;
+            mInfo->frameLeft = 0;
+            mInfo->frameTop = 0;
+            mInfo->frameRight = DISPLAY_WIDTH;
+            mInfo->frameBottom = DISPLAY_HEIGHT;
+            mInfo->scaleFactor = 1.0f;
+            mInfo->addTouchableRegion(Rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT));
+            mInfo->visible = true;
+            mInfo->canReceiveKeys = true;
+            mInfo->hasFocus = true;
+            mInfo->hasWallpaper = false;
+            mInfo->paused = false;
+            mInfo->layer = 0;
+            mInfo->ownerPid = getpid();
+            mInfo->ownerUid = getuid();
+            mInfo->inputFeatures = 0;
+            mInfo->displayId = ADISPLAY_ID_DEFAULT;
+        }
+        return true;
+    }
+
+private:
+    sp<InputChannel> mInputChannel;
+};
+
+// ---------------------------------------------------------------------------
+
+/*
+ * Latencies of the samples seen by one stage.  The samples are identified
+ * by their event time, which the reader takes from the event hub.
+ */
+class LatencyRecorder {
+public:
+    void record(nsecs_t eventTime, nsecs_t latency) {
+        AutoMutex _l(mLock);
+        mLatencies.add(latency);
+        mTimesByEvent.add(eventTime, eventTime + latency);
+    }
+
+    // Returns the time the stage saw the sample with the given event time,
+    // or 0 if it didn't.
+    nsecs_t getTime(nsecs_t eventTime) const {
+        AutoMutex _l(mLock);
+        ssize_t index = mTimesByEvent.indexOfKey(eventTime);
+        return index >= 0 ? mTimesByEvent.valueAt(index) : 0;
+    }
+
+    size_t size() const {
+        AutoMutex _l(mLock);
+        return mLatencies.size();
+    }
+
+    void report(const char* stream, const char* stage) {
+        AutoMutex _l(mLock);
+        size_t n = mLatencies.size();
+        if (!n) {
+            printf("%s\t%s\t0\t-\t-\t-\t-\n", stream, stage);
+            return;
+        }
+        mLatencies.sort(compare);
+        printf("%s\t%s\t%zu\t%.1f\t%.1f\t%.1f\t%.1f\n", stream, stage, n,
+                mLatencies[n / 2] / 1000.0, mLatencies[n * 9 / 10] / 1000.0,
+                mLatencies[n * 99 / 100] / 1000.0, mLatencies[n - 1] / 1000.0);
+    }
+
+private:
+    mutable Mutex mLock;
+    Vector<nsecs_t> mLatencies;
+    KeyedVector<nsecs_t, nsecs_t> mTimesByEvent;
+
+    static int compare(const nsecs_t* a, const nsecs_t* b) {
+        return *a < *b ? -1 : *a > *b ? 1 : 0;
+    }
+};
+
+/*
+ * Sits between the reader and the dispatcher to time the reader.
+ */
+class TimingListener : public InputListenerInterface {
+public:
+    TimingListener(const sp<InputListenerInterface>& inner, LatencyRecorder* recorder) :
+            mInner(inner), mRecorder(recorder) {
+    }
+
+    virtual void notifyConfigurationChanged(const NotifyConfigurationChangedArgs* args) {
+        mInner->notifyConfigurationChanged(args);
+    }
+
+    virtual void notifyKey(const NotifyKeyArgs* args) {
+        mRecorder->record(args->eventTime, systemTime(SYSTEM_TIME_MONOTONIC) - args->eventTime);
+        mInner->notifyKey(args);
+    }
+
+    virtual void notifyMotion(const NotifyMotionArgs* args) {
+        mRecorder->record(args->eventTime, systemTime(SYSTEM_TIME_MONOTONIC) - args->eventTime);
+        mInner->notifyMotion(args);
+    }
+
+    virtual void notifySwitch(const NotifySwitchArgs* args) {
+        mInner->notifySwitch(args);
+    }
+
+    virtual void notifyDeviceReset(const NotifyDeviceResetArgs* args) {
+        mInner->notifyDeviceReset(args);
+    }
+
+protected:
+    virtual ~TimingListener() {
+    }
+
+private:
+    sp<InputListenerInterface> mInner;
+    LatencyRecorder* mRecorder;
+};
+
+/*
+ * Receives the events sent to the window and finishes them right away.
+ */
+class BenchmarkConsumer {
+public:
+    BenchmarkConsumer(const sp<InputChannel>& channel, const LatencyRecorder* reader,
+            LatencyRecorder* dispatch, LatencyRecorder* total) :
+            mConsumer(channel), mReader(reader), mDispatch(dispatch), mTotal(total),
+            mLastEventTime(0), mExitPending(false) {
+        pipe(mExitPipe);
+    }
+
+    ~BenchmarkConsumer() {
+        close(mExitPipe[0]);
+        close(mExitPipe[1]);
+    }
+
+    bool start() {
+        return !pthread_create(&mThread, NULL, threadMain, this);
+    }
+
+    void stop() {
+        mExitPending = true;
+        write(mExitPipe[1], "", 1);
+        pthread_join(mThread, NULL);
+    }
+
+    nsecs_t getLastEventTime() const {
+        AutoMutex _l(mLock);
+        return mLastEventTime;
+    }
+
+private:
+    InputConsumer mConsumer;
+    PreallocatedInputEventFactory mEventFactory;
+    const LatencyRecorder* mReader;
+    LatencyRecorder* mDispatch;
+    LatencyRecorder* mTotal;
+
+    mutable Mutex mLock;
+    nsecs_t mLastEventTime; // when the last event was received
+
+    pthread_t mThread;
+    int mExitPipe[2];
+    volatile bool mExitPending;
+
+    static void* threadMain(void* data) {
+        static_cast<BenchmarkConsumer*>(data)->loop();
+        return NULL;
+    }
+
+    void loop() {
+        struct pollfd fds[2];
+        fds[0].fd = mConsumer.getChannel()->getFd();
+        fds[0].events = POLLIN;
+        fds[1].fd = mExitPipe[0];
+        fds[1].events = POLLIN;
+
+        while (!mExitPending) {
+            if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+                break;
+            }
+            for (;;) {
+                uint32_t seq;
+                InputEvent* event;
+                status_t status = mConsumer.consume(&mEventFactory, true /*consumeBatches*/,
+                        -1, &seq, &event);
+                if (status) {
+                    break;
+                }
+                nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+                if (event->getType() == AINPUT_EVENT_TYPE_KEY) {
+                    recordSample(static_cast<KeyEvent*>(event)->getEventTime(), now);
+                } else if (event->getType() == AINPUT_EVENT_TYPE_MOTION) {
+                    MotionEvent* motionEvent = static_cast<MotionEvent*>(event);
+                    for (size_t i = 0; i < motionEvent->getHistorySize(); i++) {
+                        recordSample(motionEvent->getHistoricalEventTime(i), now);
+                    }
+                    recordSample(motionEvent->getEventTime(), now);
+                }
+                mConsumer.sendFinishedSignal(seq, true);
+
+                AutoMutex _l(mLock);
+                mLastEventTime = now;
+            }
+        }
+    }
+
+    void recordSample(nsecs_t eventTime, nsecs_t now) {
+        mTotal->record(eventTime, now - eventTime);
+        nsecs_t readerTime = mReader->getTime(eventTime);
+        if (readerTime) {
+            mDispatch->record(eventTime, now - readerTime);
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+
+static void runStream(const ReplayStream& stream, bool paced, bool dumpDispatcher) {
+    sp<InputChannel> serverChannel, clientChannel;
+    status_t status = InputChannel::openInputChannelPair(String8("InputPipelineBenchmark"),
+            serverChannel, clientChannel);
+    if (status) {
+        fprintf(stderr, "failed to open input channels: %d\n", status);
+        return;
+    }
+
+    LatencyRecorder readerLatency, dispatchLatency, totalLatency;
+
+    sp<ReplayEventHub> eventHub = new ReplayEventHub(stream, paced);
+    sp<InputDispatcher> dispatcher = new InputDispatcher(new BenchmarkDispatcherPolicy());
+    sp<InputReader> reader = new InputReader(eventHub, new BenchmarkReaderPolicy(),
+            new TimingListener(dispatcher, &readerLatency));
+
+    sp<InputApplicationHandle> application = new BenchmarkApplicationHandle();
+    sp<InputWindowHandle> window = new BenchmarkWindowHandle(application, serverChannel);
+    Vector<sp<InputWindowHandle> > windows;
+    windows.add(window);
+    dispatcher->registerInputChannel(serverChannel, window, false /*monitor*/);
+    dispatcher->setFocusedApplication(application);
+    dispatcher->setInputWindows(windows);
+    dispatcher->setInputDispatchMode(true /*enabled*/, false /*frozen*/);
+
+    BenchmarkConsumer consumer(clientChannel, &readerLatency, &dispatchLatency, &totalLatency);
+    if (!consumer.start()) {
+        fprintf(stderr, "failed to start the consumer thread\n");
+        return;
+    }
+
+    sp<InputReaderThread> readerThread = new InputReaderThread(reader);
+    sp<InputDispatcherThread> dispatcherThread = new InputDispatcherThread(dispatcher);
+    dispatcherThread->run("InputDispatcher", PRIORITY_URGENT_DISPLAY);
+    readerThread->run("InputReader", PRIORITY_URGENT_DISPLAY);
+
+    nsecs_t startCpuTime = processCpuTime();
+    while (!eventHub->isDone()) {
+        usleep(10000);
+    }
+    for (;;) {
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t lastEventTime = consumer.getLastEventTime();
+        if (now - lastEventTime >= SETTLE_TIME) {
+            break;
+        }
+        usleep(nanoseconds_to_microseconds(lastEventTime + SETTLE_TIME - now));
+    }
+    nsecs_t cpuTime = processCpuTime() - startCpuTime;
+
+    readerThread->requestExit();
+    eventHub->wake();
+    readerThread->requestExitAndWait();
+    dispatcherThread->requestExit();
+    dispatcher->setInputDispatchMode(false /*enabled*/, false /*frozen*/); // wakes it up
+    dispatcherThread->requestExitAndWait();
+    consumer.stop();
+
+    const char* name = stream.name.string();
+    readerLatency.report(name, "reader");
+    dispatchLatency.report(name, "dispatch");
+    totalLatency.report(name, "total");
+    size_t samples = totalLatency.size();
+    printf("%s\tcpu\t%zu events\t%.1f us/event\t%zu samples\t%.1f us/sample\n", name,
+            stream.events.size(), stream.events.size()
+                    ? cpuTime / 1000.0 / stream.events.size() : 0.0,
+            samples, samples ? cpuTime / 1000.0 / samples : 0.0);
+
+    if (dumpDispatcher) {
+        String8 dump;
+        dispatcher->dump(dump);
+        printf("%s", dump.string());
+    }
+
+    dispatcher->unregisterInputChannel(serverChannel);
+}
+
+// ---------------------------------------------------------------------------
+
+static void addSync(ReplayStream& stream, nsecs_t time, int32_t deviceId) {
+    stream.addEvent(time, deviceId, EV_SYN, SYN_REPORT, 0);
+}
+
+static void makeMultiTouchStream(ReplayStream& stream) {
+    const int32_t id = 1;
+    const int fingers = 10;
+    const nsecs_t period = 1000000000LL / 240;
+    const int frames = 480;
+
+    stream.name.setTo("multitouch");
+    ReplayDevice& device = stream.addDevice(id, "/dev/input/event1",
+            INPUT_DEVICE_CLASS_TOUCH | INPUT_DEVICE_CLASS_TOUCH_MT, "Benchmark Touchscreen");
+    device.configuration.addProperty(String8("touch.deviceType"), String8("touchScreen"));
+    stream.addAxis(device, ABS_MT_SLOT, 0, fingers - 1);
+    stream.addAxis(device, ABS_MT_TRACKING_ID, 0, 65535);
+    stream.addAxis(device, ABS_MT_POSITION_X, 0, DISPLAY_WIDTH - 1);
+    stream.addAxis(device, ABS_MT_POSITION_Y, 0, DISPLAY_HEIGHT - 1);
+    stream.addAxis(device, ABS_MT_PRESSURE, 0, 255);
+    stream.addAxis(device, ABS_MT_TOUCH_MAJOR, 0, 255);
+
+    // The fingers go down one frame after the other, then all move
+    // diagonally, then lift in the same order.
+    for (int frame = 0; frame < frames; frame++) {
+        nsecs_t time = frame * period;
+        for (int finger = 0; finger < fingers; finger++) {
+            if (frame < finger) {
+                continue;
+            }
+            stream.addEvent(time, id, EV_ABS, ABS_MT_SLOT, finger);
+            if (frame >= frames - fingers + finger) {
+                if (frame == frames - fingers + finger) {
+                    stream.addEvent(time, id, EV_ABS, ABS_MT_TRACKING_ID, -1);
+                }
+                continue;
+            }
+            if (frame == finger) {
+                stream.addEvent(time, id, EV_ABS, ABS_MT_TRACKING_ID, finger);
+            }
+            int32_t x = (100 + finger * 90 + frame) % DISPLAY_WIDTH;
+            int32_t y = (200 + finger * 50 + frame * 3) % DISPLAY_HEIGHT;
+            stream.addEvent(time, id, EV_ABS, ABS_MT_POSITION_X, x);
+            stream.addEvent(time, id, EV_ABS, ABS_MT_POSITION_Y, y);
+            stream.addEvent(time, id, EV_ABS, ABS_MT_PRESSURE, 100 + (frame + finger) % 50);
+            stream.addEvent(time, id, EV_ABS, ABS_MT_TOUCH_MAJOR, 20 + finger);
+        }
+        addSync(stream, time, id);
+    }
+}
+
+static void makeStylusStream(ReplayStream& stream) {
+    const int32_t id = 2;
+    const nsecs_t period = 1000000000LL / 120;
+    const int strokes = 10;
+    const int framesPerStroke = 60;
+
+    stream.name.setTo("stylus");
+    ReplayDevice& device = stream.addDevice(id, "/dev/input/event2",
+            INPUT_DEVICE_CLASS_TOUCH, "Benchmark Stylus");
+    device.configuration.addProperty(String8("touch.deviceType"), String8("touchScreen"));
+    stream.addAxis(device, ABS_X, 0, DISPLAY_WIDTH - 1);
+    stream.addAxis(device, ABS_Y, 0, DISPLAY_HEIGHT - 1);
+    stream.addAxis(device, ABS_PRESSURE, 0, 1023);
+    device.keyCodes.add(BTN_TOUCH, 0);
+    device.keyCodes.add(BTN_TOOL_PEN, 0);
+
+    // Each stroke hovers for a few frames, then draws.
+    nsecs_t time = 0;
+    for (int stroke = 0; stroke < strokes; stroke++) {
+        stream.addEvent(time, id, EV_KEY, BTN_TOOL_PEN, 1);
+        for (int frame = 0; frame < framesPerStroke; frame++) {
+            const bool touching = frame >= 5;
+            if (frame == 5) {
+                stream.addEvent(time, id, EV_KEY, BTN_TOUCH, 1);
+            }
+            stream.addEvent(time, id, EV_ABS, ABS_X, 200 + stroke * 60 + frame * 4);
+            stream.addEvent(time, id, EV_ABS, ABS_Y, 300 + frame * 12);
+            stream.addEvent(time, id, EV_ABS, ABS_PRESSURE, touching ? 300 + frame * 5 : 0);
+            addSync(stream, time, id);
+            time += period;
+        }
+        stream.addEvent(time, id, EV_KEY, BTN_TOUCH, 0);
+        stream.addEvent(time, id, EV_KEY, BTN_TOOL_PEN, 0);
+        addSync(stream, time, id);
+        time += 20 * period;
+    }
+}
+
+static void makeKeyboardStream(ReplayStream& stream) {
+    const int32_t id = 3;
+    const int bursts = 10;
+    const int keysPerBurst = 30;
+    const nsecs_t keyInterval = 8 * 1000000LL; // 8ms
+    const nsecs_t burstInterval = 250 * 1000000LL; // 250ms
+
+    static const int32_t SCAN_CODES[] = {
+            KEY_Q, KEY_W, KEY_E, KEY_R, KEY_T, KEY_Y, KEY_U, KEY_I, KEY_O, KEY_P,
+            KEY_A, KEY_S, KEY_D, KEY_F, KEY_G, KEY_H, KEY_J, KEY_K, KEY_L,
+            KEY_Z, KEY_X, KEY_C, KEY_V, KEY_B, KEY_N, KEY_M, KEY_SPACE, KEY_ENTER,
+    };
+    static const int32_t KEY_CODES[] = {
+            AKEYCODE_Q, AKEYCODE_W, AKEYCODE_E, AKEYCODE_R, AKEYCODE_T, AKEYCODE_Y,
+            AKEYCODE_U, AKEYCODE_I, AKEYCODE_O, AKEYCODE_P,
+            AKEYCODE_A, AKEYCODE_S, AKEYCODE_D, AKEYCODE_F, AKEYCODE_G, AKEYCODE_H,
+            AKEYCODE_J, AKEYCODE_K, AKEYCODE_L,
+            AKEYCODE_Z, AKEYCODE_X, AKEYCODE_C, AKEYCODE_V, AKEYCODE_B, AKEYCODE_N,
+            AKEYCODE_M, AKEYCODE_SPACE, AKEYCODE_ENTER,
+    };
+    const size_t keyCount = sizeof(SCAN_CODES) / sizeof(SCAN_CODES[0]);
+
+    stream.name.setTo("keyboard");
+    ReplayDevice& device = stream.addDevice(id, "/dev/input/event3",
+            INPUT_DEVICE_CLASS_KEYBOARD | INPUT_DEVICE_CLASS_ALPHAKEY, "Benchmark Keyboard");
+    for (size_t i = 0; i < keyCount; i++) {
+        device.keyCodes.add(SCAN_CODES[i], KEY_CODES[i]);
+    }
+
+    nsecs_t time = 0;
+    for (int burst = 0; burst < bursts; burst++) {
+        for (int key = 0; key < keysPerBurst; key++) {
+            int32_t scanCode = SCAN_CODES[(burst * 7 + key) % keyCount];
+            stream.addEvent(time, id, EV_KEY, scanCode, 1);
+            addSync(stream, time, id);
+            time += keyInterval / 2;
+            stream.addEvent(time, id, EV_KEY, scanCode, 0);
+            addSync(stream, time, id);
+            time += keyInterval / 2;
+        }
+        time += burstInterval;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+static bool parseNumber(const char* s, int32_t* outValue) {
+    char* end;
+    errno = 0;
+    long long value = strtoll(s, &end, 0);
+    if (errno || end == s || *end) {
+        return false;
+    }
+    *outValue = int32_t(value);
+    return true;
+}
+
+static bool parseHex(const char* s, int32_t* outValue) {
+    char* end;
+    errno = 0;
+    unsigned long value = strtoul(s, &end, 16);
+    if (errno || end == s || *end) {
+        return false;
+    }
+    *outValue = int32_t(value);
+    return true;
+}
+
+static bool loadStream(const char* filename, ReplayStream& stream) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "%s: %s\n", filename, strerror(errno));
+        return false;
+    }
+
+    stream.name.setTo(filename);
+    char line[512];
+    int lineNumber = 0;
+    bool haveFirstGeteventTime = false;
+    double firstGeteventTime = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char* argv[8];
+        int argc = 0;
+        char* save;
+        for (char* token = strtok_r(line, " \t\r\n", &save); token && argc < 8;
+                token = strtok_r(NULL, " \t\r\n", &save)) {
+            argv[argc++] = token;
+        }
+        if (argc == 0 || argv[0][0] == '#') {
+            continue;
+        }
+
+        int32_t id, a, b, c, d;
+        if (!strcmp(argv[0], "device") && argc >= 5
+                && parseNumber(argv[1], &id) && parseNumber(argv[3], &a)) {
+            String8 name(argv[4]);
+            for (int i = 5; i < argc; i++) {
+                name.appendFormat(" %s", argv[i]);
+            }
+            stream.addDevice(id, argv[2], uint32_t(a), name.string());
+        } else if (!strcmp(argv[0], "config") && argc == 4
+                && parseNumber(argv[1], &id) && stream.getDevice(id)) {
+            stream.getDevice(id)->configuration.addProperty(String8(argv[2]), String8(argv[3]));
+        } else if (!strcmp(argv[0], "abs") && argc == 5 && parseNumber(argv[1], &id)
+                && parseNumber(argv[2], &a) && parseNumber(argv[3], &b)
+                && parseNumber(argv[4], &c) && stream.getDevice(id)) {
+            stream.addAxis(*stream.getDevice(id), a, b, c);
+        } else if (!strcmp(argv[0], "key") && argc == 4 && parseNumber(argv[1], &id)
+                && parseNumber(argv[2], &a) && parseNumber(argv[3], &b)
+                && stream.getDevice(id)) {
+            stream.getDevice(id)->keyCodes.add(a, b);
+        } else if (!strcmp(argv[0], "event") && argc == 6 && parseNumber(argv[1], &a)
+                && parseNumber(argv[2], &id) && parseNumber(argv[3], &b)
+                && parseNumber(argv[4], &c) && parseNumber(argv[5], &d)) {
+            stream.addEvent(nsecs_t(a) * 1000, id, b, c, d);
+        } else if (argv[0][0] == '[') {
+            // getevent -t: "[", "<seconds>]" or "[<seconds>]", "<path>:", type, code, value
+            int i = 0;
+            char* timeString = argv[i][1] ? argv[i] + 1 : argv[++i];
+            i++;
+            if (argc - i != 4) {
+                ok = false;
+                break;
+            }
+            double seconds = strtod(timeString, NULL);
+            char* path = argv[i];
+            size_t length = strlen(path);
+            if (length && path[length - 1] == ':') {
+                path[length - 1] = '\0';
+            }
+            const ReplayDevice* device = NULL;
+            for (size_t j = 0; j < stream.devices.size(); j++) {
+                if (stream.devices[j].path == path) {
+                    device = &stream.devices[j];
+                }
+            }
+            if (!device) {
+                continue; // not one of the devices being replayed
+            }
+            if (!parseHex(argv[i + 1], &b) || !parseHex(argv[i + 2], &c)
+                    || !parseHex(argv[i + 3], &d)) {
+                ok = false;
+                break;
+            }
+            if (!haveFirstGeteventTime) {
+                haveFirstGeteventTime = true;
+                firstGeteventTime = seconds;
+            }
+            stream.addEvent(nsecs_t((seconds - firstGeteventTime) * 1e9), device->id, b, c, d);
+        } else {
+            ok = false;
+        }
+    }
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "%s:%d: syntax error\n", filename, lineNumber);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    bool paced = true;
+    bool dumpDispatcher = false;
+    int c;
+    while ((c = getopt(argc, argv, "fd")) != -1) {
+        switch (c) {
+            case 'f':
+                paced = false;
+                break;
+            case 'd':
+                dumpDispatcher = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-f] [-d] [stream file...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    printf("stream\tstage\tsamples\tp50 us\tp90 us\tp99 us\tmax us\n");
+    if (optind == argc) {
+        ReplayStream multiTouch, stylus, keyboard;
+        makeMultiTouchStream(multiTouch);
+        makeStylusStream(stylus);
+        makeKeyboardStream(keyboard);
+        runStream(multiTouch, paced, dumpDispatcher);
+        runStream(stylus, paced, dumpDispatcher);
+        runStream(keyboard, paced, dumpDispatcher);
+        return 0;
+    }
+
+    for (int i = optind; i < argc; i++) {
+        ReplayStream stream;
+        if (!loadStream(argv[i], stream)) {
+            return 1;
+        }
+        runStream(stream, paced, dumpDispatcher);
+    }
+    return 0;
+}
@@ -2,7 +2,8 @@ LOCAL_PATH:= $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES:= \
-	IPowerManager.cpp
+	IPowerManager.cpp \
+	WakeLockBatcher.cpp
 
 LOCAL_SHARED_LIBRARIES := \
 	libutils \
@@ -13,3 +14,5 @@ LOCAL_MODULE:= libpowermanager
 LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
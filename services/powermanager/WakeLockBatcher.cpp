@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "WakeLockBatcher"
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#include <powermanager/WakeLockBatcher.h>
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+class WakeLockBatcher::FlushThread : public Thread
+{
+public:
+    FlushThread(WakeLockBatcher* batcher) : mBatcher(batcher) { }
+
+private:
+    virtual bool threadLoop() {
+        return mBatcher->waitForFlush();
+    }
+
+    // the batcher joins us before it goes away
+    WakeLockBatcher* const mBatcher;
+};
+
+// ----------------------------------------------------------------------------
+
+WakeLockBatcher::WakeLockBatcher(const sp<IPowerManager>& powerManager,
+        nsecs_t window)
+    : mPowerManager(powerManager),
+      mWindow(window),
+      mFlushTime(0),
+      mExiting(false)
+{
+    mStats.sent = 0;
+    mStats.coalesced = 0;
+    mThread = new FlushThread(this);
+    mThread->run("WakeLockBatcher");
+}
+
+WakeLockBatcher::~WakeLockBatcher()
+{
+    {
+        Mutex::Autolock _l(mLock);
+        mExiting = true;
+        mCondition.signal();
+    }
+    // flushes what's left on its way out
+    mThread->requestExitAndWait();
+}
+
+void WakeLockBatcher::acquireWakeLock(int flags, const sp<IBinder>& lock,
+        const String16& tag, const String16& packageName)
+{
+    acquireWakeLockWithUid(flags, lock, tag, packageName, -1);
+}
+
+void WakeLockBatcher::acquireWakeLockWithUid(int flags,
+        const sp<IBinder>& lock, const String16& tag,
+        const String16& packageName, int uid)
+{
+    Mutex::Autolock _l(mLock);
+    LockState& state(editLockLocked(lock));
+    if (flags != state.flags || tag != state.tag ||
+            packageName != state.packageName || uid != state.uid) {
+        state.argsChanged = true;
+    }
+    state.wanted = true;
+    state.flags = flags;
+    state.tag = tag;
+    state.packageName = packageName;
+    state.uid = uid;
+    scheduleFlushLocked();
+}
+
+void WakeLockBatcher::releaseWakeLock(const sp<IBinder>& lock, int flags)
+{
+    Mutex::Autolock _l(mLock);
+    ssize_t index = mLocks.indexOfKey(lock.get());
+    if (index < 0) {
+        return;
+    }
+    LockState& state(mLocks.editValueAt(index));
+    state.wanted = false;
+    state.releaseFlags = flags;
+    scheduleFlushLocked();
+}
+
+void WakeLockBatcher::updateWakeLockUids(const sp<IBinder>& lock, int len,
+        const int* uids)
+{
+    Mutex::Autolock _l(mLock);
+    LockState& state(editLockLocked(lock));
+    state.uids.clear();
+    state.uids.appendArray(uids, len);
+    state.uidsChanged = true;
+    scheduleFlushLocked();
+}
+
+void WakeLockBatcher::flush()
+{
+    Mutex::Autolock _l(mLock);
+    flushLocked();
+}
+
+WakeLockBatcher::Stats WakeLockBatcher::getStats() const
+{
+    Mutex::Autolock _l(mLock);
+    return mStats;
+}
+
+WakeLockBatcher::LockState& WakeLockBatcher::editLockLocked(
+        const sp<IBinder>& lock)
+{
+    ssize_t index = mLocks.indexOfKey(lock.get());
+    if (index < 0) {
+        LockState state;
+        state.lock = lock;
+        state.held = false;
+        state.wanted = false;
+        state.flags = 0;
+        state.uid = -1;
+        state.argsChanged = false;
+        state.releaseFlags = 0;
+        state.uidsChanged = false;
+        index = mLocks.add(lock.get(), state);
+    }
+    return mLocks.editValueAt(index);
+}
+
+void WakeLockBatcher::scheduleFlushLocked()
+{
+    // every call would have been one transaction; flushLocked() takes back
+    // the ones it makes
+    mStats.coalesced++;
+    if (mFlushTime == 0) {
+        mFlushTime = systemTime() + mWindow;
+        mCondition.signal();
+    }
+}
+
+void WakeLockBatcher::flushLocked()
+{
+    mFlushTime = 0;
+    for (size_t i = 0; i < mLocks.size(); ) {
+        LockState& state(mLocks.editValueAt(i));
+        // acquiring a held lock again updates its flags and tag
+        if (state.wanted != state.held ||
+                (state.wanted && state.argsChanged)) {
+            if (!state.wanted) {
+                mPowerManager->releaseWakeLock(state.lock, state.releaseFlags,
+                        true);
+            } else if (state.uid >= 0) {
+                mPowerManager->acquireWakeLockWithUid(state.flags, state.lock,
+                        state.tag, state.packageName, state.uid, true);
+            } else {
+                mPowerManager->acquireWakeLock(state.flags, state.lock,
+                        state.tag, state.packageName, true);
+            }
+            state.held = state.wanted;
+            mStats.sent++;
+            mStats.coalesced--;
+        }
+        state.argsChanged = false;
+        if (state.uidsChanged && state.held) {
+            mPowerManager->updateWakeLockUids(state.lock, state.uids.size(),
+                    state.uids.array(), true);
+            mStats.sent++;
+            mStats.coalesced--;
+        }
+        state.uidsChanged = false;
+
+        if (!state.held) {
+            mLocks.removeItemsAt(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+bool WakeLockBatcher::waitForFlush()
+{
+    Mutex::Autolock _l(mLock);
+    while (!mExiting && mFlushTime == 0) {
+        mCondition.wait(mLock);
+    }
+    while (!mExiting && mFlushTime != 0) {
+        const nsecs_t now = systemTime();
+        if (now >= mFlushTime) {
+            flushLocked();
+            break;
+        }
+        mCondition.waitRelative(mLock, mFlushTime - now);
+    }
+    if (mExiting) {
+        flushLocked();
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+}; // namespace android
@@ -0,0 +1,23 @@
+# Build the unit tests.
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libpowermanager_test
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_SRC_FILES := \
+    WakeLockBatcher_test.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+    libbinder \
+    libpowermanager \
+    libutils
+
+LOCAL_C_INCLUDES := \
+    bionic \
+    bionic/libstdc++/include \
+    external/gtest/include \
+    external/stlport/stlport \
+
+include $(BUILD_NATIVE_TEST)
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "WakeLockBatcher_test"
+
+#include <gtest/gtest.h>
+
+#include <binder/Binder.h>
+#include <powermanager/WakeLockBatcher.h>
+
+namespace android {
+
+// Wake lock flags, as in PowerManager.java.
+static const int PARTIAL_WAKE_LOCK = 0x00000001;
+static const int ON_AFTER_RELEASE = 0x20000000;
+
+static const String16 TAG("WakeLockBatcherTest");
+static const String16 OTHER_TAG("WakeLockBatcherTest.other");
+static const String16 PACKAGE("android");
+
+// Records the calls the batcher makes.
+class FakePowerManager : public IPowerManager {
+public:
+    int acquireCount;
+    int releaseCount;
+    int lastFlags;
+    String16 lastTag;
+
+    FakePowerManager() : acquireCount(0), releaseCount(0), lastFlags(0) {}
+
+    virtual status_t acquireWakeLock(int flags, const sp<IBinder>&,
+            const String16& tag, const String16&, bool) {
+        acquireCount++;
+        lastFlags = flags;
+        lastTag = tag;
+        return NO_ERROR;
+    }
+    virtual status_t acquireWakeLockWithUid(int flags, const sp<IBinder>& lock,
+            const String16& tag, const String16& packageName, int, bool isOneWay) {
+        return acquireWakeLock(flags, lock, tag, packageName, isOneWay);
+    }
+    virtual status_t releaseWakeLock(const sp<IBinder>&, int, bool) {
+        releaseCount++;
+        return NO_ERROR;
+    }
+    virtual status_t updateWakeLockUids(const sp<IBinder>&, int, const int*, bool) {
+        return NO_ERROR;
+    }
+    virtual status_t powerHint(int, int) {
+        return NO_ERROR;
+    }
+
+protected:
+    virtual IBinder* onAsBinder() {
+        return NULL;
+    }
+};
+
+class WakeLockBatcherTest : public testing::Test {
+protected:
+    sp<FakePowerManager> mPowerManager;
+    sp<WakeLockBatcher> mBatcher;
+    sp<IBinder> mLock;
+
+    virtual void SetUp() {
+        mPowerManager = new FakePowerManager();
+        // long enough that only flush() sends the changes
+        mBatcher = new WakeLockBatcher(mPowerManager, seconds_to_nanoseconds(60));
+        mLock = new BBinder();
+    }
+
+    virtual void TearDown() {
+        mBatcher.clear();
+    }
+};
+
+TEST_F(WakeLockBatcherTest, AcquireOfAHeldLockIsCoalesced) {
+    mBatcher->acquireWakeLock(PARTIAL_WAKE_LOCK, mLock, TAG, PACKAGE);
+    mBatcher->flush();
+    ASSERT_EQ(1, mPowerManager->acquireCount);
+
+    mBatcher->acquireWakeLock(PARTIAL_WAKE_LOCK, mLock, TAG, PACKAGE);
+    mBatcher->flush();
+    EXPECT_EQ(1, mPowerManager->acquireCount);
+}
+
+TEST_F(WakeLockBatcherTest, NewFlagsOfAHeldLockAreForwarded) {
+    mBatcher->acquireWakeLock(PARTIAL_WAKE_LOCK, mLock, TAG, PACKAGE);
+    mBatcher->flush();
+    ASSERT_EQ(1, mPowerManager->acquireCount);
+
+    mBatcher->acquireWakeLock(PARTIAL_WAKE_LOCK | ON_AFTER_RELEASE, mLock,
+            OTHER_TAG, PACKAGE);
+    mBatcher->flush();
+    EXPECT_EQ(2, mPowerManager->acquireCount);
+    EXPECT_EQ(PARTIAL_WAKE_LOCK | ON_AFTER_RELEASE, mPowerManager->lastFlags);
+    EXPECT_TRUE(OTHER_TAG == mPowerManager->lastTag);
+    EXPECT_EQ(0, mPowerManager->releaseCount);
+}
+
+TEST_F(WakeLockBatcherTest, NewTagAcrossAReleaseIsForwarded) {
+    mBatcher->acquireWakeLock(PARTIAL_WAKE_LOCK, mLock, TAG, PACKAGE);
+    mBatcher->flush();
+
+    mBatcher->releaseWakeLock(mLock, 0);
+    mBatcher->acquireWakeLock(PARTIAL_WAKE_LOCK, mLock, OTHER_TAG, PACKAGE);
+    mBatcher->flush();
+    EXPECT_EQ(0, mPowerManager->releaseCount)
+            << "Should not drop a lock that stays held";
+    EXPECT_EQ(2, mPowerManager->acquireCount);
+    EXPECT_TRUE(OTHER_TAG == mPowerManager->lastTag);
+}
+
+} // namespace android
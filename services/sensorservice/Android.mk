@@ -9,6 +9,7 @@ LOCAL_SRC_FILES:= \
     LinearAccelerationSensor.cpp \
     OrientationSensor.cpp \
     RotationVectorSensor.cpp \
+    SensorDeliveryStats.cpp \
     SensorDevice.cpp \
     SensorFusion.cpp \
     SensorInterface.cpp \
@@ -18,6 +19,9 @@ LOCAL_CFLAGS:= -DLOG_TAG=\"SensorService\"
 
 LOCAL_CFLAGS += -fvisibility=hidden
 
+# FusionKernels.h relies on multiplies and adds being rounded separately
+LOCAL_CFLAGS += -ffp-contract=off
+
 LOCAL_SHARED_LIBRARIES := \
 	libcutils \
 	libhardware \
@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include "Fusion.h"
+#include "FusionKernels.h"
 
 namespace android {
 
@@ -355,20 +356,6 @@ mat33_t Fusion::getRotationMatrix() const {
     return quatToMatrix(x0);
 }
 
-mat34_t Fusion::getF(const vec4_t& q) {
-    mat34_t F;
-
-    // This is used to compute the derivative of q
-    // F = | [q.xyz]x |
-    //     |  -q.xyz  |
-
-    F[0].x = q.w;   F[1].x =-q.z;   F[2].x = q.y;
-    F[0].y = q.z;   F[1].y = q.w;   F[2].y =-q.x;
-    F[0].z =-q.y;   F[1].z = q.x;   F[2].z = q.w;
-    F[0].w =-q.x;   F[1].w =-q.y;   F[2].w =-q.z;
-    return F;
-}
-
 void Fusion::predict(const vec3_t& w, float dT) {
     const vec4_t q  = x0;
     const vec3_t b  = x1;
@@ -421,11 +408,12 @@ void Fusion::predict(const vec3_t& w, float dT) {
     Phi[0][0] = I33 - wx*(k1*ilwe) + wx2*k0;
     Phi[1][0] = wx*k0 - I33dT - wx2*(ilwe*ilwe*ilwe)*(lwedT-k1);
 
-    x0 = O*q;
+    x0 = kernels::mul(O, q);
     if (x0.w < 0)
         x0 = -x0;
 
-    P = Phi*P*transpose(Phi) + GQGt;
+    // Phi[0][1] and Phi[1][1] never change from 0 and 1
+    kernels::propagateCovariance(P, Phi[0][0], Phi[1][0], GQGt);
 
     checkState();
 }
@@ -446,9 +434,9 @@ void Fusion::update(const vec3_t& z, const vec3_t& Bi, float sigma) {
     const mat33_t R(sigma*sigma);
     const mat33_t S(scaleCovariance(L, P[0][0]) + R);
     const mat33_t Si(invert(S));
-    const mat33_t LtSi(transpose(L)*Si);
-    K[0] = P[0][0] * LtSi;
-    K[1] = transpose(P[1][0])*LtSi;
+    const mat33_t LtSi(kernels::mul(transpose(L), Si));
+    K[0] = kernels::mul(P[0][0], LtSi);
+    K[1] = kernels::mul(transpose(P[1][0]), LtSi);
 
     // update...
     // P = (I-K*H) * P
@@ -457,18 +445,18 @@ void Fusion::update(const vec3_t& z, const vec3_t& Bi, float sigma) {
     // | K1 |                 | K1*L  0 |   | P01  P11 |   | K1*L*P00  K1*L*P10 |
     // Note: the Joseph form is numerically more stable and given by:
     //     P = (I-KH) * P * (I-KH)' + K*R*R'
-    const mat33_t K0L(K[0] * L);
-    const mat33_t K1L(K[1] * L);
-    P[0][0] -= K0L*P[0][0];
-    P[1][1] -= K1L*P[1][0];
-    P[1][0] -= K0L*P[1][0];
+    const mat33_t K0L(kernels::mul(K[0], L));
+    const mat33_t K1L(kernels::mul(K[1], L));
+    P[0][0] -= kernels::mul(K0L, P[0][0]);
+    P[1][1] -= kernels::mul(K1L, P[1][0]);
+    P[1][0] -= kernels::mul(K0L, P[1][0]);
     P[0][1] = transpose(P[1][0]);
 
     const vec3_t e(z - Bb);
     const vec3_t dq(K[0]*e);
     const vec3_t db(K[1]*e);
 
-    q += getF(q)*(0.5f*dq);
+    q += kernels::mulF(q, 0.5f*dq);
     x0 = normalize_quat(q);
     x1 += db;
 
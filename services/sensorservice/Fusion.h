@@ -77,7 +77,6 @@ private:
     void checkState();
     void predict(const vec3_t& w, float dT);
     void update(const vec3_t& z, const vec3_t& Bi, float sigma);
-    static mat34_t getF(const vec4_t& p);
 };
 
 }; // namespace android
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_FUSION_KERNELS_H
+#define ANDROID_FUSION_KERNELS_H
+
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#define FUSION_KERNELS_NEON 1
+#endif
+
+#include "mat.h"
+#include "vec.h"
+
+// -----------------------------------------------------------------------
+
+/*
+ * The operations Fusion does for every gyro event. Each one returns exactly
+ * what the equivalent mat/vec expression returns: the products and sums are
+ * done in the same order, and only terms known to be zero, or products by
+ * an identity, are skipped. The NEON versions work on whole columns but
+ * round the same way, since their multiplies and adds aren't fused (the
+ * module is built with -ffp-contract=off so the generic ones aren't
+ * either). The only difference can be the sign of a zero.
+ */
+
+namespace android {
+namespace kernels {
+
+typedef mat<mat33_t, 2, 2> mat66_t;
+
+#if FUSION_KERNELS_NEON
+
+// loads the 3 floats at p; the 4th lane is zero
+inline float32x4_t load3(const float* p) {
+    return vcombine_f32(vld1_f32(p), vld1_lane_f32(p + 2, vdup_n_f32(0), 0));
+}
+
+inline void store3(float* p, float32x4_t v) {
+    vst1_f32(p, vget_low_f32(v));
+    vst1q_lane_f32(p + 2, v, 2);
+}
+
+// a*b
+inline mat33_t PURE mul(const mat33_t& a, const mat33_t& b) {
+    // the first two columns can be loaded 4 floats at a time, the extra
+    // lane is the next column's first element and is never stored
+    const float32x4_t a0 = vld1q_f32(&a[0][0]);
+    const float32x4_t a1 = vld1q_f32(&a[1][0]);
+    const float32x4_t a2 = load3(&a[2][0]);
+    mat33_t res;
+    for (size_t c=0 ; c<3 ; c++) {
+        float32x4_t v = vmulq_n_f32(a0, b[c][0]);
+        v = vaddq_f32(v, vmulq_n_f32(a1, b[c][1]));
+        v = vaddq_f32(v, vmulq_n_f32(a2, b[c][2]));
+        store3(&res[c][0], v);
+    }
+    return res;
+}
+
+// o*q
+inline vec4_t PURE mul(const mat44_t& o, const vec4_t& q) {
+    float32x4_t v = vmulq_n_f32(vld1q_f32(&o[0][0]), q.x);
+    v = vaddq_f32(v, vmulq_n_f32(vld1q_f32(&o[1][0]), q.y));
+    v = vaddq_f32(v, vmulq_n_f32(vld1q_f32(&o[2][0]), q.z));
+    v = vaddq_f32(v, vmulq_n_f32(vld1q_f32(&o[3][0]), q.w));
+    vec4_t res;
+    vst1q_f32(&res[0], v);
+    return res;
+}
+
+#else
+
+inline mat33_t PURE mul(const mat33_t& a, const mat33_t& b) {
+    return a*b;
+}
+
+inline vec4_t PURE mul(const mat44_t& o, const vec4_t& q) {
+    return o*q;
+}
+
+#endif
+
+// F(q)*v, where F(q) is the matrix Fusion::update uses to get the
+// derivative of q:
+// F = | [q.xyz]x |
+//     |  -q.xyz  |
+// without building the matrix.
+inline vec4_t PURE mulF(const vec4_t& q, const vec3_t& v) {
+    vec4_t res;
+    res.x =  q.w*v.x + -q.z*v.y +  q.y*v.z;
+    res.y =  q.z*v.x +  q.w*v.y + -q.x*v.z;
+    res.z = -q.y*v.x +  q.x*v.y +  q.w*v.z;
+    res.w = -q.x*v.x + -q.y*v.y + -q.z*v.z;
+    return res;
+}
+
+// P = Phi*P*transpose(Phi) + GQGt, for
+// Phi = | Phi00 Phi10 |
+//       |   0     1   |
+// which is half the 3x3 products of the full expression.
+inline void propagateCovariance(mat66_t& P,
+        const mat33_t& Phi00, const mat33_t& Phi10, const mat66_t& GQGt) {
+    // T = Phi*P, its second row is the second row of P
+    const mat33_t T00(mul(Phi00, P[0][0]) + mul(Phi10, P[0][1]));
+    const mat33_t T10(mul(Phi00, P[1][0]) + mul(Phi10, P[1][1]));
+
+    // P = T*transpose(Phi), its second column is the second column of T
+    const mat33_t Phi00t(transpose(Phi00));
+    const mat33_t Phi10t(transpose(Phi10));
+    const mat33_t P00(mul(T00, Phi00t) + mul(T10, Phi10t));
+    const mat33_t P01(mul(P[0][1], Phi00t) + mul(P[1][1], Phi10t));
+    P[0][0] = P00 + GQGt[0][0];
+    P[0][1] = P01 + GQGt[0][1];
+    P[1][0] = T10 + GQGt[1][0];
+    P[1][1] = P[1][1] + GQGt[1][1];
+}
+
+}; // namespace kernels
+}; // namespace android
+
+#endif /* ANDROID_FUSION_KERNELS_H */
@@ -45,7 +45,7 @@ bool OrientationSensor::process(sensors_event_t* outEvent,
         if (mSensorFusion.hasEstimate()) {
             vec3_t g;
             const float rad2deg = 180 / M_PI;
-            const mat33_t R(mSensorFusion.getRotationMatrix());
+            const mat33_t& R(mSensorFusion.getRotationMatrix());
             g[0] = atan2f(-R[1][0], R[0][0])    * rad2deg;
             g[1] = atan2f(-R[2][1], R[2][2])    * rad2deg;
             g[2] = asinf ( R[2][0])             * rad2deg;
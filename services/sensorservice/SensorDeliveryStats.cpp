@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "SensorDeliveryStats.h"
+
+namespace android {
+// ---------------------------------------------------------------------------
+
+const nsecs_t SensorDeliveryStats::FIRST_BUCKET_NS;
+
+SensorDeliveryStats::SensorDeliveryStats()
+    : mDelivered(0), mCached(0), mDropped(0), mSkewed(0),
+      mTotalLatency(0), mMaxLatency(0)
+{
+    memset(mLatencyBuckets, 0, sizeof(mLatencyBuckets));
+}
+
+void SensorDeliveryStats::dump(String8& result, const char* prefix) const {
+    result.appendFormat("%sdelivered %" PRIu64 " | cached %" PRIu64 " | dropped %" PRIu64
+            " | latency mean %.2fms max %.2fms | skewed timestamps %" PRIu64 "\n",
+            prefix, mDelivered, mCached, mDropped,
+            mDelivered ? mTotalLatency / (mDelivered * 1e6) : 0.0,
+            mMaxLatency / 1e6, mSkewed);
+    if (mDelivered == 0) {
+        return;
+    }
+    result.appendFormat("%slatency histogram (ms):", prefix);
+    for (size_t i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+        if (i < NUM_LATENCY_BUCKETS - 1) {
+            result.appendFormat(" <%g: %u", (FIRST_BUCKET_NS << i) / 1e6, mLatencyBuckets[i]);
+        } else {
+            result.appendFormat(" >=%g: %u", (FIRST_BUCKET_NS << (i - 1)) / 1e6,
+                    mLatencyBuckets[i]);
+        }
+    }
+    result.append("\n");
+}
+
+// ---------------------------------------------------------------------------
+}; // namespace android
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_DELIVERY_STATS_H
+#define ANDROID_SENSOR_DELIVERY_STATS_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+// ---------------------------------------------------------------------------
+
+namespace android {
+// ---------------------------------------------------------------------------
+
+/*
+ * What happened to the events SensorService had for a client: how many were
+ * delivered (written to the socket or the event ring), how many had to wait
+ * in the connection's cache, and how many were dropped because the cache was
+ * full. Delivered events also go in a histogram of the time between their
+ * timestamp and their delivery, which includes the time spent in the HAL's
+ * FIFO for batched sensors.
+ *
+ * Counting is cheap enough to be always on; the caller provides locking.
+ */
+class SensorDeliveryStats {
+public:
+    // The first bucket is for latencies below FIRST_BUCKET_NS, each next one
+    // is twice as wide, the last one has no upper bound.
+    enum { NUM_LATENCY_BUCKETS = 12 };
+    static const nsecs_t FIRST_BUCKET_NS = 250000;
+
+    SensorDeliveryStats();
+
+    // latency is the delivery time minus the event's timestamp. A negative
+    // one means the HAL's timestamps aren't on the elapsed realtime clock;
+    // those are counted in the first bucket and in the skewed count.
+    void onDelivered(nsecs_t latency) {
+        mDelivered++;
+        if (latency < 0) {
+            mSkewed++;
+            latency = 0;
+        }
+        mTotalLatency += latency;
+        if (latency > mMaxLatency) {
+            mMaxLatency = latency;
+        }
+        mLatencyBuckets[bucketFor(latency)]++;
+    }
+    void onCached(size_t count) { mCached += count; }
+    void onDropped(size_t count) { mDropped += count; }
+
+    uint64_t getDelivered() const { return mDelivered; }
+    uint64_t getCached() const { return mCached; }
+    uint64_t getDropped() const { return mDropped; }
+
+    // Appends the counts on one line and the histogram on the next, each
+    // line starting with prefix.
+    void dump(String8& result, const char* prefix) const;
+
+private:
+    static size_t bucketFor(nsecs_t latency) {
+        const uint64_t q = uint64_t(latency / FIRST_BUCKET_NS);
+        if (q == 0) {
+            return 0;
+        }
+        // bucket i > 0 holds [FIRST_BUCKET_NS << (i-1), FIRST_BUCKET_NS << i)
+        const size_t bucket = 64 - __builtin_clzll(q);
+        return bucket < NUM_LATENCY_BUCKETS ? bucket : NUM_LATENCY_BUCKETS - 1;
+    }
+
+    uint64_t mDelivered;
+    uint64_t mCached;
+    uint64_t mDropped;
+    uint64_t mSkewed;
+    nsecs_t mTotalLatency;
+    nsecs_t mMaxLatency;
+    uint32_t mLatencyBuckets[NUM_LATENCY_BUCKETS];
+};
+
+// ---------------------------------------------------------------------------
+}; // namespace android
+
+#endif // ANDROID_SENSOR_DELIVERY_STATS_H
@@ -17,8 +17,11 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <sys/types.h>
 
+#include <cutils/properties.h>
+
 #include <utils/Atomic.h>
 #include <utils/Errors.h>
 #include <utils/Singleton.h>
@@ -41,8 +44,19 @@ SensorDevice::SensorDevice()
     :  mSensorDevice(0),
        mSensorModule(0)
 {
-    status_t err = hw_get_module(SENSORS_HARDWARE_MODULE_ID,
-            (hw_module_t const**)&mSensorModule);
+    status_t err;
+    char hal[PROPERTY_VALUE_MAX];
+    if (property_get("ro.debuggable", hal, "0") > 0 && atoi(hal) &&
+            property_get("debug.sensors.hal", hal, NULL) > 0) {
+        // Debuggable builds can use another HAL, sensors.<hal>.*.so, such as the replay HAL
+        // of the sensorservice tests.
+        ALOGI("using sensors.%s HAL", hal);
+        err = hw_get_module_by_class(SENSORS_HARDWARE_MODULE_ID, hal,
+                (hw_module_t const**)&mSensorModule);
+    } else {
+        err = hw_get_module(SENSORS_HARDWARE_MODULE_ID,
+                (hw_module_t const**)&mSensorModule);
+    }
 
     ALOGE_IF(err, "couldn't load %s module (%s)",
             SENSORS_HARDWARE_MODULE_ID, strerror(-err));
@@ -126,11 +140,24 @@ ssize_t SensorDevice::poll(sensors_event_t* buffer, size_t count) {
 }
 
 void SensorDevice::autoDisable(void *ident, int handle) {
-    Info& info( mActivationCount.editValueFor(handle) );
     Mutex::Autolock _l(mLock);
+    Info& info( mActivationCount.editValueFor(handle) );
     info.removeBatchParamsForIdent(ident);
 }
 
+status_t SensorDevice::getBatchParams(int handle, nsecs_t* outSamplingPeriodNs,
+                                      nsecs_t* outMaxBatchReportLatencyNs) const {
+    Mutex::Autolock _l(mLock);
+    ssize_t index = mActivationCount.indexOfKey(handle);
+    if (index < 0 || mActivationCount.valueAt(index).batchParams.isEmpty()) {
+        return BAD_VALUE;
+    }
+    const BatchParams& params = mActivationCount.valueAt(index).bestBatchParams;
+    *outSamplingPeriodNs = params.batchDelay;
+    *outMaxBatchReportLatencyNs = params.batchTimeout;
+    return NO_ERROR;
+}
+
 status_t SensorDevice::activate(void* ident, int handle, int enabled)
 {
     if (!mSensorDevice) return NO_INIT;
@@ -159,11 +186,12 @@ status_t SensorDevice::activate(void* ident, int handle, int enabled)
     } else {
         ALOGD_IF(DEBUG_CONNECTIONS, "disable index=%zd", info.batchParams.indexOfKey(ident));
 
+        BatchParams prevBestBatchParams = info.bestBatchParams;
         if (info.removeBatchParamsForIdent(ident) >= 0) {
             if (info.batchParams.size() == 0) {
                 // This is the last connection, we need to de-activate the underlying h/w sensor.
                 actuateHardware = true;
-            } else {
+            } else if (prevBestBatchParams != info.bestBatchParams) {
                 const int halVersion = getHalDeviceVersion();
                 if (halVersion >= SENSORS_DEVICE_API_VERSION_1_1) {
                     // Call batch for this sensor with the previously calculated best effort
@@ -228,17 +256,9 @@ status_t SensorDevice::batch(void* ident, int handle, int flags, int64_t samplin
     Mutex::Autolock _l(mLock);
     Info& info(mActivationCount.editValueFor(handle));
 
-    if (info.batchParams.indexOfKey(ident) < 0) {
-        BatchParams params(flags, samplingPeriodNs, maxBatchReportLatencyNs);
-        info.batchParams.add(ident, params);
-    } else {
-        // A batch has already been called with this ident. Update the batch parameters.
-        info.setBatchParamsForIdent(ident, flags, samplingPeriodNs, maxBatchReportLatencyNs);
-    }
-
     BatchParams prevBestBatchParams = info.bestBatchParams;
-    // Find the minimum of all timeouts and batch_rates for this sensor.
-    info.selectBatchParams();
+    // Also finds the minimum of all timeouts and batch_rates for this sensor.
+    info.setBatchParamsForIdent(ident, flags, samplingPeriodNs, maxBatchReportLatencyNs);
 
     ALOGD_IF(DEBUG_CONNECTIONS,
              "\t>>> curr_period=%" PRId64 " min_period=%" PRId64
@@ -289,9 +309,13 @@ status_t SensorDevice::setDelay(void* ident, int handle, int64_t samplingPeriodN
     if (index < 0) {
         return BAD_INDEX;
     }
-    BatchParams& params = info.batchParams.editValueAt(index);
-    params.batchDelay = samplingPeriodNs;
-    info.selectBatchParams();
+    const BatchParams& params = info.batchParams.valueAt(index);
+    const nsecs_t prevBatchDelay = info.bestBatchParams.batchDelay;
+    info.setBatchParamsForIdent(ident, params.flags, samplingPeriodNs, params.batchTimeout);
+    if (info.bestBatchParams.batchDelay == prevBatchDelay) {
+        // The sensor already runs at the rate asked for.
+        return NO_ERROR;
+    }
     return mSensorDevice->setDelay(reinterpret_cast<struct sensors_poll_device_t *>(mSensorDevice),
                                    handle, info.bestBatchParams.batchDelay);
 }
@@ -312,45 +336,45 @@ status_t SensorDevice::flush(void* ident, int handle) {
 
 // ---------------------------------------------------------------------------
 
-status_t SensorDevice::Info::setBatchParamsForIdent(void* ident, int flags,
-                                                    int64_t samplingPeriodNs,
-                                                    int64_t maxBatchReportLatencyNs) {
+void SensorDevice::Info::setBatchParamsForIdent(void* ident, int flags,
+                                                int64_t samplingPeriodNs,
+                                                int64_t maxBatchReportLatencyNs) {
     ssize_t index = batchParams.indexOfKey(ident);
     if (index < 0) {
-        ALOGE("Info::setBatchParamsForIdent(ident=%p, period_ns=%" PRId64 " timeout=%" PRId64 ") failed (%s)",
-              ident, samplingPeriodNs, maxBatchReportLatencyNs, strerror(-index));
-        return BAD_INDEX;
+        index = batchParams.add(ident, BatchParams());
+    } else {
+        // A batch has already been called with this ident. Drop the old values.
+        const BatchParams& params = batchParams.valueAt(index);
+        batchDelays.remove(IdentValue(params.batchDelay, ident));
+        batchTimeouts.remove(IdentValue(params.batchTimeout, ident));
     }
     BatchParams& params = batchParams.editValueAt(index);
     params.flags = flags;
     params.batchDelay = samplingPeriodNs;
     params.batchTimeout = maxBatchReportLatencyNs;
-    return NO_ERROR;
+    batchDelays.add(IdentValue(samplingPeriodNs, ident));
+    batchTimeouts.add(IdentValue(maxBatchReportLatencyNs, ident));
+    selectBatchParams();
 }
 
 void SensorDevice::Info::selectBatchParams() {
     BatchParams bestParams(-1, -1, -1);
 
     if (batchParams.size() > 0) {
-        BatchParams params = batchParams.valueAt(0);
-        bestParams = params;
-    }
-
-    for (size_t i = 1; i < batchParams.size(); ++i) {
-        BatchParams params = batchParams.valueAt(i);
-        if (params.batchDelay < bestParams.batchDelay) {
-            bestParams.batchDelay = params.batchDelay;
-        }
-        if (params.batchTimeout < bestParams.batchTimeout) {
-            bestParams.batchTimeout = params.batchTimeout;
-        }
+        bestParams.flags = batchParams.valueAt(0).flags;
+        bestParams.batchDelay = batchDelays.itemAt(0).value;
+        bestParams.batchTimeout = batchTimeouts.itemAt(0).value;
     }
     bestBatchParams = bestParams;
 }
 
 ssize_t SensorDevice::Info::removeBatchParamsForIdent(void* ident) {
-    ssize_t idx = batchParams.removeItem(ident);
+    ssize_t idx = batchParams.indexOfKey(ident);
     if (idx >= 0) {
+        const BatchParams& params = batchParams.valueAt(idx);
+        batchDelays.remove(IdentValue(params.batchDelay, ident));
+        batchTimeouts.remove(IdentValue(params.batchTimeout, ident));
+        batchParams.removeItemsAt(idx);
         selectBatchParams();
     }
     return idx;
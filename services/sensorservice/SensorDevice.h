@@ -21,6 +21,7 @@
 #include <sys/types.h>
 
 #include <utils/KeyedVector.h>
+#include <utils/SortedVector.h>
 #include <utils/Singleton.h>
 #include <utils/String8.h>
 
@@ -53,6 +54,18 @@ class SensorDevice : public Singleton<SensorDevice> {
       }
     };
 
+    // A delay or a timeout asked for by a client. The ident breaks ties so that several clients
+    // can ask for the same value.
+    struct IdentValue {
+      nsecs_t value;
+      void* ident;
+      IdentValue() : value(0), ident(NULL) {}
+      IdentValue(nsecs_t value, void* ident) : value(value), ident(ident) {}
+      bool operator < (const IdentValue& rhs) const {
+          return (value == rhs.value) ? (ident < rhs.ident) : (value < rhs.value);
+      }
+    };
+
     // Store batch parameters in the KeyedVector and the optimal batch_rate and timeout in
     // bestBatchParams. For every batch() call corresponding params are stored in batchParams
     // vector. A continuous mode request is batch(... timeout=0 ..) followed by activate(). A batch
@@ -64,12 +77,15 @@ class SensorDevice : public Singleton<SensorDevice> {
         // Key is the unique identifier(ident) for each client, value is the batch parameters
         // requested by the client.
         KeyedVector<void*, BatchParams> batchParams;
+        // The delays and timeouts in batchParams, smallest first. The best ones are looked up
+        // without going through all the clients.
+        SortedVector<IdentValue> batchDelays, batchTimeouts;
 
         Info() : bestBatchParams(-1, -1, -1) {}
-        // Sets batch parameters for this ident. Returns error if this ident is not already present
-        // in the KeyedVector above.
-        status_t setBatchParamsForIdent(void* ident, int flags, int64_t samplingPeriodNs,
-                                        int64_t maxBatchReportLatencyNs);
+        // Adds the batch parameters for this ident, or updates them if it is already present in
+        // the KeyedVector above.
+        void setBatchParamsForIdent(void* ident, int flags, int64_t samplingPeriodNs,
+                                    int64_t maxBatchReportLatencyNs);
         // Finds the optimal parameters for batching and stores them in bestBatchParams variable.
         void selectBatchParams();
         // Removes batchParams for an ident and re-computes bestBatchParams. Returns the index of
@@ -91,6 +107,10 @@ public:
     status_t setDelay(void* ident, int handle, int64_t ns);
     status_t flush(void* ident, int handle);
     void autoDisable(void *ident, int handle);
+    // Gets the sampling period and the report latency the HAL sensor runs at, which are the best
+    // of what its clients asked for. Returns BAD_VALUE if no client enabled it.
+    status_t getBatchParams(int handle, nsecs_t* outSamplingPeriodNs,
+                            nsecs_t* outMaxBatchReportLatencyNs) const;
     void dump(String8& result);
 };
 
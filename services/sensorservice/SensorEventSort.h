@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_EVENT_SORT_H
+#define ANDROID_SENSOR_EVENT_SORT_H
+
+#include <stddef.h>
+#include <string.h>
+
+#include <hardware/sensors.h>
+
+// -----------------------------------------------------------------------
+
+namespace android {
+
+/*
+ * Sorts count events by timestamp, keeping events with the same timestamp
+ * in the order they were in. scratch must hold count events.
+ *
+ * The buffer SensorService sorts is the HAL's events followed by what the
+ * virtual sensors made of them, so it is a few runs already in order
+ * rather than random: each pass merges pairs of adjacent runs into the
+ * other buffer, which takes log2(runs) passes instead of the n*log(n)
+ * compares and swaps of whole events a quicksort does. A buffer already in
+ * order is only scanned.
+ */
+inline void sortEventsByTimestamp(sensors_event_t* buffer,
+        sensors_event_t* scratch, size_t count) {
+    sensors_event_t* src = buffer;
+    sensors_event_t* dst = scratch;
+    for (;;) {
+        size_t runs = 0;
+        size_t i = 0;
+        while (i < count) {
+            // [i, mid) and [mid, end) are the next two runs
+            size_t mid = i + 1;
+            while (mid < count && src[mid - 1].timestamp <= src[mid].timestamp) {
+                mid++;
+            }
+            if (i == 0 && mid == count) {
+                // a single run: in order
+                break;
+            }
+            size_t end = mid;
+            if (end < count) {
+                end++;
+                while (end < count && src[end - 1].timestamp <= src[end].timestamp) {
+                    end++;
+                }
+            }
+            size_t a = i, b = mid, out = i;
+            while (a < mid && b < end) {
+                // ties are taken from the first run, which keeps it stable
+                if (src[b].timestamp < src[a].timestamp) {
+                    dst[out++] = src[b++];
+                } else {
+                    dst[out++] = src[a++];
+                }
+            }
+            memcpy(&dst[out], &src[a], (mid - a) * sizeof(sensors_event_t));
+            out += mid - a;
+            memcpy(&dst[out], &src[b], (end - b) * sizeof(sensors_event_t));
+            i = end;
+            runs++;
+        }
+        if (runs == 0) {
+            break;
+        }
+        sensors_event_t* const t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != buffer) {
+        memcpy(buffer, src, count * sizeof(sensors_event_t));
+    }
+}
+
+}; // namespace android
+
+#endif // ANDROID_SENSOR_EVENT_SORT_H
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <hardware/sensors.h>
+
 #include "SensorDevice.h"
 #include "SensorFusion.h"
 #include "SensorService.h"
@@ -25,7 +27,7 @@ ANDROID_SINGLETON_STATIC_INSTANCE(SensorFusion)
 
 SensorFusion::SensorFusion()
     : mSensorDevice(SensorDevice::getInstance()),
-      mEnabled(false), mGyroTime(0)
+      mEnabled(false), mGyroTime(0), mDerivedStateValid(false)
 {
     sensor_t const* list;
     Sensor uncalibratedGyro;
@@ -64,6 +66,7 @@ void SensorFusion::process(const sensors_event_t& event) {
         if (mGyroTime != 0) {
             const float dT = (event.timestamp - mGyroTime) / 1000000000.0f;
             mFusion.handleGyro(vec3_t(event.data), dT);
+            mDerivedStateValid = false;
             // here we estimate the gyro rate (useful for debugging)
             const float freq = 1 / dT;
             if (freq >= 100 && freq<1000) { // filter values obviously wrong
@@ -75,13 +78,36 @@ void SensorFusion::process(const sensors_event_t& event) {
     } else if (event.type == SENSOR_TYPE_MAGNETIC_FIELD) {
         const vec3_t mag(event.data);
         mFusion.handleMag(mag);
+        mDerivedStateValid = false;
     } else if (event.type == SENSOR_TYPE_ACCELEROMETER) {
         const vec3_t acc(event.data);
         mFusion.handleAcc(acc);
         mAttitude = mFusion.getAttitude();
+        mDerivedStateValid = false;
+    }
+}
+
+void SensorFusion::updateDerivedState() const {
+    if (!mDerivedStateValid) {
+        mRotationMatrix = mFusion.getRotationMatrix();
+        // FIXME: we need to estimate the length of gravity because
+        // the accelerometer may have a small scaling error. This
+        // translates to an offset in the linear-acceleration sensor.
+        mGravity = mRotationMatrix[2] * GRAVITY_EARTH;
+        mDerivedStateValid = true;
     }
 }
 
+const mat33_t& SensorFusion::getRotationMatrix() const {
+    updateDerivedState();
+    return mRotationMatrix;
+}
+
+const vec3_t& SensorFusion::getGravity() const {
+    updateDerivedState();
+    return mGravity;
+}
+
 template <typename T> inline T min(T a, T b) { return a<b ? a : b; }
 template <typename T> inline T max(T a, T b) { return a>b ? a : b; }
 
@@ -112,6 +138,7 @@ status_t SensorFusion::activate(void* ident, bool enabled) {
         if (newState) {
             mFusion.init();
             mGyroTime = 0;
+            mDerivedStateValid = false;
         }
     }
     return NO_ERROR;
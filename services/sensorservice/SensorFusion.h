@@ -50,14 +50,23 @@ class SensorFusion : public Singleton<SensorFusion> {
     vec4_t mAttitude;
     SortedVector<void*> mClients;
 
+    // Derived from the fusion state by the first caller after each change,
+    // so the virtual sensors fed by the same event share them.
+    mutable bool mDerivedStateValid;
+    mutable mat33_t mRotationMatrix;
+    mutable vec3_t mGravity;
+
     SensorFusion();
+    void updateDerivedState() const;
 
 public:
     void process(const sensors_event_t& event);
 
     bool isEnabled() const { return mEnabled; }
     bool hasEstimate() const { return mFusion.hasEstimate(); }
-    mat33_t getRotationMatrix() const { return mFusion.getRotationMatrix(); }
+    const mat33_t& getRotationMatrix() const;
+    // the gravity vector in the device frame, in m/s^2
+    const vec3_t& getGravity() const;
     vec4_t getAttitude() const { return mAttitude; }
     vec3_t getGyroBias() const { return mFusion.getBias(); }
     float getEstimatedRate() const { return mEstimatedGyroRate; }
@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include <cutils/properties.h>
 
@@ -48,6 +51,7 @@
 #include "LinearAccelerationSensor.h"
 #include "OrientationSensor.h"
 #include "RotationVectorSensor.h"
+#include "SensorEventSort.h"
 #include "SensorFusion.h"
 #include "SensorService.h"
 
@@ -65,9 +69,15 @@ namespace android {
 
 const char* SensorService::WAKE_LOCK_NAME = "SensorService";
 
+// The sensor an event is from. buffer[i].sensor is zero for meta_data events.
+static int32_t getSensorHandle(const sensors_event_t& event) {
+    return event.type == SENSOR_TYPE_META_DATA ? event.meta_data.sensor : event.sensor;
+}
+
 SensorService::SensorService()
     : mInitCheck(NO_INIT), mSocketBufferSize(SOCKET_BUFFER_SIZE_NON_BATCHED),
-      mWakeLockAcquired(false)
+      mWakeLockAcquired(false), mWakeLockAcquireCount(0), mWakeLockAcquireTime(0),
+      mWakeLockHeldTotal(0), mWakeLockHeldMax(0)
 {
 }
 
@@ -190,6 +200,8 @@ void SensorService::onFirstRef()
             mSensorEventBuffer = new sensors_event_t[minBufferSize];
             mSensorEventScratch = new sensors_event_t[minBufferSize];
             mMapFlushEventsToConnections = new SensorEventConnection const * [minBufferSize];
+            mEventIndicesBySensor = new uint32_t[minBufferSize];
+            mConnectionEventIndices = new uint32_t[minBufferSize];
 
             mInitCheck = NO_ERROR;
             run("SensorService", PRIORITY_URGENT_DISPLAY);
@@ -336,9 +348,16 @@ status_t SensorService::dump(int fd, const Vector<String16>& /*args*/)
                     mActiveSensors.valueAt(i)->getNumConnections());
         }
 
-        result.appendFormat("Socket Buffer size = %d events\n",
+        result.appendFormat("Max socket buffer size = %d events\n",
                             mSocketBufferSize/sizeof(sensors_event_t));
         result.appendFormat("WakeLock Status: %s \n", mWakeLockAcquired ? "acquired" : "not held");
+        nsecs_t wakeLockHeld = mWakeLockHeldTotal;
+        if (mWakeLockAcquired) {
+            wakeLockHeld += systemTime(SYSTEM_TIME_BOOTTIME) - mWakeLockAcquireTime;
+        }
+        result.appendFormat("WakeLock acquired %u times | held %.3fs in total | longest %.3fs"
+                " | ack timeout %.1fs\n", mWakeLockAcquireCount, wakeLockHeld / 1e9,
+                mWakeLockHeldMax / 1e9, WAKE_LOCK_ACK_TIMEOUT_NS / 1e9);
         result.appendFormat("%zd active connections\n", mActiveConnections.size());
 
         for (size_t i=0 ; i < mActiveConnections.size() ; i++) {
@@ -433,8 +452,7 @@ bool SensorService::threadLoop()
         }
 
         if (bufferHasWakeUpEvent && !mWakeLockAcquired) {
-            acquire_wake_lock(PARTIAL_WAKE_LOCK, WAKE_LOCK_NAME);
-            mWakeLockAcquired = true;
+            acquireWakeLockLocked();
         }
         recordLastValueLocked(mSensorEventBuffer, count);
 
@@ -471,7 +489,7 @@ bool SensorService::threadLoop()
                     recordLastValueLocked(&mSensorEventBuffer[count], k);
                     count += k;
                     // sort the buffer by time-stamps
-                    sortEventBuffer(mSensorEventBuffer, count);
+                    sortEventBuffer(mSensorEventBuffer, mSensorEventScratch, count);
                 }
             }
         }
@@ -503,27 +521,44 @@ bool SensorService::threadLoop()
             }
         }
 
+        // Split the batch by sensor once, and find the connections registered for each of its
+        // sensors from the SensorRecords, so that each connection only goes through its own
+        // events. If the batch can't be split, every connection goes through all of it.
+        const size_t numConnections = activeConnections.size();
+        Vector<uint32_t> subscribedSensors;
+        const bool split = splitEventsBySensorLocked(count);
+        if (split) {
+            findSubscribersLocked(activeConnections, &subscribedSensors);
+        } else {
+            for (int i = 0; i < count; ++i) {
+                mConnectionEventIndices[i] = i;
+            }
+        }
+
         // Send our events to clients. Check the state of wake lock for each client and release the
         // lock if none of the clients need it.
         bool needsWakeLock = false;
-        size_t numConnections = activeConnections.size();
         for (size_t i=0 ; i < numConnections; ++i) {
             if (activeConnections[i] != 0) {
-                activeConnections[i]->sendEvents(mSensorEventBuffer, count, mSensorEventScratch,
-                        mMapFlushEventsToConnections);
-                needsWakeLock |= activeConnections[i]->needsWakeLock();
-                // If the connection has one-shot sensors, it may be cleaned up after first trigger.
-                // Early check for one-shot sensors.
-                if (activeConnections[i]->hasOneShotSensors()) {
-                    cleanupAutoDisabledSensorLocked(activeConnections[i], mSensorEventBuffer,
-                            count);
+                if (!split || subscribedSensors[i] != 0) {
+                    uint32_t const* eventIndices = mConnectionEventIndices;
+                    const size_t numEventIndices = split ?
+                            collectEventsLocked(subscribedSensors[i], &eventIndices) : size_t(count);
+                    activeConnections[i]->sendEvents(mSensorEventBuffer, numEventIndices,
+                            mSensorEventScratch, mMapFlushEventsToConnections, eventIndices);
+                    // If the connection has one-shot sensors, it may be cleaned up after first
+                    // trigger. Early check for one-shot sensors.
+                    if (activeConnections[i]->hasOneShotSensors()) {
+                        cleanupAutoDisabledSensorLocked(activeConnections[i], mSensorEventBuffer,
+                                count);
+                    }
                 }
+                needsWakeLock |= activeConnections[i]->needsWakeLock();
             }
         }
 
         if (mWakeLockAcquired && !needsWakeLock) {
-            release_wake_lock(WAKE_LOCK_NAME);
-            mWakeLockAcquired = false;
+            releaseWakeLockLocked();
         }
     } while (!Thread::exitPending());
 
@@ -538,13 +573,127 @@ sp<Looper> SensorService::getLooper() const {
 
 bool SensorService::SensorEventAckReceiver::threadLoop() {
     ALOGD("new thread SensorEventAckReceiver");
+    int timeoutMillis = -1;
     do {
         sp<Looper> looper = mService->getLooper();
-        looper->pollOnce(-1);
+        looper->pollOnce(timeoutMillis);
+        timeoutMillis = mService->checkWakeLockTimeouts();
     } while(!Thread::exitPending());
     return false;
 }
 
+bool SensorService::splitEventsBySensorLocked(size_t count) {
+    mEventRanges.clear();
+    // mConnectionEventIndices isn't in use yet, it holds the range of each event for now.
+    uint32_t* const ranges = mConnectionEventIndices;
+    size_t range = 0;
+    for (size_t i = 0; i < count; i++) {
+        const int32_t handle = getSensorHandle(mSensorEventBuffer[i]);
+        // Events of the same sensor usually come in runs, check the previous one first.
+        if (mEventRanges.isEmpty() || mEventRanges[range].handle != handle) {
+            for (range = 0; range < mEventRanges.size(); range++) {
+                if (mEventRanges[range].handle == handle) {
+                    break;
+                }
+            }
+            if (range == mEventRanges.size()) {
+                if (range == MAX_SPLIT_SENSORS) {
+                    return false;
+                }
+                SensorEventRange newRange;
+                newRange.handle = handle;
+                newRange.start = 0;
+                newRange.count = 0;
+                mEventRanges.add(newRange);
+            }
+        }
+        mEventRanges.editItemAt(range).count++;
+        ranges[i] = range;
+    }
+
+    size_t start = 0;
+    for (size_t r = 0; r < mEventRanges.size(); r++) {
+        SensorEventRange& eventRange(mEventRanges.editItemAt(r));
+        eventRange.start = start;
+        start += eventRange.count;
+        eventRange.count = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        SensorEventRange& eventRange(mEventRanges.editItemAt(ranges[i]));
+        mEventIndicesBySensor[eventRange.start + eventRange.count++] = i;
+    }
+    return true;
+}
+
+void SensorService::findSubscribersLocked(
+        const SortedVector< sp<SensorEventConnection> >& connections,
+        Vector<uint32_t>* outMasks) const {
+    outMasks->insertAt(0, 0, connections.size());
+    for (size_t r = 0; r < mEventRanges.size(); r++) {
+        SensorRecord* rec = mActiveSensors.valueFor(mEventRanges[r].handle);
+        if (rec == NULL) {
+            continue;
+        }
+        // The connections are sorted by address. Look them up by address rather than promoting
+        // the weak pointers, which could leave us with the last reference under mLock.
+        const SortedVector< wp<SensorEventConnection> >& subscribers(rec->getConnections());
+        for (size_t j = 0; j < subscribers.size(); j++) {
+            SensorEventConnection* const subscriber = subscribers[j].unsafe_get();
+            ssize_t lo = 0;
+            ssize_t hi = ssize_t(connections.size()) - 1;
+            while (lo <= hi) {
+                const ssize_t mid = (lo + hi) / 2;
+                SensorEventConnection* const connection = connections[mid].get();
+                if (connection == subscriber) {
+                    outMasks->editItemAt(mid) |= 1u << r;
+                    break;
+                } else if (connection < subscriber) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+        }
+    }
+}
+
+size_t SensorService::collectEventsLocked(uint32_t mask, uint32_t const** outIndices) {
+    size_t next[MAX_SPLIT_SENSORS];
+    size_t end[MAX_SPLIT_SENSORS];
+    size_t numRanges = 0;
+    for (size_t r = 0; r < mEventRanges.size(); r++) {
+        if (mask & (1u << r)) {
+            next[numRanges] = mEventRanges[r].start;
+            end[numRanges] = mEventRanges[r].start + mEventRanges[r].count;
+            numRanges++;
+        }
+    }
+    if (numRanges == 1) {
+        // The common case: the events of a single sensor are already in order.
+        *outIndices = mEventIndicesBySensor + next[0];
+        return end[0] - next[0];
+    }
+
+    // Merge the indices of the sensors back into batch order.
+    size_t count = 0;
+    while (numRanges > 0) {
+        size_t first = 0;
+        for (size_t r = 1; r < numRanges; r++) {
+            if (mEventIndicesBySensor[next[r]] < mEventIndicesBySensor[next[first]]) {
+                first = r;
+            }
+        }
+        mConnectionEventIndices[count++] = mEventIndicesBySensor[next[first]++];
+        if (next[first] == end[first]) {
+            numRanges--;
+            next[first] = next[numRanges];
+            end[first] = end[numRanges];
+        }
+    }
+    *outIndices = mConnectionEventIndices;
+    return count;
+}
+
 void SensorService::recordLastValueLocked(
         const sensors_event_t* buffer, size_t count) {
     const sensors_event_t* last = NULL;
@@ -562,16 +711,10 @@ void SensorService::recordLastValueLocked(
     }
 }
 
-void SensorService::sortEventBuffer(sensors_event_t* buffer, size_t count)
+void SensorService::sortEventBuffer(sensors_event_t* buffer,
+        sensors_event_t* scratch, size_t count)
 {
-    struct compar {
-        static int cmp(void const* lhs, void const* rhs) {
-            sensors_event_t const* l = static_cast<sensors_event_t const*>(lhs);
-            sensors_event_t const* r = static_cast<sensors_event_t const*>(rhs);
-            return l->timestamp - r->timestamp;
-        }
-    };
-    qsort(buffer, count, sizeof(sensors_event_t), compar::cmp);
+    sortEventsByTimestamp(buffer, scratch, count);
 }
 
 String8 SensorService::getSensorName(int handle) const {
@@ -714,8 +857,7 @@ status_t SensorService::enable(const sp<SensorEventConnection>& connection,
                 sensors_event_t& event(mLastEventSeen.editValueFor(handle));
                 if (event.version == sizeof(sensors_event_t)) {
                     if (isWakeUpSensorEvent(event) && !mWakeLockAcquired) {
-                        acquire_wake_lock(PARTIAL_WAKE_LOCK, WAKE_LOCK_NAME);
-                        mWakeLockAcquired = true;
+                        acquireWakeLockLocked();
                         ALOGD_IF(DEBUG_CONNECTIONS, "acquired wakelock for on_change sensor %s",
                                                         WAKE_LOCK_NAME);
                     }
@@ -773,6 +915,7 @@ status_t SensorService::enable(const sp<SensorEventConnection>& connection,
     }
 
     if (err == NO_ERROR) {
+        connection->setBatchParams(handle, samplingPeriodNs, maxBatchReportLatencyNs);
         connection->updateLooperRegistration(mLooper);
     }
 
@@ -811,6 +954,7 @@ status_t SensorService::cleanupWithoutDisableLocked(
         // see if this connection becomes inactive
         if (connection->removeSensor(handle)) {
             BatteryService::disableSensor(connection->getUid(), handle);
+            connection->updateSocketBufferSize();
         }
         if (connection->hasAnySensor() == false) {
             connection->updateLooperRegistration(mLooper);
@@ -849,7 +993,11 @@ status_t SensorService::setEventRate(const sp<SensorEventConnection>& connection
         ns = minDelayNs;
     }
 
-    return sensor->setDelay(connection.get(), handle, ns);
+    status_t err = sensor->setDelay(connection.get(), handle, ns);
+    if (err == NO_ERROR) {
+        connection->setSamplingPeriod(handle, ns);
+    }
+    return err;
 }
 
 status_t SensorService::flushSensor(const sp<SensorEventConnection>& connection) {
@@ -922,8 +1070,65 @@ void SensorService::checkWakeLockStateLocked() {
         }
     }
     if (releaseLock) {
-        release_wake_lock(WAKE_LOCK_NAME);
-        mWakeLockAcquired = false;
+        releaseWakeLockLocked();
+    }
+}
+
+int SensorService::checkWakeLockTimeouts() {
+    // Promote the connections without holding mLock, see threadLoop.
+    SortedVector< sp<SensorEventConnection> > activeConnections;
+    {
+        Mutex::Autolock _l(mLock);
+        if (!mWakeLockAcquired) {
+            return -1;
+        }
+        for (size_t i=0 ; i < mActiveConnections.size(); ++i) {
+            sp<SensorEventConnection> connection(mActiveConnections[i].promote());
+            if (connection != 0) {
+                activeConnections.add(connection);
+            }
+        }
+    }
+
+    Mutex::Autolock _l(mLock);
+    const nsecs_t now = systemTime(SYSTEM_TIME_BOOTTIME);
+    nsecs_t nextDeadline = now + WAKE_LOCK_ACK_TIMEOUT_NS;
+    bool timedOut = false;
+    for (size_t i=0 ; i < activeConnections.size(); ++i) {
+        nsecs_t deadline = nextDeadline;
+        timedOut |= activeConnections[i]->checkAckTimeout(now, WAKE_LOCK_ACK_TIMEOUT_NS,
+                &deadline);
+        if (deadline < nextDeadline) {
+            nextDeadline = deadline;
+        }
+    }
+    if (timedOut) {
+        checkWakeLockStateLocked();
+    }
+    if (!mWakeLockAcquired) {
+        return -1;
+    }
+    return int(ns2ms(nextDeadline - now)) + 1;
+}
+
+void SensorService::acquireWakeLockLocked() {
+    acquire_wake_lock(PARTIAL_WAKE_LOCK, WAKE_LOCK_NAME);
+    mWakeLockAcquired = true;
+    mWakeLockAcquireCount++;
+    mWakeLockAcquireTime = systemTime(SYSTEM_TIME_BOOTTIME);
+    // Have SensorEventAckReceiver start watching for ack timeouts
+    if (mLooper != NULL) {
+        mLooper->wake();
+    }
+}
+
+void SensorService::releaseWakeLockLocked() {
+    release_wake_lock(WAKE_LOCK_NAME);
+    mWakeLockAcquired = false;
+    const nsecs_t held = systemTime(SYSTEM_TIME_BOOTTIME) - mWakeLockAcquireTime;
+    mWakeLockHeldTotal += held;
+    if (held > mWakeLockHeldMax) {
+        mWakeLockHeldMax = held;
     }
 }
 
@@ -987,9 +1192,17 @@ SensorService::SensorRecord::getFirstPendingFlushConnection() {
 
 SensorService::SensorEventConnection::SensorEventConnection(
         const sp<SensorService>& service, uid_t uid)
-    : mService(service), mUid(uid), mWakeLockRefCount(0), mHasLooperCallbacks(false),
-      mDead(false), mEventCache(NULL), mCacheSize(0), mMaxCacheSize(0) {
-    mChannel = new BitTube(mService->mSocketBufferSize);
+    : mService(service),
+      mSocketBufferSize(helpers::min(size_t(SOCKET_BUFFER_SIZE_NON_BATCHED),
+                                     size_t(service->mSocketBufferSize))),
+      mUid(uid), mWakeLockRefCount(0), mWakeLockPendingSince(0), mWakeLockSensor(-1),
+      mLastAckTime(0), mWakeLockHeldTotal(0), mWakeLockHeldMax(0), mWakeLockTimeouts(0),
+      mLateAcks(0),
+      mHasLooperCallbacks(false),
+      mDead(false), mEventCache(NULL), mCacheSize(0), mMaxCacheSize(0),
+      mCacheSizeHighWater(0) {
+    // Start small, the buffer grows once batched sensors are enabled.
+    mChannel = new BitTube(mSocketBufferSize);
 #if DEBUG_CONNECTIONS
     mEventsReceived = mEventsSentFromCache = mEventsSent = 0;
     mTotalAcksNeeded = mTotalAcksReceived = 0;
@@ -1013,10 +1226,68 @@ bool SensorService::SensorEventConnection::needsWakeLock() {
     return !mDead && mWakeLockRefCount > 0;
 }
 
+void SensorService::SensorEventConnection::addPendingAckLocked(int32_t handle) {
+    if (mWakeLockRefCount++ == 0) {
+        mWakeLockPendingSince = systemTime(SYSTEM_TIME_BOOTTIME);
+        mWakeLockSensor = handle;
+        mLastAckTime = mWakeLockPendingSince;
+    }
+}
+
+void SensorService::SensorEventConnection::removePendingAcksLocked(uint32_t count) {
+    if (mWakeLockRefCount == 0) {
+        return;
+    }
+    if (count < mWakeLockRefCount) {
+        mWakeLockRefCount -= count;
+        mLastAckTime = systemTime(SYSTEM_TIME_BOOTTIME);
+        return;
+    }
+    mWakeLockRefCount = 0;
+    const nsecs_t held = systemTime(SYSTEM_TIME_BOOTTIME) - mWakeLockPendingSince;
+    mWakeLockHeldTotal += held;
+    if (held > mWakeLockHeldMax) {
+        mWakeLockHeldMax = held;
+    }
+    ssize_t index = mSensorInfo.indexOfKey(mWakeLockSensor);
+    if (index >= 0) {
+        mSensorInfo.editValueAt(index).mWakeLockHeld += held;
+    }
+}
+
+bool SensorService::SensorEventConnection::checkAckTimeout(nsecs_t now, nsecs_t timeout,
+        nsecs_t* outDeadline) {
+    Mutex::Autolock _l(mConnectionLock);
+    if (mDead || mWakeLockRefCount == 0) {
+        return false;
+    }
+    const nsecs_t deadline = mLastAckTime + timeout;
+    if (now < deadline) {
+        *outDeadline = deadline;
+        return false;
+    }
+    ALOGW("uid %d didn't ack %u wake up events in %.3fs, releasing its wake lock", mUid,
+            mWakeLockRefCount, (now - mLastAckTime) / 1e9);
+    mLateAcks += mWakeLockRefCount;
+    removePendingAcksLocked(mWakeLockRefCount);
+    mWakeLockTimeouts++;
+    return true;
+}
+
 void SensorService::SensorEventConnection::dump(String8& result) {
     Mutex::Autolock _l(mConnectionLock);
-    result.appendFormat("\t WakeLockRefCount %d | uid %d | cache size %d | max cache size %d\n",
-            mWakeLockRefCount, mUid, mCacheSize, mMaxCacheSize);
+    result.appendFormat("\t WakeLockRefCount %d | uid %d | cache size %d | max cache size %d"
+            " | cache high water %d | socket buffer %zu events | event ring %zu\n",
+            mWakeLockRefCount, mUid, mCacheSize, mMaxCacheSize, mCacheSizeHighWater,
+            mSocketBufferSize / sizeof(sensors_event_t),
+            mRing != NULL ? mRing->getCapacity() : 0);
+    nsecs_t wakeLockHeld = mWakeLockHeldTotal;
+    if (mWakeLockRefCount > 0) {
+        wakeLockHeld += systemTime(SYSTEM_TIME_BOOTTIME) - mWakeLockPendingSince;
+    }
+    result.appendFormat("\t wake lock held %.3fs in total | longest %.3fs | ack timeouts %u\n",
+            wakeLockHeld / 1e9, mWakeLockHeldMax / 1e9, mWakeLockTimeouts);
+    mStats.dump(result, "\t ");
     for (size_t i = 0; i < mSensorInfo.size(); ++i) {
         const FlushInfo& flushInfo = mSensorInfo.valueAt(i);
         result.appendFormat("\t %s 0x%08x | status: %s | pending flush events %d \n",
@@ -1025,6 +1296,10 @@ void SensorService::SensorEventConnection::dump(String8& result) {
                             flushInfo.mFirstFlushPending ? "First flush pending" :
                                                            "active",
                             flushInfo.mPendingFlushEventsToSend);
+        flushInfo.mStats.dump(result, "\t\t ");
+        if (flushInfo.mWakeLockHeld > 0) {
+            result.appendFormat("\t\t wake lock held %.3fs\n", flushInfo.mWakeLockHeld / 1e9);
+        }
     }
 #if DEBUG_CONNECTIONS
     result.appendFormat("\t events recvd: %d | sent %d | cache %d | dropped %d |"
@@ -1058,6 +1333,33 @@ bool SensorService::SensorEventConnection::removeSensor(int32_t handle) {
     return false;
 }
 
+void SensorService::SensorEventConnection::setBatchParams(int32_t handle,
+        nsecs_t samplingPeriodNs, nsecs_t maxBatchReportLatencyNs) {
+    Mutex::Autolock _l(mConnectionLock);
+    ssize_t index = mSensorInfo.indexOfKey(handle);
+    if (index >= 0) {
+        FlushInfo& flushInfo = mSensorInfo.editValueAt(index);
+        flushInfo.mSamplingPeriodNs = samplingPeriodNs;
+        flushInfo.mMaxBatchReportLatencyNs = maxBatchReportLatencyNs;
+        updateSocketBufferSizeLocked();
+    }
+}
+
+void SensorService::SensorEventConnection::setSamplingPeriod(int32_t handle,
+        nsecs_t samplingPeriodNs) {
+    Mutex::Autolock _l(mConnectionLock);
+    ssize_t index = mSensorInfo.indexOfKey(handle);
+    if (index >= 0) {
+        mSensorInfo.editValueAt(index).mSamplingPeriodNs = samplingPeriodNs;
+        updateSocketBufferSizeLocked();
+    }
+}
+
+void SensorService::SensorEventConnection::updateSocketBufferSize() {
+    Mutex::Autolock _l(mConnectionLock);
+    updateSocketBufferSizeLocked();
+}
+
 bool SensorService::SensorEventConnection::hasSensor(int32_t handle) const {
     Mutex::Autolock _l(mConnectionLock);
     return mSensorInfo.indexOfKey(handle) >= 0;
@@ -1109,7 +1411,10 @@ void SensorService::SensorEventConnection::updateLooperRegistrationLocked(
     }
 
     int looper_flags = 0;
-    if (mCacheSize > 0) looper_flags |= ALOOPER_EVENT_OUTPUT;
+    if (mCacheSize > 0) {
+        // With an event ring the socket is always writable, the client says when there is room.
+        looper_flags |= mRing != NULL ? ALOOPER_EVENT_INPUT : ALOOPER_EVENT_OUTPUT;
+    }
     for (size_t i = 0; i < mSensorInfo.size(); ++i) {
         const int handle = mSensorInfo.keyAt(i);
         if (mService->getSensorFromHandle(handle).isWakeUpSensor()) {
@@ -1151,13 +1456,15 @@ void SensorService::SensorEventConnection::incrementPendingFlushCount(int32_t ha
 status_t SensorService::SensorEventConnection::sendEvents(
         sensors_event_t const* buffer, size_t numEvents,
         sensors_event_t* scratch,
-        SensorEventConnection const * const * mapFlushEventsToConnections) {
+        SensorEventConnection const * const * mapFlushEventsToConnections,
+        uint32_t const* eventIndices) {
     // filter out events not for this connection
     size_t count = 0;
     Mutex::Autolock _l(mConnectionLock);
     if (scratch) {
-        size_t i=0;
-        while (i<numEvents) {
+        size_t n=0;
+        while (n<numEvents) {
+            size_t i = eventIndices ? eventIndices[n] : n;
             int32_t sensor_handle = buffer[i].sensor;
             if (buffer[i].type == SENSOR_TYPE_META_DATA) {
                 ALOGD_IF(DEBUG_CONNECTIONS, "flush complete event sensor==%d ",
@@ -1171,7 +1478,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
             // Check if this connection has registered for this sensor. If not continue to the
             // next sensor_event.
             if (index < 0) {
-                ++i;
+                ++n;
                 continue;
             }
 
@@ -1182,14 +1489,14 @@ status_t SensorService::SensorEventConnection::sendEvents(
                 flushInfo.mFirstFlushPending = false;
                 ALOGD_IF(DEBUG_CONNECTIONS, "First flush event for sensor==%d ",
                         buffer[i].meta_data.sensor);
-                ++i;
+                ++n;
                 continue;
             }
 
             // If there is a pending flush complete event for this sensor on this connection,
             // ignore the event and proceed to the next.
             if (flushInfo.mFirstFlushPending) {
-                ++i;
+                ++n;
                 continue;
             }
 
@@ -1202,12 +1509,14 @@ status_t SensorService::SensorEventConnection::sendEvents(
                     if (this == mapFlushEventsToConnections[i]) {
                         scratch[count++] = buffer[i];
                     }
-                    ++i;
                 } else {
                     // Regular sensor event, just copy it to the scratch buffer.
-                    scratch[count++] = buffer[i++];
+                    scratch[count++] = buffer[i];
                 }
-            } while ((i<numEvents) && ((buffer[i].sensor == sensor_handle &&
+                if (++n < numEvents) {
+                    i = eventIndices ? eventIndices[n] : n;
+                }
+            } while ((n<numEvents) && ((buffer[i].sensor == sensor_handle &&
                                         buffer[i].type != SENSOR_TYPE_META_DATA) ||
                                        (buffer[i].type == SENSOR_TYPE_META_DATA  &&
                                         buffer[i].meta_data.sensor == sensor_handle)));
@@ -1237,6 +1546,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
             // the max cache size that is desired.
             if (mCacheSize + count < computeMaxCacheSizeLocked()) {
                 reAllocateCacheLocked(scratch, count);
+                updateStatsLocked(scratch, count, EVENTS_CACHED);
                 return status_t(NO_ERROR);
             }
             // Some events need to be dropped.
@@ -1247,6 +1557,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
             }
             int numEventsDropped = count - remaningCacheSize;
             countFlushCompleteEventsLocked(mEventCache, numEventsDropped);
+            updateStatsLocked(mEventCache, numEventsDropped, EVENTS_DROPPED);
             // Drop the first "numEventsDropped" in the cache.
             memmove(mEventCache, &mEventCache[numEventsDropped],
                     (mCacheSize - numEventsDropped) * sizeof(sensors_event_t));
@@ -1255,29 +1566,27 @@ status_t SensorService::SensorEventConnection::sendEvents(
             memcpy(&mEventCache[mCacheSize - numEventsDropped], scratch + remaningCacheSize,
                                             numEventsDropped * sizeof(sensors_event_t));
         }
+        updateStatsLocked(scratch, count, EVENTS_CACHED);
         return status_t(NO_ERROR);
     }
 
     int index_wake_up_event = findWakeUpSensorEventLocked(scratch, count);
     if (index_wake_up_event >= 0) {
         scratch[index_wake_up_event].flags |= WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
-        ++mWakeLockRefCount;
+        addPendingAckLocked(getSensorHandle(scratch[index_wake_up_event]));
 #if DEBUG_CONNECTIONS
         ++mTotalAcksNeeded;
 #endif
     }
 
     // NOTE: ASensorEvent and sensors_event_t are the same type.
-    ssize_t size = SensorEventQueue::write(mChannel,
-                                    reinterpret_cast<ASensorEvent const*>(scratch), count);
+    ssize_t size = writeEventsLocked(reinterpret_cast<ASensorEvent const*>(scratch), count);
     if (size < 0) {
         // Write error, copy events to local cache.
         if (index_wake_up_event >= 0) {
             // If there was a wake_up sensor_event, reset the flag.
             scratch[index_wake_up_event].flags &= ~WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
-            if (mWakeLockRefCount > 0) {
-                --mWakeLockRefCount;
-            }
+            removePendingAcksLocked(1);
 #if DEBUG_CONNECTIONS
             --mTotalAcksNeeded;
 #endif
@@ -1289,6 +1598,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
         }
         memcpy(&mEventCache[mCacheSize], scratch, count * sizeof(sensors_event_t));
         mCacheSize += count;
+        updateStatsLocked(scratch, count, EVENTS_CACHED);
 
         // Add this file descriptor to the looper to get a callback when this fd is available for
         // writing.
@@ -1296,6 +1606,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
         return size;
     }
 
+    updateStatsLocked(scratch, count, EVENTS_DELIVERED);
 #if DEBUG_CONNECTIONS
     if (size > 0) {
         mEventsSent += count;
@@ -1323,6 +1634,49 @@ void SensorService::SensorEventConnection::reAllocateCacheLocked(sensors_event_t
     mMaxCacheSize = new_cache_size;
 }
 
+void SensorService::SensorEventConnection::updateStatsLocked(sensors_event_t const* events,
+        size_t count, DeliveryOutcome outcome) {
+    if (outcome == EVENTS_CACHED && mCacheSize > mCacheSizeHighWater) {
+        mCacheSizeHighWater = mCacheSize;
+    }
+    // Timestamps are on the elapsed realtime clock.
+    const nsecs_t now = outcome == EVENTS_DELIVERED ? systemTime(SYSTEM_TIME_BOOTTIME) : 0;
+    // Events come in runs from the same sensor, only look the sensor up when it changes.
+    int32_t handle = -1;
+    SensorDeliveryStats* sensorStats = NULL;
+    for (size_t i = 0; i < count; ++i) {
+        const sensors_event_t& event(events[i]);
+        if (handle == -1 || getSensorHandle(event) != handle) {
+            handle = getSensorHandle(event);
+            ssize_t index = mSensorInfo.indexOfKey(handle);
+            sensorStats = index >= 0 ? &mSensorInfo.editValueAt(index).mStats : NULL;
+        }
+        switch (outcome) {
+            case EVENTS_DELIVERED:
+                // flush complete events don't have a timestamp
+                if (event.type != SENSOR_TYPE_META_DATA) {
+                    mStats.onDelivered(now - event.timestamp);
+                    if (sensorStats != NULL) {
+                        sensorStats->onDelivered(now - event.timestamp);
+                    }
+                }
+                break;
+            case EVENTS_CACHED:
+                mStats.onCached(1);
+                if (sensorStats != NULL) {
+                    sensorStats->onCached(1);
+                }
+                break;
+            case EVENTS_DROPPED:
+                mStats.onDropped(1);
+                if (sensorStats != NULL) {
+                    sensorStats->onDropped(1);
+                }
+                break;
+        }
+    }
+}
+
 void SensorService::SensorEventConnection::sendPendingFlushEventsLocked() {
     ASensorEvent flushCompleteEvent;
     memset(&flushCompleteEvent, 0, sizeof(flushCompleteEvent));
@@ -1337,7 +1691,7 @@ void SensorService::SensorEventConnection::sendPendingFlushEventsLocked() {
             if (mService->getSensorFromHandle(sensor_handle).isWakeUpSensor()) {
                flushCompleteEvent.flags |= WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
             }
-            ssize_t size = SensorEventQueue::write(mChannel, &flushCompleteEvent, 1);
+            ssize_t size = writeEventsLocked(&flushCompleteEvent, 1);
             if (size < 0) {
                 return;
             }
@@ -1352,7 +1706,7 @@ void SensorService::SensorEventConnection::writeToSocketFromCacheLocked() {
     // At a time write at most half the size of the receiver buffer in SensorEventQueue OR
     // half the size of the socket buffer allocated in BitTube whichever is smaller.
     const int maxWriteSize = helpers::min(SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT/2,
-            int(mService->mSocketBufferSize/(sizeof(sensors_event_t)*2)));
+            int(mSocketBufferSize/(sizeof(sensors_event_t)*2)));
     // Send pending flush complete events (if any)
     sendPendingFlushEventsLocked();
     for (int numEventsSent = 0; numEventsSent < mCacheSize;) {
@@ -1362,13 +1716,13 @@ void SensorService::SensorEventConnection::writeToSocketFromCacheLocked() {
         if (index_wake_up_event >= 0) {
             mEventCache[index_wake_up_event + numEventsSent].flags |=
                     WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
-            ++mWakeLockRefCount;
+            addPendingAckLocked(getSensorHandle(mEventCache[index_wake_up_event + numEventsSent]));
 #if DEBUG_CONNECTIONS
             ++mTotalAcksNeeded;
 #endif
         }
 
-        ssize_t size = SensorEventQueue::write(mChannel,
+        ssize_t size = writeEventsLocked(
                           reinterpret_cast<ASensorEvent const*>(mEventCache + numEventsSent),
                           numEventsToWrite);
         if (size < 0) {
@@ -1376,9 +1730,7 @@ void SensorService::SensorEventConnection::writeToSocketFromCacheLocked() {
                 // If there was a wake_up sensor_event, reset the flag.
                 mEventCache[index_wake_up_event + numEventsSent].flags  &=
                         ~WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
-                if (mWakeLockRefCount > 0) {
-                    --mWakeLockRefCount;
-                }
+                removePendingAcksLocked(1);
 #if DEBUG_CONNECTIONS
                 --mTotalAcksNeeded;
 #endif
@@ -1390,6 +1742,7 @@ void SensorService::SensorEventConnection::writeToSocketFromCacheLocked() {
             mCacheSize -= numEventsSent;
             return;
         }
+        updateStatsLocked(mEventCache + numEventsSent, numEventsToWrite, EVENTS_DELIVERED);
         numEventsSent += numEventsToWrite;
 #if DEBUG_CONNECTIONS
         mEventsSentFromCache += numEventsToWrite;
@@ -1403,6 +1756,24 @@ void SensorService::SensorEventConnection::writeToSocketFromCacheLocked() {
     updateLooperRegistrationLocked(mService->getLooper());
 }
 
+ssize_t SensorService::SensorEventConnection::writeEventsLocked(ASensorEvent const* events,
+                                                               size_t numEvents) {
+    if (mRing == NULL) {
+        return SensorEventQueue::write(mChannel, events, numEvents);
+    }
+    bool wakeReader = false;
+    ssize_t size = mRing->write(events, numEvents, &wakeReader);
+    if (size >= 0 && wakeReader) {
+        // The content doesn't matter, the client throws it away.
+        const uint8_t wakeup = 0;
+        if (::send(mChannel->getSendFd(), &wakeup, sizeof(wakeup),
+                   MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+            ALOGE("can't wake up client: %s", strerror(errno));
+        }
+    }
+    return size;
+}
+
 void SensorService::SensorEventConnection::countFlushCompleteEventsLocked(
                 sensors_event_t const* scratch, const int numEventsDropped) {
     ALOGD_IF(DEBUG_CONNECTIONS, "dropping %d events ", numEventsDropped);
@@ -1459,6 +1830,26 @@ status_t  SensorService::SensorEventConnection::flush() {
     return  mService->flushSensor(this);
 }
 
+status_t SensorService::SensorEventConnection::getEventRing(int* outFd) {
+    Mutex::Autolock _l(mConnectionLock);
+    if (mRing == NULL) {
+        // Events may already have been written to the socket once a sensor is enabled.
+        if (mSensorInfo.size() > 0) {
+            return INVALID_OPERATION;
+        }
+        mRing = SensorEventRing::create(mService->mSocketBufferSize / sizeof(sensors_event_t));
+        if (mRing == NULL) {
+            return NO_MEMORY;
+        }
+    }
+    int fd = dup(mRing->getFd());
+    if (fd < 0) {
+        return -errno;
+    }
+    *outFd = fd;
+    return NO_ERROR;
+}
+
 int SensorService::SensorEventConnection::handleEvent(int fd, int events, void* /*data*/) {
     if (events & ALOOPER_EVENT_HANGUP || events & ALOOPER_EVENT_ERROR) {
         {
@@ -1468,7 +1859,7 @@ int SensorService::SensorEventConnection::handleEvent(int fd, int events, void*
             ALOGD_IF(DEBUG_CONNECTIONS, "%p Looper error %d", this, fd);
             Mutex::Autolock _l(mConnectionLock);
             mDead = true;
-            mWakeLockRefCount = 0;
+            removePendingAcksLocked(mWakeLockRefCount);
             updateLooperRegistrationLocked(mService->getLooper());
         }
         mService->checkWakeLockState();
@@ -1480,14 +1871,28 @@ int SensorService::SensorEventConnection::handleEvent(int fd, int events, void*
         ssize_t ret = ::recv(fd, &numAcks, sizeof(numAcks), MSG_DONTWAIT);
         {
            Mutex::Autolock _l(mConnectionLock);
+           if (mRing != NULL && ret == sizeof(numAcks) && numAcks == 0) {
+               // The client made room in the event ring, send what is in the cache.
+               writeToSocketFromCacheLocked();
+               return 1;
+           }
+           // Acks of events that timed out don't count for the ones sent since.
+           if (ret == sizeof(numAcks) && mLateAcks > 0 && numAcks > 0) {
+               const uint32_t lateAcks = helpers::min(mLateAcks, numAcks);
+               mLateAcks -= lateAcks;
+               numAcks -= lateAcks;
+               if (numAcks == 0) {
+                   return 1;
+               }
+           }
            // Sanity check to ensure  there are no read errors in recv, numAcks is always
            // within the range and not zero. If any of the above don't hold reset mWakeLockRefCount
            // to zero.
            if (ret != sizeof(numAcks) || numAcks > mWakeLockRefCount || numAcks == 0) {
                ALOGE("Looper read error ret=%d numAcks=%d", ret, numAcks);
-               mWakeLockRefCount = 0;
+               removePendingAcksLocked(mWakeLockRefCount);
            } else {
-               mWakeLockRefCount -= numAcks;
+               removePendingAcksLocked(numAcks);
            }
 #if DEBUG_CONNECTIONS
            mTotalAcksReceived += numAcks;
@@ -1514,6 +1919,10 @@ int SensorService::SensorEventConnection::computeMaxCacheSizeLocked() const {
     int fifoWakeUpSensors = 0;
     int fifoNonWakeUpSensors = 0;
     for (size_t i = 0; i < mSensorInfo.size(); ++i) {
+        // Continuous mode clients don't need room for the FIFO.
+        if (mSensorInfo.valueAt(i).mMaxBatchReportLatencyNs == 0) {
+            continue;
+        }
         const Sensor& sensor = mService->getSensorFromHandle(mSensorInfo.keyAt(i));
         if (sensor.getFifoReservedEventCount() == sensor.getFifoMaxEventCount()) {
             // Each sensor has a reserved fifo. Sum up the fifo sizes for all wake up sensors and
@@ -1538,13 +1947,61 @@ int SensorService::SensorEventConnection::computeMaxCacheSizeLocked() const {
    }
    if (fifoWakeUpSensors + fifoNonWakeUpSensors == 0) {
        // It is extremely unlikely that there is a write failure in non batch mode. Return a cache
-       // size that is equal to that of the batch mode.
+       // size that is equal to that of the largest socket buffer.
        // ALOGW("Write failure in non-batch mode");
-       return MAX_SOCKET_BUFFER_SIZE_BATCHED/sizeof(sensors_event_t);
+       return mService->mSocketBufferSize/sizeof(sensors_event_t);
    }
    return fifoWakeUpSensors + fifoNonWakeUpSensors;
 }
 
+size_t SensorService::SensorEventConnection::computeSocketBufferSizeLocked() const {
+    SensorDevice& device(SensorDevice::getInstance());
+    size_t numEvents = 0;
+    for (size_t i = 0; i < mSensorInfo.size(); ++i) {
+        const int handle = mSensorInfo.keyAt(i);
+        const FlushInfo& flushInfo = mSensorInfo.valueAt(i);
+        nsecs_t samplingPeriodNs = flushInfo.mSamplingPeriodNs;
+        nsecs_t maxBatchReportLatencyNs = flushInfo.mMaxBatchReportLatencyNs;
+        if (!mService->isVirtualSensor(handle)) {
+            // Events come at the rate and in the batches the HAL sensor runs at, which may be
+            // faster and bigger than what this connection asked for because of other clients.
+            nsecs_t halSamplingPeriodNs, halMaxBatchReportLatencyNs;
+            if (device.getBatchParams(handle, &halSamplingPeriodNs,
+                                      &halMaxBatchReportLatencyNs) == NO_ERROR) {
+                samplingPeriodNs = halSamplingPeriodNs;
+                maxBatchReportLatencyNs = halMaxBatchReportLatencyNs;
+            }
+        }
+        const Sensor& sensor = mService->getSensorFromHandle(handle);
+        size_t sensorEvents = 1;
+        if (maxBatchReportLatencyNs > 0 && sensor.getFifoMaxEventCount() > 0) {
+            sensorEvents += samplingPeriodNs > 0 ?
+                    size_t(maxBatchReportLatencyNs / samplingPeriodNs) :
+                    sensor.getFifoMaxEventCount();
+            sensorEvents = helpers::min(sensorEvents, size_t(sensor.getFifoMaxEventCount()));
+        }
+        numEvents += sensorEvents;
+    }
+    size_t size = helpers::max(numEvents * sizeof(sensors_event_t),
+                               size_t(SOCKET_BUFFER_SIZE_NON_BATCHED));
+    return helpers::min(size, size_t(mService->mSocketBufferSize));
+}
+
+void SensorService::SensorEventConnection::updateSocketBufferSizeLocked() {
+    const size_t size = computeSocketBufferSizeLocked();
+    if (size == mSocketBufferSize) {
+        return;
+    }
+    status_t err = mChannel->setSendBufferSize(size);
+    if (err != NO_ERROR) {
+        ALOGE("error resizing socket buffer to %zu bytes (%s)", size, strerror(-err));
+        return;
+    }
+    ALOGD_IF(DEBUG_CONNECTIONS, "%p socket buffer %zu -> %zu bytes", this, mSocketBufferSize,
+             size);
+    mSocketBufferSize = size;
+}
+
 // ---------------------------------------------------------------------------
 }; // namespace android
 
@@ -35,6 +35,9 @@
 #include <gui/ISensorServer.h>
 #include <gui/ISensorEventConnection.h>
 
+#include <private/gui/SensorEventRing.h>
+
+#include "SensorDeliveryStats.h"
 #include "SensorInterface.h"
 
 // ---------------------------------------------------------------------------
@@ -44,6 +47,9 @@
 #define MAX_SOCKET_BUFFER_SIZE_BATCHED 100 * 1024
 // For older HALs which don't support batching, use a smaller socket buffer size.
 #define SOCKET_BUFFER_SIZE_NON_BATCHED 4 * 1024
+// How long a client may take to ack the events of wake up sensors before it stops holding the
+// wake lock.
+#define WAKE_LOCK_ACK_TIMEOUT_NS (5 * 1000000000LL)
 
 struct sensors_poll_device_t;
 struct sensors_module_t;
@@ -83,6 +89,7 @@ class SensorService :
                                        nsecs_t maxBatchReportLatencyNs, int reservedFlags);
         virtual status_t setEventRate(int handle, nsecs_t samplingPeriodNs);
         virtual status_t flush();
+        virtual status_t getEventRing(int* outFd);
         // Count the number of flush complete events which are about to be dropped in the buffer.
         // Increment mPendingFlushEventsToSend in mSensorInfo. These flush complete events will be
         // sent separately before the next batch of events.
@@ -103,20 +110,47 @@ class SensorService :
         // Writes events from mEventCache to the socket.
         void writeToSocketFromCacheLocked();
 
+        // Writes events to mRing if the client asked for one, to the socket otherwise. Either all
+        // the events are written or none, in which case an error is returned.
+        ssize_t writeEventsLocked(ASensorEvent const* events, size_t numEvents);
+
         // Compute the approximate cache size from the FIFO sizes of various sensors registered for
         // this connection. Wake up and non-wake up sensors have separate FIFOs but FIFO may be
         // shared amongst wake-up sensors and non-wake up sensors.
         int computeMaxCacheSizeLocked() const;
 
+        // Compute the socket buffer size needed to hold one batch of every sensor of this
+        // connection, from the rate and report latency the sensor runs at. Bounded by
+        // SOCKET_BUFFER_SIZE_NON_BATCHED and the size SensorService picked at startup.
+        size_t computeSocketBufferSizeLocked() const;
+        void updateSocketBufferSizeLocked();
+
         // When more sensors register, the maximum cache size desired may change. Compute max cache
         // size, reallocate memory and copy over events from the older cache.
         void reAllocateCacheLocked(sensors_event_t const* scratch, int count);
 
+        // Counts events as delivered, cached or dropped in the stats of their sensor and of the
+        // connection. Events of sensors this connection isn't registered for are skipped.
+        enum DeliveryOutcome { EVENTS_DELIVERED, EVENTS_CACHED, EVENTS_DROPPED };
+        void updateStatsLocked(sensors_event_t const* events, size_t count,
+                DeliveryOutcome outcome);
+
         // LooperCallback method. If there is data to read on this fd, it is an ack from the
         // app that it has read events from a wake up sensor, decrement mWakeLockRefCount.
         // If this fd is available for writing send the data from the cache.
         virtual int handleEvent(int fd, int events, void* data);
 
+        // Count one more ack owed for a wake up event of the given sensor, or count acks as
+        // received (all of them if count is larger than mWakeLockRefCount). The time during which
+        // acks are owed is the time this connection keeps the wake lock held, and is charged to
+        // the sensor whose event started it.
+        void addPendingAckLocked(int32_t handle);
+        void removePendingAcksLocked(uint32_t count);
+
+        // If acks are owed but none came since before now - timeout, forget them and return true.
+        // Otherwise set *outDeadline to when they will time out, if any are owed.
+        bool checkAckTimeout(nsecs_t now, nsecs_t timeout, nsecs_t* outDeadline);
+
         // Increment mPendingFlushEventsToSend for the given sensor handle.
         void incrementPendingFlushCount(int32_t handle);
 
@@ -133,12 +167,30 @@ class SensorService :
 
         sp<SensorService> const mService;
         sp<BitTube> mChannel;
+        // Current size of the send buffer of mChannel.
+        size_t mSocketBufferSize;
+        // Once set, events are written here and a message is sent on mChannel only to wake the
+        // client up. When the ring is full, the client sends an ack of zero events once it made
+        // room, and the fd is polled for input instead of output while there are cached events.
+        sp<SensorEventRing> mRing;
         uid_t mUid;
         mutable Mutex mConnectionLock;
         // Number of events from wake up sensors which are still pending and haven't been delivered
         // to the corresponding application. It is incremented by one unit for each write to the
         // socket.
         uint32_t mWakeLockRefCount;
+        // When mWakeLockRefCount last went up from zero, and the sensor whose event did it.
+        nsecs_t mWakeLockPendingSince;
+        int32_t mWakeLockSensor;
+        // When acks were last received while more were owed; the client times out if it stops
+        // acking, not if acks merely lag behind the events.
+        nsecs_t mLastAckTime;
+        // How long acks were owed, on the elapsed realtime clock, and how often the client didn't
+        // ack in time.
+        nsecs_t mWakeLockHeldTotal, mWakeLockHeldMax;
+        uint32_t mWakeLockTimeouts;
+        // Acks that timed out and may still come; they are ignored when they do.
+        uint32_t mLateAcks;
 
         // If this flag is set to true, it means that the file descriptor associated with the
         // BitTube has been added to the Looper in SensorService. This flag is typically set when
@@ -156,12 +208,25 @@ class SensorService :
             // Every activate is preceded by a flush. Only after the first flush complete is
             // received, the events for the sensor are sent on that *connection*.
             bool mFirstFlushPending;
-            FlushInfo() : mPendingFlushEventsToSend(0), mFirstFlushPending(false) {}
+            // What happened to the events of this sensor on this connection.
+            SensorDeliveryStats mStats;
+            // The rate and report latency this connection asked for.
+            nsecs_t mSamplingPeriodNs, mMaxBatchReportLatencyNs;
+            // How long acks were owed because of the events of this sensor.
+            nsecs_t mWakeLockHeld;
+            FlushInfo() : mPendingFlushEventsToSend(0), mFirstFlushPending(false),
+                          mSamplingPeriodNs(0), mMaxBatchReportLatencyNs(0),
+                          mWakeLockHeld(0) {}
         };
         // protected by SensorService::mLock. Key for this vector is the sensor handle.
         KeyedVector<int, FlushInfo> mSensorInfo;
         sensors_event_t *mEventCache;
         int mCacheSize, mMaxCacheSize;
+        // The most events that were in mEventCache at once.
+        int mCacheSizeHighWater;
+        // Totals over all the sensors this connection has had, including the ones it since
+        // unregistered from.
+        SensorDeliveryStats mStats;
 
 #if DEBUG_CONNECTIONS
         int mEventsReceived, mEventsSent, mEventsSentFromCache;
@@ -171,15 +236,25 @@ class SensorService :
     public:
         SensorEventConnection(const sp<SensorService>& service, uid_t uid);
 
+        // If eventIndices is set, only the events of buffer it lists, in that order, are considered
+        // and count is the number of indices.
         status_t sendEvents(sensors_event_t const* buffer, size_t count,
                 sensors_event_t* scratch,
-                SensorEventConnection const * const * mapFlushEventsToConnections = NULL);
+                SensorEventConnection const * const * mapFlushEventsToConnections = NULL,
+                uint32_t const* eventIndices = NULL);
         bool hasSensor(int32_t handle) const;
         bool hasAnySensor() const;
         bool hasOneShotSensors() const;
         bool addSensor(int32_t handle);
         bool removeSensor(int32_t handle);
         void setFirstFlushPending(int32_t handle, bool value);
+        // Record the rate and report latency asked for on a sensor and resize the socket buffer
+        // accordingly. setSamplingPeriod keeps the report latency.
+        void setBatchParams(int32_t handle, nsecs_t samplingPeriodNs,
+                nsecs_t maxBatchReportLatencyNs);
+        void setSamplingPeriod(int32_t handle, nsecs_t samplingPeriodNs);
+        // Resize the socket buffer after sensors were removed from this connection.
+        void updateSocketBufferSize();
         void dump(String8& result);
         bool needsWakeLock();
 
@@ -196,6 +271,9 @@ class SensorService :
         bool addConnection(const sp<SensorEventConnection>& connection);
         bool removeConnection(const wp<SensorEventConnection>& connection);
         size_t getNumConnections() const { return mConnections.size(); }
+        const SortedVector< wp<SensorEventConnection> >& getConnections() const {
+            return mConnections;
+        }
 
         void addPendingFlushConnection(const sp<SensorEventConnection>& connection);
         void removeFirstPendingFlushConnection();
@@ -214,7 +292,8 @@ class SensorService :
     Sensor getSensorFromHandle(int handle) const;
     bool isWakeUpSensor(int type) const;
     void recordLastValueLocked(sensors_event_t const* buffer, size_t count);
-    static void sortEventBuffer(sensors_event_t* buffer, size_t count);
+    static void sortEventBuffer(sensors_event_t* buffer,
+            sensors_event_t* scratch, size_t count);
     Sensor registerSensor(SensorInterface* sensor);
     Sensor registerVirtualSensor(SensorInterface* sensor);
     status_t cleanupWithoutDisable(
@@ -229,11 +308,40 @@ class SensorService :
     // method checks whether all the events from these wake up sensors have been delivered to the
     // corresponding applications, if yes the wakelock is released.
     void checkWakeLockState();
+    // Called by SensorEventAckReceiver: stops waiting for the acks of clients that didn't send
+    // them within WAKE_LOCK_ACK_TIMEOUT_NS, releasing the wake lock if nobody else needs it.
+    // Returns how long to wait before checking again, in ms, or -1 while the lock isn't held.
+    int checkWakeLockTimeouts();
     void checkWakeLockStateLocked();
+    // Acquire or release the wakelock and account for the time it was held.
+    void acquireWakeLockLocked();
+    void releaseWakeLockLocked();
     bool isWakeUpSensorEvent(const sensors_event_t& event) const;
 
     SensorRecord * getSensorRecord(int handle);
 
+    // The events of one sensor in a batch, see splitEventsBySensorLocked().
+    struct SensorEventRange {
+        int32_t handle;
+        size_t start;
+        size_t count;
+    };
+    // A batch is only split when it has events from at most this many sensors, so that the
+    // sensors a connection is registered for fit in a bit mask.
+    enum { MAX_SPLIT_SENSORS = 32 };
+
+    // Groups the indices of the first 'count' events of mSensorEventBuffer by sensor into
+    // mEventIndicesBySensor, with one entry per sensor in mEventRanges. Returns false if the batch
+    // has events from too many sensors.
+    bool splitEventsBySensorLocked(size_t count);
+    // Sets outMasks[i] to the bit mask of the sensors in mEventRanges connections[i] is
+    // registered for, using the connection list of each sensor's SensorRecord.
+    void findSubscribersLocked(const SortedVector< sp<SensorEventConnection> >& connections,
+            Vector<uint32_t>* outMasks) const;
+    // Points outIndices to the indices of the events of the sensors in mask, in the order they
+    // are in the batch, and returns how many there are.
+    size_t collectEventsLocked(uint32_t mask, uint32_t const** outIndices);
+
     sp<Looper> getLooper() const;
 
     // constants
@@ -243,8 +351,8 @@ class SensorService :
     DefaultKeyedVector<int, SensorInterface*> mSensorMap;
     Vector<SensorInterface *> mVirtualSensorList;
     status_t mInitCheck;
-    // Socket buffersize used to initialize BitTube. This size depends on whether batching is
-    // supported or not.
+    // Largest socket buffer size of a connection. This size depends on whether batching is
+    // supported or not. Each connection sizes its BitTube up to this from its sensors.
     uint32_t mSocketBufferSize;
     sp<Looper> mLooper;
 
@@ -254,8 +362,13 @@ class SensorService :
     DefaultKeyedVector<int, SensorInterface*> mActiveVirtualSensors;
     SortedVector< wp<SensorEventConnection> > mActiveConnections;
     bool mWakeLockAcquired;
+    // How often and how long the wakelock was held, on the elapsed realtime clock.
+    uint32_t mWakeLockAcquireCount;
+    nsecs_t mWakeLockAcquireTime, mWakeLockHeldTotal, mWakeLockHeldMax;
     sensors_event_t *mSensorEventBuffer, *mSensorEventScratch;
     SensorEventConnection const **mMapFlushEventsToConnections;
+    Vector<SensorEventRange> mEventRanges;
+    uint32_t *mEventIndicesBySensor, *mConnectionEventIndices;
 
     // The size of this vector is constant, only the items are mutable
     KeyedVector<int32_t, sensors_event_t> mLastEventSeen;
@@ -12,3 +12,71 @@ LOCAL_MODULE:= test-sensorservice
 LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_EXECUTABLE)
+
+#####################################################################
+# FusionKernels.h comparison test and microbenchmark
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	fusionkernelstest.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+# must round like libsensorservice does
+LOCAL_CFLAGS += -ffp-contract=off
+
+LOCAL_MODULE:= test-fusion-kernels
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_EXECUTABLE)
+
+#####################################################################
+# SensorEventSort.h ordering test and microbenchmark
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	sensoreventsorttest.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_MODULE:= test-sensor-event-sort
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_EXECUTABLE)
+
+#####################################################################
+# SensorService overhead benchmark
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	sensorservicebench.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+	libcutils libutils libui libgui
+
+LOCAL_MODULE:= test-sensorservice-bench
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_EXECUTABLE)
+
+#####################################################################
+# Sensors HAL with synthetic or recorded events for the benchmark,
+# selected with "setprop debug.sensors.hal replay" on debuggable builds
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	sensorreplayhal.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+	libcutils libutils liblog
+
+LOCAL_MODULE:= sensors.replay.default
+
+LOCAL_MODULE_RELATIVE_PATH := hw
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_SHARED_LIBRARY)
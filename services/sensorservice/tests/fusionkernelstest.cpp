@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Checks that the kernels in FusionKernels.h return exactly what the mat/vec
+ * expressions Fusion used before return, on random inputs, then times both.
+ * Exits with 1 if any result differs.
+ *
+ * Timings are printed as one tab separated line per operation:
+ *   <operation> <iterations> <reference ns> <kernel ns> <speedup>
+ *
+ * usage: test-fusion-kernels [-i iterations]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FusionKernels.h"
+
+using namespace android;
+using namespace android::kernels;
+
+static const int kNumInputs = 64;
+
+static int64_t now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static float rnd() {
+    return float(rand()) / RAND_MAX * 2 - 1;
+}
+
+static mat33_t rnd33() {
+    mat33_t m;
+    for (size_t c=0 ; c<3 ; c++)
+        for (size_t r=0 ; r<3 ; r++)
+            m[c][r] = rnd();
+    return m;
+}
+
+// Elements are compared with == rather than their bits: the kernels may
+// differ in the sign of a zero.
+template <size_t N>
+static bool same(const float* a, const float* b) {
+    for (size_t i=0 ; i<N ; i++) {
+        if (!(a[i] == b[i]) && !(isnan(a[i]) && isnan(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// What Fusion did before
+
+typedef mat<float, 3, 4> mat34_ref_t;
+
+static mat34_ref_t getF(const vec4_t& q) {
+    mat34_ref_t F;
+    F[0].x = q.w;   F[1].x =-q.z;   F[2].x = q.y;
+    F[0].y = q.z;   F[1].y = q.w;   F[2].y =-q.x;
+    F[0].z =-q.y;   F[1].z = q.x;   F[2].z = q.w;
+    F[0].w =-q.x;   F[1].w =-q.y;   F[2].w =-q.z;
+    return F;
+}
+
+static void propagateReference(mat66_t& P, const mat66_t& Phi,
+        const mat66_t& GQGt) {
+    P = Phi*P*transpose(Phi) + GQGt;
+}
+
+// ---------------------------------------------------------------------------
+
+struct Inputs {
+    mat66_t Phi;
+    mat66_t P;
+    mat66_t GQGt;
+    mat44_t O;
+    vec4_t q;
+    vec3_t v;
+    mat33_t a, b;
+};
+
+static void makeInputs(Inputs* in) {
+    in->Phi[0][0] = rnd33();
+    in->Phi[1][0] = rnd33();
+    in->Phi[0][1] = 0;
+    in->Phi[1][1] = 1;
+    // P is symmetric
+    in->P[0][0] = rnd33();
+    in->P[0][0] = in->P[0][0] + transpose(in->P[0][0]);
+    in->P[1][1] = rnd33();
+    in->P[1][1] = in->P[1][1] + transpose(in->P[1][1]);
+    in->P[1][0] = rnd33();
+    in->P[0][1] = transpose(in->P[1][0]);
+    in->GQGt[0][0] = rnd();
+    in->GQGt[1][0] = -rnd();
+    in->GQGt[0][1] = -rnd();
+    in->GQGt[1][1] = rnd();
+    for (size_t c=0 ; c<4 ; c++)
+        for (size_t r=0 ; r<4 ; r++)
+            in->O[c][r] = rnd();
+    for (size_t i=0 ; i<4 ; i++)
+        in->q[i] = rnd();
+    for (size_t i=0 ; i<3 ; i++)
+        in->v[i] = rnd();
+    in->a = rnd33();
+    in->b = rnd33();
+}
+
+static int check(const Inputs* inputs) {
+    int failures = 0;
+    for (int i=0 ; i<kNumInputs ; i++) {
+        const Inputs& in(inputs[i]);
+
+        mat66_t ref(in.P);
+        mat66_t res(in.P);
+        // a few steps, so that errors would build up
+        for (int step=0 ; step<4 ; step++) {
+            propagateReference(ref, in.Phi, in.GQGt);
+            propagateCovariance(res, in.Phi[0][0], in.Phi[1][0], in.GQGt);
+        }
+        if (!same<36>(&ref[0][0][0][0], &res[0][0][0][0])) {
+            printf("propagateCovariance differs for input %d\n", i);
+            failures++;
+        }
+
+        const mat33_t ab(in.a*in.b);
+        if (!same<9>(&ab[0][0], &mul(in.a, in.b)[0][0])) {
+            printf("mul(mat33_t, mat33_t) differs for input %d\n", i);
+            failures++;
+        }
+
+        const vec4_t oq(in.O*in.q);
+        if (!same<4>(&oq[0], &mul(in.O, in.q)[0])) {
+            printf("mul(mat44_t, vec4_t) differs for input %d\n", i);
+            failures++;
+        }
+
+        const vec4_t fv(getF(in.q)*in.v);
+        if (!same<4>(&fv[0], &mulF(in.q, in.v)[0])) {
+            printf("mulF differs for input %d\n", i);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+
+// Keeps the compiler from dropping the results.
+static volatile float sSink;
+
+static void report(const char* name, int iterations, int64_t ref,
+        int64_t kernel) {
+    const double n = double(iterations) * kNumInputs;
+    printf("%s\t%d\t%.1f\t%.1f\t%.2f\n", name, iterations, ref / n,
+            kernel / n, kernel ? double(ref) / kernel : 0.0);
+}
+
+static void benchmark(const Inputs* inputs, int iterations) {
+    int64_t t0, t1, t2;
+
+    t0 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            mat66_t P(inputs[i].P);
+            propagateReference(P, inputs[i].Phi, inputs[i].GQGt);
+            sSink = P[0][0][0][0];
+        }
+    }
+    t1 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            mat66_t P(inputs[i].P);
+            propagateCovariance(P, inputs[i].Phi[0][0], inputs[i].Phi[1][0],
+                    inputs[i].GQGt);
+            sSink = P[0][0][0][0];
+        }
+    }
+    t2 = now();
+    report("propagateCovariance", iterations, t1 - t0, t2 - t1);
+
+    t0 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            sSink = (inputs[i].a*inputs[i].b)[2][2];
+        }
+    }
+    t1 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            sSink = mul(inputs[i].a, inputs[i].b)[2][2];
+        }
+    }
+    t2 = now();
+    report("mul33", iterations, t1 - t0, t2 - t1);
+
+    t0 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            sSink = (inputs[i].O*inputs[i].q).w;
+        }
+    }
+    t1 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            sSink = mul(inputs[i].O, inputs[i].q).w;
+        }
+    }
+    t2 = now();
+    report("mul44x4", iterations, t1 - t0, t2 - t1);
+
+    t0 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            sSink = (getF(inputs[i].q)*inputs[i].v).w;
+        }
+    }
+    t1 = now();
+    for (int k=0 ; k<iterations ; k++) {
+        for (int i=0 ; i<kNumInputs ; i++) {
+            sSink = mulF(inputs[i].q, inputs[i].v).w;
+        }
+    }
+    t2 = now();
+    report("mulF", iterations, t1 - t0, t2 - t1);
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10000;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:")) != -1) {
+        switch (opt) {
+            case 'i':
+                iterations = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-i iterations]\n", argv[0]);
+                return 2;
+        }
+    }
+
+#if FUSION_KERNELS_NEON
+    printf("kernels: NEON\n");
+#else
+    printf("kernels: generic\n");
+#endif
+
+    srand(1);
+    Inputs* inputs = new Inputs[kNumInputs];
+    for (int i=0 ; i<kNumInputs ; i++) {
+        makeInputs(&inputs[i]);
+    }
+
+    const int failures = check(inputs);
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        delete [] inputs;
+        return 1;
+    }
+    printf("all kernels match\n");
+
+    benchmark(inputs, iterations);
+    delete [] inputs;
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Checks that sortEventsByTimestamp() in SensorEventSort.h orders buffers
+ * like the ones SensorService sorts by timestamp, keeping the order of
+ * events with the same timestamp, then times it against the qsort
+ * SensorService used before. Exits with 1 if any buffer is wrong.
+ *
+ * Timings are printed as one tab separated line per buffer shape:
+ *   <shape> <events> <iterations> <qsort ns> <merge ns> <speedup>
+ *
+ * usage: test-sensor-event-sort [-i iterations]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SensorEventSort.h"
+
+using namespace android;
+
+// SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT
+static const size_t kMaxEvents = 256;
+
+static int64_t now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// What SensorService did before. The difference of the timestamps is
+// truncated to an int, so events more than ~2s apart can come out in the
+// wrong order; it is only used for timing.
+static int compareTimestamps(void const* lhs, void const* rhs) {
+    sensors_event_t const* l = static_cast<sensors_event_t const*>(lhs);
+    sensors_event_t const* r = static_cast<sensors_event_t const*>(rhs);
+    return l->timestamp - r->timestamp;
+}
+
+// ---------------------------------------------------------------------------
+
+struct Buffer {
+    const char* shape;
+    size_t count;
+    sensors_event_t events[kMaxEvents];
+};
+
+static void setEvent(sensors_event_t* e, int32_t sensor, int64_t timestamp) {
+    memset(e, 0, sizeof(*e));
+    e->version = sizeof(sensors_event_t);
+    e->sensor = sensor;
+    e->timestamp = timestamp;
+}
+
+// What the HAL returns, in order, followed by what numVirtual virtual
+// sensors made of it: one event with the same timestamp per virtual sensor
+// for each HAL event, appended in the order SensorService::threadLoop()
+// does. With interleaved, the HAL events are two sensors each in order but
+// not with each other, like a batch of the accelerometer then the gyro.
+static void makeBuffer(Buffer* b, const char* shape, size_t halCount,
+        size_t numVirtual, bool interleaved, int64_t period) {
+    b->shape = shape;
+    b->count = 0;
+    int64_t t = 1000000000LL + (rand() % 1000);
+    for (size_t i=0 ; i<halCount ; i++) {
+        int64_t ts = t;
+        if (interleaved) {
+            // the second half restarts from the beginning, offset a bit
+            const size_t half = (halCount + 1) / 2;
+            ts = 1000000000LL + int64_t(i % half) * period + (i >= half ? period / 3 : 0);
+        } else {
+            t += period + (rand() % 16);
+        }
+        setEvent(&b->events[b->count++], 1 + (interleaved && i >= (halCount + 1) / 2), ts);
+    }
+    for (size_t i=0 ; i<halCount ; i++) {
+        for (size_t j=0 ; j<numVirtual && b->count<kMaxEvents ; j++) {
+            setEvent(&b->events[b->count++], 100 + j, b->events[i].timestamp);
+        }
+    }
+}
+
+// The expected order: a stable insertion sort, with 64-bit compares.
+static void sortReference(sensors_event_t* events, size_t count) {
+    for (size_t i=1 ; i<count ; i++) {
+        sensors_event_t e = events[i];
+        size_t j = i;
+        while (j > 0 && events[j - 1].timestamp > e.timestamp) {
+            events[j] = events[j - 1];
+            j--;
+        }
+        events[j] = e;
+    }
+}
+
+static int check(const Buffer* buffers, size_t numBuffers) {
+    int failures = 0;
+    sensors_event_t ref[kMaxEvents];
+    sensors_event_t res[kMaxEvents];
+    sensors_event_t scratch[kMaxEvents];
+    for (size_t i=0 ; i<numBuffers ; i++) {
+        const Buffer& b(buffers[i]);
+        memcpy(ref, b.events, b.count * sizeof(sensors_event_t));
+        memcpy(res, b.events, b.count * sizeof(sensors_event_t));
+        sortReference(ref, b.count);
+        sortEventsByTimestamp(res, scratch, b.count);
+        if (memcmp(ref, res, b.count * sizeof(sensors_event_t))) {
+            printf("%s (%zu events) sorted wrong\n", b.shape, b.count);
+            failures++;
+        }
+    }
+
+    // timestamps further apart than an int can hold
+    sensors_event_t far[3];
+    setEvent(&far[0], 1, 3000000000LL);
+    setEvent(&far[1], 1, 0);
+    setEvent(&far[2], 1, 6000000000LL);
+    sortEventsByTimestamp(far, scratch, 3);
+    if (far[0].timestamp != 0 || far[1].timestamp != 3000000000LL ||
+            far[2].timestamp != 6000000000LL) {
+        printf("timestamps more than 2s apart sorted wrong\n");
+        failures++;
+    }
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+
+// Keeps the compiler from dropping the results.
+static volatile int64_t sSink;
+
+static void benchmark(const Buffer* buffers, size_t numBuffers, int iterations) {
+    sensors_event_t work[kMaxEvents];
+    sensors_event_t scratch[kMaxEvents];
+    for (size_t i=0 ; i<numBuffers ; i++) {
+        const Buffer& b(buffers[i]);
+        const size_t size = b.count * sizeof(sensors_event_t);
+        int64_t t0, t1, t2, copy;
+
+        // the copies are timed alone and taken out
+        t0 = now();
+        for (int k=0 ; k<iterations ; k++) {
+            memcpy(work, b.events, size);
+            sSink = work[b.count - 1].timestamp;
+        }
+        copy = now() - t0;
+
+        t0 = now();
+        for (int k=0 ; k<iterations ; k++) {
+            memcpy(work, b.events, size);
+            qsort(work, b.count, sizeof(sensors_event_t), compareTimestamps);
+            sSink = work[b.count - 1].timestamp;
+        }
+        t1 = now();
+        for (int k=0 ; k<iterations ; k++) {
+            memcpy(work, b.events, size);
+            sortEventsByTimestamp(work, scratch, b.count);
+            sSink = work[b.count - 1].timestamp;
+        }
+        t2 = now();
+
+        const int64_t ref = t1 - t0 - copy;
+        const int64_t merge = t2 - t1 - copy;
+        printf("%s\t%zu\t%d\t%.1f\t%.1f\t%.2f\n", b.shape, b.count, iterations,
+                double(ref) / iterations, double(merge) / iterations,
+                merge > 0 ? double(ref) / merge : 0.0);
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10000;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:")) != -1) {
+        switch (opt) {
+            case 'i':
+                iterations = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-i iterations]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    srand(1);
+    Buffer* buffers = new Buffer[6];
+    // a game rotation vector on a 200Hz gyro, batches of various sizes
+    makeBuffer(&buffers[0], "sorted", 64, 0, false, 5000000);
+    makeBuffer(&buffers[1], "1-virtual", 16, 1, false, 5000000);
+    makeBuffer(&buffers[2], "3-virtual", 32, 3, false, 5000000);
+    makeBuffer(&buffers[3], "6-virtual", 36, 6, false, 5000000);
+    makeBuffer(&buffers[4], "interleaved", 64, 2, true, 5000000);
+    // a batch spanning more than the old comparator could tell apart
+    makeBuffer(&buffers[5], "long-batch", 128, 1, false, 50000000);
+
+    const int failures = check(buffers, 6);
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        delete [] buffers;
+        return 1;
+    }
+    printf("all buffers sorted\n");
+
+    benchmark(buffers, 6, iterations);
+    delete [] buffers;
+    return 0;
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A sensors HAL that makes up its events, for measuring SensorService.
+ *
+ * It has an accelerometer, a gyroscope and a magnetometer, so that the
+ * fusion sensors are registered, and a wake-up accelerometer. Events are
+ * generated at the rate SensorService asks for and batched with the report
+ * latency it asks for, in one FIFO of FIFO_MAX_EVENT_COUNT events. Each
+ * event carries a per-sensor sequence number in u64.data[7], which clients
+ * use to count the events that were dropped on the way.
+ *
+ * The values are synthetic, unless debug.sensors.replay.file names a
+ * recording, one "<sensor type> <x> <y> <z>" sample per line, in which case
+ * the samples of each sensor type are played in a loop.
+ *
+ * On a debuggable build, with this HAL installed as
+ * /system/lib/hw/sensors.replay.default.so:
+ *   adb shell setprop debug.sensors.hal replay
+ *   adb shell stop; adb shell start
+ */
+
+#define LOG_TAG "SensorReplayHal"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cutils/log.h>
+#include <cutils/properties.h>
+
+#include <hardware/sensors.h>
+
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+using namespace android;
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+enum {
+    HANDLE_ACCELEROMETER = 1,
+    HANDLE_GYROSCOPE,
+    HANDLE_MAGNETIC_FIELD,
+    HANDLE_WAKE_UP_ACCELEROMETER,
+    NUM_SENSORS = 4
+};
+
+const uint32_t FIFO_MAX_EVENT_COUNT = 3000;
+const int32_t MIN_DELAY_US = 2500;    // 400 Hz
+const int32_t MAX_DELAY_US = 1000000; // 1 Hz
+
+sensor_t makeSensor(const char* name, int handle, int type, const char* stringType,
+        float maxRange, uint32_t flags) {
+    sensor_t sensor;
+    memset(&sensor, 0, sizeof(sensor));
+    sensor.name = name;
+    sensor.vendor = "AOSP";
+    sensor.version = 1;
+    sensor.handle = handle;
+    sensor.type = type;
+    sensor.maxRange = maxRange;
+    sensor.resolution = maxRange / 65536.0f;
+    sensor.power = 0.1f;
+    sensor.minDelay = MIN_DELAY_US;
+    sensor.fifoReservedEventCount = 0;
+    sensor.fifoMaxEventCount = FIFO_MAX_EVENT_COUNT;
+    sensor.stringType = stringType;
+    sensor.requiredPermission = "";
+    sensor.maxDelay = MAX_DELAY_US;
+    sensor.flags = flags | SENSOR_FLAG_CONTINUOUS_MODE;
+    return sensor;
+}
+
+const sensor_t sSensorList[NUM_SENSORS] = {
+    makeSensor("Replay Accelerometer", HANDLE_ACCELEROMETER,
+            SENSOR_TYPE_ACCELEROMETER, SENSOR_STRING_TYPE_ACCELEROMETER, 4 * GRAVITY_EARTH, 0),
+    makeSensor("Replay Gyroscope", HANDLE_GYROSCOPE,
+            SENSOR_TYPE_GYROSCOPE, SENSOR_STRING_TYPE_GYROSCOPE, 35.0f, 0),
+    makeSensor("Replay Magnetic Field", HANDLE_MAGNETIC_FIELD,
+            SENSOR_TYPE_MAGNETIC_FIELD, SENSOR_STRING_TYPE_MAGNETIC_FIELD, 2000.0f, 0),
+    makeSensor("Replay Wake-up Accelerometer", HANDLE_WAKE_UP_ACCELEROMETER,
+            SENSOR_TYPE_ACCELEROMETER, SENSOR_STRING_TYPE_ACCELEROMETER, 4 * GRAVITY_EARTH,
+            SENSOR_FLAG_WAKE_UP),
+};
+
+struct Sample {
+    float v[3];
+};
+
+class ReplayDevice : public sensors_poll_device_1 {
+public:
+    ReplayDevice(const hw_module_t* module);
+
+    int activateImpl(int handle, int enabled);
+    int batchImpl(int handle, int64_t samplingPeriodNs, int64_t maxBatchReportLatencyNs);
+    int flushImpl(int handle);
+    int pollImpl(sensors_event_t* data, int count);
+
+private:
+    struct SensorState {
+        bool active;
+        nsecs_t period;
+        nsecs_t latency;
+        nsecs_t nextEventTime;
+        // Timestamp of the oldest event of this sensor in mFifo, 0 if there is none.
+        nsecs_t pendingSince;
+        uint64_t sequence;
+        size_t nextSample;
+        SensorState() : active(false), period(ms2ns(200)), latency(0), nextEventTime(0),
+                pendingSince(0), sequence(0), nextSample(0) {}
+    };
+
+    SensorState* getState(int handle);
+    void loadRecording(const char* path);
+    // Adds the events that are due by now to mFifo.
+    void generateLocked(nsecs_t now);
+    void makeEventLocked(int index, sensors_event_t* event);
+    // Returns true if mFifo should be handed to SensorService now, or else sets *outDeadline to
+    // when it should, 0 if no sensor is active.
+    bool readyLocked(nsecs_t now, nsecs_t* outDeadline) const;
+
+    Mutex mLock;
+    Condition mCondition;
+    SensorState mSensors[NUM_SENSORS];
+    // Recorded samples, indexed like mSensors.
+    Vector<Sample> mSamples[NUM_SENSORS];
+    Vector<sensors_event_t> mFifo;
+    // A flush complete event is in mFifo.
+    bool mFlushPending;
+};
+
+ReplayDevice* getDevice(void* dev) {
+    return static_cast<ReplayDevice*>(reinterpret_cast<sensors_poll_device_1*>(dev));
+}
+
+int deviceClose(hw_device_t* dev) {
+    delete getDevice(dev);
+    return 0;
+}
+
+int deviceActivate(sensors_poll_device_t* dev, int handle, int enabled) {
+    return getDevice(dev)->activateImpl(handle, enabled);
+}
+
+int deviceSetDelay(sensors_poll_device_t* dev, int handle, int64_t ns) {
+    return getDevice(dev)->batchImpl(handle, ns, 0);
+}
+
+int devicePoll(sensors_poll_device_t* dev, sensors_event_t* data, int count) {
+    return getDevice(dev)->pollImpl(data, count);
+}
+
+int deviceBatch(sensors_poll_device_1* dev, int handle, int /*flags*/, int64_t period_ns,
+        int64_t timeout) {
+    return getDevice(dev)->batchImpl(handle, period_ns, timeout);
+}
+
+int deviceFlush(sensors_poll_device_1* dev, int handle) {
+    return getDevice(dev)->flushImpl(handle);
+}
+
+ReplayDevice::ReplayDevice(const hw_module_t* module)
+    : mFlushPending(false) {
+    memset(static_cast<sensors_poll_device_1*>(this), 0, sizeof(sensors_poll_device_1));
+    common.tag = HARDWARE_DEVICE_TAG;
+    common.version = SENSORS_DEVICE_API_VERSION_1_3;
+    common.module = const_cast<hw_module_t*>(module);
+    common.close = deviceClose;
+    activate = deviceActivate;
+    setDelay = deviceSetDelay;
+    poll = devicePoll;
+    batch = deviceBatch;
+    flush = deviceFlush;
+
+    char path[PROPERTY_VALUE_MAX];
+    if (property_get("debug.sensors.replay.file", path, NULL) > 0) {
+        loadRecording(path);
+    }
+}
+
+void ReplayDevice::loadRecording(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        ALOGE("can't open %s (%s)", path, strerror(errno));
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int type;
+        Sample sample;
+        if (line[0] == '#' ||
+                sscanf(line, "%d %f %f %f", &type, &sample.v[0], &sample.v[1], &sample.v[2]) != 4) {
+            continue;
+        }
+        for (int i = 0; i < NUM_SENSORS; i++) {
+            if (sSensorList[i].type == type) {
+                mSamples[i].add(sample);
+            }
+        }
+    }
+    fclose(fp);
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        ALOGI("%s: %zu recorded samples", sSensorList[i].name, mSamples[i].size());
+    }
+}
+
+ReplayDevice::SensorState* ReplayDevice::getState(int handle) {
+    if (handle < HANDLE_ACCELEROMETER || handle > NUM_SENSORS) {
+        return NULL;
+    }
+    return &mSensors[handle - HANDLE_ACCELEROMETER];
+}
+
+int ReplayDevice::activateImpl(int handle, int enabled) {
+    Mutex::Autolock _l(mLock);
+    SensorState* state = getState(handle);
+    if (state == NULL) {
+        return -EINVAL;
+    }
+    if (enabled && !state->active) {
+        state->nextEventTime = systemTime(SYSTEM_TIME_BOOTTIME) + state->period;
+    }
+    state->active = enabled;
+    mCondition.signal();
+    return 0;
+}
+
+int ReplayDevice::batchImpl(int handle, int64_t samplingPeriodNs,
+        int64_t maxBatchReportLatencyNs) {
+    Mutex::Autolock _l(mLock);
+    SensorState* state = getState(handle);
+    if (state == NULL) {
+        return -EINVAL;
+    }
+    if (samplingPeriodNs < us2ns(MIN_DELAY_US)) {
+        samplingPeriodNs = us2ns(MIN_DELAY_US);
+    } else if (samplingPeriodNs > us2ns(MAX_DELAY_US)) {
+        samplingPeriodNs = us2ns(MAX_DELAY_US);
+    }
+    state->period = samplingPeriodNs;
+    state->latency = maxBatchReportLatencyNs;
+    mCondition.signal();
+    return 0;
+}
+
+int ReplayDevice::flushImpl(int handle) {
+    Mutex::Autolock _l(mLock);
+    SensorState* state = getState(handle);
+    if (state == NULL || !state->active) {
+        return -EINVAL;
+    }
+    generateLocked(systemTime(SYSTEM_TIME_BOOTTIME));
+    sensors_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.version = META_DATA_VERSION;
+    event.type = SENSOR_TYPE_META_DATA;
+    event.meta_data.what = META_DATA_FLUSH_COMPLETE;
+    event.meta_data.sensor = handle;
+    mFifo.add(event);
+    mFlushPending = true;
+    mCondition.signal();
+    return 0;
+}
+
+void ReplayDevice::makeEventLocked(int index, sensors_event_t* event) {
+    SensorState& state(mSensors[index]);
+    const sensor_t& sensor(sSensorList[index]);
+    memset(event, 0, sizeof(*event));
+    event->version = sizeof(sensors_event_t);
+    event->sensor = sensor.handle;
+    event->type = sensor.type;
+    event->timestamp = state.nextEventTime;
+
+    float v[3];
+    if (!mSamples[index].isEmpty()) {
+        const Sample& sample(mSamples[index][state.nextSample]);
+        state.nextSample = (state.nextSample + 1) % mSamples[index].size();
+        memcpy(v, sample.v, sizeof(v));
+    } else {
+        // A device swaying slowly, lying on its back.
+        const float t = float(state.nextEventTime % s2ns(10)) / s2ns(1);
+        const float s = sinf(t * 2 * M_PI / 10), c = cosf(t * 2 * M_PI / 10);
+        switch (sensor.type) {
+            case SENSOR_TYPE_ACCELEROMETER:
+                v[0] = 0.5f * s; v[1] = 0.5f * c; v[2] = GRAVITY_EARTH;
+                break;
+            case SENSOR_TYPE_GYROSCOPE:
+                v[0] = 0.05f * c; v[1] = -0.05f * s; v[2] = 0;
+                break;
+            default:
+                v[0] = 0; v[1] = 22.0f; v[2] = -40.0f;
+                break;
+        }
+    }
+    event->data[0] = v[0];
+    event->data[1] = v[1];
+    event->data[2] = v[2];
+    event->acceleration.status = SENSOR_STATUS_ACCURACY_HIGH;
+    event->u64.data[7] = ++state.sequence;
+}
+
+void ReplayDevice::generateLocked(nsecs_t now) {
+    for (;;) {
+        // Next event of all the sensors, so that mFifo stays in timestamp order.
+        int next = -1;
+        for (int i = 0; i < NUM_SENSORS; i++) {
+            if (mSensors[i].active && mSensors[i].nextEventTime <= now &&
+                    (next < 0 || mSensors[i].nextEventTime < mSensors[next].nextEventTime)) {
+                next = i;
+            }
+        }
+        if (next < 0 || mFifo.size() >= FIFO_MAX_EVENT_COUNT) {
+            return;
+        }
+        sensors_event_t event;
+        makeEventLocked(next, &event);
+        mFifo.add(event);
+        SensorState& state(mSensors[next]);
+        if (state.pendingSince == 0) {
+            state.pendingSince = state.nextEventTime;
+        }
+        state.nextEventTime += state.period;
+    }
+}
+
+bool ReplayDevice::readyLocked(nsecs_t now, nsecs_t* outDeadline) const {
+    if (mFlushPending || mFifo.size() >= FIFO_MAX_EVENT_COUNT) {
+        return true;
+    }
+    nsecs_t deadline = 0;
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        const SensorState& state(mSensors[i]);
+        nsecs_t sensorDeadline;
+        if (state.pendingSince != 0) {
+            sensorDeadline = state.pendingSince + state.latency;
+            if (sensorDeadline <= now) {
+                return true;
+            }
+        } else if (state.active) {
+            // The events of a batched sensor are only generated when they are reported.
+            sensorDeadline = state.nextEventTime + state.latency;
+        } else {
+            continue;
+        }
+        if (deadline == 0 || sensorDeadline < deadline) {
+            deadline = sensorDeadline;
+        }
+    }
+    *outDeadline = deadline;
+    return false;
+}
+
+int ReplayDevice::pollImpl(sensors_event_t* data, int count) {
+    Mutex::Autolock _l(mLock);
+    for (;;) {
+        const nsecs_t now = systemTime(SYSTEM_TIME_BOOTTIME);
+        generateLocked(now);
+        nsecs_t deadline;
+        if (readyLocked(now, &deadline)) {
+            break;
+        }
+        if (deadline == 0) {
+            mCondition.wait(mLock);
+        } else {
+            mCondition.waitRelative(mLock, deadline - now);
+        }
+    }
+
+    const size_t n = mFifo.size() < size_t(count) ? mFifo.size() : size_t(count);
+    memcpy(data, mFifo.array(), n * sizeof(sensors_event_t));
+    mFifo.removeItemsAt(0, n);
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        mSensors[i].pendingSince = 0;
+    }
+    mFlushPending = false;
+    for (size_t i = 0; i < mFifo.size(); i++) {
+        const sensors_event_t& event(mFifo[i]);
+        if (event.type == SENSOR_TYPE_META_DATA) {
+            mFlushPending = true;
+        } else {
+            SensorState* state = getState(event.sensor);
+            if (state->pendingSince == 0) {
+                state->pendingSince = event.timestamp;
+            }
+        }
+    }
+    return n;
+}
+
+int getSensorsList(sensors_module_t* /*module*/, sensor_t const** list) {
+    *list = sSensorList;
+    return NUM_SENSORS;
+}
+
+int openSensors(const hw_module_t* module, const char* id, hw_device_t** device) {
+    if (strcmp(id, SENSORS_HARDWARE_POLL)) {
+        return -EINVAL;
+    }
+    ReplayDevice* dev = new ReplayDevice(module);
+    *device = &dev->common;
+    return 0;
+}
+
+hw_module_methods_t sSensorsModuleMethods = {
+    open: openSensors
+};
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+sensors_module_t HAL_MODULE_INFO_SYM = {
+    common: {
+        tag: HARDWARE_MODULE_TAG,
+        version_major: 1,
+        version_minor: 0,
+        id: SENSORS_HARDWARE_MODULE_ID,
+        name: "Sensor replay HAL",
+        author: "The Android Open Source Project",
+        methods: &sSensorsModuleMethods,
+        dso: NULL,
+        reserved: {0},
+    },
+    get_sensors_list: getSensorsList,
+};
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures the overhead of SensorService: a number of clients register for
+ * the same sensors, read their events for a while, and the CPU time of the
+ * process hosting SensorService, the delivery latency and the events lost
+ * are reported.
+ *
+ * Meant to run against the replay HAL (sensorreplayhal.cpp), whose events
+ * carry a sequence number to count drops with; with another HAL drops are
+ * not counted. Wake-up sensor events are acked like SensorManager does.
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <android/sensor.h>
+#include <gui/Sensor.h>
+#include <gui/SensorManager.h>
+#include <gui/SensorEventQueue.h>
+#include <utils/Looper.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+using namespace android;
+
+// ----------------------------------------------------------------------------
+
+struct SensorStats {
+    int32_t handle;
+    uint64_t received;
+    uint64_t dropped;
+    uint64_t lastSequence;
+    nsecs_t latencyTotal;
+    nsecs_t latencyMax;
+    // Latencies in buckets of 1 ms, the last one for everything above.
+    enum { NUM_BUCKETS = 1000 };
+    uint32_t latencyBuckets[NUM_BUCKETS];
+
+    SensorStats(int32_t handle = 0) : handle(handle), received(0), dropped(0), lastSequence(0),
+            latencyTotal(0), latencyMax(0) {
+        memset(latencyBuckets, 0, sizeof(latencyBuckets));
+    }
+
+    void add(const SensorStats& other) {
+        received += other.received;
+        dropped += other.dropped;
+        latencyTotal += other.latencyTotal;
+        latencyMax = latencyMax > other.latencyMax ? latencyMax : other.latencyMax;
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            latencyBuckets[i] += other.latencyBuckets[i];
+        }
+    }
+
+    float percentileMs(float p) const {
+        uint64_t target = uint64_t(received * p), count = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            count += latencyBuckets[i];
+            if (count > target) {
+                return i + 1;
+            }
+        }
+        return NUM_BUCKETS;
+    }
+};
+
+struct Client {
+    sp<SensorEventQueue> queue;
+    Vector<SensorStats> stats;
+    uint64_t acks;
+    Client() : acks(0) {}
+};
+
+static nsecs_t sStartTime;
+
+static int receiver(int /*fd*/, int /*events*/, void* data) {
+    Client* client = static_cast<Client*>(data);
+    ASensorEvent buffer[SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT];
+    const size_t size = SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT;
+    ssize_t n;
+    while ((n = client->queue->read(buffer, size)) > 0) {
+        const nsecs_t now = systemTime(SYSTEM_TIME_BOOTTIME);
+        for (ssize_t i = 0; i < n; i++) {
+            const ASensorEvent& event(buffer[i]);
+            if (event.type == SENSOR_TYPE_META_DATA || event.timestamp < sStartTime) {
+                continue;
+            }
+            SensorStats* stats = NULL;
+            for (size_t j = 0; j < client->stats.size(); j++) {
+                if (client->stats[j].handle == event.sensor) {
+                    stats = &client->stats.editItemAt(j);
+                    break;
+                }
+            }
+            if (stats == NULL) {
+                continue;
+            }
+            stats->received++;
+            const nsecs_t latency = now - event.timestamp;
+            stats->latencyTotal += latency;
+            if (latency > stats->latencyMax) {
+                stats->latencyMax = latency;
+            }
+            size_t bucket = size_t(latency / ms2ns(1));
+            stats->latencyBuckets[bucket < SensorStats::NUM_BUCKETS ?
+                    bucket : SensorStats::NUM_BUCKETS - 1]++;
+            // Only events of the replay HAL have a sequence number.
+            const uint64_t sequence = event.u64.data[7];
+            if (sequence != 0) {
+                if (stats->lastSequence != 0 && sequence > stats->lastSequence + 1) {
+                    stats->dropped += sequence - stats->lastSequence - 1;
+                }
+                stats->lastSequence = sequence;
+            }
+            if (event.flags & WAKE_UP_SENSOR_EVENT_NEEDS_ACK) {
+                client->acks++;
+            }
+        }
+        client->queue->sendAck(buffer, n);
+    }
+    if (n < 0 && n != -EAGAIN) {
+        printf("error reading events (%s)\n", strerror(-n));
+    }
+    return 1;
+}
+
+// Finds the process SensorService runs in: sensorservice on its own, or system_server.
+static pid_t findServicePid() {
+    pid_t systemServer = -1;
+    DIR* dir = opendir("/proc");
+    if (dir == NULL) {
+        return -1;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isdigit(entry->d_name[0])) {
+            continue;
+        }
+        char path[64], name[256];
+        snprintf(path, sizeof(path), "/proc/%s/cmdline", entry->d_name);
+        FILE* fp = fopen(path, "r");
+        if (fp == NULL) {
+            continue;
+        }
+        size_t len = fread(name, 1, sizeof(name) - 1, fp);
+        fclose(fp);
+        name[len] = '\0';
+        if (strcmp(name, "/system/bin/sensorservice") == 0) {
+            closedir(dir);
+            return atoi(entry->d_name);
+        }
+        if (strcmp(name, "system_server") == 0) {
+            systemServer = atoi(entry->d_name);
+        }
+    }
+    closedir(dir);
+    return systemServer;
+}
+
+// Returns the user and system CPU time of a process, -1 on error.
+static nsecs_t getProcessCpuTime(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    char line[1024];
+    nsecs_t cpuTime = -1;
+    if (fgets(line, sizeof(line), fp) != NULL) {
+        // utime and stime are the 14th and 15th fields, the 2nd one may contain spaces.
+        const char* fields = strrchr(line, ')');
+        unsigned long utime, stime;
+        if (fields != NULL &&
+                sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                        &utime, &stime) == 2) {
+            cpuTime = (utime + stime) * (s2ns(1) / sysconf(_SC_CLK_TCK));
+        }
+    }
+    fclose(fp);
+    return cpuTime;
+}
+
+static nsecs_t getSelfCpuTime() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return s2ns(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+            us2ns(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+static void usage(const char* name) {
+    printf("usage: %s [-c clients] [-d seconds] [-r period_us] [-l latency_us] [-t types]\n"
+           "  -c  number of clients (1)\n"
+           "  -d  duration of the run (10)\n"
+           "  -r  sampling period each client asks for (5000)\n"
+           "  -l  max report latency each client asks for (0)\n"
+           "  -t  comma separated sensor types (1 = accelerometer, 11 = rotation vector)\n"
+           "      all the sensors of a type are used, wake-up ones included (1)\n",
+           name);
+}
+
+int main(int argc, char** argv) {
+    int numClients = 1;
+    int duration = 10;
+    int32_t samplingPeriodUs = 5000;
+    int maxBatchReportLatencyUs = 0;
+    const char* types = "1";
+    int opt;
+    while ((opt = getopt(argc, argv, "c:d:r:l:t:h")) != -1) {
+        switch (opt) {
+            case 'c': numClients = atoi(optarg); break;
+            case 'd': duration = atoi(optarg); break;
+            case 'r': samplingPeriodUs = atoi(optarg); break;
+            case 'l': maxBatchReportLatencyUs = atoi(optarg); break;
+            case 't': types = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    SensorManager& mgr(SensorManager::getInstance());
+    Sensor const* const* list;
+    ssize_t count = mgr.getSensorList(&list);
+
+    Vector<Sensor const*> sensors;
+    String8 typeList(types);
+    for (char* type = strtok(typeList.lockBuffer(typeList.size()), ","); type != NULL;
+            type = strtok(NULL, ",")) {
+        for (ssize_t i = 0; i < count; i++) {
+            if (list[i]->getType() == atoi(type)) {
+                sensors.add(list[i]);
+            }
+        }
+    }
+    typeList.unlockBuffer();
+    if (sensors.isEmpty()) {
+        printf("no sensor of type %s\n", types);
+        return 1;
+    }
+
+    sp<Looper> looper = new Looper(false);
+    Vector<Client*> clients;
+    for (int c = 0; c < numClients; c++) {
+        Client* client = new Client();
+        client->queue = mgr.createEventQueue();
+        for (size_t i = 0; i < sensors.size(); i++) {
+            client->stats.add(SensorStats(sensors[i]->getHandle()));
+            client->queue->enableSensor(sensors[i]->getHandle(), samplingPeriodUs,
+                    maxBatchReportLatencyUs, 0);
+        }
+        looper->addFd(client->queue->getFd(), 0, ALOOPER_EVENT_INPUT, receiver, client);
+        clients.add(client);
+    }
+
+    const pid_t servicePid = findServicePid();
+    const nsecs_t serviceCpuStart = getProcessCpuTime(servicePid);
+    const nsecs_t selfCpuStart = getSelfCpuTime();
+    sStartTime = systemTime(SYSTEM_TIME_BOOTTIME);
+    const nsecs_t endTime = sStartTime + s2ns(duration);
+    for (nsecs_t now = sStartTime; now < endTime; now = systemTime(SYSTEM_TIME_BOOTTIME)) {
+        looper->pollOnce(toMillisecondTimeoutDelay(now, endTime));
+    }
+    const nsecs_t elapsed = systemTime(SYSTEM_TIME_BOOTTIME) - sStartTime;
+    const nsecs_t serviceCpu = getProcessCpuTime(servicePid) - serviceCpuStart;
+    const nsecs_t selfCpu = getSelfCpuTime() - selfCpuStart;
+
+    for (int c = 0; c < numClients; c++) {
+        for (size_t i = 0; i < sensors.size(); i++) {
+            clients[c]->queue->disableSensor(sensors[i]->getHandle());
+        }
+    }
+
+    printf("%d clients, period %d us, latency %d us, %.1f s\n", numClients, samplingPeriodUs,
+            maxBatchReportLatencyUs, elapsed / 1e9);
+    printf("%-32s %10s %8s %8s %8s %8s %8s\n", "sensor", "events", "dropped",
+            "avg(ms)", "p50(ms)", "p99(ms)", "max(ms)");
+    uint64_t acks = 0;
+    for (int c = 0; c < numClients; c++) {
+        acks += clients[c]->acks;
+    }
+    for (size_t i = 0; i < sensors.size(); i++) {
+        SensorStats total;
+        for (int c = 0; c < numClients; c++) {
+            total.add(clients[c]->stats[i]);
+        }
+        printf("%-32.32s %10" PRIu64 " %8" PRIu64 " %8.2f %8.0f %8.0f %8.2f\n",
+                sensors[i]->getName().string(), total.received, total.dropped,
+                total.received ? total.latencyTotal / 1e6 / total.received : 0.0,
+                total.percentileMs(0.5f), total.percentileMs(0.99f), total.latencyMax / 1e6);
+    }
+    printf("wake-up acks sent: %" PRIu64 "\n", acks);
+    if (servicePid > 0 && serviceCpuStart >= 0) {
+        printf("sensorservice (pid %d) cpu: %.1f%%\n", servicePid,
+                100.0 * serviceCpu / elapsed);
+    }
+    printf("clients cpu: %.1f%%\n", 100.0 * selfCpu / elapsed);
+
+    for (int c = 0; c < numClients; c++) {
+        looper->removeFd(clients[c]->queue->getFd());
+        delete clients[c];
+    }
+    return 0;
+}
@@ -6,15 +6,25 @@ LOCAL_CLANG := true
 LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
 LOCAL_SRC_FILES:= \
     Client.cpp \
+    CompositionCache.cpp \
+    CompositionThread.cpp \
+    CompositionTimeline.cpp \
+    DeadlineTracker.cpp \
     DisplayDevice.cpp \
     DispSync.cpp \
     EventControlThread.cpp \
     EventThread.cpp \
+    FrameStreamer.cpp \
     FrameTracker.cpp \
+    HWVsyncThread.cpp \
     Layer.cpp \
     LayerDim.cpp \
     MessageQueue.cpp \
     MonitoredProducer.cpp \
+    PrelatchThread.cpp \
+    RefreshRatePolicy.cpp \
+    StartupThread.cpp \
+    StateSnapshot.cpp \
     SurfaceFlinger.cpp \
     SurfaceFlingerConsumer.cpp \
     Transform.cpp \
@@ -98,7 +108,8 @@ LOCAL_SHARED_LIBRARIES := \
 	libbinder \
 	libui \
 	libgui \
-	libpowermanager
+	libpowermanager \
+	libz
 
 LOCAL_MODULE:= libsurfaceflinger
 
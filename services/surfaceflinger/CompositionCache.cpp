@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <utils/Errors.h>
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+#include <ui/GraphicBuffer.h>
+#include <ui/Region.h>
+
+#include "CompositionCache.h"
+#include "DisplayDevice.h"
+#include "Layer.h"
+#include "SurfaceFlinger.h"
+#include "Transform.h"
+#include "RenderEngine/Mesh.h"
+#include "RenderEngine/RenderEngine.h"
+#include "RenderEngine/Texture.h"
+
+namespace android {
+
+CompositionCache::CompositionCache(const sp<SurfaceFlinger>& flinger,
+        EGLDisplay display) :
+        mFlinger(flinger),
+        mDisplay(display),
+        mImage(EGL_NO_IMAGE_KHR),
+        mTexName(0),
+        mOrientation(0) {
+}
+
+CompositionCache::~CompositionCache() {
+    release();
+}
+
+size_t CompositionCache::update(const sp<const DisplayDevice>& hw,
+        size_t count) {
+    const Vector< sp<Layer> >& layers(hw->getVisibleLayersSortedByZ());
+    Vector<Entry> current;
+    for (size_t i=0 ; i<count && i<layers.size() ; i++) {
+        const sp<Layer>& layer(layers[i]);
+        // protected layers must never end up in a buffer we can read, and
+        // what a layer without a buffer draws depends on the layers below
+        if (layer->isProtected() || layer->getActiveBuffer() == NULL) {
+            break;
+        }
+        Entry entry;
+        entry.layer = layer->sequence;
+        entry.drawSequence = layer->getDrawSequence();
+        entry.visibleRegion = layer->visibleRegion;
+        current.add(entry);
+    }
+
+    if (!isSameDisplay(hw)) {
+        mCached.clear();
+        mLastFrame.clear();
+        mOrientation = hw->getOrientation();
+        mViewport = hw->getViewport();
+        mFrame = hw->getFrame();
+    }
+
+    // the layers that were already there, unchanged, on the last frame
+    const size_t stable = commonPrefix(current, mLastFrame);
+    mLastFrame = current;
+
+    const size_t cached = mCached.size();
+    if (cached && commonPrefix(current, mCached) == cached &&
+            stable <= cached) {
+        return cached;
+    }
+
+    if (stable < MIN_CACHED_LAYERS || !render(hw, stable)) {
+        release();
+        return 0;
+    }
+    mCached.clear();
+    mCached.appendArray(current.array(), stable);
+    return stable;
+}
+
+void CompositionCache::draw(const sp<const DisplayDevice>& hw) const {
+    RenderEngine& engine(mFlinger->getRenderEngine());
+    const float w = hw->getWidth();
+    const float h = hw->getHeight();
+
+    // the buffer was rendered with the display's own viewport and
+    // projection, so it maps one to one onto the framebuffer
+    Mesh mesh(Mesh::TRIANGLE_FAN, 4, 2, 2);
+    Mesh::VertexArray<vec2> position(mesh.getPositionArray<vec2>());
+    position[0] = vec2(0, 0);
+    position[1] = vec2(0, h);
+    position[2] = vec2(w, h);
+    position[3] = vec2(w, 0);
+    Mesh::VertexArray<vec2> texCoords(mesh.getTexCoordArray<vec2>());
+    texCoords[0] = vec2(0, 0);
+    texCoords[1] = vec2(0, 1);
+    texCoords[2] = vec2(1, 1);
+    texCoords[3] = vec2(1, 0);
+
+    Texture texture(Texture::TEXTURE_2D, mTexName);
+    texture.setDimensions(hw->getWidth(), hw->getHeight());
+    engine.setupLayerTexturing(texture);
+
+    // the layers were composed over transparent black, which is also what
+    // the framebuffer is cleared to, so blending them over it is exact
+    engine.setupLayerBlending(true, false, 0xFF);
+    engine.drawMesh(mesh);
+    engine.disableBlending();
+    engine.disableTexturing();
+}
+
+size_t CompositionCache::commonPrefix(const Vector<Entry>& a,
+        const Vector<Entry>& b) {
+    size_t i = 0;
+    while (i < a.size() && i < b.size() &&
+            a[i].layer == b[i].layer &&
+            a[i].drawSequence == b[i].drawSequence &&
+            isSameRegion(a[i].visibleRegion, b[i].visibleRegion)) {
+        i++;
+    }
+    return i;
+}
+
+bool CompositionCache::isSameRegion(const Region& a, const Region& b) {
+    size_t countA, countB;
+    const Rect* rectsA = a.getArray(&countA);
+    const Rect* rectsB = b.getArray(&countB);
+    if (countA != countB) {
+        return false;
+    }
+    for (size_t i=0 ; i<countA ; i++) {
+        if (rectsA[i] != rectsB[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CompositionCache::isSameDisplay(const sp<const DisplayDevice>& hw) const {
+    return mOrientation == hw->getOrientation() &&
+            mViewport == hw->getViewport() &&
+            mFrame == hw->getFrame();
+}
+
+bool CompositionCache::render(const sp<const DisplayDevice>& hw,
+        size_t count) {
+    ATRACE_CALL();
+    RenderEngine& engine(mFlinger->getRenderEngine());
+    const uint32_t w = hw->getWidth();
+    const uint32_t h = hw->getHeight();
+
+    if (mBuffer == NULL || mBuffer->getWidth() != w ||
+            mBuffer->getHeight() != h) {
+        release();
+        sp<GraphicBuffer> buffer(new GraphicBuffer(w, h,
+                PIXEL_FORMAT_RGBA_8888,
+                GraphicBuffer::USAGE_HW_RENDER |
+                GraphicBuffer::USAGE_HW_TEXTURE));
+        if (buffer->initCheck() != NO_ERROR) {
+            ALOGE("CompositionCache: failed to allocate a %ux%u buffer", w, h);
+            return false;
+        }
+        mImage = eglCreateImageKHR(mDisplay, EGL_NO_CONTEXT,
+                EGL_NATIVE_BUFFER_ANDROID,
+                static_cast<EGLClientBuffer>(buffer->getNativeBuffer()), NULL);
+        if (mImage == EGL_NO_IMAGE_KHR) {
+            ALOGE("CompositionCache: eglCreateImageKHR failed (%#x)",
+                    eglGetError());
+            return false;
+        }
+        mBuffer = buffer;
+        engine.genTextures(1, &mTexName);
+        engine.bindImageAsTexture(mImage, mTexName);
+    }
+
+    // this binds the buffer as the framebuffer for the duration of this
+    // scope
+    RenderEngine::BindImageAsFramebuffer imageBond(engine, mImage, false, w, h);
+    if (imageBond.getStatus() != NO_ERROR) {
+        return false;
+    }
+
+    engine.clearWithColor(0, 0, 0, 0);
+    const Vector< sp<Layer> >& layers(hw->getVisibleLayersSortedByZ());
+    const Transform& tr(hw->getTransform());
+    for (size_t i=0 ; i<count ; i++) {
+        const sp<Layer>& layer(layers[i]);
+        layer->draw(hw, tr.transform(layer->visibleRegion));
+    }
+    return true;
+}
+
+void CompositionCache::release() {
+    if (mTexName) {
+        // this may run without a current context
+        mFlinger->deleteTextureAsync(mTexName);
+        mTexName = 0;
+    }
+    if (mImage != EGL_NO_IMAGE_KHR) {
+        mFlinger->destroyImageAsync(mImage);
+        mImage = EGL_NO_IMAGE_KHR;
+    }
+    mFlinger->releaseBufferAsync(mBuffer);
+    mBuffer.clear();
+    mCached.clear();
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_COMPOSITIONCACHE_H
+#define ANDROID_COMPOSITIONCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+#include <utils/RefBase.h>
+#include <utils/StrongPointer.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class DisplayDevice;
+class GraphicBuffer;
+class Layer;
+class SurfaceFlinger;
+
+/*
+ * CompositionCache keeps the GLES composition of the bottom of a display's
+ * layer stack in an offscreen buffer, so that layers which don't change
+ * from frame to frame (a wallpaper and the icons above it, say) are drawn
+ * once instead of on every frame something above them animates.
+ *
+ * Layers only get cached once they have been composed unchanged on two
+ * consecutive frames, and the cache is dropped as soon as one of them
+ * changes. A layer is drawn clipped to its visible region, so a layer
+ * whose visible region changes has changed too.
+ */
+class CompositionCache : public LightRefBase<CompositionCache> {
+public:
+    CompositionCache(const sp<SurfaceFlinger>& flinger, EGLDisplay display);
+    ~CompositionCache();
+
+    // Called with the display's surface current and no scissor set, before
+    // anything is drawn. 'count' is the number of layers at the bottom of
+    // the display's layer stack that are composed with GLES. Returns how
+    // many of them the cache covers; those must be drawn with draw()
+    // instead of individually.
+    size_t update(const sp<const DisplayDevice>& hw, size_t count);
+
+    // draw the cached layers
+    void draw(const sp<const DisplayDevice>& hw) const;
+
+private:
+    enum {
+        // caching a single layer saves nothing
+        MIN_CACHED_LAYERS = 2,
+    };
+
+    struct Entry {
+        int32_t layer;          // Layer::sequence
+        uint32_t drawSequence;  // Layer::getDrawSequence()
+        Region visibleRegion;   // Layer::visibleRegion, which draws clip to
+    };
+
+    static bool isSameRegion(const Region& a, const Region& b);
+    static size_t commonPrefix(const Vector<Entry>& a,
+            const Vector<Entry>& b);
+
+    bool isSameDisplay(const sp<const DisplayDevice>& hw) const;
+    bool render(const sp<const DisplayDevice>& hw, size_t count);
+    void release();
+
+    sp<SurfaceFlinger> mFlinger;
+    EGLDisplay mDisplay;
+
+    sp<GraphicBuffer> mBuffer;
+    EGLImageKHR mImage;
+    uint32_t mTexName;
+
+    // the layers in mBuffer, and the ones composed with GLES last frame
+    Vector<Entry> mCached;
+    Vector<Entry> mLastFrame;
+
+    // display configuration the cache was rendered for
+    int mOrientation;
+    Rect mViewport;
+    Rect mFrame;
+};
+
+}
+
+#endif // ANDROID_COMPOSITIONCACHE_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <utils/Trace.h>
+
+#include <EGL/egl.h>
+
+#include "CompositionThread.h"
+#include "DisplayDevice.h"
+#include "SurfaceFlinger.h"
+#include "RenderEngine/RenderEngine.h"
+
+namespace android {
+
+CompositionThread::CompositionThread(const sp<SurfaceFlinger>& flinger,
+        RenderEngine* engine) :
+        mFlinger(flinger),
+        mEngine(engine),
+        mRepaintEverything(false),
+        mBusy(false) {
+}
+
+void CompositionThread::compose(const sp<DisplayDevice>& hw,
+        bool repaintEverything) {
+    Mutex::Autolock lock(mMutex);
+    mPending.add(hw);
+    mRepaintEverything = repaintEverything;
+    mCondition.broadcast();
+}
+
+void CompositionThread::waitForCompletion() {
+    ATRACE_CALL();
+    Mutex::Autolock lock(mMutex);
+    while (mBusy || !mPending.isEmpty()) {
+        mCondition.wait(mMutex);
+    }
+}
+
+status_t CompositionThread::readyToRun() {
+    mFlinger->setCurrentThreadRenderEngine(mEngine);
+    return NO_ERROR;
+}
+
+bool CompositionThread::threadLoop() {
+    sp<DisplayDevice> hw;
+    bool repaintEverything;
+    {
+        Mutex::Autolock lock(mMutex);
+        while (mPending.isEmpty()) {
+            mCondition.wait(mMutex);
+        }
+        hw = mPending[0];
+        mPending.removeAt(0);
+        repaintEverything = mRepaintEverything;
+        mBusy = true;
+    }
+
+    mFlinger->composeDisplay(hw, repaintEverything);
+
+    // release the display's surface so that the main thread (or another
+    // composition thread) may make it current for the next frame
+    eglMakeCurrent(mFlinger->mEGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+            EGL_NO_CONTEXT);
+
+    Mutex::Autolock lock(mMutex);
+    mBusy = false;
+    mCondition.broadcast();
+    return true;
+}
+
+} // namespace android
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_COMPOSITIONTHREAD_H
+#define ANDROID_COMPOSITIONTHREAD_H
+
+#include <stddef.h>
+
+#include <utils/Mutex.h>
+#include <utils/Condition.h>
+#include <utils/Thread.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class DisplayDevice;
+class RenderEngine;
+class SurfaceFlinger;
+
+/*
+ * CompositionThread composes displays on behalf of the SurfaceFlinger main
+ * thread. Each thread owns a RenderEngine whose EGLContext shares its
+ * objects (layer textures in particular) with the main RenderEngine.
+ *
+ * The main thread queues displays with compose() and must call
+ * waitForCompletion() before touching any of them again.
+ */
+class CompositionThread : public Thread {
+public:
+    CompositionThread(const sp<SurfaceFlinger>& flinger, RenderEngine* engine);
+    virtual ~CompositionThread() {}
+
+    // queue a display for composition on this thread
+    void compose(const sp<DisplayDevice>& hw, bool repaintEverything);
+
+    // block until all the displays queued with compose() are composed
+    void waitForCompletion();
+
+private:
+    virtual status_t readyToRun();
+    virtual bool threadLoop();
+
+    sp<SurfaceFlinger> mFlinger;
+    RenderEngine* const mEngine;
+
+    mutable Mutex mMutex;
+    Condition mCondition;
+    Vector< sp<DisplayDevice> > mPending;
+    bool mRepaintEverything;
+    bool mBusy;
+};
+
+}
+
+#endif // ANDROID_COMPOSITIONTHREAD_H
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+
+#include <utils/String8.h>
+
+#include "CompositionTimeline.h"
+
+namespace android {
+
+CompositionTimeline::CompositionTimeline() :
+        mCount(0),
+        mNext(0) {
+}
+
+void CompositionTimeline::add(const CompositionTiming& timing) {
+    Mutex::Autolock lock(mMutex);
+    mTimings[mNext] = timing;
+    mNext = (mNext + 1) % NUM_FRAMES;
+    if (mCount < NUM_FRAMES) {
+        mCount++;
+    }
+}
+
+void CompositionTimeline::getTimings(
+        Vector<CompositionTiming>* outTimings) const {
+    Mutex::Autolock lock(mMutex);
+    outTimings->clear();
+    outTimings->setCapacity(mCount);
+    for (size_t i=0 ; i<mCount ; i++) {
+        outTimings->add(mTimings[(mNext + NUM_FRAMES - mCount + i) % NUM_FRAMES]);
+    }
+}
+
+void CompositionTimeline::dump(String8& result) const {
+    Vector<CompositionTiming> timings;
+    getTimings(&timings);
+    result.append("refresh_ns pre rebuild setup compose post "
+            "displays layers gles overlay\n");
+    for (size_t i=0 ; i<timings.size() ; i++) {
+        const CompositionTiming& t(timings[i]);
+        result.appendFormat("%" PRId64 " %" PRId64 " %" PRId64 " %" PRId64
+                " %" PRId64 " %" PRId64 " %u %u %u %u\n",
+                t.refreshTime,
+                ns2us(t.preComposition), ns2us(t.rebuildLayerStacks),
+                ns2us(t.setUpHWComposer), ns2us(t.doComposition),
+                ns2us(t.postComposition), t.displayCount, t.layerCount,
+                t.glesLayerCount, t.overlayLayerCount);
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_COMPOSITIONTIMELINE_H
+#define ANDROID_COMPOSITIONTIMELINE_H
+
+#include <stddef.h>
+
+#include <ui/CompositionTiming.h>
+
+#include <utils/Mutex.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class String8;
+
+/*
+ * CompositionTimeline remembers the CompositionTiming of the last
+ * NUM_FRAMES refreshes, so that they can be looked at after a jank report
+ * without tracing having been enabled.
+ *
+ * The main thread adds to it; it can be read from any thread.
+ */
+class CompositionTimeline {
+public:
+    enum { NUM_FRAMES = 256 };
+
+    CompositionTimeline();
+
+    void add(const CompositionTiming& timing);
+
+    // returns the recorded refreshes, oldest first
+    void getTimings(Vector<CompositionTiming>* outTimings) const;
+
+    // one line per refresh, durations in microseconds
+    void dump(String8& result) const;
+
+private:
+    mutable Mutex mMutex;
+    CompositionTiming mTimings[NUM_FRAMES];
+    size_t mCount;
+    size_t mNext;
+};
+
+}
+
+#endif // ANDROID_COMPOSITIONTIMELINE_H
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+
+#include <utils/String8.h>
+
+#include "DeadlineTracker.h"
+
+namespace android {
+
+DeadlineTracker::DeadlineTracker() :
+        mInFrame(false),
+        mStart(0),
+        mDeadline(0),
+        mFrameCount(0),
+        mLateStartCount(0),
+        mOverrunCount(0),
+        mMaxStartDelay(0),
+        mMaxOverrun(0),
+        mTotalFrameTime(0) {
+}
+
+bool DeadlineTracker::onFrameStart(nsecs_t now, nsecs_t scheduled,
+        nsecs_t deadline) {
+    mInFrame = true;
+    mStart = now;
+    mDeadline = deadline;
+    if (scheduled <= 0) {
+        return false;
+    }
+    const nsecs_t delay = now - scheduled;
+    if (delay > mMaxStartDelay) {
+        mMaxStartDelay = delay;
+    }
+    if (delay > LATE_START_THRESHOLD) {
+        mLateStartCount++;
+        return true;
+    }
+    return false;
+}
+
+nsecs_t DeadlineTracker::onFrameEnd(nsecs_t now) {
+    if (!mInFrame) {
+        return 0;
+    }
+    mInFrame = false;
+    mFrameCount++;
+    mTotalFrameTime += now - mStart;
+    if (mDeadline <= 0 || now <= mDeadline) {
+        return 0;
+    }
+    const nsecs_t overrun = now - mDeadline;
+    if (overrun > mMaxOverrun) {
+        mMaxOverrun = overrun;
+    }
+    mOverrunCount++;
+    return overrun;
+}
+
+void DeadlineTracker::dump(String8& result) const {
+    result.appendFormat("  %u frames, %u late starts (max delay %.2f ms), "
+            "%u overruns (max %.2f ms), average frame time %.2f ms\n",
+            mFrameCount, mLateStartCount, mMaxStartDelay / 1e6,
+            mOverrunCount, mMaxOverrun / 1e6,
+            mFrameCount ? mTotalFrameTime / 1e6 / mFrameCount : 0.0);
+}
+
+}
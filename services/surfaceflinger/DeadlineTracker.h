@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_DEADLINETRACKER_H
+#define ANDROID_DEADLINETRACKER_H
+
+#include <stdint.h>
+
+#include <utils/Timers.h>
+
+namespace android {
+
+class String8;
+
+/*
+ * DeadlineTracker keeps statistics about when SurfaceFlinger's frames start
+ * and end, relative to when they were scheduled to start and to the refresh
+ * they must be composed by.
+ *
+ * A frame starts late when it's handled more than LATE_START_THRESHOLD after
+ * it was scheduled, e.g. because the main thread was busy or preempted. It
+ * overruns when composition isn't done by its deadline, in which case it's
+ * most likely presented one refresh late.
+ *
+ * It is only used from the main thread.
+ */
+class DeadlineTracker {
+public:
+    enum {
+        LATE_START_THRESHOLD = 2000000, // 2ms
+    };
+
+    DeadlineTracker();
+
+    // A frame started at 'now'. 'scheduled' is when it was meant to start,
+    // 0 if unknown, and 'deadline' when it must be done by, 0 if unknown.
+    // Returns whether it started late.
+    bool onFrameStart(nsecs_t now, nsecs_t scheduled, nsecs_t deadline);
+
+    // The frame started last is done. Returns by how much it overran its
+    // deadline, 0 if it didn't.
+    nsecs_t onFrameEnd(nsecs_t now);
+
+    void dump(String8& result) const;
+
+private:
+    bool mInFrame;
+    nsecs_t mStart;
+    nsecs_t mDeadline;
+
+    uint32_t mFrameCount;
+    uint32_t mLateStartCount;
+    uint32_t mOverrunCount;
+    nsecs_t mMaxStartDelay;
+    nsecs_t mMaxOverrun;
+    nsecs_t mTotalFrameTime;
+};
+
+}
+
+#endif // ANDROID_DEADLINETRACKER_H
@@ -20,6 +20,8 @@
 #define __STDC_LIMIT_MACROS
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <cutils/log.h>
 
@@ -49,6 +51,22 @@ static const nsecs_t kErrorThreshold = 160000000000;    // 400 usec squared
 // vsync event.
 static const int64_t kPresentTimeOffset = PRESENT_TIME_OFFSET_FROM_VSYNC_NS;
 
+// Resync samples further than this from the fitted model are considered
+// outliers (typically a late vsync interrupt) and left out of the fit.
+static const nsecs_t kOutlierThreshold = 500000;        // 500 usec
+
+// Each resync sample weighs this much less in the fit than the next one, so
+// that the model follows the current rate of a drifting display clock.
+static const double kSampleWeightDecay = 0.9;
+
+// The model's phase is corrected when the present times are on average
+// further than this from it, but still within kErrorThreshold.
+static const nsecs_t kDriftCorrectionThreshold = 50000;  // 50 usec
+
+// Width of the first bucket of the model error histogram; each following
+// bucket is twice as wide.
+static const nsecs_t kErrorBucketWidth = 100000;        // 100 usec
+
 class DispSyncThread: public Thread {
 public:
 
@@ -289,7 +307,15 @@ private:
 
 DispSync::DispSync() :
         mRefreshSkipCount(0),
+        mResyncing(false),
+        mResyncStartTime(0),
+        mResyncTotalTime(0),
+        mStatsStartTime(systemTime(SYSTEM_TIME_MONOTONIC)),
+        mResyncCount(0),
+        mRejectedResyncSamples(0),
+        mDriftCorrections(0),
         mThread(new DispSyncThread()) {
+    memset(mErrorHistogram, 0, sizeof(mErrorHistogram));
 
     mThread->run("DispSync", PRIORITY_URGENT_DISPLAY + PRIORITY_MORE_FAVORABLE);
 
@@ -327,6 +353,7 @@ bool DispSync::addPresentFence(const sp<Fence>& fence) {
     mPresentSampleOffset = (mPresentSampleOffset + 1) % NUM_PRESENT_SAMPLES;
     mNumResyncSamplesSincePresent = 0;
 
+    const nsecs_t period = mPeriod / (1 + mRefreshSkipCount);
     for (size_t i = 0; i < NUM_PRESENT_SAMPLES; i++) {
         const sp<Fence>& f(mPresentFences[i]);
         if (f != NULL) {
@@ -334,11 +361,25 @@ bool DispSync::addPresentFence(const sp<Fence>& fence) {
             if (t < INT64_MAX) {
                 mPresentFences[i].clear();
                 mPresentTimes[i] = t + kPresentTimeOffset;
+
+                if (period > 0 && mPresentTimes[i] > mPhase) {
+                    nsecs_t err = computeSampleErrorLocked(mPresentTimes[i],
+                            period);
+                    size_t bucket = 0;
+                    while (bucket < NUM_ERROR_BUCKETS - 1 &&
+                            llabs(err) >= (kErrorBucketWidth << bucket)) {
+                        bucket++;
+                    }
+                    mErrorHistogram[bucket]++;
+                }
             }
         }
     }
 
     updateErrorLocked();
+    if (mPeriod != 0 && mError <= kErrorThreshold) {
+        trackDriftLocked();
+    }
 
     return mPeriod == 0 || mError > kErrorThreshold;
 }
@@ -347,6 +388,11 @@ void DispSync::beginResync() {
     Mutex::Autolock lock(mMutex);
 
     mNumResyncSamples = 0;
+    if (!mResyncing) {
+        mResyncing = true;
+        mResyncStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        mResyncCount++;
+    }
 }
 
 bool DispSync::addResyncSample(nsecs_t timestamp) {
@@ -380,6 +426,12 @@ bool DispSync::addResyncSample(nsecs_t timestamp) {
 }
 
 void DispSync::endResync() {
+    Mutex::Autolock lock(mMutex);
+
+    if (mResyncing) {
+        mResyncing = false;
+        mResyncTotalTime += systemTime(SYSTEM_TIME_MONOTONIC) - mResyncStartTime;
+    }
 }
 
 status_t DispSync::addEventListener(nsecs_t phase,
@@ -423,27 +475,15 @@ void DispSync::updateModelLocked() {
             durationSum += mResyncSamples[idx] - mResyncSamples[prev];
         }
 
-        mPeriod = durationSum / (mNumResyncSamples - 1);
-
-        double sampleAvgX = 0;
-        double sampleAvgY = 0;
-        double scale = 2.0 * M_PI / double(mPeriod);
-        for (size_t i = 0; i < mNumResyncSamples; i++) {
-            size_t idx = (mFirstResyncSample + i) % MAX_RESYNC_SAMPLES;
-            nsecs_t sample = mResyncSamples[idx];
-            double samplePhase = double(sample % mPeriod) * scale;
-            sampleAvgX += cos(samplePhase);
-            sampleAvgY += sin(samplePhase);
-        }
-
-        sampleAvgX /= double(mNumResyncSamples);
-        sampleAvgY /= double(mNumResyncSamples);
-
-        mPhase = nsecs_t(atan2(sampleAvgY, sampleAvgX) / scale);
-
-        if (mPhase < 0) {
-            mPhase += mPeriod;
+        // the mean interval is only a first estimate, which tells the fit
+        // which vsync each sample belongs to
+        nsecs_t period = durationSum / (mNumResyncSamples - 1);
+        nsecs_t phase;
+        if (period <= 0 || !fitModelLocked(period, &period, &phase)) {
+            return;
         }
+        mPeriod = period;
+        mPhase = phase;
 
         if (kTraceDetailedInfo) {
             ATRACE_INT64("DispSync:Period", mPeriod);
@@ -457,6 +497,82 @@ void DispSync::updateModelLocked() {
     }
 }
 
+bool DispSync::fitModelLocked(nsecs_t periodEstimate, nsecs_t* outPeriod,
+        nsecs_t* outPhase) {
+    // Fit sample = base + vsync * period, with the samples relative to the
+    // first one so that the doubles keep nanosecond precision.
+    const nsecs_t base = mResyncSamples[mFirstResyncSample];
+    double vsyncs[MAX_RESYNC_SAMPLES];
+    double times[MAX_RESYNC_SAMPLES];
+    double weights[MAX_RESYNC_SAMPLES];
+    double weight = 1.0;
+    for (size_t i = mNumResyncSamples; i-- > 0; ) {
+        size_t idx = (mFirstResyncSample + i) % MAX_RESYNC_SAMPLES;
+        nsecs_t offset = mResyncSamples[idx] - base;
+        vsyncs[i] = double((offset + periodEstimate / 2) / periodEstimate);
+        times[i] = double(offset);
+        weights[i] = weight;
+        weight *= kSampleWeightDecay;
+    }
+
+    double intercept = 0;
+    double slope = double(periodEstimate);
+    // the second pass leaves out the outliers of the first
+    for (int pass = 0; pass < 2; pass++) {
+        double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+        size_t used = 0;
+        for (size_t i = 0; i < mNumResyncSamples; i++) {
+            const double w = weights[i];
+            if (w == 0) {
+                continue;
+            }
+            sw += w;
+            sx += w * vsyncs[i];
+            sy += w * times[i];
+            sxx += w * vsyncs[i] * vsyncs[i];
+            sxy += w * vsyncs[i] * times[i];
+            used++;
+        }
+        const double det = sw * sxx - sx * sx;
+        if (used < MIN_RESYNC_SAMPLES_FOR_UPDATE || det <= 0) {
+            return false;
+        }
+        slope = (sw * sxy - sx * sy) / det;
+        intercept = (sy - slope * sx) / sw;
+
+        if (pass == 0) {
+            for (size_t i = 0; i < mNumResyncSamples; i++) {
+                double residual = times[i] - (intercept + slope * vsyncs[i]);
+                if (fabs(residual) > double(kOutlierThreshold)) {
+                    weights[i] = 0;
+                    mRejectedResyncSamples++;
+                }
+            }
+        }
+    }
+
+    const nsecs_t period = nsecs_t(slope + 0.5);
+    if (period <= 0) {
+        return false;
+    }
+    nsecs_t phase = (base + nsecs_t(intercept)) % period;
+    if (phase < 0) {
+        phase += period;
+    }
+    *outPeriod = period;
+    *outPhase = phase;
+    return true;
+}
+
+nsecs_t DispSync::computeSampleErrorLocked(nsecs_t sample,
+        nsecs_t period) const {
+    nsecs_t sampleErr = (sample - mPhase) % period;
+    if (sampleErr > period / 2) {
+        sampleErr -= period;
+    }
+    return sampleErr;
+}
+
 void DispSync::updateErrorLocked() {
     if (mPeriod == 0) {
         return;
@@ -472,10 +588,7 @@ void DispSync::updateErrorLocked() {
     for (size_t i = 0; i < NUM_PRESENT_SAMPLES; i++) {
         nsecs_t sample = mPresentTimes[i];
         if (sample > mPhase) {
-            nsecs_t sampleErr = (sample - mPhase) % period;
-            if (sampleErr > period / 2) {
-                sampleErr -= period;
-            }
+            nsecs_t sampleErr = computeSampleErrorLocked(sample, period);
             sqErrSum += sampleErr * sampleErr;
             numErrSamples++;
         }
@@ -492,6 +605,38 @@ void DispSync::updateErrorLocked() {
     }
 }
 
+void DispSync::trackDriftLocked() {
+    nsecs_t period = mPeriod / (1 + mRefreshSkipCount);
+
+    int numErrSamples = 0;
+    nsecs_t errSum = 0;
+    for (size_t i = 0; i < NUM_PRESENT_SAMPLES; i++) {
+        nsecs_t sample = mPresentTimes[i];
+        if (sample > mPhase) {
+            errSum += computeSampleErrorLocked(sample, period);
+            numErrSamples++;
+        }
+    }
+
+    // only correct what all the recent present times agree on
+    if (numErrSamples < NUM_PRESENT_SAMPLES) {
+        return;
+    }
+    nsecs_t meanErr = errSum / numErrSamples;
+    if (llabs(meanErr) < kDriftCorrectionThreshold) {
+        return;
+    }
+
+    mPhase = (mPhase + meanErr + mPeriod) % mPeriod;
+    mDriftCorrections++;
+    mThread->updateModel(mPeriod, mPhase);
+    updateErrorLocked();
+
+    if (kTraceDetailedInfo) {
+        ATRACE_INT64("DispSync:Phase", mPhase);
+    }
+}
+
 void DispSync::resetErrorLocked() {
     mPresentSampleOffset = 0;
     mError = 0;
@@ -521,6 +666,26 @@ void DispSync::dump(String8& result) const {
     result.appendFormat("mNumResyncSamples: %zd (max %d)\n",
             mNumResyncSamples, MAX_RESYNC_SAMPLES);
 
+    const nsecs_t statsNow = systemTime(SYSTEM_TIME_MONOTONIC);
+    const nsecs_t resyncTime = mResyncTotalTime +
+            (mResyncing ? statsNow - mResyncStartTime : 0);
+    const nsecs_t statsTime = statsNow - mStatsStartTime;
+    result.appendFormat("hw vsync enabled: %.3f s of %.3f s (%.1f%%), "
+            "%u resyncs\n", resyncTime / 1e9, statsTime / 1e9,
+            statsTime ? 100.0 * resyncTime / statsTime : 0.0, mResyncCount);
+    result.appendFormat("rejected resync samples: %u, drift corrections: %u\n",
+            mRejectedResyncSamples, mDriftCorrections);
+    result.appendFormat("present time error histogram:");
+    for (size_t i = 0; i < NUM_ERROR_BUCKETS; i++) {
+        if (i < NUM_ERROR_BUCKETS - 1) {
+            result.appendFormat(" <%" PRId64 "us: %u",
+                    (kErrorBucketWidth << i) / 1000, mErrorHistogram[i]);
+        } else {
+            result.appendFormat(" more: %u", mErrorHistogram[i]);
+        }
+    }
+    result.appendFormat("\n");
+
     result.appendFormat("mResyncSamples:\n");
     nsecs_t previous = -1;
     for (size_t i = 0; i < mNumResyncSamples; i++) {
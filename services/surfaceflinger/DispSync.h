@@ -136,10 +136,27 @@ private:
     void updateErrorLocked();
     void resetErrorLocked();
 
+    // fitModelLocked computes the period and phase of the resync samples by
+    // weighted least squares, weighting recent samples more so that the
+    // model follows a drifting clock, and ignoring outliers (e.g. late
+    // vsync interrupts). It returns false if too few samples are left.
+    bool fitModelLocked(nsecs_t periodEstimate, nsecs_t* outPeriod,
+            nsecs_t* outPhase);
+
+    // computeSampleErrorLocked returns the signed difference between a
+    // present time and the nearest vsync of the model.
+    nsecs_t computeSampleErrorLocked(nsecs_t sample, nsecs_t period) const;
+
+    // trackDriftLocked moves the model's phase by the mean error of the
+    // present times, so that a slowly drifting model doesn't have to be
+    // resynchronized with hardware vsync events when it could be corrected.
+    void trackDriftLocked();
+
     enum { MAX_RESYNC_SAMPLES = 32 };
     enum { MIN_RESYNC_SAMPLES_FOR_UPDATE = 3 };
     enum { NUM_PRESENT_SAMPLES = 8 };
     enum { MAX_RESYNC_SAMPLES_WITHOUT_PRESENT = 12 };
+    enum { NUM_ERROR_BUCKETS = 6 };
 
     // mPeriod is the computed period of the modeled vsync events in
     // nanoseconds.
@@ -170,6 +187,19 @@ private:
 
     int mRefreshSkipCount;
 
+    // Statistics, reported by dump: how often and for how long hardware
+    // vsync events were needed, what the model fits rejected, and how far
+    // the present times were from the model. mErrorHistogram bucket i
+    // counts errors below 100us << i, the last bucket everything else.
+    bool mResyncing;
+    nsecs_t mResyncStartTime;
+    nsecs_t mResyncTotalTime;
+    nsecs_t mStatsStartTime;
+    uint32_t mResyncCount;
+    uint32_t mRejectedResyncSamples;
+    uint32_t mDriftCorrections;
+    uint32_t mErrorHistogram[NUM_ERROR_BUCKETS];
+
     // mThread is the thread from which all the callbacks are called.
     sp<DispSyncThread> mThread;
 
@@ -39,6 +39,7 @@
 #include "RenderEngine/RenderEngine.h"
 
 #include "clz.h"
+#include "CompositionCache.h"
 #include "DisplayDevice.h"
 #include "SurfaceFlinger.h"
 #include "Layer.h"
@@ -47,6 +48,21 @@
 using namespace android;
 // ----------------------------------------------------------------------------
 
+static bool hasEglExtension(EGLDisplay display, const char* name) {
+    const char* exts = eglQueryString(display, EGL_EXTENSIONS);
+    if (!exts) {
+        return false;
+    }
+    const size_t len = strlen(name);
+    for (const char* pos = exts; (pos = strstr(pos, name)) != NULL; pos += len) {
+        if ((pos == exts || pos[-1] == ' ') &&
+                (pos[len] == '\0' || pos[len] == ' ')) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*
  * Initialize the display to the specified values.
  *
@@ -74,6 +90,8 @@ DisplayDevice::DisplayDevice(
       mPageFlipCount(),
       mIsSecure(isSecure),
       mSecureLayerVisible(false),
+      mHasBufferAge(false),
+      mDamageHistoryCount(0),
       mLayerStack(NO_LAYER_STACK),
       mHardwareOrientation(0),
       mOrientation(),
@@ -114,6 +132,7 @@ DisplayDevice::DisplayDevice(
     mConfig = config;
     mDisplay = display;
     mSurface = surface;
+    mHasBufferAge = hasEglExtension(display, "EGL_EXT_buffer_age");
     mFormat  = format;
     mPageFlipCount = 0;
     mViewport.makeInvalid();
@@ -148,6 +167,11 @@ DisplayDevice::DisplayDevice(
     property_get("persist.panel.orientation", property, "0");
     panelOrientation = atoi(property) / 90;
 
+    property_get("debug.sf.composition_cache", property, "0");
+    if (atoi(property)) {
+        mCompositionCache = new CompositionCache(flinger, display);
+    }
+
     // initialize the display orientation transform.
     setProjection(panelOrientation, mViewport, mFrame);
 }
@@ -247,7 +271,7 @@ status_t DisplayDevice::prepareFrame(const HWComposer& hwc) const {
     return mDisplaySurface->prepareFrame(compositionType);
 }
 
-void DisplayDevice::swapBuffers(HWComposer& hwc) const {
+void DisplayDevice::swapBuffers(HWComposer& hwc, const Region& damage) const {
     // We need to call eglSwapBuffers() if:
     //  (1) we don't have a hardware composer, or
     //  (2) we did GLES composition this frame, and either
@@ -271,6 +295,21 @@ void DisplayDevice::swapBuffers(HWComposer& hwc) const {
         }
     }
 
+    // Remember what changed in the buffer we just posted (or that
+    // HWComposer::commit() posts on legacy devices); a frame without GLES
+    // composition leaves every buffer behind, so forget everything then.
+    if (hwc.initCheck() != NO_ERROR || hwc.hasGlesComposition(mHwcDisplayId)) {
+        for (size_t i = DAMAGE_HISTORY_SIZE - 1; i > 0; i--) {
+            mDamageHistory[i] = mDamageHistory[i - 1];
+        }
+        mDamageHistory[0] = damage;
+        if (mDamageHistoryCount < DAMAGE_HISTORY_SIZE) {
+            mDamageHistoryCount++;
+        }
+    } else {
+        mDamageHistoryCount = 0;
+    }
+
     status_t result = mDisplaySurface->advanceFrame();
     if (result != NO_ERROR) {
         ALOGE("[%s] failed pushing new frame to HWC: %d",
@@ -278,6 +317,33 @@ void DisplayDevice::swapBuffers(HWComposer& hwc) const {
     }
 }
 
+Region DisplayDevice::getRepaintRegion(const Region& dirty) const {
+    EGLint age = 0;
+    if (!mHasBufferAge ||
+            !eglQuerySurface(mDisplay, mSurface, EGL_BUFFER_AGE_EXT, &age) ||
+            age <= 0 || size_t(age - 1) > mDamageHistoryCount) {
+        // the buffer's contents are unknown
+        return Region(bounds());
+    }
+    // the buffer missed the changes of the age - 1 frames that followed it
+    Region repaint(dirty);
+    for (EGLint i = 0; i < age - 1; i++) {
+        repaint.orSelf(mDamageHistory[i]);
+    }
+    return repaint;
+}
+
+void DisplayDevice::setGlesLayers(const Vector<const Layer*>& layers) const {
+    bool changed = layers.size() != mGlesLayers.size();
+    for (size_t i = 0; !changed && i < layers.size(); i++) {
+        changed = layers[i] != mGlesLayers[i];
+    }
+    if (changed) {
+        mGlesLayers = layers;
+        mDamageHistoryCount = 0;
+    }
+}
+
 void DisplayDevice::onSwapBuffersCompleted(HWComposer& hwc) const {
     if (hwc.initCheck() == NO_ERROR) {
         mDisplaySurface->onFrameCommitted();
@@ -434,6 +500,7 @@ status_t DisplayDevice::orientationToTransfrom(
 
 void DisplayDevice::setDisplaySize(const int newWidth, const int newHeight) {
     dirtyRegion.set(getBounds());
+    mDamageHistoryCount = 0;
 
     if (mSurface != EGL_NO_SURFACE) {
         eglDestroySurface(mDisplay, mSurface);
@@ -40,6 +40,7 @@ namespace android {
 class DisplayInfo;
 class DisplaySurface;
 class IGraphicBufferProducer;
+class CompositionCache;
 class Layer;
 class SurfaceFlinger;
 class HWComposer;
@@ -131,9 +132,28 @@ public:
     status_t beginFrame(bool mustRecompose) const;
     status_t prepareFrame(const HWComposer& hwc) const;
 
-    void swapBuffers(HWComposer& hwc) const;
+    // damage is what changed on the display since the previous frame; it
+    // is recorded in the damage history used by getRepaintRegion
+    void swapBuffers(HWComposer& hwc, const Region& damage) const;
     status_t compositionComplete() const;
 
+    // With EGL_EXT_buffer_age, returns what must be repainted for the buffer
+    // about to be drawn into to be up to date, knowing that dirty changed
+    // since the previous frame. That's the whole display without buffer age,
+    // or when the buffer is older than the damage history. The display's
+    // surface must be current.
+    bool hasBufferAge() const { return mHasBufferAge; }
+    Region getRepaintRegion(const Region& dirty) const;
+
+    // The damage history only holds as long as the same layers are composed
+    // with GLES: setting a different set of layers forgets it.
+    void setGlesLayers(const Vector<const Layer*>& layers) const;
+
+    // NULL unless debug.sf.composition_cache is set
+    const sp<CompositionCache>& getCompositionCache() const {
+        return mCompositionCache;
+    }
+
     // called after h/w composer has completed its set() call
     void onSwapBuffersCompleted(HWComposer& hwc) const;
 
@@ -208,6 +228,16 @@ private:
     // Whether we have a visible secure layer on this display
     bool mSecureLayerVisible;
 
+    /*
+     * Damage history, most recent frame first (see getRepaintRegion)
+     */
+    enum { DAMAGE_HISTORY_SIZE = 4 };
+    bool mHasBufferAge;
+    mutable Region mDamageHistory[DAMAGE_HISTORY_SIZE];
+    mutable size_t mDamageHistoryCount;
+    mutable Vector<const Layer*> mGlesLayers;
+    sp<CompositionCache> mCompositionCache;
+
 
     /*
      * Transaction state
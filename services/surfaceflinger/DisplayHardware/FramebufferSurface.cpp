@@ -21,6 +21,7 @@
 #include <errno.h>
 
 #include <cutils/log.h>
+#include <cutils/properties.h>
 
 #include <utils/String8.h>
 
@@ -50,6 +51,23 @@ namespace android {
  *
  */
 
+// With debug.sf.pipelined_composition set, the framebuffer target gets one
+// more buffer. GLES composition then renders into a buffer the panel stopped
+// scanning out a frame earlier, instead of the one it's about to stop using,
+// so the GPU work of a frame no longer waits on the commit of the previous
+// one. The cost is an extra framebuffer-sized allocation and up to a frame
+// of latency when the GPU is ahead. The FB HAL has a fixed set of buffers,
+// so this only applies with a framebuffer target.
+static int getFramebufferBufferCount(const HWComposer& hwc) {
+    int count = NUM_FRAMEBUFFER_SURFACE_BUFFERS;
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.sf.pipelined_composition", value, "0");
+    if (atoi(value) && hwc.supportsFramebufferTarget()) {
+        count++;
+    }
+    return count;
+}
+
 FramebufferSurface::FramebufferSurface(HWComposer& hwc, int disp,
         const sp<IGraphicBufferConsumer>& consumer) :
     ConsumerBase(consumer),
@@ -65,7 +83,7 @@ FramebufferSurface::FramebufferSurface(HWComposer& hwc, int disp,
                                        GRALLOC_USAGE_HW_COMPOSER);
     mConsumer->setDefaultBufferFormat(mHwc.getFormat(disp));
     mConsumer->setDefaultBufferSize(mHwc.getWidth(disp),  mHwc.getHeight(disp));
-    mConsumer->setDefaultMaxBufferCount(NUM_FRAMEBUFFER_SURFACE_BUFFERS);
+    mConsumer->setDefaultMaxBufferCount(getFramebufferBufferCount(hwc));
 }
 
 status_t FramebufferSurface::beginFrame(bool mustRecompose) {
@@ -442,6 +442,8 @@ status_t HWComposer::freeDisplayId(int32_t id) {
     }
     mAllocatedDisplayIDs.clearBit(id);
     mDisplayData[id].connected = false;
+    mDisplayData[id].lastGeometry.clear();
+    mDisplayData[id].lastCompositionTypes.clear();
     return NO_ERROR;
 }
 
@@ -631,6 +633,46 @@ status_t HWComposer::setFramebufferTarget(int32_t id,
     return NO_ERROR;
 }
 
+/*
+ * Serializes everything the HAL considers geometry in a work list: all the
+ * layer state except the buffer handles and fences.
+ */
+static void flattenGeometry(const hwc_display_contents_1_t* list,
+        Vector<uint32_t>* outGeometry) {
+    outGeometry->clear();
+    outGeometry->push(list->numHwLayers);
+    for (size_t i=0 ; i<list->numHwLayers ; i++) {
+        const hwc_layer_1_t& l(list->hwLayers[i]);
+        uint32_t crop[4];
+        memcpy(crop, &l.sourceCropf, sizeof(crop));
+        outGeometry->push(l.compositionType == HWC_SIDEBAND);
+        outGeometry->push(l.handle != 0);
+        outGeometry->push(l.flags);
+        outGeometry->push(l.transform);
+        outGeometry->push(l.blending);
+        outGeometry->push(l.planeAlpha);
+        outGeometry->appendArray(crop, 4);
+        outGeometry->push(l.displayFrame.left);
+        outGeometry->push(l.displayFrame.top);
+        outGeometry->push(l.displayFrame.right);
+        outGeometry->push(l.displayFrame.bottom);
+        outGeometry->push(l.visibleRegionScreen.numRects);
+        for (size_t j=0 ; j<l.visibleRegionScreen.numRects ; j++) {
+            const hwc_rect_t& r(l.visibleRegionScreen.rects[j]);
+            outGeometry->push(r.left);
+            outGeometry->push(r.top);
+            outGeometry->push(r.right);
+            outGeometry->push(r.bottom);
+        }
+    }
+}
+
+static bool isSameGeometry(const Vector<uint32_t>& a,
+        const Vector<uint32_t>& b) {
+    return a.size() == b.size() &&
+            !memcmp(a.array(), b.array(), a.size() * sizeof(uint32_t));
+}
+
 status_t HWComposer::prepare() {
     for (size_t i=0 ; i<mNumDisplays ; i++) {
         DisplayData& disp(mDisplayData[i]);
@@ -659,12 +701,45 @@ status_t HWComposer::prepare() {
                 mLists[i]->dpy = EGL_NO_DISPLAY;
                 mLists[i]->sur = EGL_NO_SURFACE;
             }
+            if (mLists[i]->flags & HWC_GEOMETRY_CHANGED) {
+                // SurfaceFlinger rebuilds every work list whenever anything
+                // might have changed. If this one came out identical to the
+                // last one, give the HAL back the composition types it chose
+                // then and let it take the cheaper, buffers-only path.
+                Vector<uint32_t> geometry;
+                flattenGeometry(mLists[i], &geometry);
+                if (isSameGeometry(geometry, disp.lastGeometry) &&
+                        disp.lastCompositionTypes.size() ==
+                                disp.list->numHwLayers) {
+                    for (size_t j=0 ; j<disp.list->numHwLayers ; j++) {
+                        hwc_layer_1_t& l = disp.list->hwLayers[j];
+                        if (l.compositionType == HWC_FRAMEBUFFER) {
+                            l.compositionType = disp.lastCompositionTypes[j];
+                        }
+                    }
+                    mLists[i]->flags &= ~HWC_GEOMETRY_CHANGED;
+                }
+                disp.lastGeometry = geometry;
+            }
         }
     }
 
     int err = mHwc->prepare(mHwc, mNumDisplays, mLists);
     ALOGE_IF(err, "HWComposer: prepare failed (%s)", strerror(-err));
 
+    for (size_t i=0 ; i<mNumDisplays ; i++) {
+        DisplayData& disp(mDisplayData[i]);
+        disp.lastCompositionTypes.clear();
+        if (err != NO_ERROR) {
+            disp.lastGeometry.clear();
+        } else if (disp.list) {
+            for (size_t j=0 ; j<disp.list->numHwLayers ; j++) {
+                disp.lastCompositionTypes.push(
+                        disp.list->hwLayers[j].compositionType);
+            }
+        }
+    }
+
     if (err == NO_ERROR) {
         // here we're just making sure that "skip" layers are set
         // to HWC_FRAMEBUFFER and we're also counting how many layers
@@ -813,6 +888,8 @@ void HWComposer::disconnectDisplay(int disp) {
     dd.lastRetireFence = Fence::NO_FENCE;
     dd.lastDisplayFence = Fence::NO_FENCE;
     dd.outbufAcquireFence = Fence::NO_FENCE;
+    dd.lastGeometry.clear();
+    dd.lastCompositionTypes.clear();
     // clear all the previous configs and repopulate when a new
     // device is added
     dd.configs.clear();
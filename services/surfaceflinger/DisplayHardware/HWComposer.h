@@ -341,6 +341,11 @@ private:
                                     // effect on screen
         buffer_handle_t outbufHandle;
         sp<Fence> outbufAcquireFence;
+        // geometry of the list given to the last successful prepare, and
+        // the composition types the HAL picked for its layers; used to
+        // detect work lists that were rebuilt without actually changing
+        Vector<uint32_t> lastGeometry;
+        Vector<int32_t> lastCompositionTypes;
 
         // protected by mEventControlLock
         int32_t events;
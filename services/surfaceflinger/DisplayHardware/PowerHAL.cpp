@@ -15,9 +15,11 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <sys/types.h>
 
 #include <cutils/log.h>
+#include <cutils/properties.h>
 #include <utils/Errors.h>
 
 #include <binder/IServiceManager.h>
@@ -29,8 +31,69 @@
 namespace android {
 // ---------------------------------------------------------------------------
 
+PowerHAL::PowerHAL() :
+        mCompositionHintId(0),
+        mCompositionLoad(0),
+        mPendingCompositionLoad(0),
+        mPendingCompositionFrames(0) {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.sf.composition_hint", value, "0");
+    mCompositionHintId = strtol(value, NULL, 0);
+}
+
 status_t PowerHAL::vsyncHint(bool enabled) {
     Mutex::Autolock _l(mlock);
+    return powerHintLocked(POWER_HINT_VSYNC, enabled ? 1 : 0);
+}
+
+bool PowerHAL::isCompositionHintEnabled() const {
+    return mCompositionHintId != 0;
+}
+
+status_t PowerHAL::compositionHint(uint32_t glesLayers,
+        uint32_t glesPixelsPercent, bool virtualDisplay) {
+    if (!isCompositionHintEnabled()) {
+        return INVALID_OPERATION;
+    }
+
+    uint32_t pixels = (glesPixelsPercent + 24) / 25 * 25;
+    if (pixels > 0xFFFF) {
+        pixels = 0xFFFF;
+    }
+    uint32_t layers = 0;
+    if (glesLayers) {
+        layers = 1;
+        while (layers < glesLayers && layers < 0x80) {
+            layers <<= 1;
+        }
+    }
+    const int32_t load = int32_t(pixels | (layers << 16) |
+            (virtualDisplay ? (1 << 24) : 0));
+
+    Mutex::Autolock _l(mlock);
+    if (load == mCompositionLoad) {
+        mPendingCompositionFrames = 0;
+        return NO_ERROR;
+    }
+    // wait a few frames before unboosting, in case the load comes back
+    const uint32_t currentPixels = mCompositionLoad & 0xFFFF;
+    const bool lower = pixels < currentPixels ||
+            (pixels == currentPixels && load < mCompositionLoad);
+    if (lower) {
+        if (load != mPendingCompositionLoad) {
+            mPendingCompositionLoad = load;
+            mPendingCompositionFrames = 0;
+        }
+        if (++mPendingCompositionFrames < UNBOOST_FRAMES) {
+            return NO_ERROR;
+        }
+    }
+    mCompositionLoad = load;
+    mPendingCompositionFrames = 0;
+    return powerHintLocked(mCompositionHintId, load);
+}
+
+status_t PowerHAL::powerHintLocked(int hintId, int data) {
     if (mPowerManager == NULL) {
         const String16 serviceName("power");
         sp<IBinder> bs = defaultServiceManager()->checkService(serviceName);
@@ -39,7 +102,7 @@ status_t PowerHAL::vsyncHint(bool enabled) {
         }
         mPowerManager = interface_cast<IPowerManager>(bs);
     }
-    status_t status = mPowerManager->powerHint(POWER_HINT_VSYNC, enabled ? 1 : 0);
+    status_t status = mPowerManager->powerHint(hintId, data);
     if(status == DEAD_OBJECT) {
         mPowerManager = NULL;
     }
@@ -30,11 +30,37 @@ namespace android {
 class PowerHAL
 {
 public:
+    PowerHAL();
+
     status_t vsyncHint(bool enabled);
 
+    // The composition load hint tells the power HAL how much GLES
+    // composition the upcoming frame needs, before it's done. The hint id
+    // is vendor defined, and set with ro.sf.composition_hint; without it
+    // no hint is sent. Its parameter is:
+    //   bits 0-15   GLES composed pixels, in percent of the primary display
+    //   bits 16-23  number of GLES composed layers
+    //   bit 24      set while a virtual display is composed
+    // The pixels are rounded up to a multiple of 25%, and the layer count
+    // to a power of two, so that the hint only changes with the load.
+    // A higher load is reported right away, a lower one only once it lasted
+    // UNBOOST_FRAMES frames.
+    bool isCompositionHintEnabled() const;
+    status_t compositionHint(uint32_t glesLayers, uint32_t glesPixelsPercent,
+            bool virtualDisplay);
+
 private:
+    enum { UNBOOST_FRAMES = 10 };
+
+    status_t powerHintLocked(int hintId, int data);
+
     sp<IPowerManager> mPowerManager;
     Mutex mlock;
+
+    int mCompositionHintId;
+    int32_t mCompositionLoad;
+    int32_t mPendingCompositionLoad;
+    uint32_t mPendingCompositionFrames;
 };
 
 // ---------------------------------------------------------------------------
@@ -56,6 +56,7 @@ VirtualDisplaySurface::VirtualDisplaySurface(HWComposer& hwc, int32_t dispId,
     mDisplayName(name),
     mOutputUsage(GRALLOC_USAGE_HW_COMPOSER),
     mProducerSlotSource(0),
+    mForceHwcCopy(false),
     mDbgState(DBG_STATE_IDLE),
     mDbgLastCompositionType(COMPOSITION_UNKNOWN),
     mMustRecompose(false)
@@ -86,6 +87,11 @@ VirtualDisplaySurface::VirtualDisplaySurface(HWComposer& hwc, int32_t dispId,
     }
     mOutputFormat = mDefaultOutputFormat;
 
+    // The extra HWC copy only pays off when HWC does the RGB->YUV conversion
+    // for a video encoder. Any other sink can take the GLES output as is.
+    mForceHwcCopy = sForceHwcCopy &&
+            (sinkUsage & GRALLOC_USAGE_HW_VIDEO_ENCODER) != 0;
+
     ConsumerBase::mName = String8::format("VDS: %s", mDisplayName.string());
     mConsumer->setConsumerName(ConsumerBase::mName);
     mConsumer->setConsumerUsageBits(GRALLOC_USAGE_HW_COMPOSER);
@@ -118,7 +124,7 @@ status_t VirtualDisplaySurface::prepareFrame(CompositionType compositionType) {
     mDbgState = DBG_STATE_PREPARED;
 
     mCompositionType = compositionType;
-    if (sForceHwcCopy && mCompositionType == COMPOSITION_GLES) {
+    if (mForceHwcCopy && mCompositionType == COMPOSITION_GLES) {
         // Some hardware can do RGB->YUV conversion more efficiently in hardware
         // controlled by HWC than in hardware controlled by the video encoder.
         // Forcing GLES-composed frames to go through an extra copy by the HWC
@@ -126,7 +132,8 @@ status_t VirtualDisplaySurface::prepareFrame(CompositionType compositionType) {
         // directly to the consumer.
         //
         // On the other hand, when the consumer prefers RGB or can consume RGB
-        // inexpensively, this forces an unnecessary copy.
+        // inexpensively, this forces an unnecessary copy, which is why this
+        // is only done for video encoder sinks.
         mCompositionType = COMPOSITION_MIXED;
     }
 
@@ -522,6 +529,20 @@ void VirtualDisplaySurface::allocateBuffers(bool /* async */,
     // TODO: Should we actually allocate buffers for a virtual display?
 }
 
+status_t VirtualDisplaySurface::getControlChannel(int* /* outFd */) {
+    // Buffers are routed between the sink and the scratch queue here, so
+    // producer calls must keep going through this object.
+    return INVALID_OPERATION;
+}
+
+status_t VirtualDisplaySurface::attachAndQueueBuffer(int* /* outSlot */,
+        const sp<GraphicBuffer>& /* buffer */,
+        const QueueBufferInput& /* input */,
+        QueueBufferOutput* /* output */) {
+    VDS_LOGE("attachAndQueueBuffer is not available for VirtualDisplaySurface");
+    return INVALID_OPERATION;
+}
+
 void VirtualDisplaySurface::updateQueueBufferOutput(
         const QueueBufferOutput& qbo) {
     uint32_t w, h, transformHint, numPendingBuffers;
@@ -115,6 +115,10 @@ private:
     virtual status_t setSidebandStream(const sp<NativeHandle>& stream);
     virtual void allocateBuffers(bool async, uint32_t width, uint32_t height,
             uint32_t format, uint32_t usage);
+    virtual status_t getControlChannel(int* outFd);
+    virtual status_t attachAndQueueBuffer(int* outSlot,
+            const sp<GraphicBuffer>& buffer, const QueueBufferInput& input,
+            QueueBufferOutput* output);
 
     //
     // Utility methods
@@ -169,6 +173,11 @@ private:
     // to the sink, we have to return the previous version.
     QueueBufferOutput mQueueBufferOutput;
 
+    // Whether GLES-only frames are copied to the sink buffer by HWC, see
+    // prepareFrame(). Only set for video encoder sinks, and only if
+    // FORCE_HWC_COPY_FOR_VIRTUAL_DISPLAYS is defined.
+    bool mForceHwcCopy;
+
     // Details of the current sink buffer. These become valid when a buffer is
     // dequeued from the sink, and are used when queueing the buffer.
     uint32_t mSinkBufferWidth, mSinkBufferHeight;
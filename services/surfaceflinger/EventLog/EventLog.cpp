@@ -14,8 +14,16 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cutils/atomic.h>
 #include <cutils/log.h>
 #include <utils/String8.h>
 
@@ -27,12 +35,44 @@ namespace android {
 
 ANDROID_SINGLETON_STATIC_INSTANCE(EventLog)
 
+const char* const EventLog::FRAME_STATS_DIR = "/data/system/sf_frame_stats";
+
+
+EventLog::EventLog()
+    : mBatching(false), mBatchStart(0), mNumDurations(0), mStatsFile(NULL) {
+}
 
-EventLog::EventLog() {
+bool EventLog::addToBatch(const String8& window, const int32_t* durations,
+        size_t numDurations) {
+    Mutex::Autolock _l(mLock);
+    if (!mBatching) {
+        return false;
+    }
+    if (numDurations > FrameStatsFile::MAX_DURATIONS) {
+        numDurations = FrameStatsFile::MAX_DURATIONS;
+    }
+    if (numDurations > mNumDurations) {
+        mNumDurations = numDurations;
+    }
+    ssize_t index = mBatch.indexOfKey(window);
+    if (index < 0) {
+        Durations empty;
+        memset(&empty, 0, sizeof(empty));
+        index = mBatch.add(window, empty);
+    }
+    Durations& sums(mBatch.editValueAt(index));
+    for (size_t i = 0; i < numDurations; i++) {
+        sums.counts[i] += durations[i];
+    }
+    return true;
 }
 
 void EventLog::doLogFrameDurations(const String8& window,
         const int32_t* durations, size_t numDurations) {
+    if (addToBatch(window, durations, numDurations)) {
+        return;
+    }
+
     EventLog::TagBuffer buffer(LOGTAG_SF_FRAME_DUR);
     buffer.startList(1 + numDurations);
     buffer.writeString8(window);
@@ -43,12 +83,126 @@ void EventLog::doLogFrameDurations(const String8& window,
     buffer.log();
 }
 
+String8 EventLog::getFrameStatsPath(const char* statsFile) {
+    if (statsFile == NULL || statsFile[0] == '\0' ||
+            strchr(statsFile, '/') != NULL ||
+            !strcmp(statsFile, ".") || !strcmp(statsFile, "..")) {
+        return String8();
+    }
+    return String8::format("%s/%s", FRAME_STATS_DIR, statsFile);
+}
+
+void EventLog::doEnableBatching(const char* statsFile) {
+    Mutex::Autolock _l(mLock);
+    if (mBatching) {
+        return;
+    }
+    mBatching = true;
+    mBatchStart = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    if (statsFile == NULL) {
+        return;
+    }
+    const String8 path(getFrameStatsPath(statsFile));
+    if (path.isEmpty()) {
+        ALOGE("frame stats file %s isn't a file name", statsFile);
+        return;
+    }
+    const char* statsPath = path.string();
+    if (mkdir(FRAME_STATS_DIR, 0755) != 0 && errno != EEXIST) {
+        ALOGE("couldn't create %s: %s", FRAME_STATS_DIR, strerror(errno));
+        return;
+    }
+    int fd = open(statsPath,
+            O_RDWR | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ALOGE("couldn't open frame stats file %s: %s", statsPath,
+                strerror(errno));
+        return;
+    }
+    if (ftruncate(fd, sizeof(FrameStatsFile)) == 0) {
+        void* map = mmap(NULL, sizeof(FrameStatsFile), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            mStatsFile = static_cast<FrameStatsFile*>(map);
+            mStatsFile->magic = FrameStatsFile::MAGIC;
+            mStatsFile->version = FrameStatsFile::VERSION;
+        }
+    }
+    ALOGE_IF(mStatsFile == NULL, "couldn't map frame stats file %s: %s",
+            statsPath, strerror(errno));
+    close(fd);
+}
+
+void EventLog::doFlushFrameDurations() {
+    Mutex::Autolock _l(mLock);
+    if (!mBatching) {
+        return;
+    }
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (mStatsFile != NULL) {
+        writeStatsFileLocked(now);
+    }
+
+    int32_t totals[FrameStatsFile::MAX_DURATIONS];
+    memset(totals, 0, sizeof(totals));
+    for (size_t i = 0; i < mBatch.size(); i++) {
+        const Durations& sums(mBatch.valueAt(i));
+        for (size_t j = 0; j < mNumDurations; j++) {
+            totals[j] += sums.counts[j];
+        }
+    }
+    if (!mBatch.isEmpty()) {
+        EventLog::TagBuffer buffer(LOGTAG_SF_FRAME_DUR_BATCH);
+        buffer.startList(2 + mNumDurations);
+        buffer.writeInt64(ns2ms(now - mBatchStart));
+        buffer.writeInt32(mBatch.size());
+        for (size_t i = 0; i < mNumDurations; i++) {
+            buffer.writeInt32(totals[i]);
+        }
+        buffer.endList();
+        buffer.log();
+    }
+
+    mBatch.clear();
+    mBatchStart = now;
+}
+
+void EventLog::writeStatsFileLocked(nsecs_t now) {
+    FrameStatsFile* file = mStatsFile;
+    android_atomic_inc(&file->sequence);
+
+    const size_t numWindows = mBatch.size() < FrameStatsFile::MAX_WINDOWS ?
+            mBatch.size() : size_t(FrameStatsFile::MAX_WINDOWS);
+    for (size_t i = 0; i < numWindows; i++) {
+        FrameStatsFile::Window& window(file->windows[i]);
+        strlcpy(window.name, mBatch.keyAt(i).string(), sizeof(window.name));
+        memcpy(window.durations, mBatch.valueAt(i).counts,
+                sizeof(window.durations));
+    }
+    file->numWindows = numWindows;
+    file->numDroppedWindows = mBatch.size() - numWindows;
+    file->numDurations = mNumDurations;
+    file->intervalStart = mBatchStart;
+    file->intervalEnd = now;
+
+    android_atomic_inc(&file->sequence);
+}
+
 void EventLog::logFrameDurations(const String8& window,
         const int32_t* durations, size_t numDurations) {
     EventLog::getInstance().doLogFrameDurations(window, durations,
             numDurations);
 }
 
+void EventLog::enableBatching(const char* statsFile) {
+    EventLog::getInstance().doEnableBatching(statsFile);
+}
+
+void EventLog::flushFrameDurations() {
+    EventLog::getInstance().doFlushFrameDurations();
+}
+
 // ---------------------------------------------------------------------------
 
 EventLog::TagBuffer::TagBuffer(int32_t tag)
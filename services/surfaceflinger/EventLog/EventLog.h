@@ -16,7 +16,11 @@
 
 #include <stdint.h>
 #include <utils/Errors.h>
+#include <utils/KeyedVector.h>
 #include <utils/Singleton.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/threads.h>
 
 #ifndef ANDROID_SF_EVENTLOG_H
 #define ANDROID_SF_EVENTLOG_H
@@ -25,7 +29,33 @@
 namespace android {
 // ---------------------------------------------------------------------------
 
-class String8;
+/*
+ * The layout of the frame stats file written in batched mode, for agents
+ * that map it. sequence is odd while the file is being updated; readers
+ * should retry until they read the same even value before and after
+ * copying the entries.
+ */
+struct FrameStatsFile {
+    enum { MAGIC = 0x53465353 /* 'SFSS' */, VERSION = 1 };
+    enum { MAX_WINDOWS = 64, MAX_DURATIONS = 8, MAX_NAME = 64 };
+
+    struct Window {
+        char name[MAX_NAME];
+        int32_t durations[MAX_DURATIONS];
+    };
+
+    uint32_t magic;
+    uint32_t version;
+    volatile int32_t sequence;
+    uint32_t numWindows;
+    // windows that didn't fit in the file in the last interval
+    uint32_t numDroppedWindows;
+    uint32_t numDurations;
+    // the last interval, on the monotonic clock
+    int64_t intervalStart;
+    int64_t intervalEnd;
+    Window windows[MAX_WINDOWS];
+};
 
 class EventLog : public Singleton<EventLog> {
 
@@ -33,6 +63,21 @@ public:
     static void logFrameDurations(const String8& window,
             const int32_t* durations, size_t numDurations);
 
+    // enableBatching makes logFrameDurations add the durations up per
+    // window, and flushFrameDurations log the sum over all windows as a
+    // single record. If statsFile isn't NULL, the per-window sums are also
+    // written to the file of that name in FRAME_STATS_DIR, see
+    // FrameStatsFile.
+    static void enableBatching(const char* statsFile);
+    static void flushFrameDurations();
+
+    // The only directory the frame stats file may be written to.
+    static const char* const FRAME_STATS_DIR;
+
+    // getFrameStatsPath returns the path of the frame stats file of the
+    // given name, or an empty string if the name isn't a plain file name.
+    static String8 getFrameStatsPath(const char* statsFile);
+
 protected:
     EventLog();
 
@@ -73,9 +118,29 @@ private:
     EventLog(const EventLog&);
     EventLog& operator =(const EventLog&);
 
-    enum { LOGTAG_SF_FRAME_DUR = 60100 };
+    enum { LOGTAG_SF_FRAME_DUR = 60100, LOGTAG_SF_FRAME_DUR_BATCH = 60101 };
     void doLogFrameDurations(const String8& window, const int32_t* durations,
             size_t numDurations);
+    // addToBatch adds the durations to the sums of the window and returns
+    // true, or returns false if not batching.
+    bool addToBatch(const String8& window, const int32_t* durations,
+            size_t numDurations);
+    void doEnableBatching(const char* statsFile);
+    void doFlushFrameDurations();
+    void writeStatsFileLocked(nsecs_t now);
+
+    struct Durations {
+        int32_t counts[FrameStatsFile::MAX_DURATIONS];
+    };
+
+    // guards the batching state, frame stats are logged from the main
+    // thread but also when layers are destroyed
+    Mutex mLock;
+    bool mBatching;
+    nsecs_t mBatchStart;
+    size_t mNumDurations;
+    KeyedVector<String8, Durations> mBatch;
+    FrameStatsFile* mStatsFile;
 };
 
 // ---------------------------------------------------------------------------
@@ -49,13 +49,16 @@ EventThread::EventThread(const sp<VSyncSource>& src)
       mUseSoftwareVSync(false),
       mVsyncEnabled(false),
       mDebugVsyncEnabled(false),
-      mVsyncHintSent(false) {
+      mVsyncHintSent(false),
+      mLastVsyncHintTime(0),
+      mNumSignalConnections(0) {
 
     for (int32_t i=0 ; i<DisplayDevice::NUM_BUILTIN_DISPLAY_TYPES ; i++) {
         mVSyncEvent[i].header.type = DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
         mVSyncEvent[i].header.id = 0;
         mVSyncEvent[i].header.timestamp = 0;
         mVSyncEvent[i].vsync.count =  0;
+        mVSyncEvent[i].vsync.deadline = 0;
     }
     struct sigevent se;
     se.sigev_notify = SIGEV_THREAD;
@@ -67,18 +70,33 @@ EventThread::EventThread(const sp<VSyncSource>& src)
 
 void EventThread::sendVsyncHintOff() {
     Mutex::Autolock _l(mLock);
+    const nsecs_t idle = systemTime(SYSTEM_TIME_MONOTONIC) - mLastVsyncHintTime;
+    if (idle < vsyncHintOffDelay) {
+        // VSYNC was requested again after the timer was set, wait for
+        // the rest of the delay.
+        armVsyncHintOffTimerLocked(vsyncHintOffDelay - idle);
+        return;
+    }
     mPowerHAL.vsyncHint(false);
     mVsyncHintSent = false;
 }
 
 void EventThread::sendVsyncHintOnLocked() {
-    struct itimerspec ts;
+    // This is called on every VSYNC. Rather than resetting the timer each
+    // time, just remember when we were last called and let the timer
+    // callback push itself back if needed.
+    mLastVsyncHintTime = systemTime(SYSTEM_TIME_MONOTONIC);
     if(!mVsyncHintSent) {
         mPowerHAL.vsyncHint(true);
         mVsyncHintSent = true;
+        armVsyncHintOffTimerLocked(vsyncHintOffDelay);
     }
-    ts.it_value.tv_sec = 0;
-    ts.it_value.tv_nsec = vsyncHintOffDelay;
+}
+
+void EventThread::armVsyncHintOffTimerLocked(nsecs_t delay) {
+    struct itimerspec ts;
+    ts.it_value.tv_sec = delay / 1000000000;
+    ts.it_value.tv_nsec = delay % 1000000000;
     ts.it_interval.tv_sec = 0;
     ts.it_interval.tv_nsec = 0;
     timer_settime(mTimerId, 0, &ts, NULL);
@@ -145,12 +163,13 @@ void EventThread::onScreenAcquired() {
     }
 }
 
-void EventThread::onVSyncEvent(nsecs_t timestamp) {
+void EventThread::onVSyncEvent(nsecs_t timestamp, nsecs_t deadline) {
     Mutex::Autolock _l(mLock);
     mVSyncEvent[0].header.type = DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
     mVSyncEvent[0].header.id = 0;
     mVSyncEvent[0].header.timestamp = timestamp;
     mVSyncEvent[0].vsync.count++;
+    mVSyncEvent[0].vsync.deadline = deadline;
     mCondition.broadcast();
 }
 
@@ -172,13 +191,11 @@ void EventThread::onHotplugReceived(int type, bool connected) {
 
 bool EventThread::threadLoop() {
     DisplayEventReceiver::Event event;
-    Vector< sp<EventThread::Connection> > signalConnections;
-    signalConnections = waitForEvent(&event);
+    const size_t count = waitForEvent(&event);
 
     // dispatch events to listeners...
-    const size_t count = signalConnections.size();
     for (size_t i=0 ; i<count ; i++) {
-        const sp<Connection>& conn(signalConnections[i]);
+        const sp<Connection>& conn(mSignalConnections[i]);
         // now see if we still need to report this event
         status_t err = conn->postEvent(event);
         if (err == -EAGAIN || err == -EWOULDBLOCK) {
@@ -193,19 +210,34 @@ bool EventThread::threadLoop() {
             // handle any other error on the pipe as fatal. the only
             // reasonable thing to do is to clean-up this connection.
             // The most common error we'll get here is -EPIPE.
-            removeDisplayEventConnection(signalConnections[i]);
+            removeDisplayEventConnection(conn);
         }
     }
+
+    // drop our references, but keep the slots for the next event
+    for (size_t i=0 ; i<count ; i++) {
+        mSignalConnections.editItemAt(i).clear();
+    }
+    mNumSignalConnections = 0;
     return true;
 }
 
+void EventThread::addSignalConnection(const sp<Connection>& connection) {
+    if (mNumSignalConnections < mSignalConnections.size()) {
+        mSignalConnections.editItemAt(mNumSignalConnections) = connection;
+    } else {
+        mSignalConnections.add(connection);
+    }
+    mNumSignalConnections++;
+}
+
 // This will return when (1) a vsync event has been received, and (2) there was
 // at least one connection interested in receiving it when we started waiting.
-Vector< sp<EventThread::Connection> > EventThread::waitForEvent(
-        DisplayEventReceiver::Event* event)
+// The connections to signal are stored in the first slots of
+// mSignalConnections, the number of which is returned.
+size_t EventThread::waitForEvent(DisplayEventReceiver::Event* event)
 {
     Mutex::Autolock _l(mLock);
-    Vector< sp<EventThread::Connection> > signalConnections;
 
     do {
         bool eventPending = false;
@@ -250,12 +282,12 @@ Vector< sp<EventThread::Connection> > EventThread::waitForEvent(
                         if (connection->count == 0) {
                             // fired this time around
                             connection->count = -1;
-                            signalConnections.add(connection);
+                            addSignalConnection(connection);
                             added = true;
                         } else if (connection->count == 1 ||
                                 (vsyncCount % connection->count) == 0) {
                             // continuous event, and time to report it
-                            signalConnections.add(connection);
+                            addSignalConnection(connection);
                             added = true;
                         }
                     }
@@ -265,7 +297,7 @@ Vector< sp<EventThread::Connection> > EventThread::waitForEvent(
                     // we don't have a vsync event to process
                     // (timestamp==0), but we have some pending
                     // messages.
-                    signalConnections.add(connection);
+                    addSignalConnection(connection);
                 }
             } else {
                 // we couldn't promote this reference, the connection has
@@ -290,8 +322,8 @@ Vector< sp<EventThread::Connection> > EventThread::waitForEvent(
             enableVSyncLocked();
         }
 
-        // note: !timestamp implies signalConnections.isEmpty(), because we
-        // don't populate signalConnections if there's no vsync pending
+        // note: !timestamp implies mNumSignalConnections == 0, because we
+        // don't add connections to signal if there's no vsync pending
         if (!timestamp && !eventPending) {
             // wait for something to happen
             if (waitForVSync) {
@@ -317,6 +349,7 @@ Vector< sp<EventThread::Connection> > EventThread::waitForEvent(
                     mVSyncEvent[0].header.id = DisplayDevice::DISPLAY_PRIMARY;
                     mVSyncEvent[0].header.timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
                     mVSyncEvent[0].vsync.count++;
+                    mVSyncEvent[0].vsync.deadline = 0;
                 }
             } else {
                 // Nobody is interested in vsync, so we just want to sleep.
@@ -326,12 +359,12 @@ Vector< sp<EventThread::Connection> > EventThread::waitForEvent(
                 mCondition.wait(mLock);
             }
         }
-    } while (signalConnections.isEmpty());
+    } while (mNumSignalConnections == 0);
 
     // here we're guaranteed to have a timestamp and some connections to signal
     // (The connections might have dropped out of mDisplayEventConnections
     // while we were asleep, but we'll still have strong references to them.)
-    return signalConnections;
+    return mNumSignalConnections;
 }
 
 void EventThread::enableVSyncLocked() {
@@ -45,7 +45,8 @@ public:
     class Callback: public virtual RefBase {
     public:
         virtual ~Callback() {}
-        virtual void onVSyncEvent(nsecs_t when) = 0;
+        // deadline is when the following vsync is expected, 0 if unknown
+        virtual void onVSyncEvent(nsecs_t when, nsecs_t deadline) = 0;
     };
 
     virtual ~VSyncSource() {}
@@ -93,9 +94,6 @@ public:
     // called when receiving a hotplug event
     void onHotplugReceived(int type, bool connected);
 
-    Vector< sp<EventThread::Connection> > waitForEvent(
-            DisplayEventReceiver::Event* event);
-
     void dump(String8& result) const;
     void sendVsyncHintOff();
 
@@ -103,12 +101,16 @@ private:
     virtual bool        threadLoop();
     virtual void        onFirstRef();
 
-    virtual void onVSyncEvent(nsecs_t timestamp);
+    virtual void onVSyncEvent(nsecs_t timestamp, nsecs_t deadline);
+
+    size_t waitForEvent(DisplayEventReceiver::Event* event);
+    void addSignalConnection(const sp<Connection>& connection);
 
     void removeDisplayEventConnection(const wp<Connection>& connection);
     void enableVSyncLocked();
     void disableVSyncLocked();
     void sendVsyncHintOnLocked();
+    void armVsyncHintOffTimerLocked(nsecs_t delay);
 
     // constants
     sp<VSyncSource> mVSyncSource;
@@ -128,7 +130,14 @@ private:
     bool mDebugVsyncEnabled;
 
     bool mVsyncHintSent;
+    nsecs_t mLastVsyncHintTime;
     timer_t mTimerId;
+
+    // only used by the EventThread itself: the connections to signal for
+    // the event being dispatched. The slots are reused from one event to
+    // the next so that dispatching a VSYNC doesn't allocate.
+    Vector< sp<Connection> > mSignalConnections;
+    size_t mNumSignalConnections;
 };
 
 // ---------------------------------------------------------------------------
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include <cutils/log.h>
+#include <cutils/sockets.h>
+
+#include <gui/BufferQueue.h>
+
+#include <ui/PixelFormat.h>
+
+#include <utils/Trace.h>
+
+#include <private/android_filesystem_config.h>
+
+#include "DisplayDevice.h"
+#include "FrameStreamer.h"
+#include "StateSnapshot.h"
+#include "SurfaceFlinger.h"
+
+namespace android {
+
+static const char* const SOCKET_NAME = "surfaceflinger_frames";
+
+FrameStreamer::FrameStreamer(const sp<SurfaceFlinger>& flinger,
+        nsecs_t period, uint32_t scale) :
+        mFlinger(flinger),
+        mPeriod(period),
+        mScale(scale > 0 ? scale : 1),
+        mServerFd(-1) {
+}
+
+FrameStreamer::~FrameStreamer() {
+    if (mServerFd >= 0) {
+        close(mServerFd);
+    }
+}
+
+status_t FrameStreamer::start() {
+    mServerFd = socket_local_server(SOCKET_NAME,
+            ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
+    if (mServerFd < 0) {
+        ALOGE("FrameStreamer: can't create socket %s: %s", SOCKET_NAME,
+                strerror(errno));
+        return -errno;
+    }
+
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&mProducer, &consumer);
+    mConsumer = new CpuConsumer(consumer, 1);
+    mConsumer->setName(String8("FrameStreamer"));
+
+    return run("FrameStreamer", PRIORITY_BACKGROUND);
+}
+
+bool FrameStreamer::threadLoop() {
+    int fd = accept(mServerFd, NULL, NULL);
+    if (fd < 0) {
+        if (errno != EINTR) {
+            ALOGE("FrameStreamer: accept failed: %s", strerror(errno));
+            return false;
+        }
+        return true;
+    }
+    if (isClientAllowed(fd)) {
+        ALOGI("FrameStreamer: client connected");
+        serve(fd);
+        ALOGI("FrameStreamer: client disconnected");
+    }
+    close(fd);
+    return true;
+}
+
+bool FrameStreamer::isClientAllowed(int fd) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        return false;
+    }
+    if (cred.uid != AID_ROOT && cred.uid != AID_SHELL) {
+        ALOGW("FrameStreamer: rejecting uid %d", cred.uid);
+        return false;
+    }
+    return true;
+}
+
+void FrameStreamer::serve(int fd) {
+    mPrevious.clear();
+    uint64_t lastRefresh = 0;
+    nsecs_t nextFrame = systemTime();
+
+    while (!exitPending()) {
+        nsecs_t now = systemTime();
+        if (now < nextFrame) {
+            usleep(ns2us(nextFrame - now));
+        }
+        nextFrame += mPeriod;
+        if (nextFrame < now) {
+            // we fell behind, don't try to catch up
+            nextFrame = now + mPeriod;
+        }
+
+        // nothing new to send if nothing was composed since the last frame
+        Vector<uint8_t> layers;
+        uint32_t layerCount;
+        uint64_t refresh;
+        appendLayers(layers, &layerCount, &refresh);
+        if (refresh == lastRefresh) {
+            continue;
+        }
+
+        CpuConsumer::LockedBuffer buffer;
+        status_t err = captureFrame(&buffer);
+        if (err == PERMISSION_DENIED) {
+            continue;
+        }
+        if (err != NO_ERROR) {
+            ALOGE("FrameStreamer: capture failed: %s (%d)",
+                    strerror(-err), err);
+            return;
+        }
+
+        const size_t rowSize = buffer.width * bytesPerPixel(buffer.format);
+        const bool keyframe = mPrevious.size() != rowSize * buffer.height;
+        err = compress(buffer, keyframe);
+        mConsumer->unlockBuffer(buffer);
+        if (err != NO_ERROR) {
+            return;
+        }
+
+        StreamHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.refresh = refresh;
+        header.timestamp = buffer.timestamp;
+        header.width = buffer.width;
+        header.height = buffer.height;
+        header.format = buffer.format;
+        header.flags = keyframe ? FLAG_KEYFRAME : 0;
+        header.layerCount = layerCount;
+        header.layerDataSize = layers.size();
+        header.pixelDataSize = mCompressed.size();
+
+        ATRACE_NAME("FrameStreamer send");
+        if (!writeFully(fd, &header, sizeof(header)) ||
+                !writeFully(fd, layers.array(), layers.size()) ||
+                !writeFully(fd, mCompressed.array(), mCompressed.size())) {
+            return;
+        }
+        lastRefresh = refresh;
+    }
+}
+
+status_t FrameStreamer::captureFrame(CpuConsumer::LockedBuffer* outBuffer) {
+    ATRACE_CALL();
+    uint32_t width, height;
+    {
+        // our producer is local, so captureScreen() doesn't check for
+        // secure layers itself
+        Mutex::Autolock _l(mFlinger->mStateLock);
+        sp<const DisplayDevice> hw(mFlinger->getDefaultDisplayDevice());
+        if (hw->getSecureLayerVisible()) {
+            return PERMISSION_DENIED;
+        }
+        width = hw->getWidth() / mScale;
+        height = hw->getHeight() / mScale;
+    }
+
+    status_t err = mFlinger->captureScreen(
+            mFlinger->getBuiltInDisplay(DisplayDevice::DISPLAY_PRIMARY),
+            mProducer, Rect(), width, height, 0, -1U, false,
+            ISurfaceComposer::eRotateNone, false);
+    if (err != NO_ERROR) {
+        return err;
+    }
+    return mConsumer->lockNextBuffer(outBuffer);
+}
+
+void FrameStreamer::appendLayers(Vector<uint8_t>& out, uint32_t* outCount,
+        uint64_t* outRefresh) const {
+    *outCount = 0;
+    *outRefresh = 0;
+    sp<const StateSnapshot> snapshot(mFlinger->getStateSnapshot());
+    if (snapshot == NULL) {
+        return;
+    }
+    const StateSnapshot::DisplayInfo* primary = NULL;
+    for (size_t i = 0; i < snapshot->mDisplays.size(); i++) {
+        if (snapshot->mDisplays[i].hwcId == DisplayDevice::DISPLAY_PRIMARY) {
+            primary = &snapshot->mDisplays[i];
+        }
+    }
+    if (primary == NULL) {
+        return;
+    }
+    *outRefresh = snapshot->mFrame;
+
+    const StateSnapshot::DisplayInfo& display(*primary);
+    for (size_t i = 0; i < display.layers.size(); i++) {
+        const StateSnapshot::ComposedLayer& composed(display.layers[i]);
+        const StateSnapshot::LayerInfo& info(snapshot->mLayers[composed.layer]);
+        StreamLayer layer;
+        memset(&layer, 0, sizeof(layer));
+        layer.compositionType = composed.compositionType;
+        layer.z = info.z;
+        layer.x = info.x;
+        layer.y = info.y;
+        layer.width = info.width;
+        layer.height = info.height;
+        layer.alpha = info.alpha;
+        layer.flags = info.flags;
+        layer.nameLength = info.name.length() < 0xffff ?
+                info.name.length() : 0xffff;
+        out.appendArray(reinterpret_cast<const uint8_t*>(&layer),
+                sizeof(layer));
+        out.appendArray(reinterpret_cast<const uint8_t*>(info.name.string()),
+                layer.nameLength);
+    }
+    *outCount = display.layers.size();
+}
+
+status_t FrameStreamer::compress(const CpuConsumer::LockedBuffer& buffer,
+        bool keyframe) {
+    ATRACE_CALL();
+    const size_t bpp = bytesPerPixel(buffer.format);
+    const size_t rowSize = buffer.width * bpp;
+    const size_t size = rowSize * buffer.height;
+
+    // pack the rows, XORed with the previous frame: what didn't change
+    // becomes zeroes, which deflate well
+    if (keyframe) {
+        mPrevious.resize(size);
+    }
+    mDelta.resize(size);
+    uint8_t* delta = mDelta.editArray();
+    uint8_t* previous = mPrevious.editArray();
+    const uint8_t* src = buffer.data;
+    for (uint32_t y = 0; y < buffer.height; y++) {
+        for (size_t x = 0; x < rowSize; x++) {
+            delta[x] = keyframe ? src[x] : src[x] ^ previous[x];
+        }
+        memcpy(previous, src, rowSize);
+        delta += rowSize;
+        previous += rowSize;
+        src += buffer.stride * bpp;
+    }
+
+    uLongf compressedSize = compressBound(size);
+    mCompressed.resize(compressedSize);
+    int zerr = compress2(mCompressed.editArray(), &compressedSize,
+            mDelta.array(), size, Z_BEST_SPEED);
+    if (zerr != Z_OK) {
+        ALOGE("FrameStreamer: compression failed: %d", zerr);
+        mPrevious.clear();
+        return UNKNOWN_ERROR;
+    }
+    mCompressed.resize(compressedSize);
+    return NO_ERROR;
+}
+
+bool FrameStreamer::writeFully(int fd, const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+}; // namespace android
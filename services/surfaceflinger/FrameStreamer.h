@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_FRAMESTREAMER_H
+#define ANDROID_FRAMESTREAMER_H
+
+#include <stdint.h>
+
+#include <gui/CpuConsumer.h>
+
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class SurfaceFlinger;
+
+/*
+ * FrameStreamer sends what the primary display shows, along with the layers
+ * that composed it, to a host profiler over a local socket, so that it
+ * doesn't have to launch screencap for every frame. The host reaches it
+ * with:
+ *
+ *   adb forward tcp:<port> localabstract:surfaceflinger_frames
+ *
+ * Only one client is served at a time, and only root and shell may connect.
+ * Each frame is a StreamHeader, the layer records, and the pixels: rows of
+ * width * bytesPerPixel(format) bytes, XORed with the previous frame of the
+ * connection unless FLAG_KEYFRAME is set, and deflated with zlib. Nothing
+ * is sent while a secure layer is visible.
+ */
+class FrameStreamer : public Thread {
+public:
+    enum { MAGIC = 0x53465354 };        // 'SFST'
+    enum { VERSION = 1 };
+    enum { FLAG_KEYFRAME = 0x1 };
+
+    struct StreamHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t refresh;               // refresh count of the layers
+        int64_t timestamp;              // capture time, CLOCK_MONOTONIC ns
+        uint32_t width;
+        uint32_t height;
+        int32_t format;
+        uint32_t flags;
+        uint32_t layerCount;
+        uint32_t layerDataSize;
+        uint32_t pixelDataSize;         // deflated
+        uint32_t reserved;
+    };
+
+    // followed by nameLength bytes of name, without terminator; visible
+    // layers of the primary display, bottom first
+    struct StreamLayer {
+        int32_t compositionType;        // HWC_*, -1 without a work list
+        uint32_t z;
+        float x;
+        float y;
+        uint32_t width;
+        uint32_t height;
+        uint8_t alpha;
+        uint8_t flags;
+        uint16_t nameLength;
+    };
+
+    // frames are sent every period at most, scaled down by scale in both
+    // directions
+    FrameStreamer(const sp<SurfaceFlinger>& flinger, nsecs_t period,
+            uint32_t scale);
+    virtual ~FrameStreamer();
+
+    // creates the socket and starts the thread
+    status_t start();
+
+private:
+    virtual bool threadLoop();
+
+    // streams to the connected client until it goes away
+    void serve(int fd);
+    status_t captureFrame(CpuConsumer::LockedBuffer* outBuffer);
+    void appendLayers(Vector<uint8_t>& out, uint32_t* outCount,
+            uint64_t* outRefresh) const;
+    status_t compress(const CpuConsumer::LockedBuffer& buffer, bool keyframe);
+
+    static bool isClientAllowed(int fd);
+    static bool writeFully(int fd, const void* data, size_t size);
+
+    const sp<SurfaceFlinger> mFlinger;
+    const nsecs_t mPeriod;
+    const uint32_t mScale;
+    int mServerFd;
+
+    sp<IGraphicBufferProducer> mProducer;
+    sp<CpuConsumer> mConsumer;
+
+    // the pixels of the last frame sent, packed, for the XOR
+    Vector<uint8_t> mPrevious;
+    Vector<uint8_t> mDelta;
+    Vector<uint8_t> mCompressed;
+};
+
+}; // namespace android
+
+#endif // ANDROID_FRAMESTREAMER_H
@@ -20,24 +20,51 @@
 #include <inttypes.h>
 
 #include <cutils/log.h>
+#include <cutils/properties.h>
 
 #include <ui/Fence.h>
+#include <ui/FrameStatInfo.h>
 #include <ui/FrameStats.h>
 
 #include <utils/String8.h>
+#include <utils/Thread.h>
 
 #include "FrameTracker.h"
 #include "EventLog/EventLog.h"
 
 namespace android {
 
+// The property atrace --daemon watches, and how often SurfaceFlinger may
+// set it.
+static const char* JANK_TRIGGER_PROPERTY = "debug.atrace.snapshot";
+static const nsecs_t JANK_TRIGGER_INTERVAL = s2ns(10);
+
+// Sets the property off the composition path, property_set talks to init.
+class JankSnapshotThread : public Thread {
+    virtual bool threadLoop() {
+        property_set(JANK_TRIGGER_PROPERTY, "jank");
+        return false;
+    }
+};
+
+int FrameTracker::sJankTriggerVsyncs = 0;
+nsecs_t FrameTracker::sLastJankTrigger = 0;
+Mutex FrameTracker::sJankTriggerMutex;
+
 FrameTracker::FrameTracker() :
+        mFrameRecords(new FrameRecord[NUM_FRAME_RECORDS]),
+        mNumRecords(NUM_FRAME_RECORDS),
         mOffset(0),
         mNumFences(0),
-        mDisplayPeriod(0) {
+        mDisplayPeriod(0),
+        mJankDetected(false) {
     resetFrameCountersLocked();
 }
 
+FrameTracker::~FrameTracker() {
+    delete [] mFrameRecords;
+}
+
 void FrameTracker::setDesiredPresentTime(nsecs_t presentTime) {
     Mutex::Autolock lock(mMutex);
     mFrameRecords[mOffset].desiredPresentTime = presentTime;
@@ -71,42 +98,57 @@ void FrameTracker::setDisplayRefreshPeriod(nsecs_t displayPeriod) {
 }
 
 void FrameTracker::advanceFrame() {
-    Mutex::Autolock lock(mMutex);
+    bool jankDetected;
+    {
+        Mutex::Autolock lock(mMutex);
+
+        // Update the statistic to include the frame we just finished.
+        updateStatsLocked(mOffset);
+
+        // Advance to the next frame.
+        mOffset = (mOffset+1) % mNumRecords;
+        mFrameRecords[mOffset].desiredPresentTime = INT64_MAX;
+        mFrameRecords[mOffset].frameReadyTime = INT64_MAX;
+        mFrameRecords[mOffset].actualPresentTime = INT64_MAX;
+        mFrameRecords[mOffset].counted = false;
+
+        if (mFrameRecords[mOffset].frameReadyFence != NULL) {
+            // We're clobbering an unsignaled fence, so we need to decrement the
+            // fence count.
+            mFrameRecords[mOffset].frameReadyFence = NULL;
+            mNumFences--;
+        }
 
-    // Update the statistic to include the frame we just finished.
-    updateStatsLocked(mOffset);
+        if (mFrameRecords[mOffset].actualPresentFence != NULL) {
+            // We're clobbering an unsignaled fence, so we need to decrement the
+            // fence count.
+            mFrameRecords[mOffset].actualPresentFence = NULL;
+            mNumFences--;
+        }
 
-    // Advance to the next frame.
-    mOffset = (mOffset+1) % NUM_FRAME_RECORDS;
-    mFrameRecords[mOffset].desiredPresentTime = INT64_MAX;
-    mFrameRecords[mOffset].frameReadyTime = INT64_MAX;
-    mFrameRecords[mOffset].actualPresentTime = INT64_MAX;
+        // Clean up the signaled fences to keep the number of open fence FDs in
+        // this process reasonable.
+        processFencesLocked();
 
-    if (mFrameRecords[mOffset].frameReadyFence != NULL) {
-        // We're clobbering an unsignaled fence, so we need to decrement the
-        // fence count.
-        mFrameRecords[mOffset].frameReadyFence = NULL;
-        mNumFences--;
+        // A jank seen by the processFencesLocked calls made to get the stats
+        // is reported on the next frame.
+        jankDetected = mJankDetected;
+        mJankDetected = false;
     }
 
-    if (mFrameRecords[mOffset].actualPresentFence != NULL) {
-        // We're clobbering an unsignaled fence, so we need to decrement the
-        // fence count.
-        mFrameRecords[mOffset].actualPresentFence = NULL;
-        mNumFences--;
+    // Outside of mMutex, the snapshot request isn't free.
+    if (jankDetected) {
+        triggerJankSnapshot();
     }
-
-    // Clean up the signaled fences to keep the number of open fence FDs in
-    // this process reasonable.
-    processFencesLocked();
 }
 
 void FrameTracker::clearStats() {
     Mutex::Autolock lock(mMutex);
-    for (size_t i = 0; i < NUM_FRAME_RECORDS; i++) {
+    for (size_t i = 0; i < mNumRecords; i++) {
         mFrameRecords[i].desiredPresentTime = 0;
         mFrameRecords[i].frameReadyTime = 0;
         mFrameRecords[i].actualPresentTime = 0;
+        mFrameRecords[i].counted = false;
         mFrameRecords[i].frameReadyFence.clear();
         mFrameRecords[i].actualPresentFence.clear();
     }
@@ -114,6 +156,31 @@ void FrameTracker::clearStats() {
     mFrameRecords[mOffset].desiredPresentTime = INT64_MAX;
     mFrameRecords[mOffset].frameReadyTime = INT64_MAX;
     mFrameRecords[mOffset].actualPresentTime = INT64_MAX;
+    resetLatencyStatsLocked();
+}
+
+void FrameTracker::setHistoryDepth(size_t numRecords) {
+    if (numRecords < MIN_FRAME_RECORDS) {
+        numRecords = MIN_FRAME_RECORDS;
+    } else if (numRecords > MAX_FRAME_RECORDS) {
+        numRecords = MAX_FRAME_RECORDS;
+    }
+
+    Mutex::Autolock lock(mMutex);
+    if (numRecords == mNumRecords) {
+        return;
+    }
+
+    // The history is dropped, but the current frame is kept so that the
+    // times already set for it aren't lost.
+    FrameRecord* records = new FrameRecord[numRecords];
+    records[0] = mFrameRecords[mOffset];
+    delete [] mFrameRecords;
+    mFrameRecords = records;
+    mNumRecords = numRecords;
+    mOffset = 0;
+    mNumFences = (records[0].frameReadyFence != NULL ? 1 : 0) +
+            (records[0].actualPresentFence != NULL ? 1 : 0);
 }
 
 void FrameTracker::getStats(FrameStats* outStats) const {
@@ -123,8 +190,8 @@ void FrameTracker::getStats(FrameStats* outStats) const {
     outStats->refreshPeriodNano = mDisplayPeriod;
 
     const size_t offset = mOffset;
-    for (size_t i = 1; i < NUM_FRAME_RECORDS; i++) {
-        const size_t index = (offset + i) % NUM_FRAME_RECORDS;
+    for (size_t i = 1; i < mNumRecords; i++) {
+        const size_t index = (offset + i) % mNumRecords;
 
         // Skip frame records with no data (if buffer not yet full).
         if (mFrameRecords[index].desiredPresentTime == 0) {
@@ -142,6 +209,18 @@ void FrameTracker::getStats(FrameStats* outStats) const {
     }
 }
 
+void FrameTracker::getStatInfo(FrameStatInfo* outInfo) const {
+    Mutex::Autolock lock(mMutex);
+    processFencesLocked();
+
+    outInfo->refreshPeriod = mDisplayPeriod;
+    outInfo->frameCount = mNumPresentedFrames;
+    outInfo->missedVsyncCount = mNumMissedVsyncs;
+    outInfo->latencyP50 = getLatencyPercentileLocked(50);
+    outInfo->latencyP90 = getLatencyPercentileLocked(90);
+    outInfo->latencyP99 = getLatencyPercentileLocked(99);
+}
+
 void FrameTracker::logAndResetStats(const String8& name) {
     Mutex::Autolock lock(mMutex);
     logStatsLocked(name);
@@ -152,8 +231,8 @@ void FrameTracker::processFencesLocked() const {
     FrameRecord* records = const_cast<FrameRecord*>(mFrameRecords);
     int& numFences = const_cast<int&>(mNumFences);
 
-    for (int i = 1; i < NUM_FRAME_RECORDS && numFences > 0; i++) {
-        size_t idx = (mOffset+NUM_FRAME_RECORDS-i) % NUM_FRAME_RECORDS;
+    for (size_t i = 1; i < mNumRecords && numFences > 0; i++) {
+        size_t idx = (mOffset+mNumRecords-i) % mNumRecords;
         bool updated = false;
 
         const sp<Fence>& rfence = records[idx].frameReadyFence;
@@ -183,15 +262,33 @@ void FrameTracker::processFencesLocked() const {
 }
 
 void FrameTracker::updateStatsLocked(size_t newFrameIdx) const {
-    int* numFrames = const_cast<int*>(mNumFrames);
+    FrameTracker* self = const_cast<FrameTracker*>(this);
+    int* numFrames = self->mNumFrames;
+
+    if (mDisplayPeriod > 0 && isFrameValidLocked(newFrameIdx) &&
+            !mFrameRecords[newFrameIdx].counted) {
+        FrameRecord& newFrame = self->mFrameRecords[newFrameIdx];
+        newFrame.counted = true;
+        self->mNumPresentedFrames++;
+
+        if (newFrame.desiredPresentTime > 0 &&
+                newFrame.desiredPresentTime < INT64_MAX &&
+                newFrame.actualPresentTime >= newFrame.desiredPresentTime) {
+            nsecs_t latency =
+                    newFrame.actualPresentTime - newFrame.desiredPresentTime;
+            size_t bucket = size_t(latency / ms2ns(1));
+            if (bucket >= NUM_LATENCY_BUCKETS) {
+                bucket = NUM_LATENCY_BUCKETS - 1;
+            }
+            self->mLatencyHistogram[bucket]++;
+            self->mNumLatencyFrames++;
+        }
 
-    if (mDisplayPeriod > 0 && isFrameValidLocked(newFrameIdx)) {
-        size_t prevFrameIdx = (newFrameIdx+NUM_FRAME_RECORDS-1) %
-                NUM_FRAME_RECORDS;
+        size_t prevFrameIdx = (newFrameIdx+mNumRecords-1) %
+                mNumRecords;
 
         if (isFrameValidLocked(prevFrameIdx)) {
-            nsecs_t newPresentTime =
-                    mFrameRecords[newFrameIdx].actualPresentTime;
+            nsecs_t newPresentTime = newFrame.actualPresentTime;
             nsecs_t prevPresentTime =
                     mFrameRecords[prevFrameIdx].actualPresentTime;
 
@@ -199,6 +296,21 @@ void FrameTracker::updateStatsLocked(size_t newFrameIdx) const {
             int numPeriods = int((duration + mDisplayPeriod/2) /
                     mDisplayPeriod);
 
+            // A refresh without a new frame only counts as missed if this
+            // frame was already queued when the previous one was presented,
+            // otherwise the producer simply had nothing new to show.
+            const nsecs_t desired = newFrame.desiredPresentTime;
+            const bool wasQueued = desired == 0 || desired == INT64_MAX ||
+                    desired <= prevPresentTime;
+            if (numPeriods > 1 && wasQueued) {
+                self->mNumMissedVsyncs += numPeriods - 1;
+                if (sJankTriggerVsyncs > 0 &&
+                        numPeriods - 1 >= sJankTriggerVsyncs) {
+                    // requested by advanceFrame once mMutex is released
+                    self->mJankDetected = true;
+                }
+            }
+
             for (int i = 0; i < NUM_FRAME_BUCKETS-1; i++) {
                 int nextBucket = 1 << (i+1);
                 if (numPeriods < nextBucket) {
@@ -213,10 +325,53 @@ void FrameTracker::updateStatsLocked(size_t newFrameIdx) const {
     }
 }
 
+void FrameTracker::setJankTrigger(int missedVsyncs) {
+    Mutex::Autolock lock(sJankTriggerMutex);
+    sJankTriggerVsyncs = missedVsyncs;
+}
+
+void FrameTracker::triggerJankSnapshot() {
+    Mutex::Autolock lock(sJankTriggerMutex);
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (sLastJankTrigger != 0 && now - sLastJankTrigger < JANK_TRIGGER_INTERVAL) {
+        return;
+    }
+    sLastJankTrigger = now;
+    sp<Thread> thread = new JankSnapshotThread();
+    thread->run("JankSnapshot", PRIORITY_BACKGROUND);
+}
+
 void FrameTracker::resetFrameCountersLocked() {
     for (int i = 0; i < NUM_FRAME_BUCKETS; i++) {
         mNumFrames[i] = 0;
     }
+    resetLatencyStatsLocked();
+}
+
+void FrameTracker::resetLatencyStatsLocked() {
+    for (int i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+        mLatencyHistogram[i] = 0;
+    }
+    mNumLatencyFrames = 0;
+    mNumPresentedFrames = 0;
+    mNumMissedVsyncs = 0;
+}
+
+nsecs_t FrameTracker::getLatencyPercentileLocked(uint32_t percentile) const {
+    if (mNumLatencyFrames == 0) {
+        return 0;
+    }
+    // the number of frames at or below the percentile, rounded up
+    const uint64_t target =
+            (uint64_t(mNumLatencyFrames) * percentile + 99) / 100;
+    uint64_t numFrames = 0;
+    for (int i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+        numFrames += mLatencyHistogram[i];
+        if (numFrames >= target) {
+            return ms2ns(i + 1);
+        }
+    }
+    return ms2ns(NUM_LATENCY_BUCKETS);
 }
 
 void FrameTracker::logStatsLocked(const String8& name) const {
@@ -238,8 +393,8 @@ void FrameTracker::dumpStats(String8& result) const {
     processFencesLocked();
 
     const size_t o = mOffset;
-    for (size_t i = 1; i < NUM_FRAME_RECORDS; i++) {
-        const size_t index = (o+i) % NUM_FRAME_RECORDS;
+    for (size_t i = 1; i < mNumRecords; i++) {
+        const size_t index = (o+i) % mNumRecords;
         result.appendFormat("%" PRId64 "\t%" PRId64 "\t%" PRId64 "\n",
             mFrameRecords[index].desiredPresentTime,
             mFrameRecords[index].actualPresentTime,
@@ -18,6 +18,7 @@
 #define ANDROID_FRAMETRACKER_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <utils/Mutex.h>
 #include <utils/Timers.h>
@@ -27,6 +28,7 @@ namespace android {
 
 class String8;
 class Fence;
+struct FrameStatInfo;
 
 // FrameTracker tracks information about the most recently rendered frames. It
 // uses a circular buffer of frame records, and is *NOT* thread-safe -
@@ -39,13 +41,21 @@ class Fence;
 class FrameTracker {
 
 public:
-    // NUM_FRAME_RECORDS is the size of the circular buffer used to track the
-    // frame time history.
+    // NUM_FRAME_RECORDS is the default size of the circular buffer used to
+    // track the frame time history.  It can be changed with setHistoryDepth
+    // to anything in [MIN_FRAME_RECORDS, MAX_FRAME_RECORDS].
     enum { NUM_FRAME_RECORDS = 128 };
+    enum { MIN_FRAME_RECORDS = 2 };
+    enum { MAX_FRAME_RECORDS = 4096 };
 
     enum { NUM_FRAME_BUCKETS = 7 };
 
+    // NUM_LATENCY_BUCKETS is the number of 1ms wide buckets of the frame
+    // latency histogram.  The last one also counts all longer latencies.
+    enum { NUM_LATENCY_BUCKETS = 100 };
+
     FrameTracker();
+    ~FrameTracker();
 
     // setDesiredPresentTime sets the time at which the current frame
     // should be presented to the user under ideal (i.e. zero latency)
@@ -84,6 +94,15 @@ public:
     // getStats gets the tracked frame stats.
     void getStats(FrameStats* outStats) const;
 
+    // getStatInfo gets a summary of the frames presented since the stats
+    // were last reset.  It doesn't walk the frame history, the summary is
+    // kept up to date as frames are presented.
+    void getStatInfo(FrameStatInfo* outInfo) const;
+
+    // setHistoryDepth resizes the circular buffer of frame records to
+    // the given number of frames.  This clears the frame time history.
+    void setHistoryDepth(size_t numRecords);
+
     // logAndResetStats dumps the current statistics to the binary event log
     // and then resets the accumulated statistics to their initial values.
     void logAndResetStats(const String8& name);
@@ -91,15 +110,27 @@ public:
     // dumpStats dump appends the current frame display time history to the result string.
     void dumpStats(String8& result) const;
 
+    // setJankTrigger makes every FrameTracker ask the atrace daemon for a
+    // snapshot of the trace when a frame misses at least the given number of
+    // vsyncs, see atrace --daemon.  0 disables the trigger.
+    static void setJankTrigger(int missedVsyncs);
+
 private:
+    // mFrameRecords is owned, so FrameTracker can't be copied.
+    FrameTracker(const FrameTracker&);
+    FrameTracker& operator=(const FrameTracker&);
+
     struct FrameRecord {
         FrameRecord() :
             desiredPresentTime(0),
             frameReadyTime(0),
-            actualPresentTime(0) {}
+            actualPresentTime(0),
+            counted(false) {}
         nsecs_t desiredPresentTime;
         nsecs_t frameReadyTime;
         nsecs_t actualPresentTime;
+        // whether the frame has already been accounted for in the stats
+        bool counted;
         sp<Fence> frameReadyFence;
         sp<Fence> actualPresentFence;
     };
@@ -121,6 +152,19 @@ private:
     // 0.
     void resetFrameCountersLocked();
 
+    // resetLatencyStatsLocked clears the latency histogram and the frame and
+    // missed vsync counts.
+    void resetLatencyStatsLocked();
+
+    // triggerJankSnapshot asks the atrace daemon for a snapshot, at most
+    // once every JANK_TRIGGER_INTERVAL.  The property is set on a thread of
+    // its own, off the composition path.
+    static void triggerJankSnapshot();
+
+    // getLatencyPercentileLocked returns the upper bound of the latency
+    // histogram bucket holding the given percentile of the frames.
+    nsecs_t getLatencyPercentileLocked(uint32_t percentile) const;
+
     // logStatsLocked dumps the current statistics to the binary event log.
     void logStatsLocked(const String8& name) const;
 
@@ -129,8 +173,9 @@ private:
     bool isFrameValidLocked(size_t idx) const;
 
     // mFrameRecords is the circular buffer storing the tracked data for each
-    // frame.
-    FrameRecord mFrameRecords[NUM_FRAME_RECORDS];
+    // frame.  It holds mNumRecords records.
+    FrameRecord* mFrameRecords;
+    size_t mNumRecords;
 
     // mOffset is the offset into mFrameRecords of the current frame.
     size_t mOffset;
@@ -141,7 +186,7 @@ private:
     // a fence.
     //
     // The number of fences is tracked so that the run time of processFences
-    // doesn't grow with NUM_FRAME_RECORDS.
+    // doesn't grow with mNumRecords.
     int mNumFences;
 
     // mNumFrames keeps a count of the number of frames with a duration in a
@@ -151,12 +196,34 @@ private:
     // all frames with duration greater than 2^(NUM_FRAME_BUCKETS-1).
     int32_t mNumFrames[NUM_FRAME_BUCKETS];
 
+    // mLatencyHistogram counts the frames by their latency, from the desired
+    // present time to the actual present time, in 1ms buckets.
+    uint32_t mLatencyHistogram[NUM_LATENCY_BUCKETS];
+    uint32_t mNumLatencyFrames;
+
+    // mNumPresentedFrames is the number of frames accounted for in the
+    // stats, and mNumMissedVsyncs the number of refresh periods between two
+    // consecutive frames that didn't have a frame of their own.
+    uint32_t mNumPresentedFrames;
+    uint32_t mNumMissedVsyncs;
+
     // mDisplayPeriod is the display refresh period of the display for which
     // this FrameTracker is gathering information.
     nsecs_t mDisplayPeriod;
 
+    // mJankDetected is set by updateStatsLocked when a frame misses at least
+    // sJankTriggerVsyncs vsyncs, advanceFrame then requests the snapshot.
+    bool mJankDetected;
+
     // mMutex is used to protect access to all member variables.
     mutable Mutex mMutex;
+
+    // sJankTriggerVsyncs is the threshold set by setJankTrigger when
+    // SurfaceFlinger starts, and sLastJankTrigger the time of the last
+    // snapshot request, protected by sJankTriggerMutex.
+    static int sJankTriggerVsyncs;
+    static nsecs_t sLastJankTrigger;
+    static Mutex sJankTriggerMutex;
 };
 
 }
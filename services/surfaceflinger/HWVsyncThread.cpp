@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <cutils/atomic.h>
+
+#include <utils/Log.h>
+#include <utils/String8.h>
+#include <utils/Trace.h>
+
+#include "HWVsyncThread.h"
+#include "SurfaceFlinger.h"
+
+namespace android {
+
+HWVsyncThread::HWVsyncThread(const sp<SurfaceFlinger>& flinger) :
+        mFlinger(flinger),
+        mEventFd(eventfd(0, EFD_CLOEXEC)),
+        mHead(0),
+        mTail(0),
+        mDropped(0),
+        mLastTimestamp(0),
+        mAccepted(0),
+        mRejected(0) {
+    if (mEventFd < 0) {
+        ALOGE("HWVsyncThread: eventfd failed (%s)", strerror(errno));
+    }
+}
+
+HWVsyncThread::~HWVsyncThread() {
+    if (mEventFd >= 0) {
+        close(mEventFd);
+    }
+}
+
+void HWVsyncThread::queueVsync(nsecs_t timestamp) {
+    const int32_t head = mHead;
+    if (head - android_atomic_acquire_load(&mTail) >= QUEUE_SIZE) {
+        android_atomic_inc(&mDropped);
+        return;
+    }
+    mQueue[head & (QUEUE_SIZE - 1)] = timestamp;
+    android_atomic_release_store(head + 1, &mHead);
+
+    const uint64_t one = 1;
+    write(mEventFd, &one, sizeof(one));
+}
+
+status_t HWVsyncThread::readyToRun() {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = 1;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+        ALOGW("HWVsyncThread: couldn't set SCHED_FIFO (%s)", strerror(errno));
+    }
+    return mEventFd < 0 ? NO_INIT : NO_ERROR;
+}
+
+bool HWVsyncThread::threadLoop() {
+    uint64_t count;
+    if (read(mEventFd, &count, sizeof(count)) != sizeof(count)) {
+        return true;
+    }
+
+    const int32_t head = android_atomic_acquire_load(&mHead);
+    int32_t tail = mTail;
+    while (tail != head) {
+        const nsecs_t timestamp = mQueue[tail & (QUEUE_SIZE - 1)];
+        android_atomic_release_store(++tail, &mTail);
+
+        const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (!isValid(timestamp, now, mFlinger->getPrimaryVsyncPeriod())) {
+            ATRACE_INT("RejectedVsync", ++mRejected & 1);
+            ALOGV("rejected vsync %" PRId64 " (last %" PRId64 ")",
+                    timestamp, mLastTimestamp);
+            continue;
+        }
+        mLastTimestamp = timestamp;
+        mAccepted++;
+        mFlinger->onPrimaryHWVsync(timestamp);
+    }
+    return true;
+}
+
+bool HWVsyncThread::isValid(nsecs_t timestamp, nsecs_t now,
+        nsecs_t period) const {
+    if (timestamp <= mLastTimestamp) {
+        return false;
+    }
+    if (period <= 0) {
+        return true;
+    }
+    return (mLastTimestamp == 0 || timestamp - mLastTimestamp >= period / 2) &&
+            timestamp <= now + period;
+}
+
+void HWVsyncThread::dump(String8& result) const {
+    result.appendFormat("  %u accepted, %u rejected, %d dropped, "
+            "last %" PRId64 "\n", mAccepted, mRejected,
+            android_atomic_acquire_load(&mDropped), mLastTimestamp);
+}
+
+} // namespace android
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HWVSYNCTHREAD_H
+#define ANDROID_HWVSYNCTHREAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+class SurfaceFlinger;
+class String8;
+
+/*
+ * HWVsyncThread hands the hardware vsync timestamps of the primary display
+ * from the HWComposer callback thread to a SCHED_FIFO thread of its own,
+ * which feeds them to SurfaceFlinger.
+ *
+ * The callback side, queueVsync(), never takes a lock: timestamps go
+ * through a single-producer single-consumer ring and the thread is woken
+ * through an eventfd. If the thread falls behind, the newest timestamps are
+ * dropped rather than blocking the HAL.
+ *
+ * Before being used, a timestamp must be later than the last accepted one,
+ * at least half a period after it, and not more than a period in the
+ * future; the others are counted and discarded.
+ */
+class HWVsyncThread : public Thread {
+public:
+    HWVsyncThread(const sp<SurfaceFlinger>& flinger);
+    virtual ~HWVsyncThread();
+
+    // called from the HWComposer callback thread only
+    void queueVsync(nsecs_t timestamp);
+
+    void dump(String8& result) const;
+
+private:
+    enum { QUEUE_SIZE = 16 };   // must be a power of two
+
+    virtual status_t readyToRun();
+    virtual bool threadLoop();
+
+    // whether the timestamp looks like a real vsync given the last one
+    bool isValid(nsecs_t timestamp, nsecs_t now, nsecs_t period) const;
+
+    sp<SurfaceFlinger> mFlinger;
+    int mEventFd;
+
+    // written by the producer, read by the consumer
+    nsecs_t mQueue[QUEUE_SIZE];
+    volatile int32_t mHead;
+    // written by the consumer, read by the producer
+    volatile int32_t mTail;
+    volatile int32_t mDropped;
+
+    // only used from this thread, except by dump()
+    nsecs_t mLastTimestamp;
+    uint32_t mAccepted;
+    uint32_t mRejected;
+};
+
+}
+
+#endif // ANDROID_HWVSYNCTHREAD_H
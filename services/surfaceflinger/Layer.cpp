@@ -36,6 +36,8 @@
 
 #include <gui/Surface.h>
 
+#include <private/gui/SyncFeatures.h>
+
 #include "clz.h"
 #include "Colorizer.h"
 #include "DisplayDevice.h"
@@ -53,11 +55,21 @@ namespace android {
 
 // ---------------------------------------------------------------------------
 
+#ifdef TARGET_DISABLE_TRIPLE_BUFFERING
+#warning "disabling triple buffering"
+static const int kDefaultMaxBufferCount = 2;
+#else
+static const int kDefaultMaxBufferCount = 3;
+#endif
+
 int32_t Layer::sSequence = 1;
 
 Layer::Layer(SurfaceFlinger* flinger, const sp<Client>& client,
         const String8& name, uint32_t w, uint32_t h, uint32_t flags)
     :   contentDirty(false),
+        visibleRegionsDirty(true),
+        visibleRegionsZIndex(-1),
+        visibleRegionsLayerStack(0),
         sequence(uint32_t(android_atomic_inc(&sSequence))),
         mFlinger(flinger),
         mTextureName(-1U),
@@ -68,21 +80,29 @@ Layer::Layer(SurfaceFlinger* flinger, const sp<Client>& client,
         mTransactionFlags(0),
         mQueuedFrames(0),
         mSidebandStreamChanged(false),
+        mDrawSequence(0),
         mCurrentTransform(0),
         mCurrentScalingMode(NATIVE_WINDOW_SCALING_MODE_FREEZE),
         mCurrentOpacity(true),
         mRefreshPending(false),
         mFrameLatencyNeeded(false),
+        mIgnoreSurfaceDamage(false),
         mFiltering(false),
         mNeedsFiltering(false),
         mMesh(Mesh::TRIANGLE_FAN, 4, 2, 2),
+        mMeshCacheNext(0),
+        mGeometryGeneration(1),
         mSecure(false),
         mProtectedByApp(false),
         mHasSurface(false),
         mClientRef(client),
-        mPotentialCursor(false)
+        mPotentialCursor(false),
+        mBufferBudgetReduced(false)
 {
     mCurrentCrop.makeInvalid();
+    for (size_t i=0 ; i<MESH_CACHE_SIZE ; i++) {
+        mMeshCache[i].geometryGeneration = 0;
+    }
     mFlinger->getRenderEngine().genTextures(1, &mTextureName);
     mTexture.init(Texture::TEXTURE_EXTERNAL, mTextureName);
 
@@ -127,12 +147,15 @@ void Layer::onFirstRef() {
     mSurfaceFlingerConsumer->setContentsChangedListener(this);
     mSurfaceFlingerConsumer->setName(mName);
 
-#ifdef TARGET_DISABLE_TRIPLE_BUFFERING
-#warning "disabling triple buffering"
-    mSurfaceFlingerConsumer->setDefaultMaxBufferCount(2);
-#else
-    mSurfaceFlingerConsumer->setDefaultMaxBufferCount(3);
-#endif
+    mSurfaceFlingerConsumer->setDefaultMaxBufferCount(kDefaultMaxBufferCount);
+    if (mFlinger->mDropLateFrames) {
+        mSurfaceFlingerConsumer->setDropLateFrames(true);
+    }
+    if (mFlinger->mAsyncFrameAvailable) {
+        // onFrameAvailable counts the queued frames, so they can't be
+        // coalesced
+        mSurfaceFlingerConsumer->setAsyncFrameAvailable(true);
+    }
 
     const sp<const DisplayDevice> hw(mFlinger->getDefaultDisplayDevice());
     updateTransformHint(hw);
@@ -144,6 +167,7 @@ Layer::~Layer() {
         c->detachLayer(this);
     }
     mFlinger->deleteTextureAsync(mTextureName);
+    mFlinger->releaseBufferAsync(mActiveBuffer);
     mFrameTracker.logAndResetStats(mName);
 }
 
@@ -160,6 +184,7 @@ void Layer::onLayerDisplayed(const sp<const DisplayDevice>& /* hw */,
 }
 
 void Layer::onFrameAvailable() {
+    mQueueCadence.addFrame(systemTime());
     android_atomic_inc(&mQueuedFrames);
     mFlinger->signalLayerUpdate();
 }
@@ -266,6 +291,41 @@ Rect Layer::getContentCrop() const {
     return crop;
 }
 
+Rect Layer::computeSurfaceDamage() const {
+    const State& s(getDrawingState());
+    const Rect bounds(s.active.w, s.active.h);
+    Rect damage(mSurfaceFlingerConsumer->getCurrentSurfaceDamage());
+    if (!damage.isValid() || mSurfaceFlingerConsumer->getTransformToDisplayInverse()) {
+        return bounds;
+    }
+
+    // the content crop of the buffer, once transformed, is scaled to the
+    // layer's size
+    const Rect crop(getContentCrop());
+    if (!damage.intersect(crop, &damage)) {
+        return Rect();
+    }
+    damage.offsetBy(-crop.left, -crop.top);
+    int32_t srcWidth = crop.getWidth();
+    int32_t srcHeight = crop.getHeight();
+    damage = damage.transform(mCurrentTransform, srcWidth, srcHeight);
+    if (mCurrentTransform & NATIVE_WINDOW_TRANSFORM_ROT_90) {
+        swap(srcWidth, srcHeight);
+    }
+    if (srcWidth != int32_t(s.active.w) || srcHeight != int32_t(s.active.h)) {
+        // round outwards, and grow by a pixel for filtering
+        damage = Rect(
+                damage.left * int32_t(s.active.w) / srcWidth - 1,
+                damage.top * int32_t(s.active.h) / srcHeight - 1,
+                (damage.right * int32_t(s.active.w) + srcWidth - 1) / srcWidth + 1,
+                (damage.bottom * int32_t(s.active.h) + srcHeight - 1) / srcHeight + 1);
+    }
+    if (!damage.intersect(bounds, &damage)) {
+        return Rect();
+    }
+    return damage;
+}
+
 static Rect reduce(const Rect& win, const Region& exclude) {
     if (CC_LIKELY(exclude.isEmpty())) {
         return win;
@@ -497,6 +557,12 @@ void Layer::setAcquireFence(const sp<const DisplayDevice>& /* hw */,
 
 Rect Layer::getPosition(
     const sp<const DisplayDevice>& hw)
+{
+    return getPosition(hw, getCurrentState().transform);
+}
+
+Rect Layer::getPosition(
+    const sp<const DisplayDevice>& hw, const Transform& transform)
 {
     // this gives us only the "orientation" component of the transform
     const State& s(getCurrentState());
@@ -509,7 +575,7 @@ Rect Layer::getPosition(
     }
     // subtract the transparent region and snap to the bounds
     Rect bounds = reduce(win, s.activeTransparentRegion);
-    Rect frame(s.transform.transform(bounds));
+    Rect frame(transform.transform(bounds));
     frame.intersect(hw->getViewport(), &frame);
     const Transform& tr(hw->getTransform());
     return Rect(tr.transform(frame));
@@ -520,15 +586,18 @@ Rect Layer::getPosition(
 // ---------------------------------------------------------------------------
 
 void Layer::draw(const sp<const DisplayDevice>& hw, const Region& clip) const {
+    Mutex::Autolock lock(mDrawLock);
     onDraw(hw, clip, false);
 }
 
 void Layer::draw(const sp<const DisplayDevice>& hw,
         bool useIdentityTransform) const {
+    Mutex::Autolock lock(mDrawLock);
     onDraw(hw, Region(hw->bounds()), useIdentityTransform);
 }
 
 void Layer::draw(const sp<const DisplayDevice>& hw) const {
+    Mutex::Autolock lock(mDrawLock);
     onDraw(hw, Region(hw->bounds()), false);
 }
 
@@ -565,9 +634,21 @@ void Layer::onDraw(const sp<const DisplayDevice>& hw, const Region& clip,
         return;
     }
 
+    RenderEngine& engine(mFlinger->getRenderEngine());
+
     // Bind the current buffer to the GL texture, and wait for it to be
     // ready for us to draw into.
-    status_t err = mSurfaceFlingerConsumer->bindTextureImage();
+    status_t err;
+    if (engine.getEGLContext() == mFlinger->mEGLContext) {
+        err = mSurfaceFlingerConsumer->bindTextureImage();
+    } else {
+        // We're on a composition thread: our context shares the texture
+        // that updateTexImage() bound on the main context, but the
+        // GLConsumer can only bind it there, so just have our context wait
+        // for the buffer.
+        err = SyncFeatures::getInstance().waitForFence(mFlinger->mEGLDisplay,
+                mSurfaceFlingerConsumer->getCurrentFence(), "Layer::onDraw");
+    }
     if (err != NO_ERROR) {
         ALOGW("onDraw: bindTextureImage failed (err=%d)", err);
         // Go ahead and draw the buffer anyway; no matter what we do the screen
@@ -576,8 +657,6 @@ void Layer::onDraw(const sp<const DisplayDevice>& hw, const Region& clip,
 
     bool blackOutLayer = isProtected() || (isSecure() && !hw->isSecure());
 
-    RenderEngine& engine(mFlinger->getRenderEngine());
-
     if (!blackOutLayer) {
         // TODO: we could be more subtle with isFixedSize()
         const bool useFiltering = getFiltering() || needsFiltering(hw) || isFixedSize();
@@ -641,14 +720,41 @@ void Layer::clearWithOpenGL(const sp<const DisplayDevice>& hw,
 
 void Layer::clearWithOpenGL(
         const sp<const DisplayDevice>& hw, const Region& clip) const {
+    Mutex::Autolock lock(mDrawLock);
     clearWithOpenGL(hw, clip, 0,0,0,0);
 }
 
-void Layer::drawWithOpenGL(const sp<const DisplayDevice>& hw,
-        const Region& /* clip */, bool useIdentityTransform) const {
-    const uint32_t fbHeight = hw->getHeight();
-    const State& s(getDrawingState());
+static bool sameTransform(const Transform& a, const Transform& b) {
+    for (size_t i=0 ; i<3 ; i++) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Layer::updateMeshLocked(const sp<const DisplayDevice>& hw,
+        bool useIdentityTransform) const {
+    const Transform& hwTransform(hw->getTransform());
+    const uint32_t hwHeight = hw->getHeight();
+    Mesh::VertexArray<vec2> position(mMesh.getPositionArray<vec2>());
+    Mesh::VertexArray<vec2> texCoords(mMesh.getTexCoordArray<vec2>());
 
+    for (size_t i=0 ; i<MESH_CACHE_SIZE ; i++) {
+        const MeshCacheEntry& entry(mMeshCache[i]);
+        if (entry.geometryGeneration == mGeometryGeneration &&
+                entry.useIdentityTransform == useIdentityTransform &&
+                entry.displayHeight == hwHeight &&
+                sameTransform(entry.displayTransform, hwTransform)) {
+            for (size_t v=0 ; v<4 ; v++) {
+                position[v] = entry.positions[v];
+                texCoords[v] = entry.texCoords[v];
+            }
+            return;
+        }
+    }
+
+    const State& s(getDrawingState());
     computeGeometry(hw, mMesh, useIdentityTransform);
 
     /*
@@ -674,12 +780,29 @@ void Layer::drawWithOpenGL(const sp<const DisplayDevice>& hw,
 
     // TODO: we probably want to generate the texture coords with the mesh
     // here we assume that we only have 4 vertices
-    Mesh::VertexArray<vec2> texCoords(mMesh.getTexCoordArray<vec2>());
     texCoords[0] = vec2(left, 1.0f - top);
     texCoords[1] = vec2(left, 1.0f - bottom);
     texCoords[2] = vec2(right, 1.0f - bottom);
     texCoords[3] = vec2(right, 1.0f - top);
 
+    MeshCacheEntry& entry(mMeshCache[mMeshCacheNext]);
+    mMeshCacheNext = (mMeshCacheNext + 1) % MESH_CACHE_SIZE;
+    entry.geometryGeneration = mGeometryGeneration;
+    entry.useIdentityTransform = useIdentityTransform;
+    entry.displayHeight = hwHeight;
+    entry.displayTransform = hwTransform;
+    for (size_t v=0 ; v<4 ; v++) {
+        entry.positions[v] = position[v];
+        entry.texCoords[v] = texCoords[v];
+    }
+}
+
+void Layer::drawWithOpenGL(const sp<const DisplayDevice>& hw,
+        const Region& /* clip */, bool useIdentityTransform) const {
+    const State& s(getDrawingState());
+
+    updateMeshLocked(hw, useIdentityTransform);
+
     RenderEngine& engine(mFlinger->getRenderEngine());
     engine.setupLayerBlending(mPremultipliedAlpha, isOpaque(s), s.alpha);
     engine.drawMesh(mMesh);
@@ -698,6 +821,9 @@ uint32_t Layer::getProducerStickyTransform() const {
 }
 
 void Layer::setFiltering(bool filtering) {
+    if (mFiltering != filtering) {
+        mDrawSequence++;
+    }
     mFiltering = filtering;
 }
 
@@ -809,6 +935,8 @@ void Layer::setVisibleNonTransparentRegion(const Region&
 uint32_t Layer::doTransaction(uint32_t flags) {
     ATRACE_CALL();
 
+    mDrawSequence++;
+
     const Layer::State& s(getDrawingState());
     const Layer::State& c(getCurrentState());
 
@@ -908,6 +1036,13 @@ uint32_t Layer::doTransaction(uint32_t flags) {
 }
 
 void Layer::commitTransaction() {
+    const State& s(getDrawingState());
+    const State& c(getCurrentState());
+    if (s.active != c.active || !sameTransform(s.transform, c.transform) ||
+            !s.activeTransparentRegion.isTriviallyEqual(
+                    c.activeTransparentRegion)) {
+        mGeometryGeneration++;
+    }
     mDrawingState = mCurrentState;
 }
 
@@ -990,6 +1125,39 @@ bool Layer::setLayerStack(uint32_t layerStack) {
     return true;
 }
 
+bool Layer::wouldChangeState(const layer_state_t& s) const {
+    const uint32_t what = s.what;
+    if ((what & layer_state_t::ePositionChanged) &&
+            (mCurrentState.transform.tx() != s.x ||
+             mCurrentState.transform.ty() != s.y))
+        return true;
+    if ((what & layer_state_t::eLayerChanged) && mCurrentState.z != s.z)
+        return true;
+    if ((what & layer_state_t::eSizeChanged) &&
+            (mCurrentState.requested.w != s.w ||
+             mCurrentState.requested.h != s.h))
+        return true;
+    if ((what & layer_state_t::eAlphaChanged) &&
+            mCurrentState.alpha != uint8_t(255.0f*s.alpha+0.5f))
+        return true;
+    // like their setters, these are always taken as changes
+    if (what & (layer_state_t::eMatrixChanged |
+            layer_state_t::eTransparentRegionChanged))
+        return true;
+    if ((what & (layer_state_t::eVisibilityChanged |
+            layer_state_t::eOpacityChanged)) &&
+            mCurrentState.flags !=
+                    ((mCurrentState.flags & ~s.mask) | (s.flags & s.mask)))
+        return true;
+    if ((what & layer_state_t::eCropChanged) &&
+            !(mCurrentState.requested.crop == s.crop))
+        return true;
+    if ((what & layer_state_t::eLayerStackChanged) &&
+            mCurrentState.layerStack != s.layerStack)
+        return true;
+    return false;
+}
+
 // ----------------------------------------------------------------------------
 // pageflip handling...
 // ----------------------------------------------------------------------------
@@ -1035,6 +1203,28 @@ bool Layer::isVisible() const {
             && (mActiveBuffer != NULL || mSidebandStream != NULL);
 }
 
+bool Layer::canPrelatch() const
+{
+    // see latchBuffer()
+    return mQueuedFrames > 0 && !mRefreshPending && !mSidebandStreamChanged;
+}
+
+void Layer::prelatchBuffer()
+{
+    mSurfaceFlingerConsumer->prelatch(mFlinger->mPrimaryDispSync);
+}
+
+int32_t Layer::consumeQueuedFrames(uint64_t count) {
+    // onFrameAvailable() may not have counted the latest frames yet, so
+    // never go below zero
+    int32_t queued, remaining;
+    do {
+        queued = mQueuedFrames;
+        remaining = count < uint64_t(queued) ? queued - int32_t(count) : 0;
+    } while (android_atomic_cmpxchg(queued, remaining, &mQueuedFrames));
+    return remaining;
+}
+
 Region Layer::latchBuffer(bool& recomputeVisibleRegions)
 {
     ATRACE_CALL();
@@ -1174,8 +1364,16 @@ Region Layer::latchBuffer(bool& recomputeVisibleRegions)
         Reject r(mDrawingState, getCurrentState(), recomputeVisibleRegions,
                 getProducerStickyTransform() != 0);
 
+        const Geometry oldActive(mDrawingState.active);
+        const Region oldTransparentRegion(mDrawingState.activeTransparentRegion);
         status_t updateResult = mSurfaceFlingerConsumer->updateTexImage(&r,
                 mFlinger->mPrimaryDispSync);
+        if (mDrawingState.active != oldActive ||
+                !mDrawingState.activeTransparentRegion.isTriviallyEqual(
+                        oldTransparentRegion)) {
+            // the rejecter latched a new size or transparent region
+            mGeometryGeneration++;
+        }
         if (updateResult == BufferQueue::PRESENT_LATER) {
             // Producer doesn't want buffer to be displayed yet.  Signal a
             // layer update so we check again at the next opportunity.
@@ -1183,15 +1381,21 @@ Region Layer::latchBuffer(bool& recomputeVisibleRegions)
             return outDirtyRegion;
         }
 
-        // Decrement the queued-frames count.  Signal another event if we
-        // have more frames pending.
-        if (android_atomic_dec(&mQueuedFrames) > 1) {
+        // Decrement the queued-frames count, including the frames the
+        // BufferQueue skipped on the way.  Signal another event if we have
+        // more frames pending.
+        if (consumeQueuedFrames(
+                mSurfaceFlingerConsumer->getSkippedFrameCount() + 1) > 0) {
             mFlinger->signalLayerUpdate();
         }
 
+        mDrawSequence++;
+
         if (updateResult != NO_ERROR) {
             // something happened!
             recomputeVisibleRegions = true;
+            // the next buffer's damage is relative to one we never showed
+            mIgnoreSurfaceDamage = true;
             return outDirtyRegion;
         }
 
@@ -1237,8 +1441,15 @@ Region Layer::latchBuffer(bool& recomputeVisibleRegions)
             recomputeVisibleRegions = true;
         }
 
-        // FIXME: postedRegion should be dirty & bounds
-        Region dirtyRegion(Rect(s.active.w, s.active.h));
+        // only what the producer reported as damaged needs to be redrawn,
+        // unless the way the buffer is mapped to the layer changed
+        Region dirtyRegion;
+        if (recomputeVisibleRegions || mIgnoreSurfaceDamage) {
+            dirtyRegion.set(Rect(s.active.w, s.active.h));
+        } else {
+            dirtyRegion.set(computeSurfaceDamage());
+        }
+        mIgnoreSurfaceDamage = false;
 
         // transform the dirty region to window-manager space
         outDirtyRegion = (s.transform.transform(dirtyRegion));
@@ -1318,9 +1529,12 @@ void Layer::dump(String8& result, Colorizer& colorizer) const
     result.appendFormat(
             "      "
             "format=%2d, activeBuffer=[%4ux%4u:%4u,%3X],"
-            " queued-frames=%d, mRefreshPending=%d\n",
+            " queued-frames=%d, mRefreshPending=%d\n"
+            "      buffer memory=%zu KB%s\n",
             mFormat, w0, h0, s0,f0,
-            mQueuedFrames, mRefreshPending);
+            mQueuedFrames, mRefreshPending,
+            getAllocatedBufferBytes() / 1024,
+            mBufferBudgetReduced ? " (over budget, double buffered)" : "");
 
     if (mSurfaceFlingerConsumer != 0) {
         mSurfaceFlingerConsumer->dump(result, "            ");
@@ -1331,8 +1545,18 @@ void Layer::dumpFrameStats(String8& result) const {
     mFrameTracker.dumpStats(result);
 }
 
+void Layer::dumpBufferQueueStats(String8& result) const {
+    if (mSurfaceFlingerConsumer != 0) {
+        mSurfaceFlingerConsumer->dumpLatencyStats(result, false);
+    }
+}
+
 void Layer::clearFrameStats() {
     mFrameTracker.clearStats();
+    if (mSurfaceFlingerConsumer != 0) {
+        String8 discarded;
+        mSurfaceFlingerConsumer->dumpLatencyStats(discarded, true);
+    }
 }
 
 void Layer::logFrameStats() {
@@ -1343,6 +1567,34 @@ void Layer::getFrameStats(FrameStats* outStats) const {
     mFrameTracker.getStats(outStats);
 }
 
+nsecs_t Layer::getQueuePeriod(nsecs_t now) const {
+    return mQueueCadence.getPeriod(now, RefreshRatePolicy::IDLE_TIMEOUT);
+}
+
+void Layer::getFrameStatInfo(FrameStatInfo* outInfo) const {
+    mFrameTracker.getStatInfo(outInfo);
+}
+
+void Layer::setFrameHistoryDepth(size_t numFrames) {
+    mFrameTracker.setHistoryDepth(numFrames);
+}
+
+size_t Layer::getAllocatedBufferBytes() const {
+    if (mSurfaceFlingerConsumer == 0) {
+        return 0;
+    }
+    return mSurfaceFlingerConsumer->getAllocatedBytes();
+}
+
+void Layer::setBufferBudgetReduced(bool reduced) {
+    if (reduced == mBufferBudgetReduced || mSurfaceFlingerConsumer == 0) {
+        return;
+    }
+    mBufferBudgetReduced = reduced;
+    mSurfaceFlingerConsumer->setDefaultMaxBufferCount(
+            reduced ? 2 : kDefaultMaxBufferCount);
+}
+
 // ---------------------------------------------------------------------------
 
 Layer::LayerCleaner::LayerCleaner(const sp<SurfaceFlinger>& flinger,
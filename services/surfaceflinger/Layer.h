@@ -27,6 +27,7 @@
 #include <utils/String8.h>
 #include <utils/Timers.h>
 
+#include <ui/FrameStatInfo.h>
 #include <ui/FrameStats.h>
 #include <ui/GraphicBuffer.h>
 #include <ui/PixelFormat.h>
@@ -39,6 +40,7 @@
 #include "FrameTracker.h"
 #include "Client.h"
 #include "MonitoredProducer.h"
+#include "RefreshRatePolicy.h"
 #include "SurfaceFlinger.h"
 #include "SurfaceFlingerConsumer.h"
 #include "Transform.h"
@@ -77,6 +79,19 @@ public:
     Region coveredRegion;
     Region visibleNonTransparentRegion;
 
+    // visibleRegionsDirty is set when the layer's geometry, opacity or
+    // visibility changed since visible regions were last computed, in which
+    // case it and every layer below it in its layer stack are recomputed.
+    bool visibleRegionsDirty;
+    // State of the last visible region computation, which lets the next one
+    // skip this layer if nothing above it changed: the opaque and covered
+    // regions of this layer together with all the layers above it, the
+    // layer's index in layersSortedByZ and its layer stack.
+    Region accumulatedOpaqueRegion;
+    Region accumulatedCoveredRegion;
+    ssize_t visibleRegionsZIndex;
+    uint32_t visibleRegionsLayerStack;
+
     // Layer serial number.  This gives layers an explicit ordering, so we
     // have a stable sort order when their layer stack and Z-order are
     // the same.
@@ -136,6 +151,8 @@ public:
     bool setFlags(uint8_t flags, uint8_t mask);
     bool setCrop(const Rect& crop);
     bool setLayerStack(uint32_t layerStack);
+    // whether applying s with the setters above would change anything
+    bool wouldChangeState(const layer_state_t& s) const;
 
     uint32_t getTransactionFlags(uint32_t flags);
     uint32_t setTransactionFlags(uint32_t flags);
@@ -184,6 +201,11 @@ public:
      */
     virtual bool isFixedSize() const;
 
+    /*
+     * isDim - true if this layer only darkens what's beneath it
+     */
+    virtual bool isDim() const              { return false; }
+
 protected:
     /*
      * onDraw - draws the surface.
@@ -194,14 +216,17 @@ protected:
 public:
     // -----------------------------------------------------------------------
 
-    void setGeometry(const sp<const DisplayDevice>& hw,
+    virtual void setGeometry(const sp<const DisplayDevice>& hw,
             HWComposer::HWCLayerInterface& layer);
-    void setPerFrameData(const sp<const DisplayDevice>& hw,
+    virtual void setPerFrameData(const sp<const DisplayDevice>& hw,
             HWComposer::HWCLayerInterface& layer);
     void setAcquireFence(const sp<const DisplayDevice>& hw,
             HWComposer::HWCLayerInterface& layer);
 
     Rect getPosition(const sp<const DisplayDevice>& hw);
+    // the position the layer would have on hw with the given transform
+    Rect getPosition(const sp<const DisplayDevice>& hw,
+            const Transform& transform);
 
     /*
      * called after page-flip
@@ -220,6 +245,12 @@ public:
      */
     void onPostComposition();
 
+    /*
+     * returns the recent interval between the buffers queued to this
+     * layer, or 0 if it hasn't queued any for a while.
+     */
+    nsecs_t getQueuePeriod(nsecs_t now) const;
+
     /*
      * draw - performs some global clipping optimizations
      * and calls onDraw().
@@ -262,6 +293,19 @@ public:
      */
     Region latchBuffer(bool& recomputeVisibleRegions);
 
+    /*
+     * canPrelatch - called from the main thread, returns whether the next
+     * latchBuffer() will latch a queued buffer that prelatchBuffer() can
+     * acquire ahead of time.
+     */
+    bool canPrelatch() const;
+
+    /*
+     * prelatchBuffer - acquires the buffer the next latchBuffer() latches
+     * and creates its EGLImage. Called from the PrelatchThread.
+     */
+    void prelatchBuffer();
+
     bool isPotentialCursor() const { return mPotentialCursor;}
 
     /*
@@ -281,6 +325,12 @@ public:
      */
     Rect getContentCrop() const;
 
+    /*
+     * returns the part of the layer, in layer coordinates, that changed with
+     * the current buffer according to the damage its producer reported.
+     */
+    Rect computeSurfaceDamage() const;
+
     /*
      * Returns if a frame is queued.
      */
@@ -295,6 +345,10 @@ public:
     // only for debugging
     inline const sp<GraphicBuffer>& getActiveBuffer() const { return mActiveBuffer; }
 
+    // changes whenever what draw() renders may have changed, that is on
+    // every transaction and every latched buffer
+    inline uint32_t getDrawSequence() const { return mDrawSequence; }
+
     inline  const State&    getDrawingState() const { return mDrawingState; }
     inline  const State&    getCurrentState() const { return mCurrentState; }
     inline  State&          getCurrentState()       { return mCurrentState; }
@@ -303,9 +357,24 @@ public:
     /* always call base class first */
     void dump(String8& result, Colorizer& colorizer) const;
     void dumpFrameStats(String8& result) const;
+    void dumpBufferQueueStats(String8& result) const;
     void clearFrameStats();
     void logFrameStats();
     void getFrameStats(FrameStats* outStats) const;
+    void getFrameStatInfo(FrameStatInfo* outInfo) const;
+    void setFrameHistoryDepth(size_t numFrames);
+
+    sp<Client> getClient() const { return mClientRef.promote(); }
+
+    // memory used by the buffers of this layer's BufferQueue, see
+    // SurfaceFlingerConsumer::getAllocatedBytes()
+    size_t getAllocatedBufferBytes() const;
+    // Lowers the number of buffers of this layer's BufferQueue to two, for
+    // layers of clients over their memory budget. A free extra buffer is
+    // dropped right away; the producer lets go of it on its next dequeue.
+    // Main thread only.
+    void setBufferBudgetReduced(bool reduced);
+    bool isBufferBudgetReduced() const { return mBufferBudgetReduced; }
 
 protected:
     // constant
@@ -345,12 +414,19 @@ private:
     // drawing
     void clearWithOpenGL(const sp<const DisplayDevice>& hw, const Region& clip,
             float r, float g, float b, float alpha) const;
+    // loads mMesh with the vertices to draw the layer on hw; mDrawLock
+    // must be held
+    void updateMeshLocked(const sp<const DisplayDevice>& hw,
+            bool useIdentityTransform) const;
     void drawWithOpenGL(const sp<const DisplayDevice>& hw, const Region& clip,
             bool useIdentityTransform) const;
 
     // Temporary - Used only for LEGACY camera mode.
     uint32_t getProducerStickyTransform() const;
 
+    // removes count frames from mQueuedFrames and returns how many are left
+    int32_t consumeQueuedFrames(uint64_t count);
+
 
     // -----------------------------------------------------------------------
 
@@ -372,8 +448,10 @@ private:
     volatile int32_t mQueuedFrames;
     volatile int32_t mSidebandStreamChanged; // used like an atomic boolean
     FrameTracker mFrameTracker;
+    FrameCadence mQueueCadence;
 
     // main thread
+    uint32_t mDrawSequence;
     sp<GraphicBuffer> mActiveBuffer;
     sp<NativeHandle> mSidebandStream;
     Rect mCurrentCrop;
@@ -382,14 +460,37 @@ private:
     bool mCurrentOpacity;
     bool mRefreshPending;
     bool mFrameLatencyNeeded;
+    // Whether the surface damage of the next latched buffer can't be trusted
+    // because the previous buffer couldn't be latched
+    bool mIgnoreSurfaceDamage;
     // Whether filtering is forced on or not
     bool mFiltering;
     // Whether filtering is needed b/c of the drawingstate
     bool mNeedsFiltering;
     // The mesh used to draw the layer in GLES composition mode
     mutable Mesh mMesh;
+    // The vertices drawWithOpenGL() computed for the last displays it drew
+    // on, reused until the drawing state's geometry or the display's
+    // transform changes
+    struct MeshCacheEntry {
+        uint32_t geometryGeneration;
+        bool useIdentityTransform;
+        uint32_t displayHeight;
+        Transform displayTransform;
+        vec2 positions[4];
+        vec2 texCoords[4];
+    };
+    enum { MESH_CACHE_SIZE = 2 };
+    mutable MeshCacheEntry mMeshCache[MESH_CACHE_SIZE];
+    mutable size_t mMeshCacheNext;
+    // changes whenever the drawing state's size, crop, transparent region
+    // or transform does (main thread); 0 marks the unused cache entries
+    uint32_t mGeometryGeneration;
     // The texture used to draw the layer in GLES composition mode
     mutable Texture mTexture;
+    // Serializes draws of this layer (and so mMesh and mTexture) when
+    // displays sharing a layer stack are composed on separate threads
+    mutable Mutex mDrawLock;
 
     // page-flip thread (currently main thread)
     bool mSecure; // no screenshots
@@ -403,6 +504,8 @@ private:
 
     // This layer can be a cursor on some displays.
     bool mPotentialCursor;
+
+    bool mBufferBudgetReduced;
 };
 
 // ---------------------------------------------------------------------------
@@ -16,6 +16,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include <utils/Errors.h>
@@ -58,6 +59,78 @@ bool LayerDim::isVisible() const {
     return !(s.flags & layer_state_t::eLayerHidden) && s.alpha;
 }
 
+void LayerDim::setGeometry(const sp<const DisplayDevice>& hw,
+        HWComposer::HWCLayerInterface& layer)
+{
+    const sp<GraphicBuffer>& buffer(mFlinger->mDimLayerBuffer);
+    if (buffer == NULL) {
+        Layer::setGeometry(hw, layer);
+        return;
+    }
+
+    // the HWC scales the black buffer to the frame and blends it with the
+    // plane alpha; HWCs older than 1.2 skip the layer for its plane alpha,
+    // which leaves it to GLES
+    layer.setDefaultState();
+    layer.setSkip(false);
+    layer.setBlending(HWC_BLENDING_PREMULT);
+
+    const State& s(getDrawingState());
+    Rect frame(s.transform.transform(computeBounds()));
+    frame.intersect(hw->getViewport(), &frame);
+    const Transform& tr(hw->getTransform());
+    layer.setFrame(tr.transform(frame));
+    layer.setCrop(FloatRect(0, 0, buffer->getWidth(), buffer->getHeight()));
+    layer.setPlaneAlpha(s.alpha);
+
+    // the buffer is uniform, so only whether the frame is still a rectangle
+    // on the display matters
+    const Transform transform(tr * s.transform);
+    if (transform.getOrientation() & Transform::ROT_INVALID) {
+        layer.setSkip(true);
+    }
+}
+
+void LayerDim::setPerFrameData(const sp<const DisplayDevice>& hw,
+        HWComposer::HWCLayerInterface& layer)
+{
+    const sp<GraphicBuffer>& buffer(mFlinger->mDimLayerBuffer);
+    if (buffer == NULL) {
+        Layer::setPerFrameData(hw, layer);
+        return;
+    }
+
+    const Transform& tr = hw->getTransform();
+    Region visible = tr.transform(visibleRegion.intersect(hw->getViewport()));
+    layer.setVisibleRegionScreen(visible);
+    // the buffer never changes, so the HWC's release fences don't matter
+    layer.setBuffer(buffer);
+}
+
+sp<GraphicBuffer> LayerDim::createHwcBuffer()
+{
+    // big enough for display controllers that can't scale up tiny buffers
+    const uint32_t size = 16;
+    sp<GraphicBuffer> buffer(new GraphicBuffer(size, size,
+            PIXEL_FORMAT_RGBX_8888,
+            GraphicBuffer::USAGE_HW_COMPOSER |
+            GraphicBuffer::USAGE_HW_TEXTURE |
+            GraphicBuffer::USAGE_SW_WRITE_RARELY));
+    if (buffer->initCheck() != NO_ERROR) {
+        ALOGE("LayerDim: failed to allocate the HWC buffer");
+        return NULL;
+    }
+
+    void* vaddr;
+    if (buffer->lock(GraphicBuffer::USAGE_SW_WRITE_RARELY, &vaddr) != NO_ERROR) {
+        ALOGE("LayerDim: failed to lock the HWC buffer");
+        return NULL;
+    }
+    memset(vaddr, 0, buffer->getStride() * size * 4);
+    buffer->unlock();
+    return buffer;
+}
+
 
 // ---------------------------------------------------------------------------
 
@@ -40,6 +40,16 @@ public:
     virtual bool isSecure() const         { return false; }
     virtual bool isFixedSize() const      { return true; }
     virtual bool isVisible() const;
+    virtual bool isDim() const            { return true; }
+
+    virtual void setGeometry(const sp<const DisplayDevice>& hw,
+            HWComposer::HWCLayerInterface& layer);
+    virtual void setPerFrameData(const sp<const DisplayDevice>& hw,
+            HWComposer::HWCLayerInterface& layer);
+
+    // createHwcBuffer returns the buffer dim layers give the HWC, opaque
+    // black, or NULL if it can't be allocated
+    static sp<GraphicBuffer> createHwcBuffer();
 };
 
 // ---------------------------------------------------------------------------
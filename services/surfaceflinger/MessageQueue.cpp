@@ -28,6 +28,7 @@
 #include <gui/BitTube.h>
 
 #include "MessageQueue.h"
+#include "DispSync.h"
 #include "EventThread.h"
 #include "SurfaceFlinger.h"
 
@@ -55,10 +56,17 @@ void MessageQueue::Handler::dispatchRefresh() {
     }
 }
 
-void MessageQueue::Handler::dispatchInvalidate() {
+bool MessageQueue::Handler::dispatchInvalidate(nsecs_t when) {
     if ((android_atomic_or(eventMaskInvalidate, &mEventMask) & eventMaskInvalidate) == 0) {
-        mQueue.mLooper->sendMessage(this, Message(MessageQueue::INVALIDATE));
+        if (when > 0) {
+            mQueue.mLooper->sendMessageAtTime(when, this,
+                    Message(MessageQueue::INVALIDATE));
+        } else {
+            mQueue.mLooper->sendMessage(this, Message(MessageQueue::INVALIDATE));
+        }
+        return true;
     }
+    return false;
 }
 
 void MessageQueue::Handler::dispatchTransaction() {
@@ -87,6 +95,9 @@ void MessageQueue::Handler::handleMessage(const Message& message) {
 // ---------------------------------------------------------------------------
 
 MessageQueue::MessageQueue()
+    : mDispSync(NULL),
+      mCompositionLead(0),
+      mInvalidateTime(0)
 {
 }
 
@@ -109,6 +120,15 @@ void MessageQueue::setEventThread(const sp<EventThread>& eventThread)
             MessageQueue::cb_eventReceiver, this);
 }
 
+void MessageQueue::setCompositionLead(DispSync* dispSync, nsecs_t lead) {
+    mDispSync = dispSync;
+    mCompositionLead = lead;
+}
+
+nsecs_t MessageQueue::getInvalidateTime() const {
+    return mInvalidateTime;
+}
+
 void MessageQueue::waitMessage() {
     do {
         IPCThreadState::self()->flushCommands();
@@ -180,19 +200,25 @@ int MessageQueue::cb_eventReceiver(int fd, int events, void* data) {
 }
 
 int MessageQueue::eventReceiver(int /*fd*/, int /*events*/) {
-    ssize_t n;
-    DisplayEventReceiver::Event buffer[8];
-    while ((n = DisplayEventReceiver::getEvents(mEventTube, buffer, 8)) > 0) {
-        for (int i=0 ; i<n ; i++) {
-            if (buffer[i].header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
+    // only the latest vsync matters if we woke up late
+    DisplayEventReceiver::Event vsync;
+    if (DisplayEventReceiver::getLatestVsync(mEventTube, &vsync, NULL) > 0) {
 #if INVALIDATE_ON_VSYNC
-                mHandler->dispatchInvalidate();
-#else
-                mHandler->dispatchRefresh();
-#endif
-                break;
+        nsecs_t when = vsync.header.timestamp;
+        if (mCompositionLead > 0 && mDispSync->getPeriod() > 0) {
+            const nsecs_t start =
+                    mDispSync->computeNextRefresh(0) - mCompositionLead;
+            if (start > when) {
+                when = start;
             }
         }
+        if (mHandler->dispatchInvalidate(
+                when > systemTime(SYSTEM_TIME_MONOTONIC) ? when : 0)) {
+            mInvalidateTime = when;
+        }
+#else
+        mHandler->dispatchRefresh();
+#endif
     }
     return 1;
 }
@@ -31,6 +31,7 @@
 
 namespace android {
 
+class DispSync;
 class IDisplayEventConnection;
 class EventThread;
 class SurfaceFlinger;
@@ -72,7 +73,8 @@ class MessageQueue {
         Handler(MessageQueue& queue) : mQueue(queue), mEventMask(0) { }
         virtual void handleMessage(const Message& message);
         void dispatchRefresh();
-        void dispatchInvalidate();
+        // returns false if an INVALIDATE message was already pending
+        bool dispatchInvalidate(nsecs_t when = 0);
         void dispatchTransaction();
     };
 
@@ -85,6 +87,12 @@ class MessageQueue {
     sp<BitTube> mEventTube;
     sp<Handler> mHandler;
 
+    // see setCompositionLead()
+    DispSync* mDispSync;
+    nsecs_t mCompositionLead;
+    // when the pending INVALIDATE message is meant to be handled, only
+    // used from the main thread
+    nsecs_t mInvalidateTime;
 
     static int cb_eventReceiver(int fd, int events, void* data);
     int eventReceiver(int fd, int events);
@@ -101,6 +109,15 @@ public:
     void init(const sp<SurfaceFlinger>& flinger);
     void setEventThread(const sp<EventThread>& events);
 
+    // Delays the INVALIDATE message sent on VSYNC until 'lead' ns before
+    // the next refresh as predicted by dispSync, so that frames are started
+    // as late as they can be. 0 sends it right away.
+    void setCompositionLead(DispSync* dispSync, nsecs_t lead);
+
+    // when the INVALIDATE message being handled was meant to be, 0 if it
+    // wasn't sent on VSYNC
+    nsecs_t getInvalidateTime() const;
+
     void waitMessage();
     status_t postMessage(const sp<MessageBase>& message, nsecs_t reltime=0);
 
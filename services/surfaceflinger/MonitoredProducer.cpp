@@ -110,6 +110,16 @@ void MonitoredProducer::allocateBuffers(bool async, uint32_t width,
     mProducer->allocateBuffers(async, width, height, format, usage);
 }
 
+status_t MonitoredProducer::getControlChannel(int* outFd) {
+    return mProducer->getControlChannel(outFd);
+}
+
+status_t MonitoredProducer::attachAndQueueBuffer(int* outSlot,
+        const sp<GraphicBuffer>& buffer, const QueueBufferInput& input,
+        QueueBufferOutput* output) {
+    return mProducer->attachAndQueueBuffer(outSlot, buffer, input, output);
+}
+
 IBinder* MonitoredProducer::onAsBinder() {
     return mProducer->asBinder().get();
 }
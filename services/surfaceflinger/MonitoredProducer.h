@@ -53,6 +53,10 @@ public:
     virtual status_t setSidebandStream(const sp<NativeHandle>& stream);
     virtual void allocateBuffers(bool async, uint32_t width, uint32_t height,
             uint32_t format, uint32_t usage);
+    virtual status_t getControlChannel(int* outFd);
+    virtual status_t attachAndQueueBuffer(int* outSlot,
+            const sp<GraphicBuffer>& buffer, const QueueBufferInput& input,
+            QueueBufferOutput* output);
     virtual IBinder* onAsBinder();
 
 private:
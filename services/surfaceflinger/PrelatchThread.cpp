@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <utils/Trace.h>
+
+#include "Layer.h"
+#include "PrelatchThread.h"
+
+namespace android {
+
+PrelatchThread::PrelatchThread() :
+        mBusy(false) {
+}
+
+void PrelatchThread::prelatch(const Vector< sp<Layer> >& layers) {
+    Mutex::Autolock lock(mMutex);
+    mPending.appendVector(layers);
+    mCondition.broadcast();
+}
+
+void PrelatchThread::waitForCompletion() {
+    ATRACE_CALL();
+    Mutex::Autolock lock(mMutex);
+    while (mBusy || !mPending.isEmpty()) {
+        mCondition.wait(mMutex);
+    }
+}
+
+bool PrelatchThread::threadLoop() {
+    Vector< sp<Layer> > layers;
+    {
+        Mutex::Autolock lock(mMutex);
+        while (mPending.isEmpty()) {
+            mCondition.wait(mMutex);
+        }
+        layers = mPending;
+        mPending.clear();
+        mBusy = true;
+    }
+
+    ATRACE_NAME("prelatch");
+    for (size_t i=0 ; i<layers.size() ; i++) {
+        layers[i]->prelatchBuffer();
+    }
+    // drop our references before waking the main thread, which holds the
+    // last ones
+    layers.clear();
+
+    Mutex::Autolock lock(mMutex);
+    mBusy = false;
+    mCondition.broadcast();
+    return true;
+}
+
+} // namespace android
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PRELATCHTHREAD_H
+#define ANDROID_PRELATCHTHREAD_H
+
+#include <stddef.h>
+
+#include <utils/Mutex.h>
+#include <utils/Condition.h>
+#include <utils/Thread.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class Layer;
+
+/*
+ * PrelatchThread acquires the queued buffers of a set of layers, and
+ * creates their EGLImages, while the SurfaceFlinger main thread handles the
+ * transaction that precedes latching. Latching then only has to swap the
+ * buffers in.
+ *
+ * The main thread queues the layers with prelatch() and must call
+ * waitForCompletion() before latching any of them.
+ */
+class PrelatchThread : public Thread {
+public:
+    PrelatchThread();
+    virtual ~PrelatchThread() {}
+
+    // prelatch the given layers on this thread. The caller keeps its own
+    // references to them until waitForCompletion() returns, so that none
+    // of them is destroyed here.
+    void prelatch(const Vector< sp<Layer> >& layers);
+
+    // block until all the layers queued with prelatch() are done
+    void waitForCompletion();
+
+private:
+    virtual bool threadLoop();
+
+    mutable Mutex mMutex;
+    Condition mCondition;
+    Vector< sp<Layer> > mPending;
+    bool mBusy;
+};
+
+}
+
+#endif // ANDROID_PRELATCHTHREAD_H
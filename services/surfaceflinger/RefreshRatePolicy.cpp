@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+
+#include <utils/String8.h>
+
+#include "RefreshRatePolicy.h"
+
+namespace android {
+
+FrameCadence::FrameCadence() :
+        mNumTimes(0),
+        mNext(0) {
+}
+
+void FrameCadence::addFrame(nsecs_t when) {
+    Mutex::Autolock lock(mMutex);
+    mTimes[mNext] = when;
+    mNext = (mNext + 1) % NUM_FRAMES;
+    if (mNumTimes < NUM_FRAMES) {
+        mNumTimes++;
+    }
+}
+
+nsecs_t FrameCadence::getPeriod(nsecs_t now, nsecs_t timeout) const {
+    Mutex::Autolock lock(mMutex);
+    if (mNumTimes == 0) {
+        return 0;
+    }
+    const nsecs_t last = mTimes[(mNext + NUM_FRAMES - 1) % NUM_FRAMES];
+    const nsecs_t sinceLast = now - last;
+    if (sinceLast > timeout) {
+        return 0;
+    }
+    if (mNumTimes < 2) {
+        return sinceLast;
+    }
+    const nsecs_t first = mTimes[(mNext + NUM_FRAMES - mNumTimes) % NUM_FRAMES];
+    const nsecs_t average = (last - first) / nsecs_t(mNumTimes - 1);
+    return average > sinceLast ? average : sinceLast;
+}
+
+// ---------------------------------------------------------------------------
+
+RefreshRatePolicy::RefreshRatePolicy() :
+        mDefaultConfig(-1),
+        mConfig(-1),
+        mCandidateConfig(-1),
+        mCandidateTime(0),
+        mContentPeriod(0),
+        mSwitchCount(0) {
+}
+
+void RefreshRatePolicy::setConfigs(
+        const Vector<HWComposer::DisplayConfig>& configs, int defaultConfig) {
+    mConfigs = configs;
+    if (defaultConfig < 0 || size_t(defaultConfig) >= configs.size()) {
+        defaultConfig = -1;
+    }
+    mDefaultConfig = defaultConfig;
+    mConfig = defaultConfig;
+    mCandidateConfig = defaultConfig;
+    mCandidateTime = 0;
+}
+
+int RefreshRatePolicy::onContentUpdate(nsecs_t now, nsecs_t contentPeriod) {
+    mContentPeriod = contentPeriod;
+    if (mDefaultConfig < 0) {
+        return mConfig;
+    }
+
+    const int candidate = findConfig(contentPeriod);
+    if (candidate != mCandidateConfig) {
+        mCandidateConfig = candidate;
+        mCandidateTime = now;
+    }
+
+    if (candidate != mConfig) {
+        // switch up right away, but only switch down once the content has
+        // kept its rate for a while
+        if (mConfigs[candidate].refresh < mConfigs[mConfig].refresh ||
+                now - mCandidateTime >= SUSTAIN_TIME) {
+            mConfig = candidate;
+            mSwitchCount++;
+        }
+    }
+    return mConfig;
+}
+
+void RefreshRatePolicy::onTransaction(nsecs_t now) {
+    if (mConfig != mDefaultConfig) {
+        mSwitchCount++;
+    }
+    mConfig = mDefaultConfig;
+    mCandidateConfig = mDefaultConfig;
+    mCandidateTime = now;
+}
+
+bool RefreshRatePolicy::isSettled() const {
+    return mConfig == mCandidateConfig;
+}
+
+int RefreshRatePolicy::findConfig(nsecs_t contentPeriod) const {
+    const HWComposer::DisplayConfig& def(mConfigs[mDefaultConfig]);
+    const bool idle = contentPeriod == 0 ||
+            contentPeriod >= SLOW_CONTENT_PERIOD;
+    int best = mDefaultConfig;
+    for (size_t i=0 ; i<mConfigs.size() ; i++) {
+        const HWComposer::DisplayConfig& config(mConfigs[i]);
+        if (config.width != def.width || config.height != def.height ||
+                config.refresh <= mConfigs[best].refresh) {
+            continue;
+        }
+        if (idle || isMultipleOf(contentPeriod, config.refresh)) {
+            best = int(i);
+        }
+    }
+    return best;
+}
+
+bool RefreshRatePolicy::isMultipleOf(nsecs_t contentPeriod,
+        nsecs_t refresh) {
+    if (refresh <= 0) {
+        return false;
+    }
+    const nsecs_t multiple = (contentPeriod + refresh/2) / refresh;
+    if (multiple < 2) {
+        return false;
+    }
+    const nsecs_t error = contentPeriod - multiple * refresh;
+    return (error < 0 ? -error : error) <= refresh / 10;
+}
+
+void RefreshRatePolicy::dump(String8& result) const {
+    if (mDefaultConfig < 0) {
+        result.append("  no configs\n");
+        return;
+    }
+    const nsecs_t refresh = mConfigs[mConfig].refresh;
+    result.appendFormat("  config %d (%.2f fps), default %d, candidate %d, "
+            "content period %" PRId64 " ns, %u switches\n",
+            mConfig, refresh > 0 ? 1e9 / refresh : 0.0, mDefaultConfig,
+            mCandidateConfig, mContentPeriod, mSwitchCount);
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_REFRESHRATEPOLICY_H
+#define ANDROID_REFRESHRATEPOLICY_H
+
+#include <stddef.h>
+
+#include <utils/Mutex.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+#include "DisplayHardware/HWComposer.h"
+
+namespace android {
+
+class String8;
+
+/*
+ * FrameCadence estimates the rate at which a producer queues frames from
+ * the times its last few frames were queued. It is thread-safe.
+ */
+class FrameCadence {
+public:
+    FrameCadence();
+
+    void addFrame(nsecs_t when);
+
+    // Returns the average interval between the recent frames, or the time
+    // since the last one if that's longer. Returns 0 if no frame was queued
+    // in the last 'timeout' ns.
+    nsecs_t getPeriod(nsecs_t now, nsecs_t timeout) const;
+
+private:
+    enum { NUM_FRAMES = 8 };
+
+    mutable Mutex mMutex;
+    nsecs_t mTimes[NUM_FRAMES];
+    size_t mNumTimes;
+    size_t mNext;
+};
+
+/*
+ * RefreshRatePolicy picks the config of the primary display from the rate
+ * at which its visible layers are updated. When nothing is updated, or the
+ * content runs at a fraction of a slower config's refresh rate (24fps video
+ * on a 48Hz config, say) for long enough, the slowest such config with the
+ * same resolution is selected. Faster content, and any transaction, bring
+ * the display back to its default config right away.
+ *
+ * Content running at the display's own refresh rate never matches a slower
+ * config: it's most likely throttled by the display, and lowering the rate
+ * further would keep it that way.
+ *
+ * It is only used from the main thread.
+ */
+class RefreshRatePolicy {
+public:
+    enum {
+        // layers that didn't queue a frame for this long are idle
+        IDLE_TIMEOUT = 500000000,   // 500ms
+        // how long content must keep its rate before switching down
+        SUSTAIN_TIME = 2000000000,  // 2s
+    };
+
+    RefreshRatePolicy();
+
+    // sets the configs of the display, and the one used when the content
+    // doesn't match a slower one
+    void setConfigs(const Vector<HWComposer::DisplayConfig>& configs,
+            int defaultConfig);
+
+    // Called after each composition, and periodically while the display
+    // isn't settled. 'contentPeriod' is the shortest frame period of the
+    // visible layers that aren't idle, 0 if they all are. Returns the
+    // config that should be used.
+    int onContentUpdate(nsecs_t now, nsecs_t contentPeriod);
+
+    // a layer or display state changed, most likely because of user input
+    void onTransaction(nsecs_t now);
+
+    // whether the selected config matches the content, i.e. there is no
+    // pending switch
+    bool isSettled() const;
+
+    void dump(String8& result) const;
+
+private:
+    enum {
+        // content slower than this is treated as idle
+        SLOW_CONTENT_PERIOD = 100000000,    // 100ms
+    };
+
+    int findConfig(nsecs_t contentPeriod) const;
+    static bool isMultipleOf(nsecs_t contentPeriod, nsecs_t refresh);
+
+    Vector<HWComposer::DisplayConfig> mConfigs;
+    int mDefaultConfig;
+    int mConfig;
+    // the config matching the content, and since when it has
+    int mCandidateConfig;
+    nsecs_t mCandidateTime;
+    nsecs_t mContentPeriod;
+    uint32_t mSwitchCount;
+};
+
+}
+
+#endif // ANDROID_REFRESHRATEPOLICY_H
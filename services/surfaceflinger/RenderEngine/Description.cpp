@@ -33,6 +33,7 @@ Description::Description() :
     mOpaque = true;
     mTextureEnabled = false;
     mColorMatrixEnabled = false;
+    mColorScale = 1.0f;
 
     memset(mColor, 0, sizeof(mColor));
 }
@@ -88,5 +89,12 @@ void Description::setColorMatrix(const mat4& mtx) {
     mColorMatrixEnabled = (mtx != identity);
 }
 
+void Description::setColorScale(GLclampf scale) {
+    if (scale != mColorScale) {
+        mUniformsDirty = true;
+        mColorScale = scale;
+    }
+}
+
 
 } /* namespace android */
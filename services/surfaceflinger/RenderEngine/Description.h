@@ -54,6 +54,9 @@ class Description {
     bool mColorMatrixEnabled;
     mat4 mColorMatrix;
 
+    // factor applied to the color that's output, after the color matrix
+    GLclampf mColorScale;
+
 public:
     Description();
     ~Description();
@@ -66,6 +69,7 @@ public:
     void setColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
     void setProjectionMatrix(const mat4& mtx);
     void setColorMatrix(const mat4& mtx);
+    void setColorScale(GLclampf scale);
 
 private:
     bool mUniformsDirty;
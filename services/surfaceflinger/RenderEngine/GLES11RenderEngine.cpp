@@ -303,10 +303,19 @@ void GLES11RenderEngine::beginGroup(const mat4& /*colorTransform*/) {
     // doesn't do anything in GLES 1.1
 }
 
+bool GLES11RenderEngine::setupColorScale(float scale) {
+    // the texture environment is already used for the plane alpha
+    return scale == 1.0f;
+}
+
 void GLES11RenderEngine::endGroup() {
     // doesn't do anything in GLES 1.1
 }
 
+void GLES11RenderEngine::setupColorTransform(const mat4& /*colorTransform*/) {
+    // doesn't do anything in GLES 1.1
+}
+
 void GLES11RenderEngine::dump(String8& result) {
     RenderEngine::dump(result);
 }
@@ -65,6 +65,8 @@ protected:
 
     virtual void beginGroup(const mat4& colorTransform);
     virtual void endGroup();
+    virtual void setupColorTransform(const mat4& colorTransform);
+    virtual bool setupColorScale(float scale);
 
     virtual size_t getMaxTextureSize() const;
     virtual size_t getMaxViewportDims() const;
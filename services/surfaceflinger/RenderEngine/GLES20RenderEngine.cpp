@@ -39,8 +39,17 @@
 namespace android {
 // ---------------------------------------------------------------------------
 
-GLES20RenderEngine::GLES20RenderEngine() :
-        mVpWidth(0), mVpHeight(0) {
+GLES20RenderEngine::GLES20RenderEngine(bool privateProgramCache,
+        bool primeProgramCache) :
+        mVpWidth(0), mVpHeight(0),
+        mProgramCache(privateProgramCache ?
+                new ProgramCache() : &ProgramCache::getInstance()),
+        mOwnsProgramCache(privateProgramCache),
+        mVertexBuffer(0),
+        mVertexBufferSize(0),
+        mVertexBufferOffset(0),
+        mBlendEnabled(false),
+        mBlendSrc(GL_ONE) {
 
     glGetIntegerv(GL_MAX_TEXTURE_SIZE, &mMaxTextureSize);
     glGetIntegerv(GL_MAX_VIEWPORT_DIMS, mMaxViewportDims);
@@ -64,10 +73,53 @@ GLES20RenderEngine::GLES20RenderEngine() :
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0,
             GL_RGB, GL_UNSIGNED_SHORT_5_6_5, protTexData);
 
+    glGenBuffers(1, &mVertexBuffer);
+    glDisable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Until surfaceflinger has a dependable blob cache on the filesystem,
+    // generate shaders on initialization so as to avoid jank.
+    if (primeProgramCache) {
+        mProgramCache->primeCache();
+    }
+
     //mColorBlindnessCorrection = M;
 }
 
 GLES20RenderEngine::~GLES20RenderEngine() {
+    glDeleteBuffers(1, &mVertexBuffer);
+    if (mOwnsProgramCache) {
+        delete mProgramCache;
+    }
+}
+
+void GLES20RenderEngine::primeShaders(EGLDisplay display, int hwcFormat) {
+    // our context may be current on another thread already, so the programs
+    // are generated with one of our own, which shares them with it
+    EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    EGLContext ctxt = eglCreateContext(display, getEGLConfig(),
+            getEGLContext(), contextAttributes);
+    if (ctxt == EGL_NO_CONTEXT) {
+        // they'll be generated as they are first used
+        ALOGW("can't create a context to prime the program cache (%#x)",
+                eglGetError());
+        return;
+    }
+    EGLint attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    EGLSurface dummy = eglCreatePbufferSurface(display,
+            chooseEglConfig(display, hwcFormat), attribs);
+    if (dummy != EGL_NO_SURFACE && eglMakeCurrent(display, dummy, dummy, ctxt)) {
+        // the programs must be complete before our context uses them
+        mProgramCache->primeCache(true);
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    } else {
+        ALOGW("can't make a context current to prime the program cache (%#x)",
+                eglGetError());
+    }
+    if (dummy != EGL_NO_SURFACE) {
+        eglDestroySurface(display, dummy);
+    }
+    eglDestroyContext(display, ctxt);
 }
 
 
@@ -131,10 +183,9 @@ void GLES20RenderEngine::setupLayerBlending(
     mState.setPlaneAlpha(alpha / 255.0f);
 
     if (alpha < 0xFF || !opaque) {
-        glEnable(GL_BLEND);
-        glBlendFunc(premultipliedAlpha ? GL_ONE : GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        setBlending(true, premultipliedAlpha ? GL_ONE : GL_SRC_ALPHA);
     } else {
-        glDisable(GL_BLEND);
+        setBlending(false);
     }
 }
 
@@ -146,10 +197,9 @@ void GLES20RenderEngine::setupDimLayerBlending(int alpha) {
     mState.disableTexture();
 
     if (alpha == 0xFF) {
-        glDisable(GL_BLEND);
+        setBlending(false);
     } else {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        setBlending(true, GL_ONE);
     }
 }
 
@@ -180,7 +230,7 @@ void GLES20RenderEngine::disableTexturing() {
 }
 
 void GLES20RenderEngine::disableBlending() {
-    glDisable(GL_BLEND);
+    setBlending(false);
 }
 
 
@@ -231,33 +281,75 @@ void GLES20RenderEngine::setupFillWithColor(float r, float g, float b, float a)
     mState.setOpaque(false);
     mState.setColor(r, g, b, a);
     mState.disableTexture();
-    glDisable(GL_BLEND);
+    setBlending(false);
+}
+
+void GLES20RenderEngine::setBlending(bool enabled, GLenum src) {
+    if (enabled != mBlendEnabled) {
+        if (enabled) {
+            glEnable(GL_BLEND);
+        } else {
+            glDisable(GL_BLEND);
+        }
+        mBlendEnabled = enabled;
+    }
+    if (enabled && src != mBlendSrc) {
+        glBlendFunc(src, GL_ONE_MINUS_SRC_ALPHA);
+        mBlendSrc = src;
+    }
+}
+
+GLintptr GLES20RenderEngine::uploadVertices(const Mesh& mesh) {
+    const GLsizeiptr size = mesh.getVertexCount() * mesh.getByteStride();
+    if (mVertexBufferOffset + size > mVertexBufferSize) {
+        // Orphan the buffer rather than overwriting vertices the GPU may
+        // still be reading; the driver hands us a fresh one.
+        if (size > mVertexBufferSize) {
+            mVertexBufferSize = size > VERTEX_BUFFER_SIZE ?
+                    size : GLsizeiptr(VERTEX_BUFFER_SIZE);
+        }
+        glBufferData(GL_ARRAY_BUFFER, mVertexBufferSize, NULL,
+                GL_STREAM_DRAW);
+        mVertexBufferOffset = 0;
+    }
+    const GLintptr offset = mVertexBufferOffset;
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, mesh.getPositions());
+    mVertexBufferOffset += size;
+    return offset;
 }
 
 void GLES20RenderEngine::drawMesh(const Mesh& mesh) {
 
-    ProgramCache::getInstance().useProgram(mState);
+    mProgramCache->useProgram(mState);
+
+    // The vertices of every mesh go through a single buffer, which spares
+    // the driver a copy from client memory on each draw.
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    const GLintptr offset = uploadVertices(mesh);
 
     if (mesh.getTexCoordsSize()) {
+        const GLintptr texCoordsOffset = offset +
+                (mesh.getTexCoords() - mesh.getPositions()) * sizeof(float);
         glEnableVertexAttribArray(Program::texCoords);
         glVertexAttribPointer(Program::texCoords,
                 mesh.getTexCoordsSize(),
                 GL_FLOAT, GL_FALSE,
                 mesh.getByteStride(),
-                mesh.getTexCoords());
+                reinterpret_cast<const GLvoid*>(texCoordsOffset));
     }
 
     glVertexAttribPointer(Program::position,
             mesh.getVertexSize(),
             GL_FLOAT, GL_FALSE,
             mesh.getByteStride(),
-            mesh.getPositions());
+            reinterpret_cast<const GLvoid*>(offset));
 
     glDrawArrays(mesh.getPrimitive(), 0, mesh.getVertexCount());
 
     if (mesh.getTexCoordsSize()) {
         glDisableVertexAttribArray(Program::texCoords);
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void GLES20RenderEngine::beginGroup(const mat4& colorTransform) {
@@ -309,7 +401,7 @@ void GLES20RenderEngine::endGroup() {
     mState.setOpaque(false);
     mState.setTexture(texture);
     mState.setColorMatrix(group.colorTransform);
-    glDisable(GL_BLEND);
+    setBlending(false);
 
     Mesh mesh(Mesh::TRIANGLE_FAN, 4, 2, 2);
     Mesh::VertexArray<vec2> position(mesh.getPositionArray<vec2>());
@@ -332,6 +424,15 @@ void GLES20RenderEngine::endGroup() {
     glDeleteTextures(1, &group.texture);
 }
 
+void GLES20RenderEngine::setupColorTransform(const mat4& colorTransform) {
+    mState.setColorMatrix(colorTransform);
+}
+
+bool GLES20RenderEngine::setupColorScale(float scale) {
+    mState.setColorScale(scale);
+    return true;
+}
+
 void GLES20RenderEngine::dump(String8& result) {
     RenderEngine::dump(result);
 }
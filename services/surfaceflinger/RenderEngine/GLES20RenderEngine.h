@@ -53,6 +53,23 @@ class GLES20RenderEngine : public RenderEngine {
 
     Description mState;
     Vector<Group> mGroupStack;
+    ProgramCache* mProgramCache;
+    bool mOwnsProgramCache;
+
+    // the vertices of all meshes are streamed into this buffer, from
+    // mVertexBufferOffset on; it's orphaned when full
+    GLuint mVertexBuffer;
+    GLsizeiptr mVertexBufferSize;
+    GLintptr mVertexBufferOffset;
+
+    // the blending state last set, so it isn't set again for every layer
+    bool mBlendEnabled;
+    GLenum mBlendSrc;
+
+    enum { VERTEX_BUFFER_SIZE = 64*1024 };
+
+    GLintptr uploadVertices(const Mesh& mesh);
+    void setBlending(bool enabled, GLenum src = GL_ONE);
 
     virtual void bindImageAsFramebuffer(EGLImageKHR image,
             uint32_t* texName, uint32_t* fbName, uint32_t* status,
@@ -60,7 +77,15 @@ class GLES20RenderEngine : public RenderEngine {
     virtual void unbindFramebuffer(uint32_t texName, uint32_t fbName, bool useReadPixels);
 
 public:
-    GLES20RenderEngine();
+    // privateProgramCache: use a ProgramCache of our own rather than the
+    // process-wide one, so that this engine may draw concurrently with
+    // another one
+    // primeProgramCache: generate the programs now; otherwise they are
+    // generated by primeShaders(), or as they are first used
+    GLES20RenderEngine(bool privateProgramCache = false,
+            bool primeProgramCache = true);
+
+    virtual void primeShaders(EGLDisplay display, int hwcFormat);
 
 protected:
     virtual ~GLES20RenderEngine();
@@ -80,6 +105,8 @@ protected:
 
     virtual void beginGroup(const mat4& colorTransform);
     virtual void endGroup();
+    virtual void setupColorTransform(const mat4& colorTransform);
+    virtual bool setupColorScale(float scale);
 
     virtual size_t getMaxTextureSize() const;
     virtual size_t getMaxViewportDims() const;
@@ -18,6 +18,8 @@
 
 #include <log/log.h>
 
+#include <GLES2/gl2ext.h>
+
 #include "Program.h"
 #include "ProgramCache.h"
 #include "Description.h"
@@ -53,26 +55,48 @@ Program::Program(const ProgramCache::Key& /*needs*/, const char* vertex, const c
         glDeleteShader(fragmentId);
         glDeleteProgram(programId);
     } else {
-        mProgram = programId;
         mVertexShader = vertexId;
         mFragmentShader = fragmentId;
-        mInitialized = true;
-
-        mColorMatrixLoc = glGetUniformLocation(programId, "colorMatrix");
-        mProjectionMatrixLoc = glGetUniformLocation(programId, "projection");
-        mTextureMatrixLoc = glGetUniformLocation(programId, "texture");
-        mSamplerLoc = glGetUniformLocation(programId, "sampler");
-        mColorLoc = glGetUniformLocation(programId, "color");
-        mAlphaPlaneLoc = glGetUniformLocation(programId, "alphaPlane");
-
-        // set-up the default values for our uniforms
-        glUseProgram(programId);
-        const GLfloat m[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
-        glUniformMatrix4fv(mProjectionMatrixLoc, 1, GL_FALSE, m);
-        glEnableVertexAttribArray(0);
+        initWithLinkedProgram(programId);
     }
 }
 
+Program::Program(const ProgramCache::Key& /*needs*/, GLenum binaryFormat,
+        const void* binary, GLsizei length)
+        : mInitialized(false), mVertexShader(0), mFragmentShader(0) {
+    GLuint programId = glCreateProgram();
+    glProgramBinaryOES(programId, binaryFormat, binary, length);
+
+    // the attribute locations were bound when the binary was linked
+    GLint status;
+    glGetProgramiv(programId, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        // not an error, the driver may reject binaries from other versions
+        glDeleteProgram(programId);
+    } else {
+        initWithLinkedProgram(programId);
+    }
+}
+
+void Program::initWithLinkedProgram(GLuint programId) {
+    mProgram = programId;
+    mInitialized = true;
+
+    mColorMatrixLoc = glGetUniformLocation(programId, "colorMatrix");
+    mProjectionMatrixLoc = glGetUniformLocation(programId, "projection");
+    mTextureMatrixLoc = glGetUniformLocation(programId, "texture");
+    mSamplerLoc = glGetUniformLocation(programId, "sampler");
+    mColorLoc = glGetUniformLocation(programId, "color");
+    mAlphaPlaneLoc = glGetUniformLocation(programId, "alphaPlane");
+    mColorScaleLoc = glGetUniformLocation(programId, "colorScale");
+
+    // set-up the default values for our uniforms
+    glUseProgram(programId);
+    const GLfloat m[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+    glUniformMatrix4fv(mProjectionMatrixLoc, 1, GL_FALSE, m);
+    glEnableVertexAttribArray(0);
+}
+
 Program::~Program() {
 }
 
@@ -94,6 +118,27 @@ GLint Program::getUniform(const char* name) const {
     return glGetUniformLocation(mProgram, name);
 }
 
+status_t Program::getBinary(GLenum* binaryFormat, Vector<uint8_t>* binary) const {
+    if (!mInitialized) {
+        return NO_INIT;
+    }
+    GLint length = 0;
+    glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) {
+        return UNKNOWN_ERROR;
+    }
+    binary->resize(length);
+    GLsizei written = 0;
+    glGetProgramBinaryOES(mProgram, length, &written, binaryFormat,
+            binary->editArray());
+    if (written <= 0) {
+        binary->clear();
+        return UNKNOWN_ERROR;
+    }
+    binary->resize(written);
+    return NO_ERROR;
+}
+
 GLuint Program::buildShader(const char* source, GLenum type) {
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, 0);
@@ -141,6 +186,9 @@ void Program::setUniforms(const Description& desc) {
     if (mColorMatrixLoc >= 0) {
         glUniformMatrix4fv(mColorMatrixLoc, 1, GL_FALSE, desc.mColorMatrix.asArray());
     }
+    if (mColorScaleLoc >= 0) {
+        glUniform1f(mColorScaleLoc, desc.mColorScale);
+    }
     // these uniforms are always present
     glUniformMatrix4fv(mProjectionMatrixLoc, 1, GL_FALSE, desc.mProjectionMatrix.asArray());
 }
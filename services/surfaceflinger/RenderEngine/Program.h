@@ -21,6 +21,9 @@
 
 #include <GLES2/gl2.h>
 
+#include <utils/Errors.h>
+#include <utils/Vector.h>
+
 #include "Description.h"
 #include "ProgramCache.h"
 
@@ -37,6 +40,11 @@ public:
     enum { position=0, texCoords=1 };
 
     Program(const ProgramCache::Key& needs, const char* vertex, const char* fragment);
+    // creates the program from a binary returned by getBinary(), with
+    // GL_OES_get_program_binary. The result is invalid if the driver
+    // doesn't accept the binary.
+    Program(const ProgramCache::Key& needs, GLenum binaryFormat,
+            const void* binary, GLsizei length);
     ~Program();
 
     /* whether this object is usable */
@@ -54,9 +62,13 @@ public:
     /* set-up uniforms from the description */
     void setUniforms(const Description& desc);
 
+    /* retrieves the linked binary of this program */
+    status_t getBinary(GLenum* binaryFormat, Vector<uint8_t>* binary) const;
+
 
 private:
     GLuint buildShader(const char* source, GLenum type);
+    void initWithLinkedProgram(GLuint programId);
     String8& dumpShader(String8& result, GLenum type);
 
     // whether the initialization succeeded
@@ -84,6 +96,9 @@ private:
 
     /* location of the color uniform */
     GLint mColorLoc;
+
+    /* location of the color scale uniform */
+    GLint mColorScaleLoc;
 };
 
 
@@ -14,14 +14,24 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
+#include <cutils/properties.h>
+
+#include <utils/JenkinsHash.h>
 #include <utils/String8.h>
 
 #include "ProgramCache.h"
 #include "Program.h"
 #include "Description.h"
+#include "GLExtensions.h"
 
 namespace android {
 // -----------------------------------------------------------------------------------------------
@@ -77,23 +87,35 @@ Formatter& dedent(Formatter& f) {
 
 ANDROID_SINGLETON_STATIC_INSTANCE(ProgramCache)
 
+// where the linked programs are kept between runs
+static const char* const PROGRAM_BINARY_FILE =
+        "/data/system/surfaceflinger_programs.bin";
+static const uint32_t PROGRAM_BINARY_MAGIC = 0x53465042; // 'SFPB'
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+
 ProgramCache::ProgramCache() {
-    // Until surfaceflinger has a dependable blob cache on the filesystem,
-    // generate shaders on initialization so as to avoid jank.
-    primeCache();
 }
 
 ProgramCache::~ProgramCache() {
 }
 
-void ProgramCache::primeCache() {
+void ProgramCache::primeCache(bool finish) {
+    Mutex::Autolock _l(mLock);
     uint32_t shaderCount = 0;
+    uint32_t binaryCount = 0;
     uint32_t keyMask = Key::BLEND_MASK | Key::OPACITY_MASK |
                        Key::PLANE_ALPHA_MASK | Key::TEXTURE_MASK;
     // Prime the cache for all combinations of the above masks,
     // leaving off the experimental color matrix mask options.
 
     nsecs_t timeBefore = systemTime();
+    // programs linked on a previous run are reloaded rather than compiled
+    // again, when the driver supports it
+    const bool useBinaries = supportsProgramBinaries();
+    KeyedVector<Key, ProgramBinary> binaries;
+    if (useBinaries) {
+        loadProgramBinaries(binaries);
+    }
     for (uint32_t keyVal = 0; keyVal <= keyMask; keyVal++) {
         Key shaderKey;
         shaderKey.set(keyMask, keyVal);
@@ -105,14 +127,180 @@ void ProgramCache::primeCache() {
         }
         Program* program = mCache.valueFor(shaderKey);
         if (program == NULL) {
-            program = generateProgram(shaderKey);
+            ssize_t index = binaries.indexOfKey(shaderKey);
+            if (index >= 0) {
+                const ProgramBinary& binary(binaries.valueAt(index));
+                if (binary.sourceHash == computeSourceHash(shaderKey)) {
+                    program = new Program(shaderKey, binary.format,
+                            binary.data.array(), binary.data.size());
+                    if (program->isValid()) {
+                        binaryCount++;
+                    } else {
+                        delete program;
+                        program = NULL;
+                    }
+                }
+            }
+            if (program == NULL) {
+                program = generateProgram(shaderKey);
+                shaderCount++;
+            }
             mCache.add(shaderKey, program);
-            shaderCount++;
         }
     }
     nsecs_t timeAfter = systemTime();
     float compileTimeMs = static_cast<float>(timeAfter - timeBefore) / 1.0E6;
-    ALOGD("shader cache generated - %u shaders in %f ms\n", shaderCount, compileTimeMs);
+    ALOGD("shader cache generated - %u shaders compiled, %u loaded in %f ms\n",
+            shaderCount, binaryCount, compileTimeMs);
+
+    if (useBinaries && shaderCount) {
+        saveProgramBinaries();
+    }
+
+    if (finish) {
+        glFinish();
+    }
+}
+
+bool ProgramCache::supportsProgramBinaries() {
+    if (!GLExtensions::getInstance().hasExtension("GL_OES_get_program_binary")) {
+        return false;
+    }
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formatCount);
+    return formatCount > 0;
+}
+
+String8 ProgramCache::getProgramBinaryFingerprint() {
+    // a new build may come with a new driver, or new shaders
+    char fingerprint[PROPERTY_VALUE_MAX];
+    property_get("ro.build.fingerprint", fingerprint, "");
+    const GLExtensions& extensions(GLExtensions::getInstance());
+    return String8::format("%s|%s|%s|%s", fingerprint,
+            extensions.getVendor(), extensions.getRenderer(),
+            extensions.getVersion());
+}
+
+uint32_t ProgramCache::computeSourceHash(const Key& needs) {
+    String8 vs = generateVertexShader(needs);
+    String8 fs = generateFragmentShader(needs);
+    hash_t hash = JenkinsHashMixBytes(0,
+            reinterpret_cast<const uint8_t*>(vs.string()), vs.length());
+    hash = JenkinsHashMixBytes(hash,
+            reinterpret_cast<const uint8_t*>(fs.string()), fs.length());
+    return JenkinsHashWhiten(hash);
+}
+
+static bool readUint32(FILE* file, uint32_t* value) {
+    return fread(value, sizeof(*value), 1, file) == 1;
+}
+
+// bytesLeft returns how many bytes of a file of the given size are left to
+// read, so that lengths read from the file can be checked against it.
+static off_t bytesLeft(FILE* file, off_t size) {
+    const long pos = ftell(file);
+    return (pos < 0 || pos > size) ? 0 : size - pos;
+}
+
+static bool writeUint32(FILE* file, uint32_t value) {
+    return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+bool ProgramCache::loadProgramBinaries(KeyedVector<Key, ProgramBinary>& binaries) {
+    FILE* file = fopen(PROGRAM_BINARY_FILE, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fileno(file), &st) < 0) {
+        fclose(file);
+        return false;
+    }
+
+    const String8 expected(getProgramBinaryFingerprint());
+    bool valid = false;
+    uint32_t magic, version, length, count;
+    if (readUint32(file, &magic) && magic == PROGRAM_BINARY_MAGIC &&
+            readUint32(file, &version) && version == PROGRAM_BINARY_VERSION &&
+            readUint32(file, &length) && length == expected.length()) {
+        Vector<char> fingerprint;
+        fingerprint.resize(length);
+        valid = fread(fingerprint.editArray(), 1, length, file) == length &&
+                !memcmp(fingerprint.array(), expected.string(), length) &&
+                readUint32(file, &count);
+    }
+
+    for (uint32_t i=0 ; valid && i<count ; i++) {
+        uint32_t key;
+        ProgramBinary binary;
+        valid = readUint32(file, &key) &&
+                readUint32(file, &binary.sourceHash) &&
+                readUint32(file, &binary.format) &&
+                readUint32(file, &length) &&
+                off_t(length) <= bytesLeft(file, st.st_size);
+        if (valid) {
+            binary.data.resize(length);
+            valid = fread(binary.data.editArray(), 1, length, file) == length;
+        }
+        if (valid) {
+            Key needs;
+            needs.mKey = key;
+            binaries.add(needs, binary);
+        }
+    }
+    fclose(file);
+
+    if (!valid) {
+        ALOGW("ignoring the programs saved in %s", PROGRAM_BINARY_FILE);
+        binaries.clear();
+    }
+    return valid;
+}
+
+void ProgramCache::saveProgramBinaries() const {
+    // written aside and renamed, so that a crash never leaves a truncated
+    // file behind
+    const String8 path(String8::format("%s.tmp", PROGRAM_BINARY_FILE));
+    FILE* file = fopen(path.string(), "wb");
+    if (file == NULL) {
+        ALOGW("couldn't save programs to %s: %s", path.string(),
+                strerror(errno));
+        return;
+    }
+
+    const String8 fingerprint(getProgramBinaryFingerprint());
+    Vector<uint8_t> data;
+    uint32_t count = 0;
+    bool ok = writeUint32(file, PROGRAM_BINARY_MAGIC) &&
+            writeUint32(file, PROGRAM_BINARY_VERSION) &&
+            writeUint32(file, fingerprint.length()) &&
+            fwrite(fingerprint.string(), 1, fingerprint.length(), file) ==
+                    fingerprint.length();
+    // the count is patched in once we know how many binaries we got
+    const long countOffset = ftell(file);
+    ok = ok && writeUint32(file, count);
+
+    for (size_t i=0 ; ok && i<mCache.size() ; i++) {
+        const Key& needs(mCache.keyAt(i));
+        GLenum format;
+        if (mCache.valueAt(i)->getBinary(&format, &data) != NO_ERROR) {
+            continue;
+        }
+        ok = writeUint32(file, needs.mKey) &&
+                writeUint32(file, computeSourceHash(needs)) &&
+                writeUint32(file, format) &&
+                writeUint32(file, data.size()) &&
+                fwrite(data.array(), 1, data.size(), file) == data.size();
+        count++;
+    }
+    ok = ok && fseek(file, countOffset, SEEK_SET) == 0 &&
+            writeUint32(file, count);
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(path.string(), PROGRAM_BINARY_FILE) != 0) {
+        ALOGW("couldn't save programs to %s", PROGRAM_BINARY_FILE);
+        unlink(path.string());
+    }
 }
 
 ProgramCache::Key ProgramCache::computeKey(const Description& description) {
@@ -129,7 +317,9 @@ ProgramCache::Key ProgramCache::computeKey(const Description& description) {
     .set(Key::OPACITY_MASK,
             description.mOpaque ? Key::OPACITY_OPAQUE : Key::OPACITY_TRANSLUCENT)
     .set(Key::COLOR_MATRIX_MASK,
-            description.mColorMatrixEnabled ? Key::COLOR_MATRIX_ON :  Key::COLOR_MATRIX_OFF);
+            description.mColorMatrixEnabled ? Key::COLOR_MATRIX_ON :  Key::COLOR_MATRIX_OFF)
+    .set(Key::COLOR_SCALE_MASK,
+            (description.mColorScale < 1) ? Key::COLOR_SCALE_ON : Key::COLOR_SCALE_OFF);
     return needs;
 }
 
@@ -175,6 +365,9 @@ String8 ProgramCache::generateFragmentShader(const Key& needs) {
     if (needs.hasColorMatrix()) {
         fs << "uniform mat4 colorMatrix;";
     }
+    if (needs.hasColorScale()) {
+        fs << "uniform float colorScale;";
+    }
     fs << "void main(void) {" << indent;
     if (needs.isTexturing()) {
         fs << "gl_FragColor = texture2D(sampler, outTexCoords);";
@@ -209,6 +402,12 @@ String8 ProgramCache::generateFragmentShader(const Key& needs) {
         }
     }
 
+    if (needs.hasColorScale()) {
+        // as if a black layer with an alpha of 1-colorScale was blended
+        // over the result
+        fs << "gl_FragColor.rgb *= colorScale;";
+    }
+
     fs << dedent << "}";
     return fs.getString();
 }
@@ -225,6 +424,7 @@ Program* ProgramCache::generateProgram(const Key& needs) {
 }
 
 void ProgramCache::useProgram(const Description& description) {
+    Mutex::Autolock _l(mLock);
 
     // generate the key for the shader based on the description
     Key needs(computeKey(description));
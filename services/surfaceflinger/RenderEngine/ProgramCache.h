@@ -21,7 +21,9 @@
 
 #include <utils/Singleton.h>
 #include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
 #include <utils/TypeHelpers.h>
+#include <utils/Vector.h>
 
 #include "Description.h"
 
@@ -69,6 +71,10 @@ public:
             COLOR_MATRIX_OFF        =       0x00000000,
             COLOR_MATRIX_ON         =       0x00000020,
             COLOR_MATRIX_MASK       =       0x00000020,
+
+            COLOR_SCALE_OFF         =       0x00000000,
+            COLOR_SCALE_ON          =       0x00000040,
+            COLOR_SCALE_MASK        =       0x00000040,
         };
 
         inline Key() : mKey(0) { }
@@ -97,6 +103,9 @@ public:
         inline bool hasColorMatrix() const {
             return (mKey & COLOR_MATRIX_MASK) == COLOR_MATRIX_ON;
         }
+        inline bool hasColorScale() const {
+            return (mKey & COLOR_SCALE_MASK) == COLOR_SCALE_ON;
+        }
 
         // this is the definition of a friend function -- not a method of class Needs
         friend inline int strictly_order_type(const Key& lhs, const Key& rhs) {
@@ -111,9 +120,32 @@ public:
     // if none can be found.
     void useProgram(const Description& description);
 
+    // Generate shaders to populate the cache. Needs a current context, which
+    // may be another one sharing its programs with the one that uses them;
+    // useProgram() waits for it to be done. In that case finish must be
+    // true, so that the programs are complete before useProgram() gets them.
+    void primeCache(bool finish = false);
+
 private:
-    // Generate shaders to populate the cache
-    void primeCache();
+    // a linked program, as saved by saveProgramBinaries()
+    struct ProgramBinary {
+        uint32_t sourceHash;
+        uint32_t format;
+        Vector<uint8_t> data;
+    };
+
+    // whether the driver lets us save and reload linked programs
+    static bool supportsProgramBinaries();
+    // identifies the build and GL driver the saved binaries are valid for
+    static String8 getProgramBinaryFingerprint();
+    // hash of the sources generated for a Key, so that binaries of shaders
+    // that have changed since are not used
+    static uint32_t computeSourceHash(const Key& needs);
+    // reads the binaries saved by saveProgramBinaries(), returns false if
+    // there are none, or they are from another build or driver
+    static bool loadProgramBinaries(KeyedVector<Key, ProgramBinary>& binaries);
+    // saves the binaries of every program in the cache
+    void saveProgramBinaries() const;
     // compute a cache Key from a Description
     static Key computeKey(const Description& description);
     // generates a program from the Key
@@ -126,6 +158,8 @@ private:
     // Key/Value map used for caching Programs. Currently the cache
     // is never shrunk.
     DefaultKeyedVector<Key, Program*> mCache;
+    // held while priming, so that the cache can be primed on another thread
+    Mutex mLock;
 };
 
 
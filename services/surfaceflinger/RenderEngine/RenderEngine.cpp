@@ -46,7 +46,8 @@ static bool findExtension(const char* exts, const char* name) {
     return false;
 }
 
-RenderEngine* RenderEngine::create(EGLDisplay display, int hwcFormat) {
+RenderEngine* RenderEngine::create(EGLDisplay display, int hwcFormat,
+        EGLContext shareContext, bool primeShaders) {
     // EGL_ANDROIDX_no_config_context is an experimental extension with no
     // written specification. It will be replaced by something more formal.
     // SurfaceFlinger is using it to allow a single EGLContext to render to
@@ -89,7 +90,8 @@ RenderEngine* RenderEngine::create(EGLDisplay display, int hwcFormat) {
 #endif
             EGL_NONE, EGL_NONE
     };
-    EGLContext ctxt = eglCreateContext(display, config, NULL, contextAttributes);
+    EGLContext ctxt = eglCreateContext(display, config, shareContext,
+            contextAttributes);
 
     // if can't create a GL context, we can only abort.
     LOG_ALWAYS_FATAL_IF(ctxt==EGL_NO_CONTEXT, "EGLContext creation failed");
@@ -129,7 +131,10 @@ RenderEngine* RenderEngine::create(EGLDisplay display, int hwcFormat) {
         break;
     case GLES_VERSION_2_0:
     case GLES_VERSION_3_0:
-        engine = new GLES20RenderEngine();
+        // programs are shared with shareContext too, but their uniforms
+        // can't be, so a sharing engine needs programs of its own
+        engine = new GLES20RenderEngine(shareContext != EGL_NO_CONTEXT,
+                primeShaders);
         break;
     }
     engine->setEGLHandles(config, ctxt);
@@ -242,10 +247,22 @@ void RenderEngine::deleteTextures(size_t count, uint32_t const* names) {
     glDeleteTextures(count, names);
 }
 
+void RenderEngine::bindImageAsTexture(EGLImageKHR image, uint32_t texName) {
+    glBindTexture(GL_TEXTURE_2D, texName);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)image);
+}
+
 void RenderEngine::readPixels(size_t l, size_t b, size_t w, size_t h, uint32_t* pixels) {
     glReadPixels(l, b, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 }
 
+void RenderEngine::flush() {
+    glFlush();
+}
+
+void RenderEngine::primeShaders(EGLDisplay, int) {
+}
+
 void RenderEngine::dump(String8& result) {
     const GLExtensions& extensions(GLExtensions::getInstance());
     result.appendFormat("GLES: %s, %s, %s\n",
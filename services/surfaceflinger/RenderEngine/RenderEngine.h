@@ -59,7 +59,16 @@ protected:
     virtual ~RenderEngine() = 0;
 
 public:
-    static RenderEngine* create(EGLDisplay display, int hwcFormat);
+    // shareContext, if given, is the context of another RenderEngine with
+    // which the new one shares its textures; see CompositionThread.
+    // Unless primeShaders is true, the engine's programs are generated by
+    // a later call to primeShaders(), or as they are first used.
+    static RenderEngine* create(EGLDisplay display, int hwcFormat,
+            EGLContext shareContext = EGL_NO_CONTEXT, bool primeShaders = true);
+
+    // generates the engine's programs. Can be called from any thread, and
+    // while the engine is drawing on another one.
+    virtual void primeShaders(EGLDisplay display, int hwcFormat);
 
     static EGLConfig chooseEglConfig(EGLDisplay display, int format);
 
@@ -76,7 +85,9 @@ public:
     void disableScissor();
     void genTextures(size_t count, uint32_t* names);
     void deleteTextures(size_t count, uint32_t const* names);
+    void bindImageAsTexture(EGLImageKHR image, uint32_t texName);
     void readPixels(size_t l, size_t b, size_t w, size_t h, uint32_t* pixels);
+    void flush();
 
     class BindImageAsFramebuffer {
         RenderEngine& mEngine;
@@ -111,6 +122,16 @@ public:
     virtual void beginGroup(const mat4& colorTransform) = 0;
     virtual void endGroup() = 0;
 
+    // sets a color transform applied to everything drawn from now on, as
+    // it's drawn. Unlike a group, it transforms each layer before blending
+    // and doesn't need an extra pass. Pass the identity to disable it.
+    virtual void setupColorTransform(const mat4& colorTransform) = 0;
+
+    // scales the color of everything drawn from now on by the given factor,
+    // which is what blending a black layer of alpha 1-scale over it would
+    // do. Pass 1 to disable it. Returns false if the engine can't do it.
+    virtual bool setupColorScale(float scale) = 0;
+
     // queries
     virtual size_t getMaxTextureSize() const = 0;
     virtual size_t getMaxViewportDims() const = 0;
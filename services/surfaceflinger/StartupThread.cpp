@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StartupThread.h"
+#include "SurfaceFlinger.h"
+
+namespace android {
+
+StartupThread::StartupThread(SurfaceFlinger* flinger, Step step) :
+        mFlinger(flinger),
+        mStep(step) {
+}
+
+StartupThread::~StartupThread() {
+}
+
+bool StartupThread::threadLoop() {
+    switch (mStep) {
+        case INITIALIZE_EGL:
+            mFlinger->initializeEgl();
+            break;
+        case PRIME_SHADERS:
+            mFlinger->primeShaders();
+            break;
+    }
+    // run once
+    return false;
+}
+
+}
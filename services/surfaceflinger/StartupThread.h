@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_STARTUPTHREAD_H
+#define ANDROID_STARTUPTHREAD_H
+
+#include <utils/Thread.h>
+
+namespace android {
+
+class SurfaceFlinger;
+
+/*
+ * StartupThread runs one step of SurfaceFlinger::init() while the main
+ * thread goes on with the steps that don't depend on it, then exits.
+ * init() joins every StartupThread before it returns, so they don't keep
+ * a reference on SurfaceFlinger.
+ */
+class StartupThread : public Thread {
+public:
+    enum Step {
+        // eglInitialize(), which loads the GL driver; the HWComposer and
+        // the EventThreads don't need it
+        INITIALIZE_EGL,
+        // generates the programs of the main RenderEngine, which then waits
+        // for them the first time it draws
+        PRIME_SHADERS,
+    };
+
+    StartupThread(SurfaceFlinger* flinger, Step step);
+    virtual ~StartupThread();
+
+private:
+    virtual bool threadLoop();
+
+    SurfaceFlinger* mFlinger;
+    Step mStep;
+};
+
+}
+
+#endif // ANDROID_STARTUPTHREAD_H
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+
+#include <hardware/hwcomposer_defs.h>
+
+#include "StateSnapshot.h"
+
+namespace android {
+
+StateSnapshot::StateSnapshot(uint64_t frame, nsecs_t when) :
+        mFrame(frame),
+        mWhen(when) {
+}
+
+static const char* compositionTypeName(int32_t type) {
+    switch (type) {
+        case HWC_FRAMEBUFFER: return "GLES";
+        case HWC_OVERLAY: return "HWC";
+        case HWC_BACKGROUND: return "BACKGROUND";
+        case HWC_FRAMEBUFFER_TARGET: return "FB TARGET";
+        case HWC_SIDEBAND: return "SIDEBAND";
+        case HWC_CURSOR_OVERLAY: return "CURSOR";
+        default: return "GLES (no hwc)";
+    }
+}
+
+void StateSnapshot::dump(String8& result) const {
+    result.appendFormat("State snapshot of refresh #%" PRIu64 ", %.1f ms ago\n",
+            mFrame, (systemTime() - mWhen) / 1e6);
+
+    result.appendFormat("Layers (count = %zu)\n", mLayers.size());
+    for (size_t i = 0; i < mLayers.size(); i++) {
+        const LayerInfo& l(mLayers[i]);
+        result.appendFormat("  %8u %s\n"
+                "           layerStack=%u, pos=(%g,%g), size=(%4u,%4u), "
+                "alpha=0x%02x, flags=0x%02x, buffer=(%4u,%4u) format=%d\n",
+                l.z, l.name.string(), l.layerStack, l.x, l.y,
+                l.width, l.height, l.alpha, l.flags,
+                l.bufferWidth, l.bufferHeight, l.bufferFormat);
+    }
+
+    result.appendFormat("Displays (count = %zu)\n", mDisplays.size());
+    for (size_t i = 0; i < mDisplays.size(); i++) {
+        const DisplayInfo& d(mDisplays[i]);
+        result.appendFormat("  %s: hwcId=%d, layerStack=%u, %dx%d\n",
+                d.name.string(), d.hwcId, d.layerStack, d.width, d.height);
+        for (size_t j = 0; j < d.layers.size(); j++) {
+            const ComposedLayer& c(d.layers[j]);
+            result.appendFormat("    %-13s | %s\n",
+                    compositionTypeName(c.compositionType),
+                    mLayers[c.layer].name.string());
+        }
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_STATESNAPSHOT_H
+#define ANDROID_STATESNAPSHOT_H
+
+#include <stdint.h>
+
+#include <utils/RefBase.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+/*
+ * StateSnapshot is what SurfaceFlinger composed in a refresh: the layers
+ * with their geometry, and how each display composed them. The main thread
+ * publishes a new one after each refresh; they never change afterwards, so
+ * that dumpsys SurfaceFlinger --snapshot can print the last one without
+ * taking mStateLock.
+ */
+class StateSnapshot : public LightRefBase<StateSnapshot> {
+public:
+    struct LayerInfo {
+        String8 name;
+        uint32_t z;
+        uint32_t layerStack;
+        float x;
+        float y;
+        uint32_t width;
+        uint32_t height;
+        uint8_t alpha;
+        uint8_t flags;
+        // 0x0 when the layer has no buffer
+        uint32_t bufferWidth;
+        uint32_t bufferHeight;
+        int32_t bufferFormat;
+    };
+
+    struct ComposedLayer {
+        size_t layer;                   // index in mLayers
+        int32_t compositionType;        // HWC_*, -1 without a work list
+    };
+
+    struct DisplayInfo {
+        String8 name;
+        int32_t hwcId;
+        uint32_t layerStack;
+        int32_t width;
+        int32_t height;
+        Vector<ComposedLayer> layers;   // visible layers, bottom first
+    };
+
+    StateSnapshot(uint64_t frame, nsecs_t when);
+
+    const uint64_t mFrame;
+    const nsecs_t mWhen;
+    Vector<LayerInfo> mLayers;          // sorted by z
+    Vector<DisplayInfo> mDisplays;
+
+    void dump(String8& result) const;
+
+private:
+    friend class LightRefBase<StateSnapshot>;
+    ~StateSnapshot() { }
+};
+
+}
+
+#endif // ANDROID_STATESNAPSHOT_H
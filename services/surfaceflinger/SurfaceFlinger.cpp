@@ -23,12 +23,14 @@
 #include <dlfcn.h>
 #include <inttypes.h>
 #include <stdatomic.h>
+#include <unistd.h>
 
 #include <EGL/egl.h>
 
 #include <cutils/log.h>
 #include <cutils/properties.h>
 
+#include <binder/ChunkedTextOutput.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
 #include <binder/MemoryHeapBase.h>
@@ -36,6 +38,7 @@
 
 #include <ui/DisplayInfo.h>
 #include <ui/DisplayStatInfo.h>
+#include <ui/Fence.h>
 
 #include <gui/BitTube.h>
 #include <gui/BufferQueue.h>
@@ -60,13 +63,20 @@
 #include "Client.h"
 #include "clz.h"
 #include "Colorizer.h"
+#include "CompositionCache.h"
+#include "CompositionThread.h"
 #include "DdmConnection.h"
 #include "DisplayDevice.h"
 #include "DispSync.h"
+#include "EventLog/EventLog.h"
 #include "EventControlThread.h"
 #include "EventThread.h"
+#include "FrameStreamer.h"
+#include "HWVsyncThread.h"
 #include "Layer.h"
 #include "LayerDim.h"
+#include "PrelatchThread.h"
+#include "StartupThread.h"
 #include "SurfaceFlinger.h"
 
 #include "DisplayHardware/FramebufferSurface.h"
@@ -90,6 +100,10 @@ EGLAPI const char* eglQueryStringImplementationANDROID(EGLDisplay dpy, EGLint na
 
 namespace android {
 
+// Defined by libEGL, appends the state of its displays, such as their
+// hibernation stats.
+extern "C" void dumpEGLDisplays(String8& result);
+
 // This is the phase offset in nanoseconds of the software vsync event
 // relative to the vsync event reported by HWComposer.  The software vsync
 // event is when SurfaceFlinger and Choreographer-based applications run each
@@ -134,8 +148,21 @@ SurfaceFlinger::SurfaceFlinger()
         mRenderEngine(NULL),
         mBootTime(systemTime()),
         mVisibleRegionsDirty(false),
+        mRecomputeAllVisibleRegions(true),
         mHwWorkListDirty(false),
         mAnimCompositionPending(false),
+        mUseRefreshRatePolicy(false),
+        mRefreshRateCheckPending(false),
+        mDeferredDeletePosted(false),
+        mClientBufferBudget(0),
+        mRefreshCount(0),
+        mDropLateFrames(false),
+        mAsyncFrameAvailable(false),
+        mFrameStatsInterval(0),
+        mLastFrameStatsTime(0),
+        mTransactionHandled(false),
+        mParallelInit(false),
+        mStartupTime(0),
         mDebugRegion(0),
         mDebugDDMS(0),
         mDebugDisableHWC(0),
@@ -144,6 +171,7 @@ SurfaceFlinger::SurfaceFlinger()
         mLastSwapBufferTime(0),
         mDebugInTransaction(0),
         mLastTransactionTime(0),
+        mLastDumpSize(0),
         mBootFinished(false),
         mPrimaryHWVsyncEnabled(false),
         mHWVsyncAvailable(false),
@@ -161,6 +189,20 @@ SurfaceFlinger::SurfaceFlinger()
     property_get("debug.sf.showupdates", value, "0");
     mDebugRegion = atoi(value);
 
+    property_get("debug.sf.jank_trigger", value, "0");
+    FrameTracker::setJankTrigger(atoi(value));
+
+    property_get("debug.sf.fence_stats", value, "0");
+    Fence::setWaitStatsEnabled(atoi(value));
+
+    // Keep the buffers of destroyed surfaces for a moment, a surface of the
+    // same size is often created right after (dialogs, activity transitions).
+    property_get("debug.sf.buffer_pool_kb", value, "16384");
+    size_t bufferPoolBytes = size_t(atoi(value)) * 1024;
+    property_get("debug.sf.buffer_pool_ms", value, "3000");
+    GraphicBufferAllocator::get().setPoolLimits(bufferPoolBytes,
+            ms2ns(atoi(value)));
+
     property_get("debug.sf.ddms", value, "0");
     mDebugDDMS = atoi(value);
     if (mDebugDDMS) {
@@ -299,19 +341,119 @@ void SurfaceFlinger::bootFinished()
 }
 
 void SurfaceFlinger::deleteTextureAsync(uint32_t texture) {
-    class MessageDestroyGLTexture : public MessageBase {
-        RenderEngine& engine;
-        uint32_t texture;
+    Mutex::Autolock _l(mDeferredDeleteLock);
+    mTexturesToDelete.add(texture);
+    scheduleDeferredDeletesLocked();
+}
+
+void SurfaceFlinger::destroyImageAsync(EGLImageKHR image) {
+    Mutex::Autolock _l(mDeferredDeleteLock);
+    mImagesToDestroy.add(image);
+    scheduleDeferredDeletesLocked();
+}
+
+void SurfaceFlinger::releaseBufferAsync(const sp<GraphicBuffer>& buffer) {
+    if (buffer == NULL) {
+        return;
+    }
+    Mutex::Autolock _l(mDeferredDeleteLock);
+    mBuffersToRelease.add(buffer);
+    scheduleDeferredDeletesLocked();
+}
+
+void SurfaceFlinger::scheduleDeferredDeletesLocked() {
+    if (mDeferredDeletePosted) {
+        return;
+    }
+    class MessageDeferredDeletes : public MessageBase {
+        SurfaceFlinger& mFlinger;
     public:
-        MessageDestroyGLTexture(RenderEngine& engine, uint32_t texture)
-            : engine(engine), texture(texture) {
-        }
+        MessageDeferredDeletes(SurfaceFlinger& flinger)
+            : mFlinger(flinger) { }
         virtual bool handler() {
-            engine.deleteTextures(1, &texture);
+            mFlinger.handleDeferredDeletes();
             return true;
         }
     };
-    postMessageAsync(new MessageDestroyGLTexture(getRenderEngine(), texture));
+    // wait a little so that everything released by a burst of layer
+    // destructions is freed at once; the end of the next composition may
+    // get to it first
+    mDeferredDeletePosted = true;
+    postMessageAsync(new MessageDeferredDeletes(*this),
+            DEFERRED_DELETE_DELAY);
+}
+
+void SurfaceFlinger::handleDeferredDeletes() {
+    {
+        Mutex::Autolock _l(mDeferredDeleteLock);
+        mDeferredDeletePosted = false;
+    }
+    if (flushDeferredDeletes(DEFERRED_DELETE_BUDGET)) {
+        Mutex::Autolock _l(mDeferredDeleteLock);
+        scheduleDeferredDeletesLocked();
+    }
+}
+
+size_t SurfaceFlinger::batchSize(size_t count) {
+    return count < DEFERRED_DELETE_BATCH ? count : DEFERRED_DELETE_BATCH;
+}
+
+bool SurfaceFlinger::flushDeferredDeletes(nsecs_t budget) {
+    ATRACE_CALL();
+    const nsecs_t start = systemTime();
+    RenderEngine& engine(getRenderEngine());
+    for (;;) {
+        uint32_t textures[DEFERRED_DELETE_BATCH];
+        EGLImageKHR images[DEFERRED_DELETE_BATCH];
+        Vector< sp<GraphicBuffer> > buffers;
+        size_t numTextures, numImages;
+        bool more;
+        {
+            // take a batch from the end of each queue, the order in which
+            // they are freed doesn't matter
+            Mutex::Autolock _l(mDeferredDeleteLock);
+            numTextures = batchSize(mTexturesToDelete.size());
+            const size_t firstTexture = mTexturesToDelete.size() - numTextures;
+            for (size_t i=0 ; i<numTextures ; i++) {
+                textures[i] = mTexturesToDelete[firstTexture + i];
+            }
+            mTexturesToDelete.removeItemsAt(firstTexture, numTextures);
+
+            numImages = batchSize(mImagesToDestroy.size());
+            const size_t firstImage = mImagesToDestroy.size() - numImages;
+            for (size_t i=0 ; i<numImages ; i++) {
+                images[i] = mImagesToDestroy[firstImage + i];
+            }
+            mImagesToDestroy.removeItemsAt(firstImage, numImages);
+
+            const size_t numBuffers = batchSize(mBuffersToRelease.size());
+            const size_t firstBuffer = mBuffersToRelease.size() - numBuffers;
+            buffers.appendArray(mBuffersToRelease.array() + firstBuffer,
+                    numBuffers);
+            mBuffersToRelease.removeItemsAt(firstBuffer, numBuffers);
+
+            more = !mTexturesToDelete.isEmpty() ||
+                    !mImagesToDestroy.isEmpty() ||
+                    !mBuffersToRelease.isEmpty();
+        }
+
+        // textures first, they may still be bound to the images
+        if (numTextures) {
+            engine.deleteTextures(numTextures, textures);
+        }
+        for (size_t i=0 ; i<numImages ; i++) {
+            eglDestroyImageKHR(mEGLDisplay, images[i]);
+        }
+        // the buffers are freed here, if these were their last references
+        buffers.clear();
+
+        if (!more) {
+            return false;
+        }
+        if (systemTime() - start >= budget) {
+            return true;
+        }
+    }
 }
 
 class DispSyncSource : public VSyncSource, private DispSync::Callback {
@@ -368,7 +510,8 @@ private:
         }
 
         if (callback != NULL) {
-            callback->onVSyncEvent(when);
+            const nsecs_t period = mDispSync->getPeriod();
+            callback->onVSyncEvent(when, period > 0 ? when + period : 0);
         }
     }
 
@@ -390,18 +533,59 @@ void SurfaceFlinger::init() {
 
     status_t err;
     Mutex::Autolock _l(mStateLock);
+    mStartupTime = systemTime();
+
+    // the calls the main thread makes, e.g. to the producers' listeners,
+    // hold up the composition; have them handled at its priority
+    IPCThreadState::self()->setLatencyCritical(true);
+    nsecs_t start;
+
+    // optionally initialize EGL, which loads the GL driver, on a thread of
+    // its own while the HAL loads; then prime the shaders on another one
+    // while the displays are created
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.sf.parallel_init", value, "0");
+    mParallelInit = atoi(value);
 
     // initialize EGL for the default display
-    mEGLDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    eglInitialize(mEGLDisplay, NULL, NULL);
+    sp<StartupThread> eglThread;
+    if (mParallelInit) {
+        eglThread = new StartupThread(this, StartupThread::INITIALIZE_EGL);
+        eglThread->run("StartupEGL", PRIORITY_URGENT_DISPLAY);
+    } else {
+        initializeEgl();
+    }
+
+    // the HWComposer may start delivering vsync events right away
+    mHWVsyncThread = new HWVsyncThread(this);
+    mHWVsyncThread->run("HWVsync", PRIORITY_URGENT_DISPLAY);
+
+    // the EventThreads only need DispSync, so they may start before the
+    // HWComposer; they're only published after the displays are created,
+    // so that onHotplugReceived() still ignores the hotplug events the
+    // HWComposer sends while it's created
+    sp<EventThread> eventThread;
+    sp<EventThread> sfEventThread;
+    if (mParallelInit) {
+        createEventThreads(&eventThread, &sfEventThread);
+    }
 
     // Initialize the H/W composer object.  There may or may not be an
     // actual hardware composer underneath.
+    start = systemTime();
     mHwc = new HWComposer(this,
             *static_cast<HWComposer::EventHandler *>(this));
+    recordStartupStep("hwcomposer", start);
+
+    if (eglThread != NULL) {
+        eglThread->join();
+    }
 
     // get a RenderEngine for the given display / config (can't fail)
-    mRenderEngine = RenderEngine::create(mEGLDisplay, mHwc->getVisualID());
+    start = systemTime();
+    mRenderEngine = RenderEngine::create(mEGLDisplay, mHwc->getVisualID(),
+            EGL_NO_CONTEXT, !mParallelInit);
+    recordStartupStep("render engine", start);
 
     // retrieve the EGL context that was selected/created
     mEGLContext = mRenderEngine->getEGLContext();
@@ -409,7 +593,43 @@ void SurfaceFlinger::init() {
     LOG_ALWAYS_FATAL_IF(mEGLContext == EGL_NO_CONTEXT,
             "couldn't create EGLContext");
 
+    // optionally compose the non-primary displays on their own threads,
+    // each with a RenderEngine sharing textures with the main one
+    property_get("debug.sf.parallel_composition", value, "0");
+    int compositionThreadCount = atoi(value);
+    if (compositionThreadCount > 0) {
+        pthread_key_create(&mRenderEngineKey, NULL);
+        for (int i=0 ; i<compositionThreadCount ; i++) {
+            RenderEngine* engine = RenderEngine::create(mEGLDisplay,
+                    mHwc->getVisualID(), mEGLContext);
+            sp<CompositionThread> thread(new CompositionThread(this, engine));
+            mCompositionThreads.add(thread);
+            thread->run(String8::format("Composition%d", i).string(),
+                    PRIORITY_URGENT_DISPLAY);
+        }
+        ALOGI("parallel composition enabled (%d threads)",
+                compositionThreadCount);
+    }
+
+    // after the composition threads' RenderEngines are created, as that
+    // sets up GLExtensions, which priming reads
+    sp<StartupThread> shaderThread;
+    if (mParallelInit) {
+        shaderThread = new StartupThread(this, StartupThread::PRIME_SHADERS);
+        shaderThread->run("StartupShaders", PRIORITY_URGENT_DISPLAY);
+    }
+
+    // optionally acquire the buffers a frame latches on a thread of their
+    // own, while the main thread handles the transaction
+    property_get("debug.sf.prelatch", value, "0");
+    if (atoi(value)) {
+        mPrelatchThread = new PrelatchThread();
+        mPrelatchThread->run("Prelatch", PRIORITY_URGENT_DISPLAY);
+        ALOGI("buffer prelatching enabled");
+    }
+
     // initialize our non-virtual displays
+    start = systemTime();
     for (size_t i=0 ; i<DisplayDevice::NUM_BUILTIN_DISPLAY_TYPES ; i++) {
         DisplayDevice::DisplayType type((DisplayDevice::DisplayType)i);
         // set-up the displays that are already connected
@@ -445,14 +665,14 @@ void SurfaceFlinger::init() {
     // make the GLContext current so that we can create textures when creating Layers
     // (which may happens before we render something)
     getDefaultDisplayDevice()->makeCurrent(mEGLDisplay, mEGLContext);
+    recordStartupStep("displays", start);
 
     // start the EventThread
-    sp<VSyncSource> vsyncSrc = new DispSyncSource(&mPrimaryDispSync,
-            vsyncPhaseOffsetNs, true, "app");
-    mEventThread = new EventThread(vsyncSrc);
-    sp<VSyncSource> sfVsyncSrc = new DispSyncSource(&mPrimaryDispSync,
-            sfVsyncPhaseOffsetNs, true, "sf");
-    mSFEventThread = new EventThread(sfVsyncSrc);
+    if (!mParallelInit) {
+        createEventThreads(&eventThread, &sfEventThread);
+    }
+    mEventThread = eventThread;
+    mSFEventThread = sfEventThread;
     mEventQueue.setEventThread(mSFEventThread);
 
     mEventControlThread = new EventControlThread(this);
@@ -463,14 +683,132 @@ void SurfaceFlinger::init() {
         mPrimaryDispSync.setPeriod(16666667);
     }
 
+    // optionally lower the refresh rate of the primary display while its
+    // content is idle, or is video at a fraction of a slower refresh rate
+    property_get("debug.sf.refresh_rate_policy", value, "0");
+    if (atoi(value) && mHwc->getConfigs(HWC_DISPLAY_PRIMARY).size() > 1) {
+        mUseRefreshRatePolicy = true;
+        mRefreshRatePolicy.setConfigs(mHwc->getConfigs(HWC_DISPLAY_PRIMARY),
+                getDefaultDisplayDevice()->getActiveConfig());
+        ALOGI("refresh rate policy enabled");
+    }
+
+    // optionally skip the queued frames that are already late
+    property_get("debug.sf.drop_late_frames", value, "0");
+    mDropLateFrames = atoi(value);
+
+    // optionally move the layers' frame-available callbacks off the
+    // producers' binder threads
+    property_get("debug.sf.async_frame_available", value, "0");
+    mAsyncFrameAvailable = atoi(value);
+
+    // optionally batch the frame stats of all layers into one event log
+    // record per interval, also written to the file debug.sf.frame_stats_file
+    // names in EventLog::FRAME_STATS_DIR
+    property_get("debug.sf.frame_stats_interval_ms", value, "0");
+    mFrameStatsInterval = ms2ns(atoi(value));
+    if (mFrameStatsInterval > 0) {
+        char name[PROPERTY_VALUE_MAX];
+        property_get("debug.sf.frame_stats_file", name, "");
+        EventLog::enableBatching(name[0] ? name : NULL);
+        mLastFrameStatsTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    }
+
+    // optionally let the HWC compose dim layers, as a black buffer with a
+    // plane alpha, instead of leaving them to GLES
+    property_get("debug.sf.hwc_dim_layers", value, "0");
+    if (atoi(value)) {
+        mDimLayerBuffer = LayerDim::createHwcBuffer();
+    }
+
+    // optionally limit the buffer memory of clients that aren't visible
+    property_get("debug.sf.client_buffer_budget", value, "0");
+    mClientBufferBudget = size_t(atoi(value)) * 1024 * 1024;
+
+    // optionally start composing a fixed time before the refresh rather
+    // than on the SF VSYNC event, to latch buffers as late as possible
+    property_get("debug.sf.composition_lead_ns", value, "0");
+    const nsecs_t compositionLead = atoll(value);
+    if (compositionLead > 0) {
+        mEventQueue.setCompositionLead(&mPrimaryDispSync, compositionLead);
+        ALOGI("composing %" PRId64 " ns before the refresh", compositionLead);
+    }
+
     // initialize our drawing state
     mDrawingState = mCurrentState;
 
     // set initial conditions (e.g. unblank default device)
     initializeDisplays();
 
+    // optionally stream the composited frames to host profilers
+    property_get("debug.sf.frame_stream_fps", value, "0");
+    const int streamFps = atoi(value);
+    if (streamFps > 0) {
+        property_get("debug.sf.frame_stream_scale", value, "2");
+        mFrameStreamer = new FrameStreamer(this, s2ns(1) / streamFps,
+                atoi(value));
+        if (mFrameStreamer->start() != NO_ERROR) {
+            mFrameStreamer.clear();
+        } else {
+            ALOGI("frame streaming enabled (%d fps)", streamFps);
+        }
+    }
+
+    // the first composition would wait for the programs anyway
+    if (shaderThread != NULL) {
+        shaderThread->join();
+    }
+
     // start boot animation
     startBootAnim();
+    recordStartupStep("init", mStartupTime);
+}
+
+void SurfaceFlinger::initializeEgl() {
+    const nsecs_t start = systemTime();
+    mEGLDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    eglInitialize(mEGLDisplay, NULL, NULL);
+    recordStartupStep("egl", start);
+}
+
+void SurfaceFlinger::primeShaders() {
+    const nsecs_t start = systemTime();
+    mRenderEngine->primeShaders(mEGLDisplay, mHwc->getVisualID());
+    recordStartupStep("shaders", start);
+}
+
+void SurfaceFlinger::createEventThreads(sp<EventThread>* app,
+        sp<EventThread>* sf) {
+    const nsecs_t start = systemTime();
+    sp<VSyncSource> vsyncSrc = new DispSyncSource(&mPrimaryDispSync,
+            vsyncPhaseOffsetNs, true, "app");
+    *app = new EventThread(vsyncSrc);
+    sp<VSyncSource> sfVsyncSrc = new DispSyncSource(&mPrimaryDispSync,
+            sfVsyncPhaseOffsetNs, true, "sf");
+    *sf = new EventThread(sfVsyncSrc);
+    recordStartupStep("event threads", start);
+}
+
+void SurfaceFlinger::recordStartupStep(const char* name, nsecs_t start) {
+    StartupStep step;
+    step.name = name;
+    step.tid = gettid();
+    step.start = start - mStartupTime;
+    step.end = systemTime() - mStartupTime;
+    Mutex::Autolock _l(mStartupLock);
+    mStartupSteps.add(step);
+}
+
+void SurfaceFlinger::dumpStartupTimeline(String8& result) const {
+    Mutex::Autolock _l(mStartupLock);
+    result.appendFormat("  %s init, main thread %d\n",
+            mParallelInit ? "parallel" : "sequential", getpid());
+    for (size_t i=0 ; i<mStartupSteps.size() ; i++) {
+        const StartupStep& step(mStartupSteps[i]);
+        result.appendFormat("  %-14s %8.2f ms .. %8.2f ms (%8.2f ms) tid %d\n",
+                step.name, step.start / 1e6, step.end / 1e6,
+                (step.end - step.start) / 1e6, step.tid);
+    }
 }
 
 int32_t SurfaceFlinger::allocateHwcDisplayId(DisplayDevice::DisplayType type) {
@@ -649,6 +987,62 @@ void SurfaceFlinger::setActiveConfigInternal(const sp<DisplayDevice>& hw, int mo
 
     hw->setActiveConfig(mode);
     getHwComposer().setActiveConfig(type, mode);
+
+    if (type == DisplayDevice::DISPLAY_PRIMARY) {
+        // the vsync model and the frame stats must follow the new period
+        const nsecs_t period = getHwComposer().getRefreshPeriod(type);
+        mAnimFrameTracker.setDisplayRefreshPeriod(period);
+        if (hw->isDisplayOn()) {
+            resyncToHardwareVsync(false);
+        }
+    }
+}
+
+void SurfaceFlinger::updateRefreshRatePolicy() {
+    if (!mUseRefreshRatePolicy) {
+        return;
+    }
+
+    const sp<DisplayDevice> hw(getDisplayDevice(
+            mBuiltinDisplays[DisplayDevice::DISPLAY_PRIMARY]));
+    if (!hw->isDisplayOn()) {
+        return;
+    }
+
+    const nsecs_t now = systemTime();
+    nsecs_t contentPeriod = 0;
+    const Vector< sp<Layer> >& layers(hw->getVisibleLayersSortedByZ());
+    for (size_t i=0 ; i<layers.size() ; i++) {
+        const nsecs_t period = layers[i]->getQueuePeriod(now);
+        if (period && (!contentPeriod || period < contentPeriod)) {
+            contentPeriod = period;
+        }
+    }
+
+    const int config = mRefreshRatePolicy.onContentUpdate(now, contentPeriod);
+    if (config >= 0 && config != hw->getActiveConfig()) {
+        setActiveConfigInternal(hw, config);
+    }
+
+    // Nothing is composed while the screen is idle, so check again later
+    // rather than relying on the next composition to notice.
+    if ((contentPeriod || !mRefreshRatePolicy.isSettled()) &&
+            !mRefreshRateCheckPending) {
+        class MessageCheckRefreshRate : public MessageBase {
+            SurfaceFlinger& mFlinger;
+        public:
+            MessageCheckRefreshRate(SurfaceFlinger& flinger)
+                : mFlinger(flinger) { }
+            virtual bool handler() {
+                mFlinger.mRefreshRateCheckPending = false;
+                mFlinger.updateRefreshRatePolicy();
+                return true;
+            }
+        };
+        mRefreshRateCheckPending = true;
+        postMessageAsync(new MessageCheckRefreshRate(*this),
+                RefreshRatePolicy::IDLE_TIMEOUT);
+    }
 }
 
 status_t SurfaceFlinger::setActiveConfig(const sp<IBinder>& display, int mode) {
@@ -676,6 +1070,13 @@ status_t SurfaceFlinger::setActiveConfig(const sp<IBinder>& display, int mode) {
                         mMode);
             } else {
                 mFlinger.setActiveConfigInternal(hw, mMode);
+                if (mFlinger.mUseRefreshRatePolicy &&
+                        hw->getDisplayType() == DisplayDevice::DISPLAY_PRIMARY) {
+                    // the policy only ever goes slower than what was asked
+                    mFlinger.mRefreshRatePolicy.setConfigs(
+                            mFlinger.getHwComposer().getConfigs(
+                                    HWC_DISPLAY_PRIMARY), mMode);
+                }
             }
             return true;
         }
@@ -697,6 +1098,43 @@ status_t SurfaceFlinger::getAnimationFrameStats(FrameStats* outStats) const {
     return NO_ERROR;
 }
 
+status_t SurfaceFlinger::getLayerFrameStatInfo(Vector<String8>* outNames,
+        Vector<FrameStatInfo>* outInfos) const {
+    if (outNames == NULL || outInfos == NULL) {
+        return BAD_VALUE;
+    }
+
+    Mutex::Autolock _l(mStateLock);
+    const LayerVector& currentLayers = mCurrentState.layersSortedByZ;
+    const size_t count = currentLayers.size();
+    outNames->clear();
+    outInfos->clear();
+    outNames->setCapacity(count + 1);
+    outInfos->setCapacity(count + 1);
+
+    FrameStatInfo info;
+    mAnimFrameTracker.getStatInfo(&info);
+    outNames->add(String8("<win-anim>"));
+    outInfos->add(info);
+
+    for (size_t i=0 ; i<count ; i++) {
+        const sp<Layer>& layer(currentLayers[i]);
+        layer->getFrameStatInfo(&info);
+        outNames->add(layer->getName());
+        outInfos->add(info);
+    }
+    return NO_ERROR;
+}
+
+status_t SurfaceFlinger::getCompositionTimeline(
+        Vector<CompositionTiming>* outTimings) const {
+    if (outTimings == NULL) {
+        return BAD_VALUE;
+    }
+    mCompositionTimeline.getTimings(outTimings);
+    return NO_ERROR;
+}
+
 // ----------------------------------------------------------------------------
 
 sp<IDisplayEventConnection> SurfaceFlinger::createDisplayEventConnection() {
@@ -789,11 +1227,26 @@ void SurfaceFlinger::disableHardwareVsync(bool makeUnavailable) {
 }
 
 void SurfaceFlinger::onVSyncReceived(int type, nsecs_t timestamp) {
+    if (type == 0) {
+        // this runs on the HWComposer callback thread, which mustn't wait
+        // for our locks
+        mHWVsyncThread->queueVsync(timestamp);
+        return;
+    }
+    // we don't track the vsync of the other displays
+    disableHardwareVsync(false);
+}
+
+nsecs_t SurfaceFlinger::getPrimaryVsyncPeriod() {
+    return mPrimaryDispSync.getPeriod();
+}
+
+void SurfaceFlinger::onPrimaryHWVsync(nsecs_t timestamp) {
     bool needsHwVsync = false;
 
     { // Scope for the lock
         Mutex::Autolock _l(mHWVsyncLock);
-        if (type == 0 && mPrimaryHWVsyncEnabled) {
+        if (mPrimaryHWVsyncEnabled) {
             needsHwVsync = mPrimaryDispSync.addResyncSample(timestamp);
         }
     }
@@ -839,37 +1292,122 @@ void SurfaceFlinger::onMessageReceived(int32_t what) {
     case MessageQueue::TRANSACTION:
         handleMessageTransaction();
         break;
-    case MessageQueue::INVALIDATE:
+    case MessageQueue::INVALIDATE: {
+        onFrameStart();
+        startPrelatch();
+        // only refresh if something may have changed: a display showing
+        // nothing but sideband streams has its content updated by the HWC,
+        // without SurfaceFlinger having anything to compose
         handleMessageTransaction();
-        handleMessageInvalidate();
-        signalRefresh();
+        if (handleMessageInvalidate() || mTransactionHandled ||
+                mRepaintEverything) {
+            mTransactionHandled = false;
+            signalRefresh();
+        }
         break;
+    }
     case MessageQueue::REFRESH:
         handleMessageRefresh();
         break;
     }
 }
 
+void SurfaceFlinger::onFrameStart() {
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    const nsecs_t deadline = mPrimaryDispSync.getPeriod() > 0 ?
+            mPrimaryDispSync.computeNextRefresh(0) : 0;
+    if (mDeadlineTracker.onFrameStart(now, mEventQueue.getInvalidateTime(),
+            deadline)) {
+        ATRACE_INT64("LateStart",
+                now - mEventQueue.getInvalidateTime());
+        ATRACE_INT64("LateStart", 0);
+    }
+}
+
+void SurfaceFlinger::onFrameEnd() {
+    const nsecs_t overrun = mDeadlineTracker.onFrameEnd(
+            systemTime(SYSTEM_TIME_MONOTONIC));
+    if (overrun) {
+        ATRACE_INT64("Overrun", overrun);
+        ATRACE_INT64("Overrun", 0);
+    }
+}
+
 void SurfaceFlinger::handleMessageTransaction() {
     uint32_t transactionFlags = peekTransactionFlags(eTransactionMask);
     if (transactionFlags) {
         handleTransaction(transactionFlags);
+        mTransactionHandled = true;
     }
 }
 
-void SurfaceFlinger::handleMessageInvalidate() {
+bool SurfaceFlinger::handleMessageInvalidate() {
     ATRACE_CALL();
-    handlePageFlip();
+    return handlePageFlip();
 }
 
 void SurfaceFlinger::handleMessageRefresh() {
     ATRACE_CALL();
+    CompositionTiming timing;
+    const nsecs_t refreshTime = systemTime();
     preComposition();
+    const nsecs_t preCompositionEnd = systemTime();
     rebuildLayerStacks();
+    const nsecs_t rebuildEnd = systemTime();
     setUpHWComposer();
+    const nsecs_t setUpEnd = systemTime();
+    countComposedLayers(&timing);
     doDebugFlashRegions();
     doComposition();
+    const nsecs_t compositionEnd = systemTime();
     postComposition();
+    publishStateSnapshot();
+    timing.refreshTime = refreshTime;
+    timing.preComposition = preCompositionEnd - refreshTime;
+    timing.rebuildLayerStacks = rebuildEnd - preCompositionEnd;
+    timing.setUpHWComposer = setUpEnd - rebuildEnd;
+    timing.doComposition = compositionEnd - setUpEnd;
+    timing.postComposition = systemTime() - compositionEnd;
+    mCompositionTimeline.add(timing);
+    onFrameEnd();
+    updateRefreshRatePolicy();
+    if (flushDeferredDeletes(DEFERRED_DELETE_BUDGET)) {
+        Mutex::Autolock _l(mDeferredDeleteLock);
+        scheduleDeferredDeletesLocked();
+    }
+}
+
+void SurfaceFlinger::countComposedLayers(CompositionTiming* timing) {
+    timing->displayCount = 0;
+    timing->layerCount = 0;
+    timing->glesLayerCount = 0;
+    timing->overlayLayerCount = 0;
+    HWComposer& hwc(getHwComposer());
+    for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
+        const sp<const DisplayDevice> hw(mDisplays[dpy]);
+        if (!hw->isDisplayOn()) {
+            continue;
+        }
+        const size_t count = hw->getVisibleLayersSortedByZ().size();
+        timing->displayCount++;
+        timing->layerCount += count;
+        const int32_t id = hw->getHwcDisplayId();
+        if (id < 0) {
+            timing->glesLayerCount += count;
+            continue;
+        }
+        // without a work list, everything is composed with GLES
+        size_t overlays = 0;
+        HWComposer::LayerListIterator cur = hwc.begin(id);
+        const HWComposer::LayerListIterator end = hwc.end(id);
+        for (size_t i=0 ; i<count && cur!=end ; i++, ++cur) {
+            if (cur->getCompositionType() != HWC_FRAMEBUFFER) {
+                overlays++;
+            }
+        }
+        timing->overlayLayerCount += overlays;
+        timing->glesLayerCount += count - overlays;
+    }
 }
 
 void SurfaceFlinger::doDebugFlashRegions()
@@ -894,7 +1432,7 @@ void SurfaceFlinger::doDebugFlashRegions()
                 engine.fillRegionWithColor(dirtyRegion, height, 1, 0, 1, 1);
 
                 hw->compositionComplete();
-                hw->swapBuffers(getHwComposer());
+                hw->swapBuffers(getHwComposer(), Region(hw->bounds()));
             }
         }
     }
@@ -935,6 +1473,8 @@ void SurfaceFlinger::postComposition()
         layers[i]->onPostComposition();
     }
 
+    GraphicBufferAllocator::get().trimPool();
+
     const HWComposer& hwc = getHwComposer();
     sp<Fence> presentFence = hwc.getDisplayFence(HWC_DISPLAY_PRIMARY);
 
@@ -968,6 +1508,70 @@ void SurfaceFlinger::postComposition()
     }
 }
 
+void SurfaceFlinger::publishStateSnapshot()
+{
+    sp<StateSnapshot> snapshot(new StateSnapshot(++mRefreshCount, systemTime()));
+
+    const LayerVector& layers(mDrawingState.layersSortedByZ);
+    const size_t count = layers.size();
+    KeyedVector<const Layer*, size_t> indices;
+    snapshot->mLayers.setCapacity(count);
+    for (size_t i=0 ; i<count ; i++) {
+        const sp<Layer>& layer(layers[i]);
+        const Layer::State& s(layer->getDrawingState());
+        const sp<GraphicBuffer>& buffer(layer->getActiveBuffer());
+        StateSnapshot::LayerInfo info;
+        info.name = layer->getName();
+        info.z = s.z;
+        info.layerStack = s.layerStack;
+        info.x = s.transform.tx();
+        info.y = s.transform.ty();
+        info.width = s.active.w;
+        info.height = s.active.h;
+        info.alpha = s.alpha;
+        info.flags = s.flags;
+        info.bufferWidth = buffer != 0 ? buffer->getWidth() : 0;
+        info.bufferHeight = buffer != 0 ? buffer->getHeight() : 0;
+        info.bufferFormat = buffer != 0 ? buffer->getPixelFormat() : 0;
+        indices.add(layer.get(), snapshot->mLayers.add(info));
+    }
+
+    HWComposer& hwc(getHwComposer());
+    snapshot->mDisplays.setCapacity(mDisplays.size());
+    for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
+        const sp<const DisplayDevice>& hw(mDisplays[dpy]);
+        StateSnapshot::DisplayInfo info;
+        info.name = hw->getDisplayName();
+        info.hwcId = hw->getHwcDisplayId();
+        info.layerStack = hw->getLayerStack();
+        info.width = hw->getWidth();
+        info.height = hw->getHeight();
+        const Vector< sp<Layer> >& visible(hw->getVisibleLayersSortedByZ());
+        HWComposer::LayerListIterator cur = hwc.begin(info.hwcId);
+        const HWComposer::LayerListIterator end = hwc.end(info.hwcId);
+        for (size_t i=0 ; i<visible.size() ; i++) {
+            StateSnapshot::ComposedLayer composed;
+            composed.layer = indices.valueFor(visible[i].get());
+            composed.compositionType = -1;
+            if (cur != end) {
+                composed.compositionType = cur->getCompositionType();
+                ++cur;
+            }
+            info.layers.add(composed);
+        }
+        snapshot->mDisplays.add(info);
+    }
+
+    Mutex::Autolock _l(mStateSnapshotLock);
+    mStateSnapshot = snapshot;
+}
+
+sp<const StateSnapshot> SurfaceFlinger::getStateSnapshot() const
+{
+    Mutex::Autolock _l(mStateSnapshotLock);
+    return mStateSnapshot;
+}
+
 void SurfaceFlinger::rebuildLayerStacks() {
     // rebuild the visible layer list per screen
     if (CC_UNLIKELY(mVisibleRegionsDirty)) {
@@ -976,6 +1580,14 @@ void SurfaceFlinger::rebuildLayerStacks() {
         invalidateHwcGeometry();
 
         const LayerVector& layers(mDrawingState.layersSortedByZ);
+        const bool incremental = !mRecomputeAllVisibleRegions;
+        mRecomputeAllVisibleRegions = false;
+
+        // Displays showing the same layer stack share one computation
+        Vector<uint32_t> computedLayerStacks;
+        Vector<Region> computedDirtyRegions;
+        Vector<Region> computedOpaqueRegions;
+
         for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
             Region opaqueRegion;
             Region dirtyRegion;
@@ -984,8 +1596,19 @@ void SurfaceFlinger::rebuildLayerStacks() {
             const Transform& tr(hw->getTransform());
             const Rect bounds(hw->getBounds());
             if (hw->isDisplayOn()) {
-                SurfaceFlinger::computeVisibleRegions(layers,
-                        hw->getLayerStack(), dirtyRegion, opaqueRegion);
+                const ssize_t computed =
+                        computedLayerStacks.indexOf(hw->getLayerStack());
+                if (computed >= 0) {
+                    dirtyRegion = computedDirtyRegions[computed];
+                    opaqueRegion = computedOpaqueRegions[computed];
+                } else {
+                    SurfaceFlinger::computeVisibleRegions(layers,
+                            hw->getLayerStack(), incremental, dirtyRegion,
+                            opaqueRegion);
+                    computedLayerStacks.add(hw->getLayerStack());
+                    computedDirtyRegions.add(dirtyRegion);
+                    computedOpaqueRegions.add(opaqueRegion);
+                }
 
                 const size_t count = layers.size();
                 for (size_t i=0 ; i<count ; i++) {
@@ -1006,6 +1629,73 @@ void SurfaceFlinger::rebuildLayerStacks() {
             hw->undefinedRegion.subtractSelf(tr.transform(opaqueRegion));
             hw->dirtyRegion.orSelf(dirtyRegion);
         }
+
+        // Only now that every layer stack has seen them (a layer may have
+        // moved from one stack to another) can the changes be forgotten.
+        // Stacks that no display showed get fully recomputed once one does.
+        for (size_t i=0 ; i<layers.size() ; i++) {
+            const sp<Layer>& layer(layers[i]);
+            layer->visibleRegionsDirty = false;
+            layer->visibleRegionsLayerStack =
+                    layer->getDrawingState().layerStack;
+        }
+
+        // clients become visible or invisible with their layers
+        enforceBufferBudgets();
+    }
+}
+
+void SurfaceFlinger::getClientBufferUsage(
+        KeyedVector<const Client*, ClientBufferUsage>* outUsage) const {
+    SortedVector<const Layer*> visible;
+    for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
+        const Vector< sp<Layer> >& layers(
+                mDisplays[dpy]->getVisibleLayersSortedByZ());
+        for (size_t i=0 ; i<layers.size() ; i++) {
+            visible.add(layers[i].get());
+        }
+    }
+
+    const LayerVector& layers(mDrawingState.layersSortedByZ);
+    for (size_t i=0 ; i<layers.size() ; i++) {
+        const sp<Layer>& layer(layers[i]);
+        const Client* client = layer->getClient().get();
+        ssize_t index = outUsage->indexOfKey(client);
+        if (index < 0) {
+            ClientBufferUsage usage;
+            usage.bytes = 0;
+            usage.layers = 0;
+            usage.foreground = false;
+            index = outUsage->add(client, usage);
+        }
+        ClientBufferUsage& usage(outUsage->editValueAt(index));
+        usage.bytes += layer->getAllocatedBufferBytes();
+        usage.layers++;
+        if (visible.indexOf(layer.get()) >= 0) {
+            usage.foreground = true;
+        }
+    }
+}
+
+void SurfaceFlinger::enforceBufferBudgets() {
+    if (!mClientBufferBudget) {
+        return;
+    }
+    KeyedVector<const Client*, ClientBufferUsage> clients;
+    getClientBufferUsage(&clients);
+
+    // A layer stays double buffered until its client is visible again,
+    // even once it's under budget, so that it doesn't go back and forth.
+    const LayerVector& layers(mDrawingState.layersSortedByZ);
+    for (size_t i=0 ; i<layers.size() ; i++) {
+        const sp<Layer>& layer(layers[i]);
+        const ClientBufferUsage& usage(
+                clients.valueFor(layer->getClient().get()));
+        if (usage.foreground) {
+            layer->setBufferBudgetReduced(false);
+        } else if (usage.bytes > mClientBufferBudget) {
+            layer->setBufferBudgetReduced(true);
+        }
     }
 }
 
@@ -1054,12 +1744,20 @@ void SurfaceFlinger::setUpHWComposer() {
                     if (hwc.createWorkList(id, count) == NO_ERROR) {
                         HWComposer::LayerListIterator cur = hwc.begin(id);
                         const HWComposer::LayerListIterator end = hwc.end(id);
+                        bool hasCursorHint = false;
                         for (size_t i=0 ; cur!=end && i<count ; ++i, ++cur) {
                             const sp<Layer>& layer(currentLayers[i]);
                             layer->setGeometry(hw, *cur);
                             if (mDebugDisableHWC || mDebugRegion || mDaltonize || mHasColorMatrix) {
                                 cur->setSkip(true);
                             }
+                            // If possible, attempt to use the cursor overlay.
+                            // The hint is part of the geometry, so it stays
+                            // set until the work list is rebuilt.
+                            if (!hasCursorHint && layer->isPotentialCursor()) {
+                                cur->setIsCursorLayerHint();
+                                hasCursorHint = true;
+                            }
                         }
                     }
                 }
@@ -1087,26 +1785,6 @@ void SurfaceFlinger::setUpHWComposer() {
             }
         }
 
-        // If possible, attempt to use the cursor overlay on each display.
-        for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
-            sp<const DisplayDevice> hw(mDisplays[dpy]);
-            const int32_t id = hw->getHwcDisplayId();
-            if (id >= 0) {
-                const Vector< sp<Layer> >& currentLayers(
-                    hw->getVisibleLayersSortedByZ());
-                const size_t count = currentLayers.size();
-                HWComposer::LayerListIterator cur = hwc.begin(id);
-                const HWComposer::LayerListIterator end = hwc.end(id);
-                for (size_t i=0 ; cur!=end && i<count ; ++i, ++cur) {
-                    const sp<Layer>& layer(currentLayers[i]);
-                    if (layer->isPotentialCursor()) {
-                        cur->setIsCursorLayerHint();
-                        break;
-                    }
-                }
-            }
-        }
-
         status_t err = hwc.prepare();
         ALOGE_IF(err, "HWComposer::prepare failed (%s)", strerror(-err));
 
@@ -1114,31 +1792,119 @@ void SurfaceFlinger::setUpHWComposer() {
             sp<const DisplayDevice> hw(mDisplays[dpy]);
             hw->prepareFrame(hwc);
         }
+
+        updateAsyncCursors();
     }
+
+    updateCompositionHint();
+}
+
+void SurfaceFlinger::updateCompositionHint() {
+    if (!mPowerHAL.isCompositionHintEnabled()) {
+        return;
+    }
+
+    HWComposer& hwc(getHwComposer());
+    uint64_t glesPixels = 0;
+    uint32_t glesLayers = 0;
+    bool virtualDisplay = false;
+    for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
+        const sp<const DisplayDevice> hw(mDisplays[dpy]);
+        if (!hw->isDisplayOn()) {
+            continue;
+        }
+        if (hw->getDisplayType() == DisplayDevice::DISPLAY_VIRTUAL) {
+            virtualDisplay = true;
+        }
+        const int32_t id = hw->getHwcDisplayId();
+        if (!hwc.hasGlesComposition(id)) {
+            continue;
+        }
+        // without a work list, everything is composed with GLES
+        const Vector< sp<Layer> >& layers(hw->getVisibleLayersSortedByZ());
+        const Transform& tr(hw->getTransform());
+        HWComposer::LayerListIterator cur = hwc.begin(id);
+        const HWComposer::LayerListIterator end = hwc.end(id);
+        for (size_t i=0 ; i<layers.size() ; i++) {
+            if (cur != end) {
+                const bool gles = cur->getCompositionType() == HWC_FRAMEBUFFER;
+                ++cur;
+                if (!gles) {
+                    continue;
+                }
+            }
+            const Rect bounds(tr.transform(layers[i]->visibleRegion.bounds()));
+            glesPixels += uint64_t(bounds.getWidth()) * bounds.getHeight();
+            glesLayers++;
+        }
+    }
+
+    const sp<const DisplayDevice> primary(getDefaultDisplayDevice());
+    const uint64_t primaryPixels =
+            uint64_t(primary->getWidth()) * primary->getHeight();
+    const uint64_t percent = primaryPixels ?
+            glesPixels * 100 / primaryPixels : 0;
+    mPowerHAL.compositionHint(glesLayers,
+            percent < 0xFFFF ? uint32_t(percent) : 0xFFFF, virtualDisplay);
 }
 
 void SurfaceFlinger::doComposition() {
     ATRACE_CALL();
     const bool repaintEverything = android_atomic_and(0, &mRepaintEverything);
+    const size_t threadCount = mCompositionThreads.size();
+    if (threadCount) {
+        // the composition threads sample the textures that were latched
+        // on our context, make sure those updates have reached the GPU
+        mRenderEngine->flush();
+    }
+    size_t nextThread = 0;
     for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
         const sp<DisplayDevice>& hw(mDisplays[dpy]);
+        if (threadCount &&
+                hw->getDisplayType() != DisplayDevice::DISPLAY_PRIMARY) {
+            if (hw->isDisplayOn()) {
+                mCompositionThreads[nextThread++ % threadCount]->compose(
+                        hw, repaintEverything);
+            }
+            continue;
+        }
         if (hw->isDisplayOn()) {
-            // transform the dirty region into this screen's coordinate space
-            const Region dirtyRegion(hw->getDirtyRegion(repaintEverything));
-
-            // repaint the framebuffer (if needed)
-            doDisplayComposition(hw, dirtyRegion);
-
-            hw->dirtyRegion.clear();
-            hw->flip(hw->swapRegion);
-            hw->swapRegion.clear();
+            composeDisplay(hw, repaintEverything);
         }
         // inform the h/w that we're done compositing
         hw->compositionComplete();
     }
+    if (threadCount) {
+        for (size_t i=0 ; i<threadCount ; i++) {
+            mCompositionThreads[i]->waitForCompletion();
+        }
+        for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
+            const sp<DisplayDevice>& hw(mDisplays[dpy]);
+            if (hw->getDisplayType() != DisplayDevice::DISPLAY_PRIMARY) {
+                hw->compositionComplete();
+            }
+        }
+    }
     postFramebuffer();
 }
 
+void SurfaceFlinger::composeDisplay(const sp<DisplayDevice>& hw,
+        bool repaintEverything) {
+    // transform the dirty region into this screen's coordinate space
+    const Region dirtyRegion(hw->getDirtyRegion(repaintEverything));
+
+    // repaint the framebuffer (if needed)
+    doDisplayComposition(hw, dirtyRegion);
+
+    hw->dirtyRegion.clear();
+    hw->flip(hw->swapRegion);
+    hw->swapRegion.clear();
+}
+
+void SurfaceFlinger::setCurrentThreadRenderEngine(RenderEngine* engine) {
+    pthread_setspecific(mRenderEngineKey, engine);
+}
+
 void SurfaceFlinger::postFramebuffer()
 {
     ATRACE_CALL();
@@ -1185,9 +1951,16 @@ void SurfaceFlinger::postFramebuffer()
     mLastSwapBufferTime = systemTime() - now;
     mDebugInSwapBuffers = 0;
 
-    uint32_t flipCount = getDefaultDisplayDevice()->getPageFlipCount();
-    if (flipCount % LOG_FRAME_STATS_PERIOD == 0) {
-        logFrameStats();
+    if (mFrameStatsInterval > 0) {
+        if (now - mLastFrameStatsTime >= mFrameStatsInterval) {
+            mLastFrameStatsTime = now;
+            logFrameStats();
+        }
+    } else {
+        uint32_t flipCount = getDefaultDisplayDevice()->getPageFlipCount();
+        if (flipCount % LOG_FRAME_STATS_PERIOD == 0) {
+            logFrameStats();
+        }
     }
 }
 
@@ -1195,11 +1968,18 @@ void SurfaceFlinger::handleTransaction(uint32_t transactionFlags)
 {
     ATRACE_CALL();
 
-    // here we keep a copy of the drawing state (that is the state that's
+    // here we keep a copy of the drawing displays (that is the state that's
     // going to be overwritten by handleTransactionLocked()) outside of
-    // mStateLock so that the side-effects of the State assignment
-    // don't happen with mStateLock held (which can cause deadlocks).
-    State drawingState(mDrawingState);
+    // mStateLock so that the side-effects of the assignment don't happen
+    // with mStateLock held (which can cause deadlocks). The layers
+    // commitTransaction() takes out of the drawing list are kept alive
+    // the same way, by reorderedLayers, and so are the surfaces and clients
+    // the pending layer states refer to, by appliedStates. The drawing list
+    // itself isn't copied, so that it can be edited in place.
+    DefaultKeyedVector< wp<IBinder>, DisplayDeviceState>
+            drawingDisplays(mDrawingState.displays);
+    SortedVector< sp<Layer> > reorderedLayers;
+    KeyedVector< sp<IBinder>, PendingClientState > appliedStates;
 
     Mutex::Autolock _l(mStateLock);
     const nsecs_t now = systemTime();
@@ -1211,13 +1991,22 @@ void SurfaceFlinger::handleTransaction(uint32_t transactionFlags)
     // with mStateLock held to guarantee that mCurrentState won't change
     // until the transaction is committed.
 
-    transactionFlags = getTransactionFlags(eTransactionMask);
+    appliedStates = mPendingClientStates;
+    transactionFlags = applyPendingClientStatesLocked();
+    transactionFlags |= getTransactionFlags(eTransactionMask);
+    reorderedLayers = mLayersPendingReorder;
     handleTransactionLocked(transactionFlags);
 
     mLastTransactionTime = systemTime() - now;
     mDebugInTransaction = 0;
     invalidateHwcGeometry();
     // here the transaction has been committed
+
+    if (mUseRefreshRatePolicy) {
+        // transactions mostly follow user input, which expects the full
+        // refresh rate
+        mRefreshRatePolicy.onTransaction(now);
+    }
 }
 
 void SurfaceFlinger::handleTransactionLocked(uint32_t transactionFlags)
@@ -1237,8 +2026,10 @@ void SurfaceFlinger::handleTransactionLocked(uint32_t transactionFlags)
             if (!trFlags) continue;
 
             const uint32_t flags = layer->doTransaction(0);
-            if (flags & Layer::eVisibleRegion)
+            if (flags & Layer::eVisibleRegion) {
                 mVisibleRegionsDirty = true;
+                layer->visibleRegionsDirty = true;
+            }
         }
     }
 
@@ -1254,6 +2045,7 @@ void SurfaceFlinger::handleTransactionLocked(uint32_t transactionFlags)
         const KeyedVector<  wp<IBinder>, DisplayDeviceState>& draw(mDrawingState.displays);
         if (!curr.isIdenticalTo(draw)) {
             mVisibleRegionsDirty = true;
+            mRecomputeAllVisibleRegions = true;
             const size_t cc = curr.size();
                   size_t dc = draw.size();
 
@@ -1460,6 +2252,7 @@ void SurfaceFlinger::handleTransactionLocked(uint32_t transactionFlags)
     if (currentLayers.size() > layers.size()) {
         // layers have been added
         mVisibleRegionsDirty = true;
+        mRecomputeAllVisibleRegions = true;
     }
 
     // some layers might have been removed, so
@@ -1467,6 +2260,7 @@ void SurfaceFlinger::handleTransactionLocked(uint32_t transactionFlags)
     if (mLayersRemoved) {
         mLayersRemoved = false;
         mVisibleRegionsDirty = true;
+        mRecomputeAllVisibleRegions = true;
         const size_t count = layers.size();
         for (size_t i=0 ; i<count ; i++) {
             const sp<Layer>& layer(layers[i]);
@@ -1514,6 +2308,71 @@ void SurfaceFlinger::updateCursorAsync()
     }
 }
 
+void SurfaceFlinger::updateAsyncCursors()
+{
+    HWComposer& hwc(getHwComposer());
+    Vector<AsyncCursor> cursors;
+    for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
+        sp<const DisplayDevice> hw(mDisplays[dpy]);
+        const int32_t id = hw->getHwcDisplayId();
+        if (id < 0) {
+            continue;
+        }
+        const Vector< sp<Layer> >& currentLayers(
+            hw->getVisibleLayersSortedByZ());
+        const size_t count = currentLayers.size();
+        HWComposer::LayerListIterator cur = hwc.begin(id);
+        const HWComposer::LayerListIterator end = hwc.end(id);
+        for (size_t i=0 ; cur!=end && i<count ; ++i, ++cur) {
+            if (cur->getCompositionType() == HWC_CURSOR_OVERLAY) {
+                AsyncCursor cursor;
+                cursor.layer = currentLayers[i];
+                cursor.display = hw;
+                cursors.add(cursor);
+                break;
+            }
+        }
+    }
+
+    Mutex::Autolock _l(mAsyncCursorLock);
+    mAsyncCursors = cursors;
+}
+
+void SurfaceFlinger::moveCursorAsyncLocked(const sp<Client>& client,
+        const layer_state_t& s)
+{
+    Vector<AsyncCursor> cursors;
+    {
+        Mutex::Autolock _l(mAsyncCursorLock);
+        if (mAsyncCursors.isEmpty()) {
+            return;
+        }
+        cursors = mAsyncCursors;
+    }
+
+    sp<Layer> layer(client->getLayerUser(s.surface));
+    if (layer == NULL) {
+        return;
+    }
+
+    // the HWC moves cursor overlays without a prepare/set, so the cursor
+    // follows the pointer even while the main thread is busy composing;
+    // the transaction still updates the layer as usual afterwards
+    HWComposer& hwc(getHwComposer());
+    Transform transform(layer->getCurrentState().transform);
+    transform.set(s.x, s.y);
+    for (size_t i=0 ; i<cursors.size() ; i++) {
+        if (cursors[i].layer.promote() != layer) {
+            continue;
+        }
+        sp<const DisplayDevice> hw(cursors[i].display.promote());
+        if (hw != NULL && hw->getHwcDisplayId() >= 0) {
+            hwc.setCursorPositionAsync(hw->getHwcDisplayId(),
+                    layer->getPosition(hw, transform));
+        }
+    }
+}
+
 void SurfaceFlinger::commitTransaction()
 {
     if (!mLayersPendingRemoval.isEmpty()) {
@@ -1528,7 +2387,29 @@ void SurfaceFlinger::commitTransaction()
     // we composite should be considered an animation as well.
     mAnimCompositionPending = mAnimTransactionPending;
 
-    mDrawingState = mCurrentState;
+    // Only the layers that were added, removed or moved need to be updated
+    // in the drawing list. Copying the whole list instead would share its
+    // storage with the current one, and the next change there would have to
+    // copy it again, taking a reference to every layer.
+    if (!mLayersPendingReorder.isEmpty()) {
+        LayerVector& drawingLayers(mDrawingState.layersSortedByZ);
+        for (size_t i = drawingLayers.size(); i > 0; i--) {
+            if (mLayersPendingReorder.indexOf(drawingLayers[i - 1]) >= 0) {
+                drawingLayers.removeAt(i - 1);
+            }
+        }
+        // the layers left behind haven't changed their sort key, so the
+        // others can be inserted where they now belong
+        const LayerVector& currentLayers(mCurrentState.layersSortedByZ);
+        for (size_t i = 0; i < mLayersPendingReorder.size(); i++) {
+            const sp<Layer>& layer(mLayersPendingReorder[i]);
+            if (currentLayers.indexOf(layer) >= 0) {
+                drawingLayers.add(layer);
+            }
+        }
+        mLayersPendingReorder.clear();
+    }
+    mDrawingState.displays = mCurrentState.displays;
     mTransactionPending = false;
     mAnimTransactionPending = false;
     mTransactionCV.broadcast();
@@ -1536,7 +2417,7 @@ void SurfaceFlinger::commitTransaction()
 
 void SurfaceFlinger::computeVisibleRegions(
         const LayerVector& currentLayers, uint32_t layerStack,
-        Region& outDirtyRegion, Region& outOpaqueRegion)
+        bool incremental, Region& outDirtyRegion, Region& outOpaqueRegion)
 {
     ATRACE_CALL();
 
@@ -1547,6 +2428,29 @@ void SurfaceFlinger::computeVisibleRegions(
     outDirtyRegion.clear();
 
     size_t i = currentLayers.size();
+    if (incremental) {
+        // The layers above the topmost one that changed come out exactly as
+        // they did last time, provided they are still at the same place in
+        // the stack: skip them and carry on with what they accumulated then.
+        // A layer that just left this stack still counts as a change in it.
+        while (i > 0) {
+            const sp<Layer>& layer = currentLayers[i - 1];
+            if (layer->getDrawingState().layerStack != layerStack &&
+                    layer->visibleRegionsLayerStack != layerStack) {
+                i--;
+                continue;
+            }
+            if (layer->visibleRegionsDirty ||
+                    layer->visibleRegionsZIndex != ssize_t(i - 1) ||
+                    layer->getDrawingState().layerStack != layerStack) {
+                break;
+            }
+            aboveOpaqueLayers = layer->accumulatedOpaqueRegion;
+            aboveCoveredLayers = layer->accumulatedCoveredRegion;
+            i--;
+        }
+    }
+
     while (i--) {
         const sp<Layer>& layer = currentLayers[i];
 
@@ -1668,6 +2572,11 @@ void SurfaceFlinger::computeVisibleRegions(
         layer->setCoveredRegion(coveredRegion);
         layer->setVisibleNonTransparentRegion(
                 visibleRegion.subtract(transparentRegion));
+
+        // Remember where we were for the next incremental computation
+        layer->accumulatedOpaqueRegion = aboveOpaqueLayers;
+        layer->accumulatedCoveredRegion = aboveCoveredLayers;
+        layer->visibleRegionsZIndex = ssize_t(i);
     }
 
     outOpaqueRegion = aboveOpaqueLayers;
@@ -1683,8 +2592,31 @@ void SurfaceFlinger::invalidateLayerStack(uint32_t layerStack,
     }
 }
 
-void SurfaceFlinger::handlePageFlip()
+void SurfaceFlinger::startPrelatch()
+{
+    if (mPrelatchThread == NULL) {
+        return;
+    }
+    // this uses the drawing list as it is before the transaction, layers
+    // the transaction adds are just latched the usual way
+    const LayerVector& layers(mDrawingState.layersSortedByZ);
+    for (size_t i = 0, count = layers.size(); i<count ; i++) {
+        const sp<Layer>& layer(layers[i]);
+        if (layer->canPrelatch())
+            mPrelatchedLayers.push_back(layer);
+    }
+    if (!mPrelatchedLayers.isEmpty()) {
+        mPrelatchThread->prelatch(mPrelatchedLayers);
+    }
+}
+
+bool SurfaceFlinger::handlePageFlip()
 {
+    if (mPrelatchThread != NULL && !mPrelatchedLayers.isEmpty()) {
+        mPrelatchThread->waitForCompletion();
+        mPrelatchedLayers.clear();
+    }
+
     Region dirtyRegion;
 
     bool visibleRegions = false;
@@ -1707,12 +2639,18 @@ void SurfaceFlinger::handlePageFlip()
     }
     for (size_t i = 0, count = layersWithQueuedFrames.size() ; i<count ; i++) {
         Layer* layer = layersWithQueuedFrames[i];
-        const Region dirty(layer->latchBuffer(visibleRegions));
+        bool layerVisibleRegions = false;
+        const Region dirty(layer->latchBuffer(layerVisibleRegions));
+        if (layerVisibleRegions) {
+            layer->visibleRegionsDirty = true;
+            visibleRegions = true;
+        }
         const Layer::State& s(layer->getDrawingState());
         invalidateLayerStack(s.layerStack, dirty);
     }
 
     mVisibleRegionsDirty |= visibleRegions;
+    return !layersWithQueuedFrames.isEmpty();
 }
 
 void SurfaceFlinger::invalidateHwcGeometry()
@@ -1751,6 +2689,12 @@ void SurfaceFlinger::doDisplayComposition(const sp<const DisplayDevice>& hw,
             // This is needed because PARTIAL_UPDATES only takes one
             // rectangle instead of a region (see DisplayDevice::flip())
             dirtyRegion.set(hw->swapRegion.bounds());
+        } else if (hw->hasBufferAge()) {
+            // we need to redraw whatever is out of date in the buffer we're
+            // about to draw into, which may be much less than everything.
+            // doComposeSurfaces can only scissor to a rectangle.
+            dirtyRegion.set(computeRepaintRegion(hw, dirtyRegion).bounds());
+            hw->swapRegion = dirtyRegion;
         } else {
             // we need to redraw everything (the whole screen)
             dirtyRegion.set(hw->bounds());
@@ -1766,16 +2710,64 @@ void SurfaceFlinger::doDisplayComposition(const sp<const DisplayDevice>& hw,
         if (mDaltonize) {
             colorMatrix = colorMatrix * mDaltonizer();
         }
-        engine.beginGroup(colorMatrix);
-        doComposeSurfaces(hw, dirtyRegion);
-        engine.endGroup();
+        if (colorMatrix[3] == vec4(0, 0, 0, 1)) {
+            // Black stays black, so the parts of the screen no layer covers
+            // don't need transforming either: apply the transform to each
+            // layer as it's drawn rather than in an extra full screen pass.
+            engine.setupColorTransform(colorMatrix);
+            doComposeSurfaces(hw, dirtyRegion);
+            engine.setupColorTransform(mat4());
+        } else {
+            engine.beginGroup(colorMatrix);
+            doComposeSurfaces(hw, dirtyRegion);
+            engine.endGroup();
+        }
     }
 
     // update the swap region and clear the dirty region
     hw->swapRegion.orSelf(dirtyRegion);
 
     // swap buffers (presentation)
-    hw->swapBuffers(getHwComposer());
+    hw->swapBuffers(getHwComposer(), inDirtyRegion);
+}
+
+Region SurfaceFlinger::computeRepaintRegion(const sp<const DisplayDevice>& hw,
+        const Region& dirty)
+{
+    HWComposer& hwc(getHwComposer());
+    const int32_t id = hw->getHwcDisplayId();
+    if (!hwc.hasGlesComposition(id)) {
+        return Region(hw->bounds());
+    }
+
+    // the buffer's contents only allow a partial repaint if they were
+    // composed from the same layers; overlays cleared in the framebuffer
+    // are listed after a NULL
+    Vector<const Layer*> glesLayers;
+    const Vector< sp<Layer> >& layers(hw->getVisibleLayersSortedByZ());
+    HWComposer::LayerListIterator cur = hwc.begin(id);
+    const HWComposer::LayerListIterator end = hwc.end(id);
+    if (cur == end) {
+        for (size_t i=0 ; i<layers.size() ; i++) {
+            glesLayers.add(layers[i].get());
+        }
+    } else {
+        for (size_t i=0 ; i<layers.size() && cur!=end ; ++i, ++cur) {
+            if (cur->getCompositionType() == HWC_FRAMEBUFFER) {
+                glesLayers.add(layers[i].get());
+            } else if (cur->getHints() & HWC_HINT_CLEAR_FB) {
+                glesLayers.add(NULL);
+                glesLayers.add(layers[i].get());
+            }
+        }
+    }
+    hw->setGlesLayers(glesLayers);
+
+    // the buffer age can only be queried once the surface is current
+    if (!hw->makeCurrent(mEGLDisplay, getRenderEngine().getEGLContext())) {
+        return Region(hw->bounds());
+    }
+    return hw->getRepaintRegion(dirty);
 }
 
 bool SurfaceFlinger::doComposeSurfaces(const sp<const DisplayDevice>& hw, const Region& dirty)
@@ -1786,18 +2778,49 @@ bool SurfaceFlinger::doComposeSurfaces(const sp<const DisplayDevice>& hw, const
     HWComposer::LayerListIterator cur = hwc.begin(id);
     const HWComposer::LayerListIterator end = hwc.end(id);
 
+    size_t cachedCount = 0;
     bool hasGlesComposition = hwc.hasGlesComposition(id);
     if (hasGlesComposition) {
-        if (!hw->makeCurrent(mEGLDisplay, mEGLContext)) {
+        if (!hw->makeCurrent(mEGLDisplay, engine.getEGLContext())) {
             ALOGW("DisplayDevice::makeCurrent failed. Aborting surface composition for display %s",
                   hw->getDisplayName().string());
             eglMakeCurrent(mEGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-            if(!getDefaultDisplayDevice()->makeCurrent(mEGLDisplay, mEGLContext)) {
+            // composition threads leave no context current anyway
+            if (engine.getEGLContext() == mEGLContext &&
+                    !getDefaultDisplayDevice()->makeCurrent(mEGLDisplay, mEGLContext)) {
               ALOGE("DisplayDevice::makeCurrent on default display failed. Aborting.");
             }
             return false;
         }
 
+        // Let the composition cache take over the bottom of the layer
+        // stack if it hasn't changed. It renders with the scissor disabled.
+        const sp<CompositionCache>& cache(hw->getCompositionCache());
+        if (cache != NULL && CC_LIKELY(!mDaltonize && !mHasColorMatrix)) {
+            size_t glesCount = 0;
+            const size_t layerCount = hw->getVisibleLayersSortedByZ().size();
+            if (cur == end) {
+                glesCount = layerCount;
+            } else {
+                HWComposer::LayerListIterator it = hwc.begin(id);
+                while (glesCount < layerCount && it != end &&
+                        it->getCompositionType() == HWC_FRAMEBUFFER) {
+                    ++glesCount;
+                    ++it;
+                }
+            }
+            cachedCount = cache->update(hw, glesCount);
+        }
+
+        // When only part of the display is repainted, the rest of the
+        // framebuffer is already up to date and must be left alone
+        const Rect repaint(dirty.getBounds());
+        if (repaint != hw->getBounds()) {
+            const uint32_t height = hw->getHeight();
+            engine.setScissor(repaint.left, height - repaint.bottom,
+                    repaint.getWidth(), repaint.getHeight());
+        }
+
         // Never touch the framebuffer if we don't have any framebuffer layers
         const bool hasHwcComposition = hwc.hasHwcComposition(id);
         if (hasHwcComposition) {
@@ -1834,7 +2857,10 @@ bool SurfaceFlinger::doComposeSurfaces(const sp<const DisplayDevice>& hw, const
             // scissor on the main display. It should never be needed
             // anyways (though in theory it could since the API allows it).
             const Rect& bounds(hw->getBounds());
-            const Rect& scissor(hw->getScissor());
+            Rect scissor;
+            if (!hw->getScissor().intersect(repaint, &scissor)) {
+                scissor.clear();
+            }
             if (scissor != bounds) {
                 // scissor doesn't match the screen's dimensions, so we
                 // need to clear everything outside of it and enable
@@ -1855,12 +2881,33 @@ bool SurfaceFlinger::doComposeSurfaces(const sp<const DisplayDevice>& hw, const
     const Vector< sp<Layer> >& layers(hw->getVisibleLayersSortedByZ());
     const size_t count = layers.size();
     const Transform& tr = hw->getTransform();
+    if (cachedCount) {
+        hw->getCompositionCache()->draw(hw);
+    }
+
+    // rather than blending a dim layer over the layers beneath it, darken
+    // them as they're drawn
+    size_t foldedDim = count;
+    if (!cachedCount && CC_LIKELY(!mDaltonize && !mHasColorMatrix)) {
+        foldedDim = findFoldableDimLayer(hw);
+        if (foldedDim < count) {
+            const Layer::State& s(layers[foldedDim]->getDrawingState());
+            if (!engine.setupColorScale(1.0f - s.alpha / 255.0f)) {
+                foldedDim = count;
+            }
+        }
+    }
+
     if (cur != end) {
         // we're using h/w composer
         for (size_t i=0 ; i<count && cur!=end ; ++i, ++cur) {
             const sp<Layer>& layer(layers[i]);
             const Region clip(dirty.intersect(tr.transform(layer->visibleRegion)));
-            if (!clip.isEmpty()) {
+            if (i == foldedDim) {
+                // the layers beneath are already darkened
+                engine.setupColorScale(1.0f);
+            } else if (!clip.isEmpty() && i >= cachedCount) {
+                // the layers below cachedCount were drawn from the cache
                 switch (cur->getCompositionType()) {
                     case HWC_CURSOR_OVERLAY:
                     case HWC_OVERLAY: {
@@ -1891,11 +2938,13 @@ bool SurfaceFlinger::doComposeSurfaces(const sp<const DisplayDevice>& hw, const
         }
     } else {
         // we're not using h/w composer
-        for (size_t i=0 ; i<count ; ++i) {
+        for (size_t i=cachedCount ; i<count ; ++i) {
             const sp<Layer>& layer(layers[i]);
             const Region clip(dirty.intersect(
                     tr.transform(layer->visibleRegion)));
-            if (!clip.isEmpty()) {
+            if (i == foldedDim) {
+                engine.setupColorScale(1.0f);
+            } else if (!clip.isEmpty()) {
                 layer->draw(hw, clip);
             }
         }
@@ -1906,6 +2955,40 @@ bool SurfaceFlinger::doComposeSurfaces(const sp<const DisplayDevice>& hw, const
     return true;
 }
 
+size_t SurfaceFlinger::findFoldableDimLayer(const sp<const DisplayDevice>& hw)
+{
+    HWComposer& hwc(getHwComposer());
+    const int32_t id = hw->getHwcDisplayId();
+    HWComposer::LayerListIterator cur = hwc.begin(id);
+    const HWComposer::LayerListIterator end = hwc.end(id);
+    const bool usesHwc = (cur != end);
+
+    // Darkening everything drawn up to a dim layer is the same as blending
+    // the dim over it as long as the dim covers all of it: only look at
+    // the GLES layers at the bottom of the stack, and at dims over all
+    // that's visible of the layers beneath them. What no layer covers is
+    // black or transparent, which stays so.
+    const Vector< sp<Layer> >& layers(hw->getVisibleLayersSortedByZ());
+    const size_t count = layers.size();
+    size_t folded = count;
+    Region beneath;
+    for (size_t i=0 ; i<count ; ++i) {
+        if (usesHwc) {
+            if (cur == end || cur->getCompositionType() != HWC_FRAMEBUFFER) {
+                break;
+            }
+            ++cur;
+        }
+        const sp<Layer>& layer(layers[i]);
+        if (layer->isDim() &&
+                beneath.subtract(layer->visibleRegion).isEmpty()) {
+            folded = i;
+        }
+        beneath.orSelf(layer->visibleRegion);
+    }
+    return folded;
+}
+
 void SurfaceFlinger::drawWormhole(const sp<const DisplayDevice>& hw, const Region& region) const {
     const int32_t height = hw->getHeight();
     RenderEngine& engine(getRenderEngine());
@@ -1923,6 +3006,7 @@ void SurfaceFlinger::addClientLayer(const sp<Client>& client,
     // add this layer to the current state list
     Mutex::Autolock _l(mStateLock);
     mCurrentState.layersSortedByZ.add(lbc);
+    mLayersPendingReorder.add(lbc);
     mGraphicBufferProducerList.add(gbc->asBinder());
 }
 
@@ -1930,6 +3014,7 @@ status_t SurfaceFlinger::removeLayer(const sp<Layer>& layer) {
     Mutex::Autolock _l(mStateLock);
     ssize_t index = mCurrentState.layersSortedByZ.remove(layer);
     if (index >= 0) {
+        mLayersPendingReorder.add(layer);
         mLayersPendingRemoval.push(layer);
         mLayersRemoved = true;
         setTransactionFlags(eTransactionNeeded);
@@ -2001,7 +3086,16 @@ void SurfaceFlinger::setTransactionState(
                 String16 desc(binder->getInterfaceDescriptor());
                 if (desc == ISurfaceComposerClient::descriptor) {
                     sp<Client> client( static_cast<Client *>(s.client.get()) );
-                    transactionFlags |= setClientStateLocked(client, s.state);
+                    // the state is applied in handleTransaction(), merged
+                    // with whatever else arrives for that surface until then
+                    if (s.state.what) {
+                        if (s.state.what & layer_state_t::ePositionChanged) {
+                            moveCursorAsyncLocked(client, s.state);
+                        }
+                        if (queueClientStateLocked(client, s.state)) {
+                            transactionFlags |= eTransactionNeeded;
+                        }
+                    }
                 }
             }
         }
@@ -2098,8 +3192,11 @@ uint32_t SurfaceFlinger::setClientStateLocked(
             // NOTE: index needs to be calculated before we update the state
             ssize_t idx = mCurrentState.layersSortedByZ.indexOf(layer);
             if (layer->setLayer(s.z)) {
-                mCurrentState.layersSortedByZ.removeAt(idx);
-                mCurrentState.layersSortedByZ.add(layer);
+                if (idx >= 0) {
+                    mCurrentState.layersSortedByZ.removeAt(idx);
+                    mCurrentState.layersSortedByZ.add(layer);
+                }
+                mLayersPendingReorder.add(layer);
                 // we need traversal (state changed)
                 // AND transaction (list changed)
                 flags |= eTransactionNeeded|eTraversalNeeded;
@@ -2136,8 +3233,11 @@ uint32_t SurfaceFlinger::setClientStateLocked(
             // NOTE: index needs to be calculated before we update the state
             ssize_t idx = mCurrentState.layersSortedByZ.indexOf(layer);
             if (layer->setLayerStack(s.layerStack)) {
-                mCurrentState.layersSortedByZ.removeAt(idx);
-                mCurrentState.layersSortedByZ.add(layer);
+                if (idx >= 0) {
+                    mCurrentState.layersSortedByZ.removeAt(idx);
+                    mCurrentState.layersSortedByZ.add(layer);
+                }
+                mLayersPendingReorder.add(layer);
                 // we need traversal (state changed)
                 // AND transaction (list changed)
                 flags |= eTransactionNeeded|eTraversalNeeded;
@@ -2147,6 +3247,88 @@ uint32_t SurfaceFlinger::setClientStateLocked(
     return flags;
 }
 
+// Returns whether a transaction is needed to apply the state. A state that
+// wouldn't change its layer isn't queued, unless the surface already has a
+// pending state that it has to be merged with.
+bool SurfaceFlinger::queueClientStateLocked(
+        const sp<Client>& client,
+        const layer_state_t& s)
+{
+    ssize_t idx = mPendingClientStates.indexOfKey(s.surface);
+    if (idx < 0) {
+        sp<Layer> layer(client->getLayerUser(s.surface));
+        if (layer == 0 || !layer->wouldChangeState(s)) {
+            return false;
+        }
+        PendingClientState pending;
+        pending.client = client;
+        pending.state = s;
+        mPendingClientStates.add(s.surface, pending);
+        return true;
+    }
+    PendingClientState& pending(mPendingClientStates.editValueAt(idx));
+    if (pending.client != client) {
+        // the handle only resolves through the client that created it, so
+        // one of these states is a no-op; keep the last one.
+        pending.client = client;
+        pending.state = s;
+        return true;
+    }
+    mergeLayerState(pending.state, s);
+    return true;
+}
+
+void SurfaceFlinger::mergeLayerState(layer_state_t& dst, const layer_state_t& src)
+{
+    // last writer wins, field by field
+    const uint32_t what = src.what;
+    if (what & layer_state_t::ePositionChanged) {
+        dst.x = src.x;
+        dst.y = src.y;
+    }
+    if (what & layer_state_t::eLayerChanged) {
+        dst.z = src.z;
+    }
+    if (what & layer_state_t::eSizeChanged) {
+        dst.w = src.w;
+        dst.h = src.h;
+    }
+    if (what & layer_state_t::eAlphaChanged) {
+        dst.alpha = src.alpha;
+    }
+    if (what & layer_state_t::eMatrixChanged) {
+        dst.matrix = src.matrix;
+    }
+    if (what & layer_state_t::eTransparentRegionChanged) {
+        dst.transparentRegion = src.transparentRegion;
+    }
+    if ((what & layer_state_t::eVisibilityChanged) ||
+            (what & layer_state_t::eOpacityChanged)) {
+        // only the bits in 'mask' are meaningful
+        dst.flags = (dst.flags & ~src.mask) | (src.flags & src.mask);
+        dst.mask |= src.mask;
+    }
+    if (what & layer_state_t::eCropChanged) {
+        dst.crop = src.crop;
+    }
+    if (what & layer_state_t::eLayerStackChanged) {
+        dst.layerStack = src.layerStack;
+    }
+    dst.what |= what;
+}
+
+uint32_t SurfaceFlinger::applyPendingClientStatesLocked()
+{
+    uint32_t flags = 0;
+    const size_t count = mPendingClientStates.size();
+    for (size_t i=0 ; i<count ; i++) {
+        const PendingClientState& pending(mPendingClientStates.valueAt(i));
+        flags |= setClientStateLocked(pending.client, pending.state);
+    }
+    mPendingClientStates.clear();
+    return flags;
+}
+
 status_t SurfaceFlinger::createLayer(
         const String8& name,
         const sp<Client>& client,
@@ -2316,6 +3498,7 @@ void SurfaceFlinger::setPowerModeInternal(const sp<DisplayDevice>& hw,
         }
 
         mVisibleRegionsDirty = true;
+        mRecomputeAllVisibleRegions = true;
         repaintEverything();
     } else if (mode == HWC_POWER_MODE_OFF) {
         if (type == DisplayDevice::DISPLAY_PRIMARY) {
@@ -2323,10 +3506,14 @@ void SurfaceFlinger::setPowerModeInternal(const sp<DisplayDevice>& hw,
 
             // FIXME: eventthread only knows about the main display right now
             mEventThread->onScreenReleased();
+
+            // nothing will be recreated before the screen is back on
+            GraphicBufferAllocator::get().flushPool();
         }
 
         getHwComposer().setPowerMode(type, mode);
         mVisibleRegionsDirty = true;
+        mRecomputeAllVisibleRegions = true;
         // from this point on, SF will stop drawing on this display
     } else {
         getHwComposer().setPowerMode(type, mode);
@@ -2365,6 +3552,8 @@ void SurfaceFlinger::setPowerMode(const sp<IBinder>& display, int mode) {
 status_t SurfaceFlinger::dump(int fd, const Vector<String16>& args)
 {
     String8 result;
+    // written to fd once the locks are released
+    ChunkedTextOutput out(fd, mLastDumpSize);
 
     IPCThreadState* ipc = IPCThreadState::self();
     const int pid = ipc->getCallingPid();
@@ -2373,6 +3562,14 @@ status_t SurfaceFlinger::dump(int fd, const Vector<String16>& args)
             !PermissionCache::checkPermission(sDump, pid, uid)) {
         result.appendFormat("Permission Denial: "
                 "can't dump SurfaceFlinger from pid=%d, uid=%d\n", pid, uid);
+    } else if (args.size() && args[0] == String16("--snapshot")) {
+        // doesn't take mStateLock at all, for monitoring
+        sp<const StateSnapshot> snapshot(getStateSnapshot());
+        if (snapshot != NULL) {
+            snapshot->dump(result);
+        } else {
+            result.append("No refresh yet\n");
+        }
     } else {
         // Try to get the main lock, but don't insist if we can't
         // (this would indicate SF is stuck, but we want to be able to
@@ -2386,6 +3583,10 @@ status_t SurfaceFlinger::dump(int fd, const Vector<String16>& args)
             result.append(
                     "SurfaceFlinger appears to be unresponsive, "
                     "dumping anyways (no locks held)\n");
+            sp<const StateSnapshot> snapshot(getStateSnapshot());
+            if (snapshot != NULL) {
+                snapshot->dump(result);
+            }
         }
 
         bool dumpAll = true;
@@ -2406,6 +3607,13 @@ status_t SurfaceFlinger::dump(int fd, const Vector<String16>& args)
                 dumpAll = false;
             }
 
+            if ((index < numArgs) &&
+                    (args[index] == String16("--latency-bq"))) {
+                index++;
+                dumpBufferQueueStatsLocked(args, index, result);
+                dumpAll = false;
+            }
+
             if ((index < numArgs) &&
                     (args[index] == String16("--latency-clear"))) {
                 index++;
@@ -2413,23 +3621,41 @@ status_t SurfaceFlinger::dump(int fd, const Vector<String16>& args)
                 dumpAll = false;
             }
 
+            if ((index < numArgs) &&
+                    (args[index] == String16("--latency-depth"))) {
+                index++;
+                setStatsDepthLocked(args, index, result);
+                dumpAll = false;
+            }
+
+            if ((index < numArgs) &&
+                    (args[index] == String16("--timeline"))) {
+                index++;
+                mCompositionTimeline.dump(result);
+                dumpAll = false;
+            }
+
             if ((index < numArgs) &&
                     (args[index] == String16("--dispsync"))) {
                 index++;
                 mPrimaryDispSync.dump(result);
+                result.append("Hardware vsync:\n");
+                mHWVsyncThread->dump(result);
                 dumpAll = false;
             }
         }
 
         if (dumpAll) {
-            dumpAllLocked(args, index, result);
+            dumpAllLocked(args, index, result, out);
         }
 
         if (locked) {
             mStateLock.unlock();
         }
     }
-    write(fd, result.string(), result.size());
+    out.append(result);
+    mLastDumpSize = out.size();
+    out.flush();
     return NO_ERROR;
 }
 
@@ -2471,6 +3697,25 @@ void SurfaceFlinger::dumpStatsLocked(const Vector<String16>& args, size_t& index
     }
 }
 
+void SurfaceFlinger::dumpBufferQueueStatsLocked(const Vector<String16>& args,
+        size_t& index, String8& result) const
+{
+    String8 name;
+    if (index < args.size()) {
+        name = String8(args[index]);
+        index++;
+    }
+
+    const LayerVector& currentLayers = mCurrentState.layersSortedByZ;
+    const size_t count = currentLayers.size();
+    for (size_t i=0 ; i<count ; i++) {
+        const sp<Layer>& layer(currentLayers[i]);
+        if (name.isEmpty() || (name == layer->getName())) {
+            layer->dumpBufferQueueStats(result);
+        }
+    }
+}
+
 void SurfaceFlinger::clearStatsLocked(const Vector<String16>& args, size_t& index,
         String8& /* result */)
 {
@@ -2492,6 +3737,40 @@ void SurfaceFlinger::clearStatsLocked(const Vector<String16>& args, size_t& inde
     mAnimFrameTracker.clearStats();
 }
 
+void SurfaceFlinger::setStatsDepthLocked(const Vector<String16>& args,
+        size_t& index, String8& result)
+{
+    // --latency-depth [name] depth
+    String8 name;
+    if (index + 1 < args.size()) {
+        name = String8(args[index]);
+        index++;
+    }
+    if (index >= args.size()) {
+        result.append("usage: --latency-depth [name] depth\n");
+        return;
+    }
+    const int depth = atoi(String8(args[index]).string());
+    index++;
+    if (depth <= 0) {
+        result.append("invalid depth\n");
+        return;
+    }
+
+    const LayerVector& currentLayers = mCurrentState.layersSortedByZ;
+    const size_t count = currentLayers.size();
+    for (size_t i=0 ; i<count ; i++) {
+        const sp<Layer>& layer(currentLayers[i]);
+        if (name.isEmpty() || (name == layer->getName())) {
+            layer->setFrameHistoryDepth(size_t(depth));
+        }
+    }
+
+    if (name.isEmpty()) {
+        mAnimFrameTracker.setHistoryDepth(size_t(depth));
+    }
+}
+
 // This should only be called from the main thread.  Otherwise it would need
 // the lock and should use mCurrentState rather than mDrawingState.
 void SurfaceFlinger::logFrameStats() {
@@ -2503,6 +3782,7 @@ void SurfaceFlinger::logFrameStats() {
     }
 
     mAnimFrameTracker.logAndResetStats(String8("<win-anim>"));
+    EventLog::flushFrameDurations();
 }
 
 /*static*/ void SurfaceFlinger::appendSfConfigString(String8& result)
@@ -2523,7 +3803,7 @@ void SurfaceFlinger::logFrameStats() {
 }
 
 void SurfaceFlinger::dumpAllLocked(const Vector<String16>& args, size_t& index,
-        String8& result) const
+        String8& result, ChunkedTextOutput& out) const
 {
     bool colorize = false;
     if (index < args.size()
@@ -2568,6 +3848,42 @@ void SurfaceFlinger::dumpAllLocked(const Vector<String16>& args, size_t& index,
         mHwc->getRefreshPeriod(HWC_DISPLAY_PRIMARY));
     result.append("\n");
 
+    colorizer.bold(result);
+    result.append("Startup timeline:\n");
+    colorizer.reset(result);
+    dumpStartupTimeline(result);
+
+    colorizer.bold(result);
+    result.append("Buffer memory:\n");
+    colorizer.reset(result);
+    {
+        KeyedVector<const Client*, ClientBufferUsage> clients;
+        getClientBufferUsage(&clients);
+        for (size_t i=0 ; i<clients.size() ; i++) {
+            const ClientBufferUsage& usage(clients.valueAt(i));
+            result.appendFormat("  client %p: %zu KB in %zu layers%s\n",
+                    clients.keyAt(i), usage.bytes / 1024, usage.layers,
+                    usage.foreground ? "" : " (background)");
+        }
+        if (mClientBufferBudget) {
+            result.appendFormat("  budget %zu KB per background client\n",
+                    mClientBufferBudget / 1024);
+        }
+    }
+    result.append("\n");
+
+    colorizer.bold(result);
+    result.append("Frame deadlines:\n");
+    colorizer.reset(result);
+    mDeadlineTracker.dump(result);
+
+    if (mUseRefreshRatePolicy) {
+        colorizer.bold(result);
+        result.append("Refresh rate policy:\n");
+        colorizer.reset(result);
+        mRefreshRatePolicy.dump(result);
+    }
+
     /*
      * Dump the visible layer list
      */
@@ -2576,9 +3892,15 @@ void SurfaceFlinger::dumpAllLocked(const Vector<String16>& args, size_t& index,
     colorizer.bold(result);
     result.appendFormat("Visible layers (count = %zu)\n", count);
     colorizer.reset(result);
+    // the layers make most of the dump: move it to out as it goes rather
+    // than growing result, which would copy it over and over again
+    out.append(result);
+    result.clear();
     for (size_t i=0 ; i<count ; i++) {
         const sp<Layer>& layer(currentLayers[i]);
-        layer->dump(result, colorizer);
+        String8 layerDump;
+        layer->dump(layerDump, colorizer);
+        out.append(layerDump);
     }
 
     /*
@@ -2610,6 +3932,7 @@ void SurfaceFlinger::dumpAllLocked(const Vector<String16>& args, size_t& index,
     colorizer.reset(result);
     result.appendFormat("%s\n",
             eglQueryStringImplementationANDROID(mEGLDisplay, EGL_EXTENSIONS));
+    dumpEGLDisplays(result);
 
     mRenderEngine->dump(result);
 
@@ -2661,6 +3984,13 @@ void SurfaceFlinger::dumpAllLocked(const Vector<String16>& args, size_t& index,
      */
     const GraphicBufferAllocator& alloc(GraphicBufferAllocator::get());
     alloc.dump(result);
+
+    /*
+     * Dump how fences were waited for, and the time spent blocked on them
+     * if debug.sf.fence_stats is set
+     */
+    SyncFeatures::getInstance().dumpFenceWaits(result);
+    Fence::dumpWaitStats(result);
 }
 
 const Vector< sp<Layer> >&
@@ -2709,6 +4039,8 @@ status_t SurfaceFlinger::onTransact(
         case BOOT_FINISHED:
         case CLEAR_ANIMATION_FRAME_STATS:
         case GET_ANIMATION_FRAME_STATS:
+        case GET_LAYER_FRAME_STAT_INFO:
+        case GET_COMPOSITION_TIMELINE:
         case SET_POWER_MODE:
         {
             // codes that require permission check
@@ -3100,7 +4432,7 @@ void SurfaceFlinger::renderScreenImplLocked(
     // get screen geometry
     const uint32_t hw_w = hw->getWidth();
     const uint32_t hw_h = hw->getHeight();
-    const bool filtering = reqWidth != hw_w || reqWidth != hw_h;
+    const bool filtering = reqWidth != hw_w || reqHeight != hw_h;
 
     // if a default or invalid sourceCrop is passed in, set reasonable values
     if (sourceCrop.width() == 0 || sourceCrop.height() == 0 ||
@@ -3197,10 +4529,16 @@ status_t SurfaceFlinger::captureScreenImplLocked(
 
         if (err == NO_ERROR) {
             ANativeWindowBuffer* buffer;
-            /* TODO: Once we have the sync framework everywhere this can use
-             * server-side waits on the fence that dequeueBuffer returns.
-             */
-            result = native_window_dequeue_buffer_and_wait(window,  &buffer);
+            int fenceFd = -1;
+            result = window->dequeueBuffer(window, &buffer, &fenceFd);
+            if (result == NO_ERROR) {
+                // the buffer may still be read by whoever has the previous
+                // screenshot; have the GPU wait for that rather than us
+                result = waitForScreenshotBufferLocked(fenceFd);
+                if (result != NO_ERROR) {
+                    window->cancelBuffer(window, buffer, -1);
+                }
+            }
             if (result == NO_ERROR) {
                 int syncFd = -1;
                 // create an EGLImage from the buffer so we can later
@@ -3294,6 +4632,17 @@ status_t SurfaceFlinger::captureScreenImplLocked(
     return result;
 }
 
+status_t SurfaceFlinger::waitForScreenshotBufferLocked(int fenceFd) const
+{
+    if (fenceFd < 0) {
+        return NO_ERROR;
+    }
+
+    sp<Fence> fence(new Fence(fenceFd));
+    return SyncFeatures::getInstance().waitForFence(mEGLDisplay, fence,
+            "captureScreen");
+}
+
 void SurfaceFlinger::checkScreenshot(size_t w, size_t s, size_t h, void const* vaddr,
         const sp<const DisplayDevice>& hw, uint32_t minLayerZ, uint32_t maxLayerZ) {
     if (DEBUG_SCREENSHOTS) {
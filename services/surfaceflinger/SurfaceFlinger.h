@@ -18,9 +18,11 @@
 #define ANDROID_SURFACE_FLINGER_H
 
 #include <stdint.h>
+#include <pthread.h>
 #include <sys/types.h>
 
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 /*
  * NOTE: Make sure this file doesn't include  anything from <gl/ > or <gl2/ >
@@ -49,26 +51,38 @@
 
 #include "Barrier.h"
 #include "DisplayDevice.h"
+#include "CompositionTimeline.h"
+#include "DeadlineTracker.h"
 #include "DispSync.h"
 #include "FrameTracker.h"
 #include "MessageQueue.h"
+#include "RefreshRatePolicy.h"
+#include "StateSnapshot.h"
 
 #include "DisplayHardware/HWComposer.h"
+#include "DisplayHardware/PowerHAL.h"
 #include "Effects/Daltonizer.h"
 
 namespace android {
 
 // ---------------------------------------------------------------------------
 
+class ChunkedTextOutput;
 class Client;
 class DisplayEventConnection;
 class EventThread;
+class FrameStreamer;
+class CompositionThread;
+class GraphicBuffer;
+class PrelatchThread;
 class IGraphicBufferAlloc;
 class Layer;
 class LayerDim;
 class Surface;
 class RenderEngine;
+class StartupThread;
 class EventControlThread;
+class HWVsyncThread;
 
 // ---------------------------------------------------------------------------
 
@@ -114,8 +128,12 @@ public:
         return getDisplayDevice(mBuiltinDisplays[DisplayDevice::DISPLAY_PRIMARY]);
     }
 
-    // utility function to delete a texture on the main thread
+    // utility functions to free GL and gralloc resources on the main thread.
+    // They are freed in batches, at the end of a composition or shortly
+    // after, within a time budget per batch.
     void deleteTextureAsync(uint32_t texture);
+    void destroyImageAsync(EGLImageKHR image);
+    void releaseBufferAsync(const sp<GraphicBuffer>& buffer);
 
     // enable/disable h/w composer event
     // TODO: this should be made accessible only to EventThread
@@ -130,20 +148,44 @@ public:
     // TODO: this should be made accessible only to HWComposer
     const Vector< sp<Layer> >& getLayerSortedByZForHwcDisplay(int id);
 
+    // returns the RenderEngine of the calling thread; composition threads
+    // have their own, every other thread uses the main one
     RenderEngine& getRenderEngine() const {
+        if (CC_UNLIKELY(!mCompositionThreads.isEmpty())) {
+            RenderEngine* engine = static_cast<RenderEngine*>(
+                    pthread_getspecific(mRenderEngineKey));
+            if (engine) {
+                return *engine;
+            }
+        }
         return *mRenderEngine;
     }
 
 private:
     friend class Client;
+    friend class CompositionThread;
     friend class DisplayEventConnection;
+    friend class FrameStreamer;
+    friend class HWVsyncThread;
     friend class Layer;
+    friend class LayerDim;
     friend class MonitoredProducer;
+    friend class StartupThread;
 
     // This value is specified in number of frames.  Log frame stats at most
     // every half hour.
     enum { LOG_FRAME_STATS_PERIOD =  30*60*60 };
 
+    enum {
+        // how many textures, images and buffers are freed at once
+        DEFERRED_DELETE_BATCH = 32,
+        // how long the main thread may spend freeing them at a time
+        DEFERRED_DELETE_BUDGET = 2000000,   // 2ms
+        // how long to collect them before freeing them when nothing is
+        // composed
+        DEFERRED_DELETE_DELAY = 10000000,   // 10ms
+    };
+
     // We're reference counted, never destroy SurfaceFlinger directly
     virtual ~SurfaceFlinger();
 
@@ -216,6 +258,10 @@ private:
     virtual status_t setActiveConfig(const sp<IBinder>& display, int id);
     virtual status_t clearAnimationFrameStats();
     virtual status_t getAnimationFrameStats(FrameStats* outStats) const;
+    virtual status_t getLayerFrameStatInfo(Vector<String8>* outNames,
+            Vector<FrameStatInfo>* outInfos) const;
+    virtual status_t getCompositionTimeline(
+            Vector<CompositionTiming>* outTimings) const;
 
     /* ------------------------------------------------------------------------
      * DeathRecipient interface
@@ -245,11 +291,52 @@ private:
     void onInitializeDisplays();
     // called on the main thread in response to setActiveConfig()
     void setActiveConfigInternal(const sp<DisplayDevice>& hw, int mode);
+
+    // lets mRefreshRatePolicy pick the primary display's config from the
+    // rate its visible layers are updated at
+    void updateRefreshRatePolicy();
+
+    // frees the queued textures, images and buffers, in batches, until the
+    // budget is spent. Returns whether some are left.
+    bool flushDeferredDeletes(nsecs_t budget);
+    void handleDeferredDeletes();
+    void scheduleDeferredDeletesLocked();
+    static size_t batchSize(size_t count);
     // called on the main thread in response to setPowerMode()
     void setPowerModeInternal(const sp<DisplayDevice>& hw, int mode);
 
+    // the memory used by the buffers of each client's layers, and whether
+    // any of its layers is visible on a display
+    struct ClientBufferUsage {
+        size_t bytes;
+        size_t layers;
+        bool foreground;
+    };
+    void getClientBufferUsage(
+            KeyedVector<const Client*, ClientBufferUsage>* outUsage) const;
+    // double buffers the layers of the background clients whose buffers
+    // use more than mClientBufferBudget
+    void enforceBufferBudgets();
+
+    // tells the power HAL how much GLES composition the frame prepared
+    // last needs, see PowerHAL::compositionHint()
+    void updateCompositionHint();
+
+    // counts the layers of the displays that are on, by composition type,
+    // for mCompositionTimeline
+    void countComposedLayers(CompositionTiming* timing);
+
+    // replaces mStateSnapshot with what the refresh just composed
+    void publishStateSnapshot();
+    sp<const StateSnapshot> getStateSnapshot() const;
+
+    // keep mDeadlineTracker posted of when frames start and end
+    void onFrameStart();
+    void onFrameEnd();
+
     void handleMessageTransaction();
-    void handleMessageInvalidate();
+    // returns whether a refresh is needed for the layers' content
+    bool handleMessageInvalidate();
     void handleMessageRefresh();
 
     void handleTransaction(uint32_t transactionFlags);
@@ -257,10 +344,26 @@ private:
 
     void updateCursorAsync();
 
+    // remembers which layers the HWC took as cursor overlays in the last
+    // prepare, for moveCursorAsyncLocked()
+    void updateAsyncCursors();
+
+    // moves a cursor overlay right away when a transaction changes its
+    // position, rather than once the main thread handles the transaction;
+    // called with mStateLock held
+    void moveCursorAsyncLocked(const sp<Client>& client, const layer_state_t& s);
+
+    /* startPrelatch: hands the layers with queued frames to
+     * mPrelatchThread, which acquires their buffers while the transaction
+     * is handled. handlePageFlip() waits for it.
+     */
+    void startPrelatch();
+
     /* handlePageFilp: this is were we latch a new buffer
-     * if available and compute the dirty region.
+     * if available and compute the dirty region. Returns whether any layer
+     * had a frame or a sideband stream change to latch.
      */
-    void handlePageFlip();
+    bool handlePageFlip();
 
     /* ------------------------------------------------------------------------
      * Transactions
@@ -270,6 +373,9 @@ private:
     uint32_t setTransactionFlags(uint32_t flags);
     void commitTransaction();
     uint32_t setClientStateLocked(const sp<Client>& client, const layer_state_t& s);
+    bool queueClientStateLocked(const sp<Client>& client, const layer_state_t& s);
+    uint32_t applyPendingClientStatesLocked();
+    static void mergeLayerState(layer_state_t& dst, const layer_state_t& src);
     uint32_t setDisplayStateLocked(const DisplayState& s);
 
     /* ------------------------------------------------------------------------
@@ -306,6 +412,18 @@ private:
             const sp<IGraphicBufferProducer>& gbc,
             const sp<Layer>& lbc);
 
+    /* ------------------------------------------------------------------------
+     * Startup
+     */
+    // the steps of init() that may run on a StartupThread
+    void initializeEgl();
+    void primeShaders();
+    // creates and starts the app and sf EventThreads
+    void createEventThreads(sp<EventThread>* app, sp<EventThread>* sf);
+    // adds a step that started at start and ends now to the startup timeline
+    void recordStartupStep(const char* name, nsecs_t start);
+    void dumpStartupTimeline(String8& result) const;
+
     /* ------------------------------------------------------------------------
      * Boot animation, on/off animations and screen capture
      */
@@ -326,6 +444,11 @@ private:
             bool useIdentityTransform, Transform::orientation_flags rotation,
             bool useReadPixels);
 
+    // makes the GPU wait for the fence of a dequeued screenshot buffer, or
+    // waits for it here when that isn't supported. Takes ownership of
+    // fenceFd.
+    status_t waitForScreenshotBufferLocked(int fenceFd) const;
+
     /* ------------------------------------------------------------------------
      * EGL
      */
@@ -370,7 +493,7 @@ private:
     void invalidateHwcGeometry();
     static void computeVisibleRegions(
             const LayerVector& currentLayers, uint32_t layerStack,
-            Region& dirtyRegion, Region& opaqueRegion);
+            bool incremental, Region& dirtyRegion, Region& opaqueRegion);
 
     void preComposition();
     void postComposition();
@@ -380,10 +503,26 @@ private:
     void doDebugFlashRegions();
     void doDisplayComposition(const sp<const DisplayDevice>& hw, const Region& dirtyRegion);
 
+    // with buffer age, returns what must be repainted on hw given that
+    // dirty changed since the last frame
+    Region computeRepaintRegion(const sp<const DisplayDevice>& hw, const Region& dirty);
+
+    // repaints hw and flips it; this runs on the main thread or, with
+    // parallel composition, on one of mCompositionThreads
+    void composeDisplay(const sp<DisplayDevice>& hw, bool repaintEverything);
+
+    // called by each composition thread before it starts composing
+    void setCurrentThreadRenderEngine(RenderEngine* engine);
+
     // compose surfaces for display hw. this fails if using GL and the surface
     // has been destroyed and is no longer valid.
     bool doComposeSurfaces(const sp<const DisplayDevice>& hw, const Region& dirty);
 
+    // returns the index of the topmost dim layer of hw that only darkens
+    // layers composed with GLES, and can thus be folded into them, or the
+    // number of layers if there is none
+    size_t findFoldableDimLayer(const sp<const DisplayDevice>& hw);
+
     void postFramebuffer();
     void drawWormhole(const sp<const DisplayDevice>& hw, const Region& region) const;
 
@@ -397,14 +536,21 @@ private:
      void enableHardwareVsync();
      void disableHardwareVsync(bool makeUnavailable);
      void resyncToHardwareVsync(bool makeAvailable);
+     // called from mHWVsyncThread with the timestamps it validated
+     void onPrimaryHWVsync(nsecs_t timestamp);
+     nsecs_t getPrimaryVsyncPeriod();
 
     /* ------------------------------------------------------------------------
      * Debugging & dumpsys
      */
     void listLayersLocked(const Vector<String16>& args, size_t& index, String8& result) const;
     void dumpStatsLocked(const Vector<String16>& args, size_t& index, String8& result) const;
+    void dumpBufferQueueStatsLocked(const Vector<String16>& args, size_t& index,
+            String8& result) const;
     void clearStatsLocked(const Vector<String16>& args, size_t& index, String8& result);
-    void dumpAllLocked(const Vector<String16>& args, size_t& index, String8& result) const;
+    void setStatsDepthLocked(const Vector<String16>& args, size_t& index, String8& result);
+    void dumpAllLocked(const Vector<String16>& args, size_t& index, String8& result,
+            ChunkedTextOutput& out) const;
     bool startDdmConnection();
     static void appendSfConfigString(String8& result);
     void checkScreenshot(size_t w, size_t s, size_t h, void const* vaddr,
@@ -425,6 +571,16 @@ private:
     bool mTransactionPending;
     bool mAnimTransactionPending;
     Vector< sp<Layer> > mLayersPendingRemoval;
+    // layers added to, removed from or moved within
+    // mCurrentState.layersSortedByZ since the last commitTransaction()
+    SortedVector< sp<Layer> > mLayersPendingReorder;
+    // layer states received since the last handleTransaction(), merged
+    // per surface and applied all at once there
+    struct PendingClientState {
+        sp<Client> client;
+        layer_state_t state;
+    };
+    KeyedVector< sp<IBinder>, PendingClientState > mPendingClientStates;
     SortedVector< wp<IBinder> > mGraphicBufferProducerList;
 
     // protected by mStateLock (but we could use another lock)
@@ -441,14 +597,89 @@ private:
     sp<EventThread> mEventThread;
     sp<EventThread> mSFEventThread;
     sp<EventControlThread> mEventControlThread;
+    sp<HWVsyncThread> mHWVsyncThread;
     EGLContext mEGLContext;
     EGLDisplay mEGLDisplay;
+    // set with debug.sf.parallel_composition; non-primary displays are
+    // composed on these threads while the main thread composes the primary
+    // display. mRenderEngineKey maps each of them to its RenderEngine.
+    Vector< sp<CompositionThread> > mCompositionThreads;
+    pthread_key_t mRenderEngineKey;
+    // set with debug.sf.prelatch; mPrelatchedLayers are the layers it's
+    // working on, kept alive here until handlePageFlip()
+    sp<PrelatchThread> mPrelatchThread;
+    Vector< sp<Layer> > mPrelatchedLayers;
+    // set with debug.sf.refresh_rate_policy; only used from the main thread
+    bool mUseRefreshRatePolicy;
+    RefreshRatePolicy mRefreshRatePolicy;
+    bool mRefreshRateCheckPending;
+    // only used from the main thread
+    DeadlineTracker mDeadlineTracker;
+    // the phase timings of the last refreshes, see dumpsys --timeline
+    CompositionTimeline mCompositionTimeline;
+    // the state of the last refresh, for dumps that can't wait for
+    // mStateLock; only the pointer is guarded by mStateSnapshotLock
+    mutable Mutex mStateSnapshotLock;
+    sp<const StateSnapshot> mStateSnapshot;
+    uint64_t mRefreshCount;
+    // set with debug.sf.client_buffer_budget (in MB); 0 when there is none
+    size_t mClientBufferBudget;
+    // set with debug.sf.drop_late_frames; layers then skip to the newest
+    // of their queued frames that is due instead of showing each in turn
+    bool mDropLateFrames;
+    // set with debug.sf.async_frame_available; layers then get their
+    // frame-available callbacks on a thread of their own, so that producers
+    // never wait for SurfaceFlinger's locks in queueBuffer
+    bool mAsyncFrameAvailable;
+    // set with debug.sf.frame_stats_interval_ms; frame stats are then
+    // logged as one batched record per interval instead of one record per
+    // layer every LOG_FRAME_STATS_PERIOD flips; only used from the main
+    // thread
+    nsecs_t mFrameStatsInterval;
+    nsecs_t mLastFrameStatsTime;
+    // set when a transaction is handled, until the refresh that shows it
+    // is scheduled; only used from the main thread
+    bool mTransactionHandled;
+    // the cursor overlays of the last prepare; guarded by mAsyncCursorLock,
+    // as they are looked up from binder threads
+    struct AsyncCursor {
+        wp<Layer> layer;
+        wp<const DisplayDevice> display;
+    };
+    Mutex mAsyncCursorLock;
+    Vector<AsyncCursor> mAsyncCursors;
+    // set with debug.sf.frame_stream_fps; sends the composited frames of
+    // the primary display to a host profiler
+    sp<FrameStreamer> mFrameStreamer;
+    // set with debug.sf.hwc_dim_layers; the solid black buffer dim layers
+    // give the HWC so it may blend them itself
+    sp<GraphicBuffer> mDimLayerBuffer;
+    // set with debug.sf.parallel_init; init() then runs the EGL driver
+    // initialization, the HWComposer and EventThreads creation, and the
+    // shaders priming concurrently
+    bool mParallelInit;
+    // when each step of init() ran, relative to mStartupTime; steps may be
+    // added from StartupThreads, so mStartupSteps is guarded by mStartupLock
+    struct StartupStep {
+        const char* name;
+        pid_t tid;
+        nsecs_t start;
+        nsecs_t end;
+    };
+    nsecs_t mStartupTime;
+    mutable Mutex mStartupLock;
+    Vector<StartupStep> mStartupSteps;
+    PowerHAL mPowerHAL;
     sp<IBinder> mBuiltinDisplays[DisplayDevice::NUM_BUILTIN_DISPLAY_TYPES];
 
     // Can only accessed from the main thread, these members
     // don't need synchronization
     State mDrawingState;
     bool mVisibleRegionsDirty;
+    // set when the visible regions of every layer must be recomputed, e.g.
+    // because layers were added or removed or displays changed; otherwise
+    // only layers below one with visibleRegionsDirty set are recomputed
+    bool mRecomputeAllVisibleRegions;
     bool mHwWorkListDirty;
     bool mAnimCompositionPending;
 
@@ -465,6 +696,8 @@ private:
     nsecs_t mLastSwapBufferTime;
     volatile nsecs_t mDebugInTransaction;
     nsecs_t mLastTransactionTime;
+    // the size of the last dump, to pre-size the next one
+    size_t mLastDumpSize;
     bool mBootFinished;
 
     // these are thread safe
@@ -472,6 +705,13 @@ private:
     FrameTracker mAnimFrameTracker;
     DispSync mPrimaryDispSync;
 
+    // protected by mDeferredDeleteLock; freed on the main thread
+    mutable Mutex mDeferredDeleteLock;
+    Vector<uint32_t> mTexturesToDelete;
+    Vector<EGLImageKHR> mImagesToDestroy;
+    Vector< sp<GraphicBuffer> > mBuffersToRelease;
+    bool mDeferredDeletePosted;
+
     // protected by mDestroyedLayerLock;
     mutable Mutex mDestroyedLayerLock;
     Vector<Layer const *> mDestroyedLayers;
@@ -49,10 +49,17 @@ status_t SurfaceFlingerConsumer::updateTexImage(BufferRejecter* rejecter,
 
     BufferQueue::BufferItem item;
 
-    // Acquire the next buffer.
-    // In asynchronous mode the list is guaranteed to be one buffer
-    // deep, while in synchronous mode we use the oldest buffer.
-    err = acquireBufferLocked(&item, computeExpectedPresent(dispSync));
+    if (mHasPrelatchedItem) {
+        // prelatch() already acquired the next buffer
+        item = mPrelatchedItem;
+        mHasPrelatchedItem = false;
+        mTransformToDisplayInverse = item.mTransformToDisplayInverse;
+    } else {
+        // Acquire the next buffer.
+        // In asynchronous mode the list is guaranteed to be one buffer
+        // deep, while in synchronous mode we use the oldest buffer.
+        err = acquireBufferLocked(&item, computeExpectedPresent(dispSync));
+    }
     if (err != NO_ERROR) {
         if (err == BufferQueue::NO_BUFFER_AVAILABLE) {
             err = NO_ERROR;
@@ -65,6 +72,7 @@ status_t SurfaceFlingerConsumer::updateTexImage(BufferRejecter* rejecter,
         return err;
     }
 
+    mSkippedFrames = item.mDroppedFrameCount;
 
     // We call the rejecter here, in case the caller has a reason to
     // not accept this buffer.  This is used by SurfaceFlinger to
@@ -94,6 +102,43 @@ status_t SurfaceFlingerConsumer::updateTexImage(BufferRejecter* rejecter,
     return err;
 }
 
+status_t SurfaceFlingerConsumer::prelatch(const DispSync& dispSync)
+{
+    ATRACE_CALL();
+    Mutex::Autolock lock(mMutex);
+
+    if (mAbandoned) {
+        return NO_INIT;
+    }
+    if (mHasPrelatchedItem) {
+        return NO_ERROR;
+    }
+
+    // This doesn't go through our acquireBufferLocked(), as
+    // mTransformToDisplayInverse belongs to the main thread; it is set
+    // when updateTexImage() picks the buffer up.
+    BufferQueue::BufferItem item;
+    status_t err = GLConsumer::acquireBufferLocked(&item,
+            computeExpectedPresent(dispSync));
+    if (err != NO_ERROR) {
+        if (err == BufferQueue::NO_BUFFER_AVAILABLE ||
+                err == BufferQueue::PRESENT_LATER) {
+            // updateTexImage() will find out for itself
+            err = NO_ERROR;
+        } else {
+            ALOGE("prelatch: acquire failed: %s (%d)", strerror(-err), err);
+        }
+        return err;
+    }
+
+    // Failing here isn't fatal, updateAndReleaseLocked() tries again
+    createEglImageLocked(item);
+
+    mPrelatchedItem = item;
+    mHasPrelatchedItem = true;
+    return NO_ERROR;
+}
+
 status_t SurfaceFlingerConsumer::bindTextureImage()
 {
     Mutex::Autolock lock(mMutex);
@@ -110,14 +155,50 @@ status_t SurfaceFlingerConsumer::acquireBufferLocked(
     return result;
 }
 
+void SurfaceFlingerConsumer::abandonLocked() {
+    // the prelatched buffer goes away with the rest of the slots
+    mHasPrelatchedItem = false;
+    mPrelatchedItem = BufferQueue::BufferItem();
+    GLConsumer::abandonLocked();
+}
+
 bool SurfaceFlingerConsumer::getTransformToDisplayInverse() const {
     return mTransformToDisplayInverse;
 }
 
+uint64_t SurfaceFlingerConsumer::getSkippedFrameCount() const {
+    return mSkippedFrames;
+}
+
+status_t SurfaceFlingerConsumer::setDropLateFrames(bool enabled) {
+    Mutex::Autolock lock(mMutex);
+    if (mAbandoned) {
+        return NO_INIT;
+    }
+    return mConsumer->setDropLateFrames(enabled);
+}
+
 sp<NativeHandle> SurfaceFlingerConsumer::getSidebandStream() const {
     return mConsumer->getSidebandStream();
 }
 
+size_t SurfaceFlingerConsumer::getAllocatedBytes() const {
+    Mutex::Autolock lock(mMutex);
+    size_t bytes = 0;
+    for (int i = 0; i < BufferQueue::NUM_BUFFER_SLOTS; i++) {
+        const sp<GraphicBuffer>& buffer(mSlots[i].mGraphicBuffer);
+        if (buffer == NULL) {
+            continue;
+        }
+        ssize_t bpp = bytesPerPixel(buffer->getPixelFormat());
+        if (bpp <= 0) {
+            bpp = 4;
+        }
+        bytes += size_t(buffer->getStride()) * buffer->getHeight() * bpp;
+    }
+    return bytes;
+}
+
 // We need to determine the time when a buffer acquired now will be
 // displayed.  This can be calculated:
 //   time when previous buffer's actual-present fence was signaled
@@ -35,7 +35,9 @@ public:
     SurfaceFlingerConsumer(const sp<IGraphicBufferConsumer>& consumer,
             uint32_t tex)
         : GLConsumer(consumer, tex, GLConsumer::TEXTURE_EXTERNAL, false, false),
-          mTransformToDisplayInverse(false)
+          mTransformToDisplayInverse(false),
+          mHasPrelatchedItem(false),
+          mSkippedFrames(0)
     {}
 
     class BufferRejecter {
@@ -55,29 +57,59 @@ public:
     // texture.
     status_t updateTexImage(BufferRejecter* rejecter, const DispSync& dispSync);
 
+    // Acquires the next buffer and creates its EGLImage ahead of the next
+    // updateTexImage(), which then uses this buffer instead of acquiring
+    // one. Unlike updateTexImage(), this may be called from any thread. At
+    // most one buffer is held this way.
+    status_t prelatch(const DispSync& dispSync);
+
     // See GLConsumer::bindTextureImageLocked().
     status_t bindTextureImage();
 
     // must be called from SF main thread
     bool getTransformToDisplayInverse() const;
 
+    // Returns how many queued frames the BufferQueue dropped before the one
+    // acquired by the last updateTexImage(). Frames replaced in async mode
+    // aren't counted, as they never raised onFrameAvailable(). Must be
+    // called from SF main thread.
+    uint64_t getSkippedFrameCount() const;
+
+    // See IGraphicBufferConsumer::setDropLateFrames().
+    status_t setDropLateFrames(bool enabled);
+
     // Sets the contents changed listener. This should be used instead of
     // ConsumerBase::setFrameAvailableListener().
     void setContentsChangedListener(const wp<ContentsChangedListener>& listener);
 
     sp<NativeHandle> getSidebandStream() const;
 
+    // Returns the memory used by the buffers this consumer has acquired
+    // so far and not freed. Buffers the producer dequeued but never queued
+    // aren't known here. Formats of unknown size count 4 bytes per pixel.
+    size_t getAllocatedBytes() const;
+
 private:
     nsecs_t computeExpectedPresent(const DispSync& dispSync);
 
     virtual void onSidebandStreamChanged();
 
+    virtual void abandonLocked();
+
     wp<ContentsChangedListener> mContentsChangedListener;
 
     // Indicates this buffer must be transformed by the inverse transform of the screen
     // it is displayed onto. This is applied after GLConsumer::mCurrentTransform.
     // This must be set/read from SurfaceFlinger's main thread.
     bool mTransformToDisplayInverse;
+
+    // the buffer acquired by prelatch(), if mHasPrelatchedItem is set
+    bool mHasPrelatchedItem;
+    BufferQueue::BufferItem mPrelatchedItem;
+
+    // how many frames were dropped before the last buffer updateTexImage()
+    // acquired
+    uint64_t mSkippedFrames;
 };
 
 // ----------------------------------------------------------------------------
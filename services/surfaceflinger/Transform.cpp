@@ -63,6 +63,12 @@ Transform Transform::operator * (const Transform& rhs) const
     if (rhs.mType == IDENTITY)
         return r;
 
+    if ((mType | rhs.mType) <= TRANSLATE) {
+        // two translations just add up
+        r.set(tx() + rhs.tx(), ty() + rhs.ty());
+        return r;
+    }
+
     // TODO: we could use mType to optimize the matrix multiply
     const mat33& A(mMatrix);
     const mat33& B(rhs.mMatrix);
@@ -200,9 +206,38 @@ Rect Transform::makeBounds(int w, int h) const
     return transform( Rect(w, h) );
 }
 
+// maps [lo, hi] with x' = s*x + t, where s is +1 or -1
+static inline void mapRange(float s, int lo, int hi, int t,
+        int32_t* outLo, int32_t* outHi) {
+    if (s > 0) {
+        *outLo = lo + t;
+        *outHi = hi + t;
+    } else {
+        *outLo = t - hi;
+        *outHi = t - lo;
+    }
+}
+
 Rect Transform::transform(const Rect& bounds) const
 {
     Rect r;
+    const uint32_t type = this->type();
+    if (CC_LIKELY(!(type & (SCALE|UNKNOWN)))) {
+        // translations, flips and 90 degrees rotations only move integer
+        // coordinates around, only the translation needs to be rounded
+        const mat33& M(mMatrix);
+        const int x = floorf(M[2][0] + 0.5f);
+        const int y = floorf(M[2][1] + 0.5f);
+        if ((type >> 8) & ROT_90) {
+            mapRange(M[1][0], bounds.top, bounds.bottom, x, &r.left, &r.right);
+            mapRange(M[0][1], bounds.left, bounds.right, y, &r.top, &r.bottom);
+        } else {
+            mapRange(M[0][0], bounds.left, bounds.right, x, &r.left, &r.right);
+            mapRange(M[1][1], bounds.top, bounds.bottom, y, &r.top, &r.bottom);
+        }
+        return r;
+    }
+
     vec2 lt( bounds.left,  bounds.top    );
     vec2 rt( bounds.right, bounds.top    );
     vec2 lb( bounds.left,  bounds.bottom );
@@ -225,7 +260,11 @@ Region Transform::transform(const Region& reg) const
 {
     Region out;
     if (CC_UNLIKELY(transformed())) {
-        if (CC_LIKELY(preserveRects())) {
+        if (reg.isEmpty()) {
+            // nothing to transform
+        } else if (reg.isRect()) {
+            out.set(transform(reg.bounds()));
+        } else if (CC_LIKELY(preserveRects())) {
             Region::const_iterator it = reg.begin();
             Region::const_iterator const end = reg.end();
             while (it != end) {
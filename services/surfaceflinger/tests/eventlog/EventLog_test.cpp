@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../../EventLog/EventLog.h"
+
+namespace android {
+
+TEST(EventLogTest, FrameStatsFileIsInTheStatsDirectory) {
+    String8 expected(EventLog::FRAME_STATS_DIR);
+    expected.append("/stats.bin");
+    EXPECT_STREQ(expected.string(),
+            EventLog::getFrameStatsPath("stats.bin").string());
+}
+
+TEST(EventLogTest, FrameStatsFileMustBeAFileName) {
+    EXPECT_TRUE(EventLog::getFrameStatsPath(NULL).isEmpty());
+    EXPECT_TRUE(EventLog::getFrameStatsPath("").isEmpty());
+    EXPECT_TRUE(EventLog::getFrameStatsPath(".").isEmpty());
+    EXPECT_TRUE(EventLog::getFrameStatsPath("..").isEmpty());
+    EXPECT_TRUE(EventLog::getFrameStatsPath("/data/system/packages.xml").isEmpty())
+            << "Should not accept an absolute path";
+    EXPECT_TRUE(EventLog::getFrameStatsPath("../packages.xml").isEmpty())
+            << "Should not leave the stats directory";
+    EXPECT_TRUE(EventLog::getFrameStatsPath("sub/stats.bin").isEmpty());
+}
+
+} // namespace android
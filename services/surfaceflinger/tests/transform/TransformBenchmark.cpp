@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures Transform::transform() on rects and regions, and makeBounds(),
+ * for each kind of transform SurfaceFlinger applies to its layers.
+ *
+ * usage: test-transform-benchmark [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+#include <utils/Timers.h>
+
+#include "../../Transform.h"
+
+using namespace android;
+
+static size_t gIterations = 1000000;
+
+// keeps the compiler from optimizing the transforms away
+static volatile int32_t gSink;
+
+static double benchRect(const Transform& tr) {
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (size_t i = 0; i < gIterations; i++) {
+        const int32_t o = int32_t(i & 0xFF);
+        const Rect r(tr.transform(Rect(o, o, o + 100, o + 200)));
+        gSink = r.left + r.bottom;
+    }
+    return double(systemTime(SYSTEM_TIME_MONOTONIC) - start) / gIterations;
+}
+
+static double benchBounds(const Transform& tr) {
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (size_t i = 0; i < gIterations; i++) {
+        const int32_t o = int32_t(i & 0xFF);
+        const Rect r(tr.makeBounds(o + 100, o + 200));
+        gSink = r.right + r.top;
+    }
+    return double(systemTime(SYSTEM_TIME_MONOTONIC) - start) / gIterations;
+}
+
+static double benchRegion(const Transform& tr, const Region& reg) {
+    const size_t iterations = gIterations / 10;
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (size_t i = 0; i < iterations; i++) {
+        const Region r(tr.transform(reg));
+        gSink = r.bounds().left;
+    }
+    return double(systemTime(SYSTEM_TIME_MONOTONIC) - start) / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        gIterations = atoi(argv[1]);
+    }
+
+    // a window with a status bar shaped hole, a few bands of several rects
+    Region reg(Rect(0, 0, 1080, 1920));
+    reg.subtractSelf(Rect(100, 0, 980, 75));
+    reg.subtractSelf(Rect(200, 500, 300, 600));
+    reg.subtractSelf(Rect(600, 550, 700, 900));
+
+    Transform scale;
+    scale.set(2.0f, 0, 0, 2.0f);
+    Transform rotate;
+    rotate.set(0.7071f, -0.7071f, 0.7071f, 0.7071f);
+
+    struct {
+        const char* name;
+        Transform tr;
+    } transforms[] = {
+        { "translate", Transform() },
+        { "rot_90", Transform(Transform::ROT_90) },
+        { "rot_180", Transform(Transform::ROT_180) },
+        { "rot_270", Transform(Transform::ROT_270) },
+        { "scale", scale },
+        { "rot_45", rotate },
+    };
+    const size_t count = sizeof(transforms) / sizeof(transforms[0]);
+    for (size_t i = 0; i < count; i++) {
+        Transform& tr(transforms[i].tr);
+        tr.set(tr.tx() + 10.0f, tr.ty() + 20.0f);
+    }
+
+    printf("%zu iterations, region of %zu rects\n", gIterations,
+            size_t(reg.end() - reg.begin()));
+    printf("transform\trect ns\tbounds ns\tregion ns\n");
+    for (size_t i = 0; i < count; i++) {
+        const Transform& tr(transforms[i].tr);
+        printf("%s\t%.1f\t%.1f\t%.1f\n", transforms[i].name,
+                benchRect(tr), benchBounds(tr), benchRegion(tr, reg));
+    }
+    return 0;
+}